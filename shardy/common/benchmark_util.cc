@@ -0,0 +1,173 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/common/benchmark_util.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace sdy {
+
+namespace {
+
+llvm::cl::opt<int64_t> repetitionsFlag(
+    "repetitions",
+    llvm::cl::desc("The number of timed runs of each benchmark."),
+    llvm::cl::init(5));
+
+llvm::cl::opt<std::string> filterFlag(
+    "filter",
+    llvm::cl::desc("Only run benchmarks whose name matches this regex."),
+    llvm::cl::init(".*"));
+
+llvm::cl::opt<bool> enableThreadingFlag(
+    "enable-threading",
+    llvm::cl::desc("Whether to enable multi-threading in the MLIR context."),
+    llvm::cl::init(false));
+
+// The regex of `--filter`, set by `parseBenchmarkCommandLine`.
+std::optional<llvm::Regex>& getFilter() {
+  static std::optional<llvm::Regex> filter;
+  return filter;
+}
+
+constexpr int64_t kMinColumnWidth = 8;
+constexpr int64_t kTimeColumnWidth = 12;
+
+int64_t getColumnWidth(StringRef column) {
+  return std::max<int64_t>(column.size(), kMinColumnWidth);
+}
+
+}  // namespace
+
+LogicalResult parseBenchmarkCommandLine(int argc, char** argv,
+                                        StringRef overview,
+                                        int64_t defaultRepetitions) {
+  repetitionsFlag.setInitialValue(defaultRepetitions);
+  llvm::cl::ParseCommandLineOptions(argc, argv, overview);
+  std::optional<llvm::Regex>& filter = getFilter();
+  filter.emplace(filterFlag);
+  std::string error;
+  if (!filter->isValid(error)) {
+    llvm::errs() << "invalid --filter: " << error << "\n";
+    return failure();
+  }
+  return success();
+}
+
+int64_t getNumRepetitions() { return std::max<int64_t>(repetitionsFlag, 1); }
+
+bool shouldRunBenchmark(StringRef name) {
+  return !getFilter() || getFilter()->match(name);
+}
+
+void applyThreadingFlag(MLIRContext* context) {
+  if (!enableThreadingFlag) {
+    context->disableMultithreading();
+  }
+}
+
+double toMilliseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+BenchmarkTimings getTimings(SmallVector<std::chrono::nanoseconds> durations) {
+  llvm::sort(durations);
+  return {toMilliseconds(durations.front()),
+          toMilliseconds(durations[durations.size() / 2])};
+}
+
+std::optional<std::chrono::nanoseconds> timeRun(
+    llvm::function_ref<LogicalResult()> run) {
+  auto start = std::chrono::steady_clock::now();
+  if (failed(run())) {
+    return std::nullopt;
+  }
+  return std::chrono::steady_clock::now() - start;
+}
+
+std::optional<BenchmarkTimings> timeRepeatedly(
+    llvm::function_ref<std::optional<std::chrono::nanoseconds>()> run) {
+  SmallVector<std::chrono::nanoseconds> durations;
+  for (int64_t i = 0; i < getNumRepetitions(); ++i) {
+    std::optional<std::chrono::nanoseconds> duration = run();
+    if (!duration) {
+      return std::nullopt;
+    }
+    durations.push_back(*duration);
+  }
+  return getTimings(std::move(durations));
+}
+
+BenchmarkTable::BenchmarkTable(int64_t nameWidth, ArrayRef<StringRef> columns,
+                               TimeUnit unit)
+    : nameWidth(nameWidth), unit(unit) {
+  for (StringRef column : columns) {
+    this->columns.push_back(column.str());
+  }
+}
+
+void BenchmarkTable::printHeader(raw_ostream& os) const {
+  StringRef suffix = unit == TimeUnit::kMilliseconds ? "ms" : "ns";
+  os << llvm::left_justify("benchmark", nameWidth);
+  for (const std::string& column : columns) {
+    os << " " << llvm::right_justify(column, getColumnWidth(column));
+  }
+  os << " "
+     << llvm::right_justify(llvm::formatv("min_{0}", suffix).str(),
+                            kTimeColumnWidth)
+     << " "
+     << llvm::right_justify(llvm::formatv("median_{0}", suffix).str(),
+                            kTimeColumnWidth)
+     << "\n";
+}
+
+void BenchmarkTable::printRow(StringRef name, ArrayRef<std::string> values,
+                              const BenchmarkTimings& timings,
+                              raw_ostream& os) const {
+  os << llvm::left_justify(name, nameWidth);
+  for (auto [column, value] : llvm::zip_equal(columns, values)) {
+    os << " " << llvm::right_justify(value, getColumnWidth(column));
+  }
+  // Times in nanoseconds are per call of a cheap utility, so one decimal is
+  // enough.
+  for (double ms : {timings.minMs, timings.medianMs}) {
+    std::string time = unit == TimeUnit::kMilliseconds
+                           ? llvm::formatv("{0:F3}", ms).str()
+                           : llvm::formatv("{0:F1}", ms * 1e6).str();
+    os << " " << llvm::right_justify(time, kTimeColumnWidth);
+  }
+  os << "\n";
+}
+
+}  // namespace sdy
+}  // namespace mlir
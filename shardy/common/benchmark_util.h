@@ -0,0 +1,104 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_COMMON_BENCHMARK_UTIL_H_
+#define SHARDY_COMMON_BENCHMARK_UTIL_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace sdy {
+
+// The harness shared by the compile-time benchmarks, which only differ in the
+// workload they time. It owns the flags every benchmark has:
+//
+// - `--repetitions=<n>`: the number of timed runs of each benchmark.
+// - `--filter=<regex>`: only run benchmarks whose name matches this regex.
+// - `--enable-threading`: whether to enable multi-threading in the context.
+
+// Parses the command line of a benchmark binary, with `defaultRepetitions` as
+// the default of `--repetitions`. Returns failure, after printing an error, if
+// `--filter` isn't a valid regex.
+LogicalResult parseBenchmarkCommandLine(int argc, char** argv,
+                                        StringRef overview,
+                                        int64_t defaultRepetitions = 5);
+
+// Returns the number of timed runs of each benchmark, which is at least 1.
+int64_t getNumRepetitions();
+
+// Returns whether the benchmark called `name` matches `--filter`.
+bool shouldRunBenchmark(StringRef name);
+
+// Disables multi-threading in `context` unless `--enable-threading` is set.
+void applyThreadingFlag(MLIRContext* context);
+
+double toMilliseconds(std::chrono::nanoseconds duration);
+
+// The min and median time of the runs of a benchmark.
+struct BenchmarkTimings {
+  double minMs = 0.0;
+  double medianMs = 0.0;
+};
+
+// Returns the timings of the runs that took `durations`, which must not be
+// empty.
+BenchmarkTimings getTimings(SmallVector<std::chrono::nanoseconds> durations);
+
+// Returns the time it takes to call `run`, or std::nullopt if it failed.
+std::optional<std::chrono::nanoseconds> timeRun(
+    llvm::function_ref<LogicalResult()> run);
+
+// Calls `run` `getNumRepetitions()` times, where each call returns the time of
+// the run (see `timeRun`), and returns the timings of all runs, or
+// std::nullopt if any of them failed.
+std::optional<BenchmarkTimings> timeRepeatedly(
+    llvm::function_ref<std::optional<std::chrono::nanoseconds>()> run);
+
+// Prints the results of benchmarks as a table, with a row per benchmark
+// holding its name, the benchmark specific `columns`, and its timings.
+class BenchmarkTable {
+ public:
+  enum class TimeUnit { kMilliseconds, kNanoseconds };
+
+  BenchmarkTable(int64_t nameWidth, ArrayRef<StringRef> columns,
+                 TimeUnit unit = TimeUnit::kMilliseconds);
+
+  void printHeader(raw_ostream& os = llvm::outs()) const;
+
+  // Prints a row with a value per column.
+  void printRow(StringRef name, ArrayRef<std::string> values,
+                const BenchmarkTimings& timings,
+                raw_ostream& os = llvm::outs()) const;
+
+ private:
+  int64_t nameWidth;
+  SmallVector<std::string> columns;
+  TimeUnit unit;
+};
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_COMMON_BENCHMARK_UTIL_H_
@@ -18,10 +18,25 @@ limitations under the License.
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SMLoc.h"
+#include "llvm/Support/SourceMgr.h"
+#include "mlir/Bytecode/BytecodeReader.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/AsmState.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Support/TypeID.h"
 #include "shardy/common/save_module_op.h"
@@ -67,8 +82,98 @@ class SaveModuleOpPass
   std::optional<int> dumpIndex;
 };
 
+// Returns the contents of the file at `filePath`, memory-mapped if it's large
+// enough, or null and emits an error if it can't be opened.
+std::unique_ptr<llvm::MemoryBuffer> openFile(StringRef filePath,
+                                             MLIRContext* context) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(filePath, /*IsText=*/false,
+                                  /*RequiresNullTerminator=*/true);
+  if (!buffer) {
+    emitError(UnknownLoc::get(context))
+        << "failed to open " << filePath << ": "
+        << buffer.getError().message();
+    return nullptr;
+  }
+  return std::move(*buffer);
+}
+
+// Only functions are loaded lazily, as they hold almost all of the IR.
+bool isLazyOp(Operation* op) { return isa<func::FuncOp>(op); }
+
 }  // namespace
 
+OwningOpRef<ModuleOp> loadModuleOp(StringRef filePath, MLIRContext* context) {
+  std::unique_ptr<llvm::MemoryBuffer> buffer = openFile(filePath, context);
+  if (!buffer) {
+    return nullptr;
+  }
+  // Shared so that resources in bytecode can refer to the buffer instead of
+  // being copied.
+  auto sourceMgr = std::make_shared<llvm::SourceMgr>();
+  sourceMgr->AddNewSourceBuffer(std::move(buffer), llvm::SMLoc());
+  return parseSourceFile<ModuleOp>(sourceMgr, ParserConfig(context));
+}
+
+std::unique_ptr<LazyModuleLoader> LazyModuleLoader::create(
+    StringRef filePath, MLIRContext* context) {
+  std::unique_ptr<llvm::MemoryBuffer> buffer = openFile(filePath, context);
+  if (!buffer) {
+    return nullptr;
+  }
+  return create(std::move(buffer), context);
+}
+
+std::unique_ptr<LazyModuleLoader> LazyModuleLoader::create(
+    std::unique_ptr<llvm::MemoryBuffer> buffer, MLIRContext* context) {
+  StringRef bufferName = buffer->getBufferIdentifier();
+  if (!isBytecode(buffer->getMemBufferRef())) {
+    emitError(UnknownLoc::get(context))
+        << bufferName << " isn't a bytecode file, which lazy loading requires";
+    return nullptr;
+  }
+  std::unique_ptr<LazyModuleLoader> loader(
+      new LazyModuleLoader(std::move(buffer), context));
+  if (failed(loader->reader.readTopLevel(&loader->block, isLazyOp))) {
+    return nullptr;
+  }
+  if (!llvm::hasSingleElement(loader->block) ||
+      !(loader->module = dyn_cast<ModuleOp>(loader->block.front()))) {
+    emitError(UnknownLoc::get(context))
+        << bufferName << " doesn't hold a single module";
+    return nullptr;
+  }
+  return loader;
+}
+
+LazyModuleLoader::LazyModuleLoader(std::unique_ptr<llvm::MemoryBuffer> buffer,
+                                   MLIRContext* context)
+    : buffer(std::move(buffer)),
+      config(context),
+      reader(this->buffer->getMemBufferRef(), config, /*lazyLoad=*/true) {}
+
+LazyModuleLoader::~LazyModuleLoader() = default;
+
+bool LazyModuleLoader::isMaterializable(Operation* op) {
+  return reader.isMaterializable(op);
+}
+
+LogicalResult LazyModuleLoader::materialize(Operation* op) {
+  if (!reader.isMaterializable(op)) {
+    return success();
+  }
+  return reader.materialize(op, isLazyOp);
+}
+
+LogicalResult LazyModuleLoader::materializeAll() {
+  return finalize(/*shouldMaterialize=*/[](Operation*) { return true; });
+}
+
+LogicalResult LazyModuleLoader::finalize(
+    function_ref<bool(Operation*)> shouldMaterialize) {
+  return reader.finalize(shouldMaterialize);
+}
+
 void saveModuleOp(ModuleOp moduleOp, StringRef dumpDirectory,
                   StringRef fileName, std::optional<int> dumpIndex) {
   if (!dumpIndex) {
@@ -85,5 +190,13 @@ std::unique_ptr<Pass> createSaveModuleOpPass(StringRef dumpDirectory,
   return std::make_unique<SaveModuleOpPass>(dumpDirectory, fileName, dumpIndex);
 }
 
+void addSaveModuleOpPass(OpPassManager& pm, StringRef dumpDirectory,
+                         StringRef fileName, int& dumpIndex) {
+  int index = dumpIndex++;
+  if (!dumpDirectory.empty()) {
+    pm.addPass(createSaveModuleOpPass(dumpDirectory, fileName, index));
+  }
+}
+
 }  // namespace sdy
 }  // namespace mlir
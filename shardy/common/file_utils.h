@@ -19,8 +19,16 @@ limitations under the License.
 #include <memory>
 #include <optional>
 
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "mlir/Bytecode/BytecodeReader.h"
+#include "mlir/IR/AsmState.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
 
 namespace mlir {
@@ -37,6 +45,11 @@ namespace sdy {
 // - any error will be logged to standard error.
 // - do not include a file extension in `fileName`, `.mlir` will be appended
 //   internally.
+// - repeated shardings are elided with per-file aliases if enabled on the
+//   `SdyDialect`, see `SdyDialect::setShardingAliasesEnabled`.
+// - the module is written on a background thread and/or compressed if enabled
+//   with `setModuleDumpOptions`, use `waitForModuleDumps` to wait for pending
+//   writes.
 void saveModuleOp(ModuleOp moduleOp, StringRef dumpDirectory,
                   StringRef fileName,
                   std::optional<int> dumpIndex = std::nullopt);
@@ -49,6 +62,73 @@ std::unique_ptr<Pass> createSaveModuleOpPass(
     StringRef dumpDirectory, StringRef fileName,
     std::optional<int> dumpIndex = std::nullopt);
 
+// Adds a `createSaveModuleOpPass` to `pm` with `dumpIndex`, and increments it.
+//
+// Skips the pass if `dumpDirectory` is empty, since it wouldn't save anything,
+// but as a module pass it would still split the function passes around it
+// into separate nested pipelines, each running on all functions before the
+// next one starts.
+void addSaveModuleOpPass(OpPassManager& pm, StringRef dumpDirectory,
+                         StringRef fileName, int& dumpIndex);
+
+// Loads the module in the textual or bytecode file at `filePath` in `context`,
+// or returns null and emits an error if it can't be loaded.
+//
+// NOTE: the file is memory-mapped rather than copied into memory, so loading a
+// huge module doesn't need memory for both the file and the module.
+OwningOpRef<ModuleOp> loadModuleOp(StringRef filePath, MLIRContext* context);
+
+// Loads a module from a bytecode file without materializing the bodies of its
+// functions, which can each be materialized on demand, so that tools can work
+// on a single function of a huge module.
+//
+// The ops of functions that aren't materialized have no regions, so passes
+// should only be run on the module once all functions are materialized.
+class LazyModuleLoader {
+ public:
+  // Returns a loader for the bytecode file at `filePath`, or null and emits an
+  // error if it can't be loaded.
+  static std::unique_ptr<LazyModuleLoader> create(StringRef filePath,
+                                                  MLIRContext* context);
+
+  // Same as above, but reads the bytecode from `buffer`, e.g., stdin.
+  static std::unique_ptr<LazyModuleLoader> create(
+      std::unique_ptr<llvm::MemoryBuffer> buffer, MLIRContext* context);
+
+  ~LazyModuleLoader();
+
+  // Returns the module, owned by this loader.
+  ModuleOp getModule() const { return module; }
+
+  // Returns whether `op`, which must be nested in the module, is yet to be
+  // materialized.
+  bool isMaterializable(Operation* op);
+
+  // Materializes the body of `op`, e.g., a function, if it isn't already.
+  LogicalResult materialize(Operation* op);
+
+  // Materializes the bodies of all ops that aren't materialized yet.
+  LogicalResult materializeAll();
+
+  // Materializes the ops that aren't materialized yet and for which
+  // `shouldMaterialize` returns true, and erases all others. Ops can no longer
+  // be materialized afterwards.
+  LogicalResult finalize(function_ref<bool(Operation*)> shouldMaterialize);
+
+ private:
+  LazyModuleLoader(std::unique_ptr<llvm::MemoryBuffer> buffer,
+                   MLIRContext* context);
+
+  // The buffer and config must outlive the reader, which reads lazy ops from
+  // the buffer.
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+  ParserConfig config;
+  BytecodeReader reader;
+  // Holds the module.
+  Block block;
+  ModuleOp module;
+};
+
 }  // namespace sdy
 }  // namespace mlir
 
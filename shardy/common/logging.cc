@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "shardy/common/logging.h"
 
+#include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
 #include <cstdint>
+#include <cstdlib>
 #include <ctime>
+#include <utility>
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/ManagedStatic.h"
@@ -34,6 +38,20 @@ namespace {
 
 static llvm::ManagedStatic<llvm::sys::Mutex> logMutex;
 
+// Guarded by `logMutex`.
+static llvm::ManagedStatic<LogSink> logSink;
+
+std::atomic<int>& getVLogLevelRef() {
+  static std::atomic<int> vlogLevel = [] {
+    int level = 0;
+    if (const char* levelStr = std::getenv("SDY_VLOG_LEVEL")) {
+      llvm::StringRef(levelStr).getAsInteger(/*Radix=*/10, level);
+    }
+    return level;
+  }();
+  return vlogLevel;
+}
+
 char severityToChar(LogSeverity s) {
   switch (s) {
     case INFO:
@@ -61,6 +79,19 @@ inline std::tm toLocalTime(std::time_t epochSeconds) {
 
 }  // namespace
 
+int getVLogLevel() {
+  return getVLogLevelRef().load(std::memory_order_relaxed);
+}
+
+void setVLogLevel(int level) {
+  getVLogLevelRef().store(level, std::memory_order_relaxed);
+}
+
+void setLogSink(LogSink sink) {
+  llvm::sys::ScopedLock guard(*logMutex);
+  *logSink = std::move(sink);
+}
+
 LogMessage::LogMessage(LogMessageData data)
     : data(data), message(), strStream(message) {
   auto nowPoint = std::chrono::system_clock::now();
@@ -89,6 +120,9 @@ LogMessage::LogMessage(LogMessageData data)
       // {9}:{9}] File:Line]
       data.file, data.line);
 
+  strStream.flush();
+  prefixSize = message.size();
+
   // If it's a CHECK, add the condition string
   if (data.conditionStr) {
     strStream << "Check failed: " << data.conditionStr << " ";
@@ -98,6 +132,10 @@ LogMessage::LogMessage(LogMessageData data)
 LogMessage::~LogMessage() {
   llvm::sys::ScopedLock guard(*logMutex);
   strStream.flush();
+  if (*logSink && data.severity != FATAL) {
+    (*logSink)(data.severity, data.file, data.line,
+               llvm::StringRef(message).drop_front(prefixSize));
+  }
   switch (data.severity) {
     case INFO:
       llvm::outs() << message << "\n";
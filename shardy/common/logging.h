@@ -16,10 +16,13 @@ limitations under the License.
 #ifndef SHARDY_COMMON_LOGGING_H_
 #define SHARDY_COMMON_LOGGING_H_
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
-#include "mlir/Support/RawOstreamExtras.h"
 
 namespace mlir {
 namespace sdy {
@@ -33,6 +36,46 @@ enum LogSeverity {
   FATAL,  // Used by SDY_LOG(FATAL) and SDY_CHECK
 };
 
+// Logs with a lower severity than `SDY_MIN_LOG_SEVERITY` are compiled out,
+// e.g., `-DSDY_MIN_LOG_SEVERITY=1` removes all INFO logs (and VLOGs).
+#ifndef SDY_MIN_LOG_SEVERITY
+#define SDY_MIN_LOG_SEVERITY 0
+#endif
+
+// VLOGs with a higher level than `SDY_MAX_VLOG_LEVEL` are compiled out.
+#ifndef SDY_MAX_VLOG_LEVEL
+#define SDY_MAX_VLOG_LEVEL 10
+#endif
+
+// Returns the runtime verbosity level, where `SDY_VLOG(level)` is only printed
+// if `level <= getVLogLevel()`. Initialized from the `SDY_VLOG_LEVEL`
+// environment variable, or 0 if it isn't set.
+int getVLogLevel();
+
+// Sets the runtime verbosity level.
+void setVLogLevel(int level);
+
+// A callback that receives every non-fatal log message, without its prefix,
+// e.g., to add it to a structured report.
+using LogSink = std::function<void(LogSeverity severity, llvm::StringRef file,
+                                   int line, llvm::StringRef message)>;
+
+// Sets the sink that receives log messages in addition to them being printed,
+// or removes it if `sink` is null.
+void setLogSink(LogSink sink);
+
+// Returns true every `n`-th time it's called with `counter`, starting with the
+// first.
+inline bool shouldLogEveryN(std::atomic<int64_t>& counter, int64_t n) {
+  return counter.fetch_add(1, std::memory_order_relaxed) % n == 0;
+}
+
+// Returns true the first `n` times it's called with `counter`.
+inline bool shouldLogFirstN(std::atomic<int64_t>& counter, int64_t n) {
+  return counter.load(std::memory_order_relaxed) < n &&
+         counter.fetch_add(1, std::memory_order_relaxed) < n;
+}
+
 // Helper struct to capture file/line/function info for logs/checks
 struct LogMessageData {
   LogSeverity severity;
@@ -58,6 +101,16 @@ class LogMessage {
   LogMessageData data;
   std::string message;
   llvm::raw_string_ostream strStream;
+  // The size of the prefix (time, file, line, etc.) at the start of `message`.
+  size_t prefixSize;
+};
+
+// Turns a log stream expression into `void`, so that it can be the other branch
+// of a conditional whose first branch is `(void)0`. `&` has a lower precedence
+// than `<<`, so the whole message is on its right, and is only built when the
+// log is enabled.
+struct LogMessageVoidify {
+  void operator&(llvm::raw_ostream&) {}
 };
 
 class LogMessageFatal : public LogMessage {
@@ -73,16 +126,35 @@ class LogMessageFatal : public LogMessage {
 }  // namespace sdy
 }  // namespace mlir
 
-#define SDY_LOG(severity) SDY_INTERNAL_CHECK_OR_LOG(severity, nullptr)
+// The arguments streamed into any of the logging macros below are only
+// evaluated if the message is logged.
 
-// TODO(tomnatan): make the verbose level actually work.
-#define SDY_VLOG(verbose_level) \
-  (verbose_level > 0) ? mlir::thread_safe_nulls() : SDY_LOG(INFO)
-#define SDY_VLOG_IS_ON(verbose_level) false
+#define SDY_LOG(severity) \
+  SDY_INTERNAL_LOG_IF(severity, SDY_INTERNAL_LOG_IS_ON(severity))
 
-#define SDY_CHECK(condition)              \
-  (condition) ? mlir::thread_safe_nulls() \
-              : SDY_INTERNAL_CHECK_OR_LOG(FATAL, #condition)
+#define SDY_VLOG(verbose_level) \
+  SDY_INTERNAL_LOG_IF(INFO, SDY_VLOG_IS_ON(verbose_level))
+#define SDY_VLOG_IS_ON(verbose_level)            \
+  (SDY_INTERNAL_LOG_IS_ON(INFO) &&               \
+   (verbose_level) <= SDY_MAX_VLOG_LEVEL &&      \
+   (verbose_level) <= mlir::sdy::log::getVLogLevel())
+
+// Logs on the 1st, (n+1)-th, (2n+1)-th, etc. time it's reached.
+#define SDY_LOG_EVERY_N(severity, n)                                  \
+  SDY_INTERNAL_LOG_IF(severity,                                       \
+                      SDY_INTERNAL_LOG_IS_ON(severity) &&             \
+                          mlir::sdy::log::shouldLogEveryN(            \
+                              SDY_INTERNAL_LOG_SITE_COUNTER(), (n)))
+
+// Logs on the first n times it's reached.
+#define SDY_LOG_FIRST_N(severity, n)                                  \
+  SDY_INTERNAL_LOG_IF(severity,                                       \
+                      SDY_INTERNAL_LOG_IS_ON(severity) &&             \
+                          mlir::sdy::log::shouldLogFirstN(            \
+                              SDY_INTERNAL_LOG_SITE_COUNTER(), (n)))
+
+#define SDY_CHECK(condition) \
+  (condition) ? (void)0 : SDY_INTERNAL_VOIDIFY(FATAL, #condition)
 
 #define SDY_CHECK_EQ(val1, val2) \
   SDY_INTERNAL_CHECK_OP(==, val1, val2)
@@ -115,6 +187,25 @@ class LogMessageFatal : public LogMessage {
              {mlir::sdy::log::severity, __FILE__, __LINE__, condition_str}) \
              .stream())
 
+// FATAL logs are never compiled out.
+#define SDY_INTERNAL_LOG_IS_ON(severity)               \
+  (mlir::sdy::log::severity == mlir::sdy::log::FATAL || \
+   mlir::sdy::log::severity >= SDY_MIN_LOG_SEVERITY)
+
+#define SDY_INTERNAL_VOIDIFY(severity, condition_str) \
+  mlir::sdy::log::LogMessageVoidify() &               \
+      SDY_INTERNAL_CHECK_OR_LOG(severity, condition_str)
+
+#define SDY_INTERNAL_LOG_IF(severity, condition) \
+  !(condition) ? (void)0 : SDY_INTERNAL_VOIDIFY(severity, nullptr)
+
+// A counter that is unique to the call site, as each lambda has its own type.
+#define SDY_INTERNAL_LOG_SITE_COUNTER()          \
+  ([]() -> std::atomic<int64_t>& {               \
+    static std::atomic<int64_t> counter = 0;     \
+    return counter;                              \
+  }())
+
 #define SDY_INTERNAL_CHECK_OP(op, val1, val2) \
   SDY_CHECK(val1 op val2) << "(" << val1 << " vs. " << val2 << ") "
 
@@ -13,15 +13,33 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <system_error>
+#include <utility>
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/DialectRegistry.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/common/save_module_op.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
 
 namespace mlir {
 namespace sdy {
@@ -31,25 +49,204 @@ static void fileSavingError(StringRef filePath, StringRef message) {
   llvm::errs() << llvm::formatv("error when writing file {0}: {1}\n", filePath,
                                 message);
 }
-}  // namespace
 
-void saveModuleOpInternal(ModuleOp moduleOp, StringRef dumpDirectory,
-                          StringRef fileName) {
-  if (dumpDirectory.empty()) {
-    return;
+std::mutex& getOptionsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+ModuleDumpOptions& getOptionsUnlocked() {
+  static ModuleDumpOptions options;
+  return options;
+}
+
+std::mutex& getDumpThreadPoolMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// A single worker, so that asynchronous dumps are written in the order they
+// were requested. Created by the first asynchronous dump, and joined and
+// destroyed by `waitForModuleDumps` rather than during static destruction.
+llvm::StdThreadPool*& getDumpThreadPoolUnlocked() {
+  static llvm::StdThreadPool* threadPool = nullptr;
+  return threadPool;
+}
+
+void enqueueDump(std::function<void()> dump) {
+  std::lock_guard<std::mutex> lock(getDumpThreadPoolMutex());
+  llvm::StdThreadPool*& threadPool = getDumpThreadPoolUnlocked();
+  if (!threadPool) {
+    threadPool = new llvm::StdThreadPool(llvm::hardware_concurrency(1));
   }
+  threadPool->async(std::move(dump));
+}
+
+// Returns `<dumpDirectory>/<fileName><extension>`.
+SmallString<128> getFilePath(StringRef dumpDirectory, StringRef fileName,
+                             StringRef extension) {
   SmallString<128> filePath(dumpDirectory);
   llvm::sys::path::append(filePath, fileName);
-  filePath.append(".mlir");
+  filePath.append(extension);
+  return filePath;
+}
+
+// Writes `contents` to `<dumpDirectory>/<fileName><extension>`, compressed with
+// zstd into a `.zst` file if `compress` is true and zstd is available.
+void writeFile(StringRef dumpDirectory, StringRef fileName, StringRef extension,
+               StringRef contents, bool compress) {
+  SmallString<128> filePath = getFilePath(dumpDirectory, fileName, extension);
+
+  SmallVector<uint8_t, 0> compressed;
+  if (compress && llvm::compression::zstd::isAvailable()) {
+    llvm::compression::zstd::compress(llvm::arrayRefFromStringRef(contents),
+                                      compressed);
+    contents = llvm::toStringRef(compressed);
+    filePath.append(".zst");
+  } else if (compress) {
+    fileSavingError(filePath.str(),
+                    "zstd is not available, writing uncompressed file");
+  }
+
+  writeToFile(filePath, [&](raw_ostream& os) { os << contents; });
+}
+
+// Parses the module in `bytecode` in a fresh context with the same dialects as
+// the one it was serialized from, and writes it in textual form. Falls back to
+// writing the raw bytecode, and reports it, if it can't be parsed.
+//
+// The module isn't printed from its original context, since that context can
+// be destroyed before the dump is written, and isn't thread-safe if
+// multi-threading is disabled.
+void printAndWriteBytecode(const std::string& bytecode,
+                           const DialectRegistry& registry,
+                           bool allowUnregisteredDialects,
+                           bool shardingAliasesEnabled,
+                           const std::string& dumpDirectory,
+                           const std::string& fileName, bool compress) {
+  MLIRContext context(registry, MLIRContext::Threading::DISABLED);
+  context.allowUnregisteredDialects(allowUnregisteredDialects);
+  context.getOrLoadDialect<SdyDialect>()->setShardingAliasesEnabled(
+      shardingAliasesEnabled);
+  OwningOpRef<ModuleOp> moduleOp =
+      parseSourceString<ModuleOp>(bytecode, &context);
+  if (!moduleOp) {
+    fileSavingError(getFilePath(dumpDirectory, fileName, ".mlir").str(),
+                    "failed to parse the bytecode snapshot of the module, "
+                    "writing it as bytecode to a `.mlirbc` file instead");
+    writeFile(dumpDirectory, fileName, ".mlirbc", bytecode, compress);
+    return;
+  }
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  moduleOp->print(os);
+  writeFile(dumpDirectory, fileName, ".mlir", text, compress);
+}
+
+}  // namespace
 
+void setModuleDumpOptions(const ModuleDumpOptions& options) {
+  std::lock_guard<std::mutex> lock(getOptionsMutex());
+  getOptionsUnlocked() = options;
+}
+
+ModuleDumpOptions getModuleDumpOptions() {
+  std::lock_guard<std::mutex> lock(getOptionsMutex());
+  return getOptionsUnlocked();
+}
+
+void waitForModuleDumps() {
+  std::unique_ptr<llvm::StdThreadPool> threadPool;
+  {
+    std::lock_guard<std::mutex> lock(getDumpThreadPoolMutex());
+    threadPool.reset(std::exchange(getDumpThreadPoolUnlocked(), nullptr));
+  }
+  // Destroying the pool waits for the pending dumps and joins its thread.
+  threadPool.reset();
+}
+
+bool writeToFile(StringRef filePath,
+                 llvm::function_ref<void(raw_ostream&)> write) {
   std::error_code errorCode;
   llvm::raw_fd_ostream fileStream(filePath, errorCode);
   if (errorCode) {
-    fileSavingError(filePath.str(), errorCode.message());
+    fileSavingError(filePath, errorCode.message());
+    return false;
+  }
+  write(fileStream);
+  return true;
+}
+
+void saveJson(StringRef dumpDirectory, StringRef fileName,
+              llvm::function_ref<void(raw_ostream&)> write) {
+  if (dumpDirectory.empty()) {
+    write(llvm::errs());
+    return;
+  }
+  writeToFile(getFilePath(dumpDirectory, fileName, ".json"), write);
+}
+
+void saveModuleOpInternal(ModuleOp moduleOp, StringRef dumpDirectory,
+                          StringRef fileName) {
+  if (dumpDirectory.empty()) {
+    return;
+  }
+  ModuleDumpOptions options = getModuleDumpOptions();
+  if (!options.async && !options.bytecode && !options.compress) {
+    // Stream the module to the file, without holding the whole printed module
+    // in memory.
+    writeToFile(getFilePath(dumpDirectory, fileName, ".mlir"),
+                [&](raw_ostream& os) { moduleOp.print(os); });
+    return;
+  }
+  if (!options.async && !options.bytecode) {
+    // The whole printed module is needed to compress it.
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    moduleOp.print(os);
+    writeFile(dumpDirectory, fileName, ".mlir", text, options.compress);
+    return;
+  }
+
+  // Only the bytecode snapshot is taken on the calling thread, as the module
+  // may be mutated as soon as this returns. In bytecode mode, the snapshot is
+  // written as is.
+  std::string bytecode;
+  llvm::raw_string_ostream os(bytecode);
+  if (failed(writeBytecodeToFile(moduleOp, os))) {
+    fileSavingError(getFilePath(dumpDirectory, fileName, "").str(),
+                    "failed to serialize module to bytecode");
+    return;
+  }
+  if (options.bytecode) {
+    if (!options.async) {
+      writeFile(dumpDirectory, fileName, ".mlirbc", bytecode, options.compress);
+      return;
+    }
+    enqueueDump([bytecode = std::move(bytecode),
+                               dumpDirectory = dumpDirectory.str(),
+                               fileName = fileName.str(),
+                               compress = options.compress]() {
+      writeFile(dumpDirectory, fileName, ".mlirbc", bytecode, compress);
+    });
     return;
   }
-  moduleOp.print(fileStream);
-  fileStream.close();
+  MLIRContext* context = moduleOp->getContext();
+  // The registry isn't copyable, and the task must be.
+  auto registry = std::make_shared<DialectRegistry>();
+  context->getDialectRegistry().appendTo(*registry);
+  auto* sdyDialect = context->getLoadedDialect<SdyDialect>();
+  bool shardingAliasesEnabled =
+      sdyDialect && sdyDialect->isShardingAliasesEnabled();
+  enqueueDump(
+      [bytecode = std::move(bytecode), registry = std::move(registry),
+       allowUnregisteredDialects = context->allowsUnregisteredDialects(),
+       shardingAliasesEnabled, dumpDirectory = dumpDirectory.str(),
+       fileName = fileName.str(), compress = options.compress]() {
+        printAndWriteBytecode(bytecode, *registry, allowUnregisteredDialects,
+                              shardingAliasesEnabled, dumpDirectory, fileName,
+                              compress);
+      });
 }
 
 }  // namespace sdy
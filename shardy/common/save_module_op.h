@@ -16,15 +16,57 @@ limitations under the License.
 #ifndef SHARDY_COMMON_SAVE_MODULE_OP_H_
 #define SHARDY_COMMON_SAVE_MODULE_OP_H_
 
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/Support/LLVM.h"
 
 namespace mlir {
 namespace sdy {
 
+// Process-wide options for how `saveModuleOpInternal` writes modules.
+struct ModuleDumpOptions {
+  // If true, the module is only serialized to bytecode on the calling thread,
+  // and then parsed in a fresh context, printed and written to disk on a
+  // background thread, so that dumping doesn't block compilation for as long
+  // as printing takes. `waitForModuleDumps` must be called before exiting.
+  bool async = false;
+  // If true, the printed module is compressed with zstd and written to a
+  // `.mlir.zst` file, if zstd is available.
+  bool compress = false;
+  // If true, the module is written as bytecode to a `.mlirbc` file instead of
+  // being printed, which is faster to write and load, and allows loading one
+  // function at a time with `LazyModuleLoader` (unless compressed).
+  bool bytecode = false;
+};
+
+// Sets the options used by all subsequent calls to `saveModuleOpInternal`.
+void setModuleDumpOptions(const ModuleDumpOptions& options);
+
+// Returns the current options of `saveModuleOpInternal`.
+ModuleDumpOptions getModuleDumpOptions();
+
+// Blocks until all modules dumped asynchronously so far have been written, and
+// joins the background thread. Dumps still pending when the process exits
+// without calling this are lost.
+void waitForModuleDumps();
+
 void saveModuleOpInternal(ModuleOp moduleOp, StringRef dumpDirectory,
                           StringRef fileName);
 
+// Writes the output of `write` to `filePath`, overwriting any existing file.
+//
+// Returns false, and logs an error to standard error, if the file can't be
+// opened.
+bool writeToFile(StringRef filePath,
+                 llvm::function_ref<void(raw_ostream&)> write);
+
+// Writes the JSON report printed by `write` to
+// `<dumpDirectory>/<fileName>.json` (see `writeToFile`), or to standard error
+// if `dumpDirectory` is empty.
+void saveJson(StringRef dumpDirectory, StringRef fileName,
+              llvm::function_ref<void(raw_ostream&)> write);
+
 }  // namespace sdy
 }  // namespace mlir
 
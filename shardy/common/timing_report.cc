@@ -0,0 +1,257 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/common/timing_report.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassInstrumentation.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/logging.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace mlir {
+namespace sdy {
+
+namespace {
+
+struct ScopeStats {
+  int64_t count = 0;
+  std::chrono::nanoseconds totalTime{0};
+  int64_t peakRssBytes = -1;
+  int64_t irSize = -1;
+};
+
+struct LogEntry {
+  log::LogSeverity severity;
+  std::string location;
+  std::string message;
+};
+
+// The maximum number of log messages kept in the report, so that a noisy log
+// doesn't dominate it.
+constexpr int64_t kMaxLogEntries = 10000;
+
+std::atomic<bool> timingReportEnabled = false;
+
+std::mutex& getReportMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// Guarded by `getReportMutex()`.
+llvm::MapVector<std::string, ScopeStats>& getScopeStatsUnlocked() {
+  static auto* scopeStats = new llvm::MapVector<std::string, ScopeStats>();
+  return *scopeStats;
+}
+
+// Guarded by `getReportMutex()`.
+std::vector<LogEntry>& getLogEntriesUnlocked() {
+  static auto* logEntries = new std::vector<LogEntry>();
+  return *logEntries;
+}
+
+StringRef severityToString(log::LogSeverity severity) {
+  switch (severity) {
+    case log::INFO:
+      return "INFO";
+    case log::WARNING:
+      return "WARNING";
+    case log::ERROR:
+      return "ERROR";
+    case log::FATAL:
+      return "FATAL";
+  }
+  llvm_unreachable("Unknown LogSeverity");
+}
+
+// The full names of the scopes that are open on the current thread.
+SmallVector<std::string>& getScopeStack() {
+  thread_local SmallVector<std::string> scopeStack;
+  return scopeStack;
+}
+
+int64_t getNumOps(Operation* op) {
+  int64_t numOps = 0;
+  op->walk([&](Operation*) { ++numOps; });
+  return numOps;
+}
+
+class TimingReportInstrumentation : public PassInstrumentation {
+ public:
+  void runBeforePass(Pass* pass, Operation* op) override {
+    StringRef name = pass->getArgument();
+    getOpenScopes().push_back(std::make_unique<TimingReportScope>(
+        name.empty() ? pass->getName() : name, op));
+  }
+
+  void runAfterPass(Pass* pass, Operation* op) override {
+    getOpenScopes().pop_back();
+  }
+
+  void runAfterPassFailed(Pass* pass, Operation* op) override {
+    getOpenScopes().pop_back();
+  }
+
+ private:
+  // Passes nested in an op-agnostic or op-specific adaptor may run on other
+  // threads, but a pass always finishes on the thread it started on.
+  static SmallVector<std::unique_ptr<TimingReportScope>>& getOpenScopes() {
+    thread_local SmallVector<std::unique_ptr<TimingReportScope>> openScopes;
+    return openScopes;
+  }
+};
+
+}  // namespace
+
+void enableTimingReport() {
+  {
+    std::lock_guard<std::mutex> lock(getReportMutex());
+    getScopeStatsUnlocked().clear();
+    getLogEntriesUnlocked().clear();
+    timingReportEnabled = true;
+  }
+  log::setLogSink([](log::LogSeverity severity, StringRef file, int line,
+                     StringRef message) {
+    std::lock_guard<std::mutex> lock(getReportMutex());
+    std::vector<LogEntry>& logEntries = getLogEntriesUnlocked();
+    if (logEntries.size() < kMaxLogEntries) {
+      logEntries.push_back(
+          {severity, (file + ":" + llvm::Twine(line)).str(), message.str()});
+    }
+  });
+}
+
+bool isTimingReportEnabled() { return timingReportEnabled; }
+
+int64_t getPeakRssBytes() {
+#if defined(__linux__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  // Linux reports kilobytes.
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return -1;
+#endif
+}
+
+void writeTimingReportJson(llvm::raw_ostream& os) {
+  std::lock_guard<std::mutex> lock(getReportMutex());
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&] {
+    json.attribute("peak_rss_bytes", getPeakRssBytes());
+    json.attributeArray("scopes", [&] {
+      for (const auto& [name, stats] : getScopeStatsUnlocked()) {
+        json.object([&, &name = name, &stats = stats] {
+          json.attribute("name", name);
+          json.attribute("count", stats.count);
+          json.attribute(
+              "total_seconds",
+              std::chrono::duration<double>(stats.totalTime).count());
+          json.attribute("peak_rss_bytes", stats.peakRssBytes);
+          if (stats.irSize != -1) {
+            json.attribute("ir_size", stats.irSize);
+          }
+        });
+      }
+    });
+    json.attributeArray("logs", [&] {
+      for (const LogEntry& entry : getLogEntriesUnlocked()) {
+        json.object([&] {
+          json.attribute("severity", severityToString(entry.severity));
+          json.attribute("location", entry.location);
+          json.attribute("message", entry.message);
+        });
+      }
+    });
+  });
+  os << "\n";
+}
+
+std::optional<double> getTimingReportSeconds(StringRef name) {
+  std::lock_guard<std::mutex> lock(getReportMutex());
+  llvm::MapVector<std::string, ScopeStats>& scopeStats =
+      getScopeStatsUnlocked();
+  auto it = scopeStats.find(name.str());
+  if (it == scopeStats.end()) {
+    return std::nullopt;
+  }
+  return std::chrono::duration<double>(it->second.totalTime).count();
+}
+
+TimingReportScope::TimingReportScope(StringRef name, Operation* irRoot)
+    : enabled(isTimingReportEnabled()), irRoot(irRoot) {
+  if (!enabled) {
+    return;
+  }
+  SmallVector<std::string>& scopeStack = getScopeStack();
+  scopeStack.push_back(scopeStack.empty()
+                           ? name.str()
+                           : (scopeStack.back() + "/" + name).str());
+  start = std::chrono::steady_clock::now();
+}
+
+TimingReportScope::~TimingReportScope() {
+  if (!enabled) {
+    return;
+  }
+  std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - start;
+  int64_t peakRssBytes = getPeakRssBytes();
+  int64_t irSize = irRoot ? getNumOps(irRoot) : -1;
+  std::string name = getScopeStack().pop_back_val();
+
+  std::lock_guard<std::mutex> lock(getReportMutex());
+  ScopeStats& stats = getScopeStatsUnlocked()[name];
+  ++stats.count;
+  stats.totalTime += duration;
+  stats.peakRssBytes = std::max(stats.peakRssBytes, peakRssBytes);
+  if (irSize != -1) {
+    stats.irSize = irSize;
+  }
+}
+
+std::unique_ptr<PassInstrumentation> createTimingReportInstrumentation() {
+  return std::make_unique<TimingReportInstrumentation>();
+}
+
+}  // namespace sdy
+}  // namespace mlir
@@ -0,0 +1,88 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_COMMON_TIMING_REPORT_H_
+#define SHARDY_COMMON_TIMING_REPORT_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Pass/PassInstrumentation.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace sdy {
+
+// A process-wide report of the time, memory and IR size of named scopes, which
+// are either passes (see `createTimingReportInstrumentation`) or steps within
+// passes (see `TimingReportScope`). Unlike `--mlir-timing`, it covers the steps
+// within a pass, and it can be written as JSON.
+//
+// The report is disabled by default, in which case scopes are no-ops.
+
+// Enables the timing report, and clears anything recorded so far. Subsequent
+// non-fatal `SDY_LOG` messages are added to the report as well.
+void enableTimingReport();
+
+// Returns whether the timing report is enabled.
+bool isTimingReportEnabled();
+
+// Writes the timing report as JSON to `os`, with an entry per scope name
+// holding the number of times it ran, the total time in seconds, the peak RSS
+// of the process at the end of the scope, and, if known, the number of ops in
+// the IR at the end of the scope, followed by the log messages.
+void writeTimingReportJson(llvm::raw_ostream& os);
+
+// Returns the total time in seconds recorded under the scope `name`, or
+// nullopt if no such scope ran.
+std::optional<double> getTimingReportSeconds(StringRef name);
+
+// Returns the peak resident set size of the process in bytes, or -1 if it
+// isn't supported on this platform.
+int64_t getPeakRssBytes();
+
+// Records the time taken between the construction and the destruction of this
+// object in the timing report, under `name` prefixed by the names of the
+// enclosing scopes on the same thread (separated by "/").
+//
+// If `irRoot` is specified, the number of ops nested in it at the end of the
+// scope is recorded as well.
+class TimingReportScope {
+ public:
+  explicit TimingReportScope(StringRef name, Operation* irRoot = nullptr);
+  ~TimingReportScope();
+
+  TimingReportScope(const TimingReportScope&) = delete;
+  TimingReportScope& operator=(const TimingReportScope&) = delete;
+
+ private:
+  bool enabled;
+  Operation* irRoot;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Returns a pass instrumentation that records a `TimingReportScope` for every
+// pass that runs, including the number of ops of the op it runs on.
+std::unique_ptr<PassInstrumentation> createTimingReportInstrumentation();
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_COMMON_TIMING_REPORT_H_
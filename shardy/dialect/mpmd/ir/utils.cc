@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "shardy/dialect/mpmd/ir/utils.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -28,6 +29,7 @@ limitations under the License.
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Bytecode/BytecodeWriter.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
@@ -233,6 +235,19 @@ llvm::DenseMap<StringRef, sdy::MeshAttr> GetMeshesByName(
   return meshes_by_name;
 }
 
+int64_t GetSizeInBytes(RankedTensorType type) {
+  return llvm::divideCeil(type.getNumElements() * type.getElementTypeBitWidth(),
+                          8);
+}
+
+int64_t GetLocalSizeInBytes(MeshTensorType type, sdy::MeshAttr mesh_attr) {
+  return GetSizeInBytes(type.getLocalTensorType(mesh_attr));
+}
+
+int64_t GetLocalSizeInBytes(MeshTensorType type, Operation* op) {
+  return GetSizeInBytes(type.getLocalTensorType(op));
+}
+
 Type GetLocalTensorTypeFromMeshType(Value value, sdy::MeshAttr mesh_attr) {
   return cast<MeshTensorType>(value.getType()).getLocalTensorType(mesh_attr);
 }
@@ -467,22 +482,38 @@ std::vector<int64_t> GetTransposeCounts(FragmentOp fragment) {
   return transpose_counts;
 }
 
+// The accessors below are called by scheduling comparators, so they read the
+// transpose counts from the origins in place rather than collecting them.
+
 std::optional<int64_t> TryToFindSingleTransposeCount(FragmentOp fragment) {
-  std::vector<int64_t> transpose_counts = GetTransposeCounts(fragment);
-  if (!transpose_counts.empty() &&
-      llvm::adjacent_find(transpose_counts, std::not_equal_to<>()) ==
-          transpose_counts.end()) {
-    return transpose_counts.front();
+  ArrayRef<Attribute> origin = fragment.getOrigin().getValue();
+  if (origin.empty()) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  int64_t transpose_count =
+      cast<UserOriginAttr>(origin.front()).getTransposeCount();
+  for (Attribute origin_attr : origin.drop_front()) {
+    if (cast<UserOriginAttr>(origin_attr).getTransposeCount() !=
+        transpose_count) {
+      return std::nullopt;
+    }
+  }
+  return transpose_count;
 }
 
 std::optional<int64_t> TryToFindMaxTransposeCount(FragmentOp fragment) {
-  std::vector<int64_t> transpose_counts = GetTransposeCounts(fragment);
-  if (!transpose_counts.empty()) {
-    return *llvm::max_element(transpose_counts);
+  ArrayRef<Attribute> origin = fragment.getOrigin().getValue();
+  if (origin.empty()) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  int64_t max_transpose_count =
+      cast<UserOriginAttr>(origin.front()).getTransposeCount();
+  for (Attribute origin_attr : origin.drop_front()) {
+    max_transpose_count = std::max(
+        max_transpose_count,
+        cast<UserOriginAttr>(origin_attr).getTransposeCount());
+  }
+  return max_transpose_count;
 }
 
 std::optional<int64_t> TryToFindFragmentTransposeCount(FragmentOp fragment) {
@@ -491,16 +522,17 @@ std::optional<int64_t> TryToFindFragmentTransposeCount(FragmentOp fragment) {
   if (single_transpose_count.has_value()) {
     return single_transpose_count;
   }
-  std::optional<int64_t> merged_transpose_count =
-      TryToFindMaxTransposeCount(fragment);
-  if (IsRemat(fragment) && merged_transpose_count.has_value()) {
-    return merged_transpose_count;
+  if (IsRemat(fragment)) {
+    return TryToFindMaxTransposeCount(fragment);
   }
   return std::nullopt;
 }
 
 std::optional<uint32_t> TryToFindCallCounter(FragmentOp fragment) {
-  if (auto count = fragment->getAttrOfType<IntegerAttr>(kCallCounterAttrName)) {
+  // The call counter is never an inherent attribute, so skip looking it up
+  // among the inherent attributes of the fragment.
+  if (auto count = dyn_cast_or_null<IntegerAttr>(
+          fragment->getDiscardableAttr(kCallCounterAttrName))) {
     SDY_CHECK(count.getType().isUnsignedInteger(32));
     return count.getUInt();
   }
@@ -733,6 +765,40 @@ void ReplaceAssignsWithChainedTransfers(SmallVector<AssignOp>& assigns,
   }
 }
 
+void ReplaceAssignsWithTransferTree(SmallVector<AssignOp>& assigns,
+                                    Value source, int fan_out,
+                                    RewriterBase& rewriter) {
+  SDY_CHECK_GT(fan_out, 0);
+  llvm::stable_sort(assigns, [](AssignOp a, AssignOp b) {
+    return IsMeshBeforeOtherMesh(a.getType().getMeshName(),
+                                 b.getType().getMeshName());
+  });
+  // As for chained transfers, insert all transfers before the earliest assign
+  // in block order so that every transfer dominates its uses.
+  AssignOp first_assign_in_block = *llvm::min_element(
+      assigns, [](AssignOp a, AssignOp b) { return a->isBeforeInBlock(b); });
+  rewriter.setInsertionPoint(first_assign_in_block);
+
+  // The nodes of the tree, in mesh order, where node 0 is `source` and the
+  // parent of node `i > 0` is node `(i - 1) / fan_out`.
+  SmallVector<Value> nodes = {source};
+  llvm::SmallDenseMap<Type, Value> type_to_node = {
+      {source.getType(), source}};
+  for (AssignOp assign : assigns) {
+    auto [it, inserted] = type_to_node.try_emplace(assign.getType());
+    if (inserted) {
+      Value parent = nodes[(nodes.size() - 1) / fan_out];
+      auto transfer = TransferOp::create(rewriter, assign.getLoc(),
+                                         assign.getType(), parent);
+      SDY_VLOG(2) << "Created cross-mesh transfer in transfer tree: "
+                  << transfer;
+      it->second = transfer.getResult();
+      nodes.push_back(transfer.getResult());
+    }
+    rewriter.replaceOp(assign, it->second);
+  }
+}
+
 Operation* FindAnnotatedOperation(ModuleOp module, StringRef annotation) {
   Operation* result = nullptr;
   module->walk([&](Operation* op) {
@@ -77,6 +77,12 @@ inline constexpr StringRef kJaxResultInfoAttr = "jax.result_info";
 // The attribute that holds the list of pass names that inferred a fragment.
 inline constexpr StringRef kInferredByAttr = "mpmd.inferred_by";
 
+// The attribute that marks the inter-mesh transfers that can be sent together,
+// e.g., by a runtime that batches sends. Transfers in the same batch have the
+// same producer and consumer fragments, and the same attribute value, which is
+// unique within their function.
+inline constexpr StringRef kTransferBatchAttr = "mpmd.transfer_batch";
+
 // Sets the `mpmd.inferred_by` attribute on `op` with the given `pass_name`.
 inline void SetInferredByAttr(Operation* op, StringRef pass_name,
                               OpBuilder& builder) {
@@ -191,6 +197,18 @@ ArrayRef<NamedMeshAttr> GetTopologyMeshes(func::FuncOp func_op);
 llvm::DenseMap<StringRef, sdy::MeshAttr> GetMeshesByName(
     ArrayRef<NamedMeshAttr> meshes);
 
+// Returns the size in bytes of a tensor of `type`, rounding the total number of
+// bits up to a whole byte.
+int64_t GetSizeInBytes(RankedTensorType type);
+
+// Returns the size in bytes of the local tensor of `type` on each device of
+// `mesh_attr`.
+int64_t GetLocalSizeInBytes(MeshTensorType type, sdy::MeshAttr mesh_attr);
+
+// Returns the size in bytes of the local tensor of `type` on each device of
+// the mesh of `op`.
+int64_t GetLocalSizeInBytes(MeshTensorType type, Operation* op);
+
 // Casts the type of `value` into a MeshTensorType and returns its local type.
 Type GetLocalTensorTypeFromMeshType(Value value, sdy::MeshAttr mesh_attr);
 
@@ -378,6 +396,19 @@ SmallVector<AssignOp> GetCrossMeshAssignUsers(UnassignOp unassign_op);
 void ReplaceAssignsWithChainedTransfers(SmallVector<AssignOp>& assigns,
                                         Value source, RewriterBase& rewriter);
 
+// Same as `ReplaceAssignsWithChainedTransfers`, but the transfers form a tree
+// in which each mesh transfers to at most `fan_out` other meshes, in mesh
+// order: the mesh of `source` transfers to the first `fan_out` meshes, the
+// first of those to the next `fan_out` meshes, and so on. This bounds the
+// egress of every mesh while keeping the number of hops to any mesh
+// logarithmic in the number of meshes, rather than linear as in a chain.
+//
+// Assigns to the same mesh share a single transfer, and assigns to the mesh of
+// `source` are replaced with `source`.
+void ReplaceAssignsWithTransferTree(SmallVector<AssignOp>& assigns,
+                                    Value source, int fan_out,
+                                    RewriterBase& rewriter);
+
 // Finds an operation inside `module` that carries an attribute named
 // `annotation`. Returns `nullptr` if such operation does not exist.
 Operation* FindAnnotatedOperation(ModuleOp module, StringRef annotation);
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "shardy/dialect/mpmd/ir/utils.h"
 
+#include <iterator>
 #include <optional>
 #include <string>
 #include <utility>
@@ -617,6 +618,34 @@ TEST(TryToFindMaxTransposeCount,
   EXPECT_THAT(TryToFindMaxTransposeCount(fragment_op), Eq(321));
 }
 
+TEST(TryToFindCallCounter, ShouldReturnCallCounterIfDefined) {
+  const std::string kProgram = R"mlir(
+    !mesh_1_tensor_4_8_f32 = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+    func.func @main(%arg0: !mesh_1_tensor_4_8_f32)
+      -> (!mesh_1_tensor_4_8_f32) attributes {"topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+      %0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) {call_counter = 3 : ui32} (%arg2: tensor<4x8xf32>) {
+        mpmd.return %arg2 : tensor<4x8xf32>
+      } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+      %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) (%arg2: tensor<4x8xf32>) {
+        mpmd.return %arg2 : tensor<4x8xf32>
+      } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+      return %1 : !mesh_1_tensor_4_8_f32
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  SDY_CHECK(module);
+  auto main_func = GetMainFunction(*module);
+  SDY_CHECK(main_func);
+  auto fragments = main_func.getOps<FragmentOp>();
+  EXPECT_THAT(TryToFindCallCounter(*fragments.begin()), Optional(3));
+  EXPECT_THAT(TryToFindCallCounter(*std::next(fragments.begin())),
+              Eq(std::nullopt));
+}
+
 TEST(IsExecutedImmediatelyAfter,
      ShouldReturnTrueIfBackwardIsImmediatelyAfterForwardFragmentInSameMesh) {
   const char kProgram[] = R"mlir(
@@ -1039,5 +1068,51 @@ TEST(GetCrossMeshAssignUsers, MultipleCrossMeshAssigns) {
   EXPECT_EQ(result.size(), 2);
 }
 
+TEST(GetSizeInBytes, RoundsUpToWholeBytes) {
+  const char kProgram[] = R"mlir(
+    func.func @main(%arg0: tensor<4x8xf32>, %arg1: tensor<3xi1>) {
+      func.return
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  SDY_CHECK(module);
+  FuncOp func = GetMainFunction(*module);
+  EXPECT_EQ(GetSizeInBytes(
+                cast<RankedTensorType>(func.getArgument(0).getType())),
+            128);
+  EXPECT_EQ(GetSizeInBytes(
+                cast<RankedTensorType>(func.getArgument(1).getType())),
+            1);
+}
+
+TEST(GetLocalSizeInBytes, DividesShardedDimensions) {
+  const char kProgram[] = R"mlir(
+    !replicated_t = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+    !sharded_t = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>, sharding=<@mesh, [{"x"}, {"y"}]>>
+    func.func @main(%arg0: !replicated_t, %arg1: !sharded_t)
+      attributes {"topology"=#mpmd.topology<<"m1": <["x"=2, "y"=4]>>>} {
+      func.return
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  SDY_CHECK(module);
+  FuncOp func = GetMainFunction(*module);
+  sdy::MeshAttr mesh = GetTopologyMeshes(func).front().getMesh();
+  EXPECT_EQ(GetLocalSizeInBytes(
+                cast<MeshTensorType>(func.getArgument(0).getType()), mesh),
+            128);
+  EXPECT_EQ(GetLocalSizeInBytes(
+                cast<MeshTensorType>(func.getArgument(1).getType()), mesh),
+            16);
+}
+
 }  // namespace
 }  // namespace mlir::mpmd
@@ -19,6 +19,7 @@ limitations under the License.
 #include "llvm/ADT/SetVector.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/OpDefinition.h"
@@ -131,13 +132,35 @@ SmallVector<TransferOp> GetTransferConsumers(FragmentOp fragment) {
   return transfers.takeVector();
 }
 
+// Moving an op invalidates the op order of its block, which makes the next
+// `isBeforeInBlock` query linear in the size of the block. Since the patterns
+// below query the closest consumers and producers on every match, and most
+// transfers are already where they need to be after the first match, we skip
+// moves that would leave the op in place.
+
+// Moves `op` right before `dest`, unless it is already there.
+void MoveOpBeforeIfNeeded(Operation* op, Operation* dest,
+                          RewriterBase& rewriter) {
+  if (op->getNextNode() != dest) {
+    rewriter.moveOpBefore(op, dest);
+  }
+}
+
+// Moves `op` right after `dest`, unless it is already there.
+void MoveOpAfterIfNeeded(Operation* op, Operation* dest,
+                         RewriterBase& rewriter) {
+  if (op->getPrevNode() != dest) {
+    rewriter.moveOpAfter(op, dest);
+  }
+}
+
 // Moves any transfer in `transfers` right before its first consumer, or removes
 // it if it has no consumer.
 void MoveTransfersToConsumerSites(ArrayRef<TransferOp> transfers,
                                   RewriterBase& rewriter) {
   for (TransferOp transfer : transfers) {
     if (Operation* closest_consumer = ClosestConsumer(transfer)) {
-      rewriter.moveOpBefore(transfer, closest_consumer);
+      MoveOpBeforeIfNeeded(transfer, closest_consumer, rewriter);
     } else {
       // If the transfer doesn't have a consumer, we simply remove it.
       rewriter.eraseOp(transfer);
@@ -255,9 +278,13 @@ void MoveTransfersToProducerSites(ArrayRef<TransferOp> transfers,
                                   RewriterBase& rewriter) {
   for (TransferOp transfer : transfers) {
     if (auto arg = dyn_cast<BlockArgument>(transfer.getOperand())) {
-      rewriter.moveOpBefore(transfer, arg.getOwner(), arg.getOwner()->begin());
+      Block* block = arg.getOwner();
+      if (&block->front() != transfer) {
+        rewriter.moveOpBefore(transfer, block, block->begin());
+      }
     } else {
-      rewriter.moveOpAfter(transfer, transfer.getOperand().getDefiningOp());
+      MoveOpAfterIfNeeded(transfer, transfer.getOperand().getDefiningOp(),
+                          rewriter);
     }
   }
 }
@@ -349,7 +376,7 @@ class AbsorbClosestConsumerPattern : public OpRewritePattern<FragmentOp> {
       new_fragment_dest = new_fragment_dest->getNextNode();
     }
     FragmentOp new_fragment = MergeFragments(op, inferred_consumer, rewriter);
-    rewriter.moveOpBefore(new_fragment, new_fragment_dest);
+    MoveOpBeforeIfNeeded(new_fragment, new_fragment_dest, rewriter);
     new_fragment->setDiscardableAttrs(discardable_attrs);
     return success();
   }
@@ -16,6 +16,7 @@ limitations under the License.
 #include <string_view>
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Block.h"
@@ -95,14 +96,23 @@ class CallInlinePass : public impl::CallInlinePassBase<CallInlinePass> {
  protected:
   void runOnOperation() final {
     ModuleOp module_op = getOperation();
-    module_op.walk([](CallOp call_op) {
+    // The number of calls to each callee that are yet to be inlined. The body
+    // of a private callee is moved into its last call instead of being cloned,
+    // which saves one copy of every callee body on deep models.
+    llvm::DenseMap<Operation*, int64_t> num_pending_calls;
+    module_op.walk([&](CallOp call_op) {
+      ++num_pending_calls[cast<CallOpInterface>(*call_op).resolveCallable()];
+    });
+    module_op.walk([&](CallOp call_op) {
       CallOpInliner inliner(call_op->getContext(), call_op);
       InlinerConfig config;
       auto call_op_interface = cast<CallOpInterface>(*call_op);
       FuncOp callable = cast<FuncOp>(call_op_interface.resolveCallable());
-      auto res = inlineCall(inliner, config.getCloneCallback(),
-                            call_op_interface, callable, &callable.getRegion(),
-                            /*shouldCloneInlinedRegion =*/true);
+      bool is_last_call = --num_pending_calls[callable] == 0;
+      auto res = inlineCall(
+          inliner, config.getCloneCallback(), call_op_interface, callable,
+          &callable.getRegion(),
+          /*shouldCloneInlinedRegion =*/!is_last_call || !callable.isPrivate());
       SDY_CHECK(res.succeeded())
           << "Failed to inline " << std::string_view(callable.getSymName());
       call_op->erase();
@@ -149,11 +159,11 @@ class SinkNegligibleOpsIntoCallOpPass
       }
       // We are guaranteed a single edge target (`arg`) in this case.
       BlockArgument arg = cast<BlockArgument>(edge.targets.front());
-      // We only allow sinking of ops without operands, assuming that these will
-      // be negligible, as this may duplicate such ops.
+      // We only allow sinking of negligible ops, as this may duplicate such
+      // ops.
       if (Operation* operand_producer = first_operand->get().getDefiningOp();
-          operand_producer && operand_producer->getNumOperands() == 0 &&
-          operand_producer->getNumResults() == 1) {
+          operand_producer &&
+          IsNegligibleOp(operand_producer, maxNegligibleBytes)) {
         Operation* cloned = Clone(block_builder, *operand_producer, {});
         arg.replaceAllUsesWith(cloned->getResult(0));
         erase_arguments.set(arg.getArgNumber());
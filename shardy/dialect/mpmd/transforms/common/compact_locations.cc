@@ -0,0 +1,184 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Block.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Region.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/transforms/common/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/sdy/ir/constants.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_COMPACTLOCATIONSPASS
+#include "shardy/dialect/mpmd/transforms/common/passes.h.inc"
+
+namespace {
+
+using ::mlir::func::FuncOp;
+
+// The attributes Shardy saves on ops and function arguments and results to
+// debug propagation, which are dropped with `strip-debug-info`.
+constexpr StringRef kShardingDebugAttrs[] = {
+    sdy::kShardingOriginsAttr,          sdy::kPropagationEdgesAttr,
+    sdy::kBlockArgShardingOriginsAttr,  sdy::kBlockArgPropagationEdgesAttr,
+    sdy::kResultShardingOriginsAttr,    sdy::kResultPropagationEdgesAttr,
+    sdy::kShardingOriginNameAttr,
+};
+
+// Compacts locations while interning the results, so that each distinct
+// location (at a given depth) is only compacted once.
+class LocationCompactor {
+ public:
+  LocationCompactor(MLIRContext* context, int64_t max_fused_locations,
+                    int64_t max_depth)
+      : unknown_loc_(UnknownLoc::get(context)),
+        max_fused_locations_(max_fused_locations),
+        max_depth_(max_depth) {}
+
+  Location Compact(Location loc) { return Compact(loc, /*depth=*/0); }
+
+ private:
+  Location Compact(Location loc, int64_t depth) {
+    if (max_depth_ > 0 && depth >= max_depth_) {
+      return unknown_loc_;
+    }
+    auto [it, inserted] = compacted_.try_emplace({loc, depth}, loc);
+    if (!inserted) {
+      return it->second;
+    }
+    Location compacted =
+        llvm::TypeSwitch<LocationAttr, Location>(loc)
+            .Case([&](FusedLoc fused_loc) -> Location {
+              ArrayRef<Location> locs = fused_loc.getLocations();
+              if (max_fused_locations_ > 0 &&
+                  static_cast<int64_t>(locs.size()) > max_fused_locations_) {
+                locs = locs.take_front(max_fused_locations_);
+              }
+              SmallVector<Location> compacted_locs = llvm::map_to_vector(
+                  locs, [&](Location sub_loc) {
+                    return Compact(sub_loc, depth + 1);
+                  });
+              return FusedLoc::get(loc.getContext(), compacted_locs,
+                                   fused_loc.getMetadata());
+            })
+            .Case([&](NameLoc name_loc) -> Location {
+              return NameLoc::get(name_loc.getName(),
+                                  Compact(name_loc.getChildLoc(), depth + 1));
+            })
+            .Case([&](CallSiteLoc call_loc) -> Location {
+              Location callee = Compact(call_loc.getCallee(), depth + 1);
+              Location caller = Compact(call_loc.getCaller(), depth + 1);
+              // Truncated call-site chains keep their innermost frames.
+              if (isa<UnknownLoc>(caller)) {
+                return callee;
+              }
+              return CallSiteLoc::get(callee, caller);
+            })
+            .Default([&](LocationAttr) -> Location { return loc; });
+    // `it` may have been invalidated by the recursive calls.
+    compacted_[{loc, depth}] = compacted;
+    return compacted;
+  }
+
+  Location unknown_loc_;
+  int64_t max_fused_locations_;
+  int64_t max_depth_;
+  llvm::DenseMap<std::pair<Location, int64_t>, Location> compacted_;
+};
+
+// Returns `origin` without duplicate entries, keeping the first occurrence of
+// each, or `origin` itself if it has none.
+ArrayAttr DedupOrigin(ArrayAttr origin) {
+  llvm::SmallSetVector<Attribute, 8> unique_origin(origin.begin(),
+                                                   origin.end());
+  if (unique_origin.size() == origin.size()) {
+    return origin;
+  }
+  return ArrayAttr::get(origin.getContext(), unique_origin.getArrayRef());
+}
+
+void RemoveShardingDebugAttrs(Operation* op) {
+  for (StringRef attr_name : kShardingDebugAttrs) {
+    op->removeAttr(attr_name);
+  }
+  if (auto func_op = dyn_cast<FuncOp>(op)) {
+    for (StringRef attr_name : kShardingDebugAttrs) {
+      for (int64_t i = 0; i < func_op.getNumArguments(); ++i) {
+        func_op.removeArgAttr(i, attr_name);
+      }
+      for (int64_t i = 0; i < func_op.getNumResults(); ++i) {
+        func_op.removeResultAttr(i, StringAttr::get(op->getContext(),
+                                                    attr_name));
+      }
+    }
+  }
+}
+
+class CompactLocationsPass
+    : public impl::CompactLocationsPassBase<CompactLocationsPass> {
+  using CompactLocationsPassBase::CompactLocationsPassBase;
+
+ private:
+  void runOnOperation() final {
+    ModuleOp module_op = getOperation();
+    MLIRContext* context = module_op.getContext();
+    Location unknown_loc = UnknownLoc::get(context);
+    LocationCompactor compactor(context, maxFusedLocations, maxLocationDepth);
+    auto compact = [&](Location loc) {
+      return stripDebugInfo ? unknown_loc : compactor.Compact(loc);
+    };
+
+    module_op.walk([&](Operation* op) {
+      op->setLoc(compact(op->getLoc()));
+      for (Region& region : op->getRegions()) {
+        for (Block& block : region) {
+          for (BlockArgument arg : block.getArguments()) {
+            arg.setLoc(compact(arg.getLoc()));
+          }
+        }
+      }
+      if (auto fragment = dyn_cast<FragmentOp>(op)) {
+        fragment.setOriginAttr(DedupOrigin(fragment.getOriginAttr()));
+      } else if (auto fragment_call = dyn_cast<FragmentCallOp>(op)) {
+        fragment_call.setOriginAttr(
+            DedupOrigin(fragment_call.getOriginAttr()));
+      }
+      if (stripDebugInfo) {
+        RemoveShardingDebugAttrs(op);
+      }
+    });
+  }
+};
+
+}  // namespace
+
+}  // namespace mlir::mpmd
@@ -13,8 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
+
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/PatternMatch.h"
@@ -23,7 +30,9 @@ limitations under the License.
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
 #include "shardy/dialect/mpmd/transforms/common/passes.h"  // IWYU pragma: keep
+#include "stablehlo/dialect/StablehloOps.h"
 
 namespace mlir::mpmd {
 
@@ -58,6 +67,36 @@ Operation* FindHloProducer(Value mesh_tensor) {
   return nullptr;
 }
 
+// Returns whether the constant `op` can be copied into its consumers, i.e.,
+// if it is a splat, which is cheap to materialize anywhere, or if
+// `max_size_bytes` isn't positive or bounds the size of the constant.
+bool IsCopyableConstant(Operation* op, int64_t max_size_bytes) {
+  if (max_size_bytes <= 0) {
+    return true;
+  }
+  if (DenseElementsAttr value;
+      matchPattern(op->getResult(0), m_Constant(&value)) && value.isSplat()) {
+    return true;
+  }
+  auto type = dyn_cast<RankedTensorType>(op->getResult(0).getType());
+  return type && type.hasStaticShape() &&
+         GetSizeInBytes(type) <= max_size_bytes;
+}
+
+// Returns the scalar constant broadcast by `op`, if `op` is a
+// broadcast_in_dim of a scalar constant, or nullptr otherwise.
+Operation* GetBroadcastScalarConstant(Operation* op) {
+  auto broadcast = dyn_cast<stablehlo::BroadcastInDimOp>(op);
+  if (!broadcast || broadcast.getOperand().getType().getRank() != 0) {
+    return nullptr;
+  }
+  Operation* scalar = broadcast.getOperand().getDefiningOp();
+  if (!scalar || !scalar->hasTrait<OpTrait::ConstantLike>()) {
+    return nullptr;
+  }
+  return scalar;
+}
+
 class CopyConstantsPass
     : public impl::CopyConstantsPassBase<CopyConstantsPass> {
   using CopyConstantsPassBase::CopyConstantsPassBase;
@@ -67,17 +106,50 @@ class CopyConstantsPass
     IRRewriter rewriter(func_op.getContext());
     Block& block = func_op.getBody().front();
     for (FragmentOp fragment : llvm::reverse(block.getOps<FragmentOp>())) {
+      // The copies in `fragment`, keyed by the op they copy, so that operands
+      // with the same producer, e.g., through different transfers, share it.
+      DenseMap<Operation*, Value> copies;
       for (OpOperand& operand : fragment->getOpOperands()) {
-        if (auto* hlo_producer = FindHloProducer(operand.get());
-            hlo_producer && hlo_producer->hasTrait<OpTrait::ConstantLike>()) {
-          rewriter.setInsertionPoint(fragment.getBody(),
-                                     fragment.getBody()->begin());
-          rewriter.replaceAllUsesWith(
-              fragment.getBody()->getArgument(operand.getOperandNumber()),
-              rewriter.clone(*hlo_producer)->getResult(0));
+        Operation* hlo_producer = FindHloProducer(operand.get());
+        if (!hlo_producer) {
+          continue;
+        }
+        Value copy = copies.lookup(hlo_producer);
+        if (!copy) {
+          copy = CopyIntoFragment(hlo_producer, fragment, rewriter);
+        }
+        if (!copy) {
+          continue;
         }
+        copies[hlo_producer] = copy;
+        rewriter.replaceAllUsesWith(
+            fragment.getBody()->getArgument(operand.getOperandNumber()), copy);
+      }
+    }
+  }
+
+ private:
+  // Copies `hlo_producer` to the start of `fragment` if it's a constant, or a
+  // broadcast of a scalar constant, that should be copied. Returns the copy or
+  // a null value if it wasn't copied.
+  Value CopyIntoFragment(Operation* hlo_producer, FragmentOp fragment,
+                         IRRewriter& rewriter) {
+    rewriter.setInsertionPoint(fragment.getBody(), fragment.getBody()->begin());
+    if (hlo_producer->hasTrait<OpTrait::ConstantLike>()) {
+      if (!IsCopyableConstant(hlo_producer, maxConstantSizeBytes)) {
+        return nullptr;
       }
+      return rewriter.clone(*hlo_producer)->getResult(0);
+    }
+    if (!copyScalarBroadcasts) {
+      return nullptr;
     }
+    if (Operation* scalar = GetBroadcastScalarConstant(hlo_producer)) {
+      IRMapping mapping;
+      rewriter.clone(*scalar, mapping);
+      return rewriter.clone(*hlo_producer, mapping)->getResult(0);
+    }
+    return nullptr;
   }
 };
 
@@ -25,8 +25,15 @@ namespace mlir::mpmd {
 // functions (i.e., functions that have a mesh or topology in its attributes).
 // This is needed to omit any reduction specific functions for all our
 // partitioning and optimization passes.
+//
+// As with any function pass, the pass manager runs these passes on the
+// functions of a module concurrently when multi-threading is enabled, e.g.,
+// on the main function and the targets of mpmd.calls. Hence, `runOnFunc`
+// must only modify `func_op`, and may only read other functions that no pass
+// in the same pass manager modifies, e.g., non-distributed fragment callees.
 // TODO(aswietlik): Consider making this a ModuleOp pass with
-// GetMainFunction(module_op) instead.
+// GetMainFunction(module_op) instead. Note that this would serialize the
+// passes over functions.
 class DistributedFunctionPass : public OperationPass<func::FuncOp> {
  public:
   using OperationPass<func::FuncOp>::OperationPass;
@@ -16,7 +16,7 @@ limitations under the License.
 #include "shardy/dialect/mpmd/transforms/common/merge_fragments.h"
 
 #include <cstdint>
-#include <iterator>
+#include <map>
 #include <optional>
 #include <string>
 #include <utility>
@@ -94,8 +94,54 @@ FragmentOp FragmentOrNull(FailureOr<FragmentOp> merge_result) {
 
 }  // namespace
 
+FragmentOrder::FragmentOrder(FuncOp func_op) {
+  int32_t position = 0;
+  func_op.walk<WalkOrder::PreOrder>([&](Operation* op) {
+    if (op == func_op) {
+      return WalkResult::advance();
+    }
+    // A pre-order numbering is consistent with the order of each block.
+    if (auto fragment = dyn_cast<FragmentOp>(op)) {
+      Insert(fragment, position++);
+      return WalkResult::skip();
+    }
+    positions_[op] = position++;
+    return WalkResult::advance();
+  });
+}
+
+bool FragmentOrder::IsBefore(Operation* op1, Operation* op2) const {
+  return GetPosition(op1) < GetPosition(op2);
+}
+
+FragmentOp FragmentOrder::GetNextFragmentOnMesh(FragmentOp fragment) const {
+  const std::map<int32_t, FragmentOp>& fragments =
+      mesh_fragments_.at(GetMeshKey(fragment));
+  auto next_it = fragments.upper_bound(GetPosition(fragment));
+  return next_it == fragments.end() ? nullptr : next_it->second;
+}
+
+int32_t FragmentOrder::GetPosition(Operation* op) const {
+  auto it = positions_.find(op);
+  SDY_CHECK(it != positions_.end()) << "Expected the op to be in the order";
+  return it->second;
+}
+
+void FragmentOrder::Insert(FragmentOp fragment, int32_t position) {
+  positions_[fragment] = position;
+  mesh_fragments_[GetMeshKey(fragment)][position] = fragment;
+}
+
+void FragmentOrder::Erase(FragmentOp fragment) {
+  auto it = positions_.find(fragment);
+  SDY_CHECK(it != positions_.end())
+      << "Expected the fragment to be in the order";
+  mesh_fragments_[GetMeshKey(fragment)].erase(it->second);
+  positions_.erase(it);
+}
+
 FailureOr<FragmentOp> MergeFragmentBasePass::GetMergeCandidate(
-    FragmentOp producer_op, OpOrderMap& order) const {
+    FragmentOp producer_op, const FragmentOrder& order) const {
   SDY_CHECK(llvm::all_of(producer_op->getUsers(), [&](Operation* user) {
     return producer_op->getBlock() == user->getBlock();
   })) << "Expected all users of the producer op to be in the same block";
@@ -107,7 +153,7 @@ FailureOr<FragmentOp> MergeFragmentBasePass::GetMergeCandidate(
     }
   }
   llvm::stable_sort(sorted_fragment_users, [&](FragmentOp a, FragmentOp b) {
-    return FastIsBeforeInBlock(a, b, order);
+    return order.IsBefore(a, b);
   });
 
   if (sorted_fragment_users.empty()) {
@@ -117,7 +163,8 @@ FailureOr<FragmentOp> MergeFragmentBasePass::GetMergeCandidate(
   if (AllowMergingWithAnyConsumer()) {
     // Find the closest user that is mergeable.
     auto* find_it = llvm::find_if(sorted_fragment_users, [&](FragmentOp user) {
-      return succeeded(AllowMerging(producer_op, user, /*log_failure=*/false));
+      return succeeded(
+          AllowMerging(producer_op, user, order, /*log_failure=*/false));
     });
     if (find_it == sorted_fragment_users.end()) {
       return mergeFailure("Failed to find a fragment user to merge with");
@@ -127,49 +174,42 @@ FailureOr<FragmentOp> MergeFragmentBasePass::GetMergeCandidate(
 
   // Merge with the closest user.
   FragmentOp mergeable_user = *sorted_fragment_users.begin();
-  if (failed(AllowMerging(producer_op, mergeable_user, /*log_failure=*/true))) {
+  if (failed(AllowMerging(producer_op, mergeable_user, order,
+                          /*log_failure=*/true))) {
     return failure();
   }
   return mergeable_user;
 }
 
-bool MergeFragmentBasePass::FastIsBeforeInBlock(Operation* op1, Operation* op2,
-                                                OpOrderMap& order) const {
-  auto it1 = order.find(op1);
-  auto it2 = order.find(op2);
-  SDY_CHECK(it1 != order.end() && it2 != order.end())
-      << "Expected both ops to be in the order map";
-  return it1->second < it2->second;
-}
-
 // Returns true if the producer can be merged with the consumer at the
 // position of the producer: i.e., all consumer's operands are produced by
 // the producer or by an earlier op.
-bool MergeFragmentBasePass::CanMergeAtProducer(Operation* producer,
-                                               Operation* consumer,
-                                               OpOrderMap& order) const {
+bool MergeFragmentBasePass::CanMergeAtProducer(
+    Operation* producer, Operation* consumer,
+    const FragmentOrder& order) const {
   return llvm::all_of(consumer->getOpOperands(), [&](OpOperand& operand) {
     Operation* operand_producer = operand.get().getDefiningOp();
     return !operand_producer || operand_producer == producer ||
-           FastIsBeforeInBlock(operand_producer, producer, order);
+           order.IsBefore(operand_producer, producer);
   });
 }
 
 // Returns true if the producer can be merged with the consumer at the
 // position of the consumer: i.e., no ops in between the consumer and
 // producer uses the producer's results.
-bool MergeFragmentBasePass::CanMergeAtConsumer(Operation* producer,
-                                               Operation* consumer,
-                                               OpOrderMap& order) const {
+bool MergeFragmentBasePass::CanMergeAtConsumer(
+    Operation* producer, Operation* consumer,
+    const FragmentOrder& order) const {
   return llvm::none_of(producer->getUsers(), [&](Operation* op) {
-    return FastIsBeforeInBlock(op, consumer, order);
+    return order.IsBefore(op, consumer);
   });
 }
 
 // Tries to merge the fragment and returns the merged fragment, or an error
 // status if merging isn't possible.
 FailureOr<FragmentOp> MergeFragmentBasePass::MergeFragmentsRewrite(
-    FragmentOp producer_op, RewriterBase& rewriter, OpOrderMap& order) const {
+    FragmentOp producer_op, RewriterBase& rewriter,
+    FragmentOrder& order) const {
   FragmentOp mergeable_user;
   if (FailureOr<FragmentOp> merge_candidate =
           GetMergeCandidate(producer_op, order);
@@ -199,6 +239,14 @@ FailureOr<FragmentOp> MergeFragmentBasePass::MergeFragmentsRewrite(
   SmallVector<std::pair<StringRef, Attribute>> merged_attributes =
       MergeAttributes(producer_op, mergeable_user);
 
+  // Notice that we merge at the producer by first moving the consumer right
+  // after the producer above, still `can_merge_at_consumer` is with respect
+  // to the original consumer, and hence we update the order accordingly.
+  int32_t merged_position = order.GetPosition(
+      can_merge_at_consumer ? mergeable_user : producer_op);
+  order.Erase(producer_op);
+  order.Erase(mergeable_user);
+
   // Now we can merge `producer_op` with `consumer_op`.
   FragmentOp merged_fragment =
       MergeFragments(producer_op, mergeable_user, rewriter);
@@ -207,11 +255,7 @@ FailureOr<FragmentOp> MergeFragmentBasePass::MergeFragmentsRewrite(
     merged_fragment->setAttr(attr_name, attr);
   }
 
-  // Notice that we merge at the producer by first moving the consumer right
-  // after the producer above, still `can_merge_at_consumer` is with respect
-  // to the original consumer, and hence we update the order map accordingly.
-  order[merged_fragment] =
-      can_merge_at_consumer ? order[mergeable_user] : order[producer_op];
+  order.Insert(merged_fragment, merged_position);
   return merged_fragment;
 }
 
@@ -221,7 +265,8 @@ FailureOr<FragmentOp> MergeFragmentBasePass::MergeFragmentsRewrite(
 // Pre-condition: All users of the producer_op have been processed by this
 // rewrite, i.e., we do the rewrite in post-order traversal.
 void MergeFragmentBasePass::MergeFragmentsRecursivelyRewrite(
-    FragmentOp producer_op, RewriterBase& rewriter, OpOrderMap& order) const {
+    FragmentOp producer_op, RewriterBase& rewriter,
+    FragmentOrder& order) const {
   FragmentOp last_merged = producer_op;
   // Because all users have been processed, we will never need to merge
   // transitive users. E.g., when processing f1, we won't have a mergeable
@@ -239,15 +284,7 @@ void MergeFragmentBasePass::runOnFunc(FuncOp func_op) {
   MLIRContext* context = func_op->getContext();
   IRRewriter rewriter(context);
 
-  OpOrderMap order;
-  // Traversals are cheap but growing the map is expensive, so we pre-grow it.
-  order.reserve(
-      std::distance(func_op.getOps().begin(), func_op.getOps().end()) + 1);
-  for (auto [index, op] : llvm::enumerate(func_op.getOps())) {
-    // NB: we start at 1 to have a way to verify that an op is not in the map
-    // by checking if order[op] == 0.
-    order[&op] = index + 1;
-  }
+  FragmentOrder order(func_op);
 
   // We do a post-order traversal as we want to process all users before the
   // op itself, for guarantees around unused fragment removal (see below).
@@ -269,6 +306,7 @@ void MergeFragmentBasePass::runOnFunc(FuncOp func_op) {
     // to merge with any removable fragments as they would've already
     // been removed.
     if (fragment.use_empty() && isPure(fragment)) {
+      order.Erase(fragment);
       rewriter.eraseOp(fragment);
     } else {
       // We need to merge recursively, because a fragment `f1` could be
@@ -301,6 +339,7 @@ class MergeInferredFragmentsPass
 
  protected:
   LogicalResult AllowMerging(FragmentOp producer_op, FragmentOp consumer_op,
+                             const FragmentOrder& order,
                              bool log_failure) const final {
     if (producer_op.isUserFragment() && consumer_op.isUserFragment()) {
       return mergeFailure("Cannot merge two user fragments", log_failure);
@@ -321,8 +360,8 @@ class MergeInferredFragmentsPass
 
   bool AllowMergingWithAnyConsumer() const final { return mergeAnyConsumer; }
 
-  FailureOr<FragmentOp> GetMergeCandidate(FragmentOp producer_op,
-                                          OpOrderMap& order) const final {
+  FailureOr<FragmentOp> GetMergeCandidate(
+      FragmentOp producer_op, const FragmentOrder& order) const final {
     if (!mergeSideways) {
       return MergeFragmentBasePass::GetMergeCandidate(producer_op, order);
     }
@@ -330,22 +369,12 @@ class MergeInferredFragmentsPass
     SDY_CHECK(!mergeAnyConsumer)
         << "merge-sideways cannot be used with merge-any-consumer";
 
-    Operation* current = producer_op->getNextNode();
-    while (current) {
-      if (auto fragment = dyn_cast<FragmentOp>(current);
-          fragment && fragment.getMeshName() == producer_op.getMeshName()) {
-        current = fragment;
-        break;
-      }
-      current = current->getNextNode();
-    }
-
-    if (!current) {
+    FragmentOp merge_candidate = order.GetNextFragmentOnMesh(producer_op);
+    if (!merge_candidate) {
       return mergeFailure("No mergeable fragment in the same mesh.");
     }
 
-    auto merge_candidate = cast<FragmentOp>(current);
-    if (failed(AllowMerging(producer_op, merge_candidate,
+    if (failed(AllowMerging(producer_op, merge_candidate, order,
                             /*log_failure=*/true))) {
       return failure();
     }
@@ -363,12 +392,13 @@ class MergeForwardWithBackwardPass
 
  protected:
   LogicalResult AllowMerging(FragmentOp producer_op, FragmentOp consumer_op,
+                             const FragmentOrder& order,
                              bool log_failure) const final {
     // Check that the producer forward fragment and is immediately before
     // the consumer backward fragment. This is only true for the last stage
     // for 1F1B so it will not merge any fragments in previous stages, which
     // is the intended behavior.
-    if (!IsExecutedImmediatelyAfter(producer_op, consumer_op)) {
+    if (order.GetNextFragmentOnMesh(producer_op) != consumer_op) {
       return mergeFailure(
           "The consumer fragment must appear immediately after the "
           "producer fragment (modulo fragments in other meshes).",
@@ -394,6 +424,7 @@ class MergeUserDefinedFragmentsIntoSchedulingUnitsPass
 
  protected:
   LogicalResult AllowMerging(FragmentOp producer_op, FragmentOp consumer_op,
+                             const FragmentOrder& order,
                              bool log_failure) const final {
     if (!producer_op.isUserFragment() || !consumer_op.isUserFragment()) {
       return mergeFailure("Cannot merge inferred fragments", log_failure);
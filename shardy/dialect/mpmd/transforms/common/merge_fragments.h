@@ -17,8 +17,14 @@ limitations under the License.
 #define SHARDY_DIALECT_MPMD_TRANSFORMS_COMMON_MERGE_FRAGMENTS_H_
 
 #include <cstdint>
+#include <map>
+#include <utility>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
+#include "mlir/IR/Operation.h"
 #include "mlir/Interfaces/LoopLikeInterface.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
@@ -28,15 +34,59 @@ limitations under the License.
 
 namespace mlir::mpmd {
 
+// The program order of the ops of a function, and of the fragments of each
+// mesh, while its fragments are merged.
+//
+// Merging replaces two fragments with a new one, and moves a consumer up to
+// its producer when merging at the producer. Rather than renumbering the block
+// after every merge, the merge updates the order incrementally: the merged
+// fragment takes the position of the fragment it's merged at, which is still
+// consistent with the rest of the block, and the fragments it replaces are
+// dropped. Program-order queries are then constant-time lookups, and finding
+// the next fragment of a mesh is logarithmic in the number of its fragments.
+//
+// Only ops in the function body and in non-fragment regions are ordered, i.e.,
+// not the ops in fragment bodies.
+class FragmentOrder {
+ public:
+  explicit FragmentOrder(func::FuncOp func_op);
+
+  // Returns whether `op1` is before `op2`, which must be ordered ops of the
+  // same block.
+  bool IsBefore(Operation* op1, Operation* op2) const;
+
+  // Returns the first fragment on the mesh of `fragment` after it in its
+  // block, or null if there is none.
+  FragmentOp GetNextFragmentOnMesh(FragmentOp fragment) const;
+
+  // Returns the position of `op`, which must be ordered.
+  int32_t GetPosition(Operation* op) const;
+
+  // Adds `fragment` at `position`, e.g., a merged fragment at the position of
+  // one of the fragments it replaces.
+  void Insert(FragmentOp fragment, int32_t position);
+
+  // Drops `fragment`. Must be called before it's erased.
+  void Erase(FragmentOp fragment);
+
+ private:
+  using MeshKey = std::pair<Block*, StringRef>;
+
+  static MeshKey GetMeshKey(FragmentOp fragment) {
+    return {fragment->getBlock(), fragment.getMeshName()};
+  }
+
+  DenseMap<Operation*, int32_t> positions_;
+  // The fragments of each mesh in each block, by position.
+  DenseMap<MeshKey, std::map<int32_t, FragmentOp>> mesh_fragments_;
+};
+
 class MergeFragmentBasePass : public DistributedFunctionPass {
  public:
   explicit MergeFragmentBasePass(TypeID passID)
       : DistributedFunctionPass(passID) {}
 
  protected:
-  // A map we will use to store the order of operations during merging.
-  using OpOrderMap = DenseMap<Operation*, int32_t>;
-
   // Checks whether `producer_op` and `consumer_op` may be merged. Must be
   // defined by subclasses of the pass.
   //
@@ -44,36 +94,34 @@ class MergeFragmentBasePass : public DistributedFunctionPass {
   // logged as a debug message.
   virtual LogicalResult AllowMerging(FragmentOp producer_op,
                                      FragmentOp consumer_op,
+                                     const FragmentOrder& order,
                                      bool log_failure) const = 0;
 
   // Whether a producer fragment should be merged with the closest mergeable
   // consumer or with the closest consumer.
   virtual bool AllowMergingWithAnyConsumer() const = 0;
 
-  virtual FailureOr<FragmentOp> GetMergeCandidate(FragmentOp producer_op,
-                                                  OpOrderMap& order) const;
+  virtual FailureOr<FragmentOp> GetMergeCandidate(
+      FragmentOp producer_op, const FragmentOrder& order) const;
 
  private:
-  bool FastIsBeforeInBlock(Operation* op1, Operation* op2,
-                           OpOrderMap& order) const;
-
   // Returns true if the producer can be merged with the consumer at the
   // position of the producer: i.e., all consumer's operands are produced by
   // the producer or by an earlier op.
   bool CanMergeAtProducer(Operation* producer, Operation* consumer,
-                          OpOrderMap& order) const;
+                          const FragmentOrder& order) const;
 
   // Returns true if the producer can be merged with the consumer at the
   // position of the consumer: i.e., no ops in between the consumer and
   // producer uses the producer's results.
   bool CanMergeAtConsumer(Operation* producer, Operation* consumer,
-                          OpOrderMap& order) const;
+                          const FragmentOrder& order) const;
 
   // Tries to merge the fragment and returns the merged fragment, or a failure
   // if merging isn't possible.
   FailureOr<FragmentOp> MergeFragmentsRewrite(FragmentOp producer_op,
                                               RewriterBase& rewriter,
-                                              OpOrderMap& order) const;
+                                              FragmentOrder& order) const;
 
   // Merges fragments recursively. A fragment may have multiple consumers that
   // can each be merged, so we merge one-by-one until no more merges are
@@ -83,7 +131,7 @@ class MergeFragmentBasePass : public DistributedFunctionPass {
   // rewrite, i.e., we do the rewrite in post-order traversal.
   void MergeFragmentsRecursivelyRewrite(FragmentOp producer_op,
                                         RewriterBase& rewriter,
-                                        OpOrderMap& order) const;
+                                        FragmentOrder& order) const;
 
  protected:
   void runOnFunc(func::FuncOp func_op) override;
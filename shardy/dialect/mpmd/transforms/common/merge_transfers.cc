@@ -13,22 +13,27 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <cstdint>
 #include <iterator>
 #include <utility>
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Dominance.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/Types.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Support/LLVM.h"
+#include "mlir/Transforms/CSE.h"
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
@@ -78,12 +83,18 @@ std::vector<TransferOp> GetNonConcatTransferUsers(Value value) {
 }
 
 // Checks if a value is eligible for merging, i.e., if it is not pinned to host,
-// not sharded, and the number of elements is below the threshold.
-bool IsEligibleForMerging(Value value) {
+// not sharded, and the number of elements is below the threshold. If
+// `bucket_size_bytes` is positive, then its size must be at most the bucket
+// size instead.
+bool IsPinnedToHost(MeshTensorType mesh_tensor_type) {
+  return mesh_tensor_type.getMemoryKind() &&
+         mesh_tensor_type.getMemoryKind().getValue() == kMemoryKindPinnedHost;
+}
+
+bool IsEligibleForMerging(Value value, int64_t bucket_size_bytes) {
   auto mesh_tensor_type = cast<MeshTensorType>(value.getType());
   // We do not concatenate values that are on the host or that are sharded.
-  if (mesh_tensor_type.getMemoryKind() &&
-      mesh_tensor_type.getMemoryKind().getValue() == kMemoryKindPinnedHost) {
+  if (IsPinnedToHost(mesh_tensor_type)) {
     return false;
   }
   if (mesh_tensor_type.getSharding() &&
@@ -91,6 +102,9 @@ bool IsEligibleForMerging(Value value) {
     return false;
   }
   RankedTensorType result_type = mesh_tensor_type.getRankedTensorType();
+  if (bucket_size_bytes > 0) {
+    return GetSizeInBytes(result_type) <= bucket_size_bytes;
+  }
   if (kNumElementsThreshold > -1 &&
       result_type.getNumElements() > kNumElementsThreshold) {
     // Being more aggressive here could impact runtime/memory performance.
@@ -102,6 +116,19 @@ bool IsEligibleForMerging(Value value) {
   return true;
 }
 
+// Checks if a value is eligible for batching, i.e., if it is not pinned to host
+// and, if `bucket_size_bytes` is positive, its size is at most the bucket size.
+// As batched values aren't concatenated, they can be of any size and sharding.
+bool IsEligibleForBatching(Value value, int64_t bucket_size_bytes) {
+  auto mesh_tensor_type = cast<MeshTensorType>(value.getType());
+  if (IsPinnedToHost(mesh_tensor_type)) {
+    return false;
+  }
+  return bucket_size_bytes <= 0 ||
+         GetSizeInBytes(mesh_tensor_type.getRankedTensorType()) <=
+             bucket_size_bytes;
+}
+
 SetVector<FragmentOp> FragmentUsers(Operation* op) {
   SetVector<FragmentOp> users;
   for (Operation* user : op->getUsers()) {
@@ -135,12 +162,13 @@ using TypeAndConsumerFragment = std::pair<RankedTensorType, FragmentOp>;
 // value.
 //
 // Values that are sharded, or allocated in pinned_host, or have more elements
-// than the threshold are not considered for concatenation.
+// than the threshold (or bytes than the bucket size) are not considered for
+// concatenation.
 llvm::MapVector<TypeAndConsumerFragment, std::vector<int>> FindValuesToConcat(
-    FragmentOp producer) {
+    FragmentOp producer, int64_t bucket_size_bytes) {
   llvm::MapVector<TypeAndConsumerFragment, std::vector<int>> values_to_concat;
   for (OpResult result : producer.getResults()) {
-    if (!IsEligibleForMerging(result)) {
+    if (!IsEligibleForMerging(result, bucket_size_bytes)) {
       continue;
     }
     auto result_type =
@@ -357,15 +385,117 @@ llvm::MapVector<BlockArgument, int> FindConsumerArgumentsToReplace(
   return consumer_args;
 }
 
+// Returns the position of each op in `block`.
+DenseMap<Operation*, int> GetOpPositions(Block* block) {
+  DenseMap<Operation*, int> op_positions;
+  for (auto [position, op] : llvm::enumerate(block->getOperations())) {
+    op_positions[&op] = position;
+  }
+  return op_positions;
+}
+
+// Returns the position in the body of `consumer` of the first op that uses the
+// result of `transfer`, or the number of ops in the body if there's no such op.
+int FindFirstUseInConsumer(TransferOp transfer, FragmentOp consumer,
+                           const DenseMap<Operation*, int>& op_positions) {
+  Block* body = consumer.getBody();
+  int first_use = body->getOperations().size();
+  for (OpOperand& transfer_use : transfer->getUses()) {
+    if (transfer_use.getOwner() != consumer) {
+      continue;
+    }
+    for (Operation* user :
+         body->getArgument(transfer_use.getOperandNumber()).getUsers()) {
+      first_use = std::min(
+          first_use, op_positions.lookup(body->findAncestorOpInBlock(*user)));
+    }
+  }
+  return first_use;
+}
+
+// Returns the position in the body of `consumer` of the first op that uses
+// the result `result_index` of `producer` via a transfer, or the number of ops
+// in the body if there's no such op.
+int FindFirstUseInConsumer(FragmentOp producer, int result_index,
+                           FragmentOp consumer,
+                           const DenseMap<Operation*, int>& op_positions) {
+  int first_use = consumer.getBody()->getOperations().size();
+  for (TransferOp transfer :
+       GetNonConcatTransferUsers(producer.getResult(result_index))) {
+    first_use = std::min(
+        first_use, FindFirstUseInConsumer(transfer, consumer, op_positions));
+  }
+  return first_use;
+}
+
+// Splits `result_indices`, which are results of `producer` of type `type`
+// transferred to `consumer`, into buckets of at most `bucket_size_bytes`. The
+// results are ordered by their first use in `consumer`, so that the first
+// bucket holds the results needed the earliest.
+std::vector<std::vector<int>> SplitIntoBuckets(
+    const std::vector<int>& result_indices, RankedTensorType type,
+    FragmentOp producer, FragmentOp consumer, int64_t bucket_size_bytes) {
+  DenseMap<Operation*, int> op_positions = GetOpPositions(consumer.getBody());
+  std::vector<std::pair<int, int>> first_use_and_result_index;
+  first_use_and_result_index.reserve(result_indices.size());
+  for (int result_index : result_indices) {
+    first_use_and_result_index.emplace_back(
+        FindFirstUseInConsumer(producer, result_index, consumer,
+                               op_positions),
+        result_index);
+  }
+  llvm::sort(first_use_and_result_index);
+
+  // All the results have the same type, so each bucket holds the same number
+  // of results.
+  const int64_t results_per_bucket =
+      std::max<int64_t>(1, bucket_size_bytes / GetSizeInBytes(type));
+  std::vector<std::vector<int>> buckets;
+  for (const std::pair<int, int>& first_use_and_index :
+       first_use_and_result_index) {
+    if (buckets.empty() ||
+        static_cast<int64_t>(buckets.back().size()) == results_per_bucket) {
+      buckets.emplace_back();
+    }
+    buckets.back().push_back(first_use_and_index.second);
+  }
+  return buckets;
+}
+
 // Given a `producer` fragment, concatenates sets of results that are smaller
 // than a given threshold and transferred to the same consumer fragment.
+//
+// If `bucket_size_bytes` is positive, each set of results is instead split into
+// buckets of at most that many bytes, which are concatenated separately.
 void MergeTransfersProducedByFragment(FragmentOp producer,
+                                      int64_t bucket_size_bytes,
                                       IRRewriter& rewriter) {
   llvm::MapVector<TypeAndConsumerFragment, std::vector<int>> values_to_concat =
-      FindValuesToConcat(producer);
+      FindValuesToConcat(producer, bucket_size_bytes);
+  std::vector<std::pair<TypeAndConsumerFragment, std::vector<int>>>
+      buckets_to_concat;
+  for (auto& [type_and_consumer_fragment, result_indices] : values_to_concat) {
+    if (bucket_size_bytes <= 0) {
+      buckets_to_concat.emplace_back(type_and_consumer_fragment,
+                                     std::move(result_indices));
+      continue;
+    }
+    auto [type, consumer_fragment] = type_and_consumer_fragment;
+    std::vector<std::vector<int>> buckets =
+        SplitIntoBuckets(result_indices, type, producer, consumer_fragment,
+                         bucket_size_bytes);
+    // Each transfer is created right after the producer, i.e., before the
+    // transfers created for previous buckets. Hence, we go through the buckets
+    // in reverse, so that the transfers are ordered by first use.
+    for (std::vector<int>& bucket : llvm::reverse(buckets)) {
+      buckets_to_concat.emplace_back(type_and_consumer_fragment,
+                                     std::move(bucket));
+    }
+  }
+
   FragmentOp current_producer = producer;
   for (const auto& [type_and_consumer_fragment, result_indices] :
-       values_to_concat) {
+       buckets_to_concat) {
     auto [type, consumer_fragment] = type_and_consumer_fragment;
     SDY_CHECK(!result_indices.empty());
     if (result_indices.size() == 1) {
@@ -411,6 +541,115 @@ void MergeTransfersProducedByFragment(FragmentOp producer,
   }
 }
 
+// Given a `producer` fragment, finds the transfers of its results that are
+// eligible for merging, grouped by their consumer fragment. Unlike
+// `FindValuesToConcat`, the transfers of a group can have different types, as
+// they aren't concatenated.
+llvm::MapVector<FragmentOp, SetVector<TransferOp>> FindTransfersToBatch(
+    FragmentOp producer, int64_t bucket_size_bytes) {
+  llvm::MapVector<FragmentOp, SetVector<TransferOp>> transfers_to_batch;
+  for (OpResult result : producer.getResults()) {
+    if (!IsEligibleForBatching(result, bucket_size_bytes)) {
+      continue;
+    }
+    for (TransferOp transfer : GetNonConcatTransferUsers(result)) {
+      for (FragmentOp consumer_fragment : FragmentUsers(transfer)) {
+        transfers_to_batch[consumer_fragment].insert(transfer);
+      }
+    }
+  }
+  return transfers_to_batch;
+}
+
+// Given a `producer` fragment, marks sets of transfers of its results to the
+// same consumer fragment as batches, i.e., with the same `kTransferBatchAttr`,
+// instead of concatenating their payloads. The transfers of each batch are
+// moved right after the producer, ordered by their first use in the consumer.
+//
+// If `bucket_size_bytes` is positive, each set of transfers is split into
+// batches of at most that many bytes.
+void BatchTransfersProducedByFragment(FragmentOp producer,
+                                      int64_t bucket_size_bytes,
+                                      int64_t& next_batch_id,
+                                      IRRewriter& rewriter) {
+  Operation* insertion_point = producer;
+  for (auto& [consumer_fragment, transfers] :
+       FindTransfersToBatch(producer, bucket_size_bytes)) {
+    DenseMap<Operation*, int> op_positions =
+        GetOpPositions(consumer_fragment.getBody());
+    std::vector<std::pair<int, TransferOp>> first_use_and_transfer;
+    first_use_and_transfer.reserve(transfers.size());
+    for (TransferOp transfer : transfers) {
+      // A transfer used by several consumers is only batched with the
+      // transfers to the first of them.
+      if (transfer->hasAttr(kTransferBatchAttr)) {
+        continue;
+      }
+      first_use_and_transfer.emplace_back(
+          FindFirstUseInConsumer(transfer, consumer_fragment, op_positions),
+          transfer);
+    }
+    llvm::stable_sort(first_use_and_transfer, [](const auto& a, const auto& b) {
+      return a.first < b.first;
+    });
+
+    // Split the transfers into batches of at most `bucket_size_bytes`.
+    std::vector<std::vector<TransferOp>> batches;
+    int64_t batch_size_bytes = 0;
+    for (const std::pair<int, TransferOp>& first_use_and_transfer_pair :
+         first_use_and_transfer) {
+      TransferOp transfer = first_use_and_transfer_pair.second;
+      int64_t size_bytes =
+          GetSizeInBytes(transfer.getType().getRankedTensorType());
+      if (batches.empty() ||
+          (bucket_size_bytes > 0 &&
+           batch_size_bytes + size_bytes > bucket_size_bytes)) {
+        batches.emplace_back();
+        batch_size_bytes = 0;
+      }
+      batches.back().push_back(transfer);
+      batch_size_bytes += size_bytes;
+    }
+
+    for (const std::vector<TransferOp>& batch : batches) {
+      if (batch.size() == 1) {
+        continue;
+      }
+      IntegerAttr batch_id = rewriter.getI64IntegerAttr(next_batch_id++);
+      for (TransferOp transfer : batch) {
+        transfer->setAttr(kTransferBatchAttr, batch_id);
+        rewriter.moveOpAfter(transfer, insertion_point);
+        insertion_point = transfer;
+      }
+    }
+  }
+}
+
+// Tracks the fragments that are created, or whose bodies are modified, by a
+// rewriter, so that they can be cleaned up without walking the whole function.
+class ModifiedFragmentTracker : public RewriterBase::Listener {
+ public:
+  void notifyOperationInserted(Operation* op,
+                               OpBuilder::InsertPoint previous) override {
+    if (auto fragment = dyn_cast<FragmentOp>(op)) {
+      modified_fragments_.insert(fragment);
+    } else if (auto fragment = op->getParentOfType<FragmentOp>()) {
+      modified_fragments_.insert(fragment);
+    }
+  }
+
+  void notifyOperationErased(Operation* op) override {
+    modified_fragments_.remove(op);
+  }
+
+  ArrayRef<Operation*> GetModifiedFragments() const {
+    return modified_fragments_.getArrayRef();
+  }
+
+ private:
+  SetVector<Operation*> modified_fragments_;
+};
+
 class MergeTransfersPass
     : public impl::MergeTransfersPassBase<MergeTransfersPass> {
   using MergeTransfersPassBase::MergeTransfersPassBase;
@@ -421,15 +660,32 @@ class MergeTransfersPass
       return;
     }
 
-    IRRewriter rewriter(func.getContext());
+    ModifiedFragmentTracker tracker;
+    IRRewriter rewriter(func.getContext(), &tracker);
     Block& block = func.getBody().front();
 
     // Copy all fragments to a vector so that replacing them with new fragments
     // (in order to introduce new results) doesn't affect the iteration order.
     SmallVector<FragmentOp> fragments(block.getOps<FragmentOp>().begin(),
                                       block.getOps<FragmentOp>().end());
+    int64_t next_batch_id = 0;
     for (FragmentOp producer : fragments) {
-      MergeTransfersProducedByFragment(producer, rewriter);
+      if (batchTransfers) {
+        BatchTransfersProducedByFragment(producer, bucketSizeBytes,
+                                         next_batch_id, rewriter);
+      } else {
+        MergeTransfersProducedByFragment(producer, bucketSizeBytes, rewriter);
+      }
+    }
+
+    if (cseModifiedFragments) {
+      // Merging transfers may duplicate the reshapes, concats and slices it
+      // adds to the producers and consumers, and nothing else.
+      IRRewriter cse_rewriter(func.getContext());
+      DominanceInfo dominance_info;
+      for (Operation* fragment : tracker.GetModifiedFragments()) {
+        eliminateCommonSubExpressions(cse_rewriter, dominance_info, fragment);
+      }
     }
   }
 };
@@ -0,0 +1,203 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <utility>
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
+#include "mlir/IR/Iterators.h"
+#include "mlir/IR/OpDefinition.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Types.h"
+#include "mlir/IR/Value.h"
+#include "mlir/IR/Visitors.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/WalkResult.h"
+#include "mlir/Transforms/RegionUtils.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/transforms/common/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/common/utils.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_MINIMIZEFRAGMENTSIGNATURESPASS
+#include "shardy/dialect/mpmd/transforms/common/passes.h.inc"
+
+namespace {
+
+// Replaces the uses of each result of `fragment` that duplicates an earlier
+// result, i.e., returns the same value with the same type, with that result,
+// and the uses of each result that returns a block argument with the
+// corresponding operand, if they have the same type. Returns the number of
+// results whose uses were replaced.
+//
+// This only redirects uses, so that the results become unused and are removed
+// when the fragment is rewritten.
+int ForwardDuplicateAndNoopResults(FragmentOp fragment,
+                                   RewriterBase& rewriter) {
+  int num_forwarded = 0;
+  Operation* terminator = fragment.getBody()->getTerminator();
+  DenseMap<std::pair<Value, Type>, OpResult> first_results;
+  for (auto [result, returned] :
+       llvm::zip_equal(fragment->getResults(), terminator->getOperands())) {
+    if (result.use_empty()) {
+      continue;
+    }
+    if (auto arg = dyn_cast<BlockArgument>(returned)) {
+      Value operand = fragment->getOperand(arg.getArgNumber());
+      if (operand.getType() == result.getType()) {
+        rewriter.replaceAllUsesWith(result, operand);
+        ++num_forwarded;
+        continue;
+      }
+    }
+    auto [it, inserted] =
+        first_results.try_emplace({returned, result.getType()}, result);
+    if (!inserted) {
+      rewriter.replaceAllUsesWith(result, it->second);
+      ++num_forwarded;
+    }
+  }
+  return num_forwarded;
+}
+
+// Returns whether `fragment` has no operands, no results and nothing in its
+// body but the terminator.
+bool IsEmptyFragment(FragmentOp fragment) {
+  return fragment->getNumResults() == 0 && fragment->getNumOperands() == 0 &&
+         llvm::hasSingleElement(fragment.getBody()->getOperations());
+}
+
+// Removes the unused results of `fragment`, and returns the fragment that
+// replaces it, or `fragment` itself if all its results are used. This is the
+// only step that creates a new fragment.
+FragmentOp RemoveUnusedResults(FragmentOp fragment, RewriterBase& rewriter) {
+  BitVector unused_results(fragment.getNumResults());
+  for (OpResult result : fragment->getResults()) {
+    if (result.use_empty()) {
+      unused_results.set(result.getResultNumber());
+    }
+  }
+  if (unused_results.none()) {
+    return fragment;
+  }
+
+  rewriter.setInsertionPoint(fragment);
+  fragment.getBody()->getTerminator()->eraseOperands(unused_results);
+  auto new_fragment = FragmentOp::create(
+      rewriter, fragment.getLoc(),
+      FilterRange<Type>(/*range=*/fragment.getResultTypes(),
+                        /*erase=*/unused_results),
+      fragment.getOperands(), fragment.getOriginAttr(),
+      fragment.getMeshNameAttr(), fragment.getStageIdAttr());
+  // Copy all attributes except `origin` and `mesh_name`, which were copied
+  // during the creation of the new fragment.
+  CopyAttributes(fragment, new_fragment,
+                 /*elided_attrs_set=*/{"origin", "mesh_name"});
+  new_fragment.getRegion().takeBody(fragment.getRegion());
+
+  BitVector& used_results = unused_results.flip();
+  for (auto [old_result_index, new_result] :
+       llvm::zip(used_results.set_bits(), new_fragment.getResults())) {
+    rewriter.replaceAllUsesWith(fragment->getResult(old_result_index),
+                                new_result);
+  }
+  rewriter.eraseOp(fragment);
+  return new_fragment;
+}
+
+// Replaces the uses of each block argument of `fragment` whose operand
+// duplicates an earlier operand with the block argument of the latter, and then
+// removes the operands whose block arguments are unused, in place.
+void RemoveDuplicateAndUnusedOperands(FragmentOp fragment,
+                                      RewriterBase& rewriter) {
+  Block& block = *fragment.getBody();
+  DenseMap<Value, BlockArgument> first_args;
+  BitVector unused_args(block.getNumArguments());
+  for (BlockArgument arg : block.getArguments()) {
+    auto [it, inserted] = first_args.try_emplace(
+        fragment->getOperand(arg.getArgNumber()), arg);
+    if (!inserted) {
+      rewriter.replaceAllUsesWith(arg, it->second);
+    }
+  }
+  for (BlockArgument arg : block.getArguments()) {
+    if (arg.use_empty()) {
+      unused_args.set(arg.getArgNumber());
+    }
+  }
+  if (unused_args.none()) {
+    return;
+  }
+  block.eraseArguments(unused_args);
+  fragment->setOperands(FilterRange<Value>(/*range=*/fragment.getOperands(),
+                                           /*erase=*/unused_args));
+}
+
+class MinimizeFragmentSignaturesPass
+    : public impl::MinimizeFragmentSignaturesPassBase<
+          MinimizeFragmentSignaturesPass> {
+  using MinimizeFragmentSignaturesPassBase::
+      MinimizeFragmentSignaturesPassBase;
+
+ protected:
+  void runOnFunc(func::FuncOp func_op) override {
+    IRRewriter rewriter(func_op.getContext());
+
+    // Forward sweep: producers are visited before their consumers, so by the
+    // time a consumer is visited, its operands are the values that its
+    // producers' duplicate and no-op results were forwarded to, and its
+    // duplicate operands are final.
+    func_op.walk<WalkOrder::PreOrder>([&](FragmentOp fragment) {
+      numForwardedResults += ForwardDuplicateAndNoopResults(fragment, rewriter);
+      // Fragments cannot nest other fragments.
+      return WalkResult::skip();
+    });
+
+    // Backward sweep: consumers are visited before their producers, so by the
+    // time a producer is visited, the liveness of its results is final, and
+    // each fragment is rewritten at most once.
+    func_op.walk<WalkOrder::PreOrder, ReverseIterator>([&](Operation* op) {
+      if (auto fragment = dyn_cast<FragmentOp>(op)) {
+        FragmentOp new_fragment = RemoveUnusedResults(fragment, rewriter);
+        if (new_fragment != fragment) {
+          ++numRewrittenFragments;
+        }
+        // Removing results and their return operands may leave dead code in
+        // the body, and thus unused block arguments.
+        (void)simplifyRegions(rewriter, new_fragment.getRegion());
+        RemoveDuplicateAndUnusedOperands(new_fragment, rewriter);
+        if (IsEmptyFragment(new_fragment)) {
+          rewriter.eraseOp(new_fragment);
+        }
+        return WalkResult::skip();
+      }
+      // Removing fragment operands may leave transfers unused.
+      if (isa<TransferOp>(op) && op->use_empty() && isPure(op)) {
+        rewriter.eraseOp(op);
+        return WalkResult::skip();
+      }
+      return WalkResult::advance();
+    });
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
@@ -13,12 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Operation.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/OperationSupport.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Types.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
@@ -34,31 +37,70 @@ namespace mlir::mpmd {
 
 namespace {
 
-// Walks the chain of device-only transfers leading to `transfer_op` to find an
-// operand with the same type. If so, this is a root of the cycle. Note that
-// this function finds the first such root.
+bool IsOnDevice(MeshTensorType type) {
+  // TODO: b/397933351 - This doesn't handle memory kind attributes. We likely
+  // don't want to use attributes for the memory kinds on transfers, but if we
+  // do, then we should handle them here.
+  return !type.getMemoryKind() ||
+         type.getMemoryKind().getValue() == kMemoryKindDevice;
+}
+
+// Removes transfer cycles and redundant transfer chains in a single pass over
+// the transfers of the function.
 //
-// Returns nullptr if no such root is found.
-Value FindDeviceOnlyTransferCycleClosestRoot(TransferOp transfer_op) {
-  TransferOp transfer_parent = transfer_op;
-  while (transfer_parent) {
-    auto parent_operand_type = transfer_parent.getTensor().getType();
-    // TODO: b/397933351 - This doesn't handle memory kind attributes. We likely
-    // don't want to use attributes for the memory kinds on transfers, but if we
-    // do, then we should handle them here.
-    if (parent_operand_type.getMemoryKind() &&
-        parent_operand_type.getMemoryKind().getValue() != kMemoryKindDevice) {
-      return nullptr;
+// The transfers of the function form a forest of chains of device-only
+// transfers, i.e., transfers whose operand lives on device. Each chain has a
+// root value, which isn't the result of such a transfer. Walking the function
+// in order, we keep track of the first value of each chain of each type, i.e.,
+// on each mesh and with each sharding. Any later transfer in the chain to a
+// type that was already seen is redundant, and it's replaced with the value
+// seen first, which dominates it. This removes cycles of any length, e.g.,
+// m0 -> m1 -> m2 -> m0, as well as chains that end up on a mesh to which the
+// root is transferred directly, e.g., m0 -> m1 -> m2 and m0 -> m2.
+class TransferChainSimplifier {
+ public:
+  explicit TransferChainSimplifier(IRRewriter& rewriter)
+      : rewriter_(rewriter) {}
+
+  void Simplify(func::FuncOp func_op) {
+    for (Operation& op :
+         llvm::make_early_inc_range(func_op.front().getOperations())) {
+      if (auto transfer_op = dyn_cast<TransferOp>(&op)) {
+        SimplifyTransfer(transfer_op);
+      }
+    }
+  }
+
+ private:
+  void SimplifyTransfer(TransferOp transfer_op) {
+    Value operand = transfer_op.getTensor();
+    if (!IsOnDevice(transfer_op.getTensor().getType())) {
+      // A `host -> device` transfer could be for memory purposes, so its
+      // result is the root of a new chain.
+      return;
+    }
+    Value root = chain_roots_.lookup(operand);
+    if (!root) {
+      root = operand;
     }
-    if (parent_operand_type == transfer_op.getType()) {
-      return transfer_parent.getTensor();
+    DenseMap<Type, Value>& chain_values = chain_values_[root];
+    chain_values.try_emplace(root.getType(), root);
+    auto [it, inserted] = chain_values.try_emplace(transfer_op.getType(),
+                                                   transfer_op.getResult());
+    if (inserted) {
+      chain_roots_[transfer_op.getResult()] = root;
+      return;
     }
-    transfer_parent = dyn_cast_if_present<TransferOp>(
-        transfer_parent.getTensor().getDefiningOp());
+    rewriter_.replaceAllUsesWith(transfer_op, it->second);
+    rewriter_.eraseOp(transfer_op);
   }
 
-  return nullptr;
-}
+  IRRewriter& rewriter_;
+  // The root of the chain of each transfer result in a chain.
+  DenseMap<Value, Value> chain_roots_;
+  // The first value of each type in the chain of each root.
+  DenseMap<Value, DenseMap<Type, Value>> chain_values_;
+};
 
 class RemoveTransferCyclesPass
     : public impl::RemoveTransferCyclesPassBase<RemoveTransferCyclesPass> {
@@ -67,19 +109,7 @@ class RemoveTransferCyclesPass
  protected:
   void runOnFunc(func::FuncOp func_op) override {
     IRRewriter rewriter(&getContext());
-    // Walk the func in reverse, so that we can delete user
-    // ops without having to worry about invalidating iterators.
-    for (Operation& op : llvm::make_early_inc_range(
-             llvm::reverse(func_op.front().getOperations()))) {
-      if (auto transfer_op = dyn_cast<TransferOp>(&op)) {
-        // Note that because we walk in reverse, it suffices to keep replacing
-        // the closest root we find.
-        if (Value root = FindDeviceOnlyTransferCycleClosestRoot(transfer_op)) {
-          rewriter.replaceAllUsesWith(transfer_op, root);
-          rewriter.eraseOp(transfer_op);
-        }
-      }
-    }
+    TransferChainSimplifier(rewriter).Simplify(func_op);
   }
 };
 
@@ -16,6 +16,9 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include "mlir/Analysis/TopologicalSortUtils.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -46,6 +49,77 @@ namespace {
 using FragmentMergeRuleMap =
     DenseMap<FragmentInfo, const FragmentMergeRule*, FragmentInfoMapInfo>;
 
+// Indexes the fragments of a function by the merge rule they match and their
+// mesh, so that the merge candidates of a fragment are found without walking
+// the function, and fragments aren't matched against the rules more than once.
+//
+// It listens to the rewriter to drop fragments from the index when they are
+// erased, e.g., by being merged or by the greedy driver, as dead code.
+class MergeCandidateIndex : public RewriterBase::Listener {
+ public:
+  MergeCandidateIndex(const FragmentMergeRuleMap& fragment_merge_rule_map,
+                      FragmentInfoCache& info_cache)
+      : fragment_merge_rule_map_(fragment_merge_rule_map),
+        info_cache_(info_cache) {}
+
+  // Adds `fragment` to the index if it matches a merge rule, replacing any
+  // previous entry, e.g., when a merge reused `fragment` in place.
+  void Insert(FragmentOp fragment) {
+    Erase(fragment);
+    int id = info_cache_.GetId(fragment);
+    auto it = fragment_merge_rule_map_.find(info_cache_.GetInfo(id));
+    if (it == fragment_merge_rule_map_.end()) {
+      return;
+    }
+    Key key = {it->second, info_cache_.GetMeshName(id)};
+    fragment_to_key_[fragment] = key;
+    key_to_fragments_[key].insert(fragment);
+  }
+
+  // Returns the merge rule that `fragment` matches, or nullptr if none.
+  const FragmentMergeRule* GetRule(FragmentOp fragment) const {
+    auto it = fragment_to_key_.find(fragment);
+    return it == fragment_to_key_.end() ? nullptr : it->second.first;
+  }
+
+  // Returns the other fragments that match the same rule as `fragment` and are
+  // on the same mesh, in program order.
+  std::vector<FragmentOp> GetMergeCandidates(FragmentOp fragment) const {
+    const SetVector<Operation*>& fragments =
+        key_to_fragments_.at(fragment_to_key_.at(fragment));
+    std::vector<FragmentOp> merge_candidates;
+    merge_candidates.reserve(fragments.size() - 1);
+    for (Operation* other : fragments) {
+      if (other != fragment) {
+        merge_candidates.push_back(cast<FragmentOp>(other));
+      }
+    }
+    llvm::sort(merge_candidates, [](FragmentOp a, FragmentOp b) {
+      return a->isBeforeInBlock(b);
+    });
+    return merge_candidates;
+  }
+
+  void notifyOperationErased(Operation* op) override { Erase(op); }
+
+ private:
+  using Key = std::pair<const FragmentMergeRule*, StringRef>;
+
+  void Erase(Operation* op) {
+    auto it = fragment_to_key_.find(op);
+    if (it == fragment_to_key_.end()) {
+      return;
+    }
+    key_to_fragments_[it->second].remove(op);
+    fragment_to_key_.erase(it);
+  }
+
+  const FragmentMergeRuleMap& fragment_merge_rule_map_;
+  FragmentInfoCache& info_cache_;
+  DenseMap<Operation*, Key> fragment_to_key_;
+  DenseMap<Key, SetVector<Operation*>> key_to_fragments_;
+};
+
 // TODO(petebu): Consider doing a forward walk through the function while
 // merging matching fragments instead of using a GreedyPatternRewriter.
 class RuleBasedMergingPattern : public OpRewritePattern<FragmentOp> {
@@ -53,24 +127,24 @@ class RuleBasedMergingPattern : public OpRewritePattern<FragmentOp> {
 
  public:
   RuleBasedMergingPattern(MLIRContext* context,
-                          const FragmentMergeRules& merging_rules,
-                          const FragmentMergeRuleMap& fragment_merge_rule_map)
+                          MergeCandidateIndex& candidate_index,
+                          FragmentInfoCache& info_cache)
       : OpRewritePattern<FragmentOp>(context),
-        fragment_merge_rule_map_(fragment_merge_rule_map) {}
+        candidate_index_(candidate_index),
+        info_cache_(info_cache) {}
 
   LogicalResult matchAndRewrite(FragmentOp merge_into_fragment,
                                 PatternRewriter& rewriter) const override {
-    FragmentInfo fragment_info = GetFragmentInfo(merge_into_fragment);
     // Find the merge rule for the fragment, if there is one.
-    auto it = fragment_merge_rule_map_.find(fragment_info);
-    if (it == fragment_merge_rule_map_.end()) {
+    const FragmentMergeRule* rule =
+        candidate_index_.GetRule(merge_into_fragment);
+    if (!rule) {
       return failure();
     }
-    const FragmentMergeRule* rule = it->second;
 
     // Get all the merge candidates for the merge rule.
     std::vector<FragmentOp> merge_candidates =
-        GetMergeCandidates(merge_into_fragment, rule);
+        candidate_index_.GetMergeCandidates(merge_into_fragment);
     if (merge_candidates.empty()) {
       return failure();
     }
@@ -88,6 +162,12 @@ class RuleBasedMergingPattern : public OpRewritePattern<FragmentOp> {
     }
 
     // Merge the fragments.
+    // The merged fragments are erased, so drop them from the cache before any
+    // new fragment can take their place. The candidate index is updated by
+    // the rewriter as they are erased.
+    for (FragmentOp merge_candidate : merge_candidates) {
+      info_cache_.Erase(merge_candidate);
+    }
     Operation* new_fragment_dest = sorted_merge_candidates[0]->getNextNode();
     FragmentOp new_fragment = dyn_cast<FragmentOp>(*sorted_merge_candidates[0]);
     for (int i = 1; i < sorted_merge_candidates.size(); ++i) {
@@ -99,6 +179,9 @@ class RuleBasedMergingPattern : public OpRewritePattern<FragmentOp> {
       new_fragment = MergeFragments(new_fragment, merge_candidate, rewriter);
     }
     SetFragmentInfo(new_fragment, rule->target, rewriter);
+    info_cache_.Update(new_fragment);
+    // The target of the rule may be a source of another rule.
+    candidate_index_.Insert(new_fragment);
     // TODO(petebu): Consider making the position of the new fragment a
     // parameter of the rule.
     SDY_CHECK(new_fragment_dest != nullptr);
@@ -107,33 +190,8 @@ class RuleBasedMergingPattern : public OpRewritePattern<FragmentOp> {
   }
 
  private:
-  std::vector<FragmentOp> GetMergeCandidates(
-      FragmentOp merge_into_fragment, const FragmentMergeRule* rule) const {
-    Block& parent_body =
-        merge_into_fragment->getParentOfType<func::FuncOp>().getBody().front();
-
-    std::vector<FragmentOp> merge_candidates;
-    for (auto fragment : parent_body.getOps<FragmentOp>()) {
-      if (fragment == merge_into_fragment) {
-        continue;
-      }
-
-      // Merge candidates must be on the same mesh.
-      if (fragment.getMeshName() != merge_into_fragment.getMeshName()) {
-        continue;
-      }
-
-      FragmentInfo fragment_info = GetFragmentInfo(fragment);
-      auto it = fragment_merge_rule_map_.find(fragment_info);
-      if (it != fragment_merge_rule_map_.end() && it->second == rule) {
-        merge_candidates.push_back(fragment);
-      }
-    }
-
-    return merge_candidates;
-  }
-
-  const FragmentMergeRuleMap& fragment_merge_rule_map_;
+  MergeCandidateIndex& candidate_index_;
+  FragmentInfoCache& info_cache_;
 };
 
 class RuleBasedMergePass
@@ -142,7 +200,6 @@ class RuleBasedMergePass
 
  private:
   FragmentMergeRuleMap fragment_merge_rule_map_;
-  FrozenRewritePatternSet patterns;
 
  protected:
   void runOnFunc(func::FuncOp func) override {
@@ -150,7 +207,23 @@ class RuleBasedMergePass
       return;
     }
 
+    // The patterns hold the per-function info cache, so they are created for
+    // each function rather than once in `initialize`.
+    //
+    // The cache isn't preserved, as the greedy driver may erase fragments
+    // without going through the patterns.
+    FragmentInfoCache& info_cache = getAnalysis<FragmentInfoCache>();
+    MergeCandidateIndex candidate_index(fragment_merge_rule_map_, info_cache);
+    for (FragmentOp fragment : func.getOps<FragmentOp>()) {
+      candidate_index.Insert(fragment);
+    }
+    RewritePatternSet patterns_internal(func.getContext());
+    patterns_internal.add<RuleBasedMergingPattern>(
+        func.getContext(), candidate_index, info_cache);
+    FrozenRewritePatternSet patterns(std::move(patterns_internal));
+
     GreedyRewriteConfig config;
+    config.setListener(&candidate_index);
     config.setRegionSimplificationLevel(GreedySimplifyRegionLevel::Disabled);
     config.enableFolding(false);
     config.enableConstantCSE(false);
@@ -181,10 +254,6 @@ class RuleBasedMergePass
         fragment_merge_rule_map_[fragment] = &rule;
       }
     }
-    RewritePatternSet patternsInternal(context);
-    patternsInternal.add<RuleBasedMergingPattern>(context, rules,
-                                                  fragment_merge_rule_map_);
-    patterns = std::move(patternsInternal);
     return success();
   }
 };
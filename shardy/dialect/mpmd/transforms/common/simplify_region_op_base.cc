@@ -160,8 +160,10 @@ void RemoveUnusedResultsFromRegionOp(Operation* region_op,
 
 }  // namespace
 
-LogicalResult SimplifyRegionOp(Operation* op, PatternRewriter& rewriter,
-                               SimplifiedRegionOpCreateFn create_op) {
+LogicalResult SimplifyRegionOp(
+    Operation* op, PatternRewriter& rewriter,
+    SimplifiedRegionOpCreateFn create_op,
+    SimplifiedRegionOpEraseOperandsFn erase_operands_fn) {
   SDY_CHECK_EQ(op->getNumRegions(), 1);
   Region& region = op->getRegion(0);
   Block& block = region.front();
@@ -203,16 +205,39 @@ LogicalResult SimplifyRegionOp(Operation* op, PatternRewriter& rewriter,
 
   // NOTE: we need to erase return operands before we erase block arguments
   // because the former might be a use of the latter.
-  return_op->eraseOperands(erase_results);
-  if (has_operands) {
-    block.eraseArguments(erase_operands);
+  if (erase_results.any()) {
+    return_op->eraseOperands(erase_results);
+  }
+  if (erase_operands.any()) {
+    // The producers of the erased operands may now have unused results, so we
+    // notify the rewriter that they changed, to add them to the worklist, as
+    // erasing `op` would.
+    SmallVector<Operation*> producers;
+    for (unsigned operand_num : erase_operands.set_bits()) {
+      if (Operation* producer = op->getOperand(operand_num).getDefiningOp()) {
+        producers.push_back(producer);
+      }
+    }
+    rewriter.modifyOpInPlace(op, [&] {
+      block.eraseArguments(erase_operands);
+      erase_operands_fn(erase_operands);
+    });
+    for (Operation* producer : producers) {
+      rewriter.modifyOpInPlace(producer, [] {});
+    }
+  }
+
+  if (erase_results.none()) {
+    // Simplify the region to make sure we remove any dead code.
+    (void)simplifyRegions(rewriter, region);
+    return success();
   }
 
-  SmallVector<Value> new_operands =
-      FilterRange<Value>(op->getOperands(), erase_operands);
+  // Results can't be erased in place, so we need a new op.
   SmallVector<Type> new_result_types =
       FilterRange<Type>(op->getResultTypes(), erase_results);
-  Operation* new_op = create_op(new_result_types, new_operands, erase_results);
+  Operation* new_op =
+      create_op(new_result_types, op->getOperands(), erase_results);
   SDY_CHECK_EQ(new_op->getNumRegions(), 1);
   Region& new_region = new_op->getRegion(0);
   new_region.takeBody(region);
@@ -30,6 +30,11 @@ namespace mlir::mpmd {
 using SimplifiedRegionOpCreateFn = std::function<Operation*(
     TypeRange result_types, ValueRange operands, BitVector erased_results)>;
 
+// Erases the operands of a region op marked in `erased_operands`, in place.
+// The block arguments are erased by the caller.
+using SimplifiedRegionOpEraseOperandsFn =
+    std::function<void(const BitVector& erased_operands)>;
+
 // Simplifies the given `op`. In particular, it:
 //  - deduplicates results, and their corresponding return values;
 //  - deduplicates operands, and their corresponding block arguments, if the op
@@ -40,11 +45,18 @@ using SimplifiedRegionOpCreateFn = std::function<Operation*(
 //    didn't have any to begin with); and
 //  - removes results that are unused.
 //
+// Operands and block arguments are always erased in place, with
+// `erase_operands_fn`. Since the results of an op can't be erased in place, the
+// op is only re-created, with `create_op`, if any of its results is erased, and
+// thus the region is only moved and its users only updated in that case.
+//
 // NOTE: This method assumes that the op has the same number of results and
 // return values, and if the op has any operands we also assume that it has the
 // same number of operands and block arguments.
-LogicalResult SimplifyRegionOp(Operation* op, PatternRewriter& rewriter,
-                               SimplifiedRegionOpCreateFn create_op);
+LogicalResult SimplifyRegionOp(
+    Operation* op, PatternRewriter& rewriter,
+    SimplifiedRegionOpCreateFn create_op,
+    SimplifiedRegionOpEraseOperandsFn erase_operands_fn);
 
 // A base class for patterns that simplify a given op. See SimplifyRegionOp for
 // more information.
@@ -61,6 +73,9 @@ class SimplifyRegionOpPatternBase : public OpRewritePattern<OpTy> {
                   BitVector erased_results) -> Operation* {
           return createNewOp(op, rewriter, result_types, operands,
                              erased_results);
+        },
+        [&, this](const BitVector& erased_operands) {
+          eraseOperands(op, erased_operands);
         });
   }
 
@@ -68,6 +83,12 @@ class SimplifyRegionOpPatternBase : public OpRewritePattern<OpTy> {
   virtual OpTy createNewOp(OpTy op, PatternRewriter& rewriter,
                            TypeRange result_types, ValueRange operands,
                            BitVector erased_results) const = 0;
+
+  // Erases the operands of `op` marked in `erased_operands`. Ops with
+  // attributes that are per operand should override this to update them.
+  virtual void eraseOperands(OpTy op, const BitVector& erased_operands) const {
+    op->eraseOperands(erased_operands);
+  }
 };
 
 }  // namespace mlir::mpmd
@@ -13,13 +13,18 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
 #include <functional>
 #include <iterator>
 #include <utility>
 #include <vector>
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/IRMapping.h"
@@ -77,41 +82,113 @@ SetVector<Value> GetEffectiveOperands(Operation* op) {
   return operands;
 }
 
-// Collects all operations that have results that have a dataflow to one of the
-// values in the `values` list.
-// NB: `values` are purposefully passed by-value as this function mutates them.
-DenseSet<Operation*> CollectOpsFlowingTo(std::vector<Value> values) {
-  DenseSet<Operation*> ops;
-  while (!values.empty()) {
-    Value value = values.back();
-    values.pop_back();
+// Indexes the ops of a fragment body by their position in the body, so that
+// the dataflow to or from a set of values can be computed as a bit vector over
+// the ops, with a single pass over the body. This relies on the ops of a block
+// being topologically sorted, and on any value used in the body being either a
+// block argument or a result of an op of the body, as fragments are isolated
+// from above.
+class FragmentBodyIndex {
+ public:
+  explicit FragmentBodyIndex(FragmentOp fragment) {
+    Block* body = fragment.getBody();
+    ops_.reserve(body->getOperations().size());
+    effective_operands_.reserve(body->getOperations().size());
+    for (Operation& op : body->getOperations()) {
+      op_to_index_[&op] = ops_.size();
+      ops_.push_back(&op);
+      effective_operands_.push_back(GetEffectiveOperands(&op));
+    }
+  }
+
+  // The number of ops in the body, including the terminator.
+  int size() const { return ops_.size(); }
+
+  Operation* GetOp(int index) const { return ops_[index]; }
+
+  const SetVector<Value>& GetEffectiveOperandsOf(int index) const {
+    return effective_operands_[index];
+  }
 
+  // Returns the position of the op that defines `value`, or -1 if `value` is a
+  // block argument.
+  int GetDefiningOpIndex(Value value) const {
     Operation* op = value.getDefiningOp();
-    if (!op || ops.contains(op)) continue;
+    return op ? op_to_index_.lookup(op) : -1;
+  }
 
-    ops.insert(op);
-    for (Value operand : GetEffectiveOperands(op)) {
-      values.push_back(operand);
+  // Returns the ops that have a dataflow from the block arguments set in
+  // `arg_mask`, including the terminator.
+  BitVector OpsFlowingFrom(const BitVector& arg_mask) const {
+    BitVector flowing_ops(size());
+    for (int index = 0; index < size(); ++index) {
+      flowing_ops[index] =
+          llvm::any_of(effective_operands_[index], [&](Value operand) {
+            return FlowsFrom(operand, arg_mask, flowing_ops);
+          });
     }
+    return flowing_ops;
   }
-  return ops;
-}
+
+  // Returns whether `value` is a block argument set in `arg_mask` or the
+  // result of an op set in `flowing_ops`.
+  bool FlowsFrom(Value value, const BitVector& arg_mask,
+                 const BitVector& flowing_ops) const {
+    if (auto arg = dyn_cast<BlockArgument>(value)) {
+      return arg_mask[arg.getArgNumber()];
+    }
+    return flowing_ops[GetDefiningOpIndex(value)];
+  }
+
+  // Returns the ops that have results that have a dataflow to one of
+  // `values`.
+  BitVector OpsFlowingTo(ArrayRef<Value> values) const {
+    BitVector flowing_ops(size());
+    for (Value value : values) {
+      if (int index = GetDefiningOpIndex(value); index >= 0) {
+        flowing_ops.set(index);
+      }
+    }
+    for (int index = size() - 1; index >= 0; --index) {
+      if (!flowing_ops[index]) continue;
+      for (Value operand : effective_operands_[index]) {
+        if (int operand_index = GetDefiningOpIndex(operand);
+            operand_index >= 0) {
+          flowing_ops.set(operand_index);
+        }
+      }
+    }
+    return flowing_ops;
+  }
+
+ private:
+  std::vector<Operation*> ops_;
+  DenseMap<Operation*, int> op_to_index_;
+  std::vector<SetVector<Value>> effective_operands_;
+};
 
 // Collect the values that represent root values of computations that (i)
 // flow to the values in the `values` and are either block arguments or produced
 // by the `boundary_ops`.
-SetVector<Value> CollectRootsForValues(
-    std::vector<Value> values, const DenseSet<Operation*>& boundary_ops) {
+//
+// Each op is visited at most once, which doesn't change the order of the roots,
+// as the traversal is depth-first: all roots of an op are found by the time it
+// is reached again.
+SetVector<Value> CollectRootsForValues(std::vector<Value> values,
+                                       const FragmentBodyIndex& index,
+                                       const BitVector& boundary_ops) {
   SetVector<Value> roots;
+  BitVector visited(index.size());
   while (!values.empty()) {
     Value value = values.back();
     values.pop_back();
 
-    Operation* op = value.getDefiningOp();
-    if (!op || boundary_ops.contains(op)) {
+    int op_index = index.GetDefiningOpIndex(value);
+    if (op_index < 0 || boundary_ops[op_index]) {
       roots.insert(value);
-    } else {
-      for (Value operand : GetEffectiveOperands(op)) {
+    } else if (!visited[op_index]) {
+      visited.set(op_index);
+      for (Value operand : index.GetEffectiveOperandsOf(op_index)) {
         values.push_back(operand);
       }
     }
@@ -149,27 +226,17 @@ std::vector<Value> FilterByMask(ValueRange values, const BitVector& mask) {
   return results;
 }
 
-// Maps a set of operations through an IRMapping.
-DenseSet<Operation*> MapOpSet(const DenseSet<Operation*> ops,
-                              const IRMapping& mapping) {
-  DenseSet<Operation*> mapped_ops;
-  for (Operation* op : ops) {
-    mapped_ops.insert(mapping.lookup(op));
-  }
-  return mapped_ops;
-}
-
-// Traverses the region in reverse order, applies the mapping for each op, and
-// erases any (mapped) op that is not a terminator and for which `should_erase`
-// returns true. As such ops are not erased from the region, but rather the
-// image of the region through the mapping.
-void EraseOpsThroughIRMapping(Region& region, IRMapping& mapping,
-                              IRRewriter& rewriter,
-                              std::function<bool(Operation*)> should_erase) {
-  for (Operation& op : llvm::reverse(region.front().getOperations())) {
-    Operation* mapped_op = mapping.lookup(&op);
+// Traverses the ops of the region in reverse order, applies the mapping for
+// each op, and erases any (mapped) op that is not a terminator and for which
+// `should_erase` returns true given its position. As such ops are not erased
+// from the region, but rather the image of the region through the mapping.
+void EraseOpsThroughIRMapping(const FragmentBodyIndex& index,
+                              IRMapping& mapping, IRRewriter& rewriter,
+                              std::function<bool(int)> should_erase) {
+  for (int op_index = index.size() - 1; op_index >= 0; --op_index) {
+    Operation* mapped_op = mapping.lookup(index.GetOp(op_index));
     if (!mapped_op->hasTrait<OpTrait::IsTerminator>() &&
-        should_erase(mapped_op)) {
+        should_erase(op_index)) {
       rewriter.eraseOp(mapped_op);
     }
   }
@@ -201,9 +268,12 @@ void EraseOpsThroughIRMapping(Region& region, IRMapping& mapping,
 //     ...
 //     return %ps
 //  }
+//
+// `non_pullable_ops` is indexed by the position of the ops in `index`.
 void PullResultsOutOf(IRRewriter& rewriter, FragmentOp fragment,
                       ArrayRef<Value> pullable_results,
-                      const DenseSet<Operation*>& non_pullable_ops,
+                      const FragmentBodyIndex& index,
+                      const BitVector& non_pullable_ops,
                       const BitVector& pullable_mask) {
   MLIRContext* context = rewriter.getContext();
 
@@ -221,13 +291,13 @@ void PullResultsOutOf(IRRewriter& rewriter, FragmentOp fragment,
 
   // If the non pullable ops and the terminator are all the ops of the fragment
   // then there is simply nothing to pull.
-  if (non_pullable_ops.size() + 1 ==
+  if (non_pullable_ops.count() + 1 ==
       fragment->getBlock()->getOperations().size()) {
     return;
   }
   // We calculate the residuals as the root values flowing to the pullables.
   SetVector<Value> residuals = CollectRootsForValues(
-      /*values=*/std::move(pullable_results),
+      /*values=*/std::move(pullable_results), index,
       /*boundary_ops=*/non_pullable_ops);
 
   // 1. Create the fragment with only transferred and residual results.
@@ -274,9 +344,8 @@ void PullResultsOutOf(IRRewriter& rewriter, FragmentOp fragment,
     terminator->setOperands(ret_values);
 
     // Erase the ops that are not in non_pullable_ops through the mapping.
-    DenseSet<Operation*> keep_ops = MapOpSet(non_pullable_ops, mapping);
-    EraseOpsThroughIRMapping(region, mapping, rewriter, [&](Operation* op) {
-      return !keep_ops.contains(op);
+    EraseOpsThroughIRMapping(index, mapping, rewriter, [&](int op_index) {
+      return !non_pullable_ops[op_index];
     });
   }
 
@@ -331,9 +400,8 @@ void PullResultsOutOf(IRRewriter& rewriter, FragmentOp fragment,
     terminator->setOperands(ret_values);
 
     // Erase any ops contained in the non_pullable_ops through the mapping.
-    DenseSet<Operation*> keep_ops = MapOpSet(non_pullable_ops, mapping);
-    EraseOpsThroughIRMapping(region, mapping, rewriter, [&](Operation* op) {
-      return keep_ops.contains(op);
+    EraseOpsThroughIRMapping(index, mapping, rewriter, [&](int op_index) {
+      return non_pullable_ops[op_index];
     });
   }
 
@@ -360,98 +428,35 @@ void PullResultsMaximally(IRRewriter& rewriter, FragmentOp fragment,
   const auto [pullable, non_pullable] = SplitValuesByMask(
       fragment.getBody()->getTerminator()->getOperands(), result_pullable_mask);
 
-  PullResultsOutOf(rewriter, fragment, std::move(pullable),
-                   CollectOpsFlowingTo(std::move(non_pullable)),
-                   result_pullable_mask);
-}
-
-// Finds the results that are returned from the fragment, and marks them in the
-// `result_mask`. Skips values that are already seen.
-void FindAndMarkResults(Value val, DenseSet<Operation*>& seen,
-                        BitVector& result_mask) {
-  for (OpOperand& use : val.getUses()) {
-    if (auto return_op = dyn_cast<ReturnOp>(use.getOwner())) {
-      result_mask.set(use.getOperandNumber());
-      continue;
-    }
-
-    if (seen.contains(use.getOwner())) {
-      continue;
-    }
-    // Only add to `seen` if there are multiple operands,
-    // otherwise this will never be visited again.
-    if (use.getOwner()->getNumOperands() > 1) {
-      seen.insert(use.getOwner());
-    }
-
-    for (auto result : use.getOwner()->getResults()) {
-      FindAndMarkResults(result, seen, result_mask);
-    }
-  }
-}
-
-BitVector FindResultsFlowingFrom(ValueRange values, int num_results) {
-  BitVector result_mask(num_results);
-  DenseSet<Operation*> seen;
-  // An early guess to the number of ops seen.
-  seen.reserve(num_results);
-  for (Value val : values) {
-    FindAndMarkResults(val, seen, result_mask);
-  }
-
-  return result_mask;
-}
-
-DenseSet<Operation*> TransitiveUsersOf(std::vector<Value> values) {
-  DenseSet<Operation*> transitive_users;
-  while (!values.empty()) {
-    Value value = values.back();
-    values.pop_back();
-
-    for (Operation* op : value.getUsers()) {
-      if (transitive_users.contains(op)) {
-        continue;
-      }
-      transitive_users.insert(op);
-      for (Value res : op->getResults()) {
-        values.push_back(res);
-      }
-    }
-  }
-  return transitive_users;
-}
-
-DenseSet<Operation*> OpsNotRelyingOn(std::vector<Value> values,
-                                     FragmentOp fragment) {
-  DenseSet<Operation*> ops_to_avoid = TransitiveUsersOf(std::move(values));
-  DenseSet<Operation*> ops;
-
-  for (Operation& op : fragment.getBody()->getOperations()) {
-    if (ops_to_avoid.contains(&op)) {
-      continue;
-    }
-    ops.insert(&op);
-  }
-
-  return ops;
+  FragmentBodyIndex index(fragment);
+  BitVector non_pullable_ops = index.OpsFlowingTo(non_pullable);
+  PullResultsOutOf(rewriter, fragment, std::move(pullable), index,
+                   non_pullable_ops, result_pullable_mask);
 }
 
 // Splits the fragment into two fragments, with as much computation as possible
 // pulled out of the original fragment into the first.
 void PullOperandsOutMaximally(IRRewriter& rewriter, FragmentOp fragment,
                               BitVector arg_pullable_mask) {
-  std::vector<Value> args_to_pull =
-      FilterByMask(fragment.getBody()->getArguments(), arg_pullable_mask);
-  BitVector result_pullable_mask =
-      FindResultsFlowingFrom(args_to_pull, fragment.getNumResults());
-
-  std::vector<Value> pullable = FilterByMask(
-      fragment.getBody()->getTerminator()->getOperands(), result_pullable_mask);
+  FragmentBodyIndex index(fragment);
+  BitVector ops_relying_on_args = index.OpsFlowingFrom(arg_pullable_mask);
+
+  // The results that flow from the args.
+  ValueRange returned_values =
+      fragment.getBody()->getTerminator()->getOperands();
+  BitVector result_pullable_mask(returned_values.size());
+  for (auto [result_index, value] : llvm::enumerate(returned_values)) {
+    result_pullable_mask[result_index] =
+        index.FlowsFrom(value, arg_pullable_mask, ops_relying_on_args);
+  }
+  std::vector<Value> pullable =
+      FilterByMask(returned_values, result_pullable_mask);
 
-  DenseSet<Operation*> non_pullable_ops =
-      OpsNotRelyingOn(std::move(args_to_pull), fragment);
+  // The ops that don't rely on the args, excluding the terminator.
+  BitVector non_pullable_ops = ~ops_relying_on_args;
+  non_pullable_ops.reset(index.size() - 1);
 
-  if (non_pullable_ops.empty() && result_pullable_mask.all()) {
+  if (non_pullable_ops.none() && result_pullable_mask.all()) {
     // Everything will be pulled out, so we don't need to split.
     return;
   }
@@ -459,7 +464,7 @@ void PullOperandsOutMaximally(IRRewriter& rewriter, FragmentOp fragment,
   // We achieve the effect of pulling out the operands by pulling out the
   // results that flow from the args, and maximally setting out the non-pullable
   // ops.
-  PullResultsOutOf(rewriter, fragment, pullable, non_pullable_ops,
+  PullResultsOutOf(rewriter, fragment, pullable, index, non_pullable_ops,
                    result_pullable_mask);
 }
 
@@ -482,11 +487,18 @@ class SplitBwdFragmentsPass
   }
 };
 
-// Finds the operands that are transfer results.
-BitVector FindTransferredArgs(FragmentOp fragment) {
+// Finds the operands that are transfer results of at least `min_transfer_bytes`
+// bytes on each device. Smaller transfers are expected to take less time than
+// it'd take to execute the split-out computation, so they aren't worth
+// splitting the fragment for.
+BitVector FindTransferredArgs(FragmentOp fragment,
+                              int64_t min_transfer_bytes) {
   BitVector mask(fragment->getNumOperands());
   for (OpOperand& operand : fragment->getOpOperands()) {
-    if (isa_and_present<TransferOp>(operand.get().getDefiningOp())) {
+    if (auto transfer = operand.get().getDefiningOp<TransferOp>();
+        transfer && (min_transfer_bytes <= 0 ||
+                     GetLocalSizeInBytes(transfer.getType(), transfer) >=
+                         min_transfer_bytes)) {
       mask.set(operand.getOperandNumber());
     }
   }
@@ -514,7 +526,8 @@ class SplitAndPrioritizeTransferIndependentComputationsPass
       if (IsSplitTransferIndependentCandidate(fragment)) {
         // The pullable values are those that are users of transfer
         // operands.
-        BitVector operand_mask = FindTransferredArgs(fragment);
+        BitVector operand_mask =
+            FindTransferredArgs(fragment, minTransferBytes);
         if (!operand_mask.all() && operand_mask.any()) {
           PullOperandsOutMaximally(rewriter, fragment, operand_mask);
         }
@@ -0,0 +1,32 @@
+// RUN: mpmd_opt %s -mpmd-compact-locations='max-fused-locations=2 max-location-depth=3' -mlir-print-debuginfo -mlir-print-local-scope -split-input-file 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-compact-locations='strip-debug-info=true' -mlir-print-debuginfo -mlir-print-local-scope -split-input-file 2>&1 | FileCheck %s --check-prefix=STRIP
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @compact_locations
+// STRIP-LABEL: func @compact_locations
+func.func @compact_locations(%arg0: !mesh_1_tensor {sdy.sharding_origins = {x = "self"}} loc("a0"))
+  -> !mesh_1_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f1", "f2"]>
+  // CHECK-SAME:   (%{{.*}}: tensor<4x8xf32> loc("b0"))
+  // CHECK-NEXT:   stablehlo.add {{.*}} loc(callsite("c0" at "c1"))
+  // CHECK-NEXT:   stablehlo.multiply {{.*}} loc(callsite("c0" at "c1"))
+  // CHECK-NEXT:   mpmd.return
+  // CHECK-NEXT: } : (!mesh_1_tensor) -> !mesh_1_tensor loc(fused["l0", "l1"])
+
+  // STRIP:      %arg0: !mesh_1_tensor loc(unknown)
+  // STRIP-NOT:  sharding_origins
+  // STRIP:      mpmd.fragment<mesh="m1", origin=["f1", "f2"]>
+  // STRIP-SAME:   (%{{.*}}: tensor<4x8xf32> loc(unknown))
+  // STRIP-NEXT:   stablehlo.add %{{[^ ]*}}, %{{[^ ]*}} : tensor<4x8xf32> loc(unknown)
+  // STRIP-NEXT:   stablehlo.multiply {{.*}} loc(unknown)
+  // STRIP-NEXT:   mpmd.return
+  // STRIP-NEXT: } : (!mesh_1_tensor) -> !mesh_1_tensor loc(unknown)
+  %0 = mpmd.fragment<mesh="m1", origin=["f1", "f2", "f1"]> (%arg0) (%arg1: tensor<4x8xf32> loc("b0")) {
+    %1 = stablehlo.add %arg1, %arg1 {sdy.result_sharding_origins = [{x = "self"}]} : tensor<4x8xf32> loc(callsite("c0" at callsite("c1" at callsite("c2" at "c3"))))
+    %2 = stablehlo.multiply %1, %1 : tensor<4x8xf32> loc(callsite("c0" at callsite("c1" at callsite("c2" at "c3"))))
+    mpmd.return %2 : tensor<4x8xf32> loc("r0")
+  } : (!mesh_1_tensor) -> !mesh_1_tensor loc(fused["l0", "l1", "l2", "l3"])
+  func.return %0 : !mesh_1_tensor
+}
@@ -0,0 +1,98 @@
+// RUN: mpmd_opt %s -mpmd-copy-constants='max-constant-size-bytes=64 copy-scalar-broadcasts=true' 2>&1 | FileCheck %s
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @large_non_splat_constant_is_not_copied
+func.func @large_non_splat_constant_is_not_copied() -> (!mesh_1_tensor, !mesh_1_tensor)
+  attributes {topology = #mpmd.topology<<"m1" : <["x"=2, "y"=4]>>>}
+{
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f1"]> (%{{.*}}) (%[[ARG:.*]]: tensor<4x8xf32>)
+  // CHECK-NEXT:   stablehlo.add %[[ARG]], %[[ARG]]
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> () () {
+    %c1 = stablehlo.constant dense<[[0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0], [0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0], [0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0], [0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0]]> : tensor<4x8xf32>
+    mpmd.return %c1 : tensor<4x8xf32>
+  } : () -> !mesh_1_tensor
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) (%arg0: tensor<4x8xf32>) {
+    %add = stablehlo.add %arg0, %arg0 : tensor<4x8xf32>
+    mpmd.return %add : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  return %0, %1 : !mesh_1_tensor, !mesh_1_tensor
+}
+
+// CHECK-LABEL: func @large_splat_constant_is_copied
+func.func @large_splat_constant_is_copied() -> (!mesh_1_tensor, !mesh_1_tensor)
+  attributes {topology = #mpmd.topology<<"m1" : <["x"=2, "y"=4]>>>}
+{
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f1"]>
+  // CHECK-NEXT:   %[[C:.*]] = stablehlo.constant dense<8.000000e+00>
+  // CHECK-NEXT:   stablehlo.add %[[C]], %[[C]]
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> () () {
+    %c = stablehlo.constant dense<8.000000e+00> : tensor<4x8xf32>
+    mpmd.return %c : tensor<4x8xf32>
+  } : () -> !mesh_1_tensor
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) (%arg0: tensor<4x8xf32>) {
+    %add = stablehlo.add %arg0, %arg0 : tensor<4x8xf32>
+    mpmd.return %add : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  return %0, %1 : !mesh_1_tensor, !mesh_1_tensor
+}
+
+// CHECK-LABEL: func @small_non_splat_constant_is_copied
+func.func @small_non_splat_constant_is_copied() -> (!mpmd.mesh_tensor<"m1", tensor<2xf32>>, !mpmd.mesh_tensor<"m1", tensor<2xf32>>)
+  attributes {topology = #mpmd.topology<<"m1" : <["x"=2, "y"=4]>>>}
+{
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f1"]>
+  // CHECK-NEXT:   %[[C:.*]] = stablehlo.constant dense<[1.000000e+00, 2.000000e+00]>
+  // CHECK-NEXT:   stablehlo.add %[[C]], %[[C]]
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> () () {
+    %c = stablehlo.constant dense<[1.0, 2.0]> : tensor<2xf32>
+    mpmd.return %c : tensor<2xf32>
+  } : () -> !mpmd.mesh_tensor<"m1", tensor<2xf32>>
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) (%arg0: tensor<2xf32>) {
+    %add = stablehlo.add %arg0, %arg0 : tensor<2xf32>
+    mpmd.return %add : tensor<2xf32>
+  } : (!mpmd.mesh_tensor<"m1", tensor<2xf32>>) -> !mpmd.mesh_tensor<"m1", tensor<2xf32>>
+  return %0, %1 : !mpmd.mesh_tensor<"m1", tensor<2xf32>>, !mpmd.mesh_tensor<"m1", tensor<2xf32>>
+}
+
+// CHECK-LABEL: func @scalar_broadcast_is_copied_through_transfer
+func.func @scalar_broadcast_is_copied_through_transfer() -> (!mesh_1_tensor, !mesh_2_tensor)
+  attributes {topology = #mpmd.topology<<"m1" : <["x"=2, "y"=4]>>, <"m2" : <["x"=2, "y"=4]>>>}
+{
+  // CHECK:      mpmd.fragment<mesh="m2", origin=["f1"]>
+  // CHECK-NEXT:   %[[C:.*]] = stablehlo.constant dense<1.000000e+00> : tensor<f32>
+  // CHECK-NEXT:   %[[B:.*]] = stablehlo.broadcast_in_dim %[[C]], dims = []
+  // CHECK-NEXT:   stablehlo.add %[[B]], %[[B]]
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> () () {
+    %c = stablehlo.constant dense<1.0> : tensor<f32>
+    %b = stablehlo.broadcast_in_dim %c, dims = [] : (tensor<f32>) -> tensor<4x8xf32>
+    mpmd.return %b : tensor<4x8xf32>
+  } : () -> !mesh_1_tensor
+  %t = mpmd.transfer %0 : (!mesh_1_tensor) -> !mesh_2_tensor
+  %1 = mpmd.fragment<mesh="m2", origin=["f1"]> (%t) (%arg0: tensor<4x8xf32>) {
+    %add = stablehlo.add %arg0, %arg0 : tensor<4x8xf32>
+    mpmd.return %add : tensor<4x8xf32>
+  } : (!mesh_2_tensor) -> !mesh_2_tensor
+  return %0, %1 : !mesh_1_tensor, !mesh_2_tensor
+}
+
+// CHECK-LABEL: func @operands_with_same_producer_share_copy
+func.func @operands_with_same_producer_share_copy() -> (!mesh_1_tensor, !mesh_1_tensor)
+  attributes {topology = #mpmd.topology<<"m1" : <["x"=2, "y"=4]>>, <"m2" : <["x"=2, "y"=4]>>>}
+{
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f1"]>
+  // CHECK-NEXT:   %[[C:.*]] = stablehlo.constant
+  // CHECK-NEXT:   stablehlo.add %[[C]], %[[C]]
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> () () {
+    %c = stablehlo.constant dense<8.000000e+00> : tensor<4x8xf32>
+    mpmd.return %c : tensor<4x8xf32>
+  } : () -> !mesh_1_tensor
+  %t1 = mpmd.transfer %0 : (!mesh_1_tensor) -> !mesh_2_tensor
+  %t2 = mpmd.transfer %t1 : (!mesh_2_tensor) -> !mesh_1_tensor
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0, %t2) (%arg0: tensor<4x8xf32>, %arg1: tensor<4x8xf32>) {
+    %add = stablehlo.add %arg0, %arg1 : tensor<4x8xf32>
+    mpmd.return %add : tensor<4x8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor) -> !mesh_1_tensor
+  return %0, %1 : !mesh_1_tensor, !mesh_1_tensor
+}
@@ -134,3 +134,47 @@ func.func @no_merge_at_consumer_due_to_intervening_use(%arg0: !m1_4x8)
 
   func.return %0, %4 : !m1_4x8, !m1_4x8
 }
+
+// CHECK-LABEL: func @chain_of_sideways_merges
+func.func @chain_of_sideways_merges(%arg0: !m1_4x8, %arg1: !m2_4x8)
+  -> (!m1_4x8, !m2_4x8, !m1_4x8, !m1_4x8) attributes {topology=#topo} {
+  // CHECK-NEXT: mpmd.fragment<mesh="m2", origin=["g"]>
+  // CHECK-NEXT:   stablehlo.abs
+  // CHECK-NEXT:   mpmd.return
+  // CHECK-NEXT: }
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f"]>
+  // CHECK-NEXT:   stablehlo.add
+  // CHECK-NEXT:   stablehlo.multiply
+  // CHECK-NEXT:   stablehlo.subtract
+  // CHECK-NEXT:   mpmd.return
+  // CHECK-NEXT: }
+  //
+  // %2 merges sideways into %3, and then %0 into the merged fragment, which
+  // is the next fragment of m1 after %0 once %2 and %3 are merged.
+
+  %0 = mpmd.fragment<mesh="m1", origin=[]> (%arg0)
+    (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.add %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!m1_4x8) -> !m1_4x8
+
+  %1 = mpmd.fragment<mesh="m2", origin=["g"]> (%arg1)
+    (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.abs %arg2 : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!m2_4x8) -> !m2_4x8
+
+  %2 = mpmd.fragment<mesh="m1", origin=[]> (%arg0)
+    (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.multiply %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!m1_4x8) -> !m1_4x8
+
+  %3 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0)
+    (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.subtract %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!m1_4x8) -> !m1_4x8
+
+  func.return %0, %1, %2, %3 : !m1_4x8, !m2_4x8, !m1_4x8, !m1_4x8
+}
@@ -0,0 +1,45 @@
+// RUN: mpmd_opt %s -mpmd-merge-transfers='batch-transfers=true' 2>&1 | FileCheck %s
+
+!mesh_1_tensor_f32 = !mpmd.mesh_tensor<"m1", tensor<4xf32>>
+!mesh_1_tensor_bf16 = !mpmd.mesh_tensor<"m1", tensor<8xbf16>>
+!mesh_2_tensor_f32 = !mpmd.mesh_tensor<"m2", tensor<4xf32>>
+!mesh_2_tensor_bf16 = !mpmd.mesh_tensor<"m2", tensor<8xbf16>>
+!mesh_3_tensor_f32 = !mpmd.mesh_tensor<"m3", tensor<4xf32>>
+
+// Transfers of different types to the same consumer are batched without any
+// concatenation, and moved right after the producer in the order of their
+// first use in the consumer.
+// CHECK-LABEL: func @batch_transfers_of_different_types
+func.func @batch_transfers_of_different_types(%arg0: !mesh_1_tensor_f32, %arg1: !mesh_1_tensor_bf16)
+  -> (!mesh_2_tensor_f32, !mesh_3_tensor_f32) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=4]>>, <"m2": <["x"=4]>>, <"m3": <["x"=4]>>>
+  }
+{
+// CHECK-NEXT: %[[PROD:.*]]:3 = mpmd.fragment<mesh="m1", origin=["f1"]>
+// CHECK-NOT:    stablehlo.concatenate
+// CHECK:      mpmd.return
+// CHECK-NEXT: }
+// CHECK-NEXT: %[[T2:.*]] = mpmd.transfer {mpmd.transfer_batch = 0 : i64} %[[PROD]]#1 : {{.*}}tensor<8xbf16>
+// CHECK-NEXT: %[[T1:.*]] = mpmd.transfer {mpmd.transfer_batch = 0 : i64} %[[PROD]]#0 : {{.*}}tensor<4xf32>
+// CHECK-NEXT: %[[T3:.*]] = mpmd.transfer %[[PROD]]#2
+// CHECK-NEXT: mpmd.fragment<mesh="m2", origin=["f2"]> (%[[T1]], %[[T2]])
+  %0:3 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0, %arg1)
+    (%arg2: tensor<4xf32>, %arg3: tensor<8xbf16>) {
+    mpmd.return %arg2, %arg3, %arg2 : tensor<4xf32>, tensor<8xbf16>, tensor<4xf32>
+  } : (!mesh_1_tensor_f32, !mesh_1_tensor_bf16) -> (!mesh_1_tensor_f32, !mesh_1_tensor_bf16, !mesh_1_tensor_f32)
+  %t1 = mpmd.transfer %0#0 : (!mesh_1_tensor_f32) -> !mesh_2_tensor_f32
+  // A single transfer to a consumer isn't batched.
+  %t3 = mpmd.transfer %0#2 : (!mesh_1_tensor_f32) -> !mesh_3_tensor_f32
+  %t2 = mpmd.transfer %0#1 : (!mesh_1_tensor_bf16) -> !mesh_2_tensor_bf16
+  %1 = mpmd.fragment<mesh="m2", origin=["f2"]> (%t1, %t2)
+    (%arg2: tensor<4xf32>, %arg3: tensor<8xbf16>) {
+    %2 = stablehlo.convert %arg3 : (tensor<8xbf16>) -> tensor<8xf32>
+    %3 = stablehlo.slice %2 [0:4] : (tensor<8xf32>) -> tensor<4xf32>
+    %4 = stablehlo.add %3, %arg2 : tensor<4xf32>
+    mpmd.return %4 : tensor<4xf32>
+  } : (!mesh_2_tensor_f32, !mesh_2_tensor_bf16) -> !mesh_2_tensor_f32
+  %5 = mpmd.fragment<mesh="m3", origin=["f3"]> (%t3) (%arg2: tensor<4xf32>) {
+    mpmd.return %arg2 : tensor<4xf32>
+  } : (!mesh_3_tensor_f32) -> !mesh_3_tensor_f32
+  func.return %1, %5 : !mesh_2_tensor_f32, !mesh_3_tensor_f32
+}
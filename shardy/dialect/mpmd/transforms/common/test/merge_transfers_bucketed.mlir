@@ -0,0 +1,55 @@
+// RUN: mpmd_opt %s -mpmd-merge-transfers='bucket-size-bytes=16' 2>&1 | FileCheck %s
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<2xf32>>
+!mesh_1_tensor_large = !mpmd.mesh_tensor<"m1", tensor<8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<2xf32>>
+!mesh_2_tensor_large = !mpmd.mesh_tensor<"m2", tensor<8xf32>>
+
+// Each bucket holds two tensor<2xf32>, ordered by first use in the consumer:
+// %t3 and %t1 are merged, %t2 is left alone in the second bucket and the
+// tensor<8xf32> exceeds the bucket size.
+// CHECK-LABEL: func @buckets_ordered_by_first_use
+func.func @buckets_ordered_by_first_use(%arg0: !mesh_1_tensor, %arg1: !mesh_1_tensor_large)
+  -> !mesh_2_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=4]>>, <"m2": <["x"=4]>>>
+  }
+{
+// CHECK-NEXT: %[[PROD:.*]]:5 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0, %arg1) (%[[ARG0:.*]]: tensor<2xf32>, %[[ARG1:.*]]: tensor<8xf32>)
+// CHECK-NEXT:   %[[ABS:.*]] = stablehlo.abs %[[ARG0]]
+// CHECK-NEXT:   %[[NEG:.*]] = stablehlo.negate %[[ARG0]]
+// CHECK-NEXT:   %[[RESHAPE1:.*]] = stablehlo.reshape %[[NEG]] : (tensor<2xf32>) -> tensor<1x2xf32>
+// CHECK-NEXT:   %[[RESHAPE2:.*]] = stablehlo.reshape %[[ARG0]] : (tensor<2xf32>) -> tensor<1x2xf32>
+// CHECK-NEXT:   %[[CONCAT:.*]] = stablehlo.concatenate %[[RESHAPE1]], %[[RESHAPE2]], dim = 0
+// CHECK-NEXT:   mpmd.return %[[ARG0]], %[[ABS]], %[[NEG]], %[[ARG1]], %[[CONCAT]]
+  %0:4 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0, %arg1)
+    (%arg2: tensor<2xf32>, %arg3: tensor<8xf32>) {
+    %1 = stablehlo.abs %arg2 : tensor<2xf32>
+    %2 = stablehlo.negate %arg2 : tensor<2xf32>
+    mpmd.return %arg2, %1, %2, %arg3 : tensor<2xf32>, tensor<2xf32>, tensor<2xf32>, tensor<8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor_large) -> (!mesh_1_tensor, !mesh_1_tensor, !mesh_1_tensor, !mesh_1_tensor_large)
+
+// CHECK-NEXT: %[[CONCAT_TRANSFER:.*]] = mpmd.transfer {concat_transfer} %[[PROD]]#4
+// CHECK-SAME:   (!mpmd.mesh_tensor<"m1", tensor<2x2xf32>>) -> !mpmd.mesh_tensor<"m2", tensor<2x2xf32>>
+// CHECK-NOT:  concat_transfer
+  %t1 = mpmd.transfer %0#0 : (!mesh_1_tensor) -> !mesh_2_tensor
+  %t2 = mpmd.transfer %0#1 : (!mesh_1_tensor) -> !mesh_2_tensor
+  %t3 = mpmd.transfer %0#2 : (!mesh_1_tensor) -> !mesh_2_tensor
+  %t4 = mpmd.transfer %0#3 : (!mesh_1_tensor_large) -> !mesh_2_tensor_large
+
+// CHECK:      mpmd.fragment<mesh="m2", origin=["f2"]> ({{.*}}, %[[CONCAT_TRANSFER]]) ({{.*}}, %[[ARG_CONCAT:.*]]: tensor<2x2xf32>)
+// CHECK-NEXT:   %[[SLICE1:.*]] = stablehlo.slice %[[ARG_CONCAT]] [0:1, 0:2]
+// CHECK-NEXT:   %[[SLICE1_RESHAPE:.*]] = stablehlo.reshape %[[SLICE1]]
+// CHECK-NEXT:   %[[SLICE2:.*]] = stablehlo.slice %[[ARG_CONCAT]] [1:2, 0:2]
+// CHECK-NEXT:   %[[SLICE2_RESHAPE:.*]] = stablehlo.reshape %[[SLICE2]]
+// CHECK-NEXT:   %[[MUL:.*]] = stablehlo.multiply %[[SLICE1_RESHAPE]], %[[SLICE1_RESHAPE]]
+// CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %[[MUL]], %[[SLICE2_RESHAPE]]
+// CHECK-NEXT:   stablehlo.add %[[ADD]], %arg{{.*}}
+  %5 = mpmd.fragment<mesh="m2", origin=["f2"]> (%t1, %t2, %t3, %t4)
+    (%arg2: tensor<2xf32>, %arg3: tensor<2xf32>, %arg4: tensor<2xf32>, %arg5: tensor<8xf32>) {
+    %6 = stablehlo.multiply %arg4, %arg4 : tensor<2xf32>
+    %7 = stablehlo.add %6, %arg2 : tensor<2xf32>
+    %8 = stablehlo.add %7, %arg3 : tensor<2xf32>
+    mpmd.return %8 : tensor<2xf32>
+  } : (!mesh_2_tensor, !mesh_2_tensor, !mesh_2_tensor, !mesh_2_tensor_large) -> !mesh_2_tensor
+  func.return %5 : !mesh_2_tensor
+}
@@ -0,0 +1,60 @@
+// RUN: mpmd_opt %s -mpmd-merge-transfers='cse-modified-fragments=true' 2>&1 | FileCheck %s
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<f32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<f32>>
+
+// CHECK-LABEL: func @duplicated_ops_in_modified_fragments_are_removed
+func.func @duplicated_ops_in_modified_fragments_are_removed(%arg0: !mesh_1_tensor)
+  -> (!mesh_2_tensor, !mesh_2_tensor, !mesh_1_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=4]>>, <"m2": <["x"=4]>>>
+  }
+{
+// The reshapes and concats added for each consumer are deduplicated.
+// CHECK-NEXT: %[[PROD:.*]]:4 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) (%[[ARG1:.*]]:
+// CHECK-NEXT:   %[[RESHAPE:.*]] = stablehlo.reshape %[[ARG1]] : (tensor<f32>) -> tensor<1xf32>
+// CHECK-NEXT:   %[[CONCAT:.*]] = stablehlo.concatenate %[[RESHAPE]], %[[RESHAPE]], dim = 0
+// CHECK-NEXT:   return %[[ARG1]], %[[ARG1]], %[[CONCAT]], %[[CONCAT]]
+  %0:2 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) (%arg2: tensor<f32>) {
+    mpmd.return %arg2, %arg2 : tensor<f32>, tensor<f32>
+  } : (!mesh_1_tensor) -> (!mesh_1_tensor, !mesh_1_tensor)
+
+  %t1 = mpmd.transfer %0#0 : (!mesh_1_tensor) -> !mesh_2_tensor
+  %t2 = mpmd.transfer %0#1 : (!mesh_1_tensor) -> !mesh_2_tensor
+
+// CHECK:      mpmd.fragment<mesh="m2", origin=["f2"]>
+// CHECK-NEXT:   stablehlo.slice
+// CHECK-NEXT:   stablehlo.reshape
+// CHECK-NEXT:   stablehlo.slice
+// CHECK-NEXT:   stablehlo.reshape
+// CHECK-NEXT:   stablehlo.add
+  %1 = mpmd.fragment<mesh="m2", origin=["f2"]> (%t1, %t2)
+    (%arg2: tensor<f32>, %arg3: tensor<f32>) {
+    %4 = stablehlo.add %arg2, %arg3 : tensor<f32>
+    mpmd.return %4 : tensor<f32>
+  } : (!mesh_2_tensor, !mesh_2_tensor) -> !mesh_2_tensor
+
+// CHECK:      mpmd.fragment<mesh="m2", origin=["f3"]>
+// CHECK-NEXT:   stablehlo.slice
+// CHECK-NEXT:   stablehlo.reshape
+// CHECK-NEXT:   stablehlo.slice
+// CHECK-NEXT:   stablehlo.reshape
+// CHECK-NEXT:   stablehlo.multiply
+  %2 = mpmd.fragment<mesh="m2", origin=["f3"]> (%t1, %t2)
+    (%arg2: tensor<f32>, %arg3: tensor<f32>) {
+    %4 = stablehlo.multiply %arg2, %arg3 : tensor<f32>
+    mpmd.return %4 : tensor<f32>
+  } : (!mesh_2_tensor, !mesh_2_tensor) -> !mesh_2_tensor
+
+// Fragments that aren't modified by the pass aren't CSE'd.
+// CHECK:      mpmd.fragment<mesh="m1", origin=["f4"]>
+// CHECK-NEXT:   stablehlo.abs
+// CHECK-NEXT:   stablehlo.abs
+  %3 = mpmd.fragment<mesh="m1", origin=["f4"]> (%arg0) (%arg2: tensor<f32>) {
+    %4 = stablehlo.abs %arg2 : tensor<f32>
+    %5 = stablehlo.abs %arg2 : tensor<f32>
+    %6 = stablehlo.add %4, %5 : tensor<f32>
+    mpmd.return %6 : tensor<f32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+
+  func.return %1, %2, %3 : !mesh_2_tensor, !mesh_2_tensor, !mesh_1_tensor
+}
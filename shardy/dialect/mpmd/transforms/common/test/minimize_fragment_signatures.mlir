@@ -0,0 +1,80 @@
+// RUN: mpmd_opt %s -mpmd-minimize-fragment-signatures 2>&1 | FileCheck %s
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @duplicate_and_noop_results
+func.func @duplicate_and_noop_results(%arg0: !mesh_1_tensor)
+  -> !mesh_1_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+// CHECK-NEXT: %[[F:.*]] = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0)
+// CHECK-SAME:   (%arg1: tensor<4x8xf32>) {
+// CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %arg1, %arg1
+// CHECK-NEXT:   mpmd.return %[[ADD]]
+// CHECK-NEXT: }
+// CHECK-NEXT: %[[G:.*]] = mpmd.fragment<mesh="m1", origin=["g"]> (%[[F]], %arg0)
+// CHECK-SAME:   (%arg1: tensor<4x8xf32>, %arg2: tensor<4x8xf32>) {
+// CHECK-NEXT:   %[[MUL:.*]] = stablehlo.multiply %arg1, %arg1
+// CHECK-NEXT:   %[[SUB:.*]] = stablehlo.subtract %[[MUL]], %arg2
+// CHECK-NEXT:   mpmd.return %[[SUB]]
+// CHECK-NEXT: }
+// CHECK-NEXT: return %[[G]]
+  // The second result duplicates the first one and the third returns a block
+  // argument, so they are replaced with the first result and with %arg0.
+  %0:3 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0)
+    (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %1, %1, %arg1 : tensor<4x8xf32>, tensor<4x8xf32>, tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> (!mesh_1_tensor, !mesh_1_tensor, !mesh_1_tensor)
+  // Which makes the first two operands of this fragment duplicates.
+  %2 = mpmd.fragment<mesh="m1", origin=["g"]> (%0#0, %0#1, %0#2)
+    (%arg1: tensor<4x8xf32>, %arg2: tensor<4x8xf32>, %arg3: tensor<4x8xf32>) {
+    %3 = stablehlo.multiply %arg1, %arg2 : tensor<4x8xf32>
+    %4 = stablehlo.subtract %3, %arg3 : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor, !mesh_1_tensor) -> !mesh_1_tensor
+  func.return %2 : !mesh_1_tensor
+}
+
+// CHECK-LABEL: func @unused_results_through_a_transfer
+func.func @unused_results_through_a_transfer(%arg0: !mesh_1_tensor)
+  -> !mesh_1_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+// CHECK-NEXT: %[[F:.*]] = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0)
+// CHECK-SAME:   (%arg1: tensor<4x8xf32>) {
+// CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %arg1, %arg1
+// CHECK-NEXT:   mpmd.return %[[ADD]]
+// CHECK-NEXT: }
+// CHECK-NEXT: return %[[F]]
+  %0:2 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0)
+    (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    %2 = stablehlo.multiply %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %1, %2 : tensor<4x8xf32>, tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> (!mesh_1_tensor, !mesh_1_tensor)
+  %3 = mpmd.transfer %0#1 : (!mesh_1_tensor) -> !mesh_2_tensor
+  // The result of this fragment is unused, so the fragment is erased, and
+  // with it the transfer and the second result of the fragment above.
+  %4 = mpmd.fragment<mesh="m2", origin=["g"]> (%3)
+    (%arg1: tensor<4x8xf32>) {
+    %5 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %5 : tensor<4x8xf32>
+  } : (!mesh_2_tensor) -> !mesh_2_tensor
+  func.return %0#0 : !mesh_1_tensor
+}
+
+// CHECK-LABEL: func @noop_result_with_different_type_is_kept
+func.func @noop_result_with_different_type_is_kept(%arg0: !mesh_1_tensor)
+  -> !mpmd.mesh_tensor<"m1", tensor<4x8xf32>, sharding=<@mesh, [{"x"}, {?}]>> attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+// CHECK-NEXT: %[[F:.*]] = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0)
+// CHECK-SAME:   (%arg1: tensor<4x8xf32>) {
+// CHECK-NEXT:   mpmd.return %arg1
+// CHECK-NEXT: }
+// CHECK-NEXT: return %[[F]]
+  %0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0)
+    (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mpmd.mesh_tensor<"m1", tensor<4x8xf32>, sharding=<@mesh, [{"x"}, {?}]>>
+  func.return %0 : !mpmd.mesh_tensor<"m1", tensor<4x8xf32>, sharding=<@mesh, [{"x"}, {?}]>>
+}
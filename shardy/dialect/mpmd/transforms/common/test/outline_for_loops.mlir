@@ -0,0 +1,63 @@
+// RUN: mpmd_opt %s -mpmd-outline-for-loops 2>&1 | FileCheck %s
+
+// CHECK-LABEL: func @outline_for_loop_of_three_iterations
+func.func @outline_for_loop_of_three_iterations(%arg0: tensor<10xui32>, %arg1: tensor<10xui32>) -> (tensor<10xui32>, tensor<10xui32>)
+  attributes {mesh_shape = #sdy.mesh<["x"=4]>}
+{
+  // CHECK-NEXT: %[[I0:.*]] = stablehlo.constant {unroll_counter = 0 : ui32} dense<0>
+  // CHECK-NEXT: %[[CALL0:.*]]:2 = mpmd.call @outline_for_loop_of_three_iterations_for_body(%arg0, %arg1, %[[I0]]) {unroll_counter = 0 : ui32}
+  // CHECK-NEXT: %[[I1:.*]] = stablehlo.constant {unroll_counter = 1 : ui32} dense<1>
+  // CHECK-NEXT: %[[CALL1:.*]]:2 = mpmd.call @outline_for_loop_of_three_iterations_for_body(%[[CALL0]]#0, %[[CALL0]]#1, %[[I1]]) {unroll_counter = 1 : ui32}
+  // CHECK-NEXT: %[[I2:.*]] = stablehlo.constant {unroll_counter = 2 : ui32} dense<2>
+  // CHECK-NEXT: %[[CALL2:.*]]:2 = mpmd.call @outline_for_loop_of_three_iterations_for_body(%[[CALL1]]#0, %[[CALL1]]#1, %[[I2]]) {unroll_counter = 2 : ui32}
+  // CHECK-NEXT: return %[[CALL2]]#0, %[[CALL2]]#1
+  %0:2 = mpmd.for (%arg0, %arg1) {iterations = 3 : ui32, unroll_factor = 3 : ui32}
+  (%arg2: tensor<10xui32>, %arg3: tensor<10xui32>, %index: tensor<ui32>) {
+    %1 = stablehlo.broadcast_in_dim %index, dims = [] : (tensor<ui32>) -> tensor<10xui32>
+    %2 = stablehlo.add %arg2, %1 : tensor<10xui32>
+    %3 = stablehlo.add %arg2, %arg3 : tensor<10xui32>
+    mpmd.return %2, %3 : tensor<10xui32>, tensor<10xui32>
+  } : tensor<10xui32>, tensor<10xui32>
+  func.return %0#0, %0#1 : tensor<10xui32>, tensor<10xui32>
+}
+
+// The loop body is outlined once, with the same mesh shape as its caller.
+// CHECK-LABEL: func private @outline_for_loop_of_three_iterations_for_body
+// CHECK-SAME:    (%arg0: tensor<10xui32>, %arg1: tensor<10xui32>, %arg2: tensor<ui32>) -> (tensor<10xui32>, tensor<10xui32>)
+// CHECK-SAME:    attributes {mesh_shape = #sdy.mesh<["x"=4]>}
+// CHECK-NEXT:  %[[BCAST:.*]] = stablehlo.broadcast_in_dim %arg2
+// CHECK-NEXT:  %[[ADD0:.*]] = stablehlo.add %arg0, %[[BCAST]]
+// CHECK-NEXT:  %[[ADD1:.*]] = stablehlo.add %arg0, %arg1
+// CHECK-NEXT:  return %[[ADD0]], %[[ADD1]]
+// CHECK-NOT:   unroll_counter
+
+// CHECK-LABEL: func @outline_two_for_loops
+func.func @outline_two_for_loops(%arg0: tensor<10xui32>) -> tensor<10xui32>
+  attributes {mesh_shape = #sdy.mesh<["x"=4]>}
+{
+  // CHECK-NEXT: %[[I0:.*]] = stablehlo.constant {unroll_counter = 0 : ui32} dense<0>
+  // CHECK-NEXT: %[[CALL0:.*]] = mpmd.call @outline_two_for_loops_for_body(%arg0, %[[I0]]) {unroll_counter = 0 : ui32}
+  // CHECK-NEXT: %[[I1:.*]] = stablehlo.constant {unroll_counter = 1 : ui32} dense<1>
+  // CHECK-NEXT: %[[CALL1:.*]] = mpmd.call @outline_two_for_loops_for_body(%[[CALL0]], %[[I1]]) {unroll_counter = 1 : ui32}
+  // CHECK-NEXT: %[[I2:.*]] = stablehlo.constant {unroll_counter = 2 : ui32} dense<0>
+  // CHECK-NEXT: %[[CALL2:.*]] = mpmd.call @outline_two_for_loops_for_body_0(%[[CALL1]], %[[I2]]) {unroll_counter = 2 : ui32}
+  // CHECK-NEXT: %[[I3:.*]] = stablehlo.constant {unroll_counter = 3 : ui32} dense<1>
+  // CHECK-NEXT: %[[CALL3:.*]] = mpmd.call @outline_two_for_loops_for_body_0(%[[CALL2]], %[[I3]]) {unroll_counter = 3 : ui32}
+  // CHECK-NEXT: return %[[CALL3]]
+  %0 = mpmd.for (%arg0) {iterations = 2 : ui32, unroll_factor = 2 : ui32}
+  (%arg1: tensor<10xui32>, %index: tensor<ui32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<10xui32>
+    mpmd.return %1 : tensor<10xui32>
+  } : tensor<10xui32>
+  %2 = mpmd.for (%0) {iterations = 2 : ui32, unroll_factor = 2 : ui32}
+  (%arg1: tensor<10xui32>, %index: tensor<ui32>) {
+    %3 = stablehlo.multiply %arg1, %arg1 : tensor<10xui32>
+    mpmd.return %3 : tensor<10xui32>
+  } : tensor<10xui32>
+  func.return %2 : tensor<10xui32>
+}
+
+// CHECK-LABEL: func private @outline_two_for_loops_for_body_0
+// CHECK-NEXT:  stablehlo.multiply
+// CHECK-LABEL: func private @outline_two_for_loops_for_body(
+// CHECK-NEXT:  stablehlo.add
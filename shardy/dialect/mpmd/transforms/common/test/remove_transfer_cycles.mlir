@@ -62,3 +62,32 @@ func.func public @cycle_with_pinned_host_is_kept(%arg0: !m1_4x8)
 
   return %t1_1, %t3 : !m1_4x8, !m3_4x8
 }
+
+// CHECK: func.func public @redundant_chain_is_removed
+func.func public @redundant_chain_is_removed(%arg0: !m1_4x8)
+  -> (!m3_4x8, !m3_4x8) attributes {topology = #topo} {
+// CHECK-NEXT: %[[T3:.*]] = mpmd.transfer %arg0 {{.*}} -> !mpmd.mesh_tensor<"mesh3"
+// CHECK-NEXT: %[[T2:.*]] = mpmd.transfer %arg0 {{.*}} -> !mpmd.mesh_tensor<"mesh2"
+// CHECK-NEXT: return %[[T3]], %[[T3]]
+
+  %t3 = mpmd.transfer %arg0 : (!m1_4x8) -> !m3_4x8
+  %t2 = mpmd.transfer %arg0 : (!m1_4x8) -> !m2_4x8
+  %t3_1 = mpmd.transfer %t2 : (!m2_4x8) -> !m3_4x8
+
+  return %t3, %t3_1 : !m3_4x8, !m3_4x8
+}
+
+// CHECK: func.func public @cycle_not_through_root_is_removed
+func.func public @cycle_not_through_root_is_removed(%arg0: !m1_4x8)
+  -> (!m2_4x8, !m3_4x8) attributes {topology = #topo} {
+// CHECK-NEXT: %[[T2:.*]] = mpmd.transfer %arg0
+// CHECK-NEXT: %[[T3:.*]] = mpmd.transfer %[[T2]]
+// CHECK-NEXT: return %[[T2]], %[[T3]]
+
+  %t2 = mpmd.transfer %arg0 : (!m1_4x8) -> !m2_4x8
+  %t3 = mpmd.transfer %t2 : (!m2_4x8) -> !m3_4x8
+  %t2_1 = mpmd.transfer %t3 : (!m3_4x8) -> !m2_4x8
+  %t3_1 = mpmd.transfer %t2_1 : (!m2_4x8) -> !m3_4x8
+
+  return %t2_1, %t3_1 : !m2_4x8, !m3_4x8
+}
@@ -0,0 +1,31 @@
+// RUN: mpmd_opt %s -mpmd-sink-negligible-ops-into-call-op='max-negligible-bytes=16' 2>&1 | FileCheck %s
+
+// A large iota isn't sunk, but a small iota and a large splat constant are.
+
+// CHECK-LABEL: func @main
+func.func @main(%arg0 : tensor<4x8xi32>, %arg1 : tensor<4x8xi32>) -> (tensor<4x8xi32>, tensor<4x8xi32>) attributes {
+  "topology"=#mpmd.topology<<"mesh1": <["z"=2]>>>
+} {
+  // CHECK-NEXT: %[[IOTA:.*]] = stablehlo.iota dim = 0 : tensor<4x8xi32>
+  // CHECK-NEXT: mpmd.call @fn(%[[IOTA]], %arg0)
+  // CHECK-NEXT: mpmd.call @fn(%[[IOTA]], %arg1)
+  // CHECK-NEXT: return
+  %0 = stablehlo.iota dim = 0 : tensor<4x8xi32>
+  %1 = stablehlo.iota dim = 0 : tensor<2xi32>
+  %2 = stablehlo.constant dense<1> : tensor<4x8xi32>
+  %3 = mpmd.call @fn(%0, %1, %2, %arg0) : (tensor<4x8xi32>, tensor<2xi32>, tensor<4x8xi32>, tensor<4x8xi32>) -> tensor<4x8xi32>
+  %4 = mpmd.call @fn(%0, %1, %2, %arg1) : (tensor<4x8xi32>, tensor<2xi32>, tensor<4x8xi32>, tensor<4x8xi32>) -> tensor<4x8xi32>
+  func.return %3, %4 : tensor<4x8xi32>, tensor<4x8xi32>
+}
+
+// CHECK-LABEL: func private @fn(%arg0: tensor<4x8xi32>, %arg1: tensor<4x8xi32>)
+func.func private @fn(%arg0: tensor<4x8xi32>, %arg1: tensor<2xi32>, %arg2: tensor<4x8xi32>, %arg3: tensor<4x8xi32>) -> tensor<4x8xi32> attributes {
+    "topology"=#mpmd.topology<<"mesh1": <["z"=2]>>>
+} {
+  // CHECK-DAG: %[[SMALL_IOTA:.*]] = stablehlo.iota dim = 0 : tensor<2xi32>
+  // CHECK-DAG: %[[C:.*]] = stablehlo.constant dense<1> : tensor<4x8xi32>
+  // CHECK: stablehlo.add %arg0, %[[C]]
+  %0 = stablehlo.add %arg0, %arg2 : tensor<4x8xi32>
+  %1 = stablehlo.add %0, %arg3 : tensor<4x8xi32>
+  return %1 : tensor<4x8xi32>
+}
@@ -0,0 +1,43 @@
+// RUN: mpmd_opt %s -mpmd-split-and-prioritize-transfer-independent-computations='min-transfer-bytes=1024' 2>&1 | FileCheck %s
+
+!mesh1_16x8_f32 = !mpmd.mesh_tensor<"mesh1", tensor<16x8xf32>>
+!mesh1_8x16_f32 = !mpmd.mesh_tensor<"mesh1", tensor<8x16xf32>>
+!mesh1_16x16_f32 = !mpmd.mesh_tensor<"mesh1", tensor<16x16xf32>>
+!mesh1_16x64_f32 = !mpmd.mesh_tensor<"mesh1", tensor<16x64xf32>>
+!mesh1_16x4_f32 = !mpmd.mesh_tensor<"mesh1", tensor<16x4xf32>>
+!mesh0_16x64_f32 = !mpmd.mesh_tensor<"mesh0", tensor<16x64xf32>>
+!mesh0_16x4_f32 = !mpmd.mesh_tensor<"mesh0", tensor<16x4xf32>>
+#topology = #mpmd.topology<<"mesh0" : <["x"=1]>>, <"mesh1" : <["x"=1]>>>
+
+// The transfer is 4096 bytes, so the fragment is split.
+// CHECK-LABEL: func public @split_large_transfer
+func.func public @split_large_transfer(%arg0: !mesh1_16x8_f32, %arg1 : !mesh1_8x16_f32, %arg2: !mesh0_16x64_f32) -> (!mesh1_16x16_f32, !mesh1_16x64_f32)
+  attributes {topology = #topology} {
+  // CHECK: mpmd.fragment<mesh="mesh1", origin=["block"(1)]> (%arg0, %arg1, %{{.*}}) {split_keep_transferred}
+  // CHECK: mpmd.fragment<mesh="mesh1", origin=["block"(1)]> ({{.*}}) {split_drop_transferred}
+  %t2 = mpmd.transfer %arg2 : (!mesh0_16x64_f32) -> !mesh1_16x64_f32
+  %0:2 = mpmd.fragment<mesh="mesh1", origin=["block"(1)]> (%arg0, %arg1, %t2)
+    (%arg10: tensor<16x8xf32>, %arg11 : tensor<8x16xf32>, %arg12: tensor<16x64xf32>) {
+      %1 = "stablehlo.dot"(%arg10, %arg11) : (tensor<16x8xf32>, tensor<8x16xf32>) -> tensor<16x16xf32>
+      %2 = "stablehlo.dot"(%1, %arg12) : (tensor<16x16xf32>, tensor<16x64xf32>) -> tensor<16x64xf32>
+      mpmd.return %1, %2 : tensor<16x16xf32>, tensor<16x64xf32>
+    } : (!mesh1_16x8_f32, !mesh1_8x16_f32, !mesh1_16x64_f32) -> (!mesh1_16x16_f32, !mesh1_16x64_f32)
+  func.return %0#0, %0#1 : !mesh1_16x16_f32, !mesh1_16x64_f32
+}
+
+// The transfer is 256 bytes, so the fragment isn't split.
+// CHECK-LABEL: func public @no_split_small_transfer
+func.func public @no_split_small_transfer(%arg0: !mesh1_16x8_f32, %arg1 : !mesh1_8x16_f32, %arg2: !mesh0_16x4_f32) -> (!mesh1_16x16_f32, !mesh1_16x4_f32)
+  attributes {topology = #topology} {
+  // CHECK:      mpmd.transfer
+  // CHECK-NEXT: mpmd.fragment<mesh="mesh1", origin=["block"(1)]> (%arg0, %arg1, %{{.*}}) (
+  // CHECK-NOT:  mpmd.fragment
+  %t2 = mpmd.transfer %arg2 : (!mesh0_16x4_f32) -> !mesh1_16x4_f32
+  %0:2 = mpmd.fragment<mesh="mesh1", origin=["block"(1)]> (%arg0, %arg1, %t2)
+    (%arg10: tensor<16x8xf32>, %arg11 : tensor<8x16xf32>, %arg12: tensor<16x4xf32>) {
+      %1 = "stablehlo.dot"(%arg10, %arg11) : (tensor<16x8xf32>, tensor<8x16xf32>) -> tensor<16x16xf32>
+      %2 = stablehlo.add %arg12, %arg12 : tensor<16x4xf32>
+      mpmd.return %1, %2 : tensor<16x16xf32>, tensor<16x4xf32>
+    } : (!mesh1_16x8_f32, !mesh1_8x16_f32, !mesh1_16x4_f32) -> (!mesh1_16x16_f32, !mesh1_16x4_f32)
+  func.return %0#0, %0#1 : !mesh1_16x16_f32, !mesh1_16x4_f32
+}
@@ -14,27 +14,34 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdint>
+#include <iterator>
 #include <vector>
 
 #include "llvm/ADT/STLExtras.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/IRMapping.h"
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/SymbolTable.h"
 #include "mlir/IR/Value.h"
 #include "mlir/IR/Visitors.h"
 #include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
 #include "mlir/Support/WalkResult.h"
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
 #include "shardy/dialect/mpmd/transforms/common/passes.h"  // IWYU pragma: keep
 #include "shardy/dialect/mpmd/transforms/common/utils.h"
 #include "stablehlo/dialect/StablehloOps.h"
 
 namespace mlir::mpmd {
 
+#define GEN_PASS_DEF_OUTLINEFORLOOPSPASS
 #define GEN_PASS_DEF_UNROLLFORLOOPSPASS
 #include "shardy/dialect/mpmd/transforms/common/passes.h.inc"
 
@@ -118,6 +125,83 @@ int FullyUnrollForOp(ForOp for_op, RewriterBase& rewriter,
   return num_iterations;
 }
 
+// Checks the pre-conditions of unrolling or outlining `for_op`, emitting an
+// error if `for_op` is nested in another loop.
+LogicalResult VerifyForOpCanBeUnrolled(ForOp for_op) {
+  // Crashes if pre-condition is not met.
+  SDY_CHECK(for_op.getIterations() == for_op.getUnrollFactor())
+      << "The unroll factor is required to be the same as the number of "
+      << "iterations.";
+  // TODO: b/372460554 - Support nested mpmd.for loops.
+  // NOTE: At the moment, users will be able to nest for loops using
+  // mpmd.calls as an indirection, this could create odd pipeline schedules,
+  // and needs to be addressed (either disallow pipeline scheduling on
+  // nested loops, or change the scheduler to consider more than one
+  // call/unroll_counter).
+  if (for_op->getParentOfType<ForOp>()) {
+    return for_op->emitError(
+               "Nested fori loops aren't supported. Please contact OWNERs if ")
+           << "you need this feature.";
+  }
+  return success();
+}
+
+// Requires: the unroll factor to be equal to the number of iterations.
+//
+// Moves the body of `for_op` into a new private function and replaces
+// `for_op` with one `mpmd.call` to that function per iteration, each passed
+// its index as a constant and annotated with an unroll counter. The function
+// is inserted after `parent`, with the same topology or mesh shape.
+//
+// Unroll counters are unique across the loops of a function, as in
+// `FullyUnrollForOp`.
+int OutlineForOp(ForOp for_op, func::FuncOp parent, SymbolTable& symbol_table,
+                 RewriterBase& rewriter, int starting_counter) {
+  const uint32_t num_iterations = for_op.getIterations();
+  Block* for_body = for_op.getBody();
+  Location loc = for_op.getLoc();
+
+  auto callee = func::FuncOp::create(
+      loc, (parent.getSymName() + "_for_body").str(),
+      rewriter.getFunctionType(for_body->getArgumentTypes(),
+                               for_op.getResultTypes()));
+  callee.setPrivate();
+  for (StringRef attr_name : {kTopologyAttr, kMeshShapeAttr}) {
+    if (Attribute attr = parent->getAttr(attr_name)) {
+      callee->setAttr(attr_name, attr);
+    }
+  }
+  // Renames the function if its name is already taken.
+  symbol_table.insert(callee, std::next(parent->getIterator()));
+
+  rewriter.inlineRegionBefore(for_op.getRegion(), callee.getBody(),
+                              callee.end());
+  Operation* terminator = callee.front().getTerminator();
+  rewriter.setInsertionPoint(terminator);
+  rewriter.replaceOpWithNewOp<func::ReturnOp>(terminator,
+                                              terminator->getOperands());
+
+  rewriter.setInsertionPoint(for_op);
+  std::vector<Value> iteration_operands(for_op.getOperands().begin(),
+                                        for_op.getOperands().end());
+  for (uint32_t unroll_counter = 0; unroll_counter < num_iterations;
+       ++unroll_counter) {
+    Value unrolled_index = GetUint32Constant(rewriter, loc, unroll_counter);
+    SetUnrollCounter(unrolled_index.getDefiningOp(),
+                     starting_counter + unroll_counter, rewriter);
+    std::vector<Value> call_operands = iteration_operands;
+    call_operands.push_back(unrolled_index);
+    auto call_op =
+        CallOp::create(rewriter, loc, for_op.getResultTypes(), call_operands,
+                       FlatSymbolRefAttr::get(callee.getSymNameAttr()));
+    SetUnrollCounter(call_op, starting_counter + unroll_counter, rewriter);
+    iteration_operands.assign(call_op.getResults().begin(),
+                              call_op.getResults().end());
+  }
+  rewriter.replaceOp(for_op, iteration_operands);
+  return num_iterations;
+}
+
 class UnrollForLoopsPass
     : public impl::UnrollForLoopsPassBase<UnrollForLoopsPass> {
   using UnrollForLoopsPassBase::UnrollForLoopsPassBase;
@@ -128,20 +212,7 @@ class UnrollForLoopsPass
     int for_loop_counter = 0;
     auto walk_result = func_op.getBody().walk([&rewriter,
                                                &for_loop_counter](ForOp op) {
-      // Crashes if pre-condition is not met.
-      SDY_CHECK(op.getIterations() == op.getUnrollFactor())
-          << "The unroll factor is required to be the same as the number of "
-          << "iterations.";
-      // TODO: b/372460554 - Support nested mpmd.for loops.
-      // NOTE: At the moment, users will be able to nest for loops using
-      // mpmd.calls as an indirection, this could create odd pipeline schedules,
-      // and needs to be addressed (either disallow pipeline scheduling on
-      // nested loops, or change the scheduler to consider more than one
-      // call/unroll_counter).
-      if (op->getParentOfType<ForOp>()) {
-        op->emitError(
-            "Nested fori loops aren't supported. Please contact OWNERs if you ")
-            << "need this feature.";
+      if (failed(VerifyForOpCanBeUnrolled(op))) {
         return WalkResult::interrupt();
       }
       for_loop_counter += FullyUnrollForOp(op, rewriter, for_loop_counter);
@@ -154,5 +225,43 @@ class UnrollForLoopsPass
   }
 };
 
+class OutlineForLoopsPass
+    : public impl::OutlineForLoopsPassBase<OutlineForLoopsPass> {
+  using OutlineForLoopsPassBase::OutlineForLoopsPassBase;
+
+ protected:
+  void runOnOperation() final {
+    ModuleOp module_op = getOperation();
+    SymbolTable symbol_table(module_op);
+    IRRewriter rewriter(module_op.getContext());
+    // Collect the functions first, as outlining adds functions to the module.
+    SmallVector<func::FuncOp> func_ops;
+    for (func::FuncOp func_op : module_op.getOps<func::FuncOp>()) {
+      if (IsDistributedFunction(func_op)) {
+        func_ops.push_back(func_op);
+      }
+    }
+    for (func::FuncOp func_op : func_ops) {
+      SmallVector<ForOp> for_ops;
+      auto walk_result = func_op.getBody().walk([&for_ops](ForOp op) {
+        if (failed(VerifyForOpCanBeUnrolled(op))) {
+          return WalkResult::interrupt();
+        }
+        for_ops.push_back(op);
+        // No nested for loops, so no need to visit the body.
+        return WalkResult::skip();
+      });
+      if (walk_result.wasInterrupted()) {
+        return signalPassFailure();
+      }
+      int for_loop_counter = 0;
+      for (ForOp for_op : for_ops) {
+        for_loop_counter += OutlineForOp(for_op, func_op, symbol_table,
+                                         rewriter, for_loop_counter);
+      }
+    }
+  }
+};
+
 }  // namespace
 }  // namespace mlir::mpmd
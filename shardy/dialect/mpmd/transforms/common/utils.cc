@@ -35,6 +35,7 @@ limitations under the License.
 #include "mlir/IR/IRMapping.h"
 #include "mlir/IR/Location.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/Region.h"
@@ -424,13 +425,52 @@ SmallVector<Value> CollectControlOperands(Operation* lhs_op,
   return control_operands;
 }
 
+// Returns true if `lhs` has fewer ops than `rhs`, in time linear in the size
+// of the smaller block.
+bool HasFewerOps(Block& lhs, Block& rhs) {
+  Block::iterator lhs_it = lhs.begin();
+  Block::iterator rhs_it = rhs.begin();
+  while (lhs_it != lhs.end() && rhs_it != rhs.end()) {
+    ++lhs_it;
+    ++rhs_it;
+  }
+  return lhs_it == lhs.end() && rhs_it != rhs.end();
+}
+
+// Equivalent to merging `consumer_block` into the end of `producer_block`, with
+// `new_consumer_args` replacing the consumer block arguments, but moves the ops
+// of the producer to the start of the consumer block instead. The consumer
+// block ends up with the arguments of the producer block.
+void InlineProducerBlockIntoConsumerBlock(Block& producer_block,
+                                          Block& consumer_block,
+                                          ArrayRef<Value> new_consumer_args,
+                                          RewriterBase& rewriter) {
+  int num_consumer_args = consumer_block.getNumArguments();
+  IRMapping producer_arg_to_merged_arg;
+  for (BlockArgument arg : producer_block.getArguments()) {
+    producer_arg_to_merged_arg.map(
+        arg, consumer_block.addArgument(arg.getType(), arg.getLoc()));
+  }
+  for (auto [arg, new_arg] : llvm::zip_equal(
+           consumer_block.getArguments().take_front(num_consumer_args),
+           new_consumer_args)) {
+    rewriter.replaceAllUsesWith(
+        arg, producer_arg_to_merged_arg.lookupOrDefault(new_arg));
+  }
+  consumer_block.eraseArguments(0, num_consumer_args);
+  rewriter.inlineBlockBefore(&producer_block, &consumer_block,
+                             consumer_block.begin(),
+                             consumer_block.getArguments());
+}
+
 Operation* MergeRegionOpsImpl(
     Operation* producer_op, Operation* consumer_op, RewriterBase& rewriter,
     int num_static_args,
     std::function<void(OpOperand&, Value)>
         replace_producer_use_in_consumer_block,
     std::function<Operation*(Location, TypeRange, ValueRange)>
-        create_merged_op) {
+        create_merged_op,
+    std::function<void(Operation*)> reset_consumer_op) {
   SDY_CHECK_EQ(producer_op->getNumRegions(), 1);
   SDY_CHECK_EQ(consumer_op->getNumRegions(), 1);
   Block& producer_block = producer_op->getRegion(0).front();
@@ -450,24 +490,28 @@ Operation* MergeRegionOpsImpl(
 
     auto fused_loc =
         rewriter.getFusedLoc({producer_op->getLoc(), consumer_op->getLoc()});
-    // It is ugly to have to set the insertion point here, but typically the
-    // callback will capture the same rewriter (!) so we have to set the
-    // insertion point before we call the callback. This is sad. We should be
-    // passing the rewriter ref to the callback.
-    rewriter.setInsertionPoint(consumer_op);
-    // It is also a little sad we cannot reuse the consumer_op entirely in place
-    // and have to allocate operand lists for it. But the callback deals with
-    // setting the attributes correctly in the fused op. This deserves some
-    // refactoring to decouple the expensive parts and allow us to fully reuse
-    // the consumer_op, in-place.
-    //
-    // TODO(dvytin): refactor the callbacks to MergeRegionOps.
-    Operation* fused_op = create_merged_op(
-        fused_loc, consumer_op->getResultTypes(), consumer_op->getOperands());
-    fused_op->getRegion(0).takeBody(consumer_op->getRegion(0));
+    // The fused op has the results of the consumer op, so we reuse the
+    // consumer op in place if we can, rather than creating a new op and
+    // replacing every use of the consumer results.
+    Operation* fused_op = consumer_op;
+    if (reset_consumer_op) {
+      rewriter.modifyOpInPlace(consumer_op, [&]() {
+        consumer_op->setLoc(fused_loc);
+        reset_consumer_op(consumer_op);
+      });
+    } else {
+      // The callback typically captures the same rewriter, so we have to set
+      // the insertion point before we call it.
+      rewriter.setInsertionPoint(consumer_op);
+      fused_op = create_merged_op(fused_loc, consumer_op->getResultTypes(),
+                                  consumer_op->getOperands());
+      fused_op->getRegion(0).takeBody(consumer_op->getRegion(0));
+    }
     Block& fused_block = fused_op->getRegion(0).front();
     // Replace the operand with the producer op operand.
-    fused_op->setOperand(operand_index, producer_op->getOperand(0));
+    rewriter.modifyOpInPlace(fused_op, [&]() {
+      fused_op->setOperand(operand_index, producer_op->getOperand(0));
+    });
     Operation* terminator = producer_block.getTerminator();
     Value yielded_value = terminator->getOperand(0);
     BlockArgument arg = fused_block.getArgument(operand_index);
@@ -475,7 +519,9 @@ Operation* MergeRegionOpsImpl(
     arg.setType(producer_block.getArgument(0).getType());
     rewriter.inlineBlockBefore(&producer_block, &fused_block.front(), arg);
     rewriter.eraseOp(terminator);
-    rewriter.replaceOp(consumer_op, fused_op->getResults());
+    if (fused_op != consumer_op) {
+      rewriter.replaceOp(consumer_op, fused_op->getResults());
+    }
     rewriter.eraseOp(producer_op);
     return fused_op;
   }
@@ -505,8 +551,18 @@ Operation* MergeRegionOpsImpl(
   Operation* producer_return_op = producer_block.getTerminator();
 
   // Inline the consumer block at the end of the producer block, to get a merged
-  // block.
-  rewriter.mergeBlocks(&consumer_block, &producer_block, new_consumer_args);
+  // block. Moving ops between blocks is linear in the number of ops moved, so
+  // if the consumer is larger we move the producer ops instead. Otherwise,
+  // absorbing a chain of small producers into a growing consumer, e.g., when
+  // merging inferred fragments bottom-up, would be quadratic.
+  bool merge_into_consumer = HasFewerOps(producer_block, consumer_block);
+  if (merge_into_consumer) {
+    InlineProducerBlockIntoConsumerBlock(producer_block, consumer_block,
+                                         new_consumer_args, rewriter);
+  } else {
+    rewriter.mergeBlocks(&consumer_block, &producer_block, new_consumer_args);
+  }
+  Block& merged_block = merge_into_consumer ? consumer_block : producer_block;
 
   int max_num_results =
       producer_op->getNumResults() + consumer_op->getNumResults();
@@ -530,19 +586,43 @@ Operation* MergeRegionOpsImpl(
   // Add all return operands of the consumer op to `new_return_operands`. Note
   // that this needs to be done after the call to `mergeBlocks` because the
   // block arguments have been replaced for the consumer block.
-  Operation* return_op = producer_block.getTerminator();
+  Operation* return_op = merged_block.getTerminator();
   llvm::copy(return_op->getOperands(), std::back_inserter(new_return_operands));
 
   // Set the operands of the return op to those of the merged block.
   return_op->setOperands(new_return_operands);
 
-  // Finally create the merged op with a fused location right before consumer
+  Location fused_loc =
+      rewriter.getFusedLoc({producer_op->getLoc(), consumer_op->getLoc()});
+
+  // If no result of the producer survives the merge, the merged op has exactly
+  // the results of the consumer op, so we turn the consumer op into the merged
+  // op in place, rather than creating a new op and replacing every use of the
+  // consumer results.
+  if (reset_consumer_op && producer_results_to_replace.empty()) {
+    rewriter.modifyOpInPlace(consumer_op, [&]() {
+      consumer_op->setOperands(new_operands);
+      consumer_op->setLoc(fused_loc);
+      reset_consumer_op(consumer_op);
+      if (!control_operands.empty()) {
+        consumer_op->setAttr(
+            kControlOperandStartIdxAttrName,
+            IntegerAttr::get(IntegerType::get(consumer_op->getContext(), 64),
+                             control_operand_start_index));
+      }
+      if (!merge_into_consumer) {
+        consumer_op->getRegion(0).takeBody(producer_op->getRegion(0));
+      }
+    });
+    rewriter.eraseOp(producer_op);
+    return consumer_op;
+  }
+
+  // Otherwise create the merged op with a fused location right before consumer
   // op, take the merged block from the producer, and replace the results of
   // both the producer and consumer ops with the corresponding results of the
   // merged op.
   rewriter.setInsertionPoint(consumer_op);
-  Location fused_loc =
-      rewriter.getFusedLoc({producer_op->getLoc(), consumer_op->getLoc()});
   Operation* new_op =
       create_merged_op(fused_loc, new_result_types, new_operands);
 
@@ -555,7 +635,9 @@ Operation* MergeRegionOpsImpl(
                                      control_operand_start_index));
   }
 
-  new_op->getRegion(0).takeBody(producer_op->getRegion(0));
+  new_op->getRegion(0).takeBody(merge_into_consumer
+                                    ? consumer_op->getRegion(0)
+                                    : producer_op->getRegion(0));
 
   for (auto [old_result, new_result] :
        llvm::zip_first(producer_results_to_replace, new_op->getResults())) {
@@ -586,6 +668,11 @@ Operation* MergeRegionOpsImpl(
 // `builder_args` should include any builder argument that should be forwarded
 // to `OpTy::create(rewriter, ...)` in addition to result types and operands.
 //
+// If `reset_consumer_op` is set and the merged op would have exactly the
+// results of `consumer_op`, `consumer_op` is reused in place as the merged op,
+// and `reset_consumer_op` should give it the attributes that
+// `OpTy::create(rewriter, ..., builder_args)` would.
+//
 // NOTE: we assume OpTy is an op with a single region, that has
 // `num_static_args` static block arguments and an additional block argument
 // for each operand, and that all uses of `producer_op` are at or after
@@ -595,14 +682,22 @@ OpTy MergeRegionOps(OpTy producer_op, OpTy consumer_op, RewriterBase& rewriter,
                     int num_static_args,
                     std::function<void(OpOperand&, Value)>
                         replace_producer_use_in_consumer_block,
+                    std::function<void(OpTy)> reset_consumer_op,
                     BuilderArgs&&... builder_args) {
+  std::function<void(Operation*)> reset_consumer_operation;
+  if (reset_consumer_op) {
+    reset_consumer_operation = [&](Operation* op) {
+      reset_consumer_op(cast<OpTy>(op));
+    };
+  }
   return cast<OpTy>(MergeRegionOpsImpl(
       producer_op, consumer_op, rewriter, num_static_args,
       replace_producer_use_in_consumer_block,
       [&](Location loc, TypeRange result_types, ValueRange operands) {
         return OpTy::create(rewriter, loc, result_types, operands,
                             std::forward<BuilderArgs>(builder_args)...);
-      }));
+      },
+      reset_consumer_operation));
 }
 
 }  // namespace
@@ -623,6 +718,8 @@ FragmentOp MergeFragments(FragmentOp producer, FragmentOp consumer,
   IntegerAttr producer_stage = producer.getStageIdAttr();
   IntegerAttr stage_id =
       producer_stage ? producer_stage : consumer.getStageIdAttr();
+  ArrayAttr origin = GetFragmentOriginUnion(producer, consumer, rewriter);
+  StringAttr mesh_name = producer.getMeshNameAttr();
 
   return MergeRegionOps(
       producer, consumer, rewriter,
@@ -631,8 +728,21 @@ FragmentOp MergeFragments(FragmentOp producer, FragmentOp consumer,
       [](OpOperand&, Value) {
         SDY_CHECK(false) << "Fragment ops shouldn't have free variables";
       },
-      GetFragmentOriginUnion(producer, consumer, rewriter),
-      producer.getMeshNameAttr(), stage_id);
+      /*reset_consumer_op=*/
+      [&](FragmentOp fragment) {
+        fragment->setDiscardableAttrs(
+            DictionaryAttr::get(fragment.getContext()));
+        fragment.setOriginAttr(origin);
+        fragment.setMeshNameAttr(mesh_name);
+        if (stage_id) {
+          fragment.setStageIdAttr(stage_id);
+        } else {
+          fragment.removeStageIdAttr();
+        }
+        fragment.removeInShardingsAttr();
+        fragment.removeOutShardingsAttr();
+      },
+      origin, mesh_name, stage_id);
 }
 
 namespace {
@@ -745,4 +855,24 @@ SmallVector<std::pair<StringRef, Attribute>> MergeAttributes(
   return attributes;
 }
 
+bool IsNegligibleOp(Operation* op, int64_t max_result_bytes) {
+  if (op->getNumOperands() != 0 || op->getNumResults() != 1) {
+    return false;
+  }
+  if (max_result_bytes < 0) {
+    return true;
+  }
+  if (DenseElementsAttr value;
+      matchPattern(op->getResult(0), m_Constant(&value)) && value.isSplat()) {
+    return true;
+  }
+  Type type = op->getResult(0).getType();
+  if (auto mesh_tensor_type = dyn_cast<MeshTensorType>(type)) {
+    type = mesh_tensor_type.getRankedTensorType();
+  }
+  auto tensor_type = dyn_cast<RankedTensorType>(type);
+  return tensor_type && tensor_type.hasStaticShape() &&
+         GetSizeInBytes(tensor_type) <= max_result_bytes;
+}
+
 }  // namespace mlir::mpmd
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_COMMON_UTILS_H_
 #define SHARDY_DIALECT_MPMD_TRANSFORMS_COMMON_UTILS_H_
 
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -163,6 +164,13 @@ FragmentOp MergeFragments(FragmentOp producer, FragmentOp consumer,
 SmallVector<std::pair<StringRef, Attribute>> MergeAttributes(
     FragmentOp producer_op, FragmentOp consumer_op);
 
+// Returns whether `op` is negligible, i.e., cheap enough to be duplicated
+// rather than passed around: it has no operands and a single result, and
+// either `max_result_bytes` is negative, the result is a splat constant, or
+// the result is a static tensor of at most `max_result_bytes` bytes. Since `op`
+// has no operands, its cost is proportional to the size of its result.
+bool IsNegligibleOp(Operation* op, int64_t max_result_bytes);
+
 }  // namespace mlir::mpmd
 
 #endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_COMMON_UTILS_H_
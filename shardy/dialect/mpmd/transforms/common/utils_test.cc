@@ -169,6 +169,53 @@ TEST(MergeFragments, ProducerResultUsedByConsumer) {
   EXPECT_EQ(merged.getNumResults(), 1);
 }
 
+TEST(MergeFragments, ReusesConsumerWhenNoProducerResultSurvives) {
+  const char kProgram[] = R"mlir(
+    !mesh_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+    func.func @main(%arg0: !mesh_tensor, %arg1: !mesh_tensor) -> !mesh_tensor
+      attributes {"topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+      %0:2 = mpmd.fragment<mesh="m1", origin=["f0"(0)]> (%arg0, %arg1)
+           (%arg2: tensor<4x8xf32>, %arg3: tensor<4x8xf32>) {
+        mpmd.return %arg2, %arg3 : tensor<4x8xf32>, tensor<4x8xf32>
+      } : (!mesh_tensor, !mesh_tensor) -> (!mesh_tensor, !mesh_tensor)
+
+      %1 = mpmd.fragment<mesh="m1", origin=["f1"(0)]> (%0#0, %0#1)
+           {foo = 1 : i32} (%arg2: tensor<4x8xf32>, %arg3: tensor<4x8xf32>) {
+        %2 = stablehlo.add %arg2, %arg3 : tensor<4x8xf32>
+        mpmd.return %2 : tensor<4x8xf32>
+      } : (!mesh_tensor, !mesh_tensor) -> !mesh_tensor
+
+      return %1 : !mesh_tensor
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  FuncOp func_op = GetMainFunction(*module);
+
+  auto it = func_op.getOps().begin();
+  FragmentOp f0 = mlir::cast<FragmentOp>(*it++);
+  FragmentOp f1 = mlir::cast<FragmentOp>(*it);
+
+  IRRewriter rewriter(&context);
+  rewriter.setInsertionPoint(f1);
+
+  FragmentOp merged = MergeFragments(f0, f1, rewriter);
+
+  // All results of the producer were only used by the consumer, so the
+  // consumer is turned into the merged fragment in place.
+  EXPECT_EQ(merged.getOperation(), f1.getOperation());
+  ASSERT_EQ(merged.getNumOperands(), 2);
+  EXPECT_EQ(merged->getOperand(0), func_op.getArgument(0));
+  EXPECT_EQ(merged->getOperand(1), func_op.getArgument(1));
+  EXPECT_EQ(merged.getOriginAttr().size(), 2);
+  // The merged fragment has the same attributes as a newly built one.
+  EXPECT_FALSE(merged->hasAttr("foo"));
+  EXPECT_EQ(&func_op.front().front(), merged.getOperation());
+}
+
 TEST(MergeFragments, PreservesControlOperands) {
   const char kProgram[] = R"mlir(
     !mesh_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
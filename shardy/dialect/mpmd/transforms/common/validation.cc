@@ -0,0 +1,44 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/common/validation.h"
+
+#include <functional>
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir::mpmd {
+
+LogicalResult ValidationWalker::Walk(func::FuncOp func_op) {
+  if (!visitors_.empty()) {
+    func_op.walk([&](Operation* op) {
+      auto it = visitors_.find(op->getName().getTypeID());
+      if (it == visitors_.end()) {
+        return;
+      }
+      for (const std::function<void(Operation*)>& visitor : it->second) {
+        visitor(op);
+      }
+    });
+  }
+  for (const std::function<void()>& finalizer : finalizers_) {
+    finalizer();
+  }
+  return failure(failed_);
+}
+
+}  // namespace mlir::mpmd
@@ -0,0 +1,73 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_COMMON_VALIDATION_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_COMMON_VALIDATION_H_
+
+#include <functional>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/TypeID.h"
+
+namespace mlir::mpmd {
+
+// Runs the validation checks of a function in a single walk.
+//
+// Each check registers visitors for the op types it inspects, and optionally a
+// finalizer for diagnostics that depend on all visited ops. `Walk` then visits
+// every op of the function once, in post-order, calling the visitors of its
+// type in the order they were registered, followed by the finalizers. A check
+// that finds an error calls `SignalFailure`.
+//
+// A walker is meant to be created for each function, e.g., in `runOnFunc` of a
+// `DistributedFunctionPass`, so that functions can be validated concurrently.
+class ValidationWalker {
+ public:
+  // Registers `visitor` to be called on every op of type `OpTy`.
+  template <typename OpTy>
+  void AddVisitor(std::function<void(OpTy)> visitor) {
+    visitors_[TypeID::get<OpTy>()].push_back(
+        [visitor = std::move(visitor)](Operation* op) {
+          visitor(cast<OpTy>(op));
+        });
+  }
+
+  // Registers `finalizer` to be called once after all ops have been visited.
+  void AddFinalizer(std::function<void()> finalizer) {
+    finalizers_.push_back(std::move(finalizer));
+  }
+
+  // Marks the validation as failed, e.g., after emitting an error.
+  void SignalFailure() { failed_ = true; }
+
+  // Walks `func_op` once with all registered visitors and then calls the
+  // finalizers. Returns failure if any check called `SignalFailure`.
+  LogicalResult Walk(func::FuncOp func_op);
+
+ private:
+  llvm::DenseMap<TypeID, SmallVector<std::function<void(Operation*)>, 1>>
+      visitors_;
+  SmallVector<std::function<void()>> finalizers_;
+  bool failed_ = false;
+};
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_COMMON_VALIDATION_H_
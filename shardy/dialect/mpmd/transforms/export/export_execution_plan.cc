@@ -0,0 +1,210 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/save_module_op.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_EXPORTEXECUTIONPLANPASS
+#include "shardy/dialect/mpmd/transforms/export/passes.h.inc"
+
+namespace {
+
+using ::mlir::func::FuncOp;
+
+// Returns the cost of `fragment_call`, which is the `kFragmentCostAttrName` of
+// the call or its callee if present, or an estimate of the floating point
+// operations of the callee otherwise. The callee holds the local types of the
+// fragment, so its ops are estimated without a mesh.
+double GetFragmentCallCost(FragmentCallOp fragment_call, FuncOp callee) {
+  for (Operation* op : {fragment_call.getOperation(), callee.getOperation()}) {
+    if (auto user_cost = op->getAttrOfType<FloatAttr>(kFragmentCostAttrName)) {
+      return user_cost.getValueAsDouble();
+    }
+    if (auto user_cost =
+            op->getAttrOfType<IntegerAttr>(kFragmentCostAttrName)) {
+      return user_cost.getInt();
+    }
+  }
+  double cost = 0.0;
+  callee.walk([&](Operation* op) {
+    if (!isa<func::ReturnOp>(op) && op != callee) {
+      cost += EstimateOpFlops(op, /*mesh=*/nullptr);
+    }
+  });
+  return cost;
+}
+
+// A node of the execution plan, i.e., a fragment call or a transfer.
+struct PlanNode {
+  Operation* op;
+  // The ids of the nodes this node depends on, in increasing order.
+  SmallVector<int64_t> node_deps;
+  // The indices of the function arguments this node uses, in increasing order.
+  SmallVector<int64_t> arg_deps;
+};
+
+class ExportExecutionPlanPass
+    : public impl::ExportExecutionPlanPassBase<ExportExecutionPlanPass> {
+  using ExportExecutionPlanPassBase::ExportExecutionPlanPassBase;
+
+ protected:
+  void runOnFunc(FuncOp func_op) override {
+    if (!IsMpmdFunction(func_op)) {
+      return;
+    }
+    std::string plan;
+    llvm::raw_string_ostream os(plan);
+    WritePlan(os, func_op, BuildNodes(func_op));
+    Save(func_op, plan);
+    markAllAnalysesPreserved();
+  }
+
+ private:
+  // Returns the fragment calls and transfers of `func_op` in program order,
+  // with the dependencies between them. Other ops, e.g., ops on tokens, are
+  // looked through, i.e., a node that uses their results depends on the nodes
+  // and arguments they use.
+  SmallVector<PlanNode> BuildNodes(FuncOp func_op) {
+    SmallVector<PlanNode> nodes;
+    // The nodes and arguments each op of the function depends on, where the
+    // nodes are given by their ids and arguments by their negated index minus
+    // one, so that both fit in one set.
+    llvm::DenseMap<Operation*, llvm::SmallSetVector<int64_t, 4>> op_deps;
+    llvm::DenseMap<Operation*, int64_t> node_ids;
+    for (Operation& op : func_op.getOps()) {
+      llvm::SmallSetVector<int64_t, 4> deps;
+      for (Value operand : op.getOperands()) {
+        if (auto arg = dyn_cast<BlockArgument>(operand)) {
+          deps.insert(-static_cast<int64_t>(arg.getArgNumber()) - 1);
+        } else if (auto node_it = node_ids.find(operand.getDefiningOp());
+                   node_it != node_ids.end()) {
+          deps.insert(node_it->second);
+        } else if (auto op_it = op_deps.find(operand.getDefiningOp());
+                   op_it != op_deps.end()) {
+          deps.insert(op_it->second.begin(), op_it->second.end());
+        }
+      }
+      if (!isa<FragmentCallOp, TransferOp>(op)) {
+        op_deps[&op] = std::move(deps);
+        continue;
+      }
+      PlanNode& node = nodes.emplace_back();
+      node.op = &op;
+      for (int64_t dep : deps) {
+        if (dep >= 0) {
+          node.node_deps.push_back(dep);
+        } else {
+          node.arg_deps.push_back(-dep - 1);
+        }
+      }
+      llvm::sort(node.node_deps);
+      llvm::sort(node.arg_deps);
+      node_ids[&op] = nodes.size() - 1;
+    }
+    return nodes;
+  }
+
+  // Returns the bytes on each device of the mesh of the `values`, ignoring
+  // values that aren't mesh tensors, e.g., tokens.
+  int64_t GetBytes(ValueRange values) {
+    LocalTensorTypeCache& type_cache = getAnalysis<LocalTensorTypeCache>();
+    int64_t bytes = 0;
+    for (Value value : values) {
+      if (auto type = dyn_cast<MeshTensorType>(value.getType())) {
+        bytes += type_cache.GetSizeInBytes(type);
+      }
+    }
+    return bytes;
+  }
+
+  void WritePlan(raw_ostream& os, FuncOp func_op, ArrayRef<PlanNode> nodes) {
+    llvm::json::OStream json(os, /*IndentSize=*/2);
+    json.object([&]() {
+      json.attribute("function", func_op.getSymName());
+      json.attributeArray("nodes", [&]() {
+        for (auto [id, node] : llvm::enumerate(nodes)) {
+          json.object([&, id = id, &node = node]() {
+            json.attribute("id", static_cast<int64_t>(id));
+            if (auto fragment_call = dyn_cast<FragmentCallOp>(node.op)) {
+              auto callee = SymbolTable::lookupNearestSymbolFrom<FuncOp>(
+                  fragment_call, fragment_call.getCalleeAttr());
+              json.attribute("kind", "fragment_call");
+              json.attribute("callee", fragment_call.getCallee());
+              json.attribute("mesh", fragment_call.getMeshName());
+              json.attribute("cost",
+                             callee ? GetFragmentCallCost(fragment_call, callee)
+                                    : 0.0);
+              json.attribute("input_bytes",
+                             GetBytes(fragment_call.getOperands()));
+              json.attribute("output_bytes",
+                             GetBytes(fragment_call->getResults()));
+            } else {
+              auto transfer = cast<TransferOp>(node.op);
+              json.attribute("kind", "transfer");
+              json.attribute("mesh", transfer.getType().getMeshName());
+              json.attribute("source_mesh",
+                             transfer.getTensor().getType().getMeshName());
+              json.attribute("bytes", GetBytes(transfer->getResults()));
+            }
+            json.attributeArray("deps", [&]() {
+              for (int64_t dep : node.node_deps) {
+                json.value(dep);
+              }
+            });
+            json.attributeArray("args", [&]() {
+              for (int64_t arg : node.arg_deps) {
+                json.value(arg);
+              }
+            });
+          });
+        }
+      });
+    });
+    os << "\n";
+  }
+
+  void Save(FuncOp func_op, StringRef plan) {
+    sdy::saveJson(
+        dumpDirectory,
+        llvm::formatv("{0}_{1}", fileName, func_op.getSymName()).str(),
+        [&](raw_ostream& os) { os << plan; });
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <memory>
 #include <utility>
 
 #include "llvm/Support/CommandLine.h"
@@ -20,16 +21,32 @@ limitations under the License.
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Pass/PassOptions.h"
 #include "mlir/Pass/PassRegistry.h"
+#include "mlir/Support/LLVM.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "mlir/Transforms/Passes.h"
 #include "shardy/dialect/mpmd/transforms/common/passes.h"
 #include "shardy/dialect/mpmd/transforms/export/passes.h"
+#include "shardy/dialect/mpmd/transforms/export/stage_report.h"
 
 namespace mlir::mpmd {
 
 using ::mlir::func::FuncOp;
 
 void addExportPipeline(OpPassManager& pm, const ExportOptions& options) {
+  // Records the wall time and module size after each stage if requested. Note
+  // that this splits the function passes of consecutive stages, so that each
+  // stage runs on all functions before the next one starts.
+  std::shared_ptr<StageReport> stage_report =
+      options.reportStages ? std::make_shared<StageReport>() : nullptr;
+  auto record_stage = [&](StringRef stage_name) {
+    if (stage_report) {
+      pm.addPass(createRecordStagePass(stage_report, stage_name));
+    }
+  };
+  if (stage_report) {
+    pm.addPass(createRecordStagePass(stage_report));
+  }
+
   // CSE the graph as this will deduplicate any duplicated transfers at the top
   // level of the function and hlo computations nested within fragments.
   // NOTE: a possible issue with applying CSE here is that in the *very
@@ -41,64 +58,87 @@ void addExportPipeline(OpPassManager& pm, const ExportOptions& options) {
   // will deduplicate them and use fwd_fragment, which will cause a memory usage
   // regression. However, this is very unlikely to happen and we can always
   // revisit this if it does.
+  if (options.compactLocations) {
+    pm.addPass(createCompactLocationsPass());
+    record_stage("compact-locations");
+  }
+
   pm.addNestedPass<FuncOp>(createCSEPass());
+  record_stage("cse");
 
   if (options.copyConstantsFromProducerToConsumer) {
     // Apply this pass before DCE as it will leave some operations unused.
-    pm.addNestedPass<FuncOp>(createCopyConstantsPass());
+    pm.addNestedPass<FuncOp>(createCopyConstantsPass(CopyConstantsPassOptions{
+        options.copyConstantsMaxSizeBytes, options.copyScalarBroadcasts}));
+    record_stage("copy-constants");
   }
 
   // Canonicalize the program and dedup operands and results of fragments.
   // TODO: jupvfranco - consider using `enabledPatterns` to apply only fragment
   // canonicalization patterns.
-  pm.addPass(createCanonicalizerPass(
+  // Nested on functions, like the passes around it, so that they all run
+  // back-to-back on each function instead of synchronizing on the module.
+  pm.addNestedPass<FuncOp>(createCanonicalizerPass(
       GreedyRewriteConfig().setRegionSimplificationLevel(
           GreedySimplifyRegionLevel::Disabled)));
+  record_stage("canonicalize");
   pm.addNestedPass<FuncOp>(createFragmentDedupPass());
+  record_stage("fragment-dedup");
 
   // This optimization may affect certain use cases negatively. Thus, it's
   // disabled by default, but users can enable it on a per-module basis.
   if (options.applyMergeTransfers) {
     // Merges transfers that share the same producer and consumer fragments to
     // minimize the number of transfers. This pass does not cleanup unused
-    // fragment results/args, so we should run it before fragment DCE.
+    // fragment results/args, so we should run it before minimizing fragment
+    // signatures.
     // We also need to run it after deduping fragment operands/results in order
     // to reduce the size of the concats (i.e., in case a fragment result is
     // duplicated with both duplicates used by the same consumer).
     // TODO: jupvfranco - consider applying this in the optimize pipeline. We
     // cannot do that yet, because we need to run it after Shardy prop, which
     // happens in between the optimization and export passes.
-    pm.addNestedPass<FuncOp>(createMergeTransfersPass());
-
-    // Run CSE and fragment dedup again after merging transfers as the
-    // -mpmd-merge-transfers pass may have created duplicated concat, slice and
-    // reshape ops.
-    pm.addNestedPass<FuncOp>(createFragmentDedupPass());
-    pm.addNestedPass<FuncOp>(createCSEPass());
+    //
+    // The -mpmd-merge-transfers pass may create duplicated concat, slice and
+    // reshape ops, so it CSEs the fragments it modified. This avoids another
+    // CSE of the whole function, which would revisit every fragment.
+    pm.addNestedPass<FuncOp>(
+        createMergeTransfersPass(MergeTransfersPassOptions{
+            options.mergeTransfersBucketSizeBytes, /*batchTransfers=*/false,
+            /*cseModifiedFragments=*/true}));
+    record_stage("merge-transfers");
   }
 
-  // Remove any dead-code by eliminating unused fragment results and arguments
-  // and by DCE'ing the fragment bodies.
-  pm.addNestedPass<FuncOp>(createFragmentDcePass());
+  // Remove any dead-code by eliminating duplicate and unused fragment results
+  // and arguments and by DCE'ing the fragment bodies. This also dedups the
+  // results that deduplicating ops in the producers, e.g., in
+  // -mpmd-merge-transfers, may have made duplicates.
+  pm.addNestedPass<FuncOp>(createMinimizeFragmentSignaturesPass());
+  record_stage("minimize-fragment-signatures");
 
-  // Must be applied after the last -mpmd-fragment-dedup, as it may add
+  // Must be applied after -mpmd-minimize-fragment-signatures, as it may add
   // duplicated fragment results and after -canonicalize, as it may add
   // identity fragments, which would be canonicalized away.
   pm.addNestedPass<FuncOp>(createUniquifyFunctionInputsOutputsPass());
+  record_stage("uniquify-function-inputs-outputs");
 
   // The fragments created by the pass above maybe slowdown compilation (more
   // fragments to compile) and may cause performance regressions. Thus, we merge
   // them with other fragments.
   pm.addNestedPass<FuncOp>(createMergeInferredFragmentsPass());
+  record_stage("merge-inferred-fragments");
 
   // Mark each fragment with the inputs and outputs which are offloaded to host
   // memory.
   pm.addNestedPass<FuncOp>(createMarkOffloadedInputOutputPass());
+  record_stage("mark-offloaded-input-output");
 
   // Propagate `mhlo.layout_mode` attributes from program inputs to fragments
   // that are consumers of program input, and propagate `mhlo.layout_mode`
   // attributes from program outputs to fragments that are output producers.
-  pm.addNestedPass<FuncOp>(createMarkInputOutputWithLayoutsPass());
+  pm.addNestedPass<FuncOp>(createMarkInputOutputWithLayoutsPass(
+      MarkInputOutputWithLayoutsPassOptions{options.propagateConsumerLayouts}));
+  record_stage("mark-input-output-with-layouts");
 
   // Before we create any dependencies between fragments, delay the
   // execution of inferred fragments to as late as possible, not to create
@@ -106,11 +146,33 @@ void addExportPipeline(OpPassManager& pm, const ExportOptions& options) {
   // execution of user-defined fragments, or even increase memory usage (the
   // produced tensors say live for longer).
   pm.addNestedPass<FuncOp>(createDelayInferredFragmentsPass());
+  record_stage("delay-inferred-fragments");
   // Delay the execution of transfers from CPU to as late as possible to reduce
   // the amount of data in memory.
   pm.addNestedPass<FuncOp>(createDelayTransfersFromCpuPass());
+  record_stage("delay-transfers-from-cpu");
+  if (options.scheduleTransfers) {
+    // Issue the other transfers as early as possible instead, so that they
+    // overlap with the fragments before their consumers.
+    pm.addNestedPass<FuncOp>(createScheduleTransfersPass(
+        ScheduleTransfersPassOptions{options.maxInFlightTransferBytes}));
+    record_stage("schedule-transfers");
+  }
+
+  if (options.offloadActivationsMinGapFragments > 0) {
+    // Offload activations that are live for long between their uses to host.
+    // This must be applied after the transfers are scheduled, as it places
+    // the transfers back to device before their users itself.
+    pm.addNestedPass<FuncOp>(
+        createOffloadActivationsPass(OffloadActivationsPassOptions{
+            options.offloadActivationsMinGapFragments,
+            options.offloadActivationsHbmBudgetBytes,
+            options.offloadActivationsHostBytesPerFragment}));
+    record_stage("offload-activations");
+  }
 
   pm.addNestedPass<FuncOp>(createSinkCreateTokenIntoFragmentsPass());
+  record_stage("sink-create-token-into-fragments");
 
   // This pass marks input and output aliasing or donation. For each fragment op
   // whose input can be aliased with an output, it adds an XLA
@@ -119,42 +181,72 @@ void addExportPipeline(OpPassManager& pm, const ExportOptions& options) {
   // op to fragment calls, the `tf.aliasing_output` and `jax.buffer_donor`
   // attributes will be set for the corresponding argument.
   pm.addNestedPass<FuncOp>(createMarkAliasingAndDonationPass());
+  record_stage("mark-aliasing-and-donation");
 
   // Mark each fragment with how much memory should be left free to account for
   // live buffers produced by other fragments. This should be run after the
   // offloading and aliasing passes.
   pm.addNestedPass<FuncOp>(createMarkFragmentReservedMemoryPass());
+  record_stage("mark-fragment-reserved-memory");
 
-  // Validate no parameter transfers across meshes (warning-only by default).
-  ValidateNoParamTransfersPassOptions paramTransfersOptions;
-  paramTransfersOptions.failOnParamTransfers = options.failOnParamTransfers;
-  paramTransfersOptions.paramPattern = options.paramTransferPattern;
-  pm.addNestedPass<FuncOp>(
-      createValidateNoParamTransfersPass(std::move(paramTransfersOptions)));
+  if (options.markReshardingTransferPlans) {
+    pm.addNestedPass<FuncOp>(createMarkReshardingTransferPlansPass());
+    record_stage("mark-resharding-transfer-plans");
+  }
 
-  // Check that no inferred fragments exist before lowering to fragment calls.
-  ValidateNoInferredFragmentsPassOptions validateInferredOptions;
-  validateInferredOptions.failOnInferredFragments =
+  // Validate no parameter transfers across meshes (warning-only by default),
+  // and that no inferred fragments exist before lowering to fragment calls,
+  // in a single walk.
+  ValidateProgramPassOptions validateFragmentsOptions;
+  validateFragmentsOptions.checkNoParamTransfers = true;
+  validateFragmentsOptions.failOnParamTransfers = options.failOnParamTransfers;
+  validateFragmentsOptions.paramPattern = options.paramTransferPattern;
+  validateFragmentsOptions.checkNoInferredFragments = true;
+  validateFragmentsOptions.failOnInferredFragments =
       options.failOnInferredFragments;
-  pm.addNestedPass<FuncOp>(createValidateNoInferredFragmentsPass(
-      std::move(validateInferredOptions)));
+  pm.addNestedPass<FuncOp>(
+      createValidateProgramPass(std::move(validateFragmentsOptions)));
+  record_stage("validate-fragments");
+
+  if (options.stripDebugInfo) {
+    // The parameter transfer check above matches the locations of transferred
+    // tensors, so locations can only be dropped after it.
+    CompactLocationsPassOptions strip_options;
+    strip_options.stripDebugInfo = true;
+    pm.addPass(createCompactLocationsPass(std::move(strip_options)));
+    record_stage("strip-debug-info");
+  }
 
   // This pass should be applied after all passes that operate on fragment ops.
   LowerToFragmentCallsPassOptions lower_to_fragment_calls_options;
   lower_to_fragment_calls_options.verboseLogging = options.verboseLogging;
+  lower_to_fragment_calls_options.emitFingerprints =
+      options.emitFragmentFingerprints;
   pm.addPass(createLowerToFragmentCallsPass(
-      std::move(lower_to_fragment_calls_options)));
+      std::move(lower_to_fragment_calls_options),
+      options.fragmentModuleCallback));
+  record_stage("lower-to-fragment-calls");
 
-  ValidateNoReshardsPassOptions validateOptions;
-  validateOptions.failOnReshardOnlyFragments =
+  if (options.exportExecutionPlan) {
+    pm.addNestedPass<FuncOp>(
+        createExportExecutionPlanPass(ExportExecutionPlanPassOptions{
+            options.dumpDirectory, "mpmd_execution_plan"}));
+  }
+
+  ValidateProgramPassOptions validateFragmentCallsOptions;
+  validateFragmentCallsOptions.checkNoReshards = true;
+  validateFragmentCallsOptions.failOnReshardOnlyFragments =
       options.failOnReshardOnlyFragments;
+  validateFragmentCallsOptions.checkNoBackwardDeps = true;
+  validateFragmentCallsOptions.failOnBackwardDeps = options.failOnBackwardDeps;
   pm.addNestedPass<FuncOp>(
-      createValidateNoReshardsPass(std::move(validateOptions)));
+      createValidateProgramPass(std::move(validateFragmentCallsOptions)));
+  record_stage("validate-fragment-calls");
 
-  ValidateNoBackwardDepsPassOptions backwardDepsOptions;
-  backwardDepsOptions.failOnBackwardDeps = options.failOnBackwardDeps;
-  pm.addNestedPass<FuncOp>(
-      createValidateNoBackwardDepsPass(std::move(backwardDepsOptions)));
+  if (stage_report) {
+    pm.addPass(createSaveStageReportPass(stage_report, options.dumpDirectory,
+                                         "mpmd_export_stages"));
+  }
 }
 
 namespace {
@@ -190,6 +282,31 @@ struct ExportPipelineOptions
           "Regex pattern to match against the location info of transferred "
           "tensors."),
       llvm::cl::init("params['transformer")};
+  Option<bool> reportStages{
+      *this, "report-stages",
+      llvm::cl::desc("Whether to report the wall time and the module size of "
+                     "each stage of the pipeline."),
+      llvm::cl::init(false)};
+  Option<bool> exportExecutionPlan{
+      *this, "export-execution-plan",
+      llvm::cl::desc("Whether to save the dependency graph of the fragment "
+                     "calls and transfers of each function."),
+      llvm::cl::init(false)};
+  Option<bool> compactLocations{
+      *this, "compact-locations",
+      llvm::cl::desc("Whether to compact the locations and origins of all ops "
+                     "before exporting."),
+      llvm::cl::init(false)};
+  Option<bool> stripDebugInfo{
+      *this, "strip-debug-info",
+      llvm::cl::desc("Whether to drop all locations and sharding debug "
+                     "attributes before lowering to fragment calls."),
+      llvm::cl::init(false)};
+  Option<std::string> dumpDirectory{
+      *this, "dump-directory",
+      llvm::cl::desc("Directory to save the stage report and the execution "
+                     "plan to. If empty, prints them to stderr."),
+      llvm::cl::init("")};
 };
 
 }  // namespace
@@ -207,6 +324,11 @@ void registerExportPipeline() {
             pipelineOptions.failOnInferredFragments;
         options.failOnParamTransfers = pipelineOptions.failOnParamTransfers;
         options.paramTransferPattern = pipelineOptions.paramTransferPattern;
+        options.reportStages = pipelineOptions.reportStages;
+        options.exportExecutionPlan = pipelineOptions.exportExecutionPlan;
+        options.compactLocations = pipelineOptions.compactLocations;
+        options.stripDebugInfo = pipelineOptions.stripDebugInfo;
+        options.dumpDirectory = pipelineOptions.dumpDirectory;
         addExportPipeline(pm, options);
       });
 }
@@ -15,26 +15,37 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Block.h"
+#include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/OwningOpRef.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Value.h"
+#include "mlir/Pass/Pass.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
@@ -148,6 +159,26 @@ struct FragmentBodyEquivalenceSameMeshGroupingInfo
   }
 };
 
+// Returns the fingerprint of the fragment function `func_op`: the hex SHA-256
+// of its generic form without locations, so it covers the operand wiring and
+// the shardings of the body and of the arguments and results.
+//
+// Unlike `FragmentBodyEquivalenceBaseInfo::getHashValue`, which hashes
+// attribute storage pointers with a per-process seed, this is stable across
+// processes. The symbol name is excluded, as it depends on the position of
+// the fragment in the module and on the name of the module.
+std::string ComputeFingerprint(FuncOp func_op) {
+  OwningOpRef<FuncOp> anonymous_func = func_op.clone();
+  anonymous_func->setSymName("fragment");
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  anonymous_func->print(
+      os, OpPrintingFlags().printGenericOpForm().enableDebugInfo(false));
+  llvm::SHA256 hasher;
+  hasher.update(str);
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
 // Auxiliary data structure for fragment grouping.
 struct FragmentGroupInfo {
   std::optional<int64_t> hbm_bytes;
@@ -222,71 +253,131 @@ std::string PrettyPrintUserOrigin(ArrayRef<Attribute> origins, bool all_forward)
 // unique identifier, and an updated hbm reserved bytes number. Marks each
 // fragment with its group id, name, and hbm bytes id.
 //
+// Hashing and comparing fragment bodies walks them, which dominates for
+// programs with many fragments, so it's done in parallel. Group ids are given
+// in program order of the first fragment of each group, so that the symbol
+// names don't depend on the threading.
+//
 // Returns all fragments in the module.
 template <typename FragmentEquivalenceInfo>
 std::vector<FragmentOp> GroupFragmentsAndMarkWithGroupName(
     ModuleOp module_op, IRRewriter& rewriter, bool is_all_forward) {
-  DenseMap<FragmentOp, FragmentGroupInfo, FragmentEquivalenceInfo> fragment_map;
-
-  // Step 1: Group all fragments by body and mesh shape equivalence, and give
-  // each group a unique identifier, and an updated hbm reserved bytes number.
-  int64_t group_id = 0;
-  std::vector<FragmentOp> all_fragments;
+  MLIRContext* ctx = module_op.getContext();
   // Walk the module, collecting fragments in program order, as we rely on that
   //  below to log the schedule.
-  module_op.walk([&](FragmentOp fragment) {
-    all_fragments.push_back(fragment);
+  std::vector<FragmentOp> all_fragments;
+  module_op.walk(
+      [&](FragmentOp fragment) { all_fragments.push_back(fragment); });
+
+  // Step 1: Group all fragments by body and mesh shape equivalence.
+  //
+  // Step 1a: Hash the fragments in parallel.
+  std::vector<unsigned> fragment_hashes(all_fragments.size());
+  parallelFor(ctx, 0, all_fragments.size(), [&](size_t i) {
+    fragment_hashes[i] =
+        FragmentEquivalenceInfo::getHashValue(all_fragments[i]);
+  });
+
+  // Step 1b: Bucket the fragments by hash, in program order.
+  llvm::MapVector<unsigned, SmallVector<int64_t>> hash_to_fragment_indices;
+  for (auto [index, hash] : llvm::enumerate(fragment_hashes)) {
+    hash_to_fragment_indices[hash].push_back(index);
+  }
 
-    std::optional<int64_t> hbm_reserved_bytes =
-        GetIntegerAttr(fragment, kReservedHbmBytes);
+  // Step 1c: Split each bucket into equivalence classes in parallel. Each
+  // fragment is mapped to the first fragment in the bucket that it's
+  // equivalent to, as with a lookup in a DenseMap.
+  std::vector<int64_t> fragment_representatives(all_fragments.size());
+  auto buckets = llvm::to_vector(
+      llvm::make_second_range(hash_to_fragment_indices.takeVector()));
+  parallelForEach(ctx, buckets, [&](ArrayRef<int64_t> bucket) {
+    SmallVector<int64_t> representatives;
+    for (int64_t index : bucket) {
+      auto representative = llvm::find_if(representatives, [&](int64_t other) {
+        return FragmentEquivalenceInfo::isEqual(all_fragments[other],
+                                                all_fragments[index]);
+      });
+      if (representative == representatives.end()) {
+        representatives.push_back(index);
+        fragment_representatives[index] = index;
+      } else {
+        fragment_representatives[index] = *representative;
+      }
+    }
+  });
 
-    auto [it, inserted] =
-        fragment_map.try_emplace(fragment, FragmentGroupInfo{});
-    FragmentGroupInfo& fragment_group = it->getSecond();
+  // Step 2: Give each group a unique identifier, in program order, and an
+  // updated hbm reserved bytes number, and collect its call sites.
+  DenseMap<int64_t, int64_t> representative_to_group_id;
+  std::vector<FragmentGroupInfo> fragment_groups;
+  std::vector<int64_t> fragment_group_ids;
+  fragment_group_ids.reserve(all_fragments.size());
+  // Many fragments share the same origins and stage id, e.g., the fragments of
+  // each microbatch, so their names are only computed once.
+  DenseMap<std::pair<ArrayAttr, IntegerAttr>, std::string> metadata_to_name;
+  for (auto [fragment, representative] :
+       llvm::zip_equal(all_fragments, fragment_representatives)) {
+    auto [it, inserted] = representative_to_group_id.try_emplace(
+        representative, fragment_groups.size());
     if (inserted) {
-      fragment_group.group_id = group_id++;
+      fragment_groups.push_back(FragmentGroupInfo{});
+      fragment_groups.back().group_id = it->getSecond();
     }
+    fragment_group_ids.push_back(it->getSecond());
+    FragmentGroupInfo& fragment_group = fragment_groups[it->getSecond()];
     // TODO(dvytin): Experiment with different policies.
     // std::nullopt < any int64_t, hence std::max works with std::nullopt.
-    fragment_group.hbm_bytes =
-        std::max(fragment_group.hbm_bytes, hbm_reserved_bytes);
-
-    std::string name =
-        GetFullNameFromMetadata(fragment.getOrigin().getValue(),
-                                fragment.getStageId(), is_all_forward);
+    fragment_group.hbm_bytes = std::max(
+        fragment_group.hbm_bytes, GetIntegerAttr(fragment, kReservedHbmBytes));
+
+    auto [name_it, name_inserted] = metadata_to_name.try_emplace(
+        std::make_pair(fragment.getOrigin(), fragment.getStageIdAttr()));
+    if (name_inserted) {
+      name_it->second =
+          GetFullNameFromMetadata(fragment.getOrigin().getValue(),
+                                  fragment.getStageId(), is_all_forward);
+    }
     std::optional<uint32_t> call_counter = TryToFindCallCounter(fragment);
     fragment_group.mesh_call_sites[fragment.getMeshName()].emplace_back(
-        std::move(name), call_counter);
-  });
+        name_it->second, call_counter);
+  }
 
-  // Step 2: Mark all fragments with their calculated group ids, names, and
-  // hbm bytes.
-  for (auto fragment : all_fragments) {
-    const auto& [hbm_bytes, group_id, call_sites] = fragment_map[fragment];
-    if (hbm_bytes.has_value()) {
-      SetIntegerAttr(fragment, kReservedHbmBytes, *hbm_bytes, rewriter);
-    }
-    SetIntegerAttr(fragment, kGroupId, group_id, rewriter);
+  // Step 3: Name each group once, as the name summarizes all its call sites.
+  // Find function name in the module.
+  StringRef module_name = GetModuleName(module_op);
+  // Drop the jit_ prefix if present.
+  module_name = DropJitPrefix(module_name);
+  std::vector<StringAttr> group_names(fragment_groups.size());
+  parallelFor(ctx, 0, fragment_groups.size(), [&](size_t i) {
+    const FragmentGroupInfo& fragment_group = fragment_groups[i];
     std::string group_name;
-
     llvm::raw_string_ostream stream(group_name);
-    std::string fragment_name = GetCallSitesSummaryName(call_sites);
+    std::string fragment_name =
+        GetCallSitesSummaryName(fragment_group.mesh_call_sites);
     // Append a unique id. We do this first to guarantee it isn't affected by
     // truncation.
-    stream << kFragmentNamePrefix << group_id << "_";
+    stream << kFragmentNamePrefix << fragment_group.group_id << "_";
 
     // Append the fragment name.
     stream << fragment_name;
 
     // Truncate the group name to something short enough to be easily readable
     group_name = Truncate(group_name, 200);
-    // Find function name in the module.
-    StringRef module_name = GetModuleName(module_op);
-    // Drop the jit_ prefix if present.
-    module_name = DropJitPrefix(module_name);
+    group_names[i] = StringAttr::get(ctx, group_name + "." + module_name);
+  });
 
-    fragment->setAttr(kGroupName,
-                      rewriter.getStringAttr(group_name + "." + module_name));
+  // Step 4: Mark all fragments with their calculated group ids, names, and
+  // hbm bytes.
+  for (auto [fragment, fragment_group_id] :
+       llvm::zip_equal(all_fragments, fragment_group_ids)) {
+    const FragmentGroupInfo& fragment_group =
+        fragment_groups[fragment_group_id];
+    if (fragment_group.hbm_bytes.has_value()) {
+      SetIntegerAttr(fragment, kReservedHbmBytes, *fragment_group.hbm_bytes,
+                     rewriter);
+    }
+    SetIntegerAttr(fragment, kGroupId, fragment_group.group_id, rewriter);
+    fragment->setAttr(kGroupName, group_names[fragment_group_id]);
   }
 
   return all_fragments;
@@ -296,6 +387,13 @@ class LowerToFragmentCallsPass
     : public impl::LowerToFragmentCallsPassBase<LowerToFragmentCallsPass> {
   using LowerToFragmentCallsPassBase::LowerToFragmentCallsPassBase;
 
+ public:
+  LowerToFragmentCallsPass() = default;
+  LowerToFragmentCallsPass(LowerToFragmentCallsPassOptions options,
+                           FragmentModuleCallback fragment_module_callback)
+      : LowerToFragmentCallsPassBase(std::move(options)),
+        fragment_module_callback_(std::move(fragment_module_callback)) {}
+
  protected:
   void runOnOperation() final {
     ModuleOp module_op = getOperation();
@@ -308,7 +406,7 @@ class LowerToFragmentCallsPass
         FragmentBodyEquivalenceSameMeshGroupingInfo>(module_op, rewriter,
                                                      is_all_forward);
 
-    // Step 3: Log the fragment naming per mesh, for debugging purposes.
+    // Step 5: Log the fragment naming per mesh, for debugging purposes.
     if (auto func = dyn_cast_or_null<FuncOp>(module_op.lookupSymbol("main"))) {
       ArrayRef<mpmd::NamedMeshAttr> meshes = mpmd::GetTopologyMeshes(func);
       for (mpmd::NamedMeshAttr mesh : meshes) {
@@ -345,11 +443,12 @@ class LowerToFragmentCallsPass
       }
     }
 
-    // Step 4: For each fragment, extract a function if not already done.
+    // Step 6: For each fragment, extract a function if not already done.
     SymbolTableCollection symbol_table_collection;
     SymbolTable& symbol_table =
         symbol_table_collection.getSymbolTable(module_op);
 
+    std::vector<FuncOp> fragment_funcs;
     for (FragmentOp fragment : all_fragments) {
       // We use the marked attributes instead of looking up in fragment_map
       // because we will be doing rewriter replacements.
@@ -443,6 +542,17 @@ class LowerToFragmentCallsPass
         });
 
         symbol_table.insert(func_op);
+        fragment_funcs.push_back(func_op);
+        if (fragment_module_callback_) {
+          // The function is final, so it can be compiled while the remaining
+          // fragments are lowered.
+          if (emitFingerprints) {
+            func_op->setAttr(kFragmentFingerprintAttr,
+                             StringAttr::get(&ctx, ComputeFingerprint(func_op)));
+          }
+          fragment_module_callback_(
+              CreateFragmentModule(module_op, func_op));
+        }
       }
       rewriter.setInsertionPoint(fragment);
       bool is_remat = mpmd::IsRemat(fragment);
@@ -455,8 +565,54 @@ class LowerToFragmentCallsPass
         mpmd::MarkAsRemat(fragment_call_op, rewriter);
       }
     }
+
+    // Step 7: Fingerprint the fragment functions in parallel, as each one
+    // prints its function, unless they were fingerprinted when streamed.
+    if (emitFingerprints && !fragment_module_callback_) {
+      parallelForEach(&ctx, fragment_funcs, [&](FuncOp func_op) {
+        func_op->setAttr(kFragmentFingerprintAttr,
+                         StringAttr::get(&ctx, ComputeFingerprint(func_op)));
+      });
+    }
+  }
+
+ private:
+  // Returns a standalone module with a copy of `func_op`, named after it, and
+  // of the meshes of `module_op` it references, e.g., in its shardings. The
+  // attributes of `module_op` are copied too.
+  OwningOpRef<ModuleOp> CreateFragmentModule(ModuleOp module_op,
+                                             FuncOp func_op) {
+    OwningOpRef<ModuleOp> fragment_module =
+        ModuleOp::create(func_op.getLoc(), func_op.getSymName());
+    for (NamedAttribute attr : module_op->getDiscardableAttrs()) {
+      (*fragment_module)->setAttr(attr.getName(), attr.getValue());
+    }
+    OpBuilder builder = OpBuilder::atBlockEnd(fragment_module->getBody());
+    if (std::optional<SymbolTable::UseRange> uses =
+            SymbolTable::getSymbolUses(func_op)) {
+      llvm::SmallDenseSet<StringRef> cloned_meshes;
+      for (const SymbolTable::SymbolUse& use : *uses) {
+        StringRef name = use.getSymbolRef().getRootReference();
+        if (auto mesh_op = module_op.lookupSymbol<sdy::MeshOp>(name);
+            mesh_op && cloned_meshes.insert(name).second) {
+          builder.clone(*mesh_op);
+        }
+      }
+    }
+    builder.clone(*func_op);
+    return fragment_module;
   }
+
+  FragmentModuleCallback fragment_module_callback_;
 };
 
 }  // namespace
+
+std::unique_ptr<Pass> createLowerToFragmentCallsPass(
+    LowerToFragmentCallsPassOptions options,
+    FragmentModuleCallback fragment_module_callback) {
+  return std::make_unique<LowerToFragmentCallsPass>(
+      std::move(options), std::move(fragment_module_callback));
+}
+
 }  // namespace mlir::mpmd
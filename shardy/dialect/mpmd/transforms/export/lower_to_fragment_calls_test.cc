@@ -0,0 +1,114 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/export/passes.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using ::mlir::func::FuncOp;
+using ::testing::ElementsAre;
+using ::testing::SizeIs;
+
+namespace mlir::mpmd {
+namespace {
+
+const char kProgram[] = R"mlir(
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+module attributes {mhlo.num_partitions = 2 : i32} {
+  func.func @main(%arg0: !mesh_1_tensor) -> !mesh_2_tensor attributes {
+      "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+    %0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+      %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+      mpmd.return %3 : tensor<4x8xf32>
+    } : (!mesh_1_tensor) -> !mesh_1_tensor
+    // Identical to the fragment above, so it calls the same function.
+    %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) (%arg1: tensor<4x8xf32>) {
+      %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+      mpmd.return %3 : tensor<4x8xf32>
+    } : (!mesh_1_tensor) -> !mesh_1_tensor
+    %2 = mpmd.transfer %1 : (!mesh_1_tensor) -> !mesh_2_tensor
+    %4 = mpmd.fragment<mesh="m2", origin=["f2"]> (%2) (%arg1: tensor<4x8xf32>) {
+      %3 = stablehlo.multiply %arg1, %arg1 : tensor<4x8xf32>
+      mpmd.return %3 : tensor<4x8xf32>
+    } : (!mesh_2_tensor) -> !mesh_2_tensor
+    func.return %4 : !mesh_2_tensor
+  }
+}
+)mlir";
+
+TEST(LowerToFragmentCallsPass, StreamsEachFragmentFunctionOnce) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module = parseSourceString<ModuleOp>(kProgram, &context);
+  ASSERT_TRUE(module);
+
+  std::vector<OwningOpRef<ModuleOp>> fragment_modules;
+  PassManager pm(&context);
+  pm.addPass(createLowerToFragmentCallsPass(
+      LowerToFragmentCallsPassOptions{},
+      [&](OwningOpRef<ModuleOp> fragment_module) {
+        fragment_modules.push_back(std::move(fragment_module));
+      }));
+  ASSERT_TRUE(succeeded(pm.run(*module)));
+
+  // The streamed functions are the callees of the lowered program, in order.
+  std::vector<std::string> callees;
+  GetMainFunction(*module).walk([&](FragmentCallOp fragment_call) {
+    if (!llvm::is_contained(callees, fragment_call.getCallee().str())) {
+      callees.push_back(fragment_call.getCallee().str());
+    }
+  });
+  ASSERT_THAT(callees, SizeIs(2));
+  ASSERT_THAT(fragment_modules, SizeIs(2));
+  for (auto [callee, fragment_module] :
+       llvm::zip_equal(callees, fragment_modules)) {
+    EXPECT_EQ(fragment_module->getSymName(), StringRef(callee));
+    auto num_partitions =
+        (*fragment_module)->getAttrOfType<IntegerAttr>("mhlo.num_partitions");
+    ASSERT_TRUE(num_partitions);
+    EXPECT_EQ(num_partitions.getInt(), 2);
+    auto funcs = llvm::to_vector(fragment_module->getOps<FuncOp>());
+    ASSERT_THAT(funcs, SizeIs(1));
+    EXPECT_EQ(funcs.front().getSymName(), callee);
+    EXPECT_TRUE(funcs.front()->hasAttr(kMeshShapeAttr));
+    // The lowered module keeps its own copy of the function.
+    EXPECT_TRUE(module->lookupSymbol<FuncOp>(callee));
+  }
+  std::vector<std::string> first_module_ops;
+  for (Operation& op : fragment_modules.front()->getOps()) {
+    first_module_ops.push_back(op.getName().getStringRef().str());
+  }
+  EXPECT_THAT(first_module_ops, ElementsAre("func.func"));
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
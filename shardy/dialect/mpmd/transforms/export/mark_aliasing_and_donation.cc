@@ -119,6 +119,12 @@ std::optional<unsigned int> FindPreferredOutput(
 // usage is the given operation, `aliased_block_args` a set of block
 // arguments the user has marked to be aliased, and `donated_block_args` a set
 // of block arguments the user has marked to be donated.
+//
+// Block arguments the user has marked to be aliased are aliased with their
+// preferred output first, so that other inputs don't take it. Then each of the
+// remaining inputs is aliased with the first free output it can be aliased
+// with, or donated if there is none. As inputs and outputs can be aliased iff
+// they have the same type and layout, this aliases as many inputs as possible.
 std::pair<DenseSet<unsigned int>, DenseMap<unsigned int, unsigned int>>
 ConstructDonationSetAndIOAliasingMap(
     FragmentOp op, ArrayRef<unsigned int> donatable_input_indices,
@@ -132,6 +138,8 @@ ConstructDonationSetAndIOAliasingMap(
   // at most once.
   DenseSet<unsigned int> aliased_outputs;
 
+  // The inputs to alias with any output, or to donate if there is none.
+  SmallVector<unsigned int> inputs_to_alias;
   for (unsigned int input_index : donatable_input_indices) {
     // Don't donate values which are on host.
     if (IsArgOnHost(op, input_index)) {
@@ -155,34 +163,29 @@ ConstructDonationSetAndIOAliasingMap(
                  it != aliased_block_args.end()) {
         // Try to find the preferred fragment output by translating the
         // user's func-level annotation to a fragment-level result index.
-        std::optional<unsigned int> aliased_output_idx;
         if (auto preferred = FindPreferredOutput(main_func, it->second, op);
             preferred && CanAlias(op, input_index, *preferred,
                                   aliased_outputs)) {
-          aliased_output_idx = preferred;
-        }
-        // Fall back to greedy scan if preferred output didn't work.
-        if (!aliased_output_idx) {
-          aliased_output_idx =
-              FindAliasingOutput(op, input_index, aliased_outputs);
-        }
-        if (aliased_output_idx) {
-          input_output_aliasing_map[input_index] = *aliased_output_idx;
-          SDY_CHECK(aliased_outputs.insert(*aliased_output_idx).second);
+          input_output_aliasing_map[input_index] = *preferred;
+          SDY_CHECK(aliased_outputs.insert(*preferred).second);
         } else {
-          // Donate the input if no aliasing output was found.
-          donated_input_indices_set.insert(input_index);
+          // Fall back to greedy scan if preferred output didn't work.
+          inputs_to_alias.push_back(input_index);
         }
       }
     } else {
-      // Try to find an alias. If no alias is found, then donate the input.
-      if (auto aliased_output_idx =
-              FindAliasingOutput(op, input_index, aliased_outputs)) {
-        input_output_aliasing_map[input_index] = *aliased_output_idx;
-        SDY_CHECK(aliased_outputs.insert(*aliased_output_idx).second);
-      } else {
-        donated_input_indices_set.insert(input_index);
-      }
+      inputs_to_alias.push_back(input_index);
+    }
+  }
+
+  for (unsigned int input_index : inputs_to_alias) {
+    // Try to find an alias. If no alias is found, then donate the input.
+    if (auto aliased_output_idx =
+            FindAliasingOutput(op, input_index, aliased_outputs)) {
+      input_output_aliasing_map[input_index] = *aliased_output_idx;
+      SDY_CHECK(aliased_outputs.insert(*aliased_output_idx).second);
+    } else {
+      donated_input_indices_set.insert(input_index);
     }
   }
   return std::make_pair(donated_input_indices_set, input_output_aliasing_map);
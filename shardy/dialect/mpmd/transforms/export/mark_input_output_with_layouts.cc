@@ -13,8 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
 #include <optional>
 
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
@@ -144,15 +146,46 @@ std::optional<CommonLayoutResult> extractCommonLayoutFromUsers(
                             hasTransferOpUse, commonLayout};
 }
 
+// Returns the layout preferred by most of the fragments that use `value`, i.e.,
+// the non-AUTO layout already set on the most fragment operands that `value`
+// is passed to, or nullptr if none of them has a layout. Ties are broken by
+// program order. Sets `numPreferringUses` to the number of operands that
+// prefer the returned layout.
+StringAttr getLayoutPreferredByConsumers(Value value, int& numPreferringUses) {
+  llvm::MapVector<StringAttr, int> numUsesPerLayout;
+  for (OpOperand& use : value.getUses()) {
+    if (!isa<FragmentOp>(use.getOwner())) {
+      continue;
+    }
+    auto layout = dyn_cast_or_null<StringAttr>(GetArgAttr(
+        use.getOwner(), use.getOperandNumber(), kLayoutModeAttr));
+    if (layout && !isAutoLayout(layout)) {
+      numUsesPerLayout[layout]++;
+    }
+  }
+  StringAttr preferredLayout;
+  numPreferringUses = 0;
+  for (auto [layout, numUses] : numUsesPerLayout) {
+    if (numUses > numPreferringUses) {
+      preferredLayout = layout;
+      numPreferringUses = numUses;
+    }
+  }
+  return preferredLayout;
+}
+
 // Choose layout for FragmentOp result based on its uses {TransferOp,
 // ReturnOp, another FragmentOp} and then propagate to all these uses.
 //
 // *Important*: If the chosen layout is AUTO, but there are uses in any
 // fragment, enforce DEFAULT layout, since we don't support cross-fragment
-// layout propagation.
+// layout propagation. If `propagateConsumerLayouts`, the layout preferred by
+// the consuming fragments is enforced instead, if any, and
+// `numRelayoutsAvoided` is incremented by the number of consuming fragment
+// operands that keep their layout.
 bool propagateFragmentResultsToEverything(
-    OpResult fragRes, FuncOp& programFunc,
-    SmallVector<Attribute>& fragResAttrs) {
+    OpResult fragRes, FuncOp& programFunc, SmallVector<Attribute>& fragResAttrs,
+    bool propagateConsumerLayouts, int64_t& numRelayoutsAvoided) {
   if (fragRes.use_empty()) {
     // the fragment result layouts are not set by default - meaning they are
     // auto
@@ -184,8 +217,22 @@ bool propagateFragmentResultsToEverything(
     chosenLayout = defaultLayout;
   } else if (isAutoLayout(chosenLayout) &&
              (layoutExtractionResult->numUsesInFragments > 0)) {
-    chosenLayout =
-        StringAttr::get(programFunc.getContext(), kLayoutModeDefault);
+    int numPreferringUses = 0;
+    StringAttr preferredLayout =
+        propagateConsumerLayouts
+            ? getLayoutPreferredByConsumers(fragRes, numPreferringUses)
+            : nullptr;
+    if (preferredLayout) {
+      // The consumers that prefer another layout need a relayout anyway, as
+      // they would with the DEFAULT layout.
+      chosenLayout = preferredLayout;
+      if (!isDefaultLayout(preferredLayout)) {
+        numRelayoutsAvoided += numPreferringUses;
+      }
+    } else {
+      chosenLayout =
+          StringAttr::get(programFunc.getContext(), kLayoutModeDefault);
+    }
   }
   setFragmentLayout(fragResAttrs, fragRes.getResultNumber(), chosenLayout);
   setLayoutForUsers(fragRes, chosenLayout, programFunc);
@@ -265,17 +312,20 @@ class MarkInputOutputWithLayoutsPass
         return;
       }
     }
+    int64_t numRelayoutsAvoidedInFunc = 0;
     for (FragmentOp frag : func.getOps<FragmentOp>()) {
       SmallVector<Attribute> fragResAttrs = GetResAttrsOrCreateDefault(frag);
       for (OpResult fragRes : frag->getOpResults()) {
-        if (!propagateFragmentResultsToEverything(fragRes, func,
-                                                  fragResAttrs)) {
+        if (!propagateFragmentResultsToEverything(
+                fragRes, func, fragResAttrs, propagateConsumerLayouts,
+                numRelayoutsAvoidedInFunc)) {
           signalPassFailure();
           return;
         }
       }
       SetResAttrs(frag, fragResAttrs);
     }
+    numRelayoutsAvoided += numRelayoutsAvoidedInFunc;
   }
 };
 
@@ -0,0 +1,69 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/transfer_plan.h"
+#include "shardy/dialect/mpmd/transforms/export/utils.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_MARKRESHARDINGTRANSFERPLANSPASS
+#include "shardy/dialect/mpmd/transforms/export/passes.h.inc"
+
+namespace {
+
+class MarkReshardingTransferPlansPass
+    : public impl::MarkReshardingTransferPlansPassBase<
+          MarkReshardingTransferPlansPass> {
+  using MarkReshardingTransferPlansPassBase::
+      MarkReshardingTransferPlansPassBase;
+
+ protected:
+  void runOnFunc(func::FuncOp func_op) override {
+    if (!IsMpmdFunction(func_op)) {
+      return;
+    }
+
+    for (TransferOp transfer : func_op.getOps<TransferOp>()) {
+      MeshTensorType src_type = transfer.getTensor().getType();
+      MeshTensorType dst_type = transfer.getType();
+      // Transfers to or from host go through the host, not device to device.
+      if (src_type.isOnHost() || dst_type.isOnHost() ||
+          sdy::isEquivalent(src_type.getSharding(), dst_type.getSharding())) {
+        continue;
+      }
+      std::vector<TransferSlice> plan = ComputeTransferPlan(
+          src_type.getRankedTensorType(), src_type.getSharding(),
+          GetMeshOrFail(transfer, src_type.getMeshName()),
+          dst_type.getSharding(),
+          GetMeshOrFail(transfer, dst_type.getMeshName()));
+      transfer->setAttr(kTransferPlanAttr,
+                        GetTransferPlanAttr(&getContext(), plan));
+      ++numReshardingTransfers;
+    }
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
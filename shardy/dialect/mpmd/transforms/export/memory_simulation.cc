@@ -0,0 +1,260 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/export/memory_simulation.h"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/logging.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/fragment_arg_res_attrs.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/export/utils.h"
+
+namespace mlir::mpmd {
+
+namespace {
+
+StringRef GetMeshName(Value value) {
+  return cast<MeshTensorType>(value.getType()).getMeshName();
+}
+
+}  // namespace
+
+MeshMemorySimulation::MeshMemorySimulation(func::FuncOp func_op,
+                                           int64_t alignment_bytes,
+                                           LocalTensorTypeCache* type_cache)
+    : func_op_(func_op),
+      alignment_bytes_(alignment_bytes),
+      type_cache_(type_cache),
+      liveness_(func_op) {
+  SDY_CHECK_GT(alignment_bytes, 0);
+  if (!type_cache_) {
+    owned_type_cache_ = std::make_unique<LocalTensorTypeCache>(func_op);
+    type_cache_ = owned_type_cache_.get();
+  }
+  for (NamedMeshAttr mesh : GetTopologyMeshes(func_op)) {
+    peaks_[mesh.getName()] = MeshPeak();
+  }
+  for (auto [position, op] : llvm::enumerate(func_op.getOps())) {
+    op_positions_[&op] = position;
+  }
+  // Find the peaks first, and then what is live at them, rather than copying
+  // the live values every time the memory usage of a mesh increases.
+  Simulate(/*peaks_known=*/false);
+  Simulate(/*peaks_known=*/true);
+}
+
+int64_t MeshMemorySimulation::GetSizeInBytes(Value value) const {
+  return llvm::alignTo(
+      type_cache_->GetSizeInBytes(cast<MeshTensorType>(value.getType())),
+      alignment_bytes_);
+}
+
+int64_t MeshMemorySimulation::GetLiveBytesBefore(Operation* op,
+                                                 StringRef mesh_name) const {
+  auto op_it = live_bytes_before_.find(op);
+  SDY_CHECK(op_it != live_bytes_before_.end())
+      << "Op isn't in the simulated function.";
+  auto mesh_it = op_it->second.find(mesh_name);
+  SDY_CHECK(mesh_it != op_it->second.end())
+      << "Required mesh_name missing: " << std::string_view(mesh_name);
+  return mesh_it->second;
+}
+
+const MeshMemorySimulation::MeshPeak& MeshMemorySimulation::GetPeak(
+    StringRef mesh_name) const {
+  auto it = peaks_.find(mesh_name);
+  SDY_CHECK(it != peaks_.end())
+      << "Required mesh_name missing: " << std::string_view(mesh_name);
+  return it->second;
+}
+
+void MeshMemorySimulation::Print(llvm::raw_ostream& os) const {
+  for (const auto& [mesh_name, peak] : peaks_) {
+    os << "mesh \"" << mesh_name << "\": peak of " << peak.bytes
+       << " bytes at ";
+    if (peak.op) {
+      peak.op->print(os, OpPrintingFlags().skipRegions().useLocalScope());
+    } else {
+      os << "function entry";
+    }
+    os << "\n";
+    for (Value value : peak.live_values) {
+      os << "  " << GetSizeInBytes(value) << " bytes: ";
+      value.printAsOperand(os, OpPrintingFlags());
+      os << " : " << value.getType() << "\n";
+    }
+  }
+}
+
+void MeshMemorySimulation::Simulate(bool peaks_known) {
+  DenseMap<StringRef, int64_t> live_bytes;
+  for (const auto& [mesh_name, peak] : peaks_) {
+    live_bytes[mesh_name] = 0;
+  }
+  DenseSet<Value> live_values;
+  auto add_live_value = [&](Value value) {
+    auto it = live_bytes.find(GetMeshName(value));
+    SDY_CHECK(it != live_bytes.end())
+        << "Required mesh_name missing: "
+        << std::string_view(GetMeshName(value));
+    it->second += GetSizeInBytes(value);
+    live_values.insert(value);
+  };
+  // Updates the peak of `mesh_name` given that `bytes` are live on it while
+  // `op` executes, which allocates `allocated_values`.
+  auto update_peak = [&](StringRef mesh_name, int64_t bytes, Operation* op,
+                         ArrayRef<Value> allocated_values) {
+    MeshPeak& peak = peaks_.find(mesh_name)->second;
+    if (!peaks_known) {
+      if (bytes > peak.bytes) {
+        peak.bytes = bytes;
+        peak.op = op;
+      }
+      return;
+    }
+    if (op != peak.op || bytes != peak.bytes) {
+      return;
+    }
+    peak.live_values = GetLiveValuesOnMesh(live_values, mesh_name);
+    for (Value value : allocated_values) {
+      if (GetMeshName(value) == mesh_name) {
+        peak.live_values.push_back(value);
+      }
+    }
+  };
+
+  for (BlockArgument arg : func_op_.getArguments()) {
+    // Do not add live values for args that are on the host or that are
+    // donated and not used.
+    if (TakesDeviceMemory(arg) &&
+        (!IsFreedAfterLastUse(arg) || !arg.use_empty())) {
+      add_live_value(arg);
+    }
+  }
+  for (const auto& [mesh_name, bytes] : live_bytes) {
+    update_peak(mesh_name, bytes, /*op=*/nullptr, /*allocated_values=*/{});
+  }
+
+  for (Operation& op : func_op_.getOps()) {
+    live_bytes_before_[&op] = live_bytes;
+
+    // Results aliased with an operand reuse its buffer.
+    DenseSet<int64_t> aliased_results;
+    if (isa<FragmentOp>(op)) {
+      for (int index = 0; index < op.getNumOperands(); ++index) {
+        if (auto output_index = dyn_cast_or_null<IntegerAttr>(
+                GetArgAttr(&op, index, kAliasingAttrName))) {
+          aliased_results.insert(output_index.getInt());
+        }
+      }
+    }
+    SmallVector<Value> allocated_values;
+    DenseMap<StringRef, int64_t> allocated_bytes;
+    for (OpResult result : op.getResults()) {
+      if (TakesDeviceMemory(result) &&
+          !aliased_results.contains(result.getResultNumber())) {
+        allocated_values.push_back(result);
+        allocated_bytes[GetMeshName(result)] += GetSizeInBytes(result);
+      }
+    }
+    for (const auto& [mesh_name, bytes] : allocated_bytes) {
+      update_peak(mesh_name, live_bytes[mesh_name] + bytes, &op,
+                  allocated_values);
+    }
+
+    // Remove any of the operands which are the last use.
+    for (Value operand : op.getOperands()) {
+      if (live_values.contains(operand) &&
+          liveness_.isDeadAfter(operand, &op) &&
+          IsFreedAfterLastUse(operand)) {
+        live_bytes[GetMeshName(operand)] -= GetSizeInBytes(operand);
+        live_values.erase(operand);
+      }
+    }
+    // Add sizes of the results which are now live.
+    for (OpResult result : op.getResults()) {
+      if (TakesDeviceMemory(result) && !result.use_empty()) {
+        add_live_value(result);
+      }
+    }
+  }
+}
+
+bool MeshMemorySimulation::TakesDeviceMemory(Value value) const {
+  auto type = dyn_cast<MeshTensorType>(value.getType());
+  if (!type) {
+    return false;
+  }
+  if (type.getMemoryKind() &&
+      type.getMemoryKind().getValue() == kMemoryKindPinnedHost) {
+    return false;
+  }
+  if (auto arg = dyn_cast<BlockArgument>(value)) {
+    return !IsArgOnHost(func_op_, arg.getArgNumber());
+  }
+  return !IsResultOnHost(cast<OpResult>(value));
+}
+
+bool MeshMemorySimulation::IsFreedAfterLastUse(Value value) const {
+  // If a value is an argument of the MPMD program then we can only free it if
+  // it has been donated to the program. Otherwise, we cannot safely free it
+  // because we do not know if there are other references to it outside of the
+  // program that would keep it alive. We take the safe option here and
+  // possibly overestimate live buffers.
+  auto arg = dyn_cast<BlockArgument>(value);
+  return !arg || IsArgDonated(func_op_, arg.getArgNumber());
+}
+
+SmallVector<Value> MeshMemorySimulation::GetLiveValuesOnMesh(
+    const DenseSet<Value>& live_values, StringRef mesh_name) const {
+  SmallVector<Value> live_values_on_mesh;
+  for (Value value : live_values) {
+    if (GetMeshName(value) == mesh_name) {
+      live_values_on_mesh.push_back(value);
+    }
+  }
+  // Arguments come first, in order, and then results, in program order.
+  auto position = [&](Value value) -> std::pair<int, int> {
+    if (auto arg = dyn_cast<BlockArgument>(value)) {
+      return {-1, arg.getArgNumber()};
+    }
+    auto result = cast<OpResult>(value);
+    return {op_positions_.lookup(result.getOwner()), result.getResultNumber()};
+  };
+  llvm::sort(live_values_on_mesh, [&](Value lhs, Value rhs) {
+    return position(lhs) < position(rhs);
+  });
+  return live_values_on_mesh;
+}
+
+}  // namespace mlir::mpmd
@@ -0,0 +1,118 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_MEMORY_SIMULATION_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_MEMORY_SIMULATION_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Analysis/Liveness.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/transforms/export/utils.h"
+
+namespace mlir::mpmd {
+
+// Simulates the device memory used on each mesh by an MPMD function, assuming
+// that its ops are executed in program order, e.g., to find the peak memory of
+// each mesh and what is live at that point.
+//
+// A value takes memory on its mesh from the op that defines it until its last
+// use, and its size is the size of its local tensor, rounded up to the
+// allocator alignment. The simulation accounts for:
+// - Offloading: values on host, i.e., function arguments and fragment results
+//   with a pinned host memory kind, don't take device memory.
+// - Donation: a function argument is freed after its last use only if it's
+//   donated to the program, i.e., marked with `tf.aliasing_output` or
+//   `jax.buffer_donor`, as it may be referenced outside of the program
+//   otherwise. Donated arguments without uses aren't live at all.
+// - Aliasing: a fragment result aliased with an operand, i.e., the operand has
+//   a `tf.aliasing_output` attribute, reuses the buffer of that operand, so it
+//   isn't allocated while the fragment executes.
+//
+// Unused results are assumed to be freed as soon as they are produced.
+class MeshMemorySimulation {
+ public:
+  // The peak memory usage of a mesh.
+  struct MeshPeak {
+    int64_t bytes = 0;
+    // The op executing at the peak, or null if the peak is at the start of the
+    // function, i.e., is the function arguments.
+    Operation* op = nullptr;
+    // The values live at the peak, including the results of `op` allocated
+    // while it executes, in program order.
+    SmallVector<Value> live_values;
+  };
+
+  // Sizes are looked up in `type_cache` if given, e.g., to share it across
+  // simulations of the same function, or in a cache owned by the simulation
+  // otherwise.
+  explicit MeshMemorySimulation(func::FuncOp func_op,
+                                int64_t alignment_bytes = 1,
+                                LocalTensorTypeCache* type_cache = nullptr);
+
+  // Returns the size of `value` on its mesh, rounded up to the alignment.
+  int64_t GetSizeInBytes(Value value) const;
+
+  // Returns the bytes live on `mesh_name` right before `op` executes.
+  int64_t GetLiveBytesBefore(Operation* op, StringRef mesh_name) const;
+
+  // Returns the peak memory usage of `mesh_name`.
+  const MeshPeak& GetPeak(StringRef mesh_name) const;
+
+  // Prints the peak memory usage of each mesh, e.g., for capacity planning.
+  void Print(llvm::raw_ostream& os) const;
+
+ private:
+  // Runs the simulation. If `peaks_known`, records the live values at the
+  // peaks found by a previous run. Otherwise, finds the peaks.
+  void Simulate(bool peaks_known);
+
+  // Returns whether `value` takes device memory, i.e., is a mesh tensor that
+  // isn't on host.
+  bool TakesDeviceMemory(Value value) const;
+
+  // Returns whether the device memory of `value` is freed after its last use.
+  bool IsFreedAfterLastUse(Value value) const;
+
+  // Returns the live values of `mesh_name` among `live_values`, in program
+  // order.
+  SmallVector<Value> GetLiveValuesOnMesh(const DenseSet<Value>& live_values,
+                                         StringRef mesh_name) const;
+
+  func::FuncOp func_op_;
+  int64_t alignment_bytes_;
+  std::unique_ptr<LocalTensorTypeCache> owned_type_cache_;
+  LocalTensorTypeCache* type_cache_;
+  Liveness liveness_;
+  // The position of each op in the function body.
+  DenseMap<Operation*, int> op_positions_;
+  // The bytes live on each mesh right before each op.
+  DenseMap<Operation*, DenseMap<StringRef, int64_t>> live_bytes_before_;
+  // The peak of each mesh, in the order of the topology.
+  llvm::MapVector<StringRef, MeshPeak> peaks_;
+};
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_MEMORY_SIMULATION_H_
@@ -0,0 +1,157 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/export/memory_simulation.h"
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using ::mlir::func::FuncOp;
+using ::testing::ElementsAre;
+
+namespace mlir::mpmd {
+namespace {
+
+// Each tensor is 128 bytes, or 2 bytes for the f16 scalar.
+const char kProgram[] = R"mlir(
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_1_scalar = !mpmd.mesh_tensor<"m1", tensor<f16>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+func.func @main(%arg0: !mesh_1_tensor {jax.buffer_donor = true}, %arg1: !mesh_1_scalar)
+  -> (!mesh_1_tensor, !mesh_2_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg2 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %1, %2 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) (%arg2: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg2 : tensor<4x8xf32>
+    mpmd.return %1, %1 : tensor<4x8xf32>, tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> (!mesh_1_tensor, !mesh_1_tensor)
+  %3 = mpmd.transfer %2 : (!mesh_1_tensor) -> !mesh_2_tensor
+  func.return %1, %3 : !mesh_1_tensor, !mesh_2_tensor
+}
+)mlir";
+
+class MeshMemorySimulationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    loadAllRequiredDialects(&context_);
+    module_ = parseSourceString<ModuleOp>(kProgram, &context_);
+    ASSERT_TRUE(module_);
+    main_func_ = GetMainFunction(*module_);
+    for (Operation& op : main_func_.getOps()) {
+      ops_.push_back(&op);
+    }
+  }
+
+  MLIRContext context_;
+  OwningOpRef<ModuleOp> module_;
+  FuncOp main_func_;
+  SmallVector<Operation*> ops_;
+};
+
+TEST_F(MeshMemorySimulationTest, TracksLiveBytesBeforeEachOp) {
+  MeshMemorySimulation simulation(main_func_);
+
+  // Both arguments are live before the first fragment.
+  EXPECT_EQ(simulation.GetLiveBytesBefore(ops_[0], "m1"), 130);
+  // The donated %arg0 is freed after its last use, and %0 is live.
+  EXPECT_EQ(simulation.GetLiveBytesBefore(ops_[1], "m1"), 130);
+  // %0 is freed, and both results of f1 are live.
+  EXPECT_EQ(simulation.GetLiveBytesBefore(ops_[2], "m1"), 258);
+  EXPECT_EQ(simulation.GetLiveBytesBefore(ops_[2], "m2"), 0);
+  // %2 is freed after the transfer.
+  EXPECT_EQ(simulation.GetLiveBytesBefore(ops_[3], "m1"), 130);
+  EXPECT_EQ(simulation.GetLiveBytesBefore(ops_[3], "m2"), 128);
+}
+
+TEST_F(MeshMemorySimulationTest, FindsPeakAndLiveValues) {
+  MeshMemorySimulation simulation(main_func_);
+
+  // While f1 executes, %arg1, %0 and both its results are live.
+  const MeshMemorySimulation::MeshPeak& peak_1 = simulation.GetPeak("m1");
+  EXPECT_EQ(peak_1.bytes, 386);
+  EXPECT_EQ(peak_1.op, ops_[1]);
+  EXPECT_THAT(peak_1.live_values,
+              ElementsAre(main_func_.getArgument(1), ops_[0]->getResult(0),
+                          ops_[1]->getResult(0), ops_[1]->getResult(1)));
+
+  const MeshMemorySimulation::MeshPeak& peak_2 = simulation.GetPeak("m2");
+  EXPECT_EQ(peak_2.bytes, 128);
+  EXPECT_EQ(peak_2.op, ops_[2]);
+  EXPECT_THAT(peak_2.live_values, ElementsAre(ops_[2]->getResult(0)));
+}
+
+TEST_F(MeshMemorySimulationTest, RoundsSizesUpToAlignment) {
+  MeshMemorySimulation simulation(main_func_, /*alignment_bytes=*/64);
+
+  EXPECT_EQ(simulation.GetSizeInBytes(main_func_.getArgument(0)), 128);
+  EXPECT_EQ(simulation.GetSizeInBytes(main_func_.getArgument(1)), 64);
+  EXPECT_EQ(simulation.GetLiveBytesBefore(ops_[0], "m1"), 192);
+}
+
+TEST_F(MeshMemorySimulationTest, AliasedResultsReuseOperandBuffers) {
+  // Alias %0 with the first result of f1.
+  ops_[1]->setAttr(
+      "arg_attrs",
+      ArrayAttr::get(&context_,
+                     {DictionaryAttr::get(
+                         &context_,
+                         {NamedAttribute(
+                             StringAttr::get(&context_, "tf.aliasing_output"),
+                             IntegerAttr::get(IntegerType::get(&context_, 32),
+                                              0))})}));
+  MeshMemorySimulation simulation(main_func_);
+
+  // f1 now needs 258 bytes, as much as f0, which comes first.
+  const MeshMemorySimulation::MeshPeak& peak = simulation.GetPeak("m1");
+  EXPECT_EQ(peak.bytes, 258);
+  EXPECT_EQ(peak.op, ops_[0]);
+}
+
+TEST_F(MeshMemorySimulationTest, PeakAtEntryWithoutOps) {
+  OwningOpRef<ModuleOp> module = parseSourceString<ModuleOp>(R"mlir(
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+func.func @main(%arg0: !mesh_1_tensor) -> !mesh_1_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+  func.return %arg0 : !mesh_1_tensor
+}
+)mlir",
+                                                             &context_);
+  ASSERT_TRUE(module);
+  MeshMemorySimulation simulation(GetMainFunction(*module));
+
+  const MeshMemorySimulation::MeshPeak& peak = simulation.GetPeak("m1");
+  EXPECT_EQ(peak.bytes, 128);
+  EXPECT_EQ(peak.op, nullptr);
+  EXPECT_THAT(peak.live_values, ElementsAre(Value(
+                                    GetMainFunction(*module).getArgument(0))));
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
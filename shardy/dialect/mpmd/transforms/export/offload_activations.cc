@@ -0,0 +1,210 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/export/memory_simulation.h"
+#include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/utils.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_OFFLOADACTIVATIONSPASS
+#include "shardy/dialect/mpmd/transforms/export/passes.h.inc"
+
+namespace {
+
+// A fragment result to offload to host across the longest gap between its
+// uses, i.e., between its producer and first user, or between two consecutive
+// users, on its mesh.
+struct OffloadCandidate {
+  OpResult value;
+  // The fragment after which the value is transferred to host: the producer
+  // or the last user before the gap.
+  Operation* offload_after;
+  // The fragment before which the value is transferred back to device: the
+  // fragment right before the first user after the gap, so that the transfer
+  // overlaps with it.
+  Operation* prefetch_before;
+  int64_t bytes;
+  // The number of fragments on the mesh in the gap.
+  int64_t gap;
+};
+
+// Returns the candidates to offload among the results of the fragments of
+// `main_func`, such that the gap of each is at least `min_gap` fragments.
+// If `host_bytes_per_fragment` is positive, a value is only a candidate if it
+// can be transferred to host and back within the gap, at that many bytes per
+// fragment.
+std::vector<OffloadCandidate> FindOffloadCandidates(
+    func::FuncOp main_func, const MeshMemorySimulation& simulation,
+    int64_t min_gap, int64_t host_bytes_per_fragment) {
+  // The fragments of each mesh and their positions in program order.
+  DenseMap<StringRef, SmallVector<FragmentOp>> mesh_fragments;
+  DenseMap<Operation*, int64_t> positions;
+  for (FragmentOp fragment : main_func.getOps<FragmentOp>()) {
+    SmallVector<FragmentOp>& fragments = mesh_fragments[fragment.getMeshName()];
+    positions[fragment] = fragments.size();
+    fragments.push_back(fragment);
+  }
+
+  std::vector<OffloadCandidate> candidates;
+  for (auto& [mesh_name, fragments] : mesh_fragments) {
+    for (FragmentOp producer : fragments) {
+      for (OpResult result : producer->getResults()) {
+        auto type = cast<MeshTensorType>(result.getType());
+        if (type.isOnHost() || IsResultOnHost(result) || result.use_empty()) {
+          continue;
+        }
+        // Only values used by fragments on the same mesh, on device, are
+        // offloaded, e.g., not those transferred to other meshes or returned.
+        SmallVector<int64_t> use_positions = {positions.lookup(producer)};
+        bool only_used_by_fragments = llvm::all_of(
+            result.getUses(), [&](OpOperand& use) {
+              auto user = dyn_cast<FragmentOp>(use.getOwner());
+              if (!user || user.getMeshName() != mesh_name ||
+                  IsArgOnHost(user, use.getOperandNumber())) {
+                return false;
+              }
+              use_positions.push_back(positions.lookup(user));
+              return true;
+            });
+        if (!only_used_by_fragments) {
+          continue;
+        }
+        llvm::sort(use_positions);
+
+        int64_t gap_start = 0;
+        int64_t gap = -1;
+        for (int64_t i = 0; i + 1 < use_positions.size(); ++i) {
+          if (int64_t new_gap = use_positions[i + 1] - use_positions[i] - 1;
+              new_gap > gap) {
+            gap = new_gap;
+            gap_start = use_positions[i];
+          }
+        }
+        if (gap < min_gap || gap <= 0) {
+          continue;
+        }
+        int64_t bytes = simulation.GetSizeInBytes(result);
+        if (host_bytes_per_fragment > 0 &&
+            2 * bytes > host_bytes_per_fragment * gap) {
+          continue;
+        }
+        candidates.push_back(
+            {result, fragments[gap_start], fragments[gap_start + gap], bytes,
+             gap});
+      }
+    }
+  }
+  return candidates;
+}
+
+// Returns whether offloading `candidate` frees its memory while `op` executes.
+bool IsOffloadedDuring(const OffloadCandidate& candidate, Operation* op) {
+  return op && candidate.offload_after->isBeforeInBlock(op) &&
+         op->isBeforeInBlock(candidate.prefetch_before);
+}
+
+// Transfers the value of `candidate` to host after `offload_after`, and back
+// to device before `prefetch_before`, for the users after the gap.
+void Offload(const OffloadCandidate& candidate, IRRewriter& rewriter) {
+  OpResult value = candidate.value;
+  auto type = cast<MeshTensorType>(value.getType());
+  auto host_type = MeshTensorType::get(
+      type.getContext(), type.getMeshName(), type.getRankedTensorType(),
+      type.getSharding(), rewriter.getStringAttr(kMemoryKindPinnedHost));
+
+  rewriter.setInsertionPointAfter(candidate.offload_after);
+  auto to_host =
+      TransferOp::create(rewriter, value.getLoc(), host_type, value);
+  rewriter.setInsertionPoint(candidate.prefetch_before);
+  auto to_device = TransferOp::create(rewriter, value.getLoc(), type, to_host);
+  rewriter.replaceUsesWithIf(value, to_device, [&](OpOperand& use) {
+    return candidate.prefetch_before->isBeforeInBlock(use.getOwner());
+  });
+}
+
+class OffloadActivationsPass
+    : public impl::OffloadActivationsPassBase<OffloadActivationsPass> {
+  using OffloadActivationsPassBase::OffloadActivationsPassBase;
+
+ protected:
+  void runOnFunc(func::FuncOp main_func) override {
+    if (minGapFragments <= 0 || !IsMpmdFunction(main_func) ||
+        !IsEntryPointFunction(main_func)) {
+      return;
+    }
+
+    IRRewriter rewriter(main_func.getContext());
+    // The simulation is rerun after each offload, so share the local types.
+    LocalTensorTypeCache& type_cache = getAnalysis<LocalTensorTypeCache>();
+    std::vector<OffloadCandidate> candidates = FindOffloadCandidates(
+        main_func, MeshMemorySimulation(main_func, alignmentBytes, &type_cache),
+        minGapFragments, hostBytesPerFragment);
+
+    if (hbmBudgetBytes <= 0) {
+      for (const OffloadCandidate& candidate : candidates) {
+        Offload(candidate, rewriter);
+      }
+      return;
+    }
+
+    // Offload values live at the peak of a mesh over the budget, the largest
+    // and longest lived first, until all meshes are within budget or no
+    // candidate reduces their peak.
+    llvm::sort(candidates, [](const OffloadCandidate& lhs,
+                              const OffloadCandidate& rhs) {
+      return lhs.bytes * lhs.gap > rhs.bytes * rhs.gap;
+    });
+    std::vector<bool> offloaded(candidates.size(), false);
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      MeshMemorySimulation simulation(main_func, alignmentBytes, &type_cache);
+      for (auto [index, candidate] : llvm::enumerate(candidates)) {
+        if (offloaded[index]) {
+          continue;
+        }
+        const MeshMemorySimulation::MeshPeak& peak = simulation.GetPeak(
+            cast<MeshTensorType>(candidate.value.getType()).getMeshName());
+        if (peak.bytes > hbmBudgetBytes &&
+            IsOffloadedDuring(candidate, peak.op) &&
+            llvm::is_contained(peak.live_values, candidate.value)) {
+          Offload(candidate, rewriter);
+          offloaded[index] = true;
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
@@ -18,10 +18,14 @@ limitations under the License.
 
 // IWYU pragma: begin_keep
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/OwningOpRef.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Pass/PassOptions.h"
@@ -36,19 +40,86 @@ namespace mlir::mpmd {
 #define GEN_PASS_REGISTRATION
 #include "shardy/dialect/mpmd/transforms/export/passes.h.inc"
 
+// Receives the standalone module of a fragment function, i.e., a module with
+// the function and the meshes it references, as soon as
+// `LowerToFragmentCallsPass` creates the function. The module is owned by the
+// callback and shares the context of the exported module, so it can be
+// compiled, or handed to another thread to compile, while the export
+// continues.
+using FragmentModuleCallback = std::function<void(OwningOpRef<ModuleOp>)>;
+
+// Creates a `LowerToFragmentCallsPass` that streams each fragment function it
+// creates to `fragment_module_callback`. The functions are still added to the
+// lowered module.
+std::unique_ptr<Pass> createLowerToFragmentCallsPass(
+    LowerToFragmentCallsPassOptions options,
+    FragmentModuleCallback fragment_module_callback);
+
 // Options for the export pipeline.
 struct ExportOptions {
   // Whether to copy constants produced in one fragment to their consumers,
   // possibly through transfers.
   bool copyConstantsFromProducerToConsumer = false;
+  // If positive, the maximum size in bytes of a non-splat constant that is
+  // copied. See `CopyConstantsPass`.
+  int64_t copyConstantsMaxSizeBytes = 0;
+  // Whether to also copy broadcasts of scalar constants.
+  bool copyScalarBroadcasts = false;
   // Whether to apply the merge transfers optimization pass.
   bool applyMergeTransfers = false;
+  // If positive, the maximum size in bytes of a merged transfer, and of the
+  // transfers that are merged. See `MergeTransfersPass`.
+  int64_t mergeTransfersBucketSizeBytes = 0;
   bool failOnReshardOnlyFragments = false;
   bool failOnBackwardDeps = false;
   bool failOnInferredFragments = true;
   // Whether to fail on parameter transfers (default: false, emits a warning).
   bool failOnParamTransfers = false;
   std::string paramTransferPattern = "params['transformer";
+  // Whether to issue inter-mesh transfers as early as their producers allow.
+  bool scheduleTransfers = false;
+  // The maximum bytes of in-flight transfers to each mesh when scheduling
+  // transfers. Unbounded if zero.
+  int64_t maxInFlightTransferBytes = 0;
+  // If positive, fragment results that aren't used for at least this many
+  // fragments of their mesh are offloaded to host in between. See
+  // `OffloadActivationsPass`.
+  int64_t offloadActivationsMinGapFragments = 0;
+  // If positive, activations are only offloaded while the peak memory of their
+  // mesh exceeds this budget.
+  int64_t offloadActivationsHbmBudgetBytes = 0;
+  // If positive, the bytes that can be transferred between device and host
+  // while a fragment executes, which bounds the activations offloaded.
+  int64_t offloadActivationsHostBytesPerFragment = 0;
+  // Whether fragment results used in other fragments take the layout
+  // preferred by their consumers. See `MarkInputOutputWithLayoutsPass`.
+  bool propagateConsumerLayouts = false;
+  // Whether to mark each resharding transfer with its device-to-device plan.
+  // See `MarkReshardingTransferPlansPass`.
+  bool markReshardingTransferPlans = false;
+  // Whether to add a fingerprint, stable across processes, to each fragment
+  // function. See `LowerToFragmentCallsPass`.
+  bool emitFragmentFingerprints = false;
+  // If set, receives each fragment function as a standalone module as soon as
+  // it is created. See `FragmentModuleCallback`.
+  FragmentModuleCallback fragmentModuleCallback;
+  // Whether to save the dependency graph of the fragment calls and transfers
+  // of each function to `dumpDirectory`, as `mpmd_execution_plan_<function>`.
+  // See `ExportExecutionPlanPass`.
+  bool exportExecutionPlan = false;
+  // Whether to compact the locations and origins of all ops before exporting,
+  // to reduce the memory and dump size of programs with many merged fragments.
+  // See `CompactLocationsPass`.
+  bool compactLocations = false;
+  // Whether to drop all locations and sharding debug attributes right before
+  // lowering to fragment calls, i.e., once the checks that use them have run.
+  bool stripDebugInfo = false;
+  // Whether to report the wall time and the module size, i.e., the number of
+  // ops, fragments and transfers, after each stage of the pipeline.
+  bool reportStages = false;
+  // Directory to save the stage report to, as `mpmd_export_stages.json`, and
+  // the execution plan. If empty, they are printed to stderr.
+  std::string dumpDirectory;
   // Whether to enable verbose logging.
   bool verboseLogging = false;
 };
@@ -13,12 +13,19 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "mlir/Analysis/Liveness.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/OperationSupport.h"
 #include "mlir/IR/PatternMatch.h"
@@ -32,6 +39,7 @@ namespace mlir::mpmd {
 
 #define GEN_PASS_DEF_DELAYINFERREDFRAGMENTSPASS
 #define GEN_PASS_DEF_DELAYTRANSFERSFROMCPUPASS
+#define GEN_PASS_DEF_SCHEDULETRANSFERSPASS
 #include "shardy/dialect/mpmd/transforms/export/passes.h.inc"
 
 namespace {
@@ -111,5 +119,91 @@ class DelayTransfersFromCpuPass
   }
 };
 
+// Returns true if `transfer` is an inter-mesh transfer between devices that
+// `ScheduleTransfersPass` may move, i.e., one that doesn't involve the host
+// (which `DelayTransfersFromCpuPass` delays instead) and that isn't part of a
+// chain of transfers.
+bool IsSchedulableTransfer(TransferOp transfer) {
+  if (!transfer.isInterMesh() || transfer.use_empty() ||
+      IsOnCpuMesh(transfer.getOperand()) || IsOnCpuMesh(transfer.getResult()) ||
+      cast<MeshTensorType>(transfer.getOperand().getType()).isOnHost() ||
+      cast<MeshTensorType>(transfer.getType()).isOnHost()) {
+    return false;
+  }
+  return !transfer.getOperand().getDefiningOp<TransferOp>() &&
+         llvm::none_of(transfer->getUsers(),
+                       [](Operation* user) { return isa<TransferOp>(user); });
+}
+
+class ScheduleTransfersPass
+    : public impl::ScheduleTransfersPassBase<ScheduleTransfersPass> {
+  using ScheduleTransfersPassBase::ScheduleTransfersPassBase;
+
+ protected:
+  void runOnFunc(func::FuncOp main_func) override {
+    if (!IsMpmdFunction(main_func) || !IsEntryPointFunction(main_func)) {
+      return;
+    }
+
+    IRRewriter rewriter(main_func.getContext());
+    Block& block = main_func.getBody().front();
+
+    // The transfers are moved right before other ops, i.e., anchors, whose
+    // relative order doesn't change.
+    std::vector<TransferOp> transfers;
+    SmallVector<Operation*> anchors;
+    DenseMap<Operation*, int> anchor_to_index;
+    for (Operation& op : block) {
+      if (auto transfer = dyn_cast<TransferOp>(&op);
+          transfer && IsSchedulableTransfer(transfer)) {
+        transfers.push_back(transfer);
+      } else {
+        anchor_to_index[&op] = anchors.size();
+        anchors.push_back(&op);
+      }
+    }
+
+    // The bytes of the transfers in flight to each mesh before each anchor,
+    // i.e., that were issued but whose first consumer didn't execute yet.
+    llvm::StringMap<std::vector<int64_t>> in_flight_bytes;
+    for (TransferOp transfer : transfers) {
+      // The earliest anchor is the one right after the producer, and the
+      // latest is the first consumer, which waits for the transfer.
+      int earliest = 0;
+      if (Operation* producer = transfer.getOperand().getDefiningOp()) {
+        earliest = anchor_to_index.at(producer) + 1;
+      }
+      int latest = anchors.size() - 1;
+      for (Operation* user : transfer->getUsers()) {
+        latest = std::min(
+            latest, anchor_to_index.at(block.findAncestorOpInBlock(*user)));
+      }
+
+      int issue = earliest;
+      std::vector<int64_t>& mesh_bytes =
+          in_flight_bytes
+              .try_emplace(cast<MeshTensorType>(transfer.getType())
+                               .getMeshName(),
+                           anchors.size(), 0)
+              .first->second;
+      int64_t bytes = GetLocalSizeInBytes(transfer.getType(), transfer);
+      if (maxInFlightBytes > 0) {
+        // Delay the transfer past any anchor where issuing it would exceed the
+        // budget of its destination mesh, or until its first consumer.
+        for (int i = latest - 1; i >= earliest; --i) {
+          if (mesh_bytes[i] + bytes > maxInFlightBytes) {
+            issue = i + 1;
+            break;
+          }
+        }
+      }
+      for (int i = issue; i < latest; ++i) {
+        mesh_bytes[i] += bytes;
+      }
+      rewriter.moveOpBefore(transfer, anchors[issue]);
+    }
+  }
+};
+
 }  // namespace
 }  // namespace mlir::mpmd
@@ -0,0 +1,172 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/export/stage_report.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/save_module_op.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+
+namespace mlir::mpmd {
+
+namespace {
+
+void WriteModuleSize(llvm::json::OStream& json, StringRef name,
+                     const ModuleSize& size) {
+  json.attributeObject(name, [&]() {
+    json.attribute("ops", size.num_ops);
+    json.attribute("fragments", size.num_fragments);
+    json.attribute("transfers", size.num_transfers);
+  });
+}
+
+class RecordStagePass
+    : public PassWrapper<RecordStagePass, OperationPass<ModuleOp>> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(RecordStagePass)
+
+  RecordStagePass(std::shared_ptr<StageReport> report, StringRef stage_name)
+      : report_(std::move(report)), stage_name_(stage_name.str()) {}
+
+ private:
+  void runOnOperation() final {
+    if (stage_name_.empty()) {
+      report_->Start(getOperation());
+    } else {
+      report_->RecordStage(getOperation(), stage_name_);
+    }
+    markAllAnalysesPreserved();
+  }
+
+  StringRef getArgument() const override { return "mpmd-record-stage"; }
+
+  StringRef getDescription() const override {
+    return "Records the wall time and the module size of a pipeline stage.";
+  }
+
+  std::shared_ptr<StageReport> report_;
+  std::string stage_name_;
+};
+
+class SaveStageReportPass
+    : public PassWrapper<SaveStageReportPass, OperationPass<ModuleOp>> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(SaveStageReportPass)
+
+  SaveStageReportPass(std::shared_ptr<StageReport> report,
+                      StringRef dump_directory, StringRef file_name)
+      : report_(std::move(report)),
+        dump_directory_(dump_directory.str()),
+        file_name_(file_name.str()) {}
+
+ private:
+  void runOnOperation() final {
+    report_->Save(dump_directory_, file_name_);
+    markAllAnalysesPreserved();
+  }
+
+  StringRef getArgument() const override { return "mpmd-save-stage-report"; }
+
+  StringRef getDescription() const override {
+    return "Saves the wall time and the module size of each pipeline stage.";
+  }
+
+  std::shared_ptr<StageReport> report_;
+  std::string dump_directory_;
+  std::string file_name_;
+};
+
+}  // namespace
+
+ModuleSize GetModuleSize(ModuleOp module_op) {
+  ModuleSize size;
+  module_op.walk([&](Operation* op) {
+    size.num_ops++;
+    if (isa<FragmentOp, FragmentCallOp>(op)) {
+      size.num_fragments++;
+    } else if (isa<TransferOp>(op)) {
+      size.num_transfers++;
+    }
+  });
+  // The module itself isn't part of any stage.
+  size.num_ops--;
+  return size;
+}
+
+void StageReport::Start(ModuleOp module_op) {
+  stages_.clear();
+  last_size_ = GetModuleSize(module_op);
+  last_time_ = std::chrono::steady_clock::now();
+}
+
+void StageReport::RecordStage(ModuleOp module_op, StringRef stage_name) {
+  std::chrono::steady_clock::time_point end_time =
+      std::chrono::steady_clock::now();
+  ModuleSize size = GetModuleSize(module_op);
+  stages_.push_back(Stage{
+      stage_name.str(),
+      std::chrono::duration<double, std::milli>(end_time - last_time_).count(),
+      last_size_, size});
+  last_size_ = size;
+  last_time_ = std::chrono::steady_clock::now();
+}
+
+void StageReport::Write(llvm::raw_ostream& os) const {
+  double total_wall_time_ms = 0;
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&]() {
+    json.attributeArray("stages", [&]() {
+      for (const Stage& stage : stages_) {
+        total_wall_time_ms += stage.wall_time_ms;
+        json.object([&]() {
+          json.attribute("name", stage.name);
+          json.attribute("wall_time_ms", stage.wall_time_ms);
+          WriteModuleSize(json, "before", stage.size_before);
+          WriteModuleSize(json, "after", stage.size_after);
+        });
+      }
+    });
+    json.attribute("total_wall_time_ms", total_wall_time_ms);
+  });
+  os << "\n";
+}
+
+void StageReport::Save(StringRef dump_directory, StringRef file_name) const {
+  sdy::saveJson(dump_directory, file_name, [&](raw_ostream& os) { Write(os); });
+}
+
+std::unique_ptr<Pass> createRecordStagePass(std::shared_ptr<StageReport> report,
+                                            StringRef stage_name) {
+  return std::make_unique<RecordStagePass>(std::move(report), stage_name);
+}
+
+std::unique_ptr<Pass> createSaveStageReportPass(
+    std::shared_ptr<StageReport> report, StringRef dump_directory,
+    StringRef file_name) {
+  return std::make_unique<SaveStageReportPass>(std::move(report),
+                                               dump_directory, file_name);
+}
+
+}  // namespace mlir::mpmd
@@ -0,0 +1,88 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_STAGE_REPORT_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_STAGE_REPORT_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir::mpmd {
+
+// The size of a module, as reported at the boundaries of pipeline stages.
+struct ModuleSize {
+  int64_t num_ops = 0;
+  // The number of fragments and fragment calls.
+  int64_t num_fragments = 0;
+  int64_t num_transfers = 0;
+};
+
+// Returns the size of `module_op`, counting the ops nested in fragments too.
+ModuleSize GetModuleSize(ModuleOp module_op);
+
+// Records the wall time and the module size of each stage of a pipeline, e.g.,
+// to find which pass blows up on a given model.
+class StageReport {
+ public:
+  // Starts the report at the beginning of the first stage, dropping the stages
+  // of a previous run of the pipeline.
+  void Start(ModuleOp module_op);
+
+  // Records the end of stage `stage_name`, which started when the previous
+  // stage ended.
+  void RecordStage(ModuleOp module_op, StringRef stage_name);
+
+  // Writes the report as JSON to `os`.
+  void Write(llvm::raw_ostream& os) const;
+
+  // Saves the report as `file_name`.json in `dump_directory`, or prints it to
+  // stderr if `dump_directory` is empty.
+  void Save(StringRef dump_directory, StringRef file_name) const;
+
+ private:
+  struct Stage {
+    std::string name;
+    double wall_time_ms;
+    ModuleSize size_before;
+    ModuleSize size_after;
+  };
+
+  std::vector<Stage> stages_;
+  ModuleSize last_size_;
+  std::chrono::steady_clock::time_point last_time_;
+};
+
+// Creates a pass that starts `report`, or records the end of stage
+// `stage_name` if not empty. The time spent computing the module size isn't
+// attributed to any stage.
+std::unique_ptr<Pass> createRecordStagePass(std::shared_ptr<StageReport> report,
+                                            StringRef stage_name = "");
+
+// Creates a pass that saves `report`. See `StageReport::Save`.
+std::unique_ptr<Pass> createSaveStageReportPass(
+    std::shared_ptr<StageReport> report, StringRef dump_directory,
+    StringRef file_name);
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_STAGE_REPORT_H_
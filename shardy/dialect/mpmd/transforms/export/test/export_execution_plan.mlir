@@ -0,0 +1,81 @@
+// RUN: mpmd_opt %s -mpmd-export-execution-plan -o /dev/null 2>&1 | FileCheck %s
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+!mesh_2_sharded_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>, sharding=<@mesh, [{"x"}, {}]>>
+
+func.func @fragment_m1(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32>
+    attributes {mesh_shape = #sdy.mesh<["x"=2]>} {
+  %0 = stablehlo.add %arg0, %arg0 : tensor<4x8xf32>
+  return %0 : tensor<4x8xf32>
+}
+
+func.func @fragment_m2(%arg0: tensor<2x8xf32>, %arg1: tensor<4x8xf32>) -> tensor<4x8xf32>
+    attributes {mesh_shape = #sdy.mesh<["x"=2]>} {
+  return %arg1 : tensor<4x8xf32>
+}
+
+// CHECK:      "function": "main",
+// CHECK-NEXT: "nodes": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "id": 0,
+// CHECK-NEXT:     "kind": "fragment_call",
+// CHECK-NEXT:     "callee": "fragment_m1",
+// CHECK-NEXT:     "mesh": "m1",
+// CHECK-NEXT:     "cost": 32,
+// CHECK-NEXT:     "input_bytes": 128,
+// CHECK-NEXT:     "output_bytes": 128,
+// CHECK-NEXT:     "deps": [],
+// CHECK-NEXT:     "args": [
+// CHECK-NEXT:       0
+// CHECK-NEXT:     ]
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "id": 1,
+// CHECK-NEXT:     "kind": "transfer",
+// CHECK-NEXT:     "mesh": "m2",
+// CHECK-NEXT:     "source_mesh": "m1",
+// CHECK-NEXT:     "bytes": 64,
+// CHECK-NEXT:     "deps": [
+// CHECK-NEXT:       0
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "args": []
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "id": 2,
+// CHECK-NEXT:     "kind": "fragment_call",
+// CHECK-NEXT:     "callee": "fragment_m2",
+// CHECK-NEXT:     "mesh": "m2",
+// CHECK-NEXT:     "cost": 5,
+// CHECK-NEXT:     "input_bytes": 192,
+// CHECK-NEXT:     "output_bytes": 128,
+// CHECK-NEXT:     "deps": [
+// CHECK-NEXT:       1
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "args": [
+// CHECK-NEXT:       1
+// CHECK-NEXT:     ]
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "id": 3,
+// CHECK-NEXT:     "kind": "fragment_call",
+// CHECK-NEXT:     "callee": "fragment_m1",
+// CHECK-NEXT:     "mesh": "m1",
+// CHECK-NEXT:     "cost": 32,
+// CHECK-NEXT:     "input_bytes": 128,
+// CHECK-NEXT:     "output_bytes": 128,
+// CHECK-NEXT:     "deps": [],
+// CHECK-NEXT:     "args": [
+// CHECK-NEXT:       0
+// CHECK-NEXT:     ]
+// CHECK-NEXT:   }
+// CHECK-NEXT: ]
+func.func @main(%arg0: !mesh_1_tensor, %arg1: !mesh_2_tensor) -> (!mesh_2_tensor, !mesh_1_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  %0 = mpmd.fragment_call<mesh="m1", origin=["f1"]> @fragment_m1(%arg0) : (!mesh_1_tensor) -> !mesh_1_tensor
+  %1 = mpmd.transfer %0 : (!mesh_1_tensor) -> !mesh_2_sharded_tensor
+  %2 = mpmd.fragment_call<mesh="m2", origin=["f2"]> @fragment_m2(%1, %arg1) {mpmd.fragment_cost = 5.0 : f32} : (!mesh_2_sharded_tensor, !mesh_2_tensor) -> !mesh_2_tensor
+  // Independent of the fragments of m2, so it can be dispatched concurrently.
+  %3 = mpmd.fragment_call<mesh="m1", origin=["f3"]> @fragment_m1(%arg0) : (!mesh_1_tensor) -> !mesh_1_tensor
+  func.return %2, %3 : !mesh_2_tensor, !mesh_1_tensor
+}
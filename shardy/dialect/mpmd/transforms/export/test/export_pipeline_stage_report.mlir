@@ -0,0 +1,42 @@
+// RUN: mpmd_opt %s -mpmd-export-pipeline='report-stages=true' -o /dev/null 2>&1 | FileCheck %s
+
+!m1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!m2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+// CHECK:      "stages": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "name": "cse",
+// CHECK-NEXT:     "wall_time_ms": {{[0-9.e+-]+}},
+// CHECK-NEXT:     "before": {
+// CHECK-NEXT:       "ops": 9,
+// CHECK-NEXT:       "fragments": 2,
+// CHECK-NEXT:       "transfers": 1
+// CHECK-NEXT:     },
+// CHECK-NEXT:     "after": {
+// CHECK-NEXT:       "ops": 9,
+// CHECK-NEXT:       "fragments": 2,
+// CHECK-NEXT:       "transfers": 1
+// CHECK-NEXT:     }
+// CHECK-NEXT:   },
+// CHECK:          "name": "canonicalize",
+// CHECK:          "name": "lower-to-fragment-calls",
+// CHECK:          "after": {
+// CHECK-NEXT:       "ops": 11,
+// CHECK-NEXT:       "fragments": 2,
+// CHECK-NEXT:       "transfers": 1
+// CHECK-NEXT:     }
+// CHECK:          "name": "validate-fragment-calls",
+// CHECK:        "total_wall_time_ms": {{[0-9.e+-]+}}
+func.func @main(%arg0: !m1_tensor) -> !m2_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  %0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %1 = mpmd.transfer %0 : (!m1_tensor) -> !m2_tensor
+  %2 = mpmd.fragment<mesh="m2", origin=["f2"]> (%1) (%arg1: tensor<4x8xf32>) {
+    %3 = stablehlo.multiply %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  func.return %2 : !m2_tensor
+}
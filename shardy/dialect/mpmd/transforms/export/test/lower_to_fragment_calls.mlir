@@ -575,3 +575,36 @@ module {
 // CHECK-NEXT:   sdy.return %[[ADD]]
 // CHECK-NEXT: } : (tensor<4x8xf32>) -> tensor<4x8xf32>
 
+
+// -----
+
+!mesh_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @main
+func.func @main(%arg0: !mesh_tensor)
+  -> (!mesh_tensor) attributes {"topology"=#mpmd.topology< <"m1": <["x"=2]>>>} {
+
+  // All the fragments have the same body but different reservations, e.g.,
+  // different microbatches of a stage. They all call the same function, which
+  // reserves the maximum of them.
+  // CHECK:      %[[CALL0:.*]] = mpmd.fragment_call<mesh="m1", origin=["f1"]> @[[FRAGMENT0:.*]](%arg0) :
+  // CHECK-NEXT: %[[CALL1:.*]] = mpmd.fragment_call<mesh="m1", origin=["f1"]> @[[FRAGMENT0]](%[[CALL0]]) :
+  // CHECK-NEXT: mpmd.fragment_call<mesh="m1", origin=["f1"]> @[[FRAGMENT0]](%[[CALL1]]) :
+  %0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) {reserved_hbm_bytes = 128 : i64} (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.abs %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_tensor) -> (!mesh_tensor)
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) {reserved_hbm_bytes = 512 : i64} (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.abs %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_tensor) -> (!mesh_tensor)
+  %2 = mpmd.fragment<mesh="m1", origin=["f1"]> (%1) {reserved_hbm_bytes = 256 : i64} (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.abs %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_tensor) -> (!mesh_tensor)
+
+  func.return %2 : !mesh_tensor
+}
+
+// CHECK:     func @[[FRAGMENT0]](%arg0: tensor<4x8xf32>) -> tensor<4x8xf32> attributes {mesh_shape = #sdy.mesh<["x"=2]>, reserved_hbm_bytes = 512 : i64} {
+// CHECK-NOT: func @
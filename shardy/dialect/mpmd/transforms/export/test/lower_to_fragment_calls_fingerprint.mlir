@@ -0,0 +1,39 @@
+// RUN: mpmd_opt %s -mpmd-lower-to-fragment-calls=emit-fingerprints=true 2>&1 | FileCheck %s
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @main
+func.func @main(%arg0: !mesh_1_tensor, %arg1: !mesh_1_tensor, %arg2: !mesh_2_tensor, %arg3: !mesh_2_tensor)
+    -> (!mesh_1_tensor, !mesh_2_tensor, !mesh_2_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=4]>>, <"m2": <["x"=4]>>>} {
+  %f0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0, %arg1)
+    (%arg4: tensor<4x8xf32>, %arg5: tensor<4x8xf32>) {
+    %0 = stablehlo.subtract %arg4, %arg5 : tensor<4x8xf32>
+    mpmd.return %0 : tensor<4x8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor) -> !mesh_1_tensor
+
+  // Same body on an identical mesh with a different name.
+  %f1 = mpmd.fragment<mesh="m2", origin=["f2"]> (%arg2, %arg3)
+    (%arg4: tensor<4x8xf32>, %arg5: tensor<4x8xf32>) {
+    %0 = stablehlo.subtract %arg4, %arg5 : tensor<4x8xf32>
+    mpmd.return %0 : tensor<4x8xf32>
+  } : (!mesh_2_tensor, !mesh_2_tensor) -> !mesh_2_tensor
+
+  // Same ops with swapped operands.
+  %f2 = mpmd.fragment<mesh="m2", origin=["f3"]> (%arg2, %arg3)
+    (%arg4: tensor<4x8xf32>, %arg5: tensor<4x8xf32>) {
+    %0 = stablehlo.subtract %arg5, %arg4 : tensor<4x8xf32>
+    mpmd.return %0 : tensor<4x8xf32>
+  } : (!mesh_2_tensor, !mesh_2_tensor) -> !mesh_2_tensor
+
+  func.return %f0, %f1, %f2 : !mesh_1_tensor, !mesh_2_tensor, !mesh_2_tensor
+}
+
+// CHECK:      func @p0_{{.*}}(
+// CHECK-SAME:   attributes {mesh_shape = #sdy.mesh<["x"=4]>, mpmd.fingerprint = "[[FINGERPRINT:[0-9a-f]{64}]]"}
+// CHECK:      func @p1_{{.*}}(
+// CHECK-SAME:   attributes {mesh_shape = #sdy.mesh<["x"=4]>, mpmd.fingerprint = "[[FINGERPRINT]]"}
+// CHECK:      func @p2_{{.*}}(
+// CHECK-NOT:    [[FINGERPRINT]]
+// CHECK-SAME:   mpmd.fingerprint = "{{[0-9a-f]{64}}}"
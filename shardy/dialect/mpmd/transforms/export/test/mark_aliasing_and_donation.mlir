@@ -94,6 +94,30 @@ func.func @alias_to_multiple_output(%arg0: !mesh_1_tensor_4_8_f32 {tf.aliasing_o
   func.return %0, %1 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
 }
 
+// CHECK-LABEL: func.func @preferred_output_is_not_taken_by_earlier_input
+func.func @preferred_output_is_not_taken_by_earlier_input(%arg0: !mesh_1_tensor_4_8_f32, %arg1: !mesh_1_tensor_4_8_f32 {tf.aliasing_output = 0 : i32})
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {
+      "topology"=#mpmd.topology<
+      <"m1": <["x"=2]>>,
+      <"m2": <["x"=2]>>
+    >} {
+  // CHECK: mpmd.fragment
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    %0 = stablehlo.abs %arg2: tensor<4x8xf32>
+    mpmd.return %0 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> (!mesh_1_tensor_4_8_f32)
+  // %0 comes first, but %arg1 is aliased with its preferred output 0, so %0 is
+  // aliased with output 1.
+  // CHECK: mpmd.fragment
+  // CHECK-SAME: {arg_attrs = [{tf.aliasing_output = 1 : i32}, {tf.aliasing_output = 0 : i32}]}
+  %1, %2 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0, %arg1) (%arg2: tensor<4x8xf32>, %arg3: tensor<4x8xf32>) {
+    %0 = stablehlo.add %arg2, %arg3: tensor<4x8xf32>
+    %1 = stablehlo.abs %arg3: tensor<4x8xf32>
+    mpmd.return %0, %1 : tensor<4x8xf32>, tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) -> (!mesh_1_tensor_4_8_f32,!mesh_1_tensor_4_8_f32)
+  func.return %1, %2 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
+
 // CHECK-LABEL: func.func @should_not_alias_offloaded_values
 func.func @should_not_alias_offloaded_values(
   %arg0: !mesh_1_tensor_4_8_f32 {tf.aliasing_output = 1 : i32},
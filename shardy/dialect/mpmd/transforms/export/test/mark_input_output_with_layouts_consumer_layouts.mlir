@@ -0,0 +1,112 @@
+// RUN: mpmd_opt %s -mpmd-mark-input-output-with-layouts='propagate-consumer-layouts=true' 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-mark-input-output-with-layouts 2>&1 | FileCheck %s --check-prefix=NO-PROP
+// RUN: mpmd_opt %s -mpmd-mark-input-output-with-layouts='propagate-consumer-layouts=true' -mlir-pass-statistics -mlir-pass-statistics-display=list 2>&1 | FileCheck %s --check-prefix=STATS
+
+!m1_16x16 = !mpmd.mesh_tensor<"m1", tensor<16x16xf32>>
+!m2_16x16 = !mpmd.mesh_tensor<"m2", tensor<16x16xf32>>
+#topology = #mpmd.topology<<"m1": <["x"=8]>>, <"m2": <["x"=8]>>>
+
+// STATS: (S) 2 num-relayouts-avoided
+
+// CHECK-LABEL: func @internal_result_takes_layout_of_most_consumers
+// NO-PROP-LABEL: func @internal_result_takes_layout_of_most_consumers
+func.func @internal_result_takes_layout_of_most_consumers(%arg0: !m1_16x16)
+    -> (!m1_16x16, !m1_16x16, !m1_16x16) attributes {topology=#topology} {
+  // CHECK-NEXT: %[[F0:.*]] = mpmd.fragment<mesh="m1", origin=["f0"]>
+  // CHECK-SAME:   {arg_attrs = [{}], res_attrs = [{mhlo.layout_mode = "{0, 1}"}]}
+  // NO-PROP-NEXT: mpmd.fragment<mesh="m1", origin=["f0"]>
+  // NO-PROP-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg1: tensor<16x16xf32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<16x16xf32>
+    mpmd.return %1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f1"]> (%[[F0]])
+  // CHECK-SAME:   {arg_attrs = [{mhlo.layout_mode = "{0, 1}"}], res_attrs = [{}]}
+  // NO-PROP-NEXT: mpmd.fragment<mesh="m1", origin=["f1"]>
+  // NO-PROP-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0)
+      {arg_attrs = [{mhlo.layout_mode = "{0, 1}"}]} (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  // The consumer that prefers another layout is relayouted.
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f2"]> (%[[F0]])
+  // CHECK-SAME:   {arg_attrs = [{mhlo.layout_mode = "{0, 1}"}], res_attrs = [{}]}
+  // NO-PROP-NEXT: mpmd.fragment<mesh="m1", origin=["f2"]>
+  // NO-PROP-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %2 = mpmd.fragment<mesh="m1", origin=["f2"]> (%0)
+      {arg_attrs = [{mhlo.layout_mode = "{1, 0}"}]} (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f3"]> (%[[F0]])
+  // CHECK-SAME:   {arg_attrs = [{mhlo.layout_mode = "{0, 1}"}], res_attrs = [{}]}
+  // NO-PROP-NEXT: mpmd.fragment<mesh="m1", origin=["f3"]>
+  // NO-PROP-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %3 = mpmd.fragment<mesh="m1", origin=["f3"]> (%0)
+      {arg_attrs = [{mhlo.layout_mode = "{0, 1}"}]} (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  func.return %1, %2, %3 : !m1_16x16, !m1_16x16, !m1_16x16
+}
+
+// CHECK-LABEL: func @internal_result_without_consumer_layouts_is_default
+func.func @internal_result_without_consumer_layouts_is_default(%arg0: !m1_16x16)
+    -> !m1_16x16 attributes {topology=#topology} {
+  // CHECK-NEXT: %[[F0:.*]] = mpmd.fragment<mesh="m1", origin=["f0"]>
+  // CHECK-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f1"]> (%[[F0]])
+  // CHECK-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0)
+      {arg_attrs = [{mhlo.layout_mode = "auto"}]} (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  func.return %1 : !m1_16x16
+}
+
+// CHECK-LABEL: func @program_result_layout_takes_precedence_over_consumers
+func.func @program_result_layout_takes_precedence_over_consumers(%arg0: !m1_16x16)
+    -> (!m1_16x16 {mhlo.layout_mode = "{1, 0}"}, !m1_16x16)
+    attributes {topology=#topology} {
+  // CHECK-NEXT: %[[F0:.*]] = mpmd.fragment<mesh="m1", origin=["f0"]>
+  // CHECK-SAME:   {arg_attrs = [{}], res_attrs = [{mhlo.layout_mode = "{1, 0}"}]}
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f1"]> (%[[F0]])
+  // CHECK-SAME:   {arg_attrs = [{mhlo.layout_mode = "{1, 0}"}], res_attrs = [{}]}
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0)
+      {arg_attrs = [{mhlo.layout_mode = "{0, 1}"}]} (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  func.return %0, %1 : !m1_16x16, !m1_16x16
+}
+
+// CHECK-LABEL: func @transferred_result_is_default
+func.func @transferred_result_is_default(%arg0: !m1_16x16)
+    -> (!m1_16x16, !m2_16x16) attributes {topology=#topology} {
+  // CHECK-NEXT: %[[F0:.*]] = mpmd.fragment<mesh="m1", origin=["f0"]>
+  // CHECK-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f1"]> (%[[F0]])
+  // CHECK-SAME:   {arg_attrs = [{}], res_attrs = [{}]}
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0)
+      {arg_attrs = [{mhlo.layout_mode = "{0, 1}"}]} (%arg1: tensor<16x16xf32>) {
+    mpmd.return %arg1 : tensor<16x16xf32>
+  } : (!m1_16x16) -> !m1_16x16
+
+  %2 = mpmd.transfer %0 : (!m1_16x16) -> !m2_16x16
+  func.return %1, %2 : !m1_16x16, !m2_16x16
+}
@@ -0,0 +1,27 @@
+// RUN: mpmd_opt %s -mpmd-mark-resharding-transfer-plans 2>&1 | FileCheck %s
+
+sdy.mesh @mesh = <["x"=2]>
+
+!sharded_on_rows = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>, sharding=<@mesh, [{"x"}, {}]>>
+!sharded_on_cols = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>, sharding=<@mesh, [{}, {"x"}]>>
+!m2_sharded_on_rows = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>, sharding=<@mesh, [{"x"}, {}]>>
+!host_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>, sharding=<@mesh, [{}, {"x"}]>, memory_kind="pinned_host">
+
+// CHECK-LABEL: func @main
+func.func @main(%arg0: !sharded_on_rows)
+  -> (!sharded_on_cols, !m2_sharded_on_rows, !host_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // CHECK-NEXT: mpmd.transfer {mpmd.transfer_plan = [
+  // CHECK-SAME:   {dst_device = 0 : i64, limit_indices = array<i64: 2, 4>, src_device = 0 : i64, start_indices = array<i64: 0, 0>},
+  // CHECK-SAME:   {dst_device = 0 : i64, limit_indices = array<i64: 4, 4>, src_device = 1 : i64, start_indices = array<i64: 2, 0>},
+  // CHECK-SAME:   {dst_device = 1 : i64, limit_indices = array<i64: 2, 8>, src_device = 0 : i64, start_indices = array<i64: 0, 4>},
+  // CHECK-SAME:   {dst_device = 1 : i64, limit_indices = array<i64: 4, 8>, src_device = 1 : i64, start_indices = array<i64: 2, 4>}]}
+  %0 = mpmd.transfer %arg0 : (!sharded_on_rows) -> !sharded_on_cols
+
+  // Transfers that don't reshard, or that go to host, aren't marked.
+  // CHECK-NEXT: mpmd.transfer %arg0
+  // CHECK-NEXT: mpmd.transfer %arg0
+  %1 = mpmd.transfer %arg0 : (!sharded_on_rows) -> !m2_sharded_on_rows
+  %2 = mpmd.transfer %arg0 : (!sharded_on_rows) -> !host_tensor
+  func.return %0, %1, %2 : !sharded_on_cols, !m2_sharded_on_rows, !host_tensor
+}
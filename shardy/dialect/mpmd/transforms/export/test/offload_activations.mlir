@@ -0,0 +1,120 @@
+// RUN: mpmd_opt %s -mpmd-offload-activations='min-gap-fragments=2' 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-offload-activations='min-gap-fragments=2 host-bytes-per-fragment=64' 2>&1 | FileCheck --check-prefix=BANDWIDTH %s
+// RUN: mpmd_opt %s -mpmd-offload-activations='min-gap-fragments=2 hbm-budget-bytes=384' 2>&1 | FileCheck --check-prefix=BUDGET %s
+// RUN: mpmd_opt %s -mpmd-offload-activations='min-gap-fragments=2 hbm-budget-bytes=512' 2>&1 | FileCheck --check-prefix=LARGE-BUDGET %s
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @offload_across_longest_gap
+func.func @offload_across_longest_gap(%arg0: !mesh_1_tensor)
+    -> (!mesh_1_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=4]>>>} {
+  // %0 is offloaded between its last use in the forward pass and its use in
+  // the backward pass, and prefetched during f3.
+  // CHECK-NEXT: %[[ACT:.*]] = mpmd.fragment<mesh="m1", origin=["fwd"]>
+  // CHECK:      %[[F1:.*]] = mpmd.fragment<mesh="m1", origin=["f1"]> (%[[ACT]])
+  // CHECK:      %[[HOST:.*]] = mpmd.transfer %[[ACT]] : (!mpmd.mesh_tensor<"m1", tensor<4x8xf32>>) -> !mpmd.mesh_tensor<"m1", tensor<4x8xf32>, memory_kind="pinned_host">
+  // CHECK-NEXT: %[[F2:.*]] = mpmd.fragment<mesh="m1", origin=["f2"]> (%[[F1]])
+  // CHECK:      %[[DEVICE:.*]] = mpmd.transfer %[[HOST]] : (!mpmd.mesh_tensor<"m1", tensor<4x8xf32>, memory_kind="pinned_host">) -> !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+  // CHECK-NEXT: %[[F3:.*]] = mpmd.fragment<mesh="m1", origin=["f3"]> (%[[F2]])
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["bwd"]> (%[[F3]], %[[DEVICE]])
+
+  // Transferring %0 to host and back takes 256 bytes, which don't fit in the
+  // gap of 2 fragments at 64 bytes per fragment.
+  // BANDWIDTH-LABEL: func @offload_across_longest_gap
+  // BANDWIDTH-NOT:   memory_kind="pinned_host"
+  %0 = mpmd.fragment<mesh="m1", origin=["fwd"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%0) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %2 = mpmd.fragment<mesh="m1", origin=["f2"]> (%1) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %3 = mpmd.fragment<mesh="m1", origin=["f3"]> (%2) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %4 = mpmd.fragment<mesh="m1", origin=["bwd"]> (%3, %0) (%arg1: tensor<4x8xf32>, %arg2: tensor<4x8xf32>) {
+    %1 = stablehlo.add %arg1, %arg2 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor) -> !mesh_1_tensor
+  return %4 : !mesh_1_tensor
+}
+
+// The peak is 512 bytes, while f2, f3 or f4 execute, when %arg0, %0, and the
+// operand and result of the fragment are live. Offloading %0 reduces the peak
+// during f2 but not during f3, when it's prefetched, so it's only offloaded
+// with a budget below 512 bytes.
+// CHECK-LABEL: func @offload_within_budget
+// BUDGET-LABEL: func @offload_within_budget
+// LARGE-BUDGET-LABEL: func @offload_within_budget
+func.func @offload_within_budget(%arg0: !mesh_1_tensor)
+    -> (!mesh_1_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=4]>>>} {
+  // CHECK-COUNT-2: memory_kind="pinned_host">
+  // CHECK-NOT:     memory_kind="pinned_host">
+  // CHECK:         return
+
+  // BUDGET:        %[[F0:.*]] = mpmd.fragment<mesh="m1", origin=["f0"]>
+  // BUDGET:        mpmd.transfer %[[F0]]
+  // BUDGET-NEXT:   mpmd.fragment<mesh="m1", origin=["f1"]>
+  // BUDGET:        %[[DEVICE:.*]] = mpmd.transfer
+  // BUDGET-NEXT:   mpmd.fragment<mesh="m1", origin=["f3"]>
+  // BUDGET:        mpmd.fragment<mesh="m1", origin=["f4"]> (%{{.*}}, %[[DEVICE]])
+
+  // LARGE-BUDGET-NOT: mpmd.transfer
+  // LARGE-BUDGET:     return
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %2 = mpmd.fragment<mesh="m1", origin=["f2"]> (%1) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %3 = mpmd.fragment<mesh="m1", origin=["f3"]> (%2) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %4 = mpmd.fragment<mesh="m1", origin=["f4"]> (%3, %0) (%arg1: tensor<4x8xf32>, %arg2: tensor<4x8xf32>) {
+    %1 = stablehlo.add %arg1, %arg2 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor) -> !mesh_1_tensor
+  return %4 : !mesh_1_tensor
+}
+
+// CHECK-LABEL: func @values_used_by_other_meshes_are_not_offloaded
+func.func @values_used_by_other_meshes_are_not_offloaded(%arg0: !mesh_1_tensor)
+    -> (!mesh_1_tensor, !mesh_2_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=4]>>, <"m2": <["x"=4]>>>} {
+  // CHECK-NOT: memory_kind="pinned_host"
+  // CHECK:     return
+  %0 = mpmd.fragment<mesh="m1", origin=["f0"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %2 = mpmd.fragment<mesh="m1", origin=["f2"]> (%1) (%arg1: tensor<4x8xf32>) {
+    %1 = stablehlo.abs %arg1 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  %3 = mpmd.fragment<mesh="m1", origin=["f3"]> (%2, %0) (%arg1: tensor<4x8xf32>, %arg2: tensor<4x8xf32>) {
+    %1 = stablehlo.add %arg1, %arg2 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor) -> !mesh_1_tensor
+  %4 = mpmd.transfer %0 : (!mesh_1_tensor) -> !mesh_2_tensor
+  return %3, %4 : !mesh_1_tensor, !mesh_2_tensor
+}
@@ -0,0 +1,93 @@
+// RUN: mpmd_opt %s -mpmd-schedule-transfers 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-schedule-transfers='max-in-flight-bytes=128' 2>&1 | FileCheck %s --check-prefix=BOUNDED
+
+!m1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!m2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+!host_tensor = !mpmd.mesh_tensor<"m2/cpu", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @transfer_is_issued_after_its_producer
+func.func @transfer_is_issued_after_its_producer(%arg0: !m1_tensor, %arg1: !m2_tensor)
+  -> (!m2_tensor, !m2_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // CHECK-NEXT: %[[F:.*]] = mpmd.fragment<mesh="m1", origin=["f"]>
+  // CHECK:      mpmd.transfer %[[F]]
+  // CHECK-NEXT: mpmd.fragment<mesh="m2", origin=["g"]>
+  // CHECK:      mpmd.fragment<mesh="m2", origin=["h"]>
+  %f = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %g = mpmd.fragment<mesh="m2", origin=["g"]> (%arg1) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  %t = mpmd.transfer %f : (!m1_tensor) -> !m2_tensor
+  %h = mpmd.fragment<mesh="m2", origin=["h"]> (%t) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  func.return %g, %h : !m2_tensor, !m2_tensor
+}
+
+// CHECK-LABEL: func @transfer_of_arg_is_issued_first
+func.func @transfer_of_arg_is_issued_first(%arg0: !m1_tensor, %arg1: !m2_tensor)
+  -> (!m2_tensor, !m2_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // CHECK-NEXT: mpmd.transfer %arg0
+  // CHECK-NEXT: mpmd.fragment<mesh="m2", origin=["g"]>
+  %g = mpmd.fragment<mesh="m2", origin=["g"]> (%arg1) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  %t = mpmd.transfer %arg0 : (!m1_tensor) -> !m2_tensor
+  func.return %g, %t : !m2_tensor, !m2_tensor
+}
+
+// CHECK-LABEL: func @transfer_from_host_is_not_moved
+func.func @transfer_from_host_is_not_moved(%arg0: !host_tensor, %arg1: !m2_tensor)
+  -> (!m2_tensor, !m2_tensor) attributes {
+    "topology"=#mpmd.topology<<"m2": <["x"=2]>>, <"m2/cpu": <["x"=2]>>>} {
+  // CHECK-NEXT: mpmd.fragment<mesh="m2", origin=["g"]>
+  // CHECK:      mpmd.transfer %arg0
+  %g = mpmd.fragment<mesh="m2", origin=["g"]> (%arg1) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  %t = mpmd.transfer %arg0 : (!host_tensor) -> !m2_tensor
+  func.return %g, %t : !m2_tensor, !m2_tensor
+}
+
+// Each transfer is 128 bytes, so with a budget of 128 bytes the second
+// transfer is only issued once the consumer of the first one waits for it.
+
+// CHECK-LABEL: func @in_flight_transfers_are_bounded
+// CHECK:      %[[F:.*]]:2 = mpmd.fragment<mesh="m1", origin=["f"]>
+// CHECK:      mpmd.transfer %[[F]]#0
+// CHECK-NEXT: mpmd.transfer %[[F]]#1
+// CHECK-NEXT: mpmd.fragment<mesh="m2", origin=["g1"]>
+
+// BOUNDED-LABEL: func @in_flight_transfers_are_bounded
+// BOUNDED:      %[[F:.*]]:2 = mpmd.fragment<mesh="m1", origin=["f"]>
+// BOUNDED:      mpmd.transfer %[[F]]#0
+// BOUNDED-NEXT: mpmd.fragment<mesh="m2", origin=["g1"]>
+// BOUNDED:      mpmd.fragment<mesh="m2", origin=["g2"]>
+// BOUNDED:      mpmd.transfer %[[F]]#1
+// BOUNDED-NEXT: mpmd.fragment<mesh="m2", origin=["h0"]>
+// BOUNDED:      mpmd.fragment<mesh="m2", origin=["h1"]>
+func.func @in_flight_transfers_are_bounded(%arg0: !m1_tensor, %arg1: !m2_tensor)
+  -> (!m2_tensor, !m2_tensor, !m2_tensor) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  %f:2 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2, %arg2 : tensor<4x8xf32>, tensor<4x8xf32>
+  } : (!m1_tensor) -> (!m1_tensor, !m1_tensor)
+  %g1 = mpmd.fragment<mesh="m2", origin=["g1"]> (%arg1) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  %g2 = mpmd.fragment<mesh="m2", origin=["g2"]> (%g1) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  %t0 = mpmd.transfer %f#0 : (!m1_tensor) -> !m2_tensor
+  %h0 = mpmd.fragment<mesh="m2", origin=["h0"]> (%t0) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  %t1 = mpmd.transfer %f#1 : (!m1_tensor) -> !m2_tensor
+  %h1 = mpmd.fragment<mesh="m2", origin=["h1"]> (%t1) (%arg2: tensor<4x8xf32>) {
+    mpmd.return %arg2 : tensor<4x8xf32>
+  } : (!m2_tensor) -> !m2_tensor
+  func.return %g2, %h0, %h1 : !m2_tensor, !m2_tensor, !m2_tensor
+}
@@ -0,0 +1,58 @@
+// RUN: mpmd_opt %s -mpmd-validate-program='check-no-param-transfers=true check-no-inferred-fragments=true fail-on-inferred-fragments=false check-no-reshards=true check-no-backward-deps=true' -split-input-file -verify-diagnostics 2>&1
+// RUN: mpmd_opt %s -mpmd-validate-program -split-input-file 2>&1 | FileCheck %s --check-prefix=NO-CHECKS --allow-empty
+
+// Without any enabled check, nothing is reported.
+// NO-CHECKS-NOT: warning
+
+// The fragment checks run in one walk and report their diagnostics.
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+func.func @param_transfer_and_inferred_fragment(
+    %arg0: !mesh_1_tensor loc("params['transformer/layer_0/attention']['w']")) -> !mesh_2_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // expected-warning@+1 {{Inferred fragment has not been merged (inferred by pass1)}}
+  %0 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) {mpmd.inferred_by = ["pass1"]} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+  // expected-warning@+1 {{Detected cross-mesh transfer of a parameter matching "params['transformer" from mesh "m1" to "m2". JAX locations: ["params['transformer/layer_0/attention']['w']"]}}
+  %1 = mpmd.transfer %arg0 : (!mesh_1_tensor) -> !mesh_2_tensor
+  func.return %1 : !mesh_2_tensor
+}
+
+// -----
+
+// The fragment call checks run in one walk as well, even on the same op.
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+func.func @fragment_m1(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32>
+    attributes {mesh_shape = #sdy.mesh<["x"=2]>} {
+  %0 = stablehlo.add %arg0, %arg0 : tensor<4x8xf32>
+  return %0 : tensor<4x8xf32>
+}
+
+func.func @fragment_m2(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32>
+    attributes {mesh_shape = #sdy.mesh<["x"=2]>} {
+  %0 = stablehlo.add %arg0, %arg0 : tensor<4x8xf32>
+  return %0 : tensor<4x8xf32>
+}
+
+func.func private @reshard_only_callee(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32>
+    attributes {mesh_shape = #sdy.mesh<["x"=2]>} {
+  return %arg0 : tensor<4x8xf32>
+}
+
+func.func @reshard_only_fragment_with_backward_dep(%arg0: !mesh_1_tensor) -> !mesh_1_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  %0 = mpmd.fragment_call<mesh="m1", origin=["f1"(0)]> @fragment_m1(%arg0) : (!mesh_1_tensor) -> !mesh_1_tensor
+  %1 = mpmd.transfer %0 : (!mesh_1_tensor) -> !mesh_2_tensor
+  %2 = mpmd.fragment_call<mesh="m2", origin=["f2"(0)]> @fragment_m2(%1) : (!mesh_2_tensor) -> !mesh_2_tensor
+  %3 = mpmd.transfer %2 : (!mesh_2_tensor) -> !mesh_1_tensor
+  // expected-warning@+2 {{Detected reshard-only fragment 'reshard_only_callee'}}
+  // expected-warning@+1 {{Detected backward dependency but expected forward-only pipeline since there are no transpose fragments: fragment "fragment_m2" mesh="m2" produces a value consumed by fragment "reshard_only_callee" mesh="m1".}}
+  %4 = mpmd.fragment_call<mesh="m1", origin=[]> @reshard_only_callee(%3) : (!mesh_1_tensor) -> !mesh_1_tensor
+  func.return %4 : !mesh_1_tensor
+}
@@ -0,0 +1,195 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/export/transfer_plan.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MathExtras.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+
+namespace mlir::mpmd {
+
+namespace {
+
+using ::mlir::sdy::AxisRefAttr;
+using ::mlir::sdy::MeshAttr;
+using ::mlir::sdy::TensorShardingAttr;
+
+// The shards of a tensor on the devices of a mesh.
+class TensorShards {
+ public:
+  TensorShards(RankedTensorType global_type,
+               TensorShardingAttr sharding_or_null, MeshAttr mesh)
+      : global_type_(global_type),
+        sharding_or_null_(sharding_or_null),
+        mesh_(mesh) {
+    int64_t stride = 1;
+    for (sdy::MeshAxisAttr axis : llvm::reverse(mesh.getAxes())) {
+      axis_strides_[axis.getName()] = stride;
+      stride *= axis.getSize();
+    }
+    for (int64_t dim = 0; dim < global_type.getRank(); ++dim) {
+      int64_t num_shards = 1;
+      if (sharding_or_null) {
+        for (AxisRefAttr axis :
+             sharding_or_null.getDimSharding(dim).getAxes()) {
+          num_shards *= axis.getSize(mesh);
+        }
+      }
+      shard_sizes_.push_back(
+          llvm::divideCeil(global_type.getDimSize(dim), num_shards));
+    }
+  }
+
+  int64_t GetNumDevices() const { return mesh_.getTotalSize(); }
+
+  // Returns the id of the device at `device_index` in the mesh.
+  int64_t GetDeviceId(int64_t device_index) const {
+    ArrayRef<int64_t> device_ids = mesh_.getDeviceIds();
+    return device_ids.empty() ? device_index : device_ids[device_index];
+  }
+
+  // Returns the index of the shard of each dimension on the device at
+  // `device_index` in the mesh.
+  SmallVector<int64_t> GetShardIndices(int64_t device_index) const {
+    SmallVector<int64_t> shard_indices(global_type_.getRank(), 0);
+    if (!sharding_or_null_) {
+      return shard_indices;
+    }
+    for (int64_t dim = 0; dim < global_type_.getRank(); ++dim) {
+      // The axes of a dimension are ordered from major to minor.
+      for (AxisRefAttr axis :
+           sharding_or_null_.getDimSharding(dim).getAxes()) {
+        int64_t index = (device_index / axis_strides_.at(axis.getName())) %
+                        mesh_.getAxisSize(axis.getName());
+        if (sdy::SubAxisInfoAttr sub_axis_info = axis.getSubAxisInfo()) {
+          index = (index / sub_axis_info.getPreSize()) %
+                  sub_axis_info.getSize();
+        }
+        shard_indices[dim] = shard_indices[dim] * axis.getSize(mesh_) + index;
+      }
+    }
+    return shard_indices;
+  }
+
+  // Returns the start and limit indices of the shard with `shard_indices`.
+  void GetShardBounds(ArrayRef<int64_t> shard_indices,
+                      SmallVector<int64_t>& start_indices,
+                      SmallVector<int64_t>& limit_indices) const {
+    start_indices.clear();
+    limit_indices.clear();
+    for (auto [dim, shard_index] : llvm::enumerate(shard_indices)) {
+      int64_t start = std::min(shard_index * shard_sizes_[dim],
+                               global_type_.getDimSize(dim));
+      start_indices.push_back(start);
+      limit_indices.push_back(std::min(start + shard_sizes_[dim],
+                                       global_type_.getDimSize(dim)));
+    }
+  }
+
+ private:
+  RankedTensorType global_type_;
+  TensorShardingAttr sharding_or_null_;
+  MeshAttr mesh_;
+  // The stride of each axis in the device indices of the mesh.
+  llvm::StringMap<int64_t> axis_strides_;
+  // The size of a shard of each dimension, where the last shard may be
+  // smaller.
+  SmallVector<int64_t> shard_sizes_;
+};
+
+}  // namespace
+
+std::vector<TransferSlice> ComputeTransferPlan(
+    RankedTensorType global_type, TensorShardingAttr src_sharding_or_null,
+    MeshAttr src_mesh, TensorShardingAttr dst_sharding_or_null,
+    MeshAttr dst_mesh) {
+  TensorShards src_shards(global_type, src_sharding_or_null, src_mesh);
+  TensorShards dst_shards(global_type, dst_sharding_or_null, dst_mesh);
+
+  // The devices that hold each distinct shard of the source, in order.
+  std::map<SmallVector<int64_t>, SmallVector<int64_t>> src_shard_to_devices;
+  for (int64_t device_index = 0; device_index < src_shards.GetNumDevices();
+       ++device_index) {
+    src_shard_to_devices[src_shards.GetShardIndices(device_index)].push_back(
+        device_index);
+  }
+
+  std::vector<TransferSlice> plan;
+  SmallVector<int64_t> dst_start, dst_limit, src_start, src_limit;
+  for (int64_t dst_index = 0; dst_index < dst_shards.GetNumDevices();
+       ++dst_index) {
+    dst_shards.GetShardBounds(dst_shards.GetShardIndices(dst_index), dst_start,
+                              dst_limit);
+    int64_t first_slice = plan.size();
+    for (const auto& [src_shard, src_devices] : src_shard_to_devices) {
+      src_shards.GetShardBounds(src_shard, src_start, src_limit);
+      TransferSlice slice;
+      bool is_empty = false;
+      for (int64_t dim = 0; dim < global_type.getRank(); ++dim) {
+        slice.start_indices.push_back(std::max(src_start[dim], dst_start[dim]));
+        slice.limit_indices.push_back(std::min(src_limit[dim], dst_limit[dim]));
+        is_empty |= slice.start_indices[dim] >= slice.limit_indices[dim];
+      }
+      if (is_empty) {
+        continue;
+      }
+      slice.src_device = src_shards.GetDeviceId(
+          src_devices[dst_index % src_devices.size()]);
+      slice.dst_device = dst_shards.GetDeviceId(dst_index);
+      plan.push_back(std::move(slice));
+    }
+    std::sort(plan.begin() + first_slice, plan.end(),
+              [](const TransferSlice& a, const TransferSlice& b) {
+                return a.src_device < b.src_device;
+              });
+  }
+  return plan;
+}
+
+ArrayAttr GetTransferPlanAttr(MLIRContext* context,
+                              ArrayRef<TransferSlice> plan) {
+  Builder builder(context);
+  SmallVector<Attribute> slices;
+  slices.reserve(plan.size());
+  for (const TransferSlice& slice : plan) {
+    slices.push_back(builder.getDictionaryAttr({
+        builder.getNamedAttr("src_device",
+                             builder.getI64IntegerAttr(slice.src_device)),
+        builder.getNamedAttr("dst_device",
+                             builder.getI64IntegerAttr(slice.dst_device)),
+        builder.getNamedAttr("start_indices",
+                             builder.getDenseI64ArrayAttr(slice.start_indices)),
+        builder.getNamedAttr("limit_indices",
+                             builder.getDenseI64ArrayAttr(slice.limit_indices)),
+    }));
+  }
+  return builder.getArrayAttr(slices);
+}
+
+}  // namespace mlir::mpmd
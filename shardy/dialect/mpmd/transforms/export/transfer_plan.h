@@ -0,0 +1,62 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_TRANSFER_PLAN_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_TRANSFER_PLAN_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+
+namespace mlir::mpmd {
+
+// A slice of a tensor sent by a resharding transfer from a device of the source
+// mesh to a device of the destination mesh. The slice is given by its start and
+// limit indices in the global tensor, as in `stablehlo.slice`.
+struct TransferSlice {
+  // The ids of the devices, as in the device ids of their meshes.
+  int64_t src_device;
+  int64_t dst_device;
+  SmallVector<int64_t> start_indices;
+  SmallVector<int64_t> limit_indices;
+};
+
+// Returns the device-to-device plan of a transfer of a tensor of
+// `global_type`, from `src_mesh` sharded with `src_sharding_or_null`, to
+// `dst_mesh` sharded with `dst_sharding_or_null`: for each destination device,
+// the slices it receives and which source device sends each of them, so that
+// no collective is needed on either mesh.
+//
+// When a slice is replicated on several source devices, the source devices
+// take turns sending it to successive destination devices, to spread the
+// sends. The slices are ordered by destination device, then by source device.
+std::vector<TransferSlice> ComputeTransferPlan(
+    RankedTensorType global_type, sdy::TensorShardingAttr src_sharding_or_null,
+    sdy::MeshAttr src_mesh, sdy::TensorShardingAttr dst_sharding_or_null,
+    sdy::MeshAttr dst_mesh);
+
+// Returns `plan` as an array of dictionaries, with the `src_device`,
+// `dst_device`, `start_indices` and `limit_indices` of each slice.
+ArrayAttr GetTransferPlanAttr(MLIRContext* context,
+                              ArrayRef<TransferSlice> plan);
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_TRANSFER_PLAN_H_
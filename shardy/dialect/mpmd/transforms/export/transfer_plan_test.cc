@@ -0,0 +1,106 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/export/transfer_plan.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "mlir/AsmParser/AsmParser.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mlir::mpmd {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::FieldsAre;
+
+class TransferPlanTest : public ::testing::Test {
+ protected:
+  TransferPlanTest() { context_.loadDialect<sdy::SdyDialect>(); }
+
+  sdy::MeshAttr ParseMesh(StringRef mesh) {
+    return cast<sdy::MeshAttr>(parseAttribute(mesh, &context_));
+  }
+
+  sdy::TensorShardingAttr ParseSharding(StringRef sharding) {
+    return cast<sdy::TensorShardingAttr>(parseAttribute(sharding, &context_));
+  }
+
+  RankedTensorType GetTensorType(ArrayRef<int64_t> shape) {
+    return RankedTensorType::get(shape, Float32Type::get(&context_));
+  }
+
+  MLIRContext context_;
+};
+
+TEST_F(TransferPlanTest, ShardedOnDifferentDimensions) {
+  sdy::MeshAttr mesh = ParseMesh(R"(#sdy.mesh<["x"=2]>)");
+  std::vector<TransferSlice> plan = ComputeTransferPlan(
+      GetTensorType({4, 8}),
+      ParseSharding(R"(#sdy.sharding<@mesh, [{"x"}, {}]>)"), mesh,
+      ParseSharding(R"(#sdy.sharding<@mesh, [{}, {"x"}]>)"), mesh);
+
+  // Each destination device receives a quarter of the tensor from each source
+  // device.
+  EXPECT_THAT(plan, ElementsAre(FieldsAre(0, 0, ElementsAre(0, 0),
+                                          ElementsAre(2, 4)),
+                                FieldsAre(1, 0, ElementsAre(2, 0),
+                                          ElementsAre(4, 4)),
+                                FieldsAre(0, 1, ElementsAre(0, 4),
+                                          ElementsAre(2, 8)),
+                                FieldsAre(1, 1, ElementsAre(2, 4),
+                                          ElementsAre(4, 8))));
+}
+
+TEST_F(TransferPlanTest, ReplicatedSourceSendsFromEachReplica) {
+  std::vector<TransferSlice> plan = ComputeTransferPlan(
+      GetTensorType({4, 8}), /*src_sharding_or_null=*/nullptr,
+      ParseMesh(R"(#sdy.mesh<["x"=2]>)"),
+      ParseSharding(R"(#sdy.sharding<@mesh, [{"y"}, {}]>)"),
+      ParseMesh(R"(#sdy.mesh<["y"=4], device_ids=[3, 2, 1, 0]>)"));
+
+  // The replicas of the source take turns, and the destination devices are
+  // given by the device ids of the mesh.
+  EXPECT_THAT(plan, ElementsAre(FieldsAre(0, 3, ElementsAre(0, 0),
+                                          ElementsAre(1, 8)),
+                                FieldsAre(1, 2, ElementsAre(1, 0),
+                                          ElementsAre(2, 8)),
+                                FieldsAre(0, 1, ElementsAre(2, 0),
+                                          ElementsAre(3, 8)),
+                                FieldsAre(1, 0, ElementsAre(3, 0),
+                                          ElementsAre(4, 8))));
+}
+
+TEST_F(TransferPlanTest, NonDivisibleShardsSkipEmptySlices) {
+  std::vector<TransferSlice> plan = ComputeTransferPlan(
+      GetTensorType({3}), ParseSharding(R"(#sdy.sharding<@mesh, [{"x"}]>)"),
+      ParseMesh(R"(#sdy.mesh<["x"=4]>)"), /*dst_sharding_or_null=*/nullptr,
+      ParseMesh(R"(#sdy.mesh<["y"=1]>)"));
+
+  // The last source device only holds padding, so it sends nothing.
+  EXPECT_THAT(plan,
+              ElementsAre(FieldsAre(0, 0, ElementsAre(0), ElementsAre(1)),
+                          FieldsAre(1, 0, ElementsAre(1), ElementsAre(2)),
+                          FieldsAre(2, 0, ElementsAre(2), ElementsAre(3))));
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
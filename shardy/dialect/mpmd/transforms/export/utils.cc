@@ -15,11 +15,16 @@ limitations under the License.
 
 #include "shardy/dialect/mpmd/transforms/export/utils.h"
 
+#include <cstdint>
+
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
 
 namespace mlir::mpmd {
 
@@ -66,4 +71,23 @@ OperandLastUseMap OperandsForDeletionMapping(FuncOp main_func) {
   return last_use_map;
 }
 
+RankedTensorType LocalTensorTypeCache::GetLocalTensorType(
+    MeshTensorType type) {
+  return GetOrCreateEntry(type).local_type;
+}
+
+int64_t LocalTensorTypeCache::GetSizeInBytes(MeshTensorType type) {
+  return GetOrCreateEntry(type).size_in_bytes;
+}
+
+const LocalTensorTypeCache::Entry& LocalTensorTypeCache::GetOrCreateEntry(
+    MeshTensorType type) {
+  auto [it, inserted] = entries_.try_emplace(type);
+  if (inserted) {
+    RankedTensorType local_type = type.getLocalTensorType(func_op_);
+    it->second = Entry{local_type, GetSizeInBytes(local_type)};
+  }
+  return it->second;
+}
+
 }  // namespace mlir::mpmd
@@ -16,12 +16,20 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_UTILS_H_
 #define SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_UTILS_H_
 
+#include <cstdint>
+
+#include "llvm/ADT/DenseMap.h"
 #include "mlir/Analysis/Liveness.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
 #include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/Types.h"
 #include "mlir/IR/Value.h"
+#include "mlir/Pass/AnalysisManager.h"
 #include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/fragment_arg_res_attrs.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
 
@@ -44,6 +52,16 @@ constexpr StringRef kBufferDonationAttrName = "jax.buffer_donor";
 // compiling each fragment.
 constexpr StringRef kReservedHbmBytes = "reserved_hbm_bytes";
 
+// Name of the attribute with the fingerprint of a fragment function, i.e., a
+// hash of its contents that is stable across processes, which can be used to
+// key a persistent cache of compiled fragments.
+constexpr StringRef kFragmentFingerprintAttr = "mpmd.fingerprint";
+
+// Name of the attribute with the device-to-device plan of a resharding
+// transfer, i.e., the slices each device of the destination mesh receives from
+// the devices of the source mesh. See `ComputeTransferPlan`.
+constexpr StringRef kTransferPlanAttr = "mpmd.transfer_plan";
+
 // Returns a map from user-marked block arguments to their target output index
 // as specified by the tf.aliasing_output attribute.
 DenseMap<BlockArgument, unsigned> GetAliasedBlockArguments(
@@ -64,6 +82,44 @@ DenseSet<BlockArgument> GetDonatedBlockArguments(
 DenseMap<Operation*, SmallVector<unsigned int>>
 OperandsForDeletionMapping(func::FuncOp main_func);
 
+// Caches the local tensor type of each mesh tensor type used in a function,
+// and its size in bytes, so that the mesh of the sharding of a type, which is
+// looked up by symbol, is resolved only once per distinct type rather than
+// once per value.
+//
+// Passes that simulate memory query the size of every value many times, e.g.,
+// once per simulation, so they should share this cache as an analysis. Types
+// are immutable and the meshes of a function don't change after import, so
+// the cache is never invalidated; a type added by a later pass is resolved the
+// first time it is queried.
+class LocalTensorTypeCache {
+ public:
+  // Caches the local types of the function `op`.
+  explicit LocalTensorTypeCache(Operation* op)
+      : func_op_(cast<func::FuncOp>(op)) {}
+
+  RankedTensorType GetLocalTensorType(MeshTensorType type);
+
+  // Returns the size of the local tensor type of `type` in bytes, with
+  // sub-byte element types rounded up to a whole byte.
+  int64_t GetSizeInBytes(MeshTensorType type);
+
+  bool isInvalidated(const AnalysisManager::PreservedAnalyses&) {
+    return false;
+  }
+
+ private:
+  struct Entry {
+    RankedTensorType local_type;
+    int64_t size_in_bytes;
+  };
+
+  const Entry& GetOrCreateEntry(MeshTensorType type);
+
+  func::FuncOp func_op_;
+  DenseMap<Type, Entry> entries_;
+};
+
 // Checks the arg attrs of the op to see if the arg is on the host.
 inline bool IsArgOnHost(Operation* op, int index) {
   return GetArgAttr(op, index, kMemoryKindAttr) ==
@@ -18,6 +18,7 @@ limitations under the License.
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/OwningOpRef.h"
@@ -109,5 +110,51 @@ TEST(OperandsForDeletionMapping,
                   Pair(OperationIsAReturnOp(), UnorderedElementsAre(0, 1, 2))));
 }
 
+const char kProgramWithShardedTensors[] = R"mlir(
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_1_tensor_dist_x = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>, sharding=<@m1, [{"x"}, {?}]>>
+!mesh_1_tensor_i1 = !mpmd.mesh_tensor<"m1", tensor<3xi1>>
+sdy.mesh @m1 = <["x"=4]>
+func.func @main(%arg0: !mesh_1_tensor, %arg1: !mesh_1_tensor_dist_x, %arg2: !mesh_1_tensor_dist_x, %arg3: !mesh_1_tensor_i1)
+  -> !mesh_1_tensor attributes {"topology"=#mpmd.topology<<"m1": <["x"=4]>>>} {
+  func.return %arg0 : !mesh_1_tensor
+}
+  )mlir";
+
+TEST(LocalTensorTypeCache, ShouldReturnLocalTypeAndSize) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgramWithShardedTensors, &context);
+  FuncOp func_op = GetMainFunction(*module);
+  LocalTensorTypeCache cache(func_op);
+
+  auto arg_type = [&](int index) {
+    return cast<MeshTensorType>(func_op.getArgument(index).getType());
+  };
+  EXPECT_EQ(cache.GetLocalTensorType(arg_type(0)),
+            RankedTensorType::get({4, 8}, Float32Type::get(&context)));
+  EXPECT_EQ(cache.GetSizeInBytes(arg_type(0)), 128);
+  EXPECT_EQ(cache.GetLocalTensorType(arg_type(1)),
+            RankedTensorType::get({1, 8}, Float32Type::get(&context)));
+  EXPECT_EQ(cache.GetSizeInBytes(arg_type(1)), 32);
+  // Sub-byte element types are rounded up to a whole byte.
+  EXPECT_EQ(cache.GetSizeInBytes(arg_type(3)), 1);
+}
+
+TEST(LocalTensorTypeCache, ShouldMatchUncachedLocalTypeForRepeatedTypes) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgramWithShardedTensors, &context);
+  FuncOp func_op = GetMainFunction(*module);
+  LocalTensorTypeCache cache(func_op);
+
+  for (BlockArgument arg : func_op.getArguments()) {
+    auto type = cast<MeshTensorType>(arg.getType());
+    EXPECT_EQ(cache.GetLocalTensorType(type), type.getLocalTensorType(func_op));
+  }
+}
+
 }  // namespace
 }  // namespace mlir::mpmd
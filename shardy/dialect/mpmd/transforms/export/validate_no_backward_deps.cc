@@ -13,19 +13,24 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <memory>
 #include <string>
+#include <utility>
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Support/LLVM.h"
-#include "mlir/Support/WalkResult.h"
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/common/validation.h"
 #include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/validation_checks.h"
 
 namespace mlir::mpmd {
 
@@ -34,18 +39,10 @@ namespace mlir::mpmd {
 
 namespace {
 
-bool IsAllForward(func::FuncOp func) {
-  bool is_all_forward = true;
-  func.walk([&](FragmentCallOp fragment_call) {
-    for (Attribute attr : fragment_call.getOrigin().getValue()) {
-      if (cast<UserOriginAttr>(attr).getTransposeCount() != 0) {
-        is_all_forward = false;
-        return WalkResult::interrupt();
-      }
-    }
-    return WalkResult::advance();
+bool IsForward(FragmentCallOp fragment_call) {
+  return llvm::all_of(fragment_call.getOrigin().getValue(), [](Attribute attr) {
+    return cast<UserOriginAttr>(attr).getTransposeCount() == 0;
   });
-  return is_all_forward;
 }
 
 FragmentCallOp FindProducerFragmentCall(Value operand) {
@@ -71,52 +68,85 @@ class ValidateNoBackwardDepsPass
 
  protected:
   void runOnFunc(func::FuncOp func) override {
-    if (!IsMpmdFunction(func)) {
+    ValidationWalker walker;
+    AddNoBackwardDepsCheck(func, failOnBackwardDeps, walker);
+    if (failed(walker.Walk(func))) {
+      signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+void AddNoBackwardDepsCheck(func::FuncOp func, bool fail_on_backward_deps,
+                            ValidationWalker& walker) {
+  if (!IsMpmdFunction(func)) {
+    return;
+  }
+
+  // Whether the program is forward-only is only known once all fragment calls
+  // are visited, so the backward dependencies are collected during the walk
+  // and reported by the finalizer.
+  struct State {
+    bool is_all_forward = true;
+    // Pairs of (producer, consumer) with a backward dependency.
+    SmallVector<std::pair<FragmentCallOp, FragmentCallOp>> backward_deps;
+  };
+  auto state = std::make_shared<State>();
+
+  walker.AddVisitor<FragmentCallOp>([state](FragmentCallOp consumer) {
+    if (!state->is_all_forward) {
+      return;
+    }
+    if (!IsForward(consumer)) {
+      state->is_all_forward = false;
+      state->backward_deps.clear();
       return;
     }
-    if (!IsAllForward(func)) {
-      if (failOnBackwardDeps) {
+    for (Value operand : consumer.getArgOperands()) {
+      FragmentCallOp producer = FindProducerFragmentCall(operand);
+      if (!producer) {
+        continue;
+      }
+      if (!IsMeshBeforeOtherMesh(producer.getMeshName(),
+                                 consumer.getMeshName()) &&
+          producer.getMeshName() != consumer.getMeshName()) {
+        state->backward_deps.emplace_back(producer, consumer);
+      }
+    }
+  });
+
+  walker.AddFinalizer([func, fail_on_backward_deps, state, &walker]() {
+    if (!state->is_all_forward) {
+      if (fail_on_backward_deps) {
         func.emitError()
             << "Expected forward-only program but found non-forward fragments.";
-        signalPassFailure();
+        walker.SignalFailure();
       }
       return;
     }
 
-    func.walk([&](FragmentCallOp consumer) {
-      for (Value operand : consumer.getArgOperands()) {
-        FragmentCallOp producer = FindProducerFragmentCall(operand);
-        if (!producer) {
-          continue;
-        }
-
-        if (!IsMeshBeforeOtherMesh(producer.getMeshName(),
-                                    consumer.getMeshName()) &&
-            producer.getMeshName() != consumer.getMeshName()) {
-          std::string msg;
-          llvm::raw_string_ostream os(msg);
-          os << "Detected backward dependency but expected forward-only "
-                "pipeline since there are no transpose fragments: "
-             << "fragment \"" << producer.getCallee() << "\" mesh=\""
-             << producer.getMeshName()
-             << "\" produces a value consumed by fragment \""
-             << consumer.getCallee() << "\" mesh=\"" << consumer.getMeshName()
-             << "\". In a forward-only pipeline, dependencies must go from "
-             << "earlier meshes to later meshes.";
-
-          SDY_LOG(WARNING) << msg;
-          auto diag = failOnBackwardDeps ? consumer.emitError()
-                                         : consumer.emitWarning();
-          diag << msg;
-          if (failOnBackwardDeps) {
-            signalPassFailure();
-          }
-        }
+    for (auto [producer, consumer] : state->backward_deps) {
+      std::string msg;
+      llvm::raw_string_ostream os(msg);
+      os << "Detected backward dependency but expected forward-only "
+            "pipeline since there are no transpose fragments: "
+         << "fragment \"" << producer.getCallee() << "\" mesh=\""
+         << producer.getMeshName()
+         << "\" produces a value consumed by fragment \""
+         << consumer.getCallee() << "\" mesh=\"" << consumer.getMeshName()
+         << "\". In a forward-only pipeline, dependencies must go from "
+         << "earlier meshes to later meshes.";
+
+      SDY_LOG(WARNING) << msg;
+      auto diag =
+          fail_on_backward_deps ? consumer.emitError() : consumer.emitWarning();
+      diag << msg;
+      if (fail_on_backward_deps) {
+        walker.SignalFailure();
       }
-    });
-  }
-};
-
-}  // namespace
+    }
+  });
+}
 
 }  // namespace mlir::mpmd
@@ -25,7 +25,9 @@ limitations under the License.
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/common/validation.h"
 #include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/validation_checks.h"
 
 namespace mlir::mpmd {
 
@@ -43,57 +45,68 @@ class ValidateNoInferredFragmentsPass
 
  protected:
   void runOnFunc(func::FuncOp func) override {
-    func.walk([&](FragmentOp fragment) {
-      if (fragment.isUserFragment()) {
-        return;
-      }
-
-      ArrayAttr inferredByAttr =
-          fragment->getAttrOfType<ArrayAttr>(kInferredByAttr);
-      if (!inferredByAttr || inferredByAttr.empty()) {
-        fragment.emitError() << "Internal error: inferred fragment missing '"
-                             << kInferredByAttr << "' attribute";
-        return signalPassFailure();
-      }
-
-      std::string msg;
-      llvm::raw_string_ostream os(msg);
-      os << "Inferred fragment has not been merged (inferred by ";
-      llvm::interleaveComma(inferredByAttr, os, [&](Attribute attr) {
-        os << cast<StringAttr>(attr).getValue();
-      });
-      os << ")";
-
-      // TODO(b/495822074): Remove uniquify exception.
-      // TODO(b/513145099): Remove infer_mesh_wrap_meshless_ops exception.
-      // TODO(b/513153410): Remove extract_reshards exception.
-      // TODO(b/517436254): Remove remaining exceptions
-      if (llvm::any_of(inferredByAttr, [](Attribute attr) {
-            StringRef value = cast<StringAttr>(attr).getValue();
-            return value == "uniquify" ||
-                   value == "infer_mesh_wrap_meshless_ops" ||
-                   value == "extract_reshards" ||
-                   value == "infer_mesh_wrap_resultless_ops" ||
-                   value == "infer_mesh_convert_reduce_ops" ||
-                   value == "introduce_transfers";
-          })) {
-        SDY_LOG(WARNING) << msg;
-        fragment.emitWarning() << msg;
-        return;
-      }
-
-      SDY_LOG(WARNING) << msg;
-      InFlightDiagnostic diag = failOnInferredFragments
-                                    ? fragment.emitError()
-                                    : fragment.emitWarning();
-      diag << msg;
-      if (failOnInferredFragments) {
-        signalPassFailure();
-      }
-    });
+    ValidationWalker walker;
+    AddNoInferredFragmentsCheck(func, failOnInferredFragments, walker);
+    if (failed(walker.Walk(func))) {
+      signalPassFailure();
+    }
   }
 };
 
 }  // namespace
 
+void AddNoInferredFragmentsCheck(func::FuncOp func,
+                                 bool fail_on_inferred_fragments,
+                                 ValidationWalker& walker) {
+  walker.AddVisitor<FragmentOp>([fail_on_inferred_fragments,
+                                 &walker](FragmentOp fragment) {
+    if (fragment.isUserFragment()) {
+      return;
+    }
+
+    ArrayAttr inferredByAttr =
+        fragment->getAttrOfType<ArrayAttr>(kInferredByAttr);
+    if (!inferredByAttr || inferredByAttr.empty()) {
+      fragment.emitError() << "Internal error: inferred fragment missing '"
+                           << kInferredByAttr << "' attribute";
+      return walker.SignalFailure();
+    }
+
+    std::string msg;
+    llvm::raw_string_ostream os(msg);
+    os << "Inferred fragment has not been merged (inferred by ";
+    llvm::interleaveComma(inferredByAttr, os, [&](Attribute attr) {
+      os << cast<StringAttr>(attr).getValue();
+    });
+    os << ")";
+
+    // TODO(b/495822074): Remove uniquify exception.
+    // TODO(b/513145099): Remove infer_mesh_wrap_meshless_ops exception.
+    // TODO(b/513153410): Remove extract_reshards exception.
+    // TODO(b/517436254): Remove remaining exceptions
+    if (llvm::any_of(inferredByAttr, [](Attribute attr) {
+          StringRef value = cast<StringAttr>(attr).getValue();
+          return value == "uniquify" ||
+                 value == "infer_mesh_wrap_meshless_ops" ||
+                 value == "extract_reshards" ||
+                 value == "infer_mesh_wrap_resultless_ops" ||
+                 value == "infer_mesh_convert_reduce_ops" ||
+                 value == "introduce_transfers";
+        })) {
+      SDY_LOG(WARNING) << msg;
+      fragment.emitWarning() << msg;
+      return;
+    }
+
+    SDY_LOG(WARNING) << msg;
+    InFlightDiagnostic diag = fail_on_inferred_fragments
+                                  ? fragment.emitError()
+                                  : fragment.emitWarning();
+    diag << msg;
+    if (fail_on_inferred_fragments) {
+      walker.SignalFailure();
+    }
+  });
+}
+
 }  // namespace mlir::mpmd
@@ -25,7 +25,9 @@ limitations under the License.
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/common/validation.h"
 #include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/validation_checks.h"
 
 namespace mlir::mpmd {
 
@@ -49,64 +51,75 @@ class ValidateNoParamTransfersPass
 
  protected:
   void runOnFunc(func::FuncOp func) override {
-    if (!IsMpmdFunction(func)) {
-      return;
+    ValidationWalker walker;
+    AddNoParamTransfersCheck(func, paramPattern, failOnParamTransfers, walker);
+    if (failed(walker.Walk(func))) {
+      signalPassFailure();
     }
+  }
+};
 
-    StringRef pattern(paramPattern);
-    func.walk([&](TransferOp transfer) {
-      if (transfer.isIntraMesh()) {
-        return;
-      }
+}  // namespace
 
-      Location operand_loc = transfer.getTensor().getLoc();
-      Location transfer_loc = transfer.getLoc();
-      if (!LocationContainsPattern(operand_loc, pattern) &&
-          !LocationContainsPattern(transfer_loc, pattern)) {
-        return;
-      }
+void AddNoParamTransfersCheck(func::FuncOp func, StringRef param_pattern,
+                              bool fail_on_param_transfers,
+                              ValidationWalker& walker) {
+  if (!IsMpmdFunction(func)) {
+    return;
+  }
 
-      auto src_mesh = transfer.getTensor().getType().getMeshName();
-      auto dst_mesh = transfer.getResult().getType().getMeshName();
+  walker.AddVisitor<TransferOp>([pattern = param_pattern.str(),
+                                 fail_on_param_transfers,
+                                 &walker](TransferOp transfer) {
+    if (transfer.isIntraMesh()) {
+      return;
+    }
 
-      // Collect only the NameLoc names that match the pattern for a concise
-      // error message. Use SetVector to deduplicate while preserving order.
-      llvm::SetVector<StringRef> matching_names;
-      if (auto name_loc = dyn_cast<NameLoc>(operand_loc)) {
-        if (name_loc.getName().getValue().contains(pattern)) {
-          matching_names.insert(name_loc.getName().getValue());
-        }
-      }
-      if (auto name_loc = dyn_cast<NameLoc>(transfer_loc)) {
-        if (name_loc.getName().getValue().contains(pattern)) {
-          matching_names.insert(name_loc.getName().getValue());
-        }
-      }
+    Location operand_loc = transfer.getTensor().getLoc();
+    Location transfer_loc = transfer.getLoc();
+    if (!LocationContainsPattern(operand_loc, pattern) &&
+        !LocationContainsPattern(transfer_loc, pattern)) {
+      return;
+    }
+
+    auto src_mesh = transfer.getTensor().getType().getMeshName();
+    auto dst_mesh = transfer.getResult().getType().getMeshName();
 
-      std::string msg;
-      llvm::raw_string_ostream os(msg);
-      os << "Detected cross-mesh transfer of a parameter matching \"" << pattern
-         << "\" from mesh \"" << src_mesh << "\" to \"" << dst_mesh
-         << "\". JAX locations: [";
-      bool first = true;
-      for (StringRef name : matching_names) {
-        if (!first) os << ", ";
-        os << "\"" << name << "\"";
-        first = false;
+    // Collect only the NameLoc names that match the pattern for a concise
+    // error message. Use SetVector to deduplicate while preserving order.
+    llvm::SetVector<StringRef> matching_names;
+    if (auto name_loc = dyn_cast<NameLoc>(operand_loc)) {
+      if (name_loc.getName().getValue().contains(pattern)) {
+        matching_names.insert(name_loc.getName().getValue());
       }
-      os << "]";
-
-      SDY_LOG(WARNING) << msg;
-      auto diag = failOnParamTransfers ? transfer.emitError()
-                                       : transfer.emitWarning();
-      diag << msg;
-      if (failOnParamTransfers) {
-        signalPassFailure();
+    }
+    if (auto name_loc = dyn_cast<NameLoc>(transfer_loc)) {
+      if (name_loc.getName().getValue().contains(pattern)) {
+        matching_names.insert(name_loc.getName().getValue());
       }
-    });
-  }
-};
+    }
 
-}  // namespace
+    std::string msg;
+    llvm::raw_string_ostream os(msg);
+    os << "Detected cross-mesh transfer of a parameter matching \"" << pattern
+       << "\" from mesh \"" << src_mesh << "\" to \"" << dst_mesh
+       << "\". JAX locations: [";
+    bool first = true;
+    for (StringRef name : matching_names) {
+      if (!first) os << ", ";
+      os << "\"" << name << "\"";
+      first = false;
+    }
+    os << "]";
+
+    SDY_LOG(WARNING) << msg;
+    auto diag = fail_on_param_transfers ? transfer.emitError()
+                                        : transfer.emitWarning();
+    diag << msg;
+    if (fail_on_param_transfers) {
+      walker.SignalFailure();
+    }
+  });
+}
 
 }  // namespace mlir::mpmd
@@ -18,6 +18,7 @@ limitations under the License.
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/SymbolTable.h"
@@ -26,7 +27,9 @@ limitations under the License.
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/common/validation.h"
 #include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/validation_checks.h"
 
 namespace mlir::mpmd {
 
@@ -35,100 +38,110 @@ namespace mlir::mpmd {
 
 namespace {
 
+bool IsReshardOnly(func::FuncOp callee) {
+  Block& body = callee.getBody().front();
+  if (!llvm::hasSingleElement(body)) {
+    return false;
+  }
+  auto returnOp = dyn_cast<func::ReturnOp>(body.front());
+  if (!returnOp) {
+    return false;
+  }
+  return llvm::all_of(returnOp.getOperands(),
+                      [](Value v) { return isa<BlockArgument>(v); });
+}
+
 class ValidateNoReshardsPass
     : public impl::ValidateNoReshardsPassBase<ValidateNoReshardsPass> {
   using ValidateNoReshardsPassBase::ValidateNoReshardsPassBase;
 
  protected:
   void runOnFunc(func::FuncOp func) override {
-    func.walk([&](FragmentCallOp callOp) {
-      auto callee = SymbolTable::lookupNearestSymbolFrom<func::FuncOp>(
-          callOp, callOp.getCalleeAttr());
-      if (!callee || !isReshardOnly(callee)) {
-        return;
-      }
+    ValidationWalker walker;
+    AddNoReshardsCheck(func, failOnReshardOnlyFragments, walker);
+    if (failed(walker.Walk(func))) {
+      signalPassFailure();
+    }
+  }
+};
 
-      // Reshard-only fragments should always be inferred, never user-defined.
-      if (!callOp.getOrigin().empty()) {
-        callOp.emitError() << "Internal error: reshard-only fragment '"
-                           << callOp.getCallee()
-                           << "' is not an inferred fragment";
-        return signalPassFailure();
-      }
+}  // namespace
 
-      std::string msg;
-      llvm::raw_string_ostream os(msg);
-      os << "Detected reshard-only fragment '" << callOp.getCallee()
-         << "'. This usually indicates an unexpected reshard. Operands: ";
-
-      auto printShardingAndShape = [](Type type, llvm::raw_ostream& stream) {
-        auto meshType = cast<MeshTensorType>(type);
-        if (auto sharding = meshType ? meshType.getSharding() : nullptr) {
-          stream << sharding;
-        } else {
-          stream << "Replicated";
-        }
+void AddNoReshardsCheck(func::FuncOp func, bool fail_on_reshard_only_fragments,
+                        ValidationWalker& walker) {
+  walker.AddVisitor<FragmentCallOp>([func, fail_on_reshard_only_fragments,
+                                     &walker](FragmentCallOp callOp) {
+    auto callee = SymbolTable::lookupNearestSymbolFrom<func::FuncOp>(
+        callOp, callOp.getCalleeAttr());
+    if (!callee || !IsReshardOnly(callee)) {
+      return;
+    }
+
+    // Reshard-only fragments should always be inferred, never user-defined.
+    if (!callOp.getOrigin().empty()) {
+      callOp.emitError() << "Internal error: reshard-only fragment '"
+                         << callOp.getCallee()
+                         << "' is not an inferred fragment";
+      return walker.SignalFailure();
+    }
 
-        RankedTensorType rankedType = meshType.getRankedTensorType();
-
-        stream << " <";
-        llvm::interleave(rankedType.getShape(), stream, "x");
-        stream << "x" << rankedType.getElementType() << ">";
-      };
-
-      llvm::interleaveComma(
-          llvm::zip(callOp.getOperands(), callOp.getOperandTypes()), os,
-          [&](auto pair) {
-            auto [operand, type] = pair;
-            printShardingAndShape(type, os);
-            os << " " << operand.getLoc();
-          });
-      os << ". Results: ";
-      bool first = true;
-      for (auto [result, type] :
-           llvm::zip(callOp.getResults(), callOp.getResultTypes())) {
-        if (!first) {
-          os << ", ";
+    std::string msg;
+    llvm::raw_string_ostream os(msg);
+    os << "Detected reshard-only fragment '" << callOp.getCallee()
+       << "'. This usually indicates an unexpected reshard. Operands: ";
+
+    auto printShardingAndShape = [](Type type, llvm::raw_ostream& stream) {
+      auto meshType = cast<MeshTensorType>(type);
+      if (auto sharding = meshType ? meshType.getSharding() : nullptr) {
+        stream << sharding;
+      } else {
+        stream << "Replicated";
+      }
+
+      RankedTensorType rankedType = meshType.getRankedTensorType();
+
+      stream << " <";
+      llvm::interleave(rankedType.getShape(), stream, "x");
+      stream << "x" << rankedType.getElementType() << ">";
+    };
+
+    llvm::interleaveComma(
+        llvm::zip(callOp.getOperands(), callOp.getOperandTypes()), os,
+        [&](auto pair) {
+          auto [operand, type] = pair;
+          printShardingAndShape(type, os);
+          os << " " << operand.getLoc();
+        });
+    os << ". Results: ";
+    bool first = true;
+    for (auto [result, type] :
+         llvm::zip(callOp.getResults(), callOp.getResultTypes())) {
+      if (!first) {
+        os << ", ";
+      }
+      first = false;
+      printShardingAndShape(type, os);
+      for (OpOperand& use : result.getUses()) {
+        auto returnOp = dyn_cast<func::ReturnOp>(use.getOwner());
+        if (!returnOp) {
+          continue;
         }
-        first = false;
-        printShardingAndShape(type, os);
-        for (OpOperand& use : result.getUses()) {
-          auto returnOp = dyn_cast<func::ReturnOp>(use.getOwner());
-          if (!returnOp) {
-            continue;
-          }
-          if (auto loc = GetResultInfoLoc(func, use.getOperandNumber())) {
-            os << " " << *loc;
-          }
+        if (auto loc = GetResultInfoLoc(func, use.getOperandNumber())) {
+          os << " " << *loc;
         }
       }
+    }
 
-      SDY_LOG(WARNING) << msg;
-      InFlightDiagnostic diag = failOnReshardOnlyFragments
-                                    ? callOp.emitError()
-                                    : callOp.emitWarning();
-      diag << msg;
-
-      if (failOnReshardOnlyFragments) {
-        signalPassFailure();
-      }
-    });
-  }
+    SDY_LOG(WARNING) << msg;
+    InFlightDiagnostic diag = fail_on_reshard_only_fragments
+                                  ? callOp.emitError()
+                                  : callOp.emitWarning();
+    diag << msg;
 
-  static bool isReshardOnly(func::FuncOp callee) {
-    Block& body = callee.getBody().front();
-    if (!llvm::hasSingleElement(body)) {
-      return false;
-    }
-    auto returnOp = dyn_cast<func::ReturnOp>(body.front());
-    if (!returnOp) {
-      return false;
+    if (fail_on_reshard_only_fragments) {
+      walker.SignalFailure();
     }
-    return llvm::all_of(returnOp.getOperands(),
-                        [](Value v) { return isa<BlockArgument>(v); });
-  }
-};
-
-}  // namespace
+  });
+}
 
 }  // namespace mlir::mpmd
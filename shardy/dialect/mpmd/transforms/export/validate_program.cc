@@ -0,0 +1,57 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/transforms/common/validation.h"
+#include "shardy/dialect/mpmd/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/export/validation_checks.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_VALIDATEPROGRAMPASS
+#include "shardy/dialect/mpmd/transforms/export/passes.h.inc"
+
+namespace {
+
+class ValidateProgramPass
+    : public impl::ValidateProgramPassBase<ValidateProgramPass> {
+  using ValidateProgramPassBase::ValidateProgramPassBase;
+
+ protected:
+  void runOnFunc(func::FuncOp func) override {
+    ValidationWalker walker;
+    if (checkNoParamTransfers) {
+      AddNoParamTransfersCheck(func, paramPattern, failOnParamTransfers,
+                               walker);
+    }
+    if (checkNoInferredFragments) {
+      AddNoInferredFragmentsCheck(func, failOnInferredFragments, walker);
+    }
+    if (checkNoReshards) {
+      AddNoReshardsCheck(func, failOnReshardOnlyFragments, walker);
+    }
+    if (checkNoBackwardDeps) {
+      AddNoBackwardDepsCheck(func, failOnBackwardDeps, walker);
+    }
+    if (failed(walker.Walk(func))) {
+      signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+}  // namespace mlir::mpmd
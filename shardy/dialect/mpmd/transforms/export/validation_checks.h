@@ -0,0 +1,51 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_VALIDATION_CHECKS_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_VALIDATION_CHECKS_H_
+
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "shardy/dialect/mpmd/transforms/common/validation.h"
+
+namespace mlir::mpmd {
+
+// The checks of the export validation passes, which register their visitors
+// for `func_op` in `walker`, so that any subset of them runs in a single walk
+// of the function. Each check emits the same diagnostics as the pass of the
+// same name, and signals a failure in the same cases.
+
+// See `ValidateNoReshardsPass`.
+void AddNoReshardsCheck(func::FuncOp func_op,
+                        bool fail_on_reshard_only_fragments,
+                        ValidationWalker& walker);
+
+// See `ValidateNoBackwardDepsPass`.
+void AddNoBackwardDepsCheck(func::FuncOp func_op, bool fail_on_backward_deps,
+                            ValidationWalker& walker);
+
+// See `ValidateNoInferredFragmentsPass`.
+void AddNoInferredFragmentsCheck(func::FuncOp func_op,
+                                 bool fail_on_inferred_fragments,
+                                 ValidationWalker& walker);
+
+// See `ValidateNoParamTransfersPass`.
+void AddNoParamTransfersCheck(func::FuncOp func_op, StringRef param_pattern,
+                              bool fail_on_param_transfers,
+                              ValidationWalker& walker);
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_EXPORT_VALIDATION_CHECKS_H_
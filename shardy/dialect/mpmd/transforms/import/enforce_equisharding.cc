@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
+
+#include "llvm/ADT/STLExtras.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/PatternMatch.h"
@@ -23,6 +26,7 @@ limitations under the License.
 #include "shardy/dialect/mpmd/transforms/import/passes.h"  // IWYU pragma: keep
 #include "shardy/dialect/mpmd/transforms/import/sharding_constraints.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
 
 namespace mlir::mpmd {
 
@@ -31,6 +35,125 @@ namespace mlir::mpmd {
 
 namespace {
 
+using ::mlir::sdy::AxisRefAttr;
+using ::mlir::sdy::MeshAttr;
+using ::mlir::sdy::TensorShardingAttr;
+
+// Returns whether all axes of `sharding` exist in `mesh`, so that it can shard
+// a tensor on `mesh`. A null sharding, i.e., replicated, is valid on any mesh.
+bool IsValidOnMesh(TensorShardingAttr sharding, MeshAttr mesh) {
+  if (!sharding) {
+    return true;
+  }
+  auto is_valid = [&](AxisRefAttr axis) {
+    if (!mesh.hasAxis(axis.getName())) {
+      return false;
+    }
+    sdy::SubAxisInfoAttr sub_axis_info = axis.getSubAxisInfo();
+    return !sub_axis_info ||
+           mesh.getAxisSize(axis.getName()) %
+                   (sub_axis_info.getPreSize() * sub_axis_info.getSize()) ==
+               0;
+  };
+  return llvm::all_of(sharding.getDimShardings(),
+                      [&](sdy::DimensionShardingAttr dim_sharding) {
+                        return llvm::all_of(dim_sharding.getAxes(), is_valid);
+                      }) &&
+         llvm::all_of(sharding.getReplicatedAxes(), is_valid) &&
+         llvm::all_of(sharding.getUnreducedAxes(), is_valid);
+}
+
+// Returns the number of dimensions sharded differently by `lhs` and `rhs`,
+// where a null sharding is replicated.
+int64_t GetNumReshardedDims(TensorShardingAttr lhs, TensorShardingAttr rhs,
+                            int64_t rank) {
+  int64_t num_resharded_dims = 0;
+  for (int64_t dim = 0; dim < rank; ++dim) {
+    ArrayRef<AxisRefAttr> lhs_axes =
+        lhs ? lhs.getDimSharding(dim).getAxes() : ArrayRef<AxisRefAttr>();
+    ArrayRef<AxisRefAttr> rhs_axes =
+        rhs ? rhs.getDimSharding(dim).getAxes() : ArrayRef<AxisRefAttr>();
+    if (lhs_axes != rhs_axes) {
+      ++num_resharded_dims;
+    }
+  }
+  return num_resharded_dims;
+}
+
+// The cost of a candidate sharding for both ends of an equisharding
+// constraint.
+struct EquishardingCost {
+  // The per-device bytes of the value on the mesh of the input.
+  int64_t resident_bytes = 0;
+  // The number of dimensions along which the output is resharded, and the
+  // per-device bytes each device of the mesh of the input receives by
+  // resharding it.
+  int64_t num_resharded_dims = 0;
+  int64_t reshard_bytes = 0;
+
+  int64_t GetTotalBytes() const { return resident_bytes + reshard_bytes; }
+};
+
+// Returns the cost of giving `candidate` to both ends of a constraint between
+// an input of `input_type` and an output of `output_type`.
+EquishardingCost GetEquishardingCost(TensorShardingAttr candidate,
+                                     MeshTensorType input_type,
+                                     MeshAttr input_mesh,
+                                     MeshTensorType output_type) {
+  MeshTensorType candidate_type = MeshTensorType::get(
+      input_type.getContext(), input_type.getMeshName(),
+      input_type.getRankedTensorType(), candidate,
+      input_type.getMemoryKind());
+  EquishardingCost cost;
+  cost.resident_bytes = GetLocalSizeInBytes(candidate_type, input_mesh);
+  cost.num_resharded_dims =
+      GetNumReshardedDims(candidate, output_type.getSharding(),
+                          output_type.getRankedTensorType().getRank());
+  if (cost.num_resharded_dims > 0) {
+    cost.reshard_bytes = cost.resident_bytes;
+  }
+  return cost;
+}
+
+// Returns the type that both ends of `constraint` should take: the type of the
+// input, or the type of the input with the sharding of the output if that is
+// cheaper, in which case it emits a warning with the costs of both.
+MeshTensorType GetCheapestInputType(
+    func::FuncOp func_op, const InputOutputEquishardingConstraint& constraint,
+    MeshTensorType input_type, MeshTensorType output_type) {
+  TensorShardingAttr input_sharding = input_type.getSharding();
+  TensorShardingAttr output_sharding = output_type.getSharding();
+  if (input_sharding == output_sharding ||
+      input_type.getRankedTensorType() != output_type.getRankedTensorType()) {
+    return input_type;
+  }
+  MeshAttr input_mesh = GetMeshOrFail(func_op, input_type.getMeshName());
+  if (!IsValidOnMesh(output_sharding, input_mesh)) {
+    return input_type;
+  }
+  EquishardingCost input_cost = GetEquishardingCost(
+      input_sharding, input_type, input_mesh, output_type);
+  EquishardingCost output_cost = GetEquishardingCost(
+      output_sharding, input_type, input_mesh, output_type);
+  if (output_cost.GetTotalBytes() >= input_cost.GetTotalBytes()) {
+    return input_type;
+  }
+  emitWarning(func_op.getArgument(constraint.input_index).getLoc())
+      << "Equisharding constraint of input " << constraint.input_index
+      << " and output " << constraint.output_index
+      << " takes the sharding of the output, with "
+      << output_cost.resident_bytes << " bytes per device and "
+      << output_cost.num_resharded_dims << " resharded dimensions, over that "
+      << "of the input, with " << input_cost.resident_bytes
+      << " bytes per device and " << input_cost.num_resharded_dims
+      << " resharded dimensions, saving "
+      << input_cost.GetTotalBytes() - output_cost.GetTotalBytes()
+      << " bytes per device.";
+  return MeshTensorType::get(func_op.getContext(), input_type.getMeshName(),
+                             input_type.getRankedTensorType(), output_sharding,
+                             input_type.getMemoryKind());
+}
+
 // Enforces input-output equisharding constraints for MPMD functions by
 // introducing TransferOps when necessary.
 class EnforceEquishardingPass
@@ -51,6 +174,17 @@ class EnforceEquishardingPass
     for (const InputOutputEquishardingConstraint& constraint : constraints) {
       Type output_mesh_type = func_type.getResult(constraint.output_index);
       Type input_mesh_type = func_type.getInput(constraint.input_index);
+      auto input_type = dyn_cast<MeshTensorType>(input_mesh_type);
+      auto output_type = dyn_cast<MeshTensorType>(output_mesh_type);
+      if (costAwareSharding && input_type && output_type) {
+        MeshTensorType cheapest_type =
+            GetCheapestInputType(func_op, constraint, input_type, output_type);
+        if (cheapest_type != input_type) {
+          ++numOutputShardingsPicked;
+          func_op.getArgument(constraint.input_index).setType(cheapest_type);
+          input_mesh_type = cheapest_type;
+        }
+      }
       if (input_mesh_type != output_mesh_type) {
         Value new_operand =
             TransferOp::create(rewriter, func_ret->getLoc(), input_mesh_type,
@@ -44,11 +44,12 @@ MATCHER(IsTransferOp, "") { return isa<TransferOp>(arg.getDefiningOp()); }
 
 void enforceEquishardingConstraints(
     ModuleOp module,
-    SmallVector<InputOutputEquishardingConstraint> constraints) {
+    SmallVector<InputOutputEquishardingConstraint> constraints,
+    bool cost_aware_sharding = false) {
   PassManager pm(module->getContext());
   pm.enableVerifier();
   pm.addNestedPass<FuncOp>(createEnforceEquishardingPass(
-      EnforceEquishardingPassOptions{constraints}));
+      EnforceEquishardingPassOptions{constraints, cost_aware_sharding}));
   SDY_CHECK(succeeded(pm.run(module)));
 }
 
@@ -188,5 +189,70 @@ TEST(EnforceEquishardingConstraints, FunctionIsNotEntrypoint) {
       dyn_cast_or_null<FuncOp>(module->lookupSymbol("f")).getFunctionType());
 }
 
+TEST(EnforceEquishardingConstraints, CostAwarePicksCheaperOutputSharding) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+
+  // Replicating the input on the 8 devices of m1 and resharding the output to
+  // it costs 2 * 32KiB per device, whereas the sharding of the output only
+  // keeps 4KiB per device on m1.
+  const std::string kProgram = R"mlir(
+  func.func @main(%arg0: !mpmd.mesh_tensor<"m1", tensor<32x256xf32>>)
+      -> (!mpmd.mesh_tensor<"m2", tensor<32x256xf32>, sharding=<@mesh, [{"x"}, {?}]>>) attributes {
+    "topology"=#mpmd.topology<
+      <"m1": <["x"=8]>>,
+      <"m2": <["x"=2]>>
+    >} {
+    %0 = mpmd.transfer %arg0 : (!mpmd.mesh_tensor<"m1", tensor<32x256xf32>>)
+        -> !mpmd.mesh_tensor<"m2", tensor<32x256xf32>, sharding=<@mesh, [{"x"}, {?}]>>
+    func.return %0 : !mpmd.mesh_tensor<"m2", tensor<32x256xf32>, sharding=<@mesh, [{"x"}, {?}]>>
+  })mlir";
+
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  enforceEquishardingConstraints(*module,
+                                 {InputOutputEquishardingConstraint(0, 0)},
+                                 /*cost_aware_sharding=*/true);
+
+  FuncOp new_fn = GetMainFunction(*module);
+  FunctionType new_type = new_fn.getFunctionType();
+  EXPECT_EQ(new_type.getInput(0), new_type.getResult(0));
+  auto input_type = cast<MeshTensorType>(new_type.getInput(0));
+  EXPECT_EQ(input_type.getMeshName(), "m1");
+  EXPECT_TRUE(input_type.getSharding());
+  EXPECT_THAT(new_fn.getBody().front().getTerminator()->getOperand(0),
+              IsTransferOp());
+}
+
+TEST(EnforceEquishardingConstraints, CostAwareKeepsCheaperInputSharding) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+
+  // The sharding of the input keeps 4KiB per device on m1, plus 4KiB received
+  // by resharding, whereas replicating it keeps 32KiB per device.
+  const std::string kProgram = R"mlir(
+  func.func @main(%arg0: !mpmd.mesh_tensor<"m1", tensor<32x256xf32>, sharding=<@mesh, [{"x"}, {?}]>>)
+      -> (!mpmd.mesh_tensor<"m2", tensor<32x256xf32>>) attributes {
+    "topology"=#mpmd.topology<
+      <"m1": <["x"=8]>>,
+      <"m2": <["x"=2]>>
+    >} {
+    %0 = mpmd.transfer %arg0 : (!mpmd.mesh_tensor<"m1", tensor<32x256xf32>, sharding=<@mesh, [{"x"}, {?}]>>)
+        -> !mpmd.mesh_tensor<"m2", tensor<32x256xf32>>
+    func.return %0 : !mpmd.mesh_tensor<"m2", tensor<32x256xf32>>
+  })mlir";
+
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  Type orig_input_type = GetMainFunction(*module).getFunctionType().getInput(0);
+  enforceEquishardingConstraints(*module,
+                                 {InputOutputEquishardingConstraint(0, 0)},
+                                 /*cost_aware_sharding=*/true);
+
+  FunctionType new_type = GetMainFunction(*module).getFunctionType();
+  EXPECT_EQ(new_type.getInput(0), orig_input_type);
+  EXPECT_EQ(new_type.getResult(0), orig_input_type);
+}
+
 }  // namespace
 }  // namespace mlir::mpmd
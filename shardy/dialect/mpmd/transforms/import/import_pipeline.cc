@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
+#include <string>
 #include <utility>
 
 #include "llvm/Support/CommandLine.h"
@@ -56,7 +58,13 @@ void addImportPipeline(OpPassManager& pm, ImportOptions options) {
 
   // Unroll mpmd.for loops as they aren't yet supported by mesh inference.
   // TODO(jupvfranco): postpone unrolling until after SPMD propagation.
-  pm.addNestedPass<FuncOp>(createUnrollForLoopsPass());
+  if (options.outlineForLoops) {
+    // Keep the loops rolled as calls to their body, which are only unrolled
+    // by call inlining.
+    pm.addPass(createOutlineForLoopsPass());
+  } else {
+    pm.addNestedPass<FuncOp>(createUnrollForLoopsPass());
+  }
   // After unrolling, we may have slice(stack(x1, ..., xn), index) in the code
   // caused by for loops with enumeration of inputs. If x1 ... xn are large
   // tensors, this could cause OOMs. However, given that index is a constant,
@@ -79,11 +87,13 @@ void addImportPipeline(OpPassManager& pm, ImportOptions options) {
   // Sink negligible ops into call_ops. This is not strictly necessary, however
   // it is advantageous for two main reasons: 1) it reduces in workload in mesh
   // inference; and 2) the sunken ops can be immediately merged into fragments.
-  pm.addPass(createSinkNegligibleOpsIntoCallOpPass());
+  pm.addPass(createSinkNegligibleOpsIntoCallOpPass(
+      SinkNegligibleOpsIntoCallOpPassOptions{options.maxNegligibleBytes}));
 
   // This pass may leave unused outputs in named computations. Thus, we apply
   // it before we simplify named_computations in order to remove those outputs.
-  pm.addNestedPass<FuncOp>(createInsertNamelessCloneOfNeglibleOpsPass());
+  pm.addNestedPass<FuncOp>(createInsertNamelessCloneOfNeglibleOpsPass(
+      InsertNamelessCloneOfNeglibleOpsPassOptions{options.maxNegligibleBytes}));
 
   // Needs to be applied before MPMD import passes as those replace named
   // computations with fragments that are assigned to meshes, which can cause
@@ -105,7 +115,9 @@ void addImportPipeline(OpPassManager& pm, ImportOptions options) {
   // at the top level of the program (i.e., all fragments and transfers are at
   // the top level of the functions).
   pm.addNestedPass<FuncOp>(createInlineNestedUserExposedOpsPass(
-      InlineNestedUserExposedOpsPassOptions{options.nameToMeshAssignment}));
+      InlineNestedUserExposedOpsPassOptions{options.nameToMeshAssignment,
+                                            options.balancedStageMeshes,
+                                            options.stageMemoryCapBytes}));
 
   // Validate that all named ops are only nested in mpmd functions.
   pm.addNestedPass<FuncOp>(createValidateNamedOpsInMpmdFuncPass());
@@ -113,10 +125,13 @@ void addImportPipeline(OpPassManager& pm, ImportOptions options) {
   // Map named computations and named tensors to fragments, assigns/unassigns.
   pm.addNestedPass<FuncOp>(
       createMapNamedOpsToMpmdOpsPass(MapNamedOpsToMpmdOpsPassOptions{
-          std::move(options.nameToMeshAssignment)}));
+          std::move(options.nameToMeshAssignment),
+          std::move(options.balancedStageMeshes),
+          options.stageMemoryCapBytes}));
 
   // Introduce transfer ops from unassign/assign ops.
-  pm.addPass(createIntroduceTransfersPass());
+  pm.addPass(createIntroduceTransfersPass(
+      IntroduceTransfersPassOptions{options.transferFanOut}));
 
   // Erase unused block arguments from functions that are target of mpmd.calls.
   // We need to do this before mesh inference, which doesn't handle arguments
@@ -135,14 +150,14 @@ void addImportPipeline(OpPassManager& pm, ImportOptions options) {
   // Enforce the user-specified input/output equi-assignment constraints.
   pm.addNestedPass<FuncOp>(
       createEnforceEquishardingPass(EnforceEquishardingPassOptions{
-          std::move(options.inputOutputConstraints)}));
+          std::move(options.inputOutputConstraints),
+          options.costAwareEquisharding}));
 
   // Simplify all the fragments. We never introduce identity fragments in our
   // passes and any identity fragment that may have been created by a user
   // would have been simplified away with `simplify-named-computation-ops`.
   // Thus, we don't apply canonicalization again.
-  pm.addNestedPass<FuncOp>(createFragmentDedupPass());
-  pm.addNestedPass<FuncOp>(createFragmentDcePass());
+  pm.addNestedPass<FuncOp>(createMinimizeFragmentSignaturesPass());
 
   // Apply optimization passes that modify fragments so fragments are stable
   // before rule-based merging/scheduling in the partition pipeline.
@@ -170,6 +185,18 @@ struct ImportPipelineOptions
           "names, and optionally stage ids."),
       llvm::cl::init(UserAssignmentMapOption())};
 
+  ListOption<std::string> balancedStageMeshes{
+      *this, "balanced-stage-meshes",
+      llvm::cl::desc("The mesh of each stage to which the named computations "
+                     "missing from the name-to-mesh assignment are assigned "
+                     "by balancing their estimated cost.")};
+
+  Option<int64_t> stageMemoryCapBytes{
+      *this, "stage-memory-cap-bytes",
+      llvm::cl::desc(
+          "If positive, the maximum activation bytes of each balanced stage."),
+      llvm::cl::init(0)};
+
   Option<bool> mergeAfterScheduling{
       *this, "merge-after-scheduling",
       llvm::cl::desc(
@@ -180,6 +207,12 @@ struct ImportPipelineOptions
       *this, "enable-heterogeneous-meshes",
       llvm::cl::desc("Whether to enable heterogeneous meshes."),
       llvm::cl::init(false)};
+
+  Option<bool> outlineForLoops{
+      *this, "outline-for-loops",
+      llvm::cl::desc("Whether to replace mpmd.for loops with calls to their "
+                     "outlined body instead of fully unrolling them."),
+      llvm::cl::init(false)};
 };
 
 }  // namespace
@@ -192,9 +225,14 @@ void registerImportPipeline() {
       [](OpPassManager& pm, const ImportPipelineOptions& pipelineOptions) {
         ImportOptions options;
         options.nameToMeshAssignment = pipelineOptions.nameToMeshAssignment;
+        options.balancedStageMeshes.assign(
+            pipelineOptions.balancedStageMeshes.begin(),
+            pipelineOptions.balancedStageMeshes.end());
+        options.stageMemoryCapBytes = pipelineOptions.stageMemoryCapBytes;
         options.mergeAfterScheduling = pipelineOptions.mergeAfterScheduling;
         options.enableHeterogeneousMeshes =
             pipelineOptions.enableHeterogeneousMeshes;
+        options.outlineForLoops = pipelineOptions.outlineForLoops;
         addImportPipeline(pm, std::move(options));
       });
 }
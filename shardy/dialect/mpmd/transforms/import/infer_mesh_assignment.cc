@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "shardy/dialect/mpmd/transforms/import/infer_mesh_assignment.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -34,6 +35,8 @@ limitations under the License.
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Block.h"
@@ -51,6 +54,7 @@ limitations under the License.
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/OperationSupport.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Value.h"
 #include "mlir/IR/ValueRange.h"
 #include "mlir/IR/Visitors.h"
@@ -58,6 +62,7 @@ limitations under the License.
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Pass/PassOptions.h"
 #include "mlir/Pass/PassRegistry.h"
+#include "mlir/Rewrite/FrozenRewritePatternSet.h"
 #include "mlir/Support/DebugStringHelper.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Support/LogicalResult.h"
@@ -67,6 +72,7 @@ limitations under the License.
 #include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
 #include "shardy/dialect/mpmd/transforms/common/utils.h"
+#include "shardy/dialect/mpmd/transforms/import/mesh_assignment_map.h"
 #include "shardy/dialect/mpmd/transforms/import/mesh_inference_origins.h"
 #include "shardy/dialect/mpmd/transforms/import/mesh_inference_utils.h"
 #include "shardy/dialect/mpmd/transforms/import/meshes_with_origins.h"
@@ -434,9 +440,23 @@ FragmentOp CreateReduceFragment(ArrayRef<Value> mesh_tensors,
 // %v_m1 = R(%v0, R(...)) # on mesh1
 // %v_m2 = R(...) # on mesh2
 // %v = R(transfer(%v_m1), transfer(%v_m2)) # on mesh3
+//
+// With `tree_reductions`, the local reductions are instead combined pairwise,
+// each pair on the mesh of its first value, until a single value is left. The
+// local reduction of the destination mesh, if any, goes first, so the result
+// ends up there. E.g., with local reductions on m1,...,m4 and destination m1:
+//
+// %v_12 = R(%v_m1, transfer(%v_m2)) # on mesh1
+// %v_34 = R(%v_m3, transfer(%v_m4)) # on mesh3
+// %v = R(%v_12, transfer(%v_34)) # on mesh1
+//
+// This way each mesh receives at most log2(n) intermediates, rather than the
+// destination mesh receiving n-1 of them at once.
 class LowerMpmdReducePattern final : public OpRewritePattern<ReduceOp> {
  public:
-  using OpRewritePattern::OpRewritePattern;
+  LowerMpmdReducePattern(MLIRContext* context, bool tree_reductions)
+      : OpRewritePattern<ReduceOp>(context),
+        tree_reductions_(tree_reductions) {}
 
   LogicalResult matchAndRewrite(ReduceOp mpmd_reduce,
                                 PatternRewriter& rewriter) const override {
@@ -486,6 +506,15 @@ class LowerMpmdReducePattern final : public OpRewritePattern<ReduceOp> {
           << "Each mesh in the use_set should "
              "correspond to at least one assign user.";
       MeshTensorType user_type = assign_users.front().getType();
+      if (tree_reductions_) {
+        Value result = CreateReduceTree(local_reductions, user_type,
+                                        mpmd_reduce.getReductionType(),
+                                        rewriter);
+        for (AssignOp user : assign_users) {
+          rewriter.replaceAllUsesWith(user, result);
+        }
+        continue;
+      }
       SmallVector<Value> transferred_intermediates;
       for (Value reduced_val : local_reductions) {
         if (reduced_val.getType() == user_type) {
@@ -506,14 +535,68 @@ class LowerMpmdReducePattern final : public OpRewritePattern<ReduceOp> {
 
     return success();
   }
+
+ private:
+  // Reduces `local_reductions` pairwise into a value of `user_type`.
+  static Value CreateReduceTree(ArrayRef<Value> local_reductions,
+                                MeshTensorType user_type,
+                                ReductionType reduction_type,
+                                RewriterBase& rewriter) {
+    auto get_mesh_name = [](Value v) {
+      return cast<MeshTensorType>(v.getType()).getMeshName();
+    };
+    SmallVector<Value> partials(local_reductions);
+    llvm::sort(partials, [&](Value a, Value b) {
+      return IsMeshBeforeOtherMesh(get_mesh_name(a), get_mesh_name(b));
+    });
+    llvm::stable_partition(partials, [&](Value v) {
+      return get_mesh_name(v) == user_type.getMeshName();
+    });
+
+    while (partials.size() > 1) {
+      SmallVector<Value> next_partials;
+      for (size_t i = 0; i + 1 < partials.size(); i += 2) {
+        Value lhs = partials[i];
+        Value rhs = partials[i + 1];
+        if (rhs.getType() != lhs.getType()) {
+          rhs = TransferOp::create(rewriter, rhs.getLoc(), lhs.getType(), rhs);
+        }
+        next_partials.push_back(
+            CreateReduceFragment({lhs, rhs}, get_mesh_name(lhs),
+                                 reduction_type, rewriter)
+                .getResult(0));
+      }
+      if (partials.size() % 2 == 1) {
+        next_partials.push_back(partials.back());
+      }
+      partials = std::move(next_partials);
+    }
+
+    Value result = partials.front();
+    if (result.getType() != user_type) {
+      result = TransferOp::create(rewriter, result.getLoc(), user_type, result);
+    }
+    return result;
+  }
+
+  bool tree_reductions_;
 };
 
-WalkResult PopulateUseSet(Operation* op, OpBuilder& builder);
+WalkResult PopulateUseSet(Operation* op, OpBuilder& builder,
+                          DenseSet<Operation*>& walked_callees);
 
 // Populates the use_set of the callee func of the given call_op.
 // Returns true if the use_set of the callee func has changed.
+//
+// The use_sets of the callee body only depend on the use_sets of the callee
+// results, which are shared by all calls to the callee. So the body is only
+// walked the first time the callee is seen, i.e., when it isn't in
+// `walked_callees`, or when the use_set of some result has changed. Calls that
+// don't add any mesh to the result use_sets reuse the use_sets of the callee
+// args.
 bool PopulateUseSetForCalleeFunc(CallOp call_op, FuncOp callee_func,
-                                 OpBuilder& builder) {
+                                 OpBuilder& builder,
+                                 DenseSet<Operation*>& walked_callees) {
   bool has_changed = false;
   // Propagate through to the callee result.
   for (OpResult call_result : call_op->getResults()) {
@@ -532,10 +615,12 @@ bool PopulateUseSetForCalleeFunc(CallOp call_op, FuncOp callee_func,
   // We only need to populate the use_set of the callee func again if the
   // use_set of the results have changed, or if we've not populated it yet.
   // Otherwise, the use_set of the body will be unchanged.
-  if (has_changed || !CallOpHasUseSetPopulated(call_op)) {
+  if (walked_callees.insert(callee_func).second || has_changed) {
     // Populate the func's use_set.
     callee_func.walk<WalkOrder::PostOrder, ReverseIterator>(
-        [&builder](Operation* op) { return PopulateUseSet(op, builder); });
+        [&](Operation* op) {
+          return PopulateUseSet(op, builder, walked_callees);
+        });
     return true;
   }
   return false;
@@ -575,16 +660,19 @@ bool PopulateUseSetForCalleeFunc(CallOp call_op, FuncOp callee_func,
 // If the call op is in a call chain, we keep propagating the use_set
 // until a fixed point, as that will be required for the mesh assignments to be
 // valid. Note that this is a little bit like the ForOp.
-void PopulateUseSetForCallOp(CallOp call_op, OpBuilder& builder) {
+void PopulateUseSetForCallOp(CallOp call_op, OpBuilder& builder,
+                             DenseSet<Operation*>& walked_callees) {
   FuncOp callee_func = GetCalleeFunc(call_op);
 
-  bool has_changed = PopulateUseSetForCalleeFunc(call_op, callee_func, builder);
+  bool has_changed = PopulateUseSetForCalleeFunc(call_op, callee_func, builder,
+                                                 walked_callees);
 
   // If the call op is in a call chain, we need to keep propagating the use_set
   // until a fixed point.
   if (IsCallOpInCallChain(call_op)) {
     for (int i = 0; i < kMaxCallChainUseSetIterations && has_changed; ++i) {
-      has_changed = PopulateUseSetForCalleeFunc(call_op, callee_func, builder);
+      has_changed = PopulateUseSetForCalleeFunc(call_op, callee_func, builder,
+                                                walked_callees);
     }
   }
 }
@@ -639,7 +727,11 @@ void PopulateUseSetForForOpTerminator(ReturnOp return_op, OpBuilder& builder) {
 //
 // Hence, it must be used in conjunction with a post-order traversal of the
 // MLIR graph, so that all users are processed before the current op.
-WalkResult PopulateUseSet(Operation* op, OpBuilder& builder) {
+//
+// `walked_callees` holds the callee funcs whose body has already been walked,
+// see `PopulateUseSetForCalleeFunc`.
+WalkResult PopulateUseSet(Operation* op, OpBuilder& builder,
+                          DenseSet<Operation*>& walked_callees) {
   if (auto assign_op = dyn_cast<AssignOp>(op)) {
     SetUseSet(assign_op, MeshesWithOrigins(assign_op.getMeshWithOrigin()),
               builder);
@@ -654,7 +746,7 @@ WalkResult PopulateUseSet(Operation* op, OpBuilder& builder) {
     // as they are already assigned.
     return WalkResult::skip();
   } else if (auto call_op = dyn_cast<CallOp>(op)) {
-    PopulateUseSetForCallOp(call_op, builder);
+    PopulateUseSetForCallOp(call_op, builder, walked_callees);
   } else if (auto for_op = dyn_cast<ForOp>(op)) {
     PopulateUseSetForForOp(for_op, builder);
   } else if (auto return_op = dyn_cast<ReturnOp>(op)) {
@@ -669,6 +761,20 @@ WalkResult PopulateUseSet(Operation* op, OpBuilder& builder) {
   return WalkResult::advance();
 }
 
+// Adds to `num_sets` the number of ops in `module_op` with a `set_attr_name`
+// attribute, and updates `max_set_size` with the largest number of meshes in
+// any of them.
+void UpdateSetStatistics(ModuleOp module_op, StringRef set_attr_name,
+                         Pass::Statistic& num_sets,
+                         Pass::Statistic& max_set_size) {
+  module_op.walk([&](Operation* op) {
+    if (auto set = op->getAttrOfType<MeshesWithOriginsAttr>(set_attr_name)) {
+      ++num_sets;
+      max_set_size.updateMax(set.getValue().size());
+    }
+  });
+}
+
 class InferMeshPopulateUseSetPass
     : public impl::InferMeshPopulateUseSetPassBase<
           InferMeshPopulateUseSetPass> {
@@ -679,13 +785,17 @@ class InferMeshPopulateUseSetPass
     ModuleOp module_op = getOperation();
     OpBuilder builder(&getContext());
 
+    DenseSet<Operation*> walked_callees;
     for (FuncOp func_op : GetMpmdFunctions(module_op)) {
       if (IsEntryPointFunction(func_op)) {
         // Do a post-order traversal.
         func_op.walk<WalkOrder::PostOrder, ReverseIterator>(
-            [&builder](Operation* op) { return PopulateUseSet(op, builder); });
+            [&](Operation* op) {
+              return PopulateUseSet(op, builder, walked_callees);
+            });
       }
     }
+    UpdateSetStatistics(module_op, kMpmdUseSet, numUseSets, maxUseSetSize);
   }
 };
 
@@ -727,15 +837,94 @@ class InferMeshPopulateSrcSetPass
     ModuleOp module_op = getOperation();
     OpBuilder builder(&getContext());
 
+    walked_callees_.clear();
+    found_empty_src_set_ = false;
     for (FuncOp func_op : GetMpmdFunctions(module_op)) {
       if (IsEntryPointFunction(func_op)) {
         func_op.walk<WalkOrder::PreOrder>(
             [&](Operation* op) { return PopulateSrcSet(op, builder); });
       }
+      if (found_empty_src_set_) {
+        return signalPassFailure();
+      }
     }
+    UpdateSetStatistics(module_op, kMpmdSrcSet, numSrcSets, maxSrcSetSize);
   }
 
  private:
+  // The callee funcs whose body has been walked by `PopulateSrcSetForCallOp`.
+  DenseSet<Operation*> walked_callees_;
+  // Whether an empty src_set was found with `failFast`, in which case the
+  // propagation stops.
+  bool found_empty_src_set_ = false;
+
+  // Returns the explanation of why `src_set` and `other_src_set` conflict, to
+  // be emitted when their intersection is empty.
+  std::string ConflictingSrcSetsError(StringRef src_set_description,
+                                      const MeshesWithOrigins& src_set,
+                                      StringRef other_src_set_description,
+                                      const MeshesWithOrigins& other_src_set,
+                                      MLIRContext* context) {
+    std::string error_str;
+    llvm::raw_string_ostream error_stream(error_str);
+    error_stream << "\n\n" << src_set_description
+                 << " can only be assigned to meshes: "
+                 << PrintMeshesWithOrigins(src_set.ToArray(context)) << "\n"
+                 << "but " << other_src_set_description
+                 << " can only be assigned to meshes: "
+                 << PrintMeshesWithOrigins(other_src_set.ToArray(context));
+    error_stream << "\n\nTo handle this automatically, set "
+                    "`mpmd_infer_transfers` in the partitioning options.";
+    return error_str;
+  }
+
+  // Emits an error for `op`, whose src_set became empty, with the operand
+  // whose src_set doesn't intersect the src_sets of the operands before it.
+  // `old_src_set` is the src_set of `op` before propagation, e.g., from an
+  // earlier walk of a callee.
+  void EmitEmptySrcSetError(Operation* op, MeshesWithOriginsAttr old_src_set) {
+    std::string error_str;
+    llvm::raw_string_ostream error_stream(error_str);
+    error_stream << "Mesh assignment is not possible for op as its operands "
+                    "are on conflicting meshes and thus we need to transfer "
+                    "some of the operands. Add an explicit transfer to fix "
+                    "this.\n\nOp: \n\t"
+                 << PrintOperationForLog(op);
+
+    // The src_set of the op before propagation and the operands so far.
+    MeshesWithOrigins src_set(old_src_set);
+    for (OpOperand& operand : op->getOpOperands()) {
+      MeshesWithOrigins operand_src_set = GetSrcSet(operand);
+      MeshesWithOrigins intersection = src_set;
+      intersection.Intersect(operand_src_set);
+      if (intersection.empty()) {
+        int operand_number = operand.getOperandNumber();
+        std::string src_set_description =
+            old_src_set ? "the op in an earlier call" : "";
+        if (operand_number > 0) {
+          if (!src_set_description.empty()) {
+            src_set_description += " and ";
+          }
+          src_set_description +=
+              operand_number == 1
+                  ? "operand 0"
+                  : llvm::formatv("operands 0 to {0}", operand_number - 1)
+                        .str();
+        }
+        error_stream << ConflictingSrcSetsError(
+            src_set_description, src_set,
+            llvm::formatv("operand {0}", operand_number).str(),
+            operand_src_set, op->getContext());
+        break;
+      }
+      src_set = std::move(intersection);
+    }
+    error_stream << "\n\nOp stack trace:\n"
+                 << PrintStackTraceFromLoc(op->getLoc()) << "\n";
+    op->emitError(error_str);
+    found_empty_src_set_ = true;
+  }
+
   // Copies the use_set to the src_set, updating the origin to inferred_in,
   // rather than copying the old one (e.g. "layer0"). We don't want to copy over
   // the origins for the use_set, we want new origins to indicate that the
@@ -913,7 +1102,8 @@ class InferMeshPopulateSrcSetPass
   // But that's not possible since m1 not in src_set(s), so x cannot live on m1.
   // And similarly, x cannot live on m3. So x has src_set {m2}.
   void PropagateSrcSet(Operation* op, OpBuilder& builder) {
-    MeshesWithOrigins src_set = GetSrcSet(op);
+    auto old_src_set = op->getAttrOfType<MeshesWithOriginsAttr>(kMpmdSrcSet);
+    MeshesWithOrigins src_set(old_src_set);
     for (OpOperand& operand : op->getOpOperands()) {
       src_set.Intersect(GetSrcSet(operand));
     }
@@ -922,6 +1112,13 @@ class InferMeshPopulateSrcSetPass
       SetSrcSet(op, src_set, builder);
 
       InferReduceAndPropagateSrcSet(op, builder);
+
+      // Only the first op in a chain of empty src_sets is reported, the same
+      // as `InferMeshValidateSrcSetNotEmptyPass`, but ops after it aren't
+      // reached since propagation stops.
+      if (failFast && IsMeshlessOp(op) && GetSrcSet(op).empty()) {
+        EmitEmptySrcSetError(op, old_src_set);
+      }
     }
   }
 
@@ -936,17 +1133,36 @@ class InferMeshPopulateSrcSetPass
   // the docs of `PopulateUseSetForCallOp` for an example of this.
   void PopulateSrcSetForCallOp(CallOp call_op, OpBuilder& builder) {
     FuncOp callee_func = GetCalleeFunc(call_op);
+    bool has_changed = walked_callees_.insert(callee_func).second;
     // Propagate through to the callee func body.
     for (OpOperand& call_operand : call_op->getOpOperands()) {
       MeshesWithOrigins src_set = GetSrcSet(call_operand);
       src_set.Intersect(
           GetSrcSet(callee_func, call_operand.getOperandNumber()));
       if (src_set) {
+        Attribute old_src_set = callee_func.getArgAttr(
+            call_operand.getOperandNumber(), kMpmdSrcSet);
         SetSrcSet(callee_func, call_operand.getOperandNumber(), src_set,
                   builder);
+        has_changed |= callee_func.getArgAttr(call_operand.getOperandNumber(),
+                                              kMpmdSrcSet) != old_src_set;
+        if (failFast && src_set.empty()) {
+          EmitEmptyCalleeArgSrcSetError(
+              call_op, call_operand.getOperandNumber(),
+              dyn_cast_if_present<MeshesWithOriginsAttr>(old_src_set));
+          return;
+        }
       }
     }
 
+    // The src_sets of the body only depend on the src_sets of the func args,
+    // and walking the body again with the same args doesn't change them. So
+    // each callee is only walked again when a call site narrows its args,
+    // rather than once per call site.
+    if (!has_changed) {
+      return;
+    }
+
     // Populate the func's src_set.
     // Walk only the body, not the func itself. We don't want to set the func
     // args' src_set with the use_set, since the src_set should come from
@@ -955,6 +1171,28 @@ class InferMeshPopulateSrcSetPass
         [&](Operation* op) { return PopulateSrcSet(op, builder); });
   }
 
+  // Emits an error for the arg `arg_num` of the callee of `call_op`, whose
+  // src_set became empty because the matching operand of `call_op` conflicts
+  // with `old_src_set`, i.e., with the operands of the earlier calls.
+  void EmitEmptyCalleeArgSrcSetError(CallOp call_op, int arg_num,
+                                     MeshesWithOriginsAttr old_src_set) {
+    std::string error_str;
+    llvm::raw_string_ostream error_stream(error_str);
+    error_stream << "Mesh assignment is not possible for arg" << arg_num
+                 << " of mpmd.call \"" << GetCalleeFunc(call_op).getSymName()
+                 << "\" as its caller operands are on conflicting meshes and "
+                    "thus we need to transfer some of the operands. Add an "
+                    "explicit transfer to fix this.";
+    error_stream << ConflictingSrcSetsError(
+        "the operand of earlier calls", MeshesWithOrigins(old_src_set),
+        "the operand of this call", GetSrcSet(call_op->getOpOperand(arg_num)),
+        call_op->getContext());
+    error_stream << "\n\nmpmd.call stack trace:\n"
+                 << PrintStackTraceFromLoc(call_op->getLoc()) << "\n";
+    call_op->emitError(error_str);
+    found_empty_src_set_ = true;
+  }
+
   // This populates the src_set of a ForOp.
   void PopulateSrcSetForForOp(ForOp for_op, OpBuilder& builder) {
     for (OpOperand& for_operand : for_op.getOperation()->getOpOperands()) {
@@ -976,6 +1214,9 @@ class InferMeshPopulateSrcSetPass
   // TODO: b/340565987 - move to class so that we can access `infer_reductions`
   // as a field instead of as an arg.
   WalkResult PopulateSrcSet(Operation* op, OpBuilder& builder) {
+    if (found_empty_src_set_) {
+      return WalkResult::interrupt();
+    }
     if (auto unassign = dyn_cast<UnassignOp>(op)) {
       InitializeSrcSet(unassign, builder);
     } else if (auto func = dyn_cast<FuncOp>(op)) {
@@ -1022,12 +1263,40 @@ std::optional<StringRef> GetMeshForAssignment(
   return *src_set.GetPrioritizedMeshName(preferred_meshes.MeshNamesOrEmpty());
 }
 
+// Returns the meshes of `candidate_meshes` that minimize the total cost of
+// transferring a value from them to all of `dst_meshes`.
+SetVector<StringRef> GetCheapestMeshes(
+    const MeshesWithOrigins& candidate_meshes,
+    const SetVector<StringRef>& dst_meshes,
+    const MeshTransferCosts& transfer_costs) {
+  SetVector<StringRef> cheapest_meshes;
+  double min_cost = 0;
+  for (StringRef candidate : candidate_meshes.MeshNames()) {
+    double cost = 0;
+    for (StringRef dst_mesh : dst_meshes) {
+      cost += GetTransferCost(transfer_costs, candidate, dst_mesh);
+    }
+    if (cheapest_meshes.empty() || cost < min_cost) {
+      cheapest_meshes.clear();
+      min_cost = cost;
+    }
+    if (cost == min_cost) {
+      cheapest_meshes.insert(candidate);
+    }
+  }
+  return cheapest_meshes;
+}
+
 // Returns the mesh for the main function's return operand which is compatible
 // with the `input_use_set`, preferring to pick a mesh from the output's use_set
 // over the src_set. Returns std::nullopt if there is no such mesh. We assume
 // here that `input_use_set` is the use_set of the input, where the pair (input,
 // output) is specified by the user to be constrained to the same mesh.
 //
+// When there are several such meshes, we pick the one that minimizes the total
+// cost of transferring the input to the other meshes of its use_set, according
+// to `transfer_costs`.
+//
 // If the input or output is already a MeshTensor (because of user-provided
 // assignment), then we try to use the mesh it is assigned to. If the output is
 // assigned, we can always assign the input (because the input can be assigned
@@ -1042,7 +1311,8 @@ std::optional<StringRef> GetMeshForAssignment(
 // without introducing a transfer. In this case, we leave it to the
 // `EnforceEquishardingPass` pass to introduce this transfer.
 std::optional<StringRef> GetMeshForInputOutputAssignment(
-    OpOperand& output_operand, FuncOp func, int64_t input_index) {
+    OpOperand& output_operand, FuncOp func, int64_t input_index,
+    const MeshTransferCosts& transfer_costs) {
   auto output_mesh_type =
       dyn_cast<MeshTensorType>(output_operand.get().getType());
   BlockArgument input_arg = func.getArgument(input_index);
@@ -1105,7 +1375,8 @@ std::optional<StringRef> GetMeshForInputOutputAssignment(
             << GetPrintableString(candidate_meshes) << "}";
       }
 
-      return *candidate_meshes.GetPrioritizedMeshName();
+      return *candidate_meshes.GetPrioritizedMeshName(GetCheapestMeshes(
+          candidate_meshes, input_use_set.MeshNames(), transfer_costs));
     }
   }
 
@@ -1119,7 +1390,8 @@ std::optional<StringRef> GetMeshForInputOutputAssignment(
           << " from the intersection of the input use_set and output src_set: {"
           << GetPrintableString(candidate_meshes) << "}";
     }
-    return *candidate_meshes.GetPrioritizedMeshName();
+    return *candidate_meshes.GetPrioritizedMeshName(GetCheapestMeshes(
+        candidate_meshes, input_use_set.MeshNames(), transfer_costs));
   }
 
   return std::nullopt;
@@ -1186,7 +1458,8 @@ class InferMeshAssignUsingInputOutputConstraintsPass
       OpOperand& return_operand =
           return_op->getOpOperand(constraint.output_index);
       if (std::optional<StringRef> mesh_name = GetMeshForInputOutputAssignment(
-              return_operand, func, constraint.input_index)) {
+              return_operand, func, constraint.input_index,
+              transferCosts.value)) {
         AssignInputAndOutputToMesh(
             func, func.getArgument(constraint.input_index), return_operand,
             *mesh_name, GetMeshByName(meshes_by_name, *mesh_name), rewriter);
@@ -2311,16 +2584,93 @@ void WrapBasedOnAssignUsers(Operation* op, RewriterBase& rewriter) {
   }
 }
 
+// Options for cloning meshless ops into their consumer fragments.
+struct CloneOptions {
+  // How many copies of a meshless op we allow.
+  int max_clones = 1;
+  // If positive, ops whose estimated floating point operations per byte of
+  // results are at most this are cloned, and other ops aren't, regardless of
+  // `max_clones`.
+  double max_flops_per_byte = 0.0;
+  // If set, incremented by the number of copies created when cloning ops into
+  // their consumers.
+  Pass::Statistic* num_clones = nullptr;
+};
+
+// Returns the number of bytes of the tensor results of `op`.
+int64_t GetResultBytes(Operation* op) {
+  int64_t bytes = 0;
+  for (Type type : op->getResultTypes()) {
+    if (auto tensor_type = dyn_cast<RankedTensorType>(type);
+        tensor_type && tensor_type.hasStaticShape()) {
+      bytes += GetSizeInBytes(tensor_type);
+    }
+  }
+  return bytes;
+}
+
+// Returns an estimate of the number of floating point operations of `op`. Ops
+// with regions (e.g., reductions) and dots read every element of their
+// operands, so we count those, and any other op is assumed to do one operation
+// per element it produces.
+int64_t EstimateFlops(Operation* op) {
+  auto get_num_elements = [](Type type) -> int64_t {
+    auto tensor_type = dyn_cast<RankedTensorType>(type);
+    return tensor_type && tensor_type.hasStaticShape()
+               ? tensor_type.getNumElements()
+               : 0;
+  };
+  int64_t flops = 0;
+  for (Type type : op->getResultTypes()) {
+    flops += get_num_elements(type);
+  }
+  if (op->getNumRegions() > 0 ||
+      isa<stablehlo::DotGeneralOp, stablehlo::DotOp>(op)) {
+    for (Type type : op->getOperandTypes()) {
+      flops += get_num_elements(type);
+    }
+  }
+  return flops;
+}
+
+// Returns true if `op` should be cloned into each of its `num_fragment_users`,
+// rather than wrapped in a fragment whose results are used by them.
+bool ShouldCloneIntoConsumers(Operation* op, int num_fragment_users,
+                              const CloneOptions& clone_options) {
+  // Trivial pure ops (single operand, single result, no regions, no side
+  // effects) like sdy.sharding_constraint, and ops with no operands, are always
+  // cheap to clone, so we bypass the limits for them to avoid creating
+  // millions of wrapper fragments that are expensive to merge later.
+  bool is_trivial_op = op->getNumOperands() <= 1 && op->getNumResults() == 1 &&
+                       op->getNumRegions() == 0 && isPure(op);
+  if (op->getNumOperands() == 0 || is_trivial_op) {
+    return true;
+  }
+  // Cloning recomputes the op in every consumer, whereas wrapping it
+  // materializes its results once, for all consumers. So we clone ops that
+  // are cheap relative to their results, e.g., broadcasts, and we don't clone
+  // ops that are expensive relative to their results, e.g., reductions.
+  if (clone_options.max_flops_per_byte > 0.0) {
+    return EstimateFlops(op) <=
+           clone_options.max_flops_per_byte * GetResultBytes(op);
+  }
+  // When `op` has many users (> `max_clones`) we do not want it to be
+  // cloned as it could be the root of a large tree, i.e., we would
+  // replicate too much code, potentially slowing down this pass (and maybe
+  // others) significantly.
+  return num_fragment_users <= clone_options.max_clones;
+}
+
 // Assigns the meshless `op` to a mesh either by being absorbed (by cloning or
 // inlining) or wrapped in a new fragment. In particular, if `op`:
 // - is used by a single fragment, then it is inlined into the fragment;
 // - is used by an op that is not a fragment (e.g., a transfer), then it is
 // wrapped in a fragment;
-// - is used by N fragments and N <= `max_clones`, or
-// the op has no operands, then it is cloned into each of its fragment users.
+// - is used by N fragments and `ShouldCloneIntoConsumers`, then it is cloned
+// into each of its fragment users.
 //
 // Pre-condition: The meshless `op` is used by AssignOps only.
-void AssignOpBasedOnConsumers(Operation* op, const int max_clones,
+void AssignOpBasedOnConsumers(Operation* op, const CloneOptions& clone_options,
                               RewriterBase& rewriter) {
   SDY_CHECK_GT(op->getNumResults(), 0)
       << "All ops with no results should have been assigned by "
@@ -2363,26 +2713,20 @@ void AssignOpBasedOnConsumers(Operation* op, const int max_clones,
   // When `has_non_fragment_user=true` we cannot clone as any non-fragment
   // user of the assign ops will not be erased, meaning `op` cannot be
   // erased either, as well as all its predecessors.
-  // When `op` has many users (> `kMaxClones`) we do not want it to be
-  // cloned as it could be the root of a large tree, i.e., we would
-  // replicate too much code, potentially slowing down this pass (and maybe
-  // others) significantly.
-  // Exception: trivial pure ops (single operand, single result, no regions,
-  // no side effects) like sdy.sharding_constraint are always cheap to clone,
-  // so we bypass the max_clones limit for them to avoid creating millions of
-  // wrapper fragments that are expensive to merge later.
-  // In any other case, we clone `op` into each of its fragment users.
-  bool is_trivial_op = op->getNumOperands() <= 1 && op->getNumResults() == 1 &&
-                       op->getNumRegions() == 0 && isPure(op);
+  // In any other case, we clone `op` into each of its fragment users if
+  // `ShouldCloneIntoConsumers`.
   if (fragment_users.empty() || has_non_fragment_user ||
-      (fragment_users.size() > max_clones && op->getNumOperands() > 0 &&
-       !is_trivial_op)) {
+      !ShouldCloneIntoConsumers(op, fragment_users.size(), clone_options)) {
     WrapBasedOnAssignUsers(op, rewriter);
   } else {
     for (FragmentOp fragment_user : fragment_users) {
       AbsorbMeshlessProducer(fragment_user, op,
                              /*op_used_by_consumer_only=*/false, rewriter);
     }
+    if (clone_options.num_clones) {
+      // The original op is erased below, so one of the copies replaces it.
+      *clone_options.num_clones += fragment_users.size() - 1;
+    }
   }
   // All users of op must be unused at this point. The op was either: (a)
   // wrapped in one or more fragments, and its assign users replaced with
@@ -2436,7 +2780,8 @@ void RewriteForOpTerminator(
 // WalkAndAbsorbMeshlessProducers, but for ForOp.
 void RewriteForOpBody(ForOp for_op,
                       const DenseMap<StringRef, sdy::MeshAttr>& meshes_by_name,
-                      const int max_clones, RewriterBase& rewriter) {
+                      const CloneOptions& clone_options,
+                      RewriterBase& rewriter) {
   Block& block = *for_op.getBody();
   for (Operation& operation :
        llvm::make_early_inc_range(llvm::reverse(block.getOperations()))) {
@@ -2446,7 +2791,7 @@ void RewriteForOpBody(ForOp for_op,
     } else if (auto for_op = dyn_cast<ForOp>(op)) {
       SDY_CHECK(false) << "Nested ForOp is not supported";
     } else if (IsMeshlessOp(op)) {
-      AssignOpBasedOnConsumers(op, max_clones, rewriter);
+      AssignOpBasedOnConsumers(op, clone_options, rewriter);
     }
   }
 }
@@ -2548,9 +2893,9 @@ void RewriteForOpResults(ForOp for_op, RewriterBase& rewriter) {
 
 void RewriteForOp(ForOp for_op,
                   const DenseMap<StringRef, sdy::MeshAttr>& meshes_by_name,
-                  const int max_clones, RewriterBase& rewriter) {
+                  const CloneOptions& clone_options, RewriterBase& rewriter) {
   RewriteForOpTerminator(for_op, meshes_by_name, rewriter);
-  RewriteForOpBody(for_op, meshes_by_name, max_clones, rewriter);
+  RewriteForOpBody(for_op, meshes_by_name, clone_options, rewriter);
   RewriteForOpArgsAndTypes(for_op, meshes_by_name, rewriter);
   RewriteForOpOperands(for_op, rewriter);
   RewriteForOpResults(for_op, rewriter);
@@ -2562,7 +2907,7 @@ void RewriteForOp(ForOp for_op,
 // that it returns mesh tensor types.
 void WalkAndAbsorbMeshlessProducers(
     FuncOp func_op, const DenseMap<StringRef, sdy::MeshAttr>& meshes_by_name,
-    const int max_clones, RewriterBase& rewriter) {
+    const CloneOptions& clone_options, RewriterBase& rewriter) {
   Block& block = func_op.getBody().front();
   for (Operation& operation :
        llvm::make_early_inc_range(llvm::reverse(block.getOperations()))) {
@@ -2570,9 +2915,9 @@ void WalkAndAbsorbMeshlessProducers(
     if (auto call_op = dyn_cast<CallOp>(op)) {
       RewriteAccordingToUpdatedCallee(call_op, rewriter);
     } else if (auto for_op = dyn_cast<ForOp>(op)) {
-      RewriteForOp(for_op, meshes_by_name, max_clones, rewriter);
+      RewriteForOp(for_op, meshes_by_name, clone_options, rewriter);
     } else if (IsMeshlessOp(op)) {
-      AssignOpBasedOnConsumers(op, max_clones, rewriter);
+      AssignOpBasedOnConsumers(op, clone_options, rewriter);
     }
   }
 }
@@ -2624,6 +2969,11 @@ class BroadcastToTransfersPattern : public OpRewritePattern<BroadcastOp> {
   }
 };
 
+bool HasCallOps(FuncOp func_op) {
+  return func_op.walk([](CallOp) { return WalkResult::interrupt(); })
+      .wasInterrupted();
+}
+
 class InferMeshRewriteUsingAnalysisPass
     : public impl::InferMeshRewriteUsingAnalysisPassBase<
           InferMeshRewriteUsingAnalysisPass> {
@@ -2634,42 +2984,59 @@ class InferMeshRewriteUsingAnalysisPass
   void runOnOperation() final {
     ModuleOp module_op = getOperation();
     MLIRContext* context = module_op->getContext();
-    IRRewriter rewriter(context);
 
     llvm::SmallVector<func::FuncOp> mpmd_functions =
         GetMpmdFunctions(module_op);
+    SmallVector<FuncOp> callees;
+    SmallVector<FuncOp> entry_points;
+    for (FuncOp func_op : mpmd_functions) {
+      (IsEntryPointFunction(func_op) ? entry_points : callees)
+          .push_back(func_op);
+    }
 
     // Rewrite all the callees before rewriting the entrypoint functions, so
     // that we can use the updated callee func info when we propagate through
     // the mpmd.calls in the entrypoint function.
-    for (FuncOp func_op : mpmd_functions) {
-      if (!IsEntryPointFunction(func_op)) {
-        // Assigns meshless ops in `callee`s. This does not update the type
-        // of the func. We reserve that to after the calls to the callee have
-        // been updated. This only changes the `callee` and does not change
-        // calls to the callee.
-        DenseMap<StringRef, sdy::MeshAttr> meshes_by_name =
-            GetMeshesByName(GetTopologyMeshes(func_op));
-
-        // We assign results first, so that they can absorb meshless ops.
-        AssignCalleeFuncResultsUsingAnalysis(func_op, meshes_by_name, rewriter);
-        WalkAndAbsorbMeshlessProducers(func_op, meshes_by_name, maxClones,
-                                       rewriter);
-        AssignCalleeFuncArgsToAssignUsers(func_op, meshes_by_name, rewriter);
-      }
-    }
-    for (FuncOp func_op : mpmd_functions) {
-      if (IsEntryPointFunction(func_op)) {
-        DenseMap<StringRef, sdy::MeshAttr> meshes_by_name =
-            GetMeshesByName(GetTopologyMeshes(func_op));
-        WalkAndAbsorbMeshlessProducers(func_op, meshes_by_name, maxClones,
-                                       rewriter);
-      }
+    //
+    // Each function is rewritten independently of the others, so we rewrite
+    // them in parallel, unless a callee has mpmd.calls itself, in which case
+    // it would read the callees it calls while they are being rewritten.
+    auto rewrite_callee = [&](FuncOp func_op) {
+      IRRewriter rewriter(context);
+      // Assigns meshless ops in `callee`s. This does not update the type
+      // of the func. We reserve that to after the calls to the callee have
+      // been updated. This only changes the `callee` and does not change
+      // calls to the callee.
+      DenseMap<StringRef, sdy::MeshAttr> meshes_by_name =
+          GetMeshesByName(GetTopologyMeshes(func_op));
+
+      // We assign results first, so that they can absorb meshless ops.
+      AssignCalleeFuncResultsUsingAnalysis(func_op, meshes_by_name, rewriter);
+      WalkAndAbsorbMeshlessProducers(func_op, meshes_by_name,
+                                     GetCloneOptions(), rewriter);
+      AssignCalleeFuncArgsToAssignUsers(func_op, meshes_by_name, rewriter);
+    };
+    if (llvm::any_of(callees, HasCallOps)) {
+      llvm::for_each(callees, rewrite_callee);
+    } else {
+      parallelForEach(context, callees, rewrite_callee);
     }
+
+    parallelForEach(context, entry_points, [&](FuncOp func_op) {
+      IRRewriter rewriter(context);
+      DenseMap<StringRef, sdy::MeshAttr> meshes_by_name =
+          GetMeshesByName(GetTopologyMeshes(func_op));
+      WalkAndAbsorbMeshlessProducers(func_op, meshes_by_name,
+                                     GetCloneOptions(), rewriter);
+    });
     for (FuncOp func_op : mpmd_functions) {
       UpdateFunctionType(func_op);
     }
   }
+
+  CloneOptions GetCloneOptions() {
+    return CloneOptions{maxClones, cloneFlopsPerByte, &numClones};
+  }
 };
 
 // TODO: b/359832656 - Use single walk instead of greedy rewriter.
@@ -2681,6 +3048,7 @@ class InferMeshFinalizePass
   void runOnOperation() final {
     ModuleOp module_op = getOperation();
     MLIRContext* context = module_op->getContext();
+    int64_t num_transfers_before = CountTransfers(module_op);
 
     IRRewriter rewriter(context);
     for (FuncOp func_op : GetMpmdFunctions(module_op)) {
@@ -2696,8 +3064,9 @@ class InferMeshFinalizePass
     RewritePatternSet patterns(context);
     patterns.add<AssignOfUnassignSameMeshPattern,
                  DedupAssignOfUnassignAndTransferPattern,
-                 AssignOfUnassignFuncArgPattern, BroadcastToTransfersPattern,
-                 LowerMpmdReducePattern>(context);
+                 AssignOfUnassignFuncArgPattern, BroadcastToTransfersPattern>(
+        context);
+    patterns.add<LowerMpmdReducePattern>(context, treeReductions);
     if (inferTransfers) {
       // Note that because we're doing this after running
       // `RewriteUsingAnalysis`, the introduction of transfers is naive: they
@@ -2733,7 +3102,13 @@ class InferMeshFinalizePass
     GreedyRewriteConfig config;
     config.enableFolding(false);
     config.enableConstantCSE(false);
-    if (failed(applyPatternsGreedily(module_op, std::move(patterns), config))) {
+    // The patterns only rewrite ops within a function, so we apply them to
+    // each function in parallel.
+    FrozenRewritePatternSet frozen_patterns(std::move(patterns));
+    SmallVector<FuncOp> func_ops = llvm::to_vector(module_op.getOps<FuncOp>());
+    if (failed(failableParallelForEach(context, func_ops, [&](FuncOp func_op) {
+          return applyPatternsGreedily(func_op, frozen_patterns, config);
+        }))) {
       return signalPassFailure();
     }
 
@@ -2746,6 +3121,16 @@ class InferMeshFinalizePass
       }
       ClearUseSetAndSrcSet(func_op);
     }
+    if (int64_t num_transfers = CountTransfers(module_op);
+        num_transfers > num_transfers_before) {
+      numTransfers += num_transfers - num_transfers_before;
+    }
+  }
+
+  static int64_t CountTransfers(ModuleOp module_op) {
+    int64_t num_transfers = 0;
+    module_op.walk([&](TransferOp) { ++num_transfers; });
+    return num_transfers;
   }
 };
 
@@ -2770,7 +3155,13 @@ void addInferMeshPipeline(
   // user (i.e. before any inference). If they are not used in any mesh, then
   // they remain unconstrained, i.e. they can be assigned to any mesh. We
   // populate the src_set to know which meshes we can assign our outputs to.
-  pm.addPass(createInferMeshPopulateSrcSetPass());
+  //
+  // Without transfer inference, an empty src_set is an error that
+  // `InferMeshValidateSrcSetNotEmptyPass` reports, so with `failFast` we stop
+  // at the first one instead of finishing the analysis.
+  pm.addPass(createInferMeshPopulateSrcSetPass(
+      InferMeshPopulateSrcSetPassOptions{options.failFast &&
+                                         !options.inferTransfers}));
 
   if (!inputOutputConstraints.empty()) {
     // Use input_output_constraints to assign the func outputs and inputs,
@@ -2778,6 +3169,8 @@ void addInferMeshPipeline(
     InferMeshAssignUsingInputOutputConstraintsPassOptions constraints_options;
     constraints_options.constraints = std::move(inputOutputConstraints);
     constraints_options.verboseLogging = options.errorLimit == -1;
+    constraints_options.transferCosts =
+        MeshTransferCostsOption{std::move(options.transferCosts)};
     pm.addPass(createInferMeshAssignUsingInputOutputConstraintsPass(
         std::move(constraints_options)));
   }
@@ -2821,10 +3214,11 @@ void addInferMeshPipeline(
   // Note: currently the transfers are created as early as possible, which is
   // likely suboptimal.
   pm.addPass(createInferMeshRewriteUsingAnalysisPass(
-      InferMeshRewriteUsingAnalysisPassOptions{options.maxClones}));
+      InferMeshRewriteUsingAnalysisPassOptions{options.maxClones,
+                                               options.cloneFlopsPerByte}));
 
-  pm.addPass(createInferMeshFinalizePass(
-      InferMeshFinalizePassOptions{options.inferTransfers}));
+  pm.addPass(createInferMeshFinalizePass(InferMeshFinalizePassOptions{
+      options.inferTransfers, options.treeReductions}));
 }
 
 namespace {
@@ -2841,6 +3235,18 @@ struct InferMeshPipelineOptions
       *this, "infer-cross-mesh-reductions",
       llvm::cl::desc("Whether to infer cross-mesh reductions."),
       llvm::cl::init(false)};
+
+  Option<bool> failFast{
+      *this, "fail-fast",
+      llvm::cl::desc("Whether to stop mesh inference at the first op that "
+                     "can't be assigned to any mesh without a transfer."),
+      llvm::cl::init(false)};
+
+  Option<bool> treeReductions{
+      *this, "tree-reductions",
+      llvm::cl::desc("Whether to lower cross-mesh reductions into trees of "
+                     "pairwise reductions."),
+      llvm::cl::init(false)};
 };
 
 }  // namespace
@@ -2853,6 +3259,8 @@ void registerInferMeshPipeline() {
         options.inferTransfers = pipelineOptions.inferTransfers;
         options.inferCrossMeshReductions =
             pipelineOptions.inferCrossMeshReductions;
+        options.failFast = pipelineOptions.failFast;
+        options.treeReductions = pipelineOptions.treeReductions;
         addInferMeshPipeline(pm, /*inputOutputConstraints=*/{}, options);
       });
 }
@@ -23,7 +23,6 @@ limitations under the License.
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
-#include "llvm/ADT/SetOperations.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
@@ -254,28 +253,6 @@ LocToOrigins GetUseOriginsWithLocs(
   return mesh_origins_with_locs;
 }
 
-// Prints mesh with origins in the format of
-// `mesh[origin1,origin2], mesh2[origin3]`.
-std::string PrintMeshWithOrigins(MeshWithOriginsAttr mesh_with_origins) {
-  std::string result;
-  llvm::raw_string_ostream str_stream(result);
-  str_stream << mesh_with_origins.getMeshName();
-  str_stream << "["
-             << llvm::join(llvm::map_range(mesh_with_origins.getOrigins(),
-                                           [](const OriginAttr& origin) {
-                                             return origin.getOriginLabel();
-                                           }),
-                           ",")
-             << "]";
-  return result;
-}
-
-std::string PrintMeshesWithOrigins(
-    ArrayRef<MeshWithOriginsAttr> meshes_with_origins) {
-  return llvm::join(llvm::map_range(meshes_with_origins, PrintMeshWithOrigins),
-                    ", ");
-}
-
 // Prints the loc to origins in the format of one of:
 // - `loc1 - Input <loc1>: mesh1[origin1], mesh2[origin3]`.
 // - `loc1 - Output <loc1>: mesh1[origin1], mesh2[origin3]`.
@@ -735,21 +712,24 @@ class InferMeshValidateNoAdditionalTransfersNeededPass
   // failed validation if we emit an error.
   // TODO(b/396601755): Return one error for all errors in an error chain.
   ValidationResult ValidateMeshlessOpDoesNotNeedTransfer(Operation* op) {
-    std::optional<SetVector<StringRef>> src_set = GetSrcMeshes(op);
-    SetVector<StringRef> use_set = GetUseMeshes(op);
-
-    if (!src_set.has_value()) {
+    // Check the sets as bitsets first, and only materialize the mesh names for
+    // the error message.
+    MeshSet src_set(op->getAttrOfType<MeshesWithOriginsAttr>(kMpmdSrcSet),
+                    mesh_indexer_);
+    if (!src_set) {
       // src_set is not present means that the op can be assigned to any mesh,
       // so any assignment is possible.
       return ValidationResult::kOk;
     }
 
     // This should be caught by ValidateSrcSetNotEmpty.
-    SDY_CHECK(!src_set->empty())
+    SDY_CHECK(!src_set.empty())
         << "This should have been caught by an earlier validation check. Reach "
            "out if you see this.";
 
-    if (llvm::set_is_subset(use_set, *src_set)) {
+    MeshSet use_set = MeshSet::CreateUseSet(
+        op->getAttrOfType<MeshesWithOriginsAttr>(kMpmdUseSet), mesh_indexer_);
+    if (use_set.IsSubsetOf(src_set)) {
       return ValidationResult::kOk;
     }
 
@@ -760,8 +740,9 @@ class InferMeshValidateNoAdditionalTransfersNeededPass
       return ValidationResult::kErrorButDontEmit;
     }
 
-    op->emitError(
-        MeshlessOpError(op, use_set.getArrayRef(), src_set->getArrayRef()));
+    op->emitError(MeshlessOpError(
+        op, use_set.MeshNames(mesh_indexer_).getArrayRef(),
+        src_set.MeshNames(mesh_indexer_).getArrayRef()));
     SetVisitedFailureAttr(op);
     return ValidationResult::kError;
   }
@@ -813,22 +794,24 @@ class InferMeshValidateNoAdditionalTransfersNeededPass
   // TODO(b/396601755): Return one error for all errors in an error chain.
   ValidationResult ValidateCalleeArgDoesNotNeedTransfer(FuncOp func,
                                                         int arg_num) {
-    std::optional<SetVector<StringRef>> src_set = GetSrcMeshes(func, arg_num);
-    SetVector<StringRef> use_set =
-        GetArgUseSet(func, arg_num).MeshNamesOrEmpty();
-
-    if (!src_set.has_value()) {
+    MeshSet src_set(dyn_cast_if_present<MeshesWithOriginsAttr>(
+                        func.getArgAttr(arg_num, kMpmdSrcSet)),
+                    mesh_indexer_);
+    if (!src_set) {
       // src_set is not present means that the op can be assigned to any mesh,
       // so any assignment is possible.
       return ValidationResult::kOk;
     }
 
     // This should be caught by ValidateSrcSetNotEmpty.
-    SDY_CHECK(!src_set->empty())
+    SDY_CHECK(!src_set.empty())
         << "This should have been caught by an earlier validation check. Reach "
            "out if you see this.";
 
-    if (llvm::set_is_subset(use_set, *src_set)) {
+    MeshSet use_set = MeshSet::CreateUseSet(
+        func.getArgAttrOfType<MeshesWithOriginsAttr>(arg_num, kMpmdUseSet),
+        mesh_indexer_);
+    if (use_set.IsSubsetOf(src_set)) {
       return ValidationResult::kOk;
     }
 
@@ -842,8 +825,9 @@ class InferMeshValidateNoAdditionalTransfersNeededPass
     }
 
     emitError(func->getLoc(),
-              CalleeArgError(func, arg_num, use_set.getArrayRef(),
-                             src_set->getArrayRef()));
+              CalleeArgError(func, arg_num,
+                             use_set.MeshNames(mesh_indexer_).getArrayRef(),
+                             src_set.MeshNames(mesh_indexer_).getArrayRef()));
 
     return ValidationResult::kError;
   }
@@ -898,6 +882,8 @@ class InferMeshValidateNoAdditionalTransfersNeededPass
   }
 
   DenseMap<StringRef, SmallVector<CallOp>> lazy_call_ops_by_callee_;
+  // Interns the mesh names of the src and use sets being validated.
+  MeshIndexer mesh_indexer_;
   int error_count_ = 0;
   int emitted_error_count_ = 0;
 };
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
+
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/PatternMatch.h"
@@ -29,15 +31,15 @@ namespace mlir::mpmd {
 
 namespace {
 
-// Returns the producer of `fragment_result` if it is considered a negligible,
-// i.e., it has no operands and returns a single result.
+// Returns the producer of `fragment_result` if it is considered negligible. See
+// `IsNegligibleOp`.
 Operation* FindNegligibleProducer(OpResult fragment_result,
-                                  ReturnOp fragment_return) {
+                                  ReturnOp fragment_return,
+                                  int64_t max_negligible_bytes) {
   Value returned_value =
       fragment_return.getOperand(fragment_result.getResultNumber());
   if (Operation* producer = returned_value.getDefiningOp();
-      producer && producer->getNumOperands() == 0 &&
-      producer->getNumResults() == 1) {
+      producer && IsNegligibleOp(producer, max_negligible_bytes)) {
     return producer;
   }
   return nullptr;
@@ -52,13 +54,14 @@ class InsertNamelessCloneOfNeglibleOpsPass
  protected:
   void runOnFunc(func::FuncOp func_op) final {
     IRRewriter rewriter(func_op.getContext());
-    func_op.walk([&rewriter](NamedComputationOp named_computation) {
+    func_op.walk([&](NamedComputationOp named_computation) {
       rewriter.setInsertionPointAfter(named_computation);
       Operation* terminator =
           named_computation.getBody()->getTerminator();
       for (OpResult result : named_computation->getResults()) {
         if (Operation* producer =
-                FindNegligibleProducer(result, cast<ReturnOp>(terminator))) {
+                FindNegligibleProducer(result, cast<ReturnOp>(terminator),
+                                       maxNegligibleBytes)) {
           // We only replace uses that represent ops that need mesh assignment.
           // A function's return will never be assigned to a mesh and therefore
           // should not be affected. Moreover, doing so could cause problems
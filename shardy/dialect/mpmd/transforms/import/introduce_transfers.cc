@@ -54,9 +54,15 @@ namespace {
 // independent ones (m1->m2, m1->m3). For achieving pipeline order, assigns are
 // sorted by mesh name suffix number or lexicographically if no suffix number
 // exists.
+//
+// With a `fan_out` greater than 1, the transfers form a tree in which each mesh
+// transfers to at most `fan_out` meshes instead (see
+// `ReplaceAssignsWithTransferTree`), and transfers relayed through other meshes
+// are reused too.
 class AssignOfUnassignPattern : public OpRewritePattern<AssignOp> {
  public:
-  using OpRewritePattern<AssignOp>::OpRewritePattern;
+  AssignOfUnassignPattern(MLIRContext* context, int fan_out)
+      : OpRewritePattern<AssignOp>(context), fan_out_(fan_out) {}
 
   LogicalResult matchAndRewrite(AssignOp op,
                                 PatternRewriter& rewriter) const override {
@@ -76,6 +82,22 @@ class AssignOfUnassignPattern : public OpRewritePattern<AssignOp> {
       return success();
     }
 
+    if (fan_out_ > 1) {
+      if (SmallVector<TransferOp> path =
+              FindRelayedTransfer(op_to_transfer, target_type);
+          !path.empty()) {
+        // Same as below, but the transfers the existing one relays from need
+        // to come before the current user too.
+        for (TransferOp transfer : path) {
+          if (op->isBeforeInBlock(transfer)) {
+            rewriter.moveOpBefore(transfer, op);
+          }
+        }
+        rewriter.replaceOp(op, path.back().getResult());
+        return success();
+      }
+    }
+
     auto existing_transfer_it =
         llvm::find_if(op_to_transfer.getUsers(), [target_type](Operation* op) {
           if (auto trf = DynCastInterMeshTransfer(op)) {
@@ -100,7 +122,10 @@ class AssignOfUnassignPattern : public OpRewritePattern<AssignOp> {
     SmallVector<AssignOp> cross_mesh_assigns =
         GetCrossMeshAssignUsers(unassign_op);
 
-    if (cross_mesh_assigns.size() >= 2) {
+    if (cross_mesh_assigns.size() >= 2 && fan_out_ > 1) {
+      ReplaceAssignsWithTransferTree(cross_mesh_assigns, op_to_transfer,
+                                     fan_out_, rewriter);
+    } else if (cross_mesh_assigns.size() >= 2) {
       ReplaceAssignsWithChainedTransfers(cross_mesh_assigns, op_to_transfer,
                                          rewriter);
     } else {
@@ -109,6 +134,32 @@ class AssignOfUnassignPattern : public OpRewritePattern<AssignOp> {
     }
     return success();
   }
+
+ private:
+  // Returns the path of inter-mesh transfers from `value` to a transfer of
+  // `value` to `target_type`, possibly relayed through transfers to other
+  // meshes, or an empty path if there is none.
+  SmallVector<TransferOp> FindRelayedTransfer(Value value,
+                                              Type target_type) const {
+    for (Operation* user : value.getUsers()) {
+      auto transfer = DynCastInterMeshTransfer(user);
+      if (!transfer) {
+        continue;
+      }
+      if (transfer.getType() == target_type) {
+        return {transfer};
+      }
+      if (SmallVector<TransferOp> path =
+              FindRelayedTransfer(transfer.getResult(), target_type);
+          !path.empty()) {
+        path.insert(path.begin(), transfer);
+        return path;
+      }
+    }
+    return {};
+  }
+
+  int fan_out_;
 };
 
 // This checks if all `stablehlo.add` operands are UnassignOps, for additions of
@@ -286,8 +337,8 @@ class IntroduceTransfersPass
  protected:
   LogicalResult initialize(MLIRContext* context) final {
     RewritePatternSet patternsInternal(context);
-    patternsInternal.add<AssignOfUnassignPattern, PushAssignBackwardThroughAdd>(
-        context);
+    patternsInternal.add<AssignOfUnassignPattern>(context, transferFanOut);
+    patternsInternal.add<PushAssignBackwardThroughAdd>(context);
     patterns = std::move(patternsInternal);
 
     return success();
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <utility>
 
@@ -36,6 +37,7 @@ limitations under the License.
 #include "shardy/dialect/mpmd/ir/utils.h"
 #include "shardy/dialect/mpmd/transforms/import/mesh_assignment_map.h"
 #include "shardy/dialect/mpmd/transforms/import/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/import/stage_balancing.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 
 namespace mlir::mpmd {
@@ -189,6 +191,23 @@ bool MapNamedTensorToUnassignOfAssign(NamedTensorOp named_tensor_op,
   return true;
 }
 
+// Returns the assignment to use for `func_op`, which is `assignment` if
+// `balanced_stage_meshes` is empty, or `assignment` completed with a balanced
+// stage assignment otherwise, stored in `balanced_assignment`. Returns null if
+// there is no balanced stage assignment.
+const UserAssignmentMap* GetAssignmentMap(
+    func::FuncOp func_op, const UserAssignmentMap& assignment,
+    ArrayRef<std::string> balanced_stage_meshes,
+    int64_t stage_memory_cap_bytes,
+    std::optional<UserAssignmentMap>& balanced_assignment) {
+  if (balanced_stage_meshes.empty()) {
+    return &assignment;
+  }
+  balanced_assignment = ProposeBalancedStageAssignment(
+      func_op, assignment, balanced_stage_meshes, stage_memory_cap_bytes);
+  return balanced_assignment ? &*balanced_assignment : nullptr;
+}
+
 class InlineNestedUserExposedOpsPass
     : public impl::InlineNestedUserExposedOpsPassBase<
           InlineNestedUserExposedOpsPass> {
@@ -197,6 +216,13 @@ class InlineNestedUserExposedOpsPass
 
  protected:
   void runOnFunc(func::FuncOp func_op) override {
+    std::optional<UserAssignmentMap> balanced_assignment;
+    const UserAssignmentMap* assignment_map =
+        GetAssignmentMap(func_op, assignment.value, *balancedStageMeshes,
+                         stageMemoryCapBytes, balanced_assignment);
+    if (!assignment_map) {
+      return signalPassFailure();
+    }
     IRRewriter rewriter(func_op.getContext());
     bool pass_must_signal_failure = false;
 
@@ -209,7 +235,7 @@ class InlineNestedUserExposedOpsPass
         return WalkResult::advance();
       }
       std::optional<MeshStageAssignment> parent_mesh_assignment =
-          GetMeshStageAssignment(parent, assignment.value);
+          GetMeshStageAssignment(parent, *assignment_map);
 
       auto is_parent_missing_assignment = [&]() {
         if (!parent_mesh_assignment.has_value()) {
@@ -227,7 +253,7 @@ class InlineNestedUserExposedOpsPass
           return WalkResult::interrupt();
         }
         std::optional<MeshStageAssignment> op_assignment =
-            GetMeshStageAssignment(named_computation, assignment.value);
+            GetMeshStageAssignment(named_computation, *assignment_map);
         if (op_assignment.has_value() &&
             op_assignment != parent_mesh_assignment) {
           named_computation.emitError("NamedComputation '")
@@ -245,7 +271,7 @@ class InlineNestedUserExposedOpsPass
           return WalkResult::interrupt();
         }
         std::optional<MeshTensorType> mesh_tensor =
-            GetMeshTensorTypeFromAssignment(named_tensor, assignment.value);
+            GetMeshTensorTypeFromAssignment(named_tensor, *assignment_map);
         if (mesh_tensor.has_value() && mesh_tensor->getMemoryKind()) {
           SDY_LOG(WARNING) << "Named tensor "
                            << std::string_view(named_tensor.getName())
@@ -282,13 +308,20 @@ class MapNamedOpsToMpmdOpsPass
 
  protected:
   void runOnFunc(func::FuncOp func_op) override {
+    std::optional<UserAssignmentMap> balanced_assignment;
+    const UserAssignmentMap* assignment_map =
+        GetAssignmentMap(func_op, assignment.value, *balancedStageMeshes,
+                         stageMemoryCapBytes, balanced_assignment);
+    if (!assignment_map) {
+      return signalPassFailure();
+    }
     IRRewriter rewriter(func_op.getContext());
     bool pass_must_signal_failure = false;
 
     func_op.getBody().walk([&](Operation* op) {
       if (auto named_computation = dyn_cast<NamedComputationOp>(op)) {
         if (std::optional<MeshStageAssignment> op_assignment =
-                GetMeshStageAssignment(named_computation, assignment.value)) {
+                GetMeshStageAssignment(named_computation, *assignment_map)) {
           MapNamedComputationToMesh(named_computation, *op_assignment,
                                     rewriter);
         } else {
@@ -305,7 +338,7 @@ class MapNamedOpsToMpmdOpsPass
 
       if (auto named_tensor = dyn_cast<NamedTensorOp>(op)) {
         if (!MapNamedTensorToUnassignOfAssign(named_tensor, rewriter,
-                                              assignment.value)) {
+                                              *assignment_map)) {
           pass_must_signal_failure = true;
         }
       }
@@ -61,12 +61,39 @@ IndexedAssignmentMap ConvertMeshVectorToMap(
   return index_to_mesh_map;
 }
 
+llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
+                              const MeshTransferCostsOption& option) {
+  llvm::interleaveComma(option.value, os, [&](const auto& entry) {
+    os << entry.first.first << ":" << entry.first.second << "="
+       << entry.second;
+  });
+  return os;
+}
+
+double GetTransferCost(const MeshTransferCosts& costs, llvm::StringRef src_mesh,
+                       llvm::StringRef dst_mesh) {
+  if (src_mesh == dst_mesh) {
+    return 0;
+  }
+  if (auto it = costs.find({src_mesh.str(), dst_mesh.str()});
+      it != costs.end()) {
+    return it->second;
+  }
+  if (auto it = costs.find({dst_mesh.str(), src_mesh.str()});
+      it != costs.end()) {
+    return it->second;
+  }
+  return 1;
+}
+
 }  // namespace mlir::mpmd
 
 namespace llvm::cl {
 
 using ::mlir::mpmd::IndexedAssignmentMap;
 using ::mlir::mpmd::IndexedAssignmentMapOption;
+using ::mlir::mpmd::MeshTransferCosts;
+using ::mlir::mpmd::MeshTransferCostsOption;
 using ::mlir::mpmd::UserAssignmentMap;
 using ::mlir::mpmd::UserAssignmentMapOption;
 
@@ -169,4 +196,48 @@ void parser<IndexedAssignmentMapOption>::printOptionDiff(
 
 void parser<IndexedAssignmentMapOption>::anchor() {}
 
+//===----------------------------------------------------------------------===//
+// MeshTransferCostsOption
+//===----------------------------------------------------------------------===//
+
+template class basic_parser<MeshTransferCostsOption>;
+
+bool parser<MeshTransferCostsOption>::parse(Option& opt, StringRef,
+                                            StringRef arg,
+                                            MeshTransferCostsOption& value) {
+  MeshTransferCosts& costs = value.value;
+  StringRef cur;
+  while (!arg.empty()) {
+    // This allows a redundant comma as the last character.
+    std::tie(cur, arg) = arg.split(',');
+    cur = cur.trim();
+    auto [meshes, cost_str] = cur.split('=');
+    auto [src_mesh, dst_mesh] = meshes.split(':');
+    if (cost_str.empty() || dst_mesh.empty()) {
+      return opt.error(
+          "Transfer cost must be of the form 'mesh:mesh=cost', got: " + cur);
+    }
+    double cost;
+    if (cost_str.getAsDouble(cost) || cost < 0) {
+      return opt.error("Failed to parse non-negative transfer cost: " +
+                       cost_str);
+    }
+    costs[std::make_pair(src_mesh.str(), dst_mesh.str())] = cost;
+  }
+  return false;
+}
+
+void parser<MeshTransferCostsOption>::printOptionDiff(
+    const Option& opt, const MeshTransferCostsOption& value,
+    const OptVal& defaultValue, size_t globalWidth) const {
+  printOptionName(opt, globalWidth);
+  outs() << "= " << value;
+  if (defaultValue.hasValue()) {
+    outs().indent(2) << " (default: " << defaultValue.getValue() << ")";
+  }
+  outs() << "\n";
+}
+
+void parser<MeshTransferCostsOption>::anchor() {}
+
 }  // namespace llvm::cl
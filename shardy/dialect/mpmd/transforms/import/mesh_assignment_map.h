@@ -77,12 +77,36 @@ llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
 IndexedAssignmentMap ConvertMeshVectorToMap(
     const std::vector<std::optional<std::string>>& meshes);
 
+// A user-defined mapping between pairs of meshes and the cost of transferring a
+// tensor between them, e.g., the inverse of their bandwidth or the number of
+// hops between them. E.g., {m1, m2} -> c means that a transfer from m1 to m2,
+// or from m2 to m1, costs c.
+//
+// Note: `std::map` is used to ensure stable iteration order, as for
+// `UserAssignmentMap`.
+using MeshTransferCosts =
+    std::map<std::pair<std::string, std::string>, double>;
+
+// A `MeshTransferCosts` option with a custom parser/printer.
+struct MeshTransferCostsOption {
+  MeshTransferCosts value;
+};
+
+llvm::raw_ostream& operator<<(llvm::raw_ostream& os,
+                              const MeshTransferCostsOption& option);
+
+// Returns the cost of transferring a tensor from `src_mesh` to `dst_mesh`,
+// which is 0 if they are the same mesh, and 1 if `costs` doesn't specify it.
+double GetTransferCost(const MeshTransferCosts& costs, llvm::StringRef src_mesh,
+                       llvm::StringRef dst_mesh);
+
 }  // namespace mlir::mpmd
 
 namespace llvm::cl {
 
 extern template class basic_parser<mlir::mpmd::UserAssignmentMapOption>;
 extern template class basic_parser<mlir::mpmd::IndexedAssignmentMapOption>;
+extern template class basic_parser<mlir::mpmd::MeshTransferCostsOption>;
 
 template <>
 class parser<mlir::mpmd::UserAssignmentMapOption>
@@ -112,6 +136,20 @@ class parser<mlir::mpmd::IndexedAssignmentMapOption>
   void anchor() override;
 };
 
+template <>
+class parser<mlir::mpmd::MeshTransferCostsOption>
+    : public basic_parser<mlir::mpmd::MeshTransferCostsOption> {
+ public:
+  parser(Option& opt) : basic_parser(opt) {}
+  bool parse(Option& opt, StringRef argName, StringRef arg,
+             mlir::mpmd::MeshTransferCostsOption& value);
+  StringRef getValueName() const override { return "mesh-transfer-costs"; }
+  void printOptionDiff(const Option& opt,
+                       const mlir::mpmd::MeshTransferCostsOption& value,
+                       const OptVal& defaultValue, size_t globalWidth) const;
+  void anchor() override;
+};
+
 }  // namespace llvm::cl
 
 #endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_IMPORT_MESH_ASSIGNMENT_MAP_H_
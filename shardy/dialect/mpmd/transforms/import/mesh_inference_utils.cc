@@ -16,10 +16,13 @@ limitations under the License.
 #include "shardy/dialect/mpmd/transforms/import/mesh_inference_utils.h"
 
 #include <optional>
+#include <string>
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/AffineMap.h"
 #include "mlir/IR/Attributes.h"
@@ -378,11 +381,24 @@ bool IsCallOpInCallChain(CallOp call_op) {
   });
 }
 
-bool CallOpHasUseSetPopulated(CallOp call_op) {
-  FuncOp callee_func = GetCalleeFunc(call_op);
-  return llvm::any_of(callee_func.getArguments(), [&](BlockArgument arg) {
-    return callee_func.getArgAttr(arg.getArgNumber(), kMpmdUseSet);
-  });
+std::string PrintMeshWithOrigins(MeshWithOriginsAttr mesh_with_origins) {
+  std::string result;
+  llvm::raw_string_ostream str_stream(result);
+  str_stream << mesh_with_origins.getMeshName();
+  str_stream << "["
+             << llvm::join(llvm::map_range(mesh_with_origins.getOrigins(),
+                                           [](const OriginAttr& origin) {
+                                             return origin.getOriginLabel();
+                                           }),
+                           ",")
+             << "]";
+  return result;
+}
+
+std::string PrintMeshesWithOrigins(
+    ArrayRef<MeshWithOriginsAttr> meshes_with_origins) {
+  return llvm::join(llvm::map_range(meshes_with_origins, PrintMeshWithOrigins),
+                    ", ");
 }
 
 }  // namespace mlir::mpmd
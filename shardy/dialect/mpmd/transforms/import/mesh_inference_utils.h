@@ -17,6 +17,7 @@ limitations under the License.
 #define SHARDY_DIALECT_MPMD_TRANSFORMS_IMPORT_MESH_INFERENCE_UTILS_H_
 
 #include <optional>
+#include <string>
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Builders.h"
@@ -161,10 +162,13 @@ inline bool CanConvertToReduce(Operation* op) {
 // %w = call @f(%v)
 bool IsCallOpInCallChain(CallOp call_op);
 
-// Returns true if the use_set of the callee func has been populated.
-// This checks if any of the callee func's args have the use_set attribute
-// populated as a proxy.
-bool CallOpHasUseSetPopulated(CallOp call_op);
+// Prints mesh with origins in the format of `mesh[origin1,origin2]`.
+std::string PrintMeshWithOrigins(MeshWithOriginsAttr mesh_with_origins);
+
+// Prints meshes with origins in the format of
+// `mesh[origin1,origin2], mesh2[origin3]`.
+std::string PrintMeshesWithOrigins(
+    ArrayRef<MeshWithOriginsAttr> meshes_with_origins);
 
 }  // namespace mlir::mpmd
 
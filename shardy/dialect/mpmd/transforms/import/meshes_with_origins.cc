@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetOperations.h"
+#include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/MLIRContext.h"
@@ -242,4 +243,108 @@ std::optional<StringRef> MeshesWithOrigins::GetPrioritizedMeshName(
   return GetHighestPriorityMeshName(*mesh_to_origins_);
 }
 
+int MeshIndexer::GetOrInsert(StringRef mesh_name) {
+  auto [it, inserted] =
+      mesh_name_to_index_.try_emplace(mesh_name, mesh_names_.size());
+  if (inserted) {
+    mesh_names_.push_back(it->first());
+  }
+  return it->second;
+}
+
+MeshSet::MeshSet(MeshesWithOriginsAttr meshes_with_origins,
+                 MeshIndexer& indexer) {
+  if (!meshes_with_origins) {
+    return;
+  }
+  has_meshes_specified_ = true;
+  for (MeshWithOriginsAttr mesh : meshes_with_origins.getValue()) {
+    insert(mesh.getMeshName(), indexer);
+  }
+}
+
+MeshSet::MeshSet(const MeshesWithOrigins& meshes_with_origins,
+                 MeshIndexer& indexer) {
+  if (!meshes_with_origins) {
+    return;
+  }
+  has_meshes_specified_ = true;
+  for (StringRef mesh_name :
+       meshes_with_origins.MeshNames(/*include_wildcard_mesh=*/true)) {
+    insert(mesh_name, indexer);
+  }
+}
+
+MeshSet MeshSet::CreateUseSet(MeshesWithOriginsAttr meshes_with_origins,
+                              MeshIndexer& indexer) {
+  MeshSet use_set(meshes_with_origins, indexer);
+  use_set.has_meshes_specified_ = true;
+  return use_set;
+}
+
+void MeshSet::insert(StringRef mesh_name, MeshIndexer& indexer) {
+  if (mesh_name == kWildcardMesh) {
+    has_wildcard_mesh_ = true;
+    return;
+  }
+  int index = indexer.GetOrInsert(mesh_name);
+  if (index >= static_cast<int>(meshes_.size())) {
+    meshes_.resize(indexer.size());
+  }
+  meshes_.set(index);
+}
+
+void MeshSet::Union(const MeshSet& other) {
+  if (!other.has_meshes_specified()) {
+    return;
+  }
+  if (!has_meshes_specified()) {
+    *this = other;
+    return;
+  }
+  meshes_ |= other.meshes_;
+  has_wildcard_mesh_ |= other.has_wildcard_mesh_;
+}
+
+void MeshSet::Intersect(const MeshSet& other) {
+  if (!other.has_meshes_specified()) {
+    return;
+  }
+  if (!has_meshes_specified()) {
+    *this = other;
+    return;
+  }
+
+  // A wildcard mesh matches any mesh of the other set.
+  llvm::SmallBitVector meshes = meshes_;
+  if (!other.has_wildcard_mesh()) {
+    meshes &= other.meshes_;
+  }
+  if (has_wildcard_mesh()) {
+    meshes |= other.meshes_;
+  }
+  meshes_ = std::move(meshes);
+  has_wildcard_mesh_ = has_wildcard_mesh_ && other.has_wildcard_mesh_;
+}
+
+bool MeshSet::IsSubsetOf(const MeshSet& other) const {
+  SDY_CHECK(has_meshes_specified() && other.has_meshes_specified())
+      << "IsSubsetOf is only allowed when meshes are specified.";
+  return !meshes_.test(other.meshes_);
+}
+
+SetVector<StringRef> MeshSet::MeshNames(const MeshIndexer& indexer,
+                                        bool include_wildcard_mesh) const {
+  SDY_CHECK(has_meshes_specified()) << "MeshSet is unspecified.";
+
+  SetVector<StringRef> mesh_names;
+  for (int index : meshes_.set_bits()) {
+    mesh_names.insert(indexer.GetMeshName(index));
+  }
+  if (include_wildcard_mesh && has_wildcard_mesh()) {
+    mesh_names.insert(kWildcardMesh);
+  }
+  return mesh_names;
+}
+
 }  // namespace mlir::mpmd
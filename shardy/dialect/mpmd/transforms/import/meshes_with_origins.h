@@ -21,6 +21,9 @@ limitations under the License.
 #include <optional>
 
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/Dialect.h"
 #include "mlir/IR/MLIRContext.h"
@@ -126,6 +129,76 @@ class MeshesWithOrigins {
   SetVector<OriginAttr> wildcard_origins_;
 };
 
+// Interns mesh names to dense indices, for `MeshSet`.
+class MeshIndexer {
+ public:
+  // Returns the index of `mesh_name`, assigning it the next index if it wasn't
+  // seen before.
+  int GetOrInsert(StringRef mesh_name);
+
+  StringRef GetMeshName(int index) const { return mesh_names_[index]; }
+
+  int size() const { return mesh_names_.size(); }
+
+ private:
+  llvm::StringMap<int> mesh_name_to_index_;
+  SmallVector<StringRef> mesh_names_;
+};
+
+// A compact version of `MeshesWithOrigins` that only tracks the meshes, as a
+// bitset over the indices of a `MeshIndexer`, so that set operations are a few
+// word operations rather than lookups of mesh names. Origins are only needed to
+// report errors, and can be read from the attribute the set was created from.
+//
+// The semantics of unspecified sets and of the wildcard mesh match
+// `MeshesWithOrigins`.
+class MeshSet {
+ public:
+  // Creates an unspecified set, i.e., the set of all meshes.
+  MeshSet() = default;
+
+  // Creates the set of meshes of `meshes_with_origins`, which is unspecified if
+  // the attribute is null.
+  MeshSet(MeshesWithOriginsAttr meshes_with_origins, MeshIndexer& indexer);
+
+  // Creates the set of meshes of `meshes_with_origins`.
+  MeshSet(const MeshesWithOrigins& meshes_with_origins, MeshIndexer& indexer);
+
+  // Same as `MeshSet(meshes_with_origins, indexer)`, but a null attribute is an
+  // empty set, as for `MeshesWithOrigins::CreateUseSet`.
+  static MeshSet CreateUseSet(MeshesWithOriginsAttr meshes_with_origins,
+                              MeshIndexer& indexer);
+
+  // See `MeshesWithOrigins::Union`.
+  void Union(const MeshSet& other);
+
+  // See `MeshesWithOrigins::Intersect`.
+  void Intersect(const MeshSet& other);
+
+  // Returns true if every mesh in this set is in `other`, ignoring the
+  // wildcard mesh. Both sets must be specified.
+  bool IsSubsetOf(const MeshSet& other) const;
+
+  // Returns the names of the meshes in the set, in the order of their indices.
+  // Assumes that meshes are specified.
+  SetVector<StringRef> MeshNames(const MeshIndexer& indexer,
+                                 bool include_wildcard_mesh = false) const;
+
+  int size() const { return has_meshes_specified_ ? meshes_.count() : -1; }
+  bool empty() const { return has_meshes_specified_ && meshes_.none(); }
+  bool has_meshes_specified() const { return has_meshes_specified_; }
+  bool has_wildcard_mesh() const { return has_wildcard_mesh_; }
+
+  explicit operator bool() const { return has_meshes_specified(); }
+
+ private:
+  void insert(StringRef mesh_name, MeshIndexer& indexer);
+
+  bool has_meshes_specified_ = false;
+  bool has_wildcard_mesh_ = false;
+  llvm::SmallBitVector meshes_;
+};
+
 }  // namespace mlir::mpmd
 
 #endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_IMPORT_MESHES_WITH_ORIGINS_H_
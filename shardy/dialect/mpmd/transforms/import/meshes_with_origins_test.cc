@@ -31,6 +31,7 @@ namespace mlir::mpmd {
 namespace {
 
 using ::testing::UnorderedElementsAre;
+using ::testing::UnorderedElementsAreArray;
 
 MeshesWithOrigins GetMeshesWithOrigins(
     MLIRContext& context,
@@ -353,4 +354,93 @@ TEST(MeshesWithOrigins, GetPrioritizedMeshNameHandlingLowPriorityOrigins) {
   EXPECT_EQ(m.GetPrioritizedMeshName(preferred_mesh_names), "m2");
 }
 
+TEST(MeshSet, BasicFunctionality) {
+  MLIRContext context;
+  context.loadDialect<MpmdDialect>();
+  MeshIndexer indexer;
+
+  MeshSet s1;
+  EXPECT_EQ(s1.size(), -1);
+  EXPECT_FALSE(s1.empty());
+  EXPECT_FALSE(s1.has_meshes_specified());
+
+  MeshSet s2 = MeshSet::CreateUseSet({}, indexer);
+  EXPECT_EQ(s2.size(), 0);
+  EXPECT_TRUE(s2.empty());
+  EXPECT_TRUE(s2.has_meshes_specified());
+
+  MeshSet s3(GetMeshesWithOrigins(context, {{"m1", {}}, {"*", "origin"}}),
+             indexer);
+  EXPECT_EQ(s3.size(), 1);
+  EXPECT_TRUE(s3.has_wildcard_mesh());
+  EXPECT_THAT(s3.MeshNames(indexer), UnorderedElementsAre("m1"));
+  EXPECT_THAT(s3.MeshNames(indexer, /*include_wildcard_mesh=*/true),
+              UnorderedElementsAre("m1", "*"));
+  EXPECT_EQ(indexer.size(), 1);
+}
+
+TEST(MeshSet, UnionAndIntersectMatchMeshesWithOrigins) {
+  MLIRContext context;
+  context.loadDialect<MpmdDialect>();
+  MeshIndexer indexer;
+
+  SmallVector<MeshesWithOrigins> sets = {
+      MeshesWithOrigins(),
+      GetMeshesWithOrigins(context, {}),
+      GetMeshesWithOrigins(context, {{"m1", "o1"}, {"m2", "o2"}}),
+      GetMeshesWithOrigins(context, {{"m2", "o2"}, {"m3", "o3"}}),
+      GetMeshesWithOrigins(context, {{"m3", "o3"}, {"*", "o4"}}),
+      GetMeshesWithOrigins(context, {{"*", "o5"}}),
+  };
+  for (const MeshesWithOrigins& lhs : sets) {
+    for (const MeshesWithOrigins& rhs : sets) {
+      MeshesWithOrigins expected_union = lhs;
+      expected_union.Union(rhs);
+      MeshSet actual_union(lhs, indexer);
+      actual_union.Union(MeshSet(rhs, indexer));
+      EXPECT_EQ(actual_union.has_meshes_specified(),
+                expected_union.has_meshes_specified());
+      if (expected_union) {
+        EXPECT_THAT(
+            actual_union.MeshNames(indexer, /*include_wildcard_mesh=*/true),
+            UnorderedElementsAreArray(
+                expected_union.MeshNames(/*include_wildcard_mesh=*/true)));
+      }
+
+      MeshesWithOrigins expected_intersection = lhs;
+      expected_intersection.Intersect(rhs);
+      MeshSet actual_intersection(lhs, indexer);
+      actual_intersection.Intersect(MeshSet(rhs, indexer));
+      EXPECT_EQ(actual_intersection.has_meshes_specified(),
+                expected_intersection.has_meshes_specified());
+      if (expected_intersection) {
+        EXPECT_THAT(actual_intersection.MeshNames(
+                        indexer, /*include_wildcard_mesh=*/true),
+                    UnorderedElementsAreArray(expected_intersection.MeshNames(
+                        /*include_wildcard_mesh=*/true)));
+      }
+    }
+  }
+}
+
+TEST(MeshSet, IsSubsetOf) {
+  MLIRContext context;
+  context.loadDialect<MpmdDialect>();
+  MeshIndexer indexer;
+
+  MeshSet s1(GetMeshesWithOrigins(context, {{"m1", {}}}), indexer);
+  MeshSet s2(GetMeshesWithOrigins(context, {{"m1", {}}, {"m2", {}}}), indexer);
+  MeshSet s3(GetMeshesWithOrigins(context, {{"m3", {}}, {"*", "origin"}}),
+             indexer);
+  MeshSet empty = MeshSet::CreateUseSet({}, indexer);
+
+  EXPECT_TRUE(s1.IsSubsetOf(s2));
+  EXPECT_FALSE(s2.IsSubsetOf(s1));
+  EXPECT_TRUE(s2.IsSubsetOf(s2));
+  // The wildcard mesh is ignored.
+  EXPECT_FALSE(s1.IsSubsetOf(s3));
+  EXPECT_TRUE(empty.IsSubsetOf(s1));
+  EXPECT_FALSE(s1.IsSubsetOf(empty));
+}
+
 }  // namespace mlir::mpmd
@@ -18,7 +18,9 @@ limitations under the License.
 
 // IWYU pragma: begin_keep
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
 #include "llvm/Support/CommandLine.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -45,12 +47,22 @@ struct ImportOptions {
   // Mapping between names (of computations and tensors) and mesh names, and
   // optionally stage ids
   UserAssignmentMapOption nameToMeshAssignment;
+  // If non-empty, the mesh of each stage, to which the named computations
+  // missing from `nameToMeshAssignment` are assigned by balancing their
+  // estimated cost. See `MapNamedOpsToMpmdOpsPass`.
+  SmallVector<std::string> balancedStageMeshes;
+  // If positive, the maximum activation bytes of each balanced stage.
+  int64_t stageMemoryCapBytes = 0;
   // Mapping between function input indices and assigned mesh names.
   IndexedAssignmentMapOption inputIndexToMeshAssignment;
   // Mapping between function output indices and assigned mesh names.
   IndexedAssignmentMapOption outputIndexToMeshAssignment;
   // Constraints enforcing inputs and outputs to be assigned to the same mesh.
   SmallVector<InputOutputEquishardingConstraint> inputOutputConstraints;
+  // Whether the ends of each constraint take the cheaper of the shardings of
+  // the input and the output, rather than the input's. See
+  // `EnforceEquishardingPass`.
+  bool costAwareEquisharding = false;
   // Whether to merge inferred fragments only after scheduling.
   bool mergeAfterScheduling = false;
   // Whether to absorb inferred fragments into user-defined fragments on
@@ -64,6 +76,18 @@ struct ImportOptions {
   bool splitBwdFragments = false;
   // Whether to verify if merging created the right number of scheduling units.
   bool verifyScheduleUnits = false;
+  // The maximum number of meshes each mesh transfers a value to, when it is
+  // assigned to several meshes. See `IntroduceTransfersPass`.
+  int transferFanOut = 1;
+  // If non-negative, the maximum result size in bytes of an operand-free op
+  // that is sunk into calls or cloned out of named computations. See
+  // `IsNegligibleOp`.
+  int64_t maxNegligibleBytes = -1;
+  // Whether to replace `mpmd.for` loops with calls to their outlined body,
+  // rather than fully unrolling them, so that mesh inference and merging
+  // process the body once. The calls are inlined before scheduling. See
+  // `OutlineForLoopsPass`.
+  bool outlineForLoops = false;
 };
 
 // Adds the standard set of passes to import an MPMD program with a fixed mesh
@@ -0,0 +1,185 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/import/stage_balancing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/import/mesh_assignment_map.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+
+namespace mlir::mpmd {
+
+namespace {
+
+// Returns the FLOPs of `named_computation`, which is its
+// `kFragmentCostAttrName` if present, or the estimated FLOPs of its body
+// otherwise, on global shapes as it isn't assigned to a mesh yet.
+double GetFlops(NamedComputationOp named_computation) {
+  if (auto user_cost = named_computation->getAttrOfType<FloatAttr>(
+          kFragmentCostAttrName)) {
+    return user_cost.getValueAsDouble();
+  }
+  double flops = 0.0;
+  named_computation.getRegion().walk([&](Operation* op) {
+    if (!isa<ReturnOp, NamedComputationOp>(op)) {
+      flops += EstimateOpFlops(op, /*mesh=*/nullptr);
+    }
+  });
+  return flops;
+}
+
+int64_t GetActivationBytes(NamedComputationOp named_computation) {
+  int64_t bytes = 0;
+  for (Value result : named_computation.getResults()) {
+    if (auto type = dyn_cast<RankedTensorType>(result.getType())) {
+      bytes += GetSizeInBytes(type);
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+std::vector<NamedComputationCost> GetNamedComputationCosts(
+    func::FuncOp func_op) {
+  std::vector<NamedComputationCost> costs;
+  llvm::StringMap<size_t> name_to_index;
+  for (auto named_computation : func_op.getOps<NamedComputationOp>()) {
+    auto [it, inserted] =
+        name_to_index.try_emplace(named_computation.getName(), costs.size());
+    if (inserted) {
+      costs.push_back({named_computation.getName().str()});
+    }
+    NamedComputationCost& cost = costs[it->second];
+    cost.flops += GetFlops(named_computation);
+    cost.activation_bytes += GetActivationBytes(named_computation);
+  }
+  return costs;
+}
+
+std::optional<std::vector<int64_t>> PartitionIntoBalancedStages(
+    ArrayRef<NamedComputationCost> costs, int64_t num_stages,
+    int64_t memory_cap_bytes) {
+  const int64_t n = costs.size();
+  if (num_stages <= 0 || n < num_stages) {
+    return std::nullopt;
+  }
+  // The FLOPs and bytes of the first i computations.
+  std::vector<double> flops_prefix(n + 1, 0.0);
+  std::vector<int64_t> bytes_prefix(n + 1, 0);
+  for (auto [i, cost] : llvm::enumerate(costs)) {
+    flops_prefix[i + 1] = flops_prefix[i] + cost.flops;
+    bytes_prefix[i + 1] = bytes_prefix[i] + cost.activation_bytes;
+  }
+  auto fits_in_memory = [&](int64_t begin, int64_t end) {
+    return memory_cap_bytes <= 0 ||
+           bytes_prefix[end] - bytes_prefix[begin] <= memory_cap_bytes;
+  };
+
+  // `max_flops[s][i]` is the smallest maximum FLOPs of a stage when
+  // partitioning the first i computations into s + 1 stages, and
+  // `stage_begin[s][i]` is the first computation of the last stage of that
+  // partition.
+  constexpr double kInfeasible = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> max_flops(
+      num_stages, std::vector<double>(n + 1, kInfeasible));
+  std::vector<std::vector<int64_t>> stage_begin(
+      num_stages, std::vector<int64_t>(n + 1, 0));
+  for (int64_t i = 1; i <= n; ++i) {
+    if (fits_in_memory(0, i)) {
+      max_flops[0][i] = flops_prefix[i];
+    }
+  }
+  for (int64_t s = 1; s < num_stages; ++s) {
+    for (int64_t i = s + 1; i <= n; ++i) {
+      for (int64_t j = s; j < i; ++j) {
+        if (max_flops[s - 1][j] == kInfeasible || !fits_in_memory(j, i)) {
+          continue;
+        }
+        double stage_max = std::max(max_flops[s - 1][j],
+                                    flops_prefix[i] - flops_prefix[j]);
+        if (stage_max < max_flops[s][i]) {
+          max_flops[s][i] = stage_max;
+          stage_begin[s][i] = j;
+        }
+      }
+    }
+  }
+  if (max_flops[num_stages - 1][n] == kInfeasible) {
+    return std::nullopt;
+  }
+
+  std::vector<int64_t> stages(n);
+  int64_t end = n;
+  for (int64_t s = num_stages - 1; s >= 0; --s) {
+    int64_t begin = stage_begin[s][end];
+    std::fill(stages.begin() + begin, stages.begin() + end, s);
+    end = begin;
+  }
+  return stages;
+}
+
+std::optional<UserAssignmentMap> ProposeBalancedStageAssignment(
+    func::FuncOp func_op, const UserAssignmentMap& assignment,
+    ArrayRef<std::string> stage_meshes, int64_t memory_cap_bytes) {
+  std::vector<NamedComputationCost> costs;
+  for (NamedComputationCost& cost : GetNamedComputationCosts(func_op)) {
+    if (assignment.find(cost.name) == assignment.end()) {
+      costs.push_back(std::move(cost));
+    }
+  }
+  UserAssignmentMap balanced_assignment = assignment;
+  if (costs.empty()) {
+    return balanced_assignment;
+  }
+  std::optional<std::vector<int64_t>> stages = PartitionIntoBalancedStages(
+      costs, stage_meshes.size(), memory_cap_bytes);
+  if (!stages) {
+    InFlightDiagnostic diag = func_op.emitError("Cannot partition ")
+                              << costs.size() << " named computations into "
+                              << stage_meshes.size()
+                              << " contiguous non-empty stages";
+    if (memory_cap_bytes > 0) {
+      diag << " with at most " << memory_cap_bytes << " activation bytes each";
+    }
+    diag << ".";
+    return std::nullopt;
+  }
+  for (auto [cost, stage] : llvm::zip_equal(costs, *stages)) {
+    balanced_assignment[cost.name] =
+        std::make_pair(stage_meshes[stage], stage);
+  }
+  return balanced_assignment;
+}
+
+}  // namespace mlir::mpmd
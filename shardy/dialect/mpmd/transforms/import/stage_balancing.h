@@ -0,0 +1,69 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_IMPORT_STAGE_BALANCING_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_IMPORT_STAGE_BALANCING_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/transforms/import/mesh_assignment_map.h"
+
+namespace mlir::mpmd {
+
+// The cost of the named computations with a given name, e.g., of the forward
+// and backward computations of a layer, summed over all of them.
+struct NamedComputationCost {
+  std::string name;
+  // The estimated floating point operations. See `EstimateOpFlops`.
+  double flops = 0.0;
+  // The bytes of the global results, i.e., of the activations the
+  // computations produce.
+  int64_t activation_bytes = 0;
+};
+
+// Returns the cost of each name of the top-level named computations of
+// `func_op`, in the order in which the names first appear.
+std::vector<NamedComputationCost> GetNamedComputationCosts(
+    func::FuncOp func_op);
+
+// Returns the stage of each of `costs`, such that:
+// - the stages are contiguous, i.e., the stage of a computation is never
+//   smaller than that of the computations before it,
+// - each of the `num_stages` stages has at least one computation,
+// - the activation bytes of each stage are at most `memory_cap_bytes`, if it
+//   is positive,
+// and the maximum FLOPs of a stage is minimal. Returns nullopt if there is no
+// such partition.
+std::optional<std::vector<int64_t>> PartitionIntoBalancedStages(
+    ArrayRef<NamedComputationCost> costs, int64_t num_stages,
+    int64_t memory_cap_bytes);
+
+// Returns an assignment of the top-level named computations of `func_op` that
+// aren't in `assignment` to the stages of `stage_meshes`, where stage i is on
+// mesh `stage_meshes[i]`, partitioned by `PartitionIntoBalancedStages`. The
+// entries of `assignment` are kept as they are. Emits an error and returns
+// nullopt if there is no partition within `memory_cap_bytes`.
+std::optional<UserAssignmentMap> ProposeBalancedStageAssignment(
+    func::FuncOp func_op, const UserAssignmentMap& assignment,
+    ArrayRef<std::string> stage_meshes, int64_t memory_cap_bytes);
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_IMPORT_STAGE_BALANCING_H_
@@ -0,0 +1,132 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/import/stage_balancing.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/transforms/import/mesh_assignment_map.h"
+#include "stablehlo/dialect/StablehloOps.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using ::mlir::func::FuncOp;
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::Optional;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+namespace mlir::mpmd {
+namespace {
+
+std::vector<NamedComputationCost> MakeCosts(ArrayRef<double> flops,
+                                            ArrayRef<int64_t> bytes) {
+  std::vector<NamedComputationCost> costs;
+  for (auto [i, f] : llvm::enumerate(flops)) {
+    costs.push_back({"c" + std::to_string(i), f, bytes[i]});
+  }
+  return costs;
+}
+
+TEST(PartitionIntoBalancedStages, MinimizesMaxStageFlops) {
+  std::vector<NamedComputationCost> costs =
+      MakeCosts({1, 1, 1, 1, 4}, {0, 0, 0, 0, 0});
+  // A split by count, i.e., {1, 1, 1} and {1, 4}, has a maximum of 5.
+  EXPECT_THAT(PartitionIntoBalancedStages(costs, /*num_stages=*/2,
+                                          /*memory_cap_bytes=*/0),
+              Optional(ElementsAre(0, 0, 0, 0, 1)));
+}
+
+TEST(PartitionIntoBalancedStages, RespectsMemoryCap) {
+  std::vector<NamedComputationCost> costs =
+      MakeCosts({1, 1, 1, 1, 4}, {10, 10, 10, 10, 10});
+  EXPECT_THAT(PartitionIntoBalancedStages(costs, /*num_stages=*/2,
+                                          /*memory_cap_bytes=*/30),
+              Optional(ElementsAre(0, 0, 0, 1, 1)));
+}
+
+TEST(PartitionIntoBalancedStages, FailsIfInfeasible) {
+  std::vector<NamedComputationCost> costs = MakeCosts({1, 1, 1}, {10, 10, 10});
+  EXPECT_EQ(PartitionIntoBalancedStages(costs, /*num_stages=*/2,
+                                        /*memory_cap_bytes=*/15),
+            std::nullopt);
+  EXPECT_EQ(PartitionIntoBalancedStages(costs, /*num_stages=*/4,
+                                        /*memory_cap_bytes=*/0),
+            std::nullopt);
+}
+
+TEST(ProposeBalancedStageAssignment, KeepsUserAssignment) {
+  constexpr StringRef kProgram = R"mlir(
+  func.func @main(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32> attributes {
+      "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+    %0 = mpmd.named_computation<"embed"> (%arg0) (%arg1: tensor<4x8xf32>) {
+      mpmd.return %arg1 : tensor<4x8xf32>
+    } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+    %1 = mpmd.named_computation<"layer1"> (%0) (%arg1: tensor<4x8xf32>) {
+      %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+      %4 = stablehlo.add %3, %3 : tensor<4x8xf32>
+      mpmd.return %4 : tensor<4x8xf32>
+    } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+    %2 = mpmd.named_computation<"layer2"> (%1) (%arg1: tensor<4x8xf32>) {
+      %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+      mpmd.return %3 : tensor<4x8xf32>
+    } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+    %5 = mpmd.named_computation<"layer3"> (%2) (%arg1: tensor<4x8xf32>) {
+      %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+      mpmd.return %3 : tensor<4x8xf32>
+    } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+    func.return %5 : tensor<4x8xf32>
+  })mlir";
+
+  MLIRContext context;
+  context.loadDialect<func::FuncDialect, stablehlo::StablehloDialect,
+                      MpmdDialect>();
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  auto main_func = cast<FuncOp>(module->lookupSymbol("main"));
+
+  std::vector<NamedComputationCost> costs = GetNamedComputationCosts(main_func);
+  EXPECT_THAT(costs, ElementsAre(Field(&NamedComputationCost::flops, 0),
+                                 Field(&NamedComputationCost::flops, 64),
+                                 Field(&NamedComputationCost::flops, 32),
+                                 Field(&NamedComputationCost::flops, 32)));
+
+  UserAssignmentMap assignment;
+  assignment["embed"] = {"m1", 0};
+  std::vector<std::string> stage_meshes = {"m1", "m2"};
+  EXPECT_THAT(ProposeBalancedStageAssignment(main_func, assignment,
+                                             stage_meshes,
+                                             /*memory_cap_bytes=*/0),
+              Optional(UnorderedElementsAre(
+                  Pair("embed", Pair("m1", Optional(0))),
+                  Pair("layer1", Pair("m1", Optional(0))),
+                  Pair("layer2", Pair("m2", Optional(1))),
+                  Pair("layer3", Pair("m2", Optional(1))))));
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
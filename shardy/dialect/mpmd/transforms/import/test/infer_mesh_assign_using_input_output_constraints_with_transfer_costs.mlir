@@ -0,0 +1,28 @@
+// RUN: mpmd_opt %s -mpmd-infer-mesh-assign-using-input-output-constraints='constraints=0:0 transfer-costs=m1:m2=10,m1:m3=10,m2:m3=1' 2>&1 | FileCheck %s
+
+#topology = #mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["y"=2]>>, <"m3": <["z"=2]>>>
+
+// Without costs we'd pick m1, but transferring the input from m1 to m2 and m3
+// costs 20, whereas from m2 to m1 and m3 it costs 11.
+// CHECK-LABEL: func @cheapest_mesh_from_use_sets(%arg0: !mpmd.mesh_tensor<"m2"
+func.func @cheapest_mesh_from_use_sets(
+  %arg0: tensor<4x8xf32> {mpmd.use_set = #mpmd.meshes_with_origins<"m1", "m2", "m3">})
+  -> tensor<4x8xf32> attributes {topology=#topology} {
+  // CHECK-NEXT: %[[UNASSIGN:.*]] = mpmd.unassign  {origin = "io_constraint_in"} %arg0
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %[[UNASSIGN]], %[[UNASSIGN]]
+  // CHECK-NEXT: %[[ASSIGN:.*]] = mpmd.assign  {origin = "io_constraint_out"} %[[ADD]]
+  // CHECK-NEXT: return %[[ASSIGN]] : !mpmd.mesh_tensor<"m2"
+  %0 = stablehlo.add %arg0, %arg0  {mpmd.use_set = #mpmd.meshes_with_origins<"m1", "m2", "m3">}: tensor<4x8xf32>
+  func.return %0 : tensor<4x8xf32>
+}
+
+// The output can only be on m1 or m3, and m3 is closer to the other mesh the
+// input is used in.
+// CHECK-LABEL: func @cheapest_mesh_from_src_set(%arg0: !mpmd.mesh_tensor<"m3"
+func.func @cheapest_mesh_from_src_set(
+  %arg0: tensor<4x8xf32> {mpmd.use_set = #mpmd.meshes_with_origins<"m1", "m2", "m3">})
+  -> tensor<4x8xf32> attributes {topology=#topology} {
+  // CHECK:      return %{{.*}} : !mpmd.mesh_tensor<"m3"
+  %0 = stablehlo.add %arg0, %arg0  {mpmd.src_set = #mpmd.meshes_with_origins<"m1", "m3">}: tensor<4x8xf32>
+  func.return %0 : tensor<4x8xf32>
+}
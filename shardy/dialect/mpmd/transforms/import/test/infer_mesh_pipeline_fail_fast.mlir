@@ -0,0 +1,43 @@
+// RUN: mpmd_opt %s -mpmd-infer-mesh-pipeline='fail-fast=true' -verify-diagnostics -split-input-file
+
+!m1_8x16 = !mpmd.mesh_tensor<"m1", tensor<8x16xf32>>
+!m2_8x16 = !mpmd.mesh_tensor<"m2", tensor<8x16xf32>>
+#topology =#mpmd.topology<<"m1": <["x"=2]>>,<"m2": <["y"=2]>>>
+
+// Only the first op with an empty src_set is reported, since inference stops
+// there.
+func.func @only_first_conflict_is_reported(%arg0: !m1_8x16, %arg1: !m2_8x16)
+  -> (tensor<8x16xf32>, tensor<8x16xf32>) attributes {topology=#topology} {
+  %0 = mpmd.unassign %arg0 : (!m1_8x16) -> tensor<8x16xf32>
+  %1 = mpmd.unassign %arg1 : (!m2_8x16) -> tensor<8x16xf32>
+  %2 = stablehlo.abs %0 : tensor<8x16xf32>
+
+  // expected-error-re @+1 {{Mesh assignment is not possible for op as its operands are on conflicting meshes{{.*}}operand 0 can only be assigned to meshes: m1{{.*}}but operand 1 can only be assigned to meshes: m2}}
+  %3 = stablehlo.divide %2, %1 : tensor<8x16xf32>
+  %4 = stablehlo.multiply %1, %0 : tensor<8x16xf32>
+
+  func.return %3, %4 : tensor<8x16xf32>, tensor<8x16xf32>
+}
+
+// -----
+
+!m1_8x16 = !mpmd.mesh_tensor<"m1", tensor<8x16xf32>>
+!m2_8x16 = !mpmd.mesh_tensor<"m2", tensor<8x16xf32>>
+#topology =#mpmd.topology<<"m1": <["x"=2]>>,<"m2": <["y"=2]>>>
+
+// The operands of the two calls conflict on the callee arg.
+func.func @callee_arg_conflict(%arg0: !m1_8x16, %arg1: !m2_8x16)
+  -> (tensor<8x16xf32>, tensor<8x16xf32>) attributes {topology=#topology} {
+  %0 = mpmd.unassign %arg0 : (!m1_8x16) -> tensor<8x16xf32>
+  %1 = mpmd.unassign %arg1 : (!m2_8x16) -> tensor<8x16xf32>
+  %2 = mpmd.call @f(%0) : (tensor<8x16xf32>) -> tensor<8x16xf32>
+  // expected-error-re @+1 {{Mesh assignment is not possible for arg0 of mpmd.call "f"{{.*}}the operand of earlier calls can only be assigned to meshes: m1{{.*}}but the operand of this call can only be assigned to meshes: m2}}
+  %3 = mpmd.call @f(%1) : (tensor<8x16xf32>) -> tensor<8x16xf32>
+  func.return %2, %3 : tensor<8x16xf32>, tensor<8x16xf32>
+}
+
+func.func private @f(%arg0: tensor<8x16xf32>) -> tensor<8x16xf32>
+  attributes {topology=#topology} {
+  %0 = stablehlo.abs %arg0 : tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
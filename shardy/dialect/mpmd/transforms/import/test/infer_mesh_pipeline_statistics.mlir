@@ -0,0 +1,24 @@
+// RUN: mpmd_opt %s -mpmd-infer-mesh-pipeline='infer-transfers=true' -mlir-pass-statistics -mlir-pass-statistics-display=list 2>&1 | FileCheck %s
+
+!m1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!m2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+#topology = #mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["y"=2]>>>
+
+// CHECK-DAG: (S) {{[1-9][0-9]*}} num-use-sets
+// CHECK-DAG: (S) {{[1-9][0-9]*}} max-use-set-size
+// CHECK-DAG: (S) {{[1-9][0-9]*}} num-src-sets
+// CHECK-DAG: (S) {{[1-9][0-9]*}} max-src-set-size
+// CHECK-DAG: (S) {{[0-9]+}} num-clones
+// CHECK-DAG: (S) 1 num-transfers
+func.func @main(%arg0: !m1_tensor) -> !m2_tensor attributes {topology=#topology} {
+  %0 = mpmd.unassign %arg0 : (!m1_tensor) -> tensor<4x8xf32>
+  %1 = stablehlo.add %0, %0 : tensor<4x8xf32>
+  %2 = mpmd.assign %1 : (tensor<4x8xf32>) -> !m1_tensor
+  %3 = mpmd.fragment<mesh="m1", origin=["f"]> (%2) (%arg1: tensor<4x8xf32>) {
+    %4 = stablehlo.multiply %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %5 = mpmd.unassign %3 : (!m1_tensor) -> tensor<4x8xf32>
+  %6 = mpmd.assign %5 : (tensor<4x8xf32>) -> !m2_tensor
+  func.return %6 : !m2_tensor
+}
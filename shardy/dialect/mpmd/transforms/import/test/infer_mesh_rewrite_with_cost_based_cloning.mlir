@@ -0,0 +1,59 @@
+// RUN: mpmd_opt %s -mpmd-infer-mesh-rewrite-using-analysis='max-clones=1 clone-flops-per-byte=1.0' 2>&1 | FileCheck %s
+
+!mesh_8x16 = !mpmd.mesh_tensor<"mesh1", tensor<8x16xf32>>
+!mesh_16 = !mpmd.mesh_tensor<"mesh1", tensor<16xf32>>
+
+// CHECK-LABEL: func @cheap_op_is_cloned_above_max_clones
+func.func @cheap_op_is_cloned_above_max_clones(%arg0: tensor<8x16xf32>, %arg1: !mesh_8x16)
+  -> (!mesh_8x16, !mesh_8x16)
+  attributes {topology = #mpmd.topology<<"mesh1" : <["x"=4]>>>}
+{
+// CHECK-NOT:  mpmd.fragment<mesh="mesh1", origin=[]>
+// CHECK:      %[[USER1:.*]] = mpmd.fragment<mesh="mesh1", origin=["m1"]>
+// CHECK-NEXT:    stablehlo.add
+// CHECK-NEXT:    stablehlo.multiply
+// CHECK:      %[[USER2:.*]] = mpmd.fragment<mesh="mesh1", origin=["m1"]>
+// CHECK-NEXT:    stablehlo.add
+// CHECK-NEXT:    stablehlo.multiply
+// CHECK:      return %[[USER1]], %[[USER2]]
+
+  // An element-wise op does one operation per 4 bytes of results.
+  %a = stablehlo.add %arg0, %arg0 : tensor<8x16xf32>
+  %aa = mpmd.assign %a : (tensor<8x16xf32>) -> !mesh_8x16
+  %user1 = mpmd.fragment<mesh="mesh1", origin=["m1"]> (%arg1, %aa) (%arg2: tensor<8x16xf32>, %arg3: tensor<8x16xf32>) {
+    %2 = stablehlo.multiply %arg2, %arg3 : tensor<8x16xf32>
+    mpmd.return %2 : tensor<8x16xf32>
+  } : (!mesh_8x16, !mesh_8x16) -> !mesh_8x16
+  %user2 = mpmd.fragment<mesh="mesh1", origin=["m1"]> (%arg1, %aa) (%arg2: tensor<8x16xf32>, %arg3: tensor<8x16xf32>) {
+    %2 = stablehlo.multiply %arg2, %arg3 : tensor<8x16xf32>
+    mpmd.return %2 : tensor<8x16xf32>
+  } : (!mesh_8x16, !mesh_8x16) -> !mesh_8x16
+  return %user1, %user2 : !mesh_8x16, !mesh_8x16
+}
+
+// CHECK-LABEL: func @expensive_op_is_wrapped
+func.func @expensive_op_is_wrapped(%arg0: tensor<8x16xf32>, %init: tensor<f32>, %arg1: !mesh_16)
+  -> (!mesh_16, !mesh_16)
+  attributes {topology = #mpmd.topology<<"mesh1" : <["x"=4]>>>}
+{
+// CHECK:      %[[INFERRED:.*]] = mpmd.fragment<mesh="mesh1", origin=[]>
+// CHECK-NEXT:    stablehlo.reduce
+// CHECK:      %[[USER1:.*]] = mpmd.fragment<mesh="mesh1", origin=["m1"]>
+// CHECK-NOT:     stablehlo.reduce
+// CHECK:      %[[USER2:.*]] = mpmd.fragment<mesh="mesh1", origin=["m1"]>
+// CHECK-NOT:     stablehlo.reduce
+// CHECK:      return %[[USER1]], %[[USER2]]
+
+  // A reduction reads 8 times more elements than it produces.
+  %r = stablehlo.reduce(%arg0 init: %init) applies stablehlo.add across dimensions = [0] : (tensor<8x16xf32>, tensor<f32>) -> tensor<16xf32>
+  %ar = mpmd.assign %r : (tensor<16xf32>) -> !mesh_16
+  %user1 = mpmd.fragment<mesh="mesh1", origin=["m1"]> (%arg1, %ar) (%arg2: tensor<16xf32>, %arg3: tensor<16xf32>) {
+    %2 = stablehlo.multiply %arg2, %arg3 : tensor<16xf32>
+    mpmd.return %2 : tensor<16xf32>
+  } : (!mesh_16, !mesh_16) -> !mesh_16
+  %user2 = mpmd.fragment<mesh="mesh1", origin=["m1"]> (%arg1, %ar) (%arg2: tensor<16xf32>, %arg3: tensor<16xf32>) {
+    %2 = stablehlo.multiply %arg2, %arg3 : tensor<16xf32>
+    mpmd.return %2 : tensor<16xf32>
+  } : (!mesh_16, !mesh_16) -> !mesh_16
+  return %user1, %user2 : !mesh_16, !mesh_16
+}
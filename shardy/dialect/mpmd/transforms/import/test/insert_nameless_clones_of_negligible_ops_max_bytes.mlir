@@ -0,0 +1,26 @@
+// RUN: mpmd_opt %s -mpmd-insert-nameless-clone-of-negligible-ops='max-negligible-bytes=16' 2>&1 | FileCheck %s
+
+// CHECK-LABEL: func @main
+func.func @main() -> (tensor<4x8xi32>, tensor<4x8xi32>, tensor<2xi32>)
+  attributes {mesh_shape = #sdy.mesh<["x"=1]>}
+{
+  // CHECK-NEXT: %[[NC:.*]]:3 = mpmd.named_computation<"nc"> () () {
+  // CHECK:      }
+  // CHECK-NEXT: %[[SPLAT:.*]] = stablehlo.constant dense<1> : tensor<4x8xi32>
+  // CHECK-NEXT: %[[SMALL_IOTA:.*]] = stablehlo.iota dim = 0 : tensor<2xi32>
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %[[NC]]#0, %[[SPLAT]]
+  // CHECK-NEXT: %[[NEG:.*]] = stablehlo.negate %[[SMALL_IOTA]]
+  // CHECK-NEXT: return %[[ADD]], %[[NC]]#0, %[[NEG]]
+  %0:3 = mpmd.named_computation<"nc"> () () {
+    // Too large to be cloned.
+    %1 = stablehlo.iota dim = 0 : tensor<4x8xi32>
+    // Large, but a splat.
+    %2 = stablehlo.constant dense<1> : tensor<4x8xi32>
+    // Small enough to be cloned.
+    %3 = stablehlo.iota dim = 0 : tensor<2xi32>
+    mpmd.return %1, %2, %3 : tensor<4x8xi32>, tensor<4x8xi32>, tensor<2xi32>
+  } : () -> (tensor<4x8xi32>, tensor<4x8xi32>, tensor<2xi32>)
+  %4 = stablehlo.add %0#0, %0#1 : tensor<4x8xi32>
+  %5 = stablehlo.negate %0#2 : tensor<2xi32>
+  func.return %4, %0#0, %5 : tensor<4x8xi32>, tensor<4x8xi32>, tensor<2xi32>
+}
@@ -0,0 +1,48 @@
+// RUN: mpmd_opt %s -mpmd-introduce-transfers='transfer-fan-out=2' 2>&1 | FileCheck %s
+
+!mesh_1_tensor_4_8_f32 = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor_4_8_f32 = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+!mesh_3_tensor_4_8_f32 = !mpmd.mesh_tensor<"m3", tensor<4x8xf32>>
+!mesh_4_tensor_4_8_f32 = !mpmd.mesh_tensor<"m4", tensor<4x8xf32>>
+!mesh_5_tensor_4_8_f32 = !mpmd.mesh_tensor<"m5", tensor<4x8xf32>>
+
+#topology = #mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>, <"m3": <["x"=2]>>, <"m4": <["x"=2]>>, <"m5": <["x"=2]>>>
+
+// Each mesh transfers to at most two meshes: m1 -> {m2, m3} and m2 -> {m4, m5}.
+// CHECK-LABEL: func @transfer_tree
+func.func @transfer_tree(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_2_tensor_4_8_f32, !mesh_3_tensor_4_8_f32, !mesh_4_tensor_4_8_f32, !mesh_5_tensor_4_8_f32, !mesh_5_tensor_4_8_f32)
+  attributes {"topology"=#topology} {
+// CHECK-NEXT: %[[T2:.*]] = mpmd.transfer %arg0 : {{.*}}m1{{.*}} -> {{.*}}m2{{.*}}
+// CHECK-NEXT: %[[T3:.*]] = mpmd.transfer %arg0 : {{.*}}m1{{.*}} -> {{.*}}m3{{.*}}
+// CHECK-NEXT: %[[T4:.*]] = mpmd.transfer %[[T2]] : {{.*}}m2{{.*}} -> {{.*}}m4{{.*}}
+// CHECK-NEXT: %[[T5:.*]] = mpmd.transfer %[[T2]] : {{.*}}m2{{.*}} -> {{.*}}m5{{.*}}
+// CHECK-NEXT: return %[[T2]], %[[T3]], %[[T4]], %[[T5]], %[[T5]]
+  %u = mpmd.unassign %arg0 : (!mesh_1_tensor_4_8_f32) -> tensor<4x8xf32>
+  %a5 = mpmd.assign %u : (tensor<4x8xf32>) -> !mesh_5_tensor_4_8_f32
+  %a2 = mpmd.assign %u : (tensor<4x8xf32>) -> !mesh_2_tensor_4_8_f32
+  %a4 = mpmd.assign %u : (tensor<4x8xf32>) -> !mesh_4_tensor_4_8_f32
+  %a3 = mpmd.assign %u : (tensor<4x8xf32>) -> !mesh_3_tensor_4_8_f32
+  %a5_again = mpmd.assign %u : (tensor<4x8xf32>) -> !mesh_5_tensor_4_8_f32
+  func.return %a2, %a3, %a4, %a5, %a5_again : !mesh_2_tensor_4_8_f32, !mesh_3_tensor_4_8_f32, !mesh_4_tensor_4_8_f32, !mesh_5_tensor_4_8_f32, !mesh_5_tensor_4_8_f32
+}
+
+// A transfer to m4 relayed through m2 is reused by another unassign of the
+// same value.
+// CHECK-LABEL: func @relayed_transfer_is_reused
+func.func @relayed_transfer_is_reused(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_2_tensor_4_8_f32, !mesh_3_tensor_4_8_f32, !mesh_4_tensor_4_8_f32, !mesh_4_tensor_4_8_f32)
+  attributes {"topology"=#topology} {
+// CHECK-NEXT: %[[T2:.*]] = mpmd.transfer %arg0 : {{.*}}m1{{.*}} -> {{.*}}m2{{.*}}
+// CHECK-NEXT: %[[T3:.*]] = mpmd.transfer %arg0 : {{.*}}m1{{.*}} -> {{.*}}m3{{.*}}
+// CHECK-NEXT: %[[T4:.*]] = mpmd.transfer %[[T2]] : {{.*}}m2{{.*}} -> {{.*}}m4{{.*}}
+// CHECK-NOT:  mpmd.transfer
+// CHECK:      return %[[T2]], %[[T3]], %[[T4]], %[[T4]]
+  %u0 = mpmd.unassign %arg0 : (!mesh_1_tensor_4_8_f32) -> tensor<4x8xf32>
+  %a2 = mpmd.assign %u0 : (tensor<4x8xf32>) -> !mesh_2_tensor_4_8_f32
+  %a3 = mpmd.assign %u0 : (tensor<4x8xf32>) -> !mesh_3_tensor_4_8_f32
+  %a4 = mpmd.assign %u0 : (tensor<4x8xf32>) -> !mesh_4_tensor_4_8_f32
+  %u1 = mpmd.unassign %arg0 : (!mesh_1_tensor_4_8_f32) -> tensor<4x8xf32>
+  %b4 = mpmd.assign %u1 : (tensor<4x8xf32>) -> !mesh_4_tensor_4_8_f32
+  func.return %a2, %a3, %a4, %b4 : !mesh_2_tensor_4_8_f32, !mesh_3_tensor_4_8_f32, !mesh_4_tensor_4_8_f32, !mesh_4_tensor_4_8_f32
+}
@@ -0,0 +1,31 @@
+// RUN: mpmd_opt %s -mpmd-map-named-ops-to-mpmd-ops='assignment=embed@m1/0 balanced-stage-meshes=m1,m2' 2>&1 | FileCheck %s
+
+// layer1 has as many FLOPs as layer2 and layer3 together, so it takes a stage
+// on its own. The user assignment of embed is kept.
+
+// CHECK-LABEL: func @balance_by_flops
+func.func @balance_by_flops(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32> attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // CHECK: mpmd.fragment<mesh="m1", origin=["embed"], stage=0>
+  // CHECK: mpmd.fragment<mesh="m1", origin=["layer1"], stage=0>
+  // CHECK: mpmd.fragment<mesh="m2", origin=["layer2"], stage=1>
+  // CHECK: mpmd.fragment<mesh="m2", origin=["layer3"], stage=1>
+  %0 = mpmd.named_computation<"embed"> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %10 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %10 : tensor<4x8xf32>
+  } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  %1 = mpmd.named_computation<"layer1"> (%0) (%arg1: tensor<4x8xf32>) {
+    %10 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    %11 = stablehlo.add %10, %10 : tensor<4x8xf32>
+    mpmd.return %11 : tensor<4x8xf32>
+  } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  %2 = mpmd.named_computation<"layer2"> (%1) (%arg1: tensor<4x8xf32>) {
+    %10 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %10 : tensor<4x8xf32>
+  } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  %3 = mpmd.named_computation<"layer3"> (%2) (%arg1: tensor<4x8xf32>) {
+    %10 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %10 : tensor<4x8xf32>
+  } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  func.return %3 : tensor<4x8xf32>
+}
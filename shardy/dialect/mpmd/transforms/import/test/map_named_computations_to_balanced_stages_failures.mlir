@@ -0,0 +1,28 @@
+// RUN: mpmd_opt %s -mpmd-map-named-ops-to-mpmd-ops='balanced-stage-meshes=m1,m2 stage-memory-cap-bytes=256' -split-input-file -verify-diagnostics
+
+// Each named computation produces 256 bytes, so each stage can only hold one.
+// expected-error @+1 {{Cannot partition 3 named computations into 2 contiguous non-empty stages with at most 256 activation bytes each.}}
+func.func @no_partition_within_memory_cap(%arg0: tensor<8x8xf32>) -> tensor<8x8xf32> attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  %0 = mpmd.named_computation<"layer1"> (%arg0) (%arg1: tensor<8x8xf32>) {
+    mpmd.return %arg1 : tensor<8x8xf32>
+  } : (tensor<8x8xf32>) -> tensor<8x8xf32>
+  %1 = mpmd.named_computation<"layer2"> (%0) (%arg1: tensor<8x8xf32>) {
+    mpmd.return %arg1 : tensor<8x8xf32>
+  } : (tensor<8x8xf32>) -> tensor<8x8xf32>
+  %2 = mpmd.named_computation<"layer3"> (%1) (%arg1: tensor<8x8xf32>) {
+    mpmd.return %arg1 : tensor<8x8xf32>
+  } : (tensor<8x8xf32>) -> tensor<8x8xf32>
+  func.return %2 : tensor<8x8xf32>
+}
+
+// -----
+
+// expected-error @+1 {{Cannot partition 1 named computations into 2 contiguous non-empty stages with at most 256 activation bytes each.}}
+func.func @fewer_named_computations_than_stages(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32> attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  %0 = mpmd.named_computation<"layer1"> (%arg0) (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (tensor<4x8xf32>) -> tensor<4x8xf32>
+  func.return %0 : tensor<4x8xf32>
+}
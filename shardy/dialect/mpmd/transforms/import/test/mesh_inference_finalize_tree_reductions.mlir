@@ -0,0 +1,56 @@
+// RUN: mpmd_opt %s -mpmd-infer-mesh-finalize='tree-reductions=true' 2>&1 | FileCheck %s
+
+!m1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!m2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+!m3_tensor = !mpmd.mesh_tensor<"m3", tensor<4x8xf32>>
+!m4_tensor = !mpmd.mesh_tensor<"m4", tensor<4x8xf32>>
+!m5_tensor = !mpmd.mesh_tensor<"m5", tensor<4x8xf32>>
+
+#topology = #mpmd.topology<<"m1" : <["x"=2]>>, <"m2" : <["x"=2]>>, <"m3" : <["x"=2]>>, <"m4" : <["x"=2]>>, <"m5" : <["x"=2]>>>
+
+// CHECK-LABEL: func @reduce_tree_on_destination_mesh
+func.func @reduce_tree_on_destination_mesh(%arg0: !m1_tensor, %arg1: !m2_tensor, %arg2: !m3_tensor, %arg3: !m4_tensor)
+  -> !m1_tensor attributes {topology = #topology} {
+// CHECK-NEXT:  %[[T2:.*]] = mpmd.transfer %arg1 {{.*}}<"m2"{{.*}} -> !mpmd.mesh_tensor<"m1"
+// CHECK-NEXT:  %[[R12:.*]] = mpmd.fragment<mesh="m1", origin=[]> (%arg0, %[[T2]])
+// CHECK-NEXT:    stablehlo.add
+// CHECK-NEXT:    mpmd.return
+// CHECK-NEXT:  }
+// CHECK-NEXT:  %[[T4:.*]] = mpmd.transfer %arg3 {{.*}}<"m4"{{.*}} -> !mpmd.mesh_tensor<"m3"
+// CHECK-NEXT:  %[[R34:.*]] = mpmd.fragment<mesh="m3", origin=[]> (%arg2, %[[T4]])
+// CHECK-NEXT:    stablehlo.add
+// CHECK-NEXT:    mpmd.return
+// CHECK-NEXT:  }
+// CHECK-NEXT:  %[[T34:.*]] = mpmd.transfer %[[R34]] {{.*}}<"m3"{{.*}} -> !mpmd.mesh_tensor<"m1"
+// CHECK-NEXT:  %[[R:.*]] = mpmd.fragment<mesh="m1", origin=[]> (%[[R12]], %[[T34]])
+// CHECK-NEXT:    stablehlo.add
+// CHECK-NEXT:    mpmd.return
+// CHECK-NEXT:  }
+// CHECK-NEXT:  return %[[R]]
+  %0 = mpmd.unassign %arg0 : (!m1_tensor) -> tensor<4x8xf32>
+  %1 = mpmd.unassign %arg1 : (!m2_tensor) -> tensor<4x8xf32>
+  %2 = mpmd.unassign %arg2 : (!m3_tensor) -> tensor<4x8xf32>
+  %3 = mpmd.unassign %arg3 : (!m4_tensor) -> tensor<4x8xf32>
+  %4 = mpmd.reduce<add>  {mpmd.use_set = #mpmd.meshes_with_origins<"m1">} %3, %2, %1, %0 : (tensor<4x8xf32>, tensor<4x8xf32>, tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  %5 = mpmd.assign %4 : (tensor<4x8xf32>) -> !m1_tensor
+  return %5 : !m1_tensor
+}
+
+// The destination mesh has no local result, so the result of the tree is
+// transferred there.
+// CHECK-LABEL: func @reduce_tree_off_destination_mesh
+func.func @reduce_tree_off_destination_mesh(%arg0: !m1_tensor, %arg1: !m2_tensor, %arg2: !m3_tensor)
+  -> !m5_tensor attributes {topology = #topology} {
+// CHECK-NEXT:  %[[T2:.*]] = mpmd.transfer %arg1 {{.*}}<"m2"{{.*}} -> !mpmd.mesh_tensor<"m1"
+// CHECK-NEXT:  %[[R12:.*]] = mpmd.fragment<mesh="m1", origin=[]> (%arg0, %[[T2]])
+// CHECK:       %[[T3:.*]] = mpmd.transfer %arg2 {{.*}}<"m3"{{.*}} -> !mpmd.mesh_tensor<"m1"
+// CHECK-NEXT:  %[[R:.*]] = mpmd.fragment<mesh="m1", origin=[]> (%[[R12]], %[[T3]])
+// CHECK:       %[[T:.*]] = mpmd.transfer %[[R]] {{.*}}<"m1"{{.*}} -> !mpmd.mesh_tensor<"m5"
+// CHECK-NEXT:  return %[[T]]
+  %0 = mpmd.unassign %arg0 : (!m1_tensor) -> tensor<4x8xf32>
+  %1 = mpmd.unassign %arg1 : (!m2_tensor) -> tensor<4x8xf32>
+  %2 = mpmd.unassign %arg2 : (!m3_tensor) -> tensor<4x8xf32>
+  %3 = mpmd.reduce<add>  {mpmd.use_set = #mpmd.meshes_with_origins<"m5">} %0, %1, %2 : (tensor<4x8xf32>, tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  %4 = mpmd.assign %3 : (tensor<4x8xf32>) -> !m5_tensor
+  return %4 : !m5_tensor
+}
@@ -0,0 +1,357 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/optimize/auto_schedule.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "mlir/IR/Block.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/logging.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/common/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+#include "shardy/dialect/mpmd/transforms/optimize/utils.h"
+
+namespace mlir::mpmd {
+
+namespace {
+
+// Returns the number of elements of `type` if it's a statically shaped tensor,
+// or zero otherwise.
+// A fragment of the simulated program.
+struct SimulatedFragment {
+  FragmentOp fragment;
+  int mesh;
+  double cost;
+  // The simulated fragments this fragment consumes values from, either
+  // directly or through ops that aren't simulated, e.g., transfers.
+  SmallVector<int> producers;
+  // The bytes of activations this fragment keeps alive, and the number of
+  // simulated fragments that use them.
+  int64_t activation_bytes = 0;
+  int num_activation_users = 0;
+  // The simulated fragments whose activations this fragment uses.
+  SmallVector<int> activation_producers;
+};
+
+// Returns the simulated fragments of `fragments`, in program order.
+//
+// Ops that aren't in `fragments` are free and forward the producers of their
+// operands to their users.
+std::vector<SimulatedFragment> BuildSimulatedFragments(
+    ArrayRef<FragmentOp> fragments, FragmentCostAnalysis* cost_analysis) {
+  std::vector<SimulatedFragment> simulated_fragments;
+  if (fragments.empty()) {
+    return simulated_fragments;
+  }
+  llvm::DenseMap<Operation*, int> fragment_to_index;
+  for (auto [index, fragment] : llvm::enumerate(fragments)) {
+    fragment_to_index[fragment] = index;
+  }
+
+  llvm::StringMap<int> mesh_name_to_index;
+  simulated_fragments.resize(fragments.size());
+  Block& block = *fragments.front()->getBlock();
+  llvm::DenseMap<Operation*, llvm::SmallSetVector<int, 4>> op_to_producers;
+  for (Operation& op : block) {
+    llvm::SmallSetVector<int, 4> producers;
+    op.walk([&](Operation* nested_op) {
+      for (Value operand : nested_op->getOperands()) {
+        Operation* def = operand.getDefiningOp();
+        if (!def) {
+          continue;
+        }
+        if (Operation* ancestor = block.findAncestorOpInBlock(*def);
+            ancestor && ancestor != &op) {
+          if (auto it = op_to_producers.find(ancestor);
+              it != op_to_producers.end()) {
+            producers.insert(it->second.begin(), it->second.end());
+          }
+        }
+      }
+    });
+
+    auto it = fragment_to_index.find(&op);
+    if (it == fragment_to_index.end()) {
+      if (!producers.empty()) {
+        op_to_producers[&op] = std::move(producers);
+      }
+      continue;
+    }
+    FragmentOp fragment = cast<FragmentOp>(op);
+    SimulatedFragment& simulated_fragment = simulated_fragments[it->second];
+    simulated_fragment.fragment = fragment;
+    simulated_fragment.mesh =
+        mesh_name_to_index
+            .try_emplace(fragment.getMeshName(), mesh_name_to_index.size())
+            .first->second;
+    simulated_fragment.cost = cost_analysis
+                                  ? cost_analysis->GetCost(fragment).flops
+                                  : EstimateFragmentCost(fragment);
+    simulated_fragment.producers.assign(producers.begin(), producers.end());
+    op_to_producers[&op].insert(it->second);
+    if (!IsForwardFragment(fragment)) {
+      continue;
+    }
+    simulated_fragment.activation_bytes = GetActivationBytes(fragment);
+    llvm::SmallSetVector<int, 4> activation_users;
+    for (Operation* user : fragment->getUsers()) {
+      if (auto user_it = fragment_to_index.find(user);
+          user_it != fragment_to_index.end() &&
+          IsBackwardFragment(cast<FragmentOp>(user))) {
+        activation_users.insert(user_it->second);
+      }
+    }
+    simulated_fragment.num_activation_users = activation_users.size();
+    for (int user : activation_users) {
+      simulated_fragments[user].activation_producers.push_back(it->second);
+    }
+  }
+  return simulated_fragments;
+}
+
+}  // namespace
+
+int64_t GetActivationBytes(FragmentOp fragment) {
+  int64_t bytes = 0;
+  for (OpResult result : fragment->getResults()) {
+    if (llvm::none_of(result.getUsers(), [](Operation* user) {
+          auto user_fragment = dyn_cast<FragmentOp>(user);
+          return user_fragment && IsBackwardFragment(user_fragment);
+        })) {
+      continue;
+    }
+    bytes += GetLocalSizeInBytes(cast<MeshTensorType>(result.getType()),
+                                 fragment);
+  }
+  return bytes;
+}
+
+std::optional<SimulatedSchedule> SimulatePipelineSchedule(
+    ArrayRef<FragmentOp> fragments, const FragmentRanker& ranker,
+    const AutoScheduleOptions& options) {
+  std::vector<SimulatedFragment> simulated_fragments =
+      BuildSimulatedFragments(fragments, options.cost_analysis);
+
+  // The fragments of each mesh in the order of their ranks, where fragments
+  // with the same rank keep their program order.
+  SmallVector<SmallVector<std::pair<FragmentRank, int>>> mesh_to_ranked;
+  for (auto [index, simulated_fragment] :
+       llvm::enumerate(simulated_fragments)) {
+    std::optional<FragmentRank> rank = ranker(simulated_fragment.fragment);
+    if (!rank) {
+      return std::nullopt;
+    }
+    if (simulated_fragment.mesh >= mesh_to_ranked.size()) {
+      mesh_to_ranked.resize(simulated_fragment.mesh + 1);
+    }
+    mesh_to_ranked[simulated_fragment.mesh].emplace_back(std::move(*rank),
+                                                         index);
+  }
+  for (auto& ranked_fragments : mesh_to_ranked) {
+    llvm::stable_sort(ranked_fragments, [](const auto& lhs, const auto& rhs) {
+      return lhs.first < rhs.first;
+    });
+  }
+
+  // Each mesh executes its next fragment once all the producers of the
+  // fragment finished, until every fragment executed or no mesh can make
+  // progress, meaning the order of the ranks contradicts a dependency.
+  std::vector<std::optional<double>> finish_times(simulated_fragments.size());
+  SmallVector<int> next_positions(mesh_to_ranked.size(), 0);
+  SmallVector<double> mesh_free_times(mesh_to_ranked.size(), 0.0);
+  SmallVector<int64_t> in_flight_microbatches(mesh_to_ranked.size(), 0);
+  SmallVector<int64_t> live_activation_bytes(mesh_to_ranked.size(), 0);
+  SmallVector<int> remaining_activation_users = llvm::map_to_vector(
+      simulated_fragments, [](const SimulatedFragment& simulated_fragment) {
+        return simulated_fragment.num_activation_users;
+      });
+  SimulatedSchedule result;
+  result.executions.resize(simulated_fragments.size());
+  int num_executed = 0;
+  while (num_executed < simulated_fragments.size()) {
+    bool made_progress = false;
+    for (auto [mesh, ranked_fragments] : llvm::enumerate(mesh_to_ranked)) {
+      for (int& position = next_positions[mesh];
+           position < ranked_fragments.size(); ++position) {
+        const SimulatedFragment& simulated_fragment =
+            simulated_fragments[ranked_fragments[position].second];
+        double start_time = mesh_free_times[mesh];
+        bool is_ready = true;
+        for (int producer : simulated_fragment.producers) {
+          if (!finish_times[producer]) {
+            is_ready = false;
+            break;
+          }
+          double latency =
+              simulated_fragments[producer].mesh == simulated_fragment.mesh
+                  ? 0.0
+                  : options.transfer_latency;
+          start_time = std::max(start_time, *finish_times[producer] + latency);
+        }
+        if (!is_ready) {
+          break;
+        }
+        double finish_time = start_time + simulated_fragment.cost;
+        finish_times[ranked_fragments[position].second] = finish_time;
+        SimulatedExecution& execution =
+            result.executions[ranked_fragments[position].second];
+        execution.start_time = start_time;
+        execution.finish_time = finish_time;
+        for (int producer : simulated_fragment.producers) {
+          if (simulated_fragments[producer].mesh != simulated_fragment.mesh) {
+            execution.transfer_sources.push_back(producer);
+          }
+        }
+        mesh_free_times[mesh] = finish_time;
+        result.makespan = std::max(result.makespan, finish_time);
+        if (IsForwardFragment(simulated_fragment.fragment)) {
+          result.max_in_flight_microbatches =
+              std::max(result.max_in_flight_microbatches,
+                       ++in_flight_microbatches[mesh]);
+          live_activation_bytes[mesh] += simulated_fragment.activation_bytes;
+          result.max_live_activation_bytes = std::max(
+              result.max_live_activation_bytes, live_activation_bytes[mesh]);
+        } else if (IsBackwardFragment(simulated_fragment.fragment) &&
+                   !IsSplitDropTransferred(simulated_fragment.fragment) &&
+                   in_flight_microbatches[mesh] > 0) {
+          // When a backward fragment is split, only the part that computes
+          // the transferred gradients finishes the microbatch.
+          --in_flight_microbatches[mesh];
+        }
+        // The activations of a forward fragment are released once all the
+        // fragments that use them executed.
+        for (int producer : simulated_fragment.activation_producers) {
+          if (--remaining_activation_users[producer] == 0) {
+            live_activation_bytes[simulated_fragments[producer].mesh] -=
+                simulated_fragments[producer].activation_bytes;
+          }
+        }
+        ++num_executed;
+        made_progress = true;
+      }
+    }
+    if (!made_progress) {
+      return std::nullopt;
+    }
+  }
+  return result;
+}
+
+std::optional<ScheduleCandidate> FindBestPipelineSchedule(
+    ArrayRef<FragmentOp> fragments, const AutoScheduleOptions& options) {
+  if (fragments.empty()) {
+    return std::nullopt;
+  }
+
+  std::vector<ScheduleCandidate> candidates;
+  for (PipelineSchedule schedule :
+       {PipelineSchedule::k1F1B, PipelineSchedule::kGPipe,
+        PipelineSchedule::kGPipeBut1F1BForLastMesh,
+        PipelineSchedule::kCircular,
+        PipelineSchedule::kCircularWithReversedBackward,
+        PipelineSchedule::kCircularWithSplitBackward,
+        PipelineSchedule::kParallelPipelinesWithWrapAround}) {
+    candidates.push_back(
+        {ToString(schedule), *BuiltinFragmentRanker(schedule)});
+  }
+  const int num_meshes = GetNumMeshes(fragments.front());
+  if (options.max_activation_bytes > 0) {
+    // Schedule as many warmup forward fragments on each mesh as fit in the
+    // bound, given the largest activations of a forward fragment on the mesh.
+    SmallVector<int64_t> max_warmup_forwards(num_meshes, num_meshes);
+    for (FragmentOp fragment : fragments) {
+      if (!IsForwardFragment(fragment)) {
+        continue;
+      }
+      if (int64_t bytes = GetActivationBytes(fragment); bytes > 0) {
+        int64_t& max_warmup = max_warmup_forwards[GetMeshIndex(fragment)];
+        max_warmup = std::min(max_warmup, options.max_activation_bytes / bytes);
+      }
+    }
+    candidates.push_back(
+        {"MemoryBounded1F1B",
+         OneFOneBRankerWithWarmup(
+             [max_warmup_forwards](int mesh_index, int pipeline_depth) {
+               return std::min<int64_t>(pipeline_depth - mesh_index,
+                                        max_warmup_forwards[mesh_index]);
+             })});
+  }
+  for (int64_t extra_warmup_forwards = 1; extra_warmup_forwards < num_meshes;
+       ++extra_warmup_forwards) {
+    candidates.push_back(
+        {llvm::formatv("1F1B+{0}", extra_warmup_forwards).str(),
+         OneFOneBRankerWithExtraWarmup(extra_warmup_forwards)});
+  }
+
+  // Every candidate simulates the same fragments, so their costs are only
+  // computed once.
+  AutoScheduleOptions simulation_options = options;
+  std::optional<FragmentCostAnalysis> cost_analysis;
+  if (!simulation_options.cost_analysis) {
+    cost_analysis.emplace(fragments.front()->getParentOp());
+    simulation_options.cost_analysis = &*cost_analysis;
+  }
+
+  std::optional<ScheduleCandidate> best_candidate;
+  double best_makespan = 0.0;
+  for (ScheduleCandidate& candidate : candidates) {
+    std::optional<SimulatedSchedule> simulated = SimulatePipelineSchedule(
+        fragments, candidate.ranker, simulation_options);
+    if (!simulated) {
+      SDY_LOG(INFO) << "Cannot simulate " << candidate.name << " schedule.";
+      continue;
+    }
+    SDY_LOG(INFO) << "Simulated " << candidate.name
+                  << " schedule: makespan=" << simulated->makespan
+                  << ", max in-flight microbatches="
+                  << simulated->max_in_flight_microbatches
+                  << ", max live activation bytes="
+                  << simulated->max_live_activation_bytes;
+    if ((options.max_in_flight_microbatches > 0 &&
+         simulated->max_in_flight_microbatches >
+             options.max_in_flight_microbatches) ||
+        (options.max_activation_bytes > 0 &&
+         simulated->max_live_activation_bytes >
+             options.max_activation_bytes)) {
+      continue;
+    }
+    if (!best_candidate || simulated->makespan < best_makespan) {
+      best_makespan = simulated->makespan;
+      best_candidate = std::move(candidate);
+    }
+  }
+  return best_candidate;
+}
+
+}  // namespace mlir::mpmd
@@ -0,0 +1,112 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_AUTO_SCHEDULE_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_AUTO_SCHEDULE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+
+namespace mlir::mpmd {
+
+struct AutoScheduleOptions {
+  // The latency of a transfer between fragments on different meshes.
+  double transfer_latency = 0.0;
+  // The maximum number of microbatches whose forward fragment executed but
+  // whose backward fragment didn't yet, on any mesh. Schedules that exceed it
+  // are discarded. Unbounded if zero.
+  int64_t max_in_flight_microbatches = 0;
+  // The maximum number of bytes of activations, i.e., results of forward
+  // fragments that are used by backward fragments, that are live at the same
+  // time on any mesh. Schedules that exceed it are discarded. Unbounded if
+  // zero.
+  int64_t max_activation_bytes = 0;
+  // The cache of the fragment costs, if any, so that the costs are computed
+  // once across simulations.
+  FragmentCostAnalysis* cost_analysis = nullptr;
+};
+
+// The simulated execution of a single fragment.
+struct SimulatedExecution {
+  double start_time = 0.0;
+  double finish_time = 0.0;
+  // The indices of the fragments on other meshes whose results are
+  // transferred to this fragment.
+  SmallVector<int> transfer_sources;
+};
+
+// The result of simulating a pipeline schedule.
+struct SimulatedSchedule {
+  // The time at which the last fragment finishes.
+  double makespan = 0.0;
+  // The maximum number of in-flight microbatches on any mesh, which
+  // approximates the peak activation memory of the schedule.
+  int64_t max_in_flight_microbatches = 0;
+  // The maximum number of bytes of live activations on any mesh.
+  int64_t max_live_activation_bytes = 0;
+  // The execution of each simulated fragment, in the order of the fragments.
+  std::vector<SimulatedExecution> executions;
+};
+
+// Simulates the execution of `fragments`, which must be in the same block, e.g.,
+// the scheduling units of a function, when the fragments of each mesh are
+// executed in the order of their ranks and each fragment starts once its mesh
+// is free and all its operands are available.
+//
+// Returns std::nullopt if any fragment cannot be ranked, or if the order of the
+// ranks contradicts the dataflow dependencies between fragments.
+std::optional<SimulatedSchedule> SimulatePipelineSchedule(
+    ArrayRef<FragmentOp> fragments, const FragmentRanker& ranker,
+    const AutoScheduleOptions& options);
+
+// A candidate schedule of the auto schedule search.
+struct ScheduleCandidate {
+  std::string name;
+  FragmentRanker ranker;
+};
+
+// Returns the number of bytes of the results of `fragment` that are used by
+// backward fragments, i.e., the activations that a forward fragment keeps
+// alive until the backward fragments that use them execute.
+int64_t GetActivationBytes(FragmentOp fragment);
+
+// Simulates the built-in schedules that totally order the fragments of each
+// mesh, and 1F1B schedules with more warmup forward fragments, and returns the
+// one with the lowest makespan within the in-flight microbatch and activation
+// memory bounds. Ties are broken in favor of the first candidate, starting with
+// 1F1B.
+//
+// With an activation memory bound, the candidates also include a 1F1B schedule
+// in which each mesh delays its forward fragments, i.e., schedules fewer
+// warmup forward fragments, so that the activations of its in-flight
+// microbatches fit in the bound.
+//
+// Returns std::nullopt if no candidate can be simulated within the bounds.
+std::optional<ScheduleCandidate> FindBestPipelineSchedule(
+    ArrayRef<FragmentOp> fragments, const AutoScheduleOptions& options);
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_AUTO_SCHEDULE_H_
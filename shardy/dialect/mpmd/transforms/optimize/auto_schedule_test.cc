@@ -0,0 +1,177 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/optimize/auto_schedule.h"
+
+#include <optional>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+#include "shardy/dialect/mpmd/transforms/optimize/utils.h"
+#include <gtest/gtest.h>
+
+using ::mlir::func::FuncOp;
+
+namespace mlir::mpmd {
+namespace {
+
+// Two microbatches of a two stage pipeline, where every fragment has a cost of
+// 1 and every forward fragment keeps 16 bytes of activations alive.
+constexpr char kTwoStagePipeline[] = R"mlir(
+  !m0_tensor = !mpmd.mesh_tensor<"m0", tensor<2x2xf32>>
+  !m1_tensor = !mpmd.mesh_tensor<"m1", tensor<2x2xf32>>
+  func.func @main(%arg0: !m0_tensor) -> (!m0_tensor, !m0_tensor)
+    attributes {"topology"=#mpmd.topology<<"m0": <["x"=1]>>, <"m1": <["x"=1]>>>} {
+    %f0_0 = mpmd.fragment<mesh="m0", origin=["f0"]> (%arg0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m0_tensor) -> !m0_tensor
+    %t0 = mpmd.transfer %f0_0 : (!m0_tensor) -> !m1_tensor
+    %f1_0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%t0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m1_tensor) -> !m1_tensor
+    %f0_1 = mpmd.fragment<mesh="m0", origin=["f0"]> (%arg0) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m0_tensor) -> !m0_tensor
+    %t1 = mpmd.transfer %f0_1 : (!m0_tensor) -> !m1_tensor
+    %f1_1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%t1) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m1_tensor) -> !m1_tensor
+    %b1_0 = mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%f1_0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m1_tensor) -> !m1_tensor
+    %u0 = mpmd.transfer %b1_0 : (!m1_tensor) -> !m0_tensor
+    %b0_0 = mpmd.fragment<mesh="m0", origin=["f0"(1)]> (%u0, %f0_0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>, %arg2: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m0_tensor, !m0_tensor) -> !m0_tensor
+    %b1_1 = mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%f1_1) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m1_tensor) -> !m1_tensor
+    %u1 = mpmd.transfer %b1_1 : (!m1_tensor) -> !m0_tensor
+    %b0_1 = mpmd.fragment<mesh="m0", origin=["f0"(1)]> (%u1, %f0_1) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>, %arg2: tensor<2x2xf32>) {
+      mpmd.return %arg1 : tensor<2x2xf32>
+    } : (!m0_tensor, !m0_tensor) -> !m0_tensor
+    return %b0_0, %b0_1 : !m0_tensor, !m0_tensor
+  }
+)mlir";
+
+SmallVector<FragmentOp> GetFragments(FuncOp func_op) {
+  return llvm::to_vector(func_op.getOps<FragmentOp>());
+}
+
+TEST(SimulatePipelineSchedule, SimulatesBuiltinSchedules) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kTwoStagePipeline, &context);
+  SmallVector<FragmentOp> fragments = GetFragments(GetMainFunction(*module));
+  AutoScheduleOptions options;
+  options.transfer_latency = 1.0;
+
+  // m0: F0 [0, 1], F1 [1, 2], B0 [6, 7], B1 [7, 8]
+  // m1: F0 [2, 3], F1 [3, 4], B0 [4, 5], B1 [5, 6]
+  std::optional<SimulatedSchedule> gpipe = SimulatePipelineSchedule(
+      fragments, *BuiltinFragmentRanker(PipelineSchedule::kGPipe), options);
+  ASSERT_TRUE(gpipe.has_value());
+  EXPECT_EQ(gpipe->makespan, 8.0);
+  EXPECT_EQ(gpipe->max_in_flight_microbatches, 2);
+  EXPECT_EQ(gpipe->max_live_activation_bytes, 32);
+
+  // m0: F0 [0, 1], F1 [1, 2], B0 [5, 6], B1 [7, 8]
+  // m1: F0 [2, 3], B0 [3, 4], F1 [4, 5], B1 [5, 6]
+  std::optional<SimulatedSchedule> one_f_one_b = SimulatePipelineSchedule(
+      fragments, *BuiltinFragmentRanker(PipelineSchedule::k1F1B), options);
+  ASSERT_TRUE(one_f_one_b.has_value());
+  EXPECT_EQ(one_f_one_b->makespan, 8.0);
+  EXPECT_EQ(one_f_one_b->max_in_flight_microbatches, 2);
+  EXPECT_EQ(one_f_one_b->max_live_activation_bytes, 32);
+}
+
+TEST(SimulatePipelineSchedule, ReturnsNulloptIfRanksContradictDataflow) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kTwoStagePipeline, &context);
+  SmallVector<FragmentOp> fragments = GetFragments(GetMainFunction(*module));
+
+  // Schedules all backward fragments before the forward fragments.
+  FragmentRanker backward_first =
+      [](FragmentOp fragment) -> std::optional<FragmentRank> {
+    return FragmentRank{-*TryToFindSingleTransposeCount(fragment)};
+  };
+  EXPECT_FALSE(
+      SimulatePipelineSchedule(fragments, backward_first, AutoScheduleOptions())
+          .has_value());
+}
+
+TEST(FindBestPipelineSchedule, PicksFirstScheduleWithLowestMakespan) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kTwoStagePipeline, &context);
+  SmallVector<FragmentOp> fragments = GetFragments(GetMainFunction(*module));
+
+  std::optional<ScheduleCandidate> best =
+      FindBestPipelineSchedule(fragments, AutoScheduleOptions());
+  ASSERT_TRUE(best.has_value());
+  EXPECT_EQ(best->name, "1F1B");
+
+  // Every schedule has two microbatches in flight on the first mesh.
+  AutoScheduleOptions options;
+  options.max_in_flight_microbatches = 1;
+  EXPECT_FALSE(FindBestPipelineSchedule(fragments, options).has_value());
+}
+
+TEST(FindBestPipelineSchedule, DelaysForwardFragmentsWithinActivationBound) {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kTwoStagePipeline, &context);
+  SmallVector<FragmentOp> fragments = GetFragments(GetMainFunction(*module));
+  for (FragmentOp fragment : fragments) {
+    EXPECT_EQ(GetActivationBytes(fragment),
+              IsForwardFragment(fragment) ? 16 : 0);
+  }
+
+  // Only a single microbatch fits in the bound, so the first mesh schedules a
+  // single warmup forward fragment instead of two.
+  AutoScheduleOptions options;
+  options.transfer_latency = 1.0;
+  options.max_activation_bytes = 16;
+  std::optional<ScheduleCandidate> best =
+      FindBestPipelineSchedule(fragments, options);
+  ASSERT_TRUE(best.has_value());
+  EXPECT_EQ(best->name, "MemoryBounded1F1B");
+
+  // m0: F0 [0, 1], B0 [5, 6], F1 [6, 7], B1 [11, 12]
+  // m1: F0 [2, 3], B0 [3, 4], F1 [8, 9], B1 [9, 10]
+  std::optional<SimulatedSchedule> simulated =
+      SimulatePipelineSchedule(fragments, best->ranker, options);
+  ASSERT_TRUE(simulated.has_value());
+  EXPECT_EQ(simulated->makespan, 12.0);
+  EXPECT_EQ(simulated->max_live_activation_bytes, 16);
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
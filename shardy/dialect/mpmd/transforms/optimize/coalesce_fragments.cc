@@ -0,0 +1,148 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/transforms/common/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/optimize/utils.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_COALESCEFRAGMENTSPASS
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h.inc"
+
+namespace {
+
+using ::mlir::func::FuncOp;
+
+// Returns true if an op between `first` and `second`, which must be in the
+// same block, depends on `first` or is a dependency of `second`. Merging the
+// two would then either delay that op until `second` is done, or delay the
+// work of `first` until that op is done.
+bool HasDependencyInBetween(FragmentOp first, FragmentOp second) {
+  Block* block = first->getBlock();
+  for (Value result : first->getResults()) {
+    for (Operation* user : result.getUsers()) {
+      Operation* ancestor = block->findAncestorOpInBlock(*user);
+      if (ancestor && ancestor != second && ancestor->isBeforeInBlock(second)) {
+        return true;
+      }
+    }
+  }
+  for (Value operand : second->getOperands()) {
+    Operation* producer = operand.getDefiningOp();
+    if (!producer) {
+      continue;
+    }
+    Operation* ancestor = block->findAncestorOpInBlock(*producer);
+    if (ancestor && ancestor != first && first->isBeforeInBlock(ancestor)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if a result of `first` is transferred to another mesh. Merging
+// `first` with the next fragment would delay the transfer until both are done.
+bool HasTransferredResult(FragmentOp first) {
+  return llvm::any_of(first->getUsers(),
+                      [](Operation* user) { return isa<TransferOp>(user); });
+}
+
+class CoalesceFragmentsPass
+    : public impl::CoalesceFragmentsPassBase<CoalesceFragmentsPass> {
+  using CoalesceFragmentsPassBase::CoalesceFragmentsPassBase;
+
+ private:
+  void runOnFunc(FuncOp func_op) override {
+    IRRewriter rewriter(func_op.getContext());
+    // The cost of each fragment, including the fragments created by merging,
+    // whose cost is the sum of the costs of the fragments they replace.
+    llvm::DenseMap<Operation*, double> costs;
+    auto get_cost = [&](FragmentOp fragment) {
+      auto [it, inserted] = costs.try_emplace(fragment, 0.0);
+      if (inserted) {
+        it->second = EstimateFragmentCost(fragment);
+      }
+      return it->second;
+    };
+
+    // The last fragment seen on each mesh, in program order.
+    llvm::DenseMap<StringRef, FragmentOp> last_fragment_on_mesh;
+    for (Operation& op : llvm::make_early_inc_range(func_op.getOps())) {
+      auto fragment = dyn_cast<FragmentOp>(&op);
+      if (!fragment) {
+        continue;
+      }
+      FragmentOp& previous = last_fragment_on_mesh[fragment.getMeshName()];
+      if (!previous || !CanCoalesce(previous, fragment, get_cost)) {
+        previous = fragment;
+        continue;
+      }
+      bool has_user_cost =
+          previous->hasAttr(kFragmentCostAttrName) ||
+          fragment->hasAttr(kFragmentCostAttrName);
+      double merged_cost = get_cost(previous) + get_cost(fragment);
+      costs.erase(previous);
+      costs.erase(fragment);
+      // The merged fragment takes the position of `fragment`, so the order of
+      // the fragments of every mesh is unchanged, apart from the two merged
+      // fragments becoming one.
+      FragmentOp merged = MergeFragments(previous, fragment, rewriter);
+      if (has_user_cost) {
+        merged->setAttr(kFragmentCostAttrName,
+                        rewriter.getF32FloatAttr(merged_cost));
+      }
+      costs[merged] = merged_cost;
+      previous = merged;
+    }
+  }
+
+  // Returns true if `fragment` can be merged with `previous`, the fragment
+  // executed immediately before it on the same mesh, i.e., such that
+  // `IsExecutedImmediatelyAfter(previous, fragment)`.
+  bool CanCoalesce(FragmentOp previous, FragmentOp fragment,
+                   llvm::function_ref<double(FragmentOp)> get_cost) const {
+    // Scheduling units are the fragments that the schedule orders, and that
+    // later passes, e.g., remat, match by their call counter and transpose
+    // count, so we never merge two of them.
+    if (IsSchedulingUnit(previous) && IsSchedulingUnit(fragment)) {
+      return false;
+    }
+    if (!AreStageIdsConsistent(previous, fragment)) {
+      return false;
+    }
+    if (get_cost(previous) + get_cost(fragment) > maxCost) {
+      return false;
+    }
+    return !HasTransferredResult(previous) &&
+           !HasDependencyInBetween(previous, fragment);
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
@@ -0,0 +1,202 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+
+#include <cstdint>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Types.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "stablehlo/dialect/StablehloOps.h"
+
+namespace mlir::mpmd {
+
+namespace {
+
+// Returns the type of `value` on each device of `mesh`, or its global type if
+// `mesh` is null or `value` isn't sharded. Returns null if `value` isn't a
+// statically shaped tensor.
+//
+// The sharding of a fragment block argument is the one of the operand type if
+// any, i.e., after the shardings were converted to mesh types, or of the
+// fragment's in_shardings otherwise.
+RankedTensorType GetLocalType(Value value, sdy::MeshAttr mesh) {
+  auto type = dyn_cast<RankedTensorType>(value.getType());
+  if (!type || !type.hasStaticShape()) {
+    return nullptr;
+  }
+  if (!mesh) {
+    return type;
+  }
+  if (auto arg = dyn_cast<BlockArgument>(value)) {
+    if (auto fragment = dyn_cast<FragmentOp>(arg.getOwner()->getParentOp())) {
+      auto mesh_type = dyn_cast<MeshTensorType>(
+          fragment->getOperand(arg.getArgNumber()).getType());
+      if (mesh_type && mesh_type.getSharding()) {
+        return mesh_type.getLocalTensorType(mesh);
+      }
+    }
+  }
+  if (sdy::TensorShardingAttr sharding = sdy::getSharding(value)) {
+    return sharding.getLocalTensorType(type, mesh);
+  }
+  return type;
+}
+
+int64_t GetNumElements(RankedTensorType type) {
+  return type ? type.getNumElements() : 0;
+}
+
+// Returns the bytes of `values` on each device, which must be mesh tensors
+// of `fragment`, or tokens, which are ignored.
+int64_t GetLocalBytes(ValueRange values, FragmentOp fragment) {
+  int64_t bytes = 0;
+  for (Value value : values) {
+    auto mesh_type = dyn_cast<MeshTensorType>(value.getType());
+    if (!mesh_type) {
+      continue;
+    }
+    bytes += GetLocalSizeInBytes(mesh_type, fragment);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+void FragmentCost::Print(llvm::raw_ostream& os) const {
+  os << "flops=" << llvm::format("%g", flops)
+     << (is_user_cost ? " (user)" : "") << ", bytes_read=" << bytes_read
+     << ", bytes_written=" << bytes_written;
+}
+
+double EstimateOpFlops(Operation* op, sdy::MeshAttr mesh) {
+  if (auto dot = dyn_cast<stablehlo::DotGeneralOp>(op)) {
+    RankedTensorType lhs_type = GetLocalType(dot.getLhs(), mesh);
+    if (lhs_type) {
+      int64_t contracting_size = 1;
+      for (int64_t dim :
+           dot.getDotDimensionNumbers().getLhsContractingDimensions()) {
+        contracting_size *= lhs_type.getDimSize(dim);
+      }
+      return 2.0 * GetNumElements(GetLocalType(dot.getResult(), mesh)) *
+             contracting_size;
+    }
+  }
+  if (auto conv = dyn_cast<stablehlo::ConvolutionOp>(op)) {
+    RankedTensorType kernel_type = GetLocalType(conv.getRhs(), mesh);
+    if (kernel_type) {
+      int64_t output_features = kernel_type.getDimSize(
+          conv.getDimensionNumbers().getKernelOutputFeatureDimension());
+      // Each output element is a dot over a window of the input features of
+      // its group.
+      return 2.0 * GetNumElements(GetLocalType(conv.getResult(), mesh)) *
+             (output_features == 0
+                  ? 0
+                  : kernel_type.getNumElements() / output_features);
+    }
+  }
+  if (auto reduce = dyn_cast<stablehlo::ReduceOp>(op)) {
+    double flops = 0.0;
+    for (Value input : reduce.getInputs()) {
+      flops += GetNumElements(GetLocalType(input, mesh));
+    }
+    return flops;
+  }
+  double flops = 0.0;
+  for (Value result : op->getResults()) {
+    flops += GetNumElements(GetLocalType(result, mesh));
+  }
+  return flops;
+}
+
+double EstimateOpCost(Operation* op) {
+  sdy::MeshAttr mesh;
+  if (auto fragment = op->getParentOfType<FragmentOp>()) {
+    FailureOr<sdy::MeshAttr> fragment_mesh = GetMeshAttr(fragment);
+    if (succeeded(fragment_mesh)) {
+      mesh = *fragment_mesh;
+    }
+  }
+  return EstimateOpFlops(op, mesh);
+}
+
+FragmentCost ComputeFragmentCost(FragmentOp fragment) {
+  FragmentCost cost;
+  cost.bytes_read = GetLocalBytes(fragment->getOperands(), fragment);
+  cost.bytes_written = GetLocalBytes(fragment->getResults(), fragment);
+  if (auto user_cost =
+          fragment->getAttrOfType<FloatAttr>(kFragmentCostAttrName)) {
+    cost.flops = user_cost.getValueAsDouble();
+    cost.is_user_cost = true;
+    return cost;
+  }
+  if (auto user_cost =
+          fragment->getAttrOfType<IntegerAttr>(kFragmentCostAttrName)) {
+    cost.flops = user_cost.getInt();
+    cost.is_user_cost = true;
+    return cost;
+  }
+  FailureOr<sdy::MeshAttr> fragment_mesh = GetMeshAttr(fragment);
+  sdy::MeshAttr mesh = succeeded(fragment_mesh) ? *fragment_mesh : nullptr;
+  fragment.getRegion().walk([&](Operation* op) {
+    if (!isa<ReturnOp>(op)) {
+      cost.flops += EstimateOpFlops(op, mesh);
+    }
+  });
+  return cost;
+}
+
+double EstimateFragmentCost(FragmentOp fragment) {
+  return ComputeFragmentCost(fragment).flops;
+}
+
+const FragmentCost& FragmentCostAnalysis::GetCost(FragmentOp fragment) {
+  auto [it, inserted] = costs_.try_emplace(fragment);
+  if (inserted) {
+    it->second = ComputeFragmentCost(fragment);
+  }
+  return it->second;
+}
+
+void FragmentCostAnalysis::Print(llvm::raw_ostream& os) {
+  op_->walk([&](FragmentOp fragment) {
+    // Origins are printed as in the fragment, e.g., `["f", "g"(1)]`.
+    os << "fragment [";
+    llvm::interleaveComma(fragment.getOrigin().getAsRange<UserOriginAttr>(),
+                          os, [&](UserOriginAttr origin) {
+                            os << "\"" << origin.getUserName().getValue()
+                               << "\"";
+                            if (origin.getTransposeCount() != 0) {
+                              os << "(" << origin.getTransposeCount() << ")";
+                            }
+                          });
+    os << "] on mesh \"" << fragment.getMeshName() << "\": ";
+    GetCost(fragment).Print(os);
+    os << "\n";
+  });
+}
+
+}  // namespace mlir::mpmd
@@ -0,0 +1,95 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_FRAGMENT_COST_H_
+#define SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_FRAGMENT_COST_H_
+
+#include <cstdint>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+
+namespace mlir::mpmd {
+
+// A user-supplied cost of a fragment, in the same unit as the transfer latency
+// of `AutoScheduleOptions`. Overrides the FLOPs estimated by
+// `ComputeFragmentCost`.
+inline constexpr StringRef kFragmentCostAttrName = "mpmd.fragment_cost";
+
+// The cost of executing a fragment on each device of its mesh.
+struct FragmentCost {
+  // The number of floating point operations, or the `kFragmentCostAttrName`
+  // attribute of the fragment if present.
+  double flops = 0.0;
+  // The bytes of the local operands and results of the fragment, i.e., read
+  // from and written to device memory.
+  int64_t bytes_read = 0;
+  int64_t bytes_written = 0;
+  // Whether `flops` is the user-supplied cost.
+  bool is_user_cost = false;
+
+  void Print(llvm::raw_ostream& os) const;
+};
+
+// Returns an estimate of the number of floating point operations of `op` on
+// each device of `mesh`, i.e., on the local shapes of its operands and
+// results, or on their global shapes if `mesh` is null:
+// - `2*M*N*K` for a dot_general.
+// - `2 * output elements * kernel elements per output feature` for a
+//   convolution.
+// - The number of operand elements for a reduce.
+// - The number of result elements for any other op, e.g., an elementwise op.
+double EstimateOpFlops(Operation* op, sdy::MeshAttr mesh);
+
+// Same as `EstimateOpFlops` with the mesh of the fragment enclosing `op`, if
+// any.
+double EstimateOpCost(Operation* op);
+
+// Returns the cost of executing `fragment`. See `FragmentCost`.
+FragmentCost ComputeFragmentCost(FragmentOp fragment);
+
+// Returns the FLOPs of `ComputeFragmentCost`.
+double EstimateFragmentCost(FragmentOp fragment);
+
+// An analysis that caches the cost of the fragments of a function, so that all
+// passes that need fragment costs use the same estimate, and each fragment is
+// only walked once.
+class FragmentCostAnalysis {
+ public:
+  explicit FragmentCostAnalysis(Operation* op) : op_(op) {}
+
+  // Returns the cost of `fragment`, computing it if it isn't cached yet.
+  const FragmentCost& GetCost(FragmentOp fragment);
+
+  // Drops the cost of `fragment`, e.g., after its body changed or before it
+  // is erased.
+  void Invalidate(FragmentOp fragment) { costs_.erase(fragment); }
+
+  // Prints the cost of each fragment of the function, in program order.
+  void Print(llvm::raw_ostream& os);
+
+ private:
+  Operation* op_;
+  llvm::DenseMap<Operation*, FragmentCost> costs_;
+};
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_FRAGMENT_COST_H_
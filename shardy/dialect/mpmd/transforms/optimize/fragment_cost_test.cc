@@ -0,0 +1,197 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+
+#include <string>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include <gtest/gtest.h>
+
+using ::mlir::func::FuncOp;
+
+namespace mlir::mpmd {
+namespace {
+
+SmallVector<FragmentOp> GetFragments(FuncOp func_op) {
+  return llvm::to_vector(func_op.getOps<FragmentOp>());
+}
+
+TEST(ComputeFragmentCost, CountsDotFlopsAndResultElements) {
+  const char kProgram[] = R"mlir(
+    !mesh_1_tensor_2_3_f32 = !mpmd.mesh_tensor<"m1", tensor<2x3xf32>>
+    !mesh_1_tensor_3_4_f32 = !mpmd.mesh_tensor<"m1", tensor<3x4xf32>>
+    !mesh_1_tensor_2_4_f32 = !mpmd.mesh_tensor<"m1", tensor<2x4xf32>>
+    func.func @main(%arg0: !mesh_1_tensor_2_3_f32, %arg1: !mesh_1_tensor_3_4_f32)
+      -> (!mesh_1_tensor_2_4_f32) attributes {"topology"=#mpmd.topology<<"m1": <["x"=1]>>>} {
+      %0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0, %arg1) (%arg2: tensor<2x3xf32>, %arg3: tensor<3x4xf32>) {
+        %1 = stablehlo.dot_general %arg2, %arg3, contracting_dims = [1] x [0] : (tensor<2x3xf32>, tensor<3x4xf32>) -> tensor<2x4xf32>
+        %2 = stablehlo.add %1, %1 : tensor<2x4xf32>
+        mpmd.return %2 : tensor<2x4xf32>
+      } : (!mesh_1_tensor_2_3_f32, !mesh_1_tensor_3_4_f32) -> !mesh_1_tensor_2_4_f32
+      return %0 : !mesh_1_tensor_2_4_f32
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  SmallVector<FragmentOp> fragments = GetFragments(GetMainFunction(*module));
+  ASSERT_EQ(fragments.size(), 1);
+
+  // 2 * 2 * 4 * 3 for the dot, and 2 * 4 for the add.
+  FragmentCost cost = ComputeFragmentCost(fragments[0]);
+  EXPECT_EQ(cost.flops, 56.0);
+  EXPECT_FALSE(cost.is_user_cost);
+  // 2 * 3 and 3 * 4 f32 operands, and a 2 * 4 f32 result.
+  EXPECT_EQ(cost.bytes_read, 72);
+  EXPECT_EQ(cost.bytes_written, 32);
+  EXPECT_EQ(EstimateFragmentCost(fragments[0]), 56.0);
+
+  fragments[0]->setAttr(kFragmentCostAttrName,
+                        FloatAttr::get(Float64Type::get(&context), 2.5));
+  cost = ComputeFragmentCost(fragments[0]);
+  EXPECT_EQ(cost.flops, 2.5);
+  EXPECT_TRUE(cost.is_user_cost);
+  EXPECT_EQ(cost.bytes_read, 72);
+  EXPECT_EQ(EstimateFragmentCost(fragments[0]), 2.5);
+}
+
+TEST(ComputeFragmentCost, UsesLocalShapes) {
+  const char kProgram[] = R"mlir(
+    !lhs = !mpmd.mesh_tensor<"m1", tensor<4x6xf32>, sharding=<@m1, [{}, {"x"}]>>
+    !rhs = !mpmd.mesh_tensor<"m1", tensor<6x8xf32>, sharding=<@m1, [{"x"}, {}]>>
+    !res = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+    func.func @main(%arg0: !lhs, %arg1: !rhs) -> !res
+      attributes {"topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+      %0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0, %arg1) (%arg2: tensor<4x6xf32>, %arg3: tensor<6x8xf32>) {
+        %1 = stablehlo.dot_general %arg2, %arg3, contracting_dims = [1] x [0] : (tensor<4x6xf32>, tensor<6x8xf32>) -> tensor<4x8xf32>
+        mpmd.return %1 : tensor<4x8xf32>
+      } : (!lhs, !rhs) -> !res
+      return %0 : !res
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  SmallVector<FragmentOp> fragments = GetFragments(GetMainFunction(*module));
+  ASSERT_EQ(fragments.size(), 1);
+
+  // Each device contracts half of the 6 elements: 2 * 4 * 8 * 3.
+  FragmentCost cost = ComputeFragmentCost(fragments[0]);
+  EXPECT_EQ(cost.flops, 192.0);
+  // 4 * 3 and 3 * 8 f32 operands, and a replicated 4 * 8 f32 result.
+  EXPECT_EQ(cost.bytes_read, 144);
+  EXPECT_EQ(cost.bytes_written, 128);
+}
+
+TEST(ComputeFragmentCost, CountsConvolutionAndReduceFlops) {
+  const char kProgram[] = R"mlir(
+    !input = !mpmd.mesh_tensor<"m1", tensor<1x8x8x3xf32>>
+    !kernel = !mpmd.mesh_tensor<"m1", tensor<3x3x3x16xf32>>
+    !res = !mpmd.mesh_tensor<"m1", tensor<1x6x6xf32>>
+    func.func @main(%arg0: !input, %arg1: !kernel) -> !res
+      attributes {"topology"=#mpmd.topology<<"m1": <["x"=1]>>>} {
+      %0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0, %arg1) (%arg2: tensor<1x8x8x3xf32>, %arg3: tensor<3x3x3x16xf32>) {
+        %1 = stablehlo.convolution(%arg2, %arg3)
+          dim_numbers = [b, 0, 1, f]x[0, 1, i, o]->[b, 0, 1, f],
+          window = {stride = [1, 1]}
+          {batch_group_count = 1 : i64, feature_group_count = 1 : i64}
+          : (tensor<1x8x8x3xf32>, tensor<3x3x3x16xf32>) -> tensor<1x6x6x16xf32>
+        %2 = stablehlo.constant dense<0.0> : tensor<f32>
+        %3 = stablehlo.reduce(%1 init: %2) applies stablehlo.add across dimensions = [3]
+          : (tensor<1x6x6x16xf32>, tensor<f32>) -> tensor<1x6x6xf32>
+        mpmd.return %3 : tensor<1x6x6xf32>
+      } : (!input, !kernel) -> !res
+      return %0 : !res
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  SmallVector<FragmentOp> fragments = GetFragments(GetMainFunction(*module));
+  ASSERT_EQ(fragments.size(), 1);
+
+  // The convolution has 576 outputs, each a dot of 3 * 3 * 3 elements. The
+  // reduce adds its 576 inputs, and the constant and the scalar add in the
+  // reducer produce one element each.
+  EXPECT_EQ(ComputeFragmentCost(fragments[0]).flops,
+            2.0 * 576 * 27 + 576 + 1 + 1);
+}
+
+TEST(FragmentCostAnalysis, CachesAndPrintsCosts) {
+  const char kProgram[] = R"mlir(
+    !mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<2x2xf32>>
+    func.func @main(%arg0: !mesh_1_tensor) -> !mesh_1_tensor
+      attributes {"topology"=#mpmd.topology<<"m1": <["x"=1]>>>} {
+      %0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) (%arg1: tensor<2x2xf32>) {
+        %1 = stablehlo.add %arg1, %arg1 : tensor<2x2xf32>
+        mpmd.return %1 : tensor<2x2xf32>
+      } : (!mesh_1_tensor) -> !mesh_1_tensor
+      %1 = mpmd.fragment<mesh="m1", origin=["g"]> (%0) {mpmd.fragment_cost = 7 : i64} (%arg1: tensor<2x2xf32>) {
+        mpmd.return %arg1 : tensor<2x2xf32>
+      } : (!mesh_1_tensor) -> !mesh_1_tensor
+      return %1 : !mesh_1_tensor
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  FuncOp main_func = GetMainFunction(*module);
+  SmallVector<FragmentOp> fragments = GetFragments(main_func);
+  ASSERT_EQ(fragments.size(), 2);
+
+  FragmentCostAnalysis analysis(main_func);
+  EXPECT_EQ(analysis.GetCost(fragments[0]).flops, 4.0);
+  EXPECT_EQ(analysis.GetCost(fragments[1]).flops, 7.0);
+
+  // The cost is cached until it's invalidated.
+  fragments[0]->setAttr(kFragmentCostAttrName,
+                        FloatAttr::get(Float64Type::get(&context), 1.0));
+  EXPECT_EQ(analysis.GetCost(fragments[0]).flops, 4.0);
+  analysis.Invalidate(fragments[0]);
+  EXPECT_EQ(analysis.GetCost(fragments[0]).flops, 1.0);
+
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  analysis.Print(os);
+  EXPECT_EQ(str,
+            "fragment [\"f\"] on mesh \"m1\": flops=1 (user), bytes_read=16, "
+            "bytes_written=16\n"
+            "fragment [\"g\"] on mesh \"m1\": flops=7 (user), bytes_read=16, "
+            "bytes_written=16\n");
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
@@ -46,7 +46,8 @@ void addOptimizePipeline(OpPassManager& pm, OptimizeOptions options) {
   // about scheduling the remat fragments.
   if (options.applyFragmentRemat) {
     pm.addNestedPass<FuncOp>(createRematFragmentPass(
-        RematFragmentPassOptions{options.mergeRematFragments}));
+        RematFragmentPassOptions{options.mergeRematFragments,
+                                 options.rematMemoryTargetBytes}));
   }
 
   // Verify fragments assigned to the same stage were merged, i.e., it's not
@@ -63,6 +64,13 @@ void addOptimizePipeline(OpPassManager& pm, OptimizeOptions options) {
   if (options.mergeForwardWithBackward) {
     pm.addNestedPass<FuncOp>(createMergeForwardWithBackwardPass());
   }
+
+  // Coalesce the small fragments that are left after all other merges, to
+  // reduce the number of fragments each mesh dispatches.
+  if (options.coalesceFragmentsMaxCost > 0) {
+    pm.addNestedPass<FuncOp>(createCoalesceFragmentsPass(
+        CoalesceFragmentsPassOptions{options.coalesceFragmentsMaxCost}));
+  }
 }
 
 namespace {
@@ -83,7 +91,16 @@ struct OptimizePipelineOptions
           clEnumValN(PipelineSchedule::kNone, "none", "No schedule"),
           clEnumValN(PipelineSchedule::k1F1B, "1F1B", "1F1B schedule"),
           clEnumValN(PipelineSchedule::kCircular, "Circular",
-                     "Circular schedule"))};
+                     "Circular schedule"),
+          clEnumValN(PipelineSchedule::kAuto, "Auto",
+                     "Schedule with the lowest simulated makespan"))};
+
+  Option<double> coalesceFragmentsMaxCost{
+      *this, "coalesce-fragments-max-cost",
+      llvm::cl::desc("The maximum cost of a fragment merged from small "
+                     "fragments that execute back to back on a mesh. If zero, "
+                     "no such fragments are merged."),
+      llvm::cl::init(0.0)};
 };
 
 }  // namespace
@@ -96,6 +113,8 @@ void registerOptimizePipeline() {
         OptimizeOptions options;
         options.mergeAfterScheduling = pipelineOptions.mergeAfterScheduling;
         options.pipelineSchedule = pipelineOptions.pipelineSchedule;
+        options.coalesceFragmentsMaxCost =
+            pipelineOptions.coalesceFragmentsMaxCost;
         addOptimizePipeline(pm, options);
       });
 }
@@ -18,6 +18,7 @@ limitations under the License.
 
 // IWYU pragma: begin_keep
 
+#include <cstdint>
 #include <memory>
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -51,11 +52,17 @@ struct OptimizeOptions {
   bool applyFragmentRemat = false;
   // Whether remat fragments can be merged with their consumer fragments.
   bool mergeRematFragments = false;
+  // The maximum bytes of live activations on each mesh that fragment remat
+  // aims for. If zero, all fragments that can be rematerialized are.
+  int64_t rematMemoryTargetBytes = 0;
   // Whether to merge forward fragments with backward fragments.
   bool mergeForwardWithBackward = false;
   // Whether to absorb inferred fragments into user-defined fragments on
   // entry-point functions.
   bool absorbInferredFragmentsOnEntryPointFunction = false;
+  // The maximum cost of a fragment merged from small fragments that execute
+  // back to back on a mesh. If zero, no such fragments are merged.
+  double coalesceFragmentsMaxCost = 0.0;
   // The pipeline schedule to use.
   PipelineSchedule pipelineSchedule = PipelineSchedule::kGPipe;
 };
@@ -73,6 +73,12 @@ std::optional<PipelineSchedule> ParsePipelineSchedule(StringRef schedule_str) {
   if (schedule_str.equals_insensitive("ParallelPipelinesWithWrapAround")) {
     return PipelineSchedule::kParallelPipelinesWithWrapAround;
   }
+  if (schedule_str.equals_insensitive("CircularWithSplitBackward")) {
+    return PipelineSchedule::kCircularWithSplitBackward;
+  }
+  if (schedule_str.equals_insensitive("Auto")) {
+    return PipelineSchedule::kAuto;
+  }
 
   return std::nullopt;
 }
@@ -101,6 +107,10 @@ std::string ToString(PipelineSchedule schedule) {
       return "ZeroBubbleH2FullTxLatency";
     case PipelineSchedule::kParallelPipelinesWithWrapAround:
       return "ParallelPipelinesWithWrapAround";
+    case PipelineSchedule::kCircularWithSplitBackward:
+      return "CircularWithSplitBackward";
+    case PipelineSchedule::kAuto:
+      return "Auto";
   }
 }
 
@@ -546,8 +556,193 @@ bool CircularMustHappenBefore(FragmentOp fragment1, FragmentOp fragment2) {
                                       /*reversed_backward=*/false);
 }
 
+// Returns the rank of `fragment` in a 1F1B schedule, i.e., its position in the
+// 1F1B order of its mesh, see `OneFOneBMustHappenBefore`.
+//
+// On mesh i of a pipeline of depth n, the first k forward fragments are
+// scheduled first, where k is `num_init_fwd` (at least one) or n - i if not
+// specified, and then backward and forward fragments are interleaved:
+//   F(0) ... F(k-1) B(0) F(k) B(1) F(k+1) ...
+std::optional<FragmentRank> OneFOneBRank(
+    FragmentOp fragment, std::optional<int64_t> num_init_fwd = std::nullopt) {
+  if (!IsSchedulingUnit(fragment)) {
+    return std::nullopt;
+  }
+  int64_t call_counter = *TryToFindCallCounter(fragment);
+  int64_t transpose_count = *TryToFindSingleTransposeCount(fragment);
+  const int64_t k = std::max<int64_t>(
+      num_init_fwd.value_or(GetNumMeshes(fragment) - GetMeshIndex(fragment)),
+      1);
+  if (transpose_count == 1) {
+    return FragmentRank{k + 2 * call_counter};
+  }
+  if (call_counter < k) {
+    return FragmentRank{call_counter};
+  }
+  return FragmentRank{2 * call_counter - k + 1};
+}
+
+// Returns the rank of `fragment` in a GPipe schedule, see
+// `GPipeMustHappenBefore`.
+std::optional<FragmentRank> GPipeRank(FragmentOp fragment) {
+  if (!IsSchedulingUnit(fragment)) {
+    return std::nullopt;
+  }
+  return FragmentRank{*TryToFindSingleTransposeCount(fragment),
+                      *TryToFindCallCounter(fragment)};
+}
+
+std::optional<FragmentRank> GPipeBut1F1BLastMeshRank(FragmentOp fragment) {
+  if (GetMeshIndex(fragment) == GetNumMeshes(fragment) - 1) {
+    return OneFOneBRank(fragment);
+  }
+  return GPipeRank(fragment);
+}
+
+// Returns the rank of `fragment` in a parallel pipeline with wrap-around, see
+// `ParallelPipelinesWithWrapAroundMustHappenBefore`: the entrypoint of the
+// mesh comes first, then the call counters below it in descending order, and
+// then the call counters above it in descending order.
+std::optional<FragmentRank> ParallelPipelinesWithWrapAroundRank(
+    FragmentOp fragment) {
+  if (!IsSchedulingUnit(fragment) || !IsForwardFragment(fragment)) {
+    return std::nullopt;
+  }
+  int64_t mesh_num = 0;
+  if (!llvm::to_integer(fragment.getMeshName().drop_until(
+                            [](char c) { return llvm::isDigit(c); }),
+                        mesh_num)) {
+    return std::nullopt;
+  }
+  int64_t call_counter = *TryToFindCallCounter(fragment);
+  return FragmentRank{call_counter != mesh_num, call_counter > mesh_num,
+                      -call_counter};
+}
+
+// Returns the rank of `fragment` in a circular schedule, see
+// `CircularMustHappenBeforeBase`.
+std::optional<FragmentRank> CircularRankBase(FragmentOp fragment,
+                                             bool reversed_backward) {
+  if (!IsSchedulingUnit(fragment) || !fragment.getStageIdAttr()) {
+    return std::nullopt;
+  }
+  const int64_t call_counter = *TryToFindCallCounter(fragment);
+  const int64_t transpose_count = *TryToFindSingleTransposeCount(fragment);
+  const int64_t stage = fragment.getStageIdAttr().getInt();
+  const int64_t phase = call_counter / GetNumMeshes(fragment);
+
+  if (transpose_count == 0) {
+    return FragmentRank{transpose_count, phase, stage, call_counter};
+  }
+  if (reversed_backward) {
+    return FragmentRank{transpose_count, -phase, -stage, -call_counter};
+  }
+  return FragmentRank{transpose_count, phase, -stage, call_counter};
+}
+
+// Returns the rank of `fragment` in a circular schedule whose backward
+// fragments are split (see `SplitBwdFragmentsPass`) into a fragment that
+// computes the transferred results, i.e., the activation gradients (Bᵃ), and
+// one that computes the remaining results, i.e., the parameter gradients (Bʷ).
+//
+// Forward and Bᵃ fragments are ordered as in the circular schedule. As in the
+// ZeroBubble H1 schedule, the Bʷ fragments don't block the transfers to the
+// previous mesh, so they are delayed to fill the bubbles while mesh i waits for
+// the activation gradients of the next microbatches: Bʷ(j) is scheduled after
+// Bᵃ(j + i) of the same logical stage and phase, or after the last Bᵃ of the
+// logical stage and phase if there is no such fragment. E.g., for a logical
+// stage on mesh 1:
+//   Bᵃ0 Bᵃ1 Bʷ0 Bᵃ2 Bʷ1 Bᵃ3 Bʷ2 Bʷ3
+//
+// Backward fragments that aren't split are ordered as Bᵃ fragments.
+std::optional<FragmentRank> CircularWithSplitBackwardRank(
+    FragmentOp fragment) {
+  std::optional<FragmentRank> rank =
+      CircularRankBase(fragment, /*reversed_backward=*/false);
+  if (!rank) {
+    return std::nullopt;
+  }
+  const bool is_wgrad = IsSplitDropTransferred(fragment);
+  if (is_wgrad) {
+    (*rank)[3] += GetMeshIndex(fragment);
+  }
+  rank->push_back(is_wgrad);
+  return rank;
+}
+
+// Returns true if `fragment1` must happen before `fragment2` in a circular
+// schedule with split backward fragments, see `CircularWithSplitBackwardRank`.
+bool CircularWithSplitBackwardMustHappenBefore(FragmentOp fragment1,
+                                               FragmentOp fragment2) {
+  std::optional<FragmentRank> rank_f1 =
+      CircularWithSplitBackwardRank(fragment1);
+  std::optional<FragmentRank> rank_f2 =
+      CircularWithSplitBackwardRank(fragment2);
+  if (!rank_f1 || !rank_f2) {
+    // Giving up. We cannot schedule for circular pipelining without stages.
+    SDY_LOG(ERROR) << "Cannot schedule for circular pipelining without stages.";
+    return false;
+  }
+  return *rank_f1 < *rank_f2;
+}
+
 }  // namespace
 
+std::optional<FragmentRanker> BuiltinFragmentRanker(
+    PipelineSchedule schedule) {
+  switch (schedule) {
+    case PipelineSchedule::k1F1B:
+      return [](FragmentOp fragment) { return OneFOneBRank(fragment); };
+    case PipelineSchedule::kGPipe:
+      return GPipeRank;
+    case PipelineSchedule::kGPipeBut1F1BForLastMesh:
+      return GPipeBut1F1BLastMeshRank;
+    case PipelineSchedule::kParallelPipelinesWithWrapAround:
+      return ParallelPipelinesWithWrapAroundRank;
+    case PipelineSchedule::kCircular:
+      return [](FragmentOp fragment) {
+        return CircularRankBase(fragment, /*reversed_backward=*/false);
+      };
+    case PipelineSchedule::kCircularWithReversedBackward:
+      return [](FragmentOp fragment) {
+        return CircularRankBase(fragment, /*reversed_backward=*/true);
+      };
+    case PipelineSchedule::kCircularWithSplitBackward:
+      return CircularWithSplitBackwardRank;
+    // The zero bubble comparators only order some pairs of fragments, and
+    // leave the remaining order to the dataflow dependencies.
+    case PipelineSchedule::kNone:
+    case PipelineSchedule::kZeroBubbleH1:
+    case PipelineSchedule::kZeroBubbleH2ZeroTxLatency:
+    case PipelineSchedule::kZeroBubbleH2HalfTxLatency:
+    case PipelineSchedule::kZeroBubbleH2FullTxLatency:
+    // The schedule is only known once the fragments of a function are
+    // simulated, see `FindBestPipelineSchedule`.
+    case PipelineSchedule::kAuto:
+      return std::nullopt;
+  }
+}
+
+FragmentRanker OneFOneBRankerWithWarmup(
+    std::function<int64_t(int, int)> num_warmup_forwards) {
+  return [num_warmup_forwards = std::move(num_warmup_forwards)](
+             FragmentOp fragment) -> std::optional<FragmentRank> {
+    if (!IsSchedulingUnit(fragment)) {
+      return std::nullopt;
+    }
+    return OneFOneBRank(fragment,
+                        num_warmup_forwards(GetMeshIndex(fragment),
+                                            GetNumMeshes(fragment)));
+  };
+}
+
+FragmentRanker OneFOneBRankerWithExtraWarmup(int64_t extra_warmup_forwards) {
+  return OneFOneBRankerWithWarmup(
+      [extra_warmup_forwards](int mesh_index, int num_meshes) {
+        return num_meshes - mesh_index + extra_warmup_forwards;
+      });
+}
+
 FragmentComparator BuiltinFragmentComparator(PipelineSchedule schedule) {
   switch (schedule) {
     case PipelineSchedule::kNone: {
@@ -589,6 +784,14 @@ FragmentComparator BuiltinFragmentComparator(PipelineSchedule schedule) {
     case PipelineSchedule::kCircular: {
       return CircularMustHappenBefore;
     }
+    case PipelineSchedule::kCircularWithSplitBackward: {
+      return CircularWithSplitBackwardMustHappenBefore;
+    }
+    // The scheduler picks a ranked schedule for each function, and only falls
+    // back to 1F1B if none of the candidates can be simulated.
+    case PipelineSchedule::kAuto: {
+      return OneFOneBMustHappenBefore;
+    }
   }
 }
 
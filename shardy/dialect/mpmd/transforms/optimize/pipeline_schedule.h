@@ -17,10 +17,12 @@ limitations under the License.
 #define SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_PIPELINE_SCHEDULE_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <string>
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
@@ -41,6 +43,10 @@ enum class PipelineSchedule {
   kZeroBubbleH2HalfTxLatency,
   kZeroBubbleH2FullTxLatency,
   kParallelPipelinesWithWrapAround,
+  kCircularWithSplitBackward,
+  // Picks the schedule with the lowest simulated makespan for each function,
+  // see `FindBestPipelineSchedule`.
+  kAuto,
 };
 
 // Parses the given string as a `PipelineSchedule` or return std::nullopt if
@@ -56,6 +62,37 @@ using FragmentComparator =
 // Returns a fragment comparator for the given pipeline schedule.
 FragmentComparator BuiltinFragmentComparator(PipelineSchedule schedule);
 
+// A key that totally orders the fragments of a mesh in a pipeline schedule:
+// fragments are scheduled in lexicographically ascending order of their ranks.
+using FragmentRank = SmallVector<int64_t>;
+
+// Returns the rank of a fragment, or std::nullopt if it cannot be ranked, e.g.,
+// because it is missing an attribute the schedule depends on.
+using FragmentRanker = std::function<std::optional<FragmentRank>(FragmentOp)>;
+
+// Returns a fragment ranker for the given pipeline schedule, if the schedule
+// totally orders the fragments of each mesh, or std::nullopt otherwise.
+//
+// The order defined by the ranker is the same as the one induced by
+// `BuiltinFragmentComparator(schedule)`, but the rank of each fragment is only
+// computed once, so that a scheduler can sort the fragments of each mesh
+// instead of comparing every pair of fragments.
+std::optional<FragmentRanker> BuiltinFragmentRanker(PipelineSchedule schedule);
+
+// Returns a fragment ranker for a 1F1B schedule in which mesh i of a pipeline
+// of n meshes schedules `num_warmup_forwards(i, n)` forward fragments, and at
+// least one, before its first backward fragment, instead of n - i.
+//
+// Fewer warmup forward fragments delay forward fragments, so that fewer
+// microbatches keep their activations alive at the same time.
+FragmentRanker OneFOneBRankerWithWarmup(
+    std::function<int64_t(int, int)> num_warmup_forwards);
+
+// Returns a fragment ranker for a 1F1B schedule in which each mesh schedules
+// `extra_warmup_forwards` more forward fragments before its first backward
+// fragment. The ranker with no extra warmup forwards is the 1F1B ranker.
+FragmentRanker OneFOneBRankerWithExtraWarmup(int64_t extra_warmup_forwards);
+
 // A `FragmentComparator` option with a custom parser/printer.
 struct FragmentComparatorOption {
   FragmentComparator value;
@@ -0,0 +1,190 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/logging.h"
+#include "shardy/common/save_module_op.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/auto_schedule.h"
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_PIPELINETIMELINEPASS
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h.inc"
+
+namespace {
+
+using ::mlir::func::FuncOp;
+
+// Returns the name of `fragment` in the trace, i.e., its origins, e.g.,
+// `f1(1)`, or `inferred` if it has none.
+std::string GetTraceName(FragmentOp fragment) {
+  if (fragment.getOrigin().empty()) {
+    return "inferred";
+  }
+  std::string name;
+  llvm::raw_string_ostream os(name);
+  llvm::interleave(
+      fragment.getOrigin().getAsRange<UserOriginAttr>(), os,
+      [&](UserOriginAttr origin) {
+        os << origin.getUserName().getValue();
+        if (origin.getTransposeCount() > 0) {
+          os << "(" << origin.getTransposeCount() << ")";
+        }
+      },
+      ",");
+  return name;
+}
+
+void WriteTimeline(raw_ostream& os, ArrayRef<FragmentOp> fragments,
+                   const SimulatedSchedule& schedule) {
+  // One track per mesh, in the order the meshes first appear.
+  llvm::MapVector<StringRef, int64_t> mesh_to_track;
+  for (FragmentOp fragment : fragments) {
+    mesh_to_track.try_emplace(fragment.getMeshName(), mesh_to_track.size());
+  }
+  double busy_time = 0.0;
+  for (const SimulatedExecution& execution : schedule.executions) {
+    busy_time += execution.finish_time - execution.start_time;
+  }
+  double bubble_ratio =
+      schedule.makespan > 0.0
+          ? 1.0 - busy_time / (schedule.makespan * mesh_to_track.size())
+          : 0.0;
+
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&]() {
+    json.attributeArray("traceEvents", [&]() {
+      for (auto [mesh_name, track] : mesh_to_track) {
+        json.object([&, mesh_name = mesh_name, track = track]() {
+          json.attribute("name", "thread_name");
+          json.attribute("ph", "M");
+          json.attribute("pid", 0);
+          json.attribute("tid", track);
+          json.attributeObject("args",
+                               [&]() { json.attribute("name", mesh_name); });
+        });
+      }
+      int64_t flow_id = 0;
+      for (auto [fragment, execution] :
+           llvm::zip_equal(fragments, schedule.executions)) {
+        int64_t track = mesh_to_track[fragment.getMeshName()];
+        json.object([&, fragment = fragment, &execution = execution]() {
+          json.attribute("name", GetTraceName(fragment));
+          json.attribute("cat", "fragment");
+          json.attribute("ph", "X");
+          json.attribute("pid", 0);
+          json.attribute("tid", track);
+          json.attribute("ts", execution.start_time);
+          json.attribute("dur", execution.finish_time - execution.start_time);
+          if (std::optional<uint32_t> call_counter =
+                  TryToFindCallCounter(fragment)) {
+            json.attributeObject("args", [&]() {
+              json.attribute("call_counter", *call_counter);
+            });
+          }
+        });
+        for (int source : execution.transfer_sources) {
+          json.object([&]() {
+            json.attribute("name", "transfer");
+            json.attribute("cat", "transfer");
+            json.attribute("ph", "s");
+            json.attribute("id", flow_id);
+            json.attribute("pid", 0);
+            json.attribute("tid",
+                           mesh_to_track[fragments[source].getMeshName()]);
+            json.attribute("ts", schedule.executions[source].finish_time);
+          });
+          json.object([&, &execution = execution]() {
+            json.attribute("name", "transfer");
+            json.attribute("cat", "transfer");
+            json.attribute("ph", "f");
+            json.attribute("bp", "e");
+            json.attribute("id", flow_id);
+            json.attribute("pid", 0);
+            json.attribute("tid", track);
+            json.attribute("ts", execution.start_time);
+          });
+          ++flow_id;
+        }
+      }
+    });
+    json.attributeObject("otherData", [&]() {
+      json.attribute("makespan", schedule.makespan);
+      json.attribute("bubble_ratio", bubble_ratio);
+    });
+  });
+  os << "\n";
+}
+
+class PipelineTimelinePass
+    : public impl::PipelineTimelinePassBase<PipelineTimelinePass> {
+  using PipelineTimelinePassBase::PipelineTimelinePassBase;
+
+ private:
+  void runOnFunc(FuncOp func_op) override {
+    if (!IsMpmdFunction(func_op)) return;
+
+    SmallVector<FragmentOp> fragments =
+        llvm::to_vector(func_op.getOps<FragmentOp>());
+    if (fragments.empty()) return;
+
+    // Each mesh executes its fragments in program order.
+    llvm::DenseMap<Operation*, int64_t> fragment_to_position;
+    for (auto [position, fragment] : llvm::enumerate(fragments)) {
+      fragment_to_position[fragment] = position;
+    }
+    FragmentRanker program_order =
+        [&](FragmentOp fragment) -> std::optional<FragmentRank> {
+      return FragmentRank{fragment_to_position.lookup(fragment)};
+    };
+    AutoScheduleOptions options;
+    options.transfer_latency = transferLatency;
+    std::optional<SimulatedSchedule> schedule =
+        SimulatePipelineSchedule(fragments, program_order, options);
+    // The program order always respects the dataflow dependencies.
+    SDY_CHECK(schedule.has_value());
+    Save(func_op, fragments, *schedule);
+    markAllAnalysesPreserved();
+  }
+
+  void Save(FuncOp func_op, ArrayRef<FragmentOp> fragments,
+            const SimulatedSchedule& schedule) {
+    sdy::saveJson(
+        dumpDirectory,
+        llvm::formatv("{0}_{1}", fileName, func_op.getSymName()).str(),
+        [&](raw_ostream& os) { WriteTimeline(os, fragments, schedule); });
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
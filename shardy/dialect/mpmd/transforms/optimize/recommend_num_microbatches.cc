@@ -0,0 +1,236 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/logging.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/auto_schedule.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+#include "shardy/dialect/mpmd/transforms/optimize/utils.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_RECOMMENDNUMMICROBATCHESPASS
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h.inc"
+
+namespace {
+
+using ::mlir::func::FuncOp;
+
+// The simulated or extrapolated execution of a pipeline with a given number of
+// microbatches.
+struct MicrobatchEstimate {
+  int64_t num_microbatches = 0;
+  double makespan = 0.0;
+  // The sum of the execution times of all fragments.
+  double busy_time = 0.0;
+  int64_t max_live_activation_bytes = 0;
+  // Whether the estimate is extrapolated from smaller microbatch counts.
+  bool is_extrapolated = false;
+
+  double GetBubbleRatio(int64_t num_meshes) const {
+    return makespan > 0.0 ? 1.0 - busy_time / (makespan * num_meshes) : 0.0;
+  }
+};
+
+// Returns the estimate of `num_microbatches` microbatches, for a count larger
+// than that of `last`, assuming each extra microbatch adds what `last` added
+// to `second_to_last`.
+MicrobatchEstimate Extrapolate(const MicrobatchEstimate& second_to_last,
+                               const MicrobatchEstimate& last,
+                               int64_t num_microbatches) {
+  int64_t num_extra = num_microbatches - last.num_microbatches;
+  MicrobatchEstimate estimate;
+  estimate.num_microbatches = num_microbatches;
+  estimate.makespan =
+      last.makespan + num_extra * (last.makespan - second_to_last.makespan);
+  estimate.busy_time =
+      last.busy_time + num_extra * (last.busy_time - second_to_last.busy_time);
+  estimate.max_live_activation_bytes =
+      last.max_live_activation_bytes +
+      num_extra * std::max<int64_t>(0, last.max_live_activation_bytes -
+                                           second_to_last
+                                               .max_live_activation_bytes);
+  estimate.is_extrapolated = true;
+  return estimate;
+}
+
+class RecommendNumMicrobatchesPass
+    : public impl::RecommendNumMicrobatchesPassBase<
+          RecommendNumMicrobatchesPass> {
+  using RecommendNumMicrobatchesPassBase::RecommendNumMicrobatchesPassBase;
+
+ private:
+  void runOnFunc(FuncOp func_op) override {
+    markAllAnalysesPreserved();
+    if (!IsMpmdFunction(func_op)) return;
+
+    std::optional<PipelineSchedule> schedule =
+        ParsePipelineSchedule(pipelineSchedule);
+    std::optional<FragmentRanker> ranker =
+        schedule ? BuiltinFragmentRanker(*schedule) : std::nullopt;
+    if (!ranker) {
+      func_op.emitError() << "pipeline schedule '"
+                          << pipelineSchedule.getValue()
+                          << "' doesn't totally order the fragments of each "
+                             "mesh and cannot be simulated";
+      return signalPassFailure();
+    }
+
+    // The call counters of the microbatches, in increasing order.
+    SmallVector<uint32_t> call_counters;
+    SmallVector<FragmentOp> scheduling_units;
+    for (FragmentOp fragment : func_op.getOps<FragmentOp>()) {
+      if (!IsSchedulingUnit(fragment)) continue;
+      scheduling_units.push_back(fragment);
+      call_counters.push_back(*TryToFindCallCounter(fragment));
+    }
+    llvm::sort(call_counters);
+    call_counters.erase(llvm::unique(call_counters), call_counters.end());
+    if (call_counters.empty()) {
+      SDY_LOG(WARNING) << "Function is not microbatched, so no number of "
+                          "microbatches can be recommended.";
+      return;
+    }
+
+    llvm::StringSet<> mesh_names;
+    for (FragmentOp fragment : scheduling_units) {
+      mesh_names.insert(fragment.getMeshName());
+    }
+    int64_t num_meshes = mesh_names.size();
+
+    AutoScheduleOptions options;
+    options.transfer_latency = transferLatency;
+    // Every simulation shares the costs of the fragments of the function.
+    options.cost_analysis = &getAnalysis<FragmentCostAnalysis>();
+
+    SmallVector<MicrobatchEstimate> estimates;
+    for (int64_t num_microbatches = 1; num_microbatches <= maxNumMicrobatches;
+         ++num_microbatches) {
+      if (num_microbatches <= call_counters.size()) {
+        std::optional<MicrobatchEstimate> estimate =
+            Simulate(scheduling_units, call_counters[num_microbatches - 1],
+                     *ranker, options);
+        if (!estimate) {
+          func_op.emitError()
+              << "cannot simulate the " << pipelineSchedule.getValue()
+              << " schedule with " << num_microbatches << " microbatches";
+          return signalPassFailure();
+        }
+        estimate->num_microbatches = num_microbatches;
+        estimates.push_back(*estimate);
+      } else if (estimates.size() >= 2) {
+        estimates.push_back(Extrapolate(estimates[call_counters.size() - 2],
+                                        estimates[call_counters.size() - 1],
+                                        num_microbatches));
+      } else {
+        // A single microbatch doesn't tell how the pipeline scales.
+        break;
+      }
+    }
+
+    auto fits_in_memory = [&](const MicrobatchEstimate& estimate) {
+      return maxActivationBytes <= 0 ||
+             estimate.max_live_activation_bytes <= maxActivationBytes;
+    };
+    const MicrobatchEstimate* best = nullptr;
+    for (const MicrobatchEstimate& estimate : estimates) {
+      if (!fits_in_memory(estimate)) continue;
+      if (estimate.GetBubbleRatio(num_meshes) <= targetBubbleRatio) {
+        Report(func_op, estimate, num_meshes, call_counters.size(),
+               /*meets_target=*/true);
+        return;
+      }
+      if (!best || estimate.GetBubbleRatio(num_meshes) <
+                       best->GetBubbleRatio(num_meshes)) {
+        best = &estimate;
+      }
+    }
+    if (!best) {
+      func_op.emitWarning() << "no number of microbatches fits in "
+                            << maxActivationBytes.getValue()
+                            << " bytes of live activations per mesh";
+      return;
+    }
+    Report(func_op, *best, num_meshes, call_counters.size(),
+           /*meets_target=*/false);
+  }
+
+  // Simulates the scheduling units whose call counter is at most
+  // `max_call_counter`, i.e., the microbatches up to that call counter.
+  std::optional<MicrobatchEstimate> Simulate(
+      ArrayRef<FragmentOp> scheduling_units, uint32_t max_call_counter,
+      const FragmentRanker& ranker, const AutoScheduleOptions& options) {
+    SmallVector<FragmentOp> fragments = llvm::filter_to_vector(
+        scheduling_units, [&](FragmentOp fragment) {
+          return *TryToFindCallCounter(fragment) <= max_call_counter;
+        });
+    std::optional<SimulatedSchedule> schedule =
+        SimulatePipelineSchedule(fragments, ranker, options);
+    if (!schedule) return std::nullopt;
+    MicrobatchEstimate estimate;
+    estimate.makespan = schedule->makespan;
+    estimate.max_live_activation_bytes = schedule->max_live_activation_bytes;
+    for (const SimulatedExecution& execution : schedule->executions) {
+      estimate.busy_time += execution.finish_time - execution.start_time;
+    }
+    return estimate;
+  }
+
+  void Report(FuncOp func_op, const MicrobatchEstimate& estimate,
+              int64_t num_meshes, int64_t num_program_microbatches,
+              bool meets_target) {
+    std::string details =
+        llvm::formatv(
+            "bubble ratio {0:F3}, makespan {1:F2}, max live activation bytes "
+            "{2}",
+            estimate.GetBubbleRatio(num_meshes), estimate.makespan,
+            estimate.max_live_activation_bytes)
+            .str();
+    if (estimate.is_extrapolated) {
+      details += llvm::formatv(", extrapolated from {0} microbatches",
+                               num_program_microbatches)
+                     .str();
+    }
+    if (meets_target) {
+      func_op.emitRemark() << "recommended number of microbatches: "
+                           << estimate.num_microbatches << " (" << details
+                           << ")";
+      return;
+    }
+    func_op.emitWarning() << llvm::formatv(
+        "no number of microbatches up to {0} achieves a bubble ratio of at "
+        "most {1:F3}, the lowest is with {2} microbatches ({3})",
+        maxNumMicrobatches.getValue(), targetBubbleRatio.getValue(),
+        estimate.num_microbatches,
+        details);
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
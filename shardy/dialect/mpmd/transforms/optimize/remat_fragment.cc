@@ -13,13 +13,22 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/MLIRContext.h"
@@ -33,6 +42,8 @@ limitations under the License.
 #include "shardy/dialect/mpmd/ir/dialect.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
 #include "shardy/dialect/mpmd/transforms/common/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/auto_schedule.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
 #include "shardy/dialect/mpmd/transforms/optimize/passes.h"  // IWYU pragma: keep
 #include "shardy/dialect/mpmd/transforms/optimize/utils.h"
 
@@ -50,7 +61,8 @@ namespace {
 //
 // Requires: CanRemat(forward_fragment, backward_fragment).
 void RematFragment(IRRewriter& rewriter, FragmentOp forward_fragment,
-                   FragmentOp backward_fragment, bool merge_remat_fragments) {
+                   FragmentOp backward_fragment, bool merge_remat_fragments,
+                   FragmentInfoCache& info_cache) {
   SDY_CHECK(CanRemat(forward_fragment, backward_fragment));
   rewriter.setInsertionPoint(backward_fragment);
   // Clone the forward fragment.
@@ -62,6 +74,7 @@ void RematFragment(IRRewriter& rewriter, FragmentOp forward_fragment,
   if (merge_remat_fragments) {
     std::optional<uint32_t> backward_fragment_call_counter =
         TryToFindCallCounter(backward_fragment);
+    info_cache.Erase(backward_fragment);
     FragmentOp merged_fragment =
         MergeFragments(remat_fragment, backward_fragment, rewriter);
     // Set the call counter of the merged fragment to the call counter of the
@@ -73,24 +86,161 @@ void RematFragment(IRRewriter& rewriter, FragmentOp forward_fragment,
     }
 
     MarkAsRemat(merged_fragment, rewriter);
+    info_cache.Update(merged_fragment);
   } else {
     MarkAsRemat(remat_fragment, rewriter);
+    info_cache.Update(remat_fragment);
+  }
+}
+
+// The activations that a forward fragment keeps alive for its backward users.
+struct Activation {
+  FragmentOp forward_fragment;
+  // The backward users of the forward fragment that can be rematerialized.
+  SmallVector<FragmentOp> remat_users;
+  // Whether every backward user of the forward fragment is in `remat_users`,
+  // i.e., whether rematerialization frees the activations.
+  bool can_free = false;
+  // The bytes of the activations.
+  int64_t bytes = 0;
+  // The positions of the forward fragment and of its last backward user in
+  // the program. The activations are live in between.
+  int start = 0;
+  int end = 0;
+  // The cost of recomputing the activations.
+  double recompute_cost = 0.0;
+  bool remat = false;
+};
+
+// Returns the cost of recomputing the results of `forward_fragment` that are
+// used by `backward_fragments`, i.e., of the ops in its body these results
+// depend on. The remaining ops of the remat fragment are dead and removed by
+// the fragment DCE, so only the slice of the forward fragment that produces
+// these results is recomputed.
+//
+// A user-supplied `kFragmentCostAttrName` cost applies to the whole fragment.
+double EstimateRecomputeCost(FragmentOp forward_fragment,
+                             ArrayRef<FragmentOp> backward_fragments) {
+  if (forward_fragment->hasAttr(kFragmentCostAttrName)) {
+    return EstimateFragmentCost(forward_fragment);
+  }
+  Block* body = forward_fragment.getBody();
+  Operation* return_op = body->getTerminator();
+  SmallVector<Operation*> worklist;
+  for (OpResult result : forward_fragment->getResults()) {
+    if (llvm::any_of(result.getUsers(), [&](Operation* user) {
+          return llvm::is_contained(backward_fragments, user);
+        })) {
+      if (Operation* defining_op =
+              return_op->getOperand(result.getResultNumber()).getDefiningOp()) {
+        worklist.push_back(defining_op);
+      }
+    }
+  }
+  DenseSet<Operation*> slice;
+  double cost = 0.0;
+  while (!worklist.empty()) {
+    Operation* op = worklist.pop_back_val();
+    if (!slice.insert(op).second) {
+      continue;
+    }
+    // Walk nested ops too, as their operands may be defined in the body.
+    op->walk([&](Operation* nested_op) {
+      cost += EstimateOpCost(nested_op);
+      for (Value operand : nested_op->getOperands()) {
+        if (Operation* defining_op = operand.getDefiningOp();
+            defining_op && defining_op->getBlock() == body) {
+          worklist.push_back(defining_op);
+        }
+      }
+    });
+  }
+  return cost;
+}
+
+// Marks the activations to rematerialize so that the bytes of activations
+// that are live at the same time on each mesh, when the fragments execute in
+// program order, are at most `memory_target_bytes`.
+//
+// While the peak of a mesh is above the target, rematerializes the activations
+// that are live at the peak and have the lowest recompute cost per byte.
+// Stops once no activation live at the peak can be freed, in which case the
+// target is not met.
+void SelectActivationsToRemat(MutableArrayRef<Activation> activations,
+                              int num_positions, int64_t memory_target_bytes) {
+  llvm::MapVector<StringRef, SmallVector<Activation*>> mesh_to_activations;
+  for (Activation& activation : activations) {
+    mesh_to_activations[activation.forward_fragment.getMeshName()].push_back(
+        &activation);
+  }
+  for (auto& [mesh_name, mesh_activations] : mesh_to_activations) {
+    while (true) {
+      std::vector<int64_t> live_bytes(num_positions + 1, 0);
+      for (Activation* activation : mesh_activations) {
+        if (!activation->remat) {
+          live_bytes[activation->start] += activation->bytes;
+          live_bytes[activation->end + 1] -= activation->bytes;
+        }
+      }
+      int peak_position = 0;
+      int64_t peak_bytes = live_bytes[0];
+      for (int position = 1; position < num_positions; ++position) {
+        live_bytes[position] += live_bytes[position - 1];
+        if (live_bytes[position] > peak_bytes) {
+          peak_position = position;
+          peak_bytes = live_bytes[position];
+        }
+      }
+      if (peak_bytes <= memory_target_bytes) {
+        break;
+      }
+      Activation* best = nullptr;
+      for (Activation* activation : mesh_activations) {
+        if (activation->remat || !activation->can_free ||
+            activation->start > peak_position ||
+            activation->end < peak_position) {
+          continue;
+        }
+        if (!best || activation->recompute_cost * best->bytes <
+                         best->recompute_cost * activation->bytes) {
+          best = activation;
+        }
+      }
+      if (!best) {
+        SDY_LOG(WARNING) << "Cannot meet the remat memory target of "
+                         << memory_target_bytes << " bytes on mesh "
+                         << mesh_name.str() << ", the peak is " << peak_bytes
+                         << " bytes.";
+        break;
+      }
+      best->remat = true;
+    }
   }
 }
 
 // Iterates over a function, identify forward and backward fragment pairs that
 // need rematerialization and rematerializes one by one. If there are multiple
 // backward fragments matching a forward fragment, remat all of them.
+//
+// When `memory_target_bytes` is positive, only rematerializes the forward
+// fragments needed to meet it, see `SelectActivationsToRemat`.
 void RematFragments(IRRewriter& rewriter, func::FuncOp func_op,
-                    bool merge_remat_fragments) {
+                    bool merge_remat_fragments, int64_t memory_target_bytes,
+                    FragmentInfoCache& info_cache) {
+  auto has_transpose_count = [&](FragmentOp fragment, int64_t count) {
+    return info_cache.GetTransposeCount(info_cache.GetId(fragment)) == count;
+  };
   SmallVector<FragmentOp> all_forward_fragments;
-  for (Operation& op : func_op.getOps()) {
-    if (auto fragment = dyn_cast<FragmentOp>(&op);
-        fragment && IsForwardFragment(fragment)) {
+  DenseMap<Operation*, int> fragment_to_position;
+  for (auto [position, fragment] :
+       llvm::enumerate(func_op.getOps<FragmentOp>())) {
+    fragment_to_position[fragment] = position;
+    if (has_transpose_count(fragment, 0)) {
       all_forward_fragments.push_back(fragment);
     }
   }
 
+  SmallVector<Activation> activations;
   for (FragmentOp forward_fragment : all_forward_fragments) {
     // Get the users of forward_fragment that can be rematerialized and sort
     // them by their program order. The sorting is needed because `getUsers()`
@@ -99,10 +249,23 @@ void RematFragments(IRRewriter& rewriter, func::FuncOp func_op,
     // `RematFragment`), it prevents the earlier users to match and remat
     // correctly.
     DenseSet<Operation*> users;
+    Activation activation{forward_fragment};
+    activation.can_free = true;
+    activation.start = fragment_to_position[forward_fragment];
+    activation.end = activation.start;
     for (Operation* user : forward_fragment->getUsers()) {
-      if (auto backward_fragment = dyn_cast<FragmentOp>(user);
-          backward_fragment && CanRemat(forward_fragment, backward_fragment)) {
-        users.insert(user);
+      // Check the cached transpose count first, to skip most non-backward
+      // users without looking at their attributes.
+      auto backward_fragment = dyn_cast<FragmentOp>(user);
+      if (!backward_fragment || !has_transpose_count(backward_fragment, 1)) {
+        continue;
+      }
+      activation.end =
+          std::max(activation.end, fragment_to_position[backward_fragment]);
+      if (!CanRemat(forward_fragment, backward_fragment)) {
+        activation.can_free = false;
+      } else if (users.insert(user).second) {
+        activation.remat_users.push_back(backward_fragment);
       }
     }
     if (users.size() > 1 && SDY_VLOG_IS_ON(1)) {
@@ -114,7 +277,31 @@ void RematFragments(IRRewriter& rewriter, func::FuncOp func_op,
              "metadata= "
           << fragment_metadata;
     }
+    if (memory_target_bytes > 0) {
+      // Activations without backward users take no memory while the forward
+      // fragment waits for them.
+      activation.bytes = GetActivationBytes(forward_fragment);
+      if (activation.bytes == 0) {
+        continue;
+      }
+      activation.can_free = activation.can_free && !users.empty();
+      activation.recompute_cost =
+          EstimateRecomputeCost(forward_fragment, activation.remat_users);
+    } else {
+      activation.remat = true;
+    }
+    activations.push_back(std::move(activation));
+  }
 
+  if (memory_target_bytes > 0) {
+    SelectActivationsToRemat(activations, fragment_to_position.size(),
+                             memory_target_bytes);
+  }
+
+  for (Activation& activation : activations) {
+    if (!activation.remat) {
+      continue;
+    }
     // In the case where multiple backward fragments match the same forward
     // fragment, we have a few options:
     // 1. Only add a remat fragment in front of the first backward fragment
@@ -127,10 +314,9 @@ void RematFragments(IRRewriter& rewriter, func::FuncOp func_op,
     // that the more remat fragments we add, the more we trade runtime for
     // memory. We are choosing option 2 because it's easier to implement. We
     // may support both options later to have more control over remat.
-    for (Operation* user : users) {
-      auto backward_fragment = dyn_cast<FragmentOp>(user);
-      RematFragment(rewriter, forward_fragment, backward_fragment,
-                    merge_remat_fragments);
+    for (FragmentOp backward_fragment : activation.remat_users) {
+      RematFragment(rewriter, activation.forward_fragment, backward_fragment,
+                    merge_remat_fragments, info_cache);
     }
   }
 }
@@ -143,7 +329,11 @@ class RematFragmentPass
   void runOnFunc(func::FuncOp func_op) override {
     MLIRContext* context = func_op->getContext();
     IRRewriter rewriter(context);
-    RematFragments(rewriter, func_op, mergeRematFragments);
+    FragmentInfoCache& info_cache = getAnalysis<FragmentInfoCache>();
+    RematFragments(rewriter, func_op, mergeRematFragments, memoryTargetBytes,
+                   info_cache);
+    // Every fragment created or erased above was updated in the cache.
+    markAnalysesPreserved<FragmentInfoCache>();
   }
 };
 
@@ -46,11 +46,14 @@ class RuleBasedSchedulePass
       return;
     }
 
+    FragmentInfoCache& info_cache = getAnalysis<FragmentInfoCache>();
+
     // Build a map from FragmentInfo to FragmentOp for efficient lookup.
     DenseMap<FragmentInfo, FragmentOp, FragmentInfoMapInfo> info_to_op_map;
     func_op.walk([&](FragmentOp fragment) {
       if (fragment.isUserFragment()) {
-        FragmentInfo fragment_info = GetFragmentInfo(fragment);
+        const FragmentInfo& fragment_info =
+            info_cache.GetInfo(info_cache.GetId(fragment));
         auto [unused_iter, was_inserted] =
             info_to_op_map.insert({fragment_info, fragment});
         if (!was_inserted) {
@@ -148,6 +151,9 @@ class RuleBasedSchedulePass
     if (removeControlDependencies) {
       RemoveAllControlDependencies(func_op);
     }
+
+    // Fragments were only reordered, so their cached info is still valid.
+    markAnalysesPreserved<FragmentInfoCache>();
   }
 };
 
@@ -16,7 +16,14 @@ limitations under the License.
 #include "shardy/dialect/mpmd/transforms/optimize/scheduler.h"
 
 #include <optional>
-
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ScopedPrinter.h"
 #include "mlir/Analysis/TopologicalSortUtils.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Value.h"
@@ -24,8 +31,12 @@ limitations under the License.
 #include "mlir/Pass/PassRegistry.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/common/logging.h"
+#include "shardy/common/timing_report.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/fragment_execution_rules.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/optimize/auto_schedule.h"
+#include "shardy/dialect/mpmd/transforms/optimize/fragment_cost.h"
 #include "shardy/dialect/mpmd/transforms/optimize/passes.h"  // IWYU pragma: keep
 #include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
 #include "shardy/dialect/mpmd/transforms/optimize/utils.h"
@@ -47,31 +58,105 @@ class PipelineSchedulerPass
   void runOnFunc(FuncOp func_op) override {
     if (!IsMpmdFunction(func_op)) return;
 
+    FragmentInfoCache& info_cache = getAnalysis<FragmentInfoCache>();
+
     // 1. Collect all fragments.
     std::vector<FragmentOp> all_fragments;
-    for (Operation& op : func_op.getOps()) {
-      if (auto fragment = dyn_cast<FragmentOp>(&op);
-          fragment && IsSchedulingUnit(fragment)) {
+    for (auto fragment : func_op.getOps<FragmentOp>()) {
+      if (info_cache.IsSchedulingUnit(info_cache.GetId(fragment))) {
         all_fragments.push_back(fragment);
       }
     }
 
     // 2. Add control dependencies between some pairs of fragments.
+    //
+    // The dependencies between fragments are precomputed, and updated with
+    // every control dependency added, so that each pair is checked in
+    // constant time instead of traversing the def-use graph.
+    FragmentReachability reachability(all_fragments);
+    std::optional<FragmentRanker> ranker;
+    if (mustHappenBefore.schedule == PipelineSchedule::kAuto) {
+      sdy::TimingReportScope timing_scope("find_auto_schedule");
+      ranker = FindAutoScheduleRanker(all_fragments);
+    } else if (rankBasedScheduling && mustHappenBefore.schedule) {
+      ranker = BuiltinFragmentRanker(*mustHappenBefore.schedule);
+    }
+    std::optional<int> count_control_dependencies;
+    {
+      sdy::TimingReportScope timing_scope("add_control_dependencies");
+      if (ranker) {
+        count_control_dependencies = AddRankedControlDependencies(
+            all_fragments, *ranker, reachability, info_cache);
+      }
+      if (!count_control_dependencies) {
+        count_control_dependencies = AddPairwiseControlDependencies(
+            all_fragments, reachability, info_cache);
+      }
+    }
+    SDY_LOG(INFO) << "Introduced " << *count_control_dependencies
+                  << " control dependencies for scheduling\n";
+
+    // 3. Sort the graph topologically to guarantee that all dependencies are
+    // respected.
+    {
+      sdy::TimingReportScope timing_scope("sort_topologically");
+      sortTopologically(&func_op.getBody().front());
+    }
+
+    // 4. Remove control dependencies if requested.
+    if (removeControlDependencies) {
+      RemoveAllControlDependencies(func_op);
+    }
+
+    // Fragments were only reordered (and control dependencies don't change
+    // their info), so the cached info of every fragment is still valid.
+    markAnalysesPreserved<FragmentInfoCache>();
+  }
+
+  // Returns the ranker of the schedule with the lowest simulated makespan for
+  // `all_fragments`, or std::nullopt if no schedule can be simulated, in which
+  // case the fallback comparator of the `Auto` schedule is used.
+  std::optional<FragmentRanker> FindAutoScheduleRanker(
+      ArrayRef<FragmentOp> all_fragments) {
+    AutoScheduleOptions options;
+    options.transfer_latency = autoScheduleTransferLatency;
+    options.max_in_flight_microbatches = autoScheduleMaxInFlightMicrobatches;
+    options.max_activation_bytes = autoScheduleMaxActivationBytes;
+    options.cost_analysis = &getAnalysis<FragmentCostAnalysis>();
+    std::optional<ScheduleCandidate> candidate =
+        FindBestPipelineSchedule(all_fragments, options);
+    if (!candidate) {
+      SDY_LOG(WARNING) << "No pipeline schedule could be simulated, falling "
+                          "back to the 1F1B schedule.";
+      return std::nullopt;
+    }
+    SDY_LOG(INFO) << "Selected " << candidate->name << " schedule.";
+    return std::move(candidate->ranker);
+  }
+
+  // Adds a control dependency from `fragment1` to `fragment2` for every pair of
+  // fragments on the same mesh, such that `fragment1` must happen before
+  // `fragment2`. Returns the number of control dependencies added.
+  int AddPairwiseControlDependencies(ArrayRef<FragmentOp> all_fragments,
+                                     FragmentReachability& reachability,
+                                     FragmentInfoCache& info_cache) {
+    SmallVector<StringRef> mesh_names =
+        llvm::map_to_vector(all_fragments, [&](FragmentOp fragment) {
+          return info_cache.GetMeshName(info_cache.GetId(fragment));
+        });
     int count_control_dependencies = 0;
-    for (FragmentOp fragment1 : all_fragments) {
-      for (FragmentOp fragment2 : all_fragments) {
+    for (auto [fragment1, mesh_name1] : llvm::zip(all_fragments, mesh_names)) {
+      for (auto [fragment2, mesh_name2] :
+           llvm::zip(all_fragments, mesh_names)) {
         if (fragment1 == fragment2) continue;
 
-        if (fragment1.getMeshName() != fragment2.getMeshName()) continue;
+        if (mesh_name1 != mesh_name2) continue;
 
-        // TODO(jupvfranco): we typically expect to see at least 2 * num_stages
-        // * num_microbatches. For high numbers of stages or microbatches this
-        // may become slow. Consider pre-computing a reachability matrix.
-        // Alternatively, consider removing this check completely and define a
-        // post-reorder check to verify that for any control-dependency added,
-        // the source appears before the destination of the dependency.
-        if (GetDependencyPath(fragment1, fragment2).has_value() ||
-            GetDependencyPath(fragment2, fragment1).has_value()) {
+        // Skip pairs that are already ordered, either by a dataflow
+        // dependency or by control dependencies added before, so that we only
+        // add non-redundant control dependencies and never introduce a cycle.
+        if (reachability.HasDependency(fragment1, fragment2) ||
+            reachability.HasDependency(fragment2, fragment1)) {
           continue;
         }
 
@@ -81,21 +166,69 @@ class PipelineSchedulerPass
           // reordered all the fragments, we can then use this information to
           // remove any control-dependencies from the program.
           AddControlDependency(fragment1, fragment2);
+          reachability.RecordDependency(fragment1, fragment2);
           count_control_dependencies++;
         }
       }
     }
-    SDY_LOG(INFO) << "Introduced " << count_control_dependencies
-                  << " control dependencies for scheduling\n";
+    return count_control_dependencies;
+  }
 
-    // 3. Sort the graph topologically to guarantee that all dependencies are
-    // respected.
-    sortTopologically(&func_op.getBody().front());
+  // Sorts the fragments of each mesh by their rank, and adds a control
+  // dependency between every two adjacent fragments that aren't already
+  // ordered. Returns the number of control dependencies added, or
+  // std::nullopt if any fragment cannot be ranked, in which case no control
+  // dependency is added.
+  std::optional<int> AddRankedControlDependencies(
+      ArrayRef<FragmentOp> all_fragments, const FragmentRanker& ranker,
+      FragmentReachability& reachability, FragmentInfoCache& info_cache) {
+    llvm::MapVector<StringRef, SmallVector<std::pair<FragmentRank, FragmentOp>>>
+        mesh_to_ranked_fragments;
+    for (FragmentOp fragment : all_fragments) {
+      std::optional<FragmentRank> rank = ranker(fragment);
+      if (!rank) {
+        SDY_LOG(WARNING) << "Cannot rank fragment "
+                         << llvm::to_string(info_cache.GetInfo(
+                                info_cache.GetId(fragment)))
+                         << ", falling back to pairwise scheduling.";
+        return std::nullopt;
+      }
+      mesh_to_ranked_fragments[info_cache.GetMeshName(
+                                   info_cache.GetId(fragment))]
+          .emplace_back(
+          std::move(*rank), fragment);
+    }
 
-    // 4. Remove control dependencies if requested.
-    if (removeControlDependencies) {
-      RemoveAllControlDependencies(func_op);
+    int count_control_dependencies = 0;
+    for (auto& [_, ranked_fragments] : mesh_to_ranked_fragments) {
+      llvm::stable_sort(ranked_fragments, [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+      });
+      for (auto [prev, next] :
+           llvm::zip(ranked_fragments, llvm::drop_begin(ranked_fragments))) {
+        FragmentOp fragment1 = prev.second;
+        FragmentOp fragment2 = next.second;
+        if (prev.first == next.first ||
+            reachability.HasDependency(fragment1, fragment2)) {
+          continue;
+        }
+        if (reachability.HasDependency(fragment2, fragment1)) {
+          SDY_LOG(WARNING) << "Fragment "
+                           << llvm::to_string(info_cache.GetInfo(
+                                  info_cache.GetId(fragment2)))
+                           << " is ranked after "
+                           << llvm::to_string(info_cache.GetInfo(
+                                  info_cache.GetId(fragment1)))
+                           << " but must happen before it due to a dataflow "
+                              "dependency.";
+          continue;
+        }
+        AddControlDependency(fragment1, fragment2);
+        reachability.RecordDependency(fragment1, fragment2);
+        count_control_dependencies++;
+      }
     }
+    return count_control_dependencies;
   }
 };
 
@@ -0,0 +1,118 @@
+// RUN: mpmd_opt %s -mpmd-coalesce-fragments='max-cost=100' 2>&1 | FileCheck %s
+
+!mesh_1_tensor_4_8_f32 = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor_4_8_f32 = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+// Each fragment adds 32 elements, so both fit in a merged fragment, even with
+// a fragment of another mesh in between.
+
+// CHECK-LABEL: func @coalesce_small_fragments
+func.func @coalesce_small_fragments(%arg0: !mesh_1_tensor_4_8_f32, %arg1: !mesh_2_tensor_4_8_f32)
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32, !mesh_2_tensor_4_8_f32) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=1]>>, <"m2": <["x"=1]>>>} {
+  // CHECK-NEXT: %[[M2:.*]] = mpmd.fragment<mesh="m2", origin=[]> (%arg1)
+  // CHECK:      %[[MERGED:.*]]:2 = mpmd.fragment<mesh="m1", origin=[]> (%arg0)
+  // CHECK-NEXT:   stablehlo.add
+  // CHECK-NEXT:   stablehlo.multiply
+  // CHECK-NEXT:   mpmd.return
+  // CHECK-NEXT: }
+  // CHECK-NEXT: return %[[MERGED]]#0, %[[MERGED]]#1, %[[M2]]
+  %0 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.add %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %1 = mpmd.fragment<mesh="m2", origin=[]> (%arg1) (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.add %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_2_tensor_4_8_f32) -> !mesh_2_tensor_4_8_f32
+  %2 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.multiply %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  return %0, %2, %1 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32, !mesh_2_tensor_4_8_f32
+}
+
+// CHECK-LABEL: func @merged_fragment_exceeds_max_cost
+func.func @merged_fragment_exceeds_max_cost(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=1]>>>} {
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=[]> (%arg0) {mpmd.fragment_cost = 8.000000e+01 : f32}
+  // CHECK:      mpmd.fragment<mesh="m1", origin=[]> (%arg0)
+  %0 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) {mpmd.fragment_cost = 80.0 : f32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %1 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %2 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %2 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  return %0, %1 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
+
+// CHECK-LABEL: func @user_costs_are_summed
+func.func @user_costs_are_summed(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=1]>>>} {
+  // CHECK-NEXT: %[[MERGED:.*]]:2 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) {mpmd.fragment_cost = 4.200000e+01 : f32}
+  // CHECK:      return %[[MERGED]]#0, %[[MERGED]]#1
+  %0 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) {mpmd.fragment_cost = 10.0 : f32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %1 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %2 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %2 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  return %0, %1 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
+
+// CHECK-LABEL: func @transferred_result_not_coalesced
+func.func @transferred_result_not_coalesced(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_2_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=1]>>, <"m2": <["x"=1]>>>} {
+  // CHECK-NEXT: %[[F0:.*]] = mpmd.fragment<mesh="m1", origin=[]> (%arg0)
+  // CHECK:      mpmd.fragment<mesh="m1", origin=[]> (%arg0)
+  // CHECK:      mpmd.transfer %[[F0]]
+  %0 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %1 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %3 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %2 = mpmd.transfer %0 : (!mesh_1_tensor_4_8_f32) -> !mesh_2_tensor_4_8_f32
+  return %2, %1 : !mesh_2_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
+
+// CHECK-LABEL: func @operand_produced_in_between_not_coalesced
+func.func @operand_produced_in_between_not_coalesced(%arg0: !mesh_1_tensor_4_8_f32, %arg1: !mesh_2_tensor_4_8_f32)
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=1]>>, <"m2": <["x"=1]>>>} {
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=[]> (%arg0)
+  // CHECK:      %[[TRANSFER:.*]] = mpmd.transfer %arg1
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=[]> (%[[TRANSFER]])
+  %0 = mpmd.fragment<mesh="m1", origin=[]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.add %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %1 = mpmd.transfer %arg1 : (!mesh_2_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %2 = mpmd.fragment<mesh="m1", origin=[]> (%1) (%arg2: tensor<4x8xf32>) {
+    %3 = stablehlo.add %arg2, %arg2 : tensor<4x8xf32>
+    mpmd.return %3 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  return %0, %2 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
+
+// CHECK-LABEL: func @scheduling_units_not_coalesced
+func.func @scheduling_units_not_coalesced(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=1]>>>} {
+  // CHECK-NEXT: mpmd.fragment<mesh="m1", origin=["f1"]>
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f2"]>
+  %0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) {call_counter = 0 : ui32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %1 = mpmd.fragment<mesh="m1", origin=["f2"]> (%arg0) {call_counter = 0 : ui32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  return %0, %1 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
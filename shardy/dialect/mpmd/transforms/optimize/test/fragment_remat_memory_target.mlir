@@ -0,0 +1,61 @@
+// RUN: mpmd_opt %s -mpmd-remat-fragment='memory-target-bytes=128' 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-remat-fragment='memory-target-bytes=256' 2>&1 | FileCheck %s --check-prefix=NO-REMAT
+
+!mesh_1_tensor_4_8_f32 = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+
+// The activations of f1 and f2 are 128 bytes each and both are live before
+// the backward fragment of f1, so one of them must be rematerialized to meet a
+// target of 128 bytes. Recomputing f1 is free, as it doesn't compute anything.
+
+// CHECK-LABEL: func @remat_cheapest_activation_at_peak
+// NO-REMAT-LABEL: func @remat_cheapest_activation_at_peak
+// NO-REMAT-NOT: remat
+func.func @remat_cheapest_activation_at_peak(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {"topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+  // CHECK: mpmd.fragment<mesh="m1", origin=["f1"]>
+  %f1 = mpmd.fragment<mesh="m1", origin=["f1"(0)]> (%arg0) {call_counter = 1 : ui32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  // CHECK: mpmd.fragment<mesh="m1", origin=["f2"]>
+  %f2 = mpmd.fragment<mesh="m1", origin=["f2"(0)]> (%arg0) {call_counter = 1 : ui32} (%arg1: tensor<4x8xf32>) {
+    %0 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %0 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  // CHECK: %[[REMAT:.*]] = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0) {call_counter = 1 : ui32, remat}
+  // CHECK: mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%[[REMAT]])
+  %b1 = mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%f1) {call_counter = 1 : ui32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  // CHECK-NOT: remat
+  // CHECK: mpmd.fragment<mesh="m1", origin=["f2"(1)]>
+  %b2 = mpmd.fragment<mesh="m1", origin=["f2"(1)]> (%f2) {call_counter = 1 : ui32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  return %b1, %b2 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
+
+// CHECK-LABEL: func @remat_respects_fragment_cost
+// NO-REMAT-LABEL: func @remat_respects_fragment_cost
+// NO-REMAT-NOT: remat
+func.func @remat_respects_fragment_cost(%arg0: !mesh_1_tensor_4_8_f32)
+  -> (!mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32) attributes {"topology"=#mpmd.topology<<"m1": <["x"=2]>>>} {
+  // A user-supplied cost makes f1 more expensive to recompute than f2.
+  %f1 = mpmd.fragment<mesh="m1", origin=["f1"(0)]> (%arg0) {call_counter = 1 : ui32, mpmd.fragment_cost = 100.0 : f32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  %f2 = mpmd.fragment<mesh="m1", origin=["f2"(0)]> (%arg0) {call_counter = 1 : ui32} (%arg1: tensor<4x8xf32>) {
+    %0 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %0 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  // CHECK-NOT: remat
+  // CHECK: mpmd.fragment<mesh="m1", origin=["f1"(1)]>
+  %b1 = mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%f1) {call_counter = 1 : ui32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  // CHECK: %[[REMAT:.*]] = mpmd.fragment<mesh="m1", origin=["f2"]> (%arg0) {call_counter = 1 : ui32, remat}
+  // CHECK: mpmd.fragment<mesh="m1", origin=["f2"(1)]> (%[[REMAT]])
+  %b2 = mpmd.fragment<mesh="m1", origin=["f2"(1)]> (%f2) {call_counter = 1 : ui32} (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor_4_8_f32) -> !mesh_1_tensor_4_8_f32
+  return %b1, %b2 : !mesh_1_tensor_4_8_f32, !mesh_1_tensor_4_8_f32
+}
@@ -0,0 +1,35 @@
+// RUN: mpmd_opt %s -mpmd-pipeline-scheduler='must-happen-before=CircularWithSplitBackward' 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-pipeline-scheduler='must-happen-before=CircularWithSplitBackward rank-based-scheduling=true' 2>&1 | FileCheck %s
+
+// Verifies that on mesh 1, the parameter gradient fragment of each microbatch
+// is delayed until after the activation gradient fragment of the next
+// microbatch.
+
+!mesh_2_tensor_2_2_f32 = !mpmd.mesh_tensor<"m2", tensor<2x2xf32>>
+
+// CHECK-LABEL: func @main
+// CHECK:       mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 0
+// CHECK-SAME:    split_keep_transferred
+// CHECK:       mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 1
+// CHECK-SAME:    split_keep_transferred
+// CHECK:       mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 0
+// CHECK-SAME:    split_drop_transferred
+// CHECK:       mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 1
+// CHECK-SAME:    split_drop_transferred
+func.func @main(%arg0: !mesh_2_tensor_2_2_f32)
+ -> (!mesh_2_tensor_2_2_f32, !mesh_2_tensor_2_2_f32, !mesh_2_tensor_2_2_f32, !mesh_2_tensor_2_2_f32)
+ attributes {topology = #mpmd.topology<<"m1" : <["x"=1]>>, <"m2" : <["x"=1]>>> } {
+  %w1 = mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 1 : ui32, split_drop_transferred} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!mesh_2_tensor_2_2_f32) -> !mesh_2_tensor_2_2_f32
+  %w0 = mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 0 : ui32, split_drop_transferred} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!mesh_2_tensor_2_2_f32) -> !mesh_2_tensor_2_2_f32
+  %b1 = mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 1 : ui32, split_keep_transferred} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!mesh_2_tensor_2_2_f32) -> !mesh_2_tensor_2_2_f32
+  %b0 = mpmd.fragment<mesh="m2", origin=["f"(1)], stage=1> (%arg0) {call_counter = 0 : ui32, split_keep_transferred} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!mesh_2_tensor_2_2_f32) -> !mesh_2_tensor_2_2_f32
+  return %b0, %b1, %w0, %w1 : !mesh_2_tensor_2_2_f32, !mesh_2_tensor_2_2_f32, !mesh_2_tensor_2_2_f32, !mesh_2_tensor_2_2_f32
+}
@@ -0,0 +1,45 @@
+// RUN: mpmd_opt %s -mpmd-pipeline-scheduler='must-happen-before=1F1B rank-based-scheduling=true' | FileCheck %s --check-prefix=1F1B
+// RUN: mpmd_opt %s -mpmd-pipeline-scheduler='must-happen-before=GPipe rank-based-scheduling=true' | FileCheck %s --check-prefix=GPIPE
+// RUN: mpmd_opt %s -mpmd-pipeline-scheduler='must-happen-before=Auto' | FileCheck %s --check-prefix=1F1B
+
+// Verifies that rank-based scheduling sorts independent fragments on the same
+// mesh in the order of the built-in schedule. All schedules have the same
+// simulated makespan on a single mesh, so the `Auto` schedule picks 1F1B.
+
+!mesh_1_tensor_2_2_f32 = !mpmd.mesh_tensor<"m1", tensor<2x2xf32>>
+
+// 1F1B-LABEL: func @main
+// 1F1B:       mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) {call_counter = 0
+// 1F1B-NEXT:  stablehlo.add
+// 1F1B-NEXT:  mpmd.return
+// 1F1B-NEXT:  }
+// 1F1B-NEXT:  mpmd.fragment<mesh="m1", origin=["f"(1)]> (%arg0) {call_counter = 0
+// 1F1B:       mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) {call_counter = 1
+// 1F1B:       mpmd.fragment<mesh="m1", origin=["f"(1)]> (%arg0) {call_counter = 1
+
+// GPIPE-LABEL: func @main
+// GPIPE:       mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) {call_counter = 0
+// GPIPE:       mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) {call_counter = 1
+// GPIPE:       mpmd.fragment<mesh="m1", origin=["f"(1)]> (%arg0) {call_counter = 0
+// GPIPE:       mpmd.fragment<mesh="m1", origin=["f"(1)]> (%arg0) {call_counter = 1
+func.func @main(%arg0: !mesh_1_tensor_2_2_f32)
+ -> (!mesh_1_tensor_2_2_f32, !mesh_1_tensor_2_2_f32, !mesh_1_tensor_2_2_f32, !mesh_1_tensor_2_2_f32)
+ attributes {topology = #mpmd.topology<<"m1" : <["x"=1]>>> } {
+  %b1 = mpmd.fragment<mesh="m1", origin=["f"(1)]> (%arg0) {call_counter = 1 : ui32} (%arg1: tensor<2x2xf32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<2x2xf32>
+    mpmd.return %1 : tensor<2x2xf32>
+  } : (!mesh_1_tensor_2_2_f32) -> !mesh_1_tensor_2_2_f32
+  %f1 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) {call_counter = 1 : ui32} (%arg1: tensor<2x2xf32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<2x2xf32>
+    mpmd.return %1 : tensor<2x2xf32>
+  } : (!mesh_1_tensor_2_2_f32) -> !mesh_1_tensor_2_2_f32
+  %b0 = mpmd.fragment<mesh="m1", origin=["f"(1)]> (%arg0) {call_counter = 0 : ui32} (%arg1: tensor<2x2xf32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<2x2xf32>
+    mpmd.return %1 : tensor<2x2xf32>
+  } : (!mesh_1_tensor_2_2_f32) -> !mesh_1_tensor_2_2_f32
+  %f0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) {call_counter = 0 : ui32} (%arg1: tensor<2x2xf32>) {
+    %1 = stablehlo.add %arg1, %arg1 : tensor<2x2xf32>
+    mpmd.return %1 : tensor<2x2xf32>
+  } : (!mesh_1_tensor_2_2_f32) -> !mesh_1_tensor_2_2_f32
+  return %f0, %f1, %b0, %b1 : !mesh_1_tensor_2_2_f32, !mesh_1_tensor_2_2_f32, !mesh_1_tensor_2_2_f32, !mesh_1_tensor_2_2_f32
+}
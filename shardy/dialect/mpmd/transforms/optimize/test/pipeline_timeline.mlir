@@ -0,0 +1,84 @@
+// RUN: mpmd_opt %s -mpmd-pipeline-timeline='transfer-latency=1' 2>&1 | FileCheck %s
+
+!m0_tensor = !mpmd.mesh_tensor<"m0", tensor<2x2xf32>>
+!m1_tensor = !mpmd.mesh_tensor<"m1", tensor<2x2xf32>>
+
+// m0: f0 [0, 2]                 f0(1) [6, 8]
+// m1:           f1 [3, 4] f1(1) [4, 5]
+// The meshes are busy for 6 out of 16 units of time.
+
+// CHECK-LABEL: "traceEvents": [
+// CHECK:         "name": "thread_name",
+// CHECK:         "tid": 0,
+// CHECK:         "name": "m0"
+// CHECK:         "name": "thread_name",
+// CHECK:         "tid": 1,
+// CHECK:         "name": "m1"
+// CHECK:         "name": "f0",
+// CHECK-NEXT:    "cat": "fragment",
+// CHECK-NEXT:    "ph": "X",
+// CHECK-NEXT:    "pid": 0,
+// CHECK-NEXT:    "tid": 0,
+// CHECK-NEXT:    "ts": 0,
+// CHECK-NEXT:    "dur": 2,
+// CHECK:         "call_counter": 0
+// CHECK:         "name": "f1",
+// CHECK:         "tid": 1,
+// CHECK-NEXT:    "ts": 3,
+// CHECK-NEXT:    "dur": 1,
+// CHECK:         "name": "transfer",
+// CHECK-NEXT:    "cat": "transfer",
+// CHECK-NEXT:    "ph": "s",
+// CHECK-NEXT:    "id": 0,
+// CHECK-NEXT:    "pid": 0,
+// CHECK-NEXT:    "tid": 0,
+// CHECK-NEXT:    "ts": 2
+// CHECK:         "name": "transfer",
+// CHECK-NEXT:    "cat": "transfer",
+// CHECK-NEXT:    "ph": "f",
+// CHECK-NEXT:    "bp": "e",
+// CHECK-NEXT:    "id": 0,
+// CHECK-NEXT:    "pid": 0,
+// CHECK-NEXT:    "tid": 1,
+// CHECK-NEXT:    "ts": 3
+// CHECK:         "name": "f1(1)",
+// CHECK:         "tid": 1,
+// CHECK-NEXT:    "ts": 4,
+// CHECK-NEXT:    "dur": 1,
+// CHECK:         "name": "f0(1)",
+// CHECK:         "tid": 0,
+// CHECK-NEXT:    "ts": 6,
+// CHECK-NEXT:    "dur": 2,
+// CHECK:         "ph": "s",
+// CHECK-NEXT:    "id": 1,
+// CHECK-NEXT:    "pid": 0,
+// CHECK-NEXT:    "tid": 1,
+// CHECK-NEXT:    "ts": 5
+// CHECK:         "ph": "f",
+// CHECK-NEXT:    "bp": "e",
+// CHECK-NEXT:    "id": 1,
+// CHECK-NEXT:    "pid": 0,
+// CHECK-NEXT:    "tid": 0,
+// CHECK-NEXT:    "ts": 6
+// CHECK:       "otherData": {
+// CHECK-NEXT:    "makespan": 8,
+// CHECK-NEXT:    "bubble_ratio": 0.625
+// CHECK-LABEL: func.func @main
+func.func @main(%arg0: !m0_tensor) -> !m0_tensor
+  attributes {topology = #mpmd.topology<<"m0" : <["x"=1]>>, <"m1" : <["x"=1]>>>} {
+  %f0 = mpmd.fragment<mesh="m0", origin=["f0"]> (%arg0) {call_counter = 0 : ui32, mpmd.fragment_cost = 2.0 : f64} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!m0_tensor) -> !m0_tensor
+  %t = mpmd.transfer %f0 : (!m0_tensor) -> !m1_tensor
+  %f1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%t) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %b1 = mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%f1) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %u = mpmd.transfer %b1 : (!m1_tensor) -> !m0_tensor
+  %b0 = mpmd.fragment<mesh="m0", origin=["f0"(1)]> (%u) {call_counter = 0 : ui32, mpmd.fragment_cost = 2.0 : f64} (%arg1: tensor<2x2xf32>) {
+    mpmd.return %arg1 : tensor<2x2xf32>
+  } : (!m0_tensor) -> !m0_tensor
+  return %b0 : !m0_tensor
+}
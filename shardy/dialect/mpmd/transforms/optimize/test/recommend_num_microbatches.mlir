@@ -0,0 +1,50 @@
+// RUN: mpmd_opt %s -mpmd-recommend-num-microbatches='target-bubble-ratio=0.15' 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-recommend-num-microbatches='target-bubble-ratio=0.15 max-num-microbatches=4' 2>&1 | FileCheck %s --check-prefix=MAX
+// RUN: mpmd_opt %s -mpmd-recommend-num-microbatches='max-activation-bytes=8' 2>&1 | FileCheck %s --check-prefix=MEMORY
+// RUN: not mpmd_opt %s -mpmd-recommend-num-microbatches='pipeline-schedule=ZeroBubbleH1' 2>&1 | FileCheck %s --check-prefix=SCHEDULE
+
+!m0_tensor = !mpmd.mesh_tensor<"m0", tensor<2x2xf32>>
+!m1_tensor = !mpmd.mesh_tensor<"m1", tensor<2x2xf32>>
+
+// With 1F1B, every fragment costs 1 and the pipeline takes 4 units of time for
+// 1 microbatch and 6 for 2, so each extra microbatch adds 2 to the makespan
+// and 4 to the busy time, i.e., the bubble ratio of m microbatches is
+// 1 / (m + 1).
+
+// CHECK:    remark: recommended number of microbatches: 6 (bubble ratio 0.143, makespan 14.00, max live activation bytes {{[0-9]+}}, extrapolated from 2 microbatches)
+// MAX:      warning: no number of microbatches up to 4 achieves a bubble ratio of at most 0.150, the lowest is with 4 microbatches (bubble ratio 0.200, makespan 10.00,
+// MEMORY:   warning: no number of microbatches fits in 8 bytes of live activations per mesh
+// SCHEDULE: error: pipeline schedule 'ZeroBubbleH1' doesn't totally order the fragments of each mesh and cannot be simulated
+func.func @main(%arg0: !m0_tensor, %arg1: !m0_tensor) -> (!m0_tensor, !m0_tensor)
+  attributes {topology = #mpmd.topology<<"m0" : <["x"=1]>>, <"m1" : <["x"=1]>>>} {
+  %f0_0 = mpmd.fragment<mesh="m0", origin=["f0"]> (%arg0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m0_tensor) -> !m0_tensor
+  %t0 = mpmd.transfer %f0_0 : (!m0_tensor) -> !m1_tensor
+  %f1_0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%t0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %b1_0 = mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%f1_0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %u0 = mpmd.transfer %b1_0 : (!m1_tensor) -> !m0_tensor
+  %b0_0 = mpmd.fragment<mesh="m0", origin=["f0"(1)]> (%u0, %f0_0) {call_counter = 0 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>, %arg3: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m0_tensor, !m0_tensor) -> !m0_tensor
+
+  %f0_1 = mpmd.fragment<mesh="m0", origin=["f0"]> (%arg1) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m0_tensor) -> !m0_tensor
+  %t1 = mpmd.transfer %f0_1 : (!m0_tensor) -> !m1_tensor
+  %f1_1 = mpmd.fragment<mesh="m1", origin=["f1"]> (%t1) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %b1_1 = mpmd.fragment<mesh="m1", origin=["f1"(1)]> (%f1_1) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m1_tensor) -> !m1_tensor
+  %u1 = mpmd.transfer %b1_1 : (!m1_tensor) -> !m0_tensor
+  %b0_1 = mpmd.fragment<mesh="m0", origin=["f0"(1)]> (%u1, %f0_1) {call_counter = 1 : ui32, mpmd.fragment_cost = 1.0 : f64} (%arg2: tensor<2x2xf32>, %arg3: tensor<2x2xf32>) {
+    mpmd.return %arg2 : tensor<2x2xf32>
+  } : (!m0_tensor, !m0_tensor) -> !m0_tensor
+  func.return %b0_0, %b0_1 : !m0_tensor, !m0_tensor
+}
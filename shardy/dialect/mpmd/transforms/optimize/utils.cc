@@ -19,12 +19,16 @@ limitations under the License.
 #include <iterator>
 #include <optional>
 #include <string>
+#include <utility>
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Operation.h"
@@ -168,6 +172,110 @@ void RemoveAllControlDependencies(func::FuncOp func_op) {
   });
 }
 
+FragmentInfoCache::FragmentInfoCache(Operation* op) {
+  auto func_op = cast<func::FuncOp>(op);
+  if (IsMpmdFunction(func_op)) {
+    for (auto [index, mesh] :
+         llvm::enumerate(GetSchedulableMeshes(func_op))) {
+      mesh_name_to_index_[mesh.getName()] = index;
+    }
+  }
+  for (FragmentOp fragment : func_op.getOps<FragmentOp>()) {
+    Insert(fragment);
+  }
+}
+
+int FragmentInfoCache::GetId(FragmentOp fragment) {
+  if (auto it = fragment_to_id_.find(fragment); it != fragment_to_id_.end()) {
+    return it->second;
+  }
+  return Insert(fragment);
+}
+
+void FragmentInfoCache::Erase(FragmentOp fragment) {
+  fragment_to_id_.erase(fragment);
+}
+
+void FragmentInfoCache::Update(FragmentOp fragment) {
+  Erase(fragment);
+  Insert(fragment);
+}
+
+int FragmentInfoCache::Insert(FragmentOp fragment) {
+  int id = infos_.size();
+  fragment_to_id_[fragment] = id;
+  infos_.push_back(GetFragmentInfo(fragment));
+  mesh_names_.push_back(fragment.getMeshName());
+  transpose_counts_.push_back(TryToFindSingleTransposeCount(fragment));
+  auto mesh_it = mesh_name_to_index_.find(fragment.getMeshName());
+  mesh_indices_.push_back(
+      mesh_it == mesh_name_to_index_.end() ? -1 : mesh_it->second);
+  is_scheduling_unit_.push_back(::mlir::mpmd::IsSchedulingUnit(fragment));
+  return id;
+}
+
+FragmentReachability::FragmentReachability(ArrayRef<FragmentOp> fragments) {
+  if (fragments.empty()) {
+    return;
+  }
+  Block* block = fragments.front()->getBlock();
+  int num_fragments = fragments.size();
+  for (auto [index, fragment] : llvm::enumerate(fragments)) {
+    SDY_CHECK(fragment->getBlock() == block);
+    fragment_to_index_[fragment] = index;
+  }
+
+  DenseMap<Operation*, llvm::BitVector> op_to_dependencies;
+  for (Operation& op : *block) {
+    llvm::BitVector dependencies(num_fragments);
+    op.walk([&](Operation* nested_op) {
+      for (Value operand : nested_op->getOperands()) {
+        Operation* def_op = operand.getDefiningOp();
+        if (!def_op) {
+          continue;
+        }
+        Operation* def_ancestor = block->findAncestorOpInBlock(*def_op);
+        // Skip values defined outside the block, or within `op` itself.
+        if (!def_ancestor || def_ancestor == &op) {
+          continue;
+        }
+        if (auto it = op_to_dependencies.find(def_ancestor);
+            it != op_to_dependencies.end()) {
+          dependencies |= it->second;
+        }
+      }
+    });
+    if (auto it = fragment_to_index_.find(&op);
+        it != fragment_to_index_.end()) {
+      dependencies.set(it->second);
+    }
+    if (dependencies.any()) {
+      op_to_dependencies[&op] = std::move(dependencies);
+    }
+  }
+
+  dependencies_.reserve(num_fragments);
+  for (FragmentOp fragment : fragments) {
+    dependencies_.push_back(std::move(op_to_dependencies[fragment]));
+  }
+}
+
+bool FragmentReachability::HasDependency(FragmentOp src, FragmentOp tgt) const {
+  return dependencies_[fragment_to_index_.at(tgt)].test(
+      fragment_to_index_.at(src));
+}
+
+void FragmentReachability::RecordDependency(FragmentOp src, FragmentOp tgt) {
+  int tgt_index = fragment_to_index_.at(tgt);
+  // Copy, as `src` may itself depend on `tgt` and be updated below.
+  llvm::BitVector src_dependencies = dependencies_[fragment_to_index_.at(src)];
+  for (llvm::BitVector& dependencies : dependencies_) {
+    if (dependencies.test(tgt_index)) {
+      dependencies |= src_dependencies;
+    }
+  }
+}
+
 namespace {
 
 // Visits all users in a depth-first, pre-order way, starting from current,
@@ -16,9 +16,16 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_UTILS_H_
 #define SHARDY_DIALECT_MPMD_TRANSFORMS_OPTIMIZE_UTILS_H_
 
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <vector>
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/Support/LLVM.h"
@@ -61,6 +68,71 @@ int GetMeshIndex(FragmentOp fragment);
 // it has a call_counter and a single transpose_count which is 0 or 1.
 bool IsSchedulingUnit(FragmentOp fragment);
 
+// A per-function analysis that caches the `FragmentInfo` of each fragment, and
+// the pipeline specific metadata derived from its attributes, e.g., its
+// transpose count or mesh index, in flat arrays indexed by a fragment id.
+//
+// This avoids re-parsing the attributes of fragments in the inner loops of the
+// scheduling and merging passes. Passes that use this analysis and create or
+// erase fragments, or change their attributes, must keep it up to date with
+// `Erase` and `Update` in order to preserve it. Note that a fragment that is
+// erased without calling `Erase` leaves a stale entry behind, which may be
+// picked up by a new op allocated at the same address, so passes that cannot
+// track all such changes must not preserve this analysis.
+class FragmentInfoCache {
+ public:
+  // Caches the info of all fragments in the body of `op`, which must be a
+  // function. Mesh indices are only defined if it is an MPMD function.
+  explicit FragmentInfoCache(Operation* op);
+
+  // Returns the id of `fragment`, computing and caching its info if it isn't
+  // cached yet.
+  int GetId(FragmentOp fragment);
+
+  const FragmentInfo& GetInfo(int id) const { return infos_[id]; }
+
+  // The returned name is owned by the context, so it outlives the cache.
+  StringRef GetMeshName(int id) const { return mesh_names_[id]; }
+
+  std::optional<int> GetCallCounter(int id) const {
+    return infos_[id].call_counter;
+  }
+
+  // Returns the single transpose count of the fragment, if it has one, see
+  // `TryToFindSingleTransposeCount`.
+  std::optional<int64_t> GetTransposeCount(int id) const {
+    return transpose_counts_[id];
+  }
+
+  bool IsSchedulingUnit(int id) const { return is_scheduling_unit_[id]; }
+
+  // Returns the index of the mesh of the fragment in the pipeline, see
+  // `GetMeshIndex`, or -1 if it isn't a schedulable mesh.
+  int GetMeshIndex(int id) const { return mesh_indices_[id]; }
+
+  // Returns the number of meshes in the pipeline, see `GetNumMeshes`.
+  int GetNumMeshes() const { return mesh_name_to_index_.size(); }
+
+  // Removes `fragment` from the cache, e.g., before it is erased.
+  void Erase(FragmentOp fragment);
+
+  // Recomputes the info of `fragment`, e.g., after it was created or its
+  // attributes were changed.
+  void Update(FragmentOp fragment);
+
+ private:
+  // Computes the info of `fragment` and returns its new id.
+  int Insert(FragmentOp fragment);
+
+  llvm::DenseMap<Operation*, int> fragment_to_id_;
+  llvm::StringMap<int> mesh_name_to_index_;
+  std::vector<FragmentInfo> infos_;
+  SmallVector<StringRef> mesh_names_;
+  SmallVector<std::optional<int64_t>> transpose_counts_;
+  SmallVector<int> mesh_indices_;
+  llvm::BitVector is_scheduling_unit_;
+};
+
 // Does `tgt_op` have (conservatively) any dataflow dependency on `src_op`?
 // Precondition: `tgt_op` and `src_op` must be in the same block.
 
@@ -76,6 +148,41 @@ bool IsSchedulingUnit(FragmentOp fragment);
 std::optional<SmallVector<Operation*>> GetDependencyPath(Operation* src_op,
                                                          Operation* tgt_op);
 
+// Precomputed transitive dataflow dependencies between a set of fragments in
+// the same block, so that checking whether one fragment depends on another,
+// like `GetDependencyPath` does, takes constant time.
+//
+// The dependencies are computed once, in a single pass over the block in
+// order, by keeping for each op the set of fragments it (transitively) depends
+// on as a bit vector. Dependencies through ops that aren't in the set of
+// fragments, e.g., transfers, and through ops nested in the regions of ops in
+// the block are taken into account.
+//
+// Control dependencies added after construction must be recorded with
+// `RecordDependency` to keep the dependencies up to date.
+class FragmentReachability {
+ public:
+  // Precondition: all `fragments` must be in the same block.
+  explicit FragmentReachability(ArrayRef<FragmentOp> fragments);
+
+  // Returns true if `tgt` (transitively) depends on `src`.
+  //
+  // Precondition: `src` and `tgt` must be in the set of fragments this was
+  // constructed with.
+  bool HasDependency(FragmentOp src, FragmentOp tgt) const;
+
+  // Records that `tgt` depends on `src`, e.g., after adding a control
+  // dependency between them, which makes every fragment that depends on `tgt`
+  // depend on everything `src` depends on.
+  void RecordDependency(FragmentOp src, FragmentOp tgt);
+
+ private:
+  llvm::DenseMap<Operation*, int> fragment_to_index_;
+  // The i-th bit vector holds the fragments the i-th fragment depends on,
+  // including itself.
+  SmallVector<llvm::BitVector> dependencies_;
+};
+
 // Adds a control dependency in the graph so that `fragment2` depends on
 // `fragment1`. This is done by inserting fragment1's result as a operand of
 // fragment2. We call these temporary operands "control operands".
@@ -22,6 +22,7 @@ limitations under the License.
 
 #include "llvm/ADT/StringRef.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/MLIRContext.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "mlir/Support/LLVM.h"
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/fragment_execution_rules.h"
 #include "shardy/dialect/mpmd/ir/register.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
 #include "shardy/dialect/mpmd/transforms/common/testing_utils.h"
@@ -725,5 +727,123 @@ TEST(RemoveAllControlDependencies, NoControlDependencies) {
   EXPECT_FALSE(frag1->hasAttr(kControlOperandStartIdxAttrName));
 }
 
+TEST(FragmentReachability, DependenciesThroughTransfersAndControlOperands) {
+  const char kProgram[] = R"mlir(
+    !mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+    !mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+    func.func @main(%arg0: !mesh_1_tensor)
+      -> (!mesh_2_tensor, !mesh_1_tensor) attributes {
+        "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+      %0 = mpmd.fragment<mesh="m1", origin=["f1"(0)]> (%arg0)
+           (%arg1: tensor<4x8xf32>) {
+        mpmd.return %arg1 : tensor<4x8xf32>
+      } : (!mesh_1_tensor) -> !mesh_1_tensor
+      %1 = mpmd.transfer %0 : (!mesh_1_tensor) -> !mesh_2_tensor
+      %2 = mpmd.fragment<mesh="m2", origin=["f2"(0)]> (%1)
+           (%arg1: tensor<4x8xf32>) {
+        mpmd.return %arg1 : tensor<4x8xf32>
+      } : (!mesh_2_tensor) -> !mesh_2_tensor
+      %3 = mpmd.fragment<mesh="m1", origin=["f3"(0)]> (%arg0)
+           (%arg1: tensor<4x8xf32>) {
+        mpmd.return %arg1 : tensor<4x8xf32>
+      } : (!mesh_1_tensor) -> !mesh_1_tensor
+      return %2, %3 : !mesh_2_tensor, !mesh_1_tensor
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  FuncOp func_op = GetMainFunction(*module);
+
+  SmallVector<FragmentOp> fragments(func_op.getOps<FragmentOp>());
+  ASSERT_EQ(fragments.size(), 3);
+  FragmentOp frag0 = fragments[0];
+  FragmentOp frag1 = fragments[1];
+  FragmentOp frag2 = fragments[2];
+
+  FragmentReachability reachability(fragments);
+  EXPECT_TRUE(reachability.HasDependency(frag0, frag0));
+  EXPECT_TRUE(reachability.HasDependency(frag0, frag1));
+  EXPECT_FALSE(reachability.HasDependency(frag1, frag0));
+  EXPECT_FALSE(reachability.HasDependency(frag0, frag2));
+  EXPECT_FALSE(reachability.HasDependency(frag2, frag0));
+  EXPECT_FALSE(reachability.HasDependency(frag1, frag2));
+
+  // frag1 -> frag2 makes frag2 depend on frag0 as well.
+  AddControlDependency(frag1, frag2);
+  reachability.RecordDependency(frag1, frag2);
+  EXPECT_TRUE(reachability.HasDependency(frag1, frag2));
+  EXPECT_TRUE(reachability.HasDependency(frag0, frag2));
+  EXPECT_FALSE(reachability.HasDependency(frag2, frag0));
+  EXPECT_FALSE(reachability.HasDependency(frag2, frag1));
+
+  // A reachability built after adding the control dependency sees it too.
+  FragmentReachability rebuilt_reachability(fragments);
+  EXPECT_TRUE(rebuilt_reachability.HasDependency(frag0, frag2));
+  EXPECT_TRUE(rebuilt_reachability.HasDependency(frag1, frag2));
+  EXPECT_FALSE(rebuilt_reachability.HasDependency(frag2, frag1));
+}
+
+TEST(FragmentInfoCache, CachesFragmentInfo) {
+  const char kProgram[] = R"mlir(
+    !mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+    !mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+    func.func @main(%arg0: !mesh_1_tensor, %arg1: !mesh_2_tensor)
+      -> (!mesh_1_tensor, !mesh_2_tensor) attributes {
+        "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+      %0 = mpmd.fragment<mesh="m1", origin=["f1"]> (%arg0)
+           {call_counter = 3 : ui32} (%arg2: tensor<4x8xf32>) {
+        mpmd.return %arg2 : tensor<4x8xf32>
+      } : (!mesh_1_tensor) -> !mesh_1_tensor
+      %1 = mpmd.fragment<mesh="m2", origin=["f1"(1)]> (%arg1)
+           (%arg2: tensor<4x8xf32>) {
+        mpmd.return %arg2 : tensor<4x8xf32>
+      } : (!mesh_2_tensor) -> !mesh_2_tensor
+      return %0, %1 : !mesh_1_tensor, !mesh_2_tensor
+    }
+  )mlir";
+
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(kProgram, &context);
+  FuncOp func_op = GetMainFunction(*module);
+
+  SmallVector<FragmentOp> fragments(func_op.getOps<FragmentOp>());
+  ASSERT_EQ(fragments.size(), 2);
+
+  FragmentInfoCache info_cache(func_op);
+  EXPECT_EQ(info_cache.GetNumMeshes(), 2);
+
+  int id0 = info_cache.GetId(fragments[0]);
+  EXPECT_EQ(info_cache.GetId(fragments[0]), id0);
+  EXPECT_EQ(info_cache.GetInfo(id0), GetFragmentInfo(fragments[0]));
+  EXPECT_EQ(info_cache.GetMeshName(id0), "m1");
+  EXPECT_EQ(info_cache.GetMeshIndex(id0), 0);
+  EXPECT_EQ(info_cache.GetCallCounter(id0), 3);
+  EXPECT_EQ(info_cache.GetTransposeCount(id0), 0);
+  EXPECT_TRUE(info_cache.IsSchedulingUnit(id0));
+
+  int id1 = info_cache.GetId(fragments[1]);
+  EXPECT_NE(id0, id1);
+  EXPECT_EQ(info_cache.GetMeshName(id1), "m2");
+  EXPECT_EQ(info_cache.GetMeshIndex(id1), 1);
+  EXPECT_EQ(info_cache.GetCallCounter(id1), std::nullopt);
+  EXPECT_EQ(info_cache.GetTransposeCount(id1), 1);
+  // Not a scheduling unit, as it has no call counter.
+  EXPECT_FALSE(info_cache.IsSchedulingUnit(id1));
+
+  // Updating a fragment recomputes its info under a new id.
+  fragments[1]->setAttr(kCallCounterAttrName,
+                        Builder(&context).getUI32IntegerAttr(5));
+  info_cache.Update(fragments[1]);
+  int updated_id1 = info_cache.GetId(fragments[1]);
+  EXPECT_NE(updated_id1, id1);
+  EXPECT_EQ(info_cache.GetCallCounter(updated_id1), 5);
+  EXPECT_TRUE(info_cache.IsSchedulingUnit(updated_id1));
+}
+
 }  // namespace
 }  // namespace mlir::mpmd
@@ -0,0 +1,268 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <optional>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Types.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/sharding_propagation/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "stablehlo/dialect/StablehloOps.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_COMPRESSINTERMESHTRANSFERSPASS
+#include "shardy/dialect/mpmd/transforms/sharding_propagation/passes.h.inc"
+
+namespace {
+
+using ::mlir::func::FuncOp;
+using ::mlir::sdy::TensorShardingAttr;
+
+// Returns `type` with its element type replaced by `element_type`.
+MeshTensorType WithElementType(MeshTensorType type, Type element_type) {
+  return MeshTensorType::get(type.getContext(), type.getMeshName(),
+                             type.getRankedTensorType().clone(element_type),
+                             type.getSharding(), type.getMemoryKind());
+}
+
+// Returns the float type named `name`, or null if it isn't a supported
+// compression type.
+FloatType ParseCompressedElementType(StringRef name, MLIRContext* context) {
+  Builder builder(context);
+  if (name == "bf16") {
+    return builder.getBF16Type();
+  }
+  if (name == "f16") {
+    return builder.getF16Type();
+  }
+  if (name == "f8E4M3FN") {
+    return Float8E4M3FNType::get(context);
+  }
+  if (name == "f8E5M2") {
+    return Float8E5M2Type::get(context);
+  }
+  return nullptr;
+}
+
+// Returns a value on the source mesh of `transfer` with its operand cast to
+// `element_type`. The cast is added to the fragment producing the operand if
+// the transfer is its only user, so that it fuses with the producer, or to a
+// new fragment otherwise, e.g., if the operand is a function argument.
+Value CompressAtProducerSite(TransferOp transfer, FloatType element_type,
+                             RewriterBase& rewriter) {
+  Value value = transfer.getTensor();
+  MeshTensorType compressed_type =
+      WithElementType(transfer.getTensor().getType(), element_type);
+  TensorShardingAttr sharding = sdy::getSharding(value);
+
+  if (auto producer = dyn_cast_or_null<FragmentOp>(value.getDefiningOp());
+      producer && value.hasOneUse()) {
+    // %v = fragment {... return %x} -> <M, f32>
+    // %t = transfer (%v) : (<M, f32>) -> <M', f32>
+    //   ~>
+    // %v = fragment {... %c = convert %x ; return %c} -> <M, bf16>
+    // %t = transfer (%v) : (<M, bf16>) -> <M', bf16>
+    Operation* terminator = producer.getBody()->getTerminator();
+    OpOperand& returned =
+        terminator->getOpOperand(cast<OpResult>(value).getResultNumber());
+    rewriter.setInsertionPoint(terminator);
+    auto convert = stablehlo::ConvertOp::create(
+        rewriter, returned.get().getLoc(),
+        compressed_type.getGlobalTensorType(), returned.get());
+    if (sharding) {
+      sdy::setSharding(convert.getResult(), sharding);
+    }
+    rewriter.modifyOpInPlace(terminator, [&]() { returned.set(convert); });
+    value.setType(compressed_type);
+    return value;
+  }
+
+  rewriter.setInsertionPoint(transfer);
+  FragmentOp compress = FragmentOp::createMeshFragmentWithGlobalBody(
+      value.getLoc(), /*user_origin=*/{}, compressed_type.getMeshName(), value,
+      compressed_type, rewriter,
+      [&](ArrayRef<Value> args, OpBuilder& builder) -> SmallVector<Value> {
+        return {stablehlo::ConvertOp::create(
+            builder, value.getLoc(), compressed_type.getGlobalTensorType(),
+            args.front())};
+      });
+  SetInferredByAttr(compress, "compress_transfers", rewriter);
+  compress.setUserSpecifiedResultSharding(0, sharding);
+  return compress.getResult(0);
+}
+
+// Casts `compressed`, a transfer result, back to `element_type` at each of its
+// users. The cast is added to the body of fragment users, so that it fuses
+// with the consumer, and to a new fragment for the other users, e.g., the
+// terminator of the function.
+void DecompressAtConsumerSite(Value compressed, Type element_type,
+                              RewriterBase& rewriter) {
+  auto compressed_type = cast<MeshTensorType>(compressed.getType());
+  MeshTensorType type = WithElementType(compressed_type, element_type);
+  TensorShardingAttr sharding = sdy::getSharding(compressed);
+
+  bool has_non_fragment_user = false;
+  for (OpOperand& use : llvm::make_early_inc_range(compressed.getUses())) {
+    auto consumer = dyn_cast<FragmentOp>(use.getOwner());
+    if (!consumer) {
+      has_non_fragment_user = true;
+      continue;
+    }
+    BlockArgument arg =
+        consumer.getBody()->getArgument(use.getOperandNumber());
+    arg.setType(compressed_type.getGlobalTensorType());
+    rewriter.setInsertionPointToStart(consumer.getBody());
+    auto convert = stablehlo::ConvertOp::create(
+        rewriter, arg.getLoc(), type.getGlobalTensorType(), arg);
+    if (sharding) {
+      sdy::setSharding(convert.getResult(), sharding);
+    }
+    rewriter.replaceAllUsesExcept(arg, convert, convert);
+  }
+
+  if (!has_non_fragment_user) {
+    return;
+  }
+  rewriter.setInsertionPointAfterValue(compressed);
+  FragmentOp decompress = FragmentOp::createMeshFragmentWithGlobalBody(
+      compressed.getLoc(), /*user_origin=*/{}, type.getMeshName(), compressed,
+      type, rewriter,
+      [&](ArrayRef<Value> args, OpBuilder& builder) -> SmallVector<Value> {
+        return {stablehlo::ConvertOp::create(builder, compressed.getLoc(),
+                                             type.getGlobalTensorType(),
+                                             args.front())};
+      });
+  SetInferredByAttr(decompress, "compress_transfers", rewriter);
+  decompress.setUserSpecifiedResultSharding(0, sharding);
+  rewriter.replaceUsesWithIf(
+      compressed, decompress.getResult(0), [](OpOperand& use) {
+        // Automatically excludes `decompress`.
+        return !isa<FragmentOp>(use.getOwner());
+      });
+}
+
+class CompressInterMeshTransfersPass
+    : public impl::CompressInterMeshTransfersPassBase<
+          CompressInterMeshTransfersPass> {
+  using CompressInterMeshTransfersPassBase::CompressInterMeshTransfersPassBase;
+
+ protected:
+  LogicalResult initialize(MLIRContext* context) final {
+    compressed_element_type_ =
+        ParseCompressedElementType(elementType, context);
+    if (!compressed_element_type_) {
+      return emitError(UnknownLoc::get(context))
+             << "Unsupported element type for transfer compression: '"
+             << StringRef(elementType) << "'. Expected one of bf16, f16, f8E4M3FN or "
+             << "f8E5M2.";
+    }
+    if (direction != "any" && direction != "forward" &&
+        direction != "backward") {
+      return emitError(UnknownLoc::get(context))
+             << "Unsupported transfer direction: '" << StringRef(direction)
+             << "'. Expected one of any, forward or backward.";
+    }
+    return success();
+  }
+
+  void runOnFunc(FuncOp func_op) final {
+    IRRewriter rewriter(&getContext());
+    func_op.walk([&](TransferOp transfer) {
+      if (!ShouldCompress(transfer)) {
+        return;
+      }
+      RankedTensorType global_type =
+          transfer.getTensor().getType().getGlobalTensorType();
+      Type element_type = global_type.getElementType();
+      Value compressed =
+          CompressAtProducerSite(transfer, compressed_element_type_, rewriter);
+      rewriter.modifyOpInPlace(transfer, [&]() {
+        transfer.getTensorMutable().assign(compressed);
+        transfer.getResult().setType(
+            WithElementType(transfer.getType(), compressed_element_type_));
+      });
+      DecompressAtConsumerSite(transfer.getResult(), element_type, rewriter);
+
+      ++numCompressedTransfers;
+      transferBytesSaved +=
+          GetSizeInBytes(global_type) -
+          GetSizeInBytes(global_type.clone(compressed_element_type_));
+    });
+  }
+
+ private:
+  // Returns true if `transfer` is a device-to-device transfer of floats wider
+  // than the compressed element type that matches the selector of the pass.
+  bool ShouldCompress(TransferOp transfer) {
+    MeshTensorType src_type = transfer.getTensor().getType();
+    if (src_type.isOnHost() || transfer.getType().isOnHost()) {
+      return false;
+    }
+    RankedTensorType global_type = src_type.getGlobalTensorType();
+    auto float_type = dyn_cast<FloatType>(global_type.getElementType());
+    if (!float_type ||
+        float_type.getWidth() <= compressed_element_type_.getWidth()) {
+      return false;
+    }
+    if (GetSizeInBytes(global_type) < minBytes) {
+      return false;
+    }
+
+    if (direction == "any" && origins.empty()) {
+      return true;
+    }
+    // Transfers of function arguments and of values produced by other
+    // transfers have no producer fragment to select them by.
+    auto producer =
+        dyn_cast_or_null<FragmentOp>(transfer.getTensor().getDefiningOp());
+    if (!producer) {
+      return false;
+    }
+    if (direction != "any") {
+      std::optional<int64_t> transpose_count =
+          TryToFindFragmentTransposeCount(producer);
+      if (!transpose_count ||
+          (*transpose_count == 0) != (direction == "forward")) {
+        return false;
+      }
+    }
+    return origins.empty() ||
+           llvm::any_of(producer.getOrigin().getAsRange<UserOriginAttr>(),
+                        [&](UserOriginAttr origin) {
+                          return llvm::is_contained(
+                              origins, origin.getUserName().getValue());
+                        });
+  }
+
+  FloatType compressed_element_type_;
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
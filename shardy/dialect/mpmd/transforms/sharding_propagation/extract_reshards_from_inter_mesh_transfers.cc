@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdint>
+#include <cstdlib>
+#include <optional>
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Threading.h"
@@ -59,37 +61,52 @@ RankedTensorType GetLocalTensorType(RankedTensorType global_type,
   return sharding.getLocalTensorType(global_type, mesh);
 }
 
-// Returns true if the resharding should be done at the producer site, i.e., if
-// the destination tensor is on host, or if the source tensor is not on host and
-// is smaller (after sharding) than the destination tensor.
-bool ReshardAtProducerSite(MeshTensorType src_mesh_type,
-                           MeshTensorType dst_mesh_type,
-                           TensorShardingAttr src_sharding_or_null,
-                           TensorShardingAttr dst_sharding_or_null,
-                           sdy::MeshAttr mesh) {
+// Where the resharding around an inter-mesh transfer is done, and how many
+// bytes per device the transfer saves compared to resharding at the other site.
+struct ReshardPlacement {
+  bool at_producer_site;
+  int64_t bytes_saved;
+};
+
+// Returns where the resharding should be done, so that the transfer carries the
+// smaller local tensor, i.e., at the producer site if the destination tensor is
+// smaller (after sharding) than the source tensor. For example, if the source
+// would need to all-gather before sending, the resharding is done at the
+// consumer site instead.
+//
+// If either tensor is on host, the resharding is done on the device, i.e., at
+// the producer site if the destination tensor is on host.
+ReshardPlacement GetReshardPlacement(MeshTensorType src_mesh_type,
+                                     MeshTensorType dst_mesh_type,
+                                     TensorShardingAttr src_sharding_or_null,
+                                     TensorShardingAttr dst_sharding_or_null,
+                                     sdy::MeshAttr mesh) {
   SDY_CHECK(!src_mesh_type.isOnHost() || !dst_mesh_type.isOnHost());
 
   if (dst_mesh_type.isOnHost()) {
-    return true;
+    return {/*at_producer_site=*/true, /*bytes_saved=*/0};
   }
 
   if (src_mesh_type.isOnHost()) {
-    return false;
+    return {/*at_producer_site=*/false, /*bytes_saved=*/0};
   }
 
-  int64_t src_num_elements =
-      GetLocalTensorType(src_mesh_type.getGlobalTensorType(),
-                         src_sharding_or_null, mesh)
-          .getNumElements();
-  int64_t dst_num_elements =
-      GetLocalTensorType(dst_mesh_type.getGlobalTensorType(),
-                         dst_sharding_or_null, mesh)
-          .getNumElements();
-  return src_num_elements > dst_num_elements;
+  RankedTensorType src_local_type = GetLocalTensorType(
+      src_mesh_type.getGlobalTensorType(), src_sharding_or_null, mesh);
+  RankedTensorType dst_local_type = GetLocalTensorType(
+      dst_mesh_type.getGlobalTensorType(), dst_sharding_or_null, mesh);
+  int64_t bytes_saved = std::abs(GetSizeInBytes(src_local_type) -
+                                 GetSizeInBytes(dst_local_type));
+  return {/*at_producer_site=*/src_local_type.getNumElements() >
+              dst_local_type.getNumElements(),
+          bytes_saved};
 }
 
-void HandleTransfer(TransferOp transfer, RewriterBase& rewriter,
-                    sdy::MeshAttr mesh) {
+// Moves the resharding of `transfer`, if any, to the producer or consumer site.
+// Returns where it was moved, or nullopt if the transfer doesn't reshard.
+std::optional<ReshardPlacement> HandleTransfer(TransferOp transfer,
+                                               RewriterBase& rewriter,
+                                               sdy::MeshAttr mesh) {
   auto src_mesh_type = transfer.getTensor().getType();
   auto dst_mesh_type = transfer.getType();
 
@@ -97,7 +114,7 @@ void HandleTransfer(TransferOp transfer, RewriterBase& rewriter,
   if (src_mesh_type.isOnHost() && dst_mesh_type.isOnHost()) {
     transfer->emitError()
         << "Resharding on host not supported with an mpmd.transfer.";
-    return;
+    return std::nullopt;
   }
 
   TensorShardingAttr src_sharding_or_null =
@@ -107,7 +124,7 @@ void HandleTransfer(TransferOp transfer, RewriterBase& rewriter,
 
   // No resharding.
   if (sdy::isEquivalent(src_sharding_or_null, dst_sharding_or_null)) {
-    return;
+    return std::nullopt;
   }
 
   // TODO: jupvfranco - the following two cases should have been supported
@@ -133,8 +150,10 @@ void HandleTransfer(TransferOp transfer, RewriterBase& rewriter,
                          OpBuilder&) -> llvm::SmallVector<Value> {
     return {args.front()};
   };
-  if (ReshardAtProducerSite(src_mesh_type, dst_mesh_type, src_sharding_or_null,
-                            dst_sharding_or_null, mesh)) {
+  ReshardPlacement placement =
+      GetReshardPlacement(src_mesh_type, dst_mesh_type, src_sharding_or_null,
+                          dst_sharding_or_null, mesh);
+  if (placement.at_producer_site) {
     // Reshard at producer-site because destination type is smaller than source
     // type. I.e.,
     //   %x = op : <M, D>
@@ -163,7 +182,7 @@ void HandleTransfer(TransferOp transfer, RewriterBase& rewriter,
       SetInferredByAttr(reshard, "extract_reshards", rewriter);
       reshard.setUserSpecifiedResultSharding(0, dst_sharding_or_null);
       operand.set(reshard.getResult(0));
-      return;
+      return placement;
     }
 
     // If the value is used by a terminator, we need to create a fragment to
@@ -191,7 +210,7 @@ void HandleTransfer(TransferOp transfer, RewriterBase& rewriter,
     SDY_CHECK(isa<FragmentOp>(value.getDefiningOp()));
     value.setType(new_operand_type);
     sdy::setSharding(value, dst_sharding_or_null);
-    return;
+    return placement;
   }
 
   // Reshard at consumer-site because source type is smaller than destination
@@ -241,6 +260,7 @@ void HandleTransfer(TransferOp transfer, RewriterBase& rewriter,
   SDY_CHECK(
       llvm::all_of(new_transfer.getResult().getUsers(),
                    [](Operation* user) { return isa<FragmentOp>(user); }));
+  return placement;
 }
 
 class ExtractReshardsFromInterMeshTransfersPass
@@ -265,8 +285,28 @@ class ExtractReshardsFromInterMeshTransfersPass
     // Assumes that the topology is homogeneous so we can just get the first
     // mesh.
     sdy::MeshAttr mesh = mpmd::GetTopologyMeshes(func_op).front().getMesh();
-    func_op.walk(
-        [&](TransferOp transfer) { HandleTransfer(transfer, rewriter, mesh); });
+    func_op.walk([&](TransferOp transfer) {
+      if (keepReshardingTransfers &&
+          !transfer.getTensor().getType().isOnHost() &&
+          !transfer.getType().isOnHost()) {
+        if (!sdy::isEquivalent(sdy::getSharding(transfer.getTensor()),
+                               sdy::getSharding(transfer.getResult()))) {
+          ++numReshardingTransfers;
+        }
+        return;
+      }
+      std::optional<ReshardPlacement> placement =
+          HandleTransfer(transfer, rewriter, mesh);
+      if (!placement) {
+        return;
+      }
+      if (placement->at_producer_site) {
+        ++numReshardsAtProducerSite;
+      } else {
+        ++numReshardsAtConsumerSite;
+      }
+      transferBytesSaved += placement->bytes_saved;
+    });
   }
 };
 
@@ -19,6 +19,7 @@ limitations under the License.
 // IWYU pragma: begin_keep
 
 #include <memory>
+#include <optional>
 
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Pass/Pass.h"
@@ -41,7 +42,24 @@ namespace mlir::mpmd {
 //
 // `sdyDumpDir` specified the dump directory to pass to the SDY propagation
 // pipeline.
-void addShardingPropagationPipeline(OpPassManager& pm, StringRef sdyDumpDir);
+//
+// If `unifyEquivalentFragmentShardings`, fragments with the same body and
+// boundary shardings, e.g., the copies of a stage for each microbatch, are
+// given the same internal shardings after propagation, so that they can share
+// an executable. See `UnifyEquivalentFragmentShardingsPass`.
+//
+// If `keepReshardingTransfers`, device-to-device transfers between different
+// shardings are kept as resharding transfers, instead of resharding on either
+// mesh. See `ExtractReshardsFromInterMeshTransfersPass`.
+//
+// If `compressTransfersOptions` is set, the selected inter-mesh transfers are
+// done at a reduced precision. See `CompressInterMeshTransfersPass`.
+void addShardingPropagationPipeline(
+    OpPassManager& pm, StringRef sdyDumpDir,
+    bool unifyEquivalentFragmentShardings = false,
+    bool keepReshardingTransfers = false,
+    std::optional<CompressInterMeshTransfersPassOptions>
+        compressTransfersOptions = std::nullopt);
 
 // Register the `-mpmd-sharding-propagation-pipeline`.
 void registerShardingPropagationPipeline();
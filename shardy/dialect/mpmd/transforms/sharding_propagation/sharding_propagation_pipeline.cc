@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <optional>
+#include <utility>
+
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Pass/PassRegistry.h"
@@ -25,8 +28,11 @@ limitations under the License.
 
 namespace mlir::mpmd {
 
-void addShardingPropagationPipeline(OpPassManager& pm,
-                                    llvm::StringRef sdyDumpDir) {
+void addShardingPropagationPipeline(
+    OpPassManager& pm, llvm::StringRef sdyDumpDir,
+    bool unifyEquivalentFragmentShardings, bool keepReshardingTransfers,
+    std::optional<CompressInterMeshTransfersPassOptions>
+        compressTransfersOptions) {
   // Uniquify function inputs and outputs, in case the same fragment result or
   // function input is returned multiple times with different shardings.
   UniquifyFunctionInputsOutputsPassOptions uniquifyOptions;
@@ -40,6 +46,11 @@ void addShardingPropagationPipeline(OpPassManager& pm,
   options.avoidExportForPartitioning = true;
   sdy::addPropagationPipeline(pm, options);
 
+  if (unifyEquivalentFragmentShardings) {
+    pm.addNestedPass<func::FuncOp>(
+        createUnifyEquivalentFragmentShardingsPass());
+  }
+
   // Populate unreduced out_shardings. This is needed because SDY propagation
   // does not populate the out_shardings for unreduced axes (as it is
   // technically not responsible for propagating unreduced axes), only the in
@@ -51,7 +62,16 @@ void addShardingPropagationPipeline(OpPassManager& pm,
 
   // Extract reshard from inter-mesh transfers.
   pm.addNestedPass<func::FuncOp>(
-      createExtractReshardsFromInterMeshTransfersPass());
+      createExtractReshardsFromInterMeshTransfersPass(
+          ExtractReshardsFromInterMeshTransfersPassOptions{
+              keepReshardingTransfers}));
+
+  // Compress the selected inter-mesh transfers, now that their producers and
+  // consumers have the same sharding, so the casts are added to fragments.
+  if (compressTransfersOptions) {
+    pm.addNestedPass<func::FuncOp>(createCompressInterMeshTransfersPass(
+        std::move(*compressTransfersOptions)));
+  }
 
   // Add the shardings back to `MeshTensorType`. Before this pass, the shardings
   // are on the attributes of fragments and transfer ops.
@@ -64,10 +84,10 @@ void addShardingPropagationPipeline(OpPassManager& pm,
 
   // Try folding/optimizing to minimize the number of tensors passed across
   // fragments. This is applied here so that later passes like
-  // mpmd-fragment-dce and mpmd-simplify-program can remove unnecessary ops.
+  // mpmd-minimize-fragment-signatures can remove unnecessary ops.
   pm.addNestedPass<func::FuncOp>(
       stablehlo::createStablehloTargetIndependentOptimizationPass());
-  pm.addNestedPass<func::FuncOp>(createSimplifyProgramPass());
+  pm.addNestedPass<func::FuncOp>(createMinimizeFragmentSignaturesPass());
 }
 
 void registerShardingPropagationPipeline() {
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <optional>
 #include <utility>
 
 #include "llvm/ADT/StringRef.h"
@@ -29,8 +30,11 @@ limitations under the License.
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/fragment_arg_res_attrs.h"
 #include "shardy/dialect/mpmd/transforms/common/simplify_region_op_base.h"
+#include "shardy/dialect/mpmd/transforms/common/utils.h"
 #include "shardy/dialect/mpmd/transforms/sharding_propagation/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/sdy/ir/dialect.h"
 
 namespace mlir::mpmd {
 
@@ -68,6 +72,22 @@ class SimplifyFragmentPattern : public SimplifyRegionOpPatternBase<FragmentOp> {
     }
     return newOp;
   }
+
+  void eraseOperands(FragmentOp op,
+                     const BitVector& erased_operands) const override {
+    if (std::optional<sdy::TensorShardingPerValueAttr> in_shardings =
+            op.getInShardings()) {
+      op.setInShardingsAttr(sdy::TensorShardingPerValueAttr::get(
+          op.getContext(),
+          FilterRange<sdy::TensorShardingAttr>(in_shardings->getShardings(),
+                                               erased_operands)));
+    }
+    if (op->hasAttr(kArgAttrName)) {
+      SetArgAttrs(op, FilterRange<Attribute>(GetArgAttrsOrCreateDefault(op),
+                                             erased_operands));
+    }
+    op->eraseOperands(erased_operands);
+  }
 };
 
 class SimplifyProgramPass
@@ -0,0 +1,80 @@
+// RUN: mpmd_opt %s -mpmd-compress-inter-mesh-transfers='min-bytes=128' 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-compress-inter-mesh-transfers='direction=backward' 2>&1 | FileCheck %s --check-prefix=BWD
+
+!m1_f32 = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!m2_f32 = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+// CHECK-LABEL: func @casts_fuse_into_producer_and_consumer
+// BWD-LABEL:   func @casts_fuse_into_producer_and_consumer
+func.func @casts_fuse_into_producer_and_consumer(%arg0: !m1_f32) -> !m2_f32 attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // CHECK-NEXT: %[[PRODUCER:.*]] = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+  // CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+  // CHECK-NEXT:   %[[CONVERT:.*]] = stablehlo.convert %[[ADD]] : (tensor<4x8xf32>) -> tensor<4x8xbf16>
+  // CHECK-NEXT:   mpmd.return %[[CONVERT]] : tensor<4x8xbf16>
+  // CHECK-NEXT: } : (!mpmd.mesh_tensor<"m1", tensor<4x8xf32>>) -> !mpmd.mesh_tensor<"m1", tensor<4x8xbf16>>
+  // CHECK-NEXT: %[[TRANSFER:.*]] = mpmd.transfer %[[PRODUCER]] : (!mpmd.mesh_tensor<"m1", tensor<4x8xbf16>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xbf16>>
+  // CHECK-NEXT: mpmd.fragment<mesh="m2", origin=["g"]> (%[[TRANSFER]]) (%arg1: tensor<4x8xbf16>) {
+  // CHECK-NEXT:   %[[CONVERT_BACK:.*]] = stablehlo.convert %arg1 : (tensor<4x8xbf16>) -> tensor<4x8xf32>
+  // CHECK-NEXT:   %[[MUL:.*]] = stablehlo.multiply %[[CONVERT_BACK]], %[[CONVERT_BACK]] : tensor<4x8xf32>
+  // CHECK-NEXT:   mpmd.return %[[MUL]] : tensor<4x8xf32>
+  // CHECK-NEXT: } : (!mpmd.mesh_tensor<"m2", tensor<4x8xbf16>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+  // The producer is a forward fragment.
+  // BWD-NOT: stablehlo.convert
+  %0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    %2 = stablehlo.add %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %2 : tensor<4x8xf32>
+  } : (!m1_f32) -> !m1_f32
+  %1 = mpmd.transfer %0 : (!m1_f32) -> !m2_f32
+  %3 = mpmd.fragment<mesh="m2", origin=["g"]> (%1) (%arg1: tensor<4x8xf32>) {
+    %2 = stablehlo.multiply %arg1, %arg1 : tensor<4x8xf32>
+    mpmd.return %2 : tensor<4x8xf32>
+  } : (!m2_f32) -> !m2_f32
+  func.return %3 : !m2_f32
+}
+
+// CHECK-LABEL: func @casts_in_new_fragments
+// BWD-LABEL:   func @casts_in_new_fragments
+func.func @casts_in_new_fragments(%arg0: !m1_f32) -> !m2_f32 attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // CHECK-NEXT: %[[COMPRESS:.*]] = mpmd.fragment<mesh="m1", origin=[]> (%arg0) {mpmd.inferred_by = ["compress_transfers"]} (%arg1: tensor<4x8xf32>) {
+  // CHECK-NEXT:   %[[CONVERT:.*]] = stablehlo.convert %arg1 : (tensor<4x8xf32>) -> tensor<4x8xbf16>
+  // CHECK-NEXT:   mpmd.return %[[CONVERT]] : tensor<4x8xbf16>
+  // CHECK-NEXT: } : (!mpmd.mesh_tensor<"m1", tensor<4x8xf32>>) -> !mpmd.mesh_tensor<"m1", tensor<4x8xbf16>>
+  // CHECK-NEXT: %[[TRANSFER:.*]] = mpmd.transfer %[[COMPRESS]] : (!mpmd.mesh_tensor<"m1", tensor<4x8xbf16>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xbf16>>
+  // CHECK-NEXT: %[[DECOMPRESS:.*]] = mpmd.fragment<mesh="m2", origin=[]> (%[[TRANSFER]]) {mpmd.inferred_by = ["compress_transfers"]} (%arg1: tensor<4x8xbf16>) {
+  // CHECK-NEXT:   %[[CONVERT_BACK:.*]] = stablehlo.convert %arg1 : (tensor<4x8xbf16>) -> tensor<4x8xf32>
+  // CHECK-NEXT:   mpmd.return %[[CONVERT_BACK]] : tensor<4x8xf32>
+  // CHECK-NEXT: } : (!mpmd.mesh_tensor<"m2", tensor<4x8xbf16>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+  // CHECK-NEXT: return %[[DECOMPRESS]]
+  // There is no producer fragment to select the transfer by.
+  // BWD-NOT: stablehlo.convert
+  %0 = mpmd.transfer %arg0 : (!m1_f32) -> !m2_f32
+  func.return %0 : !m2_f32
+}
+
+// CHECK-LABEL: func @backward_transfer
+// BWD-LABEL:   func @backward_transfer
+func.func @backward_transfer(%arg0: !m1_f32) -> !m2_f32 attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // CHECK: stablehlo.convert
+  // BWD:   stablehlo.convert {{.*}} -> tensor<4x8xbf16>
+  // BWD:   mpmd.transfer {{.*}} -> !mpmd.mesh_tensor<"m2", tensor<4x8xbf16>>
+  %0 = mpmd.fragment<mesh="m1", origin=["f"(1)]> (%arg0) (%arg1: tensor<4x8xf32>) {
+    mpmd.return %arg1 : tensor<4x8xf32>
+  } : (!m1_f32) -> !m1_f32
+  %1 = mpmd.transfer %0 : (!m1_f32) -> !m2_f32
+  func.return %1 : !m2_f32
+}
+
+// CHECK-LABEL: func @not_compressed
+func.func @not_compressed(%arg0: !mpmd.mesh_tensor<"m1", tensor<4x8xui32>>, %arg1: !mpmd.mesh_tensor<"m1", tensor<4x4xf32>>)
+  -> (!mpmd.mesh_tensor<"m2", tensor<4x8xui32>>, !mpmd.mesh_tensor<"m2", tensor<4x4xf32>>) attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>} {
+  // Integers are never compressed, and the f32 tensor is below `min-bytes`.
+  // CHECK-NEXT: mpmd.transfer %arg0 : (!mpmd.mesh_tensor<"m1", tensor<4x8xui32>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>
+  // CHECK-NEXT: mpmd.transfer %arg1 : (!mpmd.mesh_tensor<"m1", tensor<4x4xf32>>) -> !mpmd.mesh_tensor<"m2", tensor<4x4xf32>>
+  %0 = mpmd.transfer %arg0 : (!mpmd.mesh_tensor<"m1", tensor<4x8xui32>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>
+  %1 = mpmd.transfer %arg1 : (!mpmd.mesh_tensor<"m1", tensor<4x4xf32>>) -> !mpmd.mesh_tensor<"m2", tensor<4x4xf32>>
+  func.return %0, %1 : !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>, !mpmd.mesh_tensor<"m2", tensor<4x4xf32>>
+}
@@ -0,0 +1,16 @@
+// RUN: mpmd_opt %s -mpmd-extract-reshards-from-inter-mesh-transfers='keep-resharding-transfers=true' 2>&1 | FileCheck %s
+
+module {
+sdy.mesh @mesh = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @resharding_transfer_is_kept
+func.func @resharding_transfer_is_kept(%arg0: !mpmd.mesh_tensor<"m1", tensor<4x8xui32>> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {?}]>})
+  -> (!mpmd.mesh_tensor<"m2", tensor<4x8xui32>> {sdy.sharding = #sdy.sharding<@mesh, [{"y"}, {?}]>})
+  attributes {"topology"=#mpmd.topology<<"m1": <["x"=2, "y"=4]>>, <"m2": <["x"=2, "y"=4]>>>}
+{
+  // CHECK-NEXT: %[[TRANSFER:.*]] = mpmd.transfer {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {?}]>]>} %arg0
+  // CHECK-NEXT: return %[[TRANSFER]]
+  %0 = mpmd.transfer {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {?}]>]>} %arg0 : (!mpmd.mesh_tensor<"m1", tensor<4x8xui32>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>
+  func.return %0 : !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>
+}
+}
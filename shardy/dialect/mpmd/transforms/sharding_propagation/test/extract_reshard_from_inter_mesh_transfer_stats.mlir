@@ -0,0 +1,25 @@
+// RUN: mpmd_opt %s -mpmd-extract-reshards-from-inter-mesh-transfers -mlir-pass-statistics -mlir-pass-statistics-display=list 2>&1 | FileCheck %s
+
+// The first transfer is resharded at the producer site, as its destination is
+// smaller, which saves 16 - 8 elements of 4 bytes per device. The second one
+// would all-gather at the source, so it's resharded at the consumer site,
+// which saves 32 - 16 elements of 4 bytes per device.
+
+// CHECK: (S) 1 num-reshards-at-consumer-site
+// CHECK: (S) 1 num-reshards-at-producer-site
+// CHECK: (S) 96 transfer-bytes-saved
+
+module {
+sdy.mesh @mesh = <["x"=2, "y"=4]>
+
+func.func @main(%arg0: !mpmd.mesh_tensor<"m1", tensor<4x8xui32>> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {?}]>},
+                %arg1: !mpmd.mesh_tensor<"m1", tensor<4x8xui32>> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {?}]>})
+  -> (!mpmd.mesh_tensor<"m2", tensor<4x8xui32>> {sdy.sharding = #sdy.sharding<@mesh, [{"y"}, {?}]>},
+      !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>)
+  attributes {"topology"=#mpmd.topology<<"m1": <["x"=2, "y"=4]>>, <"m2": <["x"=2, "y"=4]>>>}
+{
+  %0 = mpmd.transfer {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {?}]>]>} %arg0 : (!mpmd.mesh_tensor<"m1", tensor<4x8xui32>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>
+  %1 = mpmd.transfer {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {?}]>]>} %arg1 : (!mpmd.mesh_tensor<"m1", tensor<4x8xui32>>) -> !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>
+  func.return %0, %1 : !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>, !mpmd.mesh_tensor<"m2", tensor<4x8xui32>>
+}
+}
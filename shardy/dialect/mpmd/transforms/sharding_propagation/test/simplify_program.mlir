@@ -281,3 +281,23 @@ func.func @side_effect_unused_fragment_is_not_erased(%arg0: !mesh_1_tensor)
   func.return
 }
 
+
+sdy.mesh @mesh = <["x"=2, "y"=2]>
+
+// CHECK-LABEL: func @erased_operands_drop_their_in_shardings
+func.func @erased_operands_drop_their_in_shardings(%arg0: !mesh_1_tensor, %arg1: !mesh_1_tensor)
+  -> !mesh_1_tensor attributes {
+    "topology"=#mpmd.topology<<"m1": <["x"=2, "y"=2]>>>} {
+// CHECK-NEXT: %[[FRAGMENT:.*]] = mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{"y"}, {?}]>]> (%arg1)
+// CHECK-SAME:   (%arg2: tensor<4x8xf32>) {
+// CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %arg2, %arg2
+// CHECK-NEXT:   mpmd.return %[[ADD]]
+// CHECK-NEXT: }
+// CHECK-NEXT: return %[[FRAGMENT]]
+  %0 = mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{"x"}, {?}]>, <@mesh, [{"y"}, {?}]>]> (%arg0, %arg1)
+    (%arg2: tensor<4x8xf32>, %arg3: tensor<4x8xf32>) {
+    %1 = stablehlo.add %arg3, %arg3 : tensor<4x8xf32>
+    mpmd.return %1 : tensor<4x8xf32>
+  } : (!mesh_1_tensor, !mesh_1_tensor) -> !mesh_1_tensor
+  func.return %0 : !mesh_1_tensor
+}
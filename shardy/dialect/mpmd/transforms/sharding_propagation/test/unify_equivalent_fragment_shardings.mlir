@@ -0,0 +1,83 @@
+// RUN: mpmd_opt %s -mpmd-unify-equivalent-fragment-shardings -split-input-file 2>&1 | FileCheck %s
+// RUN: mpmd_opt %s -mpmd-unify-equivalent-fragment-shardings -split-input-file -mlir-pass-statistics -mlir-pass-statistics-display=list 2>&1 | FileCheck --check-prefix=STATS %s
+
+// STATS: (S) 1 num-boundary-conflicts
+// STATS: (S) 2 num-unified-fragments
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+module {
+sdy.mesh @mesh = <["x"=2]>
+
+// CHECK-LABEL: func @copies_take_the_shardings_of_the_representative
+func.func @copies_take_the_shardings_of_the_representative(%arg0: !mesh_1_tensor, %arg1: !mesh_2_tensor)
+  -> (!mesh_1_tensor, !mesh_1_tensor, !mesh_2_tensor, !mesh_1_tensor)
+  attributes {"topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=2]>>>}
+{
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{"x"}, {}]>], out_shardings=[<@mesh, [{"x"}, {}]>]>
+  // CHECK-NEXT:   stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>}
+  %0 = mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{"x"}, {}]>], out_shardings=[<@mesh, [{"x"}, {}]>]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+
+  // A copy with a different internal sharding.
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{"x"}, {}]>], out_shardings=[<@mesh, [{"x"}, {}]>]>
+  // CHECK-NEXT:   stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>}
+  %1 = mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{"x"}, {}]>], out_shardings=[<@mesh, [{"x"}, {}]>]> (%0) (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"x"}]>]>} : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+
+  // A copy on another mesh of the homogeneous topology, without an internal
+  // sharding.
+  // CHECK:      mpmd.fragment<mesh="m2", origin=["f"], in_shardings=[<@mesh, [{"x"}, {}]>], out_shardings=[<@mesh, [{"x"}, {}]>]>
+  // CHECK-NEXT:   stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>}
+  %2 = mpmd.fragment<mesh="m2", origin=["f"], in_shardings=[<@mesh, [{"x"}, {}]>], out_shardings=[<@mesh, [{"x"}, {}]>]> (%arg1) (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.abs %arg2 : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!mesh_2_tensor) -> !mesh_2_tensor
+
+  // A copy with different boundary shardings keeps its own shardings.
+  // CHECK:      mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{}, {"x"}]>], out_shardings=[<@mesh, [{}, {"x"}]>]>
+  // CHECK-NEXT:   stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"x"}]>]>}
+  %3 = mpmd.fragment<mesh="m1", origin=["f"], in_shardings=[<@mesh, [{}, {"x"}]>], out_shardings=[<@mesh, [{}, {"x"}]>]> (%1) (%arg2: tensor<4x8xf32>) {
+    %4 = stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"x"}]>]>} : tensor<4x8xf32>
+    mpmd.return %4 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+
+  func.return %0, %1, %2, %3 : !mesh_1_tensor, !mesh_1_tensor, !mesh_2_tensor, !mesh_1_tensor
+}
+}
+
+// -----
+
+!mesh_1_tensor = !mpmd.mesh_tensor<"m1", tensor<4x8xf32>>
+!mesh_2_tensor = !mpmd.mesh_tensor<"m2", tensor<4x8xf32>>
+
+module {
+sdy.mesh @mesh = <["x"=2]>
+
+// CHECK-LABEL: func @copies_on_different_meshes_of_heterogeneous_topology
+func.func @copies_on_different_meshes_of_heterogeneous_topology(%arg0: !mesh_1_tensor, %arg1: !mesh_2_tensor)
+  -> (!mesh_1_tensor, !mesh_2_tensor)
+  attributes {"topology"=#mpmd.topology<<"m1": <["x"=2]>>, <"m2": <["x"=4]>>>}
+{
+  // CHECK:      mpmd.fragment<mesh="m1"
+  // CHECK-NEXT:   stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>}
+  %0 = mpmd.fragment<mesh="m1", origin=["f"]> (%arg0) (%arg2: tensor<4x8xf32>) {
+    %2 = stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : tensor<4x8xf32>
+    mpmd.return %2 : tensor<4x8xf32>
+  } : (!mesh_1_tensor) -> !mesh_1_tensor
+
+  // CHECK:      mpmd.fragment<mesh="m2"
+  // CHECK-NEXT:   stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"x"}]>]>}
+  %1 = mpmd.fragment<mesh="m2", origin=["f"]> (%arg1) (%arg2: tensor<4x8xf32>) {
+    %2 = stablehlo.abs %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"x"}]>]>} : tensor<4x8xf32>
+    mpmd.return %2 : tensor<4x8xf32>
+  } : (!mesh_2_tensor) -> !mesh_2_tensor
+
+  func.return %0, %1 : !mesh_1_tensor, !mesh_2_tensor
+}
+}
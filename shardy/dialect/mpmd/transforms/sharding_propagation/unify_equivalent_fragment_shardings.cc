@@ -0,0 +1,200 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <utility>
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Block.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/Region.h"
+#include "mlir/IR/Visitors.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/sharding_propagation/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/sdy/ir/constants.h"
+
+namespace mlir::mpmd {
+
+#define GEN_PASS_DEF_UNIFYEQUIVALENTFRAGMENTSHARDINGSPASS
+#include "shardy/dialect/mpmd/transforms/sharding_propagation/passes.h.inc"
+
+namespace {
+
+// Returns the ops nested in `fragment`, in pre-order.
+SmallVector<Operation*> GetNestedOps(FragmentOp fragment) {
+  SmallVector<Operation*> ops;
+  fragment.getRegion().walk<WalkOrder::PreOrder>(
+      [&](Operation* op) { ops.push_back(op); });
+  return ops;
+}
+
+// Returns the attributes of `op` without its sharding.
+DictionaryAttr GetAttrsWithoutSharding(Operation* op) {
+  NamedAttrList attrs(op->getAttrDictionary());
+  attrs.erase(sdy::kShardingAttr);
+  return attrs.getDictionary(op->getContext());
+}
+
+// Hashes the body of `fragment`, ignoring the shardings of its ops, like
+// `LowerToFragmentCallsPass` hashes fragments to group them. The mesh name is
+// only hashed if `hash_mesh_name`.
+unsigned HashIgnoringShardings(FragmentOp fragment, bool hash_mesh_name) {
+  llvm::hash_code hash =
+      llvm::hash_value(fragment.getBody()->getNumArguments());
+  if (hash_mesh_name) {
+    hash = llvm::hash_combine(hash, fragment.getMeshName());
+  }
+  fragment.getRegion().walk([&](Operation* op) {
+    hash = llvm::hash_combine(
+        hash, op->getName(), op->getNumOperands(),
+        llvm::hash_combine_range(op->getResultTypes().begin(),
+                                 op->getResultTypes().end()));
+  });
+  return hash;
+}
+
+// Returns whether the bodies of `lhs` and `rhs` are equal up to the shardings
+// of their ops, where `lhs_ops` and `rhs_ops` are their nested ops in
+// pre-order.
+bool AreEquivalentIgnoringShardings(FragmentOp lhs, FragmentOp rhs,
+                                    ArrayRef<Operation*> lhs_ops,
+                                    ArrayRef<Operation*> rhs_ops) {
+  if (lhs_ops.size() != rhs_ops.size() ||
+      lhs.getBody()->getArgumentTypes() != rhs.getBody()->getArgumentTypes()) {
+    return false;
+  }
+  IRMapping mapping;
+  mapping.map(lhs.getBody()->getArguments(), rhs.getBody()->getArguments());
+  for (auto [lhs_op, rhs_op] : llvm::zip_equal(lhs_ops, rhs_ops)) {
+    if (lhs_op->getName() != rhs_op->getName() ||
+        lhs_op->getNumOperands() != rhs_op->getNumOperands() ||
+        lhs_op->getResultTypes() != rhs_op->getResultTypes() ||
+        lhs_op->getNumRegions() != rhs_op->getNumRegions() ||
+        GetAttrsWithoutSharding(lhs_op) != GetAttrsWithoutSharding(rhs_op)) {
+      return false;
+    }
+    for (auto [lhs_operand, rhs_operand] :
+         llvm::zip_equal(lhs_op->getOperands(), rhs_op->getOperands())) {
+      if (mapping.lookupOrNull(lhs_operand) != rhs_operand) {
+        return false;
+      }
+    }
+    mapping.map(lhs_op->getResults(), rhs_op->getResults());
+    // The ops nested in the regions come next in pre-order, so map the block
+    // arguments of the regions before visiting them.
+    for (auto [lhs_region, rhs_region] :
+         llvm::zip_equal(lhs_op->getRegions(), rhs_op->getRegions())) {
+      if (lhs_region.getBlocks().size() != rhs_region.getBlocks().size()) {
+        return false;
+      }
+      for (auto [lhs_block, rhs_block] :
+           llvm::zip_equal(lhs_region.getBlocks(), rhs_region.getBlocks())) {
+        if (lhs_block.getArgumentTypes() != rhs_block.getArgumentTypes()) {
+          return false;
+        }
+        mapping.map(lhs_block.getArguments(), rhs_block.getArguments());
+      }
+    }
+  }
+  return true;
+}
+
+// Sets the shardings of `copy_ops` to those of the matching
+// `representative_ops`. Returns whether any sharding changed.
+bool CopyShardings(ArrayRef<Operation*> representative_ops,
+                   ArrayRef<Operation*> copy_ops) {
+  bool changed = false;
+  for (auto [representative_op, copy_op] :
+       llvm::zip_equal(representative_ops, copy_ops)) {
+    Attribute sharding = representative_op->getAttr(sdy::kShardingAttr);
+    if (sharding == copy_op->getAttr(sdy::kShardingAttr)) {
+      continue;
+    }
+    changed = true;
+    if (sharding) {
+      copy_op->setAttr(sdy::kShardingAttr, sharding);
+    } else {
+      copy_op->removeAttr(sdy::kShardingAttr);
+    }
+  }
+  return changed;
+}
+
+class UnifyEquivalentFragmentShardingsPass
+    : public impl::UnifyEquivalentFragmentShardingsPassBase<
+          UnifyEquivalentFragmentShardingsPass> {
+  using UnifyEquivalentFragmentShardingsPassBase::
+      UnifyEquivalentFragmentShardingsPassBase;
+
+ protected:
+  void runOnFunc(func::FuncOp func_op) final {
+    if (!IsMpmdFunction(func_op)) {
+      return;
+    }
+    // Fragments on different meshes can only share shardings if the meshes
+    // are equivalent.
+    bool hash_mesh_name = !HasHomogeneousTopology(func_op);
+
+    // Bucket the fragments by hash, in program order.
+    llvm::MapVector<unsigned, SmallVector<FragmentOp>> hash_to_fragments;
+    for (FragmentOp fragment : func_op.getOps<FragmentOp>()) {
+      hash_to_fragments[HashIgnoringShardings(fragment, hash_mesh_name)]
+          .push_back(fragment);
+    }
+
+    for (auto& [hash, fragments] : hash_to_fragments) {
+      // The representatives of the equivalence classes in the bucket, i.e.,
+      // the first fragment of each class, with their nested ops.
+      SmallVector<std::pair<FragmentOp, SmallVector<Operation*>>>
+          representatives;
+      for (FragmentOp fragment : fragments) {
+        SmallVector<Operation*> ops = GetNestedOps(fragment);
+        auto representative =
+            llvm::find_if(representatives, [&](const auto& entry) {
+              return AreEquivalentIgnoringShardings(entry.first, fragment,
+                                                    entry.second, ops);
+            });
+        if (representative == representatives.end()) {
+          representatives.emplace_back(fragment, std::move(ops));
+          continue;
+        }
+        // The internal shardings of the representative are only valid for
+        // copies with the same boundary shardings.
+        FragmentOp representative_fragment = representative->first;
+        if (representative_fragment.getInShardingsAttr() !=
+                fragment.getInShardingsAttr() ||
+            representative_fragment.getOutShardingsAttr() !=
+                fragment.getOutShardingsAttr()) {
+          ++numBoundaryConflicts;
+          continue;
+        }
+        if (CopyShardings(representative->second, ops)) {
+          ++numUnifiedFragments;
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+}  // namespace mlir::mpmd
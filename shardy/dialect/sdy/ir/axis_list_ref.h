@@ -22,6 +22,7 @@ limitations under the License.
 #include <utility>
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallVector.h"
 #include "mlir/Support/LLVM.h"
@@ -160,6 +161,10 @@ class AxisListRef {
                           /*isTailIterated=*/true, tailAxisRef);
   }
 
+  friend llvm::hash_code hash_value(const AxisListRef& axisListRef) {
+    return llvm::hash_value(axisListRef.toPair());
+  }
+
   friend struct AxisListRefInfo;
 
  private:
@@ -186,15 +191,20 @@ class AxisListRef {
   AxisRefAttr tailAxisRef;
 };
 
+// Allows `AxisListRef` to be used as a key of `DenseMap` and `DenseSet`, e.g.,
+// `DenseSet<AxisListRef, AxisListRefInfo>`. Note that the empty list is the
+// empty key, and therefore can't be inserted.
 struct AxisListRefInfo : public llvm::DenseMapInfo<AxisListRef> {
-  static unsigned getHashValue(const AxisListRef& m) {
-    return llvm::hash_value(m.toPair());
-  }
+  static unsigned getHashValue(const AxisListRef& m) { return hash_value(m); }
   static bool isEqual(const AxisListRef& lhs, const AxisListRef& rhs) {
     return lhs == rhs;
   }
 
   static inline AxisListRef getEmptyKey() { return AxisListRef(); }
+  static inline AxisListRef getTombstoneKey() {
+    return AxisListRef(/*axisRefs=*/{},
+                       llvm::DenseMapInfo<AxisRefAttr>::getTombstoneKey());
+  }
 };
 
 }  // namespace sdy
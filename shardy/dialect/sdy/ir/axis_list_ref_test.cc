@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstdint>
 
+#include "llvm/ADT/DenseSet.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
@@ -210,6 +211,28 @@ TEST_F(AxisListRefTest, LessThan_NonEmptyAgainstEmpty) {
   EXPECT_FALSE(axes < against);
 }
 
+TEST_F(AxisListRefTest, HashValue_EqualAfterTruncate) {
+  AxisListRef axes =
+      createAxisListRef({createAxis("a"), createAxis("b"), createAxis("c")});
+  AxisListRef against = createAxisListRef({createAxis("c")});
+  EXPECT_TRUE(axes.truncateWithoutOverlap(against));
+  AxisListRef truncated = createAxisListRef({createAxis("a"), createAxis("b")});
+  EXPECT_EQ(hash_value(axes), hash_value(truncated));
+}
+
+TEST_F(AxisListRefTest, DenseSet) {
+  DenseSet<AxisListRef, AxisListRefInfo> axisLists;
+  EXPECT_TRUE(axisLists.insert(createAxisListRef({createAxis("a")})).second);
+  EXPECT_TRUE(
+      axisLists.insert(createAxisListRef({createAxis("a"), createAxis("b")}))
+          .second);
+  EXPECT_FALSE(axisLists.insert(createAxisListRef({createAxis("a")})).second);
+  EXPECT_TRUE(axisLists.erase(createAxisListRef({createAxis("a")})));
+  EXPECT_EQ(axisLists.size(), 1);
+  EXPECT_TRUE(axisLists.contains(
+      createAxisListRef({createAxis("a"), createAxis("b")})));
+}
+
 // TODO(enver): Add unit tests for all methods.
 
 }  // namespace
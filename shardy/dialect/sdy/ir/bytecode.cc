@@ -18,6 +18,10 @@ limitations under the License.
 #include <memory>
 #include <optional>
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
@@ -26,9 +30,11 @@ limitations under the License.
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Dialect.h"
 #include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Support/LogicalResult.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/enums.h"
 
 using namespace mlir;
 using namespace mlir::sdy;
@@ -78,6 +84,166 @@ void writeTensorShardingPerValueAttrV2(TensorShardingPerValueAttr attr,
   });
 }
 
+//===----------------------------------------------------------------------===//
+// TensorShardingAttr V4
+//===----------------------------------------------------------------------===//
+//
+// The whole sharding is encoded in a single entry, instead of an entry per
+// dimension sharding and axis-ref that the sharding references:
+//
+//   mesh_or_ref: Attribute
+//   axis_names: list of the distinct axis names of the sharding, in order of
+//     first use
+//   dim_shardings: VarInt(num_dims), then for each dimension:
+//     VarIntWithFlag(num_axes, is_closed), OptionalVarInt(priority), axes
+//   replicated_axes, unreduced_axes: VarInt(num_axes), axes
+//   reduction_op: VarInt
+//
+// where each axis is VarIntWithFlag(axis_name_index, has_sub_axis_info),
+// followed by VarInt(pre_size) and VarInt(size) if it has sub-axis info.
+
+void writeAxisRefV4(AxisRefAttr axisRef,
+                    const llvm::DenseMap<StringRef, uint64_t>& nameToIndex,
+                    DialectBytecodeWriter& writer) {
+  SubAxisInfoAttr subAxisInfo = axisRef.getSubAxisInfo();
+  writer.writeVarIntWithFlag(nameToIndex.at(axisRef.getName()),
+                             /*flag=*/subAxisInfo != nullptr);
+  if (subAxisInfo) {
+    writer.writeVarInt(subAxisInfo.getPreSize());
+    writer.writeVarInt(subAxisInfo.getSize());
+  }
+}
+
+void writeTensorShardingAttrV4Body(TensorShardingAttr attr,
+                                   DialectBytecodeWriter& writer) {
+  SmallVector<StringRef> axisNames;
+  llvm::DenseMap<StringRef, uint64_t> nameToIndex;
+  attr.forEachAxisRef([&](AxisRefAttr axisRef) {
+    if (nameToIndex.try_emplace(axisRef.getName(), axisNames.size()).second) {
+      axisNames.push_back(axisRef.getName());
+    }
+  });
+  auto writeAxes = [&](ArrayRef<AxisRefAttr> axes) {
+    for (AxisRefAttr axisRef : axes) {
+      writeAxisRefV4(axisRef, nameToIndex, writer);
+    }
+  };
+
+  writer.writeAttribute(attr.getMeshOrRef());
+  writer.writeList(axisNames, [&](StringRef axisName) {
+    writer.writeOwnedString(axisName);
+  });
+  writer.writeVarInt(attr.getDimShardings().size());
+  for (DimensionShardingAttr dimSharding : attr.getDimShardings()) {
+    writer.writeVarIntWithFlag(dimSharding.getAxes().size(),
+                               /*flag=*/dimSharding.getIsClosed());
+    std::optional<int64_t> priority = dimSharding.getPriority();
+    writeOptionalVarInt(writer, priority ? std::optional<uint64_t>(*priority)
+                                         : std::nullopt);
+    writeAxes(dimSharding.getAxes());
+  }
+  writer.writeVarInt(attr.getReplicatedAxes().size());
+  writeAxes(attr.getReplicatedAxes());
+  writer.writeVarInt(attr.getUnreducedAxes().size());
+  writeAxes(attr.getUnreducedAxes());
+  writer.writeVarInt(static_cast<uint64_t>(attr.getReductionOp()));
+}
+
+void writeTensorShardingAttrV4(TensorShardingAttr attr,
+                               DialectBytecodeWriter& writer) {
+  writer.writeVarInt(18);
+  writeTensorShardingAttrV4Body(attr, writer);
+}
+
+LogicalResult readAxisRefsV4(MLIRContext* context,
+                             DialectBytecodeReader& reader,
+                             ArrayRef<StringRef> axisNames, uint64_t numAxes,
+                             SmallVector<AxisRefAttr>& axes) {
+  axes.reserve(numAxes);
+  for (uint64_t i = 0; i < numAxes; ++i) {
+    uint64_t nameIndex;
+    bool hasSubAxisInfo;
+    if (failed(reader.readVarIntWithFlag(nameIndex, hasSubAxisInfo))) {
+      return failure();
+    }
+    if (nameIndex >= axisNames.size()) {
+      return reader.emitError("invalid axis name index: ") << nameIndex;
+    }
+    if (!hasSubAxisInfo) {
+      axes.push_back(AxisRefAttr::get(context, axisNames[nameIndex]));
+      continue;
+    }
+    uint64_t preSize, size;
+    if (failed(reader.readVarInt(preSize)) || failed(reader.readVarInt(size))) {
+      return failure();
+    }
+    axes.push_back(
+        AxisRefAttr::get(context, axisNames[nameIndex], preSize, size));
+  }
+  return success();
+}
+
+LogicalResult readAxisRefListV4(MLIRContext* context,
+                                DialectBytecodeReader& reader,
+                                ArrayRef<StringRef> axisNames,
+                                SmallVector<AxisRefAttr>& axes) {
+  uint64_t numAxes;
+  if (failed(reader.readVarInt(numAxes))) {
+    return failure();
+  }
+  return readAxisRefsV4(context, reader, axisNames, numAxes, axes);
+}
+
+LogicalResult readTensorShardingAttrV4(MLIRContext* context,
+                                       DialectBytecodeReader& reader,
+                                       TensorShardingAttr& result) {
+  Attribute meshOrRef;
+  SmallVector<StringRef> axisNames;
+  uint64_t numDims;
+  if (failed(reader.readAttribute(meshOrRef)) ||
+      failed(reader.readList(axisNames,
+                             [&](StringRef& axisName) {
+                               return reader.readString(axisName);
+                             })) ||
+      failed(reader.readVarInt(numDims))) {
+    return failure();
+  }
+
+  SmallVector<DimensionShardingAttr> dimShardings;
+  dimShardings.reserve(numDims);
+  for (uint64_t dim = 0; dim < numDims; ++dim) {
+    uint64_t numAxes;
+    bool isClosed;
+    std::optional<uint64_t> priority;
+    SmallVector<AxisRefAttr> axes;
+    if (failed(reader.readVarIntWithFlag(numAxes, isClosed)) ||
+        failed(readOptionalVarInt(reader, priority)) ||
+        failed(readAxisRefsV4(context, reader, axisNames, numAxes, axes))) {
+      return failure();
+    }
+    dimShardings.push_back(DimensionShardingAttr::get(
+        context, axes, isClosed,
+        priority ? std::optional<int64_t>(*priority) : std::nullopt));
+  }
+
+  SmallVector<AxisRefAttr> replicatedAxes, unreducedAxes;
+  uint64_t reductionOpValue;
+  if (failed(readAxisRefListV4(context, reader, axisNames, replicatedAxes)) ||
+      failed(readAxisRefListV4(context, reader, axisNames, unreducedAxes)) ||
+      failed(reader.readVarInt(reductionOpValue))) {
+    return failure();
+  }
+  std::optional<ReductionOp> reductionOp =
+      symbolizeReductionOp(static_cast<uint32_t>(reductionOpValue));
+  if (!reductionOp) {
+    return reader.emitError("invalid reduction op: ") << reductionOpValue;
+  }
+
+  result = TensorShardingAttr::get(context, meshOrRef, dimShardings,
+                                   replicatedAxes, unreducedAxes, *reductionOp);
+  return success();
+}
+
 #include "shardy/dialect/sdy/ir/bytecode.cc.inc"
 
 /// This class implements the bytecode interface for the SDY dialect.
@@ -94,26 +260,33 @@ struct SdyDialectBytecodeInterface : public BytecodeDialectInterface {
 
   LogicalResult writeAttribute(Attribute attr,
                                DialectBytecodeWriter &writer) const override {
-    auto versionOrFailed = writer.getDialectVersion("sdy");
-    if (succeeded(versionOrFailed)) {
-      const auto* sdyVersion =
-          static_cast<const SdyDialectVersion*>(*versionOrFailed);
-      if (sdyVersion->getMajor() == 0 && sdyVersion->getMinor() == 0 &&
-          sdyVersion->getPatch() == 1) {
-        if (auto shardingAttr = dyn_cast<TensorShardingAttr>(attr)) {
-          if (!shardingAttr.getUnreducedAxes().empty()) {
-            writeTensorShardingAttrV2(shardingAttr, writer);
-            return success();
-          }
-        } else if (auto perValueAttr =
-                       dyn_cast<TensorShardingPerValueAttr>(attr)) {
-          if (perValueAttr.anyShardingHasUnreducedAxes()) {
-            writeTensorShardingPerValueAttrV2(perValueAttr, writer);
-            return success();
-          }
+    SdyDialectVersion sdyVersion = SdyDialectVersion::getCurrentVersion();
+    if (auto versionOrFailed = writer.getDialectVersion("sdy");
+        succeeded(versionOrFailed)) {
+      sdyVersion = *static_cast<const SdyDialectVersion*>(*versionOrFailed);
+    }
+    if (sdyVersion.getMajor() == 0 && sdyVersion.getMinor() == 0 &&
+        sdyVersion.getPatch() == 1) {
+      if (auto shardingAttr = dyn_cast<TensorShardingAttr>(attr)) {
+        if (!shardingAttr.getUnreducedAxes().empty()) {
+          writeTensorShardingAttrV2(shardingAttr, writer);
+          return success();
+        }
+      } else if (auto perValueAttr =
+                     dyn_cast<TensorShardingPerValueAttr>(attr)) {
+        if (perValueAttr.anyShardingHasUnreducedAxes()) {
+          writeTensorShardingPerValueAttrV2(perValueAttr, writer);
+          return success();
         }
       }
     }
+    // Shardings are written in the compact V4 encoding since version 0.0.3.
+    if (!(sdyVersion < SdyDialectVersion(0, 0, 3))) {
+      if (auto shardingAttr = dyn_cast<TensorShardingAttr>(attr)) {
+        writeTensorShardingAttrV4(shardingAttr, writer);
+        return success();
+      }
+    }
     auto result = ::writeAttribute(attr, writer);
     if (failed(result)) {
       LOG_NOT_IMPLEMENTED(attr);
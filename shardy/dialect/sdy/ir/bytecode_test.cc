@@ -0,0 +1,213 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/ir/bytecode.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/AsmParser/AsmParser.h"
+#include "mlir/Bytecode/BytecodeImplementation.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
+#include "mlir/IR/AsmState.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/IR/Types.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/testing_utils.h"
+#include <gtest/gtest.h>
+
+namespace mlir {
+namespace sdy {
+
+namespace {
+
+// Covers sub-axes, priorities, open and closed dimensions, replicated and
+// unreduced axes, every reduction op, and both a mesh reference and an inlined
+// mesh.
+constexpr StringRef kModule = R"mlir(
+sdy.mesh @mesh = <["x"=4, "y"=2, "z"=2, "w"=2]>
+
+func.func @main(
+    %arg0: tensor<8x8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x":(1)2, "y"}p1, {?}, {"z", ?}p0]>},
+    %arg1: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x":(2)2}, {}], replicated={"y"}, unreduced={"z"}>},
+    %arg2: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"y", ?}p2], replicated={"x":(1)2}, unreduced=max{"z", "w"}>},
+    %arg3: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<mesh<["a"=2]>, [{"a"}, {?}]>})
+    -> (tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {}], unreduced=min{"x":(1)2}>}) {
+  %0 = stablehlo.add %arg1, %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}], unreduced=min{"y"}>]>} : tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
+)mlir";
+
+// Records the var-ints written by a dialect bytecode interface, which for sdy
+// attributes start with the code of the encoding being written.
+class RecordingBytecodeWriter : public DialectBytecodeWriter {
+ public:
+  explicit RecordingBytecodeWriter(std::optional<SdyDialectVersion> version)
+      : version(version) {}
+
+  void writeAttribute(Attribute) override {}
+  void writeOptionalAttribute(Attribute) override {}
+  void writeType(Type) override {}
+  void writeResourceHandle(const AsmDialectResourceHandle&) override {}
+  void writeVarInt(uint64_t value) override { varInts.push_back(value); }
+  void writeAPIntWithKnownWidth(const APInt&) override {}
+  void writeAPFloatWithKnownSemantics(const APFloat&) override {}
+  void writeOwnedString(StringRef) override {}
+  void writeOwnedBlob(ArrayRef<char>) override {}
+  void writeOwnedBool(bool) override {}
+  int64_t getBytecodeVersion() const override { return 0; }
+
+  FailureOr<const DialectVersion*> getDialectVersion(
+      StringRef dialectName) const override {
+    if (dialectName != SdyDialect::getDialectNamespace() || !version) {
+      return failure();
+    }
+    return static_cast<const DialectVersion*>(&*version);
+  }
+
+  SmallVector<uint64_t> varInts;
+
+ private:
+  std::optional<SdyDialectVersion> version;
+};
+
+std::string printModule(ModuleOp module) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  module.print(os);
+  return str;
+}
+
+class BytecodeTest : public ShardyTestBase {
+ protected:
+  OwningOpRef<ModuleOp> parseModule() {
+    OwningOpRef<ModuleOp> module = parseSourceString<ModuleOp>(kModule,
+                                                               &context);
+    EXPECT_TRUE(module);
+    return module;
+  }
+
+  // Writes `module` to bytecode for `version`, reads it back, and checks that
+  // the result prints the same as `module`.
+  void expectRoundTrip(ModuleOp module,
+                       std::optional<SdyDialectVersion> version) {
+    std::string bytecode = writeBytecode(module, version);
+    OwningOpRef<ModuleOp> roundTripped =
+        parseSourceString<ModuleOp>(bytecode, &context);
+    ASSERT_TRUE(roundTripped);
+    EXPECT_EQ(printModule(*roundTripped), printModule(module));
+  }
+
+  std::string writeBytecode(ModuleOp module,
+                            std::optional<SdyDialectVersion> version) {
+    std::string bytecode;
+    llvm::raw_string_ostream os(bytecode);
+    BytecodeWriterConfig config("SDY");
+    if (version) {
+      config.setDialectVersion<SdyDialect>(
+          std::make_unique<SdyDialectVersion>(*version));
+    }
+    EXPECT_TRUE(succeeded(writeBytecodeToFile(module, os, config)));
+    return bytecode;
+  }
+
+  // Returns the code of the encoding the sdy bytecode interface picks for
+  // `sharding` when writing for `version`.
+  uint64_t getEncodingCode(TensorShardingAttr sharding,
+                           std::optional<SdyDialectVersion> version) {
+    auto* interface = context.getLoadedDialect<SdyDialect>()
+                          ->getRegisteredInterface<BytecodeDialectInterface>();
+    RecordingBytecodeWriter writer(version);
+    EXPECT_TRUE(succeeded(interface->writeAttribute(sharding, writer)));
+    EXPECT_FALSE(writer.varInts.empty());
+    return writer.varInts.empty() ? 0 : writer.varInts.front();
+  }
+
+  TensorShardingAttr parseSharding(StringRef sharding) {
+    auto attr = dyn_cast_or_null<TensorShardingAttr>(
+        parseAttribute(sharding, &context));
+    EXPECT_TRUE(attr);
+    return attr;
+  }
+};
+
+TEST_F(BytecodeTest, RoundTripCurrentVersion) {
+  OwningOpRef<ModuleOp> module = parseModule();
+  ASSERT_TRUE(module);
+  expectRoundTrip(*module, SdyDialectVersion::getCurrentVersion());
+}
+
+TEST_F(BytecodeTest, RoundTripUnknownVersion) {
+  OwningOpRef<ModuleOp> module = parseModule();
+  ASSERT_TRUE(module);
+  expectRoundTrip(*module, /*version=*/std::nullopt);
+}
+
+TEST_F(BytecodeTest, RoundTripVersion002) {
+  OwningOpRef<ModuleOp> module = parseModule();
+  ASSERT_TRUE(module);
+  expectRoundTrip(*module, SdyDialectVersion(0, 0, 2));
+}
+
+TEST_F(BytecodeTest, Version003AndUnknownVersionWriteV4) {
+  for (StringRef sharding :
+       {R"(#sdy.sharding<@mesh, [{"x":(1)2, "y"}p1, {?}]>)",
+        R"(#sdy.sharding<@mesh, [{}], unreduced={"z"}>)",
+        R"(#sdy.sharding<@mesh, [{}], unreduced=max{"z"}>)"}) {
+    TensorShardingAttr attr = parseSharding(sharding);
+    ASSERT_TRUE(attr);
+    EXPECT_EQ(getEncodingCode(attr, SdyDialectVersion(0, 0, 3)), 18)
+        << sharding.str();
+    EXPECT_EQ(getEncodingCode(attr, /*version=*/std::nullopt), 18)
+        << sharding.str();
+  }
+}
+
+TEST_F(BytecodeTest, Version002WritesOldEncodings) {
+  SdyDialectVersion version(0, 0, 2);
+  // V1: no unreduced axes.
+  EXPECT_EQ(getEncodingCode(
+                parseSharding(R"(#sdy.sharding<@mesh, [{"x":(1)2}p1, {?}]>)"),
+                version),
+            6);
+  // V2: unreduced axes with the default sum reduction.
+  EXPECT_EQ(getEncodingCode(
+                parseSharding(R"(#sdy.sharding<@mesh, [{}], unreduced={"z"}>)"),
+                version),
+            15);
+  // V3: unreduced axes with a non-sum reduction.
+  EXPECT_EQ(
+      getEncodingCode(
+          parseSharding(R"(#sdy.sharding<@mesh, [{}], unreduced=min{"z"}>)"),
+          version),
+      17);
+}
+
+}  // namespace
+
+}  // namespace sdy
+}  // namespace mlir
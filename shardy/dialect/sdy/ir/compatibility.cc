@@ -23,7 +23,8 @@ namespace mlir {
 namespace sdy {
 
 LogicalResult downgradeModule(ModuleOp module, SdyDialectVersion version) {
-  // No downgrade needed right now.
+  // No downgrade needed right now. The bytecode encoding of shardings is
+  // selected by the writer based on the target version.
   return success();
 };
 
@@ -65,6 +65,11 @@ inline constexpr StringRef kResultPropagationEdgesAttr =
 // `sdy.sharding_constraint`, or `sdy.ManualComputationOp` input/output.
 inline constexpr StringRef kShardingOriginNameAttr = "sdy.sharding_origin_name";
 
+// Attribute name for the relative bandwidth of each axis of an `sdy.mesh`, as
+// a dictionary from axis name to a float or integer attribute, e.g., to tell a
+// slow DCN axis apart from fast ICI axes. See `CollectiveCostModel`.
+inline constexpr StringRef kAxisBandwidthsAttr = "sdy.axis_bandwidths";
+
 // Default priority for a `DimensionShardingAttr` that doesn't have a
 // user-defined priority.
 inline constexpr int64_t kDefaultPriority = 0;
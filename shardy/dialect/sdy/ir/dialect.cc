@@ -33,12 +33,17 @@ limitations under the License.
 #include "llvm/ADT/SmallVectorExtras.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/RWMutex.h"
+#include "llvm/Support/SMLoc.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinTypeInterfaces.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/DialectImplementation.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/OpDefinition.h"
+#include "mlir/IR/OpImplementation.h"
 #include "mlir/IR/OperationSupport.h"
 #include "mlir/IR/Region.h"
 #include "mlir/IR/SymbolTable.h"
@@ -89,10 +94,30 @@ struct ShardyDialectInlinerInterface : public DialectInlinerInterface {
   }
 };
 
+struct ShardyDialectAsmInterface : public OpAsmDialectInterface {
+  using OpAsmDialectInterface::OpAsmDialectInterface;
+
+  AliasResult getAlias(Attribute attr, raw_ostream& os) const final {
+    if (!cast<SdyDialect>(getDialect())->isShardingAliasesEnabled()) {
+      return AliasResult::NoAlias;
+    }
+    if (isa<TensorShardingAttr>(attr)) {
+      os << "sharding";
+      return AliasResult::OverridableAlias;
+    }
+    if (isa<TensorShardingPerValueAttr>(attr)) {
+      os << "shardings";
+      return AliasResult::OverridableAlias;
+    }
+    return AliasResult::NoAlias;
+  }
+};
+
 }  // namespace
 
 void SdyDialect::initialize() {
   addInterface<ShardyDialectInlinerInterface>();
+  addInterface<ShardyDialectAsmInterface>();
   addAttributes<
 #define GET_ATTRDEF_LIST
 #include "shardy/dialect/sdy/ir/attrs.cc.inc"
@@ -105,6 +130,92 @@ void SdyDialect::initialize() {
   detail::addBytecodeInterface(this);
 }
 
+//===----------------------------------------------------------------------===//
+// ShardingRuleMemo
+//===----------------------------------------------------------------------===//
+
+std::optional<Attribute> ShardingRuleMemo::lookup(const Key& key) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  if (auto it = rules.find(key); it != rules.end()) {
+    ++numHits;
+    return it->second;
+  }
+  ++numMisses;
+  return std::nullopt;
+}
+
+void ShardingRuleMemo::insert(const Key& key, Attribute rule) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  rules.try_emplace(key, rule);
+}
+
+void ShardingRuleMemo::clear() {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  rules.clear();
+  numHits = 0;
+  numMisses = 0;
+}
+
+int64_t ShardingRuleMemo::getNumHits() {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  return numHits;
+}
+
+int64_t ShardingRuleMemo::getNumMisses() {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  return numMisses;
+}
+
+//===----------------------------------------------------------------------===//
+// VerifiedShardingCache
+//===----------------------------------------------------------------------===//
+
+bool VerifiedShardingCache::contains(const Key& key) {
+  llvm::sys::SmartScopedReader<true> scopedLock(mutex);
+  return verified.contains(key);
+}
+
+void VerifiedShardingCache::insert(const Key& key) {
+  llvm::sys::SmartScopedWriter<true> scopedLock(mutex);
+  verified.insert(key);
+}
+
+void VerifiedShardingCache::clear() {
+  llvm::sys::SmartScopedWriter<true> scopedLock(mutex);
+  verified.clear();
+}
+
+//===----------------------------------------------------------------------===//
+// CanonicalShardingCache
+//===----------------------------------------------------------------------===//
+
+std::optional<Attribute> CanonicalShardingCache::lookup(const Key& key) {
+  llvm::sys::SmartScopedReader<true> scopedLock(mutex);
+  if (auto it = canonicalShardings.find(key); it != canonicalShardings.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+void CanonicalShardingCache::insert(const Key& key,
+                                    Attribute canonicalSharding) {
+  llvm::sys::SmartScopedWriter<true> scopedLock(mutex);
+  if (canonicalShardings.size() >= kMaxSize) {
+    canonicalShardings.clear();
+  }
+  canonicalShardings.try_emplace(key, canonicalSharding);
+}
+
+int64_t CanonicalShardingCache::size() {
+  llvm::sys::SmartScopedReader<true> scopedLock(mutex);
+  return canonicalShardings.size();
+}
+
+void CanonicalShardingCache::clear() {
+  llvm::sys::SmartScopedWriter<true> scopedLock(mutex);
+  canonicalShardings.clear();
+}
+
 namespace details {
 
 SmallVector<TensorShardingAttr> getOpResultEdgeOwnerShardingsImpl(
@@ -374,7 +485,10 @@ bool AxisRefAttr::operator<(const AxisRefAttr& rhs) const {
 }
 
 std::string AxisRefAttr::toString() const {
-  return strippedAttrString(*this, /*stripMnemonic=*/true);
+  std::string result;
+  llvm::raw_string_ostream os(result);
+  printAxisRefList(os, *this);
+  return result;
 }
 
 int64_t AxisRefAttr::getSize(MeshAttr mesh) const {
@@ -990,44 +1104,60 @@ RankedTensorType TensorShardingAttr::getGlobalTensorType(
                                localTensorType.getElementType());
 }
 
-bool TensorShardingAttr::isEquivalent(TensorShardingAttr otherSharding,
-                                      bool ignoreUnreducedAxes) const {
-  // Helper to check replication, optionally ignoring unreduced axes.
-  auto isReplicated = [](TensorShardingAttr s, bool ignoreUnreduced) {
-    if (!s) {
-      return true;
-    }
-    if (!ignoreUnreduced && !s.getUnreducedAxes().empty()) {
-      return false;
-    }
-    return llvm::all_of(
-        s.getDimShardings(),
-        [](const DimensionShardingAttr& dim) { return dim.emptyAxes(); });
-  };
+namespace {
 
-  // Fast path: if both are fully replicated (under our unreduced-axes policy),
-  // they are equivalent.
-  if (isReplicated(*this, ignoreUnreducedAxes)) {
-    return isReplicated(otherSharding, ignoreUnreducedAxes);
-  }
+TensorShardingAttr computeCanonicalForm(TensorShardingAttr sharding,
+                                        bool ignoreUnreducedAxes) {
+  ArrayRef<AxisRefAttr> unreducedAxes;
+  if (!ignoreUnreducedAxes) {
+    unreducedAxes = sharding.getUnreducedAxes();
+  }
+  if (unreducedAxes.empty() &&
+      llvm::all_of(sharding.getDimShardings(),
+                   [](DimensionShardingAttr dim) { return dim.emptyAxes(); })) {
+    return TensorShardingAttr();
+  }
+  MLIRContext* context = sharding.getContext();
+  SmallVector<DimensionShardingAttr> dimShardings = llvm::map_to_vector(
+      sharding.getDimShardings(), [&](DimensionShardingAttr dim) {
+        return DimensionShardingAttr::get(context, dim.getAxes(),
+                                          /*isClosed=*/true);
+      });
+  return TensorShardingAttr::get(context, sharding.getMeshOrRef(),
+                                 dimShardings, /*replicatedAxes=*/{},
+                                 unreducedAxes);
+}
 
-  if (!otherSharding) {
-    return false;
-  }
-  if (getMeshOrRef() != otherSharding.getMeshOrRef()) {
-    return false;
-  }
-  if (!ignoreUnreducedAxes &&
-      getUnreducedAxes() != otherSharding.getUnreducedAxes()) {
-    return false;
+}  // namespace
+
+TensorShardingAttr TensorShardingAttr::getCanonicalForm(
+    bool ignoreUnreducedAxes) const {
+  auto* sdyDialect = getContext()->getLoadedDialect<SdyDialect>();
+  CanonicalShardingCache& cache = sdyDialect->getCanonicalShardingCache();
+  CanonicalShardingCache::Key key(*this, ignoreUnreducedAxes);
+  if (std::optional<Attribute> canonicalSharding = cache.lookup(key)) {
+    return cast_if_present<TensorShardingAttr>(*canonicalSharding);
   }
+  TensorShardingAttr canonicalSharding =
+      computeCanonicalForm(*this, ignoreUnreducedAxes);
+  cache.insert(key, canonicalSharding);
+  return canonicalSharding;
+}
 
-  ArrayRef<DimensionShardingAttr> left = getDimShardings();
-  ArrayRef<DimensionShardingAttr> right = otherSharding.getDimShardings();
-  return left.size() == right.size() &&
-         llvm::all_of(llvm::zip_equal(left, right), [](auto&& pair) {
-           return std::get<0>(pair).getAxes() == std::get<1>(pair).getAxes();
-         });
+bool TensorShardingAttr::isEquivalent(TensorShardingAttr otherSharding,
+                                      bool ignoreUnreducedAxes) const {
+  // Identical shardings are equivalent without looking up the cache, which
+  // takes a lock.
+  if (*this == otherSharding) {
+    return true;
+  }
+  // A missing sharding is fully replicated.
+  auto getCanonicalFormOrNull = [&](TensorShardingAttr sharding) {
+    return sharding ? sharding.getCanonicalForm(ignoreUnreducedAxes)
+                    : TensorShardingAttr();
+  };
+  return getCanonicalFormOrNull(*this) ==
+         getCanonicalFormOrNull(otherSharding);
 }
 
 //===----------------------------------------------------------------------===//
@@ -1605,6 +1735,43 @@ Type ReduceScatterOp::getType() { return getResult().getType(); }
 #include "shardy/dialect/sdy/ir/enums.cc.inc"
 #define GET_ATTRDEF_CLASSES
 #include "shardy/dialect/sdy/ir/attrs.cc.inc"
+
+namespace mlir {
+namespace sdy {
+
+Attribute SdyDialect::parseAttribute(DialectAsmParser& parser,
+                                     Type type) const {
+  // The parser resets the lexer past the attribute once we return, so the fast
+  // path doesn't need to consume the tokens it parsed.
+  if (isShardingParseFastPathEnabled()) {
+    if (Attribute attr = parseShardingAttrFastPath(
+            getContext(), parser.getFullSymbolSpec())) {
+      return attr;
+    }
+  }
+  SMLoc typeLoc = parser.getCurrentLocation();
+  StringRef attrTag;
+  Attribute attr;
+  OptionalParseResult parseResult =
+      generatedAttributeParser(parser, &attrTag, type, attr);
+  if (parseResult.has_value()) {
+    return attr;
+  }
+  parser.emitError(typeLoc) << "unknown attribute `" << attrTag
+                            << "` in dialect `" << getNamespace() << "`";
+  return Attribute();
+}
+
+void SdyDialect::printAttribute(Attribute attr,
+                                DialectAsmPrinter& printer) const {
+  if (failed(generatedAttributePrinter(attr, printer))) {
+    llvm_unreachable("unhandled sdy attribute");
+  }
+}
+
+}  // namespace sdy
+}  // namespace mlir
+
 #define GET_OP_INTERFACE_CLASSES
 #include "shardy/dialect/sdy/ir/op_interface.cc.inc"
 #define GET_OP_CLASSES
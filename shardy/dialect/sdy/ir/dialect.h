@@ -22,23 +22,32 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <utility>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/RWMutex.h"
 #include "mlir/Bytecode/BytecodeImplementation.h"
 #include "mlir/Bytecode/BytecodeOpInterface.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Dialect.h"
 #include "mlir/IR/DialectImplementation.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Operation.h"
+#include "mlir/IR/OperationSupport.h"
 #include "mlir/IR/SymbolTable.h"
 #include "mlir/IR/Types.h"
 #include "mlir/IR/ValueRange.h"
@@ -53,6 +62,106 @@ limitations under the License.
 
 // IWYU pragma: end_keep
 
+namespace mlir {
+namespace sdy {
+
+// A thread-safe memo table of sharding rules keyed by op signature, i.e., the
+// op name, the operand and result types (as a `FunctionType`), the op
+// attributes that aren't owned by Shardy, and whether the rule is
+// conservative.
+//
+// The table is owned by the `SdyDialect`, so that its entries never outlive
+// the uniqued types and attributes they reference.
+//
+// The rule is stored as an `Attribute` since `OpShardingRuleAttr` isn't
+// declared yet. A null attribute means the op has no sharding rule.
+class ShardingRuleMemo {
+ public:
+  using Key = std::tuple<OperationName, Type, DictionaryAttr, unsigned>;
+
+  // Returns the memoized rule for `key` if present, and increments the hit or
+  // miss counter accordingly.
+  std::optional<Attribute> lookup(const Key& key);
+
+  void insert(const Key& key, Attribute rule);
+
+  // Removes all entries and resets the counters.
+  void clear();
+
+  int64_t getNumHits();
+  int64_t getNumMisses();
+
+ private:
+  llvm::sys::Mutex mutex;
+  llvm::DenseMap<Key, Attribute> rules;
+  int64_t numHits = 0;
+  int64_t numMisses = 0;
+};
+
+// A thread-safe set of the sharding verifications that succeeded, keyed by the
+// sharding, the type it's attached to, the mesh it refers to, and whether
+// divisibility was checked.
+//
+// The set is owned by the `SdyDialect`, so that its entries never outlive the
+// uniqued types and attributes they reference. Checks that depend on where the
+// sharding is used, i.e., on parent `ManualComputationOp`s, aren't covered.
+//
+// The sharding and mesh are stored as `Attribute`s since `TensorShardingAttr`
+// and `MeshAttr` aren't declared yet.
+class VerifiedShardingCache {
+ public:
+  using Key = std::tuple<Attribute, Type, Attribute, bool>;
+
+  // Returns whether `key` was verified successfully.
+  bool contains(const Key& key);
+
+  void insert(const Key& key);
+
+  // Removes all entries.
+  void clear();
+
+ private:
+  llvm::sys::SmartRWMutex<true> mutex;
+  llvm::DenseSet<Key> verified;
+};
+
+// A thread-safe map from each sharding to its canonical form w.r.t.
+// `TensorShardingAttr::isEquivalent`, keyed by the sharding and whether
+// unreduced axes are ignored.
+//
+// The map is owned by the `SdyDialect`, so that its entries never outlive the
+// uniqued attributes they reference. It's cleared when it reaches `kMaxSize`
+// entries, so it doesn't grow for the whole lifetime of the context. The
+// shardings are stored as `Attribute`s since `TensorShardingAttr` isn't
+// declared yet, and a null canonical form means the sharding is fully
+// replicated.
+class CanonicalShardingCache {
+ public:
+  using Key = std::pair<Attribute, unsigned>;
+
+  static constexpr int64_t kMaxSize = 1 << 16;
+
+  // Returns the canonical form of `key` if present.
+  std::optional<Attribute> lookup(const Key& key);
+
+  // Inserts `canonicalSharding` for `key`, after removing all entries if the
+  // cache is full.
+  void insert(const Key& key, Attribute canonicalSharding);
+
+  // Returns the number of entries.
+  int64_t size();
+
+  // Removes all entries.
+  void clear();
+
+ private:
+  llvm::sys::SmartRWMutex<true> mutex;
+  llvm::DenseMap<Key, Attribute> canonicalShardings;
+};
+
+}  // namespace sdy
+}  // namespace mlir
+
 // IWYU pragma: begin_exports
 
 // Dialect main class is defined in ODS, we include it here.
@@ -95,7 +204,7 @@ struct SdyDialectVersion : public mlir::DialectVersion {
   }
 
   // Current version of Shardy dialect.
-  static SdyDialectVersion getCurrentVersion() { return {0, 0, 2}; }
+  static SdyDialectVersion getCurrentVersion() { return {0, 0, 3}; }
 
   // Minimum supported version of Shardy dialect.
   static SdyDialectVersion getMinimumVersion() { return {0, 0, 1}; }
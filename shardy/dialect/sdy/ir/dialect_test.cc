@@ -17,11 +17,22 @@ limitations under the License.
 
 #include <cstdint>
 #include <optional>
+#include <string>
 
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/AsmParser/AsmParser.h"
+#include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Location.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
 #include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include "shardy/dialect/sdy/ir/parsers.h"
 #include "shardy/dialect/sdy/ir/testing_utils.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -32,6 +43,7 @@ namespace sdy {
 namespace {
 
 using ::testing::HasSubstr;
+using ::testing::Not;
 
 class DialectTest : public ShardyTestBase {
  protected:
@@ -850,6 +862,176 @@ TEST_F(DialectTest, MeshAttrEquals) {
   }
 }
 
+TEST_F(DialectTest, TensorShardingAttrVerifyForTypeCachesValidShardings) {
+  MeshAttr mesh = createMesh({{"x", 2}, {"y", 4}});
+  auto type = RankedTensorType::get({8, 6}, Builder(&context).getF32Type());
+  TensorShardingAttr sharding =
+      createTensorSharding({createDimSharding({createAxis("x")}),
+                            createDimSharding({createAxis("y")})});
+  VerifiedShardingCache& cache =
+      context.getLoadedDialect<SdyDialect>()->getVerifiedShardingCache();
+  auto emitError = [&](StringRef msg) {
+    return mlir::emitError(UnknownLoc::get(&context), msg);
+  };
+  // Swallow the error of the invalid sharding below.
+  ScopedDiagnosticHandler diagnosticHandler(
+      &context, [](Diagnostic&) { return success(); });
+
+  EXPECT_FALSE(cache.contains({sharding, type, mesh, false}));
+  EXPECT_TRUE(succeeded(sharding.verifyForType(type, mesh, emitError,
+                                               /*checkDivisibility=*/false)));
+  EXPECT_TRUE(cache.contains({sharding, type, mesh, false}));
+  EXPECT_TRUE(succeeded(sharding.verifyForType(type, mesh, emitError,
+                                               /*checkDivisibility=*/false)));
+
+  // Dim 1 with size 6 isn't divisible by its sharded size 4.
+  EXPECT_TRUE(failed(sharding.verifyForType(type, mesh, emitError,
+                                            /*checkDivisibility=*/true)));
+  EXPECT_FALSE(cache.contains({sharding, type, mesh, true}));
+}
+
+TEST_F(DialectTest, TensorShardingAttrGetCanonicalForm) {
+  TensorShardingAttr canonical =
+      createTensorSharding({createDimSharding({createAxis("x")}, true),
+                            createDimSharding({}, true)});
+  EXPECT_EQ(canonical.getCanonicalForm(), canonical);
+
+  // Open dimensions, priorities and replicated axes don't matter.
+  TensorShardingAttr sharding = createTensorSharding(
+      {DimensionShardingAttr::get(&context, {createAxis("x")},
+                                  /*isClosed=*/false, /*priority=*/1),
+       createDimSharding({})},
+      /*replicatedAxes=*/{createAxis("y")});
+  EXPECT_EQ(sharding.getCanonicalForm(), canonical);
+  EXPECT_TRUE(sharding.isEquivalent(canonical));
+
+  // Unreduced axes only matter if they aren't ignored.
+  TensorShardingAttr unreducedSharding =
+      createTensorSharding({createDimSharding({createAxis("x")}),
+                            createDimSharding({})},
+                           /*replicatedAxes=*/{},
+                           /*unreducedAxes=*/{createAxis("y")});
+  EXPECT_NE(unreducedSharding.getCanonicalForm(), canonical);
+  EXPECT_EQ(unreducedSharding.getCanonicalForm(/*ignoreUnreducedAxes=*/true),
+            canonical);
+
+  // A fully replicated sharding has a null canonical form.
+  TensorShardingAttr replicated = createTensorSharding(
+      {createDimSharding({}), createDimSharding({}, true)});
+  EXPECT_FALSE(replicated.getCanonicalForm());
+  EXPECT_TRUE(replicated.isEquivalent(TensorShardingAttr()));
+  EXPECT_FALSE(sharding.isEquivalent(replicated));
+}
+
+TEST_F(DialectTest, TensorShardingAttrIsEquivalentSkipsCacheIfEqual) {
+  CanonicalShardingCache& cache =
+      context.getLoadedDialect<SdyDialect>()->getCanonicalShardingCache();
+  TensorShardingAttr sharding =
+      createTensorSharding({createDimSharding({createAxis("x")})});
+  int64_t sizeBefore = cache.size();
+  EXPECT_TRUE(sharding.isEquivalent(sharding));
+  EXPECT_EQ(cache.size(), sizeBefore);
+}
+
+TEST_F(DialectTest, CanonicalShardingCacheIsBounded) {
+  CanonicalShardingCache& cache =
+      context.getLoadedDialect<SdyDialect>()->getCanonicalShardingCache();
+  cache.clear();
+  TensorShardingAttr sharding =
+      createTensorSharding({createDimSharding({createAxis("x")})});
+  for (unsigned i = 0; i < CanonicalShardingCache::kMaxSize; ++i) {
+    cache.insert({sharding, i}, sharding);
+  }
+  EXPECT_EQ(cache.size(), CanonicalShardingCache::kMaxSize);
+  EXPECT_TRUE(cache.lookup({sharding, 0}));
+
+  // Inserting into a full cache removes all previous entries.
+  cache.insert({sharding, CanonicalShardingCache::kMaxSize}, sharding);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_FALSE(cache.lookup({sharding, 0}));
+  EXPECT_TRUE(cache.lookup({sharding, CanonicalShardingCache::kMaxSize}));
+}
+
+TEST_F(DialectTest, ShardingParseFastPathMatchesGeneratedParser) {
+  auto* dialect = context.getLoadedDialect<SdyDialect>();
+  for (StringRef str : {
+           R"(#sdy.sharding<@mesh, []>)",
+           R"(#sdy.sharding<@mesh, [{"a"}, {}]>)",
+           R"(#sdy.sharding<@mesh, [{"a":(2)4, "b"}, {?}, {"c", ?}p1]>)",
+           R"(#sdy.sharding<@"mesh", [ {"a"}p0 , { } ]>)",
+           R"(#sdy.sharding<@mesh, [{"a"}], replicated={"b"}>)",
+           R"(#sdy.sharding_per_value<[]>)",
+           R"(#sdy.sharding_per_value<[<@mesh, [{"a"}]>, <@mesh, [{?}]>]>)",
+       }) {
+    dialect->setShardingParseFastPathEnabled(true);
+    Attribute fastPathAttr = parseAttribute(str, &context);
+    dialect->setShardingParseFastPathEnabled(false);
+    Attribute generatedAttr = parseAttribute(str, &context);
+    EXPECT_TRUE(generatedAttr) << str.str();
+    EXPECT_EQ(fastPathAttr, generatedAttr) << str.str();
+  }
+}
+
+TEST_F(DialectTest, ShardingParseFastPathOnlyAcceptsCommonForm) {
+  EXPECT_TRUE(parseShardingAttrFastPath(
+      &context, R"(sharding<@mesh, [{"a"}, {"b", ?}p2]>)"));
+  EXPECT_TRUE(parseShardingAttrFastPath(
+      &context, R"(sharding_per_value<[<@mesh, [{}]>]>)"));
+
+  EXPECT_FALSE(parseShardingAttrFastPath(
+      &context, R"(sharding<@mesh, [{"a"}], replicated={"b"}>)"));
+  EXPECT_FALSE(parseShardingAttrFastPath(
+      &context, R"(sharding<mesh<["a"=2]>, [{"a"}]>)"));
+  EXPECT_FALSE(
+      parseShardingAttrFastPath(&context, R"(sharding<@mesh, [{"a\"b"}]>)"));
+  EXPECT_FALSE(
+      parseShardingAttrFastPath(&context, R"(sharding<@mesh, [{"a"}p01]>)"));
+  EXPECT_FALSE(
+      parseShardingAttrFastPath(&context, R"(sharding<@ mesh, [{"a"}]>)"));
+  EXPECT_FALSE(
+      parseShardingAttrFastPath(&context, R"(sharding<@mesh, [{"a"}]> x)"));
+  EXPECT_FALSE(parseShardingAttrFastPath(
+      &context, R"(op_sharding_rule<([i])->([i]) {i=2}>)"));
+}
+
+TEST_F(DialectTest, ShardingAliasesArePrintedWhenEnabled) {
+  OwningOpRef<ModuleOp> module = parseSourceString<ModuleOp>(
+      R"mlir(
+    sdy.mesh @mesh = <["a"=2, "b"=2]>
+    func.func @main(
+        %arg0: tensor<8x8xf32> {
+          sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>},
+        %arg1: tensor<8x8xf32> {
+          sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>})
+        -> (tensor<8x8xf32> {
+          sdy.sharding = #sdy.sharding<@mesh, [{}, {"b"}]>}) {
+      %0 = stablehlo.add %arg0, %arg1 {
+        sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"b"}]>]>}
+        : tensor<8x8xf32>
+      return %0 : tensor<8x8xf32>
+    })mlir",
+      &context);
+  ASSERT_TRUE(module);
+  auto printModule = [&]() {
+    std::string str;
+    llvm::raw_string_ostream os(str);
+    module->print(os);
+    return str;
+  };
+
+  EXPECT_THAT(printModule(), Not(HasSubstr("#sharding")));
+
+  context.getLoadedDialect<SdyDialect>()->setShardingAliasesEnabled(true);
+  std::string str = printModule();
+  // Each distinct sharding is printed once, as an alias.
+  EXPECT_THAT(str, HasSubstr(R"(= #sdy.sharding<@mesh, [{"a"}, {}]>)"));
+  EXPECT_THAT(str, HasSubstr(R"(= #sdy.sharding<@mesh, [{}, {"b"}]>)"));
+  EXPECT_THAT(str, HasSubstr(R"(#shardings = #sdy.sharding_per_value<[<@mesh, )"
+                             R"([{}, {"b"}]>]>)"));
+  EXPECT_THAT(str, HasSubstr("{sdy.sharding = #sharding}"));
+  EXPECT_THAT(str, HasSubstr("{sdy.sharding = #shardings}"));
+}
+
 }  // namespace
 
 }  // namespace sdy
@@ -0,0 +1,137 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmark for parsing textual modules with many sharding annotations.
+//
+// Generates a module with a sharded argument and result per func, and a chain
+// of ops with a sharding each, and reports the wall time of parsing it with
+// and without the sharding fast path (see `parseShardingAttrFastPath`).
+//
+// Usage:
+//   parser_benchmark [--size=<n>] [--repetitions=<n>] [--filter=<regex>]
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include "shardy/common/benchmark_util.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/register.h"
+
+namespace mlir {
+namespace sdy {
+namespace {
+
+llvm::cl::opt<int64_t> sizeFlag(
+    "size",
+    llvm::cl::desc("The number of generated funcs, each with as many ops."),
+    llvm::cl::init(256));
+
+// Returns the sharding of the i-th generated value, cycling through sub-axes,
+// open dimensions and priorities.
+StringRef getSharding(int64_t i) {
+  switch (i % 4) {
+    case 0:
+      return R"(<@mesh, [{"data"}, {}]>)";
+    case 1:
+      return R"(<@mesh, [{}, {"model", ?}]>)";
+    case 2:
+      return R"(<@mesh, [{"data", "model":(1)2}p0, {?}]>)";
+    default:
+      return R"(<@mesh, [{"model":(2)4}, {"data"}p1]>)";
+  }
+}
+
+// `numFuncs` funcs, each with `numFuncs` ops that have a sharding.
+std::string generateModule(int64_t numFuncs) {
+  std::string str = R"mlir(sdy.mesh @mesh = <["data"=4, "model"=8]>
+)mlir";
+  llvm::raw_string_ostream os(str);
+  for (int64_t i = 0; i < numFuncs; ++i) {
+    os << llvm::formatv(
+        "func.func @f{0}(%arg0: tensor<64x64xf32> {{sdy.sharding = "
+        "#sdy.sharding{1}}) -> (tensor<64x64xf32> {{sdy.sharding = "
+        "#sdy.sharding{2}}) {{\n",
+        i, getSharding(i), getSharding(i + 1));
+    os << "  %v0 = stablehlo.negate %arg0 : tensor<64x64xf32>\n";
+    for (int64_t j = 0; j < numFuncs; ++j) {
+      os << llvm::formatv(
+          "  %v{0} = stablehlo.add %v{1}, %v{1} {{sdy.sharding = "
+          "#sdy.sharding_per_value<[{2}]>} : tensor<64x64xf32>\n",
+          j + 1, j, getSharding(i + j));
+    }
+    os << llvm::formatv("  return %v{0} : tensor<64x64xf32>\n}\n", numFuncs);
+  }
+  return str;
+}
+
+int runBenchmarks() {
+  std::string source = generateModule(sizeFlag);
+  BenchmarkTable table(/*nameWidth=*/24, {"size_mb"});
+  table.printHeader();
+  for (bool fastPath : {false, true}) {
+    StringRef name = fastPath ? "fast_path" : "generated_parser";
+    if (!shouldRunBenchmark(name)) {
+      continue;
+    }
+    std::optional<BenchmarkTimings> timings = timeRepeatedly([&]() {
+      // A fresh context per run, so that attributes uniqued by a previous run
+      // don't make the next one cheaper.
+      MLIRContext context;
+      loadAllRequiredDialects(&context);
+      context.getLoadedDialect<SdyDialect>()->setShardingParseFastPathEnabled(
+          fastPath);
+      // The module is destroyed after the timed run.
+      OwningOpRef<ModuleOp> module;
+      return timeRun([&]() {
+        module = parseSourceString<ModuleOp>(source, &context);
+        return success(static_cast<bool>(module));
+      });
+    });
+    if (!timings) {
+      llvm::errs() << "failed to parse generated module\n";
+      return 1;
+    }
+    table.printRow(
+        name,
+        {llvm::formatv("{0:F1}", source.size() / (1024.0 * 1024.0)).str()},
+        *timings);
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace sdy
+}  // namespace mlir
+
+int main(int argc, char** argv) {
+  llvm::InitLLVM initLLVM(argc, argv);
+  if (mlir::failed(mlir::sdy::parseBenchmarkCommandLine(
+          argc, argv, "SDY parser benchmark\n"))) {
+    return 1;
+  }
+  return mlir::sdy::runBenchmarks();
+}
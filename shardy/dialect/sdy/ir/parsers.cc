@@ -463,6 +463,236 @@ ParseResult parseMinus(AsmParser& parser, StringRef) {
   return success();
 }
 
+namespace {
+
+// A minimal lexer over the textual form of a sharding, which only accepts the
+// tokens of the common form, and fails on anything else (e.g., comments or
+// escaped strings), in which case the caller falls back to the `AsmParser`.
+class ShardingLexer {
+ public:
+  explicit ShardingLexer(StringRef text) : text(text) {}
+
+  bool atEnd() {
+    skipWhitespace();
+    return text.empty();
+  }
+
+  // Consumes `c` if it's the next token.
+  bool consumeIf(char c) {
+    skipWhitespace();
+    if (text.empty() || text.front() != c) {
+      return false;
+    }
+    text = text.drop_front();
+    return true;
+  }
+
+  // Returns whether the next token is `c`, without consuming it.
+  bool peek(char c) {
+    skipWhitespace();
+    return !text.empty() && text.front() == c;
+  }
+
+  // Parses a bare identifier, i.e., `(letter|_)(letter|digit|[_$.])*`.
+  bool parseBareIdentifier(StringRef& identifier) {
+    skipWhitespace();
+    return lexBareIdentifier(identifier);
+  }
+
+  // Parses a string literal without escape sequences, and sets `str` to its
+  // contents without the quotes.
+  bool parseString(StringRef& str) {
+    skipWhitespace();
+    return lexString(str);
+  }
+
+  // Parses a symbol reference, i.e., `@` immediately followed by a bare
+  // identifier or a string literal, and sets `name` to the symbol name.
+  bool parseSymbolRef(StringRef& name) {
+    skipWhitespace();
+    if (!text.consume_front("@")) {
+      return false;
+    }
+    return lexBareIdentifier(name) || lexString(name);
+  }
+
+  // Parses a non-negative decimal integer without leading zeros.
+  bool parseInteger(int64_t& value) {
+    skipWhitespace();
+    size_t size = 0;
+    while (size < text.size() && llvm::isDigit(text[size])) {
+      ++size;
+    }
+    StringRef digits = text.take_front(size);
+    if (digits.empty() || (digits.size() > 1 && digits.front() == '0') ||
+        !llvm::to_integer(digits, value)) {
+      return false;
+    }
+    text = text.drop_front(size);
+    return true;
+  }
+
+ private:
+  void skipWhitespace() { text = text.ltrim(" \t\n\r"); }
+
+  bool lexBareIdentifier(StringRef& identifier) {
+    if (text.empty() || !(llvm::isAlpha(text.front()) || text.front() == '_')) {
+      return false;
+    }
+    size_t size = 1;
+    while (size < text.size() && (llvm::isAlnum(text[size]) ||
+                                  StringRef("_$.").contains(text[size]))) {
+      ++size;
+    }
+    identifier = text.take_front(size);
+    text = text.drop_front(size);
+    return true;
+  }
+
+  bool lexString(StringRef& str) {
+    if (!text.consume_front("\"")) {
+      return false;
+    }
+    size_t size = text.find_first_of("\"\\\n");
+    if (size == StringRef::npos || text[size] != '"') {
+      return false;
+    }
+    str = text.take_front(size);
+    text = text.drop_front(size + 1);
+    return true;
+  }
+
+  StringRef text;
+};
+
+// Parses `"name"` or `"name":(preSize)size`.
+AxisRefAttr parseAxisRefFastPath(MLIRContext* context, ShardingLexer& lexer) {
+  StringRef name;
+  if (!lexer.parseString(name)) {
+    return AxisRefAttr();
+  }
+  if (!lexer.consumeIf(':')) {
+    return AxisRefAttr::get(context, name);
+  }
+  int64_t preSize, size;
+  if (!lexer.consumeIf('(') || !lexer.parseInteger(preSize) ||
+      !lexer.consumeIf(')') || !lexer.parseInteger(size)) {
+    return AxisRefAttr();
+  }
+  return AxisRefAttr::get(context, name, preSize, size);
+}
+
+// Parses `{<axes>[, ?]}` followed by an optional `p<priority>`.
+DimensionShardingAttr parseDimShardingFastPath(MLIRContext* context,
+                                               ShardingLexer& lexer) {
+  if (!lexer.consumeIf('{')) {
+    return DimensionShardingAttr();
+  }
+  SmallVector<AxisRefAttr> axes;
+  bool isClosed = true;
+  while (!lexer.consumeIf('}')) {
+    if (!axes.empty() && !lexer.consumeIf(',')) {
+      return DimensionShardingAttr();
+    }
+    if (lexer.consumeIf('?')) {
+      isClosed = false;
+      if (!lexer.consumeIf('}')) {
+        return DimensionShardingAttr();
+      }
+      break;
+    }
+    AxisRefAttr axisRef = parseAxisRefFastPath(context, lexer);
+    if (!axisRef) {
+      return DimensionShardingAttr();
+    }
+    axes.push_back(axisRef);
+  }
+
+  std::optional<int64_t> priority;
+  if (lexer.peek('p')) {
+    StringRef priorityStr;
+    if (!lexer.parseBareIdentifier(priorityStr) ||
+        !priorityStr.consume_front("p")) {
+      return DimensionShardingAttr();
+    }
+    ShardingLexer priorityLexer(priorityStr);
+    if (!priorityLexer.parseInteger(priority.emplace()) ||
+        !priorityLexer.atEnd()) {
+      return DimensionShardingAttr();
+    }
+  }
+  return DimensionShardingAttr::get(context, axes, isClosed, priority);
+}
+
+// Parses `<@mesh_name, [<dim_shardings>]>`.
+TensorShardingAttr parseTensorShardingFastPath(MLIRContext* context,
+                                               ShardingLexer& lexer) {
+  StringRef meshName;
+  if (!lexer.consumeIf('<') || !lexer.parseSymbolRef(meshName) ||
+      !lexer.consumeIf(',') || !lexer.consumeIf('[')) {
+    return TensorShardingAttr();
+  }
+  SmallVector<DimensionShardingAttr> dimShardings;
+  while (!lexer.consumeIf(']')) {
+    if (!dimShardings.empty() && !lexer.consumeIf(',')) {
+      return TensorShardingAttr();
+    }
+    DimensionShardingAttr dimSharding =
+        parseDimShardingFastPath(context, lexer);
+    if (!dimSharding) {
+      return TensorShardingAttr();
+    }
+    dimShardings.push_back(dimSharding);
+  }
+  // Replicated and unreduced axes are left to the `AsmParser`.
+  if (!lexer.consumeIf('>')) {
+    return TensorShardingAttr();
+  }
+  return TensorShardingAttr::get(context, meshName, dimShardings,
+                                 /*replicatedAxes=*/{}, /*unreducedAxes=*/{});
+}
+
+}  // namespace
+
+Attribute parseShardingAttrFastPath(MLIRContext* context, StringRef spec) {
+  ShardingLexer lexer(spec);
+  StringRef mnemonic;
+  if (!lexer.parseBareIdentifier(mnemonic)) {
+    return Attribute();
+  }
+
+  Attribute attr;
+  if (mnemonic == TensorShardingAttr::getMnemonic()) {
+    attr = parseTensorShardingFastPath(context, lexer);
+  } else if (mnemonic == TensorShardingPerValueAttr::getMnemonic()) {
+    if (!lexer.consumeIf('<') || !lexer.consumeIf('[')) {
+      return Attribute();
+    }
+    SmallVector<TensorShardingAttr> shardings;
+    while (!lexer.consumeIf(']')) {
+      if (!shardings.empty() && !lexer.consumeIf(',')) {
+        return Attribute();
+      }
+      TensorShardingAttr sharding = parseTensorShardingFastPath(context, lexer);
+      if (!sharding) {
+        return Attribute();
+      }
+      shardings.push_back(sharding);
+    }
+    if (!lexer.consumeIf('>')) {
+      return Attribute();
+    }
+    attr = TensorShardingPerValueAttr::get(context, shardings);
+  }
+
+  // The spec should end with the attribute, but if there is anything left we
+  // let the `AsmParser` report it.
+  if (!attr || !lexer.atEnd()) {
+    return Attribute();
+  }
+  return attr;
+}
+
 ParseResult ConstantOp::parse(OpAsmParser& parser, OperationState& result) {
   return hlo::parseConstantOp(parser, result);
 }
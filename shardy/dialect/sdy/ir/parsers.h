@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdint>
 
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/IR/Region.h"
 #include "mlir/Support/LLVM.h"
@@ -86,6 +87,16 @@ ParseResult parseStrippedTensorShardingPerValueAttr(
 // seems to be MLIR tblgen requires 2 arguments for a custom parser/printer.
 ParseResult parseMinus(AsmParser& parser, StringRef);
 
+// Parses `spec`, the full textual specification of an SDY attribute without
+// the dialect prefix, e.g., `sharding<@mesh, [{"a"}, {}]>`, with a dedicated
+// lexer rather than the `AsmParser`, if it's a `TensorShardingAttr` or
+// `TensorShardingPerValueAttr` in the common form, i.e., a mesh name and
+// dimension shardings without replicated or unreduced axes.
+//
+// Returns a null attribute for any other spec, including invalid ones, which
+// should then be parsed by the generated parser that also reports errors.
+Attribute parseShardingAttrFastPath(MLIRContext* context, StringRef spec);
+
 }  // namespace sdy
 }  // namespace mlir
 
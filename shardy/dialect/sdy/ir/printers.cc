@@ -18,6 +18,8 @@ limitations under the License.
 #include <cstdint>
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/OpImplementation.h"
@@ -31,9 +33,20 @@ limitations under the License.
 namespace mlir {
 namespace sdy {
 
+void printAxisRefList(raw_ostream& os, ArrayRef<AxisRefAttr> axisRefs) {
+  llvm::interleaveComma(axisRefs, os, [&](AxisRefAttr axisRef) {
+    os << '"';
+    llvm::printEscapedString(axisRef.getName(), os);
+    os << '"';
+    if (SubAxisInfoAttr subAxisInfo = axisRef.getSubAxisInfo()) {
+      os << ":(" << subAxisInfo.getPreSize() << ")" << subAxisInfo.getSize();
+    }
+  });
+}
+
 void DimensionShardingAttr::print(AsmPrinter& printer) const {
   printer << "{";
-  printer.printStrippedAttrOrType(getAxes());
+  printAxisRefList(printer.getStream(), getAxes());
   if (!getIsClosed()) {
     // Print {"a", ?}, but never {, ?}
     if (!emptyAxes()) {
@@ -68,7 +81,7 @@ void printOptionalNamedAxisList(AsmPrinter& printer, StringRef keyword,
                                 ArrayRef<AxisRefAttr> axisList) {
   if (!axisList.empty()) {
     printer << ", " << keyword << "={";
-    printer.printStrippedAttrOrType(axisList);
+    printAxisRefList(printer.getStream(), axisList);
     printer << "}";
   }
 }
@@ -90,7 +103,7 @@ void printReplicatedAndUnreducedAxes(AsmPrinter& printer,
       }
     }
     printer << "{";
-    printer.printStrippedAttrOrType(unreducedAxes);
+    printAxisRefList(printer.getStream(), unreducedAxes);
     printer << "}";
   }
 }
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cassert>
 #include <cstdint>
 
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/IR/Operation.h"
@@ -29,6 +30,11 @@ limitations under the License.
 namespace mlir {
 namespace sdy {
 
+// Prints `axisRefs` as a comma separated list of `"name"` or
+// `"name":(preSize)size`, the same as the generated printer of `AxisRefAttr`,
+// but directly to `os` rather than through an `AsmPrinter` per axis.
+void printAxisRefList(raw_ostream& os, ArrayRef<AxisRefAttr> axisRefs);
+
 void printMeshOrRef(AsmPrinter& printer, Attribute meshOrRef);
 
 // Prints each optional axis list as ", <keyword>={<axes>}", in a predefined
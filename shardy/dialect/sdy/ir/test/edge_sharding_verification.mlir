@@ -162,3 +162,15 @@ module {
     return %0 : tensor<8x8xf32>
   }
 }
+
+// -----
+
+module {
+  sdy.mesh @mesh1 = <["x"=4]>
+  sdy.mesh @mesh2 = <["y"=4]>
+  func.func @no_common_mesh(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh1, [{"x"}, {}]>}) -> (tensor<8x8xf32>) {
+    // expected-error @+1 {{expected a common mesh for propagation edges attr.}}
+    %0 = stablehlo.add %arg0, %arg0 {sdy.propagation_edges = #sdy.propagation_edges<[{step-0 = [{"x" = operand-0 -> [result-0]}]}]>, sdy.sharding = #sdy.sharding_per_value<[<@mesh2, [{"y"}, {}]>]>} : tensor<8x8xf32>
+    return %0 : tensor<8x8xf32>
+  }
+}
@@ -0,0 +1,36 @@
+// RUN: sdy_opt %s --emit-bytecode | sdy_opt --sdy-lazy-load-function=main | FileCheck %s
+
+// CHECK: sdy.mesh @mesh
+sdy.mesh @mesh = <["a"=2]>
+
+// CHECK-NOT: func.func private @unused
+func.func private @unused(%arg0: tensor<8xf32>) -> tensor<8xf32> {
+  %0 = stablehlo.negate %arg0 : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func.func @main
+func.func @main(%arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>}) -> tensor<8xf32> {
+  // CHECK-NEXT: call @callee
+  %0 = call @callee(%arg0) : (tensor<8xf32>) -> tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func.func private @callee
+func.func private @callee(%arg0: tensor<8xf32>) -> tensor<8xf32> {
+  // CHECK-NEXT: call @nested_callee
+  %0 = call @nested_callee(%arg0) : (tensor<8xf32>) -> tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func.func private @nested_callee
+func.func private @nested_callee(%arg0: tensor<8xf32>) -> tensor<8xf32> {
+  // CHECK-NEXT: stablehlo.abs
+  %0 = stablehlo.abs %arg0 : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// CHECK-NOT: func.func @other_public
+func.func @other_public(%arg0: tensor<8xf32>) -> tensor<8xf32> {
+  return %arg0 : tensor<8xf32>
+}
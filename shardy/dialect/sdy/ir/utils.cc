@@ -90,6 +90,29 @@ void replaceShardingAtIndex(Operation* op, unsigned index,
   }
 }
 
+void replaceShardingsAtIndices(Operation* op,
+                               ArrayRef<TensorShardingAttr> shardings) {
+  assert(shardings.size() == op->getNumResults());
+  auto firstShardingIt = llvm::find_if(
+      shardings, [](TensorShardingAttr sharding) { return sharding; });
+  if (firstShardingIt == shardings.end()) {
+    return;
+  }
+  SmallVector<TensorShardingAttr> newShardings;
+  if (TensorShardingPerValueAttr shardingPerResult = getShardingPerValue(op)) {
+    newShardings = llvm::to_vector(shardingPerResult.getShardings());
+  } else {
+    newShardings = getFullyOpenShardings(op->getContext(), op->getResultTypes(),
+                                         firstShardingIt->getMeshName());
+  }
+  for (auto [newSharding, sharding] : llvm::zip_equal(newShardings, shardings)) {
+    if (sharding) {
+      newSharding = sharding;
+    }
+  }
+  setShardings(op, newShardings);
+}
+
 void emitOpWarningOnce(llvm::once_flag& flag, Operation* op, StringRef msg) {
   llvm::call_once(flag, [=]() {
     InFlightDiagnostic diag = emitWarning(op->getLoc(), msg);
@@ -195,7 +218,13 @@ MeshAttr getMeshAttr(const SymbolTable& symbolTable, StringRef meshName) {
 
 MeshAttr getMeshAttr(const SymbolTable& symbolTable,
                      SymbolRefAttr meshSymName) {
-  return getMeshAttr(symbolTable, meshSymName.getLeafReference());
+  // Look up the `StringAttr` directly, rather than its `StringRef` which would
+  // be uniqued again by `SymbolTable::lookup`.
+  if (auto meshOp =
+          symbolTable.lookup<MeshOp>(meshSymName.getLeafReference())) {
+    return meshOp.getMesh();
+  }
+  return nullptr;
 }
 
 MeshAttr getMeshAttr(Operation* op, StringRef meshName) {
@@ -237,6 +266,53 @@ TensorShardingPerValueAttr inlineMesh(
                                          inlinedShardings);
 }
 
+TensorShardingAttr removeSizeOneAxes(TensorShardingAttr sharding,
+                                     const SymbolTable& symbolTable) {
+  MeshAttr mesh = sharding.getMesh(symbolTable);
+  assert(mesh && "unknown mesh");
+
+  auto isNotSizeOne = [&](AxisRefAttr axis) { return axis.getSize(mesh) != 1; };
+
+  // Remove from dimension shardings.
+  SmallVector<DimensionShardingAttr> dimShardings;
+  dimShardings.reserve(sharding.getRank());
+  for (DimensionShardingAttr dimSharding : sharding.getDimShardings()) {
+    SmallVector<AxisRefAttr> newAxes;
+    newAxes.reserve(dimSharding.getAxes().size());
+    llvm::copy_if(dimSharding.getAxes(), std::back_inserter(newAxes),
+                  isNotSizeOne);
+    // Remove priority if there are no sharding axes and the dimension is
+    // closed, since this isn't allowed by verification (would have no effect on
+    // propagation).
+    std::optional<int64_t> priority =
+        newAxes.empty() && dimSharding.getIsClosed()
+            ? std::nullopt
+            : dimSharding.getPriority();
+    dimShardings.push_back(
+        DimensionShardingAttr::get(dimSharding.getContext(), newAxes,
+                                   dimSharding.getIsClosed(), priority));
+  }
+
+  // Remove from replicated axes.
+  SmallVector<AxisRefAttr> replicatedAxes;
+  llvm::copy_if(sharding.getReplicatedAxes(),
+                std::back_inserter(replicatedAxes), isNotSizeOne);
+
+  // Remove from unreduced axes.
+  SmallVector<AxisRefAttr> unreducedAxes;
+  llvm::copy_if(sharding.getUnreducedAxes(), std::back_inserter(unreducedAxes),
+                isNotSizeOne);
+  if (dimShardings == sharding.getDimShardings() &&
+      replicatedAxes == sharding.getReplicatedAxes() &&
+      unreducedAxes == sharding.getUnreducedAxes()) {
+    return sharding;
+  }
+
+  return TensorShardingAttr::get(sharding.getContext(), sharding.getMeshOrRef(),
+                                 dimShardings, replicatedAxes, unreducedAxes,
+                                 sharding.getReductionOp());
+}
+
 Attribute getCommonMeshOrRef(ArrayRef<TensorShardingAttr> operandShardings,
                              ArrayRef<TensorShardingAttr> resultsShardings,
                              const SymbolTable& symbolTable,
@@ -24,6 +24,7 @@ limitations under the License.
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Threading.h"
@@ -59,6 +60,15 @@ bool inDialect(Operation* op) {
   return op->getDialect()->getNamespace() == Dialect::getDialectNamespace();
 }
 
+// Returns true if `root` or any op nested in it is an `OpTy`, stopping at the
+// first one found. This is a cheap check that passes targeting specific ops can
+// use to exit early, before any setup, on modules that don't have them.
+template <typename OpTy>
+bool containsOp(Operation* root) {
+  return root->walk([](OpTy) { return WalkResult::interrupt(); })
+      .wasInterrupted();
+}
+
 // Emits a warning once for the given `flag`, with `op` attached as a note
 // if `MLIRContext::shouldPrintOpOnDiagnostic` is true (assuming the op is
 // verified).
@@ -171,6 +181,12 @@ TensorShardingPerValueAttr inlineMesh(
     const SymbolTable& symbolTable,
     TensorShardingPerValueAttr shardingPerValue);
 
+// Returns `sharding` without any axis of size one in its mesh, from the
+// dimension shardings, replicated and unreduced axes. Returns the same sharding
+// if it has no such axes.
+TensorShardingAttr removeSizeOneAxes(TensorShardingAttr sharding,
+                                     const SymbolTable& symbolTable);
+
 // Returns the common mesh (or a reference to it) bound by all the
 // `TensorShardingAttr`s or nullptr if there is none.
 //
@@ -232,6 +248,23 @@ std::optional<StringRef> getCommonMeshName(
 //   - 18 -> 'z_1'
 std::string factorSymbolString(int64_t factor);
 
+// Prints `attr` to `os` without dialect wrapping.
+//
+// If `stripMnemonic` is true, also strips the mnemonic of the attribute, in
+// which case the attribute is first printed to a stack buffer.
+template <class AttrTy>
+void printStrippedAttr(raw_ostream& os, AttrTy attr,
+                       bool stripMnemonic = false) {
+  if (!stripMnemonic) {
+    attr.printStripped(os);
+    return;
+  }
+  SmallString<128> buffer;
+  llvm::raw_svector_ostream bufferOs(buffer);
+  attr.printStripped(bufferOs);
+  os << buffer.str().drop_front(attr.getMnemonic().size());
+}
+
 // Returns the string representation of `attr` without dialect wrapping
 //
 // If `stripMnemonic` is true, also strips the mnemonic of the attribute.
@@ -239,10 +272,7 @@ template <class AttrTy>
 std::string strippedAttrString(AttrTy attr, bool stripMnemonic = false) {
   std::string result;
   llvm::raw_string_ostream os(result);
-  attr.printStripped(os);
-  if (stripMnemonic) {
-    result.erase(0, attr.getMnemonic().size());
-  }
+  printStrippedAttr(os, attr, stripMnemonic);
   return result;
 }
 
@@ -256,7 +286,7 @@ std::string strippedAttrsString(ArrayRef<AttrTy> attrs,
   std::string result = "[";
   llvm::raw_string_ostream os(result);
   llvm::interleaveComma(attrs, os, [&](AttrTy attr) {
-    os << strippedAttrString(attr, stripMnemonic);
+    printStrippedAttr(os, attr, stripMnemonic);
   });
   result += "]";
   return result;
@@ -330,6 +360,12 @@ TensorShardingAttr getOrCreateSharding(Value value, Attribute meshOrRef,
 void replaceShardingAtIndex(Operation* op, unsigned index,
                             TensorShardingAttr sharding);
 
+// Same as `replaceShardingAtIndex`, but replaces the sharding at every index
+// with a non-null sharding in `shardings`, which has a sharding per result of
+// `op`, building a single `TensorShardingPerValueAttr`.
+void replaceShardingsAtIndices(Operation* op,
+                               ArrayRef<TensorShardingAttr> shardings);
+
 // Sets the sharding of the given `value`, whose location depends on the type of
 // the value, to `sharding`.
 //
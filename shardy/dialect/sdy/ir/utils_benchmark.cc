@@ -0,0 +1,257 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Microbenchmark for the axis utilities on the hot path of propagation.
+//
+// Generates meshes with 2 to 6 axes, and for each a set of axis lists mixing
+// full axes and sub-axes, and reports the time per call of each utility (e.g.,
+// `sortAndMergeAxes`, `getAxisSetDiff` and `AxisListRef` comparisons) over
+// all lists, or all consecutive pairs of lists. Benchmarks are named
+// `<utility>/<num_axes>`.
+//
+// Usage:
+//   utils_benchmark [--iterations=<n>] [--repetitions=<n>] [--filter=<regex>]
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include "shardy/common/benchmark_util.h"
+#include "shardy/dialect/sdy/ir/axis_list_ref.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/register.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+
+namespace mlir {
+namespace sdy {
+namespace {
+
+llvm::cl::opt<int64_t> iterationsFlag(
+    "iterations",
+    llvm::cl::desc("The number of passes over all axis lists per timed run."),
+    llvm::cl::init(1000));
+
+constexpr int64_t kMinNumAxes = 2;
+constexpr int64_t kMaxNumAxes = 6;
+constexpr int64_t kAxisSize = 8;
+constexpr int64_t kNumAxisLists = 64;
+
+// Results of the benchmarked calls are accumulated here, so that the compiler
+// can't drop the calls.
+volatile int64_t sink = 0;
+
+void consume(int64_t value) { sink = sink + value; }
+
+// A mesh and the axis lists the utilities are called on.
+struct Fixture {
+  std::string meshName;
+  MeshAttr mesh;
+  SmallVector<SmallVector<AxisRefAttr>> axisLists;
+};
+
+// Returns the name of the `i`-th axis of a generated mesh.
+std::string getAxisName(int64_t i) { return llvm::formatv("a{0}", i).str(); }
+
+// Generates a mesh with `numAxes` axes, and `kNumAxisLists` axis lists of
+// increasing length, each starting at a different axis. Every axis in a list
+// is either a full axis, a single sub-axis, or two adjacent sub-axes that
+// `sortAndMergeAxes` merges back into a full axis.
+Fixture generateFixture(MLIRContext* context, int64_t numAxes) {
+  Fixture fixture;
+  fixture.meshName = llvm::formatv("mesh{0}", numAxes).str();
+  SmallVector<MeshAxisAttr> meshAxes;
+  for (int64_t i = 0; i < numAxes; ++i) {
+    meshAxes.push_back(MeshAxisAttr::get(context, getAxisName(i), kAxisSize));
+  }
+  fixture.mesh = MeshAttr::get(context, meshAxes);
+
+  for (int64_t k = 0; k < kNumAxisLists; ++k) {
+    SmallVector<AxisRefAttr>& axes = fixture.axisLists.emplace_back();
+    for (int64_t j = 0; j <= k % numAxes; ++j) {
+      std::string name = getAxisName((k + j) % numAxes);
+      switch ((k + j) % 3) {
+        case 0:
+          axes.push_back(AxisRefAttr::get(context, name));
+          break;
+        case 1:
+          axes.push_back(AxisRefAttr::get(context, name, /*preSize=*/2,
+                                          /*size=*/4));
+          break;
+        default:
+          axes.push_back(AxisRefAttr::get(context, name, /*preSize=*/4,
+                                          /*size=*/2));
+          axes.push_back(AxisRefAttr::get(context, name, /*preSize=*/1,
+                                          /*size=*/4));
+          break;
+      }
+    }
+  }
+  return fixture;
+}
+
+// Calls `fn` on each consecutive pair of axis lists of `fixture`, wrapping
+// around at the end.
+void forEachPair(
+    const Fixture& fixture,
+    llvm::function_ref<void(ArrayRef<AxisRefAttr>, ArrayRef<AxisRefAttr>)>
+        fn) {
+  const auto& lists = fixture.axisLists;
+  for (auto [i, list] : llvm::enumerate(lists)) {
+    fn(list, lists[(i + 1) % lists.size()]);
+  }
+}
+
+struct Benchmark {
+  StringRef name;
+  // Calls the utility once per axis list, or pair of axis lists, of the
+  // fixture.
+  std::function<void(const Fixture&)> run;
+};
+
+SmallVector<Benchmark> getBenchmarks() {
+  return {
+      {"sort_and_merge_axes",
+       [](const Fixture& fixture) {
+         for (ArrayRef<AxisRefAttr> list : fixture.axisLists) {
+           SmallVector<AxisRefAttr> axes(list.rbegin(), list.rend());
+           sortAndMergeAxes(axes, fixture.mesh);
+           consume(axes.size());
+         }
+       }},
+      {"get_greatest_common_prefix",
+       [](const Fixture& fixture) {
+         forEachPair(fixture, [](ArrayRef<AxisRefAttr> first,
+                                 ArrayRef<AxisRefAttr> second) {
+           consume(getGreatestCommonPrefix(first, second).size());
+         });
+       }},
+      {"get_axis_set_diff",
+       [](const Fixture& fixture) {
+         forEachPair(fixture, [&](ArrayRef<AxisRefAttr> first,
+                                  ArrayRef<AxisRefAttr> second) {
+           consume(getAxisSetDiff(first, second, fixture.mesh).size());
+         });
+       }},
+      {"truncate_axes_by_removing_overlaps",
+       [](const Fixture& fixture) {
+         forEachPair(fixture, [](ArrayRef<AxisRefAttr> first,
+                                 ArrayRef<AxisRefAttr> second) {
+           SmallVector<AxisRefAttr> axes(first);
+           truncateAxesByRemovingOverlaps(axes, second);
+           consume(axes.size());
+         });
+       }},
+      {"axis_list_ref_less",
+       [](const Fixture& fixture) {
+         forEachPair(fixture, [](ArrayRef<AxisRefAttr> first,
+                                 ArrayRef<AxisRefAttr> second) {
+           consume(AxisListRef(first) < AxisListRef(second));
+         });
+       }},
+      {"axis_list_ref_strict_prefix_of",
+       [](const Fixture& fixture) {
+         forEachPair(fixture, [](ArrayRef<AxisRefAttr> first,
+                                 ArrayRef<AxisRefAttr> second) {
+           consume(AxisListRef(first).strictPrefixOf(AxisListRef(second)));
+         });
+       }},
+      {"get_total_axes_size",
+       [](const Fixture& fixture) {
+         for (ArrayRef<AxisRefAttr> list : fixture.axisLists) {
+           consume(getTotalAxesSize(list, fixture.mesh));
+         }
+       }},
+      {"tensor_sharding_get",
+       [](const Fixture& fixture) {
+         MLIRContext* context = fixture.mesh.getContext();
+         forEachPair(fixture, [&](ArrayRef<AxisRefAttr> first,
+                                  ArrayRef<AxisRefAttr> second) {
+           // The two lists can overlap, which is fine since the sharding isn't
+           // verified.
+           auto sharding = TensorShardingAttr::get(
+               context, fixture.meshName,
+               {DimensionShardingAttr::get(context, first, /*isClosed=*/true),
+                DimensionShardingAttr::get(context, second,
+                                           /*isClosed=*/false)},
+               /*replicatedAxes=*/{}, /*unreducedAxes=*/{});
+           consume(sharding.getRank());
+         });
+       }},
+  };
+}
+
+int runBenchmarks() {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  applyThreadingFlag(&context);
+
+  int64_t iterations = std::max<int64_t>(iterationsFlag, 1);
+  BenchmarkTable table(/*nameWidth=*/40, /*columns=*/{},
+                       BenchmarkTable::TimeUnit::kNanoseconds);
+  table.printHeader();
+  for (int64_t numAxes = kMinNumAxes; numAxes <= kMaxNumAxes; ++numAxes) {
+    Fixture fixture = generateFixture(&context, numAxes);
+    for (const Benchmark& benchmark : getBenchmarks()) {
+      std::string name =
+          llvm::formatv("{0}/{1}", benchmark.name, numAxes).str();
+      if (!shouldRunBenchmark(name)) {
+        continue;
+      }
+      // Untimed warm-up run, so that attributes are already uniqued.
+      benchmark.run(fixture);
+      std::optional<BenchmarkTimings> timings = timeRepeatedly([&]() {
+        return timeRun([&]() {
+          for (int64_t j = 0; j < iterations; ++j) {
+            benchmark.run(fixture);
+          }
+          return success();
+        });
+      });
+      assert(timings && "expected the utilities to succeed");
+      // Report the time per call rather than per run.
+      double numCalls = static_cast<double>(iterations) * kNumAxisLists;
+      table.printRow(name, /*values=*/{},
+                     {timings->minMs / numCalls, timings->medianMs / numCalls});
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace sdy
+}  // namespace mlir
+
+int main(int argc, char** argv) {
+  llvm::InitLLVM initLLVM(argc, argv);
+  if (mlir::failed(mlir::sdy::parseBenchmarkCommandLine(
+          argc, argv, "SDY utils benchmark\n"))) {
+    return 1;
+  }
+  return mlir::sdy::runBenchmarks();
+}
@@ -823,6 +823,41 @@ TEST_F(UtilsTest, GetMainFuncOrDie_UseSingleFunc_NoMain) {
                "Failed to lookup function: main");
 }
 
+TEST_F(UtilsTest, ReplaceShardingsAtIndices) {
+  context.allowUnregisteredDialects();
+  auto localModule = mlir::parseSourceString<ModuleOp>(
+      "module {\n"
+      "  sdy.mesh @mesh = <[\"a\"=2]>\n"
+      "  func.func @main() {\n"
+      "    %0:3 = \"test.op\"() : () -> (tensor<8xf32>, tensor<8xf32>, "
+      "tensor<8xf32>)\n"
+      "    return\n"
+      "  }\n"
+      "}",
+      &context);
+  ASSERT_TRUE(localModule);
+  Operation* op =
+      &cast<func::FuncOp>(localModule->lookupSymbol("main")).front().front();
+  auto sharding = TensorShardingAttr::get(
+      &context, "mesh",
+      {DimensionShardingAttr::get(&context, {AxisRefAttr::get(&context, "a")},
+                                  /*isClosed=*/true)},
+      /*replicatedAxes=*/{}, /*unreducedAxes=*/{});
+  TensorShardingAttr openSharding =
+      TensorShardingAttr::getFullyOpen(&context, /*rank=*/1, "mesh");
+
+  // Without existing shardings, the other results are fully open.
+  replaceShardingsAtIndices(op, {TensorShardingAttr(), sharding,
+                                 TensorShardingAttr()});
+  EXPECT_THAT(getShardings(op),
+              ElementsAre(openSharding, sharding, openSharding));
+
+  // Otherwise, the other results keep their sharding.
+  replaceShardingsAtIndices(op, {sharding, TensorShardingAttr(),
+                                 TensorShardingAttr()});
+  EXPECT_THAT(getShardings(op), ElementsAre(sharding, sharding, openSharding));
+}
+
 }  // namespace
 
 }  // namespace sdy
@@ -97,6 +97,44 @@ MeshAttr getMeshSafe(TensorShardingAttr sharding, Operation* op) {
   return nullptr;
 }
 
+// Returns the common `MeshAttr` of `shardings`, ignoring empty meshes, or
+// nullptr if there is none. Looks up meshes with `getMeshSafe`, so this can be
+// used by verifiers that run in parallel.
+MeshAttr getCommonMeshSafe(ArrayRef<TensorShardingAttr> shardings,
+                           Operation* op) {
+  MeshAttr mesh;
+  Attribute meshOrRef;
+  for (TensorShardingAttr sharding : shardings) {
+    // Shardings usually reference the same mesh, so it's only looked up once.
+    if (mesh && !mesh.empty() && sharding.getMeshOrRef() == meshOrRef) {
+      continue;
+    }
+    MeshAttr otherMesh = getMeshSafe(sharding, op);
+    if (!otherMesh) {
+      return nullptr;
+    }
+    if (!mesh || mesh.empty()) {
+      mesh = otherMesh;
+      meshOrRef = sharding.getMeshOrRef();
+      continue;
+    }
+    if (!otherMesh.empty() && !otherMesh.equals(mesh)) {
+      return nullptr;
+    }
+  }
+  return mesh;
+}
+
+// Returns the symbol table of the module that contains `op`.
+//
+// Symbol-use verifiers should look up meshes in this table, which the
+// `symbolTableCollection` builds once per module for all ops it verifies,
+// rather than building a `SymbolTable` of their own.
+const SymbolTable& getModuleSymbolTable(
+    Operation* op, SymbolTableCollection& symbolTableCollection) {
+  return symbolTableCollection.getSymbolTable(op->getParentOfType<ModuleOp>());
+}
+
 // Verifies the following for `axisRefs`:
 //
 // - All axis names are present in `axisNameToSize`.
@@ -166,11 +204,15 @@ LogicalResult verifySortedAxisRefList(
 //
 // NOTE: this method assumes `subAxes` is sorted.
 LogicalResult verifySubAxes(ArrayRef<AxisRefAttr> subAxes, StringRef axisName,
-                            int64_t axisSize, MeshAttr mesh,
+                            int64_t axisSize,
                             const SmallDenseSet<AxisRefAttr>& seenAxisRefs,
                             EmitErrorFn emitError) {
+  // Look for the full axis by name rather than by getting its `AxisRefAttr`,
+  // which would require uniquing a new attribute.
   if (!subAxes.empty() &&
-      seenAxisRefs.contains(AxisRefAttr::get(mesh.getContext(), axisName))) {
+      llvm::any_of(seenAxisRefs, [&](AxisRefAttr axisRef) {
+        return !axisRef.getSubAxisInfo() && axisRef.getName() == axisName;
+      })) {
     return emitError("both sub-axis and full-axis are used for axis name: \"")
            << axisName << "\"";
   }
@@ -255,19 +297,15 @@ LogicalResult emitBoundAxisInManualComputationError(EmitErrorFn emitError,
 // - All sub-axes in `shardingAttr` (see `verifySubAxes`).
 // - There are no duplicate axis-refs or sub-axes that overlap with one another
 //   across all fields.
-// - If `alreadyManualAxes` is not empty, then it verifies that when
-//   shardingAttr is inside a ManualComputationOp (possibly
-//   nested), then it only operates on axes not already marked as manual.
 // - If a dimension sharding has a priority:
 //     -- The priority is greater than or equal to 0.
 //     -- The dimension has at least one axis if it is closed.
 // - If `checkDivisibility` is true, verifies that each dimension size
 //   is divisible by its sharded size.
-LogicalResult verifyTensorShardingAttr(TensorShardingAttr shardingAttr,
-                                       Type type, MeshAttr mesh,
-                                       EmitErrorFn emitError,
-                                       bool checkDivisibility,
-                                       ManualAxisToOwner alreadyManualAxes) {
+LogicalResult verifyTensorShardingAttrForType(TensorShardingAttr shardingAttr,
+                                              Type type, MeshAttr mesh,
+                                              EmitErrorFn emitError,
+                                              bool checkDivisibility) {
   if (!mesh) {
     // We can assume the sharding has a mesh symbol name.
     return emitError("unknown mesh: ") << shardingAttr.getMeshSymName();
@@ -373,12 +411,57 @@ LogicalResult verifyTensorShardingAttr(TensorShardingAttr shardingAttr,
     int64_t axisSize = axisNameToSize[axisName];
     // We need to sort the sub-axes since this is assumed by `verifySubAxes`.
     llvm::sort(subAxes, AxisRefAttr::getMeshComparator(mesh));
-    if (failed(verifySubAxes(subAxes, axisName, axisSize, mesh, seenAxisRefs,
+    if (failed(verifySubAxes(subAxes, axisName, axisSize, seenAxisRefs,
                              emitError))) {
       return failure();
     }
   }
 
+  return success();
+}
+
+// Same as `verifyTensorShardingAttrForType`, but skips the verification if the
+// same sharding, type, mesh and `checkDivisibility` were already verified
+// successfully in this context, and otherwise remembers that they were, if
+// they are valid.
+//
+// Most shardings in a module are the same few uniqued attributes attached to
+// the same types, and they are verified again every time the verifier runs.
+LogicalResult verifyTensorShardingAttrForTypeOrLookup(
+    TensorShardingAttr shardingAttr, Type type, MeshAttr mesh,
+    EmitErrorFn emitError, bool checkDivisibility) {
+  auto* sdyDialect = shardingAttr.getContext()->getLoadedDialect<SdyDialect>();
+  if (!mesh || !sdyDialect) {
+    return verifyTensorShardingAttrForType(shardingAttr, type, mesh, emitError,
+                                           checkDivisibility);
+  }
+  VerifiedShardingCache& cache = sdyDialect->getVerifiedShardingCache();
+  VerifiedShardingCache::Key key(shardingAttr, type, mesh, checkDivisibility);
+  if (cache.contains(key)) {
+    return success();
+  }
+  if (failed(verifyTensorShardingAttrForType(shardingAttr, type, mesh,
+                                             emitError, checkDivisibility))) {
+    return failure();
+  }
+  cache.insert(key);
+  return success();
+}
+
+// Verifies `shardingAttr` (see `verifyTensorShardingAttrForType`), and if
+// `alreadyManualAxes` is not empty, i.e., `shardingAttr` is inside a
+// ManualComputationOp (possibly nested), that it only operates on axes not
+// already marked as manual.
+LogicalResult verifyTensorShardingAttr(TensorShardingAttr shardingAttr,
+                                       Type type, MeshAttr mesh,
+                                       EmitErrorFn emitError,
+                                       bool checkDivisibility,
+                                       ManualAxisToOwner alreadyManualAxes) {
+  if (failed(verifyTensorShardingAttrForTypeOrLookup(
+          shardingAttr, type, mesh, emitError, checkDivisibility))) {
+    return failure();
+  }
+
   // Verify all sharding and replicated axes don't already exist as a manual
   // axis due to a parent ManualComputationOp.
   if (!alreadyManualAxes.empty()) {
@@ -400,12 +483,19 @@ LogicalResult verifyTensorShardingAttr(TensorShardingAttr shardingAttr,
 }
 
 // Same as the overload above, but gets `alreadyManualAxes` from the given `op`.
+//
+// The parent ManualComputationOps are only collected if `shardingAttr` refers
+// to any axis, since most shardings in deeply nested manual computations are
+// fully open or replicated.
 LogicalResult verifyTensorShardingAttr(TensorShardingAttr shardingAttr,
                                        Type type, Operation* op, MeshAttr mesh,
                                        EmitErrorFn emitError) {
-  return verifyTensorShardingAttr(shardingAttr, type, mesh, emitError,
-                                  /*checkDivisibility=*/false,
-                                  getParentManualComputationOps(op));
+  bool hasAxisRefs =
+      shardingAttr.anyOfAxisRef([](AxisRefAttr) { return true; });
+  return verifyTensorShardingAttr(
+      shardingAttr, type, mesh, emitError,
+      /*checkDivisibility=*/false,
+      hasAxisRefs ? getParentManualComputationOps(op) : ManualAxisToOwner());
 }
 
 // Same as the overload above, but looks up the mesh using the given `op`.
@@ -432,8 +522,7 @@ LogicalResult verifyTensorShardingAttr(
     TensorShardingAttr shardingAttr, Type type, Operation* op,
     SymbolTableCollection& symbolTableCollection, EmitErrorFn emitError) {
   return verifyTensorShardingAttr(
-      shardingAttr, type, op,
-      symbolTableCollection.getSymbolTable(op->getParentOfType<ModuleOp>()),
+      shardingAttr, type, op, getModuleSymbolTable(op, symbolTableCollection),
       emitError);
 }
 
@@ -783,6 +872,13 @@ LogicalResult MeshAttr::verify(
 }
 
 LogicalResult MeshOp::verify() {
+  // A mesh directly in a symbol table is always found in it (possibly as a
+  // duplicate symbol, which the symbol table verifies), so the linear lookup
+  // below is only needed for meshes nested elsewhere.
+  if (Operation* parentOp = getOperation()->getParentOp();
+      parentOp && parentOp->hasTrait<OpTrait::SymbolTable>()) {
+    return success();
+  }
   if (!SymbolTable::lookupNearestSymbolFrom(*this, getSymNameAttr())) {
     return emitError() << "Mesh not in symbol table: @" << getSymName();
   }
@@ -974,6 +1070,8 @@ LogicalResult verifyManualComputationValue(
       // a token type.
       continue;
     }
+    // Safe to call `getMesh` because the sharding was already verified.
+    MeshAttr mesh = sharding.getMesh(symbolTable);
     for (auto [dimensionSize, dimSharding] : llvm::zip_equal(
              globalShapedType.getShape(), sharding.getDimShardings())) {
       if (dimensionSize == ShapedType::kDynamic) {
@@ -981,11 +1079,8 @@ LogicalResult verifyManualComputationValue(
       } else {
         // 5. The manual axes cannot introduce padding. The dimension size must
         //    be divisible by the corresponding manual axes size.
-
-        // Safe to call `getMesh` because the sharding was already verified.
-        int64_t manualAxesSize =
-            accumulatedManualAxesSize(op, dimSharding.getAxes(), manualAxesSet,
-                                      sharding.getMesh(symbolTable));
+        int64_t manualAxesSize = accumulatedManualAxesSize(
+            op, dimSharding.getAxes(), manualAxesSet, mesh);
         if (dimensionSize % manualAxesSize != 0) {
           return op->emitOpError(valueKindStr)
                  << " dimension size " << dimensionSize
@@ -1025,8 +1120,8 @@ mlir::LogicalResult TensorShardingAttr::verifyForType(
 
 LogicalResult ManualComputationOp::verifySymbolUses(
     SymbolTableCollection& symbolTableCollection) {
-  const SymbolTable& symbolTable = symbolTableCollection.getSymbolTable(
-      getOperation()->getParentOfType<ModuleOp>());
+  const SymbolTable& symbolTable =
+      getModuleSymbolTable(getOperation(), symbolTableCollection);
   llvm::SmallDenseSet<StringRef> manualAxesSet(getManualAxes().begin(),
                                                getManualAxes().end());
   if (failed(verifyManualComputationValue(
@@ -1165,8 +1260,9 @@ LogicalResult verifyPropagationEdgesShardingAttr(
         "expected propagation edges attr to reference a sharding.");
   }
 
-  MeshAttr mesh =
-      getCommonMesh(shardings, SymbolTable(op->getParentOfType<ModuleOp>()));
+  // This runs in parallel with the verification of other ops, so it can't
+  // build or use a `SymbolTable`.
+  MeshAttr mesh = getCommonMeshSafe(shardings, op);
   if (!mesh) {
     return op->emitOpError(
         "expected a common mesh for propagation edges attr.");
@@ -1270,7 +1366,7 @@ LogicalResult NamedComputationOp::verifySymbolUses(
   // TODO(pxy): remove this once the `ShardableDataFlowOpInterface` is verified.
   // Verify the in/out shardings.
   const SymbolTable& symbolTable =
-      SymbolTable(getOperation()->getParentOfType<ModuleOp>());
+      getModuleSymbolTable(getOperation(), symbolTableCollection);
   if (inShardings && failed(verifyTensorShardingPerValueAttr(
                          *inShardings, getOperandTypes(), *this, symbolTable,
                          [this](StringRef msg) {
@@ -1306,8 +1402,8 @@ LogicalResult verifyCollectiveWithAxesPerDim(
   TensorShardingAttr resultSharding = op.getOutSharding();
   TensorShardingAttr operandSharding =
       getOrCreateSharding(op.getOperand(), resultSharding.getMeshOrRef());
-  MeshAttr mesh = resultSharding.getMesh(symbolTableCollection.getSymbolTable(
-      op->template getParentOfType<ModuleOp>()));
+  MeshAttr mesh =
+      resultSharding.getMesh(getModuleSymbolTable(op, symbolTableCollection));
 
   // 1. Verify all collective axes.
   SmallDenseSet<AxisRefAttr> seenAxisRefs;
@@ -1436,8 +1532,8 @@ LogicalResult ShardedToUnreducedOp::verifySymbolUses(
     expectedUnreducedAxes.append(shardedToUnreducedAxes.getValue().begin(),
                                  shardedToUnreducedAxes.getValue().end());
   }
-  MeshAttr mesh = getOutSharding().getMesh(symbolTableCollection.getSymbolTable(
-      getOperation()->getParentOfType<ModuleOp>()));
+  MeshAttr mesh = getOutSharding().getMesh(
+      getModuleSymbolTable(getOperation(), symbolTableCollection));
   sortAndMergeAxes(expectedUnreducedAxes, mesh);
 
   SmallVector<AxisRefAttr> outUnreducedAxes(
@@ -1456,8 +1552,8 @@ LogicalResult ReplicatedToUnreducedOp::verifySymbolUses(
     SymbolTableCollection& symbolTableCollection) {
   TensorShardingAttr operandSharding = getSharding(getOperand());
   TensorShardingAttr resultSharding = getOutSharding();
-  const SymbolTable& symbolTable = symbolTableCollection.getSymbolTable(
-      getOperation()->getParentOfType<ModuleOp>());
+  const SymbolTable& symbolTable =
+      getModuleSymbolTable(getOperation(), symbolTableCollection);
   MeshAttr mesh = resultSharding.getMesh(symbolTable);
 
   if (operandSharding.getDimShardings() != resultSharding.getDimShardings()) {
@@ -1538,8 +1634,8 @@ LogicalResult AllToAllOp::verifySymbolUses(
     SymbolTableCollection& symbolTableCollection) {
   TensorShardingAttr operandSharding = getSharding(getOperand());
   TensorShardingAttr resultSharding = getOutSharding();
-  MeshAttr mesh = resultSharding.getMesh(symbolTableCollection.getSymbolTable(
-      getOperation()->getParentOfType<ModuleOp>()));
+  MeshAttr mesh = resultSharding.getMesh(
+      getModuleSymbolTable(getOperation(), symbolTableCollection));
 
   ArrayRef<AllToAllParamAttr> params = getParams();
   // 1. Verify that the parameter list is not empty.
@@ -1653,8 +1749,8 @@ LogicalResult CollectivePermuteOp::verifySymbolUses(
     SymbolTableCollection& symbolTableCollection) {
   TensorShardingAttr operandSharding = getSharding(getOperand());
   TensorShardingAttr resultSharding = getOutSharding();
-  const SymbolTable& symbolTable = symbolTableCollection.getSymbolTable(
-      getOperation()->getParentOfType<ModuleOp>());
+  const SymbolTable& symbolTable =
+      getModuleSymbolTable(getOperation(), symbolTableCollection);
   MeshAttr mesh = resultSharding.getMesh(symbolTable);
   MeshAttr operandMesh = operandSharding.getMesh(symbolTable);
   if (mesh.getAxes() != operandMesh.getAxes()) {
@@ -1700,8 +1796,8 @@ LogicalResult AllReduceOp::verifySymbolUses(
   TensorShardingAttr resultSharding = getOutSharding();
   TensorShardingAttr operandSharding =
       getOrCreateSharding(getOperand(), resultSharding.getMeshOrRef());
-  MeshAttr mesh = resultSharding.getMesh(symbolTableCollection.getSymbolTable(
-      getOperation()->getParentOfType<ModuleOp>()));
+  MeshAttr mesh = resultSharding.getMesh(
+      getModuleSymbolTable(getOperation(), symbolTableCollection));
   // 1. Verify that the operand and result have equivalent shardings, ignoring
   // unreduced axes.
   if (!operandSharding.isEquivalent(resultSharding,
@@ -1786,10 +1882,13 @@ LogicalResult verifyCollectiveOp(Operation* rawOp) {
 
   // 3. Verify MeshAttr of result and operand is the same.
   if (!collectiveOp.allowDifferentMeshes()) {
-    MeshAttr operandMesh =
-        optionalOperandSharding
-            ? getMeshSafe(optionalOperandSharding, collectiveOp)
-            : nullptr;
+    MeshAttr operandMesh = nullptr;
+    if (optionalOperandSharding) {
+      operandMesh = optionalOperandSharding.getMeshOrRef() ==
+                            resultSharding.getMeshOrRef()
+                        ? resultMesh
+                        : getMeshSafe(optionalOperandSharding, collectiveOp);
+    }
     if (operandMesh && resultMesh != operandMesh) {
       return collectiveOp.emitOpError("result mesh does not match operand mesh")
                  .attachNote(collectiveOp.getTensor().getLoc())
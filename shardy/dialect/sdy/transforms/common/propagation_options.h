@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_SDY_TRANSFORMS_COMMON_PROPAGATION_OPTIONS_H_
 #define SHARDY_DIALECT_SDY_TRANSFORMS_COMMON_PROPAGATION_OPTIONS_H_
 
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace mlir {
@@ -54,6 +58,15 @@ struct PropagationOptions {
   // Whether to dedup functions fully regardless of the input/output shardings
   // of the funcs.
   bool dedupFunctionsFully = false;
+  // Whether to also dedup private funcs whose signatures and bodies are
+  // structurally equal after propagation, regardless of their origin.
+  bool dedupIdenticalFunctions = false;
+  // Whether to propagate through one copy of each func per distinct sharding
+  // signature of its calls, instead of flattening the call graph fully. Calls
+  // with the same operand and result shardings share a copy, and propagate
+  // through it via `sdy.func_data_flow_edge`s. Ignored if
+  // `dedupFunctionsFully` is true.
+  bool specializeFuncsByShardingContext = false;
   // Whether to update axes with non-divisible input/output shardings.
   bool updateNonDivisibleInputOutputShardings = true;
   // Whether to propagate shardings directly on a non-flat graph without
@@ -67,8 +80,74 @@ struct PropagationOptions {
   bool enableExplicitGatherScatterBatching = false;
   // Whether to disable splitting of sharded dimensions in ReshardOps.
   bool disableSplitReshardingDimensions = false;
+  // Whether to pick the common sharding of an op that minimizes the bytes
+  // communicated by explicit reshards, see `InsertExplicitReshardsPass`.
+  bool minimizeReshardedBytes = false;
+  // Whether to schedule explicit collectives as early as possible to overlap
+  // them with compute, see `ScheduleCollectivesForOverlapPass`.
+  bool scheduleCollectivesForOverlap = false;
+  // Whether to save a JSON report of the collectives in the partitioned module
+  // in `dumpDirectory` (or print it to stderr if empty), see
+  // `CollectiveStatisticsPass`.
+  bool dumpCollectiveStatistics = false;
+  // Whether to fuse chains of reshards before converting them to collectives,
+  // see `FuseReshardChainsPass`.
+  bool enableReshardChainFusion = false;
+  // Whether to fold chains of collectives in a single sweep before
+  // canonicalizing them, see `SimplifyCollectivesPass`.
+  bool enableCollectiveSimplification = false;
   // Whether to clear reverse op sharding on export.
   bool clearReverseOpSharding = false;
+  // Whether to propagate with a dedicated sharding worklist driver, instead of
+  // the greedy pattern rewrite driver. Both reach the same fixed point, but the
+  // former has far less overhead per propagation step.
+  bool enableWorklistPropagation = false;
+  // Whether to propagate the body of each loop, e.g., `stablehlo.while`, to a
+  // local fixed point before revisiting the ops outside it, so the body is only
+  // revisited when the sharding of a carried value changes. Implies
+  // `enableWorklistPropagation`, and only applies to sequential propagation.
+  bool enableLoopAwarePropagation = false;
+  // The path of a JSON file that maps op locations or value names to the
+  // measured cost of the collectives they caused, see `CollectiveProfile`.
+  // Aggressive propagation resolves conflicts across factors in favor of the
+  // tensors with the higher cost, so the reshards move to cheaper tensors.
+  // Empty means no profile.
+  llvm::StringRef collectiveProfile = "";
+  // Whether to seed each user-priority propagation iteration (other than the
+  // first) only with the ops affected by the shardings updated for that
+  // priority, instead of re-propagating the entire module.
+  bool enableIncrementalUserPriorityPropagation = false;
+  // Whether to seed each op-priority propagation step (other than the first)
+  // only with the ops whose propagation direction was restricted by a previous
+  // step, instead of re-propagating the entire module.
+  bool enableIncrementalOpPriorityPropagation = false;
+  // Whether to propagate independent functions of a non-flat call graph (see
+  // `enableNativeNonFlatSupport`) in parallel, synchronizing only at
+  // `sdy.func_data_flow_edge` ops. Falls back to sequential propagation if a
+  // sharding group exists.
+  bool enableParallelFuncPropagation = false;
+  // Whether to partition each function into weakly connected clusters, which
+  // are separated at ops whose sharding is fixed (closed sharding constraints
+  // and manual computations) and propagation barriers, and propagate them in
+  // parallel, synchronizing only at the boundaries between clusters. Falls
+  // back to sequential propagation if a sharding group exists.
+  bool enableParallelClusterPropagation = false;
+  // Whether to also propagate a copy of the module serially, and fail if the
+  // shardings differ from those of `enableParallelClusterPropagation`.
+  bool checkParallelClusterPropagation = false;
+  // Whether to collect per-op and per-pattern propagation counters, and save
+  // them as a JSON report in `dumpDirectory` (or print it to stderr if empty).
+  bool profilePropagation = false;
+  // The number of most recent propagation events (see `PropagationEventLog`)
+  // to record, as a cheaper alternative to `debugPropagationEdgeSharding` that
+  // keeps only the most recent edges. 0 means disabled.
+  int64_t propagationEventLogSize = 0;
+  // The names of the funcs (or of the named computations they were imported
+  // as) whose shardings were edited since the module was last propagated. If
+  // non-empty, propagation is seeded only with the ops in them, and assumes
+  // all other ops are already at a fixed point, e.g., when re-propagating a
+  // module that was propagated before with `avoidExportForPartitioning`.
+  llvm::ArrayRef<std::string> dirtyFuncs = {};
 };
 
 }  // namespace sdy
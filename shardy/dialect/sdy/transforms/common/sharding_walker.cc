@@ -112,7 +112,10 @@ void processShardings(
   for (auto [sharding, value] : llvm::zip_equal(shardings, values)) {
     newShardings.push_back(callback(sharding, value));
   }
-  setShardingsFn(newShardings);
+  // Avoid rebuilding the attribute holding the shardings if none changed.
+  if (ArrayRef<TensorShardingAttr>(newShardings) != shardings) {
+    setShardingsFn(newShardings);
+  }
 }
 
 // Same as above but for `TensorShardingPerValueAttr`.
@@ -0,0 +1,120 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Types.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/constants.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+
+namespace mlir {
+namespace sdy {
+
+CollectiveCostModel CollectiveCostModel::get(MeshOp meshOp, double latency) {
+  llvm::StringMap<double> axisToBandwidth;
+  if (auto bandwidths =
+          meshOp->getAttrOfType<DictionaryAttr>(kAxisBandwidthsAttr)) {
+    for (NamedAttribute namedAttr : bandwidths) {
+      if (auto floatAttr = dyn_cast<FloatAttr>(namedAttr.getValue())) {
+        axisToBandwidth[namedAttr.getName()] = floatAttr.getValueAsDouble();
+      } else if (auto intAttr = dyn_cast<IntegerAttr>(namedAttr.getValue())) {
+        axisToBandwidth[namedAttr.getName()] = intAttr.getInt();
+      }
+    }
+  }
+  return CollectiveCostModel(meshOp.getMesh(), std::move(axisToBandwidth),
+                             latency);
+}
+
+double CollectiveCostModel::getBandwidth(AxisRefAttr axisRef) const {
+  double bandwidth = axisToBandwidth.lookup(axisRef.getName());
+  return bandwidth > 0 ? bandwidth : 1.0;
+}
+
+double CollectiveCostModel::getMinBandwidth(ArrayRef<AxisRefAttr> axes) const {
+  double minBandwidth = std::numeric_limits<double>::max();
+  if (axes.empty()) {
+    for (MeshAxisAttr axis : mesh.getAxes()) {
+      minBandwidth = std::min(
+          minBandwidth,
+          getBandwidth(AxisRefAttr::get(mesh.getContext(), axis.getName())));
+    }
+  }
+  for (AxisRefAttr axisRef : axes) {
+    minBandwidth = std::min(minBandwidth, getBandwidth(axisRef));
+  }
+  return minBandwidth == std::numeric_limits<double>::max() ? 1.0
+                                                             : minBandwidth;
+}
+
+double CollectiveCostModel::getCost(CollectiveKind kind, int64_t localBytes,
+                                    ArrayRef<AxisRefAttr> axes) const {
+  double numDevices = 1;
+  for (AxisRefAttr axisRef : axes) {
+    numDevices *= axisRef.getSize(mesh);
+  }
+  double bytesSent = 0;
+  switch (kind) {
+    case CollectiveKind::kAllSlice:
+      // An all-slice doesn't communicate.
+      return 0.0;
+    case CollectiveKind::kAllGather:
+      // Each device receives the shards of all other devices in the group.
+      bytesSent = localBytes * (numDevices - 1);
+      break;
+    case CollectiveKind::kAllToAll:
+      // Each device keeps one chunk and sends the others.
+      bytesSent = localBytes * (numDevices - 1) / numDevices;
+      break;
+    case CollectiveKind::kCollectivePermute:
+      bytesSent = localBytes;
+      break;
+  }
+  return latency + bytesSent / getMinBandwidth(axes);
+}
+
+int64_t getElementTypeBytes(Type elementType) {
+  if (auto complexType = dyn_cast<ComplexType>(elementType)) {
+    return 2 * getElementTypeBytes(complexType.getElementType());
+  }
+  if (elementType.isIntOrIndexOrFloat() && !elementType.isIndex()) {
+    return llvm::divideCeil(elementType.getIntOrFloatBitWidth(), 8);
+  }
+  // Index and other element types are assumed to take 8 bytes.
+  return 8;
+}
+
+int64_t getLocalTensorBytes(RankedTensorType type, TensorShardingAttr sharding,
+                            MeshAttr mesh) {
+  int64_t numElements = 1;
+  for (auto [dimSize, dimSharding] :
+       llvm::zip_equal(type.getShape(), sharding.getDimShardings())) {
+    numElements *= llvm::divideCeil(dimSize, dimSharding.getShardedSize(mesh));
+  }
+  return numElements * getElementTypeBytes(type.getElementType());
+}
+
+}  // namespace sdy
+}  // namespace mlir
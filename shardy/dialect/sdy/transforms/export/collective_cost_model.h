@@ -0,0 +1,101 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_SDY_TRANSFORMS_EXPORT_COLLECTIVE_COST_MODEL_H_
+#define SHARDY_DIALECT_SDY_TRANSFORMS_EXPORT_COLLECTIVE_COST_MODEL_H_
+
+#include <cstdint>
+#include <utility>
+
+#include "llvm/ADT/StringMap.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Types.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+
+namespace mlir {
+namespace sdy {
+
+// The kinds of collectives a reshard is decomposed into.
+enum class CollectiveKind {
+  kAllGather,
+  kAllSlice,
+  kAllToAll,
+  kCollectivePermute,
+};
+
+// A cost model for collectives over the axes of a mesh, following the
+// latency-bandwidth model: a collective costs a fixed `latency`, plus the bytes
+// each device sends, divided by the bandwidth of the slowest axis the
+// collective communicates over.
+//
+// Axis bandwidths are relative, and are read from the `kAxisBandwidthsAttr`
+// of the mesh, e.g.:
+//
+// ```mlir
+// sdy.mesh @mesh = <["dcn"=2, "ici"=4]> {sdy.axis_bandwidths = {dcn = 1.0,
+//                                                              ici = 10.0}}
+// ```
+//
+// Axes without a bandwidth have a bandwidth of 1.
+class CollectiveCostModel {
+ public:
+  CollectiveCostModel(MeshAttr mesh, llvm::StringMap<double> axisToBandwidth,
+                      double latency = 0.0)
+      : mesh(mesh),
+        axisToBandwidth(std::move(axisToBandwidth)),
+        latency(latency) {}
+
+  // Creates a cost model for the mesh of `meshOp`, with the axis bandwidths
+  // of `meshOp` if present.
+  static CollectiveCostModel get(MeshOp meshOp, double latency = 0.0);
+
+  // Returns the bandwidth of the full axis of `axisRef`.
+  double getBandwidth(AxisRefAttr axisRef) const;
+
+  // Returns the cost of a collective of `kind` over `axes`, on a tensor whose
+  // size per device before the collective is `localBytes`.
+  //
+  // For a collective permute, `axes` are the axes whose device assignment
+  // changes, or empty if the order of all devices changes.
+  double getCost(CollectiveKind kind, int64_t localBytes,
+                 ArrayRef<AxisRefAttr> axes) const;
+
+ private:
+  // Returns the minimum bandwidth of `axes`, or of all axes in the mesh if
+  // `axes` is empty.
+  double getMinBandwidth(ArrayRef<AxisRefAttr> axes) const;
+
+  MeshAttr mesh;
+  llvm::StringMap<double> axisToBandwidth;
+  double latency;
+};
+
+// Returns the number of bytes of an element of `elementType`, rounding sub-byte
+// types up to a byte.
+int64_t getElementTypeBytes(Type elementType);
+
+// Returns the number of bytes per device of a tensor of `type` with
+// `sharding`, where each dimension is padded to be divisible by its sharded
+// size.
+//
+// Assumes `type` has a static shape.
+int64_t getLocalTensorBytes(RankedTensorType type, TensorShardingAttr sharding,
+                            MeshAttr mesh);
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_DIALECT_SDY_TRANSFORMS_EXPORT_COLLECTIVE_COST_MODEL_H_
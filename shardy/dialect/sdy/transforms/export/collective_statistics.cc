@@ -0,0 +1,221 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/save_module_op.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
+#include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
+
+namespace mlir {
+namespace sdy {
+
+#define GEN_PASS_DEF_COLLECTIVESTATISTICSPASS
+#include "shardy/dialect/sdy/transforms/export/passes.h.inc"
+
+namespace {
+
+// The statistics of all collectives of the same kind over the same axes in a
+// single function.
+struct CollectiveStats {
+  std::string funcName;
+  std::string kind;
+  SmallVector<std::string> axes;
+  int64_t count = 0;
+  int64_t bytes = 0;
+};
+
+void appendAxes(ListOfAxisRefListsAttr axesPerDim,
+                SmallVector<AxisRefAttr>& axes) {
+  for (AxisRefListAttr dimAxes : axesPerDim) {
+    llvm::append_range(axes, dimAxes.getValue());
+  }
+}
+
+// Returns the mesh axes `op` communicates over, or std::nullopt if `op` isn't
+// a collective that communicates between devices.
+//
+// For a collective permute, these are the axes of its out sharding, as the
+// devices that exchange data span all of them.
+std::optional<SmallVector<AxisRefAttr>> getCommunicatingAxes(Operation* op) {
+  SmallVector<AxisRefAttr> axes;
+  bool isCommunicating =
+      llvm::TypeSwitch<Operation*, bool>(op)
+          .Case<AllGatherOp>([&](AllGatherOp allGather) {
+            appendAxes(allGather.getGatheringAxes(), axes);
+            return true;
+          })
+          .Case<AllReduceOp>([&](AllReduceOp allReduce) {
+            llvm::append_range(axes, allReduce.getReductionAxes().getValue());
+            return true;
+          })
+          .Case<ReduceScatterOp>([&](ReduceScatterOp reduceScatter) {
+            appendAxes(reduceScatter.getReduceScatterAxes(), axes);
+            return true;
+          })
+          .Case<AllToAllOp>([&](AllToAllOp allToAll) {
+            for (AllToAllParamAttr param : allToAll.getParams()) {
+              llvm::append_range(axes, param.getAxes());
+            }
+            return true;
+          })
+          .Case<CollectivePermuteOp>([&](CollectivePermuteOp permute) {
+            for (DimensionShardingAttr dimSharding :
+                 permute.getOutSharding().getDimShardings()) {
+              llvm::append_range(axes, dimSharding.getAxes());
+            }
+            return true;
+          })
+          .Default([](Operation*) { return false; });
+  if (!isCommunicating) {
+    return std::nullopt;
+  }
+  return axes;
+}
+
+// Returns the name of `axis`, with its pre-size and size if it's a sub-axis,
+// e.g., `x` or `x:(2)4`.
+std::string getAxisName(AxisRefAttr axis) {
+  if (SubAxisInfoAttr subAxisInfo = axis.getSubAxisInfo()) {
+    return llvm::formatv("{0}:({1}){2}", axis.getName(),
+                         subAxisInfo.getPreSize(), subAxisInfo.getSize())
+        .str();
+  }
+  return axis.getName().str();
+}
+
+// Returns the bytes communicated by `collective` over `axes`, i.e., the local
+// size of its operand in bytes times the number of devices in each group.
+int64_t getCommunicatedBytes(CollectiveOpInterface collective,
+                             ArrayRef<AxisRefAttr> axes,
+                             const SymbolTable& symbolTable) {
+  TensorShardingAttr outSharding = collective.getOutSharding();
+  MeshAttr mesh = outSharding.getMesh(symbolTable);
+  TensorShardingAttr inSharding = getSharding(collective.getTensor());
+  if (!inSharding) {
+    inSharding = TensorShardingAttr::getFullyClosedLike(outSharding);
+  }
+  int64_t groupSize = 1;
+  for (AxisRefAttr axis : axes) {
+    groupSize *= axis.getSize(mesh);
+  }
+  return getLocalTensorBytes(
+             cast<RankedTensorType>(collective.getTensor().getType()),
+             inSharding, mesh) *
+         groupSize;
+}
+
+void writeJson(raw_ostream& os,
+               const llvm::MapVector<std::string, CollectiveStats>& keyToStats) {
+  int64_t totalCount = 0;
+  int64_t totalBytes = 0;
+  for (const auto& [_, stats] : keyToStats) {
+    totalCount += stats.count;
+    totalBytes += stats.bytes;
+  }
+
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&]() {
+    json.attribute("total_count", totalCount);
+    json.attribute("total_bytes", totalBytes);
+    json.attributeArray("collectives", [&]() {
+      for (const auto& [_, stats] : keyToStats) {
+        json.object([&, &stats = stats]() {
+          json.attribute("function", stats.funcName);
+          json.attribute("kind", stats.kind);
+          json.attributeArray("axes", [&]() {
+            for (const std::string& axis : stats.axes) {
+              json.value(axis);
+            }
+          });
+          json.attribute("count", stats.count);
+          json.attribute("bytes", stats.bytes);
+        });
+      }
+    });
+  });
+  os << "\n";
+}
+
+struct CollectiveStatisticsPass
+    : public impl::CollectiveStatisticsPassBase<CollectiveStatisticsPass> {
+  using CollectiveStatisticsPassBase::CollectiveStatisticsPassBase;
+
+  void runOnOperation() final {
+    ModuleOp moduleOp = getOperation();
+    SymbolTable symbolTable(moduleOp);
+    // Keyed by function, collective kind and axes, in the order the first
+    // collective of each key appears in the module.
+    llvm::MapVector<std::string, CollectiveStats> keyToStats;
+    for (auto funcOp : moduleOp.getOps<func::FuncOp>()) {
+      funcOp.walk([&](CollectiveOpInterface collective) {
+        std::optional<SmallVector<AxisRefAttr>> axes =
+            getCommunicatingAxes(collective);
+        if (!axes) {
+          return;
+        }
+        SmallVector<std::string> axisNames =
+            llvm::map_to_vector(*axes, getAxisName);
+        StringRef kind = collective->getName().getStringRef();
+        std::string key = llvm::formatv("{0}|{1}|{2}", funcOp.getSymName(),
+                                        kind, llvm::join(axisNames, ","))
+                              .str();
+        auto [it, inserted] = keyToStats.try_emplace(key);
+        CollectiveStats& stats = it->second;
+        if (inserted) {
+          stats.funcName = funcOp.getSymName().str();
+          stats.kind = kind.str();
+          stats.axes = std::move(axisNames);
+        }
+        ++stats.count;
+        stats.bytes += getCommunicatedBytes(collective, *axes, symbolTable);
+      });
+    }
+    save(keyToStats);
+    markAllAnalysesPreserved();
+  }
+
+  // Saves the JSON report to `<dumpDirectory>/<fileName>.json`, or prints it
+  // to stderr if `dumpDirectory` is empty.
+  void save(const llvm::MapVector<std::string, CollectiveStats>& keyToStats) {
+    saveJson(dumpDirectory, fileName,
+             [&](raw_ostream& os) { writeJson(os, keyToStats); });
+  }
+};
+
+}  // namespace
+
+}  // namespace sdy
+}  // namespace mlir
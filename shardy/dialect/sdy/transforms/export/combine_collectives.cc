@@ -0,0 +1,223 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"  // IWYU pragma: keep
+#include "mlir/IR/Block.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/TypeRange.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
+#include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
+#include "stablehlo/dialect/StablehloOps.h"
+
+namespace mlir {
+namespace sdy {
+
+#define GEN_PASS_DEF_COMBINECOLLECTIVESPASS
+#include "shardy/dialect/sdy/transforms/export/passes.h.inc"
+
+namespace {
+
+// Returns the total number of bytes of the results of `op`, or std::nullopt if
+// any of them doesn't have a static shape.
+std::optional<int64_t> getResultBytes(Operation* op) {
+  int64_t bytes = 0;
+  for (Type type : op->getResultTypes()) {
+    auto tensorType = dyn_cast<RankedTensorType>(type);
+    if (!tensorType || !tensorType.hasStaticShape()) {
+      return std::nullopt;
+    }
+    bytes += tensorType.getNumElements() *
+             getElementTypeBytes(tensorType.getElementType());
+  }
+  return bytes;
+}
+
+// Returns true if the element types of all operands of `op` are the same as
+// `elementType`.
+bool hasElementType(Operation* op, Type elementType) {
+  return llvm::all_of(op->getOperandTypes(), [&](Type type) {
+    return cast<ShapedType>(type).getElementType() == elementType;
+  });
+}
+
+bool haveSameChannelType(stablehlo::ChannelHandleAttr lhs,
+                         stablehlo::ChannelHandleAttr rhs) {
+  return lhs && rhs ? lhs.getType() == rhs.getType() : lhs == rhs;
+}
+
+// Returns true if `lhs` and `rhs` can be combined into a single collective,
+// i.e., they have the same kind, replica groups, channel type and device id
+// semantics, and:
+// - for all-reduces, the same element type and reduction computation.
+// - for all-gathers, the same gathering dimension.
+bool canCombine(Operation* lhs, Operation* rhs) {
+  if (lhs->getName() != rhs->getName()) {
+    return false;
+  }
+  if (auto lhsAllReduce = dyn_cast<stablehlo::AllReduceOp>(lhs)) {
+    auto rhsAllReduce = cast<stablehlo::AllReduceOp>(rhs);
+    Type elementType =
+        cast<ShapedType>(lhs->getOperand(0).getType()).getElementType();
+    return lhsAllReduce.getReplicaGroups() == rhsAllReduce.getReplicaGroups() &&
+           lhsAllReduce.getUseGlobalDeviceIds() ==
+               rhsAllReduce.getUseGlobalDeviceIds() &&
+           haveSameChannelType(lhsAllReduce.getChannelHandleAttr(),
+                               rhsAllReduce.getChannelHandleAttr()) &&
+           hasElementType(lhs, elementType) &&
+           hasElementType(rhs, elementType) &&
+           OperationEquivalence::isRegionEquivalentTo(
+               &lhsAllReduce.getComputation(), &rhsAllReduce.getComputation(),
+               OperationEquivalence::IgnoreLocations);
+  }
+  auto lhsAllGather = cast<stablehlo::AllGatherOp>(lhs);
+  auto rhsAllGather = cast<stablehlo::AllGatherOp>(rhs);
+  return lhsAllGather.getAllGatherDim() == rhsAllGather.getAllGatherDim() &&
+         lhsAllGather.getReplicaGroups() == rhsAllGather.getReplicaGroups() &&
+         lhsAllGather.getUseGlobalDeviceIds() ==
+             rhsAllGather.getUseGlobalDeviceIds() &&
+         haveSameChannelType(lhsAllGather.getChannelHandleAttr(),
+                             rhsAllGather.getChannelHandleAttr());
+}
+
+// A group of collectives in the same block that will be combined into a
+// single collective, at the position of the last collective in the group.
+struct CollectiveGroup {
+  SmallVector<Operation*> collectives;
+  int64_t bytes = 0;
+  bool closed = false;
+};
+
+// Replaces the collectives in `group` with a single variadic collective, that
+// takes the channel handle of the first collective.
+void combineGroup(const CollectiveGroup& group, IRRewriter& rewriter) {
+  Operation* firstOp = group.collectives.front();
+  SmallVector<Value> operands;
+  SmallVector<Type> resultTypes;
+  for (Operation* op : group.collectives) {
+    llvm::append_range(operands, op->getOperands());
+    llvm::append_range(resultTypes, op->getResultTypes());
+  }
+
+  rewriter.setInsertionPoint(group.collectives.back());
+  Operation* combinedOp;
+  if (auto allReduce = dyn_cast<stablehlo::AllReduceOp>(firstOp)) {
+    auto combinedAllReduce = stablehlo::AllReduceOp::create(
+        rewriter, allReduce.getLoc(), resultTypes, operands,
+        allReduce.getReplicaGroups(), allReduce.getChannelHandleAttr(),
+        allReduce.getUseGlobalDeviceIds());
+    combinedAllReduce.getComputation().takeBody(allReduce.getComputation());
+    combinedOp = combinedAllReduce;
+  } else {
+    auto allGather = cast<stablehlo::AllGatherOp>(firstOp);
+    combinedOp = stablehlo::AllGatherOp::create(
+        rewriter, allGather.getLoc(), resultTypes, operands,
+        allGather.getAllGatherDim(), allGather.getReplicaGroups(),
+        allGather.getChannelHandleAttr(), allGather.getUseGlobalDeviceIds());
+  }
+
+  int64_t resultIndex = 0;
+  for (Operation* op : group.collectives) {
+    rewriter.replaceOp(op, combinedOp->getResults().slice(
+                               resultIndex, op->getNumResults()));
+    resultIndex += op->getNumResults();
+  }
+}
+
+// Finds groups of independent collectives in `block` that can be combined
+// without exceeding `thresholdBytes`.
+//
+// The ops in the block are visited in order. A collective joins the open group
+// it can be combined with, or opens a new group. A group is closed once an op
+// uses the result of a collective in the group, so that the combined
+// collective, which is placed at the position of the last collective in the
+// group, still dominates all uses.
+SmallVector<CollectiveGroup> findCollectiveGroups(Block& block,
+                                                  int64_t thresholdBytes) {
+  SmallVector<CollectiveGroup> groups;
+  llvm::SmallDenseMap<Operation*, int64_t> collectiveToGroupIndex;
+
+  auto closeGroupsUsedBy = [&](Operation* op) {
+    op->walk([&](Operation* nestedOp) {
+      for (Value operand : nestedOp->getOperands()) {
+        if (auto it = collectiveToGroupIndex.find(operand.getDefiningOp());
+            it != collectiveToGroupIndex.end()) {
+          groups[it->second].closed = true;
+        }
+      }
+    });
+  };
+
+  for (Operation& op : block) {
+    closeGroupsUsedBy(&op);
+    if (!isa<stablehlo::AllReduceOp, stablehlo::AllGatherOp>(op)) {
+      continue;
+    }
+    std::optional<int64_t> bytes = getResultBytes(&op);
+    if (!bytes || *bytes > thresholdBytes) {
+      continue;
+    }
+    auto groupIt = llvm::find_if(groups, [&](const CollectiveGroup& group) {
+      return !group.closed && canCombine(group.collectives.front(), &op);
+    });
+    if (groupIt != groups.end() && groupIt->bytes + *bytes > thresholdBytes) {
+      groupIt->closed = true;
+      groupIt = groups.end();
+    }
+    if (groupIt == groups.end()) {
+      groupIt = groups.insert(groups.end(), CollectiveGroup());
+    }
+    groupIt->collectives.push_back(&op);
+    groupIt->bytes += *bytes;
+    collectiveToGroupIndex[&op] = std::distance(groups.begin(), groupIt);
+  }
+  return groups;
+}
+
+struct CombineCollectivesPass
+    : public impl::CombineCollectivesPassBase<CombineCollectivesPass> {
+  using CombineCollectivesPassBase::CombineCollectivesPassBase;
+
+  void runOnOperation() final {
+    IRRewriter rewriter(&getContext());
+    SmallVector<Block*> blocks;
+    getOperation()->walk([&](Block* block) { blocks.push_back(block); });
+    for (Block* block : blocks) {
+      for (const CollectiveGroup& group :
+           findCollectiveGroups(*block, thresholdBytes)) {
+        if (group.collectives.size() > 1) {
+          combineGroup(group, rewriter);
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+}  // namespace sdy
+}  // namespace mlir
@@ -17,20 +17,29 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <numeric>
 #include <optional>
+#include <tuple>
 #include <utility>
 
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/SmallVectorExtras.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Func/Transforms/FuncConversions.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/IRMapping.h"
 #include "mlir/IR/Location.h"
 #include "mlir/IR/Matchers.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/OperationSupport.h"
 #include "mlir/IR/SymbolTable.h"
 #include "mlir/IR/Value.h"
@@ -39,9 +48,11 @@ limitations under the License.
 #include "mlir/Support/LLVM.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "shardy/common/logging.h"
+#include "shardy/dialect/sdy/ir/constants.h"
 #include "shardy/dialect/sdy/ir/dialect.h"  // IWYU pragma: keep
 #include "shardy/dialect/sdy/ir/utils.h"
 #include "shardy/dialect/sdy/transforms/common/util.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
 #include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
 #include "shardy/dialect/sdy/transforms/propagation/utils.h"
 #include "stablehlo/dialect/StablehloOps.h"
@@ -79,14 +90,25 @@ Type getLocalType(Type type, TensorShardingAttr sharding,
   return localType;
 }
 
+// The state of the conversion of a single top-level op in the module.
+//
+// Top-level ops are converted in parallel, so channel ids can't be assigned
+// while converting. Instead, `getNextChannelId` returns negative placeholder
+// ids, -1, -2, etc., which are replaced by `assignChannelIds` once all
+// top-level ops have been converted.
 struct ConversionState {
   llvm::DenseSet<Operation*> toConvertOps;
-  int64_t nextChannelId = 0;
+  int64_t numChannelIds = 0;
+  // The replica groups of each (mesh, axes) pair. Computing them is linear in
+  // the number of devices, and the same few pairs are usually repeated across
+  // many collectives.
+  llvm::DenseMap<std::pair<MeshAttr, AxisRefListAttr>, DenseIntElementsAttr>
+      replicaGroupsCache;
 
   void addToConvertOp(Operation* op) { toConvertOps.insert(op); }
   void removeToConvertOp(Operation* op) { toConvertOps.erase(op); }
   bool needConversion(Operation* op) { return toConvertOps.contains(op); }
-  int64_t getNextChannelId() { return nextChannelId++; }
+  int64_t getNextChannelId() { return -(++numChannelIds); }
 };
 
 class GlobalToLocalTypeConverter : public TypeConverter {
@@ -311,6 +333,24 @@ int64_t getNextChannelId(ModuleOp moduleOp) {
   return maxChannelId + 1;
 }
 
+// Replaces the placeholder channel ids in `op`, i.e., the negative ids
+// returned by `ConversionState::getNextChannelId`, with `firstChannelId`,
+// `firstChannelId + 1`, etc., in the order in which they were assigned.
+void assignChannelIds(Operation* op, int64_t firstChannelId) {
+  op->walk([&](Operation* nestedOp) {
+    auto channelHandle =
+        nestedOp->getAttrOfType<stablehlo::ChannelHandleAttr>("channel_handle");
+    if (!channelHandle || channelHandle.getHandle() >= 0) {
+      return;
+    }
+    nestedOp->setAttr(
+        "channel_handle",
+        stablehlo::ChannelHandleAttr::get(
+            op->getContext(), firstChannelId - channelHandle.getHandle() - 1,
+            channelHandle.getType()));
+  });
+}
+
 // Returns a ReplicaGroupMeshAxesAttr based on the provided axes and mesh.
 Attribute getReplicaGroupsV3(ArrayRef<AxisRefAttr> axes, Attribute meshOrRef,
                              OpBuilder& rewriter) {
@@ -320,20 +360,34 @@ Attribute getReplicaGroupsV3(ArrayRef<AxisRefAttr> axes, Attribute meshOrRef,
           axes, [](AxisRefAttr attr) -> Attribute { return attr; })));
 }
 
+// Same as `getReplicaGroups` in utils.h, but looks up the replica groups in
+// the cache of `conversionState` first.
+DenseIntElementsAttr getCachedReplicaGroups(ArrayRef<AxisRefAttr> axes,
+                                            MeshAttr mesh, OpBuilder& rewriter,
+                                            ConversionState& conversionState) {
+  auto axesAttr = AxisRefListAttr::get(rewriter.getContext(), axes);
+  auto [it, inserted] =
+      conversionState.replicaGroupsCache.try_emplace({mesh, axesAttr});
+  if (inserted) {
+    it->second = getReplicaGroups(axesAttr, mesh, rewriter);
+  }
+  return it->second;
+}
+
 Attribute getReplicaGroups(ArrayRef<AxisRefAttr> axes, MeshAttr mesh,
                            Attribute meshOrRef, bool enableRGV3,
-                           OpBuilder& rewriter) {
-  return enableRGV3 ? getReplicaGroupsV3(axes, meshOrRef, rewriter)
-                    : getReplicaGroups(
-                          AxisRefListAttr::get(rewriter.getContext(), axes),
-                          mesh, rewriter);
+                           OpBuilder& rewriter,
+                           ConversionState& conversionState) {
+  return enableRGV3
+             ? getReplicaGroupsV3(axes, meshOrRef, rewriter)
+             : getCachedReplicaGroups(axes, mesh, rewriter, conversionState);
 }
 
 // Returns a pair containing the replica groups (as an Attribute) and the
 // total number of devices in each group.
 std::pair<Attribute, int64_t> getReplicaGroupsAndSize(
     ArrayRef<AxisRefAttr> axes, MeshAttr mesh, Attribute meshOrRef,
-    bool enableRGV3, OpBuilder& rewriter) {
+    bool enableRGV3, OpBuilder& rewriter, ConversionState& conversionState) {
   if (enableRGV3) {
     Attribute replicaGroups = getReplicaGroupsV3(axes, meshOrRef, rewriter);
     // Group size is the product of the sizes of the sharding axes.
@@ -341,13 +395,56 @@ std::pair<Attribute, int64_t> getReplicaGroupsAndSize(
     return {replicaGroups, groupSize};
   }
 
-  DenseIntElementsAttr replicaGroups = getReplicaGroups(
-      AxisRefListAttr::get(rewriter.getContext(), axes), mesh, rewriter);
+  DenseIntElementsAttr replicaGroups =
+      getCachedReplicaGroups(axes, mesh, rewriter, conversionState);
   // Group size is the last dimension of the 2D dense tensor.
   int64_t groupSize = replicaGroups.getShapedType().getShape().back();
   return {replicaGroups, groupSize};
 }
 
+// The axes of a collective, split by network level.
+struct AxesByLevel {
+  // The axes with the lowest bandwidth, e.g., DCN axes.
+  SmallVector<AxisRefAttr> slowAxes;
+  // The remaining axes, e.g., ICI axes.
+  SmallVector<AxisRefAttr> fastAxes;
+};
+
+// Splits `axes` by network level, according to the `kAxisBandwidthsAttr` of
+// the mesh that `meshOrRef` refers to.
+//
+// Returns std::nullopt if `meshOrRef` doesn't refer to a mesh with axis
+// bandwidths, or all of `axes` have the same bandwidth.
+std::optional<AxesByLevel> splitAxesByLevel(ArrayRef<AxisRefAttr> axes,
+                                            Attribute meshOrRef,
+                                            const SymbolTable& symbolTable) {
+  auto meshRef = dyn_cast<FlatSymbolRefAttr>(meshOrRef);
+  if (!meshRef) {
+    return std::nullopt;
+  }
+  MeshOp meshOp = getMeshOp(symbolTable, meshRef.getValue());
+  if (!meshOp || !meshOp->hasAttr(kAxisBandwidthsAttr)) {
+    return std::nullopt;
+  }
+  CollectiveCostModel costModel = CollectiveCostModel::get(meshOp);
+  double minBandwidth = std::numeric_limits<double>::max();
+  for (AxisRefAttr axis : axes) {
+    minBandwidth = std::min(minBandwidth, costModel.getBandwidth(axis));
+  }
+  AxesByLevel axesByLevel;
+  for (AxisRefAttr axis : axes) {
+    if (costModel.getBandwidth(axis) == minBandwidth) {
+      axesByLevel.slowAxes.push_back(axis);
+    } else {
+      axesByLevel.fastAxes.push_back(axis);
+    }
+  }
+  if (axesByLevel.fastAxes.empty()) {
+    return std::nullopt;
+  }
+  return axesByLevel;
+}
+
 class AllGatherOpPattern : public OpConversionPattern<AllGatherOp> {
  public:
   AllGatherOpPattern(TypeConverter& converter, MLIRContext* ctx,
@@ -397,8 +494,9 @@ class AllGatherOpPattern : public OpConversionPattern<AllGatherOp> {
 
     // Perform All-Gather on dim 0.
     Attribute replicaGroups;
-    std::tie(replicaGroups, tmpShape[0]) = getReplicaGroupsAndSize(
-        allGatheringAxes, mesh, meshOrRef, enableRGV3, rewriter);
+    std::tie(replicaGroups, tmpShape[0]) =
+        getReplicaGroupsAndSize(allGatheringAxes, mesh, meshOrRef, enableRGV3,
+                                rewriter, conversionState);
     auto channelHandle = stablehlo::ChannelHandleAttr::get(
         ctx, /*handle=*/conversionState.getNextChannelId(), kChannelHandleType);
     // Change tmpShape to represent the result of the All-Gather.
@@ -463,8 +561,9 @@ class AllGatherOpPattern : public OpConversionPattern<AllGatherOp> {
       SmallVector<int64_t> curShape = llvm::to_vector(inputType.getShape());
       Attribute replicaGroups;
       int64_t groupSize;
-      std::tie(replicaGroups, groupSize) = getReplicaGroupsAndSize(
-          axisList.getValue(), mesh, meshOrRef, enableRGV3, rewriter);
+      std::tie(replicaGroups, groupSize) =
+          getReplicaGroupsAndSize(axisList.getValue(), mesh, meshOrRef,
+                                  enableRGV3, rewriter, conversionState);
       if (curShape[dim] != ShapedType::kDynamic) {
         curShape[dim] *= groupSize;
       }
@@ -498,7 +597,9 @@ class AllGatherOpPattern : public OpConversionPattern<AllGatherOp> {
         << "No-op AllGatherOp should have been removed by "
            "canonicalization.";
 
-    MeshAttr mesh = op.getOutSharding().getMesh(op);
+    auto* converter =
+        static_cast<const GlobalToLocalTypeConverter*>(getTypeConverter());
+    MeshAttr mesh = op.getOutSharding().getMesh(converter->getSymbolTable());
     Attribute meshOrRef = op.getOutSharding().getMeshOrRef();
     if (!mesh) {
       return op.emitOpError("failed to resolve mesh");
@@ -519,13 +620,106 @@ class AllGatherOpPattern : public OpConversionPattern<AllGatherOp> {
   bool enableRGV3;
 };
 
+// Returns the element type that a reducing collective on a local tensor of
+// type `localType` should communicate in.
+//
+// If `reducedPrecisionThresholdBytes` is non-negative and `localType` is a
+// static f32 tensor of at least that many bytes, returns bf16, otherwise
+// returns the element type of `localType`.
+Type getReducingCollectiveElementType(RankedTensorType localType,
+                                      int64_t reducedPrecisionThresholdBytes,
+                                      OpBuilder& builder) {
+  Type elementType = localType.getElementType();
+  if (reducedPrecisionThresholdBytes < 0 || !elementType.isF32() ||
+      !localType.hasStaticShape() ||
+      localType.getNumElements() * localType.getElementTypeBitWidth() / 8 <
+          reducedPrecisionThresholdBytes) {
+    return elementType;
+  }
+  return builder.getBF16Type();
+}
+
+// Converts `value` to a tensor with the given `elementType`, or returns it as
+// is if it already has that element type.
+Value convertElementType(Location loc, Value value, Type elementType,
+                         OpBuilder& builder) {
+  auto type = cast<RankedTensorType>(value.getType());
+  if (type.getElementType() == elementType) {
+    return value;
+  }
+  return stablehlo::ConvertOp::create(builder, loc, type.clone(elementType),
+                                      value);
+}
+
 class AllReduceOpPattern : public OpConversionPattern<sdy::AllReduceOp> {
  public:
   AllReduceOpPattern(TypeConverter& converter, MLIRContext* ctx,
-                     ConversionState& state, bool enableRGV3)
+                     ConversionState& state, bool enableRGV3,
+                     int64_t reducedPrecisionThresholdBytes,
+                     bool hierarchicalCollectives)
       : OpConversionPattern<sdy::AllReduceOp>(converter, ctx),
         conversionState(state),
-        enableRGV3(enableRGV3) {}
+        enableRGV3(enableRGV3),
+        reducedPrecisionThresholdBytes(reducedPrecisionThresholdBytes),
+        hierarchicalCollectives(hierarchicalCollectives) {}
+
+  // Emits an all-reduce of `input` over the axes of `axesByLevel`, as a
+  // reduce-scatter over the fast axes, an all-reduce over the slow axes of the
+  // scattered data, and an all-gather over the fast axes. The input is
+  // converted to `elementType` and flattened so it can be scattered evenly.
+  //
+  // Returns a null value if the input doesn't have a static shape, or its
+  // number of elements isn't divisible by the number of fast devices.
+  Value emitHierarchicalAllReduce(Location loc, Value input, Type elementType,
+                                  const AxesByLevel& axesByLevel,
+                                  MeshAttr mesh, Attribute meshOrRef,
+                                  ConversionPatternRewriter& rewriter) const {
+    auto inputType = cast<RankedTensorType>(input.getType());
+    int64_t numFastDevices = getTotalAxesSize(axesByLevel.fastAxes, mesh);
+    if (!inputType.hasStaticShape() ||
+        inputType.getNumElements() % numFastDevices != 0) {
+      return nullptr;
+    }
+    MLIRContext* ctx = rewriter.getContext();
+    input = convertElementType(loc, input, elementType, rewriter);
+    inputType = inputType.clone(elementType);
+    auto flatType =
+        RankedTensorType::get({inputType.getNumElements()}, elementType);
+    auto scatteredType = RankedTensorType::get(
+        {inputType.getNumElements() / numFastDevices}, elementType);
+    Value flat = stablehlo::ReshapeOp::create(rewriter, loc, flatType, input);
+
+    Attribute fastReplicaGroups =
+        getReplicaGroups(axesByLevel.fastAxes, mesh, meshOrRef, enableRGV3,
+                         rewriter, conversionState);
+    auto reduceScatter = stablehlo::ReduceScatterOp::create(
+        rewriter, loc, scatteredType, flat, /*scatter_dimension=*/0,
+        fastReplicaGroups,
+        stablehlo::ChannelHandleAttr::get(
+            ctx, conversionState.getNextChannelId(), kChannelHandleType),
+        /*use_global_device_ids=*/true);
+    stablehlo::buildReduceBody<stablehlo::AddOp>(
+        elementType, reduceScatter.getComputation(), rewriter);
+
+    auto allReduce = stablehlo::AllReduceOp::create(
+        rewriter, loc, scatteredType, reduceScatter.getResult(),
+        getReplicaGroups(axesByLevel.slowAxes, mesh, meshOrRef, enableRGV3,
+                         rewriter, conversionState),
+        stablehlo::ChannelHandleAttr::get(
+            ctx, conversionState.getNextChannelId(), kChannelHandleType),
+        /*use_global_device_ids=*/true);
+    stablehlo::buildReduceBody<stablehlo::AddOp>(
+        elementType, allReduce.getComputation(), rewriter);
+
+    auto allGather = stablehlo::AllGatherOp::create(
+        rewriter, loc, TypeRange{flatType}, allReduce.getResult(0),
+        /*all_gather_dim=*/0, fastReplicaGroups,
+        stablehlo::ChannelHandleAttr::get(
+            ctx, conversionState.getNextChannelId(), kChannelHandleType),
+        /*use_global_device_ids=*/true);
+    return stablehlo::ReshapeOp::create(rewriter, loc, inputType,
+                                        allGather.getResult(0));
+  }
 
   LogicalResult matchAndRewrite(
       sdy::AllReduceOp op, OpAdaptor adaptor,
@@ -540,23 +734,44 @@ class AllReduceOpPattern : public OpConversionPattern<sdy::AllReduceOp> {
       return op.emitOpError("failed to resolve mesh");
     }
 
+    Location loc = op.getLoc();
+    auto localType = cast<RankedTensorType>(converter->convertType(op));
+    Type elementType = getReducingCollectiveElementType(
+        localType, reducedPrecisionThresholdBytes, rewriter);
+    if (hierarchicalCollectives) {
+      if (std::optional<AxesByLevel> axesByLevel = splitAxesByLevel(
+              op.getReductionAxes(), outSharding.getMeshOrRef(),
+              converter->getSymbolTable())) {
+        if (Value result = emitHierarchicalAllReduce(
+                loc, adaptor.getTensor(), elementType, *axesByLevel, mesh,
+                outSharding.getMeshOrRef(), rewriter)) {
+          rewriter.replaceOp(op, convertElementType(loc, result,
+                                                    localType.getElementType(),
+                                                    rewriter));
+          conversionState.removeToConvertOp(op);
+          return success();
+        }
+      }
+    }
+
     Attribute replicaGroups =
         getReplicaGroups(op.getReductionAxesAttr(), mesh,
-                         outSharding.getMeshOrRef(), enableRGV3, rewriter);
+                         outSharding.getMeshOrRef(), enableRGV3, rewriter,
+                         conversionState);
     auto channelHandle = stablehlo::ChannelHandleAttr::get(
         op->getContext(), conversionState.getNextChannelId(),
         kChannelHandleType);
-
     auto allReduce = stablehlo::AllReduceOp::create(
-        rewriter, op.getLoc(), converter->convertResultTypes(op->getResults()),
-        adaptor.getOperands(), replicaGroups, channelHandle,
+        rewriter, loc, localType.clone(elementType),
+        convertElementType(loc, adaptor.getTensor(), elementType, rewriter),
+        replicaGroups, channelHandle,
         /*use_global_device_ids=*/true);
-    Type elementType = cast<RankedTensorType>(allReduce->getResult(0).getType())
-                           .getElementType();
     stablehlo::buildReduceBody<stablehlo::AddOp>(
         elementType, allReduce.getComputation(), rewriter);
 
-    rewriter.replaceOp(op, allReduce.getResults());
+    rewriter.replaceOp(op, convertElementType(loc, allReduce.getResult(0),
+                                              localType.getElementType(),
+                                              rewriter));
     conversionState.removeToConvertOp(op);
     return success();
   }
@@ -564,26 +779,18 @@ class AllReduceOpPattern : public OpConversionPattern<sdy::AllReduceOp> {
  private:
   ConversionState& conversionState;
   bool enableRGV3;
+  int64_t reducedPrecisionThresholdBytes;
+  bool hierarchicalCollectives;
 };
 
-// Returns the logical index of the shard that the given device (`deviceId`)
+// Returns the logical index of the shard that the device at position
+// `logicalDeviceId` of the mesh's device list (or iota if the list is empty)
 // resides in, along a dimension sharded by the provided `axes`.
 //
 // This "shard index" ranges is [0, (TotalShardCount - 1)] and identifies
 // the device's position in the logical grid formed by the sharding axes.
-int64_t getShardIndex(int64_t deviceId, MeshAttr mesh,
-                      ArrayRef<AxisRefAttr> axes) {
-  // Resolve the physical-to-logical mapping. The 'logicalDeviceId' is the index
-  // of the device ID in the mesh's device list. If the list is empty, it
-  // follows the iota order.
-  int64_t logicalDeviceId = deviceId;
-  ArrayRef<int64_t> deviceIds = mesh.getDeviceIds();
-  if (!deviceIds.empty()) {
-    const auto* it = llvm::find(deviceIds, deviceId);
-    SDY_CHECK(it != deviceIds.end()) << "Device ID not found in mesh";
-    logicalDeviceId = std::distance(deviceIds.begin(), it);
-  }
-
+int64_t getShardIndexOfLogicalDevice(int64_t logicalDeviceId, MeshAttr mesh,
+                                     ArrayRef<AxisRefAttr> axes) {
   int64_t shardIndex = 0;
   for (AxisRefAttr axis : axes) {
     int64_t axisSize = axis.getSize(mesh);
@@ -611,35 +818,59 @@ int64_t getShardIndex(int64_t deviceId, MeshAttr mesh,
   return shardIndex;
 }
 
-// Returns a 0-rank i64 tensor containing the global offset for the given shard
-// axes and local shard size.
-Value getDimensionOffset(Location loc, MeshAttr mesh,
-                         ArrayRef<AxisRefAttr> axes, int64_t shardSize,
-                         ConversionPatternRewriter& rewriter) {
+// Returns the shard index (see `getShardIndexOfLogicalDevice`) of every device
+// of the mesh, indexed by device id.
+//
+// This is linear in the number of devices, whereas resolving each device id in
+// the mesh's device list separately would be quadratic.
+SmallVector<int64_t> getShardIndices(MeshAttr mesh,
+                                     ArrayRef<AxisRefAttr> axes) {
   int64_t numDevices = mesh.getTotalSize();
-  Type i64Ty = rewriter.getI64Type();
+  ArrayRef<int64_t> deviceIds = mesh.getDeviceIds();
+  SmallVector<int64_t> shardIndices(numDevices);
+  for (int64_t logicalDeviceId = 0; logicalDeviceId < numDevices;
+       ++logicalDeviceId) {
+    int64_t deviceId =
+        deviceIds.empty() ? logicalDeviceId : deviceIds[logicalDeviceId];
+    shardIndices[deviceId] =
+        getShardIndexOfLogicalDevice(logicalDeviceId, mesh, axes);
+  }
+  return shardIndices;
+}
+
+// Returns a 0-rank i64 tensor containing the entry of `table`, which holds a
+// value per device, for the current device.
+Value lookUpDeviceTable(Location loc, ArrayRef<int64_t> table,
+                        OpBuilder& builder) {
+  Type i64Ty = builder.getI64Type();
   auto indexTy = RankedTensorType::get({}, i64Ty);
 
   // partitionId = (i64)stablehlo.partition_id
   Value partitionId = stablehlo::ConvertOp::create(
-      rewriter, loc, indexTy, stablehlo::PartitionIdOp::create(rewriter, loc));
+      builder, loc, indexTy, stablehlo::PartitionIdOp::create(builder, loc));
 
+  auto tableConst = stablehlo::ConstantOp::create(
+      builder, loc,
+      DenseIntElementsAttr::get(
+          RankedTensorType::get({static_cast<int64_t>(table.size())}, i64Ty),
+          table));
+  auto valueSlice = stablehlo::DynamicSliceOp::create(
+      builder, loc, RankedTensorType::get({1}, i64Ty), tableConst,
+      ValueRange{partitionId}, builder.getDenseI64ArrayAttr({1}));
+
+  return stablehlo::ReshapeOp::create(builder, loc, indexTy, valueSlice);
+}
+
+// Returns a 0-rank i64 tensor containing the global offset for the given shard
+// axes and local shard size.
+Value getDimensionOffset(Location loc, MeshAttr mesh,
+                         ArrayRef<AxisRefAttr> axes, int64_t shardSize,
+                         ConversionPatternRewriter& rewriter) {
   // Calculate a compile-time offset table for this dimension.
   SmallVector<int64_t> offsetsTable = llvm::map_to_vector(
-      llvm::seq<int64_t>(0, numDevices), [&](int64_t devId) {
-        return getShardIndex(devId, mesh, axes) * shardSize;
-      });
-
-  // Create the offset table and look up the value for the current device.
-  auto tableConst = stablehlo::ConstantOp::create(
-      rewriter, loc,
-      DenseIntElementsAttr::get(RankedTensorType::get({numDevices}, i64Ty),
-                                offsetsTable));
-  auto offsetSlice = stablehlo::DynamicSliceOp::create(
-      rewriter, loc, RankedTensorType::get({1}, i64Ty), tableConst,
-      ValueRange{partitionId}, rewriter.getDenseI64ArrayAttr({1}));
-
-  return stablehlo::ReshapeOp::create(rewriter, loc, indexTy, offsetSlice);
+      getShardIndices(mesh, axes),
+      [&](int64_t shardIndex) { return shardIndex * shardSize; });
+  return lookUpDeviceTable(loc, offsetsTable, rewriter);
 }
 
 Value emitDynamicSliceForAxes(Location loc, Value globalTensor, MeshAttr mesh,
@@ -669,6 +900,80 @@ Value emitDynamicSliceForAxes(Location loc, Value globalTensor, MeshAttr mesh,
       .getResult();
 }
 
+// Emits the local shard of a `stablehlo.iota` along `iotaDim` with the given
+// `localType`, offsetting it by the global position of the shard if `iotaDim`
+// is sharded along `axes`.
+Value emitLocalIota(Location loc, RankedTensorType localType, int64_t iotaDim,
+                    MeshAttr mesh, ArrayRef<AxisRefAttr> axes,
+                    ConversionPatternRewriter& rewriter) {
+  Value localIota =
+      stablehlo::IotaOp::create(rewriter, loc, localType, iotaDim);
+  if (axes.empty()) {
+    return localIota;
+  }
+
+  // Calculate and apply the global offset for this shard.
+  Type convertedOffsetType =
+      RankedTensorType::get({}, localType.getElementType());
+  Value offset = getDimensionOffset(loc, mesh, axes,
+                                    localType.getDimSize(iotaDim), rewriter);
+  Value offsetConverted = stablehlo::ConvertOp::create(
+      rewriter, loc, convertedOffsetType, offset);
+  Value broadcastOffset = stablehlo::BroadcastInDimOp::create(
+      rewriter, loc, localType, offsetConverted,
+      rewriter.getDenseI64ArrayAttr({}));
+  return stablehlo::AddOp::create(rewriter, loc, localIota, broadcastOffset);
+}
+
+// Returns the dimension along which `elementsAttr` is equal to
+// `stablehlo.iota`, i.e., every element is equal to its index along that
+// dimension, or std::nullopt if there is no such dimension.
+//
+// Only integer constants are considered, and a dimension is only a candidate if
+// all its indices are representable as non-negative values of the element
+// type.
+std::optional<int64_t> getIotaDimension(ElementsAttr elementsAttr) {
+  auto denseAttr = dyn_cast<DenseIntElementsAttr>(elementsAttr);
+  if (!denseAttr || denseAttr.isSplat()) {
+    return std::nullopt;
+  }
+  auto type = cast<RankedTensorType>(denseAttr.getType());
+  unsigned bitWidth = type.getElementTypeBitWidth();
+  if (bitWidth <= 1 || bitWidth > 64) {
+    return std::nullopt;
+  }
+  ArrayRef<int64_t> shape = type.getShape();
+  SmallVector<bool> candidates = llvm::map_to_vector(shape, [&](int64_t size) {
+    return size > 1 && llvm::isUIntN(bitWidth - 1, size - 1);
+  });
+  if (llvm::none_of(candidates, [](bool c) { return c; })) {
+    return std::nullopt;
+  }
+
+  SmallVector<int64_t> index(shape.size(), 0);
+  for (const APInt& value : denseAttr.getValues<APInt>()) {
+    for (auto [dim, candidate] : llvm::enumerate(candidates)) {
+      if (candidate &&
+          static_cast<int64_t>(value.getZExtValue()) != index[dim]) {
+        candidate = false;
+      }
+    }
+    // Increment the multi-dimensional index in row-major order.
+    for (int64_t dim = shape.size() - 1; dim >= 0; --dim) {
+      if (++index[dim] < shape[dim]) {
+        break;
+      }
+      index[dim] = 0;
+    }
+  }
+
+  auto* it = llvm::find(candidates, true);
+  if (it == candidates.end()) {
+    return std::nullopt;
+  }
+  return std::distance(candidates.begin(), it);
+}
+
 class AllSliceOpPattern : public OpConversionPattern<AllSliceOp> {
  public:
   AllSliceOpPattern(TypeConverter& converter, MLIRContext* ctx,
@@ -708,10 +1013,12 @@ class AllSliceOpPattern : public OpConversionPattern<AllSliceOp> {
 class AllToAllOpPattern : public OpConversionPattern<AllToAllOp> {
  public:
   AllToAllOpPattern(TypeConverter& converter, MLIRContext* ctx,
-                    ConversionState& state, bool enableRGV3)
+                    ConversionState& state, bool enableRGV3,
+                    bool hierarchicalCollectives)
       : OpConversionPattern<AllToAllOp>(converter, ctx),
         conversionState(state),
-        enableRGV3(enableRGV3) {}
+        enableRGV3(enableRGV3),
+        hierarchicalCollectives(hierarchicalCollectives) {}
 
   LogicalResult rewriteAllToAllOneParam(
       AllToAllOp op, MeshAttr mesh, Attribute meshOrRef, Value input,
@@ -724,7 +1031,7 @@ class AllToAllOpPattern : public OpConversionPattern<AllToAllOp> {
     Attribute replicaGroups;
     int64_t numDevicesPerGroup;
     std::tie(replicaGroups, numDevicesPerGroup) = getReplicaGroupsAndSize(
-        axisList, mesh, meshOrRef, enableRGV3, rewriter);
+        axisList, mesh, meshOrRef, enableRGV3, rewriter, conversionState);
     auto inputType = cast<RankedTensorType>(input.getType());
     SmallVector<int64_t> resultShape = llvm::to_vector(inputType.getShape());
     int64_t srcDim = param.getSrcDim();
@@ -757,6 +1064,117 @@ class AllToAllOpPattern : public OpConversionPattern<AllToAllOp> {
     return success();
   }
 
+  // Rewrites a single-param all-to-all whose axes are `majorAxes` followed by
+  // `minorAxes`, where one of them are fast axes and the other slow axes, as
+  // an all-to-all over the fast axes followed by an all-to-all over the slow
+  // axes, so that the slow axes only see one message per device.
+  //
+  // The target dimension is split into (major, minor, rest) and the source
+  // dimension into (1, 1, size), such that each all-to-all splits one of the
+  // target factors and concatenates along the matching source factor.
+  //
+  // Returns failure if the source and target dimensions are the same, or the
+  // target dimension isn't divisible by the number of devices.
+  LogicalResult rewriteAllToAllHierarchical(
+      AllToAllOp op, MeshAttr mesh, Attribute meshOrRef, Value input,
+      ArrayRef<AxisRefAttr> majorAxes, ArrayRef<AxisRefAttr> minorAxes,
+      bool majorAxesAreFast, ConversionPatternRewriter& rewriter) const {
+    AllToAllParamAttr param = op.getParams()[0];
+    int64_t srcDim = param.getSrcDim();
+    int64_t tgtDim = param.getTgtDim();
+    auto inputType = cast<RankedTensorType>(input.getType());
+    ArrayRef<int64_t> inputShape = inputType.getShape();
+    int64_t majorSize = getTotalAxesSize(majorAxes, mesh);
+    int64_t minorSize = getTotalAxesSize(minorAxes, mesh);
+    if (srcDim == tgtDim || ShapedType::isDynamic(inputShape[srcDim]) ||
+        ShapedType::isDynamic(inputShape[tgtDim]) ||
+        inputShape[tgtDim] % (majorSize * minorSize) != 0) {
+      return failure();
+    }
+
+    Location loc = op.getLoc();
+    SmallVector<int64_t> splitShape;
+    int64_t tgtMajorDim = 0, tgtMinorDim = 0, srcMajorDim = 0, srcMinorDim = 0;
+    for (auto [dim, dimSize] : llvm::enumerate(inputShape)) {
+      if (dim == tgtDim) {
+        tgtMajorDim = splitShape.size();
+        tgtMinorDim = tgtMajorDim + 1;
+        llvm::append_values(splitShape, majorSize, minorSize,
+                            dimSize / (majorSize * minorSize));
+      } else if (dim == srcDim) {
+        srcMajorDim = splitShape.size();
+        srcMinorDim = srcMajorDim + 1;
+        llvm::append_values(splitShape, 1, 1, dimSize);
+      } else {
+        splitShape.push_back(dimSize);
+      }
+    }
+    Value result = stablehlo::ReshapeOp::create(
+        rewriter, loc, inputType.clone(splitShape), input);
+
+    auto emitAllToAll = [&](ArrayRef<AxisRefAttr> axes, int64_t splitDim,
+                            int64_t concatDim) {
+      Attribute replicaGroups;
+      int64_t numDevicesPerGroup;
+      std::tie(replicaGroups, numDevicesPerGroup) = getReplicaGroupsAndSize(
+          axes, mesh, meshOrRef, enableRGV3, rewriter, conversionState);
+      auto type = cast<RankedTensorType>(result.getType());
+      SmallVector<int64_t> resultShape = llvm::to_vector(type.getShape());
+      resultShape[splitDim] /= numDevicesPerGroup;
+      resultShape[concatDim] *= numDevicesPerGroup;
+      auto channelHandle = stablehlo::ChannelHandleAttr::get(
+          op->getContext(), conversionState.getNextChannelId(),
+          kChannelHandleType);
+      result = stablehlo::AllToAllOp::create(
+                   rewriter, loc, TypeRange{type.clone(resultShape)},
+                   ValueRange{result}, splitDim, concatDim,
+                   numDevicesPerGroup, replicaGroups, channelHandle)
+                   ->getResult(0);
+    };
+    if (majorAxesAreFast) {
+      emitAllToAll(majorAxes, tgtMajorDim, srcMajorDim);
+      emitAllToAll(minorAxes, tgtMinorDim, srcMinorDim);
+    } else {
+      emitAllToAll(minorAxes, tgtMinorDim, srcMinorDim);
+      emitAllToAll(majorAxes, tgtMajorDim, srcMajorDim);
+    }
+
+    SmallVector<int64_t> resultShape = llvm::to_vector(inputShape);
+    resultShape[srcDim] *= majorSize * minorSize;
+    resultShape[tgtDim] /= majorSize * minorSize;
+    rewriter.replaceOp(op, stablehlo::ReshapeOp::create(
+                               rewriter, loc, inputType.clone(resultShape),
+                               result));
+    conversionState.removeToConvertOp(op);
+    return success();
+  }
+
+  // Returns the prefix and suffix of the axes of the single-param `op`, if
+  // each of them is on a different network level, and whether the prefix is
+  // on the fast level.
+  std::optional<std::tuple<ArrayRef<AxisRefAttr>, ArrayRef<AxisRefAttr>, bool>>
+  getAxesByLevel(AllToAllOp op, Attribute meshOrRef,
+                 const SymbolTable& symbolTable) const {
+    ArrayRef<AxisRefAttr> axes = op.getParams()[0].getAxes();
+    std::optional<AxesByLevel> axesByLevel =
+        splitAxesByLevel(axes, meshOrRef, symbolTable);
+    if (!axesByLevel) {
+      return std::nullopt;
+    }
+    bool majorAxesAreFast = llvm::is_contained(axesByLevel->fastAxes, axes[0]);
+    int64_t numMajorAxes = majorAxesAreFast ? axesByLevel->fastAxes.size()
+                                            : axesByLevel->slowAxes.size();
+    ArrayRef<AxisRefAttr> majorAxes = axes.take_front(numMajorAxes);
+    ArrayRef<AxisRefAttr> expectedMajorAxes =
+        majorAxesAreFast ? axesByLevel->fastAxes : axesByLevel->slowAxes;
+    if (majorAxes != expectedMajorAxes) {
+      // The axes of a level aren't contiguous.
+      return std::nullopt;
+    }
+    return std::make_tuple(majorAxes, axes.drop_front(numMajorAxes),
+                           majorAxesAreFast);
+  }
+
   LogicalResult rewriteAllToAllMultipleParams(
       AllToAllOp op, MeshAttr mesh, Attribute meshOrRef, Value input,
       ConversionPatternRewriter& rewriter) const {
@@ -830,7 +1248,8 @@ class AllToAllOpPattern : public OpConversionPattern<AllToAllOp> {
     Attribute replicaGroups;
     int64_t numDevicesPerGroup;
     std::tie(replicaGroups, numDevicesPerGroup) =
-        getReplicaGroupsAndSize(allAxes, mesh, meshOrRef, enableRGV3, rewriter);
+        getReplicaGroupsAndSize(allAxes, mesh, meshOrRef, enableRGV3, rewriter,
+                                conversionState);
     // The size of dim 0 that contains all the splitted factors, which is the
     // the same as the number of devices in each replica group.
     SmallVector<int64_t> shape1 = {numDevicesPerGroup};
@@ -892,13 +1311,26 @@ class AllToAllOpPattern : public OpConversionPattern<AllToAllOp> {
   LogicalResult matchAndRewrite(
       AllToAllOp op, OpAdaptor adaptor,
       ConversionPatternRewriter& rewriter) const override {
-    MeshAttr mesh = op.getOutSharding().getMesh(op);
+    auto* converter =
+        static_cast<const GlobalToLocalTypeConverter*>(getTypeConverter());
+    MeshAttr mesh = op.getOutSharding().getMesh(converter->getSymbolTable());
     if (!mesh) {
       return op.emitOpError("failed to resolve mesh");
     }
     Attribute meshOrRef = op.getOutSharding().getMeshOrRef();
     SDY_CHECK(!op.getParams().empty());
     if (op.getParams().size() == 1) {
+      if (hierarchicalCollectives) {
+        if (auto axesByLevel = getAxesByLevel(op, meshOrRef,
+                                              converter->getSymbolTable())) {
+          auto [majorAxes, minorAxes, majorAxesAreFast] = *axesByLevel;
+          if (succeeded(rewriteAllToAllHierarchical(
+                  op, mesh, meshOrRef, adaptor.getTensor(), majorAxes,
+                  minorAxes, majorAxesAreFast, rewriter))) {
+            return success();
+          }
+        }
+      }
       return rewriteAllToAllOneParam(op, mesh, meshOrRef, adaptor.getTensor(),
                                      rewriter);
     }
@@ -909,6 +1341,7 @@ class AllToAllOpPattern : public OpConversionPattern<AllToAllOp> {
  private:
   ConversionState& conversionState;
   bool enableRGV3;
+  bool hierarchicalCollectives;
 };
 
 class CollectivePermuteOpPattern
@@ -981,16 +1414,17 @@ class CollectivePermuteOpPattern
     SmallVector<AxisRefAttr> outShardingAxes = getShardingAxes(outSharding);
     int64_t numDevices = outMesh.getTotalSize();
     llvm::DenseMap<int64_t, int64_t> logicalIdToOutDevId;
-    for (int64_t j = 0; j < numDevices; ++j) {
-      logicalIdToOutDevId[getShardIndex(j, outMesh, outShardingAxes)] = j;
+    for (auto [j, shardIndex] :
+         llvm::enumerate(getShardIndices(outMesh, outShardingAxes))) {
+      logicalIdToOutDevId[shardIndex] = j;
     }
 
     SmallVector<AxisRefAttr> inShardingAxes = getShardingAxes(inSharding);
     SmallVector<int64_t> pairs;
-    for (int64_t i = 0; i < numDevices; ++i) {
+    for (auto [i, shardIndex] :
+         llvm::enumerate(getShardIndices(inMesh, inShardingAxes))) {
       pairs.push_back(i);
-      pairs.push_back(
-          logicalIdToOutDevId[getShardIndex(i, inMesh, inShardingAxes)]);
+      pairs.push_back(logicalIdToOutDevId[shardIndex]);
     }
 
     auto pairsAttr = DenseIntElementsAttr::get(
@@ -1041,13 +1475,25 @@ class ConstantOpPattern : public OpConversionPattern<sdy::ConstantOp> {
       return success();
     }
 
-    // Sharded dense constants.
     const SymbolTable& symbolTable = converter->getSymbolTable();
     TensorShardingAttr sharding = getSharding(op.getResult());
     MeshAttr mesh = sharding.getMesh(symbolTable);
     if (!mesh) {
       return op.emitOpError("failed to resolve mesh for constant");
     }
+
+    // Iota-like constants are materialized as a local iota, offset by the
+    // position of the shard, instead of embedding the global literal.
+    if (std::optional<int64_t> iotaDim = getIotaDimension(elementsAttr)) {
+      rewriter.replaceOp(
+          op, emitLocalIota(loc, localType, *iotaDim, mesh,
+                            sharding.getDimShardings()[*iotaDim].getAxes(),
+                            rewriter));
+      conversionState.removeToConvertOp(op);
+      return success();
+    }
+
+    // Sharded dense constants.
     auto globalConst =
         stablehlo::ConstantOp::create(rewriter, loc, globalType, elementsAttr);
 
@@ -1119,11 +1565,13 @@ class ReduceScatterOpPattern : public OpConversionPattern<ReduceScatterOp> {
   ReduceScatterOpPattern(TypeConverter& converter, MLIRContext* ctx,
                          ConversionState& state,
                          bool combineMultiDimensionReduceScatter,
-                         bool enableRGV3)
+                         bool enableRGV3,
+                         int64_t reducedPrecisionThresholdBytes)
       : OpConversionPattern<ReduceScatterOp>(converter, ctx),
         conversionState(state),
         combineMultiDimensionReduceScatter(combineMultiDimensionReduceScatter),
-        enableRGV3(enableRGV3) {}
+        enableRGV3(enableRGV3),
+        reducedPrecisionThresholdBytes(reducedPrecisionThresholdBytes) {}
 
   LogicalResult rewriteReduceScatterOneDim(
       ReduceScatterOp op, Value input, int64_t scatterDim, AxisRefListAttr axes,
@@ -1139,14 +1587,20 @@ class ReduceScatterOpPattern : public OpConversionPattern<ReduceScatterOp> {
         op->getContext(), conversionState.getNextChannelId(),
         kChannelHandleType);
     Attribute replicaGroups =
-        getReplicaGroups(axes, mesh, meshOrRef, enableRGV3, rewriter);
+        getReplicaGroups(axes, mesh, meshOrRef, enableRGV3, rewriter,
+                         conversionState);
+    Type elementType = getReducingCollectiveElementType(
+        inputType, reducedPrecisionThresholdBytes, rewriter);
     auto reduceScatter = stablehlo::ReduceScatterOp::create(
-        rewriter, loc, localResultType, input, scatterDim, replicaGroups,
-        channelHandle, /*use_global_device_ids=*/true);
+        rewriter, loc, localResultType.clone(elementType),
+        convertElementType(loc, input, elementType, rewriter), scatterDim,
+        replicaGroups, channelHandle, /*use_global_device_ids=*/true);
     stablehlo::buildReduceBody<stablehlo::AddOp>(
-        inputType.getElementType(), reduceScatter.getComputation(), rewriter);
+        elementType, reduceScatter.getComputation(), rewriter);
 
-    rewriter.replaceOp(op, reduceScatter.getResult());
+    rewriter.replaceOp(
+        op, convertElementType(loc, reduceScatter.getResult(),
+                               inputType.getElementType(), rewriter));
     conversionState.removeToConvertOp(op);
     return success();
   }
@@ -1222,26 +1676,33 @@ class ReduceScatterOpPattern : public OpConversionPattern<ReduceScatterOp> {
 
     // Perform one stablehlo.reduce_scatter on dimension 0.
     Attribute replicaGroups =
-        getReplicaGroups(allReduceAxes, mesh, meshOrRef, enableRGV3, rewriter);
+        getReplicaGroups(allReduceAxes, mesh, meshOrRef, enableRGV3, rewriter,
+                         conversionState);
     auto channelHandle = stablehlo::ChannelHandleAttr::get(
         op->getContext(), conversionState.getNextChannelId(),
         kChannelHandleType);
 
     // The result of the reduce-scatter will have dimension 0 reduced to size 1.
+    Type elementType = getReducingCollectiveElementType(
+        inputType, reducedPrecisionThresholdBytes, rewriter);
     combinedShape[0] = 1;
-    auto rsType =
-        RankedTensorType::get(combinedShape, inputType.getElementType());
+    auto rsType = RankedTensorType::get(combinedShape, elementType);
     auto reduceScatter = stablehlo::ReduceScatterOp::create(
-        rewriter, loc, rsType, curInput, /*scatter_dimension=*/0, replicaGroups,
-        channelHandle, /*use_global_device_ids=*/true);
+        rewriter, loc, rsType,
+        convertElementType(loc, curInput, elementType, rewriter),
+        /*scatter_dimension=*/0, replicaGroups, channelHandle,
+        /*use_global_device_ids=*/true);
     stablehlo::buildReduceBody<stablehlo::AddOp>(
-        inputType.getElementType(), reduceScatter.getComputation(), rewriter);
+        elementType, reduceScatter.getComputation(), rewriter);
 
     // Reshape to remove the leading dimension of size 1, matching the final
     // local shape.
-    rewriter.replaceOp(
-        op, stablehlo::ReshapeOp::create(rewriter, loc, localResultType,
-                                         reduceScatter.getResult()));
+    Value result = stablehlo::ReshapeOp::create(
+        rewriter, loc, localResultType.clone(elementType),
+        reduceScatter.getResult());
+    rewriter.replaceOp(op, convertElementType(loc, result,
+                                              inputType.getElementType(),
+                                              rewriter));
     conversionState.removeToConvertOp(op);
 
     return success();
@@ -1263,18 +1724,27 @@ class ReduceScatterOpPattern : public OpConversionPattern<ReduceScatterOp> {
         op->getContext(), conversionState.getNextChannelId(),
         kChannelHandleType);
     Attribute replicaGroups =
-        getReplicaGroups(allReduceAxes, mesh, meshOrRef, enableRGV3, rewriter);
+        getReplicaGroups(allReduceAxes, mesh, meshOrRef, enableRGV3, rewriter,
+                         conversionState);
 
+    // The threshold is checked against the all-reduced operand, which is what
+    // gets communicated.
+    Type elementType = getReducingCollectiveElementType(
+        inputType, reducedPrecisionThresholdBytes, rewriter);
     auto allReduce = stablehlo::AllReduceOp::create(
-        rewriter, loc, inputType, input, replicaGroups, channelHandle,
-        /*use_global_device_ids=*/true);
+        rewriter, loc, inputType.clone(elementType),
+        convertElementType(loc, input, elementType, rewriter), replicaGroups,
+        channelHandle, /*use_global_device_ids=*/true);
     stablehlo::buildReduceBody<stablehlo::AddOp>(
-        inputType.getElementType(), allReduce.getComputation(), rewriter);
+        elementType, allReduce.getComputation(), rewriter);
 
     // Perform the "Scatter" part using a multi-dimensional DynamicSlice.
-    Value localPiece =
+    Value localPiece = convertElementType(
+        loc,
         emitDynamicSliceForAxes(loc, allReduce.getResult(0), mesh,
-                                slicingAxesPerDim, localResultType, rewriter);
+                                slicingAxesPerDim,
+                                localResultType.clone(elementType), rewriter),
+        inputType.getElementType(), rewriter);
 
     rewriter.replaceOp(op, localPiece);
     conversionState.removeToConvertOp(op);
@@ -1329,6 +1799,7 @@ class ReduceScatterOpPattern : public OpConversionPattern<ReduceScatterOp> {
   ConversionState& conversionState;
   bool combineMultiDimensionReduceScatter;
   bool enableRGV3;
+  int64_t reducedPrecisionThresholdBytes;
 };
 
 class NamedComputationOpPattern
@@ -1834,6 +2305,132 @@ Value clampGatherIndices(Location loc, Value indices,
                                     buildIndicesLikeTensor(globalMaxValues));
 }
 
+// The maximum depth of the def chain that `getStaticIndexRange` looks through.
+constexpr int64_t kMaxIndexRangeDepth = 8;
+
+// Returns the inclusive range [min, max] of the values of the integer tensor
+// `indices`, if it can be computed statically by looking through its def
+// chain, e.g., for constants, iotas, and ops that only move or convert
+// values. Otherwise, returns std::nullopt.
+//
+// Note that `indices` is a global tensor, so the range is the same for all
+// shards, no matter how `indices` is sharded.
+std::optional<std::pair<int64_t, int64_t>> getStaticIndexRange(
+    Value indices, int64_t depth = 0) {
+  Operation* defOp = indices.getDefiningOp();
+  if (!defOp || depth > kMaxIndexRangeDepth) {
+    return std::nullopt;
+  }
+  auto getOperandRange = [&](Value operand) {
+    return getStaticIndexRange(operand, depth + 1);
+  };
+
+  return llvm::TypeSwitch<Operation*,
+                          std::optional<std::pair<int64_t, int64_t>>>(defOp)
+      .Case<stablehlo::ConstantOp>(
+          [](stablehlo::ConstantOp constantOp)
+              -> std::optional<std::pair<int64_t, int64_t>> {
+            auto attr = dyn_cast<DenseIntElementsAttr>(constantOp.getValue());
+            if (!attr || attr.empty() ||
+                attr.getElementType().isUnsignedInteger()) {
+              return std::nullopt;
+            }
+            if (attr.isSplat()) {
+              int64_t value = attr.getSplatValue<APInt>().getSExtValue();
+              return std::make_pair(value, value);
+            }
+            auto values = attr.getValues<APInt>();
+            int64_t min = (*values.begin()).getSExtValue();
+            int64_t max = min;
+            for (const APInt& value : values) {
+              min = std::min(min, value.getSExtValue());
+              max = std::max(max, value.getSExtValue());
+            }
+            return std::make_pair(min, max);
+          })
+      .Case<stablehlo::IotaOp>(
+          [](stablehlo::IotaOp iotaOp)
+              -> std::optional<std::pair<int64_t, int64_t>> {
+            int64_t dimSize =
+                iotaOp.getType().getDimSize(iotaOp.getIotaDimension());
+            if (dimSize <= 0) {
+              return std::nullopt;
+            }
+            return std::make_pair(int64_t{0}, dimSize - 1);
+          })
+      // Ops that only move values around, including collectives that don't
+      // change the global values.
+      .Case<stablehlo::BroadcastInDimOp, stablehlo::ReshapeOp,
+            stablehlo::SliceOp, stablehlo::TransposeOp, AllGatherOp,
+            AllSliceOp, AllToAllOp, CollectivePermuteOp>(
+          [&](Operation* op) { return getOperandRange(op->getOperand(0)); })
+      .Case<stablehlo::ConvertOp>(
+          [&](stablehlo::ConvertOp convertOp)
+              -> std::optional<std::pair<int64_t, int64_t>> {
+            auto srcType =
+                dyn_cast<IntegerType>(convertOp.getOperand().getType()
+                                          .getElementType());
+            auto dstType = dyn_cast<IntegerType>(
+                convertOp.getType().getElementType());
+            // Only signless and signed widening conversions preserve values.
+            if (!srcType || !dstType || srcType.isUnsigned() ||
+                dstType.isUnsigned() ||
+                srcType.getWidth() > dstType.getWidth()) {
+              return std::nullopt;
+            }
+            return getOperandRange(convertOp.getOperand());
+          })
+      .Case<stablehlo::ClampOp>(
+          [&](stablehlo::ClampOp clampOp)
+              -> std::optional<std::pair<int64_t, int64_t>> {
+            auto minRange = getOperandRange(clampOp.getMin());
+            auto maxRange = getOperandRange(clampOp.getMax());
+            if (!minRange || !maxRange) {
+              return std::nullopt;
+            }
+            // clamp(lo, x, hi) = min(max(x, lo), hi).
+            auto operandRange = getOperandRange(clampOp.getOperand());
+            int64_t lowerMin = operandRange
+                                   ? std::max(operandRange->first,
+                                              minRange->first)
+                                   : minRange->first;
+            int64_t lowerMax = operandRange
+                                   ? std::max(operandRange->second,
+                                              minRange->second)
+                                   : std::numeric_limits<int64_t>::max();
+            return std::make_pair(std::min(lowerMin, maxRange->first),
+                                  std::min(lowerMax, maxRange->second));
+          })
+      .Case<stablehlo::AddOp>(
+          [&](stablehlo::AddOp addOp)
+              -> std::optional<std::pair<int64_t, int64_t>> {
+            auto lhsRange = getOperandRange(addOp.getLhs());
+            auto rhsRange = getOperandRange(addOp.getRhs());
+            int64_t min, max;
+            if (!lhsRange || !rhsRange ||
+                llvm::AddOverflow(lhsRange->first, rhsRange->first, min) ||
+                llvm::AddOverflow(lhsRange->second, rhsRange->second, max)) {
+              return std::nullopt;
+            }
+            return std::make_pair(min, max);
+          })
+      .Default([](Operation*) { return std::nullopt; });
+}
+
+// Returns true if all indices in `indices` are statically known to be in
+// [0, global_dim_size - 1] for all indexed dims in `startIndexMap`, in which
+// case `clampGatherIndices` would be a no-op.
+bool areGatherIndicesInBounds(Value indices,
+                              RankedTensorType globalOperandType,
+                              ArrayRef<int64_t> startIndexMap) {
+  std::optional<std::pair<int64_t, int64_t>> range =
+      getStaticIndexRange(indices);
+  return range && range->first >= 0 &&
+         llvm::all_of(startIndexMap, [&](int64_t indexedDim) {
+           return range->second < globalOperandType.getDimSize(indexedDim);
+         });
+}
+
 // Computes the local indices and mask for a scatter or gather op with trivial
 // slice dimensions.
 //
@@ -1843,13 +2440,16 @@ Value clampGatherIndices(Location loc, Value indices,
 //
 // If there is any trivial slice dimension is not in start_index_map, we need to
 // compute a mask based on whether the global offset of the shard is 0.
+//
+// For gathers, the indices are clamped to the global operand bounds first,
+// unless `clampIndices` is false, i.e., the indices are known to be in bounds.
 template <typename DimNumbersOp>
 std::pair<Value, Value> computeLocalIndicesAndMask(
     Location loc, Value indices, MeshAttr mesh,
     TensorShardingAttr operandSharding, RankedTensorType globalOperandType,
     RankedTensorType localOperandType, DimNumbersOp dimNumbers,
     ArrayRef<int64_t> trivialSliceDims, ConversionPatternRewriter& rewriter,
-    bool computeMask = true) {
+    bool computeMask = true, bool clampIndices = true) {
   int64_t ivd = dimNumbers.getIndexVectorDim();
   ArrayRef<int64_t> startIndexMap;
   if constexpr (std::is_same_v<DimNumbersOp,
@@ -1872,10 +2472,12 @@ std::pair<Value, Value> computeLocalIndicesAndMask(
                                  stablehlo::ScatterDimensionNumbersAttr>) {
       // Use original unclamped indices so OOB indices stay OOB locally.
       baseIndices = indices;
-    } else {
+    } else if (clampIndices) {
       // Use globally clamped indices for gather semantics.
       baseIndices = clampGatherIndices(loc, indices, globalOperandType,
                                        startIndexMap, ivd, rewriter);
+    } else {
+      baseIndices = indices;
     }
     auto [minBounds, maxBounds] = getTrivialSliceDimBounds(
         loc, mesh, operandSharding, globalOperandType, localOperandType,
@@ -1968,6 +2570,204 @@ std::pair<Value, Value> computeLocalIndicesAndMask(
   return {adjustedIndices, mask};
 }
 
+// Pattern for stablehlo.dynamic_update_slice whose operand is sharded along a
+// slicing dimension, i.e., a dimension where the update is smaller than the
+// operand, and whose update is replicated along that dimension, e.g., a write
+// to a KV cache sharded along the sequence dimension. Each device writes the
+// part of the update that overlaps its shard into its local shard, so the
+// operand never moves.
+//
+// Along a sharded slicing dimension with update size `u` and shard size `L`,
+// the clamped global start index `s` is at local index `o = s - offset` of a
+// shard, which may be outside the shard. The local update window of size `u`
+// starts at `c = clamp(o, 0, L - u)`, and its element `k` is the update
+// element `k + c - o` if it is within the update, or the existing element of
+// the shard otherwise. Therefore, the window of a shard that doesn't overlap
+// the update rewrites the shard's own values.
+//
+// Returns an error if the update is larger than the local shard along a
+// sharded slicing dimension, or the result isn't sharded like the operand
+// along it. Ops whose update is sharded along a slicing dimension are
+// localized like generic ops.
+class StablehloDynamicUpdateSliceOpPattern
+    : public OpConversionPattern<stablehlo::DynamicUpdateSliceOp> {
+ public:
+  StablehloDynamicUpdateSliceOpPattern(TypeConverter& converter,
+                                       MLIRContext* ctx,
+                                       ConversionState& state)
+      : OpConversionPattern<stablehlo::DynamicUpdateSliceOp>(converter, ctx),
+        conversionState(state) {}
+
+  LogicalResult matchAndRewrite(
+      stablehlo::DynamicUpdateSliceOp op, OpAdaptor adaptor,
+      ConversionPatternRewriter& rewriter) const override {
+    auto* converter =
+        static_cast<const GlobalToLocalTypeConverter*>(getTypeConverter());
+    TensorShardingAttr operandSharding =
+        converter->getSharding(op.getOperand());
+    TensorShardingAttr updateSharding = converter->getSharding(op.getUpdate());
+    TensorShardingAttr outSharding = converter->getSharding(op.getResult());
+    if (isFullyReplicated(operandSharding)) {
+      return localizeGenericOp(op, adaptor.getOperands(), rewriter, converter,
+                               conversionState);
+    }
+
+    MeshAttr mesh = operandSharding.getMesh(converter->getSymbolTable());
+    if (!mesh) {
+      return op.emitOpError("failed to resolve mesh");
+    }
+
+    auto globalType = cast<RankedTensorType>(op.getOperand().getType());
+    auto globalUpdateType = cast<RankedTensorType>(op.getUpdate().getType());
+    auto localType = cast<RankedTensorType>(adaptor.getOperand().getType());
+    auto localUpdateType =
+        cast<RankedTensorType>(adaptor.getUpdate().getType());
+    SmallVector<int64_t> shardedSlicingDims;
+    for (int64_t dim = 0; dim < globalType.getRank(); ++dim) {
+      ArrayRef<AxisRefAttr> axes =
+          operandSharding.getDimShardings()[dim].getAxes();
+      if (axes.empty() ||
+          globalUpdateType.getDimSize(dim) == globalType.getDimSize(dim)) {
+        continue;
+      }
+      if (updateSharding &&
+          !updateSharding.getDimShardings()[dim].getAxes().empty()) {
+        return localizeGenericOp(op, adaptor.getOperands(), rewriter,
+                                 converter, conversionState);
+      }
+      if (!outSharding || outSharding.getDimShardings()[dim].getAxes() != axes) {
+        return op.emitOpError()
+               << "dimension " << dim
+               << " has mismatched operand and result sharding axes. This "
+                  "requires a reshard which should have been handled by "
+                  "previous passes.";
+      }
+      if (localUpdateType.getDimSize(dim) > localType.getDimSize(dim)) {
+        return op.emitOpError()
+               << "dimension " << dim
+               << " is sharded but the update is larger than the local shard "
+                  "and requires device communication.";
+      }
+      shardedSlicingDims.push_back(dim);
+    }
+    if (shardedSlicingDims.empty()) {
+      return localizeGenericOp(op, adaptor.getOperands(), rewriter, converter,
+                               conversionState);
+    }
+
+    Location loc = op.getLoc();
+    auto indexType = RankedTensorType::get({}, rewriter.getI64Type());
+    auto getIndexConstant = [&](int64_t value) -> Value {
+      return stablehlo::ConstantOp::create(
+          rewriter, loc, DenseIntElementsAttr::get(indexType, value));
+    };
+    RankedTensorType updateIndexType =
+        localUpdateType.clone(rewriter.getI64Type());
+    auto getIndexTensorConstant = [&](int64_t value) -> Value {
+      return stablehlo::ConstantOp::create(
+          rewriter, loc,
+          DenseIntElementsAttr::get(updateIndexType, value));
+    };
+
+    // The start indices of the local window, and of the part of the update
+    // that is written to it in the update padded by its size along each
+    // sharded slicing dimension.
+    SmallVector<Value> localStarts = llvm::map_to_vector(
+        adaptor.getStartIndices(), [&](Value index) -> Value {
+          if (index.getType() == indexType) {
+            return index;
+          }
+          return stablehlo::ConvertOp::create(rewriter, loc, indexType, index);
+        });
+    SmallVector<Value> updateStarts(globalType.getRank(),
+                                    getIndexConstant(0));
+    SmallVector<int64_t> updatePadding(globalType.getRank(), 0);
+    Value mask;
+    for (int64_t dim : shardedSlicingDims) {
+      int64_t updateSize = globalUpdateType.getDimSize(dim);
+      int64_t shardSize = localType.getDimSize(dim);
+      Value zeroIndex = getIndexConstant(0);
+      Value maxGlobalStart =
+          getIndexConstant(globalType.getDimSize(dim) - updateSize);
+      Value globalStart = stablehlo::ClampOp::create(
+          rewriter, loc, indexType, zeroIndex, localStarts[dim],
+          maxGlobalStart);
+      Value offset = getDimensionOffset(
+          loc, mesh, operandSharding.getDimShardings()[dim].getAxes(),
+          shardSize, rewriter);
+      Value start =
+          stablehlo::SubtractOp::create(rewriter, loc, globalStart, offset);
+      Value maxLocalStart = getIndexConstant(shardSize - updateSize);
+      localStarts[dim] = stablehlo::ClampOp::create(
+          rewriter, loc, indexType, zeroIndex, start, maxLocalStart);
+      Value shift = stablehlo::SubtractOp::create(rewriter, loc,
+                                                  localStarts[dim], start);
+      Value updateSizeIndex = getIndexConstant(updateSize);
+      updateStarts[dim] =
+          stablehlo::AddOp::create(rewriter, loc, shift, updateSizeIndex);
+      updatePadding[dim] = updateSize;
+
+      // The window element `k` is within the update iff
+      // `0 <= k + shift < updateSize`.
+      Value iota =
+          stablehlo::IotaOp::create(rewriter, loc, updateIndexType, dim);
+      Value broadcastShift = stablehlo::BroadcastInDimOp::create(
+          rewriter, loc, updateIndexType, shift,
+          rewriter.getDenseI64ArrayAttr({}));
+      Value updateIndex =
+          stablehlo::AddOp::create(rewriter, loc, iota, broadcastShift);
+      Value lowerBound = getIndexTensorConstant(0);
+      Value geLowerBound = stablehlo::CompareOp::create(
+          rewriter, loc, updateIndex, lowerBound,
+          stablehlo::ComparisonDirection::GE);
+      Value upperBound = getIndexTensorConstant(updateSize);
+      Value ltUpperBound = stablehlo::CompareOp::create(
+          rewriter, loc, updateIndex, upperBound,
+          stablehlo::ComparisonDirection::LT);
+      Value inUpdate =
+          stablehlo::AndOp::create(rewriter, loc, geLowerBound, ltUpperBound);
+      mask = mask ? stablehlo::AndOp::create(rewriter, loc, mask, inUpdate)
+                        .getResult()
+                  : inUpdate;
+    }
+
+    Type elementType = localUpdateType.getElementType();
+    Value zero = stablehlo::ConstantOp::create(
+        rewriter, loc,
+        DenseElementsAttr::get(RankedTensorType::get({}, elementType),
+                               rewriter.getZeroAttr(elementType)));
+    SmallVector<int64_t> paddedUpdateShape =
+        llvm::to_vector(localUpdateType.getShape());
+    for (int64_t dim : shardedSlicingDims) {
+      paddedUpdateShape[dim] += 2 * updatePadding[dim];
+    }
+    Value paddedUpdate = stablehlo::PadOp::create(
+        rewriter, loc, localUpdateType.clone(paddedUpdateShape),
+        adaptor.getUpdate(), zero,
+        rewriter.getDenseI64ArrayAttr(updatePadding),
+        rewriter.getDenseI64ArrayAttr(updatePadding),
+        rewriter.getDenseI64ArrayAttr(
+            SmallVector<int64_t>(globalType.getRank(), 0)));
+    Value shiftedUpdate = stablehlo::DynamicSliceOp::create(
+        rewriter, loc, localUpdateType, paddedUpdate, updateStarts,
+        localUpdateType.getShape());
+    Value existingWindow = stablehlo::DynamicSliceOp::create(
+        rewriter, loc, localUpdateType, adaptor.getOperand(), localStarts,
+        localUpdateType.getShape());
+    Value window = stablehlo::SelectOp::create(rewriter, loc, mask,
+                                               shiftedUpdate, existingWindow);
+    auto localOp = stablehlo::DynamicUpdateSliceOp::create(
+        rewriter, loc, adaptor.getOperand(), window, localStarts);
+    copyAttributes(op, localOp, /*attrsToExclude=*/{});
+    rewriter.replaceOp(op, localOp.getResult());
+    conversionState.removeToConvertOp(op);
+    return success();
+  }
+
+ private:
+  ConversionState& conversionState;
+};
+
 class StablehloGatherOpPattern
     : public OpConversionPattern<stablehlo::GatherOp> {
  public:
@@ -2030,12 +2830,17 @@ class StablehloGatherOpPattern
     }
 
     // There are trivial slice dimensions. We need to adjust the start_indices,
-    // and compute a mask.
+    // and compute a mask. The global indices are clamped first, unless they
+    // are statically known to be in bounds.
+    bool indicesInBounds =
+        areGatherIndicesInBounds(op.getStartIndices(), globalOperandType,
+                                 dimNumbers.getStartIndexMap());
     auto [adjustedIndices, mask] = computeLocalIndicesAndMask(
         loc, adaptor.getStartIndices(), mesh, operandSharding,
         globalOperandType,
         cast<RankedTensorType>(adaptor.getOperand().getType()), dimNumbers,
-        trivialSliceDims, rewriter);
+        trivialSliceDims, rewriter, /*computeMask=*/true,
+        /*clampIndices=*/!indicesInBounds);
     Value result = stablehlo::GatherOp::create(
         rewriter, loc, converter->convertType(op.getResult()),
         adaptor.getOperand(), adjustedIndices, dimNumbers,
@@ -2141,32 +2946,11 @@ class StablehloIotaOpPattern : public OpConversionPattern<stablehlo::IotaOp> {
       return op.emitOpError("failed to resolve mesh");
     }
     auto localType = cast<RankedTensorType>(converter->convertType(op));
-    Location loc = op.getLoc();
     int64_t iotaDim = op.getIotaDimension();
-    // Create the local iota.
-    Value localIota =
-        stablehlo::IotaOp::create(rewriter, loc, localType, iotaDim);
-    if (sharding.getDimShardings()[iotaDim].getAxes().empty()) {
-      rewriter.replaceOp(op, localIota);
-      conversionState.removeToConvertOp(op);
-      return success();
-    }
-
-    // Calculate and apply the global offset for this shard.
-    int64_t shardSize = localType.getDimSize(iotaDim);
-    Type convertedOffsetType =
-        RankedTensorType::get({}, localType.getElementType());
-    Value offset = getDimensionOffset(
-        loc, mesh, sharding.getDimShardings()[iotaDim].getAxes(), shardSize,
-        rewriter);
-    Value offsetConverted = stablehlo::ConvertOp::create(
-        rewriter, loc, convertedOffsetType, offset);
-    Value broadcastOffset = stablehlo::BroadcastInDimOp::create(
-        rewriter, loc, localType, offsetConverted,
-        rewriter.getDenseI64ArrayAttr({}));
-    rewriter.replaceOpWithNewOp<stablehlo::AddOp>(op, localIota,
-                                                  broadcastOffset);
-
+    rewriter.replaceOp(
+        op, emitLocalIota(op.getLoc(), localType, iotaDim, mesh,
+                          sharding.getDimShardings()[iotaDim].getAxes(),
+                          rewriter));
     conversionState.removeToConvertOp(op);
     return success();
   }
@@ -2236,9 +3020,11 @@ class StablehloPadOpPattern : public OpConversionPattern<stablehlo::PadOp> {
       int64_t sOut = globalResultType.getDimSize(i) /
                      (outAxes.empty() ? 1 : totalAxesSize);
 
+      SmallVector<int64_t> inShardIndices = getShardIndices(mesh, inAxes);
+      SmallVector<int64_t> outShardIndices = getShardIndices(mesh, outAxes);
       for (int64_t devId = 0; devId < numDevices; ++devId) {
-        int64_t kIn = getShardIndex(devId, mesh, inAxes);
-        int64_t kOut = getShardIndex(devId, mesh, outAxes);
+        int64_t kIn = inShardIndices[devId];
+        int64_t kOut = outShardIndices[devId];
         // offset = (GlobalStartOfInputData)−(GlobalStartOfOutputShard)
         allOffsets[i][devId] = (kIn * sIn) * (pInt + 1) + pLow - (kOut * sOut);
         if (allOffsets[i][devId] != allOffsets[i][0]) {
@@ -2507,9 +3293,8 @@ class StablehloScatterOpPattern
       // Generate leader mask: (shardIndex(reductionAxes) == 0).
       int64_t numDevices = mesh.getTotalSize();
       SmallVector<bool> leaderTable = llvm::map_to_vector(
-          llvm::seq<int64_t>(0, numDevices), [&](int64_t devId) {
-            return getShardIndex(devId, mesh, reductionAxes) == 0;
-          });
+          getShardIndices(mesh, reductionAxes),
+          [](int64_t shardIndex) { return shardIndex == 0; });
       Value partitionId = stablehlo::ConvertOp::create(
           rewriter, loc, RankedTensorType::get({}, rewriter.getI64Type()),
           stablehlo::PartitionIdOp::create(rewriter, loc));
@@ -2759,6 +3544,362 @@ class StablehloWindowedOpPattern : public OpConversionPattern<OpTy> {
   ConversionState& conversionState;
 };
 
+// Returns the dimension of the result of `dotOp`, a `stablehlo.dot` or
+// `stablehlo.dot_general`, that corresponds to `lhsDim`, or nullopt if `lhsDim`
+// is a batching or contracting dimension.
+std::optional<int64_t> getLhsNonContractingResultDim(Operation* dotOp,
+                                                     int64_t lhsDim) {
+  if (auto dotGeneral = dyn_cast<stablehlo::DotGeneralOp>(dotOp)) {
+    stablehlo::DotDimensionNumbersAttr dimNums =
+        dotGeneral.getDotDimensionNumbers();
+    ArrayRef<int64_t> batchingDims = dimNums.getLhsBatchingDimensions();
+    ArrayRef<int64_t> contractingDims = dimNums.getLhsContractingDimensions();
+    if (llvm::is_contained(batchingDims, lhsDim) ||
+        llvm::is_contained(contractingDims, lhsDim)) {
+      return std::nullopt;
+    }
+    // The result dimensions are the batching dimensions, followed by the
+    // non-contracting dimensions of the LHS in order, then those of the RHS.
+    int64_t resultDim = batchingDims.size();
+    for (int64_t dim = 0; dim < lhsDim; ++dim) {
+      if (!llvm::is_contained(batchingDims, dim) &&
+          !llvm::is_contained(contractingDims, dim)) {
+        ++resultDim;
+      }
+    }
+    return resultDim;
+  }
+  // The LHS of a `stablehlo.dot` is a vector, whose only dimension is
+  // contracting, or a matrix, whose first dimension is non-contracting.
+  auto dot = cast<stablehlo::DotOp>(dotOp);
+  if (cast<RankedTensorType>(dot.getLhs().getType()).getRank() == 2 &&
+      lhsDim == 0) {
+    return 0;
+  }
+  return std::nullopt;
+}
+
+// A dot whose LHS is all-gathered along a non-contracting dimension, which can
+// be decomposed into a collective matmul.
+struct CollectiveMatmulCandidate {
+  Operation* dotOp;
+  stablehlo::AllGatherOp allGather;
+  int64_t resultDim;
+};
+
+// Returns the candidate for a collective matmul rooted at `dotOp`, if its LHS
+// is the only use of a single-operand `stablehlo.all_gather` with explicit
+// replica groups of global device ids, along a non-contracting dimension, of at least
+// `thresholdBytes` bytes.
+std::optional<CollectiveMatmulCandidate> getCollectiveMatmulCandidate(
+    Operation* dotOp, int64_t thresholdBytes) {
+  auto allGather =
+      dotOp->getOperand(0).getDefiningOp<stablehlo::AllGatherOp>();
+  // Without global device ids, the replica groups don't hold partition ids.
+  if (!allGather || allGather->getNumOperands() != 1 ||
+      !allGather->hasOneUse() || !allGather.getUseGlobalDeviceIds() ||
+      !isa<DenseIntElementsAttr>(allGather.getReplicaGroups())) {
+    return std::nullopt;
+  }
+  auto gatheredType =
+      dyn_cast<RankedTensorType>(allGather->getResult(0).getType());
+  auto resultType = dyn_cast<RankedTensorType>(dotOp->getResult(0).getType());
+  if (!gatheredType || !gatheredType.hasStaticShape() || !resultType ||
+      !resultType.hasStaticShape()) {
+    return std::nullopt;
+  }
+  if (gatheredType.getNumElements() *
+          getElementTypeBytes(gatheredType.getElementType()) <
+      thresholdBytes) {
+    return std::nullopt;
+  }
+  std::optional<int64_t> resultDim =
+      getLhsNonContractingResultDim(dotOp, allGather.getAllGatherDim());
+  if (!resultDim) {
+    return std::nullopt;
+  }
+  return CollectiveMatmulCandidate{dotOp, allGather, *resultDim};
+}
+
+// Decomposes the all-gather of the LHS of the dot of `candidate` into a ring
+// of collective-permutes, interleaved with dots of the local LHS chunk, so that
+// communication overlaps computation.
+//
+// With a ring of size N where the device at position `p` holds chunk `p` of the
+// LHS, at step `s` every device computes the dot of the chunk it holds,
+// `(p + s) % N`, into the corresponding slice of the result, while sending that
+// chunk to the previous device in the ring.
+void decomposeCollectiveMatmul(const CollectiveMatmulCandidate& candidate,
+                               ConversionState& conversionState) {
+  Operation* dotOp = candidate.dotOp;
+  stablehlo::AllGatherOp allGather = candidate.allGather;
+  Location loc = dotOp->getLoc();
+  OpBuilder builder(dotOp);
+  MLIRContext* ctx = dotOp->getContext();
+
+  auto replicaGroups = cast<DenseIntElementsAttr>(allGather.getReplicaGroups());
+  ArrayRef<int64_t> groupsShape = replicaGroups.getType().getShape();
+  int64_t ringSize = groupsShape.back();
+  int64_t numDevices = replicaGroups.getNumElements();
+  SmallVector<int64_t> groups =
+      llvm::to_vector(replicaGroups.getValues<int64_t>());
+
+  // The ring position of each device, and the pairs sending each chunk to the
+  // previous device in the ring.
+  SmallVector<int64_t> ringPositions(numDevices);
+  SmallVector<int64_t> pairs;
+  pairs.reserve(numDevices * 2);
+  for (int64_t groupStart = 0; groupStart < numDevices;
+       groupStart += ringSize) {
+    for (int64_t pos = 0; pos < ringSize; ++pos) {
+      int64_t deviceId = groups[groupStart + pos];
+      SDY_CHECK(deviceId >= 0 && deviceId < numDevices)
+          << "Expected replica groups to hold device ids in [0, numDevices)";
+      ringPositions[deviceId] = pos;
+      pairs.push_back(deviceId);
+      pairs.push_back(groups[groupStart + (pos + ringSize - 1) % ringSize]);
+    }
+  }
+  auto pairsAttr = DenseIntElementsAttr::get(
+      RankedTensorType::get({numDevices, 2}, builder.getI64Type()), pairs);
+
+  auto resultType = cast<RankedTensorType>(dotOp->getResult(0).getType());
+  int64_t chunkSize = cast<RankedTensorType>(allGather.getOperand(0).getType())
+                          .getDimSize(allGather.getAllGatherDim());
+  SmallVector<int64_t> partialShape = llvm::to_vector(resultType.getShape());
+  partialShape[candidate.resultDim] = chunkSize;
+  auto partialType =
+      RankedTensorType::get(partialShape, resultType.getElementType());
+
+  auto zeroIndex = stablehlo::ConstantOp::create(
+      builder, loc,
+      DenseIntElementsAttr::get(RankedTensorType::get({}, builder.getI64Type()),
+                                static_cast<int64_t>(0)));
+  Value result = stablehlo::ConstantOp::create(
+      builder, loc,
+      DenseElementsAttr::get(
+          resultType, builder.getZeroAttr(resultType.getElementType())));
+  Value chunk = allGather.getOperand(0);
+  for (int64_t step = 0; step < ringSize; ++step) {
+    // The next chunk is sent before the current one is used, so that the
+    // transfer can overlap with the dot.
+    Value nextChunk;
+    if (step + 1 < ringSize) {
+      auto channel = stablehlo::ChannelHandleAttr::get(
+          ctx, conversionState.getNextChannelId(), kChannelHandleType);
+      nextChunk = stablehlo::CollectivePermuteOp::create(
+          builder, loc, chunk.getType(), chunk, pairsAttr, channel);
+    }
+
+    IRMapping mapping;
+    mapping.map(dotOp->getOperand(0), chunk);
+    Operation* partialDot = builder.clone(*dotOp, mapping);
+    partialDot->getResult(0).setType(partialType);
+
+    SmallVector<int64_t> offsetsTable = llvm::map_to_vector(
+        ringPositions, [&](int64_t pos) {
+          return ((pos + step) % ringSize) * chunkSize;
+        });
+    SmallVector<Value> startIndices(resultType.getRank(), zeroIndex);
+    startIndices[candidate.resultDim] =
+        lookUpDeviceTable(loc, offsetsTable, builder);
+    result = stablehlo::DynamicUpdateSliceOp::create(
+        builder, loc, result, partialDot->getResult(0), startIndices);
+    chunk = nextChunk;
+  }
+
+  dotOp->getResult(0).replaceAllUsesWith(result);
+  dotOp->erase();
+  allGather->erase();
+}
+
+// Decomposes every dot in `topLevelOp` whose LHS is all-gathered along a
+// non-contracting dimension, and is at least `thresholdBytes` bytes once
+// gathered, into a collective matmul.
+void applyCollectiveMatmul(Operation* topLevelOp, int64_t thresholdBytes,
+                           ConversionState& conversionState) {
+  SmallVector<CollectiveMatmulCandidate> candidates;
+  topLevelOp->walk([&](Operation* op) {
+    if (!isa<stablehlo::DotOp, stablehlo::DotGeneralOp>(op)) {
+      return;
+    }
+    if (std::optional<CollectiveMatmulCandidate> candidate =
+            getCollectiveMatmulCandidate(op, thresholdBytes)) {
+      candidates.push_back(*candidate);
+    }
+  });
+  for (const CollectiveMatmulCandidate& candidate : candidates) {
+    decomposeCollectiveMatmul(candidate, conversionState);
+  }
+}
+
+// An `mhlo.topk` custom call whose operand is all-gathered along the top-k
+// dimension, i.e., the minor-most one, which can be computed as a distributed
+// top-k.
+struct DistributedTopKCandidate {
+  stablehlo::CustomCallOp topK;
+  stablehlo::AllGatherOp allGather;
+};
+
+// Returns the candidate for a distributed top-k rooted at `customCall`, if it's
+// a top-k of the largest elements whose operand is the only use of a
+// single-operand `stablehlo.all_gather` with explicit replica groups of global
+// device ids, along the minor-most dimension, and each shard has at least k
+// elements.
+std::optional<DistributedTopKCandidate> getDistributedTopKCandidate(
+    stablehlo::CustomCallOp customCall) {
+  if (customCall.getCallTargetName() != "mhlo.topk" ||
+      customCall->getNumOperands() != 1 || customCall->getNumResults() != 2) {
+    return std::nullopt;
+  }
+  if (auto attributes =
+          customCall->getAttrOfType<DictionaryAttr>("mhlo.attributes")) {
+    if (auto largest = attributes.getAs<BoolAttr>("largest");
+        largest && !largest.getValue()) {
+      return std::nullopt;
+    }
+  }
+  auto allGather =
+      customCall->getOperand(0).getDefiningOp<stablehlo::AllGatherOp>();
+  // Without global device ids, the replica groups don't hold partition ids.
+  if (!allGather || allGather->getNumOperands() != 1 ||
+      !allGather->hasOneUse() || !allGather.getUseGlobalDeviceIds() ||
+      !isa<DenseIntElementsAttr>(allGather.getReplicaGroups())) {
+    return std::nullopt;
+  }
+  auto shardType = dyn_cast<RankedTensorType>(allGather.getOperand(0).getType());
+  auto valuesType =
+      dyn_cast<RankedTensorType>(customCall->getResult(0).getType());
+  if (!shardType || !shardType.hasStaticShape() || !valuesType ||
+      !valuesType.hasStaticShape() || shardType.getRank() == 0 ||
+      allGather.getAllGatherDim() != shardType.getRank() - 1 ||
+      valuesType.getShape().back() > shardType.getShape().back()) {
+    return std::nullopt;
+  }
+  return DistributedTopKCandidate{customCall, allGather};
+}
+
+// Replaces the top-k of `candidate`, and the all-gather of its operand, with a
+// top-k of the local shard, an all-gather of the k candidates of each shard
+// with their global indices, and a final top-k of the gathered candidates, which
+// is computed by a stable sort followed by a slice, so that the k candidates
+// of each shard are gathered instead of the entire operand.
+void decomposeDistributedTopK(const DistributedTopKCandidate& candidate,
+                              ConversionState& conversionState) {
+  stablehlo::CustomCallOp topK = candidate.topK;
+  stablehlo::AllGatherOp allGather = candidate.allGather;
+  Location loc = topK.getLoc();
+  OpBuilder builder(topK);
+  MLIRContext* ctx = topK->getContext();
+
+  auto replicaGroups = cast<DenseIntElementsAttr>(allGather.getReplicaGroups());
+  int64_t groupSize = replicaGroups.getType().getShape().back();
+  int64_t numDevices = replicaGroups.getNumElements();
+  SmallVector<int64_t> groups =
+      llvm::to_vector(replicaGroups.getValues<int64_t>());
+
+  Value shard = allGather.getOperand(0);
+  auto shardType = cast<RankedTensorType>(shard.getType());
+  int64_t topKDim = shardType.getRank() - 1;
+  int64_t shardSize = shardType.getDimSize(topKDim);
+
+  // The offset of the shard of each device along the top-k dimension.
+  SmallVector<int64_t> offsetsTable(numDevices);
+  for (int64_t groupStart = 0; groupStart < numDevices;
+       groupStart += groupSize) {
+    for (int64_t pos = 0; pos < groupSize; ++pos) {
+      int64_t deviceId = groups[groupStart + pos];
+      SDY_CHECK(deviceId >= 0 && deviceId < numDevices)
+          << "Expected replica groups to hold device ids in [0, numDevices)";
+      offsetsTable[deviceId] = pos * shardSize;
+    }
+  }
+
+  // The local top-k has the same result types as the original one.
+  IRMapping mapping;
+  mapping.map(topK->getOperand(0), shard);
+  Operation* localTopK = builder.clone(*topK, mapping);
+  Value localValues = localTopK->getResult(0);
+  Value localIndices = localTopK->getResult(1);
+  auto valuesType = cast<RankedTensorType>(localValues.getType());
+  auto indicesType = cast<RankedTensorType>(localIndices.getType());
+
+  Value offset = stablehlo::ConvertOp::create(
+      builder, loc, RankedTensorType::get({}, indicesType.getElementType()),
+      lookUpDeviceTable(loc, offsetsTable, builder));
+  Value globalIndices = stablehlo::AddOp::create(
+      builder, loc, localIndices,
+      stablehlo::BroadcastInDimOp::create(builder, loc, indicesType, offset,
+                                          builder.getDenseI64ArrayAttr({})));
+
+  auto getGatheredType = [&](RankedTensorType type) {
+    SmallVector<int64_t> shape = llvm::to_vector(type.getShape());
+    shape[topKDim] *= groupSize;
+    return RankedTensorType::get(shape, type.getElementType());
+  };
+  auto channelHandle = stablehlo::ChannelHandleAttr::get(
+      ctx, conversionState.getNextChannelId(), kChannelHandleType);
+  auto gatheredCandidates = stablehlo::AllGatherOp::create(
+      builder, loc,
+      TypeRange{getGatheredType(valuesType), getGatheredType(indicesType)},
+      ValueRange{localValues, globalIndices}, topKDim, replicaGroups,
+      channelHandle, /*use_global_device_ids=*/true);
+
+  // The candidates are gathered in increasing order of their global indices
+  // for equal values, so a stable sort keeps the lowest index first, like
+  // top-k does.
+  auto sort = stablehlo::SortOp::create(builder, loc,
+                                        gatheredCandidates->getResults(),
+                                        topKDim, /*is_stable=*/true);
+  {
+    OpBuilder::InsertionGuard guard(builder);
+    auto valueScalarType =
+        RankedTensorType::get({}, valuesType.getElementType());
+    auto indexScalarType =
+        RankedTensorType::get({}, indicesType.getElementType());
+    Block* comparator = builder.createBlock(
+        &sort.getComparator(), {},
+        {valueScalarType, valueScalarType, indexScalarType, indexScalarType},
+        SmallVector<Location>(4, loc));
+    Value isGreater = stablehlo::CompareOp::create(
+        builder, loc, comparator->getArgument(0), comparator->getArgument(1),
+        stablehlo::ComparisonDirection::GT,
+        isa<FloatType>(valuesType.getElementType())
+            ? stablehlo::ComparisonType::TOTALORDER
+            : stablehlo::ComparisonType::NOTYPE);
+    stablehlo::ReturnOp::create(builder, loc, isGreater);
+  }
+
+  SmallVector<int64_t> startIndices(valuesType.getRank(), 0);
+  SmallVector<int64_t> strides(valuesType.getRank(), 1);
+  for (auto [result, sorted] :
+       llvm::zip_equal(topK->getResults(), sort.getResults())) {
+    auto resultType = cast<RankedTensorType>(result.getType());
+    result.replaceAllUsesWith(stablehlo::SliceOp::create(
+        builder, loc, resultType, sorted, startIndices, resultType.getShape(),
+        strides));
+  }
+  topK->erase();
+  allGather->erase();
+}
+
+// Replaces every `mhlo.topk` in `topLevelOp` whose operand is all-gathered
+// along the top-k dimension with a distributed top-k, see
+// `decomposeDistributedTopK`.
+void applyDistributedTopK(Operation* topLevelOp,
+                          ConversionState& conversionState) {
+  SmallVector<DistributedTopKCandidate> candidates;
+  topLevelOp->walk([&](stablehlo::CustomCallOp customCall) {
+    if (std::optional<DistributedTopKCandidate> candidate =
+            getDistributedTopKCandidate(customCall)) {
+      candidates.push_back(*candidate);
+    }
+  });
+  for (const DistributedTopKCandidate& candidate : candidates) {
+    decomposeDistributedTopK(candidate, conversionState);
+  }
+}
+
 // This pass converts a Shardy module with consistent sharding notations and
 // global tensor types to a module with local tensor types.
 //
@@ -2778,6 +3919,10 @@ class StablehloWindowedOpPattern : public OpConversionPattern<OpTy> {
 // argument. To resolve this, we collect a map from function arguments to
 // sharding attributes before we start to convert any ops.
 //
+// Each top-level op in the module is converted independently, and in parallel
+// if multi-threading is enabled. Channel ids are assigned once all top-level
+// ops are converted, so the result doesn't depend on the number of threads.
+//
 struct ConvertGlobalToLocalPass
     : public impl::ConvertGlobalToLocalPassBase<ConvertGlobalToLocalPass> {
   using ConvertGlobalToLocalPassBase::ConvertGlobalToLocalPassBase;
@@ -2786,9 +3931,47 @@ struct ConvertGlobalToLocalPass
   void runOnOperation() final {
     ModuleOp module = getOperation();
     SymbolTable symbolTable(module);
+
+    // Top-level ops, i.e., functions, are converted independently and in
+    // parallel, each with its own conversion state. Mesh ops are always legal
+    // and are only read during conversion.
+    SmallVector<Operation*> topLevelOps;
+    for (Operation& op : module.getOps()) {
+      if (!isa<MeshOp>(op)) {
+        topLevelOps.push_back(&op);
+      }
+    }
+    SmallVector<ConversionState> conversionStates(topLevelOps.size());
+    if (failed(failableParallelForEach(
+            &getContext(), llvm::seq<int64_t>(0, topLevelOps.size()),
+            [&](int64_t index) {
+              return convertTopLevelOp(topLevelOps[index], symbolTable,
+                                       conversionStates[index]);
+            }))) {
+      signalPassFailure();
+      return;
+    }
+
+    // Channel ids are assigned after all top-level ops are converted, in the
+    // order of the ops in the module, so that they are deterministic.
+    int64_t nextChannelId = getNextChannelId(module);
+    for (auto [op, conversionState] :
+         llvm::zip_equal(topLevelOps, conversionStates)) {
+      if (conversionState.numChannelIds > 0) {
+        assignChannelIds(op, nextChannelId);
+        nextChannelId += conversionState.numChannelIds;
+      }
+    }
+  }
+
+ private:
+  LogicalResult convertTopLevelOp(Operation* topLevelOp,
+                                  const SymbolTable& symbolTable,
+                                  ConversionState& conversionState) {
+    MLIRContext* ctx = &getContext();
     GlobalToLocalTypeConverter typeConverter(symbolTable);
 
-    module.walk([&](Operation* op) {
+    topLevelOp->walk([&](Operation* op) {
       if (auto funcOp = dyn_cast<func::FuncOp>(op)) {
         typeConverter.populateArgShardings(funcOp);
       } else if (auto dataFlowOp = dyn_cast<ShardableDataFlowOpInterface>(op)) {
@@ -2796,20 +3979,13 @@ struct ConvertGlobalToLocalPass
       }
     });
 
-    ConversionState conversionState;
-    // Walk the module and collect the set of ops that need to be converted.
-    // We use the set to determine whether a given op is legal or not during
-    // conversion.
-    module.walk([&](Operation* op) {
-      if (isa<MeshOp, ModuleOp>(op)) {
-        // Ops that are always legal do not need to be converted.
-        return;
-      }
-      conversionState.addToConvertOp(op);
-    });
-    conversionState.nextChannelId = getNextChannelId(module);
+    // Walk the top-level op and collect the set of ops that need to be
+    // converted. We use the set to determine whether a given op is legal or not
+    // during conversion.
+    topLevelOp->walk(
+        [&](Operation* op) { conversionState.addToConvertOp(op); });
 
-    RewritePatternSet patterns(&getContext());
+    RewritePatternSet patterns(ctx);
     populateFunctionOpInterfaceTypeConversionPattern<func::FuncOp>(
         patterns, typeConverter);
     populateCallOpTypeConversionPattern(patterns, typeConverter);
@@ -2819,23 +3995,27 @@ struct ConvertGlobalToLocalPass
                  ManualComputationOpPattern, NamedComputationOpPattern,
                  ReturnOpPattern, StablehloConcatenateOpPattern,
                  StablehloConvolutionOpPattern, StablehloDotGeneralOpPattern,
-                 StablehloDotOpPattern, StablehloGatherOpPattern,
+                 StablehloDotOpPattern, StablehloDynamicUpdateSliceOpPattern,
+                 StablehloGatherOpPattern,
                  StablehloIotaOpPattern, StablehloPadOpPattern,
                  StablehloWindowedOpPattern<stablehlo::ReduceWindowOp>,
                  StablehloScatterOpPattern,
                  StablehloWindowedOpPattern<stablehlo::SelectAndScatterOp>,
-                 StablehloSliceOpPattern>(typeConverter, &getContext(),
+                 StablehloSliceOpPattern>(typeConverter, ctx,
                                           conversionState);
-    patterns.add<AllReduceOpPattern, AllToAllOpPattern>(
-        typeConverter, &getContext(), conversionState, enableRGV3);
-    patterns.add<AllGatherOpPattern>(typeConverter, &getContext(),
-                                     conversionState, perDimAllGather,
-                                     enableRGV3);
+    patterns.add<AllToAllOpPattern>(typeConverter, ctx, conversionState,
+                                    enableRGV3, hierarchicalCollectives);
+    patterns.add<AllReduceOpPattern>(typeConverter, ctx, conversionState,
+                                     enableRGV3,
+                                     reducedPrecisionCollectiveThresholdBytes,
+                                     hierarchicalCollectives);
+    patterns.add<AllGatherOpPattern>(typeConverter, ctx, conversionState,
+                                     perDimAllGather, enableRGV3);
     patterns.add<ReduceScatterOpPattern>(
-        typeConverter, &getContext(), conversionState,
-        combineMultiDimensionReduceScatter, enableRGV3);
+        typeConverter, ctx, conversionState, combineMultiDimensionReduceScatter,
+        enableRGV3, reducedPrecisionCollectiveThresholdBytes);
 
-    ConversionTarget target(getContext());
+    ConversionTarget target(*ctx);
     target.addDynamicallyLegalOp<func::FuncOp>(
         [&](func::FuncOp op) { return !conversionState.needConversion(op); });
     target.addDynamicallyLegalOp<func::ReturnOp>(
@@ -2850,9 +4030,18 @@ struct ConvertGlobalToLocalPass
     target.markUnknownOpDynamicallyLegal(
         [&](Operation* op) { return !conversionState.needConversion(op); });
 
-    if (failed(applyPartialConversion(module, target, std::move(patterns)))) {
-      signalPassFailure();
+    if (failed(
+            applyPartialConversion(topLevelOp, target, std::move(patterns)))) {
+      return failure();
+    }
+    if (collectiveMatmulThresholdBytes >= 0) {
+      applyCollectiveMatmul(topLevelOp, collectiveMatmulThresholdBytes,
+                            conversionState);
     }
+    if (distributedTopK) {
+      applyDistributedTopK(topLevelOp, conversionState);
+    }
+    return success();
   }
 };
 
@@ -0,0 +1,225 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
+#include "shardy/dialect/sdy/transforms/export/explicit_reshards_util.h"
+#include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
+#include "shardy/dialect/sdy/transforms/export/utils.h"
+#include "stablehlo/dialect/StablehloOps.h"
+
+#define DEBUG_TYPE "sdy-delay-unreduced-reductions"
+
+namespace mlir {
+namespace sdy {
+
+#define GEN_PASS_DEF_DELAYUNREDUCEDREDUCTIONSPASS
+#include "shardy/dialect/sdy/transforms/export/passes.h.inc"
+
+namespace {
+
+// Returns the axes in `axes` that don't overlap with any axis in `sharding`.
+SmallVector<AxisRefAttr> getAxesNotIn(ArrayRef<AxisRefAttr> axes,
+                                      TensorShardingAttr sharding) {
+  SmallVector<AxisRefAttr> result;
+  for (AxisRefAttr axis : axes) {
+    if (!sharding || !sharding.anyOfAxisRef([&](AxisRefAttr other) {
+          return axis.overlaps(other);
+        })) {
+      result.push_back(axis);
+    }
+  }
+  return result;
+}
+
+// Returns the unreduced axes of the linear operand of a scaling op, i.e., one
+// whose result is `linearOperand` combined element-wise with a `scale` that
+// doesn't depend on the partial sums. The axes must be replicated in `scale`.
+SmallVector<AxisRefAttr> getScaledAxes(Value linearOperand, Value scale,
+                                       SmallVectorImpl<Value>& partialSums) {
+  partialSums.push_back(linearOperand);
+  return getAxesNotIn(getUnreducedAxes(linearOperand), getSharding(scale));
+}
+
+// Returns the unreduced axes that can be pushed from the operands of `op` to
+// its result, since `op` is linear in those operands, which are added to
+// `partialSums`. That is, on each device, applying `op` to the partial sums
+// along these axes gives the partial sum of the result.
+//
+// Returns an empty vector if `op` isn't linear in its unreduced operands.
+SmallVector<AxisRefAttr> getLinearUnreducedAxes(
+    Operation* op, SmallVectorImpl<Value>& partialSums) {
+  return TypeSwitch<Operation*, SmallVector<AxisRefAttr>>(op)
+      .Case<stablehlo::AddOp, stablehlo::SubtractOp>([&](auto) {
+        // Both operands must be partial sums along the same axes, otherwise
+        // the other operand would be added once per device.
+        Value lhs = op->getOperand(0);
+        Value rhs = op->getOperand(1);
+        partialSums.append({lhs, rhs});
+        SmallVector<AxisRefAttr> axes;
+        for (AxisRefAttr axis : getUnreducedAxes(lhs)) {
+          if (llvm::is_contained(getUnreducedAxes(rhs), axis)) {
+            axes.push_back(axis);
+          }
+        }
+        return axes;
+      })
+      .Case<stablehlo::MulOp>([&](stablehlo::MulOp mulOp) {
+        if (getUnreducedAxes(mulOp.getRhs()).empty()) {
+          return getScaledAxes(mulOp.getLhs(), mulOp.getRhs(), partialSums);
+        }
+        if (getUnreducedAxes(mulOp.getLhs()).empty()) {
+          return getScaledAxes(mulOp.getRhs(), mulOp.getLhs(), partialSums);
+        }
+        return SmallVector<AxisRefAttr>();
+      })
+      .Case<stablehlo::DivOp>([&](stablehlo::DivOp divOp) {
+        if (!getUnreducedAxes(divOp.getRhs()).empty()) {
+          return SmallVector<AxisRefAttr>();
+        }
+        return getScaledAxes(divOp.getLhs(), divOp.getRhs(), partialSums);
+      })
+      .Case<stablehlo::NegOp, stablehlo::TransposeOp, stablehlo::ReshapeOp,
+            stablehlo::SliceOp, stablehlo::BroadcastInDimOp>(
+          [&](auto) {
+            partialSums.push_back(op->getOperand(0));
+            return llvm::to_vector(getUnreducedAxes(op->getOperand(0)));
+          })
+      .Case<stablehlo::ReduceOp>([&](stablehlo::ReduceOp reduceOp) {
+        if (reduceOp.getInputs().size() != 1 || !isSumReduction(reduceOp)) {
+          return SmallVector<AxisRefAttr>();
+        }
+        // The init value is added once per device, so it must be zero.
+        Value initValue = reduceOp.getInitValues().front();
+        if (!matchPattern(initValue, m_AnyZeroFloat()) &&
+            !matchPattern(initValue, m_Zero())) {
+          return SmallVector<AxisRefAttr>();
+        }
+        partialSums.push_back(reduceOp.getInputs().front());
+        return llvm::to_vector(getUnreducedAxes(reduceOp.getInputs().front()));
+      })
+      .Default([](Operation*) { return SmallVector<AxisRefAttr>(); });
+}
+
+// Returns the bytes per device of `value`, or -1 if it doesn't have a static
+// shape.
+int64_t getLocalBytes(Value value, TensorShardingAttr sharding,
+                      MeshAttr mesh) {
+  auto type = dyn_cast<RankedTensorType>(value.getType());
+  if (!type || !type.hasStaticShape()) {
+    return -1;
+  }
+  return getLocalTensorBytes(type, sharding, mesh);
+}
+
+// Tries to move the reduction of unreduced axes from the operands of the
+// linear `op` to its result, by making them unreduced in the result sharding.
+// Returns true if the result sharding was updated.
+//
+// The axes are moved only if they aren't sharded or replicated in the result,
+// and the result is at most as large as the partial sums that would otherwise
+// be all-reduced at `op`.
+bool delayReductionThroughOp(Operation* op, const SymbolTable& symbolTable) {
+  if (op->getNumResults() != 1) {
+    return false;
+  }
+  SmallVector<Value> partialSums;
+  SmallVector<AxisRefAttr> axes = getLinearUnreducedAxes(op, partialSums);
+  if (axes.empty()) {
+    return false;
+  }
+
+  Value result = op->getResult(0);
+  TensorShardingAttr operandSharding = getSharding(partialSums.front());
+  TensorShardingAttr resultSharding = getSharding(result);
+  if (!resultSharding) {
+    resultSharding = TensorShardingAttr::getFullyClosed(
+        op->getContext(), getTensorRank(result),
+        operandSharding.getMeshOrRef());
+  } else if (resultSharding.getMeshOrRef() != operandSharding.getMeshOrRef()) {
+    return false;
+  }
+  axes = getAxesNotIn(axes, resultSharding);
+  if (axes.empty()) {
+    return false;
+  }
+
+  MeshAttr mesh = resultSharding.getMesh(symbolTable);
+  if (!mesh || mesh.isMaximal()) {
+    return false;
+  }
+  int64_t resultBytes = getLocalBytes(result, resultSharding, mesh);
+  int64_t partialSumBytes = 0;
+  for (Value partialSum : partialSums) {
+    int64_t bytes = getLocalBytes(partialSum, getSharding(partialSum), mesh);
+    if (bytes < 0) {
+      return false;
+    }
+    partialSumBytes += bytes;
+  }
+  LLVM_DEBUG(llvm::dbgs() << "Delaying the reduction through " << op->getName()
+                          << ": " << partialSumBytes << " bytes of partial "
+                          << "sums, " << resultBytes << " bytes of result\n");
+  if (resultBytes < 0 || resultBytes > partialSumBytes) {
+    return false;
+  }
+
+  SmallVector<AxisRefAttr> unreducedAxes =
+      llvm::to_vector(resultSharding.getUnreducedAxes());
+  llvm::append_range(unreducedAxes, axes);
+  sortAndMergeAxes(unreducedAxes, mesh);
+  setSharding(result, TensorShardingAttr::get(
+                          op->getContext(), resultSharding.getMeshOrRef(),
+                          resultSharding.getDimShardings(),
+                          resultSharding.getReplicatedAxes(), unreducedAxes));
+  return true;
+}
+
+struct DelayUnreducedReductionsPass
+    : public impl::DelayUnreducedReductionsPassBase<
+          DelayUnreducedReductionsPass> {
+  using DelayUnreducedReductionsPassBase::DelayUnreducedReductionsPassBase;
+
+ protected:
+  void runOnOperation() final {
+    func::FuncOp funcOp = getOperation();
+    SymbolTable symbolTable(funcOp->getParentOfType<ModuleOp>());
+    // Ops are visited in program order, so unreduced axes pushed to the result
+    // of an op can be pushed further by its users.
+    for (Operation& op : funcOp.getBody().getOps()) {
+      delayReductionThroughOp(&op, symbolTable);
+    }
+  }
+};
+
+}  // namespace
+
+}  // namespace sdy
+}  // namespace mlir
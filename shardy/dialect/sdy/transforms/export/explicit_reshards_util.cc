@@ -39,6 +39,8 @@ limitations under the License.
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/enums.h"
 #include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
+#include "shardy/dialect/sdy/transforms/propagation/packed_axis.h"
 #include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
 #include "shardy/dialect/sdy/transforms/propagation/utils.h"
 
@@ -740,6 +742,247 @@ SmallVector<int64_t> getTensorSizes(Operation* op) {
   return tensorSizes;
 }
 
+SmallVector<int64_t> getTensorBytes(Operation* op) {
+  SmallVector<int64_t> tensorBytes;
+  tensorBytes.reserve(op->getNumOperands() + op->getNumResults());
+  for (Type type :
+       llvm::concat<Type>(op->getOperandTypes(), op->getResultTypes())) {
+    ShapedType shapedType = dynCastStaticShapedType(type);
+    // Assign zero as the tensor size for dynamically shaped types.
+    tensorBytes.push_back(
+        shapedType ? shapedType.getNumElements() *
+                         getElementTypeBytes(shapedType.getElementType())
+                   : 0);
+  }
+  return tensorBytes;
+}
+
+namespace {
+
+// Returns the total number of bytes that need to be communicated per device to
+// reshard all tensors in `shardingProjection` to `commonAxesPerFactor`.
+//
+// A tensor needs to be resharded if the axes of any of its factors differ from
+// the common axes of that factor, in which case we estimate the bytes it
+// communicates as the larger of its local sizes before and after the reshard.
+int64_t getReshardedBytes(const ShardingProjection& shardingProjection,
+                          const AxesPerFactor& commonAxesPerFactor,
+                          ArrayRef<int64_t> tensorBytes, MeshAttr mesh) {
+  int64_t reshardedBytes = 0;
+  for (const auto& [tensorBytesOfTensor, tensorFactorSharding] :
+       llvm::zip_equal(tensorBytes, llvm::concat<const TensorFactorShardings>(
+                                        shardingProjection.getOperands(),
+                                        shardingProjection.getResults()))) {
+    int64_t shardingSizeBefore = 1;
+    int64_t shardingSizeAfter = 1;
+    bool needsReshard = false;
+    for (const auto& [factorIndex, factorSharding] :
+         tensorFactorSharding.factorIndexToSharding) {
+      ArrayRef<AxisRefAttr> commonAxes = commonAxesPerFactor[factorIndex];
+      shardingSizeBefore *=
+          AxisListRef(factorSharding.axisRefs).getShardingSize(mesh);
+      shardingSizeAfter *= AxisListRef(commonAxes).getShardingSize(mesh);
+      needsReshard |= ArrayRef(factorSharding.axisRefs) != commonAxes;
+    }
+    if (needsReshard) {
+      reshardedBytes +=
+          tensorBytesOfTensor / std::min(shardingSizeBefore, shardingSizeAfter);
+    }
+  }
+  return reshardedBytes;
+}
+
+// Returns the common axes per factor that keep the tensor at `tensorIndex`
+// as is, and then extend the factors that aren't in that tensor with the
+// non-overlapping axes of the other tensors, in order.
+AxesPerFactor getCommonAxesAlignedWithTensor(
+    const ShardingProjection& shardingProjection,
+    OpShardingRuleAttr shardingRule, int64_t tensorIndex) {
+  AxesPerFactor factorAxisRefs(shardingRule.getNumFactors());
+  BitVector assignedFactors(shardingRule.getNumFactors());
+  SmallVector<AxisRefAttr> assignedAxes;
+  auto assignTensor = [&](const TensorFactorShardings& tensor) {
+    for (const auto& [factorIndex, factorSharding] :
+         tensor.factorIndexToSharding) {
+      if (assignedFactors.test(factorIndex)) {
+        continue;
+      }
+      assignedFactors.set(factorIndex);
+      SmallVector<AxisRefAttr>& axes = factorAxisRefs[factorIndex];
+      axes = factorSharding.axisRefs;
+      truncateAxesByRemovingOverlaps(axes, assignedAxes);
+      llvm::append_range(assignedAxes, axes);
+    }
+  };
+
+  assignTensor(shardingProjection.getTensor(tensorIndex));
+  for (const TensorFactorShardings& tensor :
+       llvm::concat<const TensorFactorShardings>(
+           shardingProjection.getOperands(), shardingProjection.getResults())) {
+    assignTensor(tensor);
+  }
+  return factorAxisRefs;
+}
+
+// The factor axes of a tensor, in the order of its `factorIndexToSharding`,
+// along with their packed form.
+struct PackedFactorAxes {
+  int64_t factorIndex;
+  ArrayRef<AxisRefAttr> axisRefs;
+  SmallVector<PackedAxisRef> packedAxisRefs;
+};
+
+// Packs the factor axes of each tensor in `shardingProjection`, in the order of
+// `ShardingProjection::getTensor`.
+SmallVector<SmallVector<PackedFactorAxes>> packFactorAxes(
+    const ShardingProjection& shardingProjection,
+    const MeshAxisIndex& meshAxisIndex) {
+  SmallVector<SmallVector<PackedFactorAxes>> packedTensors;
+  packedTensors.reserve(shardingProjection.getNumTensors());
+  for (const TensorFactorShardings& tensor :
+       llvm::concat<const TensorFactorShardings>(
+           shardingProjection.getOperands(), shardingProjection.getResults())) {
+    SmallVector<PackedFactorAxes>& packedTensor = packedTensors.emplace_back();
+    for (const auto& [factorIndex, factorSharding] :
+         tensor.factorIndexToSharding) {
+      packedTensor.push_back(
+          {factorIndex, factorSharding.axisRefs,
+           packAxisRefs(factorSharding.axisRefs, meshAxisIndex)});
+    }
+  }
+  return packedTensors;
+}
+
+// Same as `getCommonAxesAlignedWithTensor`, but on the packed axes of
+// `packedTensors`, so that removing the overlaps with the assigned axes, which
+// is quadratic in the number of axes of the op, only compares integers.
+AxesPerFactor getCommonAxesAlignedWithTensor(
+    ArrayRef<SmallVector<PackedFactorAxes>> packedTensors,
+    OpShardingRuleAttr shardingRule, int64_t tensorIndex,
+    const MeshAxisIndex& meshAxisIndex) {
+  AxesPerFactor factorAxisRefs(shardingRule.getNumFactors());
+  BitVector assignedFactors(shardingRule.getNumFactors());
+  SmallVector<PackedAxisRef> assignedAxes;
+  auto assignTensor = [&](ArrayRef<PackedFactorAxes> tensor) {
+    for (const PackedFactorAxes& factorAxes : tensor) {
+      if (assignedFactors.test(factorAxes.factorIndex)) {
+        continue;
+      }
+      assignedFactors.set(factorAxes.factorIndex);
+      SmallVector<PackedAxisRef> axes = factorAxes.packedAxisRefs;
+      truncateAxesByRemovingOverlaps(axes, assignedAxes);
+      llvm::append_range(assignedAxes, axes);
+      // Only the last axis can differ from the original axes after truncation,
+      // so we avoid creating attributes for the others.
+      SmallVector<AxisRefAttr>& result =
+          factorAxisRefs[factorAxes.factorIndex];
+      result = llvm::to_vector(factorAxes.axisRefs.take_front(axes.size()));
+      if (!axes.empty() &&
+          axes.back() != factorAxes.packedAxisRefs[axes.size() - 1]) {
+        result.back() = axes.back().unpack(meshAxisIndex);
+      }
+    }
+  };
+
+  assignTensor(packedTensors[tensorIndex]);
+  for (ArrayRef<PackedFactorAxes> tensor : packedTensors) {
+    assignTensor(tensor);
+  }
+  return factorAxisRefs;
+}
+
+}  // namespace
+
+AxesPerFactor findCommonAxesMinimizingBytes(
+    const ShardingProjection& shardingProjection,
+    OpShardingRuleAttr shardingRule, ArrayRef<int64_t> tensorBytes,
+    MeshOp meshOp) {
+  MeshAttr mesh = meshOp.getMesh();
+  AxesPerFactor bestAxesPerFactor =
+      findCommonAxes(shardingProjection, shardingRule, tensorBytes, meshOp);
+  // Keeping a tensor as is might introduce strided views if a dimension has
+  // multiple factors, or shard factors that need replication.
+  if (shardingRule.hasDimensionsWithMultipleFactors() ||
+      !shardingRule.getNeedReplicationFactors().empty()) {
+    return bestAxesPerFactor;
+  }
+
+  int64_t minReshardedBytes = getReshardedBytes(
+      shardingProjection, bestAxesPerFactor, tensorBytes, mesh);
+  // Pack the factor axes once for all tensors, unless the mesh can't be packed.
+  std::optional<MeshAxisIndex> meshAxisIndex;
+  if (minReshardedBytes != 0) {
+    meshAxisIndex = MeshAxisIndex::build(mesh);
+  }
+  SmallVector<SmallVector<PackedFactorAxes>> packedTensors;
+  if (meshAxisIndex) {
+    packedTensors = packFactorAxes(shardingProjection, *meshAxisIndex);
+  }
+  for (int64_t tensorIndex : shardingRule.getNonScalarTensorIndices()) {
+    if (minReshardedBytes == 0) {
+      break;
+    }
+    if (hasShardedPermutationFactors(shardingProjection.getTensor(tensorIndex),
+                                     shardingRule)) {
+      continue;
+    }
+    AxesPerFactor axesPerFactor =
+        meshAxisIndex
+            ? getCommonAxesAlignedWithTensor(packedTensors, shardingRule,
+                                             tensorIndex, *meshAxisIndex)
+            : getCommonAxesAlignedWithTensor(shardingProjection, shardingRule,
+                                             tensorIndex);
+    int64_t reshardedBytes =
+        getReshardedBytes(shardingProjection, axesPerFactor, tensorBytes, mesh);
+    if (reshardedBytes < minReshardedBytes) {
+      minReshardedBytes = reshardedBytes;
+      bestAxesPerFactor = std::move(axesPerFactor);
+    }
+  }
+  return bestAxesPerFactor;
+}
+
+unsigned CommonAxesCache::SignatureInfo::getHashValue(
+    const Signature& signature) {
+  llvm::hash_code hash = llvm::hash_combine(
+      signature.shardingRule, signature.mesh, signature.minimizeReshardedBytes,
+      llvm::hash_combine_range(signature.tensorSizes.begin(),
+                               signature.tensorSizes.end()));
+  for (ArrayRef<AxisRefAttr> axes : signature.factorAxes) {
+    hash = llvm::hash_combine(hash, AxisListRef(axes));
+  }
+  return hash;
+}
+
+AxesPerFactor CommonAxesCache::findCommonAxes(
+    const ShardingProjection& shardingProjection,
+    OpShardingRuleAttr shardingRule, ArrayRef<int64_t> tensorSizes,
+    MeshOp meshOp, bool minimizeReshardedBytes) {
+  Signature signature{shardingRule, meshOp.getMesh(), minimizeReshardedBytes,
+                      SmallVector<int64_t>(tensorSizes)};
+  for (const TensorFactorShardings& tensorFactorSharding :
+       llvm::concat<const TensorFactorShardings>(
+           shardingProjection.getOperands(), shardingProjection.getResults())) {
+    for (const auto& [_, factorSharding] :
+         tensorFactorSharding.factorIndexToSharding) {
+      signature.factorAxes.push_back(factorSharding.axisRefs);
+    }
+  }
+
+  auto it = cache.find(signature);
+  if (it != cache.end()) {
+    return it->second;
+  }
+  AxesPerFactor commonAxesPerFactor =
+      minimizeReshardedBytes
+          ? findCommonAxesMinimizingBytes(shardingProjection, shardingRule,
+                                          tensorSizes, meshOp)
+          : sdy::findCommonAxes(shardingProjection, shardingRule, tensorSizes,
+                                meshOp);
+  cache.try_emplace(std::move(signature), commonAxesPerFactor);
+  return commonAxesPerFactor;
+}
+
 namespace {
 
 // Returns reduction axes that are the union of all axes on reduction factors.
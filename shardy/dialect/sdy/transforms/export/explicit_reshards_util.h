@@ -20,6 +20,9 @@ limitations under the License.
 #include <cstdint>
 #include <optional>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/SmallVector.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/SymbolTable.h"
@@ -68,6 +71,10 @@ ArrayRef<AxisRefAttr> getUnreducedAxes(Value value);
 // Returns a concatenated array of operand and result tensor sizes.
 SmallVector<int64_t> getTensorSizes(Operation* op);
 
+// Returns a concatenated array of operand and result tensor sizes in bytes,
+// accounting for their element types.
+SmallVector<int64_t> getTensorBytes(Operation* op);
+
 // Insert explicit reshards for operands and results that change by
 // the given `shardingProjection` for a given `op`. The reshards are inserted
 // only to make the given operation compatible.
@@ -147,6 +154,68 @@ AxesPerFactor findCommonAxes(const ShardingProjection& shardingProjection,
                              OpShardingRuleAttr shardingRule,
                              ArrayRef<int64_t> tensorSizes, MeshOp meshOp);
 
+// Same as `findCommonAxes`, with tensor sizes in bytes (see `getTensorBytes`),
+// but also considers common axes that keep each tensor as is, and returns the
+// ones that minimize the total bytes communicated per device by the reshards,
+// given the sharding size of each tensor before and after its reshard.
+//
+// For example, for an op with a large activation and a small bias that are
+// sharded differently, prefers resharding the bias.
+//
+// Has the same assumptions and guarantees as `findCommonAxes`.
+AxesPerFactor findCommonAxesMinimizingBytes(
+    const ShardingProjection& shardingProjection,
+    OpShardingRuleAttr shardingRule, ArrayRef<int64_t> tensorBytes,
+    MeshOp meshOp);
+
+// Memoizes `findCommonAxes` and `findCommonAxesMinimizingBytes` on a canonical
+// signature of their arguments, i.e., the sharding rule, the axes of each
+// factor of each tensor in the sharding projection, the tensor sizes and the
+// mesh. Ops with the same signature, e.g., the matmuls of each layer of a
+// model, therefore find their common axes once.
+class CommonAxesCache {
+ public:
+  // Returns `findCommonAxesMinimizingBytes` if `minimizeReshardedBytes` is
+  // true, and `findCommonAxes` otherwise, where `tensorSizes` are in bytes in
+  // the former case. The result is only computed if it isn't cached.
+  AxesPerFactor findCommonAxes(const ShardingProjection& shardingProjection,
+                               OpShardingRuleAttr shardingRule,
+                               ArrayRef<int64_t> tensorSizes, MeshOp meshOp,
+                               bool minimizeReshardedBytes);
+
+ private:
+  struct Signature {
+    OpShardingRuleAttr shardingRule;
+    MeshAttr mesh;
+    bool minimizeReshardedBytes = false;
+    SmallVector<int64_t> tensorSizes;
+    // The axes of each factor of each tensor, in order. The factors of each
+    // tensor are determined by `shardingRule`.
+    SmallVector<SmallVector<AxisRefAttr>> factorAxes;
+
+    bool operator==(const Signature& rhs) const {
+      return shardingRule == rhs.shardingRule && mesh == rhs.mesh &&
+             minimizeReshardedBytes == rhs.minimizeReshardedBytes &&
+             tensorSizes == rhs.tensorSizes && factorAxes == rhs.factorAxes;
+    }
+  };
+
+  struct SignatureInfo {
+    static unsigned getHashValue(const Signature& signature);
+    static bool isEqual(const Signature& lhs, const Signature& rhs) {
+      return lhs == rhs;
+    }
+    static Signature getEmptyKey() {
+      return {llvm::DenseMapInfo<OpShardingRuleAttr>::getEmptyKey()};
+    }
+    static Signature getTombstoneKey() {
+      return {llvm::DenseMapInfo<OpShardingRuleAttr>::getTombstoneKey()};
+    }
+  };
+
+  llvm::DenseMap<Signature, AxesPerFactor, SignatureInfo> cache;
+};
+
 // Converts `input` with `inSharding` to `outSharding` by inserting
 // `sdy.replicated-to-unreduced` and/or `sdy.sharded-to-unreduced` ops, if
 // `outSharding` contains unreduced axes that are replicated or sharded in
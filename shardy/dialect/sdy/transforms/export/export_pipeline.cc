@@ -29,24 +29,35 @@ namespace sdy {
 
 namespace {
 
+// The canonicalizer is nested on functions, like the passes around it, so that
+// they all run back-to-back on each function rather than synchronizing on the
+// entire module in between.
 void addCanonicalizerPass(OpPassManager& pm,
                           ArrayRef<std::string> enabledPatterns) {
-  pm.addPass(createCanonicalizerPass(GreedyRewriteConfig(),
-                                     /*disabledPatterns=*/{},
-                                     /*enabledPatterns=*/enabledPatterns));
+  pm.addNestedPass<func::FuncOp>(
+      createCanonicalizerPass(GreedyRewriteConfig(),
+                              /*disabledPatterns=*/{},
+                              /*enabledPatterns=*/enabledPatterns));
 }
 
 void runShardyPartitioner(OpPassManager& pm, int& dumpIndex,
                           const ExportOptions& options) {
+  if (options.delayUnreducedReductions) {
+    pm.addNestedPass<func::FuncOp>(createDelayUnreducedReductionsPass());
+  }
   // Catch the cases where unreduced axes are dropped and cause inconsistencies.
   pm.addNestedPass<func::FuncOp>(createVerifyUnreducedAxesPass());
   InsertExplicitReshardsPassOptions passOptions;
   passOptions.enableFullVersion = options.enableInsertExplicitCollectives;
+  passOptions.minimizeReshardedBytes = options.minimizeReshardedBytes;
   pm.addNestedPass<func::FuncOp>(createInsertExplicitReshardsPass(passOptions));
   if (options.enableInsertExplicitCollectives) {
-    pm.addPass(mlir::sdy::createSaveModuleOpPass(
-        options.dumpDirectory, "after_explicit_reshards", dumpIndex++));
+    addSaveModuleOpPass(pm, options.dumpDirectory, "after_explicit_reshards",
+                        dumpIndex);
     addCanonicalizerPass(pm, kReshardLabel);
+    if (options.enableReshardChainFusion) {
+      pm.addNestedPass<func::FuncOp>(createFuseReshardChainsPass());
+    }
     pm.addNestedPass<func::FuncOp>(createReshardToCollectivesPass());
     // NOTE: ReshardToCollectives pass above generates all-slice collectives,
     // which during the canonicalizer below may be converted to reduce scatters
@@ -54,19 +65,31 @@ void runShardyPartitioner(OpPassManager& pm, int& dumpIndex,
     // during InsertExplicitReshards pass.
   }
 
+  if (options.enableCollectiveSimplification) {
+    pm.addNestedPass<func::FuncOp>(createSimplifyCollectivesPass());
+  }
   addCanonicalizerPass(pm, kCollectiveLabel);
 
+  if (options.enableInsertExplicitCollectives &&
+      options.scheduleCollectivesForOverlap) {
+    pm.addNestedPass<func::FuncOp>(createScheduleCollectivesForOverlapPass());
+  }
+
   if (options.enableInsertExplicitCollectives &&
       options.removeAllGatherReduceScatterForCMV1) {
     pm.addNestedPass<func::FuncOp>(
         createRemoveAllGatherReduceScatterForCMV1Pass());
   }
-  pm.addPass(mlir::sdy::createSaveModuleOpPass(
-      options.dumpDirectory,
-      options.enableInsertExplicitCollectives
-          ? "after_partitioner_with_global_shapes"
-          : "after_minimal_partitioner_with_global_shapes",
-      dumpIndex++));
+  addSaveModuleOpPass(pm, options.dumpDirectory,
+                      options.enableInsertExplicitCollectives
+                          ? "after_partitioner_with_global_shapes"
+                          : "after_minimal_partitioner_with_global_shapes",
+                      dumpIndex);
+  if (options.dumpCollectiveStatistics) {
+    CollectiveStatisticsPassOptions statisticsOptions;
+    statisticsOptions.dumpDirectory = options.dumpDirectory;
+    pm.addPass(createCollectiveStatisticsPass(statisticsOptions));
+  }
 }
 
 }  // namespace
@@ -83,7 +106,9 @@ void addExportPipeline(OpPassManager& pm, int& dumpIndex,
     pm.addNestedPass<func::FuncOp>(createShardingConstraintToReshardPass());
   }
   if (options.updateNonDivisibleInputOutputShardings) {
-    pm.addPass(createUpdateNonDivisibleInputOutputShardingsPass());
+    pm.addPass(createUpdateNonDivisibleInputOutputShardingsPass(
+        UpdateNonDivisibleInputOutputShardingsPassOptions{
+            /*padAcrossCallBoundaries=*/options.padAcrossCallBoundaries}));
     pm.addPass(createRemoveSubAxesInInputOutputShardingsPass());
   }
   pm.addPass(createCloseShardingsPass());
@@ -91,8 +116,8 @@ void addExportPipeline(OpPassManager& pm, int& dumpIndex,
   // We dump the module after propagation at this point, since the export passes
   // before are removing internal implementation details of the propagation
   // itself and make the module more readable.
-  pm.addPass(mlir::sdy::createSaveModuleOpPass(
-      options.dumpDirectory, "after_propagation", dumpIndex++));
+  addSaveModuleOpPass(pm, options.dumpDirectory, "after_propagation",
+                      dumpIndex);
 
   // TODO(enver, tomnatan): Consider having a pipeline specifically for
   // reshards/collectives.
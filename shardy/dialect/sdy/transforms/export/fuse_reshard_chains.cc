@@ -0,0 +1,340 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <memory>  // IWYU pragma: keep
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"  // IWYU pragma: keep
+#include "mlir/IR/Block.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Rewrite/FrozenRewritePatternSet.h"
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/common/op_properties.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
+#include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
+
+namespace mlir {
+namespace sdy {
+
+#define GEN_PASS_DEF_FUSERESHARDCHAINSPASS
+#include "shardy/dialect/sdy/transforms/export/passes.h.inc"
+
+namespace {
+
+// Returns true if `value` already has a sharding equivalent to `sharding`,
+// treating a missing sharding as fully replicated.
+bool hasEquivalentSharding(Value value, TensorShardingAttr sharding) {
+  TensorShardingAttr valueSharding = getSharding(value);
+  return valueSharding ? valueSharding.isEquivalent(sharding)
+                       : (!sharding || sharding.isEquivalent(valueSharding));
+}
+
+// Pattern to fuse a reshard of a reshard:
+//
+// 1. If the outer reshard goes back to the sharding of the inner reshard's
+//    input (A -> B -> A), the outer reshard is replaced with that input. This
+//    holds even if the inner reshard has other uses.
+// 2. Otherwise, if the inner reshard has no other uses (A -> B -> C), both
+//    reshards are replaced with a single reshard from A to C.
+class FuseReshardOfReshardPattern : public OpRewritePattern<ReshardOp> {
+ public:
+  using OpRewritePattern<ReshardOp>::OpRewritePattern;
+
+ private:
+  LogicalResult matchAndRewrite(ReshardOp reshardOp,
+                                PatternRewriter& rewriter) const override {
+    auto innerReshardOp = reshardOp.getInput().getDefiningOp<ReshardOp>();
+    if (!innerReshardOp) {
+      return rewriter.notifyMatchFailure(
+          reshardOp, [](Diagnostic& diag) { diag << "input isn't a reshard"; });
+    }
+    Value innerInput = innerReshardOp.getInput();
+
+    if (hasEquivalentSharding(innerInput, reshardOp.getSharding())) {
+      rewriter.replaceOp(reshardOp, innerInput);
+      return success();
+    }
+
+    if (!innerReshardOp->hasOneUse()) {
+      return rewriter.notifyMatchFailure(reshardOp, [](Diagnostic& diag) {
+        diag << "inner reshard has multiple uses";
+      });
+    }
+    rewriter.modifyOpInPlace(
+        reshardOp, [&]() { reshardOp.getInputMutable().assign(innerInput); });
+    rewriter.eraseOp(innerReshardOp);
+    return success();
+  }
+};
+
+// Pattern to hoist a reshard above the elementwise op that defines its input,
+// if that reduces the number of bytes that need to be resharded.
+//
+// The reshard of the result is replaced with a reshard of each operand that
+// doesn't already have the target sharding, and the result of the elementwise
+// op gets the target sharding. For example, if `%1` is the only use of `%0`:
+//
+// ```mlir
+// %0 = stablehlo.convert %arg0 : (tensor<8xbf16>) -> tensor<8xf32>
+// %1 = sdy.reshard %0 <@mesh, [{"y"}]> : tensor<8xf32>
+// ```
+//
+// Becomes:
+//
+// ```mlir
+// %0 = sdy.reshard %arg0 <@mesh, [{"y"}]> : tensor<8xbf16>
+// %1 = stablehlo.convert %0 {sdy.sharding = ...[{"y"}]} : ... -> tensor<8xf32>
+// ```
+//
+// The bytes are compared per element, since the operands and result of an
+// elementwise op have the same shape.
+class HoistReshardAboveElementwisePattern : public OpRewritePattern<ReshardOp> {
+ public:
+  using OpRewritePattern<ReshardOp>::OpRewritePattern;
+
+ private:
+  LogicalResult matchAndRewrite(ReshardOp reshardOp,
+                                PatternRewriter& rewriter) const override {
+    Value input = reshardOp.getInput();
+    Operation* op = input.getDefiningOp();
+    if (!op || !isElementwise(op) || op->getNumResults() != 1 ||
+        !input.hasOneUse() || op->getNumRegions() != 0) {
+      return rewriter.notifyMatchFailure(reshardOp, [](Diagnostic& diag) {
+        diag << "input isn't a single use elementwise op";
+      });
+    }
+
+    TensorShardingAttr targetSharding = reshardOp.getSharding();
+    TensorShardingAttr resultSharding = getSharding(input);
+    if (!targetSharding.getUnreducedAxes().empty() ||
+        (resultSharding && !resultSharding.getUnreducedAxes().empty())) {
+      return rewriter.notifyMatchFailure(reshardOp, [](Diagnostic& diag) {
+        diag << "reshard has unreduced axes";
+      });
+    }
+    if (hasEquivalentSharding(input, targetSharding)) {
+      // The reshard is redundant, and will be removed when it's converted to
+      // collectives.
+      return rewriter.notifyMatchFailure(
+          reshardOp, [](Diagnostic& diag) { diag << "reshard is redundant"; });
+    }
+
+    auto resultType = dyn_cast<RankedTensorType>(input.getType());
+    if (!resultType) {
+      return rewriter.notifyMatchFailure(reshardOp, [](Diagnostic& diag) {
+        diag << "result isn't a ranked tensor";
+      });
+    }
+    int64_t operandBytes = 0;
+    for (Value operand : op->getOperands()) {
+      auto operandType = dyn_cast<RankedTensorType>(operand.getType());
+      // Broadcasting elementwise ops can have operands of a different shape.
+      if (!operandType || operandType.getShape() != resultType.getShape()) {
+        return rewriter.notifyMatchFailure(reshardOp, [](Diagnostic& diag) {
+          diag << "operand and result shapes don't match";
+        });
+      }
+      if (!hasEquivalentSharding(operand, targetSharding)) {
+        operandBytes += getElementTypeBytes(operandType.getElementType());
+      }
+    }
+    if (operandBytes >= getElementTypeBytes(resultType.getElementType())) {
+      return rewriter.notifyMatchFailure(reshardOp, [](Diagnostic& diag) {
+        diag << "hoisting doesn't reduce the resharded bytes";
+      });
+    }
+
+    rewriter.setInsertionPoint(op);
+    for (OpOperand& operand : op->getOpOperands()) {
+      if (!hasEquivalentSharding(operand.get(), targetSharding)) {
+        auto operandReshard = ReshardOp::create(
+            rewriter, reshardOp.getLoc(), operand.get(), targetSharding);
+        rewriter.modifyOpInPlace(op, [&]() { operand.set(operandReshard); });
+      }
+    }
+    rewriter.modifyOpInPlace(op, [&]() { setSharding(input, targetSharding); });
+    rewriter.replaceOp(reshardOp, input);
+    return success();
+  }
+};
+
+int64_t getNumAxes(TensorShardingAttr sharding) {
+  int64_t numAxes = 0;
+  for (DimensionShardingAttr dimSharding : sharding.getDimShardings()) {
+    numAxes += dimSharding.getAxes().size();
+  }
+  return numAxes;
+}
+
+// Returns true if `finer` can be obtained from `coarser` by only slicing, i.e.,
+// the axes of each dimension sharding of `coarser` are a prefix of the axes of
+// the same dimension sharding of `finer`, and `finer` has more axes.
+bool isSliceOf(TensorShardingAttr finer, TensorShardingAttr coarser) {
+  if (finer.getMeshOrRef() != coarser.getMeshOrRef() ||
+      finer.getRank() != coarser.getRank() ||
+      !finer.getUnreducedAxes().empty() ||
+      !coarser.getUnreducedAxes().empty() ||
+      getNumAxes(finer) <= getNumAxes(coarser)) {
+    return false;
+  }
+  return llvm::all_of(
+      llvm::zip_equal(finer.getDimShardings(), coarser.getDimShardings()),
+      [](auto dimShardings) {
+        auto [finerDim, coarserDim] = dimShardings;
+        ArrayRef<AxisRefAttr> finerAxes = finerDim.getAxes();
+        ArrayRef<AxisRefAttr> coarserAxes = coarserDim.getAxes();
+        return coarserAxes.size() <= finerAxes.size() &&
+               finerAxes.take_front(coarserAxes.size()) == coarserAxes;
+      });
+}
+
+// Shares the reshards of `input` among its users:
+//
+// 1. Reshards to equivalent shardings are replaced with a single reshard.
+// 2. A reshard whose sharding is a slice of the sharding of another reshard of
+//    `input` (see `isSliceOf`) is replaced with a reshard of the latter, which
+//    only needs to slice locally.
+//
+// Every reshard that is shared is hoisted right after the definition of
+// `input`, so that it dominates all its new users.
+void shareReshardsOfValue(Value input) {
+  SmallVector<ReshardOp> reshards;
+  for (Operation* user : input.getUsers()) {
+    if (auto reshardOp = dyn_cast<ReshardOp>(user)) {
+      reshards.push_back(reshardOp);
+    }
+  }
+  if (reshards.size() < 2) {
+    return;
+  }
+  // Process the reshards in program order within each block, so the first
+  // reshard of each sharding is the one that is kept.
+  llvm::sort(reshards, [](ReshardOp a, ReshardOp b) {
+    return a->getBlock() == b->getBlock() ? a->isBeforeInBlock(b)
+                                          : a->getBlock() < b->getBlock();
+  });
+
+  SmallVector<ReshardOp> uniqueReshards;
+  llvm::SetVector<ReshardOp> reshardsToHoist;
+  for (ReshardOp reshardOp : reshards) {
+    auto* it = llvm::find_if(uniqueReshards, [&](ReshardOp uniqueReshard) {
+      return uniqueReshard.getSharding().isEquivalent(reshardOp.getSharding());
+    });
+    if (it == uniqueReshards.end()) {
+      uniqueReshards.push_back(reshardOp);
+      continue;
+    }
+    reshardsToHoist.insert(*it);
+    reshardOp.getResult().replaceAllUsesWith(it->getResult());
+    reshardOp.erase();
+  }
+
+  for (ReshardOp reshardOp : uniqueReshards) {
+    TensorShardingAttr sharding = reshardOp.getSharding();
+    if (hasEquivalentSharding(input, sharding)) {
+      // The reshard is redundant, and will be removed when it's converted to
+      // collectives.
+      continue;
+    }
+    // Pick the finest sharding among those that `sharding` is a slice of.
+    ReshardOp source;
+    for (ReshardOp candidate : uniqueReshards) {
+      TensorShardingAttr candidateSharding = candidate.getSharding();
+      if (!hasEquivalentSharding(input, candidateSharding) &&
+          isSliceOf(sharding, candidateSharding) &&
+          (!source ||
+           getNumAxes(candidateSharding) > getNumAxes(source.getSharding()))) {
+        source = candidate;
+      }
+    }
+    if (source) {
+      reshardsToHoist.insert(source);
+      reshardsToHoist.insert(reshardOp);
+      reshardOp.getInputMutable().assign(source.getResult());
+    }
+  }
+
+  // Hoist from the coarsest to the finest sharding, so each source is before
+  // the reshards that use it.
+  SmallVector<ReshardOp> sortedReshardsToHoist = reshardsToHoist.takeVector();
+  llvm::stable_sort(sortedReshardsToHoist, [](ReshardOp a, ReshardOp b) {
+    return getNumAxes(a.getSharding()) < getNumAxes(b.getSharding());
+  });
+  Operation* prevOp = input.getDefiningOp();
+  for (ReshardOp reshardOp : sortedReshardsToHoist) {
+    if (prevOp) {
+      reshardOp->moveAfter(prevOp);
+    } else {
+      Block* block = cast<BlockArgument>(input).getOwner();
+      reshardOp->moveBefore(block, block->begin());
+    }
+    prevOp = reshardOp;
+  }
+}
+
+// Shares the reshards of each value in `funcOp`, see `shareReshardsOfValue`.
+void shareReshards(func::FuncOp funcOp) {
+  llvm::SetVector<Value> inputs;
+  funcOp.walk([&](ReshardOp reshardOp) { inputs.insert(reshardOp.getInput()); });
+  for (Value input : inputs) {
+    shareReshardsOfValue(input);
+  }
+}
+
+struct FuseReshardChainsPass
+    : public impl::FuseReshardChainsPassBase<FuseReshardChainsPass> {
+  using FuseReshardChainsPassBase::FuseReshardChainsPassBase;
+
+  LogicalResult initialize(MLIRContext* context) final {
+    RewritePatternSet patternsInternal(context);
+    patternsInternal.add<FuseReshardOfReshardPattern>(context, /*benefit=*/2);
+    patternsInternal.add<HoistReshardAboveElementwisePattern>(context);
+    patterns = std::move(patternsInternal);
+    return success();
+  }
+
+  void runOnOperation() final {
+    func::FuncOp funcOp = getOperation();
+    // Sharing reshards first can leave a single use for the patterns below,
+    // which can in turn create new reshards of the same value.
+    shareReshards(funcOp);
+    if (failed(applyPatternsGreedily(funcOp, patterns))) {
+      signalPassFailure();
+      return;
+    }
+    shareReshards(funcOp);
+  }
+
+ private:
+  FrozenRewritePatternSet patterns;
+};
+
+}  // namespace
+
+}  // namespace sdy
+}  // namespace mlir
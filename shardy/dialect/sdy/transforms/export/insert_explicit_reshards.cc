@@ -560,13 +560,20 @@ AxesPerFactor processReshapeWithOverflowAxes(
 // Returns the union of axes along all the reduction factors which may not be
 // canonicalized.
 //
+// If `minimizeReshardedBytes` is true, the common axes are chosen to minimize
+// the bytes communicated by the inserted reshards, see
+// `findCommonAxesMinimizingBytes`. The common axes are looked up in
+// `commonAxesCache` first.
+//
 // Guarantees to return non-empty `AxesPerFactor` if `onFullVersion` is true.
 AxesPerFactor processOp(Operation* op, ShardingProjection& shardingProjection,
                         ArrayRef<TensorShardingAttr> inShardings,
                         ArrayRef<TensorShardingAttr> outShardings,
                         IRRewriter& rewriter, const SymbolTable& symbolTable,
                         OpShardingRuleAttr shardingRule, MeshOp meshOp,
-                        const bool onFullVersion) {
+                        const bool onFullVersion,
+                        const bool minimizeReshardedBytes,
+                        CommonAxesCache& commonAxesCache) {
   // Checks if factors are sharded the same way across operands and results.
   if (onFullVersion) {
     UpdateTensorShardings updateTensorShardings =
@@ -580,8 +587,10 @@ AxesPerFactor processOp(Operation* op, ShardingProjection& shardingProjection,
       }
     }
 
-    AxesPerFactor commonAxesPerFactor = findCommonAxes(
-        shardingProjection, shardingRule, getTensorSizes(op), meshOp);
+    AxesPerFactor commonAxesPerFactor = commonAxesCache.findCommonAxes(
+        shardingProjection, shardingRule,
+        minimizeReshardedBytes ? getTensorBytes(op) : getTensorSizes(op),
+        meshOp, minimizeReshardedBytes);
     for (const auto& [index, axes] : llvm::enumerate(commonAxesPerFactor)) {
       updateTensorShardings |=
           shardingProjection.updateSharding(index, axes, /*overflowAxes=*/{});
@@ -618,6 +627,7 @@ struct InsertExplicitReshardsPass
     func::FuncOp funcOp = getOperation();
     IRRewriter rewriter(funcOp);
     SymbolTable symbolTable(funcOp->getParentOfType<ModuleOp>());
+    CommonAxesCache commonAxesCache;
 
     funcOp->walk([&](Operation* op) {
       if (op->hasTrait<OpTrait::IsTerminator>()) {
@@ -675,7 +685,8 @@ struct InsertExplicitReshardsPass
           /*closedIfMissing=*/true);
       AxesPerFactor commonAxesPerFactor =
           processOp(op, shardingProjection, inShardings, outShardings, rewriter,
-                    symbolTable, shardingRule, *meshOp, onFullVersion);
+                    symbolTable, shardingRule, *meshOp, onFullVersion,
+                    minimizeReshardedBytes, commonAxesCache);
       // TODO(b/440055868): Insert a reshard from unreduced to replicated axes.
       insertAllReducesForReductionFactors(op, shardingProjection,
                                           commonAxesPerFactor, shardingRule,
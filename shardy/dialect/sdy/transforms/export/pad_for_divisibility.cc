@@ -21,8 +21,10 @@ limitations under the License.
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SmallVectorExtras.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypeInterfaces.h"
@@ -118,7 +120,8 @@ constexpr PaddingValueKind kDefaultPaddingValueKind = PaddingValueKind::kZero;
 // Returns true if the operation has custom padding handling implemented in
 // this file and should be excluded from GenericOpPattern.
 bool hasCustomPadHandling(Operation* op) {
-  return isa<stablehlo::SliceOp, stablehlo::DotGeneralOp>(op);
+  return isa<stablehlo::SliceOp, stablehlo::DotGeneralOp, stablehlo::ReduceOp>(
+      op);
 }
 
 class PaddingCache {
@@ -271,11 +274,52 @@ Value ensurePadding(
   return select;
 }
 
+// Returns the padding kind of the results of the elementwise `op`, if it is
+// known from the padding kinds of its operands, `operandKinds`, i.e., if `op`
+// maps the padding value of its operands to a known padding value.
+std::optional<PaddingValueKind> getElementwisePaddingKind(
+    Operation* op, ArrayRef<std::optional<PaddingValueKind>> operandKinds) {
+  if (operandKinds.empty() ||
+      llvm::any_of(operandKinds, [](std::optional<PaddingValueKind> kind) {
+        return !kind.has_value();
+      })) {
+    return std::nullopt;
+  }
+  // 0 * x = 0 for any of the known padding values.
+  if (isa<stablehlo::MulOp>(op) &&
+      llvm::is_contained(operandKinds, PaddingValueKind::kZero)) {
+    return PaddingValueKind::kZero;
+  }
+  if (!llvm::all_equal(operandKinds)) {
+    return std::nullopt;
+  }
+  PaddingValueKind kind = *operandKinds.front();
+  // Ops that map both 0 to 0 and 1 to 1.
+  if (isa<stablehlo::AbsOp, stablehlo::AndOp, stablehlo::CeilOp,
+          stablehlo::ConvertOp, stablehlo::FloorOp, stablehlo::MaxOp,
+          stablehlo::MinOp, stablehlo::MulOp, stablehlo::OrOp,
+          stablehlo::RoundOp, stablehlo::SignOp, stablehlo::SqrtOp>(op)) {
+    return kind;
+  }
+  // Ops that only map 0 to 0.
+  if (kind == PaddingValueKind::kZero &&
+      isa<stablehlo::AddOp, stablehlo::NegOp, stablehlo::SineOp,
+          stablehlo::SubtractOp, stablehlo::TanhOp>(op)) {
+    return kind;
+  }
+  return std::nullopt;
+}
+
 // Converts op to its local version by replacing its operands with the already
 // converted operands.
+//
+// If `cache` is provided, the padding kind of the results is registered when
+// it can be derived from the padding kinds of the operands, see
+// `getElementwisePaddingKind`.
 LogicalResult padGenericOp(Operation* op, ValueRange operands,
                            ConversionPatternRewriter& rewriter,
-                           const PaddedTypeConverter* typeConverter) {
+                           const PaddedTypeConverter* typeConverter,
+                           PaddingCache* cache = nullptr) {
   SmallVector<Value> shardableOperands;
   for (Value operand : operands) {
     shardableOperands.push_back(getShardableValue(operand));
@@ -331,8 +375,19 @@ LogicalResult padGenericOp(Operation* op, ValueRange operands,
     rewriter.inlineRegionBefore(oldRegion, newRegion, newRegion.end());
   }
 
-  // For now, generic ops do not propagate padding kinds, so they remain
-  // unregistered in the cache.
+  // Propagate the padding kind through elementwise ops, so that consumers
+  // like dot_general don't need to re-mask the padded region.
+  if (cache && op->getNumResults() == 1 &&
+      newOp->getResult(0).getType() != op->getResult(0).getType()) {
+    SmallVector<std::optional<PaddingValueKind>> operandKinds =
+        llvm::map_to_vector(shardableOperands, [&](Value operand) {
+          return cache->getPadding(operand);
+        });
+    if (std::optional<PaddingValueKind> kind =
+            getElementwisePaddingKind(op, operandKinds)) {
+      cache->setPadding(newOp->getResult(0), *kind);
+    }
+  }
 
   rewriter.replaceOp(op, newOp->getResults());
   return success();
@@ -427,8 +482,10 @@ Operation* padCollectiveOp(Operation* op, Value input, Value inputOrig,
 // match padded shape.
 class GenericOpPattern : public ConversionPattern {
  public:
-  GenericOpPattern(TypeConverter& converter, MLIRContext* ctx)
-      : ConversionPattern(converter, MatchAnyOpTypeTag(), 1, ctx) {}
+  GenericOpPattern(TypeConverter& converter, MLIRContext* ctx,
+                   PaddingCache& cache)
+      : ConversionPattern(converter, MatchAnyOpTypeTag(), 1, ctx),
+        cache(cache) {}
 
   LogicalResult matchAndRewrite(
       Operation* op, ArrayRef<Value> operands,
@@ -440,13 +497,27 @@ class GenericOpPattern : public ConversionPattern {
       return failure();
     }
     return padGenericOp(op, operands, rewriter,
-                        static_cast<const PaddedTypeConverter*>(typeConverter));
+                        static_cast<const PaddedTypeConverter*>(typeConverter),
+                        &cache);
   }
+
+ private:
+  PaddingCache& cache;
 };
 
+// Returns true if the inputs and outputs of `funcOp` should be padded, which
+// is only the case for private functions with a body when padding across call
+// boundaries.
+bool shouldPadBoundaries(func::FuncOp funcOp, bool padAcrossCallBoundaries) {
+  return padAcrossCallBoundaries && funcOp.isPrivate() && !funcOp.isExternal();
+}
+
 class FuncOpPattern : public OpConversionPattern<func::FuncOp> {
  public:
-  using OpConversionPattern::OpConversionPattern;
+  FuncOpPattern(TypeConverter& converter, MLIRContext* ctx,
+                bool padAcrossCallBoundaries)
+      : OpConversionPattern(converter, ctx),
+        padAcrossCallBoundaries(padAcrossCallBoundaries) {}
 
   LogicalResult matchAndRewrite(
       func::FuncOp op, OpAdaptor adaptor,
@@ -455,6 +526,28 @@ class FuncOpPattern : public OpConversionPattern<func::FuncOp> {
         static_cast<const PaddedTypeConverter*>(getTypeConverter());
     const SymbolTable& symbolTable = converter->getSymbolTable();
 
+    if (shouldPadBoundaries(op, padAcrossCallBoundaries)) {
+      TypeConverter::SignatureConversion conversion(op.getNumArguments());
+      SmallVector<Type> argTypes;
+      argTypes.reserve(op.getNumArguments());
+      for (auto [index, arg] : llvm::enumerate(op.getArguments())) {
+        argTypes.push_back(
+            getPaddedType(arg.getType(), getSharding(arg), symbolTable));
+        conversion.addInputs(index, argTypes.back());
+      }
+      SmallVector<Type> resultTypes =
+          llvm::map_to_vector(llvm::seq<int>(0, op.getNumResults()), [&](int i) {
+            return getPaddedType(op.getResultTypes()[i],
+                                 getFuncResultSharding(op, i), symbolTable);
+          });
+      rewriter.applySignatureConversion(&op.getBody().front(), conversion,
+                                        converter);
+      rewriter.modifyOpInPlace(op, [&]() {
+        op.setType(rewriter.getFunctionType(argTypes, resultTypes));
+      });
+      return success();
+    }
+
     for (auto [index, arg] : llvm::enumerate(op.getArguments())) {
       if (getPaddedType(arg.getType(), getSharding(arg), symbolTable) !=
           arg.getType()) {
@@ -476,6 +569,9 @@ class FuncOpPattern : public OpConversionPattern<func::FuncOp> {
 
     return failure();
   }
+
+ private:
+  bool padAcrossCallBoundaries;
 };
 
 // Returns the dimension indices of `op` that are gathered across devices and
@@ -792,6 +888,188 @@ class StablehloDotGeneralOpPattern
   PaddingCache& cache;
 };
 
+// Returns the padding kind that is the identity of the reduction computation of
+// `op`, if `op` has a single input and its body is a single add, or, multiply
+// or and op of the block arguments.
+std::optional<PaddingValueKind> getReductionIdentityKind(
+    stablehlo::ReduceOp op) {
+  if (op.getInputs().size() != 1) {
+    return std::nullopt;
+  }
+  Block& body = op.getBody().front();
+  if (!llvm::hasSingleElement(body.without_terminator())) {
+    return std::nullopt;
+  }
+  Operation& reductionOp = body.front();
+  Operation* terminator = body.getTerminator();
+  if (reductionOp.getNumOperands() != 2 || reductionOp.getNumResults() != 1 ||
+      llvm::any_of(reductionOp.getOperands(),
+                   [&](Value operand) {
+                     return !isa<BlockArgument>(operand) ||
+                            operand.getParentBlock() != &body;
+                   }) ||
+      terminator->getNumOperands() != 1 ||
+      terminator->getOperand(0) != reductionOp.getResult(0)) {
+    return std::nullopt;
+  }
+  if (isa<stablehlo::AddOp, stablehlo::OrOp>(reductionOp)) {
+    return PaddingValueKind::kZero;
+  }
+  if (isa<stablehlo::MulOp, stablehlo::AndOp>(reductionOp)) {
+    return PaddingValueKind::kOne;
+  }
+  return std::nullopt;
+}
+
+// Pattern for stablehlo.reduce. If a reduced dimension of the input is padded,
+// the padded region must hold the identity of the reduction so that it doesn't
+// change the result. The padding is enforced only along the reduced
+// dimensions, and not at all if the cache shows it already holds the identity.
+//
+// Reductions whose identity isn't a known padding kind are handled like
+// generic ops.
+class StablehloReduceOpPattern
+    : public OpConversionPattern<stablehlo::ReduceOp> {
+ public:
+  StablehloReduceOpPattern(TypeConverter& converter, MLIRContext* ctx,
+                           PaddingCache& cache)
+      : OpConversionPattern(converter, ctx), cache(cache) {}
+
+  LogicalResult matchAndRewrite(
+      stablehlo::ReduceOp op, OpAdaptor adaptor,
+      ConversionPatternRewriter& rewriter) const override {
+    auto* converter =
+        static_cast<const PaddedTypeConverter*>(getTypeConverter());
+    SmallVector<Value> operands = llvm::to_vector(adaptor.getOperands());
+    std::optional<PaddingValueKind> identityKind =
+        getReductionIdentityKind(op);
+    auto inputOrigType = cast<RankedTensorType>(op.getInputs()[0].getType());
+    if (identityKind) {
+      operands[0] = ensurePadding(operands[0], inputOrigType, *identityKind,
+                                  rewriter, op.getLoc(), cache,
+                                  op.getDimensions());
+    }
+    return padGenericOp(op, operands, rewriter, converter);
+  }
+
+ private:
+  PaddingCache& cache;
+};
+
+// Returns `value`, the converted version of `origValue`, padded for the
+// `boundarySharding` of a call or return boundary.
+//
+// A `value` padded differently than the boundary is first sliced back to the
+// original shape, and then padded for `boundarySharding` if needed.
+Value adjustToBoundary(Value value, Value origValue,
+                       TensorShardingAttr boundarySharding,
+                       const SymbolTable& symbolTable,
+                       ConversionPatternRewriter& rewriter,
+                       PaddingCache& cache) {
+  Type origType = origValue.getType();
+  Type targetType = getPaddedType(origType, boundarySharding, symbolTable);
+  if (value.getType() == targetType) {
+    return value;
+  }
+  if (value.getType() != origType) {
+    value = trimOutputForDims(
+        value, origType,
+        llvm::to_vector(llvm::seq<int64_t>(
+            0, cast<RankedTensorType>(origType).getRank())),
+        boundarySharding, rewriter, /*paddingKind=*/std::nullopt, cache);
+  }
+  if (targetType != origType) {
+    value = createPaddedValue(cast<RankedTensorType>(targetType), value,
+                              kDefaultPaddingValueKind,
+                              kDefaultPaddingValueKind, symbolTable, rewriter,
+                              cache);
+  }
+  return value;
+}
+
+// Passes and returns padded values directly when calling a function whose
+// inputs and outputs are padded, see `shouldPadBoundaries`.
+//
+// The padding kind of the call results is unknown.
+class FuncCallOpPattern : public OpConversionPattern<func::CallOp> {
+ public:
+  FuncCallOpPattern(TypeConverter& converter, MLIRContext* ctx,
+                    PaddingCache& cache)
+      : OpConversionPattern(converter, ctx), cache(cache) {}
+
+  LogicalResult matchAndRewrite(
+      func::CallOp op, OpAdaptor adaptor,
+      ConversionPatternRewriter& rewriter) const override {
+    auto* converter =
+        static_cast<const PaddedTypeConverter*>(getTypeConverter());
+    const SymbolTable& symbolTable = converter->getSymbolTable();
+    // Only the attributes of the callee are read, since its signature and body
+    // may be converted concurrently.
+    auto callee = symbolTable.lookup<func::FuncOp>(op.getCallee());
+    if (!callee) {
+      return op.emitOpError("failed to resolve callee");
+    }
+
+    SmallVector<Value> operands;
+    operands.reserve(op.getNumOperands());
+    for (auto [index, origOperand, operand] :
+         llvm::enumerate(op.getOperands(), adaptor.getOperands())) {
+      operands.push_back(adjustToBoundary(
+          operand, origOperand,
+          callee.getArgAttrOfType<TensorShardingAttr>(index, kShardingAttr),
+          symbolTable, rewriter, cache));
+    }
+    SmallVector<Type> resultTypes =
+        llvm::map_to_vector(llvm::enumerate(op.getResultTypes()), [&](auto it) {
+          return getPaddedType(it.value(),
+                               callee.getResultAttrOfType<TensorShardingAttr>(
+                                   it.index(), kShardingAttr),
+                               symbolTable);
+        });
+
+    OperationState state(op->getLoc(), op->getName());
+    state.addOperands(operands);
+    state.addTypes(resultTypes);
+    state.addAttributes(op->getAttrs());
+    rewriter.replaceOp(op, rewriter.create(state)->getResults());
+    return success();
+  }
+
+ private:
+  PaddingCache& cache;
+};
+
+// Returns padded values directly from functions whose outputs are padded, see
+// `shouldPadBoundaries`.
+class FuncReturnOpPattern : public OpConversionPattern<func::ReturnOp> {
+ public:
+  FuncReturnOpPattern(TypeConverter& converter, MLIRContext* ctx,
+                      PaddingCache& cache)
+      : OpConversionPattern(converter, ctx), cache(cache) {}
+
+  LogicalResult matchAndRewrite(
+      func::ReturnOp op, OpAdaptor adaptor,
+      ConversionPatternRewriter& rewriter) const override {
+    auto* converter =
+        static_cast<const PaddedTypeConverter*>(getTypeConverter());
+    auto funcOp = op->getParentOfType<func::FuncOp>();
+
+    SmallVector<Value> operands;
+    operands.reserve(op.getNumOperands());
+    for (auto [index, origOperand, operand] :
+         llvm::enumerate(op.getOperands(), adaptor.getOperands())) {
+      operands.push_back(adjustToBoundary(
+          operand, origOperand, getFuncResultSharding(funcOp, index),
+          converter->getSymbolTable(), rewriter, cache));
+    }
+    rewriter.replaceOpWithNewOp<func::ReturnOp>(op, operands);
+    return success();
+  }
+
+ private:
+  PaddingCache& cache;
+};
+
 struct PadForDivisibilityPass
     : public impl::PadForDivisibilityPassBase<PadForDivisibilityPass> {
   using PadForDivisibilityPassBase::PadForDivisibilityPassBase;
@@ -801,7 +1079,9 @@ struct PadForDivisibilityPass
     // FuncOpPattern enforces that function inputs and outputs are always fully
     // divisible by sharding requirements. Consequently, padded values never
     // escape the local function scope. This isolation guarantees the cache can
-    // be stack-allocated per function.
+    // be stack-allocated per function. When padding across call boundaries,
+    // the padding kind of function arguments and call results is never
+    // registered, so the cache remains local to the function.
     PaddingCache paddingCache;
     func::FuncOp funcOp = getOperation();
     ModuleOp module = funcOp->getParentOfType<ModuleOp>();
@@ -809,13 +1089,18 @@ struct PadForDivisibilityPass
 
     PaddedTypeConverter typeConverter(symbolTable);
     RewritePatternSet patterns(&getContext());
-    patterns.add<GenericOpPattern, StablehloSliceOpPattern>(
-        typeConverter, &getContext());
-    patterns.add<FuncOpPattern>(typeConverter, &getContext());
+    patterns.add<StablehloSliceOpPattern>(typeConverter, &getContext());
+    patterns.add<FuncOpPattern>(typeConverter, &getContext(),
+                                padAcrossCallBoundaries);
+    if (padAcrossCallBoundaries) {
+      patterns.add<FuncCallOpPattern, FuncReturnOpPattern>(
+          typeConverter, &getContext(), paddingCache);
+    }
     // Sharing the padding cache reference across pattern instances is safe from
     // data races because pattern application within a function is sequential.
     patterns.add<AllSliceOpPattern, StablehloDotGeneralOpPattern,
-                 AllToAllOpPattern, AllGatherOpPattern, ReduceScatterOpPattern>(
+                 AllToAllOpPattern, AllGatherOpPattern, GenericOpPattern,
+                 ReduceScatterOpPattern, StablehloReduceOpPattern>(
         typeConverter, &getContext(), paddingCache);
     ConversionTarget target(getContext());
 
@@ -833,6 +1118,46 @@ struct PadForDivisibilityPass
                                   getFuncResultSharding(op, i));
              });
     });
+    if (padAcrossCallBoundaries) {
+      // A call or return boundary of a function with padded inputs and
+      // outputs is legal once all values crossing it are padded for the
+      // sharding of the function input or output.
+      auto isLegalBoundary =
+          [&](func::FuncOp funcOp, ValueRange values,
+              function_ref<TensorShardingAttr(int64_t)> getBoundarySharding) {
+            return !funcOp ||
+                   !shouldPadBoundaries(funcOp, padAcrossCallBoundaries) ||
+                   llvm::all_of(llvm::enumerate(values), [&](auto it) {
+                     return isLegalValue(it.value()) &&
+                            isLegalType(it.value().getType(),
+                                        getBoundarySharding(it.index()));
+                   });
+          };
+      target.addDynamicallyLegalOp<func::CallOp>([&](func::CallOp op) {
+        auto callee = symbolTable.lookup<func::FuncOp>(op.getCallee());
+        return isLegalBoundary(callee, op.getOperands(),
+                               [&](int64_t index) {
+                                 return callee.getArgAttrOfType<
+                                     TensorShardingAttr>(index, kShardingAttr);
+                               }) &&
+               (!callee ||
+                !shouldPadBoundaries(callee, padAcrossCallBoundaries) ||
+                llvm::all_of(llvm::enumerate(op.getResultTypes()),
+                             [&](auto it) {
+                               return isLegalType(
+                                   it.value(),
+                                   callee.getResultAttrOfType<
+                                       TensorShardingAttr>(it.index(),
+                                                           kShardingAttr));
+                             }));
+      });
+      target.addDynamicallyLegalOp<func::ReturnOp>([&](func::ReturnOp op) {
+        auto funcOp = op->getParentOfType<func::FuncOp>();
+        return isLegalBoundary(funcOp, op.getOperands(), [&](int64_t index) {
+          return getFuncResultSharding(funcOp, index);
+        });
+      });
+    }
     target.addDynamicallyLegalDialect<stablehlo::StablehloDialect>(
         [&](Operation* op) {
           return llvm::all_of(op->getResults(), isLegalValue) &&
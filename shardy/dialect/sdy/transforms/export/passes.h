@@ -87,6 +87,49 @@ struct ExportOptions : public PassPipelineOptions<ExportOptions> {
       llvm::cl::desc("Update axes with non-divisible input/output shardings."),
       llvm::cl::init(true)};
 
+  Option<bool> padAcrossCallBoundaries{
+      *this, "pad-across-call-boundaries",
+      llvm::cl::desc("Keep non-divisible shardings on the inputs/outputs of "
+                     "private functions whose callers all agree with them, so "
+                     "padded shapes can be kept across calls."),
+      llvm::cl::init(false)};
+
+  Option<bool> minimizeReshardedBytes{
+      *this, "minimize-resharded-bytes",
+      llvm::cl::desc("Pick common shardings that minimize the bytes "
+                     "communicated by explicit reshards."),
+      llvm::cl::init(false)};
+
+  Option<bool> enableReshardChainFusion{
+      *this, "enable-reshard-chain-fusion",
+      llvm::cl::desc("Fuse chains of reshards before converting them to "
+                     "collectives."),
+      llvm::cl::init(false)};
+
+  Option<bool> enableCollectiveSimplification{
+      *this, "enable-collective-simplification",
+      llvm::cl::desc("Fold chains of collectives in a single sweep before "
+                     "canonicalizing them."),
+      llvm::cl::init(false)};
+
+  Option<bool> scheduleCollectivesForOverlap{
+      *this, "schedule-collectives-for-overlap",
+      llvm::cl::desc("Schedule explicit collectives as early as possible to "
+                     "overlap them with compute."),
+      llvm::cl::init(false)};
+
+  Option<bool> dumpCollectiveStatistics{
+      *this, "dump-collective-statistics",
+      llvm::cl::desc("Save a JSON report of the collectives in the partitioned "
+                     "module to the dump directory."),
+      llvm::cl::init(false)};
+
+  Option<bool> delayUnreducedReductions{
+      *this, "delay-unreduced-reductions",
+      llvm::cl::desc("Push unreduced axes through linear ops to reduce them "
+                     "once, on the smallest tensor."),
+      llvm::cl::init(false)};
+
   Option<bool> disableSplitReshardingDimensions{
       *this, "disable-split-resharding-dimensions",
       llvm::cl::desc("Disable splitting sharded dimensions in ReshardOps."),
@@ -14,10 +14,13 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -38,26 +41,40 @@ namespace sdy {
 
 namespace {
 
+// Returns the index of the first sub-axis in `dimSharding`, or the number of
+// axes if there is none.
+size_t getFirstSubAxisIndex(DimensionShardingAttr dimSharding) {
+  ArrayRef<AxisRefAttr> axes = dimSharding.getAxes();
+  return std::distance(axes.begin(), llvm::find_if(axes, [](AxisRefAttr axis) {
+                         return axis.getSubAxisInfo();
+                       }));
+}
+
 TensorShardingAttr removeSubAxesInDimensionShardings(
     TensorShardingAttr sharding) {
+  // Most shardings have no sub-axes in open dimensions, in which case we return
+  // the sharding as is, without creating any new attributes.
+  if (llvm::all_of(sharding.getDimShardings(),
+                   [](DimensionShardingAttr dimSharding) {
+                     return dimSharding.getIsClosed() ||
+                            getFirstSubAxisIndex(dimSharding) ==
+                                dimSharding.getAxes().size();
+                   })) {
+    return sharding;
+  }
   MLIRContext* ctx = sharding.getContext();
   SmallVector<DimensionShardingAttr> newDimShardings;
   newDimShardings.reserve(sharding.getRank());
   for (DimensionShardingAttr oldDimSharding : sharding.getDimShardings()) {
-    if (oldDimSharding.getIsClosed()) {
+    size_t firstSubAxisIndex = getFirstSubAxisIndex(oldDimSharding);
+    if (oldDimSharding.getIsClosed() ||
+        firstSubAxisIndex == oldDimSharding.getAxes().size()) {
       newDimShardings.push_back(oldDimSharding);
       continue;
     }
-    SmallVector<AxisRefAttr> newAxes;
-    for (AxisRefAttr axis : oldDimSharding.getAxes()) {
-      if (axis.getSubAxisInfo()) {
-        break;
-      }
-      newAxes.push_back(axis);
-    }
-    newDimShardings.push_back(
-        DimensionShardingAttr::get(ctx, newAxes, oldDimSharding.getIsClosed(),
-                                   oldDimSharding.getPriority()));
+    newDimShardings.push_back(DimensionShardingAttr::get(
+        ctx, oldDimSharding.getAxes().take_front(firstSubAxisIndex),
+        oldDimSharding.getIsClosed(), oldDimSharding.getPriority()));
   }
   return TensorShardingAttr::get(ctx, sharding.getMeshOrRef(), newDimShardings,
                                  sharding.getReplicatedAxes(),
@@ -71,7 +88,11 @@ void updateValueShardings(
         setSharding) {
   for (int64_t index = 0; index < numShardings; index++) {
     if (TensorShardingAttr sharding = getSharding(index)) {
-      setSharding(index, removeSubAxesInDimensionShardings(sharding));
+      if (TensorShardingAttr newSharding =
+              removeSubAxesInDimensionShardings(sharding);
+          newSharding != sharding) {
+        setSharding(index, newSharding);
+      }
     }
   }
 }
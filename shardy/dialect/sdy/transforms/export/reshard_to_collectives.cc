@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <memory>  // IWYU pragma: keep
 #include <numeric>
@@ -28,10 +29,13 @@ limitations under the License.
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"  // IWYU pragma: keep
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/PatternMatch.h"
@@ -42,6 +46,7 @@ limitations under the License.
 #include "mlir/Transforms/DialectConversion.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
 #include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
 #include "shardy/dialect/sdy/transforms/export/utils.h"
 #include "shardy/dialect/sdy/transforms/propagation/utils.h"
@@ -185,6 +190,90 @@ struct AllToAllInfo {
   explicit AllToAllInfo(int64_t tgtDim) : tgtDim(tgtDim) {}
 };
 
+// A step of `CollectiveInserter`, that tries to insert a certain kind of
+// collective.
+enum class InsertionStep {
+  kAllSlice,
+  kCollectivePermute,
+  kAllToAllsInTargetOrder,
+  kAllToAlls,
+  kAllGather,
+};
+
+// The default order of steps.
+//
+// In the common case where all axes are a power of 2, in which case a bigger
+// axis is always divisible by a smaller axis, we are guaranteed to be done
+// after trying all-slice -> collective-permute -> all-to-alls -> all-gather.
+// The high level reasoning is that before trying to insert an all-gather, we
+// are left with an empty `outAxesPerDim`, since all out axes can be handled by
+// the previous collectives, so we are left with all-gathering all axes in
+// `inAxesPerDim` and we're done.
+//
+// 1. Try to insert an all-slice, that decreases the size of the tensor.
+//
+// 2. Try to insert a collective permute, that preserves the size of the tensor
+//    and only communicates from each device to another device.
+//
+// 3. Try to insert all-to-alls, that preserves the size of the tensor.
+//
+//    We first try to insert all-to-alls that move axes to the right position at
+//    the target dimension, to make sure multiple all-to-alls from different
+//    source dimensions to the same target dimension are inserted in the right
+//    order (to avoid the need for a collective permute), then we lift that
+//    constraint.
+//
+// 4. Try to insert an all-gather, that increases the size of the tensor.
+constexpr InsertionStep kDefaultStepOrder[] = {
+    InsertionStep::kAllSlice, InsertionStep::kCollectivePermute,
+    InsertionStep::kAllToAllsInTargetOrder, InsertionStep::kAllToAlls,
+    InsertionStep::kAllGather};
+
+// Alternative orders of steps that are considered with a cost model, in
+// addition to the default order.
+//
+// Moving axes with all-to-alls before a collective permute can make the latter
+// communicate over fewer axes.
+constexpr InsertionStep kAllToAllsFirstStepOrder[] = {
+    InsertionStep::kAllSlice, InsertionStep::kAllToAllsInTargetOrder,
+    InsertionStep::kAllToAlls, InsertionStep::kCollectivePermute,
+    InsertionStep::kAllGather};
+// Gathering axes and then slicing others can be cheaper than a collective
+// permute between them, e.g., when the gathered axis is faster.
+constexpr InsertionStep kAllGatherFirstStepOrder[] = {
+    InsertionStep::kAllGather, InsertionStep::kAllSlice,
+    InsertionStep::kCollectivePermute, InsertionStep::kAllToAllsInTargetOrder,
+    InsertionStep::kAllToAlls};
+
+// Returns all axes in `axesPerDim`.
+SmallVector<AxisRefAttr> flattenAxes(ArrayRef<AxisRefListAttr> axesPerDim) {
+  SmallVector<AxisRefAttr> axes;
+  for (AxisRefListAttr dimAxes : axesPerDim) {
+    llvm::append_range(axes, dimAxes.getValue());
+  }
+  return axes;
+}
+
+// Returns the axes that differ between `oldAxesPerDim` and `newAxesPerDim`,
+// i.e., the axes in either after the common prefix of each dimension.
+SmallVector<AxisRefAttr> getChangedAxes(const AxesPerDim& oldAxesPerDim,
+                                        const AxesPerDim& newAxesPerDim) {
+  SmallVector<AxisRefAttr> changedAxes;
+  for (auto [oldAxes, newAxes] :
+       llvm::zip_equal(oldAxesPerDim, newAxesPerDim)) {
+    auto [oldIt, newIt] = std::mismatch(oldAxes.begin(), oldAxes.end(),
+                                        newAxes.begin(), newAxes.end());
+    for (AxisRefAttr axis : llvm::concat<const AxisRefAttr>(
+             llvm::make_range(oldIt, oldAxes.end()),
+             llvm::make_range(newIt, newAxes.end()))) {
+      if (!llvm::is_contained(changedAxes, axis)) {
+        changedAxes.push_back(axis);
+      }
+    }
+  }
+  return changedAxes;
+}
+
 // A class that applies an algorithm to transform an input sharding into an
 // output sharding via a sequence of collectives.
 //
@@ -217,11 +306,17 @@ struct AllToAllInfo {
 // current and output sharding, i.e., when they are empty the shardings match
 // exactly. The algorithm inserts collectives and updates the current state
 // accordingly, until both `inAxesPerDim` and `outAxesPerDim` are empty.
+//
+// If a `costModel` is provided, the algorithm is first simulated with each
+// order of steps in `kDefaultStepOrder`, `kAllToAllsFirstStepOrder` and
+// `kAllGatherFirstStepOrder`, and the cheapest order is used to insert the
+// collectives, preferring the default order on ties.
 class CollectiveInserter {
  public:
   CollectiveInserter(TensorShardingAttr inSharding,
                      TensorShardingAttr outSharding, Value result,
-                     ConversionPatternRewriter& rewriter, Operation* op)
+                     ConversionPatternRewriter& rewriter, Operation* op,
+                     const CollectiveCostModel* costModel = nullptr)
       : rewriter(rewriter),
         loc(op->getLoc()),
         result(result),
@@ -234,6 +329,13 @@ class CollectiveInserter {
         currentAxesPerDim(getAxesPerDim<SmallVector<AxisRefAttr>>(inSharding)),
         capacityPerDim(inSharding.getRank(), 1),
         collectiveAxesPerDim(inSharding.getRank()) {
+    // The cost model needs the byte size of the tensor.
+    auto tensorType = dyn_cast<RankedTensorType>(result.getType());
+    if (costModel && tensorType && tensorType.hasStaticShape()) {
+      this->costModel = costModel;
+      this->tensorType = tensorType;
+      localBytes = getLocalTensorBytes(tensorType, inSharding, mesh);
+    }
     // Unreduced axes in the input and output sharding must match, given we
     // insert an all-reduce if an unreduced axis becomes replicated/sharded, and
     // never insert a reshard that goes from replicated/sharded to unreduced.
@@ -259,45 +361,82 @@ class CollectiveInserter {
   // If the input and output sharding are the same, returns the input value
   // without inserting any collective.
   Value insert() {
-    // In the common case where all axes are a power of 2, in which case a
-    // bigger axis is always divisible by a smaller axis, we are guaranteed to
-    // be done after trying all-slice -> collective-permute -> all-to-alls ->
-    // all-gather. The high level reasoning is that before trying to insert an
-    // all-gather, we are left with an empty `outAxesPerDim`, since all out axes
-    // can be handled by the previous collectives, so we are left with
-    // all-gathering all axes in `inAxesPerDim` and we're done.
-    //
-    // Otherwise, we need at most 2 iterations.
-
-    // TODO(tomnatan): consider looping only over all-to-all and collective
-    // permute as long as one of them was inserted.
-    for (int i = 0; i < 2 && !isDone(); ++i) {
-      // 1. Try to insert an all-slice, that decreases the size of the tensor.
-      tryAllSlice();
-
-      // 2. Try to insert a collective permute, that preserves the size of the
-      // tensor and only communicates from each device to another device.
-      tryCollectivePermute();
-
-      // 3. Try to insert all-to-alls, that preserves the size of the tensor.
-      //
-      // We first try to insert all-to-alls that move axes to the right position
-      // at the target dimension, to make sure multiple all-to-alls from
-      // different source dimensions to the same target dimension are inserted
-      // in the right order (to avoid the need for a collective permute), then
-      // we lift that constraint.
-      tryAllToAlls(/*allowOutOfOrderTarget=*/false);
-      tryAllToAlls(/*allowOutOfOrderTarget=*/true);
-
-      // 4. Try to insert an all-gather, that increases the size of the tensor.
-      tryAllGather();
-    }
+    runSteps(costModel ? getCheapestStepOrder()
+                       : ArrayRef<InsertionStep>(kDefaultStepOrder));
     assert(isDone());
 
     return result;
   }
 
  private:
+  // Runs the steps in `stepOrder` until done. With the default order, see
+  // `kDefaultStepOrder`, we need at most 2 iterations.
+  //
+  // TODO(tomnatan): consider looping only over all-to-all and collective
+  // permute as long as one of them was inserted.
+  void runSteps(ArrayRef<InsertionStep> stepOrder) {
+    for (int i = 0; i < 2 && !isDone(); ++i) {
+      for (InsertionStep step : stepOrder) {
+        runStep(step);
+      }
+    }
+  }
+
+  void runStep(InsertionStep step) {
+    switch (step) {
+      case InsertionStep::kAllSlice:
+        tryAllSlice();
+        break;
+      case InsertionStep::kCollectivePermute:
+        tryCollectivePermute();
+        break;
+      case InsertionStep::kAllToAllsInTargetOrder:
+        tryAllToAlls(/*allowOutOfOrderTarget=*/false);
+        break;
+      case InsertionStep::kAllToAlls:
+        tryAllToAlls(/*allowOutOfOrderTarget=*/true);
+        break;
+      case InsertionStep::kAllGather:
+        tryAllGather();
+        break;
+    }
+  }
+
+  // Simulates the algorithm with each order of steps, without inserting any
+  // collective, and returns the order with the lowest cost that transforms the
+  // input sharding into the output sharding.
+  ArrayRef<InsertionStep> getCheapestStepOrder() const {
+    ArrayRef<InsertionStep> cheapestStepOrder = kDefaultStepOrder;
+    double minCost = std::numeric_limits<double>::max();
+    for (ArrayRef<InsertionStep> stepOrder :
+         {ArrayRef<InsertionStep>(kDefaultStepOrder),
+          ArrayRef<InsertionStep>(kAllToAllsFirstStepOrder),
+          ArrayRef<InsertionStep>(kAllGatherFirstStepOrder)}) {
+      CollectiveInserter simulation(*this);
+      simulation.isSimulation = true;
+      simulation.runSteps(stepOrder);
+      if (simulation.isDone() && simulation.cost < minCost) {
+        minCost = simulation.cost;
+        cheapestStepOrder = stepOrder;
+      }
+    }
+    return cheapestStepOrder;
+  }
+
+  // Adds the cost of a collective of `kind` over `axes`, after the current
+  // state was updated w.r.t. the collective, and unless simulating, sets
+  // `result` to the collective created by `createCollective`.
+  void emitCollective(CollectiveKind kind, ArrayRef<AxisRefAttr> axes,
+                      llvm::function_ref<Value()> createCollective) {
+    if (costModel) {
+      cost += costModel->getCost(kind, localBytes, axes);
+      localBytes = getLocalTensorBytes(tensorType, getCurrentSharding(), mesh);
+    }
+    if (!isSimulation) {
+      result = createCollective();
+    }
+  }
+
   // Returns true if the input sharding has been transformed into the output
   // sharding, i.e., both `inAxesPerDim` and `outAxesPerDim` are empty and
   // `curMeshName == outMeshName`.
@@ -348,7 +487,7 @@ class CollectiveInserter {
     while (axisRevIt != inAxes.rend() &&
            !outAxisToDimAndIndex.contains(*axisRevIt)) {
       inAxisSet.erase(*axisRevIt);
-      --axisRevIt;
+      ++axisRevIt;
     }
     auto inAxisIt = axisRevIt.base();
     popBackFromCurrentAxes(currentAxes, inAxes, inAxisIt);
@@ -370,8 +509,12 @@ class CollectiveInserter {
       collectiveAxes = AxisRefListAttr::get(getContext(), gatheringAxes);
     }
     if (hasGatheringAxes) {
-      result = AllGatherOp::create(rewriter, loc, result, collectiveAxesPerDim,
-                                   getCurrentSharding());
+      emitCollective(CollectiveKind::kAllGather,
+                     flattenAxes(collectiveAxesPerDim), [&]() -> Value {
+                       return AllGatherOp::create(rewriter, loc, result,
+                                                  collectiveAxesPerDim,
+                                                  getCurrentSharding());
+                     });
     }
   }
 
@@ -763,8 +906,12 @@ class CollectiveInserter {
            llvm::zip_equal(collectiveAxesPerDim, *slicingAxesPerDim)) {
         collectiveAxes = AxisRefListAttr::get(getContext(), slicingAxes);
       }
-      result = AllSliceOp::create(rewriter, loc, result, collectiveAxesPerDim,
-                                  getCurrentSharding());
+      emitCollective(CollectiveKind::kAllSlice,
+                     flattenAxes(collectiveAxesPerDim), [&]() -> Value {
+                       return AllSliceOp::create(rewriter, loc, result,
+                                                 collectiveAxesPerDim,
+                                                 getCurrentSharding());
+                     });
     }
   }
 
@@ -1031,6 +1178,7 @@ class CollectiveInserter {
 
   // Tries to insert an `sdy.collective_permute`.
   void tryCollectivePermute() {
+    AxesPerDim oldAxesPerDim = currentAxesPerDim;
     // We separate the decision of whether to insert a collective permute from
     // the actual creation of the collective permute, since the latter isn't
     // guaranteed to maintain the order of axes in case a collective permute is
@@ -1050,8 +1198,12 @@ class CollectiveInserter {
     // TODO(b/392797233): if the order of device ids changes, but the input or
     // output sharding is fully replicated, we can skip the collective permute.
 
-    result = CollectivePermuteOp::create(rewriter, loc, result,
-                                         getCurrentSharding());
+    emitCollective(CollectiveKind::kCollectivePermute,
+                   getChangedAxes(oldAxesPerDim, currentAxesPerDim),
+                   [&]() -> Value {
+                     return CollectivePermuteOp::create(rewriter, loc, result,
+                                                        getCurrentSharding());
+                   });
   }
 
   // TODO(b/392952931): currently we are greedily all-to-all-ing axes even if
@@ -1193,11 +1345,13 @@ class CollectiveInserter {
   void tryAllToAlls(bool allowOutOfOrderTarget) {
     for (int64_t srcDim = 0; srcDim < getRank(); ++srcDim) {
       while (auto info = getAllToAllInfo(srcDim, allowOutOfOrderTarget)) {
-        result = AllToAllOp::create(
-            rewriter, loc, result,
-            AllToAllParamAttr::get(rewriter.getContext(), info->axes, srcDim,
-                                   info->tgtDim),
-            getCurrentSharding());
+        emitCollective(CollectiveKind::kAllToAll, info->axes, [&]() -> Value {
+          return AllToAllOp::create(
+              rewriter, loc, result,
+              AllToAllParamAttr::get(rewriter.getContext(), info->axes, srcDim,
+                                     info->tgtDim),
+              getCurrentSharding());
+        });
       }
     }
   }
@@ -1214,6 +1368,15 @@ class CollectiveInserter {
   SmallVector<AxisRefListAttr> collectiveAxesPerDim;
   AxisSet inAxisSet;
   AxisToDimAndIndex outAxisToDimAndIndex;
+  // The cost model, or nullptr if the default order of steps should be used.
+  const CollectiveCostModel* costModel = nullptr;
+  RankedTensorType tensorType;
+  // The number of bytes per device of the tensor with the current sharding.
+  int64_t localBytes = 0;
+  // The total cost of the collectives inserted so far.
+  double cost = 0.0;
+  // Whether collectives are only simulated, to compute their cost.
+  bool isSimulation = false;
 };
 
 // Assumes both `inSharding` and `outSharding` are non-null.
@@ -1237,7 +1400,11 @@ TensorShardingAttr getOrCreateShardingBypassingBarriers(
 
 class ReshardPattern : public OpConversionPattern<ReshardOp> {
  public:
-  using OpConversionPattern::OpConversionPattern;
+  ReshardPattern(MLIRContext* context, bool enableCostModel,
+                 double collectiveLatency)
+      : OpConversionPattern(context),
+        enableCostModel(enableCostModel),
+        collectiveLatency(collectiveLatency) {}
 
  private:
   LogicalResult matchAndRewrite(
@@ -1283,12 +1450,26 @@ class ReshardPattern : public OpConversionPattern<ReshardOp> {
     // sharding.
     // TODO(tomnatan): use a SymbolTable.
 
-    CollectiveInserter collectiveInserter(inSharding, outSharding,
-                                          bypassedInput, rewriter, op);
+    std::optional<CollectiveCostModel> costModel;
+    if (enableCostModel) {
+      // Inlined meshes have no bandwidth annotations.
+      if (MeshOp meshOp = getMeshOp(op, inSharding.getMeshName())) {
+        costModel = CollectiveCostModel::get(meshOp, collectiveLatency);
+      } else {
+        costModel.emplace(inSharding.getMesh(op), llvm::StringMap<double>(),
+                          collectiveLatency);
+      }
+    }
+    CollectiveInserter collectiveInserter(
+        inSharding, outSharding, bypassedInput, rewriter, op,
+        costModel ? &*costModel : nullptr);
     rewriter.replaceOp(op, collectiveInserter.insert());
 
     return success();
   }
+
+  bool enableCostModel;
+  double collectiveLatency;
 };
 
 struct ReshardToCollectivesPass
@@ -1320,7 +1501,8 @@ struct ReshardToCollectivesPass
     });
 
     RewritePatternSet patternsInternal(context);
-    patternsInternal.add<ReshardPattern>(context);
+    patternsInternal.add<ReshardPattern>(context, enableCostModel,
+                                         collectiveLatency);
     patterns = std::move(patternsInternal);
 
     return success();
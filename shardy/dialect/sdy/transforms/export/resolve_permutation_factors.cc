@@ -16,15 +16,21 @@ limitations under the License.
 #include <algorithm>
 #include <cstdint>
 #include <optional>
+#include <utility>
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/Debug.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/IRMapping.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/SymbolTable.h"
@@ -35,6 +41,7 @@ limitations under the License.
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/enums.h"
 #include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
 #include "shardy/dialect/sdy/transforms/export/explicit_reshards_util.h"
 #include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
 #include "shardy/dialect/sdy/transforms/export/utils.h"
@@ -43,6 +50,8 @@ limitations under the License.
 #include "shardy/dialect/sdy/transforms/propagation/utils.h"
 #include "stablehlo/dialect/StablehloOps.h"
 
+#define DEBUG_TYPE "sdy-export"
+
 namespace mlir {
 namespace sdy {
 
@@ -320,10 +329,718 @@ SmallVector<int64_t> getRightShiftSourceTargetPairs(
   return pairs;
 }
 
+// Returns the shape of a tensor of `shape` and `sharding` local to each device
+// of a manual computation over `manualAxes`.
+SmallVector<int64_t> getManualLocalShape(
+    ArrayRef<int64_t> shape, TensorShardingAttr sharding, MeshAttr mesh,
+    const llvm::SmallDenseSet<StringRef>& manualAxes) {
+  SmallVector<int64_t> localShape;
+  localShape.reserve(shape.size());
+  for (auto [dimSize, dimSharding] :
+       llvm::zip_equal(shape, sharding.getDimShardings())) {
+    int64_t manualFactor = 1;
+    for (AxisRefAttr axis : dimSharding.getAxes()) {
+      if (manualAxes.contains(axis.getName())) {
+        manualFactor *= axis.getSize(mesh);
+      }
+    }
+    localShape.push_back(dimSize / manualFactor);
+  }
+  return localShape;
+}
+
+// A sharded window dimension `dim` of an operand, such that each local shard
+// can be extended with the last `lowHalo` elements of the previous shard and
+// the first `highHalo` elements of the next shard along `axes`, after which the
+// windowed op can be computed locally without padding along `dim`.
+struct HaloDim {
+  int64_t dim;
+  SmallVector<AxisRefAttr> axes;
+  int64_t lowHalo;
+  int64_t highHalo;
+};
+
+// Returns the HaloDim for dimension `dim` of size `dimSize` sharded along
+// `axes`, or std::nullopt if the windowed op can't be computed with a single
+// halo exchange with the neighbouring shards.
+//
+// This requires full axes that evenly divide the dimension into whole strides,
+// and the padding to cover exactly the window overhang, i.e.,
+// `padLow + padHigh == effectiveWindowSize - stride` (e.g., "same" padding with
+// stride 1), such that the result is sharded the same way as the operand. Each
+// halo can't be larger than a shard.
+std::optional<HaloDim> getHaloDim(int64_t dim, int64_t dimSize,
+                                  ArrayRef<AxisRefAttr> axes, MeshAttr mesh,
+                                  int64_t windowSize, int64_t stride,
+                                  int64_t windowDilation, int64_t padLow,
+                                  int64_t padHigh) {
+  if (llvm::any_of(axes,
+                   [](AxisRefAttr axis) { return axis.getSubAxisInfo(); })) {
+    return std::nullopt;
+  }
+  int64_t shardCount = getTotalAxesSize(axes, mesh);
+  if (dimSize % shardCount != 0) {
+    return std::nullopt;
+  }
+  int64_t shardSize = dimSize / shardCount;
+  int64_t effectiveWindowSize = (windowSize - 1) * windowDilation + 1;
+  if (stride <= 0 || shardSize % stride != 0 || padLow < 0 || padHigh < 0 ||
+      padLow > shardSize || padHigh > shardSize ||
+      padLow + padHigh != effectiveWindowSize - stride) {
+    return std::nullopt;
+  }
+  return HaloDim{dim, llvm::to_vector(axes), padLow, padHigh};
+}
+
+// Collective permutes `value` by `shardOffset` shards along the dimension
+// sharded by the manual axes `axesInDim`. Devices without a source shard
+// receive zeros.
+Value permuteByShards(Location loc, Value value,
+                      ArrayRef<AxisRefAttr> axesInDim, int64_t shardOffset,
+                      MeshAttr mesh, TensorShardingAttr sharding,
+                      ResolutionState& state) {
+  SmallVector<int64_t> pairs =
+      getRightShiftSourceTargetPairs(mesh, axesInDim, shardOffset);
+  auto pairType =
+      RankedTensorType::get({static_cast<int64_t>(pairs.size()) / 2, 2},
+                            state.rewriter.getI64Type());
+  auto channelAttr = stablehlo::ChannelHandleAttr::get(
+      state.rewriter.getContext(), state.nextChannelId++, 1);
+  auto permOp = stablehlo::CollectivePermuteOp::create(
+      state.rewriter, loc, value.getType(), value,
+      DenseIntElementsAttr::get(pairType, pairs), channelAttr);
+  setSharding(permOp.getResult(), sharding);
+  return permOp.getResult();
+}
+
+// Like `permuteByShards`, but devices without a source shard receive
+// `padValue`, broadcast to the type of `value`, instead of zeros.
+Value permuteByShardsWithPadValue(Location loc, Value value,
+                                  ArrayRef<AxisRefAttr> axesInDim,
+                                  int64_t shardOffset, Value padValue,
+                                  MeshAttr mesh, TensorShardingAttr sharding,
+                                  ResolutionState& state) {
+  IRRewriter& rewriter = state.rewriter;
+  Value permuted =
+      permuteByShards(loc, value, axesInDim, shardOffset, mesh, sharding, state);
+  // Permute a flag alongside the value, which is false in devices without a
+  // source shard.
+  TensorShardingAttr scalarSharding = TensorShardingAttr::getFullyClosed(
+      rewriter.getContext(), /*rank=*/0, sharding.getMeshOrRef());
+  auto predType = RankedTensorType::get({}, rewriter.getI1Type());
+  auto trueOp = stablehlo::ConstantOp::create(
+      rewriter, loc, DenseElementsAttr::get(predType, true));
+  setSharding(trueOp.getResult(), scalarSharding);
+  Value hasSource = permuteByShards(loc, trueOp.getResult(), axesInDim,
+                                    shardOffset, mesh, scalarSharding, state);
+  auto padOp = stablehlo::BroadcastInDimOp::create(
+      rewriter, loc, value.getType(), padValue,
+      rewriter.getDenseI64ArrayAttr({}));
+  setSharding(padOp.getResult(), sharding);
+  auto selectOp = stablehlo::SelectOp::create(rewriter, loc, hasSource,
+                                              permuted, padOp.getResult());
+  setSharding(selectOp.getResult(), sharding);
+  return selectOp.getResult();
+}
+
+// Generates the local device code that extends `local` along `haloDim` with
+// the halos of the neighbouring shards. The shards at the edges of the
+// dimension have no neighbour, and are extended with `padValue` instead, or
+// with zeros if it's null.
+Value extendWithHalos(Location loc, Value local, const HaloDim& haloDim,
+                      Value padValue, MeshAttr mesh,
+                      TensorShardingAttr localSharding,
+                      ResolutionState& state) {
+  IRRewriter& rewriter = state.rewriter;
+  auto type = cast<RankedTensorType>(local.getType());
+  int64_t rank = type.getRank();
+
+  // Slices `size` elements starting at `start` and sends them `shardOffset`
+  // shards away.
+  auto getHalo = [&](int64_t start, int64_t size,
+                     int64_t shardOffset) -> Value {
+    SmallVector<int64_t> starts(rank, 0);
+    starts[haloDim.dim] = start;
+    SmallVector<int64_t> limits = llvm::to_vector(type.getShape());
+    limits[haloDim.dim] = start + size;
+    SmallVector<int64_t> haloShape = llvm::to_vector(type.getShape());
+    haloShape[haloDim.dim] = size;
+    auto haloType = RankedTensorType::get(haloShape, type.getElementType());
+    auto sliceOp = stablehlo::SliceOp::create(
+        rewriter, loc, haloType, local, rewriter.getDenseI64ArrayAttr(starts),
+        rewriter.getDenseI64ArrayAttr(limits),
+        rewriter.getDenseI64ArrayAttr(SmallVector<int64_t>(rank, 1)));
+    setSharding(sliceOp.getResult(), localSharding);
+    if (!padValue) {
+      return permuteByShards(loc, sliceOp.getResult(), haloDim.axes,
+                             shardOffset, mesh, localSharding, state);
+    }
+    return permuteByShardsWithPadValue(loc, sliceOp.getResult(), haloDim.axes,
+                                       shardOffset, padValue, mesh,
+                                       localSharding, state);
+  };
+
+  SmallVector<Value> pieces;
+  int64_t shardSize = type.getDimSize(haloDim.dim);
+  if (haloDim.lowHalo > 0) {
+    pieces.push_back(getHalo(shardSize - haloDim.lowHalo, haloDim.lowHalo,
+                             /*shardOffset=*/1));
+  }
+  pieces.push_back(local);
+  if (haloDim.highHalo > 0) {
+    pieces.push_back(getHalo(0, haloDim.highHalo, /*shardOffset=*/-1));
+  }
+  if (pieces.size() == 1) {
+    return local;
+  }
+  Value concat =
+      stablehlo::ConcatenateOp::create(rewriter, loc, pieces, haloDim.dim);
+  setSharding(concat, localSharding);
+  return concat;
+}
+
+// Returns the manual axes of `mesh` in `manualAxes`, in mesh order.
+SmallVector<StringAttr> getManualAxesAttrs(
+    MeshAttr mesh, const llvm::SmallDenseSet<StringRef>& manualAxes,
+    OpBuilder& builder) {
+  SmallVector<StringAttr> manualAxesAttrs;
+  for (MeshAxisAttr axis : mesh.getAxes()) {
+    if (manualAxes.contains(axis.getName())) {
+      manualAxesAttrs.push_back(builder.getStringAttr(axis.getName()));
+    }
+  }
+  return manualAxesAttrs;
+}
+
+// Replaces the single-result `op` with a manual computation over
+// `manualAxes`, whose operands are the operands of `op`. The body is built by
+// `buildBody`, given a mapping from the operands of `op` to the block
+// arguments, and returns the local result.
+void replaceWithManualComputation(
+    Operation* op, const llvm::SmallDenseSet<StringRef>& manualAxes,
+    ArrayRef<TensorShardingAttr> inShardings, TensorShardingAttr outSharding,
+    MeshAttr mesh, function_ref<Value(IRMapping&)> buildBody,
+    ResolutionState& state) {
+  IRRewriter& rewriter = state.rewriter;
+  Location loc = op->getLoc();
+  rewriter.setInsertionPoint(op);
+  auto manualComp = ManualComputationOp::create(
+      rewriter, loc, op->getResultTypes(), op->getOperands(), inShardings,
+      {outSharding}, getManualAxesAttrs(mesh, manualAxes, rewriter));
+  Block& body = manualComp.getBody().emplaceBlock();
+  IRMapping mapping;
+  for (auto [operand, sharding] :
+       llvm::zip_equal(op->getOperands(), inShardings)) {
+    auto type = cast<RankedTensorType>(operand.getType());
+    mapping.map(operand,
+                body.addArgument(
+                    RankedTensorType::get(getManualLocalShape(type.getShape(),
+                                                              sharding, mesh,
+                                                              manualAxes),
+                                          type.getElementType()),
+                    loc));
+  }
+
+  OpBuilder::InsertionGuard guard(rewriter);
+  rewriter.setInsertionPointToStart(&body);
+  ReturnOp::create(rewriter, loc, buildBody(mapping));
+
+  rewriter.replaceOp(op, manualComp.getResults());
+}
+
+// Clones the single-result `op` with `mapping`, and sets the type of its
+// result to be local to a manual computation over `manualAxes`.
+Operation* cloneAsLocalOp(Operation* op, IRMapping& mapping,
+                          TensorShardingAttr outSharding, MeshAttr mesh,
+                          const llvm::SmallDenseSet<StringRef>& manualAxes,
+                          ResolutionState& state) {
+  Operation* localOp = state.rewriter.clone(*op, mapping);
+  auto resultType = cast<RankedTensorType>(op->getResult(0).getType());
+  localOp->getResult(0).setType(RankedTensorType::get(
+      getManualLocalShape(resultType.getShape(), outSharding, mesh, manualAxes),
+      resultType.getElementType()));
+  setSharding(localOp->getResult(0),
+              removeAxesFromSharding(outSharding, manualAxes));
+  return localOp;
+}
+
+// Replaces the windowed `op` with a manual computation over the axes of
+// `haloDims`, in which the first operand is extended with halos along each of
+// `haloDims` and `op` is computed locally. `clearPadding` sets the padding of
+// the local op to zero along all `haloDims`. The edge halos have the value of
+// operand `padValueOperand` if set, or zero otherwise.
+void computeWithHalos(Operation* op, ArrayRef<HaloDim> haloDims,
+                      ArrayRef<TensorShardingAttr> inShardings,
+                      TensorShardingAttr outSharding, MeshAttr mesh,
+                      std::optional<int64_t> padValueOperand,
+                      function_ref<void(Operation*)> clearPadding,
+                      ResolutionState& state) {
+  llvm::SmallDenseSet<StringRef> manualAxes;
+  for (const HaloDim& haloDim : haloDims) {
+    for (AxisRefAttr axis : haloDim.axes) {
+      manualAxes.insert(axis.getName());
+    }
+  }
+
+  replaceWithManualComputation(
+      op, manualAxes, inShardings, outSharding, mesh,
+      [&](IRMapping& mapping) {
+        Location loc = op->getLoc();
+        TensorShardingAttr localSharding =
+            removeAxesFromSharding(inShardings.front(), manualAxes);
+        Value padValue =
+            padValueOperand
+                ? mapping.lookup(op->getOperand(*padValueOperand))
+                : nullptr;
+        Value extended = mapping.lookup(op->getOperand(0));
+        for (const HaloDim& haloDim : haloDims) {
+          extended = extendWithHalos(loc, extended, haloDim, padValue, mesh,
+                                     localSharding, state);
+        }
+        mapping.map(op->getOperand(0), extended);
+
+        Operation* localOp =
+            cloneAsLocalOp(op, mapping, outSharding, mesh, manualAxes, state);
+        clearPadding(localOp);
+        return localOp->getResult(0);
+      },
+      state);
+}
+
+// Returns the 2D padding attribute with `numDims` rows of `padding`, or zero
+// if it's null, where the rows of `haloDims` are zero.
+DenseIntElementsAttr getPaddingWithoutHaloDims(
+    std::optional<DenseIntElementsAttr> padding, int64_t numDims,
+    ArrayRef<int64_t> haloDims, OpBuilder& builder) {
+  SmallVector<int64_t> values(numDims * 2, 0);
+  if (padding) {
+    values = llvm::to_vector(padding->getValues<int64_t>());
+  }
+  for (int64_t dim : haloDims) {
+    values[2 * dim] = 0;
+    values[2 * dim + 1] = 0;
+  }
+  return DenseIntElementsAttr::get(
+      RankedTensorType::get({numDims, 2}, builder.getI64Type()), values);
+}
+
+// Returns the `dim`-th low and high padding in `padding`, or zero if it's null.
+std::pair<int64_t, int64_t> getPaddingOfDim(
+    std::optional<DenseIntElementsAttr> padding, int64_t dim) {
+  if (!padding) {
+    return {0, 0};
+  }
+  auto values = padding->getValues<int64_t>();
+  return {values[2 * dim], values[2 * dim + 1]};
+}
+
 // =============================================================================
 // Implementation of handleXYZOps routines in alphabetical order.
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+// stablehlo.convolution
+// -----------------------------------------------------------------------------
+
+// Implements a convolution whose lhs and result spatial dimensions are sharded
+// the same way, by exchanging the halos of the lhs with the neighbouring shards
+// and computing the convolution locally, instead of replicating the spatial
+// dimensions. The edge halos are zeros, which match the zero padding of a
+// convolution. Returns failure if not all sharded spatial dimensions have a
+// HaloDim, the lhs is dilated, or the rhs is sharded along the halo axes.
+LogicalResult handleConvolutionOp(stablehlo::ConvolutionOp convOp,
+                                  ResolutionState& state) {
+  Value lhs = convOp.getLhs();
+  Value rhs = convOp.getRhs();
+  TensorShardingAttr lhsSharding = getSharding(lhs);
+  TensorShardingAttr outSharding = getSharding(convOp.getResult());
+  auto lhsType = dyn_cast<RankedTensorType>(lhs.getType());
+  auto rhsType = dyn_cast<RankedTensorType>(rhs.getType());
+  if (!lhsSharding || !outSharding || !lhsType || !rhsType ||
+      !lhsType.hasStaticShape() || !rhsType.hasStaticShape() ||
+      lhsSharding.getMeshOrRef() != outSharding.getMeshOrRef()) {
+    return failure();
+  }
+  MeshAttr mesh = lhsSharding.getMesh(state.symbolTable);
+  if (!mesh || mesh.isMaximal()) {
+    return failure();
+  }
+  if (std::optional<ArrayRef<int64_t>> lhsDilation = convOp.getLhsDilation();
+      lhsDilation && llvm::any_of(*lhsDilation,
+                                  [](int64_t d) { return d != 1; })) {
+    return failure();
+  }
+
+  stablehlo::ConvDimensionNumbersAttr dimNums = convOp.getDimensionNumbers();
+  ArrayRef<int64_t> strides =
+      convOp.getWindowStrides().value_or(ArrayRef<int64_t>());
+  ArrayRef<int64_t> rhsDilations =
+      convOp.getRhsDilation().value_or(ArrayRef<int64_t>());
+  SmallVector<HaloDim> haloDims;
+  SmallVector<int64_t> haloSpatialDims;
+  for (auto [i, lhsDim, kernelDim, outDim] : llvm::enumerate(
+           dimNums.getInputSpatialDimensions(),
+           dimNums.getKernelSpatialDimensions(),
+           dimNums.getOutputSpatialDimensions())) {
+    ArrayRef<AxisRefAttr> axes =
+        lhsSharding.getDimShardings()[lhsDim].getAxes();
+    if (getTotalAxesSize(axes, mesh) <= 1) {
+      continue;
+    }
+    if (outSharding.getDimShardings()[outDim].getAxes() != axes) {
+      return failure();
+    }
+    auto [padLow, padHigh] = getPaddingOfDim(convOp.getPadding(), i);
+    std::optional<HaloDim> haloDim = getHaloDim(
+        lhsDim, lhsType.getDimSize(lhsDim), axes, mesh,
+        rhsType.getDimSize(kernelDim), strides.empty() ? 1 : strides[i],
+        rhsDilations.empty() ? 1 : rhsDilations[i], padLow, padHigh);
+    if (!haloDim) {
+      return failure();
+    }
+    haloDims.push_back(std::move(*haloDim));
+    haloSpatialDims.push_back(i);
+  }
+  if (haloDims.empty()) {
+    return failure();
+  }
+
+  TensorShardingAttr rhsSharding = getSharding(rhs);
+  if (!rhsSharding) {
+    rhsSharding = TensorShardingAttr::getFullyClosed(
+        convOp.getContext(), rhsType.getRank(), lhsSharding.getMeshOrRef());
+  }
+  if (rhsSharding.anyOfAxisRef([&](AxisRefAttr rhsAxis) {
+        return llvm::any_of(haloDims, [&](const HaloDim& haloDim) {
+          return llvm::any_of(haloDim.axes, [&](AxisRefAttr axis) {
+            return axis.getName() == rhsAxis.getName();
+          });
+        });
+      })) {
+    return failure();
+  }
+
+  int64_t numSpatialDims = dimNums.getInputSpatialDimensions().size();
+  computeWithHalos(convOp, haloDims, {lhsSharding, rhsSharding}, outSharding,
+                   mesh, /*padValueOperand=*/std::nullopt,
+                   [&](Operation* localOp) {
+                     auto localConv = cast<stablehlo::ConvolutionOp>(localOp);
+                     localConv.setPaddingAttr(getPaddingWithoutHaloDims(
+                         convOp.getPadding(), numSpatialDims, haloSpatialDims,
+                         state.rewriter));
+                   },
+                   state);
+  return success();
+}
+
+// -----------------------------------------------------------------------------
+// stablehlo.reduce_window
+// -----------------------------------------------------------------------------
+
+// Implements a single-input reduce window whose input and result are sharded
+// the same way, by exchanging the halos of the input with the neighbouring
+// shards and reducing locally, instead of replicating the window dimensions.
+// The edge halos are the init value, which matches the padding of a reduce
+// window. Returns failure if not all sharded window dimensions are either
+// pass-through or have a HaloDim, or the base is dilated along them.
+LogicalResult handleReduceWindowOp(stablehlo::ReduceWindowOp reduceWindowOp,
+                                   ResolutionState& state) {
+  if (reduceWindowOp.getInputs().size() != 1) {
+    return failure();
+  }
+  Value input = reduceWindowOp.getInputs().front();
+  Value initValue = reduceWindowOp.getInitValues().front();
+  TensorShardingAttr inSharding = getSharding(input);
+  TensorShardingAttr outSharding = getSharding(reduceWindowOp.getResult(0));
+  auto inType = dyn_cast<RankedTensorType>(input.getType());
+  if (!inSharding || !outSharding || !inType || !inType.hasStaticShape() ||
+      inSharding.getMeshOrRef() != outSharding.getMeshOrRef() ||
+      inSharding.getDimShardings() != outSharding.getDimShardings()) {
+    return failure();
+  }
+  MeshAttr mesh = inSharding.getMesh(state.symbolTable);
+  if (!mesh || mesh.isMaximal()) {
+    return failure();
+  }
+
+  ArrayRef<int64_t> windowDims = reduceWindowOp.getWindowDimensions();
+  ArrayRef<int64_t> strides =
+      reduceWindowOp.getWindowStrides().value_or(ArrayRef<int64_t>());
+  ArrayRef<int64_t> baseDilations =
+      reduceWindowOp.getBaseDilations().value_or(ArrayRef<int64_t>());
+  ArrayRef<int64_t> windowDilations =
+      reduceWindowOp.getWindowDilations().value_or(ArrayRef<int64_t>());
+  SmallVector<HaloDim> haloDims;
+  SmallVector<int64_t> haloDimIndices;
+  for (auto [dim, dimSharding] :
+       llvm::enumerate(inSharding.getDimShardings())) {
+    ArrayRef<AxisRefAttr> axes = dimSharding.getAxes();
+    if (getTotalAxesSize(axes, mesh) <= 1) {
+      continue;
+    }
+    int64_t stride = strides.empty() ? 1 : strides[dim];
+    auto [padLow, padHigh] =
+        getPaddingOfDim(reduceWindowOp.getPadding(), dim);
+    if (!baseDilations.empty() && baseDilations[dim] != 1) {
+      return failure();
+    }
+    if (windowDims[dim] == 1 && stride == 1 && padLow == 0 && padHigh == 0) {
+      // A pass-through dimension.
+      continue;
+    }
+    std::optional<HaloDim> haloDim = getHaloDim(
+        dim, inType.getDimSize(dim), axes, mesh, windowDims[dim], stride,
+        windowDilations.empty() ? 1 : windowDilations[dim], padLow, padHigh);
+    if (!haloDim) {
+      return failure();
+    }
+    haloDims.push_back(std::move(*haloDim));
+    haloDimIndices.push_back(dim);
+  }
+  if (haloDims.empty()) {
+    return failure();
+  }
+
+  TensorShardingAttr initSharding = getSharding(initValue);
+  if (!initSharding) {
+    initSharding = TensorShardingAttr::getFullyClosed(
+        reduceWindowOp.getContext(), /*rank=*/0, inSharding.getMeshOrRef());
+  }
+  computeWithHalos(reduceWindowOp, haloDims, {inSharding, initSharding},
+                   outSharding, mesh, /*padValueOperand=*/1,
+                   [&](Operation* localOp) {
+                     auto localReduceWindow =
+                         cast<stablehlo::ReduceWindowOp>(localOp);
+                     localReduceWindow.setPaddingAttr(getPaddingWithoutHaloDims(
+                         reduceWindowOp.getPadding(), inType.getRank(),
+                         haloDimIndices, state.rewriter));
+                   },
+                   state);
+  return success();
+}
+
+// Returns the single op of the reduction `body` of a reduce window, if it is an
+// associative and commutative binary op of the block arguments, or nullptr
+// otherwise.
+Operation* getAssociativeReduction(Region& body) {
+  if (!body.hasOneBlock()) {
+    return nullptr;
+  }
+  Block& block = body.front();
+  if (!llvm::hasSingleElement(block.without_terminator())) {
+    return nullptr;
+  }
+  Operation& reductionOp = block.front();
+  Operation* terminator = block.getTerminator();
+  if (!isa<stablehlo::AddOp, stablehlo::MulOp, stablehlo::OrOp,
+           stablehlo::AndOp>(reductionOp) ||
+      block.getNumArguments() != 2 ||
+      reductionOp.getOperand(0) != block.getArgument(0) ||
+      reductionOp.getOperand(1) != block.getArgument(1) ||
+      terminator->getNumOperands() != 1 ||
+      terminator->getOperand(0) != reductionOp.getResult(0)) {
+    return nullptr;
+  }
+  return &reductionOp;
+}
+
+// Returns true if `value` is a constant that is the identity of
+// `reductionOp`, i.e., zero for add and or, and one for mul and and.
+bool isReductionIdentity(Operation* reductionOp, Value value) {
+  if (isa<stablehlo::AddOp, stablehlo::OrOp>(reductionOp)) {
+    return matchPattern(value, m_Zero()) ||
+           matchPattern(value, m_AnyZeroFloat());
+  }
+  return matchPattern(value, m_One()) || matchPattern(value, m_OneFloat());
+}
+
+// Applies the scalar `reductionOp` elementwise to `lhs` and `rhs`, which have
+// the same type.
+Value applyReduction(Operation* reductionOp, Value lhs, Value rhs,
+                     TensorShardingAttr sharding, ResolutionState& state) {
+  IRMapping mapping;
+  mapping.map(reductionOp->getOperand(0), lhs);
+  mapping.map(reductionOp->getOperand(1), rhs);
+  Operation* newOp = state.rewriter.clone(*reductionOp, mapping);
+  newOp->getResult(0).setType(lhs.getType());
+  setSharding(newOp->getResult(0), sharding);
+  return newOp->getResult(0);
+}
+
+// Implements a single-input reduce window that computes a cumulative reduction
+// (e.g., a cumulative sum) along a sharded dimension, whose input and result
+// are sharded the same way, instead of replicating that dimension. A
+// dimension of size N is cumulative if its window is of size N, with stride 1,
+// no dilation, and a padding of (N-1, 0) for a prefix or (0, N-1) for a
+// suffix.
+//
+// Each shard computes the cumulative reduction of its local elements, and the
+// total of the shards before it (in the direction of the reduction) is
+// computed with a parallel prefix of the local totals, which takes
+// 1 + ceil(log2(shardCount - 1)) collective permutes of a single slice. The total is
+// then reduced into the local result.
+//
+// Returns failure if there isn't exactly one cumulative sharded dimension, all
+// other sharded dimensions aren't pass-through, the reduction isn't an
+// associative and commutative op, or the init value isn't its identity.
+LogicalResult handleCumulativeReduceWindowOp(
+    stablehlo::ReduceWindowOp reduceWindowOp, ResolutionState& state) {
+  if (reduceWindowOp.getInputs().size() != 1) {
+    return failure();
+  }
+  Operation* reductionOp = getAssociativeReduction(reduceWindowOp.getBody());
+  Value input = reduceWindowOp.getInputs().front();
+  Value initValue = reduceWindowOp.getInitValues().front();
+  if (!reductionOp || !isReductionIdentity(reductionOp, initValue)) {
+    return failure();
+  }
+  TensorShardingAttr inSharding = getSharding(input);
+  TensorShardingAttr outSharding = getSharding(reduceWindowOp.getResult(0));
+  auto inType = dyn_cast<RankedTensorType>(input.getType());
+  if (!inSharding || !outSharding || !inType || !inType.hasStaticShape() ||
+      inSharding.getMeshOrRef() != outSharding.getMeshOrRef() ||
+      inSharding.getDimShardings() != outSharding.getDimShardings()) {
+    return failure();
+  }
+  MeshAttr mesh = inSharding.getMesh(state.symbolTable);
+  if (!mesh || mesh.isMaximal()) {
+    return failure();
+  }
+
+  ArrayRef<int64_t> windowDims = reduceWindowOp.getWindowDimensions();
+  ArrayRef<int64_t> strides =
+      reduceWindowOp.getWindowStrides().value_or(ArrayRef<int64_t>());
+  ArrayRef<int64_t> baseDilations =
+      reduceWindowOp.getBaseDilations().value_or(ArrayRef<int64_t>());
+  ArrayRef<int64_t> windowDilations =
+      reduceWindowOp.getWindowDilations().value_or(ArrayRef<int64_t>());
+  std::optional<int64_t> cumulativeDim;
+  bool isSuffix = false;
+  for (auto [dim, dimSharding] :
+       llvm::enumerate(inSharding.getDimShardings())) {
+    ArrayRef<AxisRefAttr> axes = dimSharding.getAxes();
+    int64_t shardCount = getTotalAxesSize(axes, mesh);
+    if (shardCount <= 1) {
+      continue;
+    }
+    int64_t stride = strides.empty() ? 1 : strides[dim];
+    int64_t windowDilation = windowDilations.empty() ? 1 : windowDilations[dim];
+    auto [padLow, padHigh] =
+        getPaddingOfDim(reduceWindowOp.getPadding(), dim);
+    if ((!baseDilations.empty() && baseDilations[dim] != 1) || stride != 1) {
+      return failure();
+    }
+    if (windowDims[dim] == 1 && padLow == 0 && padHigh == 0) {
+      // A pass-through dimension.
+      continue;
+    }
+    int64_t dimSize = inType.getDimSize(dim);
+    bool isPrefixDim = padLow == dimSize - 1 && padHigh == 0;
+    bool isSuffixDim = padLow == 0 && padHigh == dimSize - 1;
+    if (cumulativeDim || windowDims[dim] != dimSize || windowDilation != 1 ||
+        !(isPrefixDim || isSuffixDim) || dimSize % shardCount != 0 ||
+        llvm::any_of(axes,
+                     [](AxisRefAttr axis) { return axis.getSubAxisInfo(); })) {
+      return failure();
+    }
+    cumulativeDim = dim;
+    isSuffix = isSuffixDim;
+  }
+  if (!cumulativeDim) {
+    return failure();
+  }
+
+  int64_t dim = *cumulativeDim;
+  ArrayRef<AxisRefAttr> axes = inSharding.getDimShardings()[dim].getAxes();
+  int64_t shardCount = getTotalAxesSize(axes, mesh);
+  int64_t shardSize = inType.getDimSize(dim) / shardCount;
+  int64_t direction = isSuffix ? -1 : 1;
+  llvm::SmallDenseSet<StringRef> manualAxes;
+  for (AxisRefAttr axis : axes) {
+    manualAxes.insert(axis.getName());
+  }
+  TensorShardingAttr initSharding = getSharding(initValue);
+  if (!initSharding) {
+    initSharding = TensorShardingAttr::getFullyClosed(
+        reduceWindowOp.getContext(), /*rank=*/0, inSharding.getMeshOrRef());
+  }
+
+  replaceWithManualComputation(
+      reduceWindowOp, manualAxes, {inSharding, initSharding}, outSharding,
+      mesh,
+      [&](IRMapping& mapping) {
+        IRRewriter& rewriter = state.rewriter;
+        Location loc = reduceWindowOp.getLoc();
+        TensorShardingAttr localSharding =
+            removeAxesFromSharding(outSharding, manualAxes);
+        Value localInit = mapping.lookup(initValue);
+
+        // The cumulative reduction of the local shard.
+        auto localOp = cast<stablehlo::ReduceWindowOp>(cloneAsLocalOp(
+            reduceWindowOp, mapping, outSharding, mesh, manualAxes, state));
+        SmallVector<int64_t> localWindowDims = llvm::to_vector(windowDims);
+        localWindowDims[dim] = shardSize;
+        localOp.setWindowDimensionsAttr(
+            rewriter.getDenseI64ArrayAttr(localWindowDims));
+        SmallVector<int64_t> padding(inType.getRank() * 2, 0);
+        if (std::optional<DenseIntElementsAttr> oldPadding =
+                reduceWindowOp.getPadding()) {
+          padding = llvm::to_vector(oldPadding->getValues<int64_t>());
+        }
+        padding[2 * dim] = isSuffix ? 0 : shardSize - 1;
+        padding[2 * dim + 1] = isSuffix ? shardSize - 1 : 0;
+        localOp.setPaddingAttr(DenseIntElementsAttr::get(
+            RankedTensorType::get({inType.getRank(), 2},
+                                  rewriter.getI64Type()),
+            padding));
+        Value localResult = localOp.getResult(0);
+        auto localType = cast<RankedTensorType>(localResult.getType());
+
+        // The local total is the last element of the local result along `dim`
+        // in the direction of the reduction.
+        SmallVector<int64_t> starts(localType.getRank(), 0);
+        starts[dim] = isSuffix ? 0 : shardSize - 1;
+        SmallVector<int64_t> limits = llvm::to_vector(localType.getShape());
+        limits[dim] = starts[dim] + 1;
+        SmallVector<int64_t> totalShape = llvm::to_vector(localType.getShape());
+        totalShape[dim] = 1;
+        auto totalOp = stablehlo::SliceOp::create(
+            rewriter, loc,
+            RankedTensorType::get(totalShape, localType.getElementType()),
+            localResult, rewriter.getDenseI64ArrayAttr(starts),
+            rewriter.getDenseI64ArrayAttr(limits),
+            rewriter.getDenseI64ArrayAttr(
+                SmallVector<int64_t>(localType.getRank(), 1)));
+        setSharding(totalOp.getResult(), localSharding);
+
+        // Shift the local totals by one shard, and compute an inclusive
+        // parallel prefix of the shifted totals, which is the exclusive prefix
+        // of the local totals. The first shard only has the identity, so the
+        // prefix of the last shard is complete once it covers `shardCount - 1`
+        // shards.
+        Value prefix = permuteByShardsWithPadValue(
+            loc, totalOp.getResult(), axes, direction, localInit, mesh,
+            localSharding, state);
+        for (int64_t step = 1; step < shardCount - 1; step *= 2) {
+          Value shifted =
+              permuteByShardsWithPadValue(loc, prefix, axes, direction * step,
+                                          localInit, mesh, localSharding, state);
+          prefix = applyReduction(reductionOp, shifted, prefix, localSharding,
+                                  state);
+        }
+
+        auto broadcastOp = stablehlo::BroadcastInDimOp::create(
+            rewriter, loc, localType, prefix,
+            rewriter.getDenseI64ArrayAttr(
+                llvm::to_vector(llvm::seq<int64_t>(0, localType.getRank()))));
+        setSharding(broadcastOp.getResult(), localSharding);
+        return applyReduction(reductionOp, broadcastOp.getResult(), localResult,
+                              localSharding, state);
+      },
+      state);
+  return success();
+}
+
 // -----------------------------------------------------------------------------
 // stablehlo.reverse
 // -----------------------------------------------------------------------------
@@ -480,18 +1197,9 @@ Value haloRightShiftData(Location loc, Value input, RankedTensorType origType,
                          ArrayRef<int64_t> shiftAmounts,
                          ResolutionState& state) {
   // Compute the local tensor shape for the operand inside manual computation.
-  SmallVector<int64_t> localShape;
-  localShape.reserve(sharding.getDimShardings().size());
+  SmallVector<int64_t> localShape =
+      getManualLocalShape(paddedShape, sharding, mesh, manualAxes);
   auto inputType = cast<RankedTensorType>(input.getType());
-  for (auto [dim, dimSharding] : llvm::enumerate(sharding.getDimShardings())) {
-    int64_t manualFactor = 1;
-    for (auto axis : dimSharding.getAxes()) {
-      if (manualAxes.contains(axis.getName())) {
-        manualFactor *= axis.getSize(mesh);
-      }
-    }
-    localShape.push_back(paddedShape[dim] / manualFactor);
-  }
 
   // Get the manual axes for the manual computation.
   SmallVector<StringAttr> manualAxesAttrs;
@@ -618,6 +1326,139 @@ LogicalResult handleReverseOp(stablehlo::ReverseOp reverseOp,
   return success();
 }
 
+// -----------------------------------------------------------------------------
+// Resolution by moving axes to a pass-through factor.
+// -----------------------------------------------------------------------------
+
+// Moves the axes of a permutation factor to the pass-through factor with
+// `factorIndex`.
+struct AxesMove {
+  int64_t factorIndex;
+  SmallVector<AxisRefAttr> axes;
+};
+
+// Returns the per device size of the `tensorNum`-th tensor of `op`, i.e.,
+// operands followed by results, or std::nullopt if it doesn't have a static
+// shape.
+std::optional<int64_t> getLocalBytesOfTensor(Operation* op, int64_t tensorNum,
+                                             TensorShardingAttr sharding,
+                                             MeshAttr mesh) {
+  Value tensor = tensorNum < op->getNumOperands()
+                     ? op->getOperand(tensorNum)
+                     : op->getResult(tensorNum - op->getNumOperands());
+  auto type = dyn_cast<RankedTensorType>(tensor.getType());
+  if (!type || !type.hasStaticShape()) {
+    return std::nullopt;
+  }
+  return getLocalTensorBytes(type, sharding, mesh);
+}
+
+// Tries to find a pass-through factor that `permutationFactor` can move its
+// axes to, instead of being replicated, such that the op stays sharded along
+// the same axes.
+//
+// Replicating the factor all-gathers every operand, while moving its axes
+// requires an all-to-all for every operand and result. Returns the move only if
+// it moves at most as many bytes as replicating, in which case the op also
+// keeps its compute sharded.
+//
+// The pass-through factor can't be in `excludedFactors`, and must be unsharded
+// in all tensors, and be mapped by exactly the tensors that map
+// `permutationFactor`. All tensors that map `permutationFactor` must be sharded
+// the same way along it.
+std::optional<AxesMove> findAxesMove(Operation* op, int64_t permutationFactor,
+                                     const ShardingProjection& projection,
+                                     OpShardingRuleAttr rule,
+                                     ArrayRef<TensorShardingAttr> shardings,
+                                     MeshAttr mesh,
+                                     ArrayRef<int64_t> excludedFactors) {
+  SmallVector<AxisRefAttr> axes;
+  for (int64_t tensorNum = 0; tensorNum < projection.getNumTensors();
+       ++tensorNum) {
+    const FactorIndexToSharding& factorShardings =
+        projection.getTensor(tensorNum).factorIndexToSharding;
+    auto it = factorShardings.find(permutationFactor);
+    if (it == factorShardings.end()) {
+      continue;
+    }
+    const FactorSharding& factorSharding = it->second;
+    if (factorSharding.axisRefs.empty() ||
+        !factorSharding.overflowAxes.empty() ||
+        (!axes.empty() && factorSharding.axisRefs != axes)) {
+      return std::nullopt;
+    }
+    axes = factorSharding.axisRefs;
+  }
+  if (axes.empty()) {
+    return std::nullopt;
+  }
+  int64_t axesSize = getTotalAxesSize(axes, mesh);
+
+  auto canMoveTo = [&](int64_t factorIndex) {
+    if (factorIndex == permutationFactor ||
+        !rule.isPassThroughFactor(factorIndex) ||
+        llvm::is_contained(excludedFactors, factorIndex) ||
+        rule.getFactorSize(factorIndex) % axesSize != 0) {
+      return false;
+    }
+    return llvm::all_of(
+        llvm::seq<int64_t>(0, projection.getNumTensors()),
+        [&](int64_t tensorNum) {
+          const FactorIndexToSharding& factorShardings =
+              projection.getTensor(tensorNum).factorIndexToSharding;
+          auto it = factorShardings.find(factorIndex);
+          if (it == factorShardings.end()) {
+            return !factorShardings.contains(permutationFactor);
+          }
+          return factorShardings.contains(permutationFactor) &&
+                 it->second.axisRefs.empty() &&
+                 it->second.overflowAxes.empty();
+        });
+  };
+  std::optional<int64_t> targetFactor;
+  for (int64_t factorIndex = 0; factorIndex < rule.getNumFactors();
+       ++factorIndex) {
+    if (canMoveTo(factorIndex)) {
+      targetFactor = factorIndex;
+      break;
+    }
+  }
+  if (!targetFactor) {
+    return std::nullopt;
+  }
+
+  int64_t replicateBytes = 0;
+  int64_t moveBytes = 0;
+  for (int64_t tensorNum = 0; tensorNum < projection.getNumTensors();
+       ++tensorNum) {
+    if (!projection.getTensor(tensorNum).factorIndexToSharding.contains(
+            permutationFactor)) {
+      continue;
+    }
+    std::optional<int64_t> localBytes =
+        getLocalBytesOfTensor(op, tensorNum, shardings[tensorNum], mesh);
+    if (!localBytes) {
+      return std::nullopt;
+    }
+    // Each device receives all other shards in an all-gather, and all but its
+    // own piece of its shard in an all-to-all. Resharding the replicated
+    // result back is an all-slice, which doesn't communicate.
+    if (tensorNum < projection.getNumOperands()) {
+      replicateBytes += (axesSize - 1) * *localBytes;
+    }
+    moveBytes += *localBytes - *localBytes / axesSize;
+  }
+  LLVM_DEBUG(llvm::dbgs() << "Resolving permutation factor "
+                          << permutationFactor << " of " << op->getName()
+                          << ": replicating moves " << replicateBytes
+                          << " bytes, moving axes to factor " << *targetFactor
+                          << " moves " << moveBytes << " bytes\n");
+  if (moveBytes > replicateBytes) {
+    return std::nullopt;
+  }
+  return AxesMove{*targetFactor, axes};
+}
+
 // Returns the maximum channel ID in `moduleOp` plus one.
 int64_t getNextChannelId(ModuleOp moduleOp) {
   int64_t maxChannelId = 0;
@@ -675,13 +1516,31 @@ struct ShardyResolvePermutationFactorsPass
         return;
       }
 
+      // Dispatch to a parallel prefix if enabled and the op is a cumulative
+      // reduce window.
+      if (auto reduceWindowOp = dyn_cast<stablehlo::ReduceWindowOp>(op);
+          enableParallelPrefix && reduceWindowOp &&
+          succeeded(handleCumulativeReduceWindowOp(reduceWindowOp, state))) {
+        return;
+      }
+
       // Dispatch to HALO exchange if enabled and implemented for the op.
       if (enableHaloExchange) {
-        if (auto reverseOp = dyn_cast<stablehlo::ReverseOp>(op)) {
-          // If HALO exchange failed, fall back to explicit reshards below.
-          if (succeeded(handleReverseOp(reverseOp, state))) {
-            return;
-          }
+        // If HALO exchange failed, fall back to explicit reshards below.
+        LogicalResult result =
+            TypeSwitch<Operation*, LogicalResult>(op)
+                .Case([&](stablehlo::ConvolutionOp convOp) {
+                  return handleConvolutionOp(convOp, state);
+                })
+                .Case([&](stablehlo::ReduceWindowOp reduceWindowOp) {
+                  return handleReduceWindowOp(reduceWindowOp, state);
+                })
+                .Case([&](stablehlo::ReverseOp reverseOp) {
+                  return handleReverseOp(reverseOp, state);
+                })
+                .Default([](Operation*) { return failure(); });
+        if (succeeded(result)) {
+          return;
         }
       }
 
@@ -704,6 +1563,10 @@ struct ShardyResolvePermutationFactorsPass
           ShardingProjection::build(inShardings, outShardings, rule,
                                     meshOp.getMesh(), /*closedIfMissing=*/true);
       UpdateTensorShardings update(op->getNumOperands(), op->getNumResults());
+      SmallVector<TensorShardingAttr> shardings =
+          llvm::to_vector(llvm::concat<TensorShardingAttr>(inShardings,
+                                                           outShardings));
+      SmallVector<int64_t> movedToFactors;
 
       for (int64_t i = 0; i < rule.getNumFactors(); ++i) {
         if (rule.getFactorType(i) != FactorType::kPermutation) {
@@ -717,6 +1580,16 @@ struct ShardyResolvePermutationFactorsPass
           }
         }
 
+        if (movePermutationAxes) {
+          if (std::optional<AxesMove> move = findAxesMove(
+                  op, i, projection, rule, shardings, meshOp.getMesh(),
+                  movedToFactors)) {
+            update |= projection.updateSharding(move->factorIndex, move->axes,
+                                                /*overflowAxes=*/{});
+            movedToFactors.push_back(move->factorIndex);
+          }
+        }
+
         update |=
             projection.updateSharding(i, /*axes=*/{}, /*overflowAxes=*/{});
       }
@@ -0,0 +1,93 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"  // IWYU pragma: keep
+#include "mlir/IR/Block.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
+
+namespace mlir {
+namespace sdy {
+
+#define GEN_PASS_DEF_SCHEDULECOLLECTIVESFOROVERLAPPASS
+#include "shardy/dialect/sdy/transforms/export/passes.h.inc"
+
+namespace {
+
+// Returns true if `op` is a collective that communicates between devices.
+bool isCommunicatingCollective(Operation* op) {
+  return isa<AllGatherOp, AllReduceOp, ReduceScatterOp, AllToAllOp,
+             CollectivePermuteOp>(op);
+}
+
+// Moves each communicating collective in `block` right after the latest of:
+// - the ops in the block that define its operands,
+// - the previous communicating collective in the block, to preserve the order
+//   of collectives,
+// - the previous op in the block that has side effects.
+//
+// If there is no such op, the collective is moved to the start of the block.
+void scheduleCollectivesInBlock(Block& block) {
+  Operation* lastBarrier = nullptr;
+  for (Operation& op : llvm::make_early_inc_range(block)) {
+    if (!isCommunicatingCollective(&op)) {
+      if (!isMemoryEffectFree(&op)) {
+        lastBarrier = &op;
+      }
+      continue;
+    }
+    Operation* insertAfter = lastBarrier;
+    for (Value operand : op.getOperands()) {
+      Operation* defOp = operand.getDefiningOp();
+      if (defOp && defOp->getBlock() == &block &&
+          (!insertAfter || insertAfter->isBeforeInBlock(defOp))) {
+        insertAfter = defOp;
+      }
+    }
+    if (insertAfter) {
+      op.moveAfter(insertAfter);
+    } else {
+      op.moveBefore(&block, block.begin());
+    }
+    lastBarrier = &op;
+  }
+}
+
+struct ScheduleCollectivesForOverlapPass
+    : public impl::ScheduleCollectivesForOverlapPassBase<
+          ScheduleCollectivesForOverlapPass> {
+  using ScheduleCollectivesForOverlapPassBase::
+      ScheduleCollectivesForOverlapPassBase;
+
+  void runOnOperation() final {
+    SmallVector<Block*> blocks;
+    getOperation()->walk([&](Block* block) { blocks.push_back(block); });
+    for (Block* block : blocks) {
+      scheduleCollectivesInBlock(*block);
+    }
+  }
+};
+
+}  // namespace
+
+}  // namespace sdy
+}  // namespace mlir
@@ -0,0 +1,240 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>  // IWYU pragma: keep
+#include <optional>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"  // IWYU pragma: keep
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/export/passes.h"  // IWYU pragma: keep
+
+namespace mlir {
+namespace sdy {
+
+#define GEN_PASS_DEF_SIMPLIFYCOLLECTIVESPASS
+#include "shardy/dialect/sdy/transforms/export/passes.h.inc"
+
+namespace {
+
+// The effect of a chain of all-gathers and all-slices on the axes sharding a
+// single dimension: the suffix `gathered` is removed, and then `sliced` is
+// appended.
+struct DimEffect {
+  SmallVector<AxisRefAttr> gathered;
+  SmallVector<AxisRefAttr> sliced;
+};
+
+using ChainEffect = SmallVector<DimEffect>;
+
+// Returns the effect of `op` if it's an all-gather or an all-slice.
+std::optional<ChainEffect> getEffect(Operation* op) {
+  ChainEffect effect;
+  if (auto allGather = dyn_cast_or_null<AllGatherOp>(op)) {
+    for (AxisRefListAttr axes : allGather.getGatheringAxes()) {
+      effect.push_back({llvm::to_vector(axes.getValue()), {}});
+    }
+    return effect;
+  }
+  if (auto allSlice = dyn_cast_or_null<AllSliceOp>(op)) {
+    for (AxisRefListAttr axes : allSlice.getSlicingAxes()) {
+      effect.push_back({{}, llvm::to_vector(axes.getValue())});
+    }
+    return effect;
+  }
+  return std::nullopt;
+}
+
+// Returns true if `suffix` is a suffix of `axes`.
+bool isSuffix(ArrayRef<AxisRefAttr> suffix, ArrayRef<AxisRefAttr> axes) {
+  return suffix.size() <= axes.size() &&
+         axes.take_back(suffix.size()) == suffix;
+}
+
+// Composes `first` with `second`, which is applied after it, into `first`.
+//
+// The axes gathered by `second` are either a suffix of the axes sliced by
+// `first`, in which case they cancel out, or the latter are a suffix of the
+// former, in which case the remaining prefix is gathered from the axes that
+// `first` didn't gather. Returns false otherwise, e.g., if only a sub-axis of
+// a sliced axis is gathered, since the composition can't be expressed as a
+// pair of axis lists.
+bool compose(DimEffect& first, const DimEffect& second) {
+  if (isSuffix(second.gathered, first.sliced)) {
+    first.sliced.truncate(first.sliced.size() - second.gathered.size());
+  } else if (isSuffix(first.sliced, second.gathered)) {
+    SmallVector<AxisRefAttr> gathered(ArrayRef<AxisRefAttr>(second.gathered)
+                                          .drop_back(first.sliced.size()));
+    gathered.append(first.gathered);
+    first.gathered = std::move(gathered);
+    first.sliced.clear();
+  } else {
+    return false;
+  }
+  first.sliced.append(second.sliced);
+  return true;
+}
+
+ListOfAxisRefListsAttr getAxesPerDim(MLIRContext* context,
+                                     const ChainEffect& effect,
+                                     bool gathered) {
+  return ListOfAxisRefListsAttr::get(
+      context, llvm::map_to_vector(effect, [&](const DimEffect& dim) {
+        return AxisRefListAttr::get(context,
+                                    gathered ? dim.gathered : dim.sliced);
+      }));
+}
+
+// Replaces all uses of `op` with `value`, erases it, and then erases
+// `producer` if it no longer has any uses.
+void replaceAndEraseDeadProducer(Operation* op, Value value,
+                                 Operation* producer, RewriterBase& rewriter) {
+  rewriter.replaceOp(op, value);
+  if (producer && producer->use_empty()) {
+    rewriter.eraseOp(producer);
+  }
+}
+
+// Folds an all-gather or all-slice `op` with the all-gather or all-slice that
+// defines its input, which was already folded with its own producer, if any.
+//
+// If the composed effect is a no-op, `op` is replaced with the input of the
+// producer, even if the producer has other uses. Otherwise, if the producer has
+// no other uses and the composed effect only gathers or only slices, both are
+// replaced with a single collective.
+void foldGatherSliceChain(Operation* op, ChainEffect effect,
+                          RewriterBase& rewriter) {
+  Value input = op->getOperand(0);
+  if (llvm::all_of(effect, [](const DimEffect& dim) {
+        return dim.gathered.empty() && dim.sliced.empty();
+      })) {
+    rewriter.replaceOp(op, input);
+    return;
+  }
+
+  Operation* producer = input.getDefiningOp();
+  std::optional<ChainEffect> producerEffect = getEffect(producer);
+  if (!producerEffect) {
+    return;
+  }
+  for (auto [first, second] : llvm::zip_equal(*producerEffect, effect)) {
+    if (!compose(first, second)) {
+      return;
+    }
+  }
+
+  bool gathers = llvm::any_of(*producerEffect, [](const DimEffect& dim) {
+    return !dim.gathered.empty();
+  });
+  bool slices = llvm::any_of(*producerEffect, [](const DimEffect& dim) {
+    return !dim.sliced.empty();
+  });
+  Value producerInput = producer->getOperand(0);
+  if (!gathers && !slices) {
+    replaceAndEraseDeadProducer(op, producerInput, producer, rewriter);
+    return;
+  }
+  if ((gathers && slices) || !producer->hasOneUse()) {
+    return;
+  }
+
+  rewriter.setInsertionPoint(op);
+  MLIRContext* context = op->getContext();
+  auto outSharding = cast<CollectiveOpInterface>(op).getOutSharding();
+  Value newResult =
+      gathers ? AllGatherOp::create(
+                    rewriter, op->getLoc(), producerInput,
+                    getAxesPerDim(context, *producerEffect, /*gathered=*/true),
+                    outSharding)
+                    .getResult()
+              : AllSliceOp::create(
+                    rewriter, op->getLoc(), producerInput,
+                    getAxesPerDim(context, *producerEffect, /*gathered=*/false),
+                    outSharding)
+                    .getResult();
+  replaceAndEraseDeadProducer(op, newResult, producer, rewriter);
+}
+
+// Folds `collectivePermute` with the collective permute that defines its input,
+// if it has no other uses, and removes it if it doesn't change the sharding of
+// its (new) input.
+void foldCollectivePermuteChain(CollectivePermuteOp collectivePermute,
+                                RewriterBase& rewriter) {
+  auto producer =
+      collectivePermute.getTensor().getDefiningOp<CollectivePermuteOp>();
+  if (producer && producer->hasOneUse()) {
+    rewriter.modifyOpInPlace(collectivePermute, [&]() {
+      collectivePermute.getTensorMutable().assign(producer.getTensor());
+    });
+    rewriter.eraseOp(producer);
+  }
+  Value input = collectivePermute.getTensor();
+  TensorShardingAttr inputSharding = getSharding(input);
+  if (inputSharding &&
+      inputSharding.isEquivalent(collectivePermute.getOutSharding())) {
+    rewriter.replaceOp(collectivePermute, input);
+  }
+}
+
+// Fuses `allToAll` with the all-to-all that defines its input, if it has no
+// other uses and their parameters don't overlap.
+void foldAllToAllChain(AllToAllOp allToAll, RewriterBase& rewriter) {
+  auto producer = allToAll.getTensor().getDefiningOp<AllToAllOp>();
+  if (!producer || !producer->hasOneUse() ||
+      producer.getParams().overlaps(allToAll.getParams())) {
+    return;
+  }
+  rewriter.modifyOpInPlace(allToAll, [&]() {
+    allToAll.setParamsAttr(
+        producer.getParams().combineAndSort(allToAll.getParams()));
+    allToAll.getTensorMutable().assign(producer.getTensor());
+  });
+  rewriter.eraseOp(producer);
+}
+
+struct SimplifyCollectivesPass
+    : public impl::SimplifyCollectivesPassBase<SimplifyCollectivesPass> {
+  using SimplifyCollectivesPassBase::SimplifyCollectivesPassBase;
+
+  void runOnOperation() final {
+    IRRewriter rewriter(&getContext());
+    // Producers are visited before their consumers, so the input of each
+    // collective is already the end of a folded chain, and each collective is
+    // folded at most once.
+    getOperation().walk([&](Operation* op) {
+      if (std::optional<ChainEffect> effect = getEffect(op)) {
+        foldGatherSliceChain(op, *effect, rewriter);
+      } else if (auto collectivePermute = dyn_cast<CollectivePermuteOp>(op)) {
+        foldCollectivePermuteChain(collectivePermute, rewriter);
+      } else if (auto allToAll = dyn_cast<AllToAllOp>(op)) {
+        foldAllToAllChain(allToAll, rewriter);
+      }
+    });
+  }
+};
+
+}  // namespace
+
+}  // namespace sdy
+}  // namespace mlir
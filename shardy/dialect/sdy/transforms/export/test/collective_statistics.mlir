@@ -0,0 +1,85 @@
+// RUN: sdy_opt %s -sdy-collective-statistics 2>&1 | FileCheck %s
+
+sdy.mesh @mesh = <["x"=2, "y"=2]>
+
+// CHECK:      "total_count": 7,
+// CHECK-NEXT: "total_bytes": 1664,
+// CHECK-NEXT: "collectives": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "function": "main",
+// CHECK-NEXT:     "kind": "sdy.all_gather",
+// CHECK-NEXT:     "axes": [
+// CHECK-NEXT:       "x"
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "count": 1,
+// CHECK-NEXT:     "bytes": 256
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "function": "main",
+// CHECK-NEXT:     "kind": "sdy.all_gather",
+// CHECK-NEXT:     "axes": [
+// CHECK-NEXT:       "y"
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "count": 1,
+// CHECK-NEXT:     "bytes": 512
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "function": "main",
+// CHECK-NEXT:     "kind": "sdy.all_reduce",
+// CHECK-NEXT:     "axes": [
+// CHECK-NEXT:       "x"
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "count": 2,
+// CHECK-NEXT:     "bytes": 256
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "function": "main",
+// CHECK-NEXT:     "kind": "sdy.reduce_scatter",
+// CHECK-NEXT:     "axes": [
+// CHECK-NEXT:       "x"
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "count": 1,
+// CHECK-NEXT:     "bytes": 128
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "function": "other",
+// CHECK-NEXT:     "kind": "sdy.all_to_all",
+// CHECK-NEXT:     "axes": [
+// CHECK-NEXT:       "x"
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "count": 1,
+// CHECK-NEXT:     "bytes": 256
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "function": "other",
+// CHECK-NEXT:     "kind": "sdy.collective_permute",
+// CHECK-NEXT:     "axes": [
+// CHECK-NEXT:       "y"
+// CHECK-NEXT:     ],
+// CHECK-NEXT:     "count": 1,
+// CHECK-NEXT:     "bytes": 256
+// CHECK-NEXT:   }
+// CHECK-NEXT: ]
+
+// The module is left unchanged.
+// CHECK-LABEL: func @main
+// CHECK-NEXT:    sdy.all_gather [{"x"}, {}] %arg0
+func.func @main(%arg0: tensor<16x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {"y"}]>},
+                %arg1: tensor<16x2xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"y"}, {}]>})
+    -> (tensor<16x8xf32>, tensor<16x2xf32>, tensor<16x2xf32>, tensor<16x2xf32>) {
+  %0 = sdy.all_gather [{"x"}, {}] %arg0 out_sharding=<@mesh, [{}, {"y"}]> : tensor<16x8xf32>
+  %1 = sdy.all_gather [{}, {"y"}] %0 out_sharding=<@mesh, [{}, {}]> : tensor<16x8xf32>
+  // All-slices don't communicate and are ignored.
+  %2 = sdy.all_slice [{"x"}, {}] %1 out_sharding=<@mesh, [{"x"}, {}]> : tensor<16x8xf32>
+  %3 = sdy.all_reduce {"x"} %arg1 out_sharding=<@mesh, [{"y"}, {}]> : tensor<16x2xf32>
+  %4 = sdy.all_reduce {"x"} %arg1 out_sharding=<@mesh, [{"y"}, {}]> : tensor<16x2xf32>
+  %5 = sdy.reduce_scatter [{}, {"x"}] %arg1 out_sharding=<@mesh, [{"y"}, {"x"}]> : tensor<16x2xf32>
+  return %2, %3, %4, %5 : tensor<16x8xf32>, tensor<16x2xf32>, tensor<16x2xf32>, tensor<16x2xf32>
+}
+
+func.func @other(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>})
+    -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  %0 = sdy.all_to_all [{"x"}: 0->1] %arg0 out_sharding=<@mesh, [{}, {"x"}]> : tensor<8x8xf32>
+  %1 = sdy.collective_permute %arg0 out_sharding=<@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  return %0, %1 : tensor<8x8xf32>, tensor<8x8xf32>
+}
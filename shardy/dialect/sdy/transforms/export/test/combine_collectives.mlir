@@ -0,0 +1,114 @@
+// RUN: sdy_opt %s -split-input-file -sdy-combine-collectives | FileCheck %s
+// RUN: sdy_opt %s -split-input-file -sdy-combine-collectives='threshold-bytes=32' | FileCheck %s --check-prefix=THRESHOLD
+
+// CHECK-LABEL: func @independent_all_reduces
+// THRESHOLD-LABEL: func @independent_all_reduces
+func.func @independent_all_reduces(%arg0: tensor<8xf32>, %arg1: tensor<4xf32>) -> (tensor<8xf32>, tensor<4xf32>) {
+  // CHECK-NEXT: %[[ALL_REDUCE:.*]]:2 = "stablehlo.all_reduce"(%arg0, %arg1)
+  // CHECK-SAME{LITERAL}: channel_handle = #stablehlo.channel_handle<handle = 1, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>
+  // CHECK: stablehlo.add
+  // CHECK: }) : (tensor<8xf32>, tensor<4xf32>) -> (tensor<8xf32>, tensor<4xf32>)
+  // CHECK-NEXT: return %[[ALL_REDUCE]]#0, %[[ALL_REDUCE]]#1
+
+  // The combined collective would exceed the threshold.
+  // THRESHOLD-NEXT: %[[ALL_REDUCE_0:.*]] = "stablehlo.all_reduce"(%arg0)
+  // THRESHOLD: %[[ALL_REDUCE_1:.*]] = "stablehlo.all_reduce"(%arg1)
+  // THRESHOLD: return %[[ALL_REDUCE_0]], %[[ALL_REDUCE_1]]
+  %0 = "stablehlo.all_reduce"(%arg0) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %2 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %2 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 1, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  %1 = "stablehlo.all_reduce"(%arg1) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %2 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %2 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 2, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<4xf32>) -> tensor<4xf32>
+  return %0, %1 : tensor<8xf32>, tensor<4xf32>
+}
+
+// -----
+
+// The combined all-reduce is placed at the position of the last all-reduce,
+// which is still before the first use.
+// CHECK-LABEL: func @all_reduces_interleaved_with_other_ops
+func.func @all_reduces_interleaved_with_other_ops(%arg0: tensor<8xf32>, %arg1: tensor<8xf32>) -> tensor<8xf32> {
+  // CHECK-NEXT: %[[NEGATE:.*]] = stablehlo.negate %arg1
+  // CHECK-NEXT: %[[ALL_REDUCE:.*]]:2 = "stablehlo.all_reduce"(%arg0, %[[NEGATE]])
+  // CHECK: %[[ADD:.*]] = stablehlo.add %[[ALL_REDUCE]]#0, %[[ALL_REDUCE]]#1
+  // CHECK-NEXT: return %[[ADD]]
+  %0 = "stablehlo.all_reduce"(%arg0) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %4 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %4 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 1, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  %1 = stablehlo.negate %arg1 : tensor<8xf32>
+  %2 = "stablehlo.all_reduce"(%1) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %4 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %4 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 2, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  %3 = stablehlo.add %0, %2 : tensor<8xf32>
+  return %3 : tensor<8xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @dependent_all_reduces
+func.func @dependent_all_reduces(%arg0: tensor<8xf32>) -> tensor<8xf32> {
+  // CHECK-NEXT: %[[ALL_REDUCE_0:.*]] = "stablehlo.all_reduce"(%arg0)
+  // CHECK: %[[NEGATE:.*]] = stablehlo.negate %[[ALL_REDUCE_0]]
+  // CHECK-NEXT: %[[ALL_REDUCE_1:.*]] = "stablehlo.all_reduce"(%[[NEGATE]])
+  // CHECK: return %[[ALL_REDUCE_1]]
+  %0 = "stablehlo.all_reduce"(%arg0) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %3 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %3 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 1, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  %1 = stablehlo.negate %0 : tensor<8xf32>
+  %2 = "stablehlo.all_reduce"(%1) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %3 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %3 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 2, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  return %2 : tensor<8xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @all_reduces_with_different_replica_groups_or_computations
+func.func @all_reduces_with_different_replica_groups_or_computations(%arg0: tensor<8xf32>, %arg1: tensor<8xf32>, %arg2: tensor<8xf32>) -> (tensor<8xf32>, tensor<8xf32>, tensor<8xf32>) {
+  // CHECK-NEXT: "stablehlo.all_reduce"(%arg0)
+  // CHECK: "stablehlo.all_reduce"(%arg1)
+  // CHECK: "stablehlo.all_reduce"(%arg2)
+  %0 = "stablehlo.all_reduce"(%arg0) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %3 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %3 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 1, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  %1 = "stablehlo.all_reduce"(%arg1) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %3 = stablehlo.add %lhs, %rhs : tensor<f32>
+    stablehlo.return %3 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 2, type = 1>, replica_groups = dense<[[0], [1]]> : tensor<2x1xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  %2 = "stablehlo.all_reduce"(%arg2) ({
+  ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+    %3 = stablehlo.maximum %lhs, %rhs : tensor<f32>
+    stablehlo.return %3 : tensor<f32>
+  }) {channel_handle = #stablehlo.channel_handle<handle = 3, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<8xf32>) -> tensor<8xf32>
+  return %0, %1, %2 : tensor<8xf32>, tensor<8xf32>, tensor<8xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @independent_all_gathers
+func.func @independent_all_gathers(%arg0: tensor<4x8xf32>, %arg1: tensor<4x2xbf16>) -> (tensor<8x8xf32>, tensor<8x2xbf16>) {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]]:2 = "stablehlo.all_gather"(%arg0, %arg1)
+  // CHECK-SAME: all_gather_dim = 0 : i64
+  // CHECK-SAME{LITERAL}: channel_handle = #stablehlo.channel_handle<handle = 1, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>
+  // CHECK-SAME: (tensor<4x8xf32>, tensor<4x2xbf16>) -> (tensor<8x8xf32>, tensor<8x2xbf16>)
+  // CHECK-NEXT: return %[[ALL_GATHER]]#0, %[[ALL_GATHER]]#1
+  %0 = "stablehlo.all_gather"(%arg0) {all_gather_dim = 0 : i64, channel_handle = #stablehlo.channel_handle<handle = 1, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<4x8xf32>) -> tensor<8x8xf32>
+  %1 = "stablehlo.all_gather"(%arg1) {all_gather_dim = 0 : i64, channel_handle = #stablehlo.channel_handle<handle = 2, type = 1>, replica_groups = dense<[[0, 1]]> : tensor<1x2xi64>, use_global_device_ids} : (tensor<4x2xbf16>) -> tensor<8x2xbf16>
+  return %0, %1 : tensor<8x8xf32>, tensor<8x2xbf16>
+}
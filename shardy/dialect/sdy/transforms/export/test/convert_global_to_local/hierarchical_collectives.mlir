@@ -0,0 +1,90 @@
+// RUN: sdy_opt %s -sdy-convert-global-to-local='hierarchical-collectives=true' | FileCheck %s
+
+sdy.mesh @mesh = <["dcn"=2, "ici"=4]> {sdy.axis_bandwidths = {dcn = 1.0, ici = 10.0}}
+sdy.mesh @mesh_no_bandwidths = <["dcn"=2, "ici"=4]>
+
+// CHECK-LABEL: func @all_reduce_across_levels
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<16x8xf32>) -> tensor<16x8xf32> {
+func.func @all_reduce_across_levels(%arg0: tensor<16x8xf32>) -> tensor<16x8xf32> {
+  // CHECK-NEXT: %[[FLAT:.*]] = stablehlo.reshape %[[ARG0]] : (tensor<16x8xf32>) -> tensor<128xf32>
+  // CHECK-NEXT: %[[REDUCE_SCATTER:.*]] = "stablehlo.reduce_scatter"(%[[FLAT]])
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 1, 2, 3], [4, 5, 6, 7]]>
+  // CHECK-SAME: scatter_dimension = 0 : i64
+  // CHECK-SAME: use_global_device_ids
+  // CHECK:      (tensor<128xf32>) -> tensor<32xf32>
+  // CHECK-NEXT: %[[ALL_REDUCE:.*]] = "stablehlo.all_reduce"(%[[REDUCE_SCATTER]])
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 4], [1, 5], [2, 6], [3, 7]]>
+  // CHECK-SAME: use_global_device_ids
+  // CHECK:      (tensor<32xf32>) -> tensor<32xf32>
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = "stablehlo.all_gather"(%[[ALL_REDUCE]])
+  // CHECK-SAME: all_gather_dim = 0 : i64
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 1, 2, 3], [4, 5, 6, 7]]>
+  // CHECK-SAME: use_global_device_ids
+  // CHECK-SAME: (tensor<32xf32>) -> tensor<128xf32>
+  // CHECK-NEXT: %[[RESULT:.*]] = stablehlo.reshape %[[ALL_GATHER]] : (tensor<128xf32>) -> tensor<16x8xf32>
+  // CHECK-NEXT: return %[[RESULT]] : tensor<16x8xf32>
+  %0 = sdy.all_reduce {"dcn", "ici"} %arg0 out_sharding=<@mesh, [{}, {}]> : tensor<16x8xf32>
+  return %0 : tensor<16x8xf32>
+}
+
+// CHECK-LABEL: func @all_reduce_single_level
+func.func @all_reduce_single_level(%arg0: tensor<16x8xf32>) -> tensor<16x8xf32> {
+  // CHECK-NEXT: "stablehlo.all_reduce"(%arg0)
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 1, 2, 3], [4, 5, 6, 7]]>
+  // CHECK-NOT: stablehlo.reduce_scatter
+  %0 = sdy.all_reduce {"ici"} %arg0 out_sharding=<@mesh, [{}, {}]> : tensor<16x8xf32>
+  return %0 : tensor<16x8xf32>
+}
+
+// CHECK-LABEL: func @all_reduce_indivisible_num_elements
+func.func @all_reduce_indivisible_num_elements(%arg0: tensor<3x5xf32>) -> tensor<3x5xf32> {
+  // CHECK-NEXT: "stablehlo.all_reduce"(%arg0)
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 1, 2, 3, 4, 5, 6, 7]]>
+  // CHECK-NOT: stablehlo.reduce_scatter
+  %0 = sdy.all_reduce {"dcn", "ici"} %arg0 out_sharding=<@mesh, [{}, {}]> : tensor<3x5xf32>
+  return %0 : tensor<3x5xf32>
+}
+
+// CHECK-LABEL: func @all_reduce_mesh_without_bandwidths
+func.func @all_reduce_mesh_without_bandwidths(%arg0: tensor<16x8xf32>) -> tensor<16x8xf32> {
+  // CHECK-NEXT: "stablehlo.all_reduce"(%arg0)
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 1, 2, 3, 4, 5, 6, 7]]>
+  // CHECK-NOT: stablehlo.reduce_scatter
+  %0 = sdy.all_reduce {"dcn", "ici"} %arg0 out_sharding=<@mesh_no_bandwidths, [{}, {}]> : tensor<16x8xf32>
+  return %0 : tensor<16x8xf32>
+}
+
+// CHECK-LABEL: func @all_to_all_across_levels
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<1x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"dcn", "ici"}, {}]>})
+// CHECK-SAME: -> (tensor<8x2xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"dcn", "ici"}]>})
+func.func @all_to_all_across_levels(%arg0: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"dcn", "ici"}, {}]>})
+    -> (tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"dcn", "ici"}]>}) {
+  // CHECK-NEXT: %[[SPLIT:.*]] = stablehlo.reshape %[[ARG0]] : (tensor<1x16xf32>) -> tensor<1x1x1x2x4x2xf32>
+  // CHECK-NEXT: %[[FAST:.*]] = "stablehlo.all_to_all"(%[[SPLIT]])
+  // CHECK-SAME: concat_dimension = 1 : i64
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 1, 2, 3], [4, 5, 6, 7]]>
+  // CHECK-SAME: split_count = 4 : i64
+  // CHECK-SAME: split_dimension = 4 : i64
+  // CHECK-SAME: (tensor<1x1x1x2x4x2xf32>) -> tensor<1x4x1x2x1x2xf32>
+  // CHECK-NEXT: %[[SLOW:.*]] = "stablehlo.all_to_all"(%[[FAST]])
+  // CHECK-SAME: concat_dimension = 0 : i64
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 4], [1, 5], [2, 6], [3, 7]]>
+  // CHECK-SAME: split_count = 2 : i64
+  // CHECK-SAME: split_dimension = 3 : i64
+  // CHECK-SAME: (tensor<1x4x1x2x1x2xf32>) -> tensor<2x4x1x1x1x2xf32>
+  // CHECK-NEXT: %[[RESULT:.*]] = stablehlo.reshape %[[SLOW]] : (tensor<2x4x1x1x1x2xf32>) -> tensor<8x2xf32>
+  // CHECK-NEXT: return %[[RESULT]] : tensor<8x2xf32>
+  %0 = sdy.all_to_all [{"dcn", "ici"}: 0->1] %arg0 out_sharding=<@mesh, [{}, {"dcn", "ici"}]> : tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
+
+// CHECK-LABEL: func @all_to_all_single_level
+func.func @all_to_all_single_level(%arg0: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"ici"}, {}]>})
+    -> (tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"ici"}]>}) {
+  // CHECK-NEXT: %[[RESULT:.*]] = "stablehlo.all_to_all"(%arg0)
+  // CHECK-SAME: split_count = 4 : i64
+  // CHECK-SAME: (tensor<2x16xf32>) -> tensor<8x4xf32>
+  // CHECK-NEXT: return %[[RESULT]]
+  %0 = sdy.all_to_all [{"ici"}: 0->1] %arg0 out_sharding=<@mesh, [{}, {"ici"}]> : tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
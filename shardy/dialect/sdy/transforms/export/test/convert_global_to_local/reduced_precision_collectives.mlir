@@ -0,0 +1,69 @@
+// RUN: sdy_opt %s -sdy-convert-global-to-local='reduced-precision-collective-threshold-bytes=64' | FileCheck %s
+
+sdy.mesh @mesh_2_4 = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @all_reduce_above_threshold
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<16x16xf32> {{.*}})
+func.func @all_reduce_above_threshold(%arg0: tensor<16x32xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {"y":(2)2}]>})
+  -> (tensor<16x32xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {"y":(2)2}]>}) {
+  // CHECK-NEXT: %[[CONVERT:.*]] = stablehlo.convert %[[ARG0]] : (tensor<16x16xf32>) -> tensor<16x16xbf16>
+  // CHECK-NEXT: %[[ALL_REDUCE:.*]] = "stablehlo.all_reduce"(%[[CONVERT]])
+  // CHECK: ^bb0(%[[ACC:.*]]: tensor<bf16>, %[[UPD:.*]]: tensor<bf16>):
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %[[ACC]], %[[UPD]] : tensor<bf16>
+  // CHECK-NEXT: stablehlo.return %[[ADD]] : tensor<bf16>
+  // CHECK-NEXT: }) : (tensor<16x16xbf16>) -> tensor<16x16xbf16>
+  // CHECK-NEXT: %[[RESULT:.*]] = stablehlo.convert %[[ALL_REDUCE]] : (tensor<16x16xbf16>) -> tensor<16x16xf32>
+  // CHECK-NEXT: return %[[RESULT]] : tensor<16x16xf32>
+  %0 = sdy.all_reduce {"y":(1)2} %arg0 out_sharding=<@mesh_2_4, [{}, {"y":(2)2}]> : tensor<16x32xf32>
+  return %0 : tensor<16x32xf32>
+}
+
+// CHECK-LABEL: func @all_reduce_below_threshold
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<2x2xf32> {{.*}})
+func.func @all_reduce_below_threshold(%arg0: tensor<4x2xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>})
+  -> (tensor<4x2xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>}) {
+  // CHECK-NOT: stablehlo.convert
+  // CHECK: %[[ALL_REDUCE:.*]] = "stablehlo.all_reduce"(%[[ARG0]])
+  // CHECK: }) : (tensor<2x2xf32>) -> tensor<2x2xf32>
+  // CHECK-NEXT: return %[[ALL_REDUCE]] : tensor<2x2xf32>
+  %0 = sdy.all_reduce {"y"} %arg0 out_sharding=<@mesh_2_4, [{"x"}, {}]> : tensor<4x2xf32>
+  return %0 : tensor<4x2xf32>
+}
+
+// CHECK-LABEL: func @all_reduce_not_f32
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<16x16xbf16> {{.*}})
+func.func @all_reduce_not_f32(%arg0: tensor<16x32xbf16> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {"y":(2)2}]>})
+  -> (tensor<16x32xbf16> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {"y":(2)2}]>}) {
+  // CHECK-NOT: stablehlo.convert
+  // CHECK: %[[ALL_REDUCE:.*]] = "stablehlo.all_reduce"(%[[ARG0]])
+  // CHECK: }) : (tensor<16x16xbf16>) -> tensor<16x16xbf16>
+  // CHECK-NEXT: return %[[ALL_REDUCE]] : tensor<16x16xbf16>
+  %0 = sdy.all_reduce {"y":(1)2} %arg0 out_sharding=<@mesh_2_4, [{}, {"y":(2)2}]> : tensor<16x32xbf16>
+  return %0 : tensor<16x32xbf16>
+}
+
+// CHECK-LABEL: func @reduce_scatter_above_threshold
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<2x8xf32> {{.*}})
+func.func @reduce_scatter_above_threshold(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"y"}, {}]>})
+    -> (tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"y"}, {"x"}]>}) {
+  // CHECK-NEXT: %[[CONVERT:.*]] = stablehlo.convert %[[ARG0]] : (tensor<2x8xf32>) -> tensor<2x8xbf16>
+  // CHECK-NEXT: %[[RS:.*]] = "stablehlo.reduce_scatter"(%[[CONVERT]])
+  // CHECK: ^bb0(%[[ACC:.*]]: tensor<bf16>, %[[UPD:.*]]: tensor<bf16>):
+  // CHECK: }) : (tensor<2x8xbf16>) -> tensor<2x4xbf16>
+  // CHECK-NEXT: %[[RESULT:.*]] = stablehlo.convert %[[RS]] : (tensor<2x4xbf16>) -> tensor<2x4xf32>
+  // CHECK-NEXT: return %[[RESULT]] : tensor<2x4xf32>
+  %0 = sdy.reduce_scatter [{}, {"x"}] %arg0 out_sharding=<@mesh_2_4, [{"y"}, {"x"}]> : tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @reduce_scatter_below_threshold
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<2x2xf32> {{.*}})
+func.func @reduce_scatter_below_threshold(%arg0: tensor<4x2xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>})
+    -> (tensor<4x2xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {"y":(1)2}]>}) {
+  // CHECK-NOT: stablehlo.convert
+  // CHECK: %[[RS:.*]] = "stablehlo.reduce_scatter"(%[[ARG0]])
+  // CHECK: }) : (tensor<2x2xf32>) -> tensor<2x1xf32>
+  // CHECK-NEXT: return %[[RS]] : tensor<2x1xf32>
+  %0 = sdy.reduce_scatter [{}, {"y":(1)2}] %arg0 out_sharding=<@mesh_2_4, [{"x"}, {"y":(1)2}]> : tensor<4x2xf32>
+  return %0 : tensor<4x2xf32>
+}
@@ -46,3 +46,38 @@ func.func @unsharded_dense() -> (tensor<4x2xi32> {sdy.sharding = #sdy.sharding<@
   // CHECK-NEXT: return %[[CST]] : tensor<4x2xi32>
   return %0 : tensor<4x2xi32>
 }
+
+// CHECK-LABEL: func.func @sharded_iota_like_on_sharded_dim
+// CHECK-SAME:    -> (tensor<2x4xi32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>})
+func.func @sharded_iota_like_on_sharded_dim() -> (tensor<4x4xi32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>}) {
+  // CHECK-NEXT: %[[LOCAL_IOTA:.*]] = stablehlo.iota dim = 0 : tensor<2x4xi32>
+  // CHECK-NEXT: %[[PID:.*]] = stablehlo.partition_id : tensor<ui32>
+  // CHECK-NEXT: %[[PID_I64:.*]] = stablehlo.convert %[[PID]] : (tensor<ui32>) -> tensor<i64>
+  // CHECK-NEXT: %[[TABLE:.*]] = stablehlo.constant dense<[0, 0, 0, 0, 2, 2, 2, 2]> : tensor<8xi64>
+  // CHECK-NEXT: %[[SLICE:.*]] = stablehlo.dynamic_slice %[[TABLE]], %[[PID_I64]], sizes = [1] : (tensor<8xi64>, tensor<i64>) -> tensor<1xi64>
+  // CHECK-NEXT: %[[OFFSET_I64:.*]] = stablehlo.reshape %[[SLICE]] : (tensor<1xi64>) -> tensor<i64>
+  // CHECK-NEXT: %[[OFFSET_I32:.*]] = stablehlo.convert %[[OFFSET_I64]] : (tensor<i64>) -> tensor<i32>
+  // CHECK-NEXT: %[[BCAST:.*]] = stablehlo.broadcast_in_dim %[[OFFSET_I32]], dims = [] : (tensor<i32>) -> tensor<2x4xi32>
+  // CHECK-NEXT: %[[RES:.*]] = stablehlo.add %[[LOCAL_IOTA]], %[[BCAST]] : tensor<2x4xi32>
+  %0 = sdy.constant {sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{"x"}, {}]>]>} dense<[[0, 0, 0, 0], [1, 1, 1, 1], [2, 2, 2, 2], [3, 3, 3, 3]]> : tensor<4x4xi32>
+  // CHECK-NEXT: return %[[RES]] : tensor<2x4xi32>
+  return %0 : tensor<4x4xi32>
+}
+
+// CHECK-LABEL: func.func @sharded_iota_like_on_unsharded_dim
+// CHECK-SAME:    -> (tensor<1x4xi64> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"y"}, {}]>})
+func.func @sharded_iota_like_on_unsharded_dim() -> (tensor<4x4xi64> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"y"}, {}]>}) {
+  // CHECK-NEXT: %[[LOCAL_IOTA:.*]] = stablehlo.iota dim = 1 : tensor<1x4xi64>
+  %0 = sdy.constant {sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{"y"}, {}]>]>} dense<[[0, 1, 2, 3], [0, 1, 2, 3], [0, 1, 2, 3], [0, 1, 2, 3]]> : tensor<4x4xi64>
+  // CHECK-NEXT: return %[[LOCAL_IOTA]] : tensor<1x4xi64>
+  return %0 : tensor<4x4xi64>
+}
+
+// CHECK-LABEL: func.func @sharded_non_iota_int_constant_is_sliced
+func.func @sharded_non_iota_int_constant_is_sliced() -> (tensor<4xi32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}]>}) {
+  // CHECK-NOT: stablehlo.iota
+  // CHECK: %[[GLOBAL_CST:.*]] = stablehlo.constant dense<[0, 1, 3, 2]> : tensor<4xi32>
+  // CHECK: stablehlo.dynamic_slice %[[GLOBAL_CST]]
+  %0 = sdy.constant {sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{"x"}]>]>} dense<[0, 1, 3, 2]> : tensor<4xi32>
+  return %0 : tensor<4xi32>
+}
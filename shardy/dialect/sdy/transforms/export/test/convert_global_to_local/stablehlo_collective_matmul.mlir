@@ -0,0 +1,74 @@
+// RUN: sdy_opt %s -split-input-file --sdy-convert-global-to-local='collective-matmul-threshold-bytes=1024' | FileCheck %s
+
+sdy.mesh @mesh_2_4 = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @all_gather_non_contracting_dim
+// CHECK-SAME:    (%[[ARG0:.*]]: tensor<16x8xf32> {{.*}}, %[[ARG1:.*]]: tensor<8x16xf32> {{.*}})
+func.func @all_gather_non_contracting_dim(
+  %arg0: tensor<64x8xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"y"}, {}]>},
+  %arg1: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>})
+  -> (tensor<64x16xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>}) {
+  // CHECK-NOT: stablehlo.all_gather
+  // CHECK:      %[[ZERO:.*]] = stablehlo.constant dense<0.000000e+00> : tensor<64x16xf32>
+  // CHECK:      %[[PERMUTE_0:.*]] = "stablehlo.collective_permute"(%[[ARG0]])
+  // CHECK-SAME{LITERAL}: source_target_pairs = dense<[[0, 3], [1, 0], [2, 1], [3, 2], [4, 7], [5, 4], [6, 5], [7, 6]]>
+  // CHECK:      %[[DOT_0:.*]] = stablehlo.dot_general %[[ARG0]], %[[ARG1]], contracting_dims = [1] x [0]
+  // CHECK-SAME:   (tensor<16x8xf32>, tensor<8x16xf32>) -> tensor<16x16xf32>
+  // CHECK:      stablehlo.constant dense<[0, 16, 32, 48, 0, 16, 32, 48]>
+  // CHECK:      %[[UPDATE_0:.*]] = stablehlo.dynamic_update_slice %[[ZERO]], %[[DOT_0]]
+  // CHECK:      %[[PERMUTE_1:.*]] = "stablehlo.collective_permute"(%[[PERMUTE_0]])
+  // CHECK:      %[[DOT_1:.*]] = stablehlo.dot_general %[[PERMUTE_0]], %[[ARG1]]
+  // CHECK:      stablehlo.constant dense<[16, 32, 48, 0, 16, 32, 48, 0]>
+  // CHECK:      %[[UPDATE_1:.*]] = stablehlo.dynamic_update_slice %[[UPDATE_0]], %[[DOT_1]]
+  // CHECK:      %[[PERMUTE_2:.*]] = "stablehlo.collective_permute"(%[[PERMUTE_1]])
+  // CHECK:      %[[DOT_2:.*]] = stablehlo.dot_general %[[PERMUTE_1]], %[[ARG1]]
+  // CHECK:      %[[UPDATE_2:.*]] = stablehlo.dynamic_update_slice %[[UPDATE_1]], %[[DOT_2]]
+  // CHECK-NOT:  stablehlo.collective_permute
+  // CHECK:      %[[DOT_3:.*]] = stablehlo.dot_general %[[PERMUTE_2]], %[[ARG1]]
+  // CHECK:      stablehlo.constant dense<[48, 0, 16, 32, 48, 0, 16, 32]>
+  // CHECK:      %[[UPDATE_3:.*]] = stablehlo.dynamic_update_slice %[[UPDATE_2]], %[[DOT_3]]
+  // CHECK:      return %[[UPDATE_3]] : tensor<64x16xf32>
+  %0 = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<64x8xf32>
+  %1 = stablehlo.dot_general %0, %arg1, contracting_dims = [1] x [0]
+    {sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{}, {}]>]>}
+  : (tensor<64x8xf32>, tensor<8x16xf32>) -> tensor<64x16xf32>
+  return %1 : tensor<64x16xf32>
+}
+
+// -----
+
+sdy.mesh @mesh_2_4 = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @below_threshold
+func.func @below_threshold(
+  %arg0: tensor<8x4xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"y"}, {}]>},
+  %arg1: tensor<4x4xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>})
+  -> (tensor<8x4xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>}) {
+  // CHECK:     %[[GATHER:.*]] = "stablehlo.all_gather"
+  // CHECK-NOT: stablehlo.collective_permute
+  // CHECK:     stablehlo.dot_general %[[GATHER]]
+  %0 = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<8x4xf32>
+  %1 = stablehlo.dot_general %0, %arg1, contracting_dims = [1] x [0]
+    {sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{}, {}]>]>}
+  : (tensor<8x4xf32>, tensor<4x4xf32>) -> tensor<8x4xf32>
+  return %1 : tensor<8x4xf32>
+}
+
+// -----
+
+sdy.mesh @mesh_2_4 = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @all_gather_contracting_dim
+func.func @all_gather_contracting_dim(
+  %arg0: tensor<16x32xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {"y"}]>},
+  %arg1: tensor<32x16xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>})
+  -> (tensor<16x16xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>}) {
+  // CHECK:     %[[GATHER:.*]] = "stablehlo.all_gather"
+  // CHECK-NOT: stablehlo.collective_permute
+  // CHECK:     stablehlo.dot_general %[[GATHER]]
+  %0 = sdy.all_gather [{}, {"y"}] %arg0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<16x32xf32>
+  %1 = stablehlo.dot_general %0, %arg1, contracting_dims = [1] x [0]
+    {sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{}, {}]>]>}
+  : (tensor<16x32xf32>, tensor<32x16xf32>) -> tensor<16x16xf32>
+  return %1 : tensor<16x16xf32>
+}
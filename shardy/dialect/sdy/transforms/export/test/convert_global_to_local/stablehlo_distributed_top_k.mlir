@@ -0,0 +1,73 @@
+// RUN: sdy_opt %s -split-input-file --sdy-convert-global-to-local='distributed-top-k=true' | FileCheck %s
+
+sdy.mesh @mesh_2_4 = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @top_k_of_all_gathered_operand
+// CHECK-SAME:    (%[[ARG0:.*]]: tensor<4x8xf32> {{.*}})
+func.func @top_k_of_all_gathered_operand(
+  %arg0: tensor<4x32xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {"y"}]>})
+  -> (tensor<4x2xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>},
+      tensor<4x2xi32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>}) {
+  // CHECK:      %[[LOCAL_TOP_K:.*]]:2 = stablehlo.custom_call @mhlo.topk(%[[ARG0]])
+  // CHECK-SAME:   (tensor<4x8xf32>) -> (tensor<4x2xf32>, tensor<4x2xi32>)
+  // CHECK:      stablehlo.constant dense<[0, 8, 16, 24, 0, 8, 16, 24]>
+  // CHECK:      %[[OFFSET:.*]] = stablehlo.convert %{{.*}} : (tensor<i64>) -> tensor<i32>
+  // CHECK:      %[[BROADCAST:.*]] = stablehlo.broadcast_in_dim %[[OFFSET]], dims = [] : (tensor<i32>) -> tensor<4x2xi32>
+  // CHECK:      %[[GLOBAL_INDICES:.*]] = stablehlo.add %[[LOCAL_TOP_K]]#1, %[[BROADCAST]]
+  // CHECK:      %[[GATHER:.*]]:2 = "stablehlo.all_gather"(%[[LOCAL_TOP_K]]#0, %[[GLOBAL_INDICES]])
+  // CHECK-SAME:   all_gather_dim = 1
+  // CHECK-SAME{LITERAL}: replica_groups = dense<[[0, 1, 2, 3], [4, 5, 6, 7]]>
+  // CHECK-SAME:   (tensor<4x2xf32>, tensor<4x2xi32>) -> (tensor<4x8xf32>, tensor<4x8xi32>)
+  // CHECK:      %[[SORT:.*]]:2 = "stablehlo.sort"(%[[GATHER]]#0, %[[GATHER]]#1)
+  // CHECK:        stablehlo.compare GT, %{{.*}}, %{{.*}}, TOTALORDER
+  // CHECK:      dimension = 1 : i64, is_stable = true
+  // CHECK:      %[[VALUES:.*]] = stablehlo.slice %[[SORT]]#0 [0:4, 0:2]
+  // CHECK:      %[[INDICES:.*]] = stablehlo.slice %[[SORT]]#1 [0:4, 0:2]
+  // CHECK:      return %[[VALUES]], %[[INDICES]]
+  %0 = sdy.all_gather [{}, {"y"}] %arg0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<4x32xf32>
+  %1:2 = stablehlo.custom_call @mhlo.topk(%0) {
+    mhlo.attributes = {k = 2 : i64, largest = true}, mhlo.version = 1 : i64,
+    sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{}, {}]>, <@mesh_2_4, [{}, {}]>]>}
+    : (tensor<4x32xf32>) -> (tensor<4x2xf32>, tensor<4x2xi32>)
+  return %1#0, %1#1 : tensor<4x2xf32>, tensor<4x2xi32>
+}
+
+// -----
+
+sdy.mesh @mesh_2_4 = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @top_k_with_more_than_shard_size
+func.func @top_k_with_more_than_shard_size(
+  %arg0: tensor<4x32xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {"y"}]>})
+  -> (tensor<4x16xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>},
+      tensor<4x16xi32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>}) {
+  // CHECK:     %[[GATHER:.*]] = "stablehlo.all_gather"(%arg0)
+  // CHECK:     stablehlo.custom_call @mhlo.topk(%[[GATHER]])
+  // CHECK-NOT: stablehlo.sort
+  %0 = sdy.all_gather [{}, {"y"}] %arg0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<4x32xf32>
+  %1:2 = stablehlo.custom_call @mhlo.topk(%0) {
+    mhlo.attributes = {k = 16 : i64, largest = true}, mhlo.version = 1 : i64,
+    sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{}, {}]>, <@mesh_2_4, [{}, {}]>]>}
+    : (tensor<4x32xf32>) -> (tensor<4x16xf32>, tensor<4x16xi32>)
+  return %1#0, %1#1 : tensor<4x16xf32>, tensor<4x16xi32>
+}
+
+// -----
+
+sdy.mesh @mesh_2_4 = <["x"=2, "y"=4]>
+
+// CHECK-LABEL: func @top_k_along_gathered_major_dim
+func.func @top_k_along_gathered_major_dim(
+  %arg0: tensor<16x8xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"y"}, {}]>})
+  -> (tensor<16x2xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>},
+      tensor<16x2xi32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{}, {}]>}) {
+  // CHECK:     %[[GATHER:.*]] = "stablehlo.all_gather"(%arg0)
+  // CHECK:     stablehlo.custom_call @mhlo.topk(%[[GATHER]])
+  // CHECK-NOT: stablehlo.sort
+  %0 = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<16x8xf32>
+  %1:2 = stablehlo.custom_call @mhlo.topk(%0) {
+    mhlo.attributes = {k = 2 : i64, largest = true}, mhlo.version = 1 : i64,
+    sdy.sharding = #sdy.sharding_per_value<[<@mesh_2_4, [{}, {}]>, <@mesh_2_4, [{}, {}]>]>}
+    : (tensor<16x8xf32>) -> (tensor<16x2xf32>, tensor<16x2xi32>)
+  return %1#0, %1#1 : tensor<16x2xf32>, tensor<16x2xi32>
+}
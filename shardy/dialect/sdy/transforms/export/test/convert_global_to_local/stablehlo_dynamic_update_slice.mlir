@@ -0,0 +1,102 @@
+// RUN: sdy_opt %s -sdy-convert-global-to-local | FileCheck %s
+
+sdy.mesh @mesh_4 = <["x"=4]>
+sdy.mesh @mesh_4_2 = <["x"=4, "y"=2]>
+
+// CHECK-LABEL: func @non_sharded
+func.func @non_sharded(%arg0: tensor<8x16xf32>, %arg1: tensor<8x2xf32>, %arg2: tensor<i32>) -> tensor<8x16xf32> {
+  // CHECK: %[[C0:.*]] = stablehlo.constant dense<0> : tensor<i32>
+  // CHECK-NEXT: %[[RES:.*]] = stablehlo.dynamic_update_slice %arg0, %arg1, %[[C0]], %arg2 : (tensor<8x16xf32>, tensor<8x2xf32>, tensor<i32>, tensor<i32>) -> tensor<8x16xf32>
+  // CHECK-NEXT: return %[[RES]]
+  %c0 = stablehlo.constant dense<0> : tensor<i32>
+  %0 = stablehlo.dynamic_update_slice %arg0, %arg1, %c0, %arg2 : (tensor<8x16xf32>, tensor<8x2xf32>, tensor<i32>, tensor<i32>) -> tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
+
+// CHECK-LABEL: func @sharded_pass_through_dim
+// CHECK-SAME:    %arg0: tensor<2x16xf32>
+// CHECK-SAME:    %arg1: tensor<2x2xf32>
+func.func @sharded_pass_through_dim(
+    %arg0: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh_4, [{"x"}, {}]>},
+    %arg1: tensor<8x2xf32> {sdy.sharding = #sdy.sharding<@mesh_4, [{"x"}, {}]>},
+    %arg2: tensor<i32>) -> (tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh_4, [{"x"}, {}]>}) {
+  // CHECK: %[[C0:.*]] = stablehlo.constant dense<0> : tensor<i32>
+  // CHECK-NEXT: %[[RES:.*]] = stablehlo.dynamic_update_slice %arg0, %arg1, %[[C0]], %arg2
+  // CHECK-SAME:   : (tensor<2x16xf32>, tensor<2x2xf32>, tensor<i32>, tensor<i32>) -> tensor<2x16xf32>
+  // CHECK-NEXT: return %[[RES]]
+  %c0 = stablehlo.constant dense<0> : tensor<i32>
+  %0 = stablehlo.dynamic_update_slice %arg0, %arg1, %c0, %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4, [{"x"}, {}]>]>} : (tensor<8x16xf32>, tensor<8x2xf32>, tensor<i32>, tensor<i32>) -> tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
+
+// CHECK-LABEL: func @sharded_slicing_dim
+// CHECK-SAME:    %arg0: tensor<8x4xf32>
+// CHECK-SAME:    %arg1: tensor<8x2xf32>
+// CHECK-SAME:    -> (tensor<8x4xf32>
+func.func @sharded_slicing_dim(
+    %arg0: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh_4, [{}, {"x"}]>},
+    %arg1: tensor<8x2xf32>, %arg2: tensor<i32>) -> (tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh_4, [{}, {"x"}]>}) {
+  // CHECK:      %[[C0:.*]] = stablehlo.constant dense<0> : tensor<i32>
+  // CHECK-NEXT: %[[START_0:.*]] = stablehlo.convert %[[C0]] : (tensor<i32>) -> tensor<i64>
+  // CHECK-NEXT: %[[START_1:.*]] = stablehlo.convert %arg2 : (tensor<i32>) -> tensor<i64>
+  // CHECK-NEXT: %[[UPDATE_START_0:.*]] = stablehlo.constant dense<0> : tensor<i64>
+  // CHECK-NEXT: %[[ZERO:.*]] = stablehlo.constant dense<0> : tensor<i64>
+  // CHECK-NEXT: %[[MAX_GLOBAL:.*]] = stablehlo.constant dense<14> : tensor<i64>
+  // CHECK-NEXT: %[[GLOBAL_START:.*]] = stablehlo.clamp %[[ZERO]], %[[START_1]], %[[MAX_GLOBAL]]
+  // CHECK-NEXT: %[[PID:.*]] = stablehlo.partition_id
+  // CHECK-NEXT: %[[PID_I64:.*]] = stablehlo.convert %[[PID]]
+  // CHECK-NEXT: %[[TABLE:.*]] = stablehlo.constant dense<[0, 4, 8, 12]> : tensor<4xi64>
+  // CHECK-NEXT: %[[OFFSET_SLICE:.*]] = stablehlo.dynamic_slice %[[TABLE]], %[[PID_I64]], sizes = [1]
+  // CHECK-NEXT: %[[OFFSET:.*]] = stablehlo.reshape %[[OFFSET_SLICE]]
+  // CHECK-NEXT: %[[START:.*]] = stablehlo.subtract %[[GLOBAL_START]], %[[OFFSET]] : tensor<i64>
+  // CHECK-NEXT: %[[MAX_LOCAL:.*]] = stablehlo.constant dense<2> : tensor<i64>
+  // CHECK-NEXT: %[[LOCAL_START:.*]] = stablehlo.clamp %[[ZERO]], %[[START]], %[[MAX_LOCAL]]
+  // CHECK-NEXT: %[[SHIFT:.*]] = stablehlo.subtract %[[LOCAL_START]], %[[START]] : tensor<i64>
+  // CHECK-NEXT: %[[UPDATE_SIZE:.*]] = stablehlo.constant dense<2> : tensor<i64>
+  // CHECK-NEXT: %[[UPDATE_START_1:.*]] = stablehlo.add %[[SHIFT]], %[[UPDATE_SIZE]] : tensor<i64>
+  // CHECK-NEXT: %[[IOTA:.*]] = stablehlo.iota dim = 1 : tensor<8x2xi64>
+  // CHECK-NEXT: %[[BCAST_SHIFT:.*]] = stablehlo.broadcast_in_dim %[[SHIFT]], dims = [] : (tensor<i64>) -> tensor<8x2xi64>
+  // CHECK-NEXT: %[[UPDATE_INDEX:.*]] = stablehlo.add %[[IOTA]], %[[BCAST_SHIFT]] : tensor<8x2xi64>
+  // CHECK-NEXT: %[[LOWER:.*]] = stablehlo.constant dense<0> : tensor<8x2xi64>
+  // CHECK-NEXT: %[[GE:.*]] = stablehlo.compare GE, %[[UPDATE_INDEX]], %[[LOWER]]
+  // CHECK-NEXT: %[[UPPER:.*]] = stablehlo.constant dense<2> : tensor<8x2xi64>
+  // CHECK-NEXT: %[[LT:.*]] = stablehlo.compare LT, %[[UPDATE_INDEX]], %[[UPPER]]
+  // CHECK-NEXT: %[[MASK:.*]] = stablehlo.and %[[GE]], %[[LT]] : tensor<8x2xi1>
+  // CHECK-NEXT: %[[ZERO_F32:.*]] = stablehlo.constant dense<0.000000e+00> : tensor<f32>
+  // CHECK-NEXT: %[[PADDED:.*]] = stablehlo.pad %arg1, %[[ZERO_F32]], low = [0, 2], high = [0, 2], interior = [0, 0]
+  // CHECK-SAME:   : (tensor<8x2xf32>, tensor<f32>) -> tensor<8x6xf32>
+  // CHECK-NEXT: %[[SHIFTED:.*]] = stablehlo.dynamic_slice %[[PADDED]], %[[UPDATE_START_0]], %[[UPDATE_START_1]], sizes = [8, 2]
+  // CHECK-NEXT: %[[EXISTING:.*]] = stablehlo.dynamic_slice %arg0, %[[START_0]], %[[LOCAL_START]], sizes = [8, 2]
+  // CHECK-NEXT: %[[WINDOW:.*]] = stablehlo.select %[[MASK]], %[[SHIFTED]], %[[EXISTING]]
+  // CHECK-NEXT: %[[RES:.*]] = stablehlo.dynamic_update_slice %arg0, %[[WINDOW]], %[[START_0]], %[[LOCAL_START]]
+  // CHECK-SAME:   : (tensor<8x4xf32>, tensor<8x2xf32>, tensor<i64>, tensor<i64>) -> tensor<8x4xf32>
+  // CHECK-NEXT: return %[[RES]] : tensor<8x4xf32>
+  %c0 = stablehlo.constant dense<0> : tensor<i32>
+  %0 = stablehlo.dynamic_update_slice %arg0, %arg1, %c0, %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4, [{}, {"x"}]>]>} : (tensor<8x16xf32>, tensor<8x2xf32>, tensor<i32>, tensor<i32>) -> tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
+
+// CHECK-LABEL: func @kv_cache_sharded_batch_and_sequence
+// CHECK-SAME:    %arg0: tensor<2x32x8xbf16>
+// CHECK-SAME:    %arg1: tensor<2x1x8xbf16>
+func.func @kv_cache_sharded_batch_and_sequence(
+    %arg0: tensor<4x128x8xbf16> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{"y"}, {"x"}, {}]>},
+    %arg1: tensor<4x1x8xbf16> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{"y"}, {}, {}]>},
+    %arg2: tensor<i64>) -> (tensor<4x128x8xbf16> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{"y"}, {"x"}, {}]>}) {
+  // CHECK:      %[[C0:.*]] = stablehlo.constant dense<0> : tensor<i64>
+  // CHECK-NOT:  stablehlo.convert %arg2
+  // CHECK:      %[[GLOBAL_START:.*]] = stablehlo.clamp %{{.*}}, %arg2, %{{.*}}
+  // CHECK:      stablehlo.constant dense<[0, 0, 32, 32, 64, 64, 96, 96]> : tensor<8xi64>
+  // CHECK:      %[[LOCAL_START:.*]] = stablehlo.clamp
+  // CHECK:      stablehlo.iota dim = 1 : tensor<2x1x8xi64>
+  // CHECK:      stablehlo.pad %arg1, %{{.*}}, low = [0, 1, 0], high = [0, 1, 0], interior = [0, 0, 0]
+  // CHECK-SAME:   : (tensor<2x1x8xbf16>, tensor<bf16>) -> tensor<2x3x8xbf16>
+  // CHECK:      %[[WINDOW:.*]] = stablehlo.select
+  // CHECK-NEXT: %[[RES:.*]] = stablehlo.dynamic_update_slice %arg0, %[[WINDOW]], %[[C0]], %[[LOCAL_START]], %[[C0]]
+  // CHECK-SAME:   {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"y"}, {"x"}, {}]>]>}
+  // CHECK-SAME:   : (tensor<2x32x8xbf16>, tensor<2x1x8xbf16>, tensor<i64>, tensor<i64>, tensor<i64>) -> tensor<2x32x8xbf16>
+  // CHECK-NEXT: return %[[RES]]
+  %c0 = stablehlo.constant dense<0> : tensor<i64>
+  %0 = stablehlo.dynamic_update_slice %arg0, %arg1, %c0, %arg2, %c0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"y"}, {"x"}, {}]>]>} : (tensor<4x128x8xbf16>, tensor<4x1x8xbf16>, tensor<i64>, tensor<i64>, tensor<i64>) -> tensor<4x128x8xbf16>
+  return %0 : tensor<4x128x8xbf16>
+}
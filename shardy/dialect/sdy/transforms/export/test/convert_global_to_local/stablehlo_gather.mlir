@@ -375,3 +375,73 @@ func.func @shard_two_of_three_reduction_dims_one_not_in_start_index_map(
   // CHECK: return %[[RES]] : tensor<3x2x1x1x5x1xf32>
   return %1 : tensor<6x2x1x1x5x1xf32>
 }
+
+// The constant indices are within the global operand bounds, so they are not
+// clamped.
+//
+// CHECK-LABEL: func @constant_indices_in_bounds_not_clamped(
+// CHECK-SAME: %[[ARG0:.*]]: tensor<4x10xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>}) -> tensor<2x10xf32> {
+func.func @constant_indices_in_bounds_not_clamped(
+  %arg0: tensor<8x10xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>}) -> tensor<2x10xf32> {
+  // CHECK: %[[INDICES:.*]] = stablehlo.constant dense<[1, 6]> : tensor<2xi64>
+  // CHECK-NOT: stablehlo.clamp
+  // CHECK: %[[LOCAL_IDX:.*]] = stablehlo.subtract %[[INDICES]], %{{.*}} : tensor<2xi64>
+  // CHECK: %[[GE:.*]] = stablehlo.compare GE, %[[INDICES]], %{{.*}}
+  // CHECK: %[[LE:.*]] = stablehlo.compare LE, %[[INDICES]], %{{.*}}
+  // CHECK: %[[GATHER:.*]] = "stablehlo.gather"(%[[ARG0]], %[[LOCAL_IDX]])
+  %c = stablehlo.constant dense<[1, 6]> : tensor<2xi64>
+  %0 = "stablehlo.gather"(%arg0, %c) {
+    dimension_numbers = #stablehlo.gather<
+      offset_dims = [1],
+      collapsed_slice_dims = [0],
+      start_index_map = [0],
+      index_vector_dim = 1>,
+    slice_sizes = array<i64: 1, 10>
+  } : (tensor<8x10xf32>, tensor<2xi64>) -> tensor<2x10xf32>
+  %1 = sdy.all_reduce {"x"} %0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<2x10xf32>
+  return %1 : tensor<2x10xf32>
+}
+
+// The iota indices are within the global operand bounds, so they are not
+// clamped.
+//
+// CHECK-LABEL: func @iota_indices_in_bounds_not_clamped(
+func.func @iota_indices_in_bounds_not_clamped(
+  %arg0: tensor<8x10xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>}) -> tensor<4x10xf32> {
+  // CHECK: %[[IOTA:.*]] = stablehlo.iota dim = 0 : tensor<4xi32>
+  // CHECK-NEXT: %[[INDICES:.*]] = stablehlo.convert %[[IOTA]] : (tensor<4xi32>) -> tensor<4xi64>
+  // CHECK-NOT: stablehlo.clamp
+  // CHECK: stablehlo.subtract %[[INDICES]], %{{.*}} : tensor<4xi64>
+  %iota = stablehlo.iota dim = 0 : tensor<4xi32>
+  %indices = stablehlo.convert %iota : (tensor<4xi32>) -> tensor<4xi64>
+  %0 = "stablehlo.gather"(%arg0, %indices) {
+    dimension_numbers = #stablehlo.gather<
+      offset_dims = [1],
+      collapsed_slice_dims = [0],
+      start_index_map = [0],
+      index_vector_dim = 1>,
+    slice_sizes = array<i64: 1, 10>
+  } : (tensor<8x10xf32>, tensor<4xi64>) -> tensor<4x10xf32>
+  %1 = sdy.all_reduce {"x"} %0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<4x10xf32>
+  return %1 : tensor<4x10xf32>
+}
+
+// The constant indices may be out of bounds, so they are still clamped.
+//
+// CHECK-LABEL: func @constant_indices_out_of_bounds_clamped(
+func.func @constant_indices_out_of_bounds_clamped(
+  %arg0: tensor<8x10xf32> {sdy.sharding = #sdy.sharding<@mesh_2_4, [{"x"}, {}]>}) -> tensor<2x10xf32> {
+  // CHECK: %[[INDICES:.*]] = stablehlo.constant dense<[1, 8]> : tensor<2xi64>
+  // CHECK: stablehlo.clamp %{{.*}}, %[[INDICES]], %{{.*}} : tensor<2xi64>
+  %c = stablehlo.constant dense<[1, 8]> : tensor<2xi64>
+  %0 = "stablehlo.gather"(%arg0, %c) {
+    dimension_numbers = #stablehlo.gather<
+      offset_dims = [1],
+      collapsed_slice_dims = [0],
+      start_index_map = [0],
+      index_vector_dim = 1>,
+    slice_sizes = array<i64: 1, 10>
+  } : (tensor<8x10xf32>, tensor<2xi64>) -> tensor<2x10xf32>
+  %1 = sdy.all_reduce {"x"} %0 out_sharding=<@mesh_2_4, [{}, {}]> : tensor<2x10xf32>
+  return %1 : tensor<2x10xf32>
+}
@@ -0,0 +1,131 @@
+// RUN: sdy_opt %s -sdy-fuse-reshard-chains | FileCheck %s
+
+sdy.mesh @mesh = <["x"=2, "y"=2]>
+
+// CHECK-LABEL: func @round_trip
+func.func @round_trip(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: return %arg0
+  %0 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.reshard %0 <@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @round_trip_inner_reshard_multiple_uses
+func.func @round_trip_inner_reshard_multiple_uses(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  // CHECK-NEXT: %[[RESHARD:.*]] = sdy.reshard %arg0 <@mesh, [{"y"}, {}]>
+  // CHECK-NEXT: return %arg0, %[[RESHARD]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.reshard %0 <@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  return %1, %0 : tensor<8x8xf32>, tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @chain_of_three_reshards
+func.func @chain_of_three_reshards(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[RESHARD:.*]] = sdy.reshard %arg0 <@mesh, [{}, {"x", "y"}]>
+  // CHECK-NEXT: return %[[RESHARD]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.reshard %0 <@mesh, [{}, {"y"}]> : tensor<8x8xf32>
+  %2 = sdy.reshard %1 <@mesh, [{}, {"x", "y"}]> : tensor<8x8xf32>
+  return %2 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @chain_inner_reshard_multiple_uses
+func.func @chain_inner_reshard_multiple_uses(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  // CHECK-NEXT: %[[RESHARD_0:.*]] = sdy.reshard %arg0 <@mesh, [{"y"}, {}]>
+  // CHECK-NEXT: %[[RESHARD_1:.*]] = sdy.reshard %[[RESHARD_0]] <@mesh, [{}, {"y"}]>
+  // CHECK-NEXT: return %[[RESHARD_1]], %[[RESHARD_0]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.reshard %0 <@mesh, [{}, {"y"}]> : tensor<8x8xf32>
+  return %1, %0 : tensor<8x8xf32>, tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @hoist_above_upcasting_convert
+func.func @hoist_above_upcasting_convert(%arg0: tensor<8x8xbf16> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[RESHARD:.*]] = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xbf16>
+  // CHECK-NEXT: %[[CONVERT:.*]] = stablehlo.convert %[[RESHARD]] {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {}]>]>}
+  // CHECK-NEXT: return %[[CONVERT]]
+  %0 = stablehlo.convert %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : (tensor<8x8xbf16>) -> tensor<8x8xf32>
+  %1 = sdy.reshard %0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// The reshard is hoisted above the convert, and then cancels out with the
+// reshard of its operand.
+// CHECK-LABEL: func @hoist_above_convert_then_round_trip
+func.func @hoist_above_convert_then_round_trip(%arg0: tensor<8x8xbf16> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[CONVERT:.*]] = stablehlo.convert %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>}
+  // CHECK-NEXT: return %[[CONVERT]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xbf16>
+  %1 = stablehlo.convert %0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {}]>]>} : (tensor<8x8xbf16>) -> tensor<8x8xf32>
+  %2 = sdy.reshard %1 <@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  return %2 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @no_hoist_above_downcasting_convert
+func.func @no_hoist_above_downcasting_convert(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xbf16> {
+  // CHECK-NEXT: %[[CONVERT:.*]] = stablehlo.convert %arg0
+  // CHECK-NEXT: %[[RESHARD:.*]] = sdy.reshard %[[CONVERT]] <@mesh, [{"y"}, {}]> : tensor<8x8xbf16>
+  // CHECK-NEXT: return %[[RESHARD]]
+  %0 = stablehlo.convert %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : (tensor<8x8xf32>) -> tensor<8x8xbf16>
+  %1 = sdy.reshard %0 <@mesh, [{"y"}, {}]> : tensor<8x8xbf16>
+  return %1 : tensor<8x8xbf16>
+}
+
+// CHECK-LABEL: func @no_hoist_above_binary_op
+func.func @no_hoist_above_binary_op(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}, %arg1: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %arg0, %arg1
+  // CHECK-NEXT: %[[RESHARD:.*]] = sdy.reshard %[[ADD]] <@mesh, [{"y"}, {}]>
+  // CHECK-NEXT: return %[[RESHARD]]
+  %0 = stablehlo.add %arg0, %arg1 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : tensor<8x8xf32>
+  %1 = sdy.reshard %0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @share_reshards_to_same_sharding
+func.func @share_reshards_to_same_sharding(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  // CHECK-NEXT: %[[RESHARD:.*]] = sdy.reshard %arg0 <@mesh, [{}, {"y"}]>
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %[[RESHARD]], %[[RESHARD]]
+  // CHECK-NEXT: %[[MUL:.*]] = stablehlo.multiply %[[RESHARD]], %[[ADD]]
+  // CHECK-NEXT: return %[[ADD]], %[[MUL]]
+  %0 = sdy.reshard %arg0 <@mesh, [{}, {"y"}]> : tensor<8x8xf32>
+  %1 = stablehlo.add %0, %0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"y"}]>]>} : tensor<8x8xf32>
+  %2 = sdy.reshard %arg0 <@mesh, [{}, {"y"}]> : tensor<8x8xf32>
+  %3 = stablehlo.multiply %2, %1 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"y"}]>]>} : tensor<8x8xf32>
+  return %1, %3 : tensor<8x8xf32>, tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @share_reshard_hoisted_out_of_nested_region
+func.func @share_reshard_hoisted_out_of_nested_region(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}, %arg1: tensor<i1>) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[RESHARD:.*]] = sdy.reshard %arg0 <@mesh, [{"y"}, {}]>
+  // CHECK-NEXT: %[[IF:.*]] = "stablehlo.if"
+  // CHECK-NEXT:   stablehlo.return %[[RESHARD]]
+  // CHECK:        stablehlo.return %[[RESHARD]]
+  %0 = "stablehlo.if"(%arg1) ({
+    %1 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+    stablehlo.return %1 : tensor<8x8xf32>
+  }, {
+    %2 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+    stablehlo.return %2 : tensor<8x8xf32>
+  }) : (tensor<i1>) -> tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @finer_reshard_reuses_coarser_reshard
+func.func @finer_reshard_reuses_coarser_reshard(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"x"}]>}) -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  // CHECK-NEXT: %[[COARSE:.*]] = sdy.reshard %arg0 <@mesh, [{"x"}, {}]>
+  // CHECK-NEXT: %[[FINE:.*]] = sdy.reshard %[[COARSE]] <@mesh, [{"x", "y"}, {}]>
+  // CHECK-NEXT: return %[[FINE]], %[[COARSE]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"x", "y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.reshard %arg0 <@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  return %0, %1 : tensor<8x8xf32>, tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @no_reuse_of_unrelated_reshard
+func.func @no_reuse_of_unrelated_reshard(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"x"}]>}) -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  // CHECK-NEXT: %[[RESHARD_0:.*]] = sdy.reshard %arg0 <@mesh, [{"x", "y"}, {}]>
+  // CHECK-NEXT: %[[RESHARD_1:.*]] = sdy.reshard %arg0 <@mesh, [{"y"}, {}]>
+  // CHECK-NEXT: return %[[RESHARD_0]], %[[RESHARD_1]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"x", "y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xf32>
+  return %0, %1 : tensor<8x8xf32>, tensor<8x8xf32>
+}
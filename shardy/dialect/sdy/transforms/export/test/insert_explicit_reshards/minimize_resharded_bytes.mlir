@@ -0,0 +1,26 @@
+// RUN: sdy_opt %s -sdy-insert-explicit-reshards='enable-full-version=true minimize-resharded-bytes=true' | FileCheck %s
+
+sdy.mesh @mesh = <["x"=4, "y"=2]>
+
+// The bf16 operand is resharded rather than the f32 result, even though the
+// operand is sharded on a larger axis.
+// CHECK-LABEL: func @convert_upcast
+func.func @convert_upcast(%arg0: tensor<8x8xbf16> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> (tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"y"}, {}]>}) {
+  // CHECK: %[[RESHARD:.*]] = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xbf16>
+  // CHECK-NEXT: %[[CONVERT:.*]] = stablehlo.convert %[[RESHARD]] {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {}]>]>} : (tensor<8x8xbf16>) -> tensor<8x8xf32>
+  // CHECK-NEXT: return %[[CONVERT]] : tensor<8x8xf32>
+  %0 = stablehlo.convert %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {}]>]>} : (tensor<8x8xbf16>) -> tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
+
+// The same number of elements is sharded on "x" and "y", but the tensors
+// sharded on "y" have more bytes.
+// CHECK-LABEL: func @select_small_predicate
+func.func @select_small_predicate(%arg0: tensor<8x8xi1> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}, %arg1: tensor<8x8xbf16> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}, %arg2: tensor<8x8xbf16> {sdy.sharding = #sdy.sharding<@mesh, [{"y"}, {}]>}) -> (tensor<8x8xbf16> {sdy.sharding = #sdy.sharding<@mesh, [{"y"}, {}]>}) {
+  // CHECK: %[[RESHARD1:.*]] = sdy.reshard %arg0 <@mesh, [{"y"}, {}]> : tensor<8x8xi1>
+  // CHECK-NEXT: %[[RESHARD2:.*]] = sdy.reshard %arg1 <@mesh, [{"y"}, {}]> : tensor<8x8xbf16>
+  // CHECK-NEXT: %[[SELECT:.*]] = stablehlo.select %[[RESHARD1]], %[[RESHARD2]], %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {}]>]>} : tensor<8x8xi1>, tensor<8x8xbf16>
+  // CHECK-NEXT: return %[[SELECT]] : tensor<8x8xbf16>
+  %0 = stablehlo.select %arg0, %arg1, %arg2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {}]>]>} : (tensor<8x8xi1>, tensor<8x8xbf16>, tensor<8x8xbf16>) -> tensor<8x8xbf16>
+  return %0 : tensor<8x8xbf16>
+}
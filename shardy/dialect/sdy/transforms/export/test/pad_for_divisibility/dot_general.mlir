@@ -30,13 +30,13 @@ func.func @padded_contracting_dims_reuse(%arg0: tensor<4x7xf32>, %arg1: tensor<7
 
 // CHECK-LABEL: func @padded_contracting_dims_not_reuse
 func.func @padded_contracting_dims_not_reuse(%arg0: tensor<4x7xf32>, %arg1: tensor<7x5xf32>) -> tensor<4x5xf32> {
-  // Prepare padded LHS and RHS with unknown padding (via abs).
+  // Prepare padded LHS and RHS with unknown padding (via cosine).
   // CHECK: %[[PAD0:.*]] = stablehlo.pad %arg0, {{.*}}
   // CHECK: %[[LHS_SLICE:.*]] = sdy.all_slice [{}, {"y"}] %[[PAD0]]
-  // CHECK: %[[LHS_ABS:.*]] = stablehlo.abs %[[LHS_SLICE]] {{.*}}
+  // CHECK: %[[LHS_COS:.*]] = stablehlo.cosine %[[LHS_SLICE]] {{.*}}
   // CHECK: %[[PAD1:.*]] = stablehlo.pad %arg1, {{.*}}
   // CHECK: %[[RHS_SLICE:.*]] = sdy.all_slice [{"y"}, {"x"}] %[[PAD1]]
-  // CHECK: %[[RHS_ABS:.*]] = stablehlo.abs %[[RHS_SLICE]] {{.*}}
+  // CHECK: %[[RHS_COS:.*]] = stablehlo.cosine %[[RHS_SLICE]] {{.*}}
 
   // Enforce zero-padding on LHS contracting dim (dim 1).
   // CHECK: %[[LHS_IOTA:.*]] = stablehlo.iota{{.*}}dim = 1
@@ -45,7 +45,7 @@ func.func @padded_contracting_dims_not_reuse(%arg0: tensor<4x7xf32>, %arg1: tens
   // CHECK: %[[LHS_MASK:.*]] = stablehlo.compare{{.*}}LT, %[[LHS_IOTA]], %[[LHS_LIMIT_BCAST]]
   // CHECK: %[[LHS_CST:.*]] = stablehlo.constant dense<0.000000e+00> : tensor<f32>
   // CHECK: %[[LHS_BCAST:.*]] = stablehlo.broadcast_in_dim %[[LHS_CST]], dims = []
-  // CHECK: %[[LHS_SELECT:.*]] = stablehlo.select %[[LHS_MASK]], %[[LHS_ABS]], %[[LHS_BCAST]]
+  // CHECK: %[[LHS_SELECT:.*]] = stablehlo.select %[[LHS_MASK]], %[[LHS_COS]], %[[LHS_BCAST]]
 
   // Enforce zero-padding on RHS contracting dim (dim 0).
   // CHECK: %[[RHS_IOTA:.*]] = stablehlo.iota{{.*}}dim = 0
@@ -54,7 +54,7 @@ func.func @padded_contracting_dims_not_reuse(%arg0: tensor<4x7xf32>, %arg1: tens
   // CHECK: %[[RHS_MASK:.*]] = stablehlo.compare{{.*}}LT, %[[RHS_IOTA]], %[[RHS_LIMIT_BCAST]]
   // CHECK: %[[RHS_CST:.*]] = stablehlo.constant dense<0.000000e+00> : tensor<f32>
   // CHECK: %[[RHS_BCAST:.*]] = stablehlo.broadcast_in_dim %[[RHS_CST]], dims = []
-  // CHECK: %[[RHS_SELECT:.*]] = stablehlo.select %[[RHS_MASK]], %[[RHS_ABS]], %[[RHS_BCAST]]
+  // CHECK: %[[RHS_SELECT:.*]] = stablehlo.select %[[RHS_MASK]], %[[RHS_COS]], %[[RHS_BCAST]]
   // CHECK-NOT: stablehlo.iota {{.*}} dim = 1
 
   // Perform dot_general and trim result.
@@ -63,9 +63,9 @@ func.func @padded_contracting_dims_not_reuse(%arg0: tensor<4x7xf32>, %arg1: tens
   // CHECK: return %[[TRIM]]
 
   %0 = sdy.all_slice [{}, {"y"}] %arg0 out_sharding=<@mesh_4_2, [{}, {"y"}]> : tensor<4x7xf32>
-  %1 = stablehlo.abs %0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"y"}]>]>} : tensor<4x7xf32>
+  %1 = stablehlo.cosine %0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"y"}]>]>} : tensor<4x7xf32>
   %2 = sdy.all_slice [{"y"}, {"x"}] %arg1 out_sharding=<@mesh_4_2, [{"y"}, {"x"}]> : tensor<7x5xf32>
-  %3 = stablehlo.abs %2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"y"}, {"x"}]>]>} : tensor<7x5xf32>
+  %3 = stablehlo.cosine %2 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"y"}, {"x"}]>]>} : tensor<7x5xf32>
   %4 = stablehlo.dot_general %1, %3, contracting_dims = [1] x [0] {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"x"}]>]>} : (tensor<4x7xf32>, tensor<7x5xf32>) -> tensor<4x5xf32>
   %5 = stablehlo.slice %4 [0:4, 0:5] : (tensor<4x5xf32>) -> tensor<4x5xf32>
   return %5 : tensor<4x5xf32>
@@ -128,3 +128,43 @@ func.func @padded_contracting_dims_reuse_with_all_gather(%arg0: tensor<4x7xf32>,
   return %4 : tensor<4x5xf32>
 }
 
+
+// CHECK-LABEL: func @zero_padding_propagated_through_elementwise_ops
+func.func @zero_padding_propagated_through_elementwise_ops(%arg0: tensor<4x7xf32>, %arg1: tensor<7x5xf32>) -> tensor<4x5xf32> {
+  // The zero padding of LHS is preserved by abs and negate, so it isn't
+  // enforced again before the dot_general.
+  // CHECK: %[[PAD0:.*]] = stablehlo.pad %arg0, {{.*}}
+  // CHECK: %[[LHS_SLICE:.*]] = sdy.all_slice [{}, {"y"}] %[[PAD0]]
+  // CHECK: %[[LHS_ABS:.*]] = stablehlo.abs %[[LHS_SLICE]] {{.*}}
+  // CHECK: %[[LHS_NEG:.*]] = stablehlo.negate %[[LHS_ABS]] {{.*}}
+  // CHECK: %[[PAD1:.*]] = stablehlo.pad %arg1, {{.*}}
+  // CHECK: %[[RHS_SLICE:.*]] = sdy.all_slice [{"y"}, {"x"}] %[[PAD1]]
+  // CHECK-NOT: stablehlo.select
+  // CHECK: %[[DOT:.*]] = stablehlo.dot_general %[[LHS_NEG]], %[[RHS_SLICE]], contracting_dims = [1] x [0] {{.*}}
+  // CHECK: %[[TRIM:.*]] = stablehlo.slice %[[DOT]] [0:4, 0:5]
+  // CHECK: return %[[TRIM]]
+  %0 = sdy.all_slice [{}, {"y"}] %arg0 out_sharding=<@mesh_4_2, [{}, {"y"}]> : tensor<4x7xf32>
+  %1 = stablehlo.abs %0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"y"}]>]>} : tensor<4x7xf32>
+  %2 = stablehlo.negate %1 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"y"}]>]>} : tensor<4x7xf32>
+  %3 = sdy.all_slice [{"y"}, {"x"}] %arg1 out_sharding=<@mesh_4_2, [{"y"}, {"x"}]> : tensor<7x5xf32>
+  %4 = stablehlo.dot_general %2, %3, contracting_dims = [1] x [0] {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"x"}]>]>} : (tensor<4x7xf32>, tensor<7x5xf32>) -> tensor<4x5xf32>
+  %5 = stablehlo.slice %4 [0:4, 0:5] : (tensor<4x5xf32>) -> tensor<4x5xf32>
+  return %5 : tensor<4x5xf32>
+}
+
+// CHECK-LABEL: func @zero_padding_not_preserved_by_exponential
+func.func @zero_padding_not_preserved_by_exponential(%arg0: tensor<4x7xf32>, %arg1: tensor<7x5xf32>) -> tensor<4x5xf32> {
+  // The zero padding of LHS is preserved by add, but not by exponential.
+  // CHECK: %[[LHS_ADD:.*]] = stablehlo.add
+  // CHECK: %[[LHS_EXP:.*]] = stablehlo.exponential %[[LHS_ADD]] {{.*}}
+  // CHECK: %[[LHS_IOTA:.*]] = stablehlo.iota{{.*}}dim = 1
+  // CHECK: %[[LHS_SELECT:.*]] = stablehlo.select %{{.*}}, %[[LHS_EXP]], %{{.*}}
+  // CHECK: stablehlo.dot_general %[[LHS_SELECT]]
+  %0 = sdy.all_slice [{}, {"y"}] %arg0 out_sharding=<@mesh_4_2, [{}, {"y"}]> : tensor<4x7xf32>
+  %1 = stablehlo.add %0, %0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"y"}]>]>} : tensor<4x7xf32>
+  %2 = stablehlo.exponential %1 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"y"}]>]>} : tensor<4x7xf32>
+  %3 = sdy.all_slice [{"y"}, {"x"}] %arg1 out_sharding=<@mesh_4_2, [{"y"}, {"x"}]> : tensor<7x5xf32>
+  %4 = stablehlo.dot_general %2, %3, contracting_dims = [1] x [0] {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"x"}]>]>} : (tensor<4x7xf32>, tensor<7x5xf32>) -> tensor<4x5xf32>
+  %5 = stablehlo.slice %4 [0:4, 0:5] : (tensor<4x5xf32>) -> tensor<4x5xf32>
+  return %5 : tensor<4x5xf32>
+}
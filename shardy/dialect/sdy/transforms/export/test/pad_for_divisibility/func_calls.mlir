@@ -0,0 +1,51 @@
+// RUN: sdy_opt %s -sdy-pad-for-divisibility='pad-across-call-boundaries=true' | FileCheck %s
+
+sdy.mesh @mesh_4_2 = <["x"=4, "y"=2]>
+
+// The padded value is passed to and returned from @foo without slicing and
+// re-padding around the call.
+//
+// CHECK-LABEL: func @padded_across_call
+func.func @padded_across_call(%arg0: tensor<7x8xi32>) -> tensor<7x8xi32> {
+  // CHECK-NEXT: %[[CST:.*]] = stablehlo.constant dense<0> : tensor<i32>
+  // CHECK-NEXT: %[[PAD:.*]] = stablehlo.pad %arg0, %[[CST]], low = [0, 0], high = [1, 0], interior = [0, 0] : (tensor<7x8xi32>, tensor<i32>) -> tensor<8x8xi32>
+  // CHECK-NEXT: %[[ALL_SLICE:.*]] = sdy.all_slice [{"x"}, {}] %[[PAD]] out_sharding=<@mesh_4_2, [{"x"}, {}]> : tensor<8x8xi32>
+  // CHECK-NEXT: %[[CALL:.*]] = call @foo(%[[ALL_SLICE]]) {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"x"}, {}]>]>} : (tensor<8x8xi32>) -> tensor<8x8xi32>
+  // CHECK-NEXT: %[[AG:.*]] = sdy.all_gather [{"x"}, {}] %[[CALL]] out_sharding=<@mesh_4_2, [{}, {}]> : tensor<8x8xi32>
+  // CHECK-NEXT: %[[SLICE:.*]] = stablehlo.slice %[[AG]] [0:7, 0:8]
+  // CHECK-NEXT: return %[[SLICE]] : tensor<7x8xi32>
+  %0 = sdy.all_slice [{"x"}, {}] %arg0 out_sharding=<@mesh_4_2, [{"x"}, {}]> : tensor<7x8xi32>
+  %1 = call @foo(%0) {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"x"}, {}]>]>} : (tensor<7x8xi32>) -> tensor<7x8xi32>
+  %2 = sdy.all_gather [{"x"}, {}] %1 out_sharding=<@mesh_4_2, [{}, {}]> : tensor<7x8xi32>
+  return %2 : tensor<7x8xi32>
+}
+
+// CHECK-LABEL: func private @foo
+// CHECK-SAME:    (%arg0: tensor<8x8xi32> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{"x"}, {}]>})
+// CHECK-SAME:    -> (tensor<8x8xi32> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{"x"}, {}]>})
+func.func private @foo(%arg0: tensor<7x8xi32> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{"x"}, {}]>})
+    -> (tensor<7x8xi32> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{"x"}, {}]>}) {
+  // CHECK-NEXT: %[[NEG:.*]] = stablehlo.negate %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"x"}, {}]>]>} : tensor<8x8xi32>
+  // CHECK-NEXT: return %[[NEG]] : tensor<8x8xi32>
+  %0 = stablehlo.negate %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{"x"}, {}]>]>} : tensor<7x8xi32>
+  return %0 : tensor<7x8xi32>
+}
+
+// A callee with divisible inputs receives the original shape.
+//
+// CHECK-LABEL: func @sliced_for_divisible_callee
+func.func @sliced_for_divisible_callee(%arg0: tensor<7x8xi32>) -> tensor<7x8xi32> {
+  // CHECK:      %[[ALL_SLICE:.*]] = sdy.all_slice [{"x"}, {}] %{{.*}} out_sharding=<@mesh_4_2, [{"x"}, {}]> : tensor<8x8xi32>
+  // CHECK-NEXT: %[[SLICE:.*]] = stablehlo.slice %[[ALL_SLICE]] [0:7, 0:8] {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {}]>]>}
+  // CHECK-NEXT: %[[CALL:.*]] = call @bar(%[[SLICE]]) : (tensor<7x8xi32>) -> tensor<7x8xi32>
+  // CHECK-NEXT: return %[[CALL]] : tensor<7x8xi32>
+  %0 = sdy.all_slice [{"x"}, {}] %arg0 out_sharding=<@mesh_4_2, [{"x"}, {}]> : tensor<7x8xi32>
+  %1 = call @bar(%0) : (tensor<7x8xi32>) -> tensor<7x8xi32>
+  return %1 : tensor<7x8xi32>
+}
+
+// CHECK-LABEL: func private @bar
+// CHECK-SAME:    (%arg0: tensor<7x8xi32> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{}, {}]>})
+func.func private @bar(%arg0: tensor<7x8xi32> {sdy.sharding = #sdy.sharding<@mesh_4_2, [{}, {}]>}) -> tensor<7x8xi32> {
+  return %arg0 : tensor<7x8xi32>
+}
@@ -0,0 +1,64 @@
+// RUN: sdy_opt %s -sdy-pad-for-divisibility | FileCheck %s
+
+sdy.mesh @mesh_4_2 = <["x"=4, "y"=2]>
+
+// CHECK-LABEL: func @reduce_add_zero_padding_reused
+func.func @reduce_add_zero_padding_reused(%arg0: tensor<4x7xf32>) -> tensor<4xf32> {
+  // The input is already padded with zero, which is the identity of add.
+  // CHECK: %[[PAD:.*]] = stablehlo.pad %arg0, {{.*}} -> tensor<4x8xf32>
+  // CHECK: %[[SLICE:.*]] = sdy.all_slice [{}, {"y"}] %[[PAD]]
+  // CHECK-NOT: stablehlo.select
+  // CHECK: {{"?}}stablehlo.reduce{{"?}}(%[[SLICE]]
+  %0 = sdy.all_slice [{}, {"y"}] %arg0 out_sharding=<@mesh_4_2, [{}, {"y"}]> : tensor<4x7xf32>
+  %cst = stablehlo.constant dense<0.000000e+00> : tensor<f32>
+  %1 = "stablehlo.reduce"(%0, %cst) ({
+    ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+      %3 = stablehlo.add %lhs, %rhs : tensor<f32>
+      stablehlo.return %3 : tensor<f32>
+  }) {dimensions = array<i64: 1>, sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}]>]>} : (tensor<4x7xf32>, tensor<f32>) -> tensor<4xf32>
+  %2 = sdy.all_reduce {"y"} %1 out_sharding=<@mesh_4_2, [{}]> : tensor<4xf32>
+  return %2 : tensor<4xf32>
+}
+
+// CHECK-LABEL: func @reduce_add_unknown_padding
+func.func @reduce_add_unknown_padding(%arg0: tensor<4x7xf32>) -> tensor<4xf32> {
+  // The padding after cosine is unknown, so it is set to zero along the
+  // reduced dimension.
+  // CHECK: %[[COS:.*]] = stablehlo.cosine
+  // CHECK: %[[IOTA:.*]] = stablehlo.iota{{.*}}dim = 1
+  // CHECK: %[[LIMIT:.*]] = stablehlo.constant dense<7> : tensor<i32>
+  // CHECK: %[[LIMIT_BCAST:.*]] = stablehlo.broadcast_in_dim %[[LIMIT]], dims = []
+  // CHECK: %[[MASK:.*]] = stablehlo.compare{{.*}}LT, %[[IOTA]], %[[LIMIT_BCAST]]
+  // CHECK: %[[ZERO:.*]] = stablehlo.constant dense<0.000000e+00> : tensor<f32>
+  // CHECK: %[[ZERO_BCAST:.*]] = stablehlo.broadcast_in_dim %[[ZERO]], dims = []
+  // CHECK: %[[SELECT:.*]] = stablehlo.select %[[MASK]], %[[COS]], %[[ZERO_BCAST]]
+  // CHECK: {{"?}}stablehlo.reduce{{"?}}(%[[SELECT]]
+  %0 = sdy.all_slice [{}, {"y"}] %arg0 out_sharding=<@mesh_4_2, [{}, {"y"}]> : tensor<4x7xf32>
+  %1 = stablehlo.cosine %0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}, {"y"}]>]>} : tensor<4x7xf32>
+  %cst = stablehlo.constant dense<0.000000e+00> : tensor<f32>
+  %2 = "stablehlo.reduce"(%1, %cst) ({
+    ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+      %4 = stablehlo.add %lhs, %rhs : tensor<f32>
+      stablehlo.return %4 : tensor<f32>
+  }) {dimensions = array<i64: 1>, sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}]>]>} : (tensor<4x7xf32>, tensor<f32>) -> tensor<4xf32>
+  %3 = sdy.all_reduce {"y"} %2 out_sharding=<@mesh_4_2, [{}]> : tensor<4xf32>
+  return %3 : tensor<4xf32>
+}
+
+// CHECK-LABEL: func @reduce_multiply_zero_padding_replaced_with_one
+func.func @reduce_multiply_zero_padding_replaced_with_one(%arg0: tensor<4x7xf32>) -> tensor<4xf32> {
+  // CHECK: %[[SLICE:.*]] = sdy.all_slice [{}, {"y"}]
+  // CHECK: %[[ONE:.*]] = stablehlo.constant dense<1.000000e+00> : tensor<f32>
+  // CHECK: %[[ONE_BCAST:.*]] = stablehlo.broadcast_in_dim %[[ONE]], dims = []
+  // CHECK: %[[SELECT:.*]] = stablehlo.select %{{.*}}, %[[SLICE]], %[[ONE_BCAST]]
+  // CHECK: {{"?}}stablehlo.reduce{{"?}}(%[[SELECT]]
+  %0 = sdy.all_slice [{}, {"y"}] %arg0 out_sharding=<@mesh_4_2, [{}, {"y"}]> : tensor<4x7xf32>
+  %cst = stablehlo.constant dense<1.000000e+00> : tensor<f32>
+  %1 = "stablehlo.reduce"(%0, %cst) ({
+    ^bb0(%lhs: tensor<f32>, %rhs: tensor<f32>):
+      %3 = stablehlo.multiply %lhs, %rhs : tensor<f32>
+      stablehlo.return %3 : tensor<f32>
+  }) {dimensions = array<i64: 1>, sdy.sharding = #sdy.sharding_per_value<[<@mesh_4_2, [{}]>]>} : (tensor<4x7xf32>, tensor<f32>) -> tensor<4xf32>
+  %2 = sdy.all_reduce {"y"} %1 out_sharding=<@mesh_4_2, [{}]> : tensor<4xf32>
+  return %2 : tensor<4xf32>
+}
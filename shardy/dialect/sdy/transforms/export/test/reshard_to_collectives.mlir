@@ -108,6 +108,22 @@ func.func @all_gather_multiple_axes(%arg0 : tensor<16x8xf32> {sdy.sharding = #sd
   return %0 : tensor<16x8xf32>
 }
 
+// CHECK-LABEL: func @all_gather_suffix_keeps_prefix
+func.func @all_gather_suffix_keeps_prefix(%arg0 : tensor<16x8xf32> {sdy.sharding = #sdy.sharding<@mesh4d, [{"w"}, {"x", "y", "z"}]>}) -> tensor<16x8xf32> {
+  // CHECK-NEXT: sdy.all_gather [{}, {"y", "z"}] %arg0 out_sharding=<@mesh4d, [{"w"}, {"x"}]>
+  // CHECK-NEXT: return
+  %0 = sdy.reshard %arg0 <@mesh4d, [{"w"}, {"x"}]> : tensor<16x8xf32>
+  return %0 : tensor<16x8xf32>
+}
+
+// CHECK-LABEL: func @all_gather_whole_dim
+func.func @all_gather_whole_dim(%arg0 : tensor<16x8xf32> {sdy.sharding = #sdy.sharding<@mesh3d, [{"x", "y"}, {"z"}]>}) -> tensor<16x8xf32> {
+  // CHECK-NEXT: sdy.all_gather [{"x", "y"}, {}] %arg0 out_sharding=<@mesh3d, [{}, {"z"}]>
+  // CHECK-NEXT: return
+  %0 = sdy.reshard %arg0 <@mesh3d, [{}, {"z"}]> : tensor<16x8xf32>
+  return %0 : tensor<16x8xf32>
+}
+
 // CHECK-LABEL: func @all_gather_multiple_dims
 func.func @all_gather_multiple_dims(%arg0 : tensor<16x8xf32> {sdy.sharding = #sdy.sharding<@mesh3d, [{"y", "z"}, {"x"}]>}) -> tensor<16x8xf32> {
   // CHECK-NEXT: sdy.all_gather [{"z"}, {}] %arg0 out_sharding=<@mesh3d, [{"y"}, {"x"}]>
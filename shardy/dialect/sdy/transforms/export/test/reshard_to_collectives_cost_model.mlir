@@ -0,0 +1,47 @@
+// RUN: sdy_opt %s -sdy-reshard-to-collectives='enable-cost-model=true' | FileCheck %s
+
+sdy.mesh @mesh = <["dcn"=2, "ici"=2]> {sdy.axis_bandwidths = {dcn = 1.0, ici = 10.0}}
+sdy.mesh @mesh_no_bandwidths = <["x"=2, "y"=2]>
+
+// Gathering the fast axis and slicing the slow one is cheaper than a
+// collective permute over both axes.
+// CHECK-LABEL: func @all_gather_fast_axis_then_all_slice
+func.func @all_gather_fast_axis_then_all_slice(%arg0 : tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"ici"}]>}) -> tensor<8xf32> {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = sdy.all_gather [{"ici"}] %arg0 out_sharding=<@mesh, [{}]>
+  // CHECK-NEXT: %[[ALL_SLICE:.*]] = sdy.all_slice [{"dcn"}] %[[ALL_GATHER]] out_sharding=<@mesh, [{"dcn"}]>
+  // CHECK-NEXT: return %[[ALL_SLICE]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"dcn"}]> : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// Gathering the slow axis costs the same as a collective permute, so the
+// default order is kept.
+// CHECK-LABEL: func @all_gather_slow_axis_keeps_collective_permute
+func.func @all_gather_slow_axis_keeps_collective_permute(%arg0 : tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"dcn"}]>}) -> tensor<8xf32> {
+  // CHECK-NEXT: %[[CP:.*]] = sdy.collective_permute %arg0 out_sharding=<@mesh, [{"ici"}]>
+  // CHECK-NEXT: return %[[CP]]
+  %0 = sdy.reshard %arg0 <@mesh, [{"ici"}]> : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// Without bandwidths, all axes have the same bandwidth and the default order
+// is kept.
+// CHECK-LABEL: func @no_bandwidths_keeps_default_order
+func.func @no_bandwidths_keeps_default_order(%arg0 : tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh_no_bandwidths, [{"y"}]>}) -> tensor<8xf32> {
+  // CHECK-NEXT: %[[CP:.*]] = sdy.collective_permute %arg0 out_sharding=<@mesh_no_bandwidths, [{"x"}]>
+  // CHECK-NEXT: return %[[CP]]
+  %0 = sdy.reshard %arg0 <@mesh_no_bandwidths, [{"x"}]> : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// Gathering only the minor-most axis "y" and moving "x" with an all-to-all is
+// cheaper than a collective permute followed by the same all-to-all and
+// all-gather.
+// CHECK-LABEL: func @all_gather_minor_most_axis_then_all_to_all
+func.func @all_gather_minor_most_axis_then_all_to_all(%arg0 : tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh_no_bandwidths, [{"x", "y"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh_no_bandwidths, [{"x"}, {}]>
+  // CHECK-NEXT: %[[ALL_TO_ALL:.*]] = sdy.all_to_all [{"x"}: 0->1] %[[ALL_GATHER]] out_sharding=<@mesh_no_bandwidths, [{}, {"x"}]>
+  // CHECK-NEXT: return %[[ALL_TO_ALL]]
+  %0 = sdy.reshard %arg0 <@mesh_no_bandwidths, [{}, {"x"}]> : tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
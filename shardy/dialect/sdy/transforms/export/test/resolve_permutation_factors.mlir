@@ -397,3 +397,142 @@ func.func @slice_partition_partial_dim_with_communication(
   // CHECK-NEXT: return %[[RES]]
   return %1 : tensor<3xi32>
 }
+
+// CHECK-LABEL: func @reduce_window_same_padding
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {"b"}]>})
+func.func @reduce_window_same_padding(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {"b"}]>})
+  -> (tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {"b"}]>}) {
+  // CHECK: %[[CST:.*]] = stablehlo.constant dense<0xFF800000>
+  %cst = stablehlo.constant dense<0xFF800000> : tensor<f32>
+  // REPL: %[[RESHARD_IN:.*]] = sdy.reshard %[[ARG0]] <@mesh, [{}, {"b"}]> : tensor<8x8xf32>
+  // REPL: %[[RW:.*]] = "stablehlo.reduce_window"(%[[RESHARD_IN]], %[[CST]])
+  // REPL: %[[RES:.*]] = sdy.reshard %[[RW]] <@mesh, [{"a"}, {"b"}]> : tensor<8x8xf32>
+
+  // HALO:      %[[RES:.*]] = sdy.manual_computation(%[[ARG0]], %[[CST]])
+  // HALO-SAME:   in_shardings=[<@mesh, [{"a"}, {"b"}]>, <@mesh, []>]
+  // HALO-SAME:   out_shardings=[<@mesh, [{"a"}, {"b"}]>]
+  // HALO-SAME:   manual_axes={"a"}
+  // HALO-SAME:   (%[[LOCAL_IN:.*]]: tensor<4x8xf32>, %[[INIT:.*]]: tensor<f32>) {
+  // HALO-NEXT:   %[[LOW_SLICE:.*]] = stablehlo.slice %[[LOCAL_IN]] [3:4, 0:8]
+  // HALO-NEXT:   %[[LOW_CP:.*]] = "stablehlo.collective_permute"(%[[LOW_SLICE]])
+  // HALO-SAME{LITERAL}: source_target_pairs = dense<[[0, 2], [1, 3]]> : tensor<2x2xi64>
+  // HALO-NEXT:   %[[TRUE_0:.*]] = stablehlo.constant {{.*}}dense<true> : tensor<i1>
+  // HALO-NEXT:   %[[LOW_VALID:.*]] = "stablehlo.collective_permute"(%[[TRUE_0]])
+  // HALO-SAME{LITERAL}: source_target_pairs = dense<[[0, 2], [1, 3]]> : tensor<2x2xi64>
+  // HALO-NEXT:   %[[INIT_0:.*]] = stablehlo.broadcast_in_dim %[[INIT]], dims = []
+  // HALO-NEXT:   %[[LOW_HALO:.*]] = stablehlo.select %[[LOW_VALID]], %[[LOW_CP]], %[[INIT_0]]
+  // HALO-NEXT:   %[[HIGH_SLICE:.*]] = stablehlo.slice %[[LOCAL_IN]] [0:1, 0:8]
+  // HALO-NEXT:   %[[HIGH_CP:.*]] = "stablehlo.collective_permute"(%[[HIGH_SLICE]])
+  // HALO-SAME{LITERAL}: source_target_pairs = dense<[[2, 0], [3, 1]]> : tensor<2x2xi64>
+  // HALO-NEXT:   %[[TRUE_1:.*]] = stablehlo.constant {{.*}}dense<true> : tensor<i1>
+  // HALO-NEXT:   %[[HIGH_VALID:.*]] = "stablehlo.collective_permute"(%[[TRUE_1]])
+  // HALO-SAME{LITERAL}: source_target_pairs = dense<[[2, 0], [3, 1]]> : tensor<2x2xi64>
+  // HALO-NEXT:   %[[INIT_1:.*]] = stablehlo.broadcast_in_dim %[[INIT]], dims = []
+  // HALO-NEXT:   %[[HIGH_HALO:.*]] = stablehlo.select %[[HIGH_VALID]], %[[HIGH_CP]], %[[INIT_1]]
+  // HALO-NEXT:   %[[CONCAT:.*]] = stablehlo.concatenate %[[LOW_HALO]], %[[LOCAL_IN]], %[[HIGH_HALO]], dim = 0
+  // HALO-SAME:     {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"b"}]>]>} : (tensor<1x8xf32>, tensor<4x8xf32>, tensor<1x8xf32>) -> tensor<6x8xf32>
+  // HALO-NEXT:   %[[RW:.*]] = "stablehlo.reduce_window"(%[[CONCAT]], %[[INIT]])
+  // HALO:          padding = dense<0> : tensor<2x2xi64>
+  // HALO-SAME:     sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"b"}]>]>
+  // HALO-SAME:     window_dimensions = array<i64: 3, 1>
+  // HALO-SAME:     (tensor<6x8xf32>, tensor<f32>) -> tensor<4x8xf32>
+  // HALO-NEXT:   sdy.return %[[RW]] : tensor<4x8xf32>
+  // HALO-NEXT: } : (tensor<8x8xf32>, tensor<f32>) -> tensor<8x8xf32>
+  %0 = "stablehlo.reduce_window"(%arg0, %cst) ({
+    ^bb0(%arg1: tensor<f32>, %arg2: tensor<f32>):
+      %1 = stablehlo.maximum %arg1, %arg2 : tensor<f32>
+      stablehlo.return %1 : tensor<f32>
+  }) {
+    window_dimensions = array<i64: 3, 1>,
+    window_strides = array<i64: 1, 1>,
+    padding = dense<[[1, 1], [0, 0]]> : tensor<2x2xi64>,
+    sdy.sharding = #sdy.sharding_per_value<[#sdy.sharding<@mesh, [{"a"}, {"b"}]>]>
+  } : (tensor<8x8xf32>, tensor<f32>) -> tensor<8x8xf32>
+  // CHECK: return %[[RES]] : tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @reduce_window_strided_low_padding_only
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+func.func @reduce_window_strided_low_padding_only(%arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+  -> (tensor<4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>}) {
+  %cst = stablehlo.constant dense<0.0> : tensor<f32>
+  // HALO:      sdy.manual_computation(%[[ARG0]], %{{.*}})
+  // HALO-SAME:   manual_axes={"a"}
+  // HALO-SAME:   (%[[LOCAL_IN:.*]]: tensor<4xf32>, %[[INIT:.*]]: tensor<f32>) {
+  // HALO-NEXT:   %[[LOW_SLICE:.*]] = stablehlo.slice %[[LOCAL_IN]] [3:4]
+  // HALO-NOT:    stablehlo.slice
+  // HALO:        stablehlo.concatenate %{{.*}}, %[[LOCAL_IN]], dim = 0
+  // HALO-SAME:     (tensor<1xf32>, tensor<4xf32>) -> tensor<5xf32>
+  // HALO-NEXT:   "stablehlo.reduce_window"
+  // HALO-SAME:     (tensor<5xf32>, tensor<f32>) -> tensor<2xf32>
+  %0 = "stablehlo.reduce_window"(%arg0, %cst) ({
+    ^bb0(%arg1: tensor<f32>, %arg2: tensor<f32>):
+      %1 = stablehlo.add %arg1, %arg2 : tensor<f32>
+      stablehlo.return %1 : tensor<f32>
+  }) {
+    window_dimensions = array<i64: 3>,
+    window_strides = array<i64: 2>,
+    padding = dense<[[1, 0]]> : tensor<1x2xi64>,
+    sdy.sharding = #sdy.sharding_per_value<[#sdy.sharding<@mesh, [{"a"}]>]>
+  } : (tensor<8xf32>, tensor<f32>) -> tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+
+// CHECK-LABEL: func @reduce_window_halo_larger_than_shard
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+func.func @reduce_window_halo_larger_than_shard(%arg0: tensor<4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+  -> (tensor<4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>}) {
+  %cst = stablehlo.constant dense<0.0> : tensor<f32>
+  // CHECK-NOT: sdy.manual_computation
+  // CHECK:     %[[RESHARD_IN:.*]] = sdy.reshard %[[ARG0]] <@mesh, [{}]> : tensor<4xf32>
+  // CHECK:     "stablehlo.reduce_window"(%[[RESHARD_IN]], %{{.*}})
+  %0 = "stablehlo.reduce_window"(%arg0, %cst) ({
+    ^bb0(%arg1: tensor<f32>, %arg2: tensor<f32>):
+      %1 = stablehlo.add %arg1, %arg2 : tensor<f32>
+      stablehlo.return %1 : tensor<f32>
+  }) {
+    window_dimensions = array<i64: 7>,
+    padding = dense<[[3, 3]]> : tensor<1x2xi64>,
+    sdy.sharding = #sdy.sharding_per_value<[#sdy.sharding<@mesh, [{"a"}]>]>
+  } : (tensor<4xf32>, tensor<f32>) -> tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+
+// CHECK-LABEL: func @convolution_same_padding
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<2x8x4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"a"}, {}]>},
+// CHECK-SAME:  %[[ARG1:.*]]: tensor<3x4x4xf32>)
+func.func @convolution_same_padding(
+    %arg0: tensor<2x8x4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"a"}, {}]>},
+    %arg1: tensor<3x4x4xf32>)
+    -> (tensor<2x8x4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"a"}, {}]>}) {
+  // REPL: %[[RESHARD_IN:.*]] = sdy.reshard %[[ARG0]] <@mesh, [{}, {}, {}]> : tensor<2x8x4xf32>
+  // REPL: stablehlo.convolution(%[[RESHARD_IN]], %[[ARG1]])
+
+  // HALO:      %[[RES:.*]] = sdy.manual_computation(%[[ARG0]], %[[ARG1]])
+  // HALO-SAME:   in_shardings=[<@mesh, [{}, {"a"}, {}]>, <@mesh, [{}, {}, {}]>]
+  // HALO-SAME:   out_shardings=[<@mesh, [{}, {"a"}, {}]>]
+  // HALO-SAME:   manual_axes={"a"}
+  // HALO-SAME:   (%[[LOCAL_LHS:.*]]: tensor<2x4x4xf32>, %[[LOCAL_RHS:.*]]: tensor<3x4x4xf32>) {
+  // HALO-NEXT:   %[[LOW_SLICE:.*]] = stablehlo.slice %[[LOCAL_LHS]] [0:2, 3:4, 0:4]
+  // HALO-NEXT:   %[[LOW_HALO:.*]] = "stablehlo.collective_permute"(%[[LOW_SLICE]])
+  // HALO-SAME{LITERAL}: source_target_pairs = dense<[[0, 2], [1, 3]]> : tensor<2x2xi64>
+  // HALO-NEXT:   %[[HIGH_SLICE:.*]] = stablehlo.slice %[[LOCAL_LHS]] [0:2, 0:1, 0:4]
+  // HALO-NEXT:   %[[HIGH_HALO:.*]] = "stablehlo.collective_permute"(%[[HIGH_SLICE]])
+  // HALO-SAME{LITERAL}: source_target_pairs = dense<[[2, 0], [3, 1]]> : tensor<2x2xi64>
+  // HALO-NEXT:   %[[CONCAT:.*]] = stablehlo.concatenate %[[LOW_HALO]], %[[LOCAL_LHS]], %[[HIGH_HALO]], dim = 1
+  // HALO-NEXT:   %[[CONV:.*]] = stablehlo.convolution(%[[CONCAT]], %[[LOCAL_RHS]])
+  // HALO-SAME{LITERAL}: window = {stride = [1], pad = [[0, 0]]}
+  // HALO-SAME:     (tensor<2x6x4xf32>, tensor<3x4x4xf32>) -> tensor<2x4x4xf32>
+  // HALO-NEXT:   sdy.return %[[CONV]] : tensor<2x4x4xf32>
+  // HALO-NEXT: } : (tensor<2x8x4xf32>, tensor<3x4x4xf32>) -> tensor<2x8x4xf32>
+  %0 = stablehlo.convolution(%arg0, %arg1)
+    dim_numbers = [b, 0, f] x [0, i, o] -> [b, 0, f],
+    window = {stride = [1], pad = [[1, 1]]} {
+      batch_group_count = 1 : i64,
+      feature_group_count = 1 : i64,
+      sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"a"}, {}]>]>
+    }
+    : (tensor<2x8x4xf32>, tensor<3x4x4xf32>) -> tensor<2x8x4xf32>
+  return %0 : tensor<2x8x4xf32>
+}
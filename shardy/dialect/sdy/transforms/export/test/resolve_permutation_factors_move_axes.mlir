@@ -0,0 +1,67 @@
+// RUN: sdy_opt %s -sdy-resolve-permutation-factors="enable-halo-exchange=false move-permutation-axes=true" | FileCheck %s
+
+sdy.mesh @mesh = <["a"=2, "b"=2]>
+
+// CHECK-LABEL: func @reverse_axes_moved_to_pass_through_dim
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<8x8xi32>
+func.func @reverse_axes_moved_to_pass_through_dim(
+  %arg0: tensor<8x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", "b"}, {}]>})
+  -> (tensor<8x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", "b"}, {}]>}) {
+  // CHECK-NEXT: %[[RESHARD_IN:.*]] = sdy.reshard %[[ARG0]] <@mesh, [{}, {"a", "b"}]> : tensor<8x8xi32>
+  // CHECK-NEXT: %[[REV:.*]] = stablehlo.reverse %[[RESHARD_IN]], dims = [0]
+  // CHECK-SAME: {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"a", "b"}]>]>}
+  // CHECK-NEXT: %[[RES:.*]] = sdy.reshard %[[REV]] <@mesh, [{"a", "b"}, {}]> : tensor<8x8xi32>
+  // CHECK-NEXT: return %[[RES]]
+  %0 = stablehlo.reverse %arg0, dims = [0]
+    {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a", "b"}, {}]>]>}
+    : tensor<8x8xi32>
+  return %0 : tensor<8x8xi32>
+}
+
+// CHECK-LABEL: func @reverse_pass_through_dim_already_sharded
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<8x8xi32>
+func.func @reverse_pass_through_dim_already_sharded(
+  %arg0: tensor<8x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {"b"}]>})
+  -> (tensor<8x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {"b"}]>}) {
+  // CHECK-NEXT: %[[RESHARD_IN:.*]] = sdy.reshard %[[ARG0]] <@mesh, [{}, {"b"}]> : tensor<8x8xi32>
+  // CHECK-NEXT: %[[REV:.*]] = stablehlo.reverse %[[RESHARD_IN]], dims = [0]
+  // CHECK-SAME: {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {"b"}]>]>}
+  // CHECK-NEXT: %[[RES:.*]] = sdy.reshard %[[REV]] <@mesh, [{"a"}, {"b"}]> : tensor<8x8xi32>
+  // CHECK-NEXT: return %[[RES]]
+  %0 = stablehlo.reverse %arg0, dims = [0]
+    {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a"}, {"b"}]>]>}
+    : tensor<8x8xi32>
+  return %0 : tensor<8x8xi32>
+}
+
+// CHECK-LABEL: func @reverse_pass_through_dim_not_divisible
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<8x6xi32>
+func.func @reverse_pass_through_dim_not_divisible(
+  %arg0: tensor<8x6xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", "b"}, {}]>})
+  -> (tensor<8x6xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", "b"}, {}]>}) {
+  // CHECK-NEXT: %[[RESHARD_IN:.*]] = sdy.reshard %[[ARG0]] <@mesh, [{}, {}]> : tensor<8x6xi32>
+  // CHECK-NEXT: %[[REV:.*]] = stablehlo.reverse %[[RESHARD_IN]], dims = [0]
+  // CHECK-SAME: {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {}]>]>}
+  %0 = stablehlo.reverse %arg0, dims = [0]
+    {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a", "b"}, {}]>]>}
+    : tensor<8x6xi32>
+  return %0 : tensor<8x6xi32>
+}
+
+// Moving the axes would require an all-to-all of the much larger result, which
+// communicates more than all-gathering the operand.
+//
+// CHECK-LABEL: func @pad_replicated_when_cheaper
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<8x8xi32>
+func.func @pad_replicated_when_cheaper(
+  %arg0: tensor<8x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>})
+  -> (tensor<24x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>}) {
+  // CHECK: %[[RESHARD_IN:.*]] = sdy.reshard %[[ARG0]] <@mesh, [{}, {}]> : tensor<8x8xi32>
+  // CHECK-NEXT: %[[PAD:.*]] = stablehlo.pad %[[RESHARD_IN]]
+  // CHECK-SAME: {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}, {}]>]>}
+  %cst = stablehlo.constant dense<0> : tensor<i32>
+  %0 = stablehlo.pad %arg0, %cst, low = [0, 0], high = [16, 0], interior = [0, 0]
+    {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a"}, {}]>]>}
+    : (tensor<8x8xi32>, tensor<i32>) -> tensor<24x8xi32>
+  return %0 : tensor<24x8xi32>
+}
@@ -0,0 +1,123 @@
+// RUN: sdy_opt %s -sdy-resolve-permutation-factors="enable-parallel-prefix=true" | FileCheck %s
+
+sdy.mesh @mesh = <["a"=2, "b"=2]>
+
+// CHECK-LABEL: func @cumulative_sum
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+func.func @cumulative_sum(%arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+  -> (tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>}) {
+  // CHECK:      %[[CST:.*]] = stablehlo.constant dense<0.000000e+00>
+  // CHECK-NEXT: %[[RES:.*]] = sdy.manual_computation(%[[ARG0]], %[[CST]])
+  // CHECK-SAME:   in_shardings=[<@mesh, [{"a"}]>, <@mesh, []>]
+  // CHECK-SAME:   out_shardings=[<@mesh, [{"a"}]>]
+  // CHECK-SAME:   manual_axes={"a"}
+  // CHECK-SAME:   (%[[LOCAL_IN:.*]]: tensor<4xf32>, %[[INIT:.*]]: tensor<f32>) {
+  // CHECK-NEXT:   %[[RW:.*]] = "stablehlo.reduce_window"(%[[LOCAL_IN]], %[[INIT]])
+  // CHECK:          padding = dense<{{\[\[}}3, 0]]> : tensor<1x2xi64>
+  // CHECK-SAME:     sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}]>]>
+  // CHECK-SAME:     window_dimensions = array<i64: 4>
+  // CHECK-SAME:     (tensor<4xf32>, tensor<f32>) -> tensor<4xf32>
+  // CHECK-NEXT:   %[[TOTAL:.*]] = stablehlo.slice %[[RW]] [3:4]
+  // CHECK-NEXT:   %[[TOTAL_CP:.*]] = "stablehlo.collective_permute"(%[[TOTAL]])
+  // CHECK-SAME{LITERAL}: source_target_pairs = dense<[[0, 2], [1, 3]]> : tensor<2x2xi64>
+  // CHECK-NEXT:   %[[TRUE:.*]] = stablehlo.constant {{.*}}dense<true> : tensor<i1>
+  // CHECK-NEXT:   %[[VALID:.*]] = "stablehlo.collective_permute"(%[[TRUE]])
+  // CHECK-SAME{LITERAL}: source_target_pairs = dense<[[0, 2], [1, 3]]> : tensor<2x2xi64>
+  // CHECK-NEXT:   %[[INIT_BCAST:.*]] = stablehlo.broadcast_in_dim %[[INIT]], dims = []
+  // CHECK-NEXT:   %[[PREFIX:.*]] = stablehlo.select %[[VALID]], %[[TOTAL_CP]], %[[INIT_BCAST]]
+  // CHECK-NEXT:   %[[PREFIX_BCAST:.*]] = stablehlo.broadcast_in_dim %[[PREFIX]], dims = [0]
+  // CHECK-SAME:     (tensor<1xf32>) -> tensor<4xf32>
+  // CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %[[PREFIX_BCAST]], %[[RW]]
+  // CHECK-SAME:     {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{}]>]>} : tensor<4xf32>
+  // CHECK-NEXT:   sdy.return %[[ADD]] : tensor<4xf32>
+  // CHECK-NEXT: } : (tensor<8xf32>, tensor<f32>) -> tensor<8xf32>
+  %cst = stablehlo.constant dense<0.0> : tensor<f32>
+  %0 = "stablehlo.reduce_window"(%arg0, %cst) ({
+    ^bb0(%arg1: tensor<f32>, %arg2: tensor<f32>):
+      %1 = stablehlo.add %arg1, %arg2 : tensor<f32>
+      stablehlo.return %1 : tensor<f32>
+  }) {
+    window_dimensions = array<i64: 8>,
+    padding = dense<[[7, 0]]> : tensor<1x2xi64>,
+    sdy.sharding = #sdy.sharding_per_value<[#sdy.sharding<@mesh, [{"a"}]>]>
+  } : (tensor<8xf32>, tensor<f32>) -> tensor<8xf32>
+  // CHECK: return %[[RES]] : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func @reverse_cumulative_sum_multiple_axes
+// CHECK-SAME: (%[[ARG0:.*]]: tensor<2x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"a", "b"}]>})
+func.func @reverse_cumulative_sum_multiple_axes(%arg0: tensor<2x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"a", "b"}]>})
+  -> (tensor<2x8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"a", "b"}]>}) {
+  // CHECK:      sdy.manual_computation
+  // CHECK-SAME:   manual_axes={"a", "b"}
+  // CHECK-SAME:   (%[[LOCAL_IN:.*]]: tensor<2x2xi32>, %[[INIT:.*]]: tensor<i32>) {
+  // CHECK-NEXT:   %[[RW:.*]] = "stablehlo.reduce_window"(%[[LOCAL_IN]], %[[INIT]])
+  // CHECK:          padding = dense<{{\[\[}}0, 0], [0, 1]]> : tensor<2x2xi64>
+  // CHECK-SAME:     window_dimensions = array<i64: 1, 2>
+  // CHECK-SAME:     (tensor<2x2xi32>, tensor<i32>) -> tensor<2x2xi32>
+  // CHECK-NEXT:   %[[TOTAL:.*]] = stablehlo.slice %[[RW]] [0:2, 0:1]
+  // CHECK-NEXT:   %[[CP_0:.*]] = "stablehlo.collective_permute"(%[[TOTAL]])
+  // CHECK-SAME{LITERAL}: source_target_pairs = dense<[[1, 0], [2, 1], [3, 2]]> : tensor<3x2xi64>
+  // CHECK:        %[[PREFIX_0:.*]] = stablehlo.select %{{.*}}, %[[CP_0]], %{{.*}}
+  // CHECK-NEXT:   %[[CP_1:.*]] = "stablehlo.collective_permute"(%[[PREFIX_0]])
+  // CHECK-SAME{LITERAL}: source_target_pairs = dense<[[1, 0], [2, 1], [3, 2]]> : tensor<3x2xi64>
+  // CHECK:        %[[SHIFTED_1:.*]] = stablehlo.select %{{.*}}, %[[CP_1]], %{{.*}}
+  // CHECK-NEXT:   %[[PREFIX_1:.*]] = stablehlo.add %[[SHIFTED_1]], %[[PREFIX_0]] {{.*}} : tensor<2x1xi32>
+  // CHECK-NEXT:   %[[CP_2:.*]] = "stablehlo.collective_permute"(%[[PREFIX_1]])
+  // CHECK-SAME{LITERAL}: source_target_pairs = dense<[[2, 0], [3, 1]]> : tensor<2x2xi64>
+  // CHECK:        %[[SHIFTED_2:.*]] = stablehlo.select %{{.*}}, %[[CP_2]], %{{.*}}
+  // CHECK-NEXT:   %[[PREFIX_2:.*]] = stablehlo.add %[[SHIFTED_2]], %[[PREFIX_1]] {{.*}} : tensor<2x1xi32>
+  // CHECK-NEXT:   %[[PREFIX_BCAST:.*]] = stablehlo.broadcast_in_dim %[[PREFIX_2]], dims = [0, 1]
+  // CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %[[PREFIX_BCAST]], %[[RW]]
+  // CHECK-NEXT:   sdy.return %[[ADD]] : tensor<2x2xi32>
+  %cst = stablehlo.constant dense<0> : tensor<i32>
+  %0 = "stablehlo.reduce_window"(%arg0, %cst) ({
+    ^bb0(%arg1: tensor<i32>, %arg2: tensor<i32>):
+      %1 = stablehlo.add %arg1, %arg2 : tensor<i32>
+      stablehlo.return %1 : tensor<i32>
+  }) {
+    window_dimensions = array<i64: 1, 8>,
+    padding = dense<[[0, 0], [0, 7]]> : tensor<2x2xi64>,
+    sdy.sharding = #sdy.sharding_per_value<[#sdy.sharding<@mesh, [{}, {"a", "b"}]>]>
+  } : (tensor<2x8xi32>, tensor<i32>) -> tensor<2x8xi32>
+  return %0 : tensor<2x8xi32>
+}
+
+// CHECK-LABEL: func @cumulative_max_not_supported
+func.func @cumulative_max_not_supported(%arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+  -> (tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>}) {
+  // CHECK-NOT: sdy.manual_computation
+  // CHECK:     %[[RESHARD_IN:.*]] = sdy.reshard %arg0 <@mesh, [{}]> : tensor<8xf32>
+  // CHECK:     "stablehlo.reduce_window"(%[[RESHARD_IN]], %{{.*}})
+  %cst = stablehlo.constant dense<0xFF800000> : tensor<f32>
+  %0 = "stablehlo.reduce_window"(%arg0, %cst) ({
+    ^bb0(%arg1: tensor<f32>, %arg2: tensor<f32>):
+      %1 = stablehlo.maximum %arg1, %arg2 : tensor<f32>
+      stablehlo.return %1 : tensor<f32>
+  }) {
+    window_dimensions = array<i64: 8>,
+    padding = dense<[[7, 0]]> : tensor<1x2xi64>,
+    sdy.sharding = #sdy.sharding_per_value<[#sdy.sharding<@mesh, [{"a"}]>]>
+  } : (tensor<8xf32>, tensor<f32>) -> tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func @cumulative_sum_non_identity_init
+func.func @cumulative_sum_non_identity_init(%arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>})
+  -> (tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>}) {
+  // CHECK-NOT: sdy.manual_computation
+  // CHECK:     %[[RESHARD_IN:.*]] = sdy.reshard %arg0 <@mesh, [{}]> : tensor<8xf32>
+  // CHECK:     "stablehlo.reduce_window"(%[[RESHARD_IN]], %{{.*}})
+  %cst = stablehlo.constant dense<1.0> : tensor<f32>
+  %0 = "stablehlo.reduce_window"(%arg0, %cst) ({
+    ^bb0(%arg1: tensor<f32>, %arg2: tensor<f32>):
+      %1 = stablehlo.add %arg1, %arg2 : tensor<f32>
+      stablehlo.return %1 : tensor<f32>
+  }) {
+    window_dimensions = array<i64: 8>,
+    padding = dense<[[7, 0]]> : tensor<1x2xi64>,
+    sdy.sharding = #sdy.sharding_per_value<[#sdy.sharding<@mesh, [{"a"}]>]>
+  } : (tensor<8xf32>, tensor<f32>) -> tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
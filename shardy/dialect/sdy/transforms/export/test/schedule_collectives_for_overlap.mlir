@@ -0,0 +1,88 @@
+// RUN: sdy_opt %s -split-input-file -sdy-schedule-collectives-for-overlap | FileCheck %s
+
+sdy.mesh @mesh = <["x"=2, "y"=2]>
+
+// CHECK-LABEL: func @all_gather_moved_to_start
+func.func @all_gather_moved_to_start(
+    %arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}]>},
+    %arg1: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}]>})
+    -> tensor<8xf32> {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = sdy.all_gather [{"x"}] %arg1 out_sharding=<@mesh, [{}]>
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %arg0, %arg0
+  // CHECK-NEXT: %[[MUL:.*]] = stablehlo.multiply %[[ADD]], %[[ADD]]
+  // CHECK-NEXT: %[[ADD_2:.*]] = stablehlo.add %[[MUL]], %[[ALL_GATHER]]
+  // CHECK-NEXT: return %[[ADD_2]]
+  %0 = stablehlo.add %arg0, %arg0 : tensor<8xf32>
+  %1 = stablehlo.multiply %0, %0 : tensor<8xf32>
+  %2 = sdy.all_gather [{"x"}] %arg1 out_sharding=<@mesh, [{}]> : tensor<8xf32>
+  %3 = stablehlo.add %1, %2 : tensor<8xf32>
+  return %3 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func @all_reduce_moved_after_operand
+func.func @all_reduce_moved_after_operand(%arg0: tensor<8xf32>, %arg1: tensor<8xf32>) -> tensor<8xf32> {
+  // CHECK-NEXT: %[[NEG:.*]] = stablehlo.negate %arg1
+  // CHECK-NEXT: %[[ALL_REDUCE:.*]] = sdy.all_reduce {"x"} %[[NEG]] out_sharding=<@mesh, [{}]>
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %arg0, %arg0
+  // CHECK-NEXT: %[[MUL:.*]] = stablehlo.multiply %[[ADD]], %[[ALL_REDUCE]]
+  // CHECK-NEXT: return %[[MUL]]
+  %0 = stablehlo.negate %arg1 : tensor<8xf32>
+  %1 = stablehlo.add %arg0, %arg0 : tensor<8xf32>
+  %2 = sdy.all_reduce {"x"} %0 out_sharding=<@mesh, [{}]> : tensor<8xf32>
+  %3 = stablehlo.multiply %1, %2 : tensor<8xf32>
+  return %3 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func @order_of_collectives_preserved
+func.func @order_of_collectives_preserved(
+    %arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}]>},
+    %arg1: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"y"}]>})
+    -> tensor<8xf32> {
+  // CHECK-NEXT: %[[NEG:.*]] = stablehlo.negate %arg0
+  // CHECK-NEXT: %[[ALL_GATHER_0:.*]] = sdy.all_gather [{"x"}] %[[NEG]] out_sharding=<@mesh, [{}]>
+  // CHECK-NEXT: %[[ALL_GATHER_1:.*]] = sdy.all_gather [{"y"}] %arg1 out_sharding=<@mesh, [{}]>
+  // CHECK-NEXT: %[[ABS:.*]] = stablehlo.abs %[[ALL_GATHER_0]]
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %[[ABS]], %[[ALL_GATHER_1]]
+  // CHECK-NEXT: return %[[ADD]]
+  %0 = stablehlo.negate %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}]>]>} : tensor<8xf32>
+  %1 = sdy.all_gather [{"x"}] %0 out_sharding=<@mesh, [{}]> : tensor<8xf32>
+  %2 = stablehlo.abs %1 : tensor<8xf32>
+  %3 = sdy.all_gather [{"y"}] %arg1 out_sharding=<@mesh, [{}]> : tensor<8xf32>
+  %4 = stablehlo.add %2, %3 : tensor<8xf32>
+  return %4 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func @not_moved_above_side_effecting_op
+func.func @not_moved_above_side_effecting_op(
+    %arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}]>},
+    %arg1: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}]>})
+    -> tensor<8xf32> {
+  // CHECK-NEXT: %[[ADD:.*]] = stablehlo.add %arg0, %arg0
+  // CHECK-NEXT: stablehlo.custom_call @foo(%[[ADD]]) {has_side_effect = true}
+  // CHECK-NEXT: %[[PERMUTE:.*]] = sdy.collective_permute %arg1 out_sharding=<@mesh, [{"x"}]>
+  // CHECK-NEXT: %[[MUL:.*]] = stablehlo.multiply %[[ADD]], %[[ADD]]
+  // CHECK-NEXT: %[[ADD_2:.*]] = stablehlo.add %[[MUL]], %[[PERMUTE]]
+  %0 = stablehlo.add %arg0, %arg0 : tensor<8xf32>
+  stablehlo.custom_call @foo(%0) {has_side_effect = true} : (tensor<8xf32>) -> ()
+  %1 = stablehlo.multiply %0, %0 : tensor<8xf32>
+  %2 = sdy.collective_permute %arg1 out_sharding=<@mesh, [{"x"}]> : tensor<8xf32>
+  %3 = stablehlo.add %1, %2 : tensor<8xf32>
+  return %3 : tensor<8xf32>
+}
+
+// CHECK-LABEL: func @nested_region
+func.func @nested_region(%arg0: tensor<8xf32>, %arg1: tensor<8xf32>) -> tensor<8xf32> {
+  // CHECK:      stablehlo.case
+  // CHECK-NEXT:   %[[ALL_REDUCE:.*]] = sdy.all_reduce {"y"} %arg1 out_sharding=<@mesh, [{}]>
+  // CHECK-NEXT:   %[[ADD:.*]] = stablehlo.add %arg0, %arg0
+  // CHECK-NEXT:   %[[MUL:.*]] = stablehlo.multiply %[[ADD]], %[[ALL_REDUCE]]
+  // CHECK-NEXT:   stablehlo.return %[[MUL]]
+  %c = stablehlo.constant dense<0> : tensor<i32>
+  %0 = "stablehlo.case"(%c) ({
+    %1 = stablehlo.add %arg0, %arg0 : tensor<8xf32>
+    %2 = sdy.all_reduce {"y"} %arg1 out_sharding=<@mesh, [{}]> : tensor<8xf32>
+    %3 = stablehlo.multiply %1, %2 : tensor<8xf32>
+    stablehlo.return %3 : tensor<8xf32>
+  }) : (tensor<i32>) -> tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
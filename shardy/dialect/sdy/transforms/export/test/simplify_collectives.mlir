@@ -0,0 +1,115 @@
+// RUN: sdy_opt %s -sdy-simplify-collectives | FileCheck %s
+
+sdy.mesh @mesh = <["x"=2, "y"=2, "z"=2]>
+sdy.mesh @mesh_non_iota = <["x"=2, "y"=2, "z"=2], device_ids=[7, 6, 5, 4, 3, 2, 1, 0]>
+
+// CHECK-LABEL: func @no_axes
+func.func @no_axes(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: return %arg0
+  %0 = sdy.all_gather [{}, {}] %arg0 out_sharding=<@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_slice [{}, {}] %0 out_sharding=<@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @all_gather_of_all_slice_same_axes
+func.func @all_gather_of_all_slice_same_axes(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: return %arg0
+  %0 = sdy.all_slice [{"y"}, {"z"}] %arg0 out_sharding=<@mesh, [{"x", "y"}, {"z"}]> : tensor<8x8xf32>
+  %1 = sdy.all_gather [{"y"}, {"z"}] %0 out_sharding=<@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @all_slice_of_all_gather_same_axes_multiple_uses
+func.func @all_slice_of_all_gather_same_axes_multiple_uses(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x", "y"}, {}]>}) -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh, [{"x"}, {}]>
+  // CHECK-NEXT: return %arg0, %[[ALL_GATHER]]
+  %0 = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_slice [{"y"}, {}] %0 out_sharding=<@mesh, [{"x", "y"}, {}]> : tensor<8x8xf32>
+  return %1, %0 : tensor<8x8xf32>, tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @all_gather_of_all_slice_net_gather
+func.func @all_gather_of_all_slice_net_gather(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = sdy.all_gather [{"x"}, {}] %arg0 out_sharding=<@mesh, [{}, {}]>
+  // CHECK-NEXT: return %[[ALL_GATHER]]
+  %0 = sdy.all_slice [{"y"}, {}] %arg0 out_sharding=<@mesh, [{"x", "y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_gather [{"x", "y"}, {}] %0 out_sharding=<@mesh, [{}, {}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @all_gather_of_all_slice_net_slice
+func.func @all_gather_of_all_slice_net_slice(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[ALL_SLICE:.*]] = sdy.all_slice [{"x"}, {}] %arg0 out_sharding=<@mesh, [{"x"}, {}]>
+  // CHECK-NEXT: return %[[ALL_SLICE]]
+  %0 = sdy.all_slice [{"x", "y"}, {}] %arg0 out_sharding=<@mesh, [{"x", "y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_gather [{"y"}, {}] %0 out_sharding=<@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @chain_of_all_gathers
+func.func @chain_of_all_gathers(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x", "y", "z"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = sdy.all_gather [{"x", "y", "z"}, {}] %arg0 out_sharding=<@mesh, [{}, {}]>
+  // CHECK-NEXT: return %[[ALL_GATHER]]
+  %0 = sdy.all_gather [{"z"}, {}] %arg0 out_sharding=<@mesh, [{"x", "y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_gather [{"y"}, {}] %0 out_sharding=<@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  %2 = sdy.all_gather [{"x"}, {}] %1 out_sharding=<@mesh, [{}, {}]> : tensor<8x8xf32>
+  return %2 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @chain_of_all_slices_and_all_gathers
+func.func @chain_of_all_slices_and_all_gathers(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[ALL_SLICE:.*]] = sdy.all_slice [{}, {"z"}] %arg0 out_sharding=<@mesh, [{"x"}, {"z"}]>
+  // CHECK-NEXT: return %[[ALL_SLICE]]
+  %0 = sdy.all_slice [{"y"}, {}] %arg0 out_sharding=<@mesh, [{"x", "y"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_slice [{}, {"z"}] %0 out_sharding=<@mesh, [{"x", "y"}, {"z"}]> : tensor<8x8xf32>
+  %2 = sdy.all_gather [{"y"}, {}] %1 out_sharding=<@mesh, [{"x"}, {"z"}]> : tensor<8x8xf32>
+  return %2 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @gather_and_slice_on_different_dims_not_folded
+func.func @gather_and_slice_on_different_dims_not_folded(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[ALL_GATHER:.*]] = sdy.all_gather [{"x"}, {}] %arg0 out_sharding=<@mesh, [{}, {}]>
+  // CHECK-NEXT: %[[ALL_SLICE:.*]] = sdy.all_slice [{}, {"x"}] %[[ALL_GATHER]] out_sharding=<@mesh, [{}, {"x"}]>
+  // CHECK-NEXT: return %[[ALL_SLICE]]
+  %0 = sdy.all_gather [{"x"}, {}] %arg0 out_sharding=<@mesh, [{}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_slice [{}, {"x"}] %0 out_sharding=<@mesh, [{}, {"x"}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @producer_with_multiple_uses_not_folded
+func.func @producer_with_multiple_uses_not_folded(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x", "y"}, {}]>}) -> (tensor<8x8xf32>, tensor<8x8xf32>) {
+  // CHECK-NEXT: %[[ALL_GATHER_0:.*]] = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh, [{"x"}, {}]>
+  // CHECK-NEXT: %[[ALL_GATHER_1:.*]] = sdy.all_gather [{"x"}, {}] %[[ALL_GATHER_0]] out_sharding=<@mesh, [{}, {}]>
+  // CHECK-NEXT: return %[[ALL_GATHER_1]], %[[ALL_GATHER_0]]
+  %0 = sdy.all_gather [{"y"}, {}] %arg0 out_sharding=<@mesh, [{"x"}, {}]> : tensor<8x8xf32>
+  %1 = sdy.all_gather [{"x"}, {}] %0 out_sharding=<@mesh, [{}, {}]> : tensor<8x8xf32>
+  return %1, %0 : tensor<8x8xf32>, tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @collective_permute_round_trip
+func.func @collective_permute_round_trip(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {"y"}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: return %arg0
+  %0 = sdy.collective_permute %arg0 out_sharding=<@mesh_non_iota, [{"x"}, {"y"}]> : tensor<8x8xf32>
+  %1 = sdy.collective_permute %0 out_sharding=<@mesh, [{"x"}, {"y"}]> : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @chain_of_collective_permutes
+func.func @chain_of_collective_permutes(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {"y"}]>}) -> tensor<8x8xf32> {
+  // CHECK-NEXT: %[[COLLECTIVE_PERMUTE:.*]] = sdy.collective_permute %arg0 out_sharding=<@mesh, [{"y"}, {"x"}]>
+  // CHECK-NEXT: return %[[COLLECTIVE_PERMUTE]]
+  %0 = sdy.collective_permute %arg0 out_sharding=<@mesh, [{"y"}, {"z"}]> : tensor<8x8xf32>
+  %1 = sdy.collective_permute %0 out_sharding=<@mesh, [{"z"}, {"x"}]> : tensor<8x8xf32>
+  %2 = sdy.collective_permute %1 out_sharding=<@mesh, [{"y"}, {"x"}]> : tensor<8x8xf32>
+  return %2 : tensor<8x8xf32>
+}
+
+// CHECK-LABEL: func @chain_of_all_to_alls
+func.func @chain_of_all_to_alls(%arg0 : tensor<64x16x8x8x8x8xf32> {sdy.sharding=#sdy.sharding<@mesh, [{"x"}, {"y"}, {"z"}, {}, {}, {}]>}) -> tensor<64x16x8x8x8x8xf32> {
+  // CHECK-NEXT: %[[ALL_TO_ALL:.*]] = sdy.all_to_all [{"x"}: 0->3, {"y"}: 1->4, {"z"}: 2->5] %arg0 out_sharding=<@mesh, [{}, {}, {}, {"x"}, {"y"}, {"z"}]>
+  // CHECK-NEXT: return %[[ALL_TO_ALL]]
+  %0 = sdy.all_to_all [{"y"}: 1->4] %arg0 out_sharding=<@mesh, [{"x"}, {}, {"z"}, {}, {"y"}, {}]> : tensor<64x16x8x8x8x8xf32>
+  %1 = sdy.all_to_all [{"x"}: 0->3] %0 out_sharding=<@mesh, [{}, {}, {"z"}, {"x"}, {"y"}, {}]> : tensor<64x16x8x8x8x8xf32>
+  %2 = sdy.all_to_all [{"z"}: 2->5] %1 out_sharding=<@mesh, [{}, {}, {}, {"x"}, {"y"}, {"z"}]> : tensor<64x16x8x8x8x8xf32>
+  return %2 : tensor<64x16x8x8x8x8xf32>
+}
@@ -0,0 +1,85 @@
+// RUN: sdy_opt %s -split-input-file -sdy-unflatten-call-graph='dedup-identical-functions=true' | FileCheck %s
+
+sdy.mesh @mesh = <["x"=2, "y"=2]>
+
+// CHECK-LABEL: func @different_origins_same_body(
+func.func @different_origins_same_body(%arg0: tensor<8x2xi32>) -> tensor<8x2xi32> {
+  // CHECK-NEXT: %[[CALL_0:.*]] = call @foo(%arg0)
+  // CHECK-NEXT: %[[CALL_1:.*]] = call @foo(%[[CALL_0]])
+  // CHECK-NEXT: return %[[CALL_1]]
+  %0 = call @foo(%arg0) : (tensor<8x2xi32>) -> tensor<8x2xi32>
+  %1 = call @bar(%0) : (tensor<8x2xi32>) -> tensor<8x2xi32>
+  return %1 : tensor<8x2xi32>
+}
+
+// CHECK-LABEL: func private @foo(
+// CHECK-SAME:    %arg0: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>})
+func.func private @foo(%arg0: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x2xi32> attributes {sdy.original_func_name = "foo"} {
+  %0 = stablehlo.multiply %arg0, %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : tensor<8x2xi32>
+  return %0 : tensor<8x2xi32>
+}
+
+// CHECK-LABEL: func private @bar(
+func.func private @bar(%arg0: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}, {}]>}) -> tensor<8x2xi32> attributes {sdy.original_func_name = "bar"} {
+  %0 = stablehlo.multiply %arg0, %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : tensor<8x2xi32>
+  return %0 : tensor<8x2xi32>
+}
+
+// -----
+
+sdy.mesh @mesh = <["x"=2, "y"=2]>
+
+// CHECK-LABEL: func @same_body_different_internal_shardings(
+func.func @same_body_different_internal_shardings(%arg0: tensor<8x2xi32>) -> tensor<8x2xi32> {
+  // CHECK-NEXT: %[[CALL_0:.*]] = call @foo(%arg0)
+  // CHECK-NEXT: %[[CALL_1:.*]] = call @bar(%[[CALL_0]])
+  %0 = call @foo(%arg0) : (tensor<8x2xi32>) -> tensor<8x2xi32>
+  %1 = call @bar(%0) : (tensor<8x2xi32>) -> tensor<8x2xi32>
+  return %1 : tensor<8x2xi32>
+}
+
+func.func private @foo(%arg0: tensor<8x2xi32>) -> tensor<8x2xi32> attributes {sdy.original_func_name = "foo"} {
+  %0 = stablehlo.multiply %arg0, %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}, {}]>]>} : tensor<8x2xi32>
+  return %0 : tensor<8x2xi32>
+}
+
+func.func private @bar(%arg0: tensor<8x2xi32>) -> tensor<8x2xi32> attributes {sdy.original_func_name = "bar"} {
+  %0 = stablehlo.multiply %arg0, %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"y"}, {}]>]>} : tensor<8x2xi32>
+  return %0 : tensor<8x2xi32>
+}
+
+// -----
+
+// Funcs that only differ in calls to equal funcs are deduplicated too.
+// CHECK-LABEL: func @nested_calls_to_equal_funcs(
+func.func @nested_calls_to_equal_funcs(%arg0: tensor<8xi32>) -> tensor<8xi32> {
+  // CHECK-NEXT: %[[CALL_0:.*]] = call @outer_foo(%arg0)
+  // CHECK-NEXT: %[[CALL_1:.*]] = call @outer_foo(%[[CALL_0]])
+  %0 = call @outer_foo(%arg0) : (tensor<8xi32>) -> tensor<8xi32>
+  %1 = call @outer_bar(%0) : (tensor<8xi32>) -> tensor<8xi32>
+  return %1 : tensor<8xi32>
+}
+
+// CHECK-LABEL: func private @outer_foo(
+// CHECK-NEXT:    call @inner_foo
+func.func private @outer_foo(%arg0: tensor<8xi32>) -> tensor<8xi32> attributes {sdy.original_func_name = "outer_foo"} {
+  %0 = call @inner_foo(%arg0) : (tensor<8xi32>) -> tensor<8xi32>
+  return %0 : tensor<8xi32>
+}
+
+// CHECK-LABEL: func private @outer_bar(
+// CHECK-NEXT:    call @inner_foo
+func.func private @outer_bar(%arg0: tensor<8xi32>) -> tensor<8xi32> attributes {sdy.original_func_name = "outer_bar"} {
+  %0 = call @inner_bar(%arg0) : (tensor<8xi32>) -> tensor<8xi32>
+  return %0 : tensor<8xi32>
+}
+
+func.func private @inner_foo(%arg0: tensor<8xi32>) -> tensor<8xi32> attributes {sdy.original_func_name = "inner_foo"} {
+  %0 = stablehlo.abs %arg0 : tensor<8xi32>
+  return %0 : tensor<8xi32>
+}
+
+func.func private @inner_bar(%arg0: tensor<8xi32>) -> tensor<8xi32> attributes {sdy.original_func_name = "inner_bar"} {
+  %0 = stablehlo.abs %arg0 : tensor<8xi32>
+  return %0 : tensor<8xi32>
+}
@@ -12,7 +12,12 @@ limitations under the License.
 #include <cstdint>
 #include <tuple>
 
+#include <cstdint>
+
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "mlir/Analysis/CallGraph.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
@@ -114,6 +119,74 @@ llvm::SmallDenseMap<ComputationKey, FuncOp> populateFuncCache(
   return funcCache;
 }
 
+// Returns a hash of the signature, manual axes and body of `funcOp`, ignoring
+// its name, such that structurally equal funcs have the same hash.
+llvm::hash_code getStructuralHash(FuncOp funcOp) {
+  llvm::hash_code hash = llvm::hash_combine(
+      funcOp.getFunctionType(), funcOp.getArgAttrsAttr(),
+      funcOp.getResAttrsAttr(), getManualAxesAttr(funcOp));
+  funcOp.getBody().walk([&](Operation* op) {
+    hash = llvm::hash_combine(
+        hash, OperationEquivalence::computeHash(
+                  op, OperationEquivalence::ignoreHashValue,
+                  OperationEquivalence::ignoreHashValue,
+                  OperationEquivalence::IgnoreLocations));
+  });
+  return hash;
+}
+
+// Returns true if `lhs` and `rhs` have the same signature, manual axes and
+// body, up to SSA value names and locations.
+bool isStructurallyEqual(FuncOp lhs, FuncOp rhs) {
+  return lhs.getFunctionType() == rhs.getFunctionType() &&
+         lhs.getArgAttrsAttr() == rhs.getArgAttrsAttr() &&
+         lhs.getResAttrsAttr() == rhs.getResAttrsAttr() &&
+         getManualAxesAttr(lhs) == getManualAxesAttr(rhs) &&
+         OperationEquivalence::isRegionEquivalentTo(
+             &lhs.getBody(), &rhs.getBody(),
+             OperationEquivalence::IgnoreLocations);
+}
+
+// Redirects the calls to private funcs that are structurally equal to another
+// private func to the first such func in the module, by hash-consing the
+// funcs on their structural hash.
+//
+// Funcs are compared after redirecting the calls in their bodies, so funcs
+// that only differ in calls to equal funcs are merged in a later round, which
+// repeats until no more calls are redirected.
+void dedupStructurallyEqualFuncs(ModuleOp moduleOp) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    llvm::DenseMap<StringRef, StringRef> canonicalNames;
+    llvm::DenseMap<llvm::hash_code, SmallVector<FuncOp>> funcsByHash;
+    for (FuncOp funcOp : moduleOp.getOps<FuncOp>()) {
+      if (!funcOp.isPrivate() || funcOp.isExternal()) {
+        continue;
+      }
+      SmallVector<FuncOp>& bucket = funcsByHash[getStructuralHash(funcOp)];
+      auto equalIt = llvm::find_if(bucket, [&](FuncOp other) {
+        return isStructurallyEqual(funcOp, other);
+      });
+      if (equalIt != bucket.end()) {
+        canonicalNames[funcOp.getSymName()] = equalIt->getSymName();
+      } else {
+        bucket.push_back(funcOp);
+      }
+    }
+    if (canonicalNames.empty()) {
+      break;
+    }
+    moduleOp.walk([&](CallOp callOp) {
+      auto nameIt = canonicalNames.find(callOp.getCallee());
+      if (nameIt != canonicalNames.end()) {
+        callOp.setCallee(nameIt->second);
+        changed = true;
+      }
+    });
+  }
+}
+
 struct UnflattenCallGraphPass
     : public impl::UnflattenCallGraphPassBase<UnflattenCallGraphPass> {
   using UnflattenCallGraphPassBase::UnflattenCallGraphPassBase;
@@ -127,6 +200,9 @@ struct UnflattenCallGraphPass
   // it needs to pick one of the input/output shardings, and copy operations
   // before and after some calls in order to match the input/output shardings
   // the selected function expects.
+  //
+  // When `dedupIdenticalFunctions` is enabled, it then also deduplicates
+  // functions that are structurally equal regardless of their origin.
   void runOnOperation() final {
     ModuleOp moduleOp = getOperation();
     SymbolTable symbolTable(moduleOp);
@@ -141,6 +217,10 @@ struct UnflattenCallGraphPass
       callOp.setCallee(funcOp.getName());
     });
 
+    if (dedupIdenticalFunctions) {
+      dedupStructurallyEqualFuncs(moduleOp);
+    }
+
     moduleOp.walk([&](FuncOp funcOp) {
       funcOp->removeAttr(kOriginalFuncName);
       funcOp->removeAttr(kFuncManualAxes);
@@ -17,10 +17,13 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <numeric>
+#include <optional>
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -159,6 +162,40 @@ void updateValueShardings(
   setShardings(newShardings);
 }
 
+// Returns true if `funcOp` is a private function whose every use is a
+// `func::CallOp` with operand and result shardings that match the shardings of
+// the function inputs and outputs.
+//
+// The boundaries of such a function may keep non-divisible shardings, since the
+// padded shapes can be carried across the call without reshards.
+bool allCallersAgree(func::FuncOp funcOp, ModuleOp moduleOp) {
+  if (!funcOp.isPrivate() || funcOp.isExternal()) {
+    return false;
+  }
+  std::optional<SymbolTable::UseRange> uses =
+      SymbolTable::getSymbolUses(funcOp, moduleOp);
+  if (!uses || uses->empty()) {
+    return false;
+  }
+  return llvm::all_of(*uses, [&](const SymbolTable::SymbolUse& use) {
+    auto callOp = dyn_cast<func::CallOp>(use.getUser());
+    if (!callOp) {
+      return false;
+    }
+    for (auto [index, operand] : llvm::enumerate(callOp.getOperands())) {
+      if (getSharding(operand) != getSharding(funcOp.getArgument(index))) {
+        return false;
+      }
+    }
+    for (auto [index, result] : llvm::enumerate(callOp.getResults())) {
+      if (getSharding(result) != getFuncResultSharding(funcOp, index)) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
 struct UpdateNonDivisibleInputOutputShardingsPass
     : public impl::UpdateNonDivisibleInputOutputShardingsPassBase<
           UpdateNonDivisibleInputOutputShardingsPass> {
@@ -168,7 +205,20 @@ struct UpdateNonDivisibleInputOutputShardingsPass
   void runOnOperation() final {
     ModuleOp moduleOp = getOperation();
     SymbolTable symbolTable(moduleOp);
+    // Functions whose boundaries keep their (possibly non-divisible) shardings,
+    // computed before any sharding is updated.
+    llvm::SmallDenseSet<StringRef> funcsToKeep;
+    if (padAcrossCallBoundaries) {
+      for (auto funcOp : moduleOp.getOps<func::FuncOp>()) {
+        if (allCallersAgree(funcOp, moduleOp)) {
+          funcsToKeep.insert(funcOp.getSymName());
+        }
+      }
+    }
     for (auto funcOp : moduleOp.getOps<func::FuncOp>()) {
+      if (funcsToKeep.contains(funcOp.getSymName())) {
+        continue;
+      }
       // Update arguments.
       updateValueShardings(
           funcOp.getArgumentTypes(),
@@ -187,6 +237,9 @@ struct UpdateNonDivisibleInputOutputShardingsPass
           symbolTable);
     }
     moduleOp.walk([&](func::CallOp callOp) {
+      if (funcsToKeep.contains(callOp.getCallee())) {
+        return;
+      }
       // Update call results.
       updateValueShardings(
           callOp->getResults(), getShardings(callOp),
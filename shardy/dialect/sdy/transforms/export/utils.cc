@@ -19,7 +19,10 @@ limitations under the License.
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/MathExtras.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinTypeInterfaces.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Value.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/utils.h"
@@ -128,5 +131,24 @@ bool isCommunicationFreeSliceDim(int64_t dimIdx, stablehlo::SliceOp sliceOp,
          llvm::divideCeil(outDimSize, shardCount);
 }
 
+bool isSumReduction(stablehlo::ReduceOp reduceOp) {
+  if (reduceOp.getBody().empty()) {
+    return false;
+  }
+  Block& body = reduceOp.getBody().front();
+  auto returnOp = dyn_cast<stablehlo::ReturnOp>(body.getTerminator());
+  if (!returnOp ||
+      returnOp.getOperands().size() != reduceOp.getInputs().size()) {
+    return false;
+  }
+  for (Value retValue : returnOp.getOperands()) {
+    Operation* curOp = retValue.getDefiningOp();
+    if (!curOp || !isa<stablehlo::AddOp>(curOp)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace sdy
 }  // namespace mlir
@@ -78,6 +78,10 @@ void alignSubAxesByDecomposition(SmallVector<AxisList>& inAxesPerDim,
 bool isCommunicationFreeSliceDim(int64_t dimIdx, stablehlo::SliceOp sliceOp,
                                  TensorShardingAttr sharding, MeshAttr mesh);
 
+// Returns true if every result of `reduceOp` is computed by a
+// `stablehlo.add` in its body.
+bool isSumReduction(stablehlo::ReduceOp reduceOp);
+
 }  // namespace sdy
 }  // namespace mlir
 
@@ -26,6 +26,7 @@ limitations under the License.
 #include "mlir/Support/WalkResult.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/export/utils.h"
 #include "stablehlo/dialect/StablehloOps.h"
 
 namespace mlir {
@@ -225,25 +226,6 @@ LogicalResult verifyDefaultOpUnreducedAxes(Operation* op, func::FuncOp funcOp) {
       "This is an invalid transition from unreduced to reduced.");
 }
 
-bool isSumReduction(stablehlo::ReduceOp reduceOp) {
-  if (reduceOp.getBody().empty()) {
-    return false;
-  }
-  Block& body = reduceOp.getBody().front();
-  auto returnOp = dyn_cast<stablehlo::ReturnOp>(body.getTerminator());
-  if (!returnOp ||
-      returnOp.getOperands().size() != reduceOp.getInputs().size()) {
-    return false;
-  }
-  for (Value retValue : returnOp.getOperands()) {
-    Operation* curOp = retValue.getDefiningOp();
-    if (!curOp || !isa<stablehlo::AddOp>(curOp)) {
-      return false;
-    }
-  }
-  return true;
-}
-
 struct VerifyUnreducedAxesPass
     : public impl::VerifyUnreducedAxesPassBase<VerifyUnreducedAxesPass> {
   using VerifyUnreducedAxesPassBase::VerifyUnreducedAxesPassBase;
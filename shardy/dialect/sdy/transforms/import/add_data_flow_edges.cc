@@ -38,6 +38,10 @@ struct AddDataFlowEdgesPass
 
   void runOnOperation() final {
     ModuleOp moduleOp = getOperation();
+    // Nothing to do for modules with no data-flow ops.
+    if (!containsOp<ShardableDataFlowOpInterface>(moduleOp)) {
+      return;
+    }
     SymbolTable symbolTable(moduleOp);
     IRRewriter rewriter(moduleOp);
 
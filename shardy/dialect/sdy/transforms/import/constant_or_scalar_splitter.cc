@@ -165,6 +165,27 @@ Value cloneSubComputation(OpResult opResult, SymbolTable& symbolTable) {
   return mapping.lookup(opResult);
 }
 
+// Returns true if the sub-computation whose root is `opResult` is only used by
+// its root's single user, i.e., every op in it, other than scalars which aren't
+// cloned, has exactly one use. Such a sub-computation is already isolated, so
+// it doesn't need to be cloned.
+//
+// Calls are never considered isolated, as cloning them also clones their
+// callee.
+bool isIsolatedSubComputation(OpResult opResult) {
+  if (isScalar(opResult)) {
+    return true;
+  }
+  Operation* op = opResult.getOwner();
+  if (isa<CallOp>(op) || !op->hasOneUse()) {
+    return false;
+  }
+  return llvm::all_of(op->getOperands(), [](Value operand) {
+    auto defOpResult = dyn_cast<OpResult>(operand);
+    return !defOpResult || isIsolatedSubComputation(defOpResult);
+  });
+}
+
 void cloneSubComputationOnOperands(
     Operation* op, const llvm::SetVector<Operation*>& constantOps,
     const llvm::SetVector<Operation*>& scalarExpansionOps,
@@ -177,7 +198,13 @@ void cloneSubComputationOnOperands(
       // recursively clone the sub-computation whose root is
       // `defOpResult`, and replace the `operand` with the cloned defining
       // op. The cloned constant sub-computation has only one user `op`,
-      // so that it is isolated from the rest of the computation.
+      // so that it is isolated from the rest of the computation. If it's
+      // already isolated, which is the common case of a constant with a single
+      // use, we keep it in place instead of cloning it and erasing the
+      // original.
+      if (isIsolatedSubComputation(defOpResult)) {
+        continue;
+      }
       operand.set(cloneSubComputation(defOpResult, symbolTable));
     }
   }
@@ -15,12 +15,15 @@ limitations under the License.
 
 #include <cstdint>
 #include <iterator>
+#include <tuple>
 #include <utility>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Location.h"
 #include "mlir/IR/Matchers.h"
@@ -106,6 +109,51 @@ Value sliceAndConcatenateIndices(PatternRewriter& rewriter, Location loc,
                                           indexVectorDim);
 }
 
+// Caches the index tensor created by `sliceAndConcatenateIndices` for a given
+// indices value, index vector dim and removed component, so that gathers and
+// scatters that share the same indices reuse a single converted tensor instead
+// of each creating their own slices and concatenate.
+//
+// The converted tensor is created right after the definition of the indices,
+// so it dominates all their uses. Entries are dropped when either the indices
+// or the converted tensor are erased by the rewrite driver.
+class ConvertedIndicesCache : public RewriterBase::Listener {
+ public:
+  Value getOrCreate(PatternRewriter& rewriter, Value indices,
+                    RankedTensorType indicesType, int64_t indexVectorDim,
+                    int64_t removedIdx) {
+    auto [it, inserted] = cache.try_emplace(
+        std::make_tuple(indices, indexVectorDim, removedIdx), Value());
+    if (!inserted) {
+      return it->second;
+    }
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPointAfterValue(indices);
+    it->second =
+        sliceAndConcatenateIndices(rewriter, indices.getLoc(), indices,
+                                   indicesType, indexVectorDim, removedIdx);
+    return it->second;
+  }
+
+  void notifyOperationErased(Operation* op) override {
+    SmallVector<CacheKey> erasedKeys;
+    for (auto& [key, convertedIndices] : cache) {
+      if (std::get<0>(key).getDefiningOp() == op ||
+          convertedIndices.getDefiningOp() == op) {
+        erasedKeys.push_back(key);
+      }
+    }
+    for (const CacheKey& key : erasedKeys) {
+      cache.erase(key);
+    }
+  }
+
+ private:
+  using CacheKey = std::tuple<Value, int64_t, int64_t>;
+
+  llvm::DenseMap<CacheKey, Value> cache;
+};
+
 // Helper function to unwrap values through common StableHLO operations
 // like Reshape, BroadcastInDim, Select, and Clamp to find the original
 // source.
@@ -150,7 +198,9 @@ bool verifyIotaOrigin(Value indicesVal, int64_t indexVectorDim,
 
 struct ExplicitGatherBatchingPattern
     : public OpRewritePattern<stablehlo::GatherOp> {
-  using OpRewritePattern<stablehlo::GatherOp>::OpRewritePattern;
+  ExplicitGatherBatchingPattern(MLIRContext* context,
+                               ConvertedIndicesCache& indicesCache)
+      : OpRewritePattern<stablehlo::GatherOp>(context), indicesCache(indicesCache) {}
 
   LogicalResult matchAndRewrite(stablehlo::GatherOp op,
                                 PatternRewriter& rewriter) const override {
@@ -222,9 +272,9 @@ struct ExplicitGatherBatchingPattern
 
     // 4. Construct the new start_indices tensor by slicing out the
     // component at removedIndexVectorIdx.
-    Value newStartIndices = sliceAndConcatenateIndices(
-        rewriter, op.getLoc(), op.getStartIndices(), startIndicesType,
-        indexVectorDim, removedIndexVectorIdx);
+    Value newStartIndices = indicesCache.getOrCreate(
+        rewriter, op.getStartIndices(), startIndicesType, indexVectorDim,
+        removedIndexVectorIdx);
 
     // 5. Create the new GatherDimensionNumbersAttr with explicit
     // batching.
@@ -246,11 +296,16 @@ struct ExplicitGatherBatchingPattern
 
     return success();
   }
+
+ private:
+  ConvertedIndicesCache& indicesCache;
 };
 
 struct ExplicitScatterBatchingPattern
     : public OpRewritePattern<stablehlo::ScatterOp> {
-  using OpRewritePattern<stablehlo::ScatterOp>::OpRewritePattern;
+  ExplicitScatterBatchingPattern(MLIRContext* context,
+                               ConvertedIndicesCache& indicesCache)
+      : OpRewritePattern<stablehlo::ScatterOp>(context), indicesCache(indicesCache) {}
 
   LogicalResult matchAndRewrite(stablehlo::ScatterOp op,
                                 PatternRewriter& rewriter) const override {
@@ -316,9 +371,9 @@ struct ExplicitScatterBatchingPattern
     insertedWindowDims.erase(insertedIt);
 
     // 4. Slice out the iota index component.
-    Value newScatterIndices = sliceAndConcatenateIndices(
-        rewriter, op.getLoc(), op.getScatterIndices(), scatterIndicesType,
-        indexVectorDim, removedIndexVectorIdx);
+    Value newScatterIndices = indicesCache.getOrCreate(
+        rewriter, op.getScatterIndices(), scatterIndicesType, indexVectorDim,
+        removedIndexVectorIdx);
 
     // 5. Construct new scatter dim numbers.
     SmallVector<int64_t> inputBatchingDims = {0};
@@ -345,6 +400,9 @@ struct ExplicitScatterBatchingPattern
 
     return success();
   }
+
+ private:
+  ConvertedIndicesCache& indicesCache;
 };
 
 class ExplicitGatherScatterBatchingPass
@@ -356,10 +414,14 @@ class ExplicitGatherScatterBatchingPass
 
  protected:
   void runOnOperation() override {
+    ConvertedIndicesCache indicesCache;
     RewritePatternSet patterns(&getContext());
-    patterns.add<ExplicitGatherBatchingPattern>(&getContext());
-    patterns.add<ExplicitScatterBatchingPattern>(&getContext());
-    if (failed(applyPatternsGreedily(getOperation(), std::move(patterns)))) {
+    patterns.add<ExplicitGatherBatchingPattern, ExplicitScatterBatchingPattern>(
+        &getContext(), indicesCache);
+    GreedyRewriteConfig config;
+    config.setListener(&indicesCache);
+    if (failed(applyPatternsGreedily(getOperation(), std::move(patterns),
+                                     config))) {
       signalPassFailure();
     }
   }
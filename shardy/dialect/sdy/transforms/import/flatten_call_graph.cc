@@ -9,13 +9,21 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstdint>
 #include <memory>
+#include <utility>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Value.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/Support/LLVM.h"
 #include "mlir/Support/WalkResult.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/utils.h"
@@ -32,6 +40,28 @@ namespace {
 using func::CallOp;
 using func::FuncOp;
 
+// The callee of a call together with the shardings of its operands and
+// results, with a unit attr in place of a missing sharding.
+using ShardingSignature = std::pair<StringAttr, ArrayAttr>;
+
+ShardingSignature getShardingSignature(CallOp callOp) {
+  MLIRContext* context = callOp.getContext();
+  SmallVector<Attribute> shardings;
+  shardings.reserve(callOp.getNumOperands() + callOp.getNumResults());
+  auto addSharding = [&](TensorShardingAttr sharding) {
+    shardings.push_back(sharding ? Attribute(sharding) : UnitAttr::get(context));
+  };
+  for (Value operand : callOp.getOperands()) {
+    addSharding(getSharding(operand));
+  }
+  TensorShardingPerValueAttr resultShardings = getShardingPerValue(callOp);
+  for (int64_t i = 0; i < callOp.getNumResults(); ++i) {
+    addSharding(resultShardings ? resultShardings.getSharding(i)
+                                : TensorShardingAttr());
+  }
+  return {callOp.getCalleeAttr().getAttr(), ArrayAttr::get(context, shardings)};
+}
+
 struct FlattenCallGraphPass
     : public impl::FlattenCallGraphPassBase<FlattenCallGraphPass> {
   using FlattenCallGraphPassBase::FlattenCallGraphPassBase;
@@ -46,38 +76,58 @@ struct FlattenCallGraphPass
     SymbolTable symbolTable(moduleOp);
 
     llvm::SmallDenseSet<StringRef> funcNames;
+    // The callee of the first call with each sharding signature, which
+    // subsequent calls with the same signature reuse.
+    llvm::SmallDenseMap<ShardingSignature, StringAttr> calleeBySignature;
 
     walkCalls(moduleOp, [&](CallOp callOp) {
       if (flattenCallGraphUnder && !flattenCallGraphUnder(callOp)) {
         return WalkResult::advance();
       }
-      // TODO(enver): Should we special handle loops and conditionals?
-      FuncOp funcOp = getFuncOpOrDie(callOp.getCallee(), symbolTable);
-      if (auto [_, inserted] = funcNames.insert(funcOp.getName()); inserted) {
-        if (flattenCallGraphUnder) {
-          // This is the first call to the function. Keep the function itself
-          // uncloned (it will be cloned on a second call though) but clone the
-          // call graphs under it and during which flatten thos sub call graphs.
-          // Because, unlike the case of full flattening it is *not* guaranteed
-          // that any other calls to the called functions to be cloned.
-          funcOp->walk([&](CallOp callOp) {
-            FuncOp calledFuncOp =
-                getFuncOpOrDie(callOp.getCallee(), symbolTable);
-            callOp.setCallee(symbolTable.insert(
-                cloneFuncRecursively(calledFuncOp, symbolTable)));
-          });
-        }
-        // In the case of full flatenning, it does not need to clone the called
-        // functions as it is guaranteed that any second call later to the
-        // called functions is guaranteed to be cloned.
+      if (!dedupByShardingSignature) {
+        flattenCall(callOp, symbolTable, funcNames);
         return WalkResult::advance();
       }
-      // A second call the the function. Clone fully and flatten.
-      callOp.setCallee(
-          symbolTable.insert(cloneFuncRecursively(funcOp, symbolTable)));
+      ShardingSignature signature = getShardingSignature(callOp);
+      if (auto it = calleeBySignature.find(signature);
+          it != calleeBySignature.end()) {
+        callOp.setCallee(it->second.getValue());
+        return WalkResult::advance();
+      }
+      flattenCall(callOp, symbolTable, funcNames);
+      calleeBySignature[signature] = callOp.getCalleeAttr().getAttr();
       return WalkResult::advance();
     });
   }
+
+  // Keeps the callee of the first call to each function, and clones it for
+  // every other call.
+  void flattenCall(CallOp callOp, SymbolTable& symbolTable,
+                   llvm::SmallDenseSet<StringRef>& funcNames) {
+    // TODO(enver): Should we special handle loops and conditionals?
+    FuncOp funcOp = getFuncOpOrDie(callOp.getCallee(), symbolTable);
+    if (auto [_, inserted] = funcNames.insert(funcOp.getName()); inserted) {
+      if (flattenCallGraphUnder) {
+        // This is the first call to the function. Keep the function itself
+        // uncloned (it will be cloned on a second call though) but clone the
+        // call graphs under it and during which flatten thos sub call graphs.
+        // Because, unlike the case of full flattening it is *not* guaranteed
+        // that any other calls to the called functions to be cloned.
+        funcOp->walk([&](CallOp callOp) {
+          FuncOp calledFuncOp = getFuncOpOrDie(callOp.getCallee(), symbolTable);
+          callOp.setCallee(symbolTable.insert(
+              cloneFuncRecursively(calledFuncOp, symbolTable)));
+        });
+      }
+      // In the case of full flatenning, it does not need to clone the called
+      // functions as it is guaranteed that any second call later to the
+      // called functions is guaranteed to be cloned.
+      return;
+    }
+    // A second call the the function. Clone fully and flatten.
+    callOp.setCallee(
+        symbolTable.insert(cloneFuncRecursively(funcOp, symbolTable)));
+  }
 };
 
 }  // namespace
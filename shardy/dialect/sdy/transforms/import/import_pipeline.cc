@@ -30,8 +30,8 @@ namespace sdy {
 void addImportPipeline(OpPassManager& pm, int& dumpIndex,
                        const PropagationOptions& options) {
   pm.addPass(createSymbolDCEPass());
-  pm.addPass(createLiftInlinedMeshesPass());
-  pm.addPass(createRemoveSizeOneAxesPass());
+  pm.addPass(createLiftInlinedMeshesPass(
+      LiftInlinedMeshesPassOptions{/*removeSizeOneAxes=*/true}));
   pm.addPass(createPropagateShardingFromFuncToCallPass());
   pm.addPass(createConstantOrScalarSplitterPass());
   if (options.enableExplicitGatherScatterBatching) {
@@ -44,11 +44,12 @@ void addImportPipeline(OpPassManager& pm, int& dumpIndex,
   // passes before are cleanup passes that make the module more readable, and
   // the import passes after are internal implementation details that are part
   // of the propagation itself.
-  pm.addPass(mlir::sdy::createSaveModuleOpPass(
-      options.dumpDirectory, "before_propagation", dumpIndex++));
+  addSaveModuleOpPass(pm, options.dumpDirectory, "before_propagation",
+                      dumpIndex);
 
   pm.addPass(createAddDataFlowEdgesPass());
-  if (options.dedupFunctionsFully) {
+  if (options.dedupFunctionsFully ||
+      options.specializeFuncsByShardingContext) {
     pm.addPass(
         createApplyShardingConstraintsPass(ApplyShardingConstraintsPassOptions{
             options.debugShardingOrigins,
@@ -72,6 +73,12 @@ struct ImportPipelineOptions
       *this, "dedup-functions-fully",
       llvm::cl::desc("Whether to dedup functions fully."),
       llvm::cl::init(false)};
+
+  Option<bool> specializeFuncsByShardingContext{
+      *this, "specialize-funcs-by-sharding-context",
+      llvm::cl::desc("Whether to propagate through one copy of each func per "
+                     "distinct sharding signature of its calls."),
+      llvm::cl::init(false)};
 };
 }  // namespace
 
@@ -84,6 +91,8 @@ void registerImportPipeline() {
         int dumpIndex = 0;
         PropagationOptions propOptions;
         propOptions.dedupFunctionsFully = options.dedupFunctionsFully;
+        propOptions.specializeFuncsByShardingContext =
+            options.specializeFuncsByShardingContext;
         addImportPipeline(pm, dumpIndex, propOptions);
       });
 }
@@ -16,6 +16,7 @@ limitations under the License.
 #include <cassert>
 #include <cstdint>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -44,8 +45,15 @@ struct InlineMeshesPass : public impl::InlineMeshesPassBase<InlineMeshesPass> {
     ModuleOp moduleOp = getOperation();
     SymbolTable symbolTable(moduleOp);
 
+    // Shardings are uniqued and usually repeated many times, so we only inline
+    // the mesh of each distinct sharding once.
+    llvm::SmallDenseMap<TensorShardingAttr, TensorShardingAttr> inlinedShardings;
     transformShardings(moduleOp, [&](TensorShardingAttr sharding) {
-      return inlineMesh(symbolTable, sharding);
+      TensorShardingAttr& inlinedSharding = inlinedShardings[sharding];
+      if (!inlinedSharding) {
+        inlinedSharding = inlineMesh(symbolTable, sharding);
+      }
+      return inlinedSharding;
     });
 
     moduleOp.walk([&](Operation* op) {
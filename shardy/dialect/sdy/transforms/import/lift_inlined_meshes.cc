@@ -31,6 +31,7 @@ limitations under the License.
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/sdy/ir/constants.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
 #include "shardy/dialect/sdy/transforms/common/sharding_walker.h"
 #include "shardy/dialect/sdy/transforms/import/passes.h"  // IWYU pragma: keep
 #include "stablehlo/dialect/StablehloOps.h"
@@ -73,6 +74,12 @@ MeshOp createNewMeshOp(Location loc, mlir::stablehlo::MeshAttr mesh,
   return createMesh("mesh", sdyMeshAttr);
 }
 
+bool hasSizeOneAxes(MeshAttr mesh) {
+  return mesh && llvm::any_of(mesh.getAxes(), [](MeshAxisAttr axis) {
+           return axis.getSize() == 1;
+         });
+}
+
 DictionaryAttr getStablehloMeshAttrAsDict(MeshAttr sdyMeshAttr) {
   MLIRContext* ctx = sdyMeshAttr.getContext();
   Builder builder(ctx);
@@ -184,23 +191,43 @@ struct LiftInlinedMeshesPass
       builder.setInsertionPointToStart(moduleOp.getBody());
     }
 
-    transformShardings(moduleOp, [&](TensorShardingAttr sharding) {
-      // Taking `newMeshName` by reference so we can update it if `sharding`
-      // has an inlined mesh that isn't already in the map.
-      StringAttr& newMeshName = meshOrRefToNewName[sharding.getMeshOrRef()];
-      if (newMeshName) {
-        return replaceMesh(sharding, newMeshName);
+    // Most shardings reference a mesh symbol that wasn't deduped, in which case
+    // they are returned as is, without inserting an entry for the symbol in
+    // `meshOrRefToNewName`.
+    auto liftMesh = [&](TensorShardingAttr sharding) {
+      Attribute meshOrRef = sharding.getMeshOrRef();
+      if (auto it = meshOrRefToNewName.find(meshOrRef);
+          it != meshOrRefToNewName.end()) {
+        return replaceMesh(sharding, it->second);
       }
-      if (auto mesh = dyn_cast<MeshAttr>(sharding.getMeshOrRef())) {
+      if (auto mesh = dyn_cast<MeshAttr>(meshOrRef)) {
         // Inlined mesh with a new `MeshAttr`.
         // TODO(tomnatan): give better names for meshes with device IDs, e.g.,
         // `@some_mesh_arbitrary_device_order` when there is an identical
         // `@some_mesh` without device IDs.
-        newMeshName = symbolTable.insert(
+        StringAttr newMeshName = symbolTable.insert(
             createNewMeshOp(moduleOp.getLoc(), mesh, builder));
+        meshOrRefToNewName[mesh] = newMeshName;
         return replaceMesh(sharding, newMeshName);
       }
       return sharding;
+    };
+    // Shardings are uniqued and usually repeated many times, so we only
+    // transform each distinct sharding once.
+    llvm::SmallDenseMap<TensorShardingAttr, TensorShardingAttr>
+        transformedShardings;
+    transformShardings(moduleOp, [&](TensorShardingAttr sharding) {
+      if (auto it = transformedShardings.find(sharding);
+          it != transformedShardings.end()) {
+        return it->second;
+      }
+      TensorShardingAttr newSharding = liftMesh(sharding);
+      if (removeSizeOneAxes &&
+          hasSizeOneAxes(newSharding.getMesh(symbolTable))) {
+        newSharding = sdy::removeSizeOneAxes(newSharding, symbolTable);
+      }
+      transformedShardings[sharding] = newSharding;
+      return newSharding;
     });
 
     auto processMeshInReplicaGroups = [&](auto op) {
@@ -215,16 +242,12 @@ struct LiftInlinedMeshesPass
       }
     };
 
-    moduleOp.walk(
-        [&](stablehlo::AllGatherOp op) { processMeshInReplicaGroups(op); });
-    moduleOp.walk(
-        [&](stablehlo::AllReduceOp op) { processMeshInReplicaGroups(op); });
-    moduleOp.walk(
-        [&](stablehlo::ReduceScatterOp op) { processMeshInReplicaGroups(op); });
-    moduleOp.walk(
-        [&](stablehlo::AllToAllOp op) { processMeshInReplicaGroups(op); });
-    moduleOp.walk([&](stablehlo::CollectiveBroadcastOp op) {
-      processMeshInReplicaGroups(op);
+    moduleOp.walk([&](Operation* op) {
+      if (isa<stablehlo::AllGatherOp, stablehlo::AllReduceOp,
+              stablehlo::ReduceScatterOp, stablehlo::AllToAllOp,
+              stablehlo::CollectiveBroadcastOp>(op)) {
+        processMeshInReplicaGroups(op);
+      }
     });
 
     // Attach discardable `stablehlo.mesh` attributes to all named meshes.
@@ -134,6 +134,10 @@ struct ManualAxesCleanupPass
 
   void runOnOperation() final {
     ModuleOp moduleOp = getOperation();
+    // Nothing to do for modules with no manual computations.
+    if (!containsOp<ManualComputationOp>(moduleOp)) {
+      return;
+    }
     SymbolTable symbolTable(moduleOp);
     moduleOp->walk([&](ManualComputationOp op) {
       ArrayRef<TensorShardingAttr> inShardings =
@@ -38,6 +38,10 @@ struct PropagateShardingFromFuncToCallPass
 
   void runOnOperation() override {
     ModuleOp moduleOp = getOperation();
+    // Nothing to do for modules with no calls.
+    if (!containsOp<CallOp>(moduleOp)) {
+      return;
+    }
     SymbolTable symbolTable(moduleOp);
 
     // Propagate shardings from func results to call results if call does not
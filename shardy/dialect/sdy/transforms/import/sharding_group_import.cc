@@ -18,7 +18,7 @@ limitations under the License.
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
-#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/IntEqClasses.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
@@ -40,8 +40,6 @@ namespace sdy {
 namespace {
 
 using llvm::DenseMap;
-using llvm::EquivalenceClasses;
-using llvm::SmallDenseMap;
 
 using ValueToShardingGroup =
     llvm::MapVector<Value, llvm::SmallVector<ShardingGroupOp>>;
@@ -95,36 +93,45 @@ LogicalResult buildShardingGroupMappingAndValidateGroups(
 
 GroupIdToShardingGroups unifyShardingGroups(
     ValueToShardingGroup& tensorToGroups) {
-  // Merge the equivalence classes of group ids which had the same tensors
-  // within them. (unionSets uses the default comparator and will consider the
-  // minimum group_id as the representative element of the equivalence class).
-  EquivalenceClasses<int64_t> shardingGroupEquivalences;
+  // Group ids are arbitrary, so we first map them to dense indices in
+  // increasing order of the ids, and merge the indices of group ids which had
+  // the same tensors within them in a disjoint-set forest.
+  SmallVector<int64_t> groupIds;
   for (auto& [_, groupsForTensor] : tensorToGroups) {
-    int64_t canonicalId = groupsForTensor.front().getGroupId();
     for (ShardingGroupOp group : groupsForTensor) {
-      shardingGroupEquivalences.unionSets(canonicalId, group.getGroupId());
+      groupIds.push_back(group.getGroupId());
     }
   }
+  llvm::sort(groupIds);
+  groupIds.erase(llvm::unique(groupIds), groupIds.end());
+  DenseMap<int64_t, unsigned> groupIdToIndex;
+  groupIdToIndex.reserve(groupIds.size());
+  for (auto [index, groupId] : llvm::enumerate(groupIds)) {
+    groupIdToIndex[groupId] = index;
+  }
 
-  // After merging groups we reindex the group IDs so that they take values
-  // from the set {0,1,...,N-1} (N is the number of equivalence classes).
-  // The leader element of each equivalent class corresponds to the minimum
-  // group_id, so by looping over the group leaders in order their reindexed
-  // ids can be set to maintain the same relative ordering.
-  int64_t reindexId = 0;
-  SmallDenseMap<int64_t, int64_t> reindexMap;
-  for (const auto& group : shardingGroupEquivalences) {
-    if (group->isLeader()) {
-      reindexMap[group->getData()] = reindexId++;
+  llvm::IntEqClasses shardingGroupEquivalences(groupIds.size());
+  for (auto& [_, groupsForTensor] : tensorToGroups) {
+    unsigned canonicalIndex =
+        groupIdToIndex.at(groupsForTensor.front().getGroupId());
+    for (ShardingGroupOp group : groupsForTensor) {
+      shardingGroupEquivalences.join(canonicalIndex,
+                                     groupIdToIndex.at(group.getGroupId()));
     }
   }
 
-  GroupIdToShardingGroups reindexGroups(reindexId);
+  // After merging groups we reindex the group IDs so that they take values
+  // from the set {0,1,...,N-1} (N is the number of equivalence classes).
+  // Classes are numbered in order of their smallest index, and thus of their
+  // minimum group_id, which maintains the same relative ordering.
+  shardingGroupEquivalences.compress();
+  GroupIdToShardingGroups reindexGroups(
+      shardingGroupEquivalences.getNumClasses());
   // Update the graph to replace group_ids with their canonical id.
   for (auto& [_, groupsForTensor] : tensorToGroups) {
     for (ShardingGroupOp op : groupsForTensor) {
-      op.setGroupId(reindexMap[shardingGroupEquivalences.getLeaderValue(
-          op.getGroupId())]);
+      op.setGroupId(
+          shardingGroupEquivalences[groupIdToIndex.at(op.getGroupId())]);
       reindexGroups[op.getGroupId()].push_back(op);
     }
   }
@@ -339,3 +339,52 @@ func.func @scatter_dim0_not_inserted_no_transform(
 
   return %result : tensor<4x8xi32>
 }
+
+// ===== Test 13: Gathers and scatters sharing the same indices =====
+// The indices are sliced once, and the slice is reused by all of them.
+
+// CHECK-LABEL: func @gathers_and_scatter_share_converted_indices
+func.func @gathers_and_scatter_share_converted_indices(
+    %operand: tensor<4x8xi32>, %updates: tensor<4xi32>) -> (tensor<4x1xi32>, tensor<4x1xi32>, tensor<4x8xi32>) {
+  // CHECK: %[[IOTA:.*]] = stablehlo.iota dim = 0 : tensor<4x2xi32>
+  // CHECK-NEXT: %[[SLICE:.*]] = stablehlo.slice %[[IOTA]] [0:4, 1:2]
+  // CHECK-NOT: stablehlo.slice
+  // CHECK: %[[GATHER_0:.*]] = "stablehlo.gather"(%arg0, %[[SLICE]])
+  // CHECK-SAME: operand_batching_dims = [0]
+  // CHECK: %[[GATHER_1:.*]] = "stablehlo.gather"(%arg0, %[[SLICE]])
+  // CHECK-SAME: operand_batching_dims = [0]
+  // CHECK: %[[SCATTER:.*]] = "stablehlo.scatter"(%arg0, %[[SLICE]], %arg1)
+  // CHECK-SAME: input_batching_dims = [0]
+  // CHECK: return %[[GATHER_0]], %[[GATHER_1]], %[[SCATTER]]
+  %indices = stablehlo.iota dim = 0 : tensor<4x2xi32>
+  %0 = "stablehlo.gather"(%operand, %indices) {
+    dimension_numbers = #stablehlo.gather<
+      offset_dims = [1],
+      collapsed_slice_dims = [0],
+      start_index_map = [0, 1],
+      index_vector_dim = 1>,
+    slice_sizes = array<i64: 1, 1>,
+    indices_are_sorted = false
+  } : (tensor<4x8xi32>, tensor<4x2xi32>) -> tensor<4x1xi32>
+  %1 = "stablehlo.gather"(%operand, %indices) {
+    dimension_numbers = #stablehlo.gather<
+      offset_dims = [1],
+      collapsed_slice_dims = [0],
+      start_index_map = [0, 1],
+      index_vector_dim = 1>,
+    slice_sizes = array<i64: 1, 1>,
+    indices_are_sorted = false
+  } : (tensor<4x8xi32>, tensor<4x2xi32>) -> tensor<4x1xi32>
+  %2 = "stablehlo.scatter"(%operand, %indices, %updates) <{
+    indices_are_sorted = false,
+    scatter_dimension_numbers = #stablehlo.scatter<
+      inserted_window_dims = [0, 1],
+      scatter_dims_to_operand_dims = [0, 1],
+      index_vector_dim = 1>,
+    unique_indices = false
+  }> ({
+  ^bb0(%arg0: tensor<i32>, %arg1: tensor<i32>):
+    stablehlo.return %arg1 : tensor<i32>
+  }) : (tensor<4x8xi32>, tensor<4x2xi32>, tensor<4xi32>) -> tensor<4x8xi32>
+  return %0, %1, %2 : tensor<4x1xi32>, tensor<4x1xi32>, tensor<4x8xi32>
+}
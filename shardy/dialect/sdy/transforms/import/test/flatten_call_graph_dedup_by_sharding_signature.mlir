@@ -0,0 +1,49 @@
+// RUN: sdy_opt %s -split-input-file -sdy-flatten-call-graph='dedup-by-sharding-signature=true' | FileCheck %s
+
+sdy.mesh @mesh = <["x"=2]>
+
+// CHECK-LABEL: func @same_signature_shares_callee(
+// CHECK-NEXT:    call @foo(%arg0)
+// CHECK-NEXT:    call @foo(%arg0)
+// CHECK-NEXT:    return
+func.func @same_signature_shares_callee(%arg0: tensor<8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}]>}) -> (tensor<8xi32>, tensor<8xi32>) {
+  %0 = call @foo(%arg0) : (tensor<8xi32>) -> tensor<8xi32>
+  %1 = call @foo(%arg0) : (tensor<8xi32>) -> tensor<8xi32>
+  return %0, %1 : tensor<8xi32>, tensor<8xi32>
+}
+
+// CHECK-LABEL: func private @foo(
+// CHECK-NOT:   func private @foo_0
+func.func private @foo(%arg0: tensor<8xi32>) -> tensor<8xi32> {
+  return %arg0 : tensor<8xi32>
+}
+
+// -----
+
+sdy.mesh @mesh = <["x"=2]>
+
+// CHECK-LABEL: func @different_signatures_clone_callee(
+// CHECK-NEXT:    call @foo(%arg0)
+// CHECK-NEXT:    call @foo_0(%arg1)
+// CHECK-NEXT:    call @foo(%arg0)
+// CHECK-NEXT:    call @foo_1(%arg0) {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}]>]>}
+// CHECK-NEXT:    return
+func.func @different_signatures_clone_callee(
+    %arg0: tensor<8xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}]>},
+    %arg1: tensor<8xi32>) -> (tensor<8xi32>, tensor<8xi32>, tensor<8xi32>, tensor<8xi32>) {
+  %0 = call @foo(%arg0) : (tensor<8xi32>) -> tensor<8xi32>
+  %1 = call @foo(%arg1) : (tensor<8xi32>) -> tensor<8xi32>
+  %2 = call @foo(%arg0) : (tensor<8xi32>) -> tensor<8xi32>
+  %3 = call @foo(%arg0) {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}]>]>} : (tensor<8xi32>) -> tensor<8xi32>
+  return %0, %1, %2, %3 : tensor<8xi32>, tensor<8xi32>, tensor<8xi32>, tensor<8xi32>
+}
+
+// CHECK-LABEL: func private @foo(
+func.func private @foo(%arg0: tensor<8xi32>) -> tensor<8xi32> {
+  return %arg0 : tensor<8xi32>
+}
+
+// CHECK-LABEL: func private @foo_0(
+// CHECK-SAME:  attributes {sdy.original_func_name = "foo"}
+// CHECK-LABEL: func private @foo_1(
+// CHECK-SAME:  attributes {sdy.original_func_name = "foo"}
@@ -0,0 +1,21 @@
+// RUN: sdy_opt %s -sdy-lift-inlined-meshes='remove-size-one-axes=true' | FileCheck %s
+
+sdy.mesh @mesh = <["a"=1, "b"=2]>
+sdy.mesh @copy_of_mesh = <["a"=1, "b"=2]>
+
+// CHECK: sdy.mesh @mesh = <["a"=1, "b"=2]>
+// CHECK-NOT: sdy.mesh @copy_of_mesh
+// CHECK: sdy.mesh @mesh_0 = <["c"=1, "d"=4]>
+
+// CHECK-LABEL: func @lift_and_remove_size_one_axes
+// CHECK-SAME:    %arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"b"}, {}]>},
+// CHECK-SAME:    %arg1: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"b"}]>}
+// CHECK-SAME:  ) -> (tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh_0, [{"d"}, {}]>}) {
+func.func @lift_and_remove_size_one_axes(
+  %arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", "b"}, {}]>},
+  %arg1: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@copy_of_mesh, [{"a"}, {"b"}]>}
+) -> (tensor<8x8xf32> {sdy.sharding = #sdy.sharding<mesh<["c"=1, "d"=4]>, [{"c", "d"}, {}]>}) {
+  // CHECK-NEXT: stablehlo.add %arg0, %arg1 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"b"}, {}]>]>}
+  %0 = stablehlo.add %arg0, %arg1 {sdy.sharding = #sdy.sharding_per_value<[<@copy_of_mesh, [{"a", "b"}, {}]>]>} : tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
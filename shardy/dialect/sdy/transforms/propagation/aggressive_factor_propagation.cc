@@ -20,18 +20,25 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <tuple>
+#include <utility>
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/RWMutex.h"
 #include "mlir/IR/Operation.h"
+#include "mlir/IR/Value.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/utils.h"
 #include "shardy/dialect/sdy/transforms/common/op_properties.h"
+#include "shardy/dialect/sdy/transforms/propagation/collective_profile.h"
 #include "shardy/dialect/sdy/transforms/propagation/factor_propagation.h"
 #include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
 
+#define DEBUG_TYPE "sdy-aggressive-propagation"
+
 namespace mlir {
 namespace sdy {
 
@@ -40,16 +47,37 @@ namespace {
 struct TensorIndexSize {
   int64_t index;
   int64_t size;
+  // The profiled cost of the collectives caused by the tensor, see
+  // `CollectiveProfile`.
+  double cost;
 };
 
+// Returns the profiled cost of each tensor of `op`, operands first and then
+// results, or an empty vector if there is no profile or op, or the tensors of
+// `projection` aren't the operands and results of `op`.
+SmallVector<double> getTensorCosts(Operation* op,
+                                   const ShardingProjection& projection,
+                                   const CollectiveProfile* profile) {
+  if (!op || !profile || profile->empty() ||
+      projection.getNumOperands() != op->getNumOperands() ||
+      projection.getNumResults() != op->getNumResults()) {
+    return {};
+  }
+  return llvm::map_to_vector(
+      llvm::concat<Value>(op->getOperands(), op->getResults()),
+      [&](Value value) { return profile->getCost(value); });
+}
+
 // Given a factor Fi with non-empty new axes, if tensor Tj contains this factor
 // and Tj/Fi is a prefix of the new axes, Tj is a source of this new axes.
 // Return a vector of source tensor per factor.
+//
+// `tensorCosts` is either empty or holds the profiled cost of each tensor.
 SmallVector<TensorIndexSize> getFactorToSourceTensor(
     const ShardingProjection& projection, ArrayRef<int64_t> factorSizes,
-    AxesPerFactorRef axesPerFactor) {
+    AxesPerFactorRef axesPerFactor, ArrayRef<double> tensorCosts) {
   SmallVector<TensorIndexSize> factorToSourceTensor(
-      factorSizes.size(), {/*index=*/-1, /*size=*/-1});
+      factorSizes.size(), {/*index=*/-1, /*size=*/-1, /*cost=*/0});
   for (const auto& [tensorIndex, tensorFactorShardings] :
        llvm::enumerate(llvm::concat<const TensorFactorShardings>(
            projection.getOperands(), projection.getResults()))) {
@@ -58,6 +86,7 @@ SmallVector<TensorIndexSize> getFactorToSourceTensor(
          tensorFactorShardings.factorIndexToSharding) {
       tensorSize *= factorSizes[factorIndex];
     }
+    double tensorCost = tensorCosts.empty() ? 0 : tensorCosts[tensorIndex];
 
     for (const auto& [factorIndex, sharding] :
          tensorFactorShardings.factorIndexToSharding) {
@@ -66,11 +95,14 @@ SmallVector<TensorIndexSize> getFactorToSourceTensor(
           isAxisListPrefixOf(axesPerFactor[factorIndex], sharding.axisRefs) !=
               PrefixStatus::NOT_A_PREFIX;
       // There may be multiple sources for the same factor. We take the one with
-      // largest tensor size.
+      // largest profiled cost, and then the largest tensor size.
       TensorIndexSize& sourceTensor = factorToSourceTensor[factorIndex];
-      if (isSource && tensorSize > sourceTensor.size) {
+      if (isSource &&
+          std::make_pair(tensorCost, tensorSize) >
+              std::make_pair(sourceTensor.cost, sourceTensor.size)) {
         sourceTensor.size = tensorSize;
         sourceTensor.index = tensorIndex;
+        sourceTensor.cost = tensorCost;
       }
     }
   }
@@ -137,6 +169,39 @@ AggressiveFactorPropagation::getPropagatedFactorSharding(
   return newAxes;
 }
 
+void AggressiveFactorPropagation::clearConflictCache() {
+  llvm::sys::SmartScopedWriter<true> scopedLock(conflictCacheMutex);
+  opToConflict.clear();
+}
+
+bool AggressiveFactorPropagation::isCachedConflict(
+    Operation* op, const ShardingProjection& projection,
+    PropagationDirectionAlongFactor directionAlongFactor,
+    ArrayRef<int64_t> factorSizes, MeshAttr mesh,
+    bool conservativePropagation) const {
+  llvm::sys::SmartScopedReader<true> scopedLock(conflictCacheMutex);
+  auto it = opToConflict.find(op);
+  if (it == opToConflict.end()) {
+    return false;
+  }
+  const ConflictEntry& entry = it->second;
+  // The op pointer may have been reused by a different op, or the op may have
+  // been updated since, so the whole input needs to be the same.
+  if (entry.opName != op->getName() || entry.mesh != mesh ||
+      entry.conservativePropagation != conservativePropagation ||
+      entry.collectiveProfile != collectiveProfile ||
+      ArrayRef<int64_t>(entry.factorSizes) != factorSizes ||
+      llvm::any_of(llvm::enumerate(entry.directions), [&](auto indexAndDir) {
+        auto [factorIndex, direction] = indexAndDir;
+        return directionAlongFactor(factorIndex) != direction;
+      }) ||
+      !(entry.projection == projection)) {
+    return false;
+  }
+  numSkippedConflicts += entry.numBlockedFactors;
+  return true;
+}
+
 UpdateTensorShardings AggressiveFactorPropagation::propagateFactorShardings(
     ShardingProjection& projection,
     PropagationDirectionAlongFactor directionAlongFactor,
@@ -145,6 +210,15 @@ UpdateTensorShardings AggressiveFactorPropagation::propagateFactorShardings(
   UpdateTensorShardings result(projection.getNumOperands(),
                                projection.getNumResults());
 
+  // We don't cache anything without an op, e.g., in most tests.
+  if (op && isCachedConflict(op, projection, directionAlongFactor, factorSizes,
+                             mesh, conservativePropagation)) {
+    LLVM_DEBUG(llvm::dbgs() << "Skipping cached unresolvable conflict on "
+                            << op->getName() << " at " << op->getLoc()
+                            << "\n");
+    return result;
+  }
+
   // Find the compatible major axes ignoring conflicts.
   AxesPerFactor axesPerFactor;
   axesPerFactor.reserve(factorSizes.size());
@@ -161,16 +235,18 @@ UpdateTensorShardings AggressiveFactorPropagation::propagateFactorShardings(
   }
 
   // We sort the factors based on:
-  // 1. larger source tensor size first
-  // 2. [elementwise ops] most sharded factor first
-  // 3. smaller source tensor index first
-  // 4. smaller factor index first
+  // 1. [with a profile] larger profiled source tensor cost first
+  // 2. larger source tensor size first
+  // 3. [elementwise ops] most sharded factor first
+  // 4. smaller source tensor index first
+  // 5. smaller factor index first
   // Unstable sort is fine because there is no equality in the candidates.
   // TODO(b/376233527): reevaluate this conflict resolution heuristic.
   SmallVector<int64_t> sortedFactorIndices =
       llvm::to_vector(llvm::seq<int64_t>(0, factorSizes.size()));
-  SmallVector<TensorIndexSize> factorToSourceTensor =
-      getFactorToSourceTensor(projection, factorSizes, axesPerFactor);
+  SmallVector<TensorIndexSize> factorToSourceTensor = getFactorToSourceTensor(
+      projection, factorSizes, axesPerFactor,
+      getTensorCosts(op, projection, collectiveProfile));
 
   bool isElementwiseOp = op && isElementwise(op);
 
@@ -179,10 +255,12 @@ UpdateTensorShardings AggressiveFactorPropagation::propagateFactorShardings(
         isElementwiseOp ? getTotalAxesSize(axesPerFactor[i], mesh) : 0;
     int64_t jShardingSize =
         isElementwiseOp ? getTotalAxesSize(axesPerFactor[j], mesh) : 0;
-    return std::forward_as_tuple(-factorToSourceTensor[i].size, -iShardingSize,
-                                 factorToSourceTensor[i].index, i) <
-           std::forward_as_tuple(-factorToSourceTensor[j].size, -jShardingSize,
-                                 factorToSourceTensor[j].index, j);
+    return std::make_tuple(-factorToSourceTensor[i].cost,
+                           -factorToSourceTensor[i].size, -iShardingSize,
+                           factorToSourceTensor[i].index, i) <
+           std::make_tuple(-factorToSourceTensor[j].cost,
+                           -factorToSourceTensor[j].size, -jShardingSize,
+                           factorToSourceTensor[j].index, j);
   });
 
   auto propagateFactorIndicesToValues =
@@ -251,6 +329,25 @@ UpdateTensorShardings AggressiveFactorPropagation::propagateFactorShardings(
                                                 newAxes);
       });
 
+  // If no tensor was updated, `projection` is still the input of this call, so
+  // we only copy it for the conflicts we cache.
+  if (op && !result.updateOperands.any() && !result.updateResults.any()) {
+    ConflictEntry entry{
+        op->getName(),
+        projection,
+        llvm::map_to_vector(llvm::seq<int64_t>(0, factorSizes.size()),
+                            directionAlongFactor),
+        llvm::to_vector(factorSizes),
+        mesh,
+        conservativePropagation,
+        collectiveProfile,
+        llvm::count_if(axesPerFactor, [](ArrayRef<AxisRefAttr> axes) {
+          return !axes.empty();
+        })};
+    llvm::sys::SmartScopedWriter<true> scopedLock(conflictCacheMutex);
+    opToConflict.insert_or_assign(op, std::move(entry));
+  }
+
   return result;
 }
 
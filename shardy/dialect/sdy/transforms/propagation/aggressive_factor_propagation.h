@@ -16,12 +16,18 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_AGGRESSIVE_FACTOR_PROPAGATION_H_
 #define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_AGGRESSIVE_FACTOR_PROPAGATION_H_
 
+#include <atomic>
 #include <cstdint>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/RWMutex.h"
 #include "mlir/IR/Operation.h"
+#include "mlir/IR/OperationSupport.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/transforms/propagation/basic_factor_propagation.h"
+#include "shardy/dialect/sdy/transforms/propagation/collective_profile.h"
 #include "shardy/dialect/sdy/transforms/propagation/factor_propagation.h"
 #include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
 
@@ -55,6 +61,12 @@ namespace sdy {
 // tensor size, we sort based on the source tensor index and finally factor
 // index.
 //
+// If a `CollectiveProfile` is set, we first prefer the factor whose source
+// tensor caused the most expensive collectives in the profile, as keeping its
+// sharding moves the reshard to a tensor that was cheaper at runtime. Tensors
+// without a profiled cost have a cost of 0, so this only changes the order of
+// factors whose source tensors are in the profile.
+//
 // Let us take C = dot(A, B) as an example. F0 is the factor corresponding to a
 // non-contracting dimension of A. F1 corresponds to a non-contracting dimension
 // of B. F2 corresponds to a contracting dimension. '-' means that the tensor
@@ -74,6 +86,12 @@ namespace sdy {
 // Case 2. Conflict with multiple choices. `BasicFactorPropagation` propagates
 // nothing, while this strategy propagates "a" to C/F1, since F1 is preferred
 // over F0 (tensor B is larger than A).
+//
+// An op whose factors have compatible axes, none of which can be propagated to
+// any of its tensors, e.g., due to conflicts with closed shardings, is an
+// unresolvable conflict. Such ops are cached with the input of the call, and
+// skipped if they are visited again with the same input, which is common across
+// op-priority and user-priority rounds.
 class AggressiveFactorPropagation : public BasicFactorPropagation {
  public:
   UpdateTensorShardings propagateFactorShardings(
@@ -82,7 +100,43 @@ class AggressiveFactorPropagation : public BasicFactorPropagation {
       ArrayRef<int64_t> factorSizes, MeshAttr mesh,
       bool conservativePropagation, Operation* op) const override;
 
+  // Sets the profile used to resolve conflicts across factors, or unsets it if
+  // `profile` is null. The profile must outlive propagation.
+  void setCollectiveProfile(const CollectiveProfile* profile) {
+    collectiveProfile = profile;
+  }
+
+  // Returns the number of factors that were skipped because their op was
+  // cached as an unresolvable conflict.
+  int64_t getNumSkippedConflicts() const { return numSkippedConflicts; }
+
+  // Clears all cached conflicts, which refer to ops that might be destroyed
+  // once propagation is done.
+  void clearConflictCache();
+
  private:
+  // The input of a `propagateFactorShardings` call on an op that propagated
+  // nothing, even though `numBlockedFactors` factors had compatible axes. The
+  // result only depends on the input, so the op propagates nothing as long as
+  // the input is the same.
+  struct ConflictEntry {
+    OperationName opName;
+    ShardingProjection projection;
+    SmallVector<PropagationDirection> directions;
+    SmallVector<int64_t> factorSizes;
+    MeshAttr mesh;
+    bool conservativePropagation;
+    const CollectiveProfile* collectiveProfile;
+    int64_t numBlockedFactors;
+  };
+
+  // Returns whether `op` is cached as an unresolvable conflict with the given
+  // input, in which case the blocked factors are counted as skipped.
+  bool isCachedConflict(Operation* op, const ShardingProjection& projection,
+                        PropagationDirectionAlongFactor directionAlongFactor,
+                        ArrayRef<int64_t> factorSizes, MeshAttr mesh,
+                        bool conservativePropagation) const;
+
   // Returns the axes to propagate to an individual factor in the given
   // `tensorFactorShardings` of a tensor.
   SmallVector<AxisRefAttr> getPropagatedFactorSharding(
@@ -90,6 +144,13 @@ class AggressiveFactorPropagation : public BasicFactorPropagation {
       const FactorIndexToSharding& factorIndexToSharding,
       AxesPerFactorRef axesPerFactor, MeshAttr mesh,
       bool conservativePropagation, ArrayRef<int64_t> factorSizes) const;
+
+  const CollectiveProfile* collectiveProfile = nullptr;
+
+  // The cache is accessed by functions that are propagated in parallel.
+  mutable llvm::sys::SmartRWMutex<true> conflictCacheMutex;
+  mutable llvm::DenseMap<Operation*, ConflictEntry> opToConflict;
+  mutable std::atomic<int64_t> numSkippedConflicts = 0;
 };
 
 }  // namespace sdy
@@ -18,6 +18,10 @@ limitations under the License.
 #include <cassert>
 #include <cstdint>
 
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/OwningOpRef.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/transforms/propagation/factor_propagation.h"
@@ -397,6 +401,50 @@ TEST_F(AggressiveFactorPropagationTest, PropagateAlongSpecificFactor) {
   propagateAlongFactor(propagateAnything(), propagateAlongFactor0Expected);
 }
 
+TEST_F(AggressiveFactorPropagationTest, CachesUnresolvableConflicts) {
+  // Axis "a" can't be propagated to the result along factor 0, since it's
+  // closed, so nothing is propagated.
+  ShardingProjection input(
+      /*operands=*/
+      {
+          {.factorIndexToSharding = {{0, {.axisRefs = {createAxis("a")}}}}},
+      },
+      /*results=*/{
+          {.factorIndexToSharding = {{0, {.isClosed = true}}}},
+      });
+  SmallVector<int64_t> factorSizes = {1};
+  OwningOpRef<ModuleOp> module = ModuleOp::create(UnknownLoc::get(&context));
+
+  AggressiveFactorPropagation factorPropagation;
+  auto propagate = [&](PropagationDirectionAlongFactor directionAlongFactor) {
+    ShardingProjection projection = input;
+    auto [updateOperands, updateResults] =
+        factorPropagation.propagateFactorShardings(
+            projection, directionAlongFactor, factorSizes, /*mesh=*/nullptr,
+            /*conservativePropagation=*/false, module->getOperation());
+    EXPECT_THAT(toSetBitsVector(updateOperands), IsEmpty());
+    EXPECT_THAT(toSetBitsVector(updateResults), IsEmpty());
+    EXPECT_EQ(projection, input);
+  };
+
+  propagate(propagateAnything());
+  EXPECT_EQ(factorPropagation.getNumSkippedConflicts(), 0);
+
+  // The same input hits the cache and skips factor 0.
+  propagate(propagateAnything());
+  EXPECT_EQ(factorPropagation.getNumSkippedConflicts(), 1);
+
+  // A different direction along factors is a different input.
+  propagate([](int64_t) { return PropagationDirection::FORWARD; });
+  EXPECT_EQ(factorPropagation.getNumSkippedConflicts(), 1);
+
+  factorPropagation.clearConflictCache();
+  propagate(propagateAnything());
+  EXPECT_EQ(factorPropagation.getNumSkippedConflicts(), 1);
+  propagate(propagateAnything());
+  EXPECT_EQ(factorPropagation.getNumSkippedConflicts(), 2);
+}
+
 // NOLINTEND(clang-diagnostic-pre-c++20-compat-pedantic)
 
 }  // namespace
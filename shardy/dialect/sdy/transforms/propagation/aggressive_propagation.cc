@@ -17,19 +17,25 @@ limitations under the License.
 
 #include <cassert>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/SymbolTable.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassRegistry.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Support/LogicalResult.h"
+#include "shardy/dialect/sdy/transforms/propagation/collective_profile.h"
 #include "shardy/dialect/sdy/transforms/common/propagation_options.h"
 #include "shardy/dialect/sdy/transforms/propagation/basic_propagation.h"
 #include "shardy/dialect/sdy/transforms/propagation/factor_propagation.h"
 #include "shardy/dialect/sdy/transforms/propagation/sharding_group_map.h"
 
+#define DEBUG_TYPE "sdy-aggressive-propagation"
+
 namespace mlir {
 namespace sdy {
 
@@ -84,6 +90,36 @@ LogicalResult AggressivePropagationPassImpl::propagate(
   return success();
 }
 
+void AggressivePropagationPassImpl::setPropagationOptions(
+    const PropagationOptions& options) {
+  BasicPropagationPassImpl::setPropagationOptions(options);
+  collectiveProfile = options.collectiveProfile.str();
+}
+
+void AggressivePropagationPassImpl::runOnOperation() {
+  if (!collectiveProfile.empty()) {
+    std::string errorMessage;
+    FailureOr<CollectiveProfile> profile =
+        CollectiveProfile::load(collectiveProfile, errorMessage);
+    if (failed(profile)) {
+      getOperation().emitError(errorMessage);
+      signalPassFailure();
+      return;
+    }
+    loadedCollectiveProfile = std::move(*profile);
+    aggressiveFactorPropagation.setCollectiveProfile(
+        &*loadedCollectiveProfile);
+  }
+  BasicPropagationPassImpl::runOnOperation();
+  LLVM_DEBUG(llvm::dbgs()
+             << "Skipped "
+             << aggressiveFactorPropagation.getNumSkippedConflicts()
+             << " factor(s) with a cached unresolvable conflict\n");
+  aggressiveFactorPropagation.clearConflictCache();
+  aggressiveFactorPropagation.setCollectiveProfile(nullptr);
+  loadedCollectiveProfile.reset();
+}
+
 std::unique_ptr<Pass> createAggressivePropagationPass(
     const PropagationOptions& options, PropagationStrategy strategy) {
   return std::make_unique<AggressivePropagationPass>(options, strategy);
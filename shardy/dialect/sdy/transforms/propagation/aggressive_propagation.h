@@ -17,6 +17,8 @@ limitations under the License.
 #define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_AGGRESSIVE_PROPAGATION_H_
 
 #include <memory>
+#include <optional>
+#include <string>
 
 #include "llvm/Support/CommandLine.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "shardy/dialect/sdy/transforms/common/propagation_options.h"
 #include "shardy/dialect/sdy/transforms/propagation/aggressive_factor_propagation.h"
 #include "shardy/dialect/sdy/transforms/propagation/basic_propagation.h"
+#include "shardy/dialect/sdy/transforms/propagation/collective_profile.h"
 #include "shardy/dialect/sdy/transforms/propagation/sharding_group_map.h"
 
 namespace mlir {
@@ -54,6 +57,10 @@ class AggressivePropagationPassImpl : public BasicPropagationPassImpl {
   AggressivePropagationPassImpl(const AggressivePropagationPassImpl& other)
       : BasicPropagationPassImpl(other) {}
 
+  // Sets the propagation options of `BasicPropagationPassImpl` and the ones
+  // declared below.
+  void setPropagationOptions(const PropagationOptions& options);
+
  protected:
   // This method calls `BasicPropagationPassImpl::propagate` with specified
   // strategies. See `BasicPropagationPassImpl::propagate` for documentation.
@@ -71,6 +78,11 @@ class AggressivePropagationPassImpl : public BasicPropagationPassImpl {
       const ShardingGroupMap& shardingGroupMap,
       GetDirectionToPropagateFn getDirectionToPropagate) override;
 
+  // Loads the `collectiveProfile` if any and runs propagation, then clears the
+  // conflict cache of `aggressiveFactorPropagation`, which refers to ops in the
+  // module.
+  void runOnOperation() override;
+
   Option<PropagationStrategy> propagationStrategy = {
       *this, "propagation-strategy",
       llvm::cl::desc("which factor propagation strategy to use"),
@@ -85,9 +97,20 @@ class AggressivePropagationPassImpl : public BasicPropagationPassImpl {
                      "basic factor propagation followed by aggressive factor "
                      "propagation"))};
 
+  Option<std::string> collectiveProfile{
+      *this, "collective-profile",
+      llvm::cl::desc(
+          "a JSON file that maps op locations or value names to the measured "
+          "cost of the collectives they caused, used to resolve conflicts "
+          "across factors in favor of the historically expensive tensors"),
+      llvm::cl::init("")};
+
  private:
   // This class owns the aggressive factor propagation strategy.
   AggressiveFactorPropagation aggressiveFactorPropagation;
+  // The loaded `collectiveProfile`, if any, which is only set while the pass
+  // is running.
+  std::optional<CollectiveProfile> loadedCollectiveProfile;
 };
 
 std::unique_ptr<Pass> createAggressivePropagationPass(
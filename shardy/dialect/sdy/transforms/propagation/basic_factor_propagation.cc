@@ -25,6 +25,7 @@ limitations under the License.
 #include <tuple>
 #include <utility>
 
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "mlir/IR/Diagnostics.h"
@@ -267,6 +268,35 @@ std::pair<SmallVector<AxisRefAttr>, bool> getCompatibleMajorAxesInternal(
   return {result, canExpand};
 }
 
+// Returns the factors whose axes differ between the tensors they are mapped
+// to, e.g., factors that are sharded in some tensors but not in others.
+//
+// Propagation can't update the sharding of any other factor, as the compatible
+// major axes along it would be a prefix of the axes of every tensor, so none of
+// them would be expanded. Since most factors are either unsharded or already
+// agree, this avoids finding the compatible axes of each of them in turn.
+llvm::BitVector getFactorsToPropagate(const ShardingProjection& projection,
+                                      int64_t numFactors) {
+  llvm::BitVector factorsToPropagate(numFactors);
+  // The axes of the first tensor each factor is mapped to, if any.
+  SmallVector<std::optional<ArrayRef<AxisRefAttr>>> firstAxesPerFactor(
+      numFactors);
+  for (int64_t tensorNum = 0; tensorNum < projection.getNumTensors();
+       ++tensorNum) {
+    for (const auto& [factorIndex, factorSharding] :
+         projection.getTensor(tensorNum).factorIndexToSharding) {
+      std::optional<ArrayRef<AxisRefAttr>>& firstAxes =
+          firstAxesPerFactor[factorIndex];
+      if (!firstAxes) {
+        firstAxes = factorSharding.axisRefs;
+      } else if (*firstAxes != ArrayRef<AxisRefAttr>(factorSharding.axisRefs)) {
+        factorsToPropagate.set(factorIndex);
+      }
+    }
+  }
+  return factorsToPropagate;
+}
+
 }  // namespace
 
 SmallVector<AxisRefAttr> BasicFactorPropagation::getCompatibleMajorAxes(
@@ -380,8 +410,11 @@ UpdateTensorShardings BasicFactorPropagation::propagateFactorShardings(
   UpdateTensorShardings result(projection.getNumOperands(),
                                projection.getNumResults());
 
-  // We propagate each factor separately.
-  for (auto [factorIndex, factorSize] : llvm::enumerate(factorSizes)) {
+  // We propagate each factor separately, skipping the factors whose sharding
+  // can't be updated.
+  for (int64_t factorIndex :
+       getFactorsToPropagate(projection, factorSizes.size()).set_bits()) {
+    int64_t factorSize = factorSizes[factorIndex];
     // For each factor, find the compatible major sharding axes that can shard
     // that factor for all tensors, those are the axes we will propagate to
     // tensors that aren't already sharded.
@@ -15,15 +15,28 @@ limitations under the License.
 
 #include "shardy/dialect/sdy/transforms/propagation/basic_propagation.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <utility>
+#include <variant>
+#include <vector>
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypeInterfaces.h"
@@ -32,8 +45,10 @@ limitations under the License.
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/IR/Operation.h"
+#include "mlir/IR/OwningOpRef.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Value.h"
 #include "mlir/IR/ValueRange.h"
 #include "mlir/IR/Visitors.h"
@@ -44,10 +59,13 @@ limitations under the License.
 #include "mlir/Support/WalkResult.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "shardy/common/logging.h"
+#include "shardy/common/timing_report.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/enums.h"
 #include "shardy/dialect/sdy/ir/utils.h"
 #include "shardy/dialect/sdy/transforms/common/propagation_options.h"
+#include "shardy/dialect/sdy/transforms/common/sharding_walker.h"
+#include "shardy/dialect/sdy/transforms/propagation/debugging/propagation_profiler.h"
 #include "shardy/dialect/sdy/transforms/propagation/debugging/source_sharding.h"
 #include "shardy/dialect/sdy/transforms/propagation/factor_propagation.h"
 #include "shardy/dialect/sdy/transforms/propagation/op_sharding_rule_builder.h"
@@ -71,8 +89,10 @@ using func::FuncOp;
 using SetShardingPerTensorCallback =
     std::function<void(TensorShardingAttr, int64_t)>;
 
-// Sets the sharding of a tensor to the given `TensorShardingAttr`.
-using SetTensorShardingCallback = std::function<void(TensorShardingAttr)>;
+// Sets the shardings of multiple tensors at once, given a sharding per tensor
+// that is null for tensors that shouldn't be updated.
+using SetShardingsCallback =
+    std::function<void(ArrayRef<TensorShardingAttr>)>;
 
 using NotifyOpModifiedCallback = std::function<void(Operation*)>;
 
@@ -177,6 +197,7 @@ struct PropagationSharedParams {
   StringRef meshName;
   MeshAttr mesh;
   std::optional<NotifyOpModifiedCallback> notifyOpModified;
+  PropagationProfiler* profiler = nullptr;
 };
 
 struct PropagationTensorParams {
@@ -184,6 +205,9 @@ struct PropagationTensorParams {
   ArrayRef<TensorShardingAttr> shardings;
   SetShardingPerTensorCallback setShardingCallback;
   bool isFuncResult = false;
+  // If set, used instead of `setShardingCallback` to set the shardings of all
+  // updated tensors at once.
+  SetShardingsCallback setShardingsCallback = nullptr;
 
   PropagationTensorParams(ValueRange tensors,
                           ArrayRef<TensorShardingAttr> shardings,
@@ -195,25 +219,31 @@ struct PropagationTensorParams {
         isFuncResult(isFuncResult) {}
 };
 
-// Update the sharding of `value` to the sharding in `tensorFactorShardings`.
+// The new sharding of each sharding group with a member that was updated in a
+// single propagation step.
 //
-// Returns true if it's possible to update the sharding, i.e., if strided view
-// isn't needed and all non-minor-most factors are divisible by sharding axes.
-bool updateTensorSharding(Value modifiedValue, const SymbolTable& symbolTable,
-                          const SymbolUserMap& userMap,
-                          TensorShardingAttr oldTensorSharding,
-                          SetTensorShardingCallback setTensorShardingCallback,
-                          const TensorFactorShardings& tensorFactorShardings,
-                          TensorMappingAttr tensorMapping,
-                          ArrayRef<int64_t> factorSizes,
-                          const PropagationSharedParams& params,
-                          bool isFuncResult) {
-  // We can assume `modifiedValue` exists since we are updating its sharding.
-  assert(modifiedValue && "modified value should exist");
+// All members of a group share a single canonical sharding, so instead of
+// pushing every member update to the entire group, the updates of a step are
+// collected here and applied once per group at the end of the step (see
+// `applyShardingGroupUpdates`).
+using ShardingGroupUpdates =
+    llvm::SmallMapVector<int64_t, TensorShardingAttr, 4>;
+
+// Returns the sharding in `tensorFactorShardings` that a tensor with
+// `oldTensorSharding` should be updated to.
+//
+// Returns a null sharding if it isn't possible to update the sharding, i.e.,
+// if strided view is needed or not all non-minor-most factors are divisible by
+// sharding axes.
+TensorShardingAttr getUpdatedTensorSharding(
+    TensorShardingAttr oldTensorSharding,
+    const TensorFactorShardings& tensorFactorShardings,
+    TensorMappingAttr tensorMapping, ArrayRef<int64_t> factorSizes,
+    const PropagationSharedParams& params) {
   TensorShardingAttr newSharding =
       tensorFactorShardings.createTensorShardingAttr(
           params.mesh.getContext(), tensorMapping, factorSizes, params.meshName,
-          params.mesh);
+          params.mesh, oldTensorSharding);
   // `oldTensorSharding` may be null if there is no sharding, in which case we
   // check if `newSharding` is empty.
   // TODO(tomnatan): remove this checking if the new sharding equals the old
@@ -222,15 +252,33 @@ bool updateTensorSharding(Value modifiedValue, const SymbolTable& symbolTable,
   if ((!oldTensorSharding && newSharding.emptyAxes()) ||
       newSharding == oldTensorSharding) {
     // This means no update can be done to the sharding.
-    return false;
+    return TensorShardingAttr();
   }
+  return newSharding;
+}
 
-  setTensorShardingCallback(newSharding);
+// Handles the update of the sharding of `modifiedValue` to `newSharding`,
+// after it was set, by notifying all affected ops.
+//
+// If `modifiedValue` is in a sharding group, the new sharding is recorded in
+// `groupUpdates` to be applied to the other members of the group.
+void handleTensorShardingUpdate(Value modifiedValue,
+                                TensorShardingAttr newSharding,
+                                const SymbolTable& symbolTable,
+                                const SymbolUserMap& userMap,
+                                const PropagationSharedParams& params,
+                                bool isFuncResult,
+                                ShardingGroupUpdates& groupUpdates) {
+  // We can assume `modifiedValue` exists since we are updating its sharding.
+  assert(modifiedValue && "modified value should exist");
+  if (params.profiler) {
+    params.profiler->recordShardingUpdate(modifiedValue);
+  }
 
   if (isFuncResult) {
     // Nothing more to do for a func result as it doesn't affect any tensor
     // other than the return value and can't be part of a sharding group.
-    return true;
+    return;
   }
 
   if (params.notifyOpModified) {
@@ -238,27 +286,47 @@ bool updateTensorSharding(Value modifiedValue, const SymbolTable& symbolTable,
                            *params.notifyOpModified);
   }
 
-  // Set the sharding of all values in the same sharding group to be equivalent
-  // (skipping the modified value which has already been updated).
-  for (Value groupValue :
-       params.shardingGroupMap.getGroupMembers(modifiedValue)) {
-    if (groupValue == modifiedValue) {
-      continue;
-    }
-    setSharding(groupValue, newSharding);
-    if (params.notifyOpModified) {
-      notifyShardingModified(groupValue, symbolTable, userMap,
-                             *params.notifyOpModified);
-    }
+  if (std::optional<int64_t> groupId =
+          params.shardingGroupMap.getGroupId(modifiedValue)) {
+    // If multiple members of the same group are updated in this step, the last
+    // update wins, as it would if each update was pushed to the whole group.
+    groupUpdates[*groupId] = newSharding;
   }
+}
 
-  return true;
+// Sets the sharding of all members of each group in `groupUpdates` to the new
+// group sharding, skipping members that already have it (e.g. the updated
+// member itself), so that each member is updated and its users notified at most
+// once per propagation step.
+void applyShardingGroupUpdates(const ShardingGroupUpdates& groupUpdates,
+                               const SymbolTable& symbolTable,
+                               const SymbolUserMap& userMap,
+                               const PropagationSharedParams& params) {
+  for (auto [groupId, groupSharding] : groupUpdates) {
+    for (Value groupValue :
+         params.shardingGroupMap.getGroupMembersById(groupId)) {
+      if (getSharding(groupValue) == groupSharding) {
+        continue;
+      }
+      setSharding(groupValue, groupSharding);
+      if (params.profiler) {
+        params.profiler->recordShardingUpdate(groupValue);
+      }
+      if (params.notifyOpModified) {
+        notifyShardingModified(groupValue, symbolTable, userMap,
+                               *params.notifyOpModified);
+      }
+    }
+  }
 }
 
 // Updates the sharding of all tensors according to `tensorFactorShardings`.
 //
 // Skips tensors for which `updateTensor` is set to false.
 //
+// The new shardings of all tensors are computed before any of them is set, so
+// that they can be set at once if `tensorParams.setShardingsCallback` is set.
+//
 // If an operand or result couldn't be updated to the corresponding sharding in
 // `tensorFactorShardings`, e.g., if strided view is required, sets the
 // respective bit in `updateTensor` or `updateResult` to false.
@@ -267,18 +335,34 @@ void updateTensorShardings(
     const SymbolUserMap& userMap,
     ArrayRef<TensorFactorShardings> tensorFactorShardings,
     ArrayRef<TensorMappingAttr> tensorMappings, ArrayRef<int64_t> factorSizes,
-    BitVector& updateTensor, const PropagationSharedParams& params) {
+    BitVector& updateTensor, const PropagationSharedParams& params,
+    ShardingGroupUpdates& groupUpdates) {
+  SmallVector<TensorShardingAttr> newShardings(tensorParams.tensors.size());
   for (int64_t index : updateTensor.set_bits()) {
-    if (!updateTensorSharding(
-            getShardableValue(tensorParams.tensors[index]), symbolTable,
-            userMap, tensorParams.shardings[index],
-            std::bind(tensorParams.setShardingCallback, std::placeholders::_1,
-                      index),
-            tensorFactorShardings[index], tensorMappings[index], factorSizes,
-            params, tensorParams.isFuncResult)) {
+    newShardings[index] = getUpdatedTensorSharding(
+        tensorParams.shardings[index], tensorFactorShardings[index],
+        tensorMappings[index], factorSizes, params);
+    if (!newShardings[index]) {
       updateTensor.reset(index);
     }
   }
+  if (updateTensor.none()) {
+    return;
+  }
+
+  if (tensorParams.setShardingsCallback) {
+    tensorParams.setShardingsCallback(newShardings);
+  } else {
+    for (int64_t index : updateTensor.set_bits()) {
+      tensorParams.setShardingCallback(newShardings[index], index);
+    }
+  }
+  for (int64_t index : updateTensor.set_bits()) {
+    handleTensorShardingUpdate(getShardableValue(tensorParams.tensors[index]),
+                               newShardings[index], symbolTable, userMap,
+                               params, tensorParams.isFuncResult,
+                               groupUpdates);
+  }
 }
 
 // Same as the overload above, except operates on both operands and results.
@@ -290,14 +374,30 @@ void updateTensorShardings(const PropagationTensorParams& operandsParams,
                            const ShardingProjection& shardingProjection,
                            BitVector& updateOperand, BitVector& updateResult,
                            const PropagationSharedParams& params) {
+  // An op can be affected by multiple updated tensors, e.g., a user of
+  // multiple results, so each op is only notified once per propagation step.
+  PropagationSharedParams dedupedParams = params;
+  llvm::SmallPtrSet<Operation*, 16> notifiedOps;
+  if (params.notifyOpModified) {
+    dedupedParams.notifyOpModified = [&](Operation* op) {
+      if (notifiedOps.insert(op).second) {
+        (*params.notifyOpModified)(op);
+      }
+    };
+  }
+
+  ShardingGroupUpdates groupUpdates;
   updateTensorShardings(operandsParams, symbolTable, userMap,
                         shardingProjection.getOperands(),
                         shardingRule.getOperandMappings(),
-                        shardingRule.getFactorSizes(), updateOperand, params);
+                        shardingRule.getFactorSizes(), updateOperand,
+                        dedupedParams, groupUpdates);
   updateTensorShardings(resultsParams, symbolTable, userMap,
                         shardingProjection.getResults(),
                         shardingRule.getResultMappings(),
-                        shardingRule.getFactorSizes(), updateResult, params);
+                        shardingRule.getFactorSizes(), updateResult,
+                        dedupedParams, groupUpdates);
+  applyShardingGroupUpdates(groupUpdates, symbolTable, userMap, dedupedParams);
 }
 
 // Propagates tensor shardings of the given `operands` and `results` according
@@ -313,12 +413,14 @@ LogicalResult propagateTensorShardings(
     PropagationDirectionAlongFactor directionAlongFactor,
     const FactorPropagation& factorPropagation, bool conservativePropagation,
     Operation* op, const SymbolTable& symbolTable, PatternRewriter* rewriter,
-    ShardingGroupMap shardingGroupMap) {
-  std::optional<StringRef> meshName =
-      getCommonMeshName(operandsParams.shardings, resultsParams.shardings,
-                        symbolTable, /*ignoreDeviceIds=*/false);
+    const ShardingGroupMap& shardingGroupMap,
+    ShardingProjectionCache* projectionCache = nullptr,
+    PropagationProfiler* profiler = nullptr) {
+  Attribute meshOrRef =
+      getCommonMeshOrRef(operandsParams.shardings, resultsParams.shardings,
+                         symbolTable, /*ignoreDeviceIds=*/false);
 
-  if (!meshName.has_value()) {
+  if (!meshOrRef) {
     // This means none of the operands or results have a sharding attribute or
     // the sharding attributes use different meshes.
     if (rewriter) {
@@ -327,7 +429,10 @@ LogicalResult propagateTensorShardings(
     }
     return failure();
   }
-  MeshAttr mesh = getMeshAttr(op, meshName.value());
+  // We assume that if there is a common mesh, then there can only be a unique
+  // symbol name referencing that mesh.
+  StringRef meshName = cast<FlatSymbolRefAttr>(meshOrRef).getValue();
+  MeshAttr mesh = getMeshOrLookup(symbolTable, meshOrRef);
   assert(mesh && "unknown mesh");
   if (mesh.isMaximal()) {
     // Maximal meshes and shardings are usually a placeholder for special
@@ -354,8 +459,27 @@ LogicalResult propagateTensorShardings(
     };
   }
 
-  ShardingProjection shardingProjection = ShardingProjection::build(
-      operandsParams.shardings, resultsParams.shardings, shardingRule, mesh);
+  // Only read the clock when profiling, as this runs for every op visit.
+  std::optional<std::chrono::steady_clock::time_point> startTime;
+  if (profiler) {
+    startTime = std::chrono::steady_clock::now();
+    if (!projectionCache) {
+      profiler->recordProjectionBuilds({/*numFullBuilds=*/1});
+    }
+  }
+  // The cached projection is propagated in place, so only a projection built
+  // without a cache needs storage here.
+  std::optional<ShardingProjection> builtProjection;
+  if (!projectionCache) {
+    builtProjection = ShardingProjection::build(
+        operandsParams.shardings, resultsParams.shardings, shardingRule, mesh);
+  }
+  ShardingProjection& shardingProjection =
+      projectionCache
+          ? projectionCache->getOrBuild(op, operandsParams.shardings,
+                                        resultsParams.shardings, shardingRule,
+                                        mesh)
+          : *builtProjection;
   PropagationDirectionAlongFactor localDirectionAlongFactor =
       [shardingRule, directionAlongFactor](int64_t factorIndex) {
         if (shardingRule.isBlockedPropagationFactor(factorIndex)) {
@@ -366,12 +490,15 @@ LogicalResult propagateTensorShardings(
 
   bool anyUpdated = false;
   auto updateShardings = [&]() {
-    auto [updateOperand, updateResult] =
-        factorPropagation.propagateFactorShardings(
-            shardingProjection, localDirectionAlongFactor,
-            shardingRule.getFactorSizes(), mesh, conservativePropagation, op);
-    PropagationSharedParams params{shardingGroupMap, meshName.value(), mesh,
-                                   notifyOpModified};
+    UpdateTensorShardings updated = factorPropagation.propagateFactorShardings(
+        shardingProjection, localDirectionAlongFactor,
+        shardingRule.getFactorSizes(), mesh, conservativePropagation, op);
+    if (projectionCache) {
+      projectionCache->markUpdated(op, updated);
+    }
+    auto& [updateOperand, updateResult] = updated;
+    PropagationSharedParams params{shardingGroupMap, meshName, mesh,
+                                   notifyOpModified, profiler};
 
     updateTensorShardings(operandsParams, resultsParams, symbolTable, userMap,
                           shardingRule, shardingProjection, updateOperand,
@@ -390,6 +517,12 @@ LogicalResult propagateTensorShardings(
     updateShardings();
   }
 
+  if (profiler) {
+    profiler->recordPropagationStep(
+        op, std::chrono::steady_clock::now() - *startTime, anyUpdated,
+        shardingRule.getNumFactors());
+  }
+
   if (rewriter && !anyUpdated) {
     return rewriter->notifyMatchFailure(op, [](Diagnostic& diag) {
       diag << "Couldn't update any of the factor shardings";
@@ -407,6 +540,7 @@ LogicalResult propagateTensorShardings(
     PropagationDirectionAlongFactor directionAlongFactor,
     const FactorPropagation& factorPropagation,
     const ShardingGroupMap& shardingGroupMap,
+    ShardingProjectionCache* projectionCache, PropagationProfiler* profiler,
     bool conservativePropagation = false) {
   SmallVector<TensorShardingAttr> operandsShardings = getShardings(operands);
   SmallVector<TensorShardingAttr> resultsShardings = getShardings(results);
@@ -422,11 +556,21 @@ LogicalResult propagateTensorShardings(
       /*setShardingCallback=*/[&](TensorShardingAttr sharding, int64_t index) {
         setSharding(results[index], sharding);
       });
+  // The results of a regular op share a single `TensorShardingPerValueAttr`,
+  // so it's built once instead of for every updated result.
+  if (results.size() > 1 && !isa<ShardableDataFlowOpInterface>(op) &&
+      llvm::equal(results, op->getResults())) {
+    resultsParams.setShardingsCallback =
+        [op](ArrayRef<TensorShardingAttr> shardings) {
+          replaceShardingsAtIndices(op, shardings);
+        };
+  }
 
   return propagateTensorShardings(operandsParams, resultsParams, userMap,
                                   shardingRule, directionAlongFactor,
                                   factorPropagation, conservativePropagation,
-                                  op, symbolTable, &rewriter, shardingGroupMap);
+                                  op, symbolTable, &rewriter, shardingGroupMap,
+                                  projectionCache, profiler);
 }
 
 // Propagates the shardings between the operands of the `funcOp`'s terminator
@@ -434,7 +578,8 @@ LogicalResult propagateTensorShardings(
 void propagateFuncResults(FuncOp funcOp, const SymbolUserMap& userMap,
                           const SymbolTable& symbolTable,
                           const FactorPropagation& factorPropagation,
-                          const ShardingGroupMap& shardingGroupMap) {
+                          const ShardingGroupMap& shardingGroupMap,
+                          PropagationProfiler* profiler) {
   for (OpOperand& returnOperand : getBodyTerminatorOpOperands(funcOp)) {
     Value returnValue = returnOperand.get();
     auto tensorType = dynCastStaticShapedType(returnValue.getType());
@@ -480,7 +625,8 @@ void propagateFuncResults(FuncOp funcOp, const SymbolUserMap& userMap,
         std::bind(propagateAny, funcOp, std::placeholders::_1),
         factorPropagation,
         /*conservativePropagation=*/false, funcOp, symbolTable,
-        /*rewriter=*/nullptr, shardingGroupMap);
+        /*rewriter=*/nullptr, shardingGroupMap, /*projectionCache=*/nullptr,
+        profiler);
   }
 }
 
@@ -489,10 +635,21 @@ void propagateFuncResults(FuncOp funcOp, const SymbolUserMap& userMap,
 void propagateFuncResults(ModuleOp moduleOp, const SymbolUserMap& userMap,
                           const SymbolTable& symbolTable,
                           const FactorPropagation& factorPropagation,
-                          const ShardingGroupMap& shardingGroupMap) {
+                          const ShardingGroupMap& shardingGroupMap,
+                          PropagationProfiler* profiler) {
   propagateFuncResults(
       getMainFuncOrDie(moduleOp, symbolTable, /*useSingleFunc=*/true), userMap,
-      symbolTable, factorPropagation, shardingGroupMap);
+      symbolTable, factorPropagation, shardingGroupMap, profiler);
+}
+
+// Records the `result` of applying the pattern with `patternName` in
+// `profiler`, if specified, and returns it.
+LogicalResult recordPatternResult(PropagationProfiler* profiler,
+                                  StringRef patternName, LogicalResult result) {
+  if (profiler) {
+    profiler->recordPatternApplication(patternName, succeeded(result));
+  }
+  return result;
 }
 
 // Propagates the sharding of an operation (between operands and results) that
@@ -504,14 +661,17 @@ class PropagateRegisteredOp : public RewritePattern {
       const SymbolUserMap& userMap,
       GetDirectionToPropagateFn getDirectionToPropagate,
       const FactorPropagation& factorPropagation, bool conservativePropagation,
-      const ShardingGroupMap& shardingGroupMap)
+      const ShardingGroupMap& shardingGroupMap,
+      ShardingProjectionCache* projectionCache, PropagationProfiler* profiler)
       : RewritePattern(MatchAnyOpTypeTag(), /*benefit=*/1, context),
         symbolTable(symbolTable),
         userMap(userMap),
         getDirectionToPropagate(getDirectionToPropagate),
         factorPropagation(factorPropagation),
         conservativePropagation(conservativePropagation),
-        shardingGroupMap(shardingGroupMap) {}
+        shardingGroupMap(shardingGroupMap),
+        projectionCache(projectionCache),
+        profiler(profiler) {}
 
   LogicalResult matchAndRewrite(Operation* op,
                                 PatternRewriter& rewriter) const override {
@@ -526,10 +686,13 @@ class PropagateRegisteredOp : public RewritePattern {
 
     PropagationDirectionAlongFactor directionAlongFactor =
         std::bind(getDirectionToPropagate, op, std::placeholders::_1);
-    return propagateTensorShardings(
-        op->getOperands(), op->getResults(), userMap, shardingRule, op,
-        symbolTable, rewriter, directionAlongFactor, factorPropagation,
-        shardingGroupMap, conservativePropagation);
+    return recordPatternResult(
+        profiler, "PropagateRegisteredOp",
+        propagateTensorShardings(
+            op->getOperands(), op->getResults(), userMap, shardingRule, op,
+            symbolTable, rewriter, directionAlongFactor, factorPropagation,
+            shardingGroupMap, projectionCache, profiler,
+            conservativePropagation));
   }
 
  private:
@@ -539,6 +702,8 @@ class PropagateRegisteredOp : public RewritePattern {
   const FactorPropagation& factorPropagation;
   bool conservativePropagation;
   const ShardingGroupMap& shardingGroupMap;
+  ShardingProjectionCache* projectionCache;
+  PropagationProfiler* profiler;
 };
 
 // Propagates shardings between the sources and targets of an
@@ -552,13 +717,16 @@ class PropagateDataFlowEdgeOp : public OpRewritePattern<DataFlowEdgeOp> {
       const SymbolUserMap& userMap,
       GetDirectionToPropagateFn getDirectionToPropagate,
       const FactorPropagation& factorPropagation,
-      const ShardingGroupMap& shardingGroupMap)
+      const ShardingGroupMap& shardingGroupMap,
+      ShardingProjectionCache* projectionCache, PropagationProfiler* profiler)
       : OpRewritePattern<DataFlowEdgeOp>(context),
         symbolTable(symbolTable),
         userMap(userMap),
         getDirectionToPropagate(getDirectionToPropagate),
         factorPropagation(factorPropagation),
-        shardingGroupMap(shardingGroupMap) {}
+        shardingGroupMap(shardingGroupMap),
+        projectionCache(projectionCache),
+        profiler(profiler) {}
 
   LogicalResult matchAndRewrite(DataFlowEdgeOp dataFlowEdgeOp,
                                 PatternRewriter& rewriter) const override {
@@ -598,12 +766,14 @@ class PropagateDataFlowEdgeOp : public OpRewritePattern<DataFlowEdgeOp> {
 
     PropagationDirectionAlongFactor directionAlongFactor = std::bind(
         getDirectionToPropagate, dataFlowEdgeOp, std::placeholders::_1);
-    return propagateTensorShardings(
-        operandsParams, resultsParams, userMap,
-        createIdentityShardingRule(shapedType, sources.size()),
-        directionAlongFactor, factorPropagation,
-        /*conservativePropagation=*/false, dataFlowEdgeOp, symbolTable,
-        &rewriter, shardingGroupMap);
+    return recordPatternResult(
+        profiler, "PropagateDataFlowEdgeOp",
+        propagateTensorShardings(
+            operandsParams, resultsParams, userMap,
+            createIdentityShardingRule(shapedType, sources.size()),
+            directionAlongFactor, factorPropagation,
+            /*conservativePropagation=*/false, dataFlowEdgeOp, symbolTable,
+            &rewriter, shardingGroupMap, projectionCache, profiler));
   }
 
  private:
@@ -612,6 +782,8 @@ class PropagateDataFlowEdgeOp : public OpRewritePattern<DataFlowEdgeOp> {
   GetDirectionToPropagateFn getDirectionToPropagate;
   const FactorPropagation& factorPropagation;
   const ShardingGroupMap& shardingGroupMap;
+  ShardingProjectionCache* projectionCache;
+  PropagationProfiler* profiler;
 };
 
 // Propagates shardings between:
@@ -628,13 +800,16 @@ class PropagateFuncDataFlowEdgeOp
       const SymbolUserMap& userMap,
       GetDirectionToPropagateFn getDirectionToPropagate,
       const FactorPropagation& factorPropagation,
-      const ShardingGroupMap& shardingGroupMap)
+      const ShardingGroupMap& shardingGroupMap,
+      ShardingProjectionCache* projectionCache, PropagationProfiler* profiler)
       : OpRewritePattern<FuncDataFlowEdgeOp>(context),
         symbolTable(symbolTable),
         userMap(userMap),
         getDirectionToPropagate(getDirectionToPropagate),
         factorPropagation(factorPropagation),
-        shardingGroupMap(shardingGroupMap) {}
+        shardingGroupMap(shardingGroupMap),
+        projectionCache(projectionCache),
+        profiler(profiler) {}
 
   LogicalResult matchAndRewrite(FuncDataFlowEdgeOp funcEdgeOp,
                                 PatternRewriter& rewriter) const override {
@@ -694,12 +869,14 @@ class PropagateFuncDataFlowEdgeOp
 
     PropagationDirectionAlongFactor directionAlongFactor =
         std::bind(getDirectionToPropagate, funcEdgeOp, std::placeholders::_1);
-    return propagateTensorShardings(
-        operandsParams, resultsParams, userMap,
-        createIdentityShardingRule(funcEdgeOp.getType(), sources.size()),
-        directionAlongFactor, factorPropagation,
-        /*conservativePropagation=*/false, funcEdgeOp, symbolTable, &rewriter,
-        shardingGroupMap);
+    return recordPatternResult(
+        profiler, "PropagateFuncDataFlowEdgeOp",
+        propagateTensorShardings(
+            operandsParams, resultsParams, userMap,
+            createIdentityShardingRule(funcEdgeOp.getType(), sources.size()),
+            directionAlongFactor, factorPropagation,
+            /*conservativePropagation=*/false, funcEdgeOp, symbolTable,
+            &rewriter, shardingGroupMap, projectionCache, profiler));
   }
 
  private:
@@ -708,6 +885,8 @@ class PropagateFuncDataFlowEdgeOp
   GetDirectionToPropagateFn getDirectionToPropagate;
   const FactorPropagation& factorPropagation;
   const ShardingGroupMap& shardingGroupMap;
+  ShardingProjectionCache* projectionCache;
+  PropagationProfiler* profiler;
 };
 
 // Propagates through a `PropagationBarrierOp` accounting for the direction in
@@ -718,23 +897,28 @@ class PropagatePropagationBarrier
   explicit PropagatePropagationBarrier(
       MLIRContext* context, const SymbolTable& symbolTable,
       const SymbolUserMap& userMap, const FactorPropagation& factorPropagation,
-      const ShardingGroupMap& shardingGroupMap)
+      const ShardingGroupMap& shardingGroupMap,
+      ShardingProjectionCache* projectionCache, PropagationProfiler* profiler)
       : OpRewritePattern<PropagationBarrierOp>(context),
         symbolTable(symbolTable),
         userMap(userMap),
         factorPropagation(factorPropagation),
-        shardingGroupMap(shardingGroupMap) {}
+        shardingGroupMap(shardingGroupMap),
+        projectionCache(projectionCache),
+        profiler(profiler) {}
 
   LogicalResult matchAndRewrite(PropagationBarrierOp propagationBarrierOp,
                                 PatternRewriter& rewriter) const override {
-    return propagateTensorShardings(
-        propagationBarrierOp.getInput(), propagationBarrierOp.getResult(),
-        userMap,
-        createIdentityShardingRule(
-            cast<RankedTensorType>(propagationBarrierOp.getType())),
-        propagationBarrierOp, symbolTable, rewriter,
-        [&](int64_t) { return propagationBarrierOp.getAllowedDirection(); },
-        factorPropagation, shardingGroupMap);
+    return recordPatternResult(
+        profiler, "PropagatePropagationBarrier",
+        propagateTensorShardings(
+            propagationBarrierOp.getInput(), propagationBarrierOp.getResult(),
+            userMap,
+            createIdentityShardingRule(
+                cast<RankedTensorType>(propagationBarrierOp.getType())),
+            propagationBarrierOp, symbolTable, rewriter,
+            [&](int64_t) { return propagationBarrierOp.getAllowedDirection(); },
+            factorPropagation, shardingGroupMap, projectionCache, profiler));
   }
 
  private:
@@ -742,8 +926,742 @@ class PropagatePropagationBarrier
   const SymbolUserMap& userMap;
   const FactorPropagation& factorPropagation;
   const ShardingGroupMap& shardingGroupMap;
+  ShardingProjectionCache* projectionCache;
+  PropagationProfiler* profiler;
+};
+
+// The kind of propagation that `ShardingWorklistDriver` applies on an op,
+// i.e., which of the propagation patterns above is tried first.
+enum class PropagationKind : uint8_t {
+  kRegisteredOp,
+  kDataFlowEdge,
+  kFuncDataFlowEdge,
+  kPropagationBarrier,
+};
+
+PropagationKind getPropagationKind(Operation* op) {
+  if (isa<DataFlowEdgeOp>(op)) {
+    return PropagationKind::kDataFlowEdge;
+  }
+  if (isa<FuncDataFlowEdgeOp>(op)) {
+    return PropagationKind::kFuncDataFlowEdge;
+  }
+  if (isa<PropagationBarrierOp>(op)) {
+    return PropagationKind::kPropagationBarrier;
+  }
+  return PropagationKind::kRegisteredOp;
+}
+
+// The ops in the scope of a `ShardingWorklistDriver`, in pre-order, along with
+// their dense index and propagation kind.
+//
+// An index of the whole module is shared by the drivers of all propagation
+// runs of a pass (see `BasicPropagationPassImpl::ModuleIndex`), instead of
+// walking the module again in every run.
+struct ShardingOpIndex {
+  void addOp(Operation* op) {
+    opToIndex.try_emplace(op, ops.size());
+    ops.push_back(op);
+    kinds.push_back(getPropagationKind(op));
+  }
+
+  SmallVector<Operation*> ops;
+  SmallVector<PropagationKind> kinds;
+  llvm::DenseMap<Operation*, int64_t> opToIndex;
+};
+
+// A dedicated worklist driver for sharding propagation, that reaches the same
+// fixed point as `applyPatternsGreedily` with the propagation patterns above,
+// without the overhead of the generic rewrite driver.
+//
+// All ops in the scope of the driver (either a module or a single function) are
+// assigned a dense index (in pre-order) and a propagation kind ahead of time
+// (see `ShardingOpIndex`), and a bit vector keeps track of which ops are
+// currently in the worklist. To preserve the propagation order of the greedy
+// driver, the worklist is processed in LIFO order, and modifying an op adds it
+// and all of its ancestors (up to the module) back to the worklist.
+//
+// If loop-aware propagation is enabled (see `enableLoopAwarePropagation`), the
+// ops nested in a loop are processed on a separate worklist of that loop
+// instead, which is drained whenever the loop op is popped from its own
+// worklist.
+//
+// Modified ops outside the scope of the driver are recorded as external ops,
+// and deferred ops are recorded as sync ops instead of being propagated, e.g.,
+// if `deferFuncDataFlowEdges` is true, `sdy.func_data_flow_edge` ops are
+// deferred, as they update shardings across function boundaries. Both are
+// handled by the caller.
+class ShardingWorklistDriver : public RewriterBase::Listener {
+ public:
+  ShardingWorklistDriver(Operation* scope, const SymbolTable& symbolTable,
+                         const SymbolUserMap& userMap,
+                         GetDirectionToPropagateFn getDirectionToPropagate,
+                         const FactorPropagation& factorPropagation,
+                         bool conservativePropagation,
+                         const ShardingGroupMap& shardingGroupMap,
+                         PropagationProfiler* profiler = nullptr,
+                         bool deferFuncDataFlowEdges = false)
+      : ShardingWorklistDriver(scope->getContext(), symbolTable, userMap,
+                               getDirectionToPropagate, factorPropagation,
+                               conservativePropagation, shardingGroupMap,
+                               profiler) {
+    auto addNestedOp = [&](Operation* op) {
+      addOp(op, deferFuncDataFlowEdges && isa<FuncDataFlowEdgeOp>(op));
+    };
+    if (!isa<ModuleOp>(scope)) {
+      addNestedOp(scope);
+    }
+    for (Region& region : scope->getRegions()) {
+      region.walk<WalkOrder::PreOrder>(addNestedOp);
+    }
+    initializePerOpState();
+  }
+
+  // Creates a driver whose scope is `scopeOps`, which should be in pre-order,
+  // where the ops in `deferredOps` are deferred.
+  ShardingWorklistDriver(MLIRContext* context, ArrayRef<Operation*> scopeOps,
+                         const llvm::DenseSet<Operation*>& deferredOps,
+                         const SymbolTable& symbolTable,
+                         const SymbolUserMap& userMap,
+                         GetDirectionToPropagateFn getDirectionToPropagate,
+                         const FactorPropagation& factorPropagation,
+                         bool conservativePropagation,
+                         const ShardingGroupMap& shardingGroupMap,
+                         PropagationProfiler* profiler = nullptr)
+      : ShardingWorklistDriver(context, symbolTable, userMap,
+                               getDirectionToPropagate, factorPropagation,
+                               conservativePropagation, shardingGroupMap,
+                               profiler) {
+    for (Operation* op : scopeOps) {
+      addOp(op, deferredOps.contains(op));
+    }
+    initializePerOpState();
+  }
+
+  // Creates a driver whose scope is the ops in `sharedIndex`, which must
+  // outlive the driver, where no op is deferred.
+  ShardingWorklistDriver(MLIRContext* context,
+                         const ShardingOpIndex& sharedIndex,
+                         const SymbolTable& symbolTable,
+                         const SymbolUserMap& userMap,
+                         GetDirectionToPropagateFn getDirectionToPropagate,
+                         const FactorPropagation& factorPropagation,
+                         bool conservativePropagation,
+                         const ShardingGroupMap& shardingGroupMap,
+                         PropagationProfiler* profiler = nullptr)
+      : ShardingWorklistDriver(context, symbolTable, userMap,
+                               getDirectionToPropagate, factorPropagation,
+                               conservativePropagation, shardingGroupMap,
+                               profiler) {
+    index = &sharedIndex;
+    initializePerOpState();
+  }
+
+  // Propagates the body of each loop, i.e., an op with data flow edges and
+  // regions whose arguments are tied to them, e.g., `stablehlo.while`, to a
+  // local fixed point before any op outside the loop is revisited. Updates to
+  // the carried values are then only committed to the ops outside the loop,
+  // through the data flow edges on its results, once the body has converged,
+  // and the body is only revisited when the sharding of a carried value
+  // changes, instead of after every update of an op outside the loop.
+  //
+  // Must be called before any op is added to the worklist.
+  void enableLoopAwarePropagation() {
+    SDY_CHECK(worklist.empty());
+    for (auto [opIndex, op] : llvm::enumerate(index->ops)) {
+      int64_t& loop = enclosingLoop[opIndex];
+      for (Operation* parent = op->getParentOp(); parent;
+           parent = parent->getParentOp()) {
+        auto it = index->opToIndex.find(parent);
+        if (it == index->opToIndex.end()) {
+          continue;
+        }
+        // Ops are in pre-order, so the enclosing loop of `parent` is known.
+        loop = isLoop(parent) ? it->second : enclosingLoop[it->second];
+        break;
+      }
+      if (isLoop(op)) {
+        loopWorklistIndex[opIndex] = loopWorklists.size();
+        loopWorklists.emplace_back();
+      }
+    }
+  }
+
+  // Adds all ops to the worklist and propagates until a fixed point is
+  // reached.
+  //
+  // If `frontier` is specified, only the ops in it are added to the worklist
+  // initially, and every op that is visited is added to it.
+  //
+  // Returns true if the sharding of any op was updated.
+  bool run(llvm::SetVector<Operation*>* frontier = nullptr) {
+    if (frontier) {
+      SmallVector<int64_t> frontierIndices;
+      frontierIndices.reserve(frontier->size());
+      for (Operation* op : *frontier) {
+        if (auto it = index->opToIndex.find(op);
+            it != index->opToIndex.end()) {
+          frontierIndices.push_back(it->second);
+        }
+      }
+      // Push in reverse order so the first op in pre-order is processed first.
+      llvm::sort(frontierIndices, std::greater<int64_t>());
+      for (int64_t opIndex : frontierIndices) {
+        push(opIndex);
+      }
+    } else {
+      pushAll();
+    }
+    return drain(frontier);
+  }
+
+  // Adds all ops to the worklist.
+  void pushAll() {
+    // Push in reverse order so the first op in pre-order is processed first.
+    for (int64_t opIndex = index->ops.size() - 1; opIndex >= 0; --opIndex) {
+      push(opIndex);
+    }
+  }
+
+  // Propagates until the worklist is empty, adding every visited op to
+  // `frontier` if specified.
+  //
+  // Returns true if the sharding of any op was updated.
+  bool drain(llvm::SetVector<Operation*>* frontier = nullptr) {
+    bool anyUpdated = false;
+    while (!worklist.empty()) {
+      anyUpdated |= visit(worklist.pop_back_val(), frontier);
+    }
+    return anyUpdated;
+  }
+
+  // Propagates all sync ops recorded so far, in the order they were recorded.
+  //
+  // Returns true if the sharding of any op was updated.
+  bool propagateSyncOps() {
+    bool anyUpdated = false;
+    for (Operation* op : syncOps.takeVector()) {
+      anyUpdated |= succeeded(propagate(index->opToIndex.at(op)));
+    }
+    return anyUpdated;
+  }
+
+  // Returns and clears the modified ops outside the scope of this driver.
+  SmallVector<Operation*> takeExternalOps() {
+    return std::exchange(externalOps, {});
+  }
+
+  bool hasPendingWork() const { return !worklist.empty() || !syncOps.empty(); }
+
+  const ShardingProjectionCache::Stats& getProjectionCacheStats() const {
+    return projectionCache.getStats();
+  }
+
+  void notifyOperationModified(Operation* op) override {
+    if (!index->opToIndex.contains(op)) {
+      externalOps.push_back(op);
+      return;
+    }
+    for (; op && !isa<ModuleOp>(op); op = op->getParentOp()) {
+      if (auto it = index->opToIndex.find(op); it != index->opToIndex.end()) {
+        push(it->second);
+      }
+    }
+  }
+
+ private:
+  ShardingWorklistDriver(MLIRContext* context, const SymbolTable& symbolTable,
+                         const SymbolUserMap& userMap,
+                         GetDirectionToPropagateFn getDirectionToPropagate,
+                         const FactorPropagation& factorPropagation,
+                         bool conservativePropagation,
+                         const ShardingGroupMap& shardingGroupMap,
+                         PropagationProfiler* profiler)
+      : rewriter(context),
+        registeredOpPattern(context, symbolTable, userMap,
+                            getDirectionToPropagate, factorPropagation,
+                            conservativePropagation, shardingGroupMap,
+                            &projectionCache, profiler),
+        dataFlowEdgePattern(context, symbolTable, userMap,
+                            getDirectionToPropagate, factorPropagation,
+                            shardingGroupMap, &projectionCache, profiler),
+        funcDataFlowEdgePattern(context, symbolTable, userMap,
+                                getDirectionToPropagate, factorPropagation,
+                                shardingGroupMap, &projectionCache, profiler),
+        propagationBarrierPattern(context, symbolTable, userMap,
+                                  factorPropagation, shardingGroupMap,
+                                  &projectionCache, profiler) {
+    rewriter.setListener(this);
+  }
+
+  void addOp(Operation* op, bool isDeferred) {
+    ownedIndex.addOp(op);
+    deferred.push_back(isDeferred);
+  }
+
+  // Sizes the state the driver keeps per op to the number of ops in `index`.
+  void initializePerOpState() {
+    int64_t numOps = index->ops.size();
+    deferred.resize(numOps);
+    enclosingLoop.assign(numOps, -1);
+    loopWorklistIndex.assign(numOps, -1);
+    inWorklist.resize(numOps);
+  }
+
+  // Returns true if `op` is a loop, i.e., an op with data flow edges whose
+  // regions have arguments, which are tied to the data flow edges.
+  static bool isLoop(Operation* op) {
+    return isa<ShardableDataFlowOpInterface>(op) &&
+           llvm::any_of(op->getRegions(), [](Region& region) {
+             return !region.empty() && region.front().getNumArguments() > 0;
+           });
+  }
+
+  // Pushes the op at `opIndex` to the worklist of its enclosing loop, and the
+  // loop to its own worklist, or to the main worklist if it isn't in a loop.
+  //
+  // A loop whose body is being drained is still marked as in the worklist, so
+  // the ops in its body don't push it again.
+  void push(int64_t opIndex) {
+    if (inWorklist.test(opIndex)) {
+      return;
+    }
+    inWorklist.set(opIndex);
+    if (int64_t loop = enclosingLoop[opIndex]; loop != -1) {
+      loopWorklists[loopWorklistIndex[loop]].push_back(opIndex);
+      push(loop);
+      return;
+    }
+    worklist.push_back(opIndex);
+  }
+
+  // Visits the op at `opIndex`, which was just popped from a worklist, after
+  // draining the worklist of its body if it's a loop.
+  //
+  // Returns true if the sharding of any op was updated.
+  bool visit(int64_t opIndex, llvm::SetVector<Operation*>* frontier) {
+    bool anyUpdated = false;
+    if (int64_t loopIndex = loopWorklistIndex[opIndex]; loopIndex != -1) {
+      while (!loopWorklists[loopIndex].empty()) {
+        anyUpdated |= visit(loopWorklists[loopIndex].pop_back_val(), frontier);
+      }
+    }
+    inWorklist.reset(opIndex);
+    if (frontier) {
+      frontier->insert(index->ops[opIndex]);
+    }
+    if (deferred.test(opIndex)) {
+      syncOps.insert(index->ops[opIndex]);
+      return anyUpdated;
+    }
+    return succeeded(propagate(opIndex)) || anyUpdated;
+  }
+
+  // Dispatches to the pattern matching the kind of the op at `opIndex`, falling
+  // back to `PropagateRegisteredOp` if it fails, like the greedy driver does.
+  LogicalResult propagate(int64_t opIndex) {
+    Operation* op = index->ops[opIndex];
+    switch (index->kinds[opIndex]) {
+      case PropagationKind::kDataFlowEdge:
+        if (succeeded(dataFlowEdgePattern.matchAndRewrite(
+                cast<DataFlowEdgeOp>(op), rewriter))) {
+          return success();
+        }
+        break;
+      case PropagationKind::kFuncDataFlowEdge:
+        if (succeeded(funcDataFlowEdgePattern.matchAndRewrite(
+                cast<FuncDataFlowEdgeOp>(op), rewriter))) {
+          return success();
+        }
+        break;
+      case PropagationKind::kPropagationBarrier:
+        if (succeeded(propagationBarrierPattern.matchAndRewrite(
+                cast<PropagationBarrierOp>(op), rewriter))) {
+          return success();
+        }
+        break;
+      case PropagationKind::kRegisteredOp:
+        break;
+    }
+    return registeredOpPattern.matchAndRewrite(op, rewriter);
+  }
+
+  PatternRewriter rewriter;
+  // Ops are revisited whenever the sharding of one of their operands or results
+  // changes, so we cache their projections to only rebuild the factor
+  // shardings of tensors that changed.
+  ShardingProjectionCache projectionCache;
+  PropagateRegisteredOp registeredOpPattern;
+  PropagateDataFlowEdgeOp dataFlowEdgePattern;
+  PropagateFuncDataFlowEdgeOp funcDataFlowEdgePattern;
+  PropagatePropagationBarrier propagationBarrierPattern;
+  // The index built by this driver, unless it was created with a shared one.
+  ShardingOpIndex ownedIndex;
+  const ShardingOpIndex* index = &ownedIndex;
+  BitVector deferred;
+  // The index of the nearest enclosing loop of each op, or -1 if it isn't in a
+  // loop or loop-aware propagation isn't enabled.
+  SmallVector<int64_t> enclosingLoop;
+  // The index in `loopWorklists` of each loop, or -1 if the op isn't a loop or
+  // loop-aware propagation isn't enabled.
+  SmallVector<int64_t> loopWorklistIndex;
+  SmallVector<SmallVector<int64_t>> loopWorklists;
+  BitVector inWorklist;
+  SmallVector<int64_t> worklist;
+  llvm::SetVector<Operation*> syncOps;
+  SmallVector<Operation*> externalOps;
+};
+
+// Propagates the functions in `moduleOp` in parallel, each on its own
+// `ShardingWorklistDriver`.
+//
+// Functions are assigned a level in the call graph, such that every function
+// has a higher level than all of its callers, hence functions of the same level
+// are independent. Functions are propagated level by level, and all functions
+// of the same level are propagated in parallel. Since `sdy.func_data_flow_edge`
+// ops update shardings across function boundaries, they are deferred and
+// propagated sequentially after each level, which is the only synchronization
+// point between functions. This is repeated until no function has any pending
+// work.
+//
+// Returns true if the sharding of any op was updated.
+bool propagateFuncsInParallel(ModuleOp moduleOp, const SymbolTable& symbolTable,
+                              const SymbolUserMap& userMap,
+                              GetDirectionToPropagateFn getDirectionToPropagate,
+                              const FactorPropagation& factorPropagation,
+                              bool conservativePropagation,
+                              const ShardingGroupMap& shardingGroupMap,
+                              PropagationProfiler* profiler) {
+  // Callers come before their callees in pre-order, so all callers of a func
+  // have their final level by the time we reach it.
+  SmallVector<FuncOp> funcsInPreOrder;
+  iterateFuncs(
+      moduleOp, [&](FuncOp funcOp) { funcsInPreOrder.push_back(funcOp); },
+      /*preOrder=*/true);
+  llvm::DenseMap<Operation*, int64_t> funcToLevel;
+  int64_t maxLevel = 0;
+  for (FuncOp funcOp : funcsInPreOrder) {
+    int64_t level = funcToLevel.lookup(funcOp);
+    maxLevel = std::max(maxLevel, level);
+    funcOp.walk([&](CallOp callOp) {
+      int64_t& calleeLevel =
+          funcToLevel[getFuncOpOrDie(callOp.getCallee(), symbolTable)];
+      calleeLevel = std::max(calleeLevel, level + 1);
+    });
+  }
+
+  std::vector<std::unique_ptr<ShardingWorklistDriver>> drivers;
+  SmallVector<SmallVector<ShardingWorklistDriver*>> driversPerLevel(maxLevel +
+                                                                    1);
+  llvm::DenseMap<Operation*, ShardingWorklistDriver*> funcToDriver;
+  for (FuncOp funcOp : funcsInPreOrder) {
+    if (funcOp.isExternal()) {
+      continue;
+    }
+    auto& driver = drivers.emplace_back(
+        std::make_unique<ShardingWorklistDriver>(
+            funcOp, symbolTable, userMap, getDirectionToPropagate,
+            factorPropagation, conservativePropagation, shardingGroupMap,
+            profiler, /*deferFuncDataFlowEdges=*/true));
+    driver->pushAll();
+    driversPerLevel[funcToLevel.lookup(funcOp)].push_back(driver.get());
+    funcToDriver[funcOp] = driver.get();
+  }
+
+  // Propagates the deferred sync ops of all drivers sequentially, and then
+  // routes modified ops to the driver of the function they are in.
+  auto synchronize = [&]() {
+    bool anyUpdated = false;
+    for (auto& driver : drivers) {
+      anyUpdated |= driver->propagateSyncOps();
+    }
+    for (auto& driver : drivers) {
+      for (Operation* op : driver->takeExternalOps()) {
+        auto funcOp = dyn_cast<FuncOp>(op);
+        if (!funcOp) {
+          funcOp = op->getParentOfType<FuncOp>();
+        }
+        if (ShardingWorklistDriver* owner = funcToDriver.lookup(funcOp)) {
+          owner->notifyOperationModified(op);
+        }
+      }
+    }
+    return anyUpdated;
+  };
+
+  MLIRContext* context = moduleOp.getContext();
+  bool anyUpdated = false;
+  while (llvm::any_of(drivers, [](const auto& driver) {
+    return driver->hasPendingWork();
+  })) {
+    for (ArrayRef<ShardingWorklistDriver*> levelDrivers : driversPerLevel) {
+      SmallVector<char> updated(levelDrivers.size(), false);
+      parallelFor(context, 0, levelDrivers.size(), [&](size_t index) {
+        updated[index] = levelDrivers[index]->drain();
+      });
+      anyUpdated |= llvm::is_contained(updated, true);
+      anyUpdated |= synchronize();
+    }
+  }
+  if (profiler) {
+    for (auto& driver : drivers) {
+      profiler->recordProjectionBuilds(driver->getProjectionCacheStats());
+    }
+  }
+  return anyUpdated;
+}
+
+// Returns true if `op`, a top-level op in the body of a function, splits the
+// op DAG of the function into separate clusters (see `getFuncClusters`).
+//
+// These are ops whose sharding is fixed (closed sharding constraints and
+// manual computations), propagation barriers, `sdy.func_data_flow_edge` ops
+// (which update shardings across function boundaries), and the terminator.
+bool isClusterBoundary(Operation* op) {
+  if (auto shardingConstraintOp = dyn_cast<ShardingConstraintOp>(op)) {
+    return shardingConstraintOp.getSharding().isFullyClosed();
+  }
+  return isa<ManualComputationOp, PropagationBarrierOp, FuncDataFlowEdgeOp>(
+             op) ||
+         op->hasTrait<OpTrait::IsTerminator>();
+}
+
+// Returns the values whose sharding might be updated when propagating `op`.
+SmallVector<Value> getValuesUpdatedBy(Operation* op) {
+  SmallVector<Value> values(op->getOperands());
+  llvm::append_range(values, op->getResults());
+  if (auto dataFlowEdgeOp = dyn_cast<DataFlowEdgeOp>(op)) {
+    llvm::append_range(values, dataFlowEdgeOp.getSources());
+  }
+  return values;
+}
+
+// Returns true if propagating `op` might update any sharding, i.e., if the
+// sharding of any tensor it might update is missing or has an open dimension,
+// since axes are never added to closed dimensions.
+//
+// `sdy.func_data_flow_edge` ops update shardings in other functions, so they
+// are always assumed to update a sharding.
+bool mightUpdateSharding(Operation* op) {
+  if (isa<FuncDataFlowEdgeOp>(op)) {
+    return true;
+  }
+  return llvm::any_of(getValuesUpdatedBy(op), [](Value value) {
+    if (!isa<ShapedType>(value.getType())) {
+      return false;
+    }
+    TensorShardingAttr sharding = getSharding(value);
+    return !sharding || !sharding.isFullyClosed();
+  });
+}
+
+// Returns the ops in `moduleOp`, in pre-order, that might update a sharding
+// when propagated (see `mightUpdateSharding`). All other ops can be excluded
+// from the initial worklist, as their shardings are already final.
+llvm::SetVector<Operation*> getOpsThatMightUpdateSharding(ModuleOp moduleOp) {
+  llvm::SetVector<Operation*> ops;
+  moduleOp.walk<WalkOrder::PreOrder>([&](Operation* op) {
+    if (op != moduleOp && mightUpdateSharding(op)) {
+      ops.insert(op);
+    }
+  });
+  return ops;
+}
+
+// The ops of a function partitioned into clusters that can be propagated
+// concurrently.
+struct FuncClusters {
+  // The ops of each cluster, in pre-order.
+  SmallVector<SmallVector<Operation*>> clusters;
+  // The ops that might update the sharding of a value that is shared with
+  // another cluster, and therefore must be propagated sequentially.
+  llvm::DenseSet<Operation*> deferredOps;
 };
 
+// Partitions the ops in the body of `funcOp` into weakly connected clusters.
+//
+// Each top-level op in the body, together with all of its nested ops, is
+// assigned to a single cluster, and two top-level ops are in the same cluster
+// if a value defined in one is used in the other, unless either is a cluster
+// boundary (see `isClusterBoundary`). All boundaries are assigned to their own
+// cluster, and all of their ops are deferred, as are all ops that might update
+// the sharding of a function argument or of a value defined by a boundary, as
+// the sharding of such a value is stored on an op that is shared with other
+// clusters. Hence the only shardings that are shared between clusters are
+// updated by deferred ops.
+FuncClusters getFuncClusters(FuncOp funcOp) {
+  Block& body = funcOp.getBody().front();
+  SmallVector<Operation*> topLevelOps =
+      llvm::map_to_vector(body, [](Operation& op) { return &op; });
+  llvm::DenseMap<Operation*, int64_t> topLevelOpToIndex;
+  SmallVector<int64_t> parents;
+  BitVector isBoundary;
+  for (auto [index, op] : llvm::enumerate(topLevelOps)) {
+    topLevelOpToIndex[op] = index;
+    parents.push_back(index);
+    isBoundary.push_back(isClusterBoundary(op));
+  }
+
+  // A union-find over the top-level ops, where the root of each set is its
+  // first op, so the clusters are deterministic.
+  auto findRoot = [&](int64_t index) {
+    while (parents[index] != index) {
+      index = parents[index] = parents[parents[index]];
+    }
+    return index;
+  };
+  auto unite = [&](int64_t lhs, int64_t rhs) {
+    lhs = findRoot(lhs);
+    rhs = findRoot(rhs);
+    parents[std::max(lhs, rhs)] = std::min(lhs, rhs);
+  };
+  // Returns the index of the top-level op that `value` is defined in, or -1
+  // if it's a function argument.
+  auto getTopLevelIndex = [&](Value value) -> int64_t {
+    Operation* owner = value.getDefiningOp();
+    if (!owner) {
+      Block* block = cast<BlockArgument>(value).getOwner();
+      if (block == &body) {
+        return -1;
+      }
+      owner = block->getParentOp();
+    }
+    return topLevelOpToIndex.at(body.findAncestorOpInBlock(*owner));
+  };
+
+  FuncClusters funcClusters;
+  for (int64_t index = 0; index < static_cast<int64_t>(topLevelOps.size());
+       ++index) {
+    topLevelOps[index]->walk([&](Operation* op) {
+      if (isBoundary.test(index)) {
+        funcClusters.deferredOps.insert(op);
+        return;
+      }
+      for (Value value : getValuesUpdatedBy(op)) {
+        int64_t valueIndex = getTopLevelIndex(value);
+        if (valueIndex == -1 ||
+            (valueIndex != index && isBoundary.test(valueIndex))) {
+          funcClusters.deferredOps.insert(op);
+        } else {
+          unite(index, valueIndex);
+        }
+      }
+    });
+  }
+
+  // All boundaries are in the same cluster, since they are deferred anyway.
+  int64_t boundaryCluster = -1;
+  llvm::DenseMap<int64_t, int64_t> rootToCluster;
+  for (int64_t index = 0; index < static_cast<int64_t>(topLevelOps.size());
+       ++index) {
+    int64_t& cluster =
+        isBoundary.test(index)
+            ? boundaryCluster
+            : rootToCluster.try_emplace(findRoot(index), -1).first->second;
+    if (cluster == -1) {
+      cluster = funcClusters.clusters.size();
+      funcClusters.clusters.emplace_back();
+    }
+    SmallVector<Operation*>& clusterOps = funcClusters.clusters[cluster];
+    topLevelOps[index]->walk<WalkOrder::PreOrder>(
+        [&](Operation* op) { clusterOps.push_back(op); });
+  }
+  return funcClusters;
+}
+
+// Propagates the clusters of `funcOp` (see `getFuncClusters`) in parallel,
+// each on its own `ShardingWorklistDriver`.
+//
+// Like `propagateFuncsInParallel`, all clusters are propagated in parallel
+// until none of them has any work left other than deferred ops, which are then
+// propagated sequentially, in the order of the clusters, and modified ops are
+// routed to the driver of the cluster they are in. This is repeated until no
+// cluster has any pending work. Since the clusters and the order in which
+// deferred ops are propagated are fixed, the result is deterministic.
+//
+// Modified ops outside `funcOp` are added to `externalOps`, to be propagated
+// by the caller.
+//
+// Returns true if the sharding of any op was updated.
+bool propagateFuncClustersInParallel(
+    FuncOp funcOp, const SymbolTable& symbolTable,
+    const SymbolUserMap& userMap,
+    GetDirectionToPropagateFn getDirectionToPropagate,
+    const FactorPropagation& factorPropagation, bool conservativePropagation,
+    const ShardingGroupMap& shardingGroupMap, PropagationProfiler* profiler,
+    llvm::SetVector<Operation*>& externalOps) {
+  MLIRContext* context = funcOp.getContext();
+  FuncClusters funcClusters = getFuncClusters(funcOp);
+  std::vector<std::unique_ptr<ShardingWorklistDriver>> drivers;
+  llvm::DenseMap<Operation*, ShardingWorklistDriver*> opToDriver;
+  for (ArrayRef<Operation*> clusterOps : funcClusters.clusters) {
+    auto& driver =
+        drivers.emplace_back(std::make_unique<ShardingWorklistDriver>(
+            context, clusterOps, funcClusters.deferredOps, symbolTable,
+            userMap, getDirectionToPropagate, factorPropagation,
+            conservativePropagation, shardingGroupMap, profiler));
+    driver->pushAll();
+    for (Operation* op : clusterOps) {
+      opToDriver[op] = driver.get();
+    }
+  }
+
+  auto synchronize = [&]() {
+    bool anyUpdated = false;
+    for (auto& driver : drivers) {
+      anyUpdated |= driver->propagateSyncOps();
+    }
+    for (auto& driver : drivers) {
+      for (Operation* op : driver->takeExternalOps()) {
+        if (ShardingWorklistDriver* owner = opToDriver.lookup(op)) {
+          owner->notifyOperationModified(op);
+        } else {
+          externalOps.insert(op);
+        }
+      }
+    }
+    return anyUpdated;
+  };
+
+  bool anyUpdated = false;
+  while (llvm::any_of(drivers, [](const auto& driver) {
+    return driver->hasPendingWork();
+  })) {
+    SmallVector<char> updated(drivers.size(), false);
+    parallelFor(context, 0, drivers.size(), [&](size_t index) {
+      updated[index] = drivers[index]->drain();
+    });
+    anyUpdated |= llvm::is_contained(updated, true);
+    anyUpdated |= synchronize();
+  }
+  if (profiler) {
+    for (auto& driver : drivers) {
+      profiler->recordProjectionBuilds(driver->getProjectionCacheStats());
+    }
+  }
+  return anyUpdated;
+}
+
+// Returns failure and emits an error on the first op whose attributes differ
+// between `moduleOp` and `expectedModuleOp`, which is a clone of the former
+// that was propagated separately.
+LogicalResult verifyMatchesSerialPropagation(ModuleOp moduleOp,
+                                             ModuleOp expectedModuleOp) {
+  SmallVector<Operation*> ops;
+  SmallVector<Operation*> expectedOps;
+  moduleOp.walk([&](Operation* op) { ops.push_back(op); });
+  expectedModuleOp.walk([&](Operation* op) { expectedOps.push_back(op); });
+  for (auto [op, expectedOp] : llvm::zip_equal(ops, expectedOps)) {
+    if (op->getAttrDictionary() != expectedOp->getAttrDictionary()) {
+      return op->emitError(
+                 "parallel cluster propagation diverged from serial "
+                 "propagation, expected attributes: ")
+             << expectedOp->getAttrDictionary();
+    }
+  }
+  return success();
+}
+
 // The basic propagation pass that uses the default implementation of
 // `BasicPropagationPassImpl`.
 struct BasicPropagationPass
@@ -781,6 +1699,21 @@ bool allValidShapes(ModuleOp moduleOp) {
 
 }  // namespace
 
+// The symbol users and the ops of the module being propagated, in pre-order.
+struct BasicPropagationPassImpl::ModuleIndex {
+  explicit ModuleIndex(ModuleOp moduleOp)
+      : userMap(symbolTableCollection, moduleOp) {
+    moduleOp.getBodyRegion().walk<WalkOrder::PreOrder>(
+        [&](Operation* op) { opIndex.addOp(op); });
+  }
+
+  SymbolTableCollection symbolTableCollection;
+  SymbolUserMap userMap;
+  ShardingOpIndex opIndex;
+};
+
+BasicPropagationPassImpl::~BasicPropagationPassImpl() = default;
+
 PropagationDirection propagateAny(Operation*, int64_t) {
   return PropagationDirection::BOTH;
 }
@@ -791,28 +1724,154 @@ LogicalResult BasicPropagationPassImpl::propagate(
     const FactorPropagation& factorPropagation,
     GetDirectionToPropagateFn getDirectionToPropagate) {
   IRRewriter rewriter(moduleOp);
-  SymbolTableCollection symbolTableCollection;
-  SymbolUserMap userMap(symbolTableCollection, moduleOp);
+  ModuleIndex& moduleIndex = getOrBuildModuleIndex(moduleOp);
+  const SymbolUserMap& userMap = moduleIndex.userMap;
 
   // Pushes any shardings that exist on the `funcOp` result type attrs to the
   // corresponding values returned in the terminator of the body of `funcOp`,
   // for the main function.
   propagateFuncResults(moduleOp, userMap, symbolTable, factorPropagation,
-                       shardingGroupMap);
+                       shardingGroupMap, profiler.get());
+
   MLIRContext* context = moduleOp.getContext();
+  // Unless propagation is already incremental, ops whose shardings are already
+  // final are excluded from the initial worklist, and if there are none left,
+  // propagation is skipped entirely. This isn't done if sharding rules are
+  // kept, since the rules of all ops are expected to be created.
+  std::optional<llvm::SetVector<Operation*>> initialFrontier;
+  if (!incrementalFrontier && !keepShardingRules) {
+    initialFrontier = getOpsThatMightUpdateSharding(moduleOp);
+    if (initialFrontier->empty()) {
+      propagateFuncResults(moduleOp, userMap, symbolTable, factorPropagation,
+                           shardingGroupMap, profiler.get());
+      return success();
+    }
+  }
+
+  // Functions can only be propagated in parallel if no sharding group spans
+  // across them, and the debugging action handler (which isn't thread-safe)
+  // isn't registered.
+  if (enableParallelFuncPropagation && !incrementalFrontier &&
+      shardingGroupMap.empty() && !context->hasActionHandler()) {
+    auto propagateFuncs = [&]() {
+      return propagateFuncsInParallel(
+          moduleOp, symbolTable, userMap, getDirectionToPropagate,
+          factorPropagation, conservativePropagation, shardingGroupMap,
+          profiler.get());
+    };
+    propagateFuncs();
+#ifndef NDEBUG
+    // A second run shouldn't update anything, otherwise something is wrong.
+    if (propagateFuncs()) {
+      emitWarning(moduleOp->getLoc(), "Failed to converge after 2 iterations, ")
+          << "this shouldn't happen. please contact the Shardy team.";
+    }
+#endif
+    propagateFuncResults(moduleOp, userMap, symbolTable, factorPropagation,
+                         shardingGroupMap, profiler.get());
+    return success();
+  }
+
+  // Clusters can only be propagated in parallel under the same conditions as
+  // functions (see above).
+  if (enableParallelClusterPropagation && !incrementalFrontier &&
+      shardingGroupMap.empty() && !context->hasActionHandler()) {
+    OwningOpRef<ModuleOp> serialModuleOp;
+    if (checkParallelClusterPropagation) {
+      serialModuleOp = moduleOp.clone();
+    }
+    llvm::SetVector<Operation*> frontier;
+    iterateFuncs(moduleOp, [&](FuncOp funcOp) {
+      if (!funcOp.isExternal()) {
+        propagateFuncClustersInParallel(
+            funcOp, symbolTable, userMap, getDirectionToPropagate,
+            factorPropagation, conservativePropagation, shardingGroupMap,
+            profiler.get(), frontier);
+      }
+    });
+    // Serially reconciles the ops outside the func whose clusters modified
+    // them, e.g., the callee of a `sdy.func_data_flow_edge`.
+    ShardingWorklistDriver driver(context, moduleIndex.opIndex, symbolTable,
+                                  userMap, getDirectionToPropagate,
+                                  factorPropagation, conservativePropagation,
+                                  shardingGroupMap, profiler.get());
+    driver.run(&frontier);
+#ifndef NDEBUG
+    // A full run shouldn't update anything, otherwise something is wrong.
+    if (driver.run()) {
+      emitWarning(moduleOp->getLoc(), "Failed to converge after 2 iterations, ")
+          << "this shouldn't happen. please contact the Shardy team.";
+    }
+#endif
+    if (profiler) {
+      profiler->recordProjectionBuilds(driver.getProjectionCacheStats());
+    }
+    propagateFuncResults(moduleOp, userMap, symbolTable, factorPropagation,
+                         shardingGroupMap, profiler.get());
+    if (!serialModuleOp) {
+      return success();
+    }
+
+    SymbolTable serialSymbolTable(*serialModuleOp);
+    SymbolTableCollection serialSymbolTableCollection;
+    SymbolUserMap serialUserMap(serialSymbolTableCollection, *serialModuleOp);
+    ShardingWorklistDriver serialDriver(
+        *serialModuleOp, serialSymbolTable, serialUserMap,
+        getDirectionToPropagate, factorPropagation, conservativePropagation,
+        shardingGroupMap);
+    serialDriver.run();
+    propagateFuncResults(*serialModuleOp, serialUserMap, serialSymbolTable,
+                         factorPropagation, shardingGroupMap,
+                         /*profiler=*/nullptr);
+    return verifyMatchesSerialPropagation(moduleOp, *serialModuleOp);
+  }
+
+  if (enableWorklistPropagation || enableLoopAwarePropagation ||
+      incrementalFrontier) {
+    llvm::SetVector<Operation*>* frontier =
+        incrementalFrontier ? &*incrementalFrontier
+                            : (initialFrontier ? &*initialFrontier : nullptr);
+    ShardingWorklistDriver driver(context, moduleIndex.opIndex, symbolTable,
+                                  userMap, getDirectionToPropagate,
+                                  factorPropagation, conservativePropagation,
+                                  shardingGroupMap, profiler.get());
+    if (enableLoopAwarePropagation) {
+      driver.enableLoopAwarePropagation();
+    }
+    driver.run(frontier);
+#ifndef NDEBUG
+    // A second run shouldn't update anything, otherwise something is wrong.
+    if (driver.run(frontier)) {
+      emitWarning(moduleOp->getLoc(), "Failed to converge after 2 iterations, ")
+          << "this shouldn't happen. please contact the Shardy team.";
+    }
+#endif
+    if (profiler) {
+      profiler->recordProjectionBuilds(driver.getProjectionCacheStats());
+    }
+    propagateFuncResults(moduleOp, userMap, symbolTable, factorPropagation,
+                         shardingGroupMap, profiler.get());
+    return success();
+  }
 
+  // Ops are revisited whenever the sharding of one of their operands or results
+  // changes, so we cache their projections to only rebuild the factor
+  // shardings of tensors that changed.
+  ShardingProjectionCache projectionCache;
   RewritePatternSet patterns(context);
   patterns.add<PropagatePropagationBarrier>(
-      context, symbolTable, userMap, factorPropagation, shardingGroupMap);
-  patterns.add<PropagateDataFlowEdgeOp>(context, symbolTable, userMap,
-                                        getDirectionToPropagate,
-                                        factorPropagation, shardingGroupMap);
+      context, symbolTable, userMap, factorPropagation, shardingGroupMap,
+      &projectionCache, profiler.get());
+  patterns.add<PropagateDataFlowEdgeOp>(
+      context, symbolTable, userMap, getDirectionToPropagate, factorPropagation,
+      shardingGroupMap, &projectionCache, profiler.get());
   patterns.add<PropagateFuncDataFlowEdgeOp>(
       context, symbolTable, userMap, getDirectionToPropagate, factorPropagation,
-      shardingGroupMap);
+      shardingGroupMap, &projectionCache, profiler.get());
   patterns.add<PropagateRegisteredOp>(
       context, symbolTable, userMap, getDirectionToPropagate, factorPropagation,
-      conservativePropagation, shardingGroupMap);
+      conservativePropagation, shardingGroupMap, &projectionCache,
+      profiler.get());
   // We only need a single iteration (and another to confirm convergence), since
   // we make sure ops whose sharding changes are added back to the worklist.
   // Only issue a warning if failed to converge in debug builds, otherwise we
@@ -834,12 +1893,15 @@ LogicalResult BasicPropagationPassImpl::propagate(
         << config.getMaxIterations() << " iterations, this shouldn't happen. "
         << "please contact the Shardy team.";
   }
+  if (profiler) {
+    profiler->recordProjectionBuilds(projectionCache.getStats());
+  }
 
   // Pushes any shardings from the values returned in the terminator of the body
   // of `funcOp` to the corresponding `funcOp` result type attrs, for the main
   // function.
   propagateFuncResults(moduleOp, userMap, symbolTable, factorPropagation,
-                       shardingGroupMap);
+                       shardingGroupMap, profiler.get());
   return success();
 }
 
@@ -860,6 +1922,14 @@ void BasicPropagationPassImpl::runOnOperation() {
                                  debugPropagationEdgeSharding);
   SourceShardingHandler handler(&mappings);
   handler.prepareHandler(moduleOp);
+  // The event log uses the same action, so it can't be registered with the
+  // handler above.
+  std::optional<PropagationEventLog> eventLog;
+  if (propagationEventLogSize > 0 && !debugShardingOrigins &&
+      !debugPropagationEdgeSharding) {
+    eventLog.emplace(propagationEventLogSize);
+    eventLog->prepareHandler(moduleOp);
+  }
 
   SymbolTable symbolTable(moduleOp);
 
@@ -870,18 +1940,117 @@ void BasicPropagationPassImpl::runOnOperation() {
   // Build sharding group mappings to link values to other members within their
   // group. These maps are passed through the propagation methods so that
   // `updateTensorShardings` can enforce the sharding group constraints.
-  ShardingGroupMap shardingGroupMap(moduleOp);
-  shardingGroupMap.syncGroupMemberShardings(moduleOp);
-  if (failed(propagate(moduleOp, symbolTable, shardingGroupMap))) {
+  ShardingGroupMap shardingGroupMap = [&] {
+    TimingReportScope timingScope("build_sharding_groups");
+    ShardingGroupMap groupMap(moduleOp);
+    groupMap.syncGroupMemberShardings(moduleOp);
+    return groupMap;
+  }();
+  ShardingRuleMemoStats ruleStatsBefore;
+  if (profilePropagation) {
+    profiler = std::make_unique<PropagationProfiler>();
+    ruleStatsBefore = getShardingRuleMemoStats(&context);
+  }
+  if (!dirtyFuncs.empty()) {
+    setDirtyFuncsFrontier(moduleOp);
+  }
+  LogicalResult result = failure();
+  {
+    TimingReportScope timingScope("propagate", moduleOp);
+    result = propagate(moduleOp, symbolTable, shardingGroupMap);
+  }
+  clearIncrementalFrontier();
+  moduleIndex.reset();
+  if (failed(result)) {
+    profiler.reset();
+    context.registerActionHandler(nullptr);
     signalPassFailure();
     return;
   }
+  if (profiler) {
+    ShardingRuleMemoStats ruleStatsAfter = getShardingRuleMemoStats(&context);
+    profiler->recordShardingRuleStats(
+        ruleStatsAfter.numHits - ruleStatsBefore.numHits,
+        ruleStatsAfter.numMisses - ruleStatsBefore.numMisses);
+    profiler->save(dumpDirectory, "propagation_profile");
+    profiler.reset();
+  }
   if (!keepShardingRules) {
     removeShardingRules(moduleOp);
   }
 
   context.registerActionHandler(nullptr);
   handler.saveOnModule(moduleOp);
+  if (eventLog) {
+    eventLog->saveOnModule(moduleOp);
+  }
+}
+
+void BasicPropagationPassImpl::setIncrementalFrontier(
+    ModuleOp moduleOp, ArrayRef<ValueOrFuncResult> modifiedShardings,
+    const ShardingGroupMap& shardingGroupMap) {
+  SymbolTable symbolTable(moduleOp);
+  const SymbolUserMap& userMap = getOrBuildModuleIndex(moduleOp).userMap;
+  incrementalFrontier.emplace();
+  auto addToFrontier = [&](Operation* op) { incrementalFrontier->insert(op); };
+  for (const ValueOrFuncResult& valueOrFuncResult : modifiedShardings) {
+    // A func result sharding is pushed to the corresponding return value at
+    // the start of propagation, so the ops affected by the latter are added.
+    Value value =
+        std::holds_alternative<Value>(valueOrFuncResult)
+            ? std::get<Value>(valueOrFuncResult)
+            : getBodyTerminatorOperand(
+                  std::get<FuncResult>(valueOrFuncResult).funcOp,
+                  std::get<FuncResult>(valueOrFuncResult).resNum);
+    if (!value) {
+      continue;
+    }
+    notifyShardingModified(value, symbolTable, userMap, addToFrontier);
+    // Once a sharding is pushed to `value` (e.g., from a func result at the
+    // start of propagation), it's also set on the other members of its sharding
+    // group, without notifying the ops affected by them, so they are added too.
+    for (Value groupMember : shardingGroupMap.getGroupMembers(value)) {
+      if (groupMember != value) {
+        notifyShardingModified(groupMember, symbolTable, userMap,
+                               addToFrontier);
+      }
+    }
+  }
+}
+
+BasicPropagationPassImpl::ModuleIndex&
+BasicPropagationPassImpl::getOrBuildModuleIndex(ModuleOp moduleOp) {
+  if (!moduleIndex) {
+    moduleIndex = std::make_unique<ModuleIndex>(moduleOp);
+  }
+  return *moduleIndex;
+}
+
+void BasicPropagationPassImpl::setDirtyFuncsFrontier(ModuleOp moduleOp) {
+  llvm::SmallDenseSet<StringRef> dirtyFuncNames(dirtyFuncs.begin(),
+                                                dirtyFuncs.end());
+  incrementalFrontier.emplace();
+  auto addNestedOps = [&](Region& region) {
+    region.walk([&](Operation* op) { incrementalFrontier->insert(op); });
+  };
+  for (FuncOp funcOp : moduleOp.getOps<FuncOp>()) {
+    if (dirtyFuncNames.contains(funcOp.getSymName())) {
+      addNestedOps(funcOp.getBody());
+    }
+  }
+  // After import, calls are either kept or inlined into named computations
+  // that have the name of the callee, so both are affected by an edit to it.
+  moduleOp.walk([&](Operation* op) {
+    if (auto namedComputationOp = dyn_cast<NamedComputationOp>(op);
+        namedComputationOp &&
+        dirtyFuncNames.contains(namedComputationOp.getName())) {
+      incrementalFrontier->insert(namedComputationOp);
+      addNestedOps(namedComputationOp.getBody());
+    } else if (auto callOp = dyn_cast<CallOp>(op);
+               callOp && dirtyFuncNames.contains(callOp.getCallee())) {
+      incrementalFrontier->insert(callOp);
+    }
+  });
 }
 
 void BasicPropagationPassImpl::setPropagationOptions(
@@ -891,6 +2060,16 @@ void BasicPropagationPassImpl::setPropagationOptions(
   conservativePropagation = options.conservativePropagation;
   debugShardingOrigins = options.debugShardingOrigins;
   debugPropagationEdgeSharding = options.debugPropagationEdgeSharding;
+  enableWorklistPropagation = options.enableWorklistPropagation;
+  enableLoopAwarePropagation = options.enableLoopAwarePropagation;
+  enableParallelFuncPropagation = options.enableParallelFuncPropagation;
+  enableParallelClusterPropagation = options.enableParallelClusterPropagation;
+  checkParallelClusterPropagation = options.checkParallelClusterPropagation;
+  profilePropagation = options.profilePropagation;
+  propagationEventLogSize = options.propagationEventLogSize;
+  if (!options.dirtyFuncs.empty()) {
+    dirtyFuncs = options.dirtyFuncs;
+  }
 }
 
 std::unique_ptr<Pass> createBasicPropagationPass(
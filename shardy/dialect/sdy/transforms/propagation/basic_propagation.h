@@ -21,8 +21,11 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/CommandLine.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Operation.h"
@@ -32,7 +35,9 @@ limitations under the License.
 #include "mlir/Support/LogicalResult.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/transforms/common/propagation_options.h"
+#include "shardy/dialect/sdy/transforms/common/sharding_walker.h"
 #include "shardy/dialect/sdy/transforms/propagation/basic_factor_propagation.h"
+#include "shardy/dialect/sdy/transforms/propagation/debugging/propagation_profiler.h"
 #include "shardy/dialect/sdy/transforms/propagation/factor_propagation.h"
 #include "shardy/dialect/sdy/transforms/propagation/sharding_group_map.h"
 
@@ -59,6 +64,7 @@ class BasicPropagationPassImpl : public OperationPass<ModuleOp> {
   BasicPropagationPassImpl() = default;
   BasicPropagationPassImpl(const BasicPropagationPassImpl& other)
       : OperationPass<ModuleOp>(other) {}
+  ~BasicPropagationPassImpl() override;
 
  protected:
   // Runs propagation on every function in `moduleOp`.
@@ -96,6 +102,37 @@ class BasicPropagationPassImpl : public OperationPass<ModuleOp> {
 
   void runOnOperation() override;
 
+  // Makes the following propagation runs incremental, starting from all ops
+  // that are affected by a change to the sharding of any value or func result
+  // in `modifiedShardings`, or to the sharding of any other member of its
+  // sharding group in `shardingGroupMap`.
+  //
+  // While incremental, `propagate` seeds the worklist only with the ops in the
+  // frontier rather than all ops in the module, and every op that is visited
+  // is added to the frontier, so that following runs (e.g., with a different
+  // op-priority) revisit it as well.
+  //
+  // NOTE: incremental propagation assumes all other ops are already at a fixed
+  // point, and always uses the worklist driver.
+  void setIncrementalFrontier(ModuleOp moduleOp,
+                              ArrayRef<ValueOrFuncResult> modifiedShardings,
+                              const ShardingGroupMap& shardingGroupMap);
+
+  // Makes the following propagation runs incremental, starting from the ops in
+  // `frontier`.
+  void setIncrementalFrontier(llvm::SetVector<Operation*> frontier) {
+    incrementalFrontier = std::move(frontier);
+  }
+
+  // Returns the current frontier, if propagation is incremental, and makes the
+  // following propagation runs seed the worklist with all ops again.
+  std::optional<llvm::SetVector<Operation*>> takeIncrementalFrontier() {
+    return std::exchange(incrementalFrontier, std::nullopt);
+  }
+
+  // Makes the following propagation runs seed the worklist with all ops again.
+  void clearIncrementalFrontier() { incrementalFrontier.reset(); }
+
   // Sets the propagation options declared below.
   void setPropagationOptions(const PropagationOptions& options);
 
@@ -134,9 +171,91 @@ class BasicPropagationPassImpl : public OperationPass<ModuleOp> {
           "operand/result a sharding was propagated to a given op."),
       llvm::cl::init(false)};
 
+  Option<bool> enableWorklistPropagation{
+      *this, "enable-worklist-propagation",
+      llvm::cl::desc(
+          "whether to propagate with a dedicated sharding worklist driver, "
+          "instead of the greedy pattern rewrite driver"),
+      llvm::cl::init(false)};
+
+  Option<bool> enableLoopAwarePropagation{
+      *this, "enable-loop-aware-propagation",
+      llvm::cl::desc(
+          "whether to propagate the body of each loop (e.g., stablehlo.while) "
+          "to a local fixed point before revisiting the ops outside it, with "
+          "the sharding worklist driver"),
+      llvm::cl::init(false)};
+
+  Option<bool> enableParallelFuncPropagation{
+      *this, "enable-parallel-func-propagation",
+      llvm::cl::desc(
+          "whether to propagate independent functions of a non-flat call "
+          "graph in parallel, synchronizing only at func data flow edges"),
+      llvm::cl::init(false)};
+
+  Option<bool> enableParallelClusterPropagation{
+      *this, "enable-parallel-cluster-propagation",
+      llvm::cl::desc(
+          "whether to partition each function into weakly connected clusters, "
+          "separated by fixed shardings and propagation barriers, and "
+          "propagate them in parallel, synchronizing only at the boundaries"),
+      llvm::cl::init(false)};
+
+  Option<bool> checkParallelClusterPropagation{
+      *this, "check-parallel-cluster-propagation",
+      llvm::cl::desc(
+          "whether to verify that parallel cluster propagation produces the "
+          "same shardings as serial propagation, failing the pass otherwise"),
+      llvm::cl::init(false)};
+
+  Option<bool> profilePropagation{
+      *this, "profile-propagation",
+      llvm::cl::desc(
+          "whether to collect per-op and per-pattern propagation counters, as "
+          "well as uniquing counters per sdy attribute kind, and save them as "
+          "a JSON report in the module dump directory (or print it to stderr "
+          "if there is none)"),
+      llvm::cl::init(false)};
+
+  Option<int64_t> propagationEventLogSize{
+      *this, "propagation-event-log-size",
+      llvm::cl::desc(
+          "the number of most recent propagation events to record in a "
+          "low-overhead ring buffer, and save on the module as propagation "
+          "edges at the end of the pass. Ignored if any of the other debug "
+          "options is set. 0 means disabled"),
+      llvm::cl::init(0)};
+
+  ListOption<std::string> dirtyFuncs{
+      *this, "dirty-funcs",
+      llvm::cl::desc(
+          "the names of the funcs (or named computations) whose shardings "
+          "were edited since the module was last propagated. If specified, "
+          "propagation is seeded only with the ops in them, and all other ops "
+          "are assumed to be at a fixed point")};
+
  private:
+  // The symbol users and the ops of the module, which are indexed when it's
+  // first propagated, and kept across all propagation runs of the pass (e.g.,
+  // one per user or op priority) since propagation doesn't add or erase ops.
+  struct ModuleIndex;
+
+  // Returns the index of `moduleOp`, building it if it wasn't built yet.
+  ModuleIndex& getOrBuildModuleIndex(ModuleOp moduleOp);
+
+  // Makes propagation incremental, starting from all ops in the funcs and
+  // named computations in `dirtyFuncs`, and all calls to these funcs.
+  void setDirtyFuncsFrontier(ModuleOp moduleOp);
+
   // This class owns the basic factor propagation strategy.
   BasicFactorPropagation basicFactorPropagation;
+  // The ops to seed the worklist with, if propagation is incremental.
+  std::optional<llvm::SetVector<Operation*>> incrementalFrontier;
+  // Collects propagation counters while the pass runs, if
+  // `profilePropagation` is true.
+  std::unique_ptr<PropagationProfiler> profiler;
+  // Built on the first propagation run, and reset when the pass finishes.
+  std::unique_ptr<ModuleIndex> moduleIndex;
 };
 
 // Runs the basic sharding propagation algorithm (see
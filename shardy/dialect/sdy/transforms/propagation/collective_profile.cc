@@ -0,0 +1,109 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/transforms/propagation/collective_profile.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/Visitors.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace sdy {
+
+FailureOr<CollectiveProfile> CollectiveProfile::parse(
+    StringRef json, std::string& errorMessage) {
+  llvm::Expected<llvm::json::Value> parsed = llvm::json::parse(json);
+  if (!parsed) {
+    errorMessage = llvm::toString(parsed.takeError());
+    return failure();
+  }
+  const llvm::json::Object* object = parsed->getAsObject();
+  if (!object) {
+    errorMessage = "expected a JSON object";
+    return failure();
+  }
+  CollectiveProfile profile;
+  for (const auto& [key, value] : *object) {
+    std::optional<double> cost = value.getAsNumber();
+    if (!cost || *cost < 0) {
+      errorMessage =
+          llvm::formatv("expected a non-negative number as the cost of '{0}'",
+                        key.str())
+              .str();
+      return failure();
+    }
+    profile.keyToCost[key.str()] = *cost;
+  }
+  return profile;
+}
+
+FailureOr<CollectiveProfile> CollectiveProfile::load(
+    StringRef filePath, std::string& errorMessage) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(filePath);
+  if (!buffer) {
+    errorMessage =
+        llvm::formatv("failed to read collective profile '{0}': {1}", filePath,
+                      buffer.getError().message())
+            .str();
+    return failure();
+  }
+  FailureOr<CollectiveProfile> profile =
+      parse((*buffer)->getBuffer(), errorMessage);
+  if (failed(profile)) {
+    errorMessage =
+        llvm::formatv("failed to parse collective profile '{0}': {1}",
+                      filePath, errorMessage)
+            .str();
+  }
+  return profile;
+}
+
+double CollectiveProfile::getCost(Location loc) const {
+  if (keyToCost.empty()) {
+    return 0;
+  }
+  double cost = 0;
+  auto updateCost = [&](StringRef key) {
+    if (auto it = keyToCost.find(key); it != keyToCost.end()) {
+      cost = std::max(cost, it->second);
+    }
+  };
+  loc->walk([&](Location nestedLoc) {
+    if (auto nameLoc = dyn_cast<NameLoc>(nestedLoc)) {
+      updateCost(nameLoc.getName().getValue());
+    } else if (auto fileLoc = dyn_cast<FileLineColLoc>(nestedLoc)) {
+      updateCost(llvm::formatv("{0}:{1}:{2}", fileLoc.getFilename().getValue(),
+                               fileLoc.getLine(), fileLoc.getColumn())
+                     .str());
+    }
+    return WalkResult::advance();
+  });
+  return cost;
+}
+
+}  // namespace sdy
+}  // namespace mlir
@@ -0,0 +1,73 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_COLLECTIVE_PROFILE_H_
+#define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_COLLECTIVE_PROFILE_H_
+
+#include <string>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace sdy {
+
+// The measured cost of the collectives caused by values of a previous run of
+// the program, used to bias propagation away from shardings that were
+// expensive at runtime.
+//
+// A profile is a JSON object that maps a location key to the cost of the
+// collectives caused by the values at that location, in any unit as long as it
+// is consistent across the profile, e.g.:
+// ```json
+// {"encoder/attention/qkv": 1250.5, "model.py:42:8": 80}
+// ```
+//
+// The key of a `NameLoc` is its name, e.g., the name of a value in the source
+// program, and the key of a `FileLineColLoc` is `<file>:<line>:<column>`.
+// Nested locations, e.g., of a `FusedLoc` or `CallSiteLoc`, are matched as
+// well, and the cost of a location is the maximum cost of all keys it matches.
+class CollectiveProfile {
+ public:
+  // Parses a profile from the JSON string `json`. Returns failure and sets
+  // `errorMessage` if the string isn't a valid profile.
+  static FailureOr<CollectiveProfile> parse(StringRef json,
+                                            std::string& errorMessage);
+
+  // Parses a profile from the JSON file at `filePath`. Returns failure and sets
+  // `errorMessage` if the file can't be read or isn't a valid profile.
+  static FailureOr<CollectiveProfile> load(StringRef filePath,
+                                           std::string& errorMessage);
+
+  // Returns the cost of `loc`, or 0 if none of its keys are in the profile.
+  double getCost(Location loc) const;
+
+  // Returns the cost of the location of `value`, i.e., of its defining op or
+  // of the block argument.
+  double getCost(Value value) const { return getCost(value.getLoc()); }
+
+  bool empty() const { return keyToCost.empty(); }
+
+ private:
+  llvm::StringMap<double> keyToCost;
+};
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_COLLECTIVE_PROFILE_H_
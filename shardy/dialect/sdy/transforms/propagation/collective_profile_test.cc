@@ -0,0 +1,76 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/transforms/propagation/collective_profile.h"
+
+#include <string>
+
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LLVM.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mlir {
+namespace sdy {
+namespace {
+
+using ::testing::HasSubstr;
+
+class CollectiveProfileTest : public ::testing::Test {
+ protected:
+  CollectiveProfile parse(StringRef json) {
+    std::string errorMessage;
+    FailureOr<CollectiveProfile> profile =
+        CollectiveProfile::parse(json, errorMessage);
+    EXPECT_TRUE(succeeded(profile)) << errorMessage;
+    return succeeded(profile) ? *profile : CollectiveProfile();
+  }
+
+  MLIRContext context;
+};
+
+TEST_F(CollectiveProfileTest, NameAndFileLineColLocs) {
+  CollectiveProfile profile = parse(R"({"x": 10, "model.py:4:2": 2.5})");
+  EXPECT_EQ(profile.getCost(NameLoc::get(StringAttr::get(&context, "x"))), 10);
+  EXPECT_EQ(profile.getCost(FileLineColLoc::get(&context, "model.py", 4, 2)),
+            2.5);
+  EXPECT_EQ(profile.getCost(FileLineColLoc::get(&context, "model.py", 4, 3)),
+            0);
+  EXPECT_EQ(profile.getCost(UnknownLoc::get(&context)), 0);
+}
+
+TEST_F(CollectiveProfileTest, NestedLocsTakeMaxCost) {
+  CollectiveProfile profile = parse(R"({"x": 10, "y": 20})");
+  Location x = NameLoc::get(StringAttr::get(&context, "x"));
+  Location y = NameLoc::get(StringAttr::get(&context, "y"));
+  EXPECT_EQ(profile.getCost(FusedLoc::get(&context, {x, y})), 20);
+  EXPECT_EQ(profile.getCost(CallSiteLoc::get(x, UnknownLoc::get(&context))),
+            10);
+}
+
+TEST_F(CollectiveProfileTest, InvalidProfiles) {
+  std::string errorMessage;
+  EXPECT_TRUE(failed(CollectiveProfile::parse("[1, 2]", errorMessage)));
+  EXPECT_THAT(errorMessage, HasSubstr("expected a JSON object"));
+  EXPECT_TRUE(failed(CollectiveProfile::parse(R"({"x": "a"})", errorMessage)));
+  EXPECT_THAT(errorMessage, HasSubstr("'x'"));
+  EXPECT_TRUE(failed(CollectiveProfile::parse(R"({"x": -1})", errorMessage)));
+  EXPECT_TRUE(failed(CollectiveProfile::parse("{", errorMessage)));
+}
+
+}  // namespace
+}  // namespace sdy
+}  // namespace mlir
@@ -0,0 +1,326 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <limits>
+#include <memory>  // IWYU pragma: keep
+#include <utility>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Threading.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/common/propagation_options.h"
+#include "shardy/dialect/sdy/transforms/export/collective_cost_model.h"
+#include "shardy/dialect/sdy/transforms/propagation/auto_partitioner_registry.h"
+#include "shardy/dialect/sdy/transforms/propagation/op_priority_propagation.h"
+#include "shardy/dialect/sdy/transforms/propagation/op_sharding_rule_registry.h"
+#include "shardy/dialect/sdy/transforms/propagation/passes.h"  // IWYU pragma: keep
+
+namespace mlir {
+namespace sdy {
+
+#define GEN_PASS_DEF_COSTBASEDAUTOPARTITIONERPASS
+#include "shardy/dialect/sdy/transforms/propagation/passes.h.inc"
+
+namespace {
+
+using func::FuncOp;
+
+// The maximum number of ops a dimension sharding is traced through when
+// estimating the communication it causes.
+constexpr int64_t kMaxTracedOps = 64;
+
+// Returns the size in bytes of a tensor of `type`, without any sharding.
+int64_t getGlobalBytes(RankedTensorType type) {
+  return type.getNumElements() * getElementTypeBytes(type.getElementType());
+}
+
+// A func argument without a sharding decided by the user or propagation, whose
+// sharding the auto-partitioner chooses.
+struct KeyTensor {
+  BlockArgument arg;
+  RankedTensorType type;
+  // The axes the auto-partitioner sharded each dimension along so far.
+  SmallVector<SmallVector<AxisRefAttr>> axesPerDim;
+  // The product of the sizes of all axes in `axesPerDim`.
+  int64_t numShards = 1;
+
+  int64_t getLocalBytes() const { return getGlobalBytes(type) / numShards; }
+};
+
+// Sharding dimension `dim` of a key tensor along one more `axis`.
+struct Move {
+  int64_t keyTensorIndex;
+  int64_t dim;
+  AxisRefAttr axis;
+  int64_t axisSize;
+  // The estimated communication cost of the move, see `estimateCost`.
+  double cost = 0.0;
+};
+
+// Returns true if `sharding` leaves `value` up to the auto-partitioner, i.e.,
+// it doesn't exist, or is fully replicated and open.
+bool isUndecided(TensorShardingAttr sharding) {
+  return !sharding || (sharding.isFullyReplicatedAndOpen() &&
+                       sharding.getReplicatedAxes().empty() &&
+                       sharding.getUnreducedAxes().empty());
+}
+
+// Estimates the cost of the collectives needed if dimension `dim` of `root`
+// is sharded along `axis`, by following the factor the dimension is mapped to
+// in the sharding rule of each user:
+// - A pass-through factor is propagated to the corresponding result dimensions
+//   for free, and traced further from there.
+// - A reduction factor requires an all-reduce of the result, estimated as a
+//   reduce-scatter followed by an all-gather, each costing as much as an
+//   all-gather of the sharded result.
+// - Any other factor, or a user without a sharding rule, requires an
+//   all-gather of the operand.
+//
+// `numShards` is the number of shards of `root` after the move, so the local
+// size of each traced tensor is approximated as its global size divided by it.
+//
+// This only reads the IR, so it can be called for different moves in
+// parallel.
+double estimateCost(Value root, int64_t dim, AxisRefAttr axis,
+                    int64_t numShards, const CollectiveCostModel& costModel) {
+  double cost = 0.0;
+  llvm::SmallDenseSet<std::pair<Value, int64_t>> visited;
+  SmallVector<std::pair<Value, int64_t>> worklist = {{root, dim}};
+  int64_t numTracedOps = 0;
+  auto getLocalBytes = [&](Value value) {
+    return getGlobalBytes(cast<RankedTensorType>(value.getType())) / numShards;
+  };
+  while (!worklist.empty() && numTracedOps < kMaxTracedOps) {
+    auto [value, valueDim] = worklist.pop_back_val();
+    if (!visited.insert({value, valueDim}).second) {
+      continue;
+    }
+    for (OpOperand& use : value.getUses()) {
+      Operation* user = use.getOwner();
+      if (user->hasTrait<OpTrait::IsTerminator>()) {
+        continue;
+      }
+      ++numTracedOps;
+      OpShardingRuleAttr shardingRule = getOrCreateShardingRule(
+          user, /*conservativePropagation=*/false,
+          /*setShardingRuleOnOp=*/false);
+      ArrayRef<int64_t> factorIndices;
+      if (shardingRule) {
+        factorIndices = shardingRule.getOperandMapping(use.getOperandNumber())
+                            .getDimMappings()[valueDim]
+                            .getFactorIndices();
+      }
+      if (factorIndices.empty()) {
+        cost += costModel.getCost(CollectiveKind::kAllGather,
+                                  getLocalBytes(value), axis);
+        continue;
+      }
+      // The axis shards the major-most factor of the dimension.
+      int64_t factorIndex = factorIndices.front();
+      if (shardingRule.isPassThroughFactor(factorIndex)) {
+        for (auto [resultNum, result] : llvm::enumerate(user->getResults())) {
+          auto resultType = dyn_cast<RankedTensorType>(result.getType());
+          if (!resultType || !resultType.hasStaticShape()) {
+            continue;
+          }
+          for (auto [resultDim, dimMapping] : llvm::enumerate(
+                   shardingRule.getResultMapping(resultNum).getDimMappings())) {
+            if (llvm::is_contained(dimMapping.getFactorIndices(),
+                                   factorIndex)) {
+              worklist.push_back({result, resultDim});
+            }
+          }
+        }
+      } else if (shardingRule.isReductionFactor(factorIndex)) {
+        for (Value result : user->getResults()) {
+          auto resultType = dyn_cast<RankedTensorType>(result.getType());
+          if (!resultType || !resultType.hasStaticShape()) {
+            continue;
+          }
+          cost += 2 * costModel.getCost(CollectiveKind::kAllGather,
+                                        getGlobalBytes(resultType) / numShards,
+                                        axis);
+        }
+      } else {
+        cost += costModel.getCost(CollectiveKind::kAllGather,
+                                  getLocalBytes(value), axis);
+      }
+    }
+  }
+  return cost;
+}
+
+struct CostBasedAutoPartitionerPass
+    : public impl::CostBasedAutoPartitionerPassBase<
+          CostBasedAutoPartitionerPass> {
+  using CostBasedAutoPartitionerPassBase::CostBasedAutoPartitionerPassBase;
+
+  void runOnOperation() final {
+    ModuleOp moduleOp = getOperation();
+    MLIRContext* context = moduleOp.getContext();
+    auto meshOps = llvm::to_vector(moduleOp.getOps<MeshOp>());
+    // Choosing between multiple meshes isn't supported.
+    if (meshOps.size() != 1 || meshOps.front().getMesh().empty()) {
+      return;
+    }
+    MeshOp meshOp = meshOps.front();
+    CollectiveCostModel costModel =
+        CollectiveCostModel::get(meshOp, collectiveLatency);
+
+    SmallVector<KeyTensor> keyTensors;
+    for (FuncOp funcOp : moduleOp.getOps<FuncOp>()) {
+      if (!funcOp.isPublic() || funcOp.isDeclaration()) {
+        continue;
+      }
+      for (BlockArgument arg : funcOp.getArguments()) {
+        auto type = dyn_cast<RankedTensorType>(arg.getType());
+        if (type && type.hasStaticShape() && type.getRank() > 0 &&
+            getGlobalBytes(type) >= minTensorBytes &&
+            isUndecided(getSharding(arg))) {
+          keyTensors.push_back(
+              {arg, type,
+               SmallVector<SmallVector<AxisRefAttr>>(type.getRank())});
+        }
+      }
+    }
+    if (keyTensors.empty()) {
+      return;
+    }
+
+    int64_t totalLocalBytes = 0;
+    for (const KeyTensor& keyTensor : keyTensors) {
+      totalLocalBytes += keyTensor.getLocalBytes();
+    }
+
+    // Greedily applies the move that costs the least communication per byte
+    // it saves, until no move is left or the key tensors fit in the memory
+    // budget, after which only moves without any communication are applied.
+    while (true) {
+      SmallVector<Move> moves = getCandidateMoves(keyTensors, meshOp);
+      parallelFor(context, 0, moves.size(), [&](size_t index) {
+        Move& move = moves[index];
+        const KeyTensor& keyTensor = keyTensors[move.keyTensorIndex];
+        move.cost = estimateCost(keyTensor.arg, move.dim, move.axis,
+                                 keyTensor.numShards * move.axisSize,
+                                 costModel);
+      });
+      bool overBudget =
+          memoryBudgetBytes > 0 && totalLocalBytes > memoryBudgetBytes;
+      const Move* bestMove = nullptr;
+      double bestCostPerByte = std::numeric_limits<double>::max();
+      for (const Move& move : moves) {
+        if (move.cost > 0 && !overBudget) {
+          continue;
+        }
+        const KeyTensor& keyTensor = keyTensors[move.keyTensorIndex];
+        int64_t savedBytes =
+            keyTensor.getLocalBytes() -
+            getGlobalBytes(keyTensor.type) /
+                (keyTensor.numShards * move.axisSize);
+        double costPerByte = move.cost / std::max<int64_t>(savedBytes, 1);
+        if (costPerByte < bestCostPerByte) {
+          bestCostPerByte = costPerByte;
+          bestMove = &move;
+        }
+      }
+      if (!bestMove) {
+        break;
+      }
+      KeyTensor& keyTensor = keyTensors[bestMove->keyTensorIndex];
+      totalLocalBytes -= keyTensor.getLocalBytes();
+      keyTensor.axesPerDim[bestMove->dim].push_back(bestMove->axis);
+      keyTensor.numShards *= bestMove->axisSize;
+      totalLocalBytes += keyTensor.getLocalBytes();
+    }
+
+    for (const KeyTensor& keyTensor : keyTensors) {
+      if (keyTensor.numShards == 1) {
+        continue;
+      }
+      SmallVector<DimensionShardingAttr> dimShardings = llvm::map_to_vector(
+          keyTensor.axesPerDim, [&](ArrayRef<AxisRefAttr> axes) {
+            return DimensionShardingAttr::get(context, axes,
+                                              /*isClosed=*/false);
+          });
+      setSharding(keyTensor.arg,
+                  TensorShardingAttr::get(context, meshOp.getSymName(),
+                                          dimShardings, /*replicatedAxes=*/{},
+                                          /*unreducedAxes=*/{}));
+    }
+  }
+
+ private:
+  // Returns all moves that shard a key tensor dimension along one more mesh
+  // axis that the key tensor isn't sharded along yet, and that keeps the
+  // dimension size divisible by its number of shards.
+  SmallVector<Move> getCandidateMoves(ArrayRef<KeyTensor> keyTensors,
+                                      MeshOp meshOp) {
+    SmallVector<Move> moves;
+    MLIRContext* context = meshOp.getContext();
+    for (auto [keyTensorIndex, keyTensor] : llvm::enumerate(keyTensors)) {
+      llvm::SmallDenseSet<StringRef> usedAxes;
+      for (ArrayRef<AxisRefAttr> axes : keyTensor.axesPerDim) {
+        for (AxisRefAttr axis : axes) {
+          usedAxes.insert(axis.getName());
+        }
+      }
+      for (MeshAxisAttr meshAxis : meshOp.getMesh().getAxes()) {
+        if (usedAxes.contains(meshAxis.getName()) || meshAxis.getSize() == 1) {
+          continue;
+        }
+        for (int64_t dim = 0; dim < keyTensor.type.getRank(); ++dim) {
+          int64_t dimShards = meshAxis.getSize();
+          for (AxisRefAttr axis : keyTensor.axesPerDim[dim]) {
+            dimShards *= axis.getSize(meshOp.getMesh());
+          }
+          if (keyTensor.type.getDimSize(dim) % dimShards == 0) {
+            moves.push_back({static_cast<int64_t>(keyTensorIndex), dim,
+                             AxisRefAttr::get(context, meshAxis.getName()),
+                             meshAxis.getSize()});
+          }
+        }
+      }
+    }
+    return moves;
+  }
+};
+
+}  // namespace
+
+void registerCostBasedAutoPartitioner(
+    const CostBasedAutoPartitionerPassOptions& options) {
+  AutoPartitionerRegistry::setCallback([options](OpPassManager& pm) {
+    pm.addPass(createCostBasedAutoPartitionerPass(options));
+    // Propagate the chosen shardings of the key tensors to the rest of the
+    // module.
+    pm.addPass(createOpPriorityPropagationPass(PropagationOptions{}));
+  });
+}
+
+}  // namespace sdy
+}  // namespace mlir
@@ -0,0 +1,259 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/transforms/propagation/debugging/propagation_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/AttributeSupport.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/save_module_op.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
+
+namespace mlir {
+namespace sdy {
+
+namespace {
+
+int64_t toMicroseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+// Returns a human readable description of `value`, e.g.,
+// `stablehlo.add:0 loc("foo.py":1:2)`.
+std::string describeValue(Value value) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  if (auto result = dyn_cast<OpResult>(value)) {
+    os << result.getOwner()->getName() << ":" << result.getResultNumber();
+  } else {
+    auto blockArg = cast<BlockArgument>(value);
+    os << blockArg.getOwner()->getParentOp()->getName() << ":arg"
+       << blockArg.getArgNumber();
+  }
+  os << " " << value.getLoc();
+  return str;
+}
+
+// Returns an estimate of the bytes the MLIR context allocates for the storage
+// of an attribute with the given parameters: the storage object itself and any
+// array or string parameter copied into the context allocator.
+int64_t getAxisRefStorageBytes(AxisRefAttr axisRef) {
+  return sizeof(AttributeStorage) + sizeof(StringRef) +
+         sizeof(SubAxisInfoAttr) + axisRef.getName().size();
+}
+
+int64_t getDimShardingStorageBytes(DimensionShardingAttr dimSharding) {
+  return sizeof(AttributeStorage) + sizeof(ArrayRef<AxisRefAttr>) +
+         dimSharding.getAxes().size() * sizeof(AxisRefAttr) + sizeof(bool) +
+         sizeof(std::optional<int64_t>);
+}
+
+int64_t getTensorShardingStorageBytes(TensorShardingAttr sharding) {
+  return sizeof(AttributeStorage) + sizeof(Attribute) +
+         3 * sizeof(ArrayRef<Attribute>) +
+         (sharding.getDimShardings().size() +
+          sharding.getReplicatedAxes().size() +
+          sharding.getUnreducedAxes().size()) *
+             sizeof(Attribute) +
+         sizeof(ReductionOp);
+}
+
+}  // namespace
+
+bool PropagationProfiler::recordAttr(Attribute attr, int64_t numStorageBytes,
+                                     AttrStats& stats) {
+  ++stats.numGets;
+  if (!seenAttrs.insert(attr).second) {
+    return false;
+  }
+  ++stats.numNewAllocations;
+  stats.numStorageBytes += numStorageBytes;
+  return true;
+}
+
+void PropagationProfiler::recordAxisRefs(ArrayRef<AxisRefAttr> axisRefs) {
+  for (AxisRefAttr axisRef : axisRefs) {
+    recordAttr(axisRef, getAxisRefStorageBytes(axisRef), axisRefStats);
+  }
+}
+
+void PropagationProfiler::recordPatternApplication(StringRef patternName,
+                                                   bool succeeded) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  PatternStats& stats = patternToStats[patternName];
+  ++stats.numApplications;
+  if (succeeded) {
+    ++stats.numSuccesses;
+  }
+}
+
+void PropagationProfiler::recordPropagationStep(
+    Operation* op, std::chrono::nanoseconds duration, bool anyUpdated,
+    int64_t numFactors) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  OpStats& stats = opNameToStats[op->getName()];
+  ++stats.numVisits;
+  if (anyUpdated) {
+    ++stats.numUpdates;
+  }
+  stats.duration += duration;
+  stats.maxNumFactors = std::max(stats.maxNumFactors, numFactors);
+}
+
+void PropagationProfiler::recordShardingUpdate(Value value) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  ++valueToNumUpdates[value];
+
+  TensorShardingAttr sharding = getSharding(value);
+  if (!sharding || !recordAttr(sharding,
+                               getTensorShardingStorageBytes(sharding),
+                               tensorShardingStats)) {
+    // A sharding that was seen before references the same nested attributes,
+    // which were already recorded, so we only count the get itself.
+    return;
+  }
+  for (DimensionShardingAttr dimSharding : sharding.getDimShardings()) {
+    if (recordAttr(dimSharding, getDimShardingStorageBytes(dimSharding),
+                   dimShardingStats)) {
+      recordAxisRefs(dimSharding.getAxes());
+    }
+  }
+  recordAxisRefs(sharding.getReplicatedAxes());
+  recordAxisRefs(sharding.getUnreducedAxes());
+}
+
+void PropagationProfiler::recordProjectionBuilds(
+    const ShardingProjectionCache::Stats& stats) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  projectionStats.numFullBuilds += stats.numFullBuilds;
+  projectionStats.numTensorRebuilds += stats.numTensorRebuilds;
+  projectionStats.numTensorReuses += stats.numTensorReuses;
+}
+
+void PropagationProfiler::recordShardingRuleStats(int64_t numHits,
+                                                  int64_t numMisses) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+  numRuleMemoHits += numHits;
+  numRuleMemoMisses += numMisses;
+}
+
+void PropagationProfiler::writeJson(raw_ostream& os, int64_t maxNumValues) {
+  llvm::sys::ScopedLock scopedLock(mutex);
+
+  // Ops are sorted by the time spent propagating through them, and values by
+  // the number of times their sharding was updated, as these are the entries
+  // worth looking at first.
+  SmallVector<std::pair<OperationName, OpStats>> sortedOps(
+      opNameToStats.begin(), opNameToStats.end());
+  llvm::stable_sort(sortedOps, [](const auto& lhs, const auto& rhs) {
+    return lhs.second.duration > rhs.second.duration;
+  });
+  SmallVector<std::pair<Value, int64_t>> sortedValues(
+      valueToNumUpdates.begin(), valueToNumUpdates.end());
+  llvm::stable_sort(sortedValues, [](const auto& lhs, const auto& rhs) {
+    return lhs.second > rhs.second;
+  });
+  if (static_cast<int64_t>(sortedValues.size()) > maxNumValues) {
+    sortedValues.resize(maxNumValues);
+  }
+
+  std::chrono::nanoseconds totalDuration{0};
+  for (const auto& [_, stats] : sortedOps) {
+    totalDuration += stats.duration;
+  }
+
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&]() {
+    json.attribute("total_time_us", toMicroseconds(totalDuration));
+    json.attributeArray("ops", [&]() {
+      for (const auto& [opName, stats] : sortedOps) {
+        json.object([&, &stats = stats, &opName = opName]() {
+          json.attribute("name", opName.getStringRef());
+          json.attribute("visits", stats.numVisits);
+          json.attribute("updates", stats.numUpdates);
+          json.attribute("time_us", toMicroseconds(stats.duration));
+          json.attribute("max_factors", stats.maxNumFactors);
+        });
+      }
+    });
+    json.attributeArray("patterns", [&]() {
+      for (const auto& [patternName, stats] : patternToStats) {
+        json.object([&, &stats = stats, &patternName = patternName]() {
+          json.attribute("name", patternName);
+          json.attribute("applications", stats.numApplications);
+          json.attribute("successes", stats.numSuccesses);
+        });
+      }
+    });
+    json.attributeObject("projections", [&]() {
+      json.attribute("full_builds", projectionStats.numFullBuilds);
+      json.attribute("tensor_rebuilds", projectionStats.numTensorRebuilds);
+      json.attribute("tensor_reuses", projectionStats.numTensorReuses);
+    });
+    json.attributeObject("sharding_rules", [&]() {
+      json.attribute("memo_hits", numRuleMemoHits);
+      json.attribute("memo_misses", numRuleMemoMisses);
+    });
+    json.attributeObject("attributes", [&]() {
+      int64_t totalStorageBytes = 0;
+      for (auto [kind, stats] :
+           {std::make_pair("tensor_sharding", &tensorShardingStats),
+            std::make_pair("dim_sharding", &dimShardingStats),
+            std::make_pair("axis_ref", &axisRefStats)}) {
+        json.attributeObject(kind, [&, stats = stats]() {
+          json.attribute("gets", stats->numGets);
+          json.attribute("cache_hits", stats->numCacheHits());
+          json.attribute("new_allocations", stats->numNewAllocations);
+          json.attribute("storage_bytes", stats->numStorageBytes);
+        });
+        totalStorageBytes += stats->numStorageBytes;
+      }
+      json.attribute("total_storage_bytes", totalStorageBytes);
+    });
+    json.attributeArray("most_updated_values", [&]() {
+      for (const auto& [value, numUpdates] : sortedValues) {
+        json.object([&, value = value, numUpdates = numUpdates]() {
+          json.attribute("value", describeValue(value));
+          json.attribute("updates", numUpdates);
+        });
+      }
+    });
+  });
+  os << "\n";
+}
+
+void PropagationProfiler::save(StringRef dumpDirectory, StringRef fileName) {
+  saveJson(dumpDirectory, fileName, [&](raw_ostream& os) { writeJson(os); });
+}
+
+}  // namespace sdy
+}  // namespace mlir
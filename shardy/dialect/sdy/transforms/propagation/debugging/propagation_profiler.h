@@ -0,0 +1,127 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_DEBUGGING_PROPAGATION_PROFILER_H_
+#define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_DEBUGGING_PROPAGATION_PROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/Value.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
+
+namespace mlir {
+namespace sdy {
+
+// Collects counters about where sharding propagation spends its time, for
+// the `profile-propagation` option of the propagation passes.
+//
+// All methods are thread-safe, so that a single profiler can be shared by
+// functions that are propagated in parallel. Durations are summed across
+// threads in that case.
+class PropagationProfiler {
+ public:
+  // Records an application of the pattern with `patternName`, and whether it
+  // succeeded, i.e., updated any sharding.
+  void recordPatternApplication(StringRef patternName, bool succeeded);
+
+  // Records a single propagation step through `op`, i.e., a call to
+  // `propagateTensorShardings`, that took `duration` and projected the op onto
+  // `numFactors` factors.
+  void recordPropagationStep(Operation* op, std::chrono::nanoseconds duration,
+                             bool anyUpdated, int64_t numFactors);
+
+  // Records an update to the sharding of `value`, including the sdy
+  // attributes that make up its new sharding (see `AttrStats`).
+  void recordShardingUpdate(Value value);
+
+  // Records sharding projection builds, either done directly or through a
+  // `ShardingProjectionCache`.
+  void recordProjectionBuilds(const ShardingProjectionCache::Stats& stats);
+
+  // Records the hits and misses of the sharding rule memo table during
+  // propagation, i.e., how many rules were reused or created.
+  void recordShardingRuleStats(int64_t numHits, int64_t numMisses);
+
+  // Writes all counters as a JSON report to `os`, including the
+  // `maxNumValues` values whose sharding was updated the most.
+  void writeJson(raw_ostream& os, int64_t maxNumValues = 20);
+
+  // Saves the JSON report to `<dumpDirectory>/<fileName>.json`, or prints it
+  // to stderr if `dumpDirectory` is empty.
+  void save(StringRef dumpDirectory, StringRef fileName);
+
+ private:
+  struct OpStats {
+    int64_t numVisits = 0;
+    int64_t numUpdates = 0;
+    std::chrono::nanoseconds duration{0};
+    int64_t maxNumFactors = 0;
+  };
+
+  struct PatternStats {
+    int64_t numApplications = 0;
+    int64_t numSuccesses = 0;
+  };
+
+  // Counters for a single sdy attribute kind, over all attributes referenced by
+  // the shardings recorded in `recordShardingUpdate`.
+  //
+  // MLIR's attribute uniquer can't be instrumented directly, so these are
+  // computed from the attributes that reach the IR: `numGets` counts every
+  // referenced attribute, `numNewAllocations` the distinct ones (each of which
+  // required a storage allocation in the context at some point), and
+  // `numCacheHits` the rest. `numStorageBytes` estimates the context memory of
+  // the distinct attributes.
+  struct AttrStats {
+    int64_t numGets = 0;
+    int64_t numNewAllocations = 0;
+    int64_t numStorageBytes = 0;
+
+    int64_t numCacheHits() const { return numGets - numNewAllocations; }
+  };
+
+  // Records a reference to `attr`, whose storage takes `numStorageBytes`, in
+  // `stats`. Returns true if `attr` wasn't referenced before.
+  bool recordAttr(Attribute attr, int64_t numStorageBytes, AttrStats& stats);
+
+  void recordAxisRefs(ArrayRef<AxisRefAttr> axisRefs);
+
+  llvm::sys::Mutex mutex;
+  llvm::MapVector<OperationName, OpStats> opNameToStats;
+  llvm::MapVector<StringRef, PatternStats> patternToStats;
+  llvm::DenseMap<Value, int64_t> valueToNumUpdates;
+  ShardingProjectionCache::Stats projectionStats;
+  int64_t numRuleMemoHits = 0;
+  int64_t numRuleMemoMisses = 0;
+  llvm::DenseSet<Attribute> seenAttrs;
+  AttrStats tensorShardingStats;
+  AttrStats dimShardingStats;
+  AttrStats axisRefStats;
+};
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_DEBUGGING_PROPAGATION_PROFILER_H_
@@ -20,6 +20,7 @@ limitations under the License.
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
@@ -448,8 +449,7 @@ void saveEdgesOnModule(MLIRContext* context,
 // would make sense if the `sdy.edge_sources` were saved as a top level
 // attribute on the func, but since one is saved per result, then an index of 0
 // makes most sense.
-void saveEdgesOnFuncResults(func::FuncOp funcOp,
-                            const FuncResultToEdgesMap& funcResultToEdgesMap) {
+void saveEdgesOnFuncResults(const FuncResultToEdgesMap& funcResultToEdgesMap) {
   for (auto [funcOp, resultToEdgesMap] : funcResultToEdgesMap) {
     for (auto [resultIndex, axisToEdgesMap] :
          llvm::enumerate(resultToEdgesMap)) {
@@ -717,21 +717,24 @@ SourceShardingHandler::SourceShardingHandler(ShardingDebugMappings* mappings)
 
 void SourceShardingHandler::operator()(function_ref<void()> transform,
                                        const tracing::Action& action) {
-  // NOTE: need to call `transform` first so that the `newShardingProjection`
-  // is up to date.
-  transform();
   if (action.getTag() != SourceShardingAction::tag) {
+    transform();
     return;
   }
 
-  auto sourceShardingAction = cast<SourceShardingAction>(action);
+  const auto& sourceShardingAction = cast<SourceShardingAction>(action);
+  // NOTE: need to copy the sharding projection before calling `transform`, so
+  // that it can be compared with the updated one.
+  const ShardingProjection oldShardingProjection =
+      sourceShardingAction.shardingProjection;
+  transform();
   if (!sourceShardingAction.anyUpdated) {
     return;
   }
 
   FactorsToEdgeMap factorsToEdges =
-      createSourceMap(sourceShardingAction.oldShardingProjection,
-                      sourceShardingAction.newShardingProjection,
+      createSourceMap(oldShardingProjection,
+                      sourceShardingAction.shardingProjection,
                       sourceShardingAction.shardingRule,
                       sourceShardingAction.mesh, propagationStep);
   propagationStep++;
@@ -803,10 +806,147 @@ void SourceShardingHandler::saveOnModule(ModuleOp moduleOp) {
   }
   if (mappings->debugPropagationEdgeSharding) {
     saveEdgesOnModule(context, mappings->operationToEdgesMap);
-    for (auto funcOp : moduleOp.getOps<func::FuncOp>()) {
-      saveEdgesOnFuncResults(funcOp, mappings->funcResultToEdgesMap);
+    saveEdgesOnFuncResults(mappings->funcResultToEdgesMap);
+  }
+}
+
+PropagationEventLog::PropagationEventLog(int64_t capacity)
+    : events(capacity) {
+  assert(capacity > 0);
+}
+
+void PropagationEventLog::operator()(function_ref<void()> transform,
+                                     const tracing::Action& action) {
+  if (action.getTag() != SourceShardingAction::tag) {
+    transform();
+    return;
+  }
+
+  const auto& sourceShardingAction = cast<SourceShardingAction>(action);
+  const ShardingProjection& projection =
+      sourceShardingAction.shardingProjection;
+  int64_t numFactors = sourceShardingAction.shardingRule.getNumFactors();
+  int64_t numOperands = projection.getNumOperands();
+  auto getEdgeNode = [&](int64_t tensorNum) {
+    return tensorNum < numOperands
+               ? EdgeNode{EdgeNodeType::OPERAND, tensorNum}
+               : EdgeNode{EdgeNodeType::RESULT, tensorNum - numOperands};
+  };
+
+  // The number of axes and the last axis of each tensor and factor before the
+  // step, and the tensor with the most axes along each factor, which is taken
+  // as the source of any new axes along it.
+  struct FactorSnapshot {
+    int64_t numAxes = 0;
+    AxisRefAttr lastAxis;
+  };
+  struct FactorSource {
+    int64_t tensorNum = -1;
+    int64_t numAxes = 0;
+  };
+  SmallVector<FactorSnapshot> snapshots(projection.getNumTensors() *
+                                        numFactors);
+  SmallVector<FactorSource> sources(numFactors);
+  for (int64_t tensorNum = 0; tensorNum < projection.getNumTensors();
+       ++tensorNum) {
+    for (const auto& [factorIndex, factorSharding] :
+         projection.getTensor(tensorNum).factorIndexToSharding) {
+      int64_t numAxes = factorSharding.axisRefs.size();
+      if (numAxes == 0) {
+        continue;
+      }
+      snapshots[tensorNum * numFactors + factorIndex] = {
+          numAxes, factorSharding.axisRefs.back()};
+      if (numAxes > sources[factorIndex].numAxes) {
+        sources[factorIndex] = {tensorNum, numAxes};
+      }
+    }
+  }
+
+  transform();
+  if (!sourceShardingAction.anyUpdated) {
+    return;
+  }
+
+  int64_t step = propagationStep++;
+  int64_t capacity = events.size();
+  for (int64_t tensorNum = 0; tensorNum < projection.getNumTensors();
+       ++tensorNum) {
+    EdgeNode target = getEdgeNode(tensorNum);
+    Value value = target.type == EdgeNodeType::OPERAND
+                      ? sourceShardingAction.operands[target.index]
+                      : sourceShardingAction.results[target.index];
+    for (const auto& [factorIndex, factorSharding] :
+         projection.getTensor(tensorNum).factorIndexToSharding) {
+      ArrayRef<AxisRefAttr> newAxes = factorSharding.axisRefs;
+      const FactorSnapshot& snapshot =
+          snapshots[tensorNum * numFactors + factorIndex];
+      int64_t firstNewAxis =
+          std::min<int64_t>(snapshot.numAxes, newAxes.size());
+      // The last old axis may have been expanded into a bigger sub-axis.
+      if (firstNewAxis > 0 && newAxes[firstNewAxis - 1] != snapshot.lastAxis) {
+        --firstNewAxis;
+      }
+      const FactorSource& source = sources[factorIndex];
+      if (firstNewAxis == static_cast<int64_t>(newAxes.size()) ||
+          source.tensorNum == tensorNum ||
+          source.numAxes < static_cast<int64_t>(newAxes.size())) {
+        continue;
+      }
+      for (AxisRefAttr axisRef : newAxes.drop_front(firstNewAxis)) {
+        events[numRecordedEvents++ % capacity] = PropagationEvent{
+            sourceShardingAction.op, value, axisRef,
+            PropagationEdge{getEdgeNode(source.tensorNum), target, step}};
+      }
+    }
+  }
+}
+
+void PropagationEventLog::prepareHandler(ModuleOp moduleOp) {
+  propagationStep = maximumPropagationStep(moduleOp) + 1;
+  moduleOp->getContext()->registerActionHandler(
+      [this](function_ref<void()> transform, const tracing::Action& action) {
+        (*this)(transform, action);
+      });
+}
+
+SmallVector<PropagationEvent> PropagationEventLog::getEvents() const {
+  int64_t capacity = events.size();
+  int64_t numEvents = std::min<int64_t>(numRecordedEvents, capacity);
+  int64_t begin = numRecordedEvents - numEvents;
+  SmallVector<PropagationEvent> orderedEvents;
+  orderedEvents.reserve(numEvents);
+  for (int64_t i = begin; i < begin + numEvents; ++i) {
+    orderedEvents.push_back(events[i % capacity]);
+  }
+  return orderedEvents;
+}
+
+int64_t PropagationEventLog::getNumDroppedEvents() const {
+  return std::max<int64_t>(
+      numRecordedEvents - static_cast<int64_t>(events.size()), 0);
+}
+
+void PropagationEventLog::saveOnModule(ModuleOp moduleOp) const {
+  OperationToEdgesMap operationToEdgesMap;
+  FuncResultToEdgesMap funcResultToEdgesMap;
+  for (const PropagationEvent& event : getEvents()) {
+    auto funcOp = dyn_cast<func::FuncOp>(event.op);
+    if (!funcOp) {
+      operationToEdgesMap[event.op][event.axisRef].push_back(event.edge);
+      continue;
+    }
+    if (OpOperand* terminatorOperand =
+            getTerminatorOperand(event.value, funcOp)) {
+      SmallVector<AxisToEdgesMap>& resultToEdges =
+          funcResultToEdgesMap[funcOp];
+      resultToEdges.resize(funcOp.getNumResults());
+      resultToEdges[terminatorOperand->getOperandNumber()][event.axisRef]
+          .push_back(event.edge);
     }
   }
+  saveEdgesOnModule(moduleOp.getContext(), operationToEdgesMap);
+  saveEdgesOnFuncResults(funcResultToEdgesMap);
 }
 
 namespace {
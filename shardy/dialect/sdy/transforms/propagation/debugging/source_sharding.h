@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_DEBUGGING_SOURCE_SHARDING_H_
 #define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_DEBUGGING_SOURCE_SHARDING_H_
 
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
 #include "llvm/ADT/DenseMap.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -121,8 +123,7 @@ class SourceShardingAction : public tracing::ActionImpl<SourceShardingAction> {
         results(results),
         mesh(mesh),
         shardingRule(shardingRule),
-        oldShardingProjection(shardingProjection),
-        newShardingProjection(shardingProjection),
+        shardingProjection(shardingProjection),
         anyUpdated(anyUpdated) {}
 
   static constexpr StringLiteral tag = "SourceShardingAction";
@@ -135,11 +136,10 @@ class SourceShardingAction : public tracing::ActionImpl<SourceShardingAction> {
   ValueRange operands, results;
   MeshAttr mesh;
   OpShardingRuleAttr shardingRule;
-  // NOTE: `oldShardingProjection` is a copy while `newShardingProjection` is a
-  // reference as when the action is executed, we want to see how the old and
-  // new sharding projections differ.
-  const ShardingProjection oldShardingProjection;
-  const ShardingProjection& newShardingProjection;
+  // NOTE: this is a reference to the projection that is updated when the
+  // action is executed, so a handler that wants to see how the old and new
+  // sharding projections differ needs to snapshot it before executing it.
+  const ShardingProjection& shardingProjection;
   // Whether any of the operands/results were updated.
   const bool& anyUpdated;
 };
@@ -168,6 +168,64 @@ struct SourceShardingHandler {
   int64_t propagationStep = 0;
 };
 
+// A fixed-size record of an axis that was introduced to the sharding of an
+// operand or result of `op` during a propagation step.
+struct PropagationEvent {
+  Operation* op;
+  // The operand or result whose sharding was updated. If `op` is a `FuncOp`,
+  // this is the returned value that corresponds to the updated func result.
+  Value value;
+  AxisRefAttr axisRef;
+  PropagationEdge edge;
+};
+
+// A low-overhead alternative to `debugPropagationEdgeSharding`, that records
+// the `SourceShardingAction`s where shardings are updated as
+// `PropagationEvent`s in a ring buffer, keeping only the most recent
+// `capacity` events.
+//
+// Unlike `SourceShardingHandler`, this doesn't copy the sharding projection
+// or update any map during propagation. It only snapshots the number of axes
+// per factor before each step, and takes the operand/result with the most
+// axes along a factor before the step as the source of the new axes along it.
+// The events are only decoded into `PropagationEdgesAttr`s by `saveOnModule`.
+//
+// Events can be recorded from multiple threads, e.g., with parallel func
+// propagation.
+class PropagationEventLog {
+ public:
+  explicit PropagationEventLog(int64_t capacity);
+
+  // We do not allow copying of the log, as the handler registered by
+  // `prepareHandler` refers to this instance.
+  PropagationEventLog(const PropagationEventLog&) = delete;
+  PropagationEventLog& operator=(const PropagationEventLog&) = delete;
+
+  // If `action` is a `SourceShardingAction`, records the axes introduced by
+  // `transform` as events.
+  void operator()(function_ref<void()> transform,
+                  const tracing::Action& action);
+
+  // Prepares the log for the `moduleOp` and registers it as an action handler
+  // on the `MLIRContext` of `moduleOp`.
+  void prepareHandler(ModuleOp moduleOp);
+
+  // Returns the recorded events that weren't overwritten, in recording order.
+  SmallVector<PropagationEvent> getEvents() const;
+
+  // Returns the number of events that were overwritten by more recent ones.
+  int64_t getNumDroppedEvents() const;
+
+  // Decodes the recorded events into `PropagationEdgesAttr`s, and saves them
+  // on the `moduleOp` like `SourceShardingHandler::saveOnModule` does.
+  void saveOnModule(ModuleOp moduleOp) const;
+
+ private:
+  std::vector<PropagationEvent> events;
+  std::atomic<int64_t> numRecordedEvents = 0;
+  std::atomic<int64_t> propagationStep = 0;
+};
+
 // Saves an array of all the origin sharding and propagation edge dictionaries
 // for the given `edgeOwners` on `op`. If non exist, nothing is saved.
 //
@@ -0,0 +1,31 @@
+// RUN: sdy_opt %s -sdy-basic-propagate=propagation-event-log-size=64 2>&1 | FileCheck %s
+// RUN: sdy_opt %s -sdy-basic-propagate=propagation-event-log-size=1 2>&1 | FileCheck %s --check-prefix=LAST
+
+sdy.mesh @mesh = <["a"=2, "b"=2, "c"=8]>
+
+// CHECK-LABEL: input_output_source_sharding
+// CHECK-SAME:  ) -> (tensor<8x8x8xf32> {sdy.propagation_edges = #sdy.propagation_edges<[
+// CHECK-SAME:                                                       {step-0 = [{"b" = result-0 -> [operand-0]}]},
+// CHECK-SAME:                                                       {step-2 = [{"a" = operand-0 -> [result-0]}, {"c" = operand-0 -> [result-0]}]}]>,
+// CHECK-SAME:                           sdy.sharding = #sdy.sharding<@mesh, [{"a", ?}, {"b", ?}, {"c", ?}]>}) {
+// CHECK-NEXT:  %[[ADD:.*]] = stablehlo.add %arg0, %arg1 {
+// CHECK-SAME:    sdy.propagation_edges = #sdy.propagation_edges<[
+// CHECK-SAME:                                {step-1 = [
+// CHECK-SAME:                                  {"a" = operand-0 -> [operand-1, result-0]},
+// CHECK-SAME:                                  {"b" = result-0 -> [operand-0, operand-1]},
+// CHECK-SAME:                                  {"c" = operand-1 -> [operand-0, result-0]}]}]>,
+// CHECK-SAME:    sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a", ?}, {"b", ?}, {"c", ?}]>]>
+// CHECK-SAME:  } : tensor<8x8x8xf32>
+
+// Only the last event, where "c" is propagated to the func result, is kept.
+//
+// LAST-LABEL: input_output_source_sharding
+// LAST-SAME:  ) -> (tensor<8x8x8xf32> {sdy.propagation_edges = #sdy.propagation_edges<[{step-2 = [{"c" = operand-0 -> [result-0]}]}]>,
+// LAST-NEXT:  stablehlo.add %arg0, %arg1 {sdy.sharding
+func.func @input_output_source_sharding(
+  %arg0: tensor<8x8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", ?}, {?}, {?}]>},
+  %arg1: tensor<8x8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{?}, {?}, {"c", ?}]>}
+) -> (tensor<8x8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{?}, {"b", ?}, {?}]>}) {
+  %0 = stablehlo.add %arg0, %arg1 : tensor<8x8x8xf32>
+  return %0 : tensor<8x8x8xf32>
+}
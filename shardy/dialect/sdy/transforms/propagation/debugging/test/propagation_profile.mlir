@@ -0,0 +1,36 @@
+// RUN: sdy_opt %s -sdy-basic-propagate=profile-propagation=true 2>&1 | FileCheck %s
+
+sdy.mesh @mesh = <["a"=2, "b"=2]>
+
+// CHECK:      "ops": [
+// CHECK-DAG:    "name": "stablehlo.add"
+// CHECK-DAG:    "name": "stablehlo.negate"
+// CHECK:      "patterns": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "name": "PropagateRegisteredOp",
+// CHECK-NEXT:     "applications": {{[1-9][0-9]*}},
+// CHECK:      "projections": {
+// CHECK-NEXT:   "full_builds": {{[1-9][0-9]*}},
+// CHECK:      "sharding_rules": {
+// CHECK-NEXT:   "memo_hits": {{[0-9]+}},
+// CHECK-NEXT:   "memo_misses": {{[1-9][0-9]*}}
+// CHECK:      "attributes": {
+// CHECK-NEXT:   "tensor_sharding": {
+// CHECK-NEXT:     "gets": {{[1-9][0-9]*}},
+// CHECK-NEXT:     "cache_hits": {{[0-9]+}},
+// CHECK-NEXT:     "new_allocations": {{[1-9][0-9]*}},
+// CHECK-NEXT:     "storage_bytes": {{[1-9][0-9]*}}
+// CHECK:        "dim_sharding": {
+// CHECK:        "axis_ref": {
+// CHECK:        "total_storage_bytes": {{[1-9][0-9]*}}
+// CHECK:      "most_updated_values": [
+// CHECK:        "value": "stablehlo.add:0
+
+// CHECK-LABEL: func @main
+func.func @main(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {"b"}]>},
+                %arg1: tensor<8x8xf32>) -> tensor<8x8xf32> {
+  // CHECK-NEXT: stablehlo.add %arg0, %arg1 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a", ?}, {"b", ?}]>]>}
+  %0 = stablehlo.add %arg0, %arg1 : tensor<8x8xf32>
+  %1 = stablehlo.negate %0 : tensor<8x8xf32>
+  return %1 : tensor<8x8xf32>
+}
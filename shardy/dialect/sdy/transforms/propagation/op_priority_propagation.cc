@@ -20,8 +20,13 @@ limitations under the License.
 #include <cstdint>
 #include <memory>
 #include <numeric>
+#include <optional>
+#include <utility>
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Mutex.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/SymbolTable.h"
@@ -30,6 +35,7 @@ limitations under the License.
 #include "mlir/Pass/PassRegistry.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Support/LogicalResult.h"
+#include "shardy/common/timing_report.h"
 #include "shardy/dialect/sdy/ir/constants.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/utils.h"
@@ -170,6 +176,8 @@ struct OpPriorityPropagationPass
 
   explicit OpPriorityPropagationPass(const PropagationOptions& options) {
     setPropagationOptions(options);
+    incrementalOpPriorityPropagation =
+        options.enableIncrementalOpPriorityPropagation;
   }
 };
 
@@ -183,10 +191,16 @@ LogicalResult OpPriorityPropagationPassImpl::propagate(
     return AggressivePropagationPassImpl::propagate(
         moduleOp, symbolTable, shardingGroupMap, getDirectionToPropagate);
   }
+  if (incrementalOpPriorityPropagation) {
+    return propagateIncrementally(moduleOp, symbolTable, shardingGroupMap,
+                                  getDirectionToPropagate);
+  }
   // Reset currentPriority to 0. Before running the pass. This same instance
   // could have been run earlier already (e.g. with a different user priority).
   for (int64_t currentPriority = 0;
        currentPriority < opPropagationSchedule.size(); currentPriority++) {
+    TimingReportScope timingScope(
+        llvm::formatv("op_priority_{0}", currentPriority).str());
     if (AggressivePropagationPassImpl::propagate(
             moduleOp, symbolTable, shardingGroupMap,
             getOpBasedDirectionToPropagate(currentPriority,
@@ -198,6 +212,59 @@ LogicalResult OpPriorityPropagationPassImpl::propagate(
   return success();
 }
 
+LogicalResult OpPriorityPropagationPassImpl::propagateIncrementally(
+    ModuleOp moduleOp, const SymbolTable& symbolTable,
+    const ShardingGroupMap& shardingGroupMap,
+    GetDirectionToPropagateFn getDirectionToPropagate) {
+  // The frontier of an enclosing incremental propagation (e.g., for a user
+  // priority), if any, seeds the first step, and is extended with the ops
+  // visited in all steps.
+  std::optional<llvm::SetVector<Operation*>> outerFrontier =
+      takeIncrementalFrontier();
+  // The ops for which a step returned a narrower direction than the last step
+  // would. Every other op that reached a fixed point in a step is still at a
+  // fixed point in the next one, since the direction only widens from one
+  // step to the next.
+  llvm::SetVector<Operation*> restrictedOps;
+  // Funcs might be propagated in parallel in the first step.
+  llvm::sys::SmartMutex<true> restrictedOpsMutex;
+  LogicalResult result = success();
+  for (int64_t currentPriority = 0;
+       currentPriority < opPropagationSchedule.size() && succeeded(result);
+       currentPriority++) {
+    TimingReportScope timingScope(
+        llvm::formatv("op_priority_{0}", currentPriority).str());
+    if (currentPriority > 0) {
+      setIncrementalFrontier(restrictedOps);
+    } else if (outerFrontier) {
+      setIncrementalFrontier(*outerFrontier);
+    }
+    GetDirectionToPropagateFn opBasedDirectionToPropagate =
+        getOpBasedDirectionToPropagate(currentPriority,
+                                       getDirectionToPropagate);
+    result = AggressivePropagationPassImpl::propagate(
+        moduleOp, symbolTable, shardingGroupMap,
+        [&](Operation* op, int64_t factorIndex) {
+          PropagationDirection direction =
+              opBasedDirectionToPropagate(op, factorIndex);
+          if (direction != getDirectionToPropagate(op, factorIndex)) {
+            llvm::sys::SmartScopedLock<true> lock(restrictedOpsMutex);
+            restrictedOps.insert(op);
+          }
+          return direction;
+        });
+    if (std::optional<llvm::SetVector<Operation*>> visitedOps =
+            takeIncrementalFrontier();
+        visitedOps && outerFrontier) {
+      outerFrontier->set_union(*visitedOps);
+    }
+  }
+  if (outerFrontier) {
+    setIncrementalFrontier(std::move(*outerFrontier));
+  }
+  return result;
+}
+
 std::unique_ptr<Pass> createOpPriorityPropagationPass(
     const PropagationOptions& options) {
   return std::make_unique<OpPriorityPropagationPass>(options);
@@ -51,10 +51,26 @@ class OpPriorityPropagationPassImpl : public AggressivePropagationPassImpl {
       const ShardingGroupMap& shardingGroupMap,
       GetDirectionToPropagateFn getDirectionToPropagate) override;
 
+  // Same as `propagate`, but each op-priority step other than the first seeds
+  // the worklist only with the ops whose direction was restricted by a
+  // previous step (see `incrementalOpPriorityPropagation`).
+  LogicalResult propagateIncrementally(
+      ModuleOp moduleOp, const SymbolTable& symbolTable,
+      const ShardingGroupMap& shardingGroupMap,
+      GetDirectionToPropagateFn getDirectionToPropagate);
+
   Option<bool> runOpPriorityPropagation = {
       *this, "run-op-priority-propagation",
       llvm::cl::desc("whether to run (or skip) op-priority propagation"),
       llvm::cl::init(true)};
+
+  Option<bool> incrementalOpPriorityPropagation = {
+      *this, "incremental-op-priority-propagation",
+      llvm::cl::desc(
+          "whether to seed each op-priority step (other than the first) only "
+          "with the ops whose propagation was restricted by a previous step, "
+          "instead of re-propagating the entire module"),
+      llvm::cl::init(false)};
 };
 
 // Runs op based sharding propagation (see `OpPriorityPropagationPass`).
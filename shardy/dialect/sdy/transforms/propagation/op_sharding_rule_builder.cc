@@ -23,6 +23,8 @@ limitations under the License.
 #include <optional>
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "mlir/IR/BuiltinTypeInterfaces.h"
 #include "mlir/IR/BuiltinTypes.h"
@@ -142,6 +144,10 @@ OpShardingRuleBuilder::OpShardingRuleBuilder(
                             op->getContext(), reserveNumFactors) {}
 
 OpShardingRuleAttr OpShardingRuleBuilder::build() {
+  if (std::optional<OpShardingRuleBuilder> merged = mergeAdjacentFactors()) {
+    return merged->build();
+  }
+
   // NOTE: `factorSizes` might be modified by `buildTensorMappingAttrList`,
   // therefore we can't inline these variables.
   int64_t originalNumFactors = factorSizes.size();
@@ -161,6 +167,115 @@ OpShardingRuleAttr OpShardingRuleBuilder::build() {
   return result;
 }
 
+std::optional<OpShardingRuleBuilder>
+OpShardingRuleBuilder::mergeAdjacentFactors() const {
+  int64_t numFactors = factorSizes.size();
+  auto allMappings =
+      llvm::concat<const TensorMapping>(operandMappings, resultMappings);
+
+  // The factor right before and after each factor in all dimensions it's
+  // mapped to, `kNone` if it isn't mapped to any dimension, or `kConflict` if
+  // it differs between dimensions or there is no such factor in one of them.
+  constexpr int64_t kNone = -1;
+  constexpr int64_t kConflict = -2;
+  SmallVector<int64_t> predecessors(numFactors, kNone);
+  SmallVector<int64_t> successors(numFactors, kNone);
+  auto record = [&](int64_t& neighbor, int64_t factorIndex) {
+    if (neighbor == kNone) {
+      neighbor = factorIndex;
+    } else if (neighbor != factorIndex) {
+      neighbor = kConflict;
+    }
+  };
+  for (const TensorMapping& tensorMapping : allMappings) {
+    for (const DimMapping& dimMapping : tensorMapping) {
+      ArrayRef<int64_t> factorIndices = dimMapping.factorIndices;
+      for (auto [i, factorIndex] : llvm::enumerate(factorIndices)) {
+        record(predecessors[factorIndex],
+               i > 0 ? factorIndices[i - 1] : kConflict);
+        record(successors[factorIndex],
+               i + 1 < factorIndices.size() ? factorIndices[i + 1] : kConflict);
+      }
+    }
+  }
+
+  SmallVector<FactorType> factorTypes(numFactors, FactorType::kPassThrough);
+  for (int64_t factorIndex : reductionFactors) {
+    factorTypes[factorIndex] = FactorType::kReduction;
+  }
+  for (int64_t factorIndex : needReplicationFactors) {
+    factorTypes[factorIndex] = FactorType::kNeedReplication;
+  }
+  for (int64_t factorIndex : permutationFactors) {
+    factorTypes[factorIndex] = FactorType::kPermutation;
+  }
+  SmallVector<bool> isBlocked(numFactors, false);
+  for (int64_t factorIndex : blockedPropagationFactors) {
+    isBlocked[factorIndex] = true;
+  }
+
+  // A factor is merged into its predecessor, if the latter is always followed
+  // by the former, and both have the same type, in which case the axes
+  // sharding both of them are always the same as if they were a single factor.
+  SmallVector<int64_t> mergedInto = llvm::to_vector(llvm::seq<int64_t>(0, numFactors));
+  bool anyMerged = false;
+  for (int64_t factorIndex = 0; factorIndex < numFactors; ++factorIndex) {
+    int64_t predecessor = predecessors[factorIndex];
+    if (predecessor >= 0 && successors[predecessor] == factorIndex &&
+        factorTypes[predecessor] == factorTypes[factorIndex] &&
+        isBlocked[predecessor] == isBlocked[factorIndex]) {
+      mergedInto[factorIndex] = predecessor;
+      anyMerged = true;
+    }
+  }
+  if (!anyMerged) {
+    return std::nullopt;
+  }
+
+  // Resolves chains of merged factors to the first factor in the chain, and
+  // assigns a new index to each factor that isn't merged.
+  auto getRoot = [&](int64_t factorIndex) {
+    while (mergedInto[factorIndex] != factorIndex) {
+      factorIndex = mergedInto[factorIndex];
+    }
+    return factorIndex;
+  };
+  OpShardingRuleBuilder merged(*this);
+  merged.factorSizes.clear();
+  SmallVector<int64_t> newIndices(numFactors);
+  for (int64_t factorIndex = 0; factorIndex < numFactors; ++factorIndex) {
+    if (mergedInto[factorIndex] == factorIndex) {
+      newIndices[factorIndex] = merged.factorSizes.size();
+      merged.factorSizes.push_back(factorSizes[factorIndex]);
+    }
+  }
+  for (int64_t factorIndex = 0; factorIndex < numFactors; ++factorIndex) {
+    if (int64_t root = getRoot(factorIndex); root != factorIndex) {
+      merged.factorSizes[newIndices[root]] *= factorSizes[factorIndex];
+    }
+  }
+
+  auto remap = [&](SmallVector<int64_t>& factorIndices) {
+    llvm::erase_if(factorIndices, [&](int64_t factorIndex) {
+      return mergedInto[factorIndex] != factorIndex;
+    });
+    for (int64_t& factorIndex : factorIndices) {
+      factorIndex = newIndices[factorIndex];
+    }
+  };
+  for (TensorMapping& tensorMapping : llvm::concat<TensorMapping>(
+           merged.operandMappings, merged.resultMappings)) {
+    for (DimMapping& dimMapping : tensorMapping) {
+      remap(dimMapping.factorIndices);
+    }
+  }
+  remap(merged.reductionFactors);
+  remap(merged.needReplicationFactors);
+  remap(merged.permutationFactors);
+  remap(merged.blockedPropagationFactors);
+  return merged;
+}
+
 OpShardingRuleAttr OpShardingRuleBuilder::buildPointwise(Operation* op) {
   // Non-shaped types (e.g. tokens) have no pointwise sharding rule.
   auto shapedType = dyn_cast<ShapedType>(op->getResultTypes().front());
@@ -140,6 +140,15 @@ class OpShardingRuleBuilder {
   int64_t reserveFactor(int64_t factorSize, FactorType factorType,
                         bool isBlocked);
 
+  // Returns a copy of this builder where each pair of adjacent factors that
+  // can never be sharded independently, i.e., that are always mapped to the
+  // same dimensions one right after the other, is merged into a single factor.
+  // Returns std::nullopt if there are no such factors.
+  //
+  // This keeps rules of ops with many dimensions (e.g., huge reshapes) and
+  // their projections smaller.
+  std::optional<OpShardingRuleBuilder> mergeAdjacentFactors() const;
+
   MLIRContext* context;
   SmallVector<int64_t> factorSizes;
   // The mappings of factor sizes for each operand/result. Specify the index of
@@ -23,20 +23,28 @@ limitations under the License.
 #include <iterator>
 #include <numeric>
 #include <optional>
+#include <utility>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/RWMutex.h"
 #include "llvm/Support/Threading.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/OpDefinition.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Support/LLVM.h"
+#include "mlir/Support/TypeID.h"
 #include "shardy/dialect/sdy/ir/constants.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/ir/enums.h"
@@ -228,8 +236,170 @@ Value findOperandBeforeSlice(Value operand) {
   return operand;
 }
 
+// Creates the sharding rule of an op in the dispatch table, see
+// `getShardingRuleDispatchTable`.
+using ShardingRuleFn = OpShardingRuleAttr (*)(Operation* op,
+                                              bool conservativePropagation);
+
+OpShardingRuleAttr buildPointwiseRule(Operation* op, bool) {
+  return OpShardingRuleBuilder::buildPointwise(op);
+}
+
+OpShardingRuleAttr buildNoRule(Operation*, bool) {
+  return OpShardingRuleAttr();
+}
+
+template <typename... OpTys>
+void addToDispatchTable(llvm::DenseMap<TypeID, ShardingRuleFn>& table,
+                        ShardingRuleFn shardingRuleFn) {
+  (table.try_emplace(TypeID::get<OpTys>(), shardingRuleFn), ...);
+}
+
+// Returns a table from the `TypeID` of the most common ops, whose sharding rule
+// only depends on the op kind, to the function that creates it.
+//
+// These ops are looked up in the table before the `TypeSwitch` in
+// `createOpShardingRule`, which would otherwise check for each of them in turn.
+const llvm::DenseMap<TypeID, ShardingRuleFn>& getShardingRuleDispatchTable() {
+  static const llvm::DenseMap<TypeID, ShardingRuleFn> table = [] {
+    llvm::DenseMap<TypeID, ShardingRuleFn> table;
+    addToDispatchTable<
+        ShardingConstraintOp, stablehlo::AbsOp, stablehlo::AddOp,
+        stablehlo::AllReduceOp, stablehlo::AndOp, stablehlo::Atan2Op,
+        stablehlo::CbrtOp, stablehlo::CeilOp, stablehlo::ClzOp,
+        stablehlo::CollectiveBroadcastOp, stablehlo::CollectivePermuteOp,
+        stablehlo::CompareOp, stablehlo::ComplexOp, stablehlo::ConvertOp,
+        stablehlo::CosineOp, stablehlo::CrossReplicaSumOp, stablehlo::DivOp,
+        stablehlo::ExpOp, stablehlo::Expm1Op, stablehlo::FloorOp,
+        stablehlo::ImagOp, stablehlo::IsFiniteOp, stablehlo::Log1pOp,
+        stablehlo::LogOp, stablehlo::LogisticOp, stablehlo::MaxOp,
+        stablehlo::MinOp, stablehlo::MulOp, stablehlo::NegOp, stablehlo::NotOp,
+        stablehlo::OrOp, stablehlo::PopulationCountOp, stablehlo::PowOp,
+        stablehlo::RealOp, stablehlo::ReducePrecisionOp, stablehlo::RemOp,
+        stablehlo::RoundNearestEvenOp, stablehlo::RoundOp, stablehlo::RsqrtOp,
+        stablehlo::ShiftLeftOp, stablehlo::ShiftRightArithmeticOp,
+        stablehlo::ShiftRightLogicalOp, stablehlo::SignOp, stablehlo::SineOp,
+        stablehlo::SqrtOp, stablehlo::SubtractOp, stablehlo::TanOp,
+        stablehlo::TanhOp, stablehlo::XorOp>(table, buildPointwiseRule);
+    // Ops that shouldn't be registered as they are either handled separately
+    // (e.g., `stablehlo::WhileOp`) or don't require any propagation
+    // (`stablehlo::ConstantOp`).
+    // TODO(b/327191011): output unregistered op stats instead.
+    addToDispatchTable<
+        ModuleOp, func::FuncOp, func::CallOp, ConstantOp, DataFlowEdgeOp,
+        FuncDataFlowEdgeOp, ManualComputationOp, MeshOp, PropagationBarrierOp,
+        ShardingGroupOp, ReshardOp, stablehlo::AfterAllOp, stablehlo::CaseOp,
+        stablehlo::ConstantOp, stablehlo::CreateTokenOp,
+        stablehlo::GetTupleElementOp, stablehlo::InfeedOp, stablehlo::IotaOp,
+        stablehlo::OutfeedOp, stablehlo::OptimizationBarrierOp,
+        stablehlo::PartitionIdOp, stablehlo::RecvOp, stablehlo::SendOp,
+        stablehlo::WhileOp>(table, buildNoRule);
+    return table;
+  }();
+  return table;
+}
+
+// The sharding rule generators registered by `registerCustomCallShardingRule`
+// and `registerOpShardingRule`, keyed by call target and op name respectively.
+static llvm::ManagedStatic<llvm::StringMap<ShardingRuleGenerator>>
+    customCallGenerators;
+static llvm::ManagedStatic<llvm::StringMap<ShardingRuleGenerator>>
+    opGenerators;
+static llvm::ManagedStatic<llvm::sys::SmartRWMutex<true>> generatorsMutex;
+
+// Returns the registered generator of the sharding rule of `op`, or a null
+// generator if there is none.
+ShardingRuleGenerator lookupRegisteredShardingRule(Operation* op) {
+  llvm::sys::SmartScopedReader<true> scopedLock(*generatorsMutex);
+  if (auto customCall = dyn_cast<stablehlo::CustomCallOp>(op)) {
+    if (auto it = customCallGenerators->find(customCall.getCallTargetName());
+        it != customCallGenerators->end()) {
+      return it->second;
+    }
+  }
+  return opGenerators->lookup(op->getName().getStringRef());
+}
+
+// Returns true if the sharding rule of `op` only depends on its signature,
+// i.e., its name, operand/result types, and attributes, and can therefore be
+// memoized.
+//
+// Rules of registered generators are never memoized, since a generator can
+// look at anything, and can be registered after the rule of a structurally
+// identical op was memoized.
+//
+// NOTE: if a rule in `createOpShardingRule` starts looking at anything beyond
+// the op signature (e.g. regions, defining ops of operands or users of
+// results), the op must be added here.
+bool isShardingRuleMemoizable(Operation* op) {
+  // The rule of a scatter depends on whether its update computation is a
+  // supported reduction.
+  return !isa<ShardingRuleOpInterface, stablehlo::ConcatenateOp,
+              stablehlo::CustomCallOp, stablehlo::DynamicUpdateSliceOp,
+              stablehlo::ScatterOp>(op) &&
+         !lookupRegisteredShardingRule(op);
+}
+
+// Returns the attributes of `op` that are part of its signature, i.e., all
+// attributes except the ones owned by Shardy (e.g. `sdy.sharding`), which don't
+// affect the sharding rule and change throughout propagation.
+DictionaryAttr getSignatureAttrs(Operation* op) {
+  DictionaryAttr attrs = op->getAttrDictionary();
+  auto isShardyAttr = [](NamedAttribute attr) {
+    StringRef name = attr.getName().getValue();
+    return name.consume_front(SdyDialect::getDialectNamespace()) &&
+           name.starts_with(".");
+  };
+  if (llvm::none_of(attrs, isShardyAttr)) {
+    return attrs;
+  }
+  SmallVector<NamedAttribute> signatureAttrs;
+  llvm::copy_if(attrs, std::back_inserter(signatureAttrs),
+                [&](NamedAttribute attr) { return !isShardyAttr(attr); });
+  return DictionaryAttr::get(op->getContext(), signatureAttrs);
+}
+
+// Same as `createOpShardingRule`, but memoizes the created rule in the
+// context-level `ShardingRuleMemo` by op signature, so that structurally
+// identical ops share the same rule without rebuilding it.
+OpShardingRuleAttr createOrLookupOpShardingRule(Operation* op,
+                                                bool conservativePropagation) {
+  auto* sdyDialect = op->getContext()->getLoadedDialect<SdyDialect>();
+  if (!sdyDialect || !isShardingRuleMemoizable(op)) {
+    return createOpShardingRule(op, conservativePropagation);
+  }
+  ShardingRuleMemo& memo = sdyDialect->getShardingRuleMemo();
+  ShardingRuleMemo::Key key(
+      op->getName(),
+      FunctionType::get(op->getContext(), op->getOperandTypes(),
+                        op->getResultTypes()),
+      getSignatureAttrs(op), conservativePropagation);
+  if (std::optional<Attribute> shardingRule = memo.lookup(key)) {
+    return cast_or_null<OpShardingRuleAttr>(*shardingRule);
+  }
+  OpShardingRuleAttr shardingRule =
+      createOpShardingRule(op, conservativePropagation);
+  memo.insert(key, shardingRule);
+  return shardingRule;
+}
+
 }  // namespace
 
+ShardingRuleMemoStats getShardingRuleMemoStats(MLIRContext* context) {
+  auto* sdyDialect = context->getLoadedDialect<SdyDialect>();
+  if (!sdyDialect) {
+    return {};
+  }
+  ShardingRuleMemo& memo = sdyDialect->getShardingRuleMemo();
+  return {memo.getNumHits(), memo.getNumMisses()};
+}
+
+void clearShardingRuleMemo(MLIRContext* context) {
+  if (auto* sdyDialect = context->getLoadedDialect<SdyDialect>()) {
+    sdyDialect->getShardingRuleMemo().clear();
+  }
+}
+
 OpShardingRuleAttr getOrCreateShardingRule(Operation* op,
                                            bool conservativePropagation,
                                            bool setShardingRuleOnOp) {
@@ -238,36 +408,36 @@ OpShardingRuleAttr getOrCreateShardingRule(Operation* op,
     return shardingRule;
   }
   OpShardingRuleAttr shardingRule =
-      createOpShardingRule(op, conservativePropagation);
+      createOrLookupOpShardingRule(op, conservativePropagation);
   if (setShardingRuleOnOp && shardingRule) {
     op->setAttr(kShardingRuleAttr, shardingRule);
   }
   return shardingRule;
 }
 
+void registerCustomCallShardingRule(StringRef callTargetName,
+                                    ShardingRuleGenerator generator) {
+  llvm::sys::SmartScopedWriter<true> scopedLock(*generatorsMutex);
+  (*customCallGenerators)[callTargetName] = std::move(generator);
+}
+
+void registerOpShardingRule(StringRef opName, ShardingRuleGenerator generator) {
+  llvm::sys::SmartScopedWriter<true> scopedLock(*generatorsMutex);
+  (*opGenerators)[opName] = std::move(generator);
+}
+
 OpShardingRuleAttr createOpShardingRule(Operation* op,
                                         const bool conservativePropagation) {
+  // The generator is called outside of the lock, as it may create the sharding
+  // rules of other ops.
+  if (ShardingRuleGenerator generator = lookupRegisteredShardingRule(op)) {
+    return generator(op, conservativePropagation);
+  }
+  if (ShardingRuleFn shardingRuleFn =
+          getShardingRuleDispatchTable().lookup(op->getName().getTypeID())) {
+    return shardingRuleFn(op, conservativePropagation);
+  }
   return TypeSwitch<Operation*, OpShardingRuleAttr>(op)
-      .Case<ShardingConstraintOp, stablehlo::AbsOp, stablehlo::AddOp,
-            stablehlo::AllReduceOp, stablehlo::AndOp, stablehlo::Atan2Op,
-            stablehlo::CbrtOp, stablehlo::CeilOp, stablehlo::ClzOp,
-            stablehlo::CollectiveBroadcastOp, stablehlo::CollectivePermuteOp,
-            stablehlo::CompareOp, stablehlo::ComplexOp, stablehlo::ConvertOp,
-            stablehlo::CosineOp, stablehlo::CrossReplicaSumOp, stablehlo::DivOp,
-            stablehlo::ExpOp, stablehlo::Expm1Op, stablehlo::FloorOp,
-            stablehlo::ImagOp, stablehlo::IsFiniteOp, stablehlo::Log1pOp,
-            stablehlo::LogOp, stablehlo::LogisticOp, stablehlo::MaxOp,
-            stablehlo::MinOp, stablehlo::MulOp, stablehlo::NegOp,
-            stablehlo::NotOp, stablehlo::OrOp, stablehlo::PopulationCountOp,
-            stablehlo::PowOp, stablehlo::RealOp, stablehlo::ReducePrecisionOp,
-            stablehlo::RemOp, stablehlo::RoundNearestEvenOp, stablehlo::RoundOp,
-            stablehlo::RsqrtOp, stablehlo::ShiftLeftOp,
-            stablehlo::ShiftRightArithmeticOp, stablehlo::ShiftRightLogicalOp,
-            stablehlo::SignOp, stablehlo::SineOp, stablehlo::SqrtOp,
-            stablehlo::SubtractOp, stablehlo::TanOp, stablehlo::TanhOp,
-            stablehlo::XorOp>([](Operation* pointwiseOp) {
-        return OpShardingRuleBuilder::buildPointwise(pointwiseOp);
-      })
       //===----------------------------------------------------------------===//
       // NOTE: Please keep the order of cases alphabetical.
       //===----------------------------------------------------------------===//
@@ -1313,19 +1483,9 @@ OpShardingRuleAttr createOpShardingRule(Operation* op,
             }
             return builder.build();
           })
-      // Ops that shouldn't be registered as they are either handled separately
-      // (e.g., `stablehlo::WhileOp`) or don't require any propagation
-      // (`stablehlo::ConstantOp`).
-      // TODO(b/327191011): output unregistered op stats instead.
-      .Case<ModuleOp, func::FuncOp, func::CallOp, ConstantOp, DataFlowEdgeOp,
-            FuncDataFlowEdgeOp, ManualComputationOp, MeshOp,
-            PropagationBarrierOp, ShardableDataFlowOpInterface, ShardingGroupOp,
-            ReshardOp, stablehlo::AfterAllOp, stablehlo::CaseOp,
-            stablehlo::ConstantOp, stablehlo::CreateTokenOp,
-            stablehlo::GetTupleElementOp, stablehlo::InfeedOp,
-            stablehlo::IotaOp, stablehlo::OutfeedOp,
-            stablehlo::OptimizationBarrierOp, stablehlo::PartitionIdOp,
-            stablehlo::RecvOp, stablehlo::SendOp, stablehlo::WhileOp>(
+      // Other ops that implement `ShardableDataFlowOpInterface` don't have a
+      // sharding rule either (see `getShardingRuleDispatchTable`).
+      .Case<ShardableDataFlowOpInterface>(
           [](Operation* op) { return OpShardingRuleAttr(); })
       .Case([](ShardingRuleOpInterface shardingRuleOp) {
         return shardingRuleOp.getShardingRule();
@@ -16,6 +16,11 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_OP_SHARDING_RULE_REGISTRY_H_
 #define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_OP_SHARDING_RULE_REGISTRY_H_
 
+#include <cstdint>
+#include <functional>
+
+#include "llvm/ADT/StringRef.h"
+#include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Operation.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 
@@ -33,16 +38,58 @@ namespace sdy {
 OpShardingRuleAttr createOpShardingRule(Operation* op,
                                         bool conservativePropagation = false);
 
+// Creates the sharding rule of an op, or returns a null rule if the op
+// shouldn't be propagated through. See `createOpShardingRule` for the meaning
+// of `conservativePropagation`.
+using ShardingRuleGenerator = std::function<OpShardingRuleAttr(
+    Operation* op, bool conservativePropagation)>;
+
+// Registers `generator` as the sharding rule of `stablehlo.custom_call` ops
+// whose call target is `callTargetName`, replacing any previously registered
+// generator for that target.
+//
+// Registered generators take precedence over the built-in rules of
+// `createOpShardingRule`. The rules they create aren't memoized, so a generator
+// can look at more than the op signature (e.g., its regions), and takes effect
+// even if it's registered after rules were created.
+void registerCustomCallShardingRule(StringRef callTargetName,
+                                    ShardingRuleGenerator generator);
+
+// Same as `registerCustomCallShardingRule`, but for all ops named `opName`
+// (e.g. "my_dialect.my_op"), which can come from a dialect that doesn't
+// implement `ShardingRuleOpInterface`, or even be unregistered.
+void registerOpShardingRule(StringRef opName, ShardingRuleGenerator generator);
+
 // Gets the sharding rule if it exists already on the op. Else creates one.
 //
 // If `setShardingRuleOnOp` is true, sets it on the op, and returns the
 // sharding rule.
 //
+// Rules that are created are memoized in a context-level table keyed by op
+// signature (op name, operand/result types, non-Shardy attributes and
+// `conservativePropagation`), so structurally identical ops share the same
+// rule without rebuilding it. Ops whose rule depends on more than their
+// signature (e.g., a scatter, whose rule depends on its update computation)
+// or that have a registered generator are never memoized.
+//
 // See `createOpShardingRule` for more info.
 OpShardingRuleAttr getOrCreateShardingRule(Operation* op,
                                            bool conservativePropagation = false,
                                            bool setShardingRuleOnOp = true);
 
+// Hit and miss counters of the sharding rule memo table of a context.
+struct ShardingRuleMemoStats {
+  int64_t numHits = 0;
+  int64_t numMisses = 0;
+};
+
+// Returns the hit and miss counters of the sharding rule memo table used by
+// `getOrCreateShardingRule` in `context`.
+ShardingRuleMemoStats getShardingRuleMemoStats(MLIRContext* context);
+
+// Clears the sharding rule memo table of `context` and resets its counters.
+void clearShardingRuleMemo(MLIRContext* context);
+
 }  // namespace sdy
 }  // namespace mlir
 
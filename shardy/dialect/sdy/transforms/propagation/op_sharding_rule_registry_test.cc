@@ -0,0 +1,265 @@
+/* Copyright 2024 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/transforms/propagation/op_sharding_rule_registry.h"
+
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/IR/Types.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/constants.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/enums.h"
+#include "shardy/dialect/sdy/ir/testing_utils.h"
+#include "shardy/dialect/sdy/transforms/propagation/op_sharding_rule_builder.h"
+#include "stablehlo/dialect/StablehloOps.h"
+#include <gtest/gtest.h>
+
+namespace mlir {
+namespace sdy {
+namespace {
+
+class ShardingRuleMemoTest : public ShardyTestBase {};
+
+TEST_F(ShardingRuleMemoTest, StructurallyIdenticalOpsShareRule) {
+  const std::string program = R"mlir(
+    sdy.mesh @mesh = <["a"=2]>
+
+    func.func @main(%arg0: tensor<8x16xf32>, %arg1: tensor<8x16xf32>,
+                    %arg2: tensor<4x16xf32>) -> tensor<8x16xf32> {
+      %0 = stablehlo.add %arg0, %arg1 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a"}, {}]>]>} : tensor<8x16xf32>
+      %1 = stablehlo.add %0, %arg1 : tensor<8x16xf32>
+      %2 = stablehlo.add %arg2, %arg2 : tensor<4x16xf32>
+      return %1 : tensor<8x16xf32>
+    }
+  )mlir";
+
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(program, &context);
+  ASSERT_TRUE(module);
+  clearShardingRuleMemo(&context);
+  auto mainFn = cast<func::FuncOp>(module->lookupSymbol("main"));
+  auto addOps = llvm::to_vector(mainFn.getOps<stablehlo::AddOp>());
+  ASSERT_EQ(addOps.size(), 3);
+
+  OpShardingRuleAttr rule0 = getOrCreateShardingRule(addOps[0]);
+  OpShardingRuleAttr rule1 = getOrCreateShardingRule(addOps[1]);
+  OpShardingRuleAttr rule2 = getOrCreateShardingRule(addOps[2]);
+  EXPECT_EQ(rule0, rule1);
+  EXPECT_NE(rule0, rule2);
+  // The first and last ops miss, the second one hits despite having different
+  // operands and no `sdy.sharding`.
+  ShardingRuleMemoStats stats = getShardingRuleMemoStats(&context);
+  EXPECT_EQ(stats.numHits, 1);
+  EXPECT_EQ(stats.numMisses, 2);
+
+  // The rule is already set on the op, so the memo table isn't consulted.
+  EXPECT_EQ(getOrCreateShardingRule(addOps[0]), rule0);
+  stats = getShardingRuleMemoStats(&context);
+  EXPECT_EQ(stats.numHits, 1);
+  EXPECT_EQ(stats.numMisses, 2);
+
+  // A conservative rule uses a different key.
+  addOps[2]->removeAttr(kShardingRuleAttr);
+  (void)getOrCreateShardingRule(addOps[2], /*conservativePropagation=*/true);
+  EXPECT_EQ(getShardingRuleMemoStats(&context).numMisses, 3);
+}
+
+TEST_F(ShardingRuleMemoTest, ScattersWithDifferentBodiesDontShareRule) {
+  const std::string program = R"mlir(
+    func.func @main(%arg0: tensor<3x4x2xf32>, %arg1: tensor<2x3xi64>,
+                    %arg2: tensor<2x3x2x2xf32>)
+        -> (tensor<3x4x2xf32>, tensor<3x4x2xf32>) {
+      %0 = "stablehlo.scatter"(%arg0, %arg1, %arg2) ({
+        ^bb0(%arg3: tensor<f32>, %arg4: tensor<f32>):
+          %2 = stablehlo.add %arg3, %arg4 : tensor<f32>
+          stablehlo.return %2 : tensor<f32>
+      }) {
+        scatter_dimension_numbers = #stablehlo.scatter<
+          update_window_dims = [2, 3],
+          inserted_window_dims = [0],
+          scatter_dims_to_operand_dims = [0],
+          index_vector_dim = 2>,
+        indices_are_sorted = false,
+        unique_indices = false
+      } : (tensor<3x4x2xf32>, tensor<2x3xi64>, tensor<2x3x2x2xf32>) -> tensor<3x4x2xf32>
+      %1 = "stablehlo.scatter"(%arg0, %arg1, %arg2) ({
+        ^bb0(%arg3: tensor<f32>, %arg4: tensor<f32>):
+          stablehlo.return %arg4 : tensor<f32>
+      }) {
+        scatter_dimension_numbers = #stablehlo.scatter<
+          update_window_dims = [2, 3],
+          inserted_window_dims = [0],
+          scatter_dims_to_operand_dims = [0],
+          index_vector_dim = 2>,
+        indices_are_sorted = false,
+        unique_indices = false
+      } : (tensor<3x4x2xf32>, tensor<2x3xi64>, tensor<2x3x2x2xf32>) -> tensor<3x4x2xf32>
+      return %0, %1 : tensor<3x4x2xf32>, tensor<3x4x2xf32>
+    }
+  )mlir";
+
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(program, &context);
+  ASSERT_TRUE(module);
+  clearShardingRuleMemo(&context);
+  auto mainFn = cast<func::FuncOp>(module->lookupSymbol("main"));
+  auto scatterOps = llvm::to_vector(mainFn.getOps<stablehlo::ScatterOp>());
+  ASSERT_EQ(scatterOps.size(), 2);
+
+  // The scatters have the same signature, but only the first one has an update
+  // computation that is a supported reduction.
+  OpShardingRuleAttr addRule = getOrCreateShardingRule(scatterOps[0]);
+  OpShardingRuleAttr overwriteRule = getOrCreateShardingRule(scatterOps[1]);
+  EXPECT_EQ(addRule, createOpShardingRule(scatterOps[0]));
+  EXPECT_EQ(overwriteRule, createOpShardingRule(scatterOps[1]));
+  EXPECT_NE(addRule, overwriteRule);
+  ShardingRuleMemoStats stats = getShardingRuleMemoStats(&context);
+  EXPECT_EQ(stats.numHits, 0);
+  EXPECT_EQ(stats.numMisses, 0);
+}
+
+TEST_F(ShardingRuleMemoTest, RegisteredGeneratorsAreNotMemoized) {
+  const std::string program = R"mlir(
+    func.func @main(%arg0: tensor<8x16xf32>) -> tensor<8x16xf32> {
+      %0 = "my_dialect.memo_op"(%arg0) : (tensor<8x16xf32>) -> tensor<8x16xf32>
+      %1 = "my_dialect.memo_op"(%0) : (tensor<8x16xf32>) -> tensor<8x16xf32>
+      return %1 : tensor<8x16xf32>
+    }
+  )mlir";
+
+  context.allowUnregisteredDialects();
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(program, &context);
+  ASSERT_TRUE(module);
+  clearShardingRuleMemo(&context);
+  auto mainFn = cast<func::FuncOp>(module->lookupSymbol("main"));
+  Operation* firstOp = &mainFn.front().front();
+  Operation* secondOp = firstOp->getNextNode();
+
+  // Without a generator, the op has no rule, which is memoized.
+  EXPECT_FALSE(getOrCreateShardingRule(firstOp));
+  EXPECT_EQ(getShardingRuleMemoStats(&context).numMisses, 1);
+
+  // A generator registered afterwards is used for structurally identical ops,
+  // and called for each of them.
+  int64_t numCalls = 0;
+  registerOpShardingRule("my_dialect.memo_op", [&](Operation* op, bool) {
+    ++numCalls;
+    return OpShardingRuleBuilder::buildPointwise(op);
+  });
+  EXPECT_EQ(getOrCreateShardingRule(secondOp, /*conservativePropagation=*/false,
+                                    /*setShardingRuleOnOp=*/false),
+            OpShardingRuleBuilder::buildPointwise(secondOp));
+  EXPECT_EQ(getOrCreateShardingRule(firstOp, /*conservativePropagation=*/false,
+                                    /*setShardingRuleOnOp=*/false),
+            OpShardingRuleBuilder::buildPointwise(firstOp));
+  EXPECT_EQ(numCalls, 2);
+  ShardingRuleMemoStats stats = getShardingRuleMemoStats(&context);
+  EXPECT_EQ(stats.numHits, 0);
+  EXPECT_EQ(stats.numMisses, 1);
+  // The generator references a local of this test.
+  registerOpShardingRule("my_dialect.memo_op", nullptr);
+}
+
+class RegisteredShardingRuleTest : public ShardyTestBase {};
+
+TEST_F(RegisteredShardingRuleTest, CustomCallAndOpNameGenerators) {
+  const std::string program = R"mlir(
+    func.func @main(%arg0: tensor<8x16xf32>) -> tensor<8x16xf32> {
+      %0 = stablehlo.custom_call @my_kernel(%arg0) : (tensor<8x16xf32>) -> tensor<8x16xf32>
+      %1 = stablehlo.custom_call @other_kernel(%0) : (tensor<8x16xf32>) -> tensor<8x16xf32>
+      %2 = "my_dialect.my_op"(%1) : (tensor<8x16xf32>) -> tensor<8x16xf32>
+      return %2 : tensor<8x16xf32>
+    }
+  )mlir";
+
+  context.allowUnregisteredDialects();
+  OwningOpRef<ModuleOp> module =
+      parseSourceString<ModuleOp>(program, &context);
+  ASSERT_TRUE(module);
+  auto mainFn = cast<func::FuncOp>(module->lookupSymbol("main"));
+  auto customCalls = llvm::to_vector(mainFn.getOps<stablehlo::CustomCallOp>());
+  ASSERT_EQ(customCalls.size(), 2);
+  Operation* myOp = customCalls[1]->getNextNode();
+
+  EXPECT_FALSE(createOpShardingRule(customCalls[0]));
+  EXPECT_FALSE(createOpShardingRule(myOp));
+
+  auto buildPointwise = [](Operation* op, bool) {
+    return OpShardingRuleBuilder::buildPointwise(op);
+  };
+  registerCustomCallShardingRule("my_kernel", buildPointwise);
+  registerOpShardingRule("my_dialect.my_op", buildPointwise);
+  EXPECT_EQ(createOpShardingRule(customCalls[0]),
+            OpShardingRuleBuilder::buildPointwise(customCalls[0]));
+  EXPECT_FALSE(createOpShardingRule(customCalls[1]));
+  EXPECT_EQ(createOpShardingRule(myOp),
+            OpShardingRuleBuilder::buildPointwise(myOp));
+}
+
+class OpShardingRuleBuilderTest : public ShardyTestBase {};
+
+TEST_F(OpShardingRuleBuilderTest, MergesFactorsThatAreAlwaysAdjacent) {
+  Type type = RankedTensorType::get({8, 3}, Float32Type::get(&context));
+  OpShardingRuleAttr rule = OpShardingRuleBuilder(ArrayRef<Type>(type),
+                                                  ArrayRef<Type>(type),
+                                                  &context)
+                                .addFactor({0}, {0}, 2)
+                                .addFactor({0}, {0}, 4)
+                                .addFactor({1}, {1}, 3)
+                                .build();
+  EXPECT_EQ(rule.getFactorSizes(), ArrayRef<int64_t>({8, 3}));
+  EXPECT_EQ(rule.getOperandMapping(0).getDimMappings()[0].getFactorIndices(),
+            ArrayRef<int64_t>({0}));
+  EXPECT_EQ(rule.getResultMapping(0).getDimMappings()[1].getFactorIndices(),
+            ArrayRef<int64_t>({1}));
+}
+
+TEST_F(OpShardingRuleBuilderTest, DoesNotMergeFactorsOfDifferentTypes) {
+  Type type = RankedTensorType::get({8}, Float32Type::get(&context));
+  OpShardingRuleAttr rule =
+      OpShardingRuleBuilder(ArrayRef<Type>(type), ArrayRef<Type>(type),
+                            &context)
+          .addFactor({0}, {0}, 2)
+          .addFactor({0}, {0}, 4, FactorType::kNeedReplication)
+          .build();
+  EXPECT_EQ(rule.getFactorSizes(), ArrayRef<int64_t>({2, 4}));
+  EXPECT_TRUE(rule.isNeedReplicationFactor(1));
+}
+
+TEST_F(OpShardingRuleBuilderTest, DoesNotMergeFactorsThatAreSplitElsewhere) {
+  Type operandType = RankedTensorType::get({8}, Float32Type::get(&context));
+  Type resultType = RankedTensorType::get({2, 4}, Float32Type::get(&context));
+  OpShardingRuleAttr rule =
+      OpShardingRuleBuilder(ArrayRef<Type>(operandType),
+                            ArrayRef<Type>(resultType), &context)
+          .addFactor({0}, {0}, 2)
+          .addFactor({0}, {1}, 4)
+          .build();
+  EXPECT_EQ(rule.getFactorSizes(), ArrayRef<int64_t>({2, 4}));
+}
+
+}  // namespace
+}  // namespace sdy
+}  // namespace mlir
@@ -0,0 +1,229 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/transforms/propagation/packed_axis.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/macros.h"
+#include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
+
+namespace mlir {
+namespace sdy {
+
+//===----------------------------------------------------------------------===//
+// MeshAxisIndex
+//===----------------------------------------------------------------------===//
+
+std::optional<MeshAxisIndex> MeshAxisIndex::build(MeshAttr mesh) {
+  ArrayRef<MeshAxisAttr> axes = mesh.getAxes();
+  if (axes.size() > kMaxNumAxes) {
+    return std::nullopt;
+  }
+  MeshAxisIndex index(mesh);
+  index.axisSizes.reserve(axes.size());
+  for (auto [axisIndex, axis] : llvm::enumerate(axes)) {
+    if (axis.getSize() >= kMaxAxisSize) {
+      return std::nullopt;
+    }
+    index.axisNameToIndex[axis.getName()] = axisIndex;
+    index.axisSizes.push_back(axis.getSize());
+  }
+  return index;
+}
+
+//===----------------------------------------------------------------------===//
+// PackedAxisRef
+//===----------------------------------------------------------------------===//
+
+PackedAxisRef PackedAxisRef::pack(AxisRefAttr axisRef,
+                                  const MeshAxisIndex& index) {
+  assert(index.getMesh().hasAxis(axisRef.getName()));
+  int64_t axisIndex = index.getAxisIndex(axisRef.getName());
+  if (SubAxisInfoAttr subAxisInfo = axisRef.getSubAxisInfo()) {
+    return PackedAxisRef(axisIndex, subAxisInfo.getPreSize(),
+                         subAxisInfo.getSize());
+  }
+  return PackedAxisRef(axisIndex, /*preSize=*/1, index.getAxisSize(axisIndex));
+}
+
+AxisRefAttr PackedAxisRef::unpack(const MeshAxisIndex& index) const {
+  MeshAxisAttr axis = index.getMesh().getAxes()[getAxisIndex()];
+  if (getPreSize() == 1 && getSize() == axis.getSize()) {
+    return AxisRefAttr::get(index.getMesh().getContext(), axis.getName());
+  }
+  return AxisRefAttr::get(index.getMesh().getContext(), axis.getName(),
+                          getPreSize(), getSize());
+}
+
+bool PackedAxisRef::contains(PackedAxisRef other) const {
+  return sameAxis(other) && getPreSize() <= other.getPreSize() &&
+         getNextPreSize() >= other.getNextPreSize();
+}
+
+bool PackedAxisRef::prefixOf(PackedAxisRef other) const {
+  return other.contains(*this) && getPreSize() == other.getPreSize();
+}
+
+bool PackedAxisRef::overlaps(PackedAxisRef other) const {
+  return sameAxis(other) && getPreSize() < other.getNextPreSize() &&
+         other.getPreSize() < getNextPreSize();
+}
+
+bool PackedAxisRef::canCoexist(PackedAxisRef other) const {
+  if (!sameAxis(other)) {
+    return true;
+  }
+  auto [minPreSize, maxPreSize] =
+      std::minmax(getPreSize(), other.getPreSize());
+  auto [minNextPreSize, maxNextPreSize] =
+      std::minmax(getNextPreSize(), other.getNextPreSize());
+  if (minNextPreSize > maxPreSize) {
+    // Sub-axes overlap, check if overlapping and non-overlapping parts are
+    // valid.
+    return minNextPreSize % maxPreSize == 0 && maxPreSize % minPreSize == 0 &&
+           maxNextPreSize % minNextPreSize == 0;
+  }
+  // Sub-axes don't overlap, check if the gap is valid.
+  return maxPreSize % minNextPreSize == 0;
+}
+
+std::optional<PackedAxisRef> PackedAxisRef::getPrefixWithoutOverlap(
+    PackedAxisRef other) const {
+  if (!canCoexist(other)) {
+    return std::nullopt;
+  }
+  if (!overlaps(other)) {
+    return *this;
+  }
+  if (getPreSize() >= other.getPreSize()) {
+    return std::nullopt;
+  }
+  return PackedAxisRef(getAxisIndex(), getPreSize(),
+                       other.getPreSize() / getPreSize());
+}
+
+std::optional<PackedAxisRef> PackedAxisRef::getGreatestCommonPrefix(
+    PackedAxisRef other) const {
+  if (!canCoexist(other)) {
+    return std::nullopt;
+  }
+  if (prefixOf(other)) {
+    return *this;
+  }
+  if (other.prefixOf(*this)) {
+    return other;
+  }
+  return std::nullopt;
+}
+
+//===----------------------------------------------------------------------===//
+// Axis list utilities
+//===----------------------------------------------------------------------===//
+
+SmallVector<PackedAxisRef> packAxisRefs(ArrayRef<AxisRefAttr> axisRefs,
+                                        const MeshAxisIndex& index) {
+  return llvm::map_to_vector(axisRefs, [&](AxisRefAttr axisRef) {
+    return PackedAxisRef::pack(axisRef, index);
+  });
+}
+
+SmallVector<AxisRefAttr> unpackAxisRefs(ArrayRef<PackedAxisRef> axisRefs,
+                                        const MeshAxisIndex& index) {
+  return llvm::map_to_vector(axisRefs, [&](PackedAxisRef axisRef) {
+    return axisRef.unpack(index);
+  });
+}
+
+PrefixStatus isAxisListPrefixOf(ArrayRef<PackedAxisRef> first,
+                                ArrayRef<PackedAxisRef> second) {
+  if (first.empty()) {
+    return second.empty() ? PrefixStatus::EQUAL : PrefixStatus::STRICT_PREFIX;
+  }
+  if (first.size() > second.size()) {
+    return PrefixStatus::NOT_A_PREFIX;
+  }
+  if (!llvm::equal(first.drop_back(),
+                   second.take_front(first.size() - 1))) {
+    return PrefixStatus::NOT_A_PREFIX;
+  }
+  PackedAxisRef firstLast = first.back();
+  PackedAxisRef secondLast = second[first.size() - 1];
+  if (first.size() == second.size() && firstLast == secondLast) {
+    return PrefixStatus::EQUAL;
+  }
+  if (firstLast.prefixOf(secondLast)) {
+    return PrefixStatus::STRICT_PREFIX;
+  }
+  return PrefixStatus::NOT_A_PREFIX;
+}
+
+SmallVector<PackedAxisRef> getGreatestCommonPrefix(
+    ArrayRef<PackedAxisRef> first, ArrayRef<PackedAxisRef> second) {
+  SmallVector<PackedAxisRef> result;
+  for (auto [firstAxisRef, secondAxisRef] : llvm::zip(first, second)) {
+    if (firstAxisRef == secondAxisRef) {
+      result.push_back(firstAxisRef);
+      continue;
+    }
+    if (auto prefix = firstAxisRef.getGreatestCommonPrefix(secondAxisRef)) {
+      result.push_back(*prefix);
+    }
+    break;
+  }
+  return result;
+}
+
+std::optional<PackedAxisRef> getPrefixWithoutOverlap(
+    PackedAxisRef axisRef, ArrayRef<PackedAxisRef> otherAxisRefs) {
+  PackedAxisRef result = axisRef;
+  for (PackedAxisRef otherAxisRef : otherAxisRefs) {
+    SDY_ASSIGN_OR_RETURN_IF_NULLOPT(
+        result, result.getPrefixWithoutOverlap(otherAxisRef));
+  }
+  return result;
+}
+
+void truncateAxesByRemovingOverlaps(SmallVector<PackedAxisRef>& axes,
+                                    ArrayRef<PackedAxisRef> otherAxisRefs) {
+  PackedAxisSet otherAxisSet;
+  otherAxisSet.insert(otherAxisRefs);
+  for (const auto [axisIndex, curAxis] : llvm::enumerate(axes)) {
+    if (!otherAxisSet.mayOverlap(curAxis)) {
+      continue;
+    }
+    std::optional<PackedAxisRef> newAxis =
+        getPrefixWithoutOverlap(curAxis, otherAxisRefs);
+    if (!newAxis) {
+      axes.truncate(axisIndex);
+      return;
+    }
+    if (axes[axisIndex] != *newAxis) {
+      axes[axisIndex] = *newAxis;
+      axes.truncate(axisIndex + 1);
+      return;
+    }
+  }
+}
+
+}  // namespace sdy
+}  // namespace mlir
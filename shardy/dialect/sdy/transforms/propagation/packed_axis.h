@@ -0,0 +1,172 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_PACKED_AXIS_H_
+#define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_PACKED_AXIS_H_
+
+#include <cstdint>
+#include <optional>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
+
+namespace mlir {
+namespace sdy {
+
+// Maps the axes of a mesh to their index in the mesh, so that axis refs can be
+// packed into a `PackedAxisRef`.
+class MeshAxisIndex {
+ public:
+  // The maximum number of axes in a mesh that can be packed, such that a
+  // `PackedAxisSet` can hold all of them.
+  static constexpr int64_t kMaxNumAxes = 64;
+  // Axis sizes (and therefore sub-axis pre-sizes and sizes) must be smaller
+  // than this bound to be packed.
+  static constexpr int64_t kMaxAxisSize = int64_t{1} << 24;
+
+  // Returns a `MeshAxisIndex` for `mesh`, or std::nullopt if the mesh has too
+  // many axes or an axis that is too large to be packed.
+  static std::optional<MeshAxisIndex> build(MeshAttr mesh);
+
+  MeshAttr getMesh() const { return mesh; }
+
+  // Returns the index of the axis with `name` in the mesh.
+  int64_t getAxisIndex(StringRef name) const {
+    return axisNameToIndex.lookup(name);
+  }
+
+  int64_t getAxisSize(int64_t axisIndex) const { return axisSizes[axisIndex]; }
+
+ private:
+  explicit MeshAxisIndex(MeshAttr mesh) : mesh(mesh) {}
+
+  MeshAttr mesh;
+  llvm::StringMap<int64_t> axisNameToIndex;
+  SmallVector<int64_t> axisSizes;
+};
+
+// An axis ref packed into a single integer, i.e., the index of the axis in the
+// mesh, the sub-axis pre-size and the sub-axis size.
+//
+// A full axis is represented as a sub-axis with pre-size 1 and the full axis
+// size, which allows all queries to be implemented as integer comparisons
+// without looking up the mesh.
+class PackedAxisRef {
+ public:
+  // Packs `axisRef`, which must refer to an axis in `index.getMesh()`.
+  static PackedAxisRef pack(AxisRefAttr axisRef, const MeshAxisIndex& index);
+
+  // Unpacks this axis ref back into an `AxisRefAttr`.
+  AxisRefAttr unpack(const MeshAxisIndex& index) const;
+
+  int64_t getAxisIndex() const { return bits >> (2 * kSizeBits); }
+  int64_t getPreSize() const { return (bits >> kSizeBits) & kSizeMask; }
+  int64_t getSize() const { return bits & kSizeMask; }
+  int64_t getNextPreSize() const { return getPreSize() * getSize(); }
+
+  uint64_t getRawBits() const { return bits; }
+
+  bool operator==(PackedAxisRef other) const { return bits == other.bits; }
+  bool operator!=(PackedAxisRef other) const { return bits != other.bits; }
+
+  // See `AxisRefAttr` for the semantics of the following methods.
+  bool contains(PackedAxisRef other) const;
+  bool prefixOf(PackedAxisRef other) const;
+  bool overlaps(PackedAxisRef other) const;
+  bool canCoexist(PackedAxisRef other) const;
+  std::optional<PackedAxisRef> getPrefixWithoutOverlap(
+      PackedAxisRef other) const;
+  std::optional<PackedAxisRef> getGreatestCommonPrefix(
+      PackedAxisRef other) const;
+
+ private:
+  static constexpr int kSizeBits = 24;
+  static constexpr uint64_t kSizeMask = (uint64_t{1} << kSizeBits) - 1;
+
+  PackedAxisRef(int64_t axisIndex, int64_t preSize, int64_t size)
+      : bits((static_cast<uint64_t>(axisIndex) << (2 * kSizeBits)) |
+             (static_cast<uint64_t>(preSize) << kSizeBits) |
+             static_cast<uint64_t>(size)) {}
+
+  bool sameAxis(PackedAxisRef other) const {
+    return getAxisIndex() == other.getAxisIndex();
+  }
+
+  uint64_t bits;
+};
+
+// A set of mesh axes represented as a bitmask over the axis indices of a
+// `MeshAxisIndex`.
+//
+// The set only tracks full axes, i.e., inserting a sub-axis adds its full
+// axis. Therefore `mayOverlap` is a conservative filter: if it returns false,
+// the axis ref is guaranteed not to overlap with any axis in the set.
+class PackedAxisSet {
+ public:
+  void insert(PackedAxisRef axisRef) { mask |= getBit(axisRef); }
+
+  void insert(ArrayRef<PackedAxisRef> axisRefs) {
+    for (PackedAxisRef axisRef : axisRefs) {
+      insert(axisRef);
+    }
+  }
+
+  bool mayOverlap(PackedAxisRef axisRef) const {
+    return mask & getBit(axisRef);
+  }
+
+  bool mayOverlap(PackedAxisSet other) const { return mask & other.mask; }
+
+  bool empty() const { return mask == 0; }
+
+ private:
+  static uint64_t getBit(PackedAxisRef axisRef) {
+    return uint64_t{1} << axisRef.getAxisIndex();
+  }
+
+  uint64_t mask = 0;
+};
+
+// Packs each axis ref in `axisRefs`.
+SmallVector<PackedAxisRef> packAxisRefs(ArrayRef<AxisRefAttr> axisRefs,
+                                        const MeshAxisIndex& index);
+
+// Unpacks each axis ref in `axisRefs`.
+SmallVector<AxisRefAttr> unpackAxisRefs(ArrayRef<PackedAxisRef> axisRefs,
+                                        const MeshAxisIndex& index);
+
+// Same as the `AxisRefAttr` variant in sharding_projection.h.
+PrefixStatus isAxisListPrefixOf(ArrayRef<PackedAxisRef> first,
+                                ArrayRef<PackedAxisRef> second);
+
+// Same as the `AxisRefAttr` variant in ir/utils.h.
+SmallVector<PackedAxisRef> getGreatestCommonPrefix(
+    ArrayRef<PackedAxisRef> first, ArrayRef<PackedAxisRef> second);
+
+// Same as the `AxisRefAttr` variant in ir/utils.h.
+std::optional<PackedAxisRef> getPrefixWithoutOverlap(
+    PackedAxisRef axisRef, ArrayRef<PackedAxisRef> otherAxisRefs);
+
+// Same as the `AxisRefAttr` variant in ir/utils.h.
+void truncateAxesByRemovingOverlaps(SmallVector<PackedAxisRef>& axes,
+                                    ArrayRef<PackedAxisRef> otherAxisRefs);
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_PACKED_AXIS_H_
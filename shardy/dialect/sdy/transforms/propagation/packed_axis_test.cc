@@ -0,0 +1,168 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/dialect/sdy/transforms/propagation/packed_axis.h"
+
+#include <optional>
+
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/testing_utils.h"
+#include "shardy/dialect/sdy/ir/utils.h"
+#include "shardy/dialect/sdy/transforms/propagation/sharding_projection.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mlir {
+namespace sdy {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+class PackedAxisTest : public ShardyTestBase {
+ protected:
+  void SetUp() override {
+    ShardyTestBase::SetUp();
+    index = MeshAxisIndex::build(createMesh({{"a", 16}, {"b", 4}, {"c", 6}}));
+    ASSERT_TRUE(index.has_value());
+  }
+
+  PackedAxisRef pack(AxisRefAttr axisRef) {
+    return PackedAxisRef::pack(axisRef, *index);
+  }
+
+  SmallVector<PackedAxisRef> pack(ArrayRef<AxisRefAttr> axisRefs) {
+    return packAxisRefs(axisRefs, *index);
+  }
+
+  std::optional<MeshAxisIndex> index;
+};
+
+TEST_F(PackedAxisTest, PackUnpackRoundTrip) {
+  for (AxisRefAttr axisRef :
+       {createAxis("a"), createAxis("b"), createAxis("c"),
+        createSubAxis("a", 1, 4), createSubAxis("a", 4, 2),
+        createSubAxis("c", 2, 3)}) {
+    EXPECT_EQ(pack(axisRef).unpack(*index), axisRef);
+  }
+  EXPECT_EQ(pack(createAxis("a")).getPreSize(), 1);
+  EXPECT_EQ(pack(createAxis("a")).getSize(), 16);
+  EXPECT_NE(pack(createAxis("b")), pack(createSubAxis("a", 1, 4)));
+}
+
+TEST_F(PackedAxisTest, MatchesAxisRefAttrQueries) {
+  SmallVector<AxisRefAttr> axisRefs = {
+      createAxis("a"),          createAxis("b"),
+      createSubAxis("a", 1, 2), createSubAxis("a", 1, 4),
+      createSubAxis("a", 2, 2), createSubAxis("a", 2, 4),
+      createSubAxis("a", 4, 4), createSubAxis("a", 8, 2),
+      createSubAxis("b", 2, 2), createSubAxis("c", 2, 3),
+      createSubAxis("c", 1, 3)};
+  for (AxisRefAttr lhs : axisRefs) {
+    for (AxisRefAttr rhs : axisRefs) {
+      PackedAxisRef packedLhs = pack(lhs);
+      PackedAxisRef packedRhs = pack(rhs);
+      EXPECT_EQ(packedLhs.contains(packedRhs), lhs.contains(rhs));
+      EXPECT_EQ(packedLhs.prefixOf(packedRhs), lhs.prefixOf(rhs));
+      EXPECT_EQ(packedLhs.overlaps(packedRhs), lhs.overlaps(rhs));
+      EXPECT_EQ(packedLhs.canCoexist(packedRhs), lhs.canCoexist(rhs));
+
+      std::optional<AxisRefAttr> prefix = lhs.getPrefixWithoutOverlap(rhs);
+      std::optional<PackedAxisRef> packedPrefix =
+          packedLhs.getPrefixWithoutOverlap(packedRhs);
+      ASSERT_EQ(packedPrefix.has_value(), prefix.has_value());
+      if (prefix) {
+        EXPECT_EQ(packedPrefix->unpack(*index), *prefix);
+      }
+
+      std::optional<AxisRefAttr> commonPrefix =
+          lhs.getGreatestCommonPrefix(rhs);
+      std::optional<PackedAxisRef> packedCommonPrefix =
+          packedLhs.getGreatestCommonPrefix(packedRhs);
+      ASSERT_EQ(packedCommonPrefix.has_value(), commonPrefix.has_value());
+      if (commonPrefix) {
+        EXPECT_EQ(packedCommonPrefix->unpack(*index), *commonPrefix);
+      }
+    }
+  }
+}
+
+TEST_F(PackedAxisTest, IsAxisListPrefixOf) {
+  SmallVector<AxisRefAttr> first = {createAxis("b"), createSubAxis("a", 1, 2)};
+  SmallVector<AxisRefAttr> second = {createAxis("b"), createSubAxis("a", 1, 4),
+                                     createAxis("c")};
+  EXPECT_EQ(isAxisListPrefixOf(pack(first), pack(second)),
+            PrefixStatus::STRICT_PREFIX);
+  EXPECT_EQ(isAxisListPrefixOf(pack(second), pack(first)),
+            PrefixStatus::NOT_A_PREFIX);
+  EXPECT_EQ(isAxisListPrefixOf(pack(first), pack(first)), PrefixStatus::EQUAL);
+  EXPECT_EQ(isAxisListPrefixOf(ArrayRef<PackedAxisRef>(), pack(first)),
+            PrefixStatus::STRICT_PREFIX);
+}
+
+TEST_F(PackedAxisTest, GetGreatestCommonPrefix) {
+  SmallVector<AxisRefAttr> first = {createAxis("b"), createSubAxis("a", 1, 2),
+                                    createAxis("c")};
+  SmallVector<AxisRefAttr> second = {createAxis("b"),
+                                     createSubAxis("a", 1, 4)};
+  EXPECT_THAT(unpackAxisRefs(getGreatestCommonPrefix(pack(first), pack(second)),
+                             *index),
+              ElementsAreArray(getGreatestCommonPrefix(first, second)));
+}
+
+TEST_F(PackedAxisTest, TruncateAxesByRemovingOverlaps) {
+  SmallVector<AxisRefAttr> axes = {createAxis("b"), createAxis("a"),
+                                   createAxis("c")};
+  SmallVector<AxisRefAttr> otherAxes = {createSubAxis("a", 4, 2)};
+  SmallVector<PackedAxisRef> packedAxes = pack(axes);
+  truncateAxesByRemovingOverlaps(packedAxes, pack(otherAxes));
+  truncateAxesByRemovingOverlaps(axes, otherAxes);
+  EXPECT_THAT(unpackAxisRefs(packedAxes, *index), ElementsAreArray(axes));
+  EXPECT_THAT(axes, ElementsAreArray({createAxis("b"),
+                                      createSubAxis("a", 1, 4)}));
+}
+
+TEST_F(PackedAxisTest, TruncateAxesByRemovingOverlapsMatchesAxisRefAttr) {
+  SmallVector<SmallVector<AxisRefAttr>> axisLists = {
+      {},
+      {createAxis("a")},
+      {createSubAxis("a", 1, 2), createAxis("b")},
+      {createSubAxis("a", 2, 4), createSubAxis("c", 1, 3)},
+      {createAxis("b"), createSubAxis("a", 4, 4), createAxis("c")},
+      {createSubAxis("b", 2, 2), createSubAxis("a", 1, 8)},
+      {createSubAxis("c", 2, 3), createSubAxis("a", 8, 2)}};
+  for (ArrayRef<AxisRefAttr> axisList : axisLists) {
+    for (ArrayRef<AxisRefAttr> otherAxisList : axisLists) {
+      SmallVector<AxisRefAttr> axes = llvm::to_vector(axisList);
+      SmallVector<PackedAxisRef> packedAxes = pack(axes);
+      truncateAxesByRemovingOverlaps(axes, otherAxisList);
+      truncateAxesByRemovingOverlaps(packedAxes, pack(otherAxisList));
+      EXPECT_THAT(unpackAxisRefs(packedAxes, *index), ElementsAreArray(axes));
+    }
+  }
+}
+
+TEST_F(PackedAxisTest, PackedAxisSet) {
+  PackedAxisSet axisSet;
+  EXPECT_TRUE(axisSet.empty());
+  axisSet.insert(pack(createSubAxis("a", 2, 2)));
+  EXPECT_TRUE(axisSet.mayOverlap(pack(createSubAxis("a", 8, 2))));
+  EXPECT_FALSE(axisSet.mayOverlap(pack(createAxis("b"))));
+}
+
+}  // namespace
+}  // namespace sdy
+}  // namespace mlir
@@ -54,6 +54,13 @@ void addPropagationPipeline(OpPassManager& pm,
 // Register the sdy-propagation-pipeline.
 void registerPropagationPipeline();
 
+// Registers the `CostBasedAutoPartitionerPass` with `options`, followed by
+// op-priority propagation, as the callback of the `AutoPartitionerRegistry`.
+//
+// Assumes no callback has been registered yet.
+void registerCostBasedAutoPartitioner(
+    const CostBasedAutoPartitionerPassOptions& options = {});
+
 }  // namespace sdy
 }  // namespace mlir
 
@@ -13,11 +13,20 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstddef>
 #include <memory>  // IWYU pragma: keep
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"  // IWYU pragma: keep
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Operation.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/constants.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/transforms/propagation/op_sharding_rule_registry.h"
 #include "shardy/dialect/sdy/transforms/propagation/passes.h"  // IWYU pragma: keep
 
@@ -35,9 +44,35 @@ struct PopulateOpShardingRulesPass
   using PopulateOpShardingRulesPassBase::PopulateOpShardingRulesPassBase;
 
   void runOnOperation() final {
-    getOperation().walk([this](Operation* op) {
-      (void)getOrCreateShardingRule(op, conservativePropagation);
+    MLIRContext* context = &getContext();
+    SmallVector<Operation*> ops;
+    getOperation().walk([&](Operation* op) {
+      if (!op->hasAttr(kShardingRuleAttr)) {
+        ops.push_back(op);
+      }
     });
+
+    // Creating a rule only reads the IR, and attributes are uniqued in a
+    // thread-safe way, so the rules are created in parallel and only attached
+    // to the ops afterwards. Structurally identical ops still share a rule
+    // through the context-level memo table, which is thread-safe as well.
+    SmallVector<OpShardingRuleAttr> shardingRules(ops.size());
+    // Orders the diagnostics emitted while creating the rules by op, rather
+    // than by the thread that emitted them.
+    ParallelDiagnosticHandler diagHandler(context);
+    parallelFor(context, 0, ops.size(), [&](size_t index) {
+      diagHandler.setOrderIDForThread(index);
+      shardingRules[index] =
+          getOrCreateShardingRule(ops[index], conservativePropagation,
+                                  /*setShardingRuleOnOp=*/false);
+      diagHandler.eraseOrderIDForThread();
+    });
+
+    for (auto [op, shardingRule] : llvm::zip_equal(ops, shardingRules)) {
+      if (shardingRule) {
+        op->setAttr(kShardingRuleAttr, shardingRule);
+      }
+    }
   }
 };
 
@@ -0,0 +1,396 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmark for the SDY propagation passes on synthetic modules.
+//
+// Generates parameterized StableHLO modules on a fixed mesh (MLPs, attention
+// blocks, nested while loops, wide constant fan-out and many sharding groups)
+// and reports the wall time of each propagation stage, to catch compile-time
+// regressions. Benchmarks are named `<module>/<stage>`.
+//
+// Usage:
+//   propagation_benchmark [--size=<n>] [--repetitions=<n>] [--filter=<regex>]
+//     [--enable-threading]
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/benchmark_util.h"
+#include "shardy/dialect/sdy/ir/register.h"
+#include "shardy/dialect/sdy/transforms/common/propagation_options.h"
+#include "shardy/dialect/sdy/transforms/import/passes.h"
+#include "shardy/dialect/sdy/transforms/propagation/aggressive_propagation.h"
+#include "shardy/dialect/sdy/transforms/propagation/basic_propagation.h"
+#include "shardy/dialect/sdy/transforms/propagation/op_priority_propagation.h"
+#include "shardy/dialect/sdy/transforms/propagation/op_sharding_rule_registry.h"
+#include "shardy/dialect/sdy/transforms/propagation/passes.h"
+#include "shardy/dialect/sdy/transforms/propagation/user_priority_propagation.h"
+
+namespace mlir {
+namespace sdy {
+namespace {
+
+llvm::cl::opt<int64_t> sizeFlag(
+    "size",
+    llvm::cl::desc("The scale of each generated module, e.g., the number of "
+                   "layers, the loop depth or the number of users."),
+    llvm::cl::init(16));
+
+constexpr StringRef kMesh = R"mlir(sdy.mesh @mesh = <["data"=4, "model"=8]>
+)mlir";
+
+// Returns the sharding of the j-th generated rank-2 func argument, alternating
+// between data and model parallelism.
+StringRef getArgSharding(int64_t j) {
+  return j % 2 == 0 ? R"(#sdy.sharding<@mesh, [{"data"}, {}]>)"
+                    : R"(#sdy.sharding<@mesh, [{}, {"model"}]>)";
+}
+
+// An MLP with `numLayers` layers, each a matmul followed by a bias add and a
+// non-linearity, where the weights alternate between column and row sharding.
+std::string generateMlp(int64_t numLayers) {
+  std::string str(kMesh);
+  llvm::raw_string_ostream os(str);
+  os << "func.func @main(%x: tensor<64x256xf32> "
+        "{sdy.sharding = #sdy.sharding<@mesh, [{\"data\"}, {}]>}";
+  for (int64_t i = 0; i < numLayers; ++i) {
+    os << llvm::formatv(
+        ", %w{0}: tensor<256x256xf32> {sdy.sharding = "
+        "#sdy.sharding<@mesh, [{1}]>}, %b{0}: tensor<256xf32>",
+        i, i % 2 == 0 ? R"({}, {"model"})" : R"({"model"}, {})");
+  }
+  os << ") -> tensor<64x256xf32> {\n";
+  os << "  %h0 = stablehlo.negate %x : tensor<64x256xf32>\n";
+  for (int64_t i = 0; i < numLayers; ++i) {
+    os << llvm::formatv(
+        "  %mm{0} = stablehlo.dot_general %h{0}, %w{0}, contracting_dims = "
+        "[1] x [0] : (tensor<64x256xf32>, tensor<256x256xf32>) -> "
+        "tensor<64x256xf32>\n"
+        "  %bb{0} = stablehlo.broadcast_in_dim %b{0}, dims = [1] : "
+        "(tensor<256xf32>) -> tensor<64x256xf32>\n"
+        "  %add{0} = stablehlo.add %mm{0}, %bb{0} : tensor<64x256xf32>\n"
+        "  %h{1} = stablehlo.tanh %add{0} : tensor<64x256xf32>\n",
+        i, i + 1);
+  }
+  os << llvm::formatv("  return %h{0} : tensor<64x256xf32>\n}\n", numLayers);
+  return str;
+}
+
+// A stack of `numLayers` single-head attention blocks with a residual
+// connection, reshaping into 8 heads to exercise reshape, transpose, batched
+// dot and reduce sharding rules.
+std::string generateAttention(int64_t numLayers) {
+  std::string str(kMesh);
+  llvm::raw_string_ostream os(str);
+  os << "func.func @main(%x: tensor<8x128x256xf32> "
+        "{sdy.sharding = #sdy.sharding<@mesh, [{\"data\"}, {}, {}]>}";
+  for (int64_t i = 0; i < numLayers; ++i) {
+    for (StringRef name : {"wq", "wk", "wv"}) {
+      os << llvm::formatv(
+          ", %{0}{1}: tensor<256x256xf32> {sdy.sharding = "
+          "#sdy.sharding<@mesh, [{}, {\"model\"}]>}",
+          name, i);
+    }
+    os << llvm::formatv(
+        ", %wo{0}: tensor<256x256xf32> {sdy.sharding = "
+        "#sdy.sharding<@mesh, [{\"model\"}, {}]>}",
+        i);
+  }
+  os << ") -> tensor<8x128x256xf32> {\n";
+  os << "  %zero = stablehlo.constant dense<0.000000e+00> : tensor<f32>\n";
+  os << "  %h0 = stablehlo.negate %x : tensor<8x128x256xf32>\n";
+  for (int64_t i = 0; i < numLayers; ++i) {
+    for (StringRef name : {"q", "k", "v"}) {
+      os << llvm::formatv(
+          "  %{0}proj{1} = stablehlo.dot_general %h{1}, %w{0}{1}, "
+          "contracting_dims = [2] x [0] : (tensor<8x128x256xf32>, "
+          "tensor<256x256xf32>) -> tensor<8x128x256xf32>\n"
+          "  %{0}split{1} = stablehlo.reshape %{0}proj{1} : "
+          "(tensor<8x128x256xf32>) -> tensor<8x128x8x32xf32>\n"
+          "  %{0}{1} = stablehlo.transpose %{0}split{1}, dims = [0, 2, 1, 3] "
+          ": (tensor<8x128x8x32xf32>) -> tensor<8x8x128x32xf32>\n",
+          name, i);
+    }
+    os << llvm::formatv(
+        "  %scores{0} = stablehlo.dot_general %q{0}, %k{0}, batching_dims = "
+        "[0, 1] x [0, 1], contracting_dims = [3] x [3] : "
+        "(tensor<8x8x128x32xf32>, tensor<8x8x128x32xf32>) -> "
+        "tensor<8x8x128x128xf32>\n"
+        "  %exp{0} = stablehlo.exponential %scores{0} : "
+        "tensor<8x8x128x128xf32>\n"
+        "  %sum{0} = stablehlo.reduce(%exp{0} init: %zero) applies "
+        "stablehlo.add across dimensions = [3] : (tensor<8x8x128x128xf32>, "
+        "tensor<f32>) -> tensor<8x8x128xf32>\n"
+        "  %sumb{0} = stablehlo.broadcast_in_dim %sum{0}, dims = [0, 1, 2] : "
+        "(tensor<8x8x128xf32>) -> tensor<8x8x128x128xf32>\n"
+        "  %probs{0} = stablehlo.divide %exp{0}, %sumb{0} : "
+        "tensor<8x8x128x128xf32>\n"
+        "  %ctx{0} = stablehlo.dot_general %probs{0}, %v{0}, batching_dims = "
+        "[0, 1] x [0, 1], contracting_dims = [3] x [2] : "
+        "(tensor<8x8x128x128xf32>, tensor<8x8x128x32xf32>) -> "
+        "tensor<8x8x128x32xf32>\n"
+        "  %ctxt{0} = stablehlo.transpose %ctx{0}, dims = [0, 2, 1, 3] : "
+        "(tensor<8x8x128x32xf32>) -> tensor<8x128x8x32xf32>\n"
+        "  %merged{0} = stablehlo.reshape %ctxt{0} : (tensor<8x128x8x32xf32>) "
+        "-> tensor<8x128x256xf32>\n"
+        "  %out{0} = stablehlo.dot_general %merged{0}, %wo{0}, "
+        "contracting_dims = [2] x [0] : (tensor<8x128x256xf32>, "
+        "tensor<256x256xf32>) -> tensor<8x128x256xf32>\n"
+        "  %h{1} = stablehlo.add %h{0}, %out{0} : tensor<8x128x256xf32>\n",
+        i, i + 1);
+  }
+  os << llvm::formatv("  return %h{0} : tensor<8x128x256xf32>\n}\n",
+                      numLayers);
+  return str;
+}
+
+// Prints a while loop at `level` that contains the loop at `level + 1`, down
+// to `depth`, where each body updates the loop carried tensor.
+void printNestedWhile(raw_ostream& os, int64_t level, int64_t depth,
+                      StringRef operand) {
+  std::string indent(2 * (level + 1), ' ');
+  os << llvm::formatv(
+      "{0}%while{1}:2 = stablehlo.while(%iterArg{1} = {2}, %i{1} = %c0) : "
+      "tensor<32x96xf32>, tensor<i32>\n"
+      "{0}  cond {{\n"
+      "{0}  %cmp{1} = stablehlo.compare LT, %i{1}, %c4 : (tensor<i32>, "
+      "tensor<i32>) -> tensor<i1>\n"
+      "{0}  stablehlo.return %cmp{1} : tensor<i1>\n"
+      "{0}} do {{\n"
+      "{0}  %inc{1} = stablehlo.add %i{1}, %c1 : tensor<i32>\n",
+      indent, level, operand);
+  std::string inner = llvm::formatv("%iterArg{0}", level).str();
+  if (level + 1 < depth) {
+    printNestedWhile(os, level + 1, depth, inner);
+    inner = llvm::formatv("%while{0}#0", level + 1).str();
+  }
+  os << llvm::formatv(
+      "{0}  %body{1} = stablehlo.add {2}, {2} : tensor<32x96xf32>\n"
+      "{0}  stablehlo.return %body{1}, %inc{1} : tensor<32x96xf32>, "
+      "tensor<i32>\n"
+      "{0}}\n",
+      indent, level, inner);
+}
+
+// `depth` nested while loops, where the sharding needs to propagate through
+// the data flow edges of every loop.
+std::string generateNestedWhile(int64_t depth) {
+  std::string str(kMesh);
+  llvm::raw_string_ostream os(str);
+  os << "func.func @main(%arg0: tensor<32x96xf32> {sdy.sharding = "
+        "#sdy.sharding<@mesh, [{\"data\"}, {\"model\"}]>}) -> "
+        "tensor<32x96xf32> {\n"
+        "  %c0 = stablehlo.constant dense<0> : tensor<i32>\n"
+        "  %c1 = stablehlo.constant dense<1> : tensor<i32>\n"
+        "  %c4 = stablehlo.constant dense<4> : tensor<i32>\n";
+  printNestedWhile(os, 0, depth, "%arg0");
+  os << "  return %while0#0 : tensor<32x96xf32>\n}\n";
+  return str;
+}
+
+// A single constant with `numUsers` users, each combining it with a
+// differently sharded argument, which stresses constant splitting and the
+// number of ops propagation visits.
+std::string generateConstantFanOut(int64_t numUsers) {
+  std::string str(kMesh);
+  llvm::raw_string_ostream os(str);
+  os << "func.func @main(";
+  for (int64_t i = 0; i < numUsers; ++i) {
+    os << llvm::formatv(
+        "{0}%arg{1}: tensor<64x64xf32> {sdy.sharding = {2}}",
+        i == 0 ? "" : ", ", i, getArgSharding(i));
+  }
+  os << ") -> tensor<64x64xf32> {\n"
+        "  %cst = stablehlo.constant dense<1.000000e+00> : "
+        "tensor<64x64xf32>\n"
+        "  %acc0 = stablehlo.negate %cst : tensor<64x64xf32>\n";
+  for (int64_t i = 0; i < numUsers; ++i) {
+    os << llvm::formatv(
+        "  %use{0} = stablehlo.multiply %cst, %arg{0} : tensor<64x64xf32>\n"
+        "  %acc{1} = stablehlo.add %acc{0}, %use{0} : tensor<64x64xf32>\n",
+        i, i + 1);
+  }
+  os << llvm::formatv("  return %acc{0} : tensor<64x64xf32>\n}\n", numUsers);
+  return str;
+}
+
+// `numGroups` sharding groups of 8 members each, where only the first member
+// of every group is reachable from a sharded argument.
+std::string generateShardingGroups(int64_t numGroups) {
+  constexpr int64_t kGroupSize = 8;
+  std::string str(kMesh);
+  llvm::raw_string_ostream os(str);
+  os << "func.func @main(%arg0: tensor<64x64xf32> {sdy.sharding = "
+        "#sdy.sharding<@mesh, [{\"data\"}, {\"model\"}]>}";
+  for (int64_t i = 0; i < numGroups * kGroupSize; ++i) {
+    os << llvm::formatv(", %in{0}: tensor<64x64xf32>", i);
+  }
+  os << ") -> tensor<64x64xf32> {\n"
+        "  %acc0 = stablehlo.negate %arg0 : tensor<64x64xf32>\n";
+  for (int64_t i = 0; i < numGroups * kGroupSize; ++i) {
+    int64_t groupId = i / kGroupSize;
+    if (i % kGroupSize == 0) {
+      os << llvm::formatv(
+          "  %m{0} = stablehlo.add %arg0, %in{0} : tensor<64x64xf32>\n", i);
+    } else {
+      os << llvm::formatv(
+          "  %m{0} = stablehlo.abs %in{0} : tensor<64x64xf32>\n", i);
+    }
+    os << llvm::formatv(
+        "  sdy.sharding_group %m{0} group_id={1} : tensor<64x64xf32>\n"
+        "  %acc{2} = stablehlo.add %acc{0}, %m{0} : tensor<64x64xf32>\n",
+        i, groupId, i + 1);
+  }
+  os << llvm::formatv("  return %acc{0} : tensor<64x64xf32>\n}\n",
+                      numGroups * kGroupSize);
+  return str;
+}
+
+struct ModuleGenerator {
+  StringRef name;
+  std::function<std::string(int64_t)> generate;
+};
+
+struct Stage {
+  StringRef name;
+  // Whether the stage runs on the imported module, i.e., after the import
+  // pipeline and sharding group import, rather than the generated module.
+  bool runsOnImportedModule;
+  std::function<void(OpPassManager&, const PropagationOptions&)> addPasses;
+};
+
+SmallVector<ModuleGenerator> getModuleGenerators() {
+  return {{"mlp", generateMlp},
+          {"attention", generateAttention},
+          {"nested_while", generateNestedWhile},
+          {"constant_fan_out", generateConstantFanOut},
+          {"sharding_groups", generateShardingGroups}};
+}
+
+SmallVector<Stage> getStages() {
+  return {
+      {"import", /*runsOnImportedModule=*/false,
+       [](OpPassManager& pm, const PropagationOptions& options) {
+         addImportPipeline(pm, options);
+         pm.addPass(createShardingGroupImportPass());
+       }},
+      {"basic", /*runsOnImportedModule=*/true,
+       [](OpPassManager& pm, const PropagationOptions& options) {
+         pm.addPass(createBasicPropagationPass(options));
+       }},
+      {"aggressive", /*runsOnImportedModule=*/true,
+       [](OpPassManager& pm, const PropagationOptions& options) {
+         pm.addPass(createAggressivePropagationPass(options));
+       }},
+      {"op_priority", /*runsOnImportedModule=*/true,
+       [](OpPassManager& pm, const PropagationOptions& options) {
+         pm.addPass(createOpPriorityPropagationPass(options));
+       }},
+      {"user_priority", /*runsOnImportedModule=*/true,
+       [](OpPassManager& pm, const PropagationOptions& options) {
+         pm.addPass(createUserPriorityPropagationPass(options));
+       }},
+      {"pipeline", /*runsOnImportedModule=*/false,
+       [](OpPassManager& pm, const PropagationOptions& options) {
+         addPropagationPipeline(pm, options);
+       }},
+  };
+}
+
+// Runs the passes of `stage` on a clone of `module` and returns the elapsed
+// time, or std::nullopt if the passes failed.
+std::optional<std::chrono::nanoseconds> runStage(ModuleOp module,
+                                                 const Stage& stage) {
+  MLIRContext* context = module.getContext();
+  OwningOpRef<ModuleOp> clone = module.clone();
+  PassManager pm(context);
+  stage.addPasses(pm, PropagationOptions());
+  // Sharding rules are memoized in the context, so we clear them to measure
+  // each run from scratch.
+  clearShardingRuleMemo(context);
+  return timeRun([&]() { return pm.run(*clone); });
+}
+
+int runBenchmarks() {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  applyThreadingFlag(&context);
+
+  BenchmarkTable table(/*nameWidth=*/32, {"size"});
+  table.printHeader();
+  for (const ModuleGenerator& generator : getModuleGenerators()) {
+    OwningOpRef<ModuleOp> module =
+        parseSourceString<ModuleOp>(generator.generate(sizeFlag), &context);
+    if (!module) {
+      llvm::errs() << "failed to parse generated module " << generator.name
+                   << "\n";
+      return 1;
+    }
+
+    OwningOpRef<ModuleOp> importedModule = module->clone();
+    PassManager importPm(&context);
+    getStages().front().addPasses(importPm, PropagationOptions());
+    if (failed(importPm.run(*importedModule))) {
+      llvm::errs() << "failed to import generated module " << generator.name
+                   << "\n";
+      return 1;
+    }
+
+    for (const Stage& stage : getStages()) {
+      std::string name =
+          llvm::formatv("{0}/{1}", generator.name, stage.name).str();
+      if (!shouldRunBenchmark(name)) {
+        continue;
+      }
+      ModuleOp input = stage.runsOnImportedModule ? *importedModule : *module;
+      std::optional<BenchmarkTimings> timings =
+          timeRepeatedly([&]() { return runStage(input, stage); });
+      if (!timings) {
+        llvm::errs() << "failed to run " << name << "\n";
+        return 1;
+      }
+      table.printRow(name, {std::to_string(sizeFlag.getValue())}, *timings);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace sdy
+}  // namespace mlir
+
+int main(int argc, char** argv) {
+  llvm::InitLLVM initLLVM(argc, argv);
+  if (mlir::failed(mlir::sdy::parseBenchmarkCommandLine(
+          argc, argv, "SDY propagation benchmark\n"))) {
+    return 1;
+  }
+  return mlir::sdy::runBenchmarks();
+}
@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstdint>
+#include <string>
+
 #include "llvm/Support/CommandLine.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Pass/PassManager.h"
@@ -50,6 +53,13 @@ void populateExportOptions(ExportOptions& options,
       propOptions.updateNonDivisibleInputOutputShardings;
   options.disableSplitReshardingDimensions =
       propOptions.disableSplitReshardingDimensions;
+  options.minimizeReshardedBytes = propOptions.minimizeReshardedBytes;
+  options.enableReshardChainFusion = propOptions.enableReshardChainFusion;
+  options.enableCollectiveSimplification =
+      propOptions.enableCollectiveSimplification;
+  options.scheduleCollectivesForOverlap =
+      propOptions.scheduleCollectivesForOverlap;
+  options.dumpCollectiveStatistics = propOptions.dumpCollectiveStatistics;
 }
 
 }  // namespace
@@ -57,8 +67,18 @@ void populateExportOptions(ExportOptions& options,
 void addPropagationPipeline(OpPassManager& pm, int& dumpIndex,
                             const PropagationOptions& options) {
   addImportPipeline(pm, dumpIndex, options);
+  bool propagateThroughFuncs =
+      options.dedupFunctionsFully || options.specializeFuncsByShardingContext;
   if (options.dedupFunctionsFully) {  // Aggresive compilation mode.
     pm.addPass(createAddFuncDataFlowEdgesPass());
+  } else if (options.specializeFuncsByShardingContext) {
+    // One copy of each func per sharding signature of its calls, which
+    // `UnflattenCallGraphPass` keeps apart if their shardings still differ
+    // after propagation.
+    pm.addPass(createFlattenCallGraphPass(
+        FlattenCallGraphPassOptions{/*dedupByShardingSignature=*/true}));
+    pm.addPass(createSymbolDCEPass());  // After FlattenCallGraphPass.
+    pm.addPass(createAddFuncDataFlowEdgesPass());
   } else {  // Conservative compilation mode.
     pm.addPass(createFlattenCallGraphPass());
     pm.addPass(createSymbolDCEPass());  // After FlattenCallGraphPass.
@@ -84,19 +104,22 @@ void addPropagationPipeline(OpPassManager& pm, int& dumpIndex,
     pm.addPass(createUserPriorityPropagationPass(optionsWithKeepShardingRules,
                                                  dumpIndex));
   }
-  if (options.dedupFunctionsFully) {  // Aggresive compilation mode.
+  if (propagateThroughFuncs) {
     pm.addPass(createPropagateToFuncResultsPass());
     pm.addNestedPass<func::FuncOp>(createSinkFuncDataFlowEdgesPass());
   } else {  // Conservative compilation mode.
     pm.addPass(createExportNamedComputationsPass());
     pm.addPass(createPropagateToFuncResultsPass());
   }
-  pm.addPass(createUnflattenCallGraphPass());
+  {
+    UnflattenCallGraphPassOptions unflattenOptions;
+    unflattenOptions.dedupIdenticalFunctions = options.dedupIdenticalFunctions;
+    pm.addPass(createUnflattenCallGraphPass(unflattenOptions));
+  }
   pm.addPass(createSymbolDCEPass());  // After UnflattenCallGraphPass.
   if (options.enableAutoPartitioning) {
-    pm.addPass(createSaveModuleOpPass(options.dumpDirectory,
-                                      "propagation_before_auto_partitioning",
-                                      dumpIndex++));
+    addSaveModuleOpPass(pm, options.dumpDirectory,
+                        "propagation_before_auto_partitioning", dumpIndex);
     AutoPartitionerRegistry::addPasses(pm);
   }
   pm.addPass(createInsertFuncCallReshardsPass());
@@ -118,10 +141,102 @@ struct PropagationOptionsOptions
       llvm::cl::desc("Whether to dedup functions fully."),
       llvm::cl::init(false)};
 
+  Option<bool> dedupIdenticalFunctions{
+      *this, "dedup-identical-functions",
+      llvm::cl::desc("Whether to also dedup functions that are structurally "
+                     "equal after propagation."),
+      llvm::cl::init(false)};
+
+  Option<bool> specializeFuncsByShardingContext{
+      *this, "specialize-funcs-by-sharding-context",
+      llvm::cl::desc("Whether to propagate through one copy of each func per "
+                     "distinct sharding signature of its calls."),
+      llvm::cl::init(false)};
+
   Option<bool> disableSplitReshardingDimensions{
       *this, "disable-split-resharding-dimensions",
       llvm::cl::desc("Disable splitting sharded dimensions."),
       llvm::cl::init(false)};
+
+  Option<bool> minimizeReshardedBytes{
+      *this, "minimize-resharded-bytes",
+      llvm::cl::desc("Pick common shardings that minimize the bytes "
+                     "communicated by explicit reshards."),
+      llvm::cl::init(false)};
+
+  Option<bool> enableReshardChainFusion{
+      *this, "enable-reshard-chain-fusion",
+      llvm::cl::desc("Fuse chains of reshards before converting them to "
+                     "collectives."),
+      llvm::cl::init(false)};
+
+  Option<bool> enableCollectiveSimplification{
+      *this, "enable-collective-simplification",
+      llvm::cl::desc("Fold chains of collectives in a single sweep before "
+                     "canonicalizing them."),
+      llvm::cl::init(false)};
+
+  Option<bool> scheduleCollectivesForOverlap{
+      *this, "schedule-collectives-for-overlap",
+      llvm::cl::desc("Schedule explicit collectives as early as possible to "
+                     "overlap them with compute."),
+      llvm::cl::init(false)};
+
+  Option<bool> dumpCollectiveStatistics{
+      *this, "dump-collective-statistics",
+      llvm::cl::desc("Whether to save a JSON report of the collectives in the "
+                     "partitioned module."),
+      llvm::cl::init(false)};
+
+  Option<bool> enableWorklistPropagation{
+      *this, "enable-worklist-propagation",
+      llvm::cl::desc("Whether to propagate with the sharding worklist driver."),
+      llvm::cl::init(false)};
+
+  Option<bool> enableLoopAwarePropagation{
+      *this, "enable-loop-aware-propagation",
+      llvm::cl::desc("Whether to propagate each loop body to a local fixed "
+                     "point before revisiting the ops outside it."),
+      llvm::cl::init(false)};
+
+  Option<std::string> collectiveProfile{
+      *this, "collective-profile",
+      llvm::cl::desc("A JSON file with the measured cost of the collectives "
+                     "caused by op locations, to bias conflict resolution."),
+      llvm::cl::init("")};
+
+  Option<bool> enableParallelFuncPropagation{
+      *this, "enable-parallel-func-propagation",
+      llvm::cl::desc("Whether to propagate independent functions in parallel."),
+      llvm::cl::init(false)};
+
+  Option<bool> enableParallelClusterPropagation{
+      *this, "enable-parallel-cluster-propagation",
+      llvm::cl::desc("Whether to propagate independent clusters of ops within "
+                     "each function in parallel."),
+      llvm::cl::init(false)};
+
+  Option<bool> checkParallelClusterPropagation{
+      *this, "check-parallel-cluster-propagation",
+      llvm::cl::desc("Whether to verify that parallel cluster propagation "
+                     "matches serial propagation."),
+      llvm::cl::init(false)};
+
+  Option<bool> profilePropagation{
+      *this, "profile-propagation",
+      llvm::cl::desc("Whether to save a JSON report of propagation counters."),
+      llvm::cl::init(false)};
+
+  Option<int64_t> propagationEventLogSize{
+      *this, "propagation-event-log-size",
+      llvm::cl::desc("The number of most recent propagation events to record "
+                     "and save on the module as propagation edges."),
+      llvm::cl::init(0)};
+
+  ListOption<std::string> dirtyFuncs{
+      *this, "dirty-funcs",
+      llvm::cl::desc("The funcs whose shardings were edited since the module "
+                     "was last propagated, to seed propagation with.")};
 };
 
 void registerPropagationPipeline() {
@@ -132,8 +247,32 @@ void registerPropagationPipeline() {
       [](OpPassManager& pm, const PropagationOptionsOptions& options) {
         PropagationOptions propOptions;
         propOptions.dedupFunctionsFully = options.dedupFunctionsFully;
+        propOptions.dedupIdenticalFunctions = options.dedupIdenticalFunctions;
+        propOptions.specializeFuncsByShardingContext =
+            options.specializeFuncsByShardingContext;
         propOptions.disableSplitReshardingDimensions =
             options.disableSplitReshardingDimensions;
+        propOptions.minimizeReshardedBytes = options.minimizeReshardedBytes;
+        propOptions.enableReshardChainFusion = options.enableReshardChainFusion;
+        propOptions.enableCollectiveSimplification =
+            options.enableCollectiveSimplification;
+        propOptions.scheduleCollectivesForOverlap =
+            options.scheduleCollectivesForOverlap;
+        propOptions.dumpCollectiveStatistics = options.dumpCollectiveStatistics;
+        propOptions.enableWorklistPropagation =
+            options.enableWorklistPropagation;
+        propOptions.enableLoopAwarePropagation =
+            options.enableLoopAwarePropagation;
+        propOptions.collectiveProfile = options.collectiveProfile;
+        propOptions.enableParallelFuncPropagation =
+            options.enableParallelFuncPropagation;
+        propOptions.enableParallelClusterPropagation =
+            options.enableParallelClusterPropagation;
+        propOptions.checkParallelClusterPropagation =
+            options.checkParallelClusterPropagation;
+        propOptions.profilePropagation = options.profilePropagation;
+        propOptions.propagationEventLogSize = options.propagationEventLogSize;
+        propOptions.dirtyFuncs = options.dirtyFuncs;
         return addPropagationPipeline(pm, propOptions);
       });
 }
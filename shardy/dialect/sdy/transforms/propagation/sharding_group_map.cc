@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <optional>
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
@@ -132,12 +133,18 @@ void ShardingGroupMap::syncGroupMemberShardings(ModuleOp module) {
 }
 
 ValueRange ShardingGroupMap::getGroupMembers(const Value& value) const {
+  if (std::optional<int64_t> groupId = getGroupId(value)) {
+    return getGroupMembersById(*groupId);
+  }
+  return {};
+}
+
+std::optional<int64_t> ShardingGroupMap::getGroupId(const Value& value) const {
   if (auto it = valueToShardingGroup.find(value);
       it != valueToShardingGroup.end()) {
-    int64_t shardingGroupId = it->getSecond();
-    return shardingGroupToValues[shardingGroupId];
+    return it->getSecond();
   }
-  return {};
+  return std::nullopt;
 }
 
 }  // namespace sdy
@@ -17,6 +17,7 @@ limitations under the License.
 #define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_SHARDING_GROUP_MAP_H_
 
 #include <cstdint>
+#include <optional>
 
 #include "llvm/ADT/DenseMap.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -44,6 +45,18 @@ class ShardingGroupMap {
   // (including `value`) or an empty range if none exist.
   ValueRange getGroupMembers(const Value& value) const;
 
+  // Returns the id of the sharding group of `value`, or std::nullopt if
+  // `value` isn't in a sharding group.
+  std::optional<int64_t> getGroupId(const Value& value) const;
+
+  // Returns the members of the sharding group with `groupId`.
+  ValueRange getGroupMembersById(int64_t groupId) const {
+    return shardingGroupToValues[groupId];
+  }
+
+  // Returns true if there are no sharding groups.
+  bool empty() const { return shardingGroupToValues.empty(); }
+
  private:
   SmallVector<SmallVector<Value>> shardingGroupToValues;
   llvm::SmallDenseMap<Value, int64_t> valueToShardingGroup;
@@ -142,11 +142,21 @@ int64_t addAxesToDimSharding(SmallVector<AxisRefAttr>& dimSharding,
 
 TensorShardingAttr TensorFactorShardings::createTensorShardingAttr(
     MLIRContext* ctx, TensorMappingAttr tensorMapping,
-    ArrayRef<int64_t> factorSizes, StringRef meshName, MeshAttr mesh) const {
+    ArrayRef<int64_t> factorSizes, StringRef meshName, MeshAttr mesh,
+    TensorShardingAttr oldSharding) const {
   SmallVector<DimensionShardingAttr> newDimShardings;
   newDimShardings.reserve(tensorMapping.getRank());
 
-  for (DimMappingAttr dimMapping : tensorMapping.getDimMappings()) {
+  if (oldSharding &&
+      (oldSharding.getRank() != tensorMapping.getRank() ||
+       !isa<FlatSymbolRefAttr>(oldSharding.getMeshOrRef()) ||
+       oldSharding.getMeshName() != meshName)) {
+    oldSharding = TensorShardingAttr();
+  }
+  bool allDimShardingsReused = static_cast<bool>(oldSharding);
+
+  for (auto [dim, dimMapping] :
+       llvm::enumerate(tensorMapping.getDimMappings())) {
     bool isClosed = false;
     SmallVector<AxisRefAttr> dimSharding;
     for (int64_t factorIndex : dimMapping.getFactorIndices()) {
@@ -179,12 +189,30 @@ TensorShardingAttr TensorFactorShardings::createTensorShardingAttr(
         break;
       }
     }
+    // Reuse the old dimension sharding if it's unchanged, which avoids
+    // uniquing a new attribute.
+    if (oldSharding) {
+      DimensionShardingAttr oldDimSharding = oldSharding.getDimSharding(dim);
+      if (oldDimSharding.getIsClosed() == isClosed &&
+          !oldDimSharding.getPriority() &&
+          oldDimSharding.getAxes() == ArrayRef(dimSharding)) {
+        newDimShardings.push_back(oldDimSharding);
+        continue;
+      }
+    }
+    allDimShardingsReused = false;
     // If this dimension is fully sharded, we mark it as closed since it can't
     // be further sharded.
     newDimShardings.push_back(
         DimensionShardingAttr::get(ctx, dimSharding, isClosed));
   }
 
+  if (allDimShardingsReused &&
+      oldSharding.getReplicatedAxes() == ArrayRef(replicatedAxes) &&
+      oldSharding.getUnreducedAxes() == ArrayRef(unreducedAxes) &&
+      oldSharding.getReductionOp() == ReductionOp::SUM) {
+    return oldSharding;
+  }
   return TensorShardingAttr::get(ctx, meshName, newDimShardings, replicatedAxes,
                                  unreducedAxes);
 }
@@ -402,6 +430,8 @@ ShardingProjection ShardingProjection::build(
     OpShardingRuleAttr shardingRule, MeshAttr mesh,
     const bool closedIfMissing) {
   ShardingProjection projection;
+  projection.operands.reserve(operandShardings.size());
+  projection.results.reserve(resultShardings.size());
 
   for (const auto& [operandSharding, operandMapping] :
        llvm::zip_equal(operandShardings, shardingRule.getOperandMappings())) {
@@ -431,6 +461,8 @@ ShardingProjection ShardingProjection::build(Operation* op,
 ShardingProjection ShardingProjection::build(AxesPerFactorRef axesPerFactorRef,
                                              OpShardingRuleAttr shardingRule) {
   ShardingProjection projection;
+  projection.operands.reserve(shardingRule.getNumOperands());
+  projection.results.reserve(shardingRule.getNumResults());
   for (const auto& operandMapping : shardingRule.getOperandMappings()) {
     projection.operands.push_back(
         buildTensorFactorShardings(operandMapping, axesPerFactorRef));
@@ -442,6 +474,72 @@ ShardingProjection ShardingProjection::build(AxesPerFactorRef axesPerFactorRef,
   return projection;
 }
 
+ShardingProjection& ShardingProjectionCache::getOrBuild(
+    Operation* op, ArrayRef<TensorShardingAttr> operandShardings,
+    ArrayRef<TensorShardingAttr> resultShardings,
+    OpShardingRuleAttr shardingRule, MeshAttr mesh) {
+  auto [it, inserted] = entries.try_emplace(op);
+  Entry& entry = it->second;
+  if (inserted || entry.shardingRule != shardingRule || entry.mesh != mesh ||
+      entry.operandShardings.size() != operandShardings.size() ||
+      entry.resultShardings.size() != resultShardings.size()) {
+    entry.shardingRule = shardingRule;
+    entry.mesh = mesh;
+    entry.operandShardings.assign(operandShardings.begin(),
+                                  operandShardings.end());
+    entry.resultShardings.assign(resultShardings.begin(),
+                                 resultShardings.end());
+    entry.modifiedOperands.clear();
+    entry.modifiedOperands.resize(operandShardings.size());
+    entry.modifiedResults.clear();
+    entry.modifiedResults.resize(resultShardings.size());
+    entry.projection = ShardingProjection::build(
+        operandShardings, resultShardings, shardingRule, mesh);
+    ++stats.numFullBuilds;
+    return entry.projection;
+  }
+
+  for (auto [index, sharding, mapping] : llvm::enumerate(
+           operandShardings, shardingRule.getOperandMappings())) {
+    if (!entry.modifiedOperands.test(index) &&
+        entry.operandShardings[index] == sharding) {
+      ++stats.numTensorReuses;
+      continue;
+    }
+    entry.operandShardings[index] = sharding;
+    entry.modifiedOperands.reset(index);
+    entry.projection.getMutableOperand(index) = buildTensorFactorShardings(
+        mapping, sharding, shardingRule.getFactorSizes(), mesh,
+        /*closedIfMissing=*/false);
+    ++stats.numTensorRebuilds;
+  }
+  for (auto [index, sharding, mapping] :
+       llvm::enumerate(resultShardings, shardingRule.getResultMappings())) {
+    if (!entry.modifiedResults.test(index) &&
+        entry.resultShardings[index] == sharding) {
+      ++stats.numTensorReuses;
+      continue;
+    }
+    entry.resultShardings[index] = sharding;
+    entry.modifiedResults.reset(index);
+    entry.projection.getMutableResult(index) = buildTensorFactorShardings(
+        mapping, sharding, shardingRule.getFactorSizes(), mesh,
+        /*closedIfMissing=*/false);
+    ++stats.numTensorRebuilds;
+  }
+  return entry.projection;
+}
+
+void ShardingProjectionCache::markUpdated(
+    Operation* op, const UpdateTensorShardings& updated) {
+  auto it = entries.find(op);
+  if (it == entries.end()) {
+    return;
+  }
+  it->second.modifiedOperands |= updated.updateOperands;
+  it->second.modifiedResults |= updated.updateResults;
+}
+
 AxesPerFactor ShardingProjection::getGreatestCommonPrefixAxes(
     int64_t numFactors) const {
   AxesPerFactor factorAxisRefs(numFactors);
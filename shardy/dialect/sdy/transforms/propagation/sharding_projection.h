@@ -16,9 +16,15 @@ limitations under the License.
 #ifndef SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_SHARDING_PROJECTION_H_
 #define SHARDY_DIALECT_SDY_TRANSFORMS_PROPAGATION_SHARDING_PROJECTION_H_
 
+#include <cassert>
 #include <cstdint>
+#include <initializer_list>
+#include <utility>
 
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/Support/LLVM.h"
@@ -70,12 +76,119 @@ struct FactorSharding {
   }
 };
 
-using FactorIndexToSharding = llvm::DenseMap<int64_t, FactorSharding>;
+// A mapping between factor index to the sharding of that factor, for the
+// factors a tensor is associated with.
+//
+// Factor indices are small and contiguous, so the shardings are stored in a
+// vector indexed by factor, with an unmapped slot for each factor the tensor
+// isn't associated with. A lookup is an index instead of a hash probe, and
+// `reserve` sizes the storage once for all factors of an op. Iteration visits
+// the mapped factors in increasing order of factor index.
+class FactorIndexToSharding {
+ public:
+  using value_type = std::pair<int64_t, FactorSharding>;
+
+ private:
+  static constexpr int64_t kUnmapped = -1;
+
+  struct IsMapped {
+    bool operator()(const value_type& slot) const {
+      return slot.first != kUnmapped;
+    }
+  };
+
+  // Not inlined, since a `FactorSharding` is too large to keep a few of them
+  // inside every `TensorFactorShardings`.
+  using Slots = SmallVector<value_type, 0>;
+
+ public:
+  using iterator = llvm::filter_iterator<Slots::iterator, IsMapped>;
+  using const_iterator = llvm::filter_iterator<Slots::const_iterator, IsMapped>;
+
+  FactorIndexToSharding() = default;
+
+  FactorIndexToSharding(std::initializer_list<value_type> entries) {
+    for (const auto& [factorIndex, factorSharding] : entries) {
+      (*this)[factorIndex] = factorSharding;
+    }
+  }
+
+  // Adds an unmapped slot for each of the first `numFactors` factors that
+  // doesn't have one, so that mapping them doesn't reallocate.
+  void reserve(int64_t numFactors) {
+    if (numFactors > static_cast<int64_t>(slots.size())) {
+      slots.resize(numFactors, value_type(kUnmapped, FactorSharding()));
+    }
+  }
+
+  iterator begin() { return makeIterator(slots.begin()); }
+  iterator end() { return makeIterator(slots.end()); }
+  const_iterator begin() const { return makeIterator(slots.begin()); }
+  const_iterator end() const { return makeIterator(slots.end()); }
+
+  int64_t size() const { return numMapped; }
+  bool empty() const { return numMapped == 0; }
+
+  bool contains(int64_t factorIndex) const {
+    return factorIndex >= 0 &&
+           factorIndex < static_cast<int64_t>(slots.size()) &&
+           slots[factorIndex].first != kUnmapped;
+  }
+
+  iterator find(int64_t factorIndex) {
+    return contains(factorIndex) ? makeIterator(slots.begin() + factorIndex)
+                                 : end();
+  }
+  const_iterator find(int64_t factorIndex) const {
+    return contains(factorIndex) ? makeIterator(slots.begin() + factorIndex)
+                                 : end();
+  }
+
+  FactorSharding& at(int64_t factorIndex) {
+    assert(contains(factorIndex) && "factor isn't mapped");
+    return slots[factorIndex].second;
+  }
+  const FactorSharding& at(int64_t factorIndex) const {
+    assert(contains(factorIndex) && "factor isn't mapped");
+    return slots[factorIndex].second;
+  }
+
+  // Returns the sharding of `factorIndex`, which is mapped to an empty
+  // sharding if it isn't mapped already.
+  FactorSharding& operator[](int64_t factorIndex) {
+    assert(factorIndex >= 0 && "negative factor index");
+    reserve(factorIndex + 1);
+    value_type& slot = slots[factorIndex];
+    if (slot.first == kUnmapped) {
+      slot.first = factorIndex;
+      ++numMapped;
+    }
+    return slot.second;
+  }
+
+  bool operator==(const FactorIndexToSharding& other) const {
+    return numMapped == other.numMapped && llvm::equal(*this, other);
+  }
+
+  bool operator!=(const FactorIndexToSharding& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  iterator makeIterator(Slots::iterator it) {
+    return iterator(it, slots.end(), IsMapped());
+  }
+  const_iterator makeIterator(Slots::const_iterator it) const {
+    return const_iterator(it, slots.end(), IsMapped());
+  }
+
+  Slots slots;
+  int64_t numMapped = 0;
+};
 
 // Holds the factor shardings and replicated axes of a tensor.
 struct TensorFactorShardings {
   // A mapping between factor index to the sharding of that factor.
-  // TODO(tomnatan): consider using a vector with null for unmapped factors.
   FactorIndexToSharding factorIndexToSharding;
   SmallVector<AxisRefAttr> replicatedAxes;
   SmallVector<AxisRefAttr> unreducedAxes;
@@ -111,11 +224,15 @@ struct TensorFactorShardings {
   // this `TensorFactorShardings` to dimension shardings w.r.t. `tensorMapping`.
   //
   // Ignores sharding of any factor that needs strided view.
-  TensorShardingAttr createTensorShardingAttr(MLIRContext* ctx,
-                                              TensorMappingAttr tensorMapping,
-                                              ArrayRef<int64_t> factorSizes,
-                                              StringRef meshName,
-                                              MeshAttr mesh) const;
+  //
+  // If `oldSharding` is specified, any of its dimension shardings that match
+  // the projected ones are reused, and `oldSharding` itself is returned if it
+  // matches entirely, so that unchanged shardings aren't looked up again in
+  // the context's attribute uniquer.
+  TensorShardingAttr createTensorShardingAttr(
+      MLIRContext* ctx, TensorMappingAttr tensorMapping,
+      ArrayRef<int64_t> factorSizes, StringRef meshName, MeshAttr mesh,
+      TensorShardingAttr oldSharding = TensorShardingAttr()) const;
 
   // Returns the total sharding size of the tensor across all its factors.
   int64_t getShardingSize(MeshAttr mesh) const;
@@ -275,6 +392,76 @@ class ShardingProjection {
   SmallVector<TensorFactorShardings> results;
 };
 
+// A cache of the `ShardingProjection` of each op, that is kept across
+// propagation steps, such that revisiting an op only rebuilds the factor
+// shardings of operands and results whose sharding has changed since the last
+// visit, instead of rebuilding the entire projection.
+//
+// Since sharding attributes are uniqued, a change to the sharding of any
+// operand or result (which is what triggers revisiting the op in the first
+// place) is detected by comparing the attributes.
+class ShardingProjectionCache {
+ public:
+  // Counters of how the returned projections were obtained.
+  struct Stats {
+    // The number of projections that were built from scratch.
+    int64_t numFullBuilds = 0;
+    // The number of tensors whose factor shardings were rebuilt in a cached
+    // projection.
+    int64_t numTensorRebuilds = 0;
+    // The number of tensors whose cached factor shardings were reused.
+    int64_t numTensorReuses = 0;
+  };
+
+  // Returns the cached `ShardingProjection` of `op`, updated in place for the
+  // given operand and result shardings of `op`, w.r.t. the given
+  // `shardingRule`.
+  //
+  // Reuses the cached factor shardings of every tensor whose sharding is the
+  // same as in the previous call for `op`, and rebuilds the others. The whole
+  // projection is rebuilt if `shardingRule`, `mesh` or the number of tensors
+  // changed.
+  //
+  // The returned reference is invalidated by the next call to any non-const
+  // method. The caller may modify the projection, but must then call
+  // `markUpdated` with the modified tensors.
+  //
+  // An empty and open sharding is created for missing shardings.
+  ShardingProjection& getOrBuild(Operation* op,
+                                 ArrayRef<TensorShardingAttr> operandShardings,
+                                 ArrayRef<TensorShardingAttr> resultShardings,
+                                 OpShardingRuleAttr shardingRule,
+                                 MeshAttr mesh);
+
+  // Marks the tensors in `updated` as modified in the cached projection of
+  // `op`, so that the next call to `getOrBuild` for `op` rebuilds them
+  // regardless of their sharding.
+  void markUpdated(Operation* op, const UpdateTensorShardings& updated);
+
+  // Drops the cached projection of `op`, if any.
+  void erase(Operation* op) { entries.erase(op); }
+
+  void clear() { entries.clear(); }
+
+  const Stats& getStats() const { return stats; }
+
+ private:
+  struct Entry {
+    OpShardingRuleAttr shardingRule;
+    MeshAttr mesh;
+    SmallVector<TensorShardingAttr> operandShardings;
+    SmallVector<TensorShardingAttr> resultShardings;
+    // The tensors whose factor shardings in `projection` were modified by the
+    // caller, and thus don't match their sharding anymore.
+    BitVector modifiedOperands;
+    BitVector modifiedResults;
+    ShardingProjection projection;
+  };
+
+  llvm::DenseMap<Operation*, Entry> entries;
+  Stats stats;
+};
+
 // Redistributes a list of sharding axes among a set of factors. This logic
 // eliminates artificial overflows by allowing axes to span factor boundaries
 // or be skipped by factors they don't perfectly divide.
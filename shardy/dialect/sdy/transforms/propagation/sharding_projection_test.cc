@@ -886,6 +886,50 @@ TEST_F(ShardingProjectionExpandShardingTest, DotGeneralSimple) {
                       ElementsAre(AxisRefIs("d"), AxisRefIs("f")))));
 }
 
+//===----------------------------------------------------------------------===//
+// Tests for FactorIndexToSharding
+//===----------------------------------------------------------------------===//
+
+class FactorIndexToShardingTest : public ShardyTestBase {};
+
+TEST_F(FactorIndexToShardingTest, OnlyMappedFactorsAreVisitedInOrder) {
+  FactorIndexToSharding factorIndexToSharding;
+  factorIndexToSharding.reserve(4);
+  EXPECT_TRUE(factorIndexToSharding.empty());
+
+  factorIndexToSharding[2].axisRefs = {createAxis("a")};
+  factorIndexToSharding[0].isClosed = true;
+  EXPECT_EQ(factorIndexToSharding.size(), 2);
+  EXPECT_TRUE(factorIndexToSharding.contains(0));
+  EXPECT_FALSE(factorIndexToSharding.contains(1));
+  EXPECT_FALSE(factorIndexToSharding.contains(4));
+  EXPECT_EQ(factorIndexToSharding.find(3), factorIndexToSharding.end());
+  EXPECT_EQ(factorIndexToSharding.find(2)->first, 2);
+  EXPECT_THAT(factorIndexToSharding,
+              ElementsAre(FactorShardingIs(/*index*/ 0, /*isClosed*/ true,
+                                           /*isMinorMost*/ false, IsEmpty()),
+                          FactorShardingIs(/*index*/ 2, /*isClosed*/ false,
+                                           /*isMinorMost*/ false,
+                                           ElementsAre(AxisRefIs("a")))));
+
+  // Mapping a factor beyond the reserved ones grows the storage.
+  factorIndexToSharding[5].isMinorMost = true;
+  EXPECT_EQ(factorIndexToSharding.size(), 3);
+  EXPECT_TRUE(factorIndexToSharding.at(5).isMinorMost);
+}
+
+TEST_F(FactorIndexToShardingTest, EqualityIgnoresUnmappedFactors) {
+  FactorIndexToSharding reserved;
+  reserved.reserve(8);
+  reserved[1].axisRefs = {createAxis("a")};
+  FactorIndexToSharding factorIndexToSharding = {
+      {1, {.axisRefs = {createAxis("a")}}}};
+  EXPECT_EQ(reserved, factorIndexToSharding);
+
+  reserved[3];
+  EXPECT_NE(reserved, factorIndexToSharding);
+}
+
 //===----------------------------------------------------------------------===//
 // Tests for IsAxisListPrefixOfTest
 //===----------------------------------------------------------------------===//
@@ -1112,6 +1156,49 @@ TEST_F(TensorFactorShardingsTest,
                                    {createAxis("b"), createAxis("a")})}));
 }
 
+TEST_F(TensorFactorShardingsTest, CreateTensorShardingAttr_ReusesOldSharding) {
+  const std::string program = R"mlir(
+    sdy.mesh @mesh = <["a"=2, "b"=2]>
+
+    func.func @main(%arg0: tensor<8x8xf32>) -> tensor<8x8xf32> {
+      %0 = stablehlo.negate %arg0 : tensor<8x8xf32>
+      return %0 : tensor<8x8xf32>
+    })mlir";
+
+  OwningOpRef<ModuleOp> module = parseSourceString<ModuleOp>(program, &context);
+  ASSERT_TRUE(module);
+  auto op = getFirstOp<stablehlo::NegOp>(module.get());
+  OpShardingRuleAttr shardingRule = getOrCreateShardingRule(op);
+  TensorFactorShardings factorShardings{
+      .factorIndexToSharding = {{0, {.axisRefs = {createAxis("a")}}},
+                                {1, {.axisRefs = {createAxis("b")}}}}};
+  auto createWithOldSharding = [&](TensorShardingAttr oldSharding) {
+    return factorShardings.createTensorShardingAttr(
+        &context, shardingRule.getResultMapping(0),
+        shardingRule.getFactorSizes(), kMeshName, getMeshAttr(module.get()),
+        oldSharding);
+  };
+
+  TensorShardingAttr fullMatch = createTensorSharding(
+      /*dimShardings=*/{openDimSharding({createAxis("a")}),
+                        openDimSharding({createAxis("b")})});
+  EXPECT_EQ(createWithOldSharding(fullMatch), fullMatch);
+
+  TensorShardingAttr partialMatch = createTensorSharding(
+      /*dimShardings=*/{openDimSharding({createAxis("a")}),
+                        openDimSharding({})});
+  verifyShardingAttrsMatch(createWithOldSharding(partialMatch), fullMatch);
+
+  // A dimension sharding with a priority isn't reused, as projected dimension
+  // shardings don't have one.
+  TensorShardingAttr withPriority = createTensorSharding(
+      /*dimShardings=*/{DimensionShardingAttr::get(&context, {createAxis("a")},
+                                                   /*isClosed=*/false,
+                                                   /*priority=*/1),
+                        openDimSharding({createAxis("b")})});
+  verifyShardingAttrsMatch(createWithOldSharding(withPriority), fullMatch);
+}
+
 TEST_F(TensorFactorShardingsTest, ExpandShardingAxes_Expands) {
   const std::string program = R"mlir(
     sdy.mesh @mesh = <["a"=3, "b"=2, "c"=2]>
@@ -1298,6 +1385,120 @@ TEST_F(ShardingProjectionGetGreatestCommonPrefixAxesTest,
               ElementsAre(ElementsAre(AxisRefIs("b"))));
 }
 
+//===----------------------------------------------------------------------===//
+// Tests for ShardingProjectionCache
+//===----------------------------------------------------------------------===//
+
+class ShardingProjectionCacheTest : public ShardyTestBase {};
+
+TEST_F(ShardingProjectionCacheTest, RebuildsOnlyChangedTensors) {
+  const std::string program = R"mlir(
+    sdy.mesh @mesh = <["a"=4, "b"=2, "c"=2]>
+
+    func.func @main(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {?}]>},
+                    %arg1: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{?}, {"b", ?}]>})
+        -> tensor<8x16xf32> {
+      %0 = stablehlo.dot_general %arg0, %arg1, contracting_dims = [1] x [0] :
+        (tensor<8x8xf32>, tensor<8x16xf32>) -> tensor<8x16xf32>
+      return %0 : tensor<8x16xf32>
+    })mlir";
+
+  OwningOpRef<ModuleOp> module = parseSourceString<ModuleOp>(program, &context);
+  ASSERT_TRUE(module);
+  auto op = getFirstOp<stablehlo::DotGeneralOp>(module.get());
+  OpShardingRuleAttr shardingRule = getOrCreateShardingRule(op);
+  ASSERT_TRUE(shardingRule);
+  MeshAttr mesh = getMeshAttr(module.get());
+
+  ShardingProjectionCache cache;
+  SmallVector<TensorShardingAttr> operandShardings =
+      getShardings(op->getOperands());
+  SmallVector<TensorShardingAttr> resultShardings =
+      getShardings(op->getResults());
+  EXPECT_EQ(cache.getOrBuild(op, operandShardings, resultShardings,
+                             shardingRule, mesh),
+            ShardingProjection::build(operandShardings, resultShardings,
+                                      shardingRule, mesh));
+
+  // Update the sharding of the result and verify the cached projection of the
+  // operands is reused, while the result is rebuilt.
+  resultShardings[0] = TensorShardingAttr::get(
+      &context, kMeshName,
+      {DimensionShardingAttr::get(&context, {createAxis("a")},
+                                  /*isClosed=*/false),
+       DimensionShardingAttr::get(&context, {createAxis("c")},
+                                  /*isClosed=*/true)},
+      /*replicatedAxes=*/{}, /*unreducedAxes=*/{});
+  ShardingProjection projection = cache.getOrBuild(
+      op, operandShardings, resultShardings, shardingRule, mesh);
+  EXPECT_EQ(projection, ShardingProjection::build(operandShardings,
+                                                  resultShardings,
+                                                  shardingRule, mesh));
+  EXPECT_THAT(projection.getResult(0).factorIndexToSharding,
+              UnorderedElementsAre(
+                  FactorShardingIs(/*index*/ 0, /*isClosed*/ false,
+                                   /*isMinorMost*/ true,
+                                   ElementsAre(AxisRefIs("a"))),
+                  FactorShardingIs(/*index*/ 1, /*isClosed*/ true,
+                                   /*isMinorMost*/ true,
+                                   ElementsAre(AxisRefIs("c")))));
+}
+
+TEST_F(ShardingProjectionCacheTest, SecondLookupReturnsCachedProjection) {
+  const std::string program = R"mlir(
+    sdy.mesh @mesh = <["a"=4, "b"=2]>
+
+    func.func @main(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {?}]>},
+                    %arg1: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{?}, {"b", ?}]>})
+        -> tensor<8x8xf32> {
+      %0 = stablehlo.add %arg0, %arg1 : tensor<8x8xf32>
+      return %0 : tensor<8x8xf32>
+    })mlir";
+
+  OwningOpRef<ModuleOp> module = parseSourceString<ModuleOp>(program, &context);
+  ASSERT_TRUE(module);
+  auto op = getFirstOp<stablehlo::AddOp>(module.get());
+  OpShardingRuleAttr shardingRule = getOrCreateShardingRule(op);
+  ASSERT_TRUE(shardingRule);
+  MeshAttr mesh = getMeshAttr(module.get());
+  SmallVector<TensorShardingAttr> operandShardings =
+      getShardings(op->getOperands());
+  SmallVector<TensorShardingAttr> resultShardings =
+      getShardings(op->getResults());
+
+  ShardingProjectionCache cache;
+  ShardingProjection* projection = &cache.getOrBuild(
+      op, operandShardings, resultShardings, shardingRule, mesh);
+  EXPECT_EQ(cache.getStats().numFullBuilds, 1);
+
+  // The second lookup returns the same projection, without rebuilding or
+  // copying any of its tensors.
+  EXPECT_EQ(&cache.getOrBuild(op, operandShardings, resultShardings,
+                              shardingRule, mesh),
+            projection);
+  EXPECT_EQ(cache.getStats().numFullBuilds, 1);
+  EXPECT_EQ(cache.getStats().numTensorRebuilds, 0);
+  EXPECT_EQ(cache.getStats().numTensorReuses, 3);
+
+  // A tensor modified in place is rebuilt on the next lookup, even though its
+  // sharding didn't change.
+  UpdateTensorShardings updated = projection->expandSharding(
+      /*factorIndex=*/1, {createAxis("b")});
+  // Expands operand 0 and the result, operand 1 is already sharded by "b".
+  EXPECT_TRUE(updated.updateOperands.test(0));
+  EXPECT_FALSE(updated.updateOperands.test(1));
+  EXPECT_TRUE(updated.updateResults.test(0));
+  cache.markUpdated(op, updated);
+  EXPECT_EQ(&cache.getOrBuild(op, operandShardings, resultShardings,
+                              shardingRule, mesh),
+            projection);
+  EXPECT_EQ(*projection, ShardingProjection::build(operandShardings,
+                                                   resultShardings,
+                                                   shardingRule, mesh));
+  EXPECT_EQ(cache.getStats().numFullBuilds, 1);
+  EXPECT_EQ(cache.getStats().numTensorRebuilds, 2);
+}
+
 }  // namespace
 }  // namespace sdy
 }  // namespace mlir
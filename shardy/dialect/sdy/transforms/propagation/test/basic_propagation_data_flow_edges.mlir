@@ -1,4 +1,6 @@
 // RUN: sdy_opt %s -split-input-file -sdy-basic-propagate 2>&1 | FileCheck %s
+// RUN: sdy_opt %s -split-input-file -sdy-basic-propagate="enable-worklist-propagation=true" 2>&1 | FileCheck %s
+// RUN: sdy_opt %s -split-input-file -sdy-basic-propagate="enable-loop-aware-propagation=true" 2>&1 | FileCheck %s
 
 // Propagation tests for ops with data-flow edges like CaseOp and WhileOp
 
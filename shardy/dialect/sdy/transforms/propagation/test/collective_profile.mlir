@@ -0,0 +1,28 @@
+// RUN: sdy_opt %s -sdy-aggressive-propagate 2>&1 | FileCheck %s --check-prefix=NO-PROFILE
+// RUN: echo '{"rhs": 100, "unused": 5}' > %t.json
+// RUN: sdy_opt %s -sdy-aggressive-propagate="collective-profile=%t.json" 2>&1 | FileCheck %s --check-prefix=PROFILE
+// RUN: not sdy_opt %s -sdy-aggressive-propagate="collective-profile=%t.missing.json" 2>&1 | FileCheck %s --check-prefix=MISSING
+
+sdy.mesh @mesh = <["a"=2]>
+
+// Without a profile, the conflict between the non-contracting factors is
+// resolved in favor of the larger lhs. With a profile, the rhs caused more
+// expensive collectives, so its factor is preferred and the lhs is resharded.
+
+// NO-PROFILE-LABEL: func @conflict_resolved_by_profile
+// NO-PROFILE:         stablehlo.dot_general
+// NO-PROFILE-SAME:      {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a", ?}, {?}]>]>}
+
+// PROFILE-LABEL: func @conflict_resolved_by_profile
+// PROFILE:         stablehlo.dot_general
+// PROFILE-SAME:      {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{?}, {"a", ?}]>]>}
+
+// MISSING: error: failed to read collective profile
+func.func @conflict_resolved_by_profile(
+    %arg0: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>} loc("lhs"),
+    %arg1: tensor<16x4xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"a"}]>} loc("rhs"))
+    -> tensor<8x4xf32> {
+  %0 = stablehlo.dot_general %arg0, %arg1, contracting_dims = [1] x [0] :
+    (tensor<8x16xf32>, tensor<16x4xf32>) -> tensor<8x4xf32>
+  return %0 : tensor<8x4xf32>
+}
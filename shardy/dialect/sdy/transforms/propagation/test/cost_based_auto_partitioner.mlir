@@ -0,0 +1,46 @@
+// RUN: sdy_opt %s -split-input-file -sdy-cost-based-auto-partitioner | FileCheck %s
+// RUN: sdy_opt %s -split-input-file -sdy-cost-based-auto-partitioner="memory-budget-bytes=1024" | FileCheck %s --check-prefix=BUDGET
+
+sdy.mesh @mesh = <["a"=2]>
+
+// Both arguments can be sharded without any communication, since the add is
+// element-wise.
+// CHECK-LABEL: func @elementwise(
+// CHECK-SAME:      %arg0: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", ?}, {?}]>},
+// CHECK-SAME:      %arg1: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", ?}, {?}]>})
+func.func @elementwise(%arg0: tensor<8x16xf32>, %arg1: tensor<8x16xf32>) -> tensor<8x16xf32> {
+  %0 = stablehlo.add %arg0, %arg1 : tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
+
+// -----
+
+sdy.mesh @mesh = <["a"=2]>
+
+// Sharding the contracting dimension would require an all-reduce, so the
+// non-contracting dimensions are sharded instead.
+// CHECK-LABEL: func @dot_general(
+// CHECK-SAME:      %arg0: tensor<8x16xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", ?}, {?}]>},
+// CHECK-SAME:      %arg1: tensor<16x32xf32> {sdy.sharding = #sdy.sharding<@mesh, [{?}, {"a", ?}]>})
+func.func @dot_general(%arg0: tensor<8x16xf32>, %arg1: tensor<16x32xf32>) -> tensor<8x32xf32> {
+  %0 = stablehlo.dot_general %arg0, %arg1, contracting_dims = [1] x [0] : (tensor<8x16xf32>, tensor<16x32xf32>) -> tensor<8x32xf32>
+  return %0 : tensor<8x32xf32>
+}
+
+// -----
+
+sdy.mesh @mesh = <["a"=2]>
+
+// The only dimension of %arg0 is contracted, so sharding it requires an
+// all-reduce, which is only worth it to fit in the memory budget. Arguments
+// that already have a sharding are left as is.
+// CHECK-LABEL: func @over_budget(
+// CHECK-SAME:      %arg0: tensor<512xf32>,
+// CHECK-SAME:      %arg1: tensor<512x2xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {}]>})
+// BUDGET-LABEL: func @over_budget(
+// BUDGET-SAME:      %arg0: tensor<512xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a", ?}]>},
+// BUDGET-SAME:      %arg1: tensor<512x2xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {}]>})
+func.func @over_budget(%arg0: tensor<512xf32>, %arg1: tensor<512x2xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {}]>}) -> tensor<2xf32> {
+  %0 = stablehlo.dot_general %arg0, %arg1, contracting_dims = [0] x [0] : (tensor<512xf32>, tensor<512x2xf32>) -> tensor<2xf32>
+  return %0 : tensor<2xf32>
+}
@@ -0,0 +1,10 @@
+// RUN: not sdy_opt %s -sdy-basic-propagate -sdy-interestingness-scope=sdy-basic-propagate -sdy-interestingness-threshold=0 -o /dev/null
+// RUN: sdy_opt %s -sdy-basic-propagate -sdy-interestingness-scope=sdy-basic-propagate -sdy-interestingness-threshold=1000000 -o /dev/null
+// RUN: sdy_opt %s -sdy-basic-propagate -sdy-interestingness-scope=no-such-scope -o /dev/null
+
+sdy.mesh @mesh = <["a"=2]>
+
+func.func @main(%arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}]>}) -> tensor<8xf32> {
+  %0 = stablehlo.abs %arg0 : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
@@ -0,0 +1,23 @@
+// RUN: rm -rf %t && sdy_opt %s -sdy-user-priority-propagate='module-dump-directory=%t' -o /dev/null
+// RUN: cat %t/*propagation_after_user_priority_0.mlir | FileCheck %s
+
+// RUN: rm -rf %t && sdy_opt %s -sdy-user-priority-propagate='module-dump-directory=%t' --sdy-async-module-dumps -o /dev/null
+// RUN: cat %t/*propagation_after_user_priority_0.mlir | FileCheck %s
+
+// RUN: rm -rf %t && sdy_opt %s -sdy-user-priority-propagate='module-dump-directory=%t' --sdy-bytecode-module-dumps -o /dev/null
+// RUN: sdy_opt %t/*propagation_after_user_priority_0.mlirbc | FileCheck %s
+
+// RUN: rm -rf %t && sdy_opt %s -sdy-user-priority-propagate='module-dump-directory=%t' --sdy-async-module-dumps --sdy-bytecode-module-dumps -o /dev/null
+// RUN: sdy_opt %t/*propagation_after_user_priority_0.mlirbc | FileCheck %s
+
+sdy.mesh @mesh = <["a"=2, "b"=2]>
+
+// CHECK: sdy.mesh @mesh
+// CHECK: func.func @main
+// CHECK: stablehlo.add %arg0, %arg1
+func.func @main(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}p0, {}]>},
+                %arg1: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{}, {"b"}p1]>})
+    -> tensor<8x8xf32> {
+  %0 = stablehlo.add %arg0, %arg1 : tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
@@ -1,4 +1,5 @@
 // RUN: sdy_opt %s -split-input-file -sdy-op-priority-propagate 2>&1 | FileCheck %s
+// RUN: sdy_opt %s -split-input-file -sdy-op-priority-propagate="incremental-op-priority-propagation=true" 2>&1 | FileCheck %s
 
 sdy.mesh @mesh = <["a"=2, "b"=2]>
 
@@ -1,4 +1,5 @@
 // RUN: sdy_opt %s -sdy-populate-op-sharding-rules -verify-diagnostics 2>&1 | FileCheck %s
+// RUN: sdy_opt %s -sdy-populate-op-sharding-rules -verify-diagnostics -mlir-disable-threading 2>&1 | FileCheck %s
 
 // CHECK-LABEL: func @pointwise_op
 func.func @pointwise_op(%arg0: tensor<2x1x4xf32>) -> tensor<2x1x4xf32> {
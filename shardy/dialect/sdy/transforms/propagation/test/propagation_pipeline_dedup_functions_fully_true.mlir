@@ -1,4 +1,5 @@
 // RUN: sdy_opt %s -split-input-file -sdy-propagation-pipeline='dedup-functions-fully=true' | FileCheck %s
+// RUN: sdy_opt %s -split-input-file -sdy-propagation-pipeline='dedup-functions-fully=true enable-worklist-propagation=true' | FileCheck %s
 
 sdy.mesh @mesh = <["a"=2, "b"=2]>
 
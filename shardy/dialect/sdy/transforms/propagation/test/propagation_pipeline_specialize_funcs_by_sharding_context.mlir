@@ -0,0 +1,34 @@
+// RUN: sdy_opt %s -split-input-file -sdy-propagation-pipeline='specialize-funcs-by-sharding-context=true' | FileCheck %s
+
+sdy.mesh @mesh = <["a"=2, "b"=2]>
+
+// Calls with the same operand sharding share a copy of @foo, and the call with
+// a different operand sharding gets its own.
+// CHECK-LABEL: func @main(
+// CHECK-SAME:      %arg0: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>}
+// CHECK-SAME:      %arg1: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"b"}, {}]>}
+func.func @main(%arg0: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>},
+                %arg1: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"b"}, {}]>})
+    -> (tensor<8x2xi32>, tensor<8x2xi32>, tensor<8x2xi32>) {
+  // CHECK-NEXT: call @foo(%arg0) {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a"}, {}]>]>}
+  // CHECK-NEXT: call @foo(%arg0) {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a"}, {}]>]>}
+  // CHECK-NEXT: call @foo_0(%arg1) {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"b"}, {}]>]>}
+  %0 = call @foo(%arg0) : (tensor<8x2xi32>) -> tensor<8x2xi32>
+  %1 = call @foo(%arg0) : (tensor<8x2xi32>) -> tensor<8x2xi32>
+  %2 = call @foo(%arg1) : (tensor<8x2xi32>) -> tensor<8x2xi32>
+  return %0, %1, %2 : tensor<8x2xi32>, tensor<8x2xi32>, tensor<8x2xi32>
+}
+
+// CHECK-LABEL: func private @foo(
+// CHECK-SAME:      %arg0: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>})
+// CHECK-SAME:      -> (tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}, {}]>})
+// CHECK-NEXT:    stablehlo.abs %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"a"}, {}]>]>}
+func.func private @foo(%arg0: tensor<8x2xi32>) -> tensor<8x2xi32> {
+  %0 = stablehlo.abs %arg0 : tensor<8x2xi32>
+  return %0 : tensor<8x2xi32>
+}
+
+// CHECK-LABEL: func private @foo_0(
+// CHECK-SAME:      %arg0: tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"b"}, {}]>})
+// CHECK-SAME:      -> (tensor<8x2xi32> {sdy.sharding = #sdy.sharding<@mesh, [{"b"}, {}]>})
+// CHECK-NEXT:    stablehlo.abs %arg0 {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"b"}, {}]>]>}
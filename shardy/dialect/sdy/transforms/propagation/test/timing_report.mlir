@@ -0,0 +1,17 @@
+// RUN: sdy_opt %s -sdy-user-priority-propagate --sdy-timing-report=%t.json -o /dev/null
+// RUN: FileCheck %s < %t.json
+
+sdy.mesh @mesh = <["a"=2, "b"=2]>
+
+// CHECK:     "peak_rss_bytes":
+// CHECK-DAG: "name": "sdy-user-priority-propagate/build_sharding_groups",
+// CHECK-DAG: "name": "sdy-user-priority-propagate/propagate/user_priority_0",
+// CHECK-DAG: "name": "sdy-user-priority-propagate/propagate/user_priority_1",
+// CHECK-DAG: "name": "sdy-user-priority-propagate/propagate",
+// CHECK-DAG: "name": "sdy-user-priority-propagate",
+// CHECK-DAG: "ir_size": 5
+func.func @main(%arg0: tensor<8x8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"a"}p1, {"b"}]>},
+                %arg1: tensor<8x8xf32>) -> tensor<8x8xf32> {
+  %0 = stablehlo.add %arg0, %arg1 : tensor<8x8xf32>
+  return %0 : tensor<8x8xf32>
+}
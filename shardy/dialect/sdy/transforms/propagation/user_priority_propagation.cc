@@ -36,6 +36,7 @@ limitations under the License.
 #include "mlir/Support/LLVM.h"
 #include "mlir/Support/LogicalResult.h"
 #include "shardy/common/file_utils.h"
+#include "shardy/common/timing_report.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/transforms/common/propagation_options.h"
 #include "shardy/dialect/sdy/transforms/common/sharding_walker.h"
@@ -213,6 +214,10 @@ struct UserPriorityPropagationPass
   explicit UserPriorityPropagationPass(const PropagationOptions& options,
                                        int curDumpIndex) {
     setPropagationOptions(options);
+    incrementalUserPriorityPropagation =
+        options.enableIncrementalUserPriorityPropagation;
+    incrementalOpPriorityPropagation =
+        options.enableIncrementalOpPriorityPropagation;
     this->dumpIndex = curDumpIndex;
   }
 };
@@ -234,19 +239,36 @@ LogicalResult UserPriorityPropagationPassImpl::propagate(
   SmallVector<PriorityShardingReferences> shardingReferencesPerPriority =
       getShardingReferencesPerPriorityAndInitialize(moduleOp, symbolTable);
   // We first run the first iteration (priority 0):
-  if (failed(OpPriorityPropagationPassImpl::propagate(
-          moduleOp, symbolTable, shardingGroupMap, getDirectionToPropagate))) {
-    return failure();
+  {
+    TimingReportScope timingScope("user_priority_0", moduleOp);
+    if (failed(OpPriorityPropagationPassImpl::propagate(
+            moduleOp, symbolTable, shardingGroupMap,
+            getDirectionToPropagate))) {
+      return failure();
+    }
   }
   int64_t prevPriority = 0;
   // Then we run the remaining iterations (priority >0):
   for (const auto& [priority, shardingReferences] :
        shardingReferencesPerPriority) {
     saveModuleOpAfterPriority(moduleOp, dumpDirectory, prevPriority, dumpIndex);
+    TimingReportScope timingScope(
+        llvm::formatv("user_priority_{0}", priority).str(), moduleOp);
     updateReferencedShardingsForPriority(shardingReferences, priority);
-    if (failed(OpPriorityPropagationPassImpl::propagate(
-            moduleOp, symbolTable, shardingGroupMap,
-            getDirectionToPropagate))) {
+    if (incrementalUserPriorityPropagation) {
+      // Only the ops affected by the shardings updated for this priority can
+      // make progress, since everything else already reached a fixed point.
+      setIncrementalFrontier(
+          moduleOp, llvm::map_to_vector(shardingReferences,
+                                        [](const ShardingReference& reference) {
+                                          return reference.valueOrFuncResult;
+                                        }),
+          shardingGroupMap);
+    }
+    LogicalResult result = OpPriorityPropagationPassImpl::propagate(
+        moduleOp, symbolTable, shardingGroupMap, getDirectionToPropagate);
+    clearIncrementalFrontier();
+    if (failed(result)) {
       return failure();
     }
     prevPriority = priority;
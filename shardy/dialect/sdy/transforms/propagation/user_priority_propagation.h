@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 
+#include "llvm/Support/CommandLine.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/SymbolTable.h"
 #include "mlir/Pass/Pass.h"
@@ -42,6 +43,14 @@ class UserPriorityPropagationPassImpl : public OpPriorityPropagationPassImpl {
       const ShardingGroupMap& shardingGroupMap,
       GetDirectionToPropagateFn getDirectionToPropagate) override;
 
+  Option<bool> incrementalUserPriorityPropagation = {
+      *this, "incremental-user-priority-propagation",
+      llvm::cl::desc(
+          "whether to seed each user-priority iteration (other than the first) "
+          "only with the ops affected by the shardings updated for that "
+          "priority, instead of re-propagating the entire module"),
+      llvm::cl::init(false)};
+
   // Current module dump index.
   int dumpIndex = 0;
 };
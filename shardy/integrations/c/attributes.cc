@@ -18,12 +18,22 @@ limitations under the License.
 #include <cstdint>
 #include <optional>
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "mlir-c/IR.h"
 #include "mlir-c/Support.h"
 #include "mlir/CAPI/IR.h"
 #include "mlir/CAPI/Support.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Visitors.h"
 #include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/constants.h"
 #include "shardy/dialect/sdy/ir/dialect.h"
 
 namespace {
@@ -243,6 +253,222 @@ MlirAttribute sdyTensorShardingAttrGetUnreducedAxesElem(MlirAttribute attr,
       unwrapAttr<sdy::TensorShardingAttr>(attr).getUnreducedAxes()[pos]);
 }
 
+//===----------------------------------------------------------------------===//
+// Bulk TensorShardingAttr construction and queries
+//===----------------------------------------------------------------------===//
+
+void sdyTensorShardingAttrGetBulk(
+    MlirContext ctx, MlirAttribute meshOrRef, MlirAttribute mesh,
+    intptr_t nShardings, const intptr_t* ranks, const intptr_t* numAxesPerDim,
+    const bool* isClosedPerDim, const int64_t* priorityPerDim,
+    const int64_t* axisIndices, const int64_t* subAxisPreSizes,
+    const int64_t* subAxisSizes, MlirAttribute* shardings) {
+  mlir::MLIRContext* context = unwrap(ctx);
+  mlir::Attribute unwrappedMeshOrRef = unwrap(meshOrRef);
+  mlir::ArrayRef<sdy::MeshAxisAttr> meshAxes =
+      unwrapAttr<sdy::MeshAttr>(mesh).getAxes();
+  // Full axes are by far the most common, so they are only created once.
+  mlir::SmallVector<sdy::AxisRefAttr> fullAxisRefs =
+      llvm::map_to_vector(meshAxes, [&](sdy::MeshAxisAttr meshAxis) {
+        return sdy::AxisRefAttr::get(context, meshAxis.getName());
+      });
+
+  intptr_t dimIndex = 0;
+  intptr_t axisIndex = 0;
+  mlir::SmallVector<sdy::DimensionShardingAttr> dimShardings;
+  mlir::SmallVector<sdy::AxisRefAttr> axisRefs;
+  for (intptr_t i = 0; i < nShardings; ++i) {
+    dimShardings.clear();
+    for (intptr_t dim = 0; dim < ranks[i]; ++dim, ++dimIndex) {
+      axisRefs.clear();
+      for (intptr_t axis = 0; axis < numAxesPerDim[dimIndex];
+           ++axis, ++axisIndex) {
+        int64_t meshAxisIndex = axisIndices[axisIndex];
+        if (subAxisSizes == nullptr || subAxisSizes[axisIndex] == -1) {
+          axisRefs.push_back(fullAxisRefs[meshAxisIndex]);
+          continue;
+        }
+        axisRefs.push_back(sdy::AxisRefAttr::get(
+            context, meshAxes[meshAxisIndex].getName(),
+            subAxisPreSizes[axisIndex], subAxisSizes[axisIndex]));
+      }
+      int64_t priority =
+          priorityPerDim == nullptr ? -1 : priorityPerDim[dimIndex];
+      dimShardings.push_back(sdy::DimensionShardingAttr::get(
+          context, axisRefs, isClosedPerDim[dimIndex],
+          priority == -1 ? std::nullopt : std::make_optional(priority)));
+    }
+    shardings[i] = wrap(sdy::TensorShardingAttr::get(
+        context, unwrappedMeshOrRef, dimShardings,
+        /*replicatedAxes=*/{}, /*unreducedAxes=*/{}));
+  }
+}
+
+void sdyTensorShardingAttrBulkGetSizes(intptr_t nShardings,
+                                       const MlirAttribute* shardings,
+                                       intptr_t* nDims, intptr_t* nAxes) {
+  *nDims = 0;
+  *nAxes = 0;
+  for (sdy::TensorShardingAttr sharding :
+       unwrapAttrs<sdy::TensorShardingAttr>(shardings, nShardings)) {
+    *nDims += sharding.getRank();
+    for (sdy::DimensionShardingAttr dimSharding : sharding.getDimShardings()) {
+      *nAxes += dimSharding.getAxes().size();
+    }
+  }
+}
+
+void sdyTensorShardingAttrBulkGetFields(
+    const MlirAttribute* meshes, intptr_t nShardings,
+    const MlirAttribute* shardings, intptr_t* ranks, intptr_t* numAxesPerDim,
+    bool* isClosedPerDim, int64_t* priorityPerDim, int64_t* axisIndices,
+    int64_t* subAxisPreSizes, int64_t* subAxisSizes) {
+  // Shardings usually share a few meshes, so only rebuild the axis map when
+  // the mesh changes.
+  sdy::MeshAttr currentMesh;
+  llvm::StringMap<int64_t> axisNameToIndex;
+
+  intptr_t dimIndex = 0;
+  intptr_t axisIndex = 0;
+  for (auto [i, sharding] : llvm::enumerate(
+           unwrapAttrs<sdy::TensorShardingAttr>(shardings, nShardings))) {
+    auto mesh = mlir::cast_or_null<sdy::MeshAttr>(unwrap(meshes[i]));
+    if (i == 0 || mesh != currentMesh) {
+      currentMesh = mesh;
+      axisNameToIndex.clear();
+      if (mesh) {
+        for (auto [index, meshAxis] : llvm::enumerate(mesh.getAxes())) {
+          axisNameToIndex[meshAxis.getName()] = index;
+        }
+      }
+    }
+    ranks[i] = sharding.getRank();
+    for (sdy::DimensionShardingAttr dimSharding : sharding.getDimShardings()) {
+      numAxesPerDim[dimIndex] = dimSharding.getAxes().size();
+      isClosedPerDim[dimIndex] = dimSharding.getIsClosed();
+      priorityPerDim[dimIndex] = dimSharding.getPriority().value_or(-1);
+      ++dimIndex;
+      for (sdy::AxisRefAttr axisRef : dimSharding.getAxes()) {
+        auto axisIt = axisNameToIndex.find(axisRef.getName());
+        axisIndices[axisIndex] =
+            axisIt == axisNameToIndex.end() ? -1 : axisIt->getValue();
+        if (sdy::SubAxisInfoAttr subAxisInfo = axisRef.getSubAxisInfo()) {
+          subAxisPreSizes[axisIndex] = subAxisInfo.getPreSize();
+          subAxisSizes[axisIndex] = subAxisInfo.getSize();
+        } else {
+          subAxisPreSizes[axisIndex] = -1;
+          subAxisSizes[axisIndex] = -1;
+        }
+        ++axisIndex;
+      }
+    }
+  }
+}
+
+void sdyFuncOpGetArgAndResultShardings(MlirOperation funcOp,
+                                       MlirAttribute* argShardings,
+                                       MlirAttribute* resultShardings) {
+  auto unwrappedFuncOp = mlir::cast<mlir::func::FuncOp>(unwrap(funcOp));
+  for (int64_t i = 0; i < unwrappedFuncOp.getNumArguments(); ++i) {
+    argShardings[i] = wrap(unwrappedFuncOp.getArgAttrOfType<
+                           sdy::TensorShardingAttr>(i, sdy::kShardingAttr));
+  }
+  for (int64_t i = 0; i < unwrappedFuncOp.getNumResults(); ++i) {
+    resultShardings[i] = wrap(unwrappedFuncOp.getResultAttrOfType<
+                              sdy::TensorShardingAttr>(i, sdy::kShardingAttr));
+  }
+}
+
+namespace {
+
+// Calls `callback` on the sharding of every value in `op` and its nested ops
+// that has one, in pre-order, along with the op that holds it.
+void forEachSharding(
+    mlir::Operation* op,
+    llvm::function_ref<void(sdy::TensorShardingAttr, mlir::Operation*)>
+        callback) {
+  op->walk<mlir::WalkOrder::PreOrder>([&](mlir::Operation* nestedOp) {
+    if (auto funcOp = mlir::dyn_cast<mlir::func::FuncOp>(nestedOp)) {
+      for (int64_t i = 0; i < funcOp.getNumArguments(); ++i) {
+        if (auto sharding = funcOp.getArgAttrOfType<sdy::TensorShardingAttr>(
+                i, sdy::kShardingAttr)) {
+          callback(sharding, funcOp);
+        }
+      }
+      for (int64_t i = 0; i < funcOp.getNumResults(); ++i) {
+        if (auto sharding =
+                funcOp.getResultAttrOfType<sdy::TensorShardingAttr>(
+                    i, sdy::kShardingAttr)) {
+          callback(sharding, funcOp);
+        }
+      }
+      return;
+    }
+    if (auto shardingPerValue =
+            nestedOp->getAttrOfType<sdy::TensorShardingPerValueAttr>(
+                sdy::kShardingAttr)) {
+      for (sdy::TensorShardingAttr sharding : shardingPerValue.getShardings()) {
+        callback(sharding, nestedOp);
+      }
+      return;
+    }
+    if (auto sharding = nestedOp->getAttrOfType<sdy::TensorShardingAttr>(
+            sdy::kShardingAttr)) {
+      callback(sharding, nestedOp);
+      return;
+    }
+    // Ops like `sdy.sharding_constraint` and `sdy.reshard` hold the sharding of
+    // their result in an inherent attribute.
+    sdy::TensorShardingAttr sharding;
+    if (auto constraintOp =
+            mlir::dyn_cast<sdy::ShardingConstraintOp>(nestedOp)) {
+      sharding = constraintOp.getSharding();
+    } else if (auto reshardOp = mlir::dyn_cast<sdy::ReshardOp>(nestedOp)) {
+      sharding = reshardOp.getSharding();
+    } else if (auto edgeOp = mlir::dyn_cast<sdy::DataFlowEdgeOp>(nestedOp)) {
+      sharding = edgeOp.getShardingAttr();
+    }
+    if (sharding) {
+      callback(sharding, nestedOp);
+    }
+  });
+}
+
+}  // namespace
+
+intptr_t sdyOperationGetNumShardings(MlirOperation op) {
+  intptr_t numShardings = 0;
+  forEachSharding(unwrap(op), [&](sdy::TensorShardingAttr, mlir::Operation*) {
+    ++numShardings;
+  });
+  return numShardings;
+}
+
+void sdyOperationGetShardings(MlirOperation op, MlirAttribute* shardings) {
+  forEachSharding(unwrap(op),
+                  [&](sdy::TensorShardingAttr sharding, mlir::Operation*) {
+                    *shardings++ = wrap(sharding);
+                  });
+}
+
+void sdyOperationGetShardingMeshes(MlirOperation op, MlirAttribute* meshes) {
+  // Cache the symbol tables, as looking up each mesh from scratch would scan
+  // the module for every sharding.
+  mlir::SymbolTableCollection symbolTables;
+  forEachSharding(unwrap(op), [&](sdy::TensorShardingAttr sharding,
+                                  mlir::Operation* owner) {
+    mlir::Attribute meshOrRef = sharding.getMeshOrRef();
+    auto mesh = mlir::dyn_cast<sdy::MeshAttr>(meshOrRef);
+    if (!mesh) {
+      if (auto meshOp = symbolTables.lookupNearestSymbolFrom<sdy::MeshOp>(
+              owner, mlir::cast<mlir::FlatSymbolRefAttr>(meshOrRef))) {
+        mesh = meshOp.getMesh();
+      }
+    }
+    *meshes++ = wrap(mesh);
+  });
+}
+
 //===----------------------------------------------------------------------===//
 // TensorShardingPerValueAttr
 //===----------------------------------------------------------------------===//
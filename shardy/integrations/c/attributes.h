@@ -154,6 +154,76 @@ sdyTensorShardingAttrGetUnreducedAxesSize(MlirAttribute attr);
 MLIR_CAPI_EXPORTED MlirAttribute
 sdyTensorShardingAttrGetUnreducedAxesElem(MlirAttribute attr, intptr_t pos);
 
+//===----------------------------------------------------------------------===//
+// Bulk TensorShardingAttr construction and queries
+//===----------------------------------------------------------------------===//
+
+// Creates `nShardings` TensorShardingAttrs with `meshOrRef` and no replicated
+// or unreduced axes from flat arrays, and writes them to `shardings`.
+//
+// `ranks[i]` is the number of dimensions of the i-th sharding. The dimensions
+// of all shardings are concatenated in `numAxesPerDim`, `isClosedPerDim` and
+// `priorityPerDim` (-1 if the dimension has no priority), and the axes of all
+// dimensions are concatenated in `axisIndices` (the index of the axis in
+// `mesh`), `subAxisPreSizes` and `subAxisSizes` (-1 if the axis is a full
+// axis).
+//
+// NOTE: `priorityPerDim` can be null if no dimension has a priority, and
+// `subAxisPreSizes` and `subAxisSizes` can be null if there are no sub-axes.
+// The sizes of the arrays and the axis indices aren't checked, so callers must
+// validate them first.
+MLIR_CAPI_EXPORTED void sdyTensorShardingAttrGetBulk(
+    MlirContext ctx, MlirAttribute meshOrRef, MlirAttribute mesh,
+    intptr_t nShardings, const intptr_t* ranks, const intptr_t* numAxesPerDim,
+    const bool* isClosedPerDim, const int64_t* priorityPerDim,
+    const int64_t* axisIndices, const int64_t* subAxisPreSizes,
+    const int64_t* subAxisSizes, MlirAttribute* shardings);
+
+// Writes the total number of dimensions and axes in the dimension shardings of
+// `shardings` to `nDims` and `nAxes`, i.e., the sizes of the per-dimension and
+// per-axis buffers of `sdyTensorShardingAttrBulkGetFields`.
+MLIR_CAPI_EXPORTED void sdyTensorShardingAttrBulkGetSizes(
+    intptr_t nShardings, const MlirAttribute* shardings, intptr_t* nDims,
+    intptr_t* nAxes);
+
+// Writes the dimension shardings of `shardings` to flat arrays, in the same
+// format as `sdyTensorShardingAttrGetBulk`, where the axis indices of the i-th
+// sharding are w.r.t. the `MeshAttr` `meshes[i]` (-1 if the axis isn't in that
+// mesh, or if `meshes[i]` is null). Replicated and unreduced axes aren't
+// written.
+MLIR_CAPI_EXPORTED void sdyTensorShardingAttrBulkGetFields(
+    const MlirAttribute* meshes, intptr_t nShardings,
+    const MlirAttribute* shardings, intptr_t* ranks, intptr_t* numAxesPerDim,
+    bool* isClosedPerDim, int64_t* priorityPerDim, int64_t* axisIndices,
+    int64_t* subAxisPreSizes, int64_t* subAxisSizes);
+
+// Writes the TensorShardingAttr of each argument and result of the
+// `func.func` op `funcOp` to `argShardings` and `resultShardings`, whose sizes
+// should be the number of arguments and results respectively.
+//
+// NOTE: Attr is null for arguments and results without a sharding.
+MLIR_CAPI_EXPORTED void sdyFuncOpGetArgAndResultShardings(
+    MlirOperation funcOp, MlirAttribute* argShardings,
+    MlirAttribute* resultShardings);
+
+// Returns the number of shardings written by `sdyOperationGetShardings`.
+MLIR_CAPI_EXPORTED intptr_t sdyOperationGetNumShardings(MlirOperation op);
+
+// Writes the shardings of all values in `op` and its nested ops that have one
+// to `shardings`, in pre-order. The shardings of a `func.func` are those of its
+// arguments followed by those of its results, and the shardings of any other
+// op are those in its `TensorShardingPerValueAttr`, or its single
+// `TensorShardingAttr`, e.g., the sharding of an `sdy.sharding_constraint` or
+// `sdy.reshard`.
+MLIR_CAPI_EXPORTED void sdyOperationGetShardings(MlirOperation op,
+                                                 MlirAttribute* shardings);
+
+// Writes the `MeshAttr` of each sharding written by `sdyOperationGetShardings`
+// to `meshes`, in the same order. A mesh referenced by name is looked up from
+// the op that holds the sharding, and is null if it can't be found.
+MLIR_CAPI_EXPORTED void sdyOperationGetShardingMeshes(MlirOperation op,
+                                                      MlirAttribute* meshes);
+
 //===----------------------------------------------------------------------===//
 // TensorShardingPerValueAttr
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,102 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/integrations/c/attributes.h"
+
+#include <cstdint>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir-c/IR.h"
+#include "mlir/AsmParser/AsmParser.h"
+#include "mlir/CAPI/IR.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+class AttributesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    context.loadDialect<mlir::func::FuncDialect, mlir::sdy::SdyDialect>();
+  }
+
+  mlir::sdy::TensorShardingAttr parseSharding(llvm::StringRef sharding) {
+    return mlir::cast<mlir::sdy::TensorShardingAttr>(
+        mlir::parseAttribute(sharding, &context));
+  }
+
+  mlir::MLIRContext context;
+};
+
+TEST_F(AttributesTest, OperationGetShardingsIncludesSingleShardings) {
+  mlir::OwningOpRef<mlir::ModuleOp> module =
+      mlir::parseSourceString<mlir::ModuleOp>(R"mlir(
+sdy.mesh @mesh = <["x"=2]>
+
+func.func @main(%arg0: tensor<8xf32> {sdy.sharding = #sdy.sharding<@mesh, [{"x"}]>}) -> tensor<8xf32> {
+  %0 = sdy.sharding_constraint %arg0 <@mesh, [{}]> : tensor<8xf32>
+  %1 = sdy.reshard %0 <@mesh, [{"x"}]> : tensor<8xf32>
+  return %1 : tensor<8xf32>
+}
+)mlir",
+                                              &context);
+  ASSERT_TRUE(module);
+  MlirOperation op = wrap(module->getOperation());
+
+  ASSERT_EQ(sdyOperationGetNumShardings(op), 3);
+  llvm::SmallVector<MlirAttribute> shardings(3);
+  sdyOperationGetShardings(op, shardings.data());
+  EXPECT_EQ(unwrap(shardings[0]),
+            parseSharding(R"(#sdy.sharding<@mesh, [{"x"}]>)"));
+  EXPECT_EQ(unwrap(shardings[1]),
+            parseSharding(R"(#sdy.sharding<@mesh, [{}]>)"));
+  EXPECT_EQ(unwrap(shardings[2]),
+            parseSharding(R"(#sdy.sharding<@mesh, [{"x"}]>)"));
+
+  llvm::SmallVector<MlirAttribute> meshes(3);
+  sdyOperationGetShardingMeshes(op, meshes.data());
+  for (MlirAttribute mesh : meshes) {
+    EXPECT_TRUE(mlir::isa_and_present<mlir::sdy::MeshAttr>(unwrap(mesh)));
+  }
+}
+
+TEST_F(AttributesTest, OperationGetShardingsIncludesShardingPerValue) {
+  mlir::OwningOpRef<mlir::ModuleOp> module =
+      mlir::parseSourceString<mlir::ModuleOp>(R"mlir(
+sdy.mesh @mesh = <["x"=2]>
+
+func.func @main(%arg0: tensor<8xf32>) -> tensor<8xf32> {
+  %0 = sdy.constant {sdy.sharding = #sdy.sharding_per_value<[<@mesh, [{"x"}]>]>} dense<0.0> : tensor<8xf32>
+  return %0 : tensor<8xf32>
+}
+)mlir",
+                                              &context);
+  ASSERT_TRUE(module);
+  MlirOperation op = wrap(module->getOperation());
+
+  ASSERT_EQ(sdyOperationGetNumShardings(op), 1);
+  MlirAttribute sharding;
+  sdyOperationGetShardings(op, &sharding);
+  EXPECT_EQ(unwrap(sharding),
+            parseSharding(R"(#sdy.sharding<@mesh, [{"x"}]>)"));
+}
+
+}  // namespace
@@ -15,8 +15,45 @@ limitations under the License.
 
 #include "shardy/integrations/c/passes.h"
 
+#include "mlir-c/IR.h"
+#include "mlir-c/Support.h"
+#include "mlir/CAPI/IR.h"
+#include "mlir/CAPI/Support.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/dialect/sdy/transforms/passes.h"
+#include "shardy/dialect/sdy/transforms/propagation/op_sharding_rule_registry.h"
+
+namespace {
+
+namespace sdy = mlir::sdy;
+
+sdy::ShardingRuleGenerator toShardingRuleGenerator(
+    MlirSdyShardingRuleCallback callback, void* userData) {
+  return [callback, userData](mlir::Operation* op,
+                              bool conservativePropagation) {
+    return mlir::cast_or_null<sdy::OpShardingRuleAttr>(
+        unwrap(callback(wrap(op), conservativePropagation, userData)));
+  };
+}
+
+}  // namespace
 
 void mlirRegisterAllSdyPassesAndPipelines() {
   mlir::sdy::registerAllSdyPassesAndPipelines();
 }
+
+void mlirSdyRegisterCustomCallShardingRule(
+    MlirStringRef callTargetName, MlirSdyShardingRuleCallback callback,
+    void* userData) {
+  sdy::registerCustomCallShardingRule(
+      unwrap(callTargetName), toShardingRuleGenerator(callback, userData));
+}
+
+void mlirSdyRegisterOpShardingRule(MlirStringRef opName,
+                                   MlirSdyShardingRuleCallback callback,
+                                   void* userData) {
+  sdy::registerOpShardingRule(unwrap(opName),
+                              toShardingRuleGenerator(callback, userData));
+}
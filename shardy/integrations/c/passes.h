@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef SHARDY_INTEGRATIONS_C_PASSES_H_
 #define SHARDY_INTEGRATIONS_C_PASSES_H_
 
+#include <stdbool.h>
+
+#include "mlir-c/IR.h"
 #include "mlir-c/Support.h"
 
 #ifdef __cplusplus
@@ -25,6 +28,25 @@ extern "C" {
 /// Register all compiler passes and pipelines of Shardy.
 MLIR_CAPI_EXPORTED void mlirRegisterAllSdyPassesAndPipelines();
 
+/// Creates the `OpShardingRuleAttr` of `op`, or returns a null attribute if the
+/// op shouldn't be propagated through. `userData` is the pointer that was
+/// passed when registering the callback.
+typedef MlirAttribute (*MlirSdyShardingRuleCallback)(
+    MlirOperation op, bool conservativePropagation, void* userData);
+
+/// Registers `callback` as the sharding rule of `stablehlo.custom_call` ops
+/// whose call target is `callTargetName`. `userData` must outlive all uses of
+/// the callback.
+MLIR_CAPI_EXPORTED void mlirSdyRegisterCustomCallShardingRule(
+    MlirStringRef callTargetName, MlirSdyShardingRuleCallback callback,
+    void* userData);
+
+/// Registers `callback` as the sharding rule of all ops named `opName`.
+/// `userData` must outlive all uses of the callback.
+MLIR_CAPI_EXPORTED void mlirSdyRegisterOpShardingRule(
+    MlirStringRef opName, MlirSdyShardingRuleCallback callback,
+    void* userData);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,25 +13,33 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "llvm/ADT/STLExtras.h"
 #include "mlir-c/BuiltinAttributes.h"
+#include "mlir-c/BuiltinTypes.h"
 #include "mlir-c/IR.h"
 #include "mlir-c/Support.h"
 #include "mlir/Bindings/Python/NanobindAdaptors.h"  // IWYU pragma: keep
 #include "nanobind/nanobind.h"
+#include "nanobind/ndarray.h"
 #include "nanobind/stl/optional.h"  // IWYU pragma: keep
+#include "nanobind/stl/pair.h"      // IWYU pragma: keep
 #include "nanobind/stl/string.h"    // IWYU pragma: keep
 #include "nanobind/stl/variant.h"   // IWYU pragma: keep
 #include "nanobind/stl/vector.h"    // IWYU pragma: keep
 #include "shardy/dialect/sdy/ir/dialect.h"
 #include "shardy/integrations/c/attributes.h"
 #include "shardy/integrations/c/dialect.h"
+#include "shardy/integrations/c/passes.h"
 
 namespace mlir {
 namespace sdy {
@@ -63,6 +71,71 @@ MlirStringRef toStringRef(const std::string& s) {
   return mlirStringRefCreate(s.c_str(), s.size());
 }
 
+// Returns a 1D NumPy array that takes ownership of `data` instead of copying
+// it.
+template <typename T>
+nb::object toNumpyArray(std::unique_ptr<T[]> data, size_t size) {
+  T* ptr = data.release();
+  nb::capsule owner(ptr, [](void* p) noexcept { delete[] static_cast<T*>(p); });
+  return nb::cast(nb::ndarray<nb::numpy, T, nb::ndim<1>>(ptr, {size}, owner));
+}
+
+// Returns the dimension shardings of `shardings` as a dict of flat NumPy
+// arrays, in the format of `sdyTensorShardingAttrBulkGetFields`, where
+// `meshes[i]` is the mesh of the i-th sharding, or null if it's unknown.
+//
+// The distinct meshes are returned in `meshes`, and `mesh_indices` holds the
+// index of the mesh of each sharding in it (-1 if unknown).
+nb::dict getShardingArrays(const std::vector<MlirAttribute>& shardings,
+                           const std::vector<MlirAttribute>& meshes) {
+  std::vector<MlirAttribute> distinctMeshes;
+  auto meshIndices = std::make_unique<int64_t[]>(shardings.size());
+  for (auto [i, mesh] : llvm::enumerate(meshes)) {
+    if (mlirAttributeIsNull(mesh)) {
+      meshIndices[i] = -1;
+      continue;
+    }
+    // There are usually only a few meshes, so a linear search is enough.
+    auto it = llvm::find_if(distinctMeshes, [&](MlirAttribute other) {
+      return mlirAttributeEqual(mesh, other);
+    });
+    meshIndices[i] = it - distinctMeshes.begin();
+    if (it == distinctMeshes.end()) {
+      distinctMeshes.push_back(mesh);
+    }
+  }
+
+  intptr_t nDims = 0;
+  intptr_t nAxes = 0;
+  sdyTensorShardingAttrBulkGetSizes(shardings.size(), shardings.data(), &nDims,
+                                    &nAxes);
+  auto ranks = std::make_unique<intptr_t[]>(shardings.size());
+  auto numAxesPerDim = std::make_unique<intptr_t[]>(nDims);
+  auto isClosedPerDim = std::make_unique<bool[]>(nDims);
+  auto priorityPerDim = std::make_unique<int64_t[]>(nDims);
+  auto axisIndices = std::make_unique<int64_t[]>(nAxes);
+  auto subAxisPreSizes = std::make_unique<int64_t[]>(nAxes);
+  auto subAxisSizes = std::make_unique<int64_t[]>(nAxes);
+  sdyTensorShardingAttrBulkGetFields(
+      meshes.data(), shardings.size(), shardings.data(), ranks.get(),
+      numAxesPerDim.get(), isClosedPerDim.get(), priorityPerDim.get(),
+      axisIndices.get(), subAxisPreSizes.get(), subAxisSizes.get());
+
+  nb::dict result;
+  result["meshes"] = distinctMeshes;
+  result["mesh_indices"] =
+      toNumpyArray(std::move(meshIndices), shardings.size());
+  result["ranks"] = toNumpyArray(std::move(ranks), shardings.size());
+  result["num_axes_per_dim"] = toNumpyArray(std::move(numAxesPerDim), nDims);
+  result["is_closed_per_dim"] = toNumpyArray(std::move(isClosedPerDim), nDims);
+  result["priority_per_dim"] = toNumpyArray(std::move(priorityPerDim), nDims);
+  result["axis_indices"] = toNumpyArray(std::move(axisIndices), nAxes);
+  result["sub_axis_pre_sizes"] =
+      toNumpyArray(std::move(subAxisPreSizes), nAxes);
+  result["sub_axis_sizes"] = toNumpyArray(std::move(subAxisSizes), nAxes);
+  return result;
+}
+
 MlirAttribute toMeshOrRefAttr(
     MlirContext ctx,
     const std::variant<std::string, MlirAttribute>& meshOrRef) {
@@ -72,6 +145,88 @@ MlirAttribute toMeshOrRefAttr(
   return std::get<MlirAttribute>(meshOrRef);
 }
 
+// Throws a `ValueError` unless the flat lists passed to `get_bulk` are
+// consistent with each other and with `mesh`, since
+// `sdyTensorShardingAttrGetBulk` doesn't check them.
+void validateBulkShardingArgs(MlirAttribute mesh,
+                              const std::vector<intptr_t>& ranks,
+                              const std::vector<intptr_t>& numAxesPerDim,
+                              const std::vector<bool>& isClosedPerDim,
+                              const std::vector<int64_t>& priorityPerDim,
+                              const std::vector<int64_t>& axisIndices,
+                              const std::vector<int64_t>& subAxisPreSizes,
+                              const std::vector<int64_t>& subAxisSizes) {
+  if (!sdyAttributeIsAMeshAttr(mesh)) {
+    throw nb::value_error("mesh must be a MeshAttr.");
+  }
+  size_t numDims = 0;
+  for (intptr_t rank : ranks) {
+    if (rank < 0) {
+      throw nb::value_error("ranks must be non-negative.");
+    }
+    numDims += rank;
+  }
+  if (numAxesPerDim.size() != numDims || isClosedPerDim.size() != numDims) {
+    throw nb::value_error(
+        "num_axes_per_dim and is_closed_per_dim must have sum(ranks) "
+        "elements.");
+  }
+  if (!priorityPerDim.empty() && priorityPerDim.size() != numDims) {
+    throw nb::value_error(
+        "priority_per_dim must be empty or have sum(ranks) elements.");
+  }
+  size_t numAxes = 0;
+  for (intptr_t numAxesInDim : numAxesPerDim) {
+    if (numAxesInDim < 0) {
+      throw nb::value_error("num_axes_per_dim must be non-negative.");
+    }
+    numAxes += numAxesInDim;
+  }
+  if (axisIndices.size() != numAxes) {
+    throw nb::value_error(
+        "axis_indices must have sum(num_axes_per_dim) elements.");
+  }
+  if (subAxisPreSizes.size() != subAxisSizes.size() ||
+      (!subAxisSizes.empty() && subAxisSizes.size() != numAxes)) {
+    throw nb::value_error(
+        "sub_axis_pre_sizes and sub_axis_sizes must both be empty or both "
+        "have sum(num_axes_per_dim) elements.");
+  }
+  intptr_t meshSize = sdyMeshAttrGetAxesSize(mesh);
+  for (int64_t axisIndex : axisIndices) {
+    if (axisIndex < 0 || axisIndex >= meshSize) {
+      throw nb::value_error("axis_indices must be indices of axes in mesh.");
+    }
+  }
+}
+
+// Calls the Python sharding rule generator `userData` on `op`. Errors raised by
+// the generator are reported as unraisable and result in a null rule, since
+// they can't propagate through the C API.
+MlirAttribute callPyShardingRuleGenerator(MlirOperation op,
+                                          bool conservativePropagation,
+                                          void* userData) {
+  nb::gil_scoped_acquire acquire;
+  try {
+    nb::object rule = nb::borrow<nb::callable>(static_cast<PyObject*>(userData))(
+        op, conservativePropagation);
+    if (!rule.is_none()) {
+      return nb::cast<MlirAttribute>(rule);
+    }
+  } catch (nb::python_error& e) {
+    e.discard_as_unraisable("sdy sharding rule generator");
+  } catch (const std::exception& e) {
+    PyErr_WarnEx(PyExc_RuntimeWarning, e.what(), /*stack_level=*/1);
+  }
+  return {nullptr};
+}
+
+// Returns a new reference to `generator`, which is never released as
+// registered generators live as long as the process.
+void* leakGenerator(nb::callable generator) {
+  return std::move(generator).release().ptr();
+}
+
 NB_MODULE(_sdy, m) {
   m.doc() = "SDY main Python extension";
 
@@ -90,6 +245,34 @@ NB_MODULE(_sdy, m) {
       },
       nb::arg("context"), nb::arg("load") = true);
 
+  //
+  // Sharding rules.
+  //
+
+  m.def(
+      "register_custom_call_sharding_rule",
+      [](const std::string& callTargetName, nb::callable generator) {
+        mlirSdyRegisterCustomCallShardingRule(
+            toStringRef(callTargetName), callPyShardingRuleGenerator,
+            leakGenerator(std::move(generator)));
+      },
+      nb::arg("call_target_name"), nb::arg("generator"),
+      "Registers `generator(op, conservative_propagation)` as the sharding "
+      "rule of `stablehlo.custom_call` ops with the given call target. It "
+      "should return an `OpShardingRuleAttr`, or None if the op shouldn't be "
+      "propagated through.");
+
+  m.def(
+      "register_op_sharding_rule",
+      [](const std::string& opName, nb::callable generator) {
+        mlirSdyRegisterOpShardingRule(toStringRef(opName),
+                                      callPyShardingRuleGenerator,
+                                      leakGenerator(std::move(generator)));
+      },
+      nb::arg("op_name"), nb::arg("generator"),
+      "Same as `register_custom_call_sharding_rule`, but for all ops with the "
+      "given name.");
+
   nb::enum_<SdyDialectVersion::CompatibilityRequirement>(
       m, "CompatibilityRequirement")
       .value("NONE", SdyDialectVersion::CompatibilityRequirement::NONE)
@@ -105,6 +288,100 @@ NB_MODULE(_sdy, m) {
       },
       nb::arg("requirement"));
 
+  m.def(
+      "get_func_arg_and_result_shardings",
+      [](MlirOperation funcOp) {
+        MlirType funcType =
+            mlirTypeAttrGetValue(mlirOperationGetAttributeByName(
+                funcOp, toStringRef("function_type")));
+        std::vector<MlirAttribute> argShardings(
+            mlirFunctionTypeGetNumInputs(funcType));
+        std::vector<MlirAttribute> resultShardings(
+            mlirFunctionTypeGetNumResults(funcType));
+        sdyFuncOpGetArgAndResultShardings(funcOp, argShardings.data(),
+                                          resultShardings.data());
+        auto toOptionals = [](const std::vector<MlirAttribute>& shardings) {
+          std::vector<std::optional<MlirAttribute>> result;
+          result.reserve(shardings.size());
+          for (MlirAttribute sharding : shardings) {
+            result.push_back(mlirAttributeIsNull(sharding)
+                                 ? std::nullopt
+                                 : std::make_optional(sharding));
+          }
+          return result;
+        };
+        return std::make_pair(toOptionals(argShardings),
+                              toOptionals(resultShardings));
+      },
+      nb::arg("func_op"),
+      "Returns the shardings of all arguments and results of a `func.func` "
+      "op, or None for those without a sharding.");
+
+  m.def(
+      "get_sharding_arrays",
+      [](const std::vector<MlirAttribute>& shardings,
+         const std::variant<MlirAttribute, std::vector<MlirAttribute>>& mesh) {
+        std::vector<MlirAttribute> meshes;
+        if (auto* meshPerSharding =
+                std::get_if<std::vector<MlirAttribute>>(&mesh)) {
+          if (meshPerSharding->size() != shardings.size()) {
+            throw nb::value_error(
+                "mesh must be a MeshAttr or a list with one MeshAttr per "
+                "sharding.");
+          }
+          meshes = *meshPerSharding;
+        } else {
+          meshes.assign(shardings.size(), std::get<MlirAttribute>(mesh));
+        }
+        for (size_t i = 0; i < shardings.size(); ++i) {
+          if (!sdyAttributeIsATensorShardingAttr(shardings[i])) {
+            throw nb::value_error("shardings must be TensorShardingAttrs.");
+          }
+          if (!sdyAttributeIsAMeshAttr(meshes[i])) {
+            throw nb::value_error(
+                "mesh must be a MeshAttr or a list of MeshAttrs.");
+          }
+          // A sharding with an inlined mesh always uses its own mesh.
+          if (MlirAttribute meshOrRef =
+                  sdyTensorShardingAttrGetMeshOrRef(shardings[i]);
+              sdyAttributeIsAMeshAttr(meshOrRef)) {
+            meshes[i] = meshOrRef;
+          }
+        }
+        return getShardingArrays(shardings, meshes);
+      },
+      nb::arg("shardings"), nb::arg("mesh"),
+      "Returns the dimension shardings of `shardings` as a dict of flat "
+      "NumPy arrays: `mesh_indices` and `ranks` per sharding, "
+      "`num_axes_per_dim`, `is_closed_per_dim` and `priority_per_dim` (-1 if "
+      "none) per dimension, and `axis_indices` (w.r.t. the mesh of the "
+      "sharding, -1 if not in it), `sub_axis_pre_sizes` and `sub_axis_sizes` "
+      "(-1 if a full axis) per axis. `mesh` is the MeshAttr of all shardings, "
+      "or a list with the MeshAttr of each sharding, except that shardings "
+      "with an inlined mesh use it instead. `mesh_indices` are indices into "
+      "the list of distinct meshes returned as `meshes`. Raises a ValueError "
+      "if `mesh` doesn't match `shardings`.");
+
+  m.def(
+      "get_op_sharding_arrays",
+      [](MlirOperation op) {
+        intptr_t numShardings = sdyOperationGetNumShardings(op);
+        std::vector<MlirAttribute> shardings(numShardings);
+        std::vector<MlirAttribute> meshes(numShardings);
+        sdyOperationGetShardings(op, shardings.data());
+        sdyOperationGetShardingMeshes(op, meshes.data());
+        return getShardingArrays(shardings, meshes);
+      },
+      nb::arg("op"),
+      "Returns the shardings of all values in `op` (e.g. a module) and its "
+      "nested ops that have one, in pre-order, in the format of "
+      "`get_sharding_arrays`. The mesh of each sharding is the one it "
+      "references, so axis indices are w.r.t. that mesh, and `mesh_indices` "
+      "is -1 for shardings whose mesh can't be found. The shardings of a "
+      "`func.func` are those of its arguments followed by those of its "
+      "results, and ops like `sdy.sharding_constraint` and `sdy.reshard` "
+      "contribute their single sharding.");
+
   //
   // Attributes.
   //
@@ -266,6 +543,52 @@ NB_MODULE(_sdy, m) {
           nb::arg("context").none() = nb::none(),
           "Creates a TensorShardingAttr with either an inlined mesh or mesh "
           "name, dimension shardings, and replicated axes.")
+      .def_classmethod(
+          "get_bulk",
+          [](nb::object cls,
+             const std::variant<std::string, MlirAttribute>& meshOrRef,
+             MlirAttribute mesh, const std::vector<intptr_t>& ranks,
+             const std::vector<intptr_t>& numAxesPerDim,
+             const std::vector<bool>& isClosedPerDim,
+             const std::vector<int64_t>& priorityPerDim,
+             const std::vector<int64_t>& axisIndices,
+             const std::vector<int64_t>& subAxisPreSizes,
+             const std::vector<int64_t>& subAxisSizes, MlirContext ctx) {
+            validateBulkShardingArgs(mesh, ranks, numAxesPerDim,
+                                     isClosedPerDim, priorityPerDim,
+                                     axisIndices, subAxisPreSizes,
+                                     subAxisSizes);
+            // `std::vector<bool>` isn't contiguous.
+            auto isClosed = std::make_unique<bool[]>(isClosedPerDim.size());
+            llvm::copy(isClosedPerDim, isClosed.get());
+            std::vector<MlirAttribute> shardings(ranks.size());
+            sdyTensorShardingAttrGetBulk(
+                ctx, toMeshOrRefAttr(ctx, meshOrRef), mesh, ranks.size(),
+                ranks.data(), numAxesPerDim.data(), isClosed.get(),
+                priorityPerDim.empty() ? nullptr : priorityPerDim.data(),
+                axisIndices.data(),
+                subAxisSizes.empty() ? nullptr : subAxisPreSizes.data(),
+                subAxisSizes.empty() ? nullptr : subAxisSizes.data(),
+                shardings.data());
+            nb::list result;
+            for (MlirAttribute sharding : shardings) {
+              result.append(cls(sharding));
+            }
+            return result;
+          },
+          nb::arg("cls"), nb::arg("mesh_or_ref"), nb::arg("mesh"),
+          nb::arg("ranks"), nb::arg("num_axes_per_dim"),
+          nb::arg("is_closed_per_dim"),
+          nb::arg("priority_per_dim") = std::vector<int64_t>(),
+          nb::arg("axis_indices") = std::vector<int64_t>(),
+          nb::arg("sub_axis_pre_sizes") = std::vector<int64_t>(),
+          nb::arg("sub_axis_sizes") = std::vector<int64_t>(),
+          nb::arg("context").none() = nb::none(),
+          "Creates a TensorShardingAttr per rank in `ranks` from flat lists "
+          "of the dimension shardings of all of them, and of the axes of all "
+          "dimensions, given by their index in `mesh`. Raises a ValueError "
+          "if the sizes of the lists don't match or an axis index is out of "
+          "bounds. See `sdyTensorShardingAttrGetBulk`.")
       .def_property_readonly("mesh_or_ref",
                              [](MlirAttribute self) {
                                return sdyTensorShardingAttrGetMeshOrRef(self);
@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "shardy/integrations/python/jax/mpmd/jaxlib/mpmd_program.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
@@ -24,15 +27,30 @@ limitations under the License.
 #include <variant>
 #include <vector>
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/DialectRegistry.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
 #include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/IR/Threading.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassInstrumentation.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LogicalResult.h"
+#include "mlir/Support/TypeID.h"
 #include "shardy/common/logging.h"
 #include "shardy/dialect/mpmd/ir/register.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
@@ -43,6 +61,7 @@ limitations under the License.
 #include "shardy/dialect/mpmd/transforms/optimize/passes.h"
 #include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
 #include "shardy/dialect/mpmd/transforms/sharding_propagation/passes.h"
+#include "shardy/integrations/python/jax/mpmd/jaxlib/partitioning_cache.h"
 #include "shardy/integrations/python/jax/mpmd/jaxlib/throw_error.h"
 
 namespace mlir::mpmd {
@@ -91,6 +110,63 @@ void VerifyOnlyDonatedArgsHaveDonationAttributes(
   }
 }
 
+// Fails if the cancellation callback of a program requests cancellation, so
+// that a batch pipeline stops between phases, as a pass pipeline can't be
+// interrupted otherwise.
+class CancellationCheckPass
+    : public PassWrapper<CancellationCheckPass, OperationPass<ModuleOp>> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(CancellationCheckPass)
+
+  CancellationCheckPass(PartitioningCancellationCallback callback,
+                        std::string func_name)
+      : callback_(std::move(callback)), func_name_(std::move(func_name)) {}
+
+  StringRef getArgument() const override { return "mpmd-check-cancellation"; }
+
+  void runOnOperation() override {
+    if (callback_()) {
+      getOperation().emitError("MPMD partitioning of function named ")
+          << func_name_ << " was cancelled";
+      signalPassFailure();
+    }
+  }
+
+ private:
+  PartitioningCancellationCallback callback_;
+  std::string func_name_;
+};
+
+// Calls a progress callback before each top-level pass of a pass manager,
+// other than cancellation checks.
+class ProgressInstrumentation : public PassInstrumentation {
+ public:
+  ProgressInstrumentation(PartitioningProgressCallback callback,
+                          std::vector<PartitioningPhase> phase_per_pass)
+      : callback_(std::move(callback)),
+        phase_per_pass_(std::move(phase_per_pass)) {}
+
+  void runBeforePass(Pass* pass, Operation* op) override {
+    // Nested passes run on ops within the module, possibly in parallel, and
+    // are part of a top-level pass (i.e., pass adaptor) that was reported.
+    if (op->getParentOp() ||
+        pass->getTypeID() == TypeID::get<CancellationCheckPass>()) {
+      return;
+    }
+    PartitioningPhase phase =
+        phase_per_pass_[std::min(next_pass_, phase_per_pass_.size() - 1)];
+    ++next_pass_;
+    callback_(phase,
+              pass->getArgument().empty() ? pass->getName()
+                                          : pass->getArgument());
+  }
+
+ private:
+  PartitioningProgressCallback callback_;
+  std::vector<PartitioningPhase> phase_per_pass_;
+  size_t next_pass_ = 0;
+};
+
 }  // namespace
 
 PartitioningOptions ParsePartitioningOptions(
@@ -108,6 +184,12 @@ PartitioningOptions ParsePartitioningOptions(
   PARSE_BOOL_OPTION(mpmd_assume_homogeneous_devices);
 #undef PARSE_BOOL_OPTION
 
+  if (auto it = options.find("mpmd_partitioning_cache_dir");
+      it != options.end()) {
+    parsed_options.mpmd_partitioning_cache_dir =
+        std::get<std::string>(it->second);
+  }
+
   if (auto it = options.find("mpmd_pipeline_schedule"); it != options.end()) {
     std::string schedule_str = std::get<std::string>(it->second);
     if (std::optional<PipelineSchedule> parsed_schedule =
@@ -165,7 +247,7 @@ LogicalResult ErrorDiagnosticHandler::HandleDiagnostic(Diagnostic& diag) {
   return success();
 }
 
-PartitioningResult MpmdProgram::ApplyPartitioning(PartitioningPhase phases) {
+void MpmdProgram::PrepareForPartitioning(PartitioningPhase phases) {
   if ((phases & ~PartitioningPhase::kAll) != 0) {
     // Check that no undefined phase bits are set.
     ThrowError("Invalid PartitioningPhase: " + std::to_string(phases));
@@ -182,7 +264,28 @@ PartitioningResult MpmdProgram::ApplyPartitioning(PartitioningPhase phases) {
     // because here we're only checking that the attributes set on the main func
     // are consistent with the received donate args.
     VerifyOnlyDonatedArgsHaveDonationAttributes(main_func, donate_argnums);
+  }
+}
 
+PartitioningResult MpmdProgram::ApplyPartitioning(PartitioningPhase phases) {
+  PrepareForPartitioning(phases);
+
+  PartitioningCache* partitioning_cache = GetCache();
+  std::string cache_key;
+  if (partitioning_cache) {
+    cache_key = ComputeCacheKey(phases);
+    if (OwningOpRef<ModuleOp> cached_module =
+            partitioning_cache->Lookup(cache_key, module.getContext())) {
+      SDY_LOG(INFO) << "Using the cached MPMD partitioning of function named "
+                    << func_name << ".";
+      module->setAttrs(cached_module.get()->getAttrDictionary());
+      module.getBodyRegion().takeBody(cached_module->getBodyRegion());
+      return PartitioningResult(module);
+    }
+  }
+
+  if (phases & PartitioningPhase::kImport) {
+    ThrowIfCancelled();
     SDY_LOG(INFO) << "Importing function named " << func_name
                   << " for MPMD partitioning.";
 
@@ -190,27 +293,228 @@ PartitioningResult MpmdProgram::ApplyPartitioning(PartitioningPhase phases) {
   }
 
   if (phases & PartitioningPhase::kOptimize) {
+    ThrowIfCancelled();
     SDY_LOG(INFO) << "Optimizing function named " << func_name
                   << " for pipeline parallelism.";
     Optimize(module);
   }
 
   if (phases & PartitioningPhase::kPartition) {
+    ThrowIfCancelled();
     SDY_LOG(INFO) << "Applying SDY propagation to function named " << func_name
                   << ".";
     PropagateSharding(module);
 
+    ThrowIfCancelled();
     SDY_LOG(INFO) << "Exporting MPMD function named " << func_name << ".";
     Export(module);
   }
 
+  if (partitioning_cache) {
+    partitioning_cache->Insert(cache_key, module);
+  }
   return PartitioningResult(module);
 }
 
+BatchPartitioningResult MpmdProgram::ApplyPartitioningToBatch(
+    std::vector<MpmdProgram>& programs, PartitioningPhase phases) {
+  BatchPartitioningResult batch_result;
+  if (programs.empty()) {
+    return batch_result;
+  }
+  MLIRContext* context = programs.front().module->getContext();
+
+  // Build the pipelines of all programs upfront, running all phases of a
+  // program in a single pass manager, as the programs are then partitioned
+  // in parallel.
+  std::vector<std::unique_ptr<PassManager>> pass_managers;
+  pass_managers.reserve(programs.size());
+  DialectRegistry dependent_dialects;
+  for (MpmdProgram& program : programs) {
+    if (program.module->getContext() != context) {
+      ThrowError("All programs in a batch must share the same MLIRContext");
+    }
+    program.PrepareForPartitioning(phases);
+
+    auto pm = std::make_unique<PassManager>(program.module->getName());
+    pm->enableVerifier(kEnableVerifier);
+    std::vector<PartitioningPhase> phase_per_pass;
+    // Adds a step of `phase`, preceded by a cancellation check like the one
+    // `ApplyPartitioning` does before each step.
+    auto add_step = [&](PartitioningPhase phase,
+                        llvm::function_ref<void()> add_passes) {
+      if (!(phases & phase)) {
+        return;
+      }
+      if (program.cancellation_callback) {
+        pm->addPass(std::make_unique<CancellationCheckPass>(
+            program.cancellation_callback, program.func_name));
+      }
+      size_t num_passes = pm->size();
+      add_passes();
+      phase_per_pass.insert(phase_per_pass.end(), pm->size() - num_passes,
+                            phase);
+    };
+    add_step(kImport, [&]() { program.AddImportPasses(*pm); });
+    add_step(kOptimize, [&]() { program.AddOptimizePasses(*pm); });
+    add_step(kPartition,
+             [&]() { program.AddShardingPropagationPasses(*pm); });
+    // Fingerprints are needed to find the fragments shared by programs.
+    add_step(kPartition, [&]() {
+      program.AddExportPasses(*pm, /*emit_fragment_fingerprints=*/true);
+    });
+    program.AddProgressInstrumentation(*pm, std::move(phase_per_pass));
+    pm->getDependentDialects(dependent_dialects);
+    pass_managers.push_back(std::move(pm));
+  }
+  // Dialects can't be loaded while the programs are partitioned in parallel,
+  // so we load the dialects of all pipelines here.
+  context->appendDialectRegistry(dependent_dialects);
+  for (StringRef dialect_name : dependent_dialects.getDialectNames()) {
+    context->getOrLoadDialect(dialect_name);
+  }
+
+  for (MpmdProgram& program : programs) {
+    program.ThrowIfCancelled();
+  }
+
+  SDY_LOG(INFO) << "Partitioning a batch of " << programs.size()
+                << " MPMD programs.";
+  ErrorDiagnosticHandler diagnostic_handler(context);
+  LogicalResult result = success();
+  {
+    // Orders the diagnostics by program, and forwards them to
+    // `diagnostic_handler` when destroyed.
+    ParallelDiagnosticHandler parallel_diagnostic_handler(context);
+    result = failableParallelForEachN(
+        context, 0, programs.size(), [&](size_t program_index) {
+          parallel_diagnostic_handler.setOrderIDForThread(program_index);
+          LogicalResult program_result =
+              pass_managers[program_index]->run(programs[program_index].module);
+          parallel_diagnostic_handler.eraseOrderIDForThread();
+          return program_result;
+        });
+  }
+  diagnostic_handler.ConsumeStatus(result);
+
+  batch_result.results.reserve(programs.size());
+  for (auto [program_index, program] : llvm::enumerate(programs)) {
+    batch_result.results.emplace_back(program.module);
+    if (!(phases & PartitioningPhase::kPartition)) {
+      continue;
+    }
+    for (func::FuncOp func_op : program.module.getOps<func::FuncOp>()) {
+      if (auto fingerprint =
+              func_op->getAttrOfType<StringAttr>(kFragmentFingerprintAttr)) {
+        batch_result.fragments_by_fingerprint[fingerprint.str()].emplace_back(
+            program_index, func_op.getSymName().str());
+      }
+    }
+  }
+  return batch_result;
+}
+
 void MpmdProgram::Import(ModuleOp module) {
   PassManager pm(module->getName());
   pm.enableVerifier(kEnableVerifier);
+  AddImportPasses(pm);
+  RunPhase(module, pm, PartitioningPhase::kImport);
+}
+
+void MpmdProgram::Optimize(ModuleOp module) {
+  PassManager pm(module->getName());
+  pm.enableVerifier(kEnableVerifier);
+  AddOptimizePasses(pm);
+  RunPhase(module, pm, PartitioningPhase::kOptimize);
+}
+
+void MpmdProgram::PropagateSharding(ModuleOp module) {
+  PassManager pm(module->getName());
+  pm.enableVerifier(kEnableVerifier);
+  AddShardingPropagationPasses(pm);
+  RunPhase(module, pm, PartitioningPhase::kPartition);
+}
 
+void MpmdProgram::Export(ModuleOp module) {
+  PassManager pm(module->getName());
+  pm.enableVerifier(kEnableVerifier);
+  AddExportPasses(pm, /*emit_fragment_fingerprints=*/false);
+  RunPhase(module, pm, PartitioningPhase::kPartition);
+}
+
+std::string MpmdProgram::ComputeCacheKey(PartitioningPhase phases) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  // The topology and donation attributes are already set on the main function.
+  if (failed(writeBytecodeToFile(module, os))) {
+    ThrowError("Failed to serialize module to bytecode");
+  }
+  // Entries may be shared across processes, so make them version-specific.
+  os << "\nversion=" << SHARDY_MPMD_JAXLIB_VERSION << "\nfunc_name="
+     << func_name << "\nphases=" << static_cast<int32_t>(phases);
+  os << "\noptions=" << options.mpmd_infer_transfers
+     << options.mpmd_infer_cross_mesh_reductions << options.mpmd_fragment_remat
+     << options.mpmd_merge_remat_fragments << options.mpmd_split_bwd_fragments
+     << options.mpmd_assume_homogeneous_devices
+     << options.mpmd_absorb_inferred_fragments_on_entry_point_function
+     << options.mpmd_copy_constant_creation_from_producer_to_consumer
+     << options.mpmd_apply_merge_transfers_pass
+     << options.mpmd_merge_inferred_after_scheduling
+     << options.mpmd_fail_on_backward_deps << ","
+     << ToString(options.mpmd_pipeline_schedule);
+  os << "\nassignment=" << UserAssignmentMapOption{assignment};
+  auto print_meshes = [&](const std::vector<std::optional<std::string>>&
+                              meshes) {
+    llvm::interleaveComma(meshes, os, [&](const auto& mesh) {
+      os << mesh.value_or("<none>");
+    });
+  };
+  os << "\ninput_meshes=";
+  print_meshes(input_meshes);
+  os << "\noutput_meshes=";
+  print_meshes(output_meshes);
+  os << "\nfragment_merge_rules=";
+  llvm::interleaveComma(fragment_merge_rules, os);
+  os << "\nfragment_schedule_rules=";
+  llvm::interleaveComma(fragment_schedule_rules, os);
+
+  llvm::SHA256 hasher;
+  hasher.update(str);
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+PartitioningCache* MpmdProgram::GetCache() {
+  if (cache || options.mpmd_partitioning_cache_dir.empty()) {
+    return cache;
+  }
+  return &GetSharedPartitioningCache(options.mpmd_partitioning_cache_dir);
+}
+
+void MpmdProgram::ThrowIfCancelled() {
+  if (cancellation_callback && cancellation_callback()) {
+    ThrowError("MPMD partitioning of function named " + func_name +
+               " was cancelled");
+  }
+}
+
+void MpmdProgram::AddProgressInstrumentation(
+    PassManager& pm, std::vector<PartitioningPhase> phase_per_pass) {
+  if (!progress_callback || phase_per_pass.empty()) {
+    return;
+  }
+  pm.addInstrumentation(std::make_unique<ProgressInstrumentation>(
+      progress_callback, std::move(phase_per_pass)));
+}
+
+void MpmdProgram::RunPhase(ModuleOp module, PassManager& pm,
+                           PartitioningPhase phase) {
+  AddProgressInstrumentation(pm,
+                             std::vector<PartitioningPhase>(pm.size(), phase));
+  ErrorDiagnosticHandler diagnostic_handler(module.getContext());
+  return diagnostic_handler.ConsumeStatus(pm.run(module));
+}
+
+void MpmdProgram::AddImportPasses(OpPassManager& pm) {
   ImportOptions import_options;
   import_options.nameToMeshAssignment = {std::move(assignment)};
   import_options.inputIndexToMeshAssignment = {
@@ -227,14 +531,9 @@ void MpmdProgram::Import(ModuleOp module) {
   };
   import_options.splitBwdFragments = options.mpmd_split_bwd_fragments;
   addImportPipeline(pm, import_options);
-  ErrorDiagnosticHandler diagnostic_handler(module.getContext());
-  return diagnostic_handler.ConsumeStatus(pm.run(module));
 }
 
-void MpmdProgram::Optimize(ModuleOp module) {
-  PassManager pm(module->getName());
-  pm.enableVerifier(kEnableVerifier);
-
+void MpmdProgram::AddOptimizePasses(OpPassManager& pm) {
   OptimizeOptions optimize_options;
   optimize_options.fragmentMergeRules = llvm::to_vector(fragment_merge_rules);
   optimize_options.mergeAfterScheduling =
@@ -245,35 +544,25 @@ void MpmdProgram::Optimize(ModuleOp module) {
       options.mpmd_absorb_inferred_fragments_on_entry_point_function;
   optimize_options.pipelineSchedule = options.mpmd_pipeline_schedule;
   addOptimizePipeline(pm, optimize_options);
-
-  ErrorDiagnosticHandler diagnostic_handler(module.getContext());
-  return diagnostic_handler.ConsumeStatus(pm.run(module));
 }
 
-void MpmdProgram::PropagateSharding(ModuleOp module) {
-  PassManager pm(module->getName());
-  pm.enableVerifier(kEnableVerifier);
-
-  addShardingPropagationPipeline(pm, "");
-
-  ErrorDiagnosticHandler diagnostic_handler(module.getContext());
-  return diagnostic_handler.ConsumeStatus(pm.run(module));
+void MpmdProgram::AddShardingPropagationPasses(OpPassManager& pm) {
+  addShardingPropagationPipeline(
+      pm, /*sdyDumpDir=*/"",
+      /*unifyEquivalentFragmentShardings=*/
+      options.mpmd_assume_homogeneous_devices);
 }
 
-void MpmdProgram::Export(ModuleOp module) {
-  PassManager pm(module->getName());
-  pm.enableVerifier(kEnableVerifier);
-
+void MpmdProgram::AddExportPasses(OpPassManager& pm,
+                                  bool emit_fragment_fingerprints) {
   ExportOptions export_options;
   export_options.copyConstantsFromProducerToConsumer =
       options.mpmd_copy_constant_creation_from_producer_to_consumer;
   export_options.applyMergeTransfers = options.mpmd_apply_merge_transfers_pass;
   export_options.failOnBackwardDeps = options.mpmd_fail_on_backward_deps;
+  export_options.emitFragmentFingerprints = emit_fragment_fingerprints;
   export_options.verboseLogging = true;
   addExportPipeline(pm, export_options);
-
-  ErrorDiagnosticHandler diagnostic_handler(module.getContext());
-  return diagnostic_handler.ConsumeStatus(pm.run(module));
 }
 
 }  // namespace mlir::mpmd
@@ -17,6 +17,7 @@ limitations under the License.
 #define SHARDY_INTEGRATIONS_PYTHON_JAX_MPMD_JAXLIB_MPMD_PROGRAM_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <optional>
 #include <string>
@@ -24,22 +25,25 @@ limitations under the License.
 #include <variant>
 #include <vector>
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
 #include "shardy/dialect/mpmd/ir/fragment_execution_rules.h"
 #include "shardy/dialect/mpmd/ir/utils.h"
 #include "shardy/dialect/mpmd/transforms/import/mesh_assignment_map.h"
 #include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+#include "shardy/integrations/python/jax/mpmd/jaxlib/partitioning_cache.h"
 
 // An increasing version number to protect jax code against breaking changes.
 // Please suffix the version number with a brief description of your change
 // in a comment. The goal here is to force a merge conflict if two changes
 // attempt to grab the same version number.
-#define SHARDY_MPMD_JAXLIB_VERSION 2  // NamedSpmdShardingSpec::unreduced_axes
+#define SHARDY_MPMD_JAXLIB_VERSION 5  // mpmd_partitioning_cache_dir
 
 namespace mlir::mpmd {
 
@@ -59,6 +63,16 @@ enum PartitioningPhase : int32_t {
   kAll = kImport | kOptimize | kPartition,
 };
 
+// Called with the phase and name of each top-level pass before it runs.
+using PartitioningProgressCallback =
+    std::function<void(PartitioningPhase phase, llvm::StringRef pass_name)>;
+
+// Polled before each phase, including within the pipeline of each program of a
+// batch. Returning true cancels partitioning, which then raises a runtime
+// error. MLIR can't interrupt a running pass pipeline, so the current phase
+// runs to completion first.
+using PartitioningCancellationCallback = std::function<bool()>;
+
 struct PartitioningResult {
   mlir::ModuleOp mpmd_module;
   // Partition specs and mesh names of each input and output of the MPMD
@@ -73,6 +87,18 @@ struct PartitioningResult {
                 GetMainFunction(mpmd_module))) {}
 };
 
+// The result of partitioning a batch of MPMD programs together.
+struct BatchPartitioningResult {
+  // The result of each program, in the order of the batch.
+  std::vector<PartitioningResult> results;
+  // The fragment functions of all programs, grouped by fingerprint, i.e., each
+  // entry holds the program index and name of each function with the same
+  // body, so that it only needs to be compiled once. Only populated if the
+  // batch was exported.
+  std::map<std::string, std::vector<std::pair<int64_t, std::string>>>
+      fragments_by_fingerprint;
+};
+
 class ErrorDiagnosticHandler : public mlir::SourceMgrDiagnosticHandler {
  public:
   explicit ErrorDiagnosticHandler(mlir::MLIRContext* context);
@@ -110,6 +136,9 @@ struct PartitioningOptions {
   bool mpmd_apply_merge_transfers_pass = false;
   bool mpmd_merge_inferred_after_scheduling = false;
   bool mpmd_fail_on_backward_deps = false;
+  // If not empty, partitioned programs are cached in this directory, shared by
+  // all programs of the process that use it (see `MpmdProgram::cache`).
+  std::string mpmd_partitioning_cache_dir;
 };
 
 PartitioningOptions ParsePartitioningOptions(
@@ -127,18 +156,69 @@ struct MpmdProgram {
   const std::vector<int64_t>& donate_argnums;
   const mlir::mpmd::FragmentMergeRules& fragment_merge_rules;
   const mlir::mpmd::FragmentScheduleRules& fragment_schedule_rules;
+  // Optional hooks to report progress and to cooperatively cancel
+  // partitioning. They are called from the threads running the passes, which
+  // don't hold the GIL, so Python callbacks must acquire it.
+  PartitioningProgressCallback progress_callback = nullptr;
+  PartitioningCancellationCallback cancellation_callback = nullptr;
+  // If set, `ApplyPartitioning` returns the cached result of partitioning an
+  // identical program, and caches the result otherwise. If null, the cache of
+  // `options.mpmd_partitioning_cache_dir` is used, if that is set.
+  PartitioningCache* cache = nullptr;
 
   // Runs the PartIR MPMD partitioning passes on the MPMD program.
   //
-  // Raises a runtime error if it fails.
+  // Raises a runtime error if it fails or is cancelled.
   PartitioningResult ApplyPartitioning(PartitioningPhase phases);
 
+  // Runs the PartIR MPMD partitioning passes on a batch of MPMD programs, e.g.,
+  // variants of the same program with different batch sizes, whose modules
+  // must share the same MLIRContext. The programs are partitioned in parallel,
+  // and the fragment functions of all of them are grouped by fingerprint.
+  //
+  // Raises a runtime error if any of them fails or is cancelled.
+  static BatchPartitioningResult ApplyPartitioningToBatch(
+      std::vector<MpmdProgram>& programs, PartitioningPhase phases);
+
+  // Returns a fingerprint of the module, after `PrepareForPartitioning`, and
+  // of everything else that affects partitioning it with `phases`.
+  std::string ComputeCacheKey(PartitioningPhase phases);
+
  private:
+  // Sets the topology and the donation attributes of the main function, as
+  // needed by `phases`. Raises a runtime error if it fails.
+  void PrepareForPartitioning(PartitioningPhase phases);
+
   // Raises a runtime error if these functions fail.
   void Import(mlir::ModuleOp module);
   void Optimize(mlir::ModuleOp module);
   void PropagateSharding(mlir::ModuleOp module);
   void Export(mlir::ModuleOp module);
+
+  // Returns `cache`, or the shared cache of
+  // `options.mpmd_partitioning_cache_dir` if `cache` is null and it is set.
+  PartitioningCache* GetCache();
+
+  // Raises a runtime error if `cancellation_callback` requests cancellation.
+  void ThrowIfCancelled();
+
+  // Adds an instrumentation to `pm` that calls `progress_callback` before
+  // each top-level pass, if set, where `phase_per_pass[i]` is the phase of the
+  // i-th top-level pass in `pm`.
+  void AddProgressInstrumentation(
+      mlir::PassManager& pm, std::vector<PartitioningPhase> phase_per_pass);
+
+  // Runs `pm`, whose passes all belong to `phase`, on `module`. Raises a
+  // runtime error if it fails.
+  void RunPhase(mlir::ModuleOp module, mlir::PassManager& pm,
+                PartitioningPhase phase);
+
+  // Add the passes of each phase to `pm`.
+  void AddImportPasses(mlir::OpPassManager& pm);
+  void AddOptimizePasses(mlir::OpPassManager& pm);
+  void AddShardingPropagationPasses(mlir::OpPassManager& pm);
+  void AddExportPasses(mlir::OpPassManager& pm,
+                       bool emit_fragment_fingerprints);
 };
 
 }  // namespace mlir::mpmd
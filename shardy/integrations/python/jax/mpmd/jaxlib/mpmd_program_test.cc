@@ -0,0 +1,379 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/integrations/python/jax/mpmd/jaxlib/mpmd_program.h"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/fragment_execution_rules.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/mpmd/ir/utils.h"
+#include "shardy/dialect/mpmd/transforms/import/mesh_assignment_map.h"
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+#include "shardy/integrations/python/jax/mpmd/jaxlib/partitioning_cache.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mlir::mpmd {
+namespace {
+
+using ::testing::HasSubstr;
+
+const char kProgram[] = R"mlir(
+func.func public @main(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %0 = stablehlo.add %arg0, %arg0 : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+)mlir";
+
+const char kOtherProgram[] = R"mlir(
+func.func public @main(%arg0: tensor<8xf32>) -> tensor<8xf32> {
+  %0 = stablehlo.multiply %arg0, %arg0 : tensor<8xf32>
+  %1 = stablehlo.tanh %0 : tensor<8xf32>
+  return %1 : tensor<8xf32>
+}
+)mlir";
+
+// The outer named computation isn't assigned to a mesh, which import rejects.
+const char kInvalidProgram[] = R"mlir(
+func.func public @main(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %0 = mpmd.named_computation<"outer"> (%arg0) (%arg1: tensor<4xf32>) {
+    %1 = mpmd.named_computation<"inner"> (%arg1) (%arg2: tensor<4xf32>) {
+      %2 = stablehlo.add %arg2, %arg2 : tensor<4xf32>
+      mpmd.return %2 : tensor<4xf32>
+    } : (tensor<4xf32>) -> tensor<4xf32>
+    mpmd.return %1 : tensor<4xf32>
+  } : (tensor<4xf32>) -> tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+)mlir";
+
+std::string PrintModule(ModuleOp module) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  module.print(os);
+  return str;
+}
+
+class MpmdProgramCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override { loadAllRequiredDialects(&context_); }
+
+  // Returns a program partitioning a fresh copy of `source`, which counts the
+  // passes it runs in `num_passes_run_`.
+  MpmdProgram CreateProgram(StringRef source = kProgram) {
+    modules_.push_back(parseSourceString<ModuleOp>(source, &context_));
+    EXPECT_TRUE(modules_.back());
+    MpmdProgram program{
+        .module = *modules_.back(),
+        .func_name = "main",
+        .options = options_,
+        .named_meshes = named_meshes_,
+        .assignment = assignment_,
+        .input_meshes = input_meshes_,
+        .output_meshes = output_meshes_,
+        .donate_argnums = donate_argnums_,
+        .fragment_merge_rules = fragment_merge_rules_,
+        .fragment_schedule_rules = fragment_schedule_rules_,
+    };
+    program.progress_callback = [&](PartitioningPhase, StringRef) {
+      ++num_passes_run_;
+    };
+    return program;
+  }
+
+  std::string CreateCacheDir() {
+    SmallString<128> dir;
+    EXPECT_FALSE(llvm::sys::fs::createUniqueDirectory("mpmd_cache", dir));
+    cache_dir_ = dir.str().str();
+    return cache_dir_;
+  }
+
+  void TearDown() override {
+    if (!cache_dir_.empty()) {
+      llvm::sys::fs::remove_directories(cache_dir_);
+    }
+  }
+
+  MLIRContext context_;
+  std::vector<OwningOpRef<ModuleOp>> modules_;
+  PartitioningOptions options_;
+  std::vector<std::pair<std::string, FlatMesh>> named_meshes_ = {
+      {"m1", {{"x", 2}}}};
+  UserAssignmentMap assignment_;
+  std::vector<std::optional<std::string>> input_meshes_ = {"m1"};
+  std::vector<std::optional<std::string>> output_meshes_ = {"m1"};
+  std::vector<int64_t> donate_argnums_;
+  FragmentMergeRules fragment_merge_rules_;
+  FragmentScheduleRules fragment_schedule_rules_;
+  int64_t num_passes_run_ = 0;
+  std::string cache_dir_;
+};
+
+using MpmdProgramBatchTest = MpmdProgramCacheTest;
+
+TEST_F(MpmdProgramCacheTest, KeyIsDeterministic) {
+  EXPECT_EQ(CreateProgram().ComputeCacheKey(PartitioningPhase::kAll),
+            CreateProgram().ComputeCacheKey(PartitioningPhase::kAll));
+}
+
+TEST_F(MpmdProgramCacheTest, KeyDependsOnPhases) {
+  MpmdProgram program = CreateProgram();
+  EXPECT_NE(program.ComputeCacheKey(PartitioningPhase::kAll),
+            program.ComputeCacheKey(PartitioningPhase::kImport));
+}
+
+TEST_F(MpmdProgramCacheTest, KeyDependsOnOptions) {
+  std::string key = CreateProgram().ComputeCacheKey(PartitioningPhase::kAll);
+  options_.mpmd_infer_transfers = true;
+  EXPECT_NE(CreateProgram().ComputeCacheKey(PartitioningPhase::kAll), key);
+  options_ = PartitioningOptions();
+  options_.mpmd_pipeline_schedule = PipelineSchedule::k1F1B;
+  EXPECT_NE(CreateProgram().ComputeCacheKey(PartitioningPhase::kAll), key);
+}
+
+TEST_F(MpmdProgramCacheTest, KeyDoesNotDependOnCacheDir) {
+  std::string key = CreateProgram().ComputeCacheKey(PartitioningPhase::kAll);
+  options_.mpmd_partitioning_cache_dir = "/tmp/mpmd_cache";
+  EXPECT_EQ(CreateProgram().ComputeCacheKey(PartitioningPhase::kAll), key);
+}
+
+TEST_F(MpmdProgramCacheTest, KeyDependsOnRules) {
+  std::string key = CreateProgram().ComputeCacheKey(PartitioningPhase::kAll);
+  FragmentInfo fragment{.origins = {{"f", 0}}, .mesh_name = "m1"};
+  fragment_merge_rules_.push_back(
+      FragmentMergeRule{.sources = {fragment}, .target = fragment});
+  std::string key_with_merge_rule =
+      CreateProgram().ComputeCacheKey(PartitioningPhase::kAll);
+  EXPECT_NE(key_with_merge_rule, key);
+  fragment_schedule_rules_.push_back(
+      FragmentScheduleRule{.ordered_fragments = {fragment}});
+  EXPECT_NE(CreateProgram().ComputeCacheKey(PartitioningPhase::kAll),
+            key_with_merge_rule);
+}
+
+TEST_F(MpmdProgramCacheTest, KeyDependsOnAssignment) {
+  std::string key = CreateProgram().ComputeCacheKey(PartitioningPhase::kAll);
+  assignment_["f"] = {"m1", std::nullopt};
+  std::string key_with_assignment =
+      CreateProgram().ComputeCacheKey(PartitioningPhase::kAll);
+  EXPECT_NE(key_with_assignment, key);
+  assignment_["f"] = {"m1", 0};
+  EXPECT_NE(CreateProgram().ComputeCacheKey(PartitioningPhase::kAll),
+            key_with_assignment);
+}
+
+TEST_F(MpmdProgramCacheTest, HitSkipsPartitioning) {
+  PartitioningCache cache;
+  MpmdProgram first = CreateProgram();
+  first.cache = &cache;
+  std::string partitioned =
+      PrintModule(first.ApplyPartitioning(PartitioningPhase::kImport)
+                      .mpmd_module);
+  EXPECT_GT(num_passes_run_, 0);
+
+  num_passes_run_ = 0;
+  MpmdProgram second = CreateProgram();
+  second.cache = &cache;
+  EXPECT_EQ(PrintModule(second.ApplyPartitioning(PartitioningPhase::kImport)
+                            .mpmd_module),
+            partitioned);
+  EXPECT_EQ(num_passes_run_, 0);
+}
+
+TEST_F(MpmdProgramCacheTest, MissPartitionsAndCaches) {
+  PartitioningCache cache;
+  MpmdProgram program = CreateProgram();
+  program.cache = &cache;
+  program.ApplyPartitioning(PartitioningPhase::kImport);
+  EXPECT_GT(num_passes_run_, 0);
+  EXPECT_EQ(cache.GetNumEntriesInMemory(), 1);
+
+  // A different option is a miss.
+  num_passes_run_ = 0;
+  options_.mpmd_infer_transfers = true;
+  MpmdProgram other = CreateProgram();
+  other.cache = &cache;
+  other.ApplyPartitioning(PartitioningPhase::kImport);
+  EXPECT_GT(num_passes_run_, 0);
+  EXPECT_EQ(cache.GetNumEntriesInMemory(), 2);
+}
+
+TEST_F(MpmdProgramCacheTest, CorruptedEntryFallsBackToPartitioning) {
+  std::string cache_dir = CreateCacheDir();
+  std::string partitioned;
+  {
+    PartitioningCache cache(cache_dir);
+    MpmdProgram program = CreateProgram();
+    program.cache = &cache;
+    partitioned = PrintModule(
+        program.ApplyPartitioning(PartitioningPhase::kImport).mpmd_module);
+  }
+
+  // Corrupt the only entry in the cache directory.
+  std::error_code error;
+  llvm::sys::fs::directory_iterator it(cache_dir, error);
+  ASSERT_FALSE(error);
+  ASSERT_NE(it, llvm::sys::fs::directory_iterator());
+  std::string entry_path = it->path();
+  {
+    llvm::raw_fd_ostream os(entry_path, error);
+    ASSERT_FALSE(error);
+    os << "not bytecode";
+  }
+
+  num_passes_run_ = 0;
+  PartitioningCache cache(cache_dir);
+  MpmdProgram program = CreateProgram();
+  program.cache = &cache;
+  EXPECT_EQ(PrintModule(program.ApplyPartitioning(PartitioningPhase::kImport)
+                            .mpmd_module),
+            partitioned);
+  EXPECT_GT(num_passes_run_, 0);
+
+  // The corrupted entry was replaced by a valid one.
+  EXPECT_TRUE(PartitioningCache(cache_dir).Lookup(
+      llvm::sys::path::stem(entry_path), &context_));
+}
+
+TEST_F(MpmdProgramCacheTest, CacheDirOptionEnablesSharedCache) {
+  options_.mpmd_partitioning_cache_dir = CreateCacheDir();
+  CreateProgram().ApplyPartitioning(PartitioningPhase::kImport);
+  EXPECT_GT(num_passes_run_, 0);
+
+  num_passes_run_ = 0;
+  CreateProgram().ApplyPartitioning(PartitioningPhase::kImport);
+  EXPECT_EQ(num_passes_run_, 0);
+  EXPECT_EQ(GetSharedPartitioningCache(options_.mpmd_partitioning_cache_dir)
+                .GetNumEntriesInMemory(),
+            1);
+}
+
+TEST_F(MpmdProgramBatchTest, MatchesPartitioningEachProgram) {
+  std::vector<std::string> expected;
+  for (const char* source : {kProgram, kOtherProgram, kProgram}) {
+    expected.push_back(PrintModule(
+        CreateProgram(source).ApplyPartitioning(PartitioningPhase::kImport)
+            .mpmd_module));
+  }
+
+  std::vector<MpmdProgram> programs;
+  for (const char* source : {kProgram, kOtherProgram, kProgram}) {
+    programs.push_back(CreateProgram(source));
+    // The programs are partitioned in parallel.
+    programs.back().progress_callback = nullptr;
+  }
+  BatchPartitioningResult batch_result =
+      MpmdProgram::ApplyPartitioningToBatch(programs,
+                                            PartitioningPhase::kImport);
+  ASSERT_EQ(batch_result.results.size(), expected.size());
+  for (auto [result, expected_module] :
+       llvm::zip_equal(batch_result.results, expected)) {
+    EXPECT_EQ(PrintModule(result.mpmd_module), expected_module);
+  }
+  // Fragments are only fingerprinted by the export pipeline.
+  EXPECT_TRUE(batch_result.fragments_by_fingerprint.empty());
+}
+
+TEST_F(MpmdProgramBatchTest, ErrorInOneProgramFailsTheBatch) {
+  std::vector<MpmdProgram> programs;
+  for (const char* source : {kProgram, kInvalidProgram, kOtherProgram}) {
+    programs.push_back(CreateProgram(source));
+    programs.back().progress_callback = nullptr;
+  }
+  try {
+    MpmdProgram::ApplyPartitioningToBatch(programs,
+                                          PartitioningPhase::kImport);
+    FAIL() << "expected partitioning the batch to fail";
+  } catch (const std::runtime_error& error) {
+    EXPECT_THAT(error.what(), HasSubstr("outer"));
+  }
+}
+
+TEST_F(MpmdProgramBatchTest, ReportsProgressInPipelineOrder) {
+  constexpr auto kPhases = static_cast<PartitioningPhase>(
+      PartitioningPhase::kImport | PartitioningPhase::kOptimize);
+  using Progress = std::vector<std::pair<PartitioningPhase, std::string>>;
+  auto record_progress = [](Progress& progress) {
+    return [&progress](PartitioningPhase phase, StringRef pass_name) {
+      progress.emplace_back(phase, pass_name.str());
+    };
+  };
+
+  Progress expected;
+  MpmdProgram program = CreateProgram();
+  program.progress_callback = record_progress(expected);
+  program.ApplyPartitioning(kPhases);
+  ASSERT_FALSE(expected.empty());
+  EXPECT_EQ(expected.front().first, PartitioningPhase::kImport);
+  EXPECT_EQ(expected.back().first, PartitioningPhase::kOptimize);
+  EXPECT_TRUE(llvm::is_sorted(expected, [](const auto& a, const auto& b) {
+    return a.first < b.first;
+  }));
+
+  // Cancellation checks within the batch pipeline aren't reported.
+  Progress progress;
+  std::vector<MpmdProgram> programs = {CreateProgram()};
+  programs.front().progress_callback = record_progress(progress);
+  programs.front().cancellation_callback = []() { return false; };
+  MpmdProgram::ApplyPartitioningToBatch(programs, kPhases);
+  EXPECT_EQ(progress, expected);
+}
+
+TEST_F(MpmdProgramBatchTest, CancelsBetweenPhases) {
+  constexpr auto kPhases = static_cast<PartitioningPhase>(
+      PartitioningPhase::kImport | PartitioningPhase::kOptimize);
+  std::atomic<bool> imported = false;
+  std::atomic<bool> optimized = false;
+  std::vector<MpmdProgram> programs;
+  for (const char* source : {kProgram, kOtherProgram}) {
+    MpmdProgram& program = programs.emplace_back(CreateProgram(source));
+    program.progress_callback = [&](PartitioningPhase phase, StringRef) {
+      (phase == PartitioningPhase::kImport ? imported : optimized) = true;
+    };
+    // Cancels once the first program was imported, so that the batch
+    // pipeline is cancelled before optimizing.
+    program.cancellation_callback = [&]() { return imported.load(); };
+  }
+  try {
+    MpmdProgram::ApplyPartitioningToBatch(programs, kPhases);
+    FAIL() << "expected partitioning the batch to be cancelled";
+  } catch (const std::runtime_error& error) {
+    EXPECT_THAT(error.what(), HasSubstr("was cancelled"));
+  }
+  EXPECT_TRUE(imported);
+  EXPECT_FALSE(optimized);
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
@@ -0,0 +1,168 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/integrations/python/jax/mpmd/jaxlib/partitioning_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/logging.h"
+
+namespace mlir::mpmd {
+
+PartitioningCache::PartitioningCache(std::string cache_dir,
+                                     int64_t max_entries)
+    : cache_dir_(std::move(cache_dir)), max_entries_(max_entries) {
+  SDY_CHECK_GT(max_entries_, 0);
+  if (!cache_dir_.empty()) {
+    if (std::error_code error = llvm::sys::fs::create_directories(cache_dir_)) {
+      SDY_LOG(WARNING) << "Failed to create MPMD partitioning cache directory "
+                       << cache_dir_ << ": " << error.message();
+    }
+  }
+}
+
+std::string PartitioningCache::GetFilePath(StringRef key) const {
+  SmallString<128> path(cache_dir_);
+  llvm::sys::path::append(path, key + ".mlirbc");
+  return path.str().str();
+}
+
+void PartitioningCache::InsertInMemory(StringRef key, std::string bytecode) {
+  entry_by_key_[key] = Entry{std::move(bytecode), ++use_counter_};
+  while (static_cast<int64_t>(entry_by_key_.size()) > max_entries_) {
+    auto lru = llvm::min_element(entry_by_key_, [](const auto& lhs,
+                                                   const auto& rhs) {
+      return lhs.getValue().last_use < rhs.getValue().last_use;
+    });
+    entry_by_key_.erase(lru);
+  }
+}
+
+void PartitioningCache::Drop(StringRef key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry_by_key_.erase(key);
+  }
+  if (!cache_dir_.empty()) {
+    // The file may not exist, e.g., if another process already dropped it.
+    (void)llvm::sys::fs::remove(GetFilePath(key));
+  }
+}
+
+OwningOpRef<ModuleOp> PartitioningCache::Lookup(StringRef key,
+                                                MLIRContext* context) {
+  std::string bytecode;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = entry_by_key_.find(key); it != entry_by_key_.end()) {
+      it->getValue().last_use = ++use_counter_;
+      bytecode = it->getValue().bytecode;
+    }
+  }
+  if (bytecode.empty() && !cache_dir_.empty()) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFile(GetFilePath(key));
+    if (!buffer) {
+      return nullptr;
+    }
+    bytecode = (*buffer)->getBuffer().str();
+    std::lock_guard<std::mutex> lock(mutex_);
+    InsertInMemory(key, bytecode);
+  }
+  if (bytecode.empty()) {
+    return nullptr;
+  }
+
+  // A corrupted entry must not surface as a partitioning error, so swallow the
+  // parser diagnostics and let the caller partition the program instead.
+  std::string parse_error;
+  OwningOpRef<ModuleOp> module;
+  {
+    ScopedDiagnosticHandler diag_handler(context, [&](Diagnostic& diag) {
+      parse_error = diag.str();
+      return success();
+    });
+    module = parseSourceString<ModuleOp>(bytecode, context);
+  }
+  if (!module) {
+    SDY_LOG(WARNING) << "Dropping MPMD partitioning cache entry " << key.str()
+                     << " that failed to parse: " << parse_error;
+    Drop(key);
+  }
+  return module;
+}
+
+void PartitioningCache::Insert(StringRef key, ModuleOp module) {
+  std::string bytecode;
+  llvm::raw_string_ostream os(bytecode);
+  if (failed(writeBytecodeToFile(module, os))) {
+    SDY_LOG(WARNING) << "Failed to serialize module to bytecode, not caching "
+                     << "it in the MPMD partitioning cache";
+    return;
+  }
+  if (!cache_dir_.empty()) {
+    // Written to a temporary file that is then renamed, so that concurrent
+    // readers never see a partial entry.
+    if (llvm::Error error = llvm::writeToOutput(
+            GetFilePath(key), [&](llvm::raw_ostream& file_os) {
+              file_os << bytecode;
+              return llvm::Error::success();
+            })) {
+      SDY_LOG(WARNING) << "Failed to write MPMD partitioning cache entry: "
+                       << llvm::toString(std::move(error));
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  InsertInMemory(key, std::move(bytecode));
+}
+
+int64_t PartitioningCache::GetNumEntriesInMemory() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entry_by_key_.size();
+}
+
+PartitioningCache& GetSharedPartitioningCache(StringRef cache_dir) {
+  static auto* mutex = new std::mutex();
+  static auto* caches =
+      new llvm::StringMap<std::unique_ptr<PartitioningCache>>();
+  std::lock_guard<std::mutex> lock(*mutex);
+  std::unique_ptr<PartitioningCache>& cache = (*caches)[cache_dir];
+  if (!cache) {
+    cache = std::make_unique<PartitioningCache>(cache_dir.str());
+  }
+  return *cache;
+}
+
+}  // namespace mlir::mpmd
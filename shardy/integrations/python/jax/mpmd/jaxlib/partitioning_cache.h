@@ -0,0 +1,90 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_INTEGRATIONS_PYTHON_JAX_MPMD_JAXLIB_PARTITIONING_CACHE_H_
+#define SHARDY_INTEGRATIONS_PYTHON_JAX_MPMD_JAXLIB_PARTITIONING_CACHE_H_
+
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+
+namespace mlir::mpmd {
+
+// A content-addressed cache of partitioned MPMD modules, so that partitioning
+// the same program with the same options again can skip the partitioner.
+//
+// Entries are keyed by a fingerprint of everything that affects partitioning
+// (see `MpmdProgram::ComputeCacheKey`) and hold the bytecode of the resulting
+// module. At most `max_entries` entries are kept in memory, evicting the least
+// recently used one. Files in the cache directory are never removed, except
+// for entries that fail to parse.
+//
+// Thread-safe.
+class PartitioningCache {
+ public:
+  static constexpr int64_t kDefaultMaxEntries = 64;
+
+  // If `cache_dir` isn't empty, entries are also written to and read from
+  // files in it, so that they can be shared across processes and hosts.
+  explicit PartitioningCache(std::string cache_dir = "",
+                             int64_t max_entries = kDefaultMaxEntries);
+
+  // Returns the module cached for `key`, parsed in `context`, or null if there
+  // is none. An entry that fails to parse, e.g., because its file is
+  // corrupted, is dropped and treated as a miss.
+  OwningOpRef<ModuleOp> Lookup(llvm::StringRef key, MLIRContext* context);
+
+  // Caches `module` for `key`, replacing any existing entry.
+  void Insert(llvm::StringRef key, ModuleOp module);
+
+  // Returns the number of entries held in memory.
+  int64_t GetNumEntriesInMemory();
+
+ private:
+  struct Entry {
+    std::string bytecode;
+    uint64_t last_use;
+  };
+
+  // Returns the path of the file of `key` in `cache_dir_`.
+  std::string GetFilePath(llvm::StringRef key) const;
+
+  // Adds or replaces the entry of `key` and evicts the least recently used
+  // entries beyond `max_entries_`. Requires `mutex_` to be held.
+  void InsertInMemory(llvm::StringRef key, std::string bytecode);
+
+  // Removes the entry of `key` from memory and from the cache directory.
+  void Drop(llvm::StringRef key);
+
+  std::string cache_dir_;
+  int64_t max_entries_;
+  std::mutex mutex_;
+  uint64_t use_counter_ = 0;
+  llvm::StringMap<Entry> entry_by_key_;
+};
+
+// Returns the cache shared by all programs partitioned in this process with
+// the given cache directory, creating it if needed.
+PartitioningCache& GetSharedPartitioningCache(llvm::StringRef cache_dir);
+
+}  // namespace mlir::mpmd
+
+#endif  // SHARDY_INTEGRATIONS_PYTHON_JAX_MPMD_JAXLIB_PARTITIONING_CACHE_H_
@@ -0,0 +1,156 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/integrations/python/jax/mpmd/jaxlib/partitioning_cache.h"
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include <gtest/gtest.h>
+
+namespace mlir::mpmd {
+namespace {
+
+const char kProgram[] = R"mlir(
+func.func public @main(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %0 = stablehlo.add %arg0, %arg0 : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+)mlir";
+
+std::string PrintModule(ModuleOp module) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  module.print(os);
+  return str;
+}
+
+class PartitioningCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    loadAllRequiredDialects(&context_);
+    module_ = parseSourceString<ModuleOp>(kProgram, &context_);
+    ASSERT_TRUE(module_);
+  }
+
+  // Returns a new directory for the test, which is removed on teardown.
+  std::string CreateCacheDir() {
+    SmallString<128> dir;
+    EXPECT_FALSE(llvm::sys::fs::createUniqueDirectory("mpmd_cache", dir));
+    cache_dirs_.push_back(dir.str().str());
+    return cache_dirs_.back();
+  }
+
+  void TearDown() override {
+    for (const std::string& dir : cache_dirs_) {
+      llvm::sys::fs::remove_directories(dir);
+    }
+  }
+
+  MLIRContext context_;
+  OwningOpRef<ModuleOp> module_;
+  std::vector<std::string> cache_dirs_;
+};
+
+TEST_F(PartitioningCacheTest, MissReturnsNull) {
+  PartitioningCache cache;
+  EXPECT_FALSE(cache.Lookup("key", &context_));
+}
+
+TEST_F(PartitioningCacheTest, HitReturnsInsertedModule) {
+  PartitioningCache cache;
+  cache.Insert("key", *module_);
+  OwningOpRef<ModuleOp> cached = cache.Lookup("key", &context_);
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(PrintModule(*cached), PrintModule(*module_));
+  EXPECT_FALSE(cache.Lookup("other_key", &context_));
+}
+
+TEST_F(PartitioningCacheTest, EvictsLeastRecentlyUsedEntry) {
+  PartitioningCache cache(/*cache_dir=*/"", /*max_entries=*/2);
+  cache.Insert("a", *module_);
+  cache.Insert("b", *module_);
+  // Makes "b" the least recently used entry.
+  EXPECT_TRUE(cache.Lookup("a", &context_));
+  cache.Insert("c", *module_);
+
+  EXPECT_EQ(cache.GetNumEntriesInMemory(), 2);
+  EXPECT_TRUE(cache.Lookup("a", &context_));
+  EXPECT_FALSE(cache.Lookup("b", &context_));
+  EXPECT_TRUE(cache.Lookup("c", &context_));
+}
+
+TEST_F(PartitioningCacheTest, EvictedEntryIsReloadedFromCacheDir) {
+  PartitioningCache cache(CreateCacheDir(), /*max_entries=*/1);
+  cache.Insert("a", *module_);
+  cache.Insert("b", *module_);
+  EXPECT_EQ(cache.GetNumEntriesInMemory(), 1);
+  EXPECT_TRUE(cache.Lookup("a", &context_));
+}
+
+TEST_F(PartitioningCacheTest, EntriesAreSharedThroughCacheDir) {
+  std::string cache_dir = CreateCacheDir();
+  PartitioningCache writer(cache_dir);
+  writer.Insert("key", *module_);
+
+  PartitioningCache reader(cache_dir);
+  OwningOpRef<ModuleOp> cached = reader.Lookup("key", &context_);
+  ASSERT_TRUE(cached);
+  EXPECT_EQ(PrintModule(*cached), PrintModule(*module_));
+}
+
+TEST_F(PartitioningCacheTest, CorruptedEntryIsDropped) {
+  std::string cache_dir = CreateCacheDir();
+  SmallString<128> path(cache_dir);
+  llvm::sys::path::append(path, "key.mlirbc");
+  {
+    std::error_code error;
+    llvm::raw_fd_ostream os(path, error);
+    ASSERT_FALSE(error);
+    os << "not bytecode";
+  }
+
+  PartitioningCache cache(cache_dir);
+  EXPECT_FALSE(cache.Lookup("key", &context_));
+  EXPECT_FALSE(llvm::sys::fs::exists(path));
+  EXPECT_EQ(cache.GetNumEntriesInMemory(), 0);
+
+  // A valid entry can be cached again under the same key.
+  cache.Insert("key", *module_);
+  EXPECT_TRUE(PartitioningCache(cache_dir).Lookup("key", &context_));
+}
+
+TEST_F(PartitioningCacheTest, SharedCacheIsPerDirectory) {
+  std::string cache_dir = CreateCacheDir();
+  EXPECT_EQ(&GetSharedPartitioningCache(cache_dir),
+            &GetSharedPartitioningCache(cache_dir));
+  EXPECT_NE(&GetSharedPartitioningCache(cache_dir),
+            &GetSharedPartitioningCache(CreateCacheDir()));
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
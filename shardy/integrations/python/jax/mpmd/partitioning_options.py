@@ -44,4 +44,10 @@ MPMD_PIPELINE_SCHEDULE_VALUES = frozenset({
     'ParallelPipelinesWithWrapAround',
 })
 
-MPMD_OPTIONS = MPMD_BOOLEAN_OPTIONS | frozenset({MPMD_PIPELINE_SCHEDULE_OPTION})
+# If set, partitioned programs are cached in this directory, and partitioning an
+# identical program again reuses the cached result.
+MPMD_PARTITIONING_CACHE_DIR_OPTION = 'mpmd_partitioning_cache_dir'
+
+MPMD_OPTIONS = MPMD_BOOLEAN_OPTIONS | frozenset(
+    {MPMD_PIPELINE_SCHEDULE_OPTION, MPMD_PARTITIONING_CACHE_DIR_OPTION}
+)
@@ -26,14 +26,21 @@ merging of these fragments. Rule builders take lists of fragments and build
 concrete scheduling/merging rules - these rules determine how fragments are
 scheduled and merged together.
 
-There are two main approaches to defining pipeline schedules:
+There are three main approaches to defining pipeline schedules:
 
 1. Predicate-based approach (recommended for simple patterns):
    Use binary predicates with helper functions to automatically generate rules.
    `schedule_impl.py` contains implementations of common schedules using these
    predicates.
 
-2. Direct construction (for complex custom schedules):
+2. Rank-key approach (recommended for schedules that totally order the
+   fragments of each mesh, e.g., with many stages):
+   Use a key function that is evaluated once per fragment, and build a single
+   ordering rule per mesh by sorting the fragments by key. Unlike predicates,
+   this needs O(F log F) work and O(F) ordering constraints for F fragments
+   per mesh, instead of O(F^2).
+
+3. Direct construction (for complex custom schedules):
    Explicitly build execution order and merge rules for full control.
 
 This is best shown through example: see `pipeline_test.py` for a concrete
@@ -66,6 +73,11 @@ RuleGeneratorPredicate = Callable[
     ['FragmentInfo', 'FragmentInfo', 'PipelineContext'], bool
 ]
 
+# Function returning the rank of a fragment in a schedule, where fragments of
+# the same mesh are scheduled in ascending rank order, or None if the fragment
+# isn't ordered by the schedule.
+RankKey = Callable[['FragmentInfo', 'PipelineContext'], tuple[int, ...] | None]
+
 
 @dataclasses.dataclass(frozen=True)
 class FragmentOrigin:
@@ -238,6 +250,57 @@ def build_schedule_rules_from_predicate(
   return res, []
 
 
+def build_schedule_rules_from_rank_key(
+    fragment_infos: Sequence[FragmentInfo],
+    context: PipelineContext,
+    *,
+    rank_key: RankKey,
+) -> tuple[FragmentScheduleRules, FragmentMergeRules]:
+  """Builds one scheduling rule per mesh by sorting fragments by `rank_key`.
+
+  `rank_key` is evaluated once per fragment. Fragments for which it returns
+  None are left unordered.
+
+  Args:
+    fragment_infos: List of fragments to create schedule rules for.
+    context: PipelineContext object containing additional context for the
+      scheduling process.
+    rank_key: Function returning the rank of a fragment in the schedule.
+
+  Returns:
+    Tuple of (schedule_rules, merge_rules) where merge_rules is empty.
+
+  Raises:
+    ValueError: If two fragments of the same mesh have the same rank, as the
+      relative order of such fragments would be arbitrary.
+  """
+  mesh_to_ranked_fragments = collections.defaultdict(list)
+  for fragment in fragment_infos:
+    rank = rank_key(fragment, context)
+    if rank is not None:
+      mesh_to_ranked_fragments[fragment.mesh_name].append((rank, fragment))
+
+  res = []
+  for ranked_fragments in mesh_to_ranked_fragments.values():
+    if len(ranked_fragments) < 2:
+      continue
+    ranked_fragments.sort(key=lambda ranked_fragment: ranked_fragment[0])
+    for (rank_a, a), (rank_b, b) in zip(
+        ranked_fragments, ranked_fragments[1:]
+    ):
+      if rank_a == rank_b:
+        raise ValueError(
+            f'Fragments {a} and {b} have the same rank {rank_a}, but ranks'
+            ' must be unique within a mesh.'
+        )
+    res.append(
+        FragmentScheduleRule(
+            ordered_fragments=[fragment for _, fragment in ranked_fragments]
+        )
+    )
+  return res, []
+
+
 def union_fragment_origins(
     source_fragments: Sequence[FragmentInfo],
 ) -> tuple[FragmentOrigin, ...]:
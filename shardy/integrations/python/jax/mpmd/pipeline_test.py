@@ -108,6 +108,70 @@ class BasicScheduleBuildTest(unittest.TestCase):
     self.assertEqual(len(schedule.schedule_merge_rule_builders), 1)
 
 
+class BuildScheduleRulesFromRankKeyTest(unittest.TestCase):
+
+  def _fragment(self, **kwargs):
+    return _make_fragment(origins=(pipeline.FragmentOrigin("f"),), **kwargs)
+
+  def _rank_by_call_counter(self, f, _):
+    if f.call_counter is None:
+      return None
+    return (-f.call_counter,)
+
+  def test_one_rule_per_mesh_in_rank_order(self):
+    f0 = self._fragment(mesh_name="mesh1", call_counter=0)
+    f1 = self._fragment(mesh_name="mesh1", call_counter=1)
+    f2 = self._fragment(mesh_name="mesh1", call_counter=2)
+    g0 = self._fragment(mesh_name="mesh2", call_counter=0)
+    g1 = self._fragment(mesh_name="mesh2", call_counter=1)
+
+    schedule_rules, merge_rules = (
+        pipeline.build_schedule_rules_from_rank_key(
+            [f0, g0, f1, g1, f2],
+            pipeline.PipelineContext(num_meshes=2),
+            rank_key=self._rank_by_call_counter,
+        )
+    )
+
+    self.assertEqual(
+        [rule.ordered_fragments for rule in schedule_rules],
+        [[f2, f1, f0], [g1, g0]],
+    )
+    self.assertEqual(merge_rules, [])
+
+  def test_unranked_fragments_are_skipped(self):
+    f0 = self._fragment(call_counter=0)
+    f1 = self._fragment(call_counter=1)
+    unranked = self._fragment()
+    other_mesh = self._fragment(mesh_name="mesh2", call_counter=0)
+
+    schedule_rules, _ = pipeline.build_schedule_rules_from_rank_key(
+        [f0, unranked, f1, other_mesh],
+        pipeline.PipelineContext(num_meshes=2),
+        rank_key=self._rank_by_call_counter,
+    )
+
+    # The single ranked fragment of mesh2 doesn't need a rule.
+    self.assertEqual(
+        [rule.ordered_fragments for rule in schedule_rules], [[f1, f0]]
+    )
+
+  def test_duplicate_rank_raises_error(self):
+    f0 = _make_fragment(
+        origins=(pipeline.FragmentOrigin("a"),), call_counter=0
+    )
+    f1 = _make_fragment(
+        origins=(pipeline.FragmentOrigin("b"),), call_counter=0
+    )
+
+    with self.assertRaisesRegex(ValueError, "have the same rank"):
+      pipeline.build_schedule_rules_from_rank_key(
+          [f0, f1],
+          pipeline.PipelineContext(num_meshes=1),
+          rank_key=self._rank_by_call_counter,
+      )
+
+
 class MinimalCreateTargetInfoTest(parameterized.TestCase):
 
   def test_empty_source_fragments_raises_error(self):
@@ -12,7 +12,12 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 # ==============================================================================
-"""Implementations of common pipeline scheduling predicates for MPMD."""
+"""Implementations of common pipeline scheduling predicates for MPMD.
+
+Schedules that totally order the fragments of each mesh also have a rank key,
+for `pipeline.build_schedule_rules_from_rank_key`, whose order agrees with the
+predicate of the schedule on every pair of fragments the predicate orders.
+"""
 
 from typing import Callable
 
@@ -79,6 +84,51 @@ def one_fwd_one_bwd_schedule_predicate(
   return False
 
 
+def gpipe_schedule_rank_key(
+    f: pipeline.FragmentInfo,
+    _: pipeline.PipelineContext,
+) -> tuple[int, ...] | None:
+  """Returns the rank of `f` in a GPipe schedule."""
+  transpose_count = pipeline.maybe_unique_transpose_count(f)
+  if transpose_count is None or f.call_counter is None:
+    return None
+  return (transpose_count, f.call_counter)
+
+
+def one_fwd_one_bwd_schedule_rank_key(
+    f: pipeline.FragmentInfo,
+    context: pipeline.PipelineContext,
+) -> tuple[int, ...] | None:
+  """Returns the rank of `f` in a 1F1B schedule.
+
+  On stage `s` of a pipeline of depth `n`, the first `k = n - s` forward
+  fragments come first (warmup), then backward and forward fragments
+  alternate: bwd 0, fwd k, bwd 1, fwd k + 1, and so on.
+
+  Args:
+    f: The fragment to rank.
+    context: The pipeline context.
+
+  Returns:
+    The rank of `f`, or None if it isn't a scheduling unit.
+
+  Raises:
+    ValueError: If `stage_id` is not set on the fragment.
+  """
+  info = pipeline.get_scheduling_unit_info(f)
+  if info is None:
+    return None
+  if f.stage_id is None:
+    raise ValueError("All fragments must have a stage id for 1F1B scheduling.")
+  call_counter, transpose_count = info
+  k = max(context.num_meshes - f.stage_id, 1)
+  if transpose_count == 1:
+    return (k + 2 * call_counter,)
+  if call_counter < k:
+    return (call_counter,)
+  return (2 * call_counter - k + 1,)
+
+
 def gpipe_with_1f1b_on_last_mesh_schedule_predicate(
     f1: pipeline.FragmentInfo,
     f2: pipeline.FragmentInfo,
@@ -98,6 +148,23 @@ def gpipe_with_1f1b_on_last_mesh_schedule_predicate(
   return gpipe_schedule_predicate(f1, f2, context)
 
 
+def gpipe_with_1f1b_on_last_mesh_schedule_rank_key(
+    f: pipeline.FragmentInfo,
+    context: pipeline.PipelineContext,
+) -> tuple[int, ...] | None:
+  """Returns the rank of `f` in a GPipe schedule with 1F1B on the last mesh."""
+  if pipeline.get_scheduling_unit_info(f) is None:
+    return None
+  if f.stage_id is None:
+    raise ValueError(
+        "All fragments must have a stage id for GPipe with 1F1B on the last"
+        " mesh scheduling."
+    )
+  if f.stage_id == context.num_meshes - 1:
+    return one_fwd_one_bwd_schedule_rank_key(f, context)
+  return gpipe_schedule_rank_key(f, context)
+
+
 def circular_schedule_predicate_base(
     f1: pipeline.FragmentInfo,
     f2: pipeline.FragmentInfo,
@@ -463,6 +463,9 @@ def _validate_partitioning_options(
         raise ValueError(
             f'Option {k} has value {v}, which is not a valid pipeline schedule.'
         )
+    elif k == part_options.MPMD_PARTITIONING_CACHE_DIR_OPTION:
+      if not isinstance(v, str):
+        raise ValueError(f'Option {k} has value {v}, which is not a string.')
     else:
       # Raise exception to guard against adding new PartIR MPMD options without
       # extending this function to handle them.
@@ -222,6 +222,21 @@ class MakePartitioningOptionsTest(parameterized.TestCase):
         {'mpmd_pipeline_schedule': schedule_as_str}
     )
 
+  def test_partitioning_cache_dir_option(self):
+    types._validate_partitioning_options(
+        {'mpmd_partitioning_cache_dir': '/tmp/mpmd_cache'}
+    )
+
+  def test_non_string_partitioning_cache_dir_raises(self):
+    with self.assertRaisesRegex(
+        ValueError,
+        'Option mpmd_partitioning_cache_dir has value True, which is not a'
+        ' string.',
+    ):
+      types._validate_partitioning_options(
+          {'mpmd_partitioning_cache_dir': True}
+      )
+
   def test_unsupported_option_raises(self):
     with self.assertRaisesRegex(
         ValueError,
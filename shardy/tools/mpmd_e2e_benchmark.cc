@@ -0,0 +1,537 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// End-to-end compile benchmark for the combined SDY and MPMD pipelines.
+//
+// Generates pipelined training programs like
+// `shardy/dialect/mpmd/transforms/test/e2e_pipeline.mlir`, i.e., a named
+// computation per stage whose forward and backward computations are called
+// once per microbatch, scaled by the number of layers per stage, stages,
+// microbatches and devices per mesh. Each program runs through the import
+// (including mesh inference), optimize, sharding propagation and export
+// pipelines, and the benchmark reports the wall time, the peak RSS of the
+// process and the size of the printed module after each of them.
+//
+// The results can be saved as a baseline, and compared against a saved
+// baseline, in which case the benchmark fails if the median time, peak RSS or
+// output size of any stage exceeds its baseline by more than `--tolerance`.
+// `--filter` matches the name of a program, e.g.,
+// `layers=2,stages=4,microbatches=4,mesh_size=4`.
+//
+// Usage:
+//   mpmd_e2e_benchmark [--layers=<n>,...] [--stages=<n>,...]
+//     [--microbatches=<n>,...] [--mesh-size=<n>,...] [--schedule=<schedule>]
+//     [--repetitions=<n>] [--filter=<regex>] [--baseline=<file>]
+//     [--write-baseline=<file>] [--tolerance=<ratio>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/benchmark_util.h"
+#include "shardy/common/save_module_op.h"
+#include "shardy/common/timing_report.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/mpmd/transforms/export/passes.h"
+#include "shardy/dialect/mpmd/transforms/import/passes.h"
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h"
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+#include "shardy/dialect/mpmd/transforms/sharding_propagation/passes.h"
+
+namespace mlir::mpmd {
+namespace {
+
+llvm::cl::list<int64_t> layers_flag(
+    "layers", llvm::cl::desc("The numbers of layers of each stage."),
+    llvm::cl::CommaSeparated, llvm::cl::list_init<int64_t>({2}));
+
+llvm::cl::list<int64_t> stages_flag(
+    "stages", llvm::cl::desc("The numbers of pipeline stages, i.e., meshes."),
+    llvm::cl::CommaSeparated, llvm::cl::list_init<int64_t>({2, 4, 8}));
+
+llvm::cl::list<int64_t> microbatches_flag(
+    "microbatches", llvm::cl::desc("The numbers of microbatches."),
+    llvm::cl::CommaSeparated, llvm::cl::list_init<int64_t>({4}));
+
+llvm::cl::list<int64_t> mesh_size_flag(
+    "mesh-size", llvm::cl::desc("The numbers of devices of each mesh."),
+    llvm::cl::CommaSeparated, llvm::cl::list_init<int64_t>({4}));
+
+llvm::cl::opt<std::string> schedule_flag(
+    "schedule",
+    llvm::cl::desc("The pipeline schedule of the optimize pipeline."),
+    llvm::cl::init("1F1B"));
+
+llvm::cl::opt<std::string> baseline_flag(
+    "baseline",
+    llvm::cl::desc("A JSON file written by `--write-baseline` to compare the "
+                   "results against."),
+    llvm::cl::init(""));
+
+llvm::cl::opt<std::string> write_baseline_flag(
+    "write-baseline",
+    llvm::cl::desc("A JSON file to save the results to, as a baseline."),
+    llvm::cl::init(""));
+
+llvm::cl::opt<double> tolerance_flag(
+    "tolerance",
+    llvm::cl::desc("The relative increase over the baseline of any result "
+                   "that counts as a regression."),
+    llvm::cl::init(0.25));
+
+// The batch and hidden dimensions of the activations and weights.
+constexpr int64_t kBatchSize = 32;
+constexpr int64_t kHiddenSize = 64;
+
+struct ProgramShape {
+  int64_t num_layers;
+  int64_t num_stages;
+  int64_t num_microbatches;
+  int64_t mesh_size;
+
+  std::string Name() const {
+    return llvm::formatv("layers={0},stages={1},microbatches={2},mesh_size={3}",
+                         num_layers, num_stages, num_microbatches, mesh_size)
+        .str();
+  }
+};
+
+std::string StageName(int64_t stage) {
+  return llvm::formatv("stage{0}", stage).str();
+}
+
+// Returns a reference to result `index` of the op whose results are named
+// `name`, given that it has `num_results` results.
+std::string ResultRef(StringRef name, int64_t index, int64_t num_results) {
+  return num_results == 1 ? name.str()
+                          : llvm::formatv("{0}#{1}", name, index).str();
+}
+
+// Returns `name` or `name:<num_results>` for the results of an op.
+std::string ResultDef(StringRef name, int64_t num_results) {
+  return num_results == 1 ? name.str()
+                          : llvm::formatv("{0}:{1}", name, num_results).str();
+}
+
+// Prints `count` comma-separated copies of `type`.
+void PrintTypes(raw_ostream& os, int64_t count, StringRef type) {
+  llvm::interleaveComma(llvm::seq<int64_t>(0, count), os,
+                        [&](int64_t) { os << type; });
+}
+
+// Returns a program where `@microbatch` runs the forward named computation of
+// each stage in order, each a chain of `num_layers` matmuls with their own
+// weights followed by a non-linearity, and then the backward named
+// computations in reverse, which return the weight gradient of their stage.
+// `@main` calls `@microbatch` for every microbatch and accumulates the weight
+// gradients.
+std::string GenerateProgram(const ProgramShape& shape) {
+  const int64_t num_weights = shape.num_stages * shape.num_layers;
+  const std::string act_type =
+      llvm::formatv("tensor<{0}x{1}xf32>", kBatchSize, kHiddenSize).str();
+  const std::string weight_type =
+      llvm::formatv("tensor<{0}x{0}xf32>", kHiddenSize).str();
+
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  os << "func.func public @main(";
+  llvm::interleaveComma(
+      llvm::seq<int64_t>(0, shape.num_microbatches), os,
+      [&](int64_t i) { os << "%x" << i << ": " << act_type; });
+  for (int64_t w = 0; w < num_weights; ++w) {
+    os << ", %w" << w << ": " << weight_type;
+  }
+  os << ") -> (";
+  PrintTypes(os, shape.num_stages, weight_type);
+  os << ") attributes {topology = #mpmd.topology<";
+  llvm::interleaveComma(
+      llvm::seq<int64_t>(0, shape.num_stages), os, [&](int64_t s) {
+        os << llvm::formatv("<\"m{0}\" : <[\"x\"={1}]>>", s, shape.mesh_size);
+      });
+  os << ">} {\n";
+  for (int64_t mb = 0; mb < shape.num_microbatches; ++mb) {
+    os << "  " << ResultDef(llvm::formatv("%c{0}", mb).str(), shape.num_stages)
+       << " = mpmd.call @microbatch(%x" << mb;
+    for (int64_t w = 0; w < num_weights; ++w) {
+      os << ", %w" << w;
+    }
+    os << llvm::formatv(") {{call_counter = {0} : ui32} : (", mb) << act_type;
+    for (int64_t w = 0; w < num_weights; ++w) {
+      os << ", " << weight_type;
+    }
+    os << ") -> (";
+    PrintTypes(os, shape.num_stages, weight_type);
+    os << ")\n";
+    for (int64_t s = 0; s < shape.num_stages && mb > 0; ++s) {
+      std::string previous =
+          mb == 1 ? ResultRef("%c0", s, shape.num_stages)
+                  : llvm::formatv("%acc{0}_{1}", mb - 1, s).str();
+      os << llvm::formatv("  %acc{0}_{1} = stablehlo.add {2}, {3} : {4}\n", mb,
+                          s, previous,
+                          ResultRef(llvm::formatv("%c{0}", mb).str(), s,
+                                    shape.num_stages),
+                          weight_type);
+    }
+  }
+  os << "  return ";
+  llvm::interleaveComma(
+      llvm::seq<int64_t>(0, shape.num_stages), os, [&](int64_t s) {
+        const int64_t last = shape.num_microbatches - 1;
+        os << (last == 0 ? ResultRef("%c0", s, shape.num_stages)
+                         : llvm::formatv("%acc{0}_{1}", last, s).str());
+      });
+  os << " : ";
+  PrintTypes(os, shape.num_stages, weight_type);
+  os << "\n}\n\n";
+
+  os << "func.func private @microbatch(%x: " << act_type;
+  for (int64_t w = 0; w < num_weights; ++w) {
+    os << ", %w" << w << ": " << weight_type;
+  }
+  os << ") -> (";
+  PrintTypes(os, shape.num_stages, weight_type);
+  os << ") {\n";
+
+  // The weights of a stage as operands, block arguments and operand types.
+  auto print_stage_weights = [&](int64_t s) {
+    for (int64_t l = 0; l < shape.num_layers; ++l) {
+      os << ", %w" << s * shape.num_layers + l;
+    }
+  };
+  auto print_weight_args = [&]() {
+    for (int64_t l = 0; l < shape.num_layers; ++l) {
+      os << ", %p" << l << ": " << weight_type;
+    }
+  };
+  auto print_weight_types = [&]() {
+    for (int64_t l = 0; l < shape.num_layers; ++l) {
+      os << ", " << weight_type;
+    }
+  };
+
+  // Forward computations, where `%h<s>` is the input of stage `s`.
+  os << "  %h0 = stablehlo.negate %x : " << act_type << "\n";
+  for (int64_t s = 0; s < shape.num_stages; ++s) {
+    os << llvm::formatv("  %h{0} = mpmd.named_computation<\"{1}\"> (%h{2}",
+                        s + 1, StageName(s), s);
+    print_stage_weights(s);
+    os << ") (%a: " << act_type;
+    print_weight_args();
+    os << ") {\n";
+    for (int64_t l = 0; l < shape.num_layers; ++l) {
+      os << llvm::formatv(
+          "    %d{0} = stablehlo.dot_general {1}, %p{0}, contracting_dims = "
+          "[1] x [0] : ({2}, {3}) -> {2}\n"
+          "    %y{0} = stablehlo.tanh %d{0} : {2}\n",
+          l, l == 0 ? "%a" : llvm::formatv("%y{0}", l - 1).str(), act_type,
+          weight_type);
+    }
+    os << llvm::formatv("    mpmd.return %y{0} : {1}\n", shape.num_layers - 1,
+                        act_type);
+    os << "  } : (" << act_type;
+    print_weight_types();
+    os << ") -> " << act_type << "\n";
+  }
+
+  // Backward computations, where `%g<s>` is the gradient of the output of
+  // stage `s`, and `%b<s>#1` the gradient of its weights.
+  os << llvm::formatv("  %g{0} = stablehlo.negate %h{0} : {1}\n",
+                      shape.num_stages, act_type);
+  for (int64_t s = shape.num_stages - 1; s >= 0; --s) {
+    os << llvm::formatv(
+        "  %b{0}:2 = mpmd.named_computation<\"{1}\"(1)> (%g{2}, %h{0}", s,
+        StageName(s), s + 1);
+    print_stage_weights(s);
+    os << ") (%g: " << act_type << ", %a: " << act_type;
+    print_weight_args();
+    os << ") {\n";
+    os << llvm::formatv(
+        "    %gw = stablehlo.dot_general %a, %g, contracting_dims = [0] x [0] "
+        ": ({0}, {0}) -> {1}\n",
+        act_type, weight_type);
+    for (int64_t l = shape.num_layers - 1; l >= 0; --l) {
+      os << llvm::formatv(
+          "    %e{0} = stablehlo.dot_general {1}, %p{0}, contracting_dims = "
+          "[1] x [1] : ({2}, {3}) -> {2}\n",
+          l,
+          l == shape.num_layers - 1 ? "%g"
+                                    : llvm::formatv("%e{0}", l + 1).str(),
+          act_type, weight_type);
+    }
+    os << llvm::formatv(
+        "    %ga = stablehlo.multiply %e0, %a : {0}\n"
+        "    mpmd.return %ga, %gw : {0}, {1}\n",
+        act_type, weight_type);
+    os << "  } : (" << act_type << ", " << act_type;
+    print_weight_types();
+    os << ") -> (" << act_type << ", " << weight_type << ")\n";
+    os << llvm::formatv("  %g{0} = stablehlo.add %b{0}#0, %b{0}#0 : {1}\n", s,
+                        act_type);
+  }
+  os << "  return ";
+  llvm::interleaveComma(llvm::seq<int64_t>(0, shape.num_stages), os,
+                        [&](int64_t s) { os << "%b" << s << "#1"; });
+  os << " : ";
+  PrintTypes(os, shape.num_stages, weight_type);
+  os << "\n}\n";
+  return str;
+}
+
+struct Stage {
+  StringRef name;
+  std::function<void(OpPassManager&, const ProgramShape&, PipelineSchedule)>
+      add_passes;
+};
+
+// The pipelines in the order they run, each on the output of the previous one.
+SmallVector<Stage> GetStages() {
+  return {
+      {"import",
+       [](OpPassManager& pm, const ProgramShape& shape, PipelineSchedule) {
+         ImportOptions options;
+         for (int64_t s = 0; s < shape.num_stages; ++s) {
+           options.nameToMeshAssignment.value[StageName(s)] = {
+               llvm::formatv("m{0}", s).str(), std::nullopt};
+         }
+         addImportPipeline(pm, std::move(options));
+       }},
+      {"optimize",
+       [](OpPassManager& pm, const ProgramShape&, PipelineSchedule schedule) {
+         OptimizeOptions options;
+         options.pipelineSchedule = schedule;
+         addOptimizePipeline(pm, std::move(options));
+       }},
+      {"sharding_propagation",
+       [](OpPassManager& pm, const ProgramShape&, PipelineSchedule) {
+         addShardingPropagationPipeline(pm, /*sdyDumpDir=*/"");
+       }},
+      {"export",
+       [](OpPassManager& pm, const ProgramShape&, PipelineSchedule) {
+         addExportPipeline(pm);
+       }},
+  };
+}
+
+// The results of a stage on a program.
+struct StageResult {
+  std::string name;
+  sdy::BenchmarkTimings timings;
+  // The peak RSS of the process at the end of the first run of the stage.
+  int64_t peak_rss_bytes = 0;
+  // The size of the printed module after the stage.
+  int64_t output_bytes = 0;
+};
+
+int64_t GetPrintedSize(ModuleOp module) {
+  std::string printed;
+  llvm::raw_string_ostream os(printed);
+  module.print(os);
+  return printed.size();
+}
+
+// Runs every stage on the output of the previous one, `--repetitions` times
+// from the generated program, and appends the results of each stage to
+// `results`. Returns false if a pipeline failed.
+bool RunProgram(ModuleOp generated, const ProgramShape& shape,
+                PipelineSchedule schedule,
+                std::vector<StageResult>& results) {
+  SmallVector<Stage> stages = GetStages();
+  std::vector<SmallVector<std::chrono::nanoseconds>> durations(stages.size());
+  std::vector<StageResult> program_results(stages.size());
+  for (int64_t i = 0; i < sdy::getNumRepetitions(); ++i) {
+    OwningOpRef<ModuleOp> module = generated.clone();
+    for (auto [stage_index, stage] : llvm::enumerate(stages)) {
+      PassManager pm(generated.getContext());
+      stage.add_passes(pm, shape, schedule);
+      std::optional<std::chrono::nanoseconds> duration =
+          sdy::timeRun([&]() { return pm.run(*module); });
+      if (!duration) {
+        llvm::errs() << "failed to run the " << stage.name << " pipeline on "
+                     << shape.Name() << "\n";
+        return false;
+      }
+      durations[stage_index].push_back(*duration);
+      StageResult& result = program_results[stage_index];
+      if (i == 0) {
+        result.name = llvm::formatv("{0}/{1}", shape.Name(), stage.name).str();
+        result.peak_rss_bytes = sdy::getPeakRssBytes();
+        result.output_bytes = GetPrintedSize(*module);
+      }
+    }
+  }
+  for (auto [result, stage_durations] :
+       llvm::zip_equal(program_results, durations)) {
+    result.timings = sdy::getTimings(std::move(stage_durations));
+    results.push_back(std::move(result));
+  }
+  return true;
+}
+
+bool WriteBaseline(StringRef file_path, ArrayRef<StageResult> results) {
+  return sdy::writeToFile(file_path, [&](raw_ostream& os) {
+    llvm::json::OStream json(os, /*IndentSize=*/2);
+    json.object([&]() {
+      for (const StageResult& result : results) {
+        json.attributeObject(result.name, [&]() {
+          json.attribute("median_ms", result.timings.medianMs);
+          json.attribute("peak_rss_bytes", result.peak_rss_bytes);
+          json.attribute("output_bytes", result.output_bytes);
+        });
+      }
+    });
+    os << "\n";
+  });
+}
+
+// Compares `results` against the baseline saved in `file_path`, and prints
+// every result that exceeds its baseline by more than `tolerance_flag`.
+// Results missing from the baseline are skipped. Returns false if the baseline
+// can't be read or any result regressed.
+bool CompareWithBaseline(StringRef file_path, ArrayRef<StageResult> results) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(file_path);
+  if (!buffer) {
+    llvm::errs() << llvm::formatv("error when reading file {0}: {1}\n",
+                                  file_path, buffer.getError().message());
+    return false;
+  }
+  llvm::Expected<llvm::json::Value> baseline =
+      llvm::json::parse((*buffer)->getBuffer());
+  if (!baseline || !baseline->getAsObject()) {
+    llvm::errs() << "invalid baseline " << file_path << "\n";
+    if (!baseline) llvm::consumeError(baseline.takeError());
+    return false;
+  }
+
+  bool has_regression = false;
+  auto check = [&](StringRef name, StringRef metric, double value,
+                   std::optional<double> baseline_value) {
+    if (!baseline_value || value <= *baseline_value * (1.0 + tolerance_flag)) {
+      return;
+    }
+    llvm::outs() << llvm::formatv(
+        "regression: {0} {1} is {2:F3}, baseline is {3:F3}\n", name, metric,
+        value, *baseline_value);
+    has_regression = true;
+  };
+  for (const StageResult& result : results) {
+    const llvm::json::Object* entry =
+        baseline->getAsObject()->getObject(result.name);
+    if (!entry) continue;
+    check(result.name, "median_ms", result.timings.medianMs,
+          entry->getNumber("median_ms"));
+    check(result.name, "peak_rss_bytes", result.peak_rss_bytes,
+          entry->getNumber("peak_rss_bytes"));
+    check(result.name, "output_bytes", result.output_bytes,
+          entry->getNumber("output_bytes"));
+  }
+  return !has_regression;
+}
+
+int RunBenchmarks() {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  sdy::applyThreadingFlag(&context);
+
+  std::optional<PipelineSchedule> schedule =
+      ParsePipelineSchedule(schedule_flag);
+  if (!schedule) {
+    llvm::errs() << "invalid --schedule: " << schedule_flag << "\n";
+    return 1;
+  }
+
+  std::vector<StageResult> results;
+  for (int64_t num_layers : layers_flag) {
+    for (int64_t num_stages : stages_flag) {
+      for (int64_t num_microbatches : microbatches_flag) {
+        for (int64_t mesh_size : mesh_size_flag) {
+          ProgramShape shape{std::max<int64_t>(num_layers, 1),
+                             std::max<int64_t>(num_stages, 1),
+                             std::max<int64_t>(num_microbatches, 1),
+                             std::max<int64_t>(mesh_size, 1)};
+          if (!sdy::shouldRunBenchmark(shape.Name())) {
+            continue;
+          }
+          OwningOpRef<ModuleOp> module =
+              parseSourceString<ModuleOp>(GenerateProgram(shape), &context);
+          if (!module) {
+            llvm::errs() << "failed to parse the generated program "
+                         << shape.Name() << "\n";
+            return 1;
+          }
+          if (!RunProgram(*module, shape, *schedule, results)) {
+            return 1;
+          }
+        }
+      }
+    }
+  }
+
+  sdy::BenchmarkTable table(/*name_width=*/72,
+                            {"peak_rss_mb", "output_bytes"});
+  table.printHeader();
+  for (const StageResult& result : results) {
+    table.printRow(
+        result.name,
+        {llvm::formatv("{0:F1}", result.peak_rss_bytes / (1024.0 * 1024.0))
+             .str(),
+         std::to_string(result.output_bytes)},
+        result.timings);
+  }
+
+  if (!write_baseline_flag.empty() &&
+      !WriteBaseline(write_baseline_flag, results)) {
+    return 1;
+  }
+  if (!baseline_flag.empty() && !CompareWithBaseline(baseline_flag, results)) {
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
+
+int main(int argc, char** argv) {
+  llvm::InitLLVM init_llvm(argc, argv);
+  if (mlir::failed(mlir::sdy::parseBenchmarkCommandLine(
+          argc, argv, "MPMD e2e compile benchmark\n",
+          /*defaultRepetitions=*/3))) {
+    return 1;
+  }
+  return mlir::mpmd::RunBenchmarks();
+}
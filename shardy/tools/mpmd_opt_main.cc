@@ -26,6 +26,7 @@ limitations under the License.
 #include "shardy/dialect/mpmd/ir/register.h"
 #include "shardy/dialect/sdy/transforms/passes.h"
 #include "shardy/dialect/mpmd/transforms/passes.h"
+#include "shardy/tools/opt_main.h"
 #include "stablehlo/dialect/ChloOps.h"
 
 
@@ -45,5 +46,5 @@ int main(int argc, char** argv) {
   mlir::mpmd::registerAllMpmdPassesAndPipelines();
 
   return mlir::asMainReturnCode(
-      mlir::MlirOptMain(argc, argv, "MPMD pass driver\n", registry));
+      mlir::sdy::sdyOptMain(argc, argv, "MPMD pass driver\n", registry));
 }
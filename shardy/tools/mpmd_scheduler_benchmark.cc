@@ -0,0 +1,369 @@
+/* Copyright 2026 The MPMD Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmark for the MPMD scheduling passes on synthetic pipelines.
+//
+// Generates MPMD programs with one mesh per stage, where every microbatch runs
+// a chain of forward fragments through the stages followed by the matching
+// backward fragments in reverse, and reports the wall time of each scheduling
+// stage for every pipeline shape, i.e., a scaling curve of time vs the number
+// of fragments.
+//
+// Usage:
+//   mpmd_scheduler_benchmark [--stages=<n>,...] [--microbatches=<n>,...]
+//     [--fragments-per-stage=<n>,...] [--schedule=<schedule>]
+//     [--rank-based-scheduling] [--repetitions=<n>] [--filter=<regex>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/common/benchmark_util.h"
+#include "shardy/dialect/mpmd/ir/fragment_execution_rules.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/mpmd/transforms/common/passes.h"
+#include "shardy/dialect/mpmd/transforms/export/passes.h"
+#include "shardy/dialect/mpmd/transforms/optimize/passes.h"
+#include "shardy/dialect/mpmd/transforms/optimize/pipeline_schedule.h"
+
+namespace mlir::mpmd {
+namespace {
+
+using ::mlir::func::FuncOp;
+
+llvm::cl::list<int64_t> stages_flag(
+    "stages", llvm::cl::desc("The numbers of pipeline stages, i.e., meshes."),
+    llvm::cl::CommaSeparated, llvm::cl::list_init<int64_t>({4, 8, 16, 32}));
+
+llvm::cl::list<int64_t> microbatches_flag(
+    "microbatches", llvm::cl::desc("The numbers of microbatches."),
+    llvm::cl::CommaSeparated, llvm::cl::list_init<int64_t>({8}));
+
+llvm::cl::list<int64_t> fragments_per_stage_flag(
+    "fragments-per-stage",
+    llvm::cl::desc("The numbers of forward fragments of each stage for every "
+                   "microbatch."),
+    llvm::cl::CommaSeparated, llvm::cl::list_init<int64_t>({1}));
+
+llvm::cl::opt<std::string> schedule_flag(
+    "schedule",
+    llvm::cl::desc("The built-in schedule of the pipeline scheduler, which "
+                   "also produces the input of the stages that run on "
+                   "scheduled programs."),
+    llvm::cl::init("1F1B"));
+
+llvm::cl::opt<bool> rank_based_scheduling_flag(
+    "rank-based-scheduling",
+    llvm::cl::desc("Whether the pipeline scheduler sorts fragments by rank."),
+    llvm::cl::init(false));
+
+struct PipelineShape {
+  int64_t num_stages;
+  int64_t num_microbatches;
+  int64_t fragments_per_stage;
+
+  int64_t NumFragments() const {
+    // A forward and a backward fragment per stage, fragment and microbatch.
+    return 2 * num_stages * num_microbatches * fragments_per_stage;
+  }
+};
+
+std::string FragmentName(int64_t stage, int64_t index) {
+  return llvm::formatv("stage{0}_{1}", stage, index).str();
+}
+
+// Returns a program where microbatch `i` runs the forward fragments
+// `stage<s>_<k>` of every stage in order, with `call_counter = i`, transferring
+// the last result of each stage to the next one, and then the backward
+// fragments in reverse. Each backward fragment uses the activation of its
+// forward fragment, returns the gradient for the previous fragment, and
+// accumulates a parameter gradient over the microbatches, which the function
+// returns.
+std::string GeneratePipeline(const PipelineShape& shape) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  for (int64_t s = 0; s < shape.num_stages; ++s) {
+    os << llvm::formatv(
+        "!t{0} = !mpmd.mesh_tensor<\"m{0}\", tensor<16x16xf32>>\n", s);
+  }
+  os << "func.func @main(%arg0: !t0) -> (";
+  llvm::interleaveComma(
+      llvm::seq<int64_t>(0, shape.num_stages * shape.fragments_per_stage), os,
+      [&](int64_t i) { os << "!t" << i / shape.fragments_per_stage; });
+  os << ") attributes {topology = #mpmd.topology<";
+  llvm::interleaveComma(llvm::seq<int64_t>(0, shape.num_stages), os,
+                        [&](int64_t s) {
+                          os << llvm::formatv("<\"m{0}\" : <[\"x\"=1]>>", s);
+                        });
+  os << ">} {\n";
+
+  const int64_t last_stage = shape.num_stages - 1;
+  const int64_t last_fragment = shape.fragments_per_stage - 1;
+  for (int64_t mb = 0; mb < shape.num_microbatches; ++mb) {
+    for (int64_t s = 0; s < shape.num_stages; ++s) {
+      std::string input = "%arg0";
+      if (s > 0) {
+        os << llvm::formatv(
+            "  %x_{0}_{1} = mpmd.transfer %f_{0}_{2}_{3} : (!t{2}) -> !t{1}\n",
+            mb, s, s - 1, last_fragment);
+        input = llvm::formatv("%x_{0}_{1}", mb, s).str();
+      }
+      for (int64_t k = 0; k < shape.fragments_per_stage; ++k) {
+        if (k > 0) {
+          input = llvm::formatv("%f_{0}_{1}_{2}", mb, s, k - 1).str();
+        }
+        os << llvm::formatv(
+            "  %f_{0}_{1}_{2} = mpmd.fragment<mesh=\"m{1}\", "
+            "origin=[\"{3}\"]> ({4}) {{call_counter = {0} : ui32} "
+            "(%a: tensor<16x16xf32>) {{\n"
+            "    %0 = stablehlo.tanh %a : tensor<16x16xf32>\n"
+            "    mpmd.return %0 : tensor<16x16xf32>\n"
+            "  } : (!t{1}) -> !t{1}\n",
+            mb, s, k, FragmentName(s, k), input);
+      }
+    }
+    std::string grad =
+        llvm::formatv("%f_{0}_{1}_{2}", mb, last_stage, last_fragment).str();
+    for (int64_t s = last_stage; s >= 0; --s) {
+      if (s < last_stage) {
+        os << llvm::formatv(
+            "  %y_{0}_{1} = mpmd.transfer {2} : (!t{3}) -> !t{1}\n", mb, s,
+            grad, s + 1);
+        grad = llvm::formatv("%y_{0}_{1}", mb, s).str();
+      }
+      for (int64_t k = last_fragment; k >= 0; --k) {
+        std::string activation =
+            llvm::formatv("%f_{0}_{1}_{2}", mb, s, k).str();
+        std::string accumulator =
+            mb == 0 ? activation
+                    : llvm::formatv("%b_{0}_{1}_{2}#1", mb - 1, s, k).str();
+        os << llvm::formatv(
+            "  %b_{0}_{1}_{2}:2 = mpmd.fragment<mesh=\"m{1}\", "
+            "origin=[\"{3}\"(1)]> ({4}, {5}, {6}) {{call_counter = {0} : ui32} "
+            "(%g: tensor<16x16xf32>, %a: tensor<16x16xf32>, "
+            "%acc: tensor<16x16xf32>) {{\n"
+            "    %0 = stablehlo.multiply %g, %a : tensor<16x16xf32>\n"
+            "    %1 = stablehlo.add %acc, %0 : tensor<16x16xf32>\n"
+            "    mpmd.return %0, %1 : tensor<16x16xf32>, tensor<16x16xf32>\n"
+            "  } : (!t{1}, !t{1}, !t{1}) -> (!t{1}, !t{1})\n",
+            mb, s, k, FragmentName(s, k), grad, activation, accumulator);
+        grad = llvm::formatv("%b_{0}_{1}_{2}#0", mb, s, k).str();
+      }
+    }
+  }
+
+  os << "  return ";
+  const int64_t last_microbatch = shape.num_microbatches - 1;
+  llvm::interleaveComma(
+      llvm::seq<int64_t>(0, shape.num_stages * shape.fragments_per_stage), os,
+      [&](int64_t i) {
+        os << llvm::formatv("%b_{0}_{1}_{2}#1", last_microbatch,
+                            i / shape.fragments_per_stage,
+                            i % shape.fragments_per_stage);
+      });
+  os << " : ";
+  llvm::interleaveComma(
+      llvm::seq<int64_t>(0, shape.num_stages * shape.fragments_per_stage), os,
+      [&](int64_t i) { os << "!t" << i / shape.fragments_per_stage; });
+  os << "\n}\n";
+  return str;
+}
+
+// Returns one rule per mesh that schedules its fragments in the GPipe order,
+// i.e., all forward fragments before all backward fragments.
+std::vector<FragmentScheduleRule> GetGPipeScheduleRules(
+    const PipelineShape& shape) {
+  std::vector<FragmentScheduleRule> rules;
+  for (int64_t s = 0; s < shape.num_stages; ++s) {
+    FragmentScheduleRule& rule = rules.emplace_back();
+    std::string mesh_name = llvm::formatv("m{0}", s).str();
+    for (int64_t transpose_count : {0, 1}) {
+      for (int64_t mb = 0; mb < shape.num_microbatches; ++mb) {
+        for (int64_t i = 0; i < shape.fragments_per_stage; ++i) {
+          int64_t k = transpose_count == 0 ? i
+                                           : shape.fragments_per_stage - 1 - i;
+          rule.ordered_fragments.push_back(FragmentInfo{
+              /*origins=*/{FragmentOrigin{FragmentName(s, k), transpose_count}},
+              /*stage_id=*/std::nullopt,
+              /*call_counter=*/static_cast<int>(mb),
+              /*split_type=*/std::nullopt, mesh_name});
+        }
+      }
+    }
+  }
+  return rules;
+}
+
+void AddPipelineSchedulerPass(OpPassManager& pm, PipelineSchedule schedule) {
+  PipelineSchedulerPassOptions options;
+  options.mustHappenBefore.value = BuiltinFragmentComparator(schedule);
+  options.mustHappenBefore.schedule = schedule;
+  options.rankBasedScheduling = rank_based_scheduling_flag;
+  pm.addNestedPass<FuncOp>(createPipelineSchedulerPass(options));
+}
+
+struct Stage {
+  StringRef name;
+  // Whether the stage runs on the scheduled program, i.e., after the pipeline
+  // scheduler, rather than the generated program.
+  bool runs_on_scheduled_program;
+  std::function<void(OpPassManager&, const PipelineShape&, PipelineSchedule)>
+      add_passes;
+};
+
+SmallVector<Stage> GetStages() {
+  return {
+      {"pipeline_scheduler", /*runs_on_scheduled_program=*/false,
+       [](OpPassManager& pm, const PipelineShape&, PipelineSchedule schedule) {
+         AddPipelineSchedulerPass(pm, schedule);
+       }},
+      {"rule_based_schedule", /*runs_on_scheduled_program=*/false,
+       [](OpPassManager& pm, const PipelineShape& shape, PipelineSchedule) {
+         RuleBasedSchedulePassOptions options;
+         options.rules = GetGPipeScheduleRules(shape);
+         pm.addNestedPass<FuncOp>(createRuleBasedSchedulePass(options));
+       }},
+      {"merge_forward_with_backward", /*runs_on_scheduled_program=*/true,
+       [](OpPassManager& pm, const PipelineShape&, PipelineSchedule) {
+         pm.addNestedPass<FuncOp>(createMergeForwardWithBackwardPass());
+       }},
+      {"split_bwd_fragments", /*runs_on_scheduled_program=*/false,
+       [](OpPassManager& pm, const PipelineShape&, PipelineSchedule) {
+         pm.addNestedPass<FuncOp>(createSplitBwdFragmentsPass());
+       }},
+      {"export", /*runs_on_scheduled_program=*/true,
+       [](OpPassManager& pm, const PipelineShape&, PipelineSchedule) {
+         addExportPipeline(pm);
+       }},
+  };
+}
+
+// Runs the passes of `stage` on a clone of `module` and returns the elapsed
+// time, or std::nullopt if the passes failed.
+std::optional<std::chrono::nanoseconds> RunStage(ModuleOp module,
+                                                 const Stage& stage,
+                                                 const PipelineShape& shape,
+                                                 PipelineSchedule schedule) {
+  OwningOpRef<ModuleOp> clone = module.clone();
+  PassManager pm(module.getContext());
+  stage.add_passes(pm, shape, schedule);
+  return sdy::timeRun([&]() { return pm.run(*clone); });
+}
+
+// A generated program and its scheduled counterpart.
+struct Program {
+  PipelineShape shape;
+  OwningOpRef<ModuleOp> module;
+  OwningOpRef<ModuleOp> scheduled_module;
+};
+
+int RunBenchmarks() {
+  MLIRContext context;
+  loadAllRequiredDialects(&context);
+  sdy::applyThreadingFlag(&context);
+
+  std::optional<PipelineSchedule> schedule =
+      ParsePipelineSchedule(schedule_flag);
+  if (!schedule) {
+    llvm::errs() << "invalid --schedule: " << schedule_flag << "\n";
+    return 1;
+  }
+
+  std::vector<Program> programs;
+  for (int64_t num_stages : stages_flag) {
+    for (int64_t num_microbatches : microbatches_flag) {
+      for (int64_t fragments_per_stage : fragments_per_stage_flag) {
+        PipelineShape shape{std::max<int64_t>(num_stages, 1),
+                            std::max<int64_t>(num_microbatches, 1),
+                            std::max<int64_t>(fragments_per_stage, 1)};
+        Program& program = programs.emplace_back();
+        program.shape = shape;
+        program.module =
+            parseSourceString<ModuleOp>(GeneratePipeline(shape), &context);
+        if (!program.module) {
+          llvm::errs() << "failed to parse the generated program\n";
+          return 1;
+        }
+        program.scheduled_module = program.module->clone();
+        PassManager pm(&context);
+        AddPipelineSchedulerPass(pm, *schedule);
+        if (failed(pm.run(*program.scheduled_module))) {
+          llvm::errs() << "failed to schedule the generated program\n";
+          return 1;
+        }
+      }
+    }
+  }
+
+  // Every stage prints one row per pipeline shape, which makes up its scaling
+  // curve.
+  sdy::BenchmarkTable table(/*name_width=*/28,
+                            {"stages", "microbatches", "fragments"});
+  table.printHeader();
+  for (const Stage& stage : GetStages()) {
+    if (!sdy::shouldRunBenchmark(stage.name)) {
+      continue;
+    }
+    for (const Program& program : programs) {
+      ModuleOp input = stage.runs_on_scheduled_program
+                           ? *program.scheduled_module
+                           : *program.module;
+      std::optional<sdy::BenchmarkTimings> timings =
+          sdy::timeRepeatedly([&]() {
+            return RunStage(input, stage, program.shape, *schedule);
+          });
+      if (!timings) {
+        llvm::errs() << "failed to run " << stage.name << "\n";
+        return 1;
+      }
+      table.printRow(stage.name,
+                     {std::to_string(program.shape.num_stages),
+                      std::to_string(program.shape.num_microbatches),
+                      std::to_string(program.shape.NumFragments())},
+                     *timings);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace mlir::mpmd
+
+int main(int argc, char** argv) {
+  llvm::InitLLVM init_llvm(argc, argv);
+  if (mlir::failed(mlir::sdy::parseBenchmarkCommandLine(
+          argc, argv, "MPMD scheduler benchmark\n"))) {
+    return 1;
+  }
+  return mlir::mpmd::RunBenchmarks();
+}
@@ -0,0 +1,222 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/tools/opt_main.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/DialectRegistry.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Support/FileUtilities.h"
+#include "mlir/Support/LogicalResult.h"
+#include "mlir/Tools/mlir-opt/MlirOptMain.h"
+#include "shardy/common/file_utils.h"
+#include "shardy/common/save_module_op.h"
+#include "shardy/common/timing_report.h"
+
+namespace mlir {
+namespace sdy {
+
+namespace {
+
+// Lazily loads the bytecode module in `file`, materializing only the function
+// `rootName` and the symbols it transitively references, erases all other
+// functions, and returns the resulting module as bytecode. Returns null and
+// emits an error on failure.
+//
+// Only the kept functions are ever parsed, which is what makes this fast for
+// huge modules.
+std::unique_ptr<llvm::MemoryBuffer> loadFunctionAndCallees(
+    std::unique_ptr<llvm::MemoryBuffer> file, StringRef rootName,
+    DialectRegistry& registry, const MlirOptMainConfig& config) {
+  std::string bufferName = file->getBufferIdentifier().str();
+  MLIRContext context(registry, MLIRContext::Threading::DISABLED);
+  context.allowUnregisteredDialects(config.shouldAllowUnregisteredDialects());
+  std::unique_ptr<LazyModuleLoader> loader =
+      LazyModuleLoader::create(std::move(file), &context);
+  if (!loader) {
+    return nullptr;
+  }
+  ModuleOp module = loader->getModule();
+  SymbolTable symbolTable(module);
+  Operation* root = symbolTable.lookup(rootName);
+  if (!root) {
+    module.emitError() << "no symbol named '" << rootName << "'";
+    return nullptr;
+  }
+
+  llvm::DenseSet<Operation*> reached = {root};
+  SmallVector<Operation*> worklist = {root};
+  while (!worklist.empty()) {
+    Operation* symbol = worklist.pop_back_val();
+    if (failed(loader->materialize(symbol))) {
+      return nullptr;
+    }
+    std::optional<SymbolTable::UseRange> uses =
+        SymbolTable::getSymbolUses(symbol);
+    if (!uses) {
+      continue;
+    }
+    for (const SymbolTable::SymbolUse& use : *uses) {
+      Operation* used =
+          symbolTable.lookup(use.getSymbolRef().getRootReference());
+      if (used && reached.insert(used).second) {
+        worklist.push_back(used);
+      }
+    }
+  }
+  // All reached functions are materialized by now, so this erases the rest.
+  if (failed(loader->finalize(
+          /*shouldMaterialize=*/[](Operation*) { return false; }))) {
+    return nullptr;
+  }
+
+  std::string bytecode;
+  llvm::raw_string_ostream os(bytecode);
+  if (failed(writeBytecodeToFile(module, os))) {
+    module.emitError() << "failed to serialize module to bytecode";
+    return nullptr;
+  }
+  return llvm::MemoryBuffer::getMemBufferCopy(bytecode, bufferName);
+}
+
+}  // namespace
+
+LogicalResult sdyOptMain(int argc, char** argv, llvm::StringRef toolName,
+                         DialectRegistry& registry) {
+  static llvm::cl::opt<std::string> timingReportFile(
+      "sdy-timing-report",
+      llvm::cl::desc("Write the time, peak memory and IR size of all passes, "
+                     "and of the Shardy steps within them, as JSON to the "
+                     "given file"),
+      llvm::cl::value_desc("filename"), llvm::cl::init(""));
+  static llvm::cl::opt<std::string> lazyLoadFunction(
+      "sdy-lazy-load-function",
+      llvm::cl::desc("Lazily load the bytecode input, keeping only the given "
+                     "function and the symbols it transitively references"),
+      llvm::cl::value_desc("name"), llvm::cl::init(""));
+  static llvm::cl::opt<std::string> interestingnessScope(
+      "sdy-interestingness-scope",
+      llvm::cl::desc("Act as an interestingness test for sdy_reduce: exit "
+                     "with 1 if the pipeline succeeds and the given scope of "
+                     "the timing report took at least "
+                     "--sdy-interestingness-threshold seconds, and with 0 "
+                     "otherwise"),
+      llvm::cl::value_desc("scope"), llvm::cl::init(""));
+  static llvm::cl::opt<double> interestingnessThreshold(
+      "sdy-interestingness-threshold",
+      llvm::cl::desc("The time in seconds above which the module is "
+                     "interesting, see --sdy-interestingness-scope"),
+      llvm::cl::value_desc("seconds"), llvm::cl::init(0));
+  static llvm::cl::opt<bool> asyncModuleDumps(
+      "sdy-async-module-dumps",
+      llvm::cl::desc("Print and write module dumps, e.g., to a "
+                     "`module-dump-directory`, on a background thread"),
+      llvm::cl::init(false));
+  static llvm::cl::opt<bool> compressModuleDumps(
+      "sdy-compress-module-dumps",
+      llvm::cl::desc("Compress module dumps with zstd, if available"),
+      llvm::cl::init(false));
+  static llvm::cl::opt<bool> bytecodeModuleDumps(
+      "sdy-bytecode-module-dumps",
+      llvm::cl::desc("Write module dumps as bytecode instead of text"),
+      llvm::cl::init(false));
+
+  auto [inputFilename, outputFilename] =
+      registerAndParseCLIOptions(argc, argv, toolName, registry);
+  MlirOptMainConfig config = MlirOptMainConfig::createFromCLOptions();
+  setModuleDumpOptions({/*async=*/asyncModuleDumps,
+                        /*compress=*/compressModuleDumps,
+                        /*bytecode=*/bytecodeModuleDumps});
+  if (!timingReportFile.empty() || !interestingnessScope.empty()) {
+    enableTimingReport();
+    // Keep the pass pipeline specified on the command line.
+    config.setPassPipelineSetupFn(
+        [baseConfig = config](PassManager& pm) -> LogicalResult {
+          if (failed(baseConfig.setupPassPipeline(pm))) {
+            return failure();
+          }
+          pm.addInstrumentation(createTimingReportInstrumentation());
+          return success();
+        });
+  }
+
+  std::string errorMessage;
+  std::unique_ptr<llvm::MemoryBuffer> file =
+      openInputFile(inputFilename, &errorMessage);
+  if (!file) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+  if (!lazyLoadFunction.empty()) {
+    file = loadFunctionAndCallees(std::move(file), lazyLoadFunction, registry,
+                                  config);
+    if (!file) {
+      return failure();
+    }
+  }
+  std::unique_ptr<llvm::ToolOutputFile> output =
+      openOutputFile(outputFilename, &errorMessage);
+  if (!output) {
+    llvm::errs() << errorMessage << "\n";
+    return failure();
+  }
+  LogicalResult result =
+      MlirOptMain(output->os(), std::move(file), registry, config);
+  waitForModuleDumps();
+  if (!interestingnessScope.empty()) {
+    // A module that fails the pipeline, e.g., because it was over-reduced,
+    // isn't interesting.
+    std::optional<double> seconds =
+        getTimingReportSeconds(interestingnessScope);
+    bool interesting = succeeded(result) && seconds &&
+                       *seconds >= interestingnessThreshold;
+    return failure(interesting);
+  }
+  if (failed(result)) {
+    return failure();
+  }
+  output->keep();
+
+  if (!timingReportFile.empty()) {
+    std::unique_ptr<llvm::ToolOutputFile> report =
+        openOutputFile(timingReportFile, &errorMessage);
+    if (!report) {
+      llvm::errs() << errorMessage << "\n";
+      return failure();
+    }
+    writeTimingReportJson(report->os());
+    report->keep();
+  }
+  return success();
+}
+
+}  // namespace sdy
+}  // namespace mlir
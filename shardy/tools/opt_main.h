@@ -0,0 +1,45 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_TOOLS_OPT_MAIN_H_
+#define SHARDY_TOOLS_OPT_MAIN_H_
+
+#include "llvm/ADT/StringRef.h"
+#include "mlir/IR/DialectRegistry.h"
+#include "mlir/Support/LogicalResult.h"
+
+namespace mlir {
+namespace sdy {
+
+// Same as `mlir::MlirOptMain(argc, argv, toolName, registry)`, with additional
+// flags:
+// - `--sdy-timing-report=<file>` writes the timing report (see
+//   `shardy/common/timing_report.h`) of all passes, and of the steps within
+//   them, to a JSON file.
+// - `--sdy-lazy-load-function=<name>` lazily loads a bytecode input, keeping
+//   only function `name` and the symbols it transitively references, so that
+//   passes can be rerun on a single function of a huge module.
+// - `--sdy-interestingness-scope=<scope>` and
+//   `--sdy-interestingness-threshold=<seconds>` make the tool an
+//   interestingness test for `sdy_reduce`, which fails, i.e., the module is
+//   interesting, iff the pipeline succeeds and `scope` of the timing report
+//   took at least `seconds`.
+LogicalResult sdyOptMain(int argc, char** argv, llvm::StringRef toolName,
+                         DialectRegistry& registry);
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_TOOLS_OPT_MAIN_H_
@@ -0,0 +1,173 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "shardy/tools/reduction_patterns.h"
+
+#include <cstdint>
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/DialectRegistry.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Reducer/ReductionPatternInterface.h"
+#include "mlir/Support/LLVM.h"
+#include "shardy/dialect/mpmd/ir/dialect.h"
+#include "shardy/dialect/sdy/ir/constants.h"
+#include "shardy/dialect/sdy/ir/dialect.h"
+
+namespace mlir {
+namespace sdy {
+
+namespace {
+
+// Removes the `sdy.sharding` attribute of an op that isn't an SDY op, for
+// which the sharding is part of the op.
+class DropOpShardingPattern : public RewritePattern {
+ public:
+  explicit DropOpShardingPattern(MLIRContext* context)
+      : RewritePattern(MatchAnyOpTypeTag(), /*benefit=*/1, context) {}
+
+  LogicalResult matchAndRewrite(Operation* op,
+                                PatternRewriter& rewriter) const override {
+    if (!op->getDiscardableAttr(kShardingAttr)) {
+      return rewriter.notifyMatchFailure(op, "op has no sharding");
+    }
+    rewriter.modifyOpInPlace(op, [&]() {
+      op->removeDiscardableAttr(kShardingAttr);
+    });
+    return success();
+  }
+};
+
+// Removes the shardings of all arguments and results of a function.
+class DropFuncShardingsPattern : public OpRewritePattern<func::FuncOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(func::FuncOp funcOp,
+                                PatternRewriter& rewriter) const override {
+    bool hasSharding = false;
+    for (int64_t argNum = 0; argNum < funcOp.getNumArguments(); ++argNum) {
+      hasSharding |= funcOp.getArgAttr(argNum, kShardingAttr) != nullptr;
+    }
+    for (int64_t resNum = 0; resNum < funcOp.getNumResults(); ++resNum) {
+      hasSharding |= funcOp.getResultAttr(resNum, kShardingAttr) != nullptr;
+    }
+    if (!hasSharding) {
+      return rewriter.notifyMatchFailure(funcOp, "function has no shardings");
+    }
+    rewriter.modifyOpInPlace(funcOp, [&]() {
+      for (int64_t argNum = 0; argNum < funcOp.getNumArguments(); ++argNum) {
+        funcOp.removeArgAttr(argNum, kShardingAttr);
+      }
+      for (int64_t resNum = 0; resNum < funcOp.getNumResults(); ++resNum) {
+        funcOp.removeResultAttr(resNum, kShardingAttr);
+      }
+    });
+    return success();
+  }
+};
+
+// Replaces an op that has a single operand and result of the same type with
+// its operand.
+template <typename OpTy>
+class ReplaceWithInputPattern : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter& rewriter) const override {
+    rewriter.replaceOp(op, op.getInput());
+    return success();
+  }
+};
+
+class EraseShardingGroupPattern : public OpRewritePattern<ShardingGroupOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(ShardingGroupOp op,
+                                PatternRewriter& rewriter) const override {
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// Erases an op whose results are all unused, even if it isn't pure.
+template <typename OpTy>
+class EraseUnusedPattern : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter& rewriter) const override {
+    if (!op->use_empty()) {
+      return rewriter.notifyMatchFailure(op, "op has uses");
+    }
+    rewriter.eraseOp(op);
+    return success();
+  }
+};
+
+// Reduces the number of iterations of an `mpmd.for` to its unroll factor, i.e.,
+// a single iteration of the unrolled body.
+class ShrinkForLoopPattern : public OpRewritePattern<mpmd::ForOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(mpmd::ForOp op,
+                                PatternRewriter& rewriter) const override {
+    uint32_t minIterations = op.getUnrollFactor().value_or(1);
+    if (op.getIterations() <= minIterations) {
+      return rewriter.notifyMatchFailure(op, "loop is already minimal");
+    }
+    rewriter.modifyOpInPlace(op, [&]() { op.setIterations(minIterations); });
+    return success();
+  }
+};
+
+class SdyReductionPatternInterface : public DialectReductionPatternInterface {
+ public:
+  using DialectReductionPatternInterface::DialectReductionPatternInterface;
+
+  void populateReductionPatterns(RewritePatternSet& patterns) const override {
+    patterns.add<DropOpShardingPattern, DropFuncShardingsPattern,
+                 ReplaceWithInputPattern<ShardingConstraintOp>,
+                 ReplaceWithInputPattern<ReshardOp>,
+                 ReplaceWithInputPattern<PropagationBarrierOp>,
+                 EraseShardingGroupPattern>(patterns.getContext());
+  }
+};
+
+class MpmdReductionPatternInterface : public DialectReductionPatternInterface {
+ public:
+  using DialectReductionPatternInterface::DialectReductionPatternInterface;
+
+  void populateReductionPatterns(RewritePatternSet& patterns) const override {
+    patterns.add<ShrinkForLoopPattern, EraseUnusedPattern<mpmd::FragmentOp>,
+                 EraseUnusedPattern<mpmd::FragmentCallOp>>(
+        patterns.getContext());
+  }
+};
+
+}  // namespace
+
+void registerReductionPatternInterfaces(DialectRegistry& registry) {
+  registry.addExtension(+[](MLIRContext*, SdyDialect* dialect) {
+    dialect->addInterfaces<SdyReductionPatternInterface>();
+  });
+  registry.addExtension(+[](MLIRContext*, mpmd::MpmdDialect* dialect) {
+    dialect->addInterfaces<MpmdReductionPatternInterface>();
+  });
+}
+
+}  // namespace sdy
+}  // namespace mlir
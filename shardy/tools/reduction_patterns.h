@@ -0,0 +1,36 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef SHARDY_TOOLS_REDUCTION_PATTERNS_H_
+#define SHARDY_TOOLS_REDUCTION_PATTERNS_H_
+
+#include "mlir/IR/DialectRegistry.h"
+
+namespace mlir {
+namespace sdy {
+
+// Registers the SDY and MPMD implementations of
+// `DialectReductionPatternInterface`, which the `reduction-tree` pass of
+// `sdy_reduce` uses to reduce a module:
+// - SDY: drops shardings, sharding constraints, reshards, propagation barriers
+//   and sharding groups.
+// - MPMD: shrinks `mpmd.for` loops to a single (unrolled) iteration, and erases
+//   fragments and fragment calls whose results are unused.
+void registerReductionPatternInterfaces(DialectRegistry& registry);
+
+}  // namespace sdy
+}  // namespace mlir
+
+#endif  // SHARDY_TOOLS_REDUCTION_PATTERNS_H_
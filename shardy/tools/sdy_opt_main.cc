@@ -25,6 +25,7 @@ limitations under the License.
 #include "mlir/Tools/mlir-opt/MlirOptMain.h"
 #include "shardy/dialect/sdy/ir/register.h"
 #include "shardy/dialect/sdy/transforms/passes.h"
+#include "shardy/tools/opt_main.h"
 
 int main(int argc, char** argv) {
   mlir::registerAllPasses();
@@ -38,5 +39,5 @@ int main(int argc, char** argv) {
   mlir::sdy::registerAllSdyPassesAndPipelines();
 
   return mlir::asMainReturnCode(
-      mlir::MlirOptMain(argc, argv, "SDY pass driver\n", registry));
+      mlir::sdy::sdyOptMain(argc, argv, "SDY pass driver\n", registry));
 }
@@ -0,0 +1,47 @@
+/* Copyright 2026 The Shardy Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// MLIR `reduce` tool for minimizing SDY and MPMD modules that reproduce an
+// issue, e.g., a pass that is too slow.
+//
+// Usage:
+//   sdy_reduce <file> -reduction-tree='traversal-mode=0 test=<test> ...'
+//
+// For example, to keep the module as long as propagation takes at least 10
+// seconds, use `sdy_opt` as the test:
+//   sdy_reduce <file> -reduction-tree='traversal-mode=0 test=sdy_opt
+//     test-arg=-sdy-propagation-pipeline
+//     test-arg=-sdy-interestingness-scope=sdy-user-priority-propagate
+//     test-arg=-sdy-interestingness-threshold=10 test-arg=-o=/dev/null'
+
+#include "mlir/Dialect/Func/Extensions/AllExtensions.h"
+#include "mlir/IR/DialectRegistry.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LogicalResult.h"
+#include "mlir/Tools/mlir-reduce/MlirReduceMain.h"
+#include "shardy/dialect/mpmd/ir/register.h"
+#include "shardy/dialect/sdy/ir/register.h"
+#include "shardy/tools/reduction_patterns.h"
+
+int main(int argc, char** argv) {
+  mlir::DialectRegistry registry;
+  mlir::sdy::registerAllDialects(registry);
+  mlir::mpmd::registerAllDialects(registry);
+  mlir::func::registerAllExtensions(registry);
+  mlir::sdy::registerReductionPatternInterfaces(registry);
+
+  mlir::MLIRContext context(registry);
+  return mlir::asMainReturnCode(mlir::mlirReduceMain(argc, argv, context));
+}
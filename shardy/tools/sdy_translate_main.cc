@@ -18,18 +18,26 @@ limitations under the License.
 // Usage:
 //   sdy_translate <file.mlir> -serialize
 //   sdy_translate <file.mlir.bc> -deserialize
+//   sdy_translate <file.mlir> -benchmark-roundtrip [-benchmark-iterations=N]
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/LogicalResult.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Bytecode/BytecodeWriter.h"
 #include "mlir/Dialect/Func/Extensions/AllExtensions.h"
 #include "mlir/Dialect/Quant/IR/Quant.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/DialectRegistry.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Tools/mlir-opt/MlirOptMain.h"
@@ -49,6 +57,11 @@ llvm::cl::opt<bool> stripDebuginfoOption(
 llvm::cl::opt<std::string> targetVersionOption(
     "target-version", llvm::cl::desc("Target version for serialization"),
     llvm::cl::init(""));
+llvm::cl::opt<int> benchmarkIterationsOption(
+    "benchmark-iterations",
+    llvm::cl::desc("Number of round trips per format and version in "
+                   "-benchmark-roundtrip"),
+    llvm::cl::init(10));
 
 void registerDialectsForSdy(DialectRegistry &registry) {
   mlir::sdy::registerAllDialects(registry);
@@ -88,6 +101,139 @@ TranslateFromMLIRRegistration serializeRegistration(
     },
     [](DialectRegistry &registry) { registerDialectsForSdy(registry); });
 
+// Returns all versions from the minimum supported version to the current one.
+SmallVector<sdy::SdyDialectVersion> getSupportedVersions() {
+  auto minVersion = sdy::SdyDialectVersion::getMinimumVersion();
+  auto curVersion = sdy::SdyDialectVersion::getCurrentVersion();
+  if (minVersion.getMajor() != curVersion.getMajor() ||
+      minVersion.getMinor() != curVersion.getMinor()) {
+    return {minVersion, curVersion};
+  }
+  SmallVector<sdy::SdyDialectVersion> versions;
+  for (int64_t patch = minVersion.getPatch(); patch <= curVersion.getPatch();
+       ++patch) {
+    versions.emplace_back(curVersion.getMajor(), curVersion.getMinor(), patch);
+  }
+  return versions;
+}
+
+// Returns the time `fn` takes to run `iterations` times, in seconds.
+template <typename Fn>
+double timeIterations(int iterations, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    fn();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Returns the throughput of processing `bytes` bytes `iterations` times in
+// `seconds`, in MB/s.
+double getThroughput(size_t bytes, int iterations, double seconds) {
+  return seconds == 0 ? 0 : bytes * iterations / seconds / 1e6;
+}
+
+// Writes the number of SDY attributes in `module`, including nested ones, and
+// the number of unique ones among them.
+void printSdyAttrCounts(ModuleOp module, llvm::raw_ostream &os) {
+  int64_t numAttrs = 0;
+  llvm::DenseSet<Attribute> uniqueAttrs;
+  module->walk([&](Operation *op) {
+    op->getAttrDictionary().walk([&](Attribute attr) {
+      if (isa<sdy::SdyDialect>(attr.getDialect())) {
+        ++numAttrs;
+        uniqueAttrs.insert(attr);
+      }
+    });
+  });
+  os << llvm::formatv("sdy attrs: {0} ({1} unique)\n", numAttrs,
+                      uniqueAttrs.size());
+}
+
+// Round-trips a clone of `module` through bytecode and text at every supported
+// SDY dialect version (downgrading it first if needed), and writes the size
+// and throughput of each to `os`.
+LogicalResult benchmarkRoundTrip(ModuleOp module, llvm::raw_ostream &os) {
+  int iterations = benchmarkIterationsOption;
+  if (iterations <= 0) {
+    return module.emitError("-benchmark-iterations must be positive");
+  }
+  MLIRContext *context = module->getContext();
+  printSdyAttrCounts(module, os);
+  os << llvm::formatv(
+      "{0,-8} {1,12} {2,12} {3,12} {4,12} {5,12} {6,12} {7,12}\n", "version",
+      "downgrade_ms", "bc_bytes", "bc_wr_MB/s", "bc_rd_MB/s", "txt_bytes",
+      "txt_wr_MB/s", "txt_rd_MB/s");
+  for (const sdy::SdyDialectVersion &version : getSupportedVersions()) {
+    OwningOpRef<ModuleOp> clone = module.clone();
+    double downgradeSeconds = 0;
+    if (version < sdy::SdyDialectVersion::getCurrentVersion()) {
+      LogicalResult result = success();
+      downgradeSeconds = timeIterations(1, [&]() {
+        result = sdy::downgradeModule(*clone, version);
+      });
+      if (failed(result)) {
+        return module.emitError("failed to downgrade module to ")
+               << version.toString();
+      }
+    }
+
+    std::string bytecode;
+    LogicalResult writeResult = success();
+    double bytecodeWriteSeconds = timeIterations(iterations, [&]() {
+      bytecode.clear();
+      llvm::raw_string_ostream bytecodeOs(bytecode);
+      BytecodeWriterConfig writerConfig("SDY");
+      writerConfig.setDialectVersion<sdy::SdyDialect>(
+          std::make_unique<sdy::SdyDialectVersion>(version));
+      writeResult = writeBytecodeToFile(*clone, bytecodeOs, writerConfig);
+    });
+    if (failed(writeResult)) {
+      return module.emitError("failed to write bytecode at version ")
+             << version.toString();
+    }
+    bool readFailed = false;
+    double bytecodeReadSeconds = timeIterations(iterations, [&]() {
+      readFailed |= !parseSourceString<ModuleOp>(bytecode, context);
+    });
+
+    std::string text;
+    double textWriteSeconds = timeIterations(iterations, [&]() {
+      text.clear();
+      llvm::raw_string_ostream textOs(text);
+      clone->print(textOs);
+    });
+    double textReadSeconds = timeIterations(iterations, [&]() {
+      readFailed |= !parseSourceString<ModuleOp>(text, context);
+    });
+    if (readFailed) {
+      return module.emitError("failed to read module at version ")
+             << version.toString();
+    }
+
+    os << llvm::formatv(
+        "{0,-8} {1,12:F3} {2,12} {3,12:F1} {4,12:F1} {5,12} {6,12:F1} "
+        "{7,12:F1}\n",
+        version.toString(), downgradeSeconds * 1e3, bytecode.size(),
+        getThroughput(bytecode.size(), iterations, bytecodeWriteSeconds),
+        getThroughput(bytecode.size(), iterations, bytecodeReadSeconds),
+        text.size(), getThroughput(text.size(), iterations, textWriteSeconds),
+        getThroughput(text.size(), iterations, textReadSeconds));
+  }
+  return success();
+}
+
+TranslateFromMLIRRegistration benchmarkRoundTripRegistration(
+    "benchmark-roundtrip",
+    "Report the throughput of round-tripping a SDY program through bytecode "
+    "and text at every supported version",
+    [](mlir::ModuleOp module, llvm::raw_ostream &os) -> llvm::LogicalResult {
+      return benchmarkRoundTrip(module, os);
+    },
+    [](DialectRegistry &registry) { registerDialectsForSdy(registry); });
+
 TranslateToMLIRRegistration deserializeRegistration(
     "deserialize", "Deserialize a portable artifact into a SDY program",
     [](llvm::StringRef input, mlir::MLIRContext *context) {